@@ -190,11 +190,15 @@ TensorHandlePtr ParallelTensorToTensorHandle(
   // The resulting TensorHandle owns an opaque pointer to "device memory", which
   // for a ParallelDevice is really a ParallelTensor. When the TensorHandle is
   // deleted, it will call ParallelTensorDeallocator to free the struct.
+  //
+  // Handles take their shape on creation, so this waits for the components of
+  // `t` to be computed.
+  const std::vector<int64_t>* shape = t->Shape(status);
+  if (TF_GetCode(status) != TF_OK) return nullptr;
   ParallelTensor* t_released = t.release();
-  const std::vector<int64_t>& shape(t_released->shape());
   return TensorHandlePtr(TFE_NewTensorHandleFromDeviceMemory(
-      context, parallel_device_name.c_str(), t_released->dtype(), shape.data(),
-      shape.size(), t_released, 1, &ParallelTensorDeallocator, nullptr,
+      context, parallel_device_name.c_str(), t_released->dtype(), shape->data(),
+      shape->size(), t_released, 1, &ParallelTensorDeallocator, nullptr,
       status));
 }
 
@@ -309,7 +309,7 @@ std::unique_ptr<ParallelTensor> ParallelDevice::Vector(
     if (TF_GetCode(status) != TF_OK) return nullptr;
   }
   return ParallelTensor::FromTensorHandles(*this, std::move(components),
-                                           status);
+                                           /*shape=*/{}, status);
 }
 
 std::unique_ptr<ParallelTensor> ParallelDevice::DeviceIDs(
@@ -398,17 +398,43 @@ std::unique_ptr<ParallelTensor> ParallelTensor::FromTensorHandles(
     const ParallelDevice& parallel_device,
     std::vector<TensorHandlePtr> components, TF_Status* status) {
   TF_DataType dtype = TFE_TensorHandleDataType(components[0].get());
+  // The dtypes are known before the components are computed.
+  for (TensorHandlePtr& component : components) {
+    if (TFE_TensorHandleDataType(component.get()) != dtype) {
+      TF_SetStatus(status, TF_INTERNAL,
+                   "Components of a ParallelTensor must all have "
+                   "the same dtype");
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<ParallelTensor>(new ParallelTensor(
+      parallel_device, std::move(components), absl::nullopt, dtype));
+}
+
+std::unique_ptr<ParallelTensor> ParallelTensor::FromTensorHandles(
+    const ParallelDevice& parallel_device,
+    std::vector<TensorHandlePtr> components, absl::Span<const int64_t> shape,
+    TF_Status* status) {
+  std::unique_ptr<ParallelTensor> result(
+      FromTensorHandles(parallel_device, std::move(components), status));
+  if (TF_GetCode(status) != TF_OK) return nullptr;
+  result->shape_.emplace(shape.begin(), shape.end());
+  return result;
+}
+
+const std::vector<int64_t>* ParallelTensor::Shape(TF_Status* status) const {
+  tensorflow::mutex_lock l(shape_mu_);
+  if (shape_.has_value()) return &*shape_;
   std::vector<int64_t> shape(
-      TFE_TensorHandleNumDims(components[0].get(), status));
+      TFE_TensorHandleNumDims(tensors_[0].get(), status));
   if (TF_GetCode(status) != TF_OK) return nullptr;
   for (int i = 0; i < shape.size(); ++i) {
-    shape[i] = TFE_TensorHandleDim(components[0].get(), i, status);
+    shape[i] = TFE_TensorHandleDim(tensors_[0].get(), i, status);
     if (TF_GetCode(status) != TF_OK) return nullptr;
   }
 
-  // Verify that the TensorHandle's shape and dtype match all of the component
-  // shapes and dtypes.
-  for (TensorHandlePtr& component : components) {
+  // Verify that the TensorHandle's shape matches all of the component shapes.
+  for (const TensorHandlePtr& component : tensors_) {
     for (int i = 0; i < shape.size(); ++i) {
       int64_t tensor_dim = TFE_TensorHandleDim(component.get(), i, status);
       if (TF_GetCode(status) != TF_OK) return nullptr;
@@ -419,17 +445,10 @@ std::unique_ptr<ParallelTensor> ParallelTensor::FromTensorHandles(
                      "the same shape");
         return nullptr;
       }
-      if (TFE_TensorHandleDataType(component.get()) != dtype) {
-        TF_SetStatus(status, TF_INTERNAL,
-                     "Components of a ParallelTensor must all have "
-                     "the same dtype");
-        return nullptr;
-      }
     }
   }
-
-  return std::unique_ptr<ParallelTensor>(new ParallelTensor(
-      parallel_device, std::move(components), std::move(shape), dtype));
+  shape_.emplace(std::move(shape));
+  return &*shape_;
 }
 
 }  // namespace parallel_device
@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_experimental.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace parallel_device {
@@ -51,6 +53,11 @@ class ParallelDevice {
  public:
   // Eager async execution is only supported when remote eager is not in use
   // (b/157523095).
+  //
+  // With async execution, Execute returns once the operation is enqueued on
+  // each component device, and the shapes of its outputs are only waited for
+  // when requested, so a sequence of operations is pipelined: each component
+  // device runs ahead independently until a value is needed.
   explicit ParallelDevice(const std::vector<std::string>& devices,
                           const bool is_async = false);
 
@@ -117,22 +124,31 @@ class ParallelDevice {
 class ParallelTensor {
  public:
   // Construct a ParallelTensor from TensorHandles placed on the component
-  // devices of a ParallelDevice.
+  // devices of a ParallelDevice. Does not wait for the components to be
+  // computed.
   static std::unique_ptr<ParallelTensor> FromTensorHandles(
       const ParallelDevice& parallel_device,
       std::vector<TensorHandlePtr> components, TF_Status* status);
+  // Same, for components whose shape is known to be `shape`.
+  static std::unique_ptr<ParallelTensor> FromTensorHandles(
+      const ParallelDevice& parallel_device,
+      std::vector<TensorHandlePtr> components,
+      absl::Span<const int64_t> shape, TF_Status* status);
 
   size_t num_tensors() const { return tensors_.size(); }
   TFE_TensorHandle* tensor(size_t index) const { return tensors_[index].get(); }
 
-  // A generalization of the shapes of the underlying tensors.
-  const std::vector<int64_t>& shape() const { return shape_; }
+  // A generalization of the shapes of the underlying tensors. The first call
+  // waits for the components to be computed, and sets a bad status and returns
+  // nullptr if their shapes differ.
+  const std::vector<int64_t>* Shape(TF_Status* status) const;
   TF_DataType dtype() const { return dtype_; }
 
  private:
   ParallelTensor(const ParallelDevice& device,
                  std::vector<TensorHandlePtr> tensors,
-                 std::vector<int64_t> shape, const TF_DataType dtype)
+                 absl::optional<std::vector<int64_t>> shape,
+                 const TF_DataType dtype)
       : device_(device),
         tensors_(std::move(tensors)),
         shape_(std::move(shape)),
@@ -140,7 +156,9 @@ class ParallelTensor {
 
   const ParallelDevice& device_;
   const std::vector<TensorHandlePtr> tensors_;
-  const std::vector<int64_t> shape_;
+  mutable tensorflow::mutex shape_mu_;
+  mutable absl::optional<std::vector<int64_t>> shape_
+      TF_GUARDED_BY(shape_mu_);
   const TF_DataType dtype_;
 };
 
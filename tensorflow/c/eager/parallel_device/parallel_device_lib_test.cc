@@ -80,5 +80,61 @@ TEST(PARALLEL_DEVICE_LIB, TestOpWithError) {
   ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
 }
 
+TEST(PARALLEL_DEVICE_LIB, TestAsyncPipelining) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TF_Buffer, decltype(&TF_DeleteBuffer)> config(
+      TF_CreateConfig(
+          /*xla*/ false,
+          /* gpu_memory_allow_growth */ true, /* num_cpu_devices */
+          2),
+      TF_DeleteBuffer);
+  TFE_ContextOptionsSetConfig(opts.get(), config->data, config->length,
+                              status.get());
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status.get()), TFE_DeleteContext);
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+
+  std::vector<std::string> devices{
+      "/job:localhost/replica:0/task:0/device:CPU:0",
+      "/job:localhost/replica:0/task:0/device:CPU:1"};
+  ParallelDevice parallel_device(std::move(devices), /*is_async=*/true);
+  std::unique_ptr<ParallelTensor> values =
+      parallel_device.Vector(context.get(), status.get(), {3, 4});
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+
+  std::unique_ptr<TFE_Op, decltype(&TFE_DeleteOp)> neg_op(
+      TFE_NewOp(context.get(), "Neg", status.get()), TFE_DeleteOp);
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+  TFE_OpSetAttrType(neg_op.get(), "T", TF_INT32);
+  // A sequence of operations, which are only enqueued on the component
+  // devices.
+  std::vector<std::unique_ptr<ParallelTensor>> outputs;
+  outputs.push_back(std::move(values));
+  for (int i = 0; i < 3; ++i) {
+    auto results = parallel_device.Execute(
+        context.get(), {outputs.back().get()}, "Neg",
+        TFE_OpGetAttrs(neg_op.get()), /*expected_max_outputs=*/1,
+        status.get());
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    ASSERT_EQ(results->size(), 1);
+    outputs.push_back(std::move((*results)[0]));
+  }
+
+  const std::vector<int64_t>* shape = outputs.back()->Shape(status.get());
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+  EXPECT_TRUE(shape->empty());
+  const int32_t expected[] = {-3, -4};
+  for (int i = 0; i < 2; ++i) {
+    std::unique_ptr<TF_Tensor, decltype(&TF_DeleteTensor)> value(
+        TFE_TensorHandleResolve(outputs.back()->tensor(i), status.get()),
+        TF_DeleteTensor);
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    EXPECT_EQ(*static_cast<int32_t*>(TF_TensorData(value.get())), expected[i]);
+  }
+}
+
 }  // namespace parallel_device
 }  // namespace tensorflow
@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/common_runtime/node_cost_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -31,12 +34,14 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -235,6 +240,82 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// Registers the node costs measured while serving the model, if it was
+// exported with them, for the cost models of Grappler. They must be registered
+// before the session is created, which optimizes the graph.
+Status RegisterNodeCostsIfPresent(const string& export_dir) {
+  const string path = io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                                   kNodeCostsFilename);
+  if (!Env::Default()->FileExists(path).ok()) return Status::OK();
+  RunMetadata node_costs;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), path, &node_costs));
+  RegisterNodeCosts(node_costs.step_stats());
+  return Status::OK();
+}
+
+constexpr int kMaxPrefetchThreads = 8;
+constexpr int64 kPrefetchChunkBytes = 64 << 20;
+constexpr int64 kPrefetchReadBytes = 8 << 20;
+
+// Reads the variables data files of a SavedModel in a thread pool, in chunks,
+// so that the restore op later finds them in the page cache, while the
+// loader imports the graph, creates the session and prepares the restore
+// subgraph. Stops reading, and joins the threads, on destruction.
+class VariablesPrefetcher {
+ public:
+  explicit VariablesPrefetcher(const string& export_dir) {
+    std::vector<string> data_files;
+    const Status status = Env::Default()->GetMatchingPaths(
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                     strings::StrCat(kSavedModelVariablesFilename, ".data-*")),
+        &data_files);
+    if (!status.ok() || data_files.empty()) return;
+    std::vector<std::pair<string, uint64>> chunks;
+    for (const string& data_file : data_files) {
+      uint64 file_size = 0;
+      if (!Env::Default()->GetFileSize(data_file, &file_size).ok()) continue;
+      for (uint64 offset = 0; offset < file_size;
+           offset += kPrefetchChunkBytes) {
+        chunks.emplace_back(data_file, offset);
+      }
+    }
+    if (chunks.empty()) return;
+    pool_.reset(new thread::ThreadPool(
+        Env::Default(), "prefetch_variables",
+        std::min<int>(kMaxPrefetchThreads, chunks.size())));
+    for (const auto& chunk : chunks) {
+      pool_->Schedule([this, chunk] { ReadChunk(chunk.first, chunk.second); });
+    }
+  }
+
+  ~VariablesPrefetcher() {
+    cancelled_ = true;
+    pool_.reset();
+  }
+
+ private:
+  void ReadChunk(const string& data_file, uint64 chunk_offset) {
+    if (cancelled_) return;
+    std::unique_ptr<RandomAccessFile> file;
+    if (!Env::Default()->NewRandomAccessFile(data_file, &file).ok()) return;
+    std::unique_ptr<char[]> scratch(new char[kPrefetchReadBytes]);
+    for (uint64 offset = chunk_offset;
+         offset < chunk_offset + kPrefetchChunkBytes && !cancelled_;
+         offset += kPrefetchReadBytes) {
+      StringPiece result;
+      // Stops at the end of the file, and on any error, which the restore op
+      // reports.
+      if (!file->Read(offset, kPrefetchReadBytes, &result, scratch.get())
+               .ok()) {
+        return;
+      }
+    }
+  }
+
+  std::atomic<bool> cancelled_{false};
+  std::unique_ptr<thread::ThreadPool> pool_;
+};
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() {}
@@ -254,15 +335,33 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
                               SavedModelBundle* const bundle) {
+  const ConfigProto::Experimental& experimental =
+      session_options.config.experimental();
+  // Mapped variables are read on first access instead.
+  std::unique_ptr<VariablesPrefetcher> prefetcher;
+  if (experimental.prefetch_restored_variables() &&
+      !experimental.memmap_restored_variables()) {
+    prefetcher.reset(new VariablesPrefetcher(export_dir));
+  }
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  TF_RETURN_IF_ERROR(RegisterNodeCostsIfPresent(export_dir));
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
-  TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
-                                    export_dir, &bundle->session));
-  return Status::OK();
+  if (!experimental.memmap_restored_variables()) {
+    return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                          &bundle->session);
+  }
+  // The restore op maps the variables it restores from this prefix.
+  const string variables_path = io::JoinPath(
+      export_dir, kSavedModelVariablesDirectory, kSavedModelVariablesFilename);
+  RegisterMemmappedBundle(variables_path);
+  const Status status = RestoreSession(run_options, bundle->meta_graph_def,
+                                       export_dir, &bundle->session);
+  UnregisterMemmappedBundle(variables_path);
+  return status;
 }
 
 Status LoadSavedModel(const SessionOptions& session_options,
@@ -388,6 +388,22 @@ std::vector<string> BufferInfosToCppExpression(
                  });
   return buffer_infos_as_strings;
 }
+
+// Generates the code opening and closing the namespaces of the generated
+// class.
+void GenNamespaceStartAndEnd(const CodegenOpts& opts, string* ns_start,
+                             string* ns_end) {
+  ns_start->clear();
+  for (const string& n : opts.namespaces) {
+    *ns_start += absl::StrCat("namespace ", n, " {\n");
+  }
+  *ns_start += "\n";
+  *ns_end = "\n";
+  for (int i = opts.namespaces.size() - 1; i >= 0; --i) {
+    const string& n = opts.namespaces[i];
+    *ns_end += absl::StrCat("}  // end namespace ", n, "\n");
+  }
+}
 }  // namespace
 
 Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
@@ -431,16 +447,8 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
   const size_t temp_bytes_total = TotalBufferBytes(buffer_infos_for_temps);
 
   // Create rewrite strings for namespace start and end.
-  string ns_start;
-  for (const string& n : opts.namespaces) {
-    ns_start += absl::StrCat("namespace ", n, " {\n");
-  }
-  ns_start += "\n";
-  string ns_end("\n");
-  for (int i = opts.namespaces.size() - 1; i >= 0; --i) {
-    const string& n = opts.namespaces[i];
-    ns_end += absl::StrCat("}  // end namespace ", n, "\n");
-  }
+  string ns_start, ns_end;
+  GenNamespaceStartAndEnd(opts, &ns_start, &ns_end);
 
   // Generate metadata.
   const string arg_names_code =
@@ -546,6 +554,11 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
   // Number of variables for the compiled computation.
   static constexpr size_t kNumVariables = {{VARIABLE_NUM}};
 
+  // Maximum number of parallel tasks run by the ops of the compiled
+  // computation, or 0 if it was compiled single-threaded.  Computations with
+  // parallel tasks must be given a thread pool to run them on.
+  static constexpr int kMaxParallelism = {{MAX_PARALLELISM}};
+
   // Byte size of each argument buffer. There are kNumArgs entries.
   static const ::tensorflow::int64 ArgSize(::tensorflow::int32 index) {
     return BufferInfos()[ArgIndexToBufferIndex()[index]].size();
@@ -579,6 +592,15 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
             AllocMode::ARGS_VARIABLES_RESULTS_PROFILES_AND_TEMPS)
       : XlaCompiledCpuFunction(StaticData(), alloc_mode) {}
 
+  // Binds `thread_pool` to the computation, which runs its parallel tasks and
+  // multi-threaded Eigen ops on it.  Same as calling set_thread_pool.
+  explicit {{CLASS}}(const Eigen::ThreadPoolDevice* thread_pool,
+            AllocMode alloc_mode =
+            AllocMode::ARGS_VARIABLES_RESULTS_PROFILES_AND_TEMPS)
+      : XlaCompiledCpuFunction(StaticData(), alloc_mode) {
+    set_thread_pool(thread_pool);
+  }
+
   {{CLASS}}(const {{CLASS}}&) = delete;
   {{CLASS}}& operator=(const {{CLASS}}&) = delete;
 
@@ -699,6 +721,7 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
       {"{{ARG_NAMES_CODE}}", arg_names_code},
       {"{{ARG_NUM}}", absl::StrCat(arg_index_table.size())},
       {"{{VARIABLE_NUM}}", absl::StrCat(config.variable_size())},
+      {"{{MAX_PARALLELISM}}", absl::StrCat(opts.max_parallelism)},
       {"{{ARG_INDEX_TABLE}}", absl::StrJoin(arg_index_table, ", ")},
       {"{{ASSIGN_PROFILE_COUNTERS_SIZE}}", assign_profile_counters_size},
       {"{{CLASS}}", opts.class_name},
@@ -730,6 +753,130 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
   return Status::OK();
 }
 
+string BatchVariantClassName(absl::string_view class_name, int64 batch_size) {
+  return absl::StrCat(class_name, "Batch", batch_size);
+}
+
+Status GenerateBatchDispatchHeader(const CodegenOpts& opts,
+                                   absl::string_view entry_point,
+                                   absl::Span<const int64> batch_sizes,
+                                   string* header) {
+  if (batch_sizes.empty()) {
+    return errors::InvalidArgument("no batch size to dispatch among");
+  }
+  for (int i = 1; i < batch_sizes.size(); ++i) {
+    if (batch_sizes[i] <= batch_sizes[i - 1]) {
+      return errors::InvalidArgument("batch sizes must be increasing");
+    }
+  }
+  string ns_start, ns_end;
+  GenNamespaceStartAndEnd(opts, &ns_start, &ns_end);
+  std::vector<string> variant_static_data;
+  for (int64 batch_size : batch_sizes) {
+    variant_static_data.push_back(absl::StrCat(
+        "      &", BatchVariantClassName(opts.class_name, batch_size),
+        "::StaticData()"));
+  }
+
+  *header =
+      R"(
+// clang-format off
+
+#ifndef TFCOMPILE_GENERATED_{{ENTRY}}_H_  // NOLINT(build/header_guard)
+#define TFCOMPILE_GENERATED_{{ENTRY}}_H_  // NOLINT(build/header_guard)
+
+#include <memory>
+
+{{NS_START}}
+// {{CLASS}} picks among the variants of a computation compiled for several
+// batch sizes.  The feeds of a variant have its batch size as dimension 0,
+// unless they are scalars.  Usage example:
+//
+//   int variant = {{CLASS}}::VariantForBatchSize(batch_size);
+//   std::unique_ptr<tensorflow::XlaCompiledCpuFunction> computation =
+//       {{CLASS}}::Create(variant);
+//   // ...set args using computation->arg_data, padding dimension 0 to
+//   // {{CLASS}}::BatchSizes()[variant]
+//   CHECK(computation->Run());
+//   // ...inspect results using computation->result_data
+//
+// The class of each variant, e.g. {{FIRST_VARIANT_CLASS}}, gives statically
+// type-safe access to its args and results instead.
+class {{CLASS}} final {
+ public:
+  // Number of variants of the computation.
+  static constexpr size_t kNumVariants = {{NUM_VARIANTS}};
+
+  // Maximum number of parallel tasks run by the ops of the variants, or 0 if
+  // they were compiled single-threaded.
+  static constexpr int kMaxParallelism = {{MAX_PARALLELISM}};
+
+  // Batch size of each variant, in increasing order.  There are kNumVariants
+  // entries.
+  static const ::tensorflow::int64* BatchSizes() {
+    static constexpr ::tensorflow::int64 kBatchSizes[kNumVariants] = {
+      {{BATCH_SIZES}}
+    };
+    return kBatchSizes;
+  }
+
+  // Returns the variant with the smallest batch size not below `batch_size`,
+  // or -1 if `batch_size` is larger than all the batch sizes.
+  static int VariantForBatchSize(::tensorflow::int64 batch_size) {
+    for (size_t i = 0; i < kNumVariants; ++i) {
+      if (BatchSizes()[i] >= batch_size) return static_cast<int>(i);
+    }
+    return -1;
+  }
+
+  // Returns static data used to create an XlaCompiledCpuFunction running the
+  // variant `variant`.
+  static const tensorflow::XlaCompiledCpuFunction::StaticData& StaticData(
+      int variant) {
+    static const tensorflow::XlaCompiledCpuFunction::StaticData* const
+      kStaticData[kNumVariants] = {
+{{VARIANT_STATIC_DATA}}
+      };
+    return *kStaticData[variant];
+  }
+
+  // Creates a computation running the variant `variant`.  If `thread_pool` is
+  // not null, the computation runs its parallel tasks and multi-threaded Eigen
+  // ops on it.
+  static std::unique_ptr<tensorflow::XlaCompiledCpuFunction> Create(
+      int variant, const Eigen::ThreadPoolDevice* thread_pool = nullptr,
+      tensorflow::XlaCompiledCpuFunction::AllocMode alloc_mode =
+      tensorflow::XlaCompiledCpuFunction::AllocMode::ARGS_VARIABLES_RESULTS_PROFILES_AND_TEMPS) {
+    std::unique_ptr<tensorflow::XlaCompiledCpuFunction> computation(
+        new tensorflow::XlaCompiledCpuFunction(StaticData(variant),
+                                               alloc_mode));
+    if (thread_pool != nullptr) {
+      computation->set_thread_pool(thread_pool);
+    }
+    return computation;
+  }
+};
+{{NS_END}}
+
+#endif  // TFCOMPILE_GENERATED_{{ENTRY}}_H_
+
+// clang-format on
+)";
+  const std::vector<std::pair<string, string>> rewrites = {
+      {"{{BATCH_SIZES}}", absl::StrJoin(batch_sizes, ", ")},
+      {"{{CLASS}}", opts.class_name},
+      {"{{ENTRY}}", string(entry_point)},
+      {"{{FIRST_VARIANT_CLASS}}",
+       BatchVariantClassName(opts.class_name, batch_sizes.front())},
+      {"{{MAX_PARALLELISM}}", absl::StrCat(opts.max_parallelism)},
+      {"{{NS_END}}\n", ns_end},
+      {"{{NS_START}}\n", ns_start},
+      {"{{NUM_VARIANTS}}", absl::StrCat(batch_sizes.size())},
+      {"{{VARIANT_STATIC_DATA}}", absl::StrJoin(variant_static_data, ",\n")}};
+  absl::StrReplaceAll(rewrites, header);
+  return Status::OK();
+}
+
 static string CreateUniqueIdentifier(const CodegenOpts& opts,
                                      absl::string_view suffix) {
   string result = "__tfcompile";
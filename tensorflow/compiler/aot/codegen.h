@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/aot/compile.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
 
@@ -48,6 +49,10 @@ struct CodegenOpts {
   // If true, emit a serialized HloProfilePrinterData protobuf that can be used
   // to pretty print HLO profile counters.
   bool gen_hlo_profile_printer_data = false;
+
+  // The maximum number of parallel tasks the function was compiled with, or 0
+  // if it is single-threaded.
+  int max_parallelism = 0;
 };
 
 // Describes a generated metadata object file.
@@ -87,6 +92,20 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
                       const CompileResult& compile_result,
                       const MetadataResult& metadata_result, string* header);
 
+// Returns the name of the class generated for the variant of the computation
+// `class_name` compiled for `batch_size`.
+string BatchVariantClassName(absl::string_view class_name, int64 batch_size);
+
+// GenerateBatchDispatchHeader generates a C++ header declaring the class
+// opts.class_name, which picks among the classes generated by GenerateHeader
+// for the variants of a computation compiled for each of `batch_sizes`, named
+// by BatchVariantClassName.  The header must follow the headers of the
+// variants.  `entry_point` names the header guard.
+Status GenerateBatchDispatchHeader(const CodegenOpts& opts,
+                                   absl::string_view entry_point,
+                                   absl::Span<const int64> batch_sizes,
+                                   string* header);
+
 // ParseCppClass parses `cpp_class` into its `class_name` and `namespaces`
 // components.  The syntax is [[<optional_namespace>::],...]<class_name>.  This
 // mirrors the C++ syntax for referring to a class, where multiple namespaces
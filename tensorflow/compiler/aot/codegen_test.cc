@@ -264,6 +264,32 @@ TEST(CodegenTest, Golden) {
   CompareWithGoldenFile("tensorflow/compiler/aot/codegen_test_h.golden", header,
                         true);
 }
+
+TEST(CodegenTest, BatchDispatchHeader) {
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  opts.namespaces = {"foo"};
+  opts.max_parallelism = 4;
+  EXPECT_EQ(BatchVariantClassName(opts.class_name, 8), "MyClassBatch8");
+
+  string header;
+  TF_ASSERT_OK(
+      GenerateBatchDispatchHeader(opts, "entry_point", {1, 8, 32}, &header));
+  EXPECT_TRUE(absl::StrContains(header, "namespace foo {")) << header;
+  EXPECT_TRUE(absl::StrContains(header, "class MyClass final")) << header;
+  EXPECT_TRUE(absl::StrContains(header, "kNumVariants = 3;")) << header;
+  EXPECT_TRUE(absl::StrContains(header, "kMaxParallelism = 4;")) << header;
+  EXPECT_TRUE(absl::StrContains(header, "1, 8, 32")) << header;
+  EXPECT_TRUE(absl::StrContains(header, "&MyClassBatch32::StaticData()"))
+      << header;
+
+  ExpectErrorContains(
+      GenerateBatchDispatchHeader(opts, "entry_point", {}, &header),
+      "batch size");
+  ExpectErrorContains(
+      GenerateBatchDispatchHeader(opts, "entry_point", {8, 1}, &header),
+      "increasing");
+}
 }  // namespace
 }  // namespace tfcompile
 }  // namespace tensorflow
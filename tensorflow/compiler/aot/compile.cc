@@ -15,12 +15,17 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/call_once.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "llvm-c/Target.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "tensorflow/compiler/aot/codegen.h"
@@ -147,6 +152,7 @@ Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  aot_opts.set_max_parallelism(flags.max_parallelism);
 
   return CompileXla(client, computation, aot_opts, compile_result);
 }
@@ -206,6 +212,66 @@ static std::string InterpolateErrorMessage(std::string message) {
   return message;
 }
 
+// Parses the comma-separated increasing batch sizes of --batch_sizes.
+static Status ParseBatchSizes(const string& value,
+                              std::vector<int64>* batch_sizes) {
+  batch_sizes->clear();
+  if (value.empty()) return Status::OK();
+  for (absl::string_view part : absl::StrSplit(value, ',')) {
+    int64 batch_size;
+    if (!absl::SimpleAtoi(part, &batch_size) || batch_size <= 0 ||
+        (!batch_sizes->empty() && batch_size <= batch_sizes->back())) {
+      return errors::InvalidArgument(
+          "--batch_sizes must be a list of increasing positive integers, got ",
+          value);
+    }
+    batch_sizes->push_back(batch_size);
+  }
+  return Status::OK();
+}
+
+// Returns the path of the object file of the variant for `batch_size`, which
+// is `path` with "_batch<batch_size>" inserted before its extension.
+static string BatchVariantPath(const string& path, int64 batch_size) {
+  absl::string_view stem = path;
+  absl::string_view extension = io::Extension(path);
+  if (!extension.empty()) {
+    stem.remove_suffix(extension.size() + 1);
+  }
+  return absl::StrCat(stem, "_batch", batch_size,
+                      extension.empty() ? "" : ".", extension);
+}
+
+// Compiles the graph, writes its function and metadata object files, and
+// generates the header of its class in `header`.
+static Status CompileAndWriteObjects(GraphDef graph_def,
+                                     const tf2xla::Config& config,
+                                     const MainFlags& flags,
+                                     const CodegenOpts& codegen_opts,
+                                     string* header) {
+  CompileResult compile_result;
+  Status status =
+      CompileGraph(std::move(graph_def), config, flags, &compile_result);
+  if (!status.ok()) {
+    return Status(status.code(),
+                  InterpolateErrorMessage(status.error_message()));
+  }
+
+  // Write output files.
+  Env* env = Env::Default();
+  const std::vector<char>& obj = compile_result.aot->object_file_data();
+  TF_RETURN_IF_ERROR(
+      WriteStringToFile(env, flags.out_function_object,
+                        absl::string_view(obj.data(), obj.size())));
+  MetadataResult metadata_result;
+  TF_RETURN_IF_ERROR(
+      GenerateMetadata(codegen_opts, compile_result, &metadata_result));
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
+                                       metadata_result.object_file_data));
+  return GenerateHeader(codegen_opts, config, compile_result, metadata_result,
+                        header);
+}
+
 Status Main(const MainFlags& flags) {
   absl::call_once(targets_init, &InitializeTargets);
 
@@ -231,25 +297,12 @@ Status Main(const MainFlags& flags) {
   }
   GraphDef graph_def;
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.graph, &graph_def));
-  CompileResult compile_result;
 
-  Status status =
-      CompileGraph(std::move(graph_def), config, flags, &compile_result);
-  if (!status.ok()) {
-    return Status(status.code(),
-                  InterpolateErrorMessage(status.error_message()));
-  }
-
-  // Write output files.
-  Env* env = Env::Default();
-  const std::vector<char>& obj = compile_result.aot->object_file_data();
-  TF_RETURN_IF_ERROR(
-      WriteStringToFile(env, flags.out_function_object,
-                        absl::string_view(obj.data(), obj.size())));
   CodegenOpts codegen_opts;
   codegen_opts.gen_name_to_index = flags.gen_name_to_index;
   codegen_opts.gen_program_shape = flags.gen_program_shape;
   codegen_opts.target_triple = flags.target_triple;
+  codegen_opts.max_parallelism = std::max(flags.max_parallelism, 0);
   if (flags.cpp_class.empty()) {
     return errors::InvalidArgument("Must specify --cpp_class");
   }
@@ -257,16 +310,47 @@ Status Main(const MainFlags& flags) {
       xla::GetDebugOptionsFromFlags().xla_hlo_profile();
   TF_RETURN_IF_ERROR(ParseCppClass(flags.cpp_class, &codegen_opts.class_name,
                                    &codegen_opts.namespaces));
+  std::vector<int64> batch_sizes;
+  TF_RETURN_IF_ERROR(ParseBatchSizes(flags.batch_sizes, &batch_sizes));
 
-  MetadataResult metadata_result;
-  TF_RETURN_IF_ERROR(
-      GenerateMetadata(codegen_opts, compile_result, &metadata_result));
-  TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
-                                       metadata_result.object_file_data));
   string header;
-  TF_RETURN_IF_ERROR(GenerateHeader(codegen_opts, config, compile_result,
-                                    metadata_result, &header));
-  TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_header, header));
+  if (batch_sizes.empty()) {
+    TF_RETURN_IF_ERROR(CompileAndWriteObjects(
+        std::move(graph_def), config, flags, codegen_opts, &header));
+  } else {
+    // Compiles a variant per batch size, each with its own entry point, object
+    // files and class, followed by the class picking among them.
+    for (int64 batch_size : batch_sizes) {
+      tf2xla::Config variant_config = config;
+      for (tf2xla::Feed& feed : *variant_config.mutable_feed()) {
+        if (feed.shape().dim_size() > 0) {
+          feed.mutable_shape()->mutable_dim(0)->set_size(batch_size);
+        }
+      }
+      MainFlags variant_flags = flags;
+      variant_flags.entry_point =
+          absl::StrCat(flags.entry_point, "_batch", batch_size);
+      variant_flags.out_function_object =
+          BatchVariantPath(flags.out_function_object, batch_size);
+      variant_flags.out_metadata_object =
+          BatchVariantPath(flags.out_metadata_object, batch_size);
+      CodegenOpts variant_codegen_opts = codegen_opts;
+      variant_codegen_opts.class_name =
+          BatchVariantClassName(codegen_opts.class_name, batch_size);
+      string variant_header;
+      TF_RETURN_IF_ERROR(CompileAndWriteObjects(graph_def, variant_config,
+                                                variant_flags,
+                                                variant_codegen_opts,
+                                                &variant_header));
+      header += variant_header;
+    }
+    string dispatch_header;
+    TF_RETURN_IF_ERROR(GenerateBatchDispatchHeader(
+        codegen_opts, flags.entry_point, batch_sizes, &dispatch_header));
+    header += dispatch_header;
+  }
+  TF_RETURN_IF_ERROR(
+      WriteStringToFile(Env::Default(), flags.out_header, header));
   return Status::OK();
 }
 
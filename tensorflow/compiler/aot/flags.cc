@@ -80,6 +80,16 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
       {"experimental_quantize", &flags->experimental_quantize,
        "If set, quantization passes will run and dump the result before HLO "
        "code generation."},
+      {"max_parallelism", &flags->max_parallelism,
+       "If positive, large ops are split into up to this many parallel tasks, "
+       "which run on the thread pool bound with set_thread_pool.  The "
+       "generated code then requires a thread pool."},
+      {"batch_sizes", &flags->batch_sizes,
+       "Comma-separated list of increasing batch sizes.  If set, the graph is "
+       "compiled once per batch size, with dimension 0 of the non-scalar feeds "
+       "set to the batch size, and --cpp_class picks among the variants.  The "
+       "object files of each variant are named after --out_function_object "
+       "and --out_metadata_object, suffixed with _batch<size>."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
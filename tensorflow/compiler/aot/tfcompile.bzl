@@ -40,6 +40,7 @@ def tf_library(
         enable_xla_hlo_profiling = False,
         enable_tracemes = False,
         mlir_components = "None",
+        batch_sizes = None,
         deps = None,
         tags = []):
     """Runs tfcompile to compile a TensorFlow graph into executable code with fast
@@ -96,6 +97,12 @@ def tf_library(
         Xprof to construct profiler timelines.
       mlir_components: When the value is "None", no components use MLIR. When
         the value is "Bridge", use MLIR to translate GraphDef to HLO.
+      batch_sizes: If provided, a list of increasing batch sizes to compile a
+        variant of the graph for each.  Each variant sets dimension 0 of the
+        non-scalar feeds to its batch size, and is generated as the class
+        <cpp_class>Batch<size>; cpp_class then names a class picking among the
+        variants.  The generated test exercises the first variant, and the
+        generated benchmark reports the latency of every variant.
       deps: a list of deps to include on the build rules for the generated
         library, added to the standard deps if standard_runtime_deps is True.
       tags: tags to apply to subsidiary build rules.
@@ -172,6 +179,22 @@ def tf_library(
     metadata_object_file = name + "_tfcompile_metadata.o"
     function_object_file = name + "_tfcompile_function.o"
 
+    # With batch sizes, tfcompile writes an object file pair per variant,
+    # suffixed with the batch size of the variant, instead of the pair above.
+    if batch_sizes:
+        object_files = []
+        for batch_size in batch_sizes:
+            object_files += [
+                "%s_tfcompile_metadata_batch%d.o" % (name, batch_size),
+                "%s_tfcompile_function_batch%d.o" % (name, batch_size),
+            ]
+        batch_sizes_flag = " --batch_sizes=" + ",".join(
+            [str(batch_size) for batch_size in batch_sizes],
+        )
+    else:
+        object_files = [metadata_object_file, function_object_file]
+        batch_sizes_flag = ""
+
     # The XLA backends morph kernal name prefix __ that is not in the form of
     # __xla_.
     ep = ("__xla_" + native.package_name() + "__" + name).replace("/", "_")
@@ -222,11 +245,7 @@ def tf_library(
     native.genrule(
         name = ("gen_" + name),
         srcs = srcs,
-        outs = [
-            header_file,
-            metadata_object_file,
-            function_object_file,
-        ],
+        outs = [header_file] + object_files,
         cmd = (
             default_fast_math_xla_flags +
             "CUDA_VISIBLE_DEVICES='' " +
@@ -240,6 +259,7 @@ def tf_library(
             " --out_header=$(@D)/" + header_file +
             " --out_metadata_object=$(@D)/" + metadata_object_file +
             " --out_function_object=$(@D)/" + function_object_file +
+            batch_sizes_flag +
             " " + flags + " " + profiling_flag + " " + mlir_flag + " " + traceme_flag
         ),
         tools = [tfcompile_tool],
@@ -292,7 +312,7 @@ def tf_library(
     # kernel implementations.
     native.cc_library(
         name = name,
-        srcs = [function_object_file, metadata_object_file],
+        srcs = object_files,
         hdrs = [header_file],
         visibility = visibility,
         testonly = testonly,
@@ -312,6 +332,7 @@ def tf_library(
             # TODO(cwhipkey): only depend on kernel code that the model actually
             # needed.
             "//tensorflow/compiler/xla/service/cpu:runtime_conv2d",
+            "//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
             "//tensorflow/compiler/xla/service/cpu:runtime_key_value_sort",
             "//tensorflow/compiler/xla/service/cpu:runtime_matmul",
             "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_conv2d",
@@ -333,6 +354,17 @@ def tf_library(
         "-e \"s|{{TFCOMPILE_NAME}}|" + no_ns_name + "|g\" "
     )
 
+    # The generated test exercises a single class, which is the first variant
+    # when compiling for several batch sizes.
+    test_sed_replace = sed_replace
+    if batch_sizes:
+        test_sed_replace = (
+            "-e \"s|{{TFCOMPILE_HEADER}}|$(location " + header_file + ")|g\" " +
+            "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + cpp_class + "Batch" +
+            str(batch_sizes[0]) + "|g\" " +
+            "-e \"s|{{TFCOMPILE_NAME}}|" + no_ns_name + "|g\" "
+        )
+
     if gen_test:
         test_name = name + "_test"
         test_file = test_name + ".cc"
@@ -347,7 +379,7 @@ def tf_library(
             ],
             outs = [test_file],
             cmd = (
-                "sed " + sed_replace +
+                "sed " + test_sed_replace +
                 " $(location //tensorflow/compiler/aot:test.cc) " +
                 "> $(OUTS)"
             ),
@@ -376,8 +408,12 @@ def tf_library(
     if gen_benchmark:
         benchmark_name = name + "_benchmark"
         benchmark_file = benchmark_name + ".cc"
-        benchmark_main = ("//tensorflow/compiler/aot:" +
-                          "benchmark_main.template")
+        if batch_sizes:
+            benchmark_main = ("//tensorflow/compiler/aot:" +
+                              "benchmark_batch_variants_main.template")
+        else:
+            benchmark_main = ("//tensorflow/compiler/aot:" +
+                              "benchmark_main.template")
 
         # Rule to rewrite benchmark.cc to produce the benchmark_file.
         native.genrule(
@@ -0,0 +1,416 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/batch_bucketing.h"
+
+#include <limits>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+// How a tensor of a cluster relates to the batch dimension.
+struct BatchInfo {
+  // True if dimension 0 of the tensor is the batch dimension.
+  bool is_batch = false;
+
+  // The rank of the tensor, or -1 if it is unknown.
+  int rank = -1;
+};
+
+// Ops computing each element of their output from the same element of their
+// only input.
+bool IsElementwiseUnaryOp(const Node& n) {
+  static const auto* ops = new absl::flat_hash_set<string>{
+      "Abs",          "Cast",         "Ceil",         "Elu",
+      "Erf",          "Exp",          "Floor",        "Identity",
+      "LeakyRelu",    "Log",          "Log1p",        "Neg",
+      "Reciprocal",   "Relu",         "Relu6",        "Round",
+      "Rsqrt",        "Selu",         "Sigmoid",      "Sign",
+      "Snapshot",     "Softplus",     "Softsign",     "Sqrt",
+      "Square",       "StopGradient", "Tanh"};
+  return ops->contains(n.type_string());
+}
+
+// Ops computing each element of their output from the elements of their two
+// broadcast inputs at the same index.
+bool IsElementwiseBinaryOp(const Node& n) {
+  static const auto* ops = new absl::flat_hash_set<string>{
+      "Add",               "AddV2",             "Div",
+      "DivNoNan",          "FloorDiv",          "FloorMod",
+      "Maximum",           "Minimum",           "Mul",
+      "Pow",               "RealDiv",           "SquaredDifference",
+      "Sub"};
+  return ops->contains(n.type_string());
+}
+
+// Ops taking batches of images as their first input, and computing each image
+// of their output from the same image.
+bool IsImageOp(const Node& n) {
+  static const auto* ops = new absl::flat_hash_set<string>{
+      "AvgPool", "Conv2D", "DepthwiseConv2dNative", "MaxPool"};
+  return ops->contains(n.type_string());
+}
+
+bool IsReductionOp(const Node& n) {
+  static const auto* ops =
+      new absl::flat_hash_set<string>{"Max", "Mean", "Min", "Prod", "Sum"};
+  return ops->contains(n.type_string());
+}
+
+// Returns the value of the constant `n`, or false if it is not a constant.
+bool GetConstantValue(const Node& n, Tensor* value) {
+  const TensorProto* proto;
+  return n.type_string() == "Const" &&
+         GetNodeAttr(n.attrs(), "value", &proto).ok() &&
+         value->FromProto(*proto);
+}
+
+// Returns the rank of the output of the reduction `n` of a tensor of rank
+// `rank`, or -1 if it may reduce the batch dimension.
+int ReducedRank(const Node& n, int rank) {
+  const Edge* axes_edge;
+  Tensor axes;
+  if (rank < 1 || !n.input_edge(1, &axes_edge).ok() ||
+      !GetConstantValue(*axes_edge->src(), &axes) ||
+      (axes.dtype() != DT_INT32 && axes.dtype() != DT_INT64)) {
+    return -1;
+  }
+  absl::flat_hash_set<int64> reduced;
+  for (int64 i = 0; i < axes.NumElements(); ++i) {
+    int64 axis = axes.dtype() == DT_INT32 ? axes.flat<int32>()(i)
+                                          : axes.flat<int64>()(i);
+    if (axis < 0) axis += rank;
+    if (axis <= 0 || axis >= rank) return -1;
+    reduced.insert(axis);
+  }
+  bool keep_dims;
+  if (!GetNodeAttr(n.attrs(), "keep_dims", &keep_dims).ok()) return -1;
+  return keep_dims ? rank : rank - static_cast<int>(reduced.size());
+}
+
+// Computes the batch information of the outputs of `n` from the one of its
+// `inputs`. Returns false if a row of a batch input may affect another row of
+// an output.
+bool PropagateThroughNode(const Node& n, absl::Span<const BatchInfo> inputs,
+                          std::vector<BatchInfo>* outputs) {
+  const bool has_batch_input =
+      absl::c_any_of(inputs, [](const BatchInfo& i) { return i.is_batch; });
+  if (!has_batch_input) {
+    Tensor value;
+    if (GetConstantValue(n, &value)) {
+      (*outputs)[0].rank = value.dims();
+    } else if (IsElementwiseUnaryOp(n) && inputs.size() == 1) {
+      (*outputs)[0].rank = inputs[0].rank;
+    }
+    return true;
+  }
+
+  if (IsElementwiseUnaryOp(n)) {
+    if (inputs.size() != 1) return false;
+    (*outputs)[0] = inputs[0];
+    return true;
+  }
+  if (IsElementwiseBinaryOp(n)) {
+    if (inputs.size() != 2) return false;
+    const BatchInfo& a = inputs[0];
+    const BatchInfo& b = inputs[1];
+    if (a.is_batch && b.is_batch) {
+      // Operands of different ranks would align the batch dimension of one
+      // with another dimension of the other.
+      if (a.rank < 0 || a.rank != b.rank) return false;
+      (*outputs)[0] = a;
+      return true;
+    }
+    // The other operand must be broadcast along the batch dimension.
+    const BatchInfo& batch = a.is_batch ? a : b;
+    const BatchInfo& other = a.is_batch ? b : a;
+    if (batch.rank < 0 || other.rank < 0 || other.rank >= batch.rank) {
+      return false;
+    }
+    (*outputs)[0] = batch;
+    return true;
+  }
+
+  const string& op = n.type_string();
+  if (op == "BiasAdd") {
+    if (inputs.size() != 2 || !inputs[0].is_batch || inputs[1].is_batch) {
+      return false;
+    }
+    (*outputs)[0] = inputs[0];
+    return true;
+  }
+  if (op == "Softmax" || op == "LogSoftmax") {
+    // Normalizes along the last dimension, which is not the batch dimension.
+    if (inputs[0].rank < 2) return false;
+    (*outputs)[0] = inputs[0];
+    return true;
+  }
+  if (op == "MatMul") {
+    bool transpose_a;
+    if (inputs.size() != 2 || !inputs[0].is_batch || inputs[1].is_batch ||
+        !GetNodeAttr(n.attrs(), "transpose_a", &transpose_a).ok() ||
+        transpose_a) {
+      return false;
+    }
+    (*outputs)[0] = {/*is_batch=*/true, /*rank=*/2};
+    return true;
+  }
+  if (IsImageOp(n)) {
+    // The batch is the dimension 0 of the NHWC and NCHW formats alike.
+    if (!inputs[0].is_batch) return false;
+    for (int i = 1; i < inputs.size(); ++i) {
+      if (inputs[i].is_batch) return false;
+    }
+    (*outputs)[0] = {/*is_batch=*/true, /*rank=*/4};
+    return true;
+  }
+  if (IsReductionOp(n)) {
+    if (inputs.size() != 2 || !inputs[0].is_batch || inputs[1].is_batch) {
+      return false;
+    }
+    const int rank = ReducedRank(n, inputs[0].rank);
+    if (rank < 1) return false;
+    (*outputs)[0] = {/*is_batch=*/true, rank};
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+xla::StatusOr<std::vector<int32>> ParseBatchBuckets(absl::string_view value) {
+  std::vector<int32> buckets;
+  if (value.empty()) return buckets;
+  if (value == "pow2") {
+    for (int32 bucket = 1; bucket > 0 && bucket <= (1 << 30); bucket <<= 1) {
+      buckets.push_back(bucket);
+    }
+    return buckets;
+  }
+  for (absl::string_view s : absl::StrSplit(value, ',')) {
+    int32 bucket;
+    if (!absl::SimpleAtoi(s, &bucket) || bucket <= 0 ||
+        (!buckets.empty() && bucket <= buckets.back())) {
+      return errors::InvalidArgument(
+          "Invalid batch buckets \"", value,
+          "\": expected \"pow2\" or increasing positive sizes.");
+    }
+    buckets.push_back(bucket);
+  }
+  return buckets;
+}
+
+bool PropagateBatchDimension(const Graph& body,
+                             absl::Span<const bool> batch_args,
+                             absl::Span<const int> arg_ranks,
+                             std::vector<bool>* batch_retvals) {
+  std::vector<std::vector<BatchInfo>> infos(body.num_node_ids());
+  std::vector<Node*> order;
+  GetReversePostOrder(body, &order);
+  for (Node* n : order) {
+    std::vector<BatchInfo> inputs(n->num_inputs());
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      // The sources of back edges are not visited yet, but the loops have no
+      // batch input, as no op entering them propagates the batch dimension.
+      const std::vector<BatchInfo>& src_infos = infos[e->src()->id()];
+      if (e->src_output() < src_infos.size()) {
+        inputs[e->dst_input()] = src_infos[e->src_output()];
+      }
+    }
+    std::vector<BatchInfo>& outputs = infos[n->id()];
+    outputs.resize(n->num_outputs());
+
+    if (n->IsArg() || n->IsRetval()) {
+      int index;
+      if (!GetNodeAttr(n->attrs(), "index", &index).ok() || index < 0) {
+        return false;
+      }
+      if (n->IsArg()) {
+        if (index >= batch_args.size()) return false;
+        outputs[0] = {batch_args[index], arg_ranks[index]};
+      } else {
+        if (index >= batch_retvals->size()) return false;
+        (*batch_retvals)[index] = inputs[0].is_batch;
+      }
+      continue;
+    }
+    if (!PropagateThroughNode(*n, inputs, &outputs)) {
+      VLOG(2) << "The rows of the batch may mix in " << n->name() << " ("
+              << n->type_string() << ")";
+      return false;
+    }
+  }
+  return true;
+}
+
+Status BucketBatchDimension(const FunctionLibraryDefinition& flib_def,
+                            const GraphShapeInfo& shape_info,
+                            absl::Span<const int32> buckets, Graph* graph,
+                            Node* n) {
+  int num_constant_inputs, num_resource_inputs;
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(n->attrs(), kXlaNumConstantArgsAttr, &num_constant_inputs));
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(n->attrs(), kXlaNumResourceArgsAttr, &num_resource_inputs));
+  std::vector<const Edge*> input_edges;
+  TF_RETURN_IF_ERROR(n->input_edges(&input_edges));
+
+  // The batch inputs are the non-constant inputs with a dynamic dimension 0.
+  const int num_inputs = n->num_inputs();
+  std::vector<bool> batch_args(num_inputs, false);
+  std::vector<int> arg_ranks(num_inputs, -1);
+  std::vector<int> batch_inputs;
+  for (int i = 0; i < num_inputs; ++i) {
+    const Edge* e = input_edges[i];
+    auto it = shape_info.find(e->src()->name());
+    if (it == shape_info.end() || e->src_output() >= it->second.size()) {
+      continue;
+    }
+    const PartialTensorShape& shape = it->second[e->src_output()].shape;
+    if (shape.unknown_rank()) continue;
+    arg_ranks[i] = shape.dims();
+    if (i >= num_constant_inputs && i < num_inputs - num_resource_inputs &&
+        n->input_type(i) != DT_RESOURCE && shape.dims() >= 1 &&
+        shape.dim_size(0) < 0) {
+      batch_args[i] = true;
+      batch_inputs.push_back(i);
+    }
+  }
+  if (batch_inputs.empty()) return Status::OK();
+
+  const FunctionDef* fdef = flib_def.Find(n->type_string());
+  if (fdef == nullptr) {
+    return errors::Internal("Cannot find the function of the cluster ",
+                            n->name());
+  }
+  std::unique_ptr<FunctionBody> fbody;
+  TF_RETURN_IF_ERROR(
+      FunctionDefToBodyHelper(*fdef, n->attrs(), &flib_def, &fbody));
+  std::vector<bool> batch_retvals(n->num_outputs(), false);
+  if (!PropagateBatchDimension(*fbody->graph, batch_args, arg_ranks,
+                               &batch_retvals)) {
+    VLOG(1) << "Not bucketing the batch dimension of " << n->name()
+            << ": its rows may mix.";
+    return Status::OK();
+  }
+  VLOG(1) << "Bucketing the batch dimension of " << n->name();
+
+  Status status;
+  Scope root = NewInternalScope(graph, &status, /*refiner=*/nullptr)
+                   .NewSubScope(absl::StrCat(n->name(), "_bucketing"))
+                   .WithDevice(n->requested_device())
+                   .WithAssignedDevice(n->assigned_device_name());
+  auto dimension_0 = [&](Output x) -> Output {
+    return ops::StridedSlice(root, ops::Shape(root, x), {0}, {1}, {1},
+                             ops::StridedSlice::ShrinkAxisMask(1));
+  };
+
+  // The batch size is the largest dimension 0 of the batch inputs.  The
+  // inputs of a smaller size, which is 1 unless the cluster fails, are
+  // broadcast along the batch dimension and are not padded.
+  std::vector<Output> input_sizes;
+  Output batch_size;
+  for (int i : batch_inputs) {
+    input_sizes.push_back(dimension_0(
+        Output(input_edges[i]->src(), input_edges[i]->src_output())));
+    batch_size = i == batch_inputs.front()
+                     ? input_sizes.back()
+                     : ops::Maximum(root, batch_size, input_sizes.back());
+  }
+
+  // Rounds the batch size up to the smallest bucket not below it, if any.
+  constexpr int32 kNoBucket = std::numeric_limits<int32>::max();
+  const TensorShape buckets_shape({static_cast<int64>(buckets.size())});
+  Output bucket_sizes = ops::Const(
+      root, gtl::ArraySlice<int32>(buckets.data(), buckets.size()),
+      buckets_shape);
+  Output smallest_bucket = ops::Min(
+      root,
+      ops::Select(root, ops::GreaterEqual(root, bucket_sizes, batch_size),
+                  bucket_sizes, ops::Const(root, kNoBucket, buckets_shape)),
+      0);
+  Output bucket =
+      ops::Select(root, ops::Equal(root, smallest_bucket, kNoBucket),
+                  batch_size, smallest_bucket);
+  Output padding = ops::Sub(root, bucket, batch_size);
+  Output zero = ops::Const(root, 0);
+
+  for (int j = 0; j < batch_inputs.size(); ++j) {
+    const int i = batch_inputs[j];
+    Output pad = ops::Select(root, ops::Equal(root, input_sizes[j], batch_size),
+                             padding, zero);
+    Output paddings = ops::Reshape(root, ops::Stack(root, {zero, pad}), {1, 2});
+    if (arg_ranks[i] > 1) {
+      Output zero_paddings =
+          ops::Const(root, 0, TensorShape({arg_ranks[i] - 1, 2}));
+      paddings = ops::Concat(root, {paddings, zero_paddings}, 0);
+    }
+    ops::Pad padded(
+        root.WithOpName("pad_", i),
+        Output(input_edges[i]->src(), input_edges[i]->src_output()), paddings);
+    TF_RETURN_IF_ERROR(root.status());
+    TF_RETURN_IF_ERROR(graph->UpdateEdge(padded.output.node(), 0, n, i));
+  }
+
+  std::vector<std::vector<const Edge*>> output_edges(n->num_outputs());
+  for (const Edge* e : n->out_edges()) {
+    if (!e->IsControlEdge()) output_edges[e->src_output()].push_back(e);
+  }
+  for (int i = 0; i < n->num_outputs(); ++i) {
+    if (!batch_retvals[i] || output_edges[i].empty()) continue;
+    // The outputs padded to the bucket are sliced back to the batch size.
+    Output output(n, i);
+    Output output_shape = ops::Shape(root, output);
+    Output output_size = dimension_0(output);
+    Output sliced_size =
+        ops::Select(root, ops::Equal(root, output_size, bucket), batch_size,
+                    output_size);
+    Output size = ops::Concat(
+        root,
+        {ops::Reshape(root, sliced_size, {1}),
+         ops::Slice(root, output_shape, {1}, {-1})},
+        0);
+    ops::Slice sliced(root.WithOpName("slice_", i), output,
+                      ops::ZerosLike(root, output_shape), size);
+    TF_RETURN_IF_ERROR(root.status());
+    for (const Edge* e : output_edges[i]) {
+      TF_RETURN_IF_ERROR(graph->UpdateEdge(sliced.output.node(), 0, e->dst(),
+                                           e->dst_input()));
+    }
+  }
+  return root.status();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,64 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Rounds the dynamic batch dimension of XLA clusters up to a few bucket
+// sizes, so that a cluster fed batches of many sizes is only compiled once per
+// bucket.  The batch inputs of a cluster are padded with zeros to the bucket
+// and its batch outputs are sliced back to the batch size, which is only done
+// for the clusters in which no row of the batch affects another row.
+
+#ifndef TENSORFLOW_COMPILER_JIT_BATCH_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_BATCH_BUCKETING_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+// Parses the bucket sizes of --tf_xla_batch_buckets: "pow2" for the powers of
+// two, or a comma-separated list of increasing sizes.  Returns no buckets if
+// `value` is empty, which disables bucketing.
+xla::StatusOr<std::vector<int32>> ParseBatchBuckets(absl::string_view value);
+
+// Finds the results of the function `body` whose dimension 0 is the batch
+// dimension, given whether it is the dimension 0 of each argument in
+// `batch_args`, and the rank of each argument in `arg_ranks` (-1 if unknown).
+// Returns false if a row of a batch argument may affect another row of a
+// result, in which case the batch dimension cannot be padded.
+// `batch_retvals` must hold an element per result.
+bool PropagateBatchDimension(const Graph& body,
+                             absl::Span<const bool> batch_args,
+                             absl::Span<const int> arg_ranks,
+                             std::vector<bool>* batch_retvals);
+
+// Pads the batch inputs of the XLA cluster call `n` in `graph` to the smallest
+// of `buckets` not below the batch size, and slices its batch outputs back to
+// the batch size.  The batch inputs are the non-constant inputs whose
+// dimension 0 is dynamic in `shape_info`.  Leaves `n` unchanged if it has no
+// batch input, or if its rows may mix.
+Status BucketBatchDimension(const FunctionLibraryDefinition& flib_def,
+                            const GraphShapeInfo& shape_info,
+                            absl::Span<const int32> buckets, Graph* graph,
+                            Node* n);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_BATCH_BUCKETING_H_
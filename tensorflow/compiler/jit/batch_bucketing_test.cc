@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/batch_bucketing.h"
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/function_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(BatchBucketingTest, ParseBatchBuckets) {
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<int32> buckets, ParseBatchBuckets(""));
+  EXPECT_TRUE(buckets.empty());
+
+  TF_ASSERT_OK_AND_ASSIGN(buckets, ParseBatchBuckets("pow2"));
+  ASSERT_EQ(buckets.size(), 31);
+  EXPECT_EQ(buckets[0], 1);
+  EXPECT_EQ(buckets[4], 16);
+
+  TF_ASSERT_OK_AND_ASSIGN(buckets, ParseBatchBuckets("8,32,128"));
+  EXPECT_EQ(buckets, std::vector<int32>({8, 32, 128}));
+
+  EXPECT_FALSE(ParseBatchBuckets("32,8").ok());
+  EXPECT_FALSE(ParseBatchBuckets("0,8").ok());
+  EXPECT_FALSE(ParseBatchBuckets("eight").ok());
+}
+
+TEST(BatchBucketingTest, PropagatesThroughRowwiseOps) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto w = ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto b = ops::Const(root.WithOpName("b"), {1.0f, 2.0f});
+  auto matmul = ops::MatMul(root.WithOpName("matmul"), x, w);
+  auto bias_add = ops::BiasAdd(root.WithOpName("bias_add"), matmul, b);
+  auto relu = ops::Relu(root.WithOpName("relu"), bias_add);
+  auto scaled = ops::Mul(root.WithOpName("scaled"), relu, 0.5f);
+  auto softmax = ops::Softmax(root.WithOpName("softmax"), scaled);
+  auto mean = ops::Mean(root.WithOpName("mean"), softmax, {1});
+  ops::_Retval(root.WithOpName("softmax_out"), softmax, 0);
+  ops::_Retval(root.WithOpName("mean_out"), mean, 1);
+  ops::_Retval(root.WithOpName("w_out"), w, 2);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+
+  std::vector<bool> batch_retvals(3);
+  ASSERT_TRUE(PropagateBatchDimension(graph, /*batch_args=*/{true, false},
+                                      /*arg_ranks=*/{2, 2}, &batch_retvals));
+  EXPECT_EQ(batch_retvals, std::vector<bool>({true, true, false}));
+}
+
+TEST(BatchBucketingTest, RejectsOpsMixingRows) {
+  auto propagate = [](const Scope& root) {
+    Graph graph(OpRegistry::Global());
+    TF_CHECK_OK(root.ToGraph(&graph));
+    std::vector<bool> batch_retvals(1);
+    return PropagateBatchDimension(graph, /*batch_args=*/{true},
+                                   /*arg_ranks=*/{2}, &batch_retvals);
+  };
+
+  {
+    // Reduces the batch dimension.
+    Scope root = Scope::NewRootScope().ExitOnError();
+    auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+    ops::_Retval(root.WithOpName("out"), ops::Sum(root, x, {0}), 0);
+    EXPECT_FALSE(propagate(root));
+  }
+  {
+    // Moves the batch dimension.
+    Scope root = Scope::NewRootScope().ExitOnError();
+    auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+    ops::_Retval(root.WithOpName("out"), ops::Transpose(root, x, {1, 0}), 0);
+    EXPECT_FALSE(propagate(root));
+  }
+  {
+    // May add a different row to each row of the batch.
+    Scope root = Scope::NewRootScope().ExitOnError();
+    auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+    auto y = ops::Const(root.WithOpName("y"), {{1.0f}, {2.0f}});
+    ops::_Retval(root.WithOpName("out"), ops::Add(root, x, y), 0);
+    EXPECT_FALSE(propagate(root));
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
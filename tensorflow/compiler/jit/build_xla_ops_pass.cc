@@ -25,10 +25,12 @@ limitations under the License.
 #include "tensorflow/cc/ops/control_flow_ops.h"
 #include "tensorflow/cc/ops/functional_ops.h"
 #include "tensorflow/cc/ops/logging_ops.h"
+#include "tensorflow/compiler/jit/batch_bucketing.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/jit/device_util.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/cc/ops/xla_jit_ops.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
@@ -601,6 +603,18 @@ Status BuildXlaOpsPass::Run(const GraphOptimizationPassOptions& options) {
   VLOG(1) << "check_input_numerics = " << debugging_opts.check_input_numerics;
   VLOG(1) << "check_output_numerics = " << debugging_opts.check_output_numerics;
 
+  TF_ASSIGN_OR_RETURN(std::vector<int32> batch_buckets,
+                      ParseBatchBuckets(flags.tf_xla_batch_buckets));
+  if (!batch_buckets.empty() && !xla_compiled_kernels.empty()) {
+    GraphShapeInfo shape_info;
+    TF_RETURN_IF_ERROR(InferShapes(graph, /*arg_shapes=*/{},
+                                   options.flib_def, &shape_info));
+    for (Node* n : xla_compiled_kernels) {
+      TF_RETURN_IF_ERROR(BucketBatchDimension(
+          *options.flib_def, shape_info, batch_buckets, graph, n));
+    }
+  }
+
   for (Node* n : xla_compiled_kernels) {
     TF_RETURN_IF_ERROR(ReplaceNodeWithXlaCompileAndXlaRun(
         &device_info_cache, options, *options.flib_def,
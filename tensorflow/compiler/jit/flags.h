@@ -98,6 +98,22 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, _XlaCompile compiles the clusters which need not be compiled on
+  // background threads, and the clusters run in the TF executor until their
+  // compilation completes.  Defaults to false.
+  bool tf_xla_async_compilation;
+
+  // If non-empty, the XLA computations compiled by the _Xla* kernels are also
+  // written to this directory once optimized, and later processes sharing it
+  // only run the compiler backends on them.  Defaults to empty.
+  string tf_xla_persistent_cache_directory;
+
+  // If true, the _Xla* kernels compile a cluster for new dimension sizes of its
+  // arguments by inferring the shapes of the XLA computation it was first
+  // lowered to again, when the computation does not depend on them, rather
+  // than by lowering the cluster again.  Defaults to false.
+  bool tf_xla_respecialize_lowering;
 };
 
 // Flags for the build_xla_ops pass.
@@ -121,6 +137,12 @@ struct BuildXlaOpsPassFlags {
   // Disables all constant folding. The primary use for this is for testing to
   // guarantee that tests are run on XLA and not on TF's CPU implementation.
   bool tf_xla_disable_constant_folding;
+
+  // If non-empty, the dynamic batch dimension of the XLA clusters whose rows
+  // are independent is padded to these buckets, which bounds the number of
+  // compilations: "pow2" for the powers of two, or a comma-separated list of
+  // increasing sizes.  Defaults to empty.
+  string tf_xla_batch_buckets;
 };
 
 // Flags for the IntroduceFloatingPointJitter pass.
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -28,6 +30,10 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/hlo.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -40,8 +46,12 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/public/version.h"
@@ -55,12 +65,24 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
+constexpr int XlaCompilationCache::kNumAsyncCompilerThreads;
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
-                                         DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+                                         DeviceType device_type,
+                                         string persistent_cache_directory)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      persistent_cache_directory_(std::move(persistent_cache_directory)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for the background compilations, which write into the cache entries.
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads;
+  {
+    mutex_lock lock(async_compiler_mu_);
+    async_compiler_threads = std::move(async_compiler_threads_);
+  }
+  async_compiler_threads.reset();
+
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -174,14 +196,139 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_device_allocator(options.device_allocator);
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
 
+  string path;
+  if (!persistent_cache_directory_.empty()) {
+    xla::StatusOr<uint64> fingerprint = PersistentCacheFingerprint(
+        *result.computation, argument_layouts, build_options);
+    if (fingerprint.ok()) {
+      path = io::JoinPath(
+          persistent_cache_directory_,
+          absl::StrCat("xla_", strings::Hex(fingerprint.ValueOrDie()), ".pb"));
+      Status status = LoadPersistedExecutable(path, argument_layouts,
+                                              build_options, executable);
+      if (status.ok()) return Status::OK();
+      if (!errors::IsNotFound(status)) {
+        LOG(WARNING) << "Failed to load the persisted XLA computation " << path
+                     << ", compiling it again: " << status;
+      }
+    } else {
+      LOG(WARNING) << "Not persisting the XLA computation "
+                   << result.computation->proto().name() << ": "
+                   << fingerprint.status();
+    }
+  }
+
   TF_ASSIGN_OR_RETURN(
       auto executables,
       client_->Compile(*result.computation, argument_layouts, build_options));
   TF_RET_CHECK(executables.size() == 1);
   *executable = std::move(executables[0]);
+
+  if (!path.empty()) {
+    Status status = PersistExecutable(path, **executable);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to persist the XLA computation " << path << ": "
+                   << status;
+    }
+  }
   return Status::OK();
 }
 
+xla::StatusOr<uint64> XlaCompilationCache::PersistentCacheFingerprint(
+    const xla::XlaComputation& computation,
+    absl::Span<const xla::Shape* const> argument_layouts,
+    const xla::ExecutableBuildOptions& build_options) const {
+  // The optimized modules depend on the XLA flags, and the modules on disk may
+  // be read by processes running another version.
+  const xla::DebugOptions debug_options = xla::GetDebugOptionsFromFlags();
+  uint64 fingerprint = Fingerprint64(TF_VERSION_STRING);
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(tf_git_version()));
+  string serialized_debug_options;
+  SerializeToStringDeterministic(debug_options, &serialized_debug_options);
+  fingerprint =
+      FingerprintCat64(fingerprint, Fingerprint64(serialized_debug_options));
+
+  // The HLO passes autotune for the device model.
+  TF_ASSIGN_OR_RETURN(
+      se::StreamExecutor * executor,
+      client_->backend().stream_executor(build_options.device_ordinal()));
+  const se::DeviceDescription& device = executor->GetDeviceDescription();
+  fingerprint =
+      FingerprintCat64(fingerprint, Fingerprint64(device_type_.type_string()));
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device.name()));
+  fingerprint =
+      FingerprintCat64(fingerprint, Fingerprint64(device.platform_version()));
+
+  // The instruction ids of a computation depend on the computations built
+  // before it in the process, so the module is fingerprinted from its
+  // canonical text instead of its proto.
+  TF_ASSIGN_OR_RETURN(xla::HloModuleConfig config,
+                      xla::HloModule::CreateModuleConfigFromProto(
+                          computation.proto(), debug_options));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<xla::HloModule> module,
+      xla::HloModule::CreateFromProto(computation.proto(), config));
+  fingerprint = FingerprintCat64(
+      fingerprint,
+      Fingerprint64(module->ToString(
+          xla::HloPrintOptions::Fingerprint().set_print_large_constants(
+              true))));
+
+  fingerprint = FingerprintCat64(fingerprint, argument_layouts.size());
+  for (const xla::Shape* layout : argument_layouts) {
+    fingerprint = FingerprintCat64(
+        fingerprint,
+        Fingerprint64(xla::ShapeUtil::HumanStringWithLayout(*layout)));
+  }
+  fingerprint = FingerprintCat64(
+      fingerprint, Fingerprint64(xla::ShapeUtil::HumanStringWithLayout(
+                       *build_options.result_layout())));
+  return FingerprintCat64(fingerprint,
+                          build_options.alias_passthrough_params());
+}
+
+Status XlaCompilationCache::LoadPersistedExecutable(
+    const string& path, absl::Span<const xla::Shape* const> argument_layouts,
+    xla::ExecutableBuildOptions build_options,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->FileExists(path));
+  xla::HloModuleProto module;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, path, &module));
+  VLOG(1) << "Loading the persisted XLA computation " << path;
+
+  build_options.set_run_backend_only(true);
+  TF_ASSIGN_OR_RETURN(auto executables,
+                      client_->Compile(xla::XlaComputation(std::move(module)),
+                                       argument_layouts, build_options));
+  TF_RET_CHECK(executables.size() == 1);
+  *executable = std::move(executables[0]);
+  return Status::OK();
+}
+
+Status XlaCompilationCache::PersistExecutable(
+    const string& path, const xla::LocalExecutable& executable) {
+  if (!executable.executable()->has_module()) {
+    return errors::Unimplemented("The executable holds no module");
+  }
+  const xla::HloModuleProto module =
+      executable.executable()->module().ToProto();
+
+  // Writes the module to a temporary file and renames it, so that other
+  // processes never read a partially written module.
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(persistent_cache_directory_));
+  string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  Status status = WriteBinaryProto(env, temp_path, module);
+  if (status.ok()) status = env->RenameFile(temp_path, path);
+  if (!status.ok()) env->DeleteFile(temp_path).IgnoreError();
+  return status;
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
@@ -189,19 +336,61 @@ Status XlaCompilationCache::Compile(
     CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
-  absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
-    compile_threshold = kDefaultCompilationThreshold;
-  }
-  auto compile_fn = [&](XlaCompiler* compiler,
+  // Captures by value, as the function may be compiled in the background.
+  auto compile_fn = [this, compile_options, function](
+                        XlaCompiler* compiler,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
+    if (GetXlaOpsCommonFlags().tf_xla_respecialize_lowering) {
+      return CompileOrRespecializeFunction(compiler, compile_options, function,
+                                           args, result);
+    }
     return compiler->CompileFunction(compile_options, function, args, result);
   };
-  return CompileImpl(options, function, args, compile_fn,
-                     /*compile_threshold=*/compile_threshold,
+  return CompileImpl(options, function, args, compile_fn, compile_mode,
                      out_compilation_result, out_executable);
 }
 
+Status XlaCompilationCache::CompileOrRespecializeFunction(
+    XlaCompiler* compiler, const XlaCompiler::CompileOptions& compile_options,
+    const NameAttrList& function, absl::Span<const XlaCompiler::Argument> args,
+    XlaCompiler::CompilationResult* result) {
+  TF_ASSIGN_OR_RETURN(Signature signature, BuildSignature(function, args));
+  for (auto& arg_shape : signature.arg_shapes) {
+    std::fill(arg_shape.second.begin(), arg_shape.second.end(), -1);
+  }
+  std::shared_ptr<Lowering> lowering;
+  {
+    mutex_lock lock(lowering_cache_mu_);
+    auto it = lowering_cache_.find(signature);
+    if (it != lowering_cache_.end()) lowering = it->second;
+  }
+
+  if (lowering != nullptr && lowering->respecializable) {
+    Status status = compiler->RespecializeFunction(
+        compile_options, function, lowering->args, lowering->result, args,
+        result);
+    if (status.ok()) {
+      VLOG(1) << "Respecialized the lowering of " << function.name();
+      return Status::OK();
+    }
+    VLOG(1) << "Cannot respecialize the lowering of " << function.name()
+            << ": " << status;
+    lowering->respecializable = false;
+  }
+
+  TF_RETURN_IF_ERROR(
+      compiler->CompileFunction(compile_options, function, args, result));
+  if (lowering == nullptr) {
+    lowering = std::make_shared<Lowering>();
+    lowering->args.assign(args.begin(), args.end());
+    lowering->result = *result;
+    mutex_lock lock(lowering_cache_mu_);
+    lowering_cache_.emplace(std::move(signature), std::move(lowering));
+  }
+  return Status::OK();
+}
+
 static bool ShouldBeMegamorphic(int64 compile_count, int64 execution_count) {
   const int64 kCompileThreshold = 10;
   const int64 kMinExecutionsPerCompile = 50;
@@ -274,6 +463,7 @@ Status XlaCompilationCache::CompileSingleOp(
   // and causes false uniqueness between nodes.
   name.mutable_attr()->erase("_class");
   auto compile_op = [&](XlaCompiler* compiler,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
     std::vector<DataType> result_dtypes(ctx->num_outputs());
     for (int i = 0, end = result_dtypes.size(); i < end; ++i) {
@@ -317,8 +507,7 @@ Status XlaCompilationCache::CompileSingleOp(
         *options.flib_def, debug_info, options.shape_representation_fn, result);
 #endif
   };
-  return CompileImpl(options, name, args, compile_op,
-                     /*compile_threshold=*/absl::nullopt,
+  return CompileImpl(options, name, args, compile_op, CompileMode::kStrict,
                      out_compilation_result, out_executable);
 }
 
@@ -338,10 +527,8 @@ void LogOnceXlaCompiledFirstCluster() {
 
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
-    absl::Span<const XlaCompiler::Argument> args,
-    const std::function<Status(XlaCompiler* compiler,
-                               XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    absl::Span<const XlaCompiler::Argument> args, CompileFn compile_fn,
+    CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   if (FailOnXlaCompilation()) {
@@ -411,14 +598,17 @@ Status XlaCompilationCache::CompileImpl(
   // cache eviction.
   mutex_lock entry_lock(entry->mu);
   int64 current_request_count = ++entry->request_count;
+  const int64 compile_threshold = compile_mode == CompileMode::kLazy
+                                      ? kDefaultCompilationThreshold
+                                      : 0;
   VLOG(2) << "Compilation cache entry hit: " << entry->compiled
           << " signature: " << signature.HumanString() << " with request count "
           << current_request_count << " and compile threshold "
-          << compile_threshold.value_or(0);
+          << compile_threshold;
   if (!entry->compiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     const bool should_compile = [&] {
-      if (!compile_threshold.has_value()) {
+      if (compile_mode == CompileMode::kStrict) {
         // Lazy compilation is disabled.
         return true;
       }
@@ -432,23 +622,29 @@ Status XlaCompilationCache::CompileImpl(
         return false;
       }
 
-      if (is_first_execution) {
+      // Compiling in the background does not block the step.
+      if (is_first_execution || compile_mode == CompileMode::kAsync) {
         return true;
       }
 
       bool reached_compile_threshold =
-          current_request_count >= *compile_threshold;
+          current_request_count >= compile_threshold;
       if (!reached_compile_threshold) {
         VLOG(3)
             << "Not compiling cluster " << function.name()
             << " because it has not reached compile threshold; threshold is "
-            << *compile_threshold << " execution count "
+            << compile_threshold << " execution count "
             << current_request_count << ".";
       }
       return reached_compile_threshold;
     }();
 
-    if (!should_compile) {
+    if (should_compile && compile_mode == CompileMode::kAsync &&
+        !entry->compiling_async) {
+      CompileAsync(options, function.name(), args, std::move(compile_fn),
+                   entry);
+    }
+    if (!should_compile || compile_mode == CompileMode::kAsync) {
       VLOG(2) << "Not compiling for signature: " << signature.HumanString();
       *out_compilation_result = nullptr;
       *out_executable = nullptr;
@@ -464,43 +660,15 @@ Status XlaCompilationCache::CompileImpl(
     entry->compiled = true;
 
     entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
+        compile_fn(&compiler, args, &entry->compilation_result);
     TF_RETURN_IF_ERROR(entry->compilation_status);
     CHECK_EQ(entry->executable.get(), nullptr);
     entry->compilation_status =
         BuildExecutable(options, entry->compilation_result, &entry->executable);
 
     const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(
+        RecordCompilation(function.name(), compile_end_us - compile_start_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -508,4 +676,101 @@ Status XlaCompilationCache::CompileImpl(
   return Status::OK();
 }
 
+void XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const string& function_name,
+    absl::Span<const XlaCompiler::Argument> args, CompileFn compile_fn,
+    Entry* entry) {
+  {
+    mutex_lock lock(async_compiler_mu_);
+    if (num_ongoing_async_compilations_ >= kNumAsyncCompilerThreads) {
+      VLOG(2) << "Not compiling " << function_name
+              << " in the background: too many ongoing compilations.";
+      return;
+    }
+    ++num_ongoing_async_compilations_;
+    if (!async_compiler_threads_) {
+      async_compiler_threads_ = absl::make_unique<thread::ThreadPool>(
+          Env::Default(), "xla_async_compiler", kNumAsyncCompilerThreads);
+    }
+  }
+  entry->compiling_async = true;
+  VLOG(2) << "Compiling " << function_name << " in the background.";
+
+  // The compilation may outlive the step, so it owns a copy of the function
+  // library, and allocates from the XLA backend rather than from the device
+  // allocator of the step.
+  auto flib_def =
+      std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  XlaCompiler::Options async_options = options;
+  async_options.flib_def = flib_def.get();
+  async_options.device_allocator = nullptr;
+  std::vector<XlaCompiler::Argument> async_args(args.begin(), args.end());
+
+  mutex_lock lock(async_compiler_mu_);
+  async_compiler_threads_->Schedule([this, async_options, flib_def,
+                                     function_name,
+                                     args = std::move(async_args),
+                                     compile_fn = std::move(compile_fn),
+                                     entry]() {
+    Env* env = Env::Default();
+    const uint64 compile_start_us = env->NowMicros();
+    XlaCompiler compiler(async_options);
+    XlaCompiler::CompilationResult result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status = compile_fn(&compiler, args, &result);
+    if (status.ok()) {
+      status = BuildExecutable(async_options, result, &executable);
+    }
+    const uint64 compile_end_us = env->NowMicros();
+    {
+      mutex_lock lock(entry->mu);
+      entry->compiling_async = false;
+      // A strict compilation of the same signature may have completed first.
+      if (!entry->compiled) {
+        entry->compiled = true;
+        entry->compilation_status = status;
+        entry->compilation_result = std::move(result);
+        entry->executable = std::move(executable);
+      }
+    }
+    Status record_status =
+        RecordCompilation(function_name, compile_end_us - compile_start_us);
+    if (!record_status.ok()) {
+      LOG(WARNING) << "Failed to record the compilation of " << function_name
+                   << ": " << record_status;
+    }
+    mutex_lock lock(async_compiler_mu_);
+    --num_ongoing_async_compilations_;
+  });
+}
+
+Status XlaCompilationCache::RecordCompilation(const string& function_name,
+                                              uint64 compile_time_us) {
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
 }  // namespace tensorflow
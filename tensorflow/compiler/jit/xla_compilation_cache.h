@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
@@ -42,14 +46,22 @@ namespace tensorflow {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// If a persistent cache directory is given, the optimized HLO module of each
+// executable is also written to it, keyed by a fingerprint of the computation,
+// the device, the XLA flags and the TensorFlow version.  Caches sharing the
+// directory, in this or later processes, then only run the compiler backend on
+// the module instead of optimizing the computation again.
 class XlaCompilationCache : public ResourceBase {
  public:
-  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
+  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type,
+                      string persistent_cache_directory = "");
   ~XlaCompilationCache() override;
 
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +74,10 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then, unless the cluster is megamorphic, a cache miss starts
+  // the compilation on a background thread and returns null like `kLazy`;
+  // later calls return null until the compilation completes.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -123,32 +138,80 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
+  // Compiles the arguments with an XlaCompiler into a compilation result.
+  using CompileFn = std::function<Status(
+      XlaCompiler* compiler, absl::Span<const XlaCompiler::Argument> args,
+      XlaCompiler::CompilationResult*)>;
+
+  // The value associated with a cache entry.
+  struct Entry;
+
   // Common implementation of Compile and CompileSingleOp.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
-      absl::Span<const XlaCompiler::Argument> args,
-      const std::function<Status(XlaCompiler* compiler,
-                                 XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      absl::Span<const XlaCompiler::Argument> args, CompileFn compile_fn,
+      CompileMode compile_mode,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Compiles `function` for `args` with `compiler`. If the function has been
+  // lowered for other dimension sizes of the same arguments, respecializes
+  // the lowering instead, when it does not depend on them.
+  Status CompileOrRespecializeFunction(
+      XlaCompiler* compiler, const XlaCompiler::CompileOptions& compile_options,
+      const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      XlaCompiler::CompilationResult* result);
+
+  // Starts compiling `entry` on a background thread, unless too many
+  // compilations are ongoing.  `compile_fn` must not refer to the caller's
+  // state.  The caller must hold the lock of `entry`.
+  void CompileAsync(const XlaCompiler::Options& options,
+                    const string& function_name,
+                    absl::Span<const XlaCompiler::Argument> args,
+                    CompileFn compile_fn, Entry* entry);
+
+  // Records that `function_name` was compiled in `compile_time_us`.
+  Status RecordCompilation(const string& function_name,
+                           uint64 compile_time_us);
+
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
   Status BuildExecutable(const XlaCompiler::Options& options,
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Returns the fingerprint under which the executable of `computation`, built
+  // with `argument_layouts` and `build_options`, is persisted.
+  xla::StatusOr<uint64> PersistentCacheFingerprint(
+      const xla::XlaComputation& computation,
+      absl::Span<const xla::Shape* const> argument_layouts,
+      const xla::ExecutableBuildOptions& build_options) const;
+
+  // Builds `executable` from the optimized module persisted in `path`. Returns
+  // a NotFound error if there is none.
+  Status LoadPersistedExecutable(
+      const string& path, absl::Span<const xla::Shape* const> argument_layouts,
+      xla::ExecutableBuildOptions build_options,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
+  // Writes the optimized module of `executable` in `path`.
+  Status PersistExecutable(const string& path,
+                           const xla::LocalExecutable& executable);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  const string persistent_cache_directory_;
 
-  // The value associated with a cache entry.
   struct Entry {
     mutex mu;
 
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is this entry being compiled on a background thread?
+    bool compiling_async TF_GUARDED_BY(mu) = false;
+
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
@@ -167,6 +230,21 @@ class XlaCompilationCache : public ResourceBase {
   absl::flat_hash_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       TF_GUARDED_BY(compile_cache_mu_);
 
+  // The first lowering of a function, and the arguments it was lowered for.
+  struct Lowering {
+    std::vector<XlaCompiler::Argument> args;
+    XlaCompiler::CompilationResult result;
+
+    // Cleared once the lowering cannot be respecialized for other arguments.
+    std::atomic<bool> respecializable{true};
+  };
+
+  mutex lowering_cache_mu_;
+  // Maps the signatures without the dimension sizes of the arguments to their
+  // first lowering.
+  absl::flat_hash_map<Signature, std::shared_ptr<Lowering>, Signature::Hash>
+      lowering_cache_ TF_GUARDED_BY(lowering_cache_mu_);
+
   struct ClusterCompileStats {
     // Number of times the cluster has been (re-)compiled.
     int64 compile_count = 0;
@@ -193,6 +271,15 @@ class XlaCompilationCache : public ResourceBase {
   // signature before  we attempt to compile it.
   static constexpr int64 kDefaultCompilationThreshold = 2;
 
+  // The number of background compilations that may be ongoing at once.
+  static constexpr int kNumAsyncCompilerThreads = 4;
+
+  mutex async_compiler_mu_;
+  // Created on the first background compilation.
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads_
+      TF_GUARDED_BY(async_compiler_mu_);
+  int num_ongoing_async_compilations_ TF_GUARDED_BY(async_compiler_mu_) = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
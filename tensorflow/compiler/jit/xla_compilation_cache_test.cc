@@ -18,6 +18,9 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -54,6 +57,89 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+// Compiles XTimesTwo on float vectors with the CPU JIT.
+class XTimesTwoCompilation {
+ public:
+  XTimesTwoCompilation()
+      : flib_def_(OpRegistry::Global(), MakeLibrary()), args_(1) {
+    options_.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    options_.client = xla::ClientLibrary::LocalClientOrDie();
+    options_.flib_def = &flib_def_;
+    function_.set_name("XTimesTwo");
+    (*function_.mutable_attr())["T"].set_type(DT_FLOAT);
+    args_[0].kind = XlaCompiler::Argument::kParameter;
+    args_[0].type = DT_FLOAT;
+    args_[0].shape = TensorShape({2});
+  }
+
+  XlaCompilationCache* NewCache(const string& persistent_cache_directory) {
+    return new XlaCompilationCache(options_.client, options_.device_type,
+                                   persistent_cache_directory);
+  }
+
+  Status Compile(XlaCompilationCache* cache,
+                 XlaCompilationCache::CompileMode compile_mode,
+                 xla::LocalExecutable** executable) {
+    const XlaCompiler::CompilationResult* compilation_result;
+    return cache->Compile(options_, function_, args_,
+                          XlaCompiler::CompileOptions{}, compile_mode,
+                          &compilation_result, executable);
+  }
+
+ private:
+  static FunctionDefLibrary MakeLibrary() {
+    FunctionDefLibrary library;
+    *library.add_function() = test::function::XTimesTwo();
+    return library;
+  }
+
+  FunctionLibraryDefinition flib_def_;
+  XlaCompiler::Options options_;
+  NameAttrList function_;
+  std::vector<XlaCompiler::Argument> args_;
+};
+
+TEST(XlaCompilationCacheTest, PersistsOptimizedComputations) {
+  const string dir = io::JoinPath(testing::TmpDir(), "xla_compilation_cache");
+  XTimesTwoCompilation compilation;
+
+  // The second cache builds its executable from the module written by the
+  // first one.
+  for (int i = 0; i < 2; ++i) {
+    XlaCompilationCache* cache = compilation.NewCache(dir);
+    core::ScopedUnref cache_ref(cache);
+
+    xla::LocalExecutable* executable;
+    TF_ASSERT_OK(compilation.Compile(
+        cache, XlaCompilationCache::CompileMode::kStrict, &executable));
+    EXPECT_NE(executable, nullptr);
+
+    std::vector<string> files;
+    TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+        io::JoinPath(dir, "xla_*.pb"), &files));
+    EXPECT_EQ(files.size(), 1);
+  }
+}
+
+TEST(XlaCompilationCacheTest, CompilesInTheBackground) {
+  XTimesTwoCompilation compilation;
+  XlaCompilationCache* cache = compilation.NewCache("");
+  core::ScopedUnref cache_ref(cache);
+
+  // The first request only starts the compilation.
+  xla::LocalExecutable* executable;
+  TF_ASSERT_OK(compilation.Compile(
+      cache, XlaCompilationCache::CompileMode::kAsync, &executable));
+  EXPECT_EQ(executable, nullptr);
+
+  for (int i = 0; i < 600 && executable == nullptr; ++i) {
+    Env::Default()->SleepForMicroseconds(100 * 1000);
+    TF_ASSERT_OK(compilation.Compile(
+        cache, XlaCompilationCache::CompileMode::kAsync, &executable));
+  }
+  EXPECT_NE(executable, nullptr);
+}
+
 TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
   NameAttrList fn;
   fn.set_name("afunction");
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_platform_info.h"
 
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 
 namespace tensorflow {
@@ -25,7 +26,8 @@ Status BuildXlaCompilationCache(DeviceBase* device,
   if (platform_info.xla_device_metadata()) {
     *cache = new XlaCompilationCache(
         platform_info.xla_device_metadata()->client(),
-        platform_info.xla_device_metadata()->jit_device_type());
+        platform_info.xla_device_metadata()->jit_device_type(),
+        GetXlaOpsCommonFlags().tf_xla_persistent_cache_directory);
     return Status::OK();
   }
 
@@ -71,7 +73,8 @@ Status BuildXlaCompilationCache(DeviceBase* device,
                                    platform_info.device_type().type());
   }
   *cache = new XlaCompilationCache(
-      client.ValueOrDie(), DeviceType(registration->compilation_device_name));
+      client.ValueOrDie(), DeviceType(registration->compilation_device_name),
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_directory);
   return Status::OK();
 }
 
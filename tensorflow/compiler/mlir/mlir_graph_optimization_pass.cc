@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/compiler/mlir/tensorflow/utils/device_util.h"
 #include "tensorflow/compiler/mlir/tensorflow/utils/dump_mlir_util.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -86,6 +87,42 @@ static void DumpModule(mlir::ModuleOp module, std::string file_prefix) {
   VLOG(1) << "Dumped MLIR module to " << prefix;
 }
 
+namespace {
+
+// Hashes the text written to the stream, without keeping it in memory.
+class FingerprintOStream : public llvm::raw_ostream {
+ public:
+  ~FingerprintOStream() override { flush(); }
+
+  uint64 fingerprint() {
+    flush();
+    return fingerprint_;
+  }
+
+ private:
+  void write_impl(const char* ptr, size_t size) override {
+    fingerprint_ = Hash64(ptr, size, fingerprint_);
+    pos_ += size;
+  }
+
+  uint64_t current_pos() const override { return pos_; }
+
+  uint64 fingerprint_ = 0;
+  uint64_t pos_ = 0;
+};
+
+}  // namespace
+
+// Returns a fingerprint of the module, including the locations the node names
+// are exported from. Printing the module is much cheaper than converting it
+// back to a graph, so it is used to detect the passes that left the module
+// unchanged.
+static uint64 FingerprintModule(mlir::ModuleOp module) {
+  FingerprintOStream os;
+  module.print(os, mlir::OpPrintingFlags().enableDebugInfo());
+  return os.fingerprint();
+}
+
 MlirOptimizationPassRegistry& MlirOptimizationPassRegistry::Global() {
   static auto* global = new MlirOptimizationPassRegistry();
   return *global;
@@ -141,6 +178,7 @@ Status MlirFunctionOptimizationPass::Run(
                                          import_config, &context));
 
   AddDevicesToOp(*module_ref, &device_set);
+  const uint64 fingerprint = FingerprintModule(*module_ref);
 
   for (auto& pass_registration : registry_->passes()) {
     llvm::StringRef name = pass_registration.pass->name();
@@ -157,6 +195,13 @@ Status MlirFunctionOptimizationPass::Run(
     }
   }
 
+  // The graph is only replaced if a pass changed it.
+  if (FingerprintModule(*module_ref) == fingerprint) {
+    VLOG(1) << "MLIR graph optimization passes did not change the module, "
+               "skipping conversion back to graph";
+    return Status::OK();
+  }
+
   GraphExportConfig export_config;
   absl::flat_hash_set<Node*> control_ret_nodes;
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
@@ -217,6 +262,7 @@ Status MlirV1CompatGraphOptimizationPass::Run(
                          import_config, &context));
 
   AddDevicesToOp(*module_ref, options.device_set);
+  const uint64 fingerprint = FingerprintModule(*module_ref);
 
   for (auto& pass_registration : registry_->passes()) {
     llvm::StringRef name = pass_registration.pass->name();
@@ -233,6 +279,12 @@ Status MlirV1CompatGraphOptimizationPass::Run(
     }
   }
 
+  if (FingerprintModule(*module_ref) == fingerprint) {
+    VLOG(1) << "MLIR V1 compat graph optimization passes did not change the "
+               "module, skipping conversion back to graph";
+    return Status::OK();
+  }
+
   GraphExportConfig export_config;
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
       ConvertMlirToGraph(*module_ref, export_config, options.graph,
@@ -70,7 +70,8 @@ class MlirOptimizationPassRegistry {
 };
 
 // Function optimization pass that runs all MLIR passes registered in
-// MlirOptimizationPassRegistry.
+// MlirOptimizationPassRegistry. The graph is converted to MLIR once for all the
+// passes, and only converted back if they changed the module.
 class MlirFunctionOptimizationPass : public FunctionOptimizationPass {
  public:
   explicit MlirFunctionOptimizationPass(
@@ -135,6 +136,9 @@ class MlirV1CompatOptimizationPassRegistry {
   Passes passes_;
 };
 
+// Graph optimization pass that runs all MLIR passes registered in
+// MlirV1CompatOptimizationPassRegistry, converting the graph like
+// MlirFunctionOptimizationPass.
 class MlirV1CompatGraphOptimizationPass : public GraphOptimizationPass {
  public:
   explicit MlirV1CompatGraphOptimizationPass(
@@ -18,6 +18,8 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/types/variant.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -35,7 +37,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/xla_builder.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/protobuf_util.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/shape_inference.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/device.h"
@@ -785,6 +790,471 @@ Status XlaCompiler::CompileFunction(
   return Status::OK();
 }
 
+namespace {
+
+// Ops whose outputs depend on the dimension sizes of their inputs. The graph
+// optimizations of CompileFunction() fold them into constants.
+bool ReadsShapes(const string& op) {
+  static const auto* const kShapeOps = new absl::flat_hash_set<string>({
+      "BroadcastArgs",
+      "BroadcastGradientArgs",
+      "Rank",
+      "Shape",
+      "ShapeN",
+      "Size",
+      "TensorArraySizeV3",
+      "TensorListElementShape",
+      "TensorListLength",
+      "VariableShape",
+  });
+  return kShapeOps->contains(op);
+}
+
+// Returns true if the function `name`, or a function it calls, has an op
+// reading the dimension sizes of its inputs.
+bool FunctionReadsShapes(const FunctionLibraryDefinition& flib_def,
+                         const string& name,
+                         absl::flat_hash_set<string>* visited) {
+  if (!visited->insert(name).second) return false;
+  const FunctionDef* fdef = flib_def.Find(name);
+  if (fdef == nullptr) return false;
+  for (const NodeDef& node : fdef->node_def()) {
+    if (ReadsShapes(node.op()) ||
+        FunctionReadsShapes(flib_def, node.op(), visited)) {
+      return true;
+    }
+    for (const auto& attr : node.attr()) {
+      if (attr.second.has_func() &&
+          FunctionReadsShapes(flib_def, attr.second.func().name(), visited)) {
+        return true;
+      }
+      for (const NameAttrList& func : attr.second.list().func()) {
+        if (FunctionReadsShapes(flib_def, func.name(), visited)) return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Gives `shape` the layouts of `lowered_shape`, the shape of the same
+// instruction for the lowered dimension sizes.
+void CopyLayouts(const xla::Shape& lowered_shape, xla::Shape* shape) {
+  if (shape->IsTuple()) {
+    for (int i = 0; i < shape->tuple_shapes_size(); ++i) {
+      CopyLayouts(lowered_shape.tuple_shapes(i),
+                  shape->mutable_tuple_shapes(i));
+    }
+  } else if (shape->IsArray()) {
+    if (lowered_shape.has_layout()) {
+      *shape->mutable_layout() = lowered_shape.layout();
+    } else {
+      shape->clear_layout();
+    }
+  }
+}
+
+bool IsElementwiseUnary(xla::HloOpcode opcode) {
+  switch (opcode) {
+    case xla::HloOpcode::kAbs:
+    case xla::HloOpcode::kCbrt:
+    case xla::HloOpcode::kCeil:
+    case xla::HloOpcode::kClz:
+    case xla::HloOpcode::kCopy:
+    case xla::HloOpcode::kCos:
+    case xla::HloOpcode::kExp:
+    case xla::HloOpcode::kExpm1:
+    case xla::HloOpcode::kFloor:
+    case xla::HloOpcode::kImag:
+    case xla::HloOpcode::kIsFinite:
+    case xla::HloOpcode::kLog:
+    case xla::HloOpcode::kLog1p:
+    case xla::HloOpcode::kLogistic:
+    case xla::HloOpcode::kNegate:
+    case xla::HloOpcode::kNot:
+    case xla::HloOpcode::kPopulationCount:
+    case xla::HloOpcode::kReal:
+    case xla::HloOpcode::kRoundNearestAfz:
+    case xla::HloOpcode::kRsqrt:
+    case xla::HloOpcode::kSign:
+    case xla::HloOpcode::kSin:
+    case xla::HloOpcode::kSqrt:
+    case xla::HloOpcode::kTanh:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsElementwiseBinary(xla::HloOpcode opcode) {
+  switch (opcode) {
+    case xla::HloOpcode::kAdd:
+    case xla::HloOpcode::kAnd:
+    case xla::HloOpcode::kAtan2:
+    case xla::HloOpcode::kCompare:
+    case xla::HloOpcode::kComplex:
+    case xla::HloOpcode::kDivide:
+    case xla::HloOpcode::kMaximum:
+    case xla::HloOpcode::kMinimum:
+    case xla::HloOpcode::kMultiply:
+    case xla::HloOpcode::kOr:
+    case xla::HloOpcode::kPower:
+    case xla::HloOpcode::kRemainder:
+    case xla::HloOpcode::kShiftLeft:
+    case xla::HloOpcode::kShiftRightArithmetic:
+    case xla::HloOpcode::kShiftRightLogical:
+    case xla::HloOpcode::kSubtract:
+    case xla::HloOpcode::kXor:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Infers the shapes of the instructions of the entry computation of `module`
+// again, for `parameter_shapes` of the same ranks as the lowered ones, and
+// returns the new result shape.
+//
+// Only the instructions which do not hold dimension sizes are supported:
+// elementwise operations, dots, reductions and transposes. Broadcasts, which
+// XlaBuilder emits to match the shapes of the operands of elementwise
+// operations, take the new shape of the other operands of their first user.
+// Any other instruction, and in particular any integer constant, which may
+// hold a dimension size, makes it return an Unimplemented error.
+xla::StatusOr<xla::Shape> RespecializeEntryComputation(
+    absl::Span<const xla::Shape> parameter_shapes,
+    xla::HloModuleProto* module) {
+  if (module->dynamic_parameter_binding().entries_size() > 0) {
+    return errors::Unimplemented("The computation has dynamic parameters");
+  }
+  absl::flat_hash_map<int64, const xla::HloComputationProto*> computations;
+  xla::HloComputationProto* entry = nullptr;
+  for (xla::HloComputationProto& computation :
+       *module->mutable_computations()) {
+    computations[computation.id()] = &computation;
+    if (computation.id() == module->entry_computation_id()) {
+      entry = &computation;
+    }
+  }
+  TF_RET_CHECK(entry != nullptr);
+  TF_RET_CHECK(entry->program_shape().parameters_size() ==
+               parameter_shapes.size());
+
+  // The lowered and new shapes of the instructions, by id.
+  absl::flat_hash_map<int64, xla::Shape> lowered_shapes;
+  absl::flat_hash_map<int64, xla::Shape> shapes;
+  // The broadcasts whose new shape is not known yet.
+  absl::flat_hash_map<int64, xla::HloInstructionProto*> pending_broadcasts;
+
+  // Gives the pending broadcasts among the operands of elementwise `instr`
+  // the new shape of its other operands of the same lowered dimensions.
+  auto resolve_broadcasts = [&](const xla::HloInstructionProto& instr) {
+    for (int64 id : instr.operand_ids()) {
+      auto it = pending_broadcasts.find(id);
+      if (it == pending_broadcasts.end()) continue;
+      const xla::Shape& lowered_shape = lowered_shapes[id];
+      const xla::Shape* other_shape = nullptr;
+      for (int64 other_id : instr.operand_ids()) {
+        if (!pending_broadcasts.contains(other_id) &&
+            xla::ShapeUtil::SameDimensions(lowered_shapes[other_id],
+                                           lowered_shape)) {
+          other_shape = &shapes[other_id];
+          break;
+        }
+      }
+      if (other_shape == nullptr) {
+        return errors::Unimplemented("Broadcast ", it->second->name(),
+                                     " has no shape to take");
+      }
+      xla::HloInstructionProto* broadcast = it->second;
+      xla::Shape shape = xla::ShapeUtil::ChangeElementType(
+          *other_shape, lowered_shape.element_type());
+      CopyLayouts(lowered_shape, &shape);
+      Status status =
+          xla::ShapeInference::InferBroadcastShape(
+              shapes[broadcast->operand_ids(0)], shape,
+              xla::AsInt64Slice(broadcast->dimensions()))
+              .status();
+      if (!status.ok()) {
+        return errors::Unimplemented("Cannot respecialize ",
+                                     broadcast->name(), ": ",
+                                     status.error_message());
+      }
+      *broadcast->mutable_shape() = shape.ToProto();
+      shapes[id] = std::move(shape);
+      pending_broadcasts.erase(it);
+    }
+    return Status::OK();
+  };
+
+  for (xla::HloInstructionProto& instr : *entry->mutable_instructions()) {
+    TF_ASSIGN_OR_RETURN(xla::HloOpcode opcode,
+                        xla::StringToHloOpcode(instr.opcode()));
+    const xla::Shape lowered_shape(instr.shape());
+    lowered_shapes[instr.id()] = lowered_shape;
+    if (absl::c_any_of(instr.sharding().tuple_shardings(),
+                       [](const xla::OpSharding& sharding) {
+                         return sharding.type() == xla::OpSharding::OTHER;
+                       }) ||
+        instr.sharding().type() == xla::OpSharding::OTHER) {
+      return errors::Unimplemented("Cannot respecialize tiled ",
+                                   instr.name());
+    }
+
+    const bool elementwise = IsElementwiseUnary(opcode) ||
+                             IsElementwiseBinary(opcode) ||
+                             opcode == xla::HloOpcode::kConvert ||
+                             opcode == xla::HloOpcode::kSelect ||
+                             opcode == xla::HloOpcode::kClamp;
+    if (elementwise) {
+      TF_RETURN_IF_ERROR(resolve_broadcasts(instr));
+    }
+    std::vector<const xla::Shape*> operand_shapes;
+    for (int64 id : instr.operand_ids()) {
+      if (pending_broadcasts.contains(id)) {
+        return errors::Unimplemented("Broadcast ", id, " is used by ",
+                                     instr.name());
+      }
+      operand_shapes.push_back(&shapes[id]);
+    }
+    // HLO elementwise operations do not broadcast, except for scalars.
+    if (elementwise) {
+      const xla::Shape* array_shape = nullptr;
+      for (const xla::Shape* shape : operand_shapes) {
+        if (xla::ShapeUtil::IsScalar(*shape)) continue;
+        if (array_shape != nullptr &&
+            !xla::ShapeUtil::SameDimensions(*array_shape, *shape)) {
+          return errors::Unimplemented("Operands of ", instr.name(),
+                                       " have different dimensions");
+        }
+        array_shape = shape;
+      }
+    }
+
+    xla::StatusOr<xla::Shape> shape_or;
+    if (IsElementwiseUnary(opcode)) {
+      shape_or = xla::ShapeInference::InferUnaryOpShape(opcode,
+                                                        *operand_shapes[0]);
+    } else if (IsElementwiseBinary(opcode)) {
+      shape_or = xla::ShapeInference::InferBinaryOpShape(
+          opcode, *operand_shapes[0], *operand_shapes[1],
+          /*broadcast_dimensions=*/{});
+    } else {
+      switch (opcode) {
+        case xla::HloOpcode::kParameter:
+          if (instr.parameter_number() >= parameter_shapes.size()) {
+            return errors::Unimplemented("Unknown parameter ", instr.name());
+          }
+          shape_or = parameter_shapes[instr.parameter_number()];
+          break;
+        case xla::HloOpcode::kConstant:
+          // Integer constants, such as the static results of
+          // GetDimensionSize, may hold dimension sizes.
+          if (!xla::ShapeUtil::IsScalar(lowered_shape) ||
+              !(xla::primitive_util::IsFloatingPointType(
+                    lowered_shape.element_type()) ||
+                xla::primitive_util::IsComplexType(
+                    lowered_shape.element_type()) ||
+                lowered_shape.element_type() == xla::PRED)) {
+            return errors::Unimplemented("Cannot respecialize constant ",
+                                         instr.name());
+          }
+          shape_or = lowered_shape;
+          break;
+        case xla::HloOpcode::kBroadcast:
+          pending_broadcasts[instr.id()] = &instr;
+          continue;
+        case xla::HloOpcode::kConvert:
+          shape_or = xla::ShapeInference::InferConvertShape(
+              *operand_shapes[0], lowered_shape.element_type());
+          break;
+        case xla::HloOpcode::kSelect:
+        case xla::HloOpcode::kClamp:
+          shape_or = xla::ShapeInference::InferTernaryOpShape(
+              opcode, *operand_shapes[0], *operand_shapes[1],
+              *operand_shapes[2]);
+          break;
+        case xla::HloOpcode::kDot:
+          shape_or = xla::ShapeInference::InferDotOpShape(
+              *operand_shapes[0], *operand_shapes[1],
+              instr.dot_dimension_numbers());
+          break;
+        case xla::HloOpcode::kReduce: {
+          auto it = computations.find(instr.called_computation_ids(0));
+          TF_RET_CHECK(it != computations.end());
+          shape_or = xla::ShapeInference::InferReduceShape(
+              operand_shapes, xla::AsInt64Slice(instr.dimensions()),
+              xla::ProgramShape(it->second->program_shape()));
+          break;
+        }
+        case xla::HloOpcode::kTranspose:
+          shape_or = xla::ShapeInference::InferTransposeShape(
+              *operand_shapes[0], xla::AsInt64Slice(instr.dimensions()));
+          break;
+        case xla::HloOpcode::kGetTupleElement:
+          shape_or = xla::ShapeInference::InferGetTupleElementShape(
+              *operand_shapes[0], instr.tuple_index());
+          break;
+        case xla::HloOpcode::kTuple:
+          shape_or = xla::ShapeInference::InferVariadicOpShape(opcode,
+                                                               operand_shapes);
+          break;
+        default:
+          return errors::Unimplemented("Cannot respecialize ", instr.opcode(),
+                                       " ", instr.name());
+      }
+    }
+    if (!shape_or.ok()) {
+      return errors::Unimplemented("Cannot respecialize ", instr.name(), ": ",
+                                   shape_or.status().error_message());
+    }
+    xla::Shape shape = shape_or.ConsumeValueOrDie();
+    if (opcode != xla::HloOpcode::kParameter) {
+      CopyLayouts(lowered_shape, &shape);
+    }
+    *instr.mutable_shape() = shape.ToProto();
+    shapes[instr.id()] = std::move(shape);
+  }
+  if (!pending_broadcasts.empty()) {
+    return errors::Unimplemented("Broadcast ",
+                                 pending_broadcasts.begin()->second->name(),
+                                 " has no elementwise user");
+  }
+
+  const xla::Shape& result_shape = shapes[entry->root_id()];
+  xla::ProgramShapeProto* program_shape = entry->mutable_program_shape();
+  for (int i = 0; i < parameter_shapes.size(); ++i) {
+    *program_shape->mutable_parameters(i) = parameter_shapes[i].ToProto();
+  }
+  *program_shape->mutable_result() = result_shape.ToProto();
+  *module->mutable_host_program_shape() = *program_shape;
+  return result_shape;
+}
+
+// Returns the dimension sizes of `shape`, which must be an array.
+std::vector<int64> XlaDimensionSizes(const xla::Shape& shape) {
+  return std::vector<int64>(shape.dimensions().begin(),
+                            shape.dimensions().end());
+}
+
+}  // namespace
+
+Status XlaCompiler::RespecializeFunction(
+    const XlaCompiler::CompileOptions& options,
+    const NameAttrList& fn_name_attrs,
+    absl::Span<const XlaCompiler::Argument> lowered_args,
+    const XlaCompiler::CompilationResult& lowered,
+    absl::Span<const XlaCompiler::Argument> args,
+    XlaCompiler::CompilationResult* result) {
+  absl::flat_hash_set<string> visited;
+  if (options_.flib_def->Find(fn_name_attrs.name()) == nullptr ||
+      FunctionReadsShapes(*options_.flib_def, fn_name_attrs.name(),
+                          &visited)) {
+    return errors::Unimplemented(fn_name_attrs.name(),
+                                 " may read the shapes of its arguments");
+  }
+
+  // Only the dimension sizes of the parameters may differ.
+  if (lowered_args.size() != args.size()) {
+    return errors::InvalidArgument("Expected ", lowered_args.size(),
+                                   " arguments, got ", args.size());
+  }
+  for (int i = 0, end = args.size(); i < end; ++i) {
+    if (args[i].kind != XlaCompiler::Argument::kParameter) {
+      if (!(args[i] == lowered_args[i])) {
+        return errors::Unimplemented("Argument ", i, " is not a parameter");
+      }
+      continue;
+    }
+    if (!absl::holds_alternative<TensorShape>(args[i].shape) ||
+        !absl::holds_alternative<TensorShape>(lowered_args[i].shape) ||
+        !args[i].dynamic_dim_to_arg_num_map.empty()) {
+      return errors::Unimplemented("Argument ", i, " is not static");
+    }
+    XlaCompiler::Argument arg = args[i];
+    arg.shape = lowered_args[i].shape;
+    if (!(arg == lowered_args[i]) ||
+        absl::get<TensorShape>(args[i].shape).dims() !=
+            absl::get<TensorShape>(lowered_args[i].shape).dims()) {
+      return errors::Unimplemented("Argument ", i,
+                                   " differs in more than its dimensions");
+    }
+  }
+  if (!lowered.resource_updates.empty() ||
+      lowered.host_compute_metadata.device_to_host_size() > 0 ||
+      lowered.host_compute_metadata.host_to_device_size() > 0) {
+    return errors::Unimplemented(
+        "The computation updates resources or transfers to the host");
+  }
+
+  // The parameters keep their representation, if it does not reshape them.
+  std::vector<xla::Shape> xla_input_shapes;
+  for (int i = 0, end = lowered.input_mapping.size(); i < end; ++i) {
+    const int arg_num = lowered.input_mapping[i];
+    const XlaCompiler::Argument& arg = args[arg_num];
+    const xla::Shape& lowered_shape = lowered.xla_input_shapes[i];
+    if (arg.kind != XlaCompiler::Argument::kParameter) {
+      xla_input_shapes.push_back(lowered_shape);
+      continue;
+    }
+    if (!lowered_shape.IsArray() ||
+        XlaDimensionSizes(lowered_shape) !=
+            lowered_args[arg_num].DimensionSizes()) {
+      return errors::Unimplemented("Argument ", arg_num, " is reshaped");
+    }
+    xla::Shape shape;
+    TF_RETURN_IF_ERROR(XLAShapeForArgument(arg, options.is_entry_computation,
+                                           /*arg_sharding=*/{}, &shape));
+    if (!shape.IsArray() || XlaDimensionSizes(shape) != arg.DimensionSizes()) {
+      return errors::Unimplemented("Argument ", arg_num, " is reshaped");
+    }
+    xla_input_shapes.push_back(std::move(shape));
+  }
+  std::vector<xla::Shape> parameter_shapes;
+  if (options.use_tuple_arg) {
+    parameter_shapes.push_back(
+        xla::ShapeUtil::MakeTupleShape(xla_input_shapes));
+  } else {
+    parameter_shapes = xla_input_shapes;
+  }
+
+  xla::HloModuleProto module = lowered.computation->proto();
+  TF_ASSIGN_OR_RETURN(xla::Shape xla_output_shape,
+                      RespecializeEntryComputation(parameter_shapes, &module));
+
+  // The non-constant outputs are the elements of the output tuple, unless a
+  // single one is returned as is.
+  std::vector<XlaCompiler::OutputDescription> outputs = lowered.outputs;
+  const bool tuple_output = lowered.xla_output_shape.IsTuple();
+  if (tuple_output &&
+      lowered.xla_output_shape.tuple_shapes_size() != outputs.size()) {
+    return errors::Unimplemented("The computation has constant outputs");
+  }
+  for (int i = 0, end = outputs.size(); i < end; ++i) {
+    XlaCompiler::OutputDescription& output = outputs[i];
+    if (output.is_constant || output.is_tensor_list) {
+      return errors::Unimplemented("Output ", i, " is not a tensor");
+    }
+    const xla::Shape& lowered_shape =
+        tuple_output ? lowered.xla_output_shape.tuple_shapes(i)
+                     : lowered.xla_output_shape;
+    const xla::Shape& shape =
+        tuple_output ? xla_output_shape.tuple_shapes(i) : xla_output_shape;
+    if (!lowered_shape.IsArray() ||
+        TensorShape(XlaDimensionSizes(lowered_shape)) != output.shape) {
+      return errors::Unimplemented("Output ", i, " is reshaped");
+    }
+    TF_RETURN_IF_ERROR(XLAShapeToTensorShape(shape, &output.shape));
+  }
+
+  *result = lowered;
+  result->xla_input_shapes = std::move(xla_input_shapes);
+  result->xla_output_shape = std::move(xla_output_shape);
+  result->outputs = std::move(outputs);
+  result->computation =
+      std::make_shared<xla::XlaComputation>(std::move(module));
+  return Status::OK();
+}
+
 // Computes the XLA shape for argument 'arg'.
 Status XlaCompiler::XLAShapeForArgument(
     const XlaCompiler::Argument& arg, bool is_entry_computation,
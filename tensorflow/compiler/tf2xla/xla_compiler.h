@@ -212,6 +212,20 @@ class XlaCompiler {
                          absl::Span<const Argument> args,
                          CompilationResult* result);
 
+  // Reuses `lowered`, the result of CompileFunction() for `fn_name_attrs` and
+  // `lowered_args`, for `args`, whose parameters may only differ from
+  // `lowered_args` in their dimension sizes. Rather than lowering the function
+  // again, infers the shapes of the instructions of its computation for the
+  // new parameter shapes. Returns an Unimplemented error if the computation
+  // may depend on the dimension sizes of the parameters, in which case the
+  // function must be compiled with CompileFunction().
+  Status RespecializeFunction(const CompileOptions& options,
+                              const NameAttrList& fn_name_attrs,
+                              absl::Span<const Argument> lowered_args,
+                              const CompilationResult& lowered,
+                              absl::Span<const Argument> args,
+                              CompilationResult* result);
+
   // Compiles a tensorflow::Graph into an xla::XlaComputation.
   // Similar to CompileFunction, but takes a Graph as input rather than a
   // function.
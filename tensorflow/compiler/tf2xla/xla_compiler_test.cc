@@ -1020,6 +1020,120 @@ TEST_F(XlaCompilerTest, LocalFunctionWithWrongArgumentsFail) {
       << status.error_message();
 }
 
+FunctionDef ScaledSumFn() {
+  return FunctionDefHelper::Define(
+      // Name
+      "ScaledSumFn",
+      // Args
+      {"x: float", "y: float"},
+      // Return values
+      {"z: float"},
+      // Attr def
+      {},
+      // Nodes
+      {FunctionDefHelper::Const("two", 2.0f),
+       {{"sum"}, "Add", {"x", "y"}, {{"T", DT_FLOAT}}},
+       {{"z"}, "Mul", {"sum", "two"}, {{"T", DT_FLOAT}}}});
+}
+
+FunctionDef ReshapeToShapeFn() {
+  return FunctionDefHelper::Define(
+      // Name
+      "ReshapeToShapeFn",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"shape"}, "Shape", {"x"}, {{"T", DT_FLOAT}}},
+       {{"y"}, "Reshape", {"x", "shape"}, {{"T", DT_FLOAT}}}});
+}
+
+std::vector<XlaCompiler::Argument> FloatParameters(int num_args,
+                                                    const TensorShape& shape) {
+  std::vector<XlaCompiler::Argument> args(num_args);
+  for (XlaCompiler::Argument& arg : args) {
+    arg.kind = XlaCompiler::Argument::kParameter;
+    arg.type = DT_FLOAT;
+    arg.shape = shape;
+  }
+  return args;
+}
+
+// Tests that a function lowered for some dimension sizes is respecialized for
+// others.
+TEST_F(XlaCompilerTest, RespecializeFunction) {
+  TF_ASSERT_OK(flib_def_->AddFunctionDef(ScaledSumFn()));
+  XlaCompiler compiler(DefaultOptions());
+  NameAttrList name_attr;
+  name_attr.set_name("ScaledSumFn");
+
+  std::vector<XlaCompiler::Argument> lowered_args =
+      FloatParameters(2, TensorShape({2}));
+  XlaCompiler::CompilationResult lowered;
+  TF_ASSERT_OK(compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                        name_attr, lowered_args, &lowered));
+
+  std::vector<XlaCompiler::Argument> args =
+      FloatParameters(2, TensorShape({3}));
+  XlaCompiler::CompilationResult result;
+  TF_ASSERT_OK(compiler.RespecializeFunction(XlaCompiler::CompileOptions(),
+                                             name_attr, lowered_args, lowered,
+                                             args, &result));
+  ASSERT_EQ(1, result.outputs.size());
+  EXPECT_EQ(TensorShape({3}), result.outputs[0].shape);
+  ASSERT_EQ(2, result.xla_input_shapes.size());
+  EXPECT_TRUE(xla::ShapeUtil::Equal(xla::ShapeUtil::MakeShape(xla::F32, {3}),
+                                    result.xla_input_shapes[0]));
+
+  // Tests that the respecialized computation works.
+  xla::Literal param0_literal = xla::LiteralUtil::CreateR1<float>({1, 2, 3});
+  xla::Literal param1_literal = xla::LiteralUtil::CreateR1<float>({4, 5, 6});
+  std::unique_ptr<xla::GlobalData> param0_data =
+      client_->TransferToServer(param0_literal).ConsumeValueOrDie();
+  std::unique_ptr<xla::GlobalData> param1_data =
+      client_->TransferToServer(param1_literal).ConsumeValueOrDie();
+
+  std::unique_ptr<xla::GlobalData> actual =
+      client_
+          ->Execute(*result.computation, {param0_data.get(), param1_data.get()})
+          .ConsumeValueOrDie();
+  xla::Literal actual_literal = client_->Transfer(*actual).ConsumeValueOrDie();
+
+  xla::Literal expected0 = xla::LiteralUtil::CreateR1<float>({10, 14, 18});
+  xla::Literal expected_literal = xla::LiteralUtil::MakeTuple({&expected0});
+  EXPECT_TRUE(xla::LiteralTestUtil::Equal(expected_literal, actual_literal));
+
+  // The ranks of the parameters cannot change.
+  Status status = compiler.RespecializeFunction(
+      XlaCompiler::CompileOptions(), name_attr, lowered_args, lowered,
+      FloatParameters(2, TensorShape({3, 2})), &result);
+  EXPECT_TRUE(errors::IsUnimplemented(status)) << status;
+}
+
+// Tests that a function reading the shapes of its arguments is not
+// respecialized.
+TEST_F(XlaCompilerTest, RespecializeFunctionReadingShapes) {
+  TF_ASSERT_OK(flib_def_->AddFunctionDef(ReshapeToShapeFn()));
+  XlaCompiler compiler(DefaultOptions());
+  NameAttrList name_attr;
+  name_attr.set_name("ReshapeToShapeFn");
+
+  std::vector<XlaCompiler::Argument> lowered_args =
+      FloatParameters(1, TensorShape({2}));
+  XlaCompiler::CompilationResult lowered;
+  TF_ASSERT_OK(compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                        name_attr, lowered_args, &lowered));
+
+  XlaCompiler::CompilationResult result;
+  Status status = compiler.RespecializeFunction(
+      XlaCompiler::CompileOptions(), name_attr, lowered_args, lowered,
+      FloatParameters(1, TensorShape({3})), &result);
+  EXPECT_TRUE(errors::IsUnimplemented(status)) << status;
+}
+
 void RunAndCheckVariablesComputation(
     xla::Client* client, const XlaCompiler::CompilationResult& result) {
   xla::Literal param0_literal = xla::LiteralUtil::CreateR1<int32>({7, 42});
@@ -104,6 +104,15 @@ class ExecutableBuildOptions {
     alias_passthrough_params_ = alias_passthrough_params;
   }
 
+  // Whether the computation is already optimized, so that only the backend
+  // compiles it: the HLO passes are skipped. Only single partition
+  // computations are supported.
+  bool run_backend_only() const { return run_backend_only_; }
+  ExecutableBuildOptions& set_run_backend_only(bool run_backend_only) {
+    run_backend_only_ = run_backend_only;
+    return *this;
+  }
+
  private:
   int device_ordinal_ = -1;
   Shape result_layout_;
@@ -116,6 +125,7 @@ class ExecutableBuildOptions {
   bool deduplicate_hlo_ = false;
   absl::optional<DeviceAssignment> device_assignment_;
   bool alias_passthrough_params_ = false;
+  bool run_backend_only_ = false;
 };
 
 }  // namespace xla
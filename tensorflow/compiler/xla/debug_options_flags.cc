@@ -72,6 +72,8 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_force_host_platform_device_count(1);
   opts.set_xla_gpu_deterministic_reductions(false);
   opts.set_xla_cpu_enable_xprof_traceme(false);
+  opts.set_xla_cpu_parallel_codegen_split_count(1);
+  opts.set_xla_gpu_enable_cuda_graphs(false);
   opts.set_xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found(false);
 
   return opts;
@@ -273,6 +275,19 @@ static void AllocateFlags() {
       flag_values->xla_cpu_enable_fast_min_max(),
       "Enable fast floating point min/max lowering that always propagates "
       "NaNs."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_codegen_split_count",
+      int32_setter_for(
+          &DebugOptions::set_xla_cpu_parallel_codegen_split_count),
+      flag_values->xla_cpu_parallel_codegen_split_count(),
+      "If greater than 1, split the LLVM module of a computation into up to "
+      "this many modules which the CPU backend compiles concurrently."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Capture the thunks of GPU executables into CUDA graphs, and replay the "
+      "graphs when the executables run again with the same buffers."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_enable_fast_min_max",
       bool_setter_for(&DebugOptions::set_xla_gpu_enable_fast_min_max),
@@ -28,7 +28,8 @@ CpuDevice::CpuDevice(int id,
     : PjRtDevice(id, std::move(local_device_state), kCpuPlatformName,
                  /*device_kind=*/kCpuPlatformName) {}
 
-StatusOr<std::unique_ptr<PjRtClient>> GetCpuClient(bool asynchronous) {
+StatusOr<std::unique_ptr<PjRtClient>> GetCpuClient(
+    bool asynchronous, int intra_op_parallelism_threads) {
   TF_ASSIGN_OR_RETURN(se::Platform * platform,
                       PlatformUtil::GetPlatform("Host"));
   if (platform->VisibleDeviceCount() <= 0) {
@@ -52,6 +53,9 @@ StatusOr<std::unique_ptr<PjRtClient>> GetCpuClient(bool asynchronous) {
     auto device_state = absl::make_unique<LocalDeviceState>(
         executor, client, LocalDeviceState::kSynchronous, asynchronous,
         /*allow_event_reuse=*/false);
+    if (intra_op_parallelism_threads > 0) {
+      device_state->CreateIntraOpThreadPool(intra_op_parallelism_threads);
+    }
     auto device = absl::make_unique<CpuDevice>(i, std::move(device_state));
     devices.push_back(std::move(device));
   }
@@ -28,7 +28,18 @@ class CpuDevice : public PjRtDevice {
   CpuDevice(int id, std::unique_ptr<LocalDeviceState> local_device_state);
 };
 
-StatusOr<std::unique_ptr<PjRtClient>> GetCpuClient(bool asynchronous);
+// Returns a client with a CPU device per host platform device, of which there
+// are --xla_force_host_platform_device_count.  If `asynchronous` is true,
+// executions and transfers are dispatched to the devices without waiting for
+// them to complete, and the buffers they produce are defined once they do.
+//
+// If `intra_op_parallelism_threads` is positive, each device runs the intra-op
+// parallel work of its computations on a thread pool of its own with that many
+// threads, rather than all the devices sharing the thread pool of the backend.
+// This keeps data-parallel computations on several devices from contending for
+// the same threads.
+StatusOr<std::unique_ptr<PjRtClient>> GetCpuClient(
+    bool asynchronous, int intra_op_parallelism_threads = 0);
 
 }  // namespace xla
 
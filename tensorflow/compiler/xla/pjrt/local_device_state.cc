@@ -13,13 +13,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
 #include "tensorflow/compiler/xla/pjrt/local_device_state.h"
 
 #include <memory>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/stream_executor/stream.h"
@@ -85,6 +89,15 @@ Status LocalDeviceState::SynchronizeAllActivity() {
   return status;
 }
 
+void LocalDeviceState::CreateIntraOpThreadPool(int num_threads) {
+  CHECK_GT(num_threads, 0);
+  intra_op_thread_pool_ = absl::make_unique<tensorflow::thread::ThreadPool>(
+      tensorflow::Env::Default(),
+      absl::StrCat("py_xla_intra_op_", device_ordinal()), num_threads);
+  intra_op_thread_pool_device_ = absl::make_unique<Eigen::ThreadPoolDevice>(
+      intra_op_thread_pool_->AsEigenThreadPool(), num_threads);
+}
+
 Status LocalDeviceState::ThenMemcpyDeviceToDevice(
     se::Stream* transfer_stream, se::Stream* dst_stream,
     se::DeviceMemoryBase src_buffer, se::DeviceMemoryBase dst_buffer) {
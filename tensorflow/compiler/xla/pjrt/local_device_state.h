@@ -26,8 +26,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/pjrt/semaphore.h"
 #include "tensorflow/compiler/xla/pjrt/worker_thread.h"
 #include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/stream_executor.h"
 
+namespace Eigen {
+struct ThreadPoolDevice;
+}  // namespace Eigen
+
 namespace xla {
 
 // Class that encapsulates state relating to a device (e.g., a GPU) on which we
@@ -131,6 +136,17 @@ class LocalDeviceState {
 
   WorkerThread* execute_thread() const { return execute_thread_.get(); }
 
+  // Creates a thread pool with `num_threads` threads, on which the computations
+  // launched on this device run their intra-op parallel work instead of on the
+  // thread pool of the backend, which is shared by all the devices.
+  void CreateIntraOpThreadPool(int num_threads);
+
+  // Returns the thread pool created by CreateIntraOpThreadPool, or nullptr if
+  // the computations run on the thread pool of the backend.
+  const Eigen::ThreadPoolDevice* intra_op_thread_pool() const {
+    return intra_op_thread_pool_device_.get();
+  }
+
   // Enqueues a host callback on 'stream', to be executed by callback_thread_.
   // ThenDoHostCallback is often constrained in what it can do, in particular,
   // on GPU the callback runs on a thread belonging to the GPU runtime and
@@ -195,6 +211,10 @@ class LocalDeviceState {
   // work.
   std::unique_ptr<se::Stream> callback_stream_;
 
+  // Thread pool of the device for intra-op parallelism, if any.
+  std::unique_ptr<tensorflow::thread::ThreadPool> intra_op_thread_pool_;
+  std::unique_ptr<Eigen::ThreadPoolDevice> intra_op_thread_pool_device_;
+
   // A worker thread, used for replicated computation launches.
   std::unique_ptr<WorkerThread> execute_thread_;
 
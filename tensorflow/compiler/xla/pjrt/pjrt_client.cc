@@ -1649,8 +1649,12 @@ StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
   run_options.set_stream(device_state->compute_stream());
   run_options.set_host_to_device_stream(device_state->host_to_device_stream());
   run_options.set_allocator(client_->allocator());
-  run_options.set_intra_op_thread_pool(
-      client_->client()->backend().eigen_intra_op_thread_pool_device());
+  if (device_state->intra_op_thread_pool() != nullptr) {
+    run_options.set_intra_op_thread_pool(device_state->intra_op_thread_pool());
+  } else {
+    run_options.set_intra_op_thread_pool(
+        client_->client()->backend().eigen_intra_op_thread_pool_device());
+  }
   run_options.set_device_assignment(device_assignment.get());
   run_options.set_run_id(run_id);
   run_options.set_rng_seed(device_state->GetNewPrngSeed());
@@ -562,12 +562,15 @@ PYBIND11_MODULE(xla_extension, m) {
 
   m.def(
       "get_cpu_client",
-      [](bool asynchronous) -> StatusOr<std::shared_ptr<PyClient>> {
-        TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtClient> client,
-                            GetCpuClient(asynchronous));
+      [](bool asynchronous, int intra_op_parallelism_threads)
+          -> StatusOr<std::shared_ptr<PyClient>> {
+        TF_ASSIGN_OR_RETURN(
+            std::unique_ptr<PjRtClient> client,
+            GetCpuClient(asynchronous, intra_op_parallelism_threads));
         return std::make_shared<PyClient>(std::move(client));
       },
-      py::arg("asynchronous") = true);
+      py::arg("asynchronous") = true,
+      py::arg("intra_op_parallelism_threads") = 0);
   m.def("get_interpreter_client", []() -> StatusOr<std::shared_ptr<PyClient>> {
     TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtClient> client,
                         GetInterpreterClient());
@@ -32,6 +32,8 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Mangler.h"
@@ -44,6 +46,7 @@ limitations under the License.
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"  // from @llvm-project
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"  // from @llvm-project
 #include "mlir/Dialect/Linalg/IR/LinalgTypes.h"  // from @llvm-project
@@ -407,12 +410,12 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
-  if (!is_aot_compile) {
+  if (!is_aot_compile || module->config().intra_op_parallelism_threads() > 0) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
+    // Note this is only run for AOT if requested by
+    // CpuAotCompilationOptions::max_parallelism, because it brings in thread
+    // pool and thread synchronization dependencies which would likely increase
     // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
         max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
   }
@@ -510,6 +513,39 @@ Status VerifyLlvmModule(const llvm::Module& llvm_module) {
   return Status::OK();
 }
 
+// Splits `llvm_module` into up to `num_partitions` modules, each in its own
+// LLVM context so that they can be compiled concurrently.  The partitions are
+// round-tripped through bitcode, since llvm::SplitModule clones them into the
+// context of `llvm_module`.
+StatusOr<std::vector<llvm::orc::ThreadSafeModule>> SplitLlvmModule(
+    std::unique_ptr<llvm::Module> llvm_module, int num_partitions) {
+  XLA_SCOPED_LOGGING_TIMER("CpuCompiler - Splitting LLVM module");
+  std::vector<std::string> bitcodes;
+  llvm::SplitModule(
+      std::move(llvm_module), num_partitions,
+      [&](std::unique_ptr<llvm::Module> partition) {
+        bitcodes.emplace_back();
+        llvm::raw_string_ostream stream(bitcodes.back());
+        llvm::WriteBitcodeToFile(*partition, stream);
+        stream.flush();
+      },
+      /*PreserveLocals=*/false);
+
+  std::vector<llvm::orc::ThreadSafeModule> partitions;
+  for (const std::string& bitcode : bitcodes) {
+    auto llvm_context = std::make_unique<llvm::LLVMContext>();
+    llvm::Expected<std::unique_ptr<llvm::Module>> partition =
+        llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "partition"),
+                               *llvm_context);
+    if (!partition) {
+      return InternalError("Reading a partition of the LLVM module failed: %s",
+                           llvm::toString(partition.takeError()));
+    }
+    partitions.emplace_back(std::move(*partition), std::move(llvm_context));
+  }
+  return std::move(partitions);
+}
+
 Status CreateHloProfilingArtifacts(
     const HloModule& module,
     std::unordered_map<const HloInstruction*, int64>*
@@ -756,10 +792,26 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
-  // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  // JIT compile the LLVM IR module to in-memory machine code.  The module is
+  // only split when nothing observes it, as the hooks would see the partitions.
+  const int split_count =
+      module->config().debug_options().xla_cpu_parallel_codegen_split_count();
+  if (split_count > 1 && !DumpingEnabledForHloModule(*module) &&
+      !user_pre_optimization_hook_ && !user_post_optimization_hook_) {
+    TF_ASSIGN_OR_RETURN(std::vector<llvm::orc::ThreadSafeModule> partitions,
+                        SplitLlvmModule(std::move(llvm_module), split_count));
+    VLOG(1) << "Compiling " << partitions.size()
+            << " LLVM modules in parallel";
+    if (llvm::Error error =
+            (*jit)->AddModulesInParallel(std::move(partitions), split_count)) {
+      return InternalError("Compiling the LLVM modules failed: %s",
+                           llvm::toString(std::move(error)));
+    }
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
   cpu_executable.reset(new CpuExecutable(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
@@ -880,6 +932,11 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
   for (size_t i = 0; i < modules.size(); ++i) {
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
+    if (options.max_parallelism() > 0) {
+      HloModuleConfig config = module->config();
+      config.set_intra_op_parallelism_threads(options.max_parallelism());
+      module->set_config(config);
+    }
 
     TF_RETURN_IF_ERROR(
         RunHloPasses(module, /*is_aot_compile=*/true, target_machine.get()));
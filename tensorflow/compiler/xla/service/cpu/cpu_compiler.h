@@ -70,12 +70,23 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // If positive, large ops are split into up to this many parallel tasks, which
+  // run on the intra-op thread pool of the ExecutableRunOptions.  The compiled
+  // code then requires a thread pool, and the runtime_fork_join library.
+  // Otherwise the compiled code is single-threaded, apart from the Eigen
+  // matmuls and convolutions.
+  int max_parallelism() const { return max_parallelism_; }
+  void set_max_parallelism(int max_parallelism) {
+    max_parallelism_ = max_parallelism;
+  }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int max_parallelism_ = 0;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
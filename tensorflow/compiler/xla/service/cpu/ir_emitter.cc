@@ -2267,7 +2267,8 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
     HloInstruction* root = computation->root_instruction();
     TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
         call_args, root->shape(), root->outer_dimension_partitions(), &b_,
-        call_ir_function, computation->name()));
+        call_ir_function, computation->name(),
+        options::AutotuneParallelTasksRequested(hlo_module_config_)));
   } else {
     EmitGlobalCall(*computation, computation->name());
   }
@@ -239,7 +239,7 @@ std::vector<llvm::Value*> GetArrayFunctionCallArguments(
 Status EmitCallToParallelForkJoin(
     const std::vector<llvm::Value*>& arguments, const Shape& shape,
     const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
-    llvm::Function* parallel_function, const string& name) {
+    llvm::Function* parallel_function, const string& name, bool autotune) {
   llvm::Module* module = b->GetInsertBlock()->getModule();
 
   // Build ParallelForkJoin function type.
@@ -264,8 +264,10 @@ Status EmitCallToParallelForkJoin(
 
   llvm::Function* fork_join_func = llvm::dyn_cast<llvm::Function>(
       module
-          ->getOrInsertFunction(runtime::kParallelForkJoinSymbolName,
-                                fork_join_type)
+          ->getOrInsertFunction(
+              autotune ? runtime::kAutotunedParallelForkJoinSymbolName
+                       : runtime::kParallelForkJoinSymbolName,
+              fork_join_type)
           .getCallee());
   fork_join_func->setCallingConv(llvm::CallingConv::C);
   fork_join_func->setDoesNotThrow();
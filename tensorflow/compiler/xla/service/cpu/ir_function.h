@@ -129,10 +129,13 @@ std::vector<llvm::Value*> GetArrayFunctionCallArguments(
 
 // Emits a call to a runtime fork/join function which dispatches parallel
 // calls to 'parallel_function' (and joins threads before returning).
+// If 'autotune' is true, the runtime times the first calls to choose how many
+// threads run the partitions.
 Status EmitCallToParallelForkJoin(
     const std::vector<llvm::Value*>& arguments, const Shape& shape,
     const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
-    llvm::Function* parallel_function, const string& name);
+    llvm::Function* parallel_function, const string& name,
+    bool autotune = false);
 
 }  // namespace cpu
 }  // namespace xla
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
@@ -106,12 +107,40 @@ class DefaultCostModel : public ParallelCostModel {
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
+// Cost model for the autotuned fork/join runtime, which times the first
+// executions to choose how many threads run the partitions of an instruction.
+// Partitions the instructions for the maximum parallelism, so that the runtime
+// can choose among all the thread counts.
+class AutotunedCostModel : public ParallelCostModel {
+ public:
+  AutotunedCostModel(const int64 max_parallelism,
+                     const HloCostAnalysis::ShapeSizeFunction& shape_size)
+      : max_parallelism_(max_parallelism), shape_size_(shape_size) {}
+  ~AutotunedCostModel() override {}
+
+  int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    // Instructions which fit in the L1 cache are not worth timing.
+    const int64 min_autotuned_cost = 32LL << 10;  // 32KB L1 Cache size.
+    return shape_size_(instruction->shape()) < min_autotuned_cost
+               ? 1
+               : max_parallelism_;
+  }
+
+ private:
+  const int64 max_parallelism_;
+  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+};
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64 max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
     const TargetMachineFeatures* target_machine_features)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
+  if (options::AutotuneParallelTasksRequested(module->config())) {
+    cost_model_.reset(new AutotunedCostModel(max_parallelism, shape_size));
+    return;
+  }
   // Run cost analysis on 'module'.
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
   HloComputation* computation = module->entry_computation();
@@ -205,5 +205,35 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, AutotunedAssignsMaxParallelism) {
+  // Too small to be parallelized by the default cost model.
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_autotuned
+    ENTRY autotuned {
+      lhs = f32[16384] parameter(0)
+      rhs = f32[16384] parameter(1)
+      ROOT add = f32[16384] add(lhs, rhs)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+
+  HloModuleConfig config = GetModuleConfigForTest();
+  DebugOptions debug_options = config.debug_options();
+  (*debug_options.mutable_xla_backend_extra_options())
+      ["xla_cpu_autotune_parallel_tasks"] = "";
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(m, ParseAndReturnVerifiedModule(hlo_string, config));
+  TF_ASSERT_OK_AND_ASSIGN(changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+  const HloInstruction* call = m->entry_computation()->root_instruction();
+  ASSERT_EQ(call->opcode(), HloOpcode::kCall);
+  EXPECT_EQ(call->to_apply()->root_instruction()->outer_dimension_partitions(),
+            std::vector<int64>({max_parallelism_}));
+}
+
 }  // namespace
 }  // namespace xla
@@ -17,11 +17,20 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 using tensorflow::int32;
@@ -31,6 +40,136 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
+namespace {
+
+// Dispatches 'num_tasks - 1' tasks in parallel, and runs the first task
+// inline.  The tasks call 'function' for contiguous ranges of the
+// 'num_partitions' partitions.  Uses blocking counter to synchronize threads
+// after parallel calls complete.
+void ForkJoin(ComputeFunctionType function, void* result_ptr,
+              const xla::ExecutableRunOptions* run_options,
+              const void** params, void** buffer_table, uint64* prof_counters,
+              int32 num_partitions, int64* partitions,
+              int32 num_partitioned_dims, int32 num_tasks) {
+  // Compute partition stride in 'partitions' array.
+  const int64 stride = 2 * num_partitioned_dims;
+  auto run_task = [=](int32 task, const void** task_params) {
+    const int32 begin = int64{task} * num_partitions / num_tasks;
+    const int32 end = int64{task + 1} * num_partitions / num_tasks;
+    for (int32 i = begin; i < end; ++i) {
+      function(result_ptr, run_options, task_params, buffer_table,
+               &partitions[i * stride], prof_counters);
+    }
+  };
+
+  // Dispatch 'num_tasks - 1' tasks to run in parallel.
+  tensorflow::BlockingCounter bc(num_tasks - 1);
+  for (int32 i = 1; i < num_tasks; ++i) {
+    run_options->intra_op_thread_pool()->enqueueNoNotification(
+        [i, &run_task, &bc]() {
+          run_task(i, nullptr);
+          bc.DecrementCount();
+          VLOG(3) << "ParallelForkJoin task " << i << " done.";
+        });
+  }
+
+  // Run first task inline.
+  run_task(0, params);
+  VLOG(3) << "ParallelForkJoin task 0 done.";
+  bc.Wait();
+}
+
+const xla::ExecutableRunOptions* CheckForkJoinArguments(
+    const void* run_options_ptr, const void** params, int32 num_partitions,
+    int64* partitions, int32 num_partitioned_dims, void* function_ptr) {
+  CHECK_EQ(params, nullptr);
+  CHECK_GT(num_partitions, 1);
+  CHECK_GT(num_partitioned_dims, 0);
+  CHECK_NE(function_ptr, nullptr);
+  CHECK_NE(partitions, nullptr);
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  CHECK_NE(run_options, nullptr);
+  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+  return run_options;
+}
+
+// Chooses the number of tasks over which a fork/join call site spreads its
+// partitions.  Each candidate task count is timed on kRunsPerCandidate calls,
+// after which the fastest one is used for the remaining calls.
+class ForkJoinTuner {
+ public:
+  ForkJoinTuner(int32 num_partitions, int32 max_tasks)
+      : num_partitions_(num_partitions), max_tasks_(max_tasks) {
+    for (int32 num_tasks = 1; num_tasks < max_tasks; num_tasks *= 2) {
+      candidates_.push_back(num_tasks);
+    }
+    candidates_.push_back(max_tasks);
+    nanos_.resize(candidates_.size(), std::numeric_limits<int64>::max());
+  }
+
+  int32 num_partitions() const { return num_partitions_; }
+  int32 max_tasks() const { return max_tasks_; }
+
+  // Returns the index of the candidate to run next, or -1 to run the fastest
+  // one without timing it.
+  int NextCandidate() TF_LOCKS_EXCLUDED(mu_) {
+    tensorflow::mutex_lock l(mu_);
+    if (next_run_ >= candidates_.size() * kRunsPerCandidate) return -1;
+    return next_run_++ / kRunsPerCandidate;
+  }
+
+  int32 TaskCount(int candidate) TF_LOCKS_EXCLUDED(mu_) {
+    if (candidate >= 0) return candidates_[candidate];
+    tensorflow::mutex_lock l(mu_);
+    return candidates_[best_];
+  }
+
+  void RecordTime(int candidate, int64 nanos) TF_LOCKS_EXCLUDED(mu_) {
+    tensorflow::mutex_lock l(mu_);
+    nanos_[candidate] = std::min(nanos_[candidate], nanos);
+    if (nanos_[candidate] < nanos_[best_]) best_ = candidate;
+    if (++num_timed_runs_ == candidates_.size() * kRunsPerCandidate) {
+      VLOG(2) << "AutotunedParallelForkJoin chose " << candidates_[best_]
+              << " tasks for " << num_partitions_ << " partitions";
+    }
+  }
+
+ private:
+  static constexpr int kRunsPerCandidate = 2;
+
+  const int32 num_partitions_;
+  const int32 max_tasks_;
+  std::vector<int32> candidates_;
+  tensorflow::mutex mu_;
+  std::vector<int64> nanos_ TF_GUARDED_BY(mu_);
+  int best_ TF_GUARDED_BY(mu_) = 0;
+  int next_run_ TF_GUARDED_BY(mu_) = 0;
+  int num_timed_runs_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Returns the tuner of the call site which dispatches 'function_ptr'.  The
+// tuner is replaced if the partitioning or the thread pool differ from those
+// it was tuned for, which also happens when a compiled function is freed and
+// its address reused.
+ForkJoinTuner* GetForkJoinTuner(void* function_ptr, int32 num_partitions,
+                                int32 max_tasks) {
+  static tensorflow::mutex* mu = new tensorflow::mutex;
+  static auto* tuners =
+      new std::unordered_map<void*, std::unique_ptr<ForkJoinTuner>>;
+  tensorflow::mutex_lock l(*mu);
+  std::unique_ptr<ForkJoinTuner>& tuner = (*tuners)[function_ptr];
+  if (tuner == nullptr || tuner->num_partitions() != num_partitions ||
+      tuner->max_tasks() != max_tasks) {
+    // The tuner may be in use by another call, so it is never deleted.
+    tuner.release();
+    tuner = std::make_unique<ForkJoinTuner>(num_partitions, max_tasks);
+  }
+  return tuner.get();
+}
+
+}  // namespace
+
 // Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
 // Calls 'function_ptr' for first partition inline.
 // Uses blocking counter to synchronize threads after parallel calls complete.
@@ -66,39 +205,48 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   VLOG(2) << "ParallelForkJoin ENTRY"
           << " num_partitions: " << num_partitions
           << " num_partitioned_dims: " << num_partitioned_dims;
-  CHECK_EQ(params, nullptr);
-  CHECK_GT(num_partitions, 1);
-  CHECK_GT(num_partitioned_dims, 0);
-  CHECK_NE(function_ptr, nullptr);
-  CHECK_NE(partitions, nullptr);
   const xla::ExecutableRunOptions* run_options =
-      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
-  CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+      CheckForkJoinArguments(run_options_ptr, params, num_partitions,
+                             partitions, num_partitioned_dims, function_ptr);
+  ForkJoin(reinterpret_cast<ComputeFunctionType>(function_ptr), result_ptr,
+           run_options, params, buffer_table, prof_counters, num_partitions,
+           partitions, num_partitioned_dims, /*num_tasks=*/num_partitions);
+  VLOG(2) << "ParallelForkJoin EXIT";
+}
 
-  ComputeFunctionType function =
-      reinterpret_cast<ComputeFunctionType>(function_ptr);
-  // Compute partition stride in 'partitions' array.
-  const int64 stride = 2 * num_partitioned_dims;
+// Like __xla_cpu_runtime_ParallelForkJoin, but groups the partitions into
+// contiguous ranges run by fewer tasks when that is faster.  The partitions
+// are emitted for the maximum parallelism, and the number of tasks is chosen
+// per call site among the powers of two below the number of threads, by
+// timing each on the first calls.
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_AutotunedParallelForkJoin(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** buffer_table, uint64* prof_counters, int32 num_partitions,
+    int64* partitions, int32 num_partitioned_dims, void* function_ptr) {
+  VLOG(2) << "AutotunedParallelForkJoin ENTRY"
+          << " num_partitions: " << num_partitions
+          << " num_partitioned_dims: " << num_partitioned_dims;
+  const xla::ExecutableRunOptions* run_options =
+      CheckForkJoinArguments(run_options_ptr, params, num_partitions,
+                             partitions, num_partitioned_dims, function_ptr);
+  // The calling thread runs a task too.
+  const int32 max_tasks = std::min(
+      num_partitions, run_options->intra_op_thread_pool()->numThreads() + 1);
+  ForkJoinTuner* tuner =
+      GetForkJoinTuner(function_ptr, num_partitions, max_tasks);
+  const int candidate = tuner->NextCandidate();
+  const int32 num_tasks = tuner->TaskCount(candidate);
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+  const auto start = std::chrono::steady_clock::now();
+  ForkJoin(reinterpret_cast<ComputeFunctionType>(function_ptr), result_ptr,
+           run_options, params, buffer_table, prof_counters, num_partitions,
+           partitions, num_partitioned_dims, num_tasks);
+  if (candidate >= 0) {
+    tuner->RecordTime(candidate,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
   }
-
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
-  VLOG(2) << "ParallelForkJoin EXIT";
+  VLOG(2) << "AutotunedParallelForkJoin EXIT num_tasks: " << num_tasks;
 }
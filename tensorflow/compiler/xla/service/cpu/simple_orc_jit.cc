@@ -48,7 +48,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/windows_compatibility.h"
 #include "tensorflow/compiler/xla/service/custom_call_target_registry.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace cpu {
@@ -106,12 +108,19 @@ SimpleOrcJIT::SimpleOrcJIT(
           *execution_session_, object_layer_,
           std::make_unique<CompilerFunctor>(
               target_machine_.get(), opt_level, optimize_for_size,
-              disable_expensive_passes, fast_math_flags,
-              std::move(pre_optimization_hook),
-              std::move(post_optimization_hook), std::move(post_codegen_hook))),
+              disable_expensive_passes, fast_math_flags, pre_optimization_hook,
+              post_optimization_hook, post_codegen_hook)),
       main_jit_dylib_(&execution_session_->createBareJITDylib("<main>")),
       gdb_jit_event_listener_(
-          llvm::JITEventListener::createGDBRegistrationListener()) {
+          llvm::JITEventListener::createGDBRegistrationListener()),
+      target_options_(target_options),
+      opt_level_(opt_level),
+      optimize_for_size_(optimize_for_size),
+      disable_expensive_passes_(disable_expensive_passes),
+      fast_math_flags_(fast_math_flags),
+      pre_optimization_hook_(std::move(pre_optimization_hook)),
+      post_optimization_hook_(std::move(post_optimization_hook)),
+      post_codegen_hook_(std::move(post_codegen_hook)) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 
@@ -214,6 +223,49 @@ llvm::Error SimpleOrcJIT::AddModule(llvm::orc::ThreadSafeModule module) {
   return compile_layer_.add(*main_jit_dylib_, std::move(module));
 }
 
+llvm::Error SimpleOrcJIT::AddModulesInParallel(
+    std::vector<llvm::orc::ThreadSafeModule> modules, int num_threads) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects(modules.size());
+  std::vector<std::string> errors(modules.size());
+  {
+    // The target machine is not thread-safe, so each module is compiled with
+    // its own.
+    tensorflow::thread::ThreadPool pool(
+        tensorflow::Env::Default(), "xla_cpu_codegen",
+        std::max(1, std::min<int>(num_threads, modules.size())));
+    for (int i = 0; i < modules.size(); ++i) {
+      pool.Schedule([this, i, &modules, &objects, &errors]() {
+        std::unique_ptr<llvm::TargetMachine> target_machine =
+            InferTargetMachineForJIT(target_options_, opt_level_);
+        CompilerFunctor compiler(target_machine.get(), opt_level_,
+                                 optimize_for_size_, disable_expensive_passes_,
+                                 fast_math_flags_, pre_optimization_hook_,
+                                 post_optimization_hook_, post_codegen_hook_);
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object =
+            modules[i].withModuleDo(
+                [&](llvm::Module& module) { return compiler(module); });
+        if (object) {
+          objects[i] = std::move(*object);
+        } else {
+          errors[i] = llvm::toString(object.takeError());
+        }
+      });
+    }
+  }
+
+  for (int i = 0; i < modules.size(); ++i) {
+    if (!errors[i].empty()) {
+      return llvm::make_error<llvm::StringError>(
+          errors[i], llvm::inconvertibleErrorCode());
+    }
+    if (llvm::Error error =
+            object_layer_.add(*main_jit_dylib_, std::move(objects[i]))) {
+      return error;
+    }
+  }
+  return llvm::Error::success();
+}
+
 llvm::Expected<llvm::JITEvaluatedSymbol> SimpleOrcJIT::FindCompiledSymbol(
     const std::string& name) {
   return execution_session_->lookup({main_jit_dylib_}, name);
@@ -272,6 +324,7 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulC128);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulS32);
   REGISTER_CPU_RUNTIME_SYMBOL(ParallelForkJoin);
+  REGISTER_CPU_RUNTIME_SYMBOL(AutotunedParallelForkJoin);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseInfeedBufferAfterDequeue);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseOutfeedBufferAfterPopulation);
   REGISTER_CPU_RUNTIME_SYMBOL(KeyValueSort);
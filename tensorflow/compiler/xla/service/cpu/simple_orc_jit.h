@@ -79,6 +79,12 @@ class SimpleOrcJIT : public llvm::JITEventListener {
 
   llvm::Error AddModule(llvm::orc::ThreadSafeModule module);
 
+  // Compiles `modules` to machine code on up to `num_threads` threads and adds
+  // them to the JIT.  The modules must not share an LLVM context, and may
+  // reference each other's symbols.  The hooks may be called concurrently.
+  llvm::Error AddModulesInParallel(
+      std::vector<llvm::orc::ThreadSafeModule> modules, int num_threads);
+
   // Get the runtime address of the compiled symbol whose name is given. Returns
   // nullptr if the symbol cannot be found.
   llvm::Expected<llvm::JITEvaluatedSymbol> FindCompiledSymbol(
@@ -122,6 +128,17 @@ class SimpleOrcJIT : public llvm::JITEventListener {
   // free this, but the function is poorly named and really just returns a
   // pointer to a static object.
   llvm::JITEventListener* gdb_jit_event_listener_;
+
+  // The options of the compile layer, from which AddModulesInParallel creates
+  // a compiler per thread.
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
+  const bool optimize_for_size_;
+  const bool disable_expensive_passes_;
+  const llvm::FastMathFlags fast_math_flags_;
+  LLVMCompiler::ModuleHook pre_optimization_hook_;
+  LLVMCompiler::ModuleHook post_optimization_hook_;
+  std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook_;
 };
 
 }  // namespace cpu
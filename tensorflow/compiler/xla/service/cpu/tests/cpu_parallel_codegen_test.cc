@@ -0,0 +1,73 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelCodegenTest : public CpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_parallel_codegen_split_count(4);
+    return debug_options;
+  }
+};
+
+TEST_F(CpuParallelCodegenTest, CallsAcrossPartitions) {
+  // The embedded computations and the constant are emitted as separate
+  // globals, which are spread over the partitions of the LLVM module.
+  const char* const hlo_text = R"(
+HloModule CallsAcrossPartitions
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+max {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT max = f32[] maximum(lhs, rhs)
+}
+
+compare {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT lt = pred[] compare(lhs, rhs), direction=LT
+}
+
+ENTRY main {
+  x = f32[8,16] parameter(0)
+  c = f32[16] constant({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16})
+  b = f32[8,16] broadcast(c), dimensions={1}
+  y = f32[8,16] multiply(x, b)
+  zero = f32[] constant(0)
+  sum = f32[8] reduce(y, zero), dimensions={1}, to_apply=add
+  min = f32[] constant(-inf)
+  max = f32[8] reduce(y, min), dimensions={1}, to_apply=max
+  sorted = f32[8] sort(sum), dimensions={0}, to_apply=compare
+  ROOT result = f32[8] add(sorted, max)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
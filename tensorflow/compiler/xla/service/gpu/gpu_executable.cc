@@ -15,19 +15,23 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 
+#include <map>
 #include <set>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/copy_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_debug_info_manager.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable_run_options.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
+#include "tensorflow/compiler/xla/service/gpu/sequential_thunk.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/buffer_assignment_util.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
@@ -44,14 +48,87 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/stream_executor/platform.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA
+
 namespace xla {
 namespace gpu {
 namespace {
 
 using ::tensorflow::profiler::ScopedAnnotation;
 
+// Returns whether `thunk` only enqueues device work which can be captured into
+// a CUDA graph and replayed.  Thunks which run host code, call libraries which
+// may synchronize or allocate memory, or pick what to run on the host, such as
+// conditionals and loops, cannot be captured.
+bool CanCaptureThunk(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kGemm:
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+      return true;
+    case Thunk::kCopy:
+      return dynamic_cast<const DeviceToDeviceCopyThunk*>(&thunk) != nullptr;
+    case Thunk::kSequential:
+      return absl::c_all_of(
+          static_cast<const SequentialThunk&>(thunk).thunks(),
+          [](const std::unique_ptr<Thunk>& nested_thunk) {
+            return CanCaptureThunk(*nested_thunk);
+          });
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
+#if GOOGLE_CUDA
+
+class GpuExecutable::GraphCache {
+ public:
+  // The graphs baked in the buffer addresses, so there is one per executor and
+  // buffer addresses.
+  using Key = std::pair<se::StreamExecutor*, std::vector<const void*>>;
+
+  struct Entry {
+    // The number of executions which launched the thunks without a graph.
+    int num_launches = 0;
+    bool capturing = false;
+    se::gpu::GpuContext* context = nullptr;
+    se::gpu::GpuGraphExecHandle graph_exec = nullptr;
+  };
+
+  // Bounds the number of graphs, since temporary buffers may land at new
+  // addresses on every execution.
+  static constexpr int kMaxEntries = 16;
+
+  ~GraphCache() {
+    for (auto& key_and_entry : entries) {
+      const Entry& entry = key_and_entry.second;
+      if (entry.graph_exec != nullptr) {
+        se::gpu::GpuDriver::DestroyGraphExec(entry.context, entry.graph_exec);
+      }
+    }
+  }
+
+  tensorflow::mutex mu;
+  // Set when a capture fails, after which the thunks are always launched
+  // without a graph.
+  bool disabled TF_GUARDED_BY(mu) = false;
+  // Entries are never erased, so that pointers to them stay valid.
+  std::map<Key, Entry> entries TF_GUARDED_BY(mu);
+};
+
+#else  // GOOGLE_CUDA
+
+class GpuExecutable::GraphCache {};
+
+#endif  // GOOGLE_CUDA
+
 // Implementation note: HLO profiling is always enabled for GPU executables,
 // since we can use timers around thunks.
 GpuExecutable::GpuExecutable(
@@ -73,6 +150,12 @@ GpuExecutable::GpuExecutable(
   CHECK(has_module() && assignment_);
   GpuDebugInfoManager::Get()->RegisterModule(module().name(), shared_module(),
                                              assignment_);
+  if (module().config().debug_options().xla_gpu_enable_cuda_graphs() &&
+      absl::c_all_of(thunk_schedule_->TotalOrder(), [](const Thunk* thunk) {
+        return CanCaptureThunk(*thunk);
+      })) {
+    graph_cache_ = absl::make_unique<GraphCache>();
+  }
 }
 
 GpuExecutable::~GpuExecutable() {
@@ -152,9 +235,6 @@ Status GpuExecutable::ExecuteThunks(
     sub_streams.emplace_back();
     TF_ASSIGN_OR_RETURN(sub_streams.back(),
                         run_options->BorrowStream(executor->device_ordinal()));
-    // Require substreams to wait for the main stream, otherwise substreams may
-    // execute before the program is scheduled to start on the main stream.
-    sub_streams.back()->ThenWaitFor(main_stream);
   }
 
   HloExecutionProfiler profiler(do_profile, hlo_execution_profile, main_stream,
@@ -165,49 +245,20 @@ Status GpuExecutable::ExecuteThunks(
       [&] { return absl::StrCat(hlo_module_->name(), ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
   std::vector<std::function<void()>> deferred_host_callbacks;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
-
-    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
-
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
-
-    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
-            << " on stream " << stream_no;
-    const GpuExecutableRunOptions* gpu_options =
-        run_options->run_options().gpu_executable_run_options();
-    Thunk::ExecuteParams thunk_params{
-        &buffer_allocations,
-        stream,
-        run_options->run_options().run_id(),
-        &profiler,
-        run_options->run_options().device_assignment(),
-        &deferred_host_callbacks,
-        gpu_options && gpu_options->gpu_global_device_ids()
-            ? &*gpu_options->gpu_global_device_ids()
-            : nullptr,
-        gpu_options && gpu_options->nccl_unique_id_callback()
-            ? &gpu_options->nccl_unique_id_callback()
-            : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
-    }
+  bool launched_from_graph = false;
+  if (graph_cache_ != nullptr && !do_profile) {
+    TF_ASSIGN_OR_RETURN(
+        launched_from_graph,
+        LaunchThunksFromGraph(run_options, buffer_allocations, sub_streams,
+                              &profiler, &deferred_host_callbacks));
+  }
+  if (!launched_from_graph) {
+    TF_RETURN_IF_ERROR(LaunchThunks(run_options, buffer_allocations,
+                                    sub_streams, &profiler,
+                                    &deferred_host_callbacks));
   }
 
-  main_stream->ThenWaitFor(&sub_streams);
   if (!deferred_host_callbacks.empty()) {
     auto fn = [deferred_host_callbacks{std::move(deferred_host_callbacks)}]() {
       for (auto& callback : deferred_host_callbacks) {
@@ -256,6 +307,152 @@ Status GpuExecutable::ExecuteThunks(
   return Status::OK();
 }
 
+Status GpuExecutable::LaunchThunks(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations,
+    absl::Span<const StreamPool::Ptr> sub_streams,
+    HloExecutionProfiler* profiler,
+    std::vector<std::function<void()>>* deferred_host_callbacks) {
+  se::Stream* main_stream = run_options->stream();
+  // Require substreams to wait for the main stream, otherwise substreams may
+  // execute before the program is scheduled to start on the main stream.
+  for (const StreamPool::Ptr& sub_stream : sub_streams) {
+    sub_stream->ThenWaitFor(main_stream);
+  }
+
+  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
+  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    // Annotate execution of this op if tracing was enabled when we started
+    // running this module.  If tracing is enabled *while* we're running the
+    // module, we won't get any data, but that's probably an OK trade-off.
+    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
+
+    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
+    se::Stream* stream =
+        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+
+    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+    }
+
+    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
+            << " on stream " << stream_no;
+    const GpuExecutableRunOptions* gpu_options =
+        run_options->run_options().gpu_executable_run_options();
+    Thunk::ExecuteParams thunk_params{
+        &buffer_allocations,
+        stream,
+        run_options->run_options().run_id(),
+        profiler,
+        run_options->run_options().device_assignment(),
+        deferred_host_callbacks,
+        gpu_options && gpu_options->gpu_global_device_ids()
+            ? &*gpu_options->gpu_global_device_ids()
+            : nullptr,
+        gpu_options && gpu_options->nccl_unique_id_callback()
+            ? &gpu_options->nccl_unique_id_callback()
+            : nullptr};
+    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+    if (thunk_schedule_->Depended(thunk)) {
+      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
+      finish_event->Init();
+      stream->ThenRecordEvent(finish_event.get());
+      thunk_to_finish_event[thunk] = std::move(finish_event);
+    }
+  }
+
+  for (const StreamPool::Ptr& sub_stream : sub_streams) {
+    main_stream->ThenWaitFor(sub_stream.get());
+  }
+  return Status::OK();
+}
+
+StatusOr<bool> GpuExecutable::LaunchThunksFromGraph(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations,
+    absl::Span<const StreamPool::Ptr> sub_streams,
+    HloExecutionProfiler* profiler,
+    std::vector<std::function<void()>>* deferred_host_callbacks) {
+#if GOOGLE_CUDA
+  se::Stream* main_stream = run_options->stream();
+  se::gpu::GpuContext* context =
+      se::gpu::AsGpuStream(main_stream)->parent()->gpu_context();
+  se::gpu::GpuStreamHandle stream = se::gpu::AsGpuStreamValue(main_stream);
+
+  GraphCache::Key key;
+  key.first = main_stream->parent();
+  for (BufferAllocation::Index i = 0; i < assignment_->Allocations().size();
+       ++i) {
+    key.second.push_back(buffer_allocations.GetDeviceAddress(i).opaque());
+  }
+
+  GraphCache::Entry* entry;
+  se::gpu::GpuGraphExecHandle graph_exec;
+  {
+    tensorflow::mutex_lock lock(graph_cache_->mu);
+    if (graph_cache_->disabled) return false;
+    auto it = graph_cache_->entries.find(key);
+    if (it == graph_cache_->entries.end()) {
+      if (graph_cache_->entries.size() >= GraphCache::kMaxEntries) {
+        return false;
+      }
+      it = graph_cache_->entries.emplace(std::move(key), GraphCache::Entry())
+               .first;
+    }
+    entry = &it->second;
+    graph_exec = entry->graph_exec;
+    if (graph_exec == nullptr) {
+      // The first execution loads the kernels and initializes the libraries,
+      // which cannot be captured, so only the second one is.
+      if (entry->num_launches++ == 0 || entry->capturing) return false;
+      entry->capturing = true;
+    }
+  }
+
+  if (graph_exec == nullptr) {
+    VLOG(1) << "Capturing the thunks of " << module().name()
+            << " into a CUDA graph";
+    se::gpu::GpuGraphHandle graph = nullptr;
+    Status status = se::gpu::GpuDriver::StreamBeginCapture(context, stream);
+    if (status.ok()) {
+      status = LaunchThunks(run_options, buffer_allocations, sub_streams,
+                            profiler, deferred_host_callbacks);
+      Status end_status =
+          se::gpu::GpuDriver::StreamEndCapture(context, stream, &graph);
+      if (status.ok()) status = end_status;
+    }
+    if (status.ok() && !deferred_host_callbacks->empty()) {
+      status = Unimplemented("Host callbacks cannot be captured");
+    }
+    if (status.ok()) {
+      status =
+          se::gpu::GpuDriver::GraphInstantiate(context, graph, &graph_exec);
+    }
+    if (graph != nullptr) {
+      se::gpu::GpuDriver::DestroyGraph(context, graph);
+    }
+
+    tensorflow::mutex_lock lock(graph_cache_->mu);
+    entry->capturing = false;
+    if (!status.ok()) {
+      LOG(WARNING) << "Launching the thunks of " << module().name()
+                   << " without CUDA graphs: " << status;
+      graph_cache_->disabled = true;
+      deferred_host_callbacks->clear();
+      return false;
+    }
+    entry->context = context;
+    entry->graph_exec = graph_exec;
+  }
+
+  TF_RETURN_IF_ERROR(
+      se::gpu::GpuDriver::GraphLaunch(context, graph_exec, stream));
+  return true;
+#else   // GOOGLE_CUDA
+  return false;
+#endif  // GOOGLE_CUDA
+}
+
 StatusOr<const GpuExecutable::BufferAllocToDeviceMemoryMap*>
 GpuExecutable::ResolveConstantGlobals(se::Stream* stream) {
   se::StreamExecutor* executor = stream->parent();
@@ -16,8 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/shaped_buffer.h"
+#include "tensorflow/compiler/xla/service/stream_pool.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
@@ -42,6 +45,8 @@ limitations under the License.
 namespace xla {
 namespace gpu {
 
+class HloExecutionProfiler;
+
 // GPU-targeting implementation of the XLA Executable interface.
 //
 // Launches the given GPU kernel via the StreamExecutor.
@@ -109,6 +114,25 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // Launches the thunks on the stream of `run_options` and on `sub_streams`.
+  Status LaunchThunks(
+      const ServiceExecutableRunOptions* run_options,
+      const BufferAllocations& buffer_allocations,
+      absl::Span<const StreamPool::Ptr> sub_streams,
+      HloExecutionProfiler* profiler,
+      std::vector<std::function<void()>>* deferred_host_callbacks);
+
+  // Launches the CUDA graph captured from the thunks by a previous execution
+  // with the same buffer addresses, or captures it if this is the second such
+  // execution.  Returns false if the thunks must be launched by LaunchThunks
+  // instead.
+  StatusOr<bool> LaunchThunksFromGraph(
+      const ServiceExecutableRunOptions* run_options,
+      const BufferAllocations& buffer_allocations,
+      absl::Span<const StreamPool::Ptr> sub_streams,
+      HloExecutionProfiler* profiler,
+      std::vector<std::function<void()>>* deferred_host_callbacks);
+
   // Returns the value set of the root instruction of the entry
   // computation. Uses dataflow analysis from buffer assignment.
   const InstructionValueSet& GetRootValueSet() const;
@@ -178,6 +202,11 @@ class GpuExecutable : public Executable {
 
   std::vector<ConstantInfo> constants_;
 
+  // The CUDA graphs captured by LaunchThunksFromGraph.  Null unless
+  // --xla_gpu_enable_cuda_graphs is set and all the thunks can be captured.
+  class GraphCache;
+  std::unique_ptr<GraphCache> graph_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
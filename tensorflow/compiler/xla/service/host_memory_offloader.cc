@@ -0,0 +1,265 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/host_memory_offloader.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_live_range.h"
+#include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+namespace {
+
+using LogicalTime = HloLiveRange::LogicalTime;
+
+// A value of the entry computation which may be offloaded over the longest
+// stretch of the schedule where it is not used.  The fields ending in
+// `_after` are the indices of the instructions of the entry sequence after
+// which the copies start and end.
+struct Candidate {
+  HloInstruction* instruction;
+  int64 size;
+  int64 offload_start_after;
+  int64 offload_done_after;
+  int64 prefetch_start_after;
+  int64 prefetch_done_after;
+  // The times during which the device buffer of the value is free.
+  LogicalTime free_start;
+  LogicalTime free_end;
+};
+
+// Returns whether the value defined by `instruction` may live in host memory
+// for a while.  Aliased values, such as the loop-carried values of while loops
+// and the outputs of the module, must stay where they are.
+bool CanOffload(const HloInstruction* instruction,
+                const HloAliasAnalysis& alias_analysis,
+                int64 host_memory_space) {
+  switch (instruction->opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kCopyDone:
+    case HloOpcode::kCopyStart:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kParameter:
+    case HloOpcode::kTuple:
+      return false;
+    default:
+      break;
+  }
+  const Shape& shape = instruction->shape();
+  if (!shape.IsArray() || !LayoutUtil::HasLayout(shape) ||
+      shape.layout().memory_space() == host_memory_space) {
+    return false;
+  }
+  const HloValue& value =
+      alias_analysis.dataflow_analysis().GetUniqueValueAt(instruction);
+  if (value.defining_instruction() != instruction ||
+      value.live_out_of_module() ||
+      alias_analysis.GetBufferContainingValue(value).values().size() != 1) {
+    return false;
+  }
+  // Only the direct uses of the value are rewritten.
+  for (const HloUse& use : value.uses()) {
+    if (use.instruction->parent() != instruction->parent() ||
+        !use.operand_index.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the memory use of the module at each time of the schedule,
+// assuming every value occupies its buffer over its whole live range.
+std::vector<int64> ComputeMemoryUse(
+    const HloLiveRange& live_range,
+    const HostMemoryOffloader::ShapeSizeFunction& size_function) {
+  std::vector<int64> memory_use(live_range.schedule_end_time() + 2, 0);
+  for (const auto& value_and_range : live_range.buffer_live_ranges()) {
+    const int64 size = size_function(value_and_range.first->shape());
+    memory_use[value_and_range.second.start] += size;
+    memory_use[value_and_range.second.end + 1] -= size;
+  }
+  for (int64 time = 1; time < memory_use.size(); ++time) {
+    memory_use[time] += memory_use[time - 1];
+  }
+  return memory_use;
+}
+
+}  // namespace
+
+StatusOr<bool> HostMemoryOffloader::Run(HloModule* module) {
+  TF_RET_CHECK(module->has_schedule());
+  HloComputation* entry = module->entry_computation();
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloAliasAnalysis> alias_analysis,
+                      HloAliasAnalysis::Run(module));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloLiveRange> live_range,
+      HloLiveRange::Run(module->schedule(), *alias_analysis, entry));
+  std::vector<int64> memory_use =
+      ComputeMemoryUse(*live_range, options_.size_function);
+  VLOG(1) << "Peak memory use before offloading: "
+          << *std::max_element(memory_use.begin(), memory_use.end());
+
+  const std::vector<HloInstruction*> sequence =
+      module->schedule().sequence(entry).instructions();
+  absl::flat_hash_map<const HloInstruction*, int64> index_of;
+  for (int64 i = 0; i < sequence.size(); ++i) {
+    index_of[sequence[i]] = i;
+  }
+  auto time_of = [&](int64 index) {
+    return live_range->instruction_schedule().at(sequence[index]);
+  };
+
+  // Finds the longest stretch of the schedule where each value is not used,
+  // which must be long enough for the device buffer to be free between the
+  // offload and the prefetch.
+  const int64 overlap = options_.copy_overlap_instructions;
+  std::vector<Candidate> candidates;
+  for (int64 i = 0; i < sequence.size(); ++i) {
+    HloInstruction* instruction = sequence[i];
+    if (!CanOffload(instruction, *alias_analysis,
+                    options_.host_memory_space)) {
+      continue;
+    }
+    const int64 size = options_.size_function(instruction->shape());
+    if (size < options_.min_offload_bytes) continue;
+    std::vector<int64> use_indices;
+    for (const HloInstruction* user : instruction->users()) {
+      use_indices.push_back(index_of.at(user));
+    }
+    absl::c_sort(use_indices);
+    int64 last_index = i;
+    absl::optional<Candidate> best;
+    for (int64 use_index : use_indices) {
+      // The offload ends after `last_index + overlap`, and the prefetch starts
+      // after `use_index - 1 - overlap`.
+      if (use_index - last_index > 2 * overlap + 1) {
+        Candidate candidate;
+        candidate.instruction = instruction;
+        candidate.size = size;
+        candidate.offload_start_after = last_index;
+        candidate.offload_done_after = last_index + overlap;
+        candidate.prefetch_start_after = use_index - 1 - overlap;
+        candidate.prefetch_done_after = use_index - 1;
+        candidate.free_start = time_of(candidate.offload_done_after) + 1;
+        candidate.free_end = time_of(candidate.prefetch_start_after);
+        if (candidate.free_start <= candidate.free_end &&
+            (!best.has_value() || candidate.free_end - candidate.free_start >
+                                      best->free_end - best->free_start)) {
+          best = candidate;
+        }
+      }
+      last_index = use_index;
+    }
+    if (best.has_value()) candidates.push_back(*best);
+  }
+
+  // Greedily offloads the largest value which is free at the peak memory use,
+  // until the peak is below the limit.
+  std::vector<Candidate> offloaded;
+  while (!candidates.empty()) {
+    const int64 peak_time =
+        std::max_element(memory_use.begin(), memory_use.end()) -
+        memory_use.begin();
+    if (memory_use[peak_time] <= options_.memory_limit_bytes) break;
+    auto best = candidates.end();
+    for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+      if (it->free_start <= peak_time && peak_time <= it->free_end &&
+          (best == candidates.end() || it->size > best->size)) {
+        best = it;
+      }
+    }
+    if (best == candidates.end()) break;
+    for (LogicalTime time = best->free_start; time <= best->free_end; ++time) {
+      memory_use[time] -= best->size;
+    }
+    offloaded.push_back(*best);
+    candidates.erase(best);
+  }
+  if (offloaded.empty()) return false;
+  VLOG(1) << "Offloading " << offloaded.size()
+          << " values, peak memory use after offloading: "
+          << *std::max_element(memory_use.begin(), memory_use.end());
+
+  // Inserts the copies, and rewrites the uses after the prefetch.
+  std::vector<std::vector<HloInstruction*>> scheduled_after(sequence.size());
+  for (const Candidate& candidate : offloaded) {
+    HloInstruction* instruction = candidate.instruction;
+    const Shape& device_shape = instruction->shape();
+    Shape host_shape = device_shape;
+    host_shape.mutable_layout()->set_memory_space(options_.host_memory_space);
+    const Shape context_shape = ShapeUtil::MakeShape(U32, {});
+
+    HloInstruction* offload_start =
+        entry->AddInstruction(HloInstruction::CreateCopyStart(
+            ShapeUtil::MakeTupleShape(
+                {host_shape, device_shape, context_shape}),
+            instruction));
+    HloInstruction* offload_done = entry->AddInstruction(
+        HloInstruction::CreateUnary(host_shape, HloOpcode::kCopyDone,
+                                    offload_start));
+    HloInstruction* prefetch_start =
+        entry->AddInstruction(HloInstruction::CreateCopyStart(
+            ShapeUtil::MakeTupleShape(
+                {device_shape, host_shape, context_shape}),
+            offload_done));
+    HloInstruction* prefetch_done = entry->AddInstruction(
+        HloInstruction::CreateUnary(device_shape, HloOpcode::kCopyDone,
+                                    prefetch_start));
+    VLOG(2) << "Offloading " << instruction->name() << " after "
+            << sequence[candidate.offload_start_after]->name()
+            << " and prefetching it after "
+            << sequence[candidate.prefetch_start_after]->name();
+
+    const std::vector<HloInstruction*> users = instruction->users();
+    for (HloInstruction* user : users) {
+      if (user != offload_start &&
+          index_of.at(user) > candidate.prefetch_done_after) {
+        TF_RETURN_IF_ERROR(instruction->ReplaceUseWith(user, prefetch_done));
+      }
+    }
+    scheduled_after[candidate.offload_start_after].push_back(offload_start);
+    scheduled_after[candidate.offload_done_after].push_back(offload_done);
+    scheduled_after[candidate.prefetch_start_after].push_back(prefetch_start);
+    scheduled_after[candidate.prefetch_done_after].push_back(prefetch_done);
+  }
+
+  HloInstructionSequence new_sequence;
+  for (int64 i = 0; i < sequence.size(); ++i) {
+    new_sequence.push_back(sequence[i]);
+    for (HloInstruction* instruction : scheduled_after[i]) {
+      new_sequence.push_back(instruction);
+    }
+  }
+  module->schedule().set_sequence(entry, std::move(new_sequence));
+  TF_RETURN_IF_ERROR(module->schedule().Verify());
+  return true;
+}
+
+}  // namespace xla
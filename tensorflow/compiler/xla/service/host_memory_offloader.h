@@ -0,0 +1,82 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HOST_MEMORY_OFFLOADER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_HOST_MEMORY_OFFLOADER_H_
+
+#include <functional>
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+// HLO pass which reduces the peak device memory use of a scheduled module by
+// offloading long-lived values of the entry computation to host memory.
+//
+// A value which is not used for a long stretch of the schedule is copied to
+// host memory asynchronously after its definition or one of its uses, and
+// prefetched back asynchronously before its next use, which then reads the
+// prefetched copy.  The copies are copy-start/copy-done pairs whose host side
+// has the host memory space in its layout, and which are scheduled a few
+// instructions apart so that they overlap with compute.  The device buffer of
+// the value is thus free between the end of the offload and the start of the
+// prefetch.
+//
+// Unlike HloRematerialization, this trades host-device bandwidth rather than
+// compute for memory.  The pass should run after scheduling, as late as
+// HloRematerialization; the backend must support copies to and from the host
+// memory space.
+class HostMemoryOffloader : public HloModulePass {
+ public:
+  using ShapeSizeFunction = std::function<int64(const Shape&)>;
+
+  struct Options {
+    // Returns the size in bytes of the top-level buffer of a shape.
+    ShapeSizeFunction size_function;
+
+    // Backend-specific memory space of the host memory in the layouts.
+    int64 host_memory_space = 0;
+
+    // The peak device memory use to reduce to by offloading.  No value is
+    // offloaded if the peak memory use is already below it.
+    int64 memory_limit_bytes = 0;
+
+    // Values smaller than this are never offloaded.
+    int64 min_offload_bytes = 0;
+
+    // The number of instructions scheduled between the start and the end of
+    // each copy, which the copy overlaps with.
+    int64 copy_overlap_instructions = 2;
+  };
+
+  explicit HostMemoryOffloader(const Options& options) : options_(options) {}
+  ~HostMemoryOffloader() override = default;
+
+  absl::string_view name() const override { return "host-memory-offloader"; }
+
+  // Requires that the module has a schedule.  Returns whether any value was
+  // offloaded.
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  Options options_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_HOST_MEMORY_OFFLOADER_H_
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/host_memory_offloader.h"
+
+#include <algorithm>
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+constexpr int64 kHostMemorySpace = 5;
+
+class HostMemoryOffloaderTest : public HloTestBase {
+ protected:
+  StatusOr<bool> RunOffloader(int64 memory_limit_bytes, HloModule* module) {
+    HostMemoryOffloader::Options options;
+    options.size_function = [](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, /*pointer_size=*/8);
+    };
+    options.host_memory_space = kHostMemorySpace;
+    options.memory_limit_bytes = memory_limit_bytes;
+    options.copy_overlap_instructions = 1;
+    return HostMemoryOffloader(options).Run(module);
+  }
+};
+
+// `negate` is only used by the last instruction of the entry computation, so it
+// can be offloaded while the chain of exponentials runs.
+constexpr char kLongLivedValue[] = R"(
+HloModule LongLivedValue, is_scheduled=true
+
+ENTRY entry {
+  p0 = f32[1024]{0} parameter(0)
+  negate = f32[1024]{0} negate(p0)
+  exp0 = f32[1024]{0} exponential(p0)
+  exp1 = f32[1024]{0} exponential(exp0)
+  exp2 = f32[1024]{0} exponential(exp1)
+  exp3 = f32[1024]{0} exponential(exp2)
+  exp4 = f32[1024]{0} exponential(exp3)
+  exp5 = f32[1024]{0} exponential(exp4)
+  ROOT add = f32[1024]{0} add(negate, exp5)
+}
+)";
+
+TEST_F(HostMemoryOffloaderTest, OffloadsLongLivedValue) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kLongLivedValue));
+  // p0, negate and two exponentials are live at once.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunOffloader(/*memory_limit_bytes=*/14 * 1024,
+                                       module.get()));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  ASSERT_THAT(root, op::Add(op::CopyDone(op::CopyStart(
+                                op::CopyDone(op::CopyStart(op::Negate())))),
+                            op::Exp()));
+  const HloInstruction* offload_done = root->operand(0)->operand(0)->operand(0);
+  EXPECT_EQ(offload_done->shape().layout().memory_space(), kHostMemorySpace);
+  EXPECT_EQ(root->operand(0)->shape().layout().memory_space(),
+            Layout::kDefaultMemorySpace);
+  TF_EXPECT_OK(module->schedule().Verify());
+
+  // The copies overlap with the exponentials.
+  const auto& sequence =
+      module->schedule().sequence(module->entry_computation()).instructions();
+  auto index_of = [&](const HloInstruction* instruction) {
+    return std::find(sequence.begin(), sequence.end(), instruction) -
+           sequence.begin();
+  };
+  const HloInstruction* offload_start = offload_done->operand(0);
+  const HloInstruction* prefetch_start = root->operand(0)->operand(0);
+  EXPECT_EQ(index_of(offload_done) - index_of(offload_start), 2);
+  EXPECT_EQ(index_of(root->operand(0)) - index_of(prefetch_start), 2);
+}
+
+TEST_F(HostMemoryOffloaderTest, NoOffloadingBelowMemoryLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kLongLivedValue));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunOffloader(/*memory_limit_bytes=*/16 * 1024,
+                                       module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(HostMemoryOffloaderTest, DoesNotOffloadModuleOutputs) {
+  const char* const hlo_string = R"(
+HloModule ModuleOutput, is_scheduled=true
+
+ENTRY entry {
+  p0 = f32[1024]{0} parameter(0)
+  negate = f32[1024]{0} negate(p0)
+  exp0 = f32[1024]{0} exponential(p0)
+  exp1 = f32[1024]{0} exponential(exp0)
+  exp2 = f32[1024]{0} exponential(exp1)
+  exp3 = f32[1024]{0} exponential(exp2)
+  exp4 = f32[1024]{0} exponential(exp3)
+  exp5 = f32[1024]{0} exponential(exp4)
+  add = f32[1024]{0} add(negate, exp5)
+  ROOT tuple = (f32[1024]{0}, f32[1024]{0}) tuple(add, negate)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunOffloader(/*memory_limit_bytes=*/0, module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace xla
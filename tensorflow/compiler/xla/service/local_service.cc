@@ -193,11 +193,17 @@ LocalService::CompileExecutables(
     TF_ASSIGN_OR_RETURN(
         std::unique_ptr<Executable> executable,
         BuildExecutable(proto, std::move(module_config), execute_backend_.get(),
-                        executor, build_options.device_allocator()));
+                        executor, build_options.device_allocator(),
+                        build_options.run_backend_only()));
     std::vector<std::unique_ptr<Executable>> executables;
     executables.push_back(std::move(executable));
     return executables;
   } else {
+    if (build_options.run_backend_only()) {
+      return Unimplemented(
+          "Running only the backend is not supported for computations with "
+          "several partitions.");
+    }
     std::vector<std::unique_ptr<HloModuleConfig>> module_configs;
     module_configs.push_back(std::move(module_config));
     // BuildExecutables uses the executors length to determine the number of
@@ -808,7 +808,8 @@ Status Service::GetDeviceHandles(const GetDeviceHandlesRequest* arg,
 StatusOr<std::unique_ptr<Executable>> Service::BuildExecutable(
     const HloModuleProto& module_proto,
     std::unique_ptr<HloModuleConfig> module_config, Backend* backend,
-    se::StreamExecutor* executor, se::DeviceMemoryAllocator* device_allocator) {
+    se::StreamExecutor* executor, se::DeviceMemoryAllocator* device_allocator,
+    bool run_backend_only) {
   VLOG(1) << StrFormat(
       "BuildExecutable on service %p with serialized module proto: %s", this,
       module_proto.name());
@@ -817,9 +818,11 @@ StatusOr<std::unique_ptr<Executable>> Service::BuildExecutable(
                       CreateModuleFromProto(module_proto, *module_config));
   DumpHloModuleIfEnabled(*module, kBeforeOptimizationsDumpName);
 
-  TF_ASSIGN_OR_RETURN(
-      module, backend->compiler()->RunHloPasses(std::move(module), executor,
-                                                device_allocator));
+  if (!run_backend_only) {
+    TF_ASSIGN_OR_RETURN(
+        module, backend->compiler()->RunHloPasses(std::move(module), executor,
+                                                  device_allocator));
+  }
 
   TF_ASSIGN_OR_RETURN(std::unique_ptr<Executable> executable,
                       backend->compiler()->RunBackend(
@@ -0,0 +1,377 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/array.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace spmd {
+
+namespace {
+
+// A way of partitioning an instruction: the shardings its operands must have
+// and the sharding of its result.
+struct Strategy {
+  std::vector<HloSharding> operand_shardings;
+  HloSharding output_sharding = HloSharding::Replicate();
+  // Whether each partition computes a part of the instruction.
+  bool partitioned = true;
+  // Whether the partitions compute partial sums of the result, which must be
+  // all-reduced.
+  bool all_reduce = false;
+};
+
+// Returns the sharding tiling dimension `dim` of `shape` across the partitions.
+HloSharding TileOnDimension(const Shape& shape, int64 dim,
+                            int64 num_partitions) {
+  std::vector<int64> dimensions(shape.rank(), 1);
+  dimensions[dim] = num_partitions;
+  Array<int64> tile_assignment(dimensions);
+  tile_assignment.FillIota(0);
+  return HloSharding::Tile(tile_assignment);
+}
+
+Strategy ReplicatedStrategy(const HloInstruction* instruction) {
+  Strategy strategy;
+  strategy.operand_shardings.assign(instruction->operand_count(),
+                                    HloSharding::Replicate());
+  strategy.partitioned = false;
+  return strategy;
+}
+
+std::vector<Strategy> DotStrategies(const HloInstruction* dot,
+                                    int64 num_partitions) {
+  const DotDimensionNumbers& dnums = dot->dot_dimension_numbers();
+  const Shape& lhs_shape = dot->operand(0)->shape();
+  const Shape& rhs_shape = dot->operand(1)->shape();
+  const Shape& shape = dot->shape();
+  auto divisible = [&](const Shape& operand_shape, int64 dim) {
+    return operand_shape.dimensions(dim) % num_partitions == 0;
+  };
+  auto tile = [&](const Shape& operand_shape, int64 dim) {
+    return TileOnDimension(operand_shape, dim, num_partitions);
+  };
+
+  // The dimensions of the result are the batch dimensions, followed by the
+  // non-contracting dimensions of the lhs and then of the rhs.
+  std::vector<Strategy> strategies;
+  int64 output_dim = 0;
+  for (int64 i = 0; i < dnums.lhs_batch_dimensions_size(); ++i) {
+    const int64 lhs_dim = dnums.lhs_batch_dimensions(i);
+    const int64 rhs_dim = dnums.rhs_batch_dimensions(i);
+    if (divisible(lhs_shape, lhs_dim)) {
+      Strategy strategy;
+      strategy.operand_shardings = {tile(lhs_shape, lhs_dim),
+                                    tile(rhs_shape, rhs_dim)};
+      strategy.output_sharding = tile(shape, output_dim);
+      strategies.push_back(strategy);
+    }
+    ++output_dim;
+  }
+  for (int64 lhs_dim = 0; lhs_dim < lhs_shape.rank(); ++lhs_dim) {
+    if (absl::c_linear_search(dnums.lhs_batch_dimensions(), lhs_dim) ||
+        absl::c_linear_search(dnums.lhs_contracting_dimensions(), lhs_dim)) {
+      continue;
+    }
+    if (divisible(lhs_shape, lhs_dim)) {
+      Strategy strategy;
+      strategy.operand_shardings = {tile(lhs_shape, lhs_dim),
+                                    HloSharding::Replicate()};
+      strategy.output_sharding = tile(shape, output_dim);
+      strategies.push_back(strategy);
+    }
+    ++output_dim;
+  }
+  for (int64 rhs_dim = 0; rhs_dim < rhs_shape.rank(); ++rhs_dim) {
+    if (absl::c_linear_search(dnums.rhs_batch_dimensions(), rhs_dim) ||
+        absl::c_linear_search(dnums.rhs_contracting_dimensions(), rhs_dim)) {
+      continue;
+    }
+    if (divisible(rhs_shape, rhs_dim)) {
+      Strategy strategy;
+      strategy.operand_shardings = {HloSharding::Replicate(),
+                                    tile(rhs_shape, rhs_dim)};
+      strategy.output_sharding = tile(shape, output_dim);
+      strategies.push_back(strategy);
+    }
+    ++output_dim;
+  }
+  for (int64 i = 0; i < dnums.lhs_contracting_dimensions_size(); ++i) {
+    const int64 lhs_dim = dnums.lhs_contracting_dimensions(i);
+    const int64 rhs_dim = dnums.rhs_contracting_dimensions(i);
+    if (divisible(lhs_shape, lhs_dim)) {
+      Strategy strategy;
+      strategy.operand_shardings = {tile(lhs_shape, lhs_dim),
+                                    tile(rhs_shape, rhs_dim)};
+      strategy.all_reduce = true;
+      strategies.push_back(strategy);
+    }
+  }
+  return strategies;
+}
+
+std::vector<Strategy> ConvolutionStrategies(const HloInstruction* conv,
+                                            int64 num_partitions) {
+  std::vector<Strategy> strategies;
+  if (conv->feature_group_count() != 1 || conv->batch_group_count() != 1) {
+    return strategies;
+  }
+  const ConvolutionDimensionNumbers& dnums =
+      conv->convolution_dimension_numbers();
+  const Shape& lhs_shape = conv->operand(0)->shape();
+  const Shape& rhs_shape = conv->operand(1)->shape();
+  if (lhs_shape.dimensions(dnums.input_batch_dimension()) % num_partitions ==
+      0) {
+    Strategy strategy;
+    strategy.operand_shardings = {
+        TileOnDimension(lhs_shape, dnums.input_batch_dimension(),
+                        num_partitions),
+        HloSharding::Replicate()};
+    strategy.output_sharding = TileOnDimension(
+        conv->shape(), dnums.output_batch_dimension(), num_partitions);
+    strategies.push_back(strategy);
+  }
+  if (rhs_shape.dimensions(dnums.kernel_output_feature_dimension()) %
+          num_partitions ==
+      0) {
+    Strategy strategy;
+    strategy.operand_shardings = {
+        HloSharding::Replicate(),
+        TileOnDimension(rhs_shape, dnums.kernel_output_feature_dimension(),
+                        num_partitions)};
+    strategy.output_sharding = TileOnDimension(
+        conv->shape(), dnums.output_feature_dimension(), num_partitions);
+    strategies.push_back(strategy);
+  }
+  return strategies;
+}
+
+std::vector<Strategy> GatherStrategies(const HloInstruction* gather,
+                                       int64 num_partitions) {
+  const GatherDimensionNumbers& dnums = gather->gather_dimension_numbers();
+  const Shape& indices_shape = gather->operand(1)->shape();
+  std::vector<Strategy> strategies;
+  // The batch dimensions of the result are those which are not offset
+  // dimensions, and correspond in order to the dimensions of the indices other
+  // than the index vector dimension.
+  int64 indices_dim = 0;
+  for (int64 output_dim = 0; output_dim < gather->shape().rank();
+       ++output_dim) {
+    if (absl::c_linear_search(dnums.offset_dims(), output_dim)) {
+      continue;
+    }
+    if (indices_dim == dnums.index_vector_dim()) {
+      ++indices_dim;
+    }
+    if (indices_shape.dimensions(indices_dim) % num_partitions == 0) {
+      Strategy strategy;
+      strategy.operand_shardings = {
+          HloSharding::Replicate(),
+          TileOnDimension(indices_shape, indices_dim, num_partitions)};
+      strategy.output_sharding =
+          TileOnDimension(gather->shape(), output_dim, num_partitions);
+      strategies.push_back(strategy);
+    }
+    ++indices_dim;
+  }
+  return strategies;
+}
+
+class ShardingPlanner {
+ public:
+  ShardingPlanner(const AutoShardingOptions& options,
+                  const HloCostAnalysis& cost_analysis)
+      : options_(options), cost_analysis_(cost_analysis) {}
+
+  // Picks the shardings of the instructions of `computation`, and returns
+  // whether any instruction was annotated.
+  bool Run(HloComputation* computation) {
+    bool changed = false;
+    for (HloInstruction* instruction :
+         computation->MakeInstructionPostOrder()) {
+      if (instruction->has_sharding()) {
+        continue;
+      }
+      std::vector<Strategy> strategies;
+      switch (instruction->opcode()) {
+        case HloOpcode::kDot:
+          strategies = DotStrategies(instruction, options_.num_partitions);
+          break;
+        case HloOpcode::kConvolution:
+          strategies =
+              ConvolutionStrategies(instruction, options_.num_partitions);
+          break;
+        case HloOpcode::kGather:
+          strategies = GatherStrategies(instruction, options_.num_partitions);
+          break;
+        default:
+          PassThroughSharding(instruction);
+          continue;
+      }
+      strategies.push_back(ReplicatedStrategy(instruction));
+      changed |= Annotate(instruction, strategies);
+    }
+    return changed;
+  }
+
+ private:
+  // Returns the sharding `instruction` is known to have so far, if any.
+  absl::optional<HloSharding> CurrentSharding(
+      const HloInstruction* instruction) const {
+    if (instruction->has_sharding()) {
+      return instruction->sharding();
+    }
+    auto it = planned_.find(instruction);
+    if (it == planned_.end()) {
+      return absl::nullopt;
+    }
+    return it->second;
+  }
+
+  // Records the sharding of an elementwise instruction as the one its
+  // operands of the same shape agree on, as ShardingPropagation would.
+  void PassThroughSharding(const HloInstruction* instruction) {
+    if (!instruction->IsElementwise() || !instruction->shape().IsArray()) {
+      return;
+    }
+    absl::optional<HloSharding> sharding;
+    for (const HloInstruction* operand : instruction->operands()) {
+      if (!ShapeUtil::SameDimensions(operand->shape(), instruction->shape())) {
+        continue;
+      }
+      absl::optional<HloSharding> operand_sharding = CurrentSharding(operand);
+      if (!operand_sharding.has_value()) {
+        continue;
+      }
+      if (sharding.has_value() && *sharding != *operand_sharding) {
+        return;
+      }
+      sharding = operand_sharding;
+    }
+    if (sharding.has_value()) {
+      planned_.emplace(instruction, *sharding);
+    }
+  }
+
+  // Returns the time to change the sharding of a value of `bytes` bytes.
+  double ReshardTime(const HloSharding& from, const HloSharding& to,
+                     int64 bytes) const {
+    const double n = options_.num_partitions;
+    const double all_gather_bytes = (n - 1) / n * bytes;
+    if (from == to || from.IsReplicated()) {
+      // Each partition slices its shard locally.
+      return 0;
+    }
+    if (to.IsReplicated() || !from.IsTiled()) {
+      return all_gather_bytes / options_.interconnect_bytes_per_second;
+    }
+    // An all-to-all exchanges all but one part of each shard.
+    return all_gather_bytes / n / options_.interconnect_bytes_per_second;
+  }
+
+  double Cost(const HloInstruction* instruction,
+              const Strategy& strategy) const {
+    double compute_time = std::max(
+        cost_analysis_.flop_count(*instruction) / options_.flops_per_second,
+        cost_analysis_.bytes_accessed(*instruction) /
+            options_.memory_bytes_per_second);
+    if (strategy.partitioned) {
+      compute_time /= options_.num_partitions;
+    }
+    double communication_time = 0;
+    for (int64 i = 0; i < instruction->operand_count(); ++i) {
+      const HloInstruction* operand = instruction->operand(i);
+      absl::optional<HloSharding> sharding = CurrentSharding(operand);
+      if (sharding.has_value()) {
+        communication_time +=
+            ReshardTime(*sharding, strategy.operand_shardings[i],
+                        options_.shape_size(operand->shape()));
+      }
+    }
+    if (strategy.all_reduce) {
+      const double n = options_.num_partitions;
+      communication_time += 2 * (n - 1) / n *
+                            options_.shape_size(instruction->shape()) /
+                            options_.interconnect_bytes_per_second;
+    }
+    return compute_time + communication_time;
+  }
+
+  // Annotates `instruction` with the cheapest strategy, the first one on ties.
+  bool Annotate(HloInstruction* instruction,
+                absl::Span<const Strategy> strategies) {
+    const Strategy* best = nullptr;
+    double best_cost = 0;
+    for (const Strategy& strategy : strategies) {
+      const double cost = Cost(instruction, strategy);
+      if (best == nullptr || cost < best_cost) {
+        best = &strategy;
+        best_cost = cost;
+      }
+    }
+    VLOG(2) << "Sharding " << instruction->name() << " as "
+            << best->output_sharding.ToString() << ", cost " << best_cost;
+    instruction->set_sharding(best->output_sharding);
+    // Operands used only here and without a sharding take the one the
+    // strategy needs, e.g. the weights of a layer.
+    for (int64 i = 0; i < instruction->operand_count(); ++i) {
+      HloInstruction* operand = instruction->mutable_operand(i);
+      if (best->operand_shardings[i].IsTiled() &&
+          !CurrentSharding(operand).has_value() &&
+          operand->user_count() == 1) {
+        operand->set_sharding(best->operand_shardings[i]);
+      }
+    }
+    return true;
+  }
+
+  const AutoShardingOptions& options_;
+  const HloCostAnalysis& cost_analysis_;
+  // Shardings ShardingPropagation is expected to give to instructions without
+  // one.
+  absl::flat_hash_map<const HloInstruction*, HloSharding> planned_;
+};
+
+}  // namespace
+
+StatusOr<bool> AutoSharding::Run(HloModule* module) {
+  if (options_.num_partitions <= 1) {
+    return false;
+  }
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    HloCostAnalysis cost_analysis(options_.shape_size);
+    TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+    ShardingPlanner planner(options_, cost_analysis);
+    changed |= planner.Run(computation);
+  }
+  return changed;
+}
+
+}  // namespace spmd
+}  // namespace xla
@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace spmd {
+
+struct AutoShardingOptions {
+  // Number of partitions of the one-dimensional device mesh.
+  int64 num_partitions = 1;
+
+  // Returns the size in bytes of a shape, for the cost analysis and the
+  // communication cost model.
+  HloCostAnalysis::ShapeSizeFunction shape_size;
+
+  // Compute throughput and memory bandwidth of a partition, and bandwidth of
+  // the interconnect of a partition for collectives.
+  double flops_per_second = 1e12;
+  double memory_bytes_per_second = 1e11;
+  double interconnect_bytes_per_second = 1e10;
+};
+
+// Picks the shardings of the dot, convolution and gather instructions without
+// one, so that ShardingPropagation and SpmdPartitioner can partition a module
+// without hand-written annotations.
+//
+// The instructions are visited in post order.  For each one, the pass costs
+// the strategies of partitioning one of its dimensions, or none, as the time
+// to compute its partition (from HloCostAnalysis) plus the time of the
+// collectives it needs: resharding its operands from the shardings of their
+// producers, and all-reducing partial results when a contracting dimension is
+// partitioned.  It keeps the cheapest strategy, and also annotates the
+// operands without a sharding when the strategy needs them partitioned.
+// Shardings are passed through elementwise instructions when costing their
+// users, which picks e.g. the sharding of Megatron-style transformer layers
+// when the batch is too small to partition.
+class AutoSharding : public HloModulePass {
+ public:
+  explicit AutoSharding(const AutoShardingOptions& options)
+      : options_(options) {}
+  ~AutoSharding() override = default;
+  absl::string_view name() const override { return "auto-sharding"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  AutoShardingOptions options_;
+};
+
+}  // namespace spmd
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
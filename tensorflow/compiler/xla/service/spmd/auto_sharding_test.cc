@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace spmd {
+namespace {
+
+using ::testing::AllOf;
+namespace op = xla::testing::opcode_matchers;
+
+class AutoShardingTest : public HloTestBase {
+ public:
+  StatusOr<bool> RunAutoSharding(HloModule* module, int64 num_partitions) {
+    AutoShardingOptions options;
+    options.num_partitions = num_partitions;
+    options.shape_size = [](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, /*pointer_size=*/8);
+    };
+    return AutoSharding(options).Run(module);
+  }
+};
+
+TEST_F(AutoShardingTest, PartitionsLargeBatch) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[64,128] parameter(0)
+  w = f32[128,256] parameter(1)
+  ROOT dot = f32[64,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), 4));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              AllOf(op::Dot(op::Parameter(0), op::Parameter(1)),
+                    op::Sharding("{devices=[4,1]0,1,2,3}")));
+  EXPECT_THAT(module->entry_computation()->parameter_instruction(0),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_THAT(module->entry_computation()->parameter_instruction(1),
+              op::NoSharding());
+}
+
+TEST_F(AutoShardingTest, PartitionsSmallBatchMlpLikeMegatron) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[2,512] parameter(0)
+  w1 = f32[512,2048] parameter(1)
+  w2 = f32[2048,512] parameter(2)
+  dot1 = f32[2,2048] dot(x, w1), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  zero = f32[] constant(0)
+  zeros = f32[2,2048] broadcast(zero), dimensions={}
+  relu = f32[2,2048] maximum(dot1, zeros)
+  ROOT dot2 = f32[2,512] dot(relu, w2), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), 4));
+  EXPECT_TRUE(changed);
+  const HloComputation* entry = module->entry_computation();
+  // The first layer is partitioned on its output features, and the second one
+  // on its input features, so that only its result is all-reduced.
+  EXPECT_THAT(entry->GetInstructionWithName("dot1"),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+  EXPECT_THAT(entry->parameter_instruction(1),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+  EXPECT_THAT(entry->root_instruction(), op::Sharding("{replicated}"));
+  EXPECT_THAT(entry->parameter_instruction(2),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+}
+
+TEST_F(AutoShardingTest, KeepsExistingShardings) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[64,128] parameter(0)
+  w = f32[128,256] parameter(1), sharding={devices=[1,4]0,1,2,3}
+  ROOT dot = f32[64,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), 4));
+  EXPECT_TRUE(changed);
+  // Partitioning the batch would all-gather the weights.
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+  EXPECT_THAT(module->entry_computation()->parameter_instruction(1),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+}
+
+TEST_F(AutoShardingTest, NoChangeWithOnePartition) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[64,128] parameter(0)
+  w = f32[128,256] parameter(1)
+  ROOT dot = f32[64,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), 1));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace spmd
+}  // namespace xla
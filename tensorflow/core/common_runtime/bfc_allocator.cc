@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <algorithm>
 #include <atomic>
 
 #include "absl/strings/string_view.h"
@@ -37,6 +38,25 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr int BFCAllocator::kNumCacheableChunkShards;
+
+namespace {
+
+// Source of BFCAllocator::cache_owner_id_.
+std::atomic<int64> next_cache_owner_id{0};
+
+}  // namespace
+
+// Free chunks cached by one thread, bucketed by chunk size in units of
+// kMinAllocationSize. `mu` is only contended when another thread flushes the
+// caches.
+struct BFCAllocator::ThreadLocalCache {
+  explicit ThreadLocalCache(size_t num_buckets) : free_chunks(num_buckets) {}
+
+  mutex mu;
+  std::vector<std::vector<void*>> free_chunks TF_GUARDED_BY(mu);
+  size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+};
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
@@ -45,7 +65,8 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       sub_allocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      cache_owner_id_(next_cache_owner_id.fetch_add(1)) {
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -79,6 +100,16 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
 }
 
 BFCAllocator::~BFCAllocator() {
+  // Drop any cached chunks; their memory is returned with the regions below.
+  {
+    mutex_lock l(thread_caches_mu_);
+    for (const auto& cache : thread_caches_) {
+      mutex_lock cache_lock(cache->mu);
+      for (auto& bucket : cache->free_chunks) bucket.clear();
+      cache->cached_bytes = 0;
+    }
+  }
+
   // Return memory back.
   VLOG(2) << "Number of regions allocated: "
           << region_manager_.regions().size();
@@ -238,8 +269,13 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     if (allocation_attr.freed_by_func != nullptr) {
       freed_by_count = (*allocation_attr.freed_by_func)();
     }
-    void* result = AllocateRawInternal(unused_alignment, num_bytes,
-                                       dump_log_on_failure, freed_by_count);
+    void* result = nullptr;
+    if (thread_local_cache_enabled() && freed_by_count == 0) {
+      result = AllocateFromThreadLocalCache(RoundedBytes(num_bytes), num_bytes);
+      if (result != nullptr) return result;
+    }
+    result = AllocateRawInternal(unused_alignment, num_bytes,
+                                 dump_log_on_failure, freed_by_count);
     if (result == nullptr) {
       static std::atomic<int32> log_counter{0};
       int32 counter_value = log_counter.load(std::memory_order_relaxed);
@@ -257,6 +293,11 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     }
     return result;
   } else {
+    if (thread_local_cache_enabled()) {
+      void* result =
+          AllocateFromThreadLocalCache(RoundedBytes(num_bytes), num_bytes);
+      if (result != nullptr) return result;
+    }
     return AllocateRawInternalWithRetry(unused_alignment, num_bytes,
                                         allocation_attr);
   }
@@ -280,25 +321,8 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
 
   // Searching for free regions.
   absl::flat_hash_set<void*> free_region_ptrs;
-  size_t total_free_bytes = 0;
-  for (const AllocationRegion& region : region_manager_.regions()) {
-    ChunkHandle h = region_manager_.get_handle(region.ptr());
-    bool any_use = false;
-    while (h != kInvalidChunkHandle) {
-      const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
-        any_use = true;
-        break;
-      }
-      h = c->next;
-    }
-
-    if (!any_use) {
-      VLOG(2) << "Found free region with ptr = " << region.ptr();
-      free_region_ptrs.insert(region.ptr());
-      total_free_bytes += region.memory_size();
-    }
-  }
+  size_t total_free_bytes =
+      FindFreeRegions(/*require_safe=*/false, &free_region_ptrs);
 
   if (total_free_bytes == 0) {
     return false;
@@ -327,6 +351,54 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
   return true;
 }
 
+size_t BFCAllocator::FindFreeRegions(bool require_safe,
+                                     absl::flat_hash_set<void*>* region_ptrs) {
+  size_t total_free_bytes = 0;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    bool any_use = false;
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (c->in_use() || (require_safe && c->freed_at_count > 0)) {
+        any_use = true;
+        break;
+      }
+      h = c->next;
+    }
+
+    if (!any_use) {
+      VLOG(2) << "Found free region with ptr = " << region.ptr();
+      region_ptrs->insert(region.ptr());
+      total_free_bytes += region.memory_size();
+    }
+  }
+  return total_free_bytes;
+}
+
+size_t BFCAllocator::ReleaseFreeRegions() {
+  FlushThreadLocalCaches();
+  mutex_lock l(lock_);
+  if (!timestamped_chunks_.empty()) {
+    MergeTimestampedChunks(0);
+  }
+  absl::flat_hash_set<void*> free_region_ptrs;
+  const size_t total_free_bytes =
+      FindFreeRegions(/*require_safe=*/true, &free_region_ptrs);
+  if (total_free_bytes > 0) {
+    DeallocateRegions(free_region_ptrs);
+  }
+  VLOG(1) << "Released " << free_region_ptrs.size() << " free regions of "
+          << strings::HumanReadableNumBytes(total_free_bytes) << " from "
+          << Name() << "; " << total_region_allocated_bytes_
+          << " bytes remain allocated from the SubAllocator";
+  return total_free_bytes;
+}
+
+double BFCAllocator::GetFragmentationMetric() {
+  mutex_lock l(lock_);
+  return GetFragmentation();
+}
+
 void BFCAllocator::DeallocateRegions(
     const absl::flat_hash_set<void*>& region_ptrs)
     TF_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
@@ -412,6 +484,19 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Chunks held in thread-local caches are free memory the bins cannot see.
+  // Return them to the bins and try again before growing any further.
+  if (thread_local_cache_enabled()) {
+    under_memory_pressure_.store(true, std::memory_order_relaxed);
+    if (FlushThreadLocalCachesLocked() > 0) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+      if (ptr != nullptr) {
+        AddTraceMe("MemoryAllocation", ptr);
+        return ptr;
+      }
+    }
+  }
+
   // Reaching this point means that no chunks can satisfy the request. Also,
   // the unallocated bytes cannot satisfy the request. Before giving up, let's
   // try deallocating free regions so that suballocator can combine them with
@@ -454,7 +539,9 @@ int64 BFCAllocator::LargestFreeChunk() {
 
 double BFCAllocator::GetFragmentation() {
   int64 bytes_available = total_region_allocated_bytes_ - stats_.bytes_in_use;
-  DCHECK_GT(bytes_available, 0);
+  // There is nothing to fragment once every region is fully in use, or has
+  // been released.
+  if (bytes_available <= 0) return 0.0;
   return static_cast<double>(bytes_available - LargestFreeChunk()) /
          bytes_available;
 }
@@ -543,6 +630,15 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
 
+        if (thread_local_cache_enabled()) {
+          under_memory_pressure_.store(false, std::memory_order_relaxed);
+          UpdateLiveBytes(chunk->size);
+          MaybeRegisterCacheableChunk(*chunk);
+        }
+        if (record_allocation_sites_) {
+          RecordAllocationSite(chunk);
+        }
+
 #ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
           const auto& annotation =
@@ -617,6 +713,12 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  // A chunk taken by a thread-local cache is not available to other
+  // allocations, so there is no point in waking up AllocatorRetry waiters.
+  if (thread_local_cache_enabled() && ptr != nullptr &&
+      DeallocateToThreadLocalCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -627,7 +729,10 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     return;
   }
   mutex_lock l(lock_);
+  DeallocateRawLocked(ptr);
+}
 
+void BFCAllocator::DeallocateRawLocked(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
@@ -638,6 +743,14 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   int64 alloc_bytes = chunk->size;
 
   MarkFree(h);
+  if (thread_local_cache_enabled()) {
+    UpdateLiveBytes(-alloc_bytes);
+    if (alloc_bytes <= max_cached_chunk_bytes_) {
+      CacheableChunkShard* shard = ShardForPointer(chunk_ptr);
+      mutex_lock shard_lock(shard->mu);
+      shard->chunks.erase(chunk_ptr);
+    }
+  }
 
   // Consider coalescing it.
   if (timing_counter_) {
@@ -737,6 +850,10 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
     c->freed_at_count = timing_counter_->next();
   }
 
+  if (c->allocation_site != nullptr) {
+    ReleaseAllocationSite(c);
+  }
+
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
 
@@ -870,6 +987,8 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  CacheableChunk cacheable;
+  if (LookupCacheableChunk(ptr, &cacheable)) return cacheable.requested_size;
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -879,6 +998,8 @@ size_t BFCAllocator::RequestedSize(const void* ptr) const {
 }
 
 size_t BFCAllocator::AllocatedSize(const void* ptr) const {
+  CacheableChunk cacheable;
+  if (LookupCacheableChunk(ptr, &cacheable)) return cacheable.size;
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -888,6 +1009,8 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) const {
+  CacheableChunk cacheable;
+  if (LookupCacheableChunk(ptr, &cacheable)) return cacheable.allocation_id;
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -1115,6 +1238,12 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
       mc->set_step_id(c->step_id);
       mc->set_action_count(c->action_count);
 #endif
+      if (c->allocation_site != nullptr) {
+        const AllocationSiteStats& site = *c->allocation_site;
+        mc->set_op_name(site.op_name ? site.op_name : "UNKNOWN");
+        if (site.region_type) mc->set_region_type(site.region_type);
+        if (site.function_name) mc->set_function_name(site.function_name);
+      }
       if (timing_counter_) {
         mc->set_freed_at_count(c->in_use() ? 0 : c->freed_at_count);
       }
@@ -1136,12 +1265,29 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   }
 #endif
 
+  for (const AllocationSiteStats& site : SortedPeakAllocationSites()) {
+    AllocationSite* as = md.add_peak_allocation_site();
+    as->set_op_name(site.op_name ? site.op_name : "UNKNOWN");
+    if (site.region_type) as->set_region_type(site.region_type);
+    if (site.function_name) as->set_function_name(site.function_name);
+    as->set_bytes_in_use(site.bytes_in_use);
+    as->set_num_chunks(site.num_chunks);
+  }
+
   return md;
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  if (thread_local_cache_enabled()) {
+    // `stats_` counts cached chunks as in use and does not see allocations
+    // served by the caches.
+    stats.num_allocs += thread_cache_num_allocs_.load();
+    stats.bytes_in_use -= thread_cached_bytes_.load();
+    stats.peak_bytes_in_use = peak_live_bytes_.load();
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
@@ -1149,6 +1295,277 @@ void BFCAllocator::ClearStats() {
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
+  thread_cache_num_allocs_.store(0);
+  peak_live_bytes_.store(live_bytes_.load());
+  peak_allocation_sites_.clear();
+  peak_allocation_sites_bytes_ = 0;
+}
+
+void BFCAllocator::EnableAllocationSiteRecording() {
+  CHECK(!thread_local_cache_enabled())
+      << "Allocation sites are not supported with thread-local caches";
+  mutex_lock l(lock_);
+  CHECK_EQ(stats_.num_allocs, 0)
+      << "EnableAllocationSiteRecording() must be called before the first "
+         "allocation";
+  record_allocation_sites_ = true;
+}
+
+string BFCAllocator::RenderPeakAllocationSites(int top_n) {
+  mutex_lock l(lock_);
+  if (peak_allocation_sites_.empty()) return "";
+  std::vector<AllocationSiteStats> sites = SortedPeakAllocationSites();
+  sites.resize(std::min<size_t>(sites.size(), std::max(top_n, 0)));
+  string report = strings::StrCat(
+      "Peak allocation sites of ", Name(), " at ",
+      strings::HumanReadableNumBytes(peak_allocation_sites_bytes_),
+      " in use:\n");
+  for (const AllocationSiteStats& site : sites) {
+    strings::StrAppend(&report, "  ",
+                       strings::HumanReadableNumBytes(site.bytes_in_use),
+                       " in ", site.num_chunks, " chunks: ",
+                       site.op_name ? site.op_name : "UNKNOWN");
+    if (site.region_type) {
+      strings::StrAppend(&report, " (", site.region_type, ")");
+    }
+    if (site.function_name) {
+      strings::StrAppend(&report, " in function ", site.function_name);
+    }
+    strings::StrAppend(&report, "\n");
+  }
+  return report;
+}
+
+std::vector<BFCAllocator::AllocationSiteStats>
+BFCAllocator::SortedPeakAllocationSites() {
+  std::vector<AllocationSiteStats> sites = peak_allocation_sites_;
+  std::sort(sites.begin(), sites.end(),
+            [](const AllocationSiteStats& a, const AllocationSiteStats& b) {
+              return a.bytes_in_use > b.bytes_in_use;
+            });
+  return sites;
+}
+
+const char* BFCAllocator::InternAllocationSiteName(const char* name) {
+  if (name == nullptr) return nullptr;
+  auto it = allocation_site_names_.find(absl::string_view(name));
+  if (it == allocation_site_names_.end()) {
+    it = allocation_site_names_.insert(name).first;
+  }
+  return it->c_str();
+}
+
+void BFCAllocator::RecordAllocationSite(Chunk* c) {
+  const MemoryDebugAnnotation& annotation =
+      ScopedMemoryDebugAnnotation::CurrentAnnotation();
+  // Interned names are never freed, so they can key the sites.
+  const char* op_name = InternAllocationSiteName(annotation.pending_op_name);
+  const char* region_type =
+      InternAllocationSiteName(annotation.pending_region_type);
+  const char* function_name =
+      InternAllocationSiteName(annotation.pending_function_name);
+  AllocationSiteStats& site =
+      allocation_sites_[std::make_tuple(op_name, region_type, function_name)];
+  site.op_name = op_name;
+  site.region_type = region_type;
+  site.function_name = function_name;
+  site.bytes_in_use += c->size;
+  ++site.num_chunks;
+  c->allocation_site = &site;
+
+  // Snapshotting every new peak would copy the sites on most allocations
+  // while the memory grows, so the peak is only tracked within 1/64.
+  if (stats_.bytes_in_use >
+      peak_allocation_sites_bytes_ + peak_allocation_sites_bytes_ / 64) {
+    peak_allocation_sites_bytes_ = stats_.bytes_in_use;
+    peak_allocation_sites_.clear();
+    for (const auto& entry : allocation_sites_) {
+      if (entry.second.num_chunks > 0) {
+        peak_allocation_sites_.push_back(entry.second);
+      }
+    }
+  }
+}
+
+void BFCAllocator::ReleaseAllocationSite(Chunk* c) {
+  c->allocation_site->bytes_in_use -= c->size;
+  --c->allocation_site->num_chunks;
+  c->allocation_site = nullptr;
+}
+
+void BFCAllocator::EnableThreadLocalCache(size_t max_cached_chunk_bytes,
+                                          size_t max_cached_bytes_per_thread) {
+  CHECK(timing_counter_ == nullptr)
+      << "Thread-local caches are not supported with a timing counter";
+  CHECK(!record_allocation_sites_)
+      << "Thread-local caches are not supported with allocation sites";
+  {
+    mutex_lock l(lock_);
+    CHECK_EQ(stats_.num_allocs, 0)
+        << "EnableThreadLocalCache() must be called before the first "
+           "allocation";
+  }
+  max_cached_chunk_bytes_ = RoundedBytes(max_cached_chunk_bytes);
+  max_cached_bytes_per_thread_ = max_cached_bytes_per_thread;
+  cacheable_chunk_shards_.reset(
+      new CacheableChunkShard[kNumCacheableChunkShards]);
+  VLOG(1) << "Enabled thread-local caches for " << Name()
+          << " with chunks of up to " << max_cached_chunk_bytes_
+          << " bytes and up to " << max_cached_bytes_per_thread_
+          << " bytes per thread";
+}
+
+void BFCAllocator::FlushThreadLocalCaches() {
+  if (!thread_local_cache_enabled()) return;
+  int64 num_flushed;
+  {
+    mutex_lock l(lock_);
+    num_flushed = FlushThreadLocalCachesLocked();
+  }
+  if (num_flushed > 0) retry_helper_.NotifyDealloc();
+}
+
+BFCAllocator::CacheableChunkShard* BFCAllocator::ShardForPointer(
+    const void* ptr) const {
+  const uintptr_t key =
+      reinterpret_cast<uintptr_t>(ptr) >> kMinAllocationBits;
+  return &cacheable_chunk_shards_[key % kNumCacheableChunkShards];
+}
+
+BFCAllocator::ThreadLocalCache* BFCAllocator::GetThreadLocalCache() {
+  // Owner ids are never reused, so stale entries left by destroyed
+  // allocators are harmless. Threads typically use very few allocators, so a
+  // linear scan is cheaper than a hash lookup.
+  static thread_local std::vector<
+      std::pair<int64, std::shared_ptr<ThreadLocalCache>>>
+      caches;
+  for (const auto& entry : caches) {
+    if (entry.first == cache_owner_id_) return entry.second.get();
+  }
+  auto cache = std::make_shared<ThreadLocalCache>(
+      max_cached_chunk_bytes_ / kMinAllocationSize + 1);
+  {
+    mutex_lock l(thread_caches_mu_);
+    thread_caches_.push_back(cache);
+  }
+  caches.emplace_back(cache_owner_id_, cache);
+  return cache.get();
+}
+
+void* BFCAllocator::AllocateFromThreadLocalCache(size_t rounded_bytes,
+                                                 size_t num_bytes) {
+  if (rounded_bytes > max_cached_chunk_bytes_ || num_bytes == 0) {
+    return nullptr;
+  }
+  ThreadLocalCache* cache = GetThreadLocalCache();
+  void* ptr;
+  {
+    mutex_lock l(cache->mu);
+    std::vector<void*>& bucket =
+        cache->free_chunks[rounded_bytes / kMinAllocationSize];
+    if (bucket.empty()) return nullptr;
+    ptr = bucket.back();
+    bucket.pop_back();
+    cache->cached_bytes -= rounded_bytes;
+  }
+  const int64 allocation_id = next_allocation_id_.fetch_add(1);
+  {
+    CacheableChunkShard* shard = ShardForPointer(ptr);
+    mutex_lock l(shard->mu);
+    CacheableChunk& chunk = shard->chunks[ptr];
+    DCHECK_EQ(chunk.size, rounded_bytes);
+    chunk.requested_size = num_bytes;
+    chunk.allocation_id = allocation_id;
+  }
+  thread_cached_bytes_.fetch_sub(rounded_bytes, std::memory_order_relaxed);
+  thread_cache_num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdateLiveBytes(rounded_bytes);
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadLocalCache(void* ptr) {
+  if (under_memory_pressure_.load(std::memory_order_relaxed)) return false;
+  CacheableChunk chunk;
+  if (!LookupCacheableChunk(ptr, &chunk)) return false;
+  ThreadLocalCache* cache = GetThreadLocalCache();
+  {
+    mutex_lock l(cache->mu);
+    if (cache->cached_bytes + chunk.size > max_cached_bytes_per_thread_) {
+      return false;
+    }
+    cache->free_chunks[chunk.size / kMinAllocationSize].push_back(ptr);
+    cache->cached_bytes += chunk.size;
+  }
+  thread_cached_bytes_.fetch_add(chunk.size, std::memory_order_relaxed);
+  UpdateLiveBytes(-static_cast<int64>(chunk.size));
+  return true;
+}
+
+void BFCAllocator::MaybeRegisterCacheableChunk(const Chunk& chunk) {
+  CacheableChunkShard* shard = ShardForPointer(chunk.ptr);
+  mutex_lock l(shard->mu);
+  if (chunk.size > max_cached_chunk_bytes_) {
+    // The address may have belonged to a cacheable chunk before a merge.
+    shard->chunks.erase(chunk.ptr);
+    return;
+  }
+  shard->chunks[chunk.ptr] =
+      CacheableChunk{chunk.size, chunk.requested_size, chunk.allocation_id};
+}
+
+bool BFCAllocator::LookupCacheableChunk(const void* ptr,
+                                        CacheableChunk* chunk) const {
+  if (!thread_local_cache_enabled()) return false;
+  CacheableChunkShard* shard = ShardForPointer(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->chunks.find(ptr);
+  if (it == shard->chunks.end()) return false;
+  *chunk = it->second;
+  return true;
+}
+
+int64 BFCAllocator::FlushThreadLocalCachesLocked() {
+  std::vector<void*> to_free;
+  {
+    mutex_lock l(thread_caches_mu_);
+    for (const auto& cache : thread_caches_) {
+      mutex_lock cache_lock(cache->mu);
+      for (auto& bucket : cache->free_chunks) {
+        to_free.insert(to_free.end(), bucket.begin(), bucket.end());
+        bucket.clear();
+      }
+      cache->cached_bytes = 0;
+    }
+    // Forget the caches of threads that have exited.
+    thread_caches_.erase(
+        std::remove_if(thread_caches_.begin(), thread_caches_.end(),
+                       [](const std::shared_ptr<ThreadLocalCache>& cache) {
+                         return cache.use_count() == 1;
+                       }),
+        thread_caches_.end());
+  }
+  for (void* ptr : to_free) {
+    const ChunkHandle h = region_manager_.get_handle(ptr);
+    const size_t size = ChunkFromHandle(h)->size;
+    thread_cached_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    // The chunk is in use as far as the bins are concerned, but its bytes
+    // have already been subtracted from `live_bytes_`.
+    UpdateLiveBytes(size);
+    DeallocateRawLocked(ptr);
+  }
+  VLOG(2) << "Flushed " << to_free.size() << " chunks from thread-local caches"
+          << " of " << Name();
+  return to_free.size();
+}
+
+void BFCAllocator::UpdateLiveBytes(int64 delta) {
+  const int64 live =
+      live_bytes_.fetch_add(delta, std::memory_order_relaxed) + delta;
+  if (delta <= 0) return;
+  int64 peak = peak_live_bytes_.load(std::memory_order_relaxed);
+  while (live > peak && !peak_live_bytes_.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -20,10 +20,14 @@ limitations under the License.
 #include <deque>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/container/node_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -79,12 +83,66 @@ class BFCAllocator : public Allocator {
 
   void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
 
+  // Enables an opt-in layer of per-thread caches of small free chunks in
+  // front of the bins. A chunk of at most `max_cached_chunk_bytes` bytes that
+  // is freed by a thread is kept in that thread's cache (up to
+  // `max_cached_bytes_per_thread` bytes in total) and is handed out again to
+  // the next allocation of the same rounded size by that thread without
+  // taking `lock_`. The caches are flushed back to the bins whenever an
+  // allocation cannot otherwise be satisfied, so caching never causes an
+  // allocation (with or without AllocatorRetry) to fail. GetStats() does not
+  // count cached chunks as in use.
+  //
+  // REQUIRES: Called before the first allocation. Not compatible with
+  // SetTimingCounter(), since cached chunks bypass the freed-at timestamps.
+  void EnableThreadLocalCache(size_t max_cached_chunk_bytes,
+                              size_t max_cached_bytes_per_thread);
+
+  // Returns all chunks held in thread-local caches to the bins.
+  void FlushThreadLocalCaches();
+
+  // Returns every region that holds no allocated chunk to the SubAllocator
+  // (e.g. the GPU driver), after flushing the thread-local caches and merging
+  // the chunks whose freed-at timestamps have become safe. Regions holding a
+  // chunk that may still be in use by a stream are kept. Returns the number of
+  // bytes released.
+  //
+  // Free chunks are always coalesced with their neighbors, but regions are
+  // otherwise only released when an allocation fails and the allocator was
+  // created with `garbage_collection`. This method lets callers compact the
+  // allocator at a quiescent point, e.g. between steps, so that freed regions
+  // can be re-extended in a single larger region. Releasing a region is
+  // expensive and later allocations may need to extend again, so it should
+  // not be called on every step.
+  size_t ReleaseFreeRegions();
+
+  // Returns the fraction of the free bytes in the allocator's regions that are
+  // not part of the largest free chunk, in [0, 1]. Chunks held in thread-local
+  // caches count as in use. 0 means that all the free memory could serve a
+  // single allocation.
+  double GetFragmentationMetric();
+
   void SetSafeFrontier(uint64 count) override;
 
   bool ShouldRecordOpName() const { return true; }
 
   MemoryDump RecordMemoryMap();
 
+  // Records the allocation site of every chunk: the op, the region type
+  // ("output", "temp", "persist", ...) and the tf.function of the
+  // ScopedMemoryDebugAnnotation of the allocating thread. RecordMemoryMap()
+  // then reports the site of each chunk, and the sites holding memory at the
+  // peak of bytes in use. Costs a few hash lookups per allocation.
+  //
+  // REQUIRES: Called before the first allocation. Not compatible with
+  // EnableThreadLocalCache(), since cached chunks bypass the bookkeeping.
+  void EnableAllocationSiteRecording();
+
+  // Returns a human-readable report of the `top_n` allocation sites holding
+  // the most memory at the peak of bytes in use (within 1/64 of the peak).
+  // Empty unless EnableAllocationSiteRecording() has been called.
+  string RenderPeakAllocationSites(int top_n);
+
  private:
   struct Bin;
 
@@ -98,6 +156,10 @@ class BFCAllocator : public Allocator {
 
   void DeallocateRawInternal(void* ptr);
 
+  // Like DeallocateRawInternal(), for callers that already hold `lock_`.
+  void DeallocateRawLocked(void* ptr) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -152,6 +214,16 @@ class BFCAllocator : public Allocator {
   // in order to service a user allocation.  We always merge adjacent free
   // chunks.
   //
+  // The memory held by the chunks allocated at one site. The names are
+  // interned in `allocation_site_names_`.
+  struct AllocationSiteStats {
+    const char* op_name = nullptr;
+    const char* region_type = nullptr;
+    const char* function_name = nullptr;
+    int64 bytes_in_use = 0;
+    int64 num_chunks = 0;
+  };
+
   // Chunks contain information about whether they are in use or whether they
   // are free, and contain a pointer to the bin they are in.
   struct Chunk {
@@ -188,6 +260,10 @@ class BFCAllocator : public Allocator {
 
     bool in_use() const { return allocation_id != -1; }
 
+    // Where the chunk was allocated, if allocation sites are recorded and the
+    // chunk is in use.
+    AllocationSiteStats* allocation_site = nullptr;
+
 #ifdef TENSORFLOW_MEM_DEBUG
     // optional debugging info
     const char* op_name = nullptr;
@@ -402,6 +478,13 @@ class BFCAllocator : public Allocator {
   // found and freed; false otherwise.
   bool DeallocateFreeRegions(size_t rounded_bytes);
 
+  // Adds to `region_ptrs` the regions that hold no allocated chunk and returns
+  // their total size. If `require_safe`, regions holding a free chunk whose
+  // freed-at timestamp is not yet safe are skipped.
+  size_t FindFreeRegions(bool require_safe,
+                         absl::flat_hash_set<void*>* region_ptrs)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Helper function to deallocate regions.
   void DeallocateRegions(const absl::flat_hash_set<void*>& region_ptrs)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -470,6 +553,54 @@ class BFCAllocator : public Allocator {
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Allocation site support. See EnableAllocationSiteRecording().
+  // Returns the interned copy of `name`, or nullptr if `name` is nullptr.
+  const char* InternAllocationSiteName(const char* name)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Attributes the in-use chunk `c` to the site of the current annotation.
+  void RecordAllocationSite(Chunk* c) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Releases the site of `c`, which is being freed.
+  void ReleaseAllocationSite(Chunk* c) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the sites held at the peak by decreasing bytes in use.
+  std::vector<AllocationSiteStats> SortedPeakAllocationSites()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Thread-local chunk cache support. See EnableThreadLocalCache().
+  struct ThreadLocalCache;
+
+  // What the cache layer knows about a cacheable chunk that has been handed
+  // out by the bins. Kept outside of `chunks_` so that it can be read
+  // without `lock_`.
+  struct CacheableChunk {
+    size_t size;
+    int64 requested_size;
+    int64 allocation_id;
+  };
+  struct CacheableChunkShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, CacheableChunk> chunks TF_GUARDED_BY(mu);
+  };
+  static constexpr int kNumCacheableChunkShards = 16;
+
+  bool thread_local_cache_enabled() const {
+    return max_cached_chunk_bytes_ > 0;
+  }
+  CacheableChunkShard* ShardForPointer(const void* ptr) const;
+  // Returns the calling thread's cache, creating it if necessary.
+  ThreadLocalCache* GetThreadLocalCache();
+  // Returns a cached chunk of exactly `rounded_bytes` bytes, or nullptr.
+  void* AllocateFromThreadLocalCache(size_t rounded_bytes, size_t num_bytes);
+  // Returns true iff `ptr` was taken by the calling thread's cache.
+  bool DeallocateToThreadLocalCache(void* ptr);
+  // Records a chunk that has just been handed out by the bins, if cacheable.
+  void MaybeRegisterCacheableChunk(const Chunk& chunk)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  bool LookupCacheableChunk(const void* ptr, CacheableChunk* chunk) const;
+  // Returns the number of chunks returned to the bins.
+  int64 FlushThreadLocalCachesLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Updates `live_bytes_` and `peak_live_bytes_` by `delta` bytes.
+  void UpdateLiveBytes(int64 delta);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -544,8 +675,9 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ TF_GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ TF_GUARDED_BY(lock_);
+  // newly-created chunk. Atomic because allocations served by the
+  // thread-local caches do not hold `lock_`.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
@@ -555,6 +687,40 @@ class BFCAllocator : public Allocator {
   int64 size_history_[MEM_DEBUG_SIZE_HISTORY_SIZE];
 #endif
 
+  // Allocation site state, only used if `record_allocation_sites_`.
+  bool record_allocation_sites_ = false;
+  absl::node_hash_set<string> allocation_site_names_ TF_GUARDED_BY(lock_);
+  absl::node_hash_map<std::tuple<const char*, const char*, const char*>,
+                      AllocationSiteStats>
+      allocation_sites_ TF_GUARDED_BY(lock_);
+  // The sites holding memory when bytes in use were last at least 1/64 above
+  // `peak_allocation_sites_bytes_`.
+  std::vector<AllocationSiteStats> peak_allocation_sites_ TF_GUARDED_BY(lock_);
+  int64 peak_allocation_sites_bytes_ TF_GUARDED_BY(lock_) = 0;
+
+  // Thread-local chunk cache state. `max_cached_chunk_bytes_` is 0 unless
+  // EnableThreadLocalCache() has been called.
+  size_t max_cached_chunk_bytes_ = 0;
+  size_t max_cached_bytes_per_thread_ = 0;
+  // Identifies this allocator in the per-thread cache lists. Unlike `this`,
+  // never reused by another allocator.
+  const int64 cache_owner_id_;
+  std::unique_ptr<CacheableChunkShard[]> cacheable_chunk_shards_;
+  mutex thread_caches_mu_;
+  std::vector<std::shared_ptr<ThreadLocalCache>> thread_caches_
+      TF_GUARDED_BY(thread_caches_mu_);
+  // Set when an allocation had to flush the caches, cleared by the next
+  // allocation served from the bins. Deallocations bypass the caches while
+  // set, so that memory reaches waiters in AllocatorRetry.
+  std::atomic<bool> under_memory_pressure_{false};
+  // Bytes held in thread-local caches, which `stats_` counts as in use.
+  std::atomic<int64> thread_cached_bytes_{0};
+  // Allocations served by thread-local caches, which `stats_` does not count.
+  std::atomic<int64> thread_cache_num_allocs_{0};
+  // Bytes in use excluding cached chunks, and their peak.
+  std::atomic<int64> live_bytes_{0};
+  std::atomic<int64> peak_live_bytes_{0};
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
@@ -0,0 +1,249 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<BFCAllocator> NewCPUBFCAllocator(size_t total_memory,
+                                                 bool allow_growth) {
+  return absl::make_unique<BFCAllocator>(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), total_memory,
+      allow_growth, "cpu_bfc");
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, ReusesChunkFreedOnSameThread) {
+  auto a = NewCPUBFCAllocator(1 << 20, true);
+  a->EnableThreadLocalCache(4096, 64 << 10);
+
+  void* p1 = a->AllocateRaw(64, 1000);
+  EXPECT_EQ(1000, a->RequestedSize(p1));
+  const int64 id1 = a->AllocationId(p1);
+  a->DeallocateRaw(p1);
+
+  void* p2 = a->AllocateRaw(64, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(900, a->RequestedSize(p2));
+  EXPECT_EQ(1024, a->AllocatedSize(p2));
+  EXPECT_GT(a->AllocationId(p2), id1);
+
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1024, stats->bytes_in_use);
+  EXPECT_EQ(1024, stats->peak_bytes_in_use);
+
+  a->DeallocateRaw(p2);
+  stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(1024, stats->peak_bytes_in_use);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, LargeChunksBypassCache) {
+  auto a = NewCPUBFCAllocator(1 << 20, true);
+  a->EnableThreadLocalCache(4096, 64 << 10);
+
+  void* p = a->AllocateRaw(64, 8192);
+  a->DeallocateRaw(p);
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(1, stats->num_allocs);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  // The chunk went back to the bins, so it can be merged and reused for a
+  // larger allocation.
+  void* q = a->AllocateRaw(64, 16384);
+  EXPECT_EQ(p, q);
+  a->DeallocateRaw(q);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, ChunkFreedOnAnotherThread) {
+  auto a = NewCPUBFCAllocator(1 << 20, true);
+  a->EnableThreadLocalCache(4096, 64 << 10);
+
+  void* p = a->AllocateRaw(64, 512);
+  std::unique_ptr<Thread> t(Env::Default()->StartThread(
+      ThreadOptions(), "dealloc", [&a, p]() {
+        a->DeallocateRaw(p);
+        // The chunk is in this thread's cache.
+        EXPECT_EQ(p, a->AllocateRaw(64, 512));
+        a->DeallocateRaw(p);
+      }));
+  t.reset();
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+  // The exited thread's cache still holds the chunk until it is flushed.
+  a->FlushThreadLocalCaches();
+  void* q = a->AllocateRaw(64, 512);
+  EXPECT_EQ(p, q);
+  a->DeallocateRaw(q);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, FlushesCachesUnderMemoryPressure) {
+  constexpr size_t kTotalMemory = 64 << 10;
+  auto a = NewCPUBFCAllocator(kTotalMemory, false);
+  a->EnableThreadLocalCache(4096, kTotalMemory);
+
+  // Fill the whole arena with small chunks and cache all of them.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < kTotalMemory / 4096; ++i) {
+    void* p = a->AllocateRaw(64, 4096);
+    ASSERT_NE(nullptr, p);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+
+  // Satisfying this request requires returning the cached chunks to the bins
+  // and coalescing them.
+  AllocationAttributes no_retry(false, true, nullptr);
+  void* big = a->AllocateRaw(64, kTotalMemory / 2, no_retry);
+  ASSERT_NE(nullptr, big);
+  EXPECT_EQ(kTotalMemory / 2, a->GetStats()->bytes_in_use);
+  a->DeallocateRaw(big);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+}
+
+TEST(BFCAllocatorReleaseFreeRegionsTest, ReleasesOnlyUnusedRegions) {
+  auto a = NewCPUBFCAllocator(64 << 20, true);
+
+  // The first allocation extends the allocator by a 1MiB region, the second
+  // needs a region of its own.
+  void* small = a->AllocateRaw(64, 1024);
+  void* large = a->AllocateRaw(64, 2 << 20);
+  ASSERT_NE(nullptr, small);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(0, a->ReleaseFreeRegions());
+
+  a->DeallocateRaw(large);
+  // Most of the free memory is in the large region, away from the free part
+  // of the small one.
+  EXPECT_GT(a->GetFragmentationMetric(), 0.0);
+  EXPECT_GE(a->ReleaseFreeRegions(), 2 << 20);
+  EXPECT_EQ(0.0, a->GetFragmentationMetric());
+  EXPECT_EQ(1024, a->RequestedSize(small));
+  EXPECT_EQ(0, a->ReleaseFreeRegions());
+
+  // The released memory can be allocated again.
+  large = a->AllocateRaw(64, 2 << 20);
+  ASSERT_NE(nullptr, large);
+  a->DeallocateRaw(large);
+  a->DeallocateRaw(small);
+  EXPECT_GT(a->ReleaseFreeRegions(), 0);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+}
+
+TEST(BFCAllocatorReleaseFreeRegionsTest, FlushesThreadLocalCaches) {
+  auto a = NewCPUBFCAllocator(1 << 20, false);
+  a->EnableThreadLocalCache(4096, 64 << 10);
+
+  void* p = a->AllocateRaw(64, 1024);
+  a->DeallocateRaw(p);
+  // The cached chunk would otherwise keep the only region in use.
+  EXPECT_EQ(1 << 20, a->ReleaseFreeRegions());
+
+  void* q = a->AllocateRaw(64, 1024);
+  ASSERT_NE(nullptr, q);
+  a->DeallocateRaw(q);
+}
+
+TEST(BFCAllocatorAllocationSitesTest, ReportsSitesAtPeak) {
+  auto a = NewCPUBFCAllocator(1 << 20, true);
+  a->EnableAllocationSiteRecording();
+
+  void* temp;
+  void* output;
+  {
+    ScopedMemoryDebugFunctionAnnotation function_annotation("my_function");
+    ScopedMemoryDebugAnnotation op_annotation("matmul", 0, "temp", 0, nullptr);
+    temp = a->AllocateRaw(64, 2048);
+  }
+  {
+    ScopedMemoryDebugAnnotation op_annotation("add", 0, "output", 0, nullptr);
+    output = a->AllocateRaw(64, 1024);
+  }
+  a->DeallocateRaw(temp);
+  // Below the peak, so the peak sites are unchanged.
+  void* other = a->AllocateRaw(64, 256);
+
+  MemoryDump md = a->RecordMemoryMap();
+  ASSERT_EQ(2, md.peak_allocation_site_size());
+  EXPECT_EQ("matmul", md.peak_allocation_site(0).op_name());
+  EXPECT_EQ("temp", md.peak_allocation_site(0).region_type());
+  EXPECT_EQ("my_function", md.peak_allocation_site(0).function_name());
+  EXPECT_EQ(2048, md.peak_allocation_site(0).bytes_in_use());
+  EXPECT_EQ(1, md.peak_allocation_site(0).num_chunks());
+  EXPECT_EQ("add", md.peak_allocation_site(1).op_name());
+  EXPECT_EQ("output", md.peak_allocation_site(1).region_type());
+  EXPECT_EQ("", md.peak_allocation_site(1).function_name());
+  EXPECT_EQ(1024, md.peak_allocation_site(1).bytes_in_use());
+
+  int num_attributed_chunks = 0;
+  for (const MemChunk& chunk : md.chunk()) {
+    if (chunk.address() == reinterpret_cast<uint64>(output)) {
+      EXPECT_EQ("add", chunk.op_name());
+      EXPECT_EQ("output", chunk.region_type());
+      ++num_attributed_chunks;
+    }
+  }
+  EXPECT_EQ(1, num_attributed_chunks);
+
+  const string report = a->RenderPeakAllocationSites(1);
+  EXPECT_NE(string::npos, report.find("matmul (temp) in function my_function"))
+      << report;
+  EXPECT_EQ(string::npos, report.find("add")) << report;
+
+  a->DeallocateRaw(output);
+  a->DeallocateRaw(other);
+}
+
+void BM_AllocateAndDeallocate(int iters, int num_threads, bool use_cache) {
+  testing::StopTiming();
+  auto a = NewCPUBFCAllocator(1 << 30, true);
+  if (use_cache) a->EnableThreadLocalCache(64 << 10, 1 << 20);
+  std::vector<std::unique_ptr<Thread>> threads;
+  testing::StartTiming();
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back(Env::Default()->StartThread(
+        ThreadOptions(), "bench", [&a, iters]() {
+          for (int i = 0; i < iters; ++i) {
+            void* p = a->AllocateRaw(64, 256 * (1 + i % 16));
+            a->DeallocateRaw(p);
+          }
+        }));
+  }
+  threads.clear();
+  testing::StopTiming();
+}
+
+void BM_AllocateAndDeallocateNoCache(int iters, int num_threads) {
+  BM_AllocateAndDeallocate(iters, num_threads, false);
+}
+BENCHMARK(BM_AllocateAndDeallocateNoCache)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_AllocateAndDeallocateThreadLocalCache(int iters, int num_threads) {
+  BM_AllocateAndDeallocate(iters, num_threads, true);
+}
+BENCHMARK(BM_AllocateAndDeallocateThreadLocalCache)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -666,11 +666,23 @@ Status DirectSession::RunInternal(
           ((measure_step_count + 1) % build_cost_model_every == 0);
     }
   }
+  const int32 node_cost_sample_steps =
+      options_.config.experimental().node_cost_sample_steps();
+  const bool collect_node_costs =
+      node_cost_sample_steps > 0 &&
+      (executor_step_count + 1) % node_cost_sample_steps == 0;
+  // The stats of the step, unless the caller asked for them in `run_metadata`.
+  StepStats node_cost_step_stats;
+  const StepStats* collected_step_stats = &node_cost_step_stats;
   if (do_trace || update_cost_model ||
       run_options.report_tensor_allocations_upon_oom()) {
     run_state.collector.reset(
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
+    collected_step_stats = &run_metadata->step_stats();
+  } else if (collect_node_costs) {
+    run_state.collector.reset(new StepStatsCollector(&node_cost_step_stats));
+    args.stats_collector = run_state.collector.get();
   }
 
   std::unique_ptr<ProfilerSession> profiler_session;
@@ -772,6 +784,9 @@ Status DirectSession::RunInternal(
   if (run_state.collector) {
     run_state.collector->Finalize();
   }
+  if (collect_node_costs) {
+    node_cost_collector_.AddStep(*collected_step_stats);
+  }
 
   // Build and return the cost model as instructed.
   if (update_cost_model) {
@@ -1372,6 +1387,12 @@ Status DirectSession::CreateExecutors(
     params.device = device;
     params.session_metadata = session_metadata;
     params.function_library = lib;
+    params.static_memory_plan_warmup_steps =
+        options_.config.experimental().static_memory_plan_warmup_steps();
+    params.record_op_latency =
+        options_.config.experimental().record_op_latency();
+    params.capture_device_graphs =
+        options_.config.experimental().capture_gpu_graphs();
     auto opseg = device->op_segment();
     params.create_kernel =
         [this, lib, opseg](const std::shared_ptr<const NodeProperties>& props,
@@ -1412,6 +1433,15 @@ Status DirectSession::CreateExecutors(
                                          device->name(),
                                          partition_graph.get()));
 
+    for (const Node* n : partition_graph->op_nodes()) {
+      // Arguments, return values and transfers only touch per-step state.
+      if (n->IsArg() || n->IsRetval() || n->IsSend() || n->IsRecv()) continue;
+      if (n->op_def().is_stateful() || n->IsFunctionCall()) {
+        ek->has_stateful_ops = true;
+        break;
+      }
+    }
+
     item->executor = nullptr;
     item->device = device;
     auto executor_type = options_.config.experimental().executor_type();
@@ -1759,6 +1789,11 @@ Status DirectSession::CreateGraphs(
     closed_ = true;
   }
   if (factory_ != nullptr) factory_->Deregister(this);
+  const string& node_cost_path =
+      options_.config.experimental().node_cost_path();
+  if (!node_cost_path.empty() && node_cost_collector_.num_steps() > 0) {
+    return node_cost_collector_.WriteSummary(options_.env, node_cost_path);
+  }
   return ::tensorflow::Status::OK();
 }
 
@@ -1913,22 +1948,120 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   TF_RETURN_IF_ERROR(CheckGraphCreated("RunCallable()"));
   direct_session_runs->GetCell()->IncrementBy(1);
 
-  // Check if we already have an executor for these arguments.
   std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
-  const int64 step_id = step_id_counter_.fetch_add(1);
+  TF_RETURN_IF_ERROR(GetCallableExecutors(handle, &executors_and_keys));
+  return RunCallableStep(executors_and_keys.get(), feed_tensors, fetch_tensors,
+                         run_metadata, threadpool_options);
+}
+
+::tensorflow::Status DirectSession::RunCallableBatch(
+    CallableHandle handle,
+    const std::vector<std::vector<Tensor>>& feed_tensors_batch,
+    std::vector<std::vector<Tensor>>* fetch_tensors_batch,
+    RunMetadata* run_metadata,
+    const thread::ThreadPoolOptions& threadpool_options) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  TF_RETURN_IF_ERROR(CheckGraphCreated("RunCallableBatch()"));
+  if (fetch_tensors_batch == nullptr) {
+    return errors::InvalidArgument("`fetch_tensors_batch` must be provided.");
+  }
+  direct_session_runs->GetCell()->IncrementBy(feed_tensors_batch.size());
+
+  // The handle is resolved once, and the executors it names are kept alive
+  // for the whole batch even if the handle is released concurrently.
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
+  TF_RETURN_IF_ERROR(GetCallableExecutors(handle, &executors_and_keys));
+
+  const size_t num_iterations = feed_tensors_batch.size();
+  fetch_tensors_batch->clear();
+  fetch_tensors_batch->resize(num_iterations);
+  auto iteration_failed = [fetch_tensors_batch](size_t i, Status s) {
+    fetch_tensors_batch->resize(i);
+    errors::AppendToMessage(&s, "in iteration ", i, " of RunCallableBatch");
+    return s;
+  };
+
+  if (executors_and_keys->has_stateful_ops || num_iterations < 2) {
+    // Each iteration must observe the side effects of the previous one.
+    for (size_t i = 0; i < num_iterations; ++i) {
+      Status s = RunCallableStep(executors_and_keys.get(),
+                                 feed_tensors_batch[i],
+                                 &(*fetch_tensors_batch)[i], run_metadata,
+                                 threadpool_options);
+      if (!s.ok()) return iteration_failed(i, s);
+    }
+    return Status::OK();
+  }
 
+  // The iterations of a callable without stateful ops are independent, so
+  // iteration i + 1 is dispatched while iteration i is still running. Each
+  // in-flight iteration collects its own metadata, which is merged in order.
+  static constexpr size_t kMaxInFlightIterations = 2;
+  struct Iteration {
+    Notification done;
+    Status status;
+    RunMetadata run_metadata;
+  };
+  std::vector<std::unique_ptr<Iteration>> iterations;
+  iterations.reserve(num_iterations);
+  for (size_t i = 0; i < num_iterations; ++i) {
+    if (i >= kMaxInFlightIterations) {
+      Iteration* oldest = iterations[i - kMaxInFlightIterations].get();
+      oldest->done.WaitForNotification();
+      // Stop dispatching once an iteration has failed.
+      if (!oldest->status.ok()) break;
+    }
+    iterations.push_back(absl::make_unique<Iteration>());
+    Iteration* iteration = iterations.back().get();
+    options_.env->SchedClosure([this, &executors_and_keys, &feed_tensors_batch,
+                                fetch_tensors_batch, run_metadata,
+                                &threadpool_options, i, iteration]() {
+      iteration->status = RunCallableStep(
+          executors_and_keys.get(), feed_tensors_batch[i],
+          &(*fetch_tensors_batch)[i],
+          run_metadata != nullptr ? &iteration->run_metadata : nullptr,
+          threadpool_options);
+      iteration->done.Notify();
+    });
+  }
+  for (const auto& iteration : iterations) {
+    iteration->done.WaitForNotification();
+  }
+  for (size_t i = 0; i < iterations.size(); ++i) {
+    if (!iterations[i]->status.ok()) {
+      return iteration_failed(i, iterations[i]->status);
+    }
+    if (run_metadata != nullptr) {
+      run_metadata->MergeFrom(iterations[i]->run_metadata);
+    }
+  }
+  return Status::OK();
+}
+
+::tensorflow::Status DirectSession::GetCallableExecutors(
+    CallableHandle handle,
+    std::shared_ptr<ExecutorsAndKeys>* executors_and_keys) {
   {
     tf_shared_lock l(callables_lock_);
     if (handle >= next_callable_handle_) {
       return errors::InvalidArgument("No such callable handle: ", handle);
     }
-    executors_and_keys = callables_[handle].executors_and_keys;
+    *executors_and_keys = callables_[handle].executors_and_keys;
   }
 
-  if (!executors_and_keys) {
+  if (!*executors_and_keys) {
     return errors::InvalidArgument(
         "Attempted to run callable after handle was released: ", handle);
   }
+  return Status::OK();
+}
+
+::tensorflow::Status DirectSession::RunCallableStep(
+    ExecutorsAndKeys* executors_and_keys,
+    const std::vector<Tensor>& feed_tensors,
+    std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
+    const thread::ThreadPoolOptions& threadpool_options) {
+  const int64 step_id = step_id_counter_.fetch_add(1);
 
   // NOTE(mrry): Debug options are not currently supported in the
   // callable interface.
@@ -1980,7 +2113,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
 
   // A specialized CallFrame implementation that takes advantage of the
   // optimized RunCallable interface.
-  RunCallableCallFrame call_frame(this, executors_and_keys.get(),
+  RunCallableCallFrame call_frame(this, executors_and_keys,
                                   actual_feed_tensors, fetch_tensors);
 
   if (LogMemory::IsEnabled()) {
@@ -1989,7 +2122,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
 
   TF_RETURN_IF_ERROR(RunInternal(
       step_id, executors_and_keys->callable_options.run_options(), &call_frame,
-      executors_and_keys.get(), run_metadata, threadpool_options));
+      executors_and_keys, run_metadata, threadpool_options));
 
   if (fetch_tensors != nullptr) {
     size_t output_size = 0;
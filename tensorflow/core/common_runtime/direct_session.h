@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
+#include "tensorflow/core/common_runtime/node_cost_collector.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
@@ -131,6 +132,13 @@ class DirectSession : public Session {
       std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
       const thread::ThreadPoolOptions& threadpool_options) override;
 
+  ::tensorflow::Status RunCallableBatch(
+      CallableHandle handle,
+      const std::vector<std::vector<Tensor>>& feed_tensors_batch,
+      std::vector<std::vector<Tensor>>* fetch_tensors_batch,
+      RunMetadata* run_metadata,
+      const thread::ThreadPoolOptions& threadpool_options) override;
+
   ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
 
   ::tensorflow::Status Finalize() override;
@@ -176,6 +184,10 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // True if any partition contains a stateful op or a function call, in
+    // which case steps may not overlap within RunCallableBatch().
+    bool has_stateful_ops = false;
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -269,6 +281,19 @@ class DirectSession : public Session {
       RunMetadata* run_metadata,
       const thread::ThreadPoolOptions& threadpool_options);
 
+  // Looks up the executors of the callable named by `handle`.
+  ::tensorflow::Status GetCallableExecutors(
+      CallableHandle handle,
+      std::shared_ptr<ExecutorsAndKeys>* executors_and_keys);
+
+  // Runs one step of a callable whose executors were returned by
+  // GetCallableExecutors().
+  ::tensorflow::Status RunCallableStep(
+      ExecutorsAndKeys* executors_and_keys,
+      const std::vector<Tensor>& feed_tensors,
+      std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
+      const thread::ThreadPoolOptions& threadpool_options);
+
   // Returns whether inter-op execution uses a global pool or the input
   // `run_options` requests being run on inter_op_thread_pool = 0 in case
   // multiple pools are configured.
@@ -421,6 +446,10 @@ class DirectSession : public Session {
   // Manages all the cost models for the graphs executed in this session.
   CostModelManager cost_model_manager_;
 
+  // Aggregates the node costs of the steps sampled every
+  // `ConfigProto.Experimental.node_cost_sample_steps`.
+  NodeCostCollector node_cost_collector_;
+
   // For testing collective graph key generation.
   mutex collective_graph_key_lock_;
   int64 collective_graph_key_ TF_GUARDED_BY(collective_graph_key_lock_) = -1;
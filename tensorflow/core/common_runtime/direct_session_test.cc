@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -43,11 +44,13 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
@@ -228,6 +231,107 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
       absl::StrContains(s.error_message(), "optimize_for_static_graph"));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_StaticMemoryPlan) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_static_memory_plan_warmup_steps(2);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(
+      MakeCallableOptions({}, {y_ + ":0", z_ + ":0"}, {}), &handle));
+  // Keep the outputs of every step alive, so that later steps cannot reuse
+  // the buffers of fetched tensors.
+  std::vector<std::vector<Tensor>> all_outputs(5);
+  for (auto& outputs : all_outputs) {
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(2, outputs.size());
+  }
+  for (const auto& outputs : all_outputs) {
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  // Fetched tensors remain valid after the executors have been deleted.
+  TF_ASSERT_OK(session->Close());
+  session.reset();
+  EXPECT_FLOAT_EQ(1.0, all_outputs[4][1].matrix<float>()(1, 0));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_RecordOpLatency) {
+  Initialize({3, 2, -1, 0});
+  monitoring::SamplerCell* matmul_latency =
+      metrics::GetOpLatencyUsecsCell("MatMul", DEVICE_CPU);
+  const double num_samples_before = matmul_latency->value().num();
+
+  SessionOptions options(DefaultSessionOptions());
+  // Keep the MatMul of constants from being folded away.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_constant_folding(RewriterConfig::OFF);
+  options.config.mutable_experimental()->set_record_op_latency(true);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {}, &outputs));
+  }
+  // The graph has one MatMul, which runs once per step.
+  EXPECT_EQ(num_samples_before + 3, matmul_latency->value().num());
+
+  // Latencies are not recorded by default.
+  options.config.mutable_experimental()->set_record_op_latency(false);
+  session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {}, &outputs));
+  EXPECT_EQ(num_samples_before + 3, matmul_latency->value().num());
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_CollectNodeCosts) {
+  Initialize({3, 2, -1, 0});
+  const string path = io::JoinPath(testing::TmpDir(), "node_costs.pb");
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_node_cost_sample_steps(2);
+  options.config.mutable_experimental()->set_node_cost_path(path);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 4; ++i) {
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(RunOptions(), {}, {y_ + ":0"}, {}, &outputs,
+                              &run_metadata));
+    // The sampled stats are not returned to the caller.
+    EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 0);
+  }
+  TF_ASSERT_OK(session->Close());
+
+  RunMetadata node_costs;
+  TF_ASSERT_OK(ReadBinaryProto(Env::Default(), path, &node_costs));
+  bool found = false;
+  for (const auto& dev_stats : node_costs.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      if (node_stats.node_name() != y_) continue;
+      found = true;
+      ASSERT_EQ(node_stats.output_size(), 1);
+      // y is a 2x1 float matrix.
+      EXPECT_EQ(node_stats.output(0)
+                    .tensor_description()
+                    .allocation_description()
+                    .requested_bytes(),
+                8);
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
 TEST_F(DirectSessionMinusAXTest,
        RunSimpleNetwork_DisableOutputPartitionGraphs) {
   Initialize({3, 2, -1, 0});
@@ -550,6 +654,46 @@ TEST_F(DirectSessionMinusAXTest, TestFeed_Callable) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, TestFeed_CallableBatch) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(MakeCallableOptions({x_}, {y_ + ":0"}, {}),
+                                     &handle));
+  std::vector<std::vector<Tensor>> inputs;
+  for (int i = 0; i < 3; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = i;
+    t.matrix<float>()(1, 0) = 1;
+    inputs.push_back({t});
+  }
+  std::vector<std::vector<Tensor>> outputs;
+  TF_ASSERT_OK(session->RunCallableBatch(handle, inputs, &outputs, nullptr,
+                                         thread::ThreadPoolOptions()));
+  ASSERT_EQ(3, outputs.size());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(1, outputs[i].size());
+    auto mat = outputs[i][0].matrix<float>();
+    EXPECT_FLOAT_EQ(1 * i + 2, mat(0, 0));
+    EXPECT_FLOAT_EQ(3 * i + 4, mat(1, 0));
+  }
+
+  // A bad feed stops the batch and keeps the fetches of earlier iterations.
+  inputs[1] = {};
+  Status s = session->RunCallableBatch(handle, inputs, &outputs, nullptr,
+                                       thread::ThreadPoolOptions());
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_EQ(1, outputs.size());
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  s = session->RunCallableBatch(handle, inputs, &outputs, nullptr,
+                                thread::ThreadPoolOptions());
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -97,6 +97,7 @@ class AttrBuilder {
     op_name_ = op;
     num_inputs_ = 0;
     encoded_attrs_.clear();
+    attrs_fingerprint_ = {0, 0};
     node_def_initialized_ = false;
     node_def_finalized_ = false;
     cached_cache_key_ = absl::nullopt;
@@ -180,6 +181,10 @@ class AttrBuilder {
   void AddAttrIfNotPresent(StringPiece attr_name, const AttrValue& value);
 
   gtl::FlatMap<string, string> encoded_attrs_;
+  // Unordered combination of the fingerprints of the entries of
+  // `encoded_attrs_`, maintained as they are added so that computing a cache
+  // key does not rehash every attribute.
+  tensorflow::Fprint128 attrs_fingerprint_{0, 0};
   mutable AttrValue attr_tmp_;  // For encoding
 
   string op_name_;  // Conceptually const, but can't be because of Reset(...)
@@ -29,6 +29,13 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+int64 MaxFusedNodes() {
+  int64 max_fused_nodes = 0;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_MAX_FUSED_ASYNC_NODES", 0,
+                                  &max_fused_nodes));
+  return max_fused_nodes;
+}
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async)
@@ -40,7 +47,8 @@ EagerExecutor::EagerExecutor(bool async)
                     : nullptr),
       last_eager_client_(nullptr),
       enable_async_wait_for_remote_function_(
-          IsAsyncWaitForRemoteFunctionEnabled()) {}
+          IsAsyncWaitForRemoteFunctionEnabled()),
+      max_fused_nodes_(MaxFusedNodes()) {}
 
 EagerExecutor::~EagerExecutor() {
   tensorflow::mutex_lock l(node_queue_mutex_);
@@ -153,7 +161,7 @@ Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
     } else {
       status = status_;
       if (status.ok()) {
-        node_queue_.push(std::move(item));
+        node_queue_.push_back(std::move(item));
         // If there were no previous nodes pending, wake the run thread to
         // start processing requests again.
         if (node_queue_.size() == 1) {
@@ -235,7 +243,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
     if (from_queue) {
       // Since this was from the async queue, pop it from the front of the queue
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-      node_queue_.pop();
+      node_queue_.pop_front();
     } else if (async) {
       // If it is an Async node then we will find the node in the unfinished
       // nodes list. However we only notify if we are at the front of the list
@@ -269,7 +277,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       }
       while (!node_queue_.empty()) {
         items_to_destroy.push_front(std::move(node_queue_.front()));
-        node_queue_.pop();
+        node_queue_.pop_front();
       }
       for (auto& it : unfinished_nodes_) {
         items_to_destroy.push_front(std::move(it.second));
@@ -323,6 +331,7 @@ void EagerExecutor::Run() {
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
     core::RefCountPtr<NodeItem> curr_item;
+    std::vector<core::RefCountPtr<NodeItem>> fused_items;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
@@ -338,8 +347,22 @@ void EagerExecutor::Run() {
       // and register a notification for its completion.
       curr_item.reset(node_queue_.front().get());
       curr_item->Ref();
+      if (max_fused_nodes_ > 1 && curr_item->node->AsFusible() != nullptr) {
+        for (int i = 1; i < node_queue_.size() && i < max_fused_nodes_; ++i) {
+          NodeItem* item = node_queue_[i].get();
+          if (item->node->AsFusible() == nullptr) break;
+          item->Ref();
+          fused_items.emplace_back(item);
+        }
+      }
+    }
+    Status status;
+    if (fused_items.empty()) {
+      status = RunItem(std::move(curr_item), /*from_queue=*/true);
+    } else {
+      fused_items.insert(fused_items.begin(), std::move(curr_item));
+      status = RunFusedItems(std::move(fused_items));
     }
-    Status status = RunItem(std::move(curr_item), /*from_queue=*/true);
     if (!status.ok()) {
       VLOG(1) << "Failed to run item: " << status;
     }
@@ -399,6 +422,26 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
   return status();
 }
 
+Status EagerExecutor::RunFusedItems(
+    std::vector<core::RefCountPtr<NodeItem>> items) {
+  std::vector<FusibleEagerNode*> nodes;
+  nodes.reserve(items.size());
+  for (const auto& item : items) {
+    DVLOG(3) << "Running fused Node: [id " << item->id << "] "
+             << item->node->DebugString();
+    nodes.push_back(item->node->AsFusible());
+  }
+  int num_done = 0;
+  Status status = nodes.front()->RunFused(nodes, &num_done);
+  for (int i = 0; i < num_done; ++i) {
+    NodeDone(items[i], Status::OK(), /*from_queue=*/true);
+  }
+  if (!status.ok()) {
+    NodeDone(items[num_done], status, /*from_queue=*/true);
+  }
+  return status;
+}
+
 Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
                                        bool from_queue) {
   tensorflow::mutex_lock l(node_queue_mutex_);
@@ -408,7 +451,7 @@ Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
 
   if (from_queue) {
     DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-    node_queue_.pop();
+    node_queue_.pop_front();
   }
 
   DVLOG(3) << "Add Node: [id " << item->id << "] to unfinished map.";
@@ -17,12 +17,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
@@ -40,6 +41,7 @@ namespace tensorflow {
 
 class AsyncEagerNode;
 class AsyncRemoteExecuteNode;
+class FusibleEagerNode;
 namespace eager {
 class EagerClient;
 }
@@ -71,6 +73,9 @@ class EagerNode {
   virtual AsyncEagerNode* AsAsync() { return nullptr; }
   virtual AsyncRemoteExecuteNode* AsAsyncRemoteExecuteNode() { return nullptr; }
 
+  // Returns nullptr iff this Eager node can't run fused with other nodes.
+  virtual FusibleEagerNode* AsFusible() { return nullptr; }
+
   virtual string DebugString() const = 0;
 
   // Indicates whether a node failure should make the executor unusable.
@@ -109,6 +114,20 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): Support out-of-order execution and dispatching multiple
 // EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
+// A synchronous EagerNode which an async EagerExecutor may run together with
+// the fusible nodes that follow it in its queue. Enabled by setting the
+// TF_EAGER_MAX_FUSED_ASYNC_NODES environment variable to the largest number of
+// nodes to run together.
+class FusibleEagerNode : public EagerNode {
+ public:
+  // Runs `nodes`, consecutive fusible nodes of the queue starting with this
+  // one and of the same type, in order, fusing them into single calls where
+  // possible. Stops at the first failure and returns it, after aborting the
+  // node that failed. Sets `num_done` to the number of nodes run successfully.
+  virtual Status RunFused(absl::Span<FusibleEagerNode* const> nodes,
+                          int* num_done) = 0;
+};
+
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async);
@@ -204,6 +223,8 @@ class EagerExecutor {
   void Run();
 
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Runs `items`, the fusible items at the front of the queue, together.
+  Status RunFusedItems(std::vector<core::RefCountPtr<NodeItem>> items);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
 
   // The impl of WaitForAllPendingNodes
@@ -221,7 +242,7 @@ class EagerExecutor {
   condition_variable nodes_pending_ TF_GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending NodeItems. Ordered by NodeItem::id.
-  std::queue<core::RefCountPtr<NodeItem>> node_queue_
+  std::deque<core::RefCountPtr<NodeItem>> node_queue_
       TF_GUARDED_BY(node_queue_mutex_);
 
   // Ordered by NodeItem::id.
@@ -258,6 +279,10 @@ class EagerExecutor {
 
   const bool enable_async_wait_for_remote_function_;
 
+  // The largest number of fusible nodes run together. Fusion is disabled when
+  // smaller than 2.
+  const int64 max_fused_nodes_;
+
   // Callbacks to run on destruction.
   std::unordered_map<intptr_t, std::vector<std::function<void()>>> cleanups_;
 };
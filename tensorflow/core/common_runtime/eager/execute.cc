@@ -68,6 +68,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/common_runtime/eager/eager_op_rewrite_registry.h"
@@ -432,6 +433,11 @@ Status GetOrCreateKernelAndDevice(
     profiler::TraceMe activity("EagerCopyToDeviceAndAddCacheKey",
                                profiler::TraceMeLevel::kInfo);
     input_dev_ptrs.reserve(op->Inputs().size());
+    // Inputs are mostly on a handful of devices, so the composite device
+    // lookup and the fingerprint of the device name are reused from the
+    // previous input when it is on the same device.
+    Device* previous_input_device = nullptr;
+    Fprint128 previous_input_device_fingerprint = {0, 0};
     // When LazyCopyFunctionRemoteInputs is disabled, all inputs need to be on
     // local devices, since we execute a remote function through worker service,
     // which doesn't accept remote inputs.
@@ -454,15 +460,20 @@ Status GetOrCreateKernelAndDevice(
       Device* input_device;
       TF_RETURN_IF_ERROR(GetDeviceForInput(ctx, input, &input_device));
       input_dev_ptrs.push_back(input_device);
-      CompositeDevice* composite_device = nullptr;
-      if (ctx.FindCompositeDeviceFromName(input_device->name(),
-                                          &composite_device)
-              .ok()) {
-        composite_devices[input_device->name()] =
-            composite_device->underlying_devices();
+      if (input_device != previous_input_device) {
+        CompositeDevice* composite_device = nullptr;
+        if (ctx.FindCompositeDeviceFromName(input_device->name(),
+                                            &composite_device)
+                .ok()) {
+          composite_devices[input_device->name()] =
+              composite_device->underlying_devices();
+        }
+        previous_input_device = input_device;
+        previous_input_device_fingerprint =
+            Fingerprint128(input_device->name());
       }
       cache_key =
-          FingerprintCat128(cache_key, Fingerprint128(input_device->name()));
+          FingerprintCat128(cache_key, previous_input_device_fingerprint);
 
       // If input is a ResourceHandle, get its resource handle dtypes and shapes
       // and add them to 'cache_key'.
@@ -1237,6 +1248,28 @@ Status LocalEagerCopyToDevice(TensorHandle* h, EagerContext* ctx,
   return s;
 }
 
+#if !defined(IS_MOBILE_PLATFORM)
+// Fingerprints the content of `h` when it is a ready local tensor in host
+// memory, whose copies to remote devices can then be shared by content.
+bool RemoteTensorCopyFingerprint(TensorHandle* h, const Device* send_device,
+                                 Fprint128* fingerprint, int64* num_bytes) {
+  const Tensor* t = nullptr;
+  if (h->Type() != TensorHandle::LOCAL || !h->IsReady() ||
+      send_device->device_type() != DEVICE_CPU ||
+      !DataTypeCanUseMemcpy(h->dtype) || !h->Tensor(&t).ok()) {
+    return false;
+  }
+  const StringPiece data = t->tensor_data();
+  *fingerprint = Fingerprint128(data);
+  const string metadata =
+      absl::StrCat(DataTypeString(t->dtype()), t->shape().DebugString());
+  fingerprint->low64 =
+      FingerprintCat64(fingerprint->low64, Fingerprint64(metadata));
+  *num_bytes = data.size();
+  return true;
+}
+#endif  // !IS_MOBILE_PLATFORM
+
 }  // namespace
 
 Status EagerCopyToDevice(TensorHandle* h, EagerContext* ctx,
@@ -1266,6 +1299,9 @@ Status EagerCopyToDevice(TensorHandle* h, EagerContext* ctx,
         "Eager's remote execution is not available on mobile devices.");
 #else   // !IS_MOBILE_PLATFORM
     uint64 recv_op_id = 0;
+    bool cache_copy = false;
+    Fprint128 fingerprint;
+    int64 num_bytes = 0;
     if (receiver_is_local) {
       Device* d = ctx->CanonicalDevice(device);
       // TODO(gjn): Need to add support for async execution. Note if receiver
@@ -1306,6 +1342,19 @@ Status EagerCopyToDevice(TensorHandle* h, EagerContext* ctx,
           return Status::OK();
         }
       }
+      // A local tensor with the content of one sent before reuses its copy,
+      // which is referred to by id instead of being sent again.
+      cache_copy =
+          sender_is_local && ctx->RemoteMgr()->RemoteTensorCacheEnabled() &&
+          RemoteTensorCopyFingerprint(h, absl::get<Device*>(send_device),
+                                      &fingerprint, &num_bytes);
+      if (cache_copy) {
+        *result = ctx->RemoteMgr()->LookupRemoteTensorCopy(
+            fingerprint, device, ctx->GetContextViewId());
+        if (*result != nullptr) {
+          return Status::OK();
+        }
+      }
       string remote_task;
       if (!DeviceNameUtils::GetTaskName(device->parsed_name(), &remote_task)) {
         return errors::InvalidArgument(
@@ -1329,6 +1378,9 @@ Status EagerCopyToDevice(TensorHandle* h, EagerContext* ctx,
     Status s = executor->AddOrExecute(std::move(node));
     if (!s.ok()) {
       result[0]->Unref();
+    } else if (cache_copy) {
+      ctx->RemoteMgr()->CacheRemoteTensorCopy(
+          fingerprint, device, ctx->GetContextViewId(), num_bytes, result[0]);
     }
     return s;
 #endif  // !IS_MOBILE_PLATFORM
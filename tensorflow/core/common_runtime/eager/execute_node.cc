@@ -14,9 +14,36 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
+namespace {
+
+// Prefix of the names of the functions AsyncExecuteNode::RunFused runs.
+constexpr char kFusedFunctionPrefix[] = "__eager_fused_ops_";
+
+// Whether a tensor of `dtype` lives in the memory of `device`, as opposed to
+// host memory.
+bool InDeviceMemory(DataType dtype, const Device& device) {
+  if (IsRefType(dtype) || dtype == DT_RESOURCE || dtype == DT_VARIANT) {
+    return false;
+  }
+  return device.device_type() == DEVICE_CPU ||
+         MTypeFromDType(dtype) == DEVICE_MEMORY;
+}
+
+}  // namespace
 
 #if !defined(IS_MOBILE_PLATFORM)
 bool ExecuteNodeArgs::IsRemote(EagerContext* ctx, Device* input_device,
@@ -148,4 +175,204 @@ Status ExecuteNodeArgs::GetLocalArg(const FunctionArgIndex& index,
   }
 }
 
+bool AsyncExecuteNode::IsFusible() const {
+  if (remote_func_params_.has_value() || graph_collector_ != nullptr ||
+      cancellation_manager_ != nullptr || kernel_->IsFunction() ||
+      kernel_->kernel() == nullptr) {
+    return false;
+  }
+  const Device* device = kernel_->device();
+  if (device == nullptr || !device->IsLocal()) return false;
+  for (int i = 0, end = inputs_.size(); i < end; ++i) {
+    if (kernel_->InputDevice(i) != device ||
+        inputs_[i]->Type() != TensorHandle::LOCAL ||
+        VariantDeviceIsCustom(inputs_[i]->device()) ||
+        !InDeviceMemory(kernel_->input_dtypes()[i], *device)) {
+      return false;
+    }
+  }
+  for (int i = 0, end = retvals_.size(); i < end; ++i) {
+    if (kernel_->OutputDevice(i) != device ||
+        !InDeviceMemory(kernel_->output_dtypes()[i], *device)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AsyncExecuteNode::IsStateless() const {
+  const OpDef* op_def = nullptr;
+  return OpRegistry::Global()
+             ->LookUpOpDef(kernel_->kernel()->def().op(), &op_def)
+             .ok() &&
+         !op_def->is_stateful();
+}
+
+Status AsyncExecuteNode::RunFused(absl::Span<FusibleEagerNode* const> nodes,
+                                  int* num_done) {
+  // The executor only fuses nodes of the same type.
+  std::vector<AsyncExecuteNode*> execute_nodes;
+  execute_nodes.reserve(nodes.size());
+  for (FusibleEagerNode* node : nodes) {
+    execute_nodes.push_back(static_cast<AsyncExecuteNode*>(node));
+  }
+  const int num_nodes = execute_nodes.size();
+  *num_done = 0;
+  while (*num_done < num_nodes) {
+    const int begin = *num_done;
+    const AsyncExecuteNode* first = execute_nodes[begin];
+    int end = begin + 1;
+    if (first->IsStateless()) {
+      while (end < num_nodes && execute_nodes[end]->ctx_ == first->ctx_ &&
+             execute_nodes[end]->kernel_->device() ==
+                 first->kernel_->device() &&
+             execute_nodes[end]->IsStateless()) {
+        ++end;
+      }
+    }
+    Status status;
+    if (end - begin == 1) {
+      status = execute_nodes[begin]->Run();
+    } else {
+      status = RunAsFunction(
+          absl::MakeConstSpan(execute_nodes).subspan(begin, end - begin));
+      if (!status.ok()) {
+        if (first->stack_trace_.has_value()) {
+          status = Status(status.code(), status.error_message(),
+                          first->stack_trace_->ToStackFrames());
+        }
+        execute_nodes[begin]->Abort(status);
+      }
+    }
+    if (!status.ok()) return status;
+    *num_done = end;
+  }
+  return Status::OK();
+}
+
+Status AsyncExecuteNode::RunAsFunction(
+    absl::Span<AsyncExecuteNode* const> nodes) {
+  EagerContext* ctx = nodes.front()->ctx_;
+  Device* device = nodes.front()->kernel_->device();
+
+  // Maps the tensors of the nodes to their sources, i.e. the node, or -1 for
+  // the arguments of the function, and the index of the output.
+  absl::flat_hash_map<const TensorHandle*, std::pair<int, int>> sources;
+  std::vector<TensorHandle*> args;
+  std::vector<std::vector<std::pair<int, int>>> input_sources(nodes.size());
+  // The signature of the sequence of ops, from which the function is named.
+  string signature = device->name();
+  int num_outputs = 0;
+  for (int i = 0, end = nodes.size(); i < end; ++i) {
+    const AsyncExecuteNode& node = *nodes[i];
+    strings::StrAppend(&signature, ";",
+                       DeterministicProtoHash64(node.kernel_->kernel()->def()));
+    for (TensorHandle* input : node.inputs_) {
+      auto it = sources.find(input);
+      if (it == sources.end()) {
+        it = sources.emplace(input, std::make_pair(-1, args.size())).first;
+        args.push_back(input);
+      }
+      input_sources[i].push_back(it->second);
+      strings::StrAppend(&signature, ",", it->second.first, ":",
+                         it->second.second);
+    }
+    for (int j = 0, num_retvals = node.retvals_.size(); j < num_retvals; ++j) {
+      sources.emplace(node.retvals_[j], std::make_pair(i, j));
+    }
+    num_outputs += node.retvals_.size();
+  }
+  const Fprint128 fingerprint = Fingerprint128(signature);
+  const string name =
+      strings::StrCat(kFusedFunctionPrefix,
+                      strings::Hex(fingerprint.high64, strings::kZeroPad16),
+                      strings::Hex(fingerprint.low64, strings::kZeroPad16));
+
+  if (ctx->FindFunctionDef(name) == nullptr) {
+    Graph graph(OpRegistry::Global());
+    Status status;
+    std::vector<Node*> arg_nodes;
+    for (int k = 0, end = args.size(); k < end; ++k) {
+      NodeDef def;
+      TF_RETURN_IF_ERROR(NodeDefBuilder(strings::StrCat("arg", k),
+                                        FunctionLibraryDefinition::kArgOp)
+                             .Attr("T", args[k]->dtype)
+                             .Attr("index", k)
+                             .Device(device->name())
+                             .Finalize(&def));
+      arg_nodes.push_back(graph.AddNode(def, &status));
+      TF_RETURN_IF_ERROR(status);
+    }
+    std::vector<Node*> op_nodes;
+    int num_retval_nodes = 0;
+    for (int i = 0, end = nodes.size(); i < end; ++i) {
+      NodeDef def = nodes[i]->kernel_->kernel()->def();
+      def.set_name(strings::StrCat("op", i));
+      def.clear_input();
+      def.set_device(device->name());
+      Node* op_node = graph.AddNode(def, &status);
+      TF_RETURN_IF_ERROR(status);
+      for (int j = 0, num_inputs = input_sources[i].size(); j < num_inputs;
+           ++j) {
+        const std::pair<int, int>& source = input_sources[i][j];
+        if (source.first < 0) {
+          graph.AddEdge(arg_nodes[source.second], 0, op_node, j);
+        } else {
+          graph.AddEdge(op_nodes[source.first], source.second, op_node, j);
+        }
+      }
+      op_nodes.push_back(op_node);
+      const DataTypeVector& output_dtypes =
+          nodes[i]->kernel_->output_dtypes();
+      for (int j = 0, num_retvals = nodes[i]->retvals_.size(); j < num_retvals;
+           ++j) {
+        NodeDef retval_def;
+        TF_RETURN_IF_ERROR(
+            NodeDefBuilder(strings::StrCat("retval", num_retval_nodes),
+                           FunctionLibraryDefinition::kRetOp)
+                .Attr("T", output_dtypes[j])
+                .Attr("index", num_retval_nodes)
+                .Device(device->name())
+                .Finalize(&retval_def));
+        Node* retval_node = graph.AddNode(retval_def, &status);
+        TF_RETURN_IF_ERROR(status);
+        graph.AddEdge(op_node, j, retval_node, 0);
+        ++num_retval_nodes;
+      }
+    }
+    FunctionDef fdef;
+    TF_RETURN_IF_ERROR(GraphToFunctionDef(graph, name, &fdef));
+    // Identical definitions added concurrently are accepted.
+    TF_RETURN_IF_ERROR(ctx->AddFunctionDef(fdef));
+  }
+
+  // Runs the function inline on this thread.
+  EagerExecutor executor(/*async=*/false);
+  EagerOperation op(ctx);
+  TF_RETURN_IF_ERROR(op.Reset(name.c_str(), device->name().c_str(),
+                              /*remote=*/false, &executor));
+  for (TensorHandle* arg : args) {
+    TF_RETURN_IF_ERROR(op.AddInput(arg));
+  }
+  std::vector<TensorHandle*> outputs(num_outputs);
+  int num_retvals = num_outputs;
+  TF_RETURN_IF_ERROR(EagerExecute(&op, outputs.data(), &num_retvals));
+  Status status;
+  int k = 0;
+  for (AsyncExecuteNode* node : nodes) {
+    for (int j = 0, num_retvals = node->retvals_.size(); j < num_retvals;
+         ++j, ++k) {
+      const Tensor* tensor = nullptr;
+      if (status.ok()) status = outputs[k]->Tensor(&tensor);
+      if (status.ok()) {
+        const Device* output_device =
+            ctx->CanonicalDevice(node->kernel_->OutputDevice(j));
+        status = node->retvals_[j]->SetTensor(Tensor(*tensor), output_device);
+      }
+      outputs[k]->Unref();
+    }
+  }
+  return status;
+}
+
 }  // namespace tensorflow
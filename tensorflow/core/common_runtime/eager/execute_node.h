@@ -142,7 +142,11 @@ class ExecuteNode : public EagerNode {
   absl::Span<TensorHandle*> retvals_;
 };
 
-class AsyncExecuteNode : public EagerNode {
+// Runs a kernel asynchronously on the executor thread. When the executor fuses
+// nodes, runs of these nodes executing stateless ops locally on the same
+// device are traced into a function, cached by the signature of the sequence
+// of ops, and run in a single call.
+class AsyncExecuteNode : public FusibleEagerNode {
  public:
   AsyncExecuteNode(
       EagerContext* ctx, const absl::InlinedVector<TensorHandle*, 4>& inputs,
@@ -152,7 +156,7 @@ class AsyncExecuteNode : public EagerNode {
       CancellationManager* cancellation_manager,
       absl::Span<TensorHandle*> retvals,
       absl::optional<AbstractStackTrace> stack_trace)
-      : EagerNode(),
+      : FusibleEagerNode(),
         ctx_(ctx),
         inputs_(inputs),
         remote_func_params_(remote_func_params),
@@ -226,7 +230,23 @@ class AsyncExecuteNode : public EagerNode {
     return out;
   }
 
+  FusibleEagerNode* AsFusible() override {
+    if (!fusible_.has_value()) fusible_ = IsFusible();
+    return *fusible_ ? this : nullptr;
+  }
+
+  Status RunFused(absl::Span<FusibleEagerNode* const> nodes,
+                  int* num_done) override;
+
  private:
+  // Whether this node runs an op, not a function, locally, with its inputs
+  // and outputs in the memory of its device, and nothing to collect.
+  bool IsFusible() const;
+  bool IsStateless() const;
+
+  // Runs `nodes`, which run stateless ops on the same device, as a function.
+  static Status RunAsFunction(absl::Span<AsyncExecuteNode* const> nodes);
+
   EagerContext* ctx_;
   absl::InlinedVector<TensorHandle*, 4> inputs_;
   const absl::optional<EagerRemoteFunctionParams> remote_func_params_;
@@ -235,6 +255,7 @@ class AsyncExecuteNode : public EagerNode {
   CancellationManager* const cancellation_manager_;
   absl::optional<AbstractStackTrace> stack_trace_;
   absl::InlinedVector<TensorHandle*, 2> retvals_;
+  absl::optional<bool> fusible_;
 };
 
 }  // namespace tensorflow
@@ -15,14 +15,20 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <stdlib.h>
+
 #include <memory>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/composite_device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/execute.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -138,5 +144,97 @@ TEST(ExecuteNodeTest, ExecuteNodeArgs) {
   ctx->Unref();
 }
 
+// Blocks the executor until notified, so that the nodes queued behind it
+// are run together.
+class BlockingNode : public EagerNode {
+ public:
+  explicit BlockingNode(Notification* unblock) : unblock_(unblock) {}
+
+  Status Run() override {
+    unblock_->WaitForNotification();
+    return Status::OK();
+  }
+
+  void Abort(Status status) override {}
+
+  string DebugString() const override { return "[BlockingNode]"; }
+
+ private:
+  Notification* const unblock_;
+};
+
+// Queues `op_name` on `executor`, with `inputs`, and returns its output.
+TensorHandle* QueueOp(EagerContext* ctx, EagerExecutor* executor,
+                      const char* op_name, const string& device_name,
+                      absl::Span<TensorHandle* const> inputs) {
+  EagerOperation op(ctx);
+  TF_CHECK_OK(op.Reset(op_name, device_name.c_str(), /*remote=*/false,
+                       executor));
+  for (TensorHandle* input : inputs) {
+    TF_CHECK_OK(op.AddInput(input));
+  }
+  TensorHandle* output = nullptr;
+  int num_retvals = 1;
+  TF_CHECK_OK(EagerExecute(&op, &output, &num_retvals));
+  return output;
+}
+
+int NumFusedFunctions(EagerContext* ctx) {
+  int num_fused_functions = 0;
+  for (const string& name : ctx->FuncLibDef()->ListFunctionNames()) {
+    if (absl::StartsWith(name, "__eager_fused_ops_")) ++num_fused_functions;
+  }
+  return num_fused_functions;
+}
+
+TEST(ExecuteNodeTest, FusesAsyncExecuteNodes) {
+  setenv("TF_EAGER_MAX_FUSED_ASYNC_NODES", "8", /*overwrite=*/1);
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  Device* device = device_mgr.ListDevices().at(0);
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      false, &device_mgr, false, nullptr, nullptr);
+
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = 2.0f;
+  TensorHandle* x =
+      TensorHandle::CreateLocalHandle(std::move(t), device, device, ctx);
+
+  for (int i = 0; i < 2; ++i) {
+    EagerExecutor executor(/*async=*/true);
+    Notification unblock;
+    TF_ASSERT_OK(
+        executor.AddOrExecute(absl::make_unique<BlockingNode>(&unblock)));
+    TensorHandle* neg = QueueOp(ctx, &executor, "Neg", device->name(), {x});
+    TensorHandle* neg_neg =
+        QueueOp(ctx, &executor, "Neg", device->name(), {neg});
+    TensorHandle* mul =
+        QueueOp(ctx, &executor, "Mul", device->name(), {neg, neg_neg});
+    unblock.Notify();
+    TF_ASSERT_OK(executor.WaitForAllPendingNodes());
+
+    const Tensor* result = nullptr;
+    TF_ASSERT_OK(neg->Tensor(&result));
+    EXPECT_EQ(result->scalar<float>()(), -2.0f);
+    TF_ASSERT_OK(neg_neg->Tensor(&result));
+    EXPECT_EQ(result->scalar<float>()(), 2.0f);
+    TF_ASSERT_OK(mul->Tensor(&result));
+    EXPECT_EQ(result->scalar<float>()(), -4.0f);
+    // The function is reused for the same sequence of ops.
+    EXPECT_EQ(NumFusedFunctions(ctx), 1);
+
+    neg->Unref();
+    neg_neg->Unref();
+    mul->Unref();
+    TF_ASSERT_OK(executor.ShutDown());
+  }
+
+  x->Unref();
+  ctx->Unref();
+  unsetenv("TF_EAGER_MAX_FUSED_ASYNC_NODES");
+}
+
 }  // namespace
 }  // namespace tensorflow
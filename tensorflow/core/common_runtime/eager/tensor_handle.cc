@@ -740,6 +740,25 @@ Status TensorHandle::RemoteAddress(const Device* d, const bool wait_until_ready,
   return data.OpIdAndOutputNum(wait_until_ready, op_id, output_num);
 }
 
+Status TensorHandle::RemoteCopyStatus(const Device* d) const {
+  if (VariantDeviceIsCustom(device_) || d != absl::get<Device*>(device_)) {
+    tf_shared_lock l(mu_);
+    auto mirror = remote_mirrors_.find(d->name());
+    if (mirror != remote_mirrors_.end()) {
+      return mirror->second.IsPoisoned();
+    }
+
+    return errors::FailedPrecondition(
+        "Could not find remote mirror for specified device");
+  }
+
+  if (Type() != REMOTE) {
+    return errors::InvalidArgument("Primary device is not remote");
+  }
+
+  return absl::get<RemoteTensorHandleData>(data_).IsPoisoned();
+}
+
 bool TensorHandle::HasRemoteMirror(const Device* d,
                                    uint64 context_view_id) const {
   DVLOG(3) << "HasRemoteMirror on TensorHandle: " << this << " device: " << d
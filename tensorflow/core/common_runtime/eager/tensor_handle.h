@@ -192,6 +192,10 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   Status RemoteAddress(const Device* d, const bool wait_until_ready,
                        int64* op_id, int32* output_num) const;
 
+  // Returns the error which poisoned the tensor of this handle on remote
+  // device `d`, or OK if it is ready or still pending. Does not block.
+  Status RemoteCopyStatus(const Device* d) const;
+
   // Called on an async remote tensor once it's shape has been determined. This
   // transitions the tensor handle from a non-ready to a ready state by
   // replacing the backing data abstraction to allow for the shape to be
@@ -246,6 +250,8 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   enum HandleType { LOCAL = 0, PACKED = 1, REMOTE = 2 };
 
   HandleType Type() const;
+  // Whether the tensor or shape of this handle has been set, without blocking.
+  bool IsReady() const;
   string TypeString() const;
 
   string DebugString() const;
@@ -282,7 +288,6 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // Further, it can be in a non-ready state. It would become ready with a call
   // to either SetTensor or SetRemoteShape which replaces the underlying data
   // with a ready version of the tensor handle data.
-  bool IsReady() const;
   Status WaitReady(const char* caller) const;
 
   VariantDevice device_;
@@ -29,7 +29,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/static_memory_plan_allocator.h"
+#include "tensorflow/core/common_runtime/step_capture_cache.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -56,6 +59,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -133,13 +137,64 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+template <class PropagatorStateType>
+class ExecutorState;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  // If `use_work_stealing` is true, expensive ready nodes are queued in
+  // per-worker deques owned by the step (see `WorkStealingReadyQueue`) instead
+  // of being submitted to the inter-op runner one closure at a time.
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool use_work_stealing = false)
+      : immutable_state_(p), use_work_stealing_(use_work_stealing) {}
+
+  ~ExecutorImpl() override;
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    if (use_work_stealing_) {
+      // There is no point in having more workers than nodes in the graph.
+      num_work_stealing_workers_ = std::max(
+          1, std::min(port::MaxParallelism(),
+                      immutable_state_.graph_view().num_nodes()));
+    }
+    const LocalExecutorParams& params = immutable_state_.params();
+    if (params.static_memory_plan_warmup_steps > 0) {
+      Allocator* base = params.device->GetAllocator(AllocatorAttributes());
+      if (base != nullptr) {
+        memory_plan_ = new StaticMemoryPlanAllocator(
+            base, params.static_memory_plan_warmup_steps);
+        memory_plan_device_ = RenamedDevice::NewRenamedDevice(
+            params.device->name(), params.device, false, false, nullptr,
+            memory_plan_);
+      }
+    }
+    if (params.capture_device_graphs && memory_plan_ == nullptr &&
+        params.device->tensorflow_gpu_device_info() != nullptr) {
+      const Status s = StepCaptureCache::CanCapture(graph);
+      if (s.ok()) {
+        capture_cache_ = absl::make_unique<StepCaptureCache>(
+            params.device,
+            [this](const Args& args, Device* kernel_device, DoneCallback done) {
+              RunStep(args, kernel_device, std::move(done));
+            });
+      } else {
+        VLOG(1) << "Not capturing the steps of the graph: " << s;
+      }
+    }
+    if (params.record_op_latency) {
+      const GraphView& gview = immutable_state_.graph_view();
+      op_latency_cells_.resize(gview.num_nodes(), nullptr);
+      for (int32 i = 0; i < gview.num_nodes(); ++i) {
+        const NodeItem* item = gview.node(i);
+        if (item != nullptr && item->kernel != nullptr) {
+          op_latency_cells_[i] = metrics::GetOpLatencyUsecsCell(
+              item->kernel->type_string(), params.device->device_type());
+        }
+      }
+    }
     return Status::OK();
   }
 
@@ -149,6 +204,33 @@ class ExecutorImpl : public Executor {
   template <class PropagatorStateType>
   friend class ExecutorState;
 
+  // Runs a step whose kernels run on `kernel_device`, or on `kernel_device()`
+  // if it is null.
+  void RunStep(const Args& args, Device* kernel_device, DoneCallback done);
+
+  // Returns the device that the kernels of a step run on by default.
+  Device* kernel_device() const {
+    return memory_plan_device_ != nullptr ? memory_plan_device_.get()
+                                          : immutable_state_.params().device;
+  }
+
+  // The maximum number of idle states kept in `state_pool_`.
+  static constexpr int kMaxPooledStates = 8;
+
+  // Takes ownership of a state whose step has finished successfully, so that
+  // it can be reused by a later step. Returns false if the caller must delete
+  // the state instead. Only states of graphs without control flow are pooled,
+  // because `PropagatorState` allocates its frames per step anyway.
+  bool RecycleState(ExecutorState<SimplePropagatorState>* state);
+  bool RecycleState(ExecutorState<PropagatorState>* state) { return false; }
+
+  // Returns the cell of the latency histogram of the op type of `item`, or
+  // null if the executor does not record op latencies.
+  monitoring::SamplerCell* OpLatencyCell(const NodeItem& item) const {
+    return op_latency_cells_.empty() ? nullptr
+                                     : op_latency_cells_[item.node_id];
+  }
+
   // Stores execution time information about the kernels in an executor's graph.
   class KernelStats {
    public:
@@ -214,6 +296,32 @@ class ExecutorImpl : public Executor {
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  const bool use_work_stealing_;
+  // Zero unless `use_work_stealing_` is true.
+  int num_work_stealing_workers_ = 0;
+
+  // Non-null iff `params.static_memory_plan_warmup_steps` is positive. Kernels
+  // run on `memory_plan_device_`, which forwards everything to
+  // `params.device` except for default allocations, which go to
+  // `memory_plan_`.
+  StaticMemoryPlanAllocator* memory_plan_ = nullptr;
+  std::unique_ptr<Device> memory_plan_device_;
+
+  // Idle states that are reset and reused by new steps, which saves
+  // constructing the per-step state (and its propagator buffers) for every
+  // step of a small graph.
+  mutex state_pool_mu_;
+  std::vector<ExecutorState<SimplePropagatorState>*> state_pool_
+      TF_GUARDED_BY(state_pool_mu_);
+
+  // The latency histogram cell of each node, indexed by node id, looked up
+  // once so that recording a latency does not look up the labels. Empty
+  // unless `params.record_op_latency`.
+  std::vector<monitoring::SamplerCell*> op_latency_cells_;
+
+  // Non-null iff `params.capture_device_graphs` is true and the steps of the
+  // graph can be captured. Steps run through it.
+  std::unique_ptr<StepCaptureCache> capture_cache_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -270,11 +378,22 @@ class ExecutorImpl : public Executor {
 template <class PropagatorStateType>
 class ExecutorState {
  public:
+  // If `num_work_stealing_workers` is positive, expensive ready nodes are
+  // dispatched through a `WorkStealingReadyQueue` with that many workers.
+  // Kernels run on `kernel_device`. If `memory_plan` is not null, the plan is
+  // notified when the step finishes.
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                int num_work_stealing_workers,
+                StaticMemoryPlanAllocator* memory_plan, Device* kernel_device,
+                ExecutorImpl* executor);
   ~ExecutorState();
 
+  // Prepares a state taken from `ExecutorImpl::state_pool_` for a new step.
+  // The previous step of the state must have finished successfully.
+  void Reset(const Executor::Args& args);
+
   void RunAsync(Executor::DoneCallback done);
 
  private:
@@ -330,18 +449,31 @@ class ExecutorState {
   template <typename Closure>
   void RunTask(Closure&& c);
 
+  // Arranges for `tagged_node` to be processed on another thread, either by
+  // submitting a closure to `runner_` or, in work-stealing mode, by pushing it
+  // onto `work_queue_` and starting a new worker if needed.
+  void ScheduleOnOtherThread(const TaggedNode& tagged_node,
+                             int64 scheduled_nsec);
+
   // Clean up when this executor is done.
   void Finish();
   void ScheduleFinish();
 
+  // Initializes the members that depend on the step's `args`.
+  void InitializeStep(const Executor::Args& args);
+
+  // Returns this state to `executor_` for reuse if `step_ok`, and deletes it
+  // otherwise. The state must not be accessed afterwards.
+  void Release(bool step_ok);
+
   // Contains the device context assigned by the device at the beginning of a
   // step.
   DeviceContext* device_context_ = nullptr;
 
-  const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
+  bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
 
   // true if LogMemory::IsEnabled(). Used to check memory enabled cheaply.
-  const bool log_memory_;
+  bool log_memory_;
 
   int64 step_id_;
   // Not owned.
@@ -353,8 +485,8 @@ class ExecutorState {
   TensorStore* tensor_store_;
   // Step-local container.
   ScopedStepContainer* step_container_;
-  StepStatsCollectorInterface* const stats_collector_;
-  const tracing::EventCollector* const event_collector_;
+  StepStatsCollectorInterface* stats_collector_;
+  const tracing::EventCollector* event_collector_;
   Context context_;
 
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
@@ -363,12 +495,32 @@ class ExecutorState {
   CallFrameInterface* call_frame_;
   const ImmutableExecutorState& immutable_state_;
   ExecutorImpl::KernelStats* const kernel_stats_;
+  // Not owned. The executor that created this state.
+  ExecutorImpl* const executor_;
   CancellationManager* cancellation_manager_;
+  // Not owned. Null unless the executor uses a static memory plan.
+  StaticMemoryPlanAllocator* const memory_plan_;
+  // The device that kernels run on: `immutable_state_.params().device`, or a
+  // wrapper of it that allocates from `memory_plan_` or from the buffers of a
+  // captured step.
+  Device* const kernel_device_;
   // If not null, use this device to schedule intra-op operation
   std::unique_ptr<DeviceBase> user_device_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
-  const bool run_all_kernels_inline_;
+  bool run_all_kernels_inline_;
+
+  // A ready node waiting in `work_queue_`.
+  struct ReadyItem {
+    TaggedNode tagged_node;
+    int64 scheduled_nsec;
+  };
+  typedef WorkStealingReadyQueue<ReadyItem> WorkQueue;
+  const int num_work_stealing_workers_;
+  // Non-null iff work-stealing mode is enabled. Shared with the workers,
+  // because a worker may still be retiring after this state has been deleted
+  // or reused, so every step gets a new queue.
+  std::shared_ptr<WorkQueue> work_queue_;
 
   PropagatorStateType propagator_;
 
@@ -390,36 +542,85 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
-    : vlog_(VLOG_IS_ON(1)),
-      log_memory_(LogMemory::IsEnabled()),
-      step_id_(args.step_id),
-      rendezvous_(args.rendezvous),
-      collective_executor_(args.collective_executor),
-      session_state_(args.session_state),
-      session_handle_(args.session_handle),
-      session_metadata_(immutable_state.params().session_metadata),
-      tensor_store_(args.tensor_store),
-      step_container_(args.step_container),
-      stats_collector_(args.stats_collector),
-      event_collector_(
-          tracing::GetEventCollector(tracing::EventCategory::kCompute)),
-      context_(ContextKind::kThread),
-      slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
-      call_frame_(args.call_frame),
+    ExecutorImpl::KernelStats* kernel_stats, int num_work_stealing_workers,
+    StaticMemoryPlanAllocator* memory_plan, Device* kernel_device,
+    ExecutorImpl* executor)
+    : session_metadata_(immutable_state.params().session_metadata),
+      slice_reader_cache_(nullptr),
       immutable_state_(immutable_state),
       kernel_stats_(kernel_stats),
-      cancellation_manager_(args.cancellation_manager),
-      runner_(args.runner),
-      sync_on_finish_(args.sync_on_finish),
-      run_all_kernels_inline_(args.run_all_kernels_inline),
-      propagator_(immutable_state, step_id_, vlog_),
+      executor_(executor),
+      memory_plan_(memory_plan),
+      kernel_device_(kernel_device),
+      num_work_stealing_workers_(num_work_stealing_workers),
+      propagator_(immutable_state, args.step_id, VLOG_IS_ON(1)),
       num_outstanding_ops_(0) {
+  InitializeStep(args);
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::InitializeStep(
+    const Executor::Args& args) {
+  vlog_ = VLOG_IS_ON(1);
+  log_memory_ = LogMemory::IsEnabled();
+  step_id_ = args.step_id;
+  rendezvous_ = args.rendezvous;
+  collective_executor_ = args.collective_executor;
+  session_state_ = args.session_state;
+  session_handle_ = args.session_handle;
+  tensor_store_ = args.tensor_store;
+  step_container_ = args.step_container;
+  stats_collector_ = args.stats_collector;
+  event_collector_ =
+      tracing::GetEventCollector(tracing::EventCategory::kCompute);
+  context_ = Context(ContextKind::kThread);
+  slice_reader_cache_ = new checkpoint::TensorSliceReaderCacheWrapper;
+  call_frame_ = args.call_frame;
+  cancellation_manager_ = args.cancellation_manager;
+  runner_ = args.runner;
+  sync_on_finish_ = args.sync_on_finish;
+  run_all_kernels_inline_ = args.run_all_kernels_inline;
+  if (num_work_stealing_workers_ > 0) {
+    work_queue_ = std::make_shared<WorkQueue>(num_work_stealing_workers_);
+  }
   if (args.user_intra_op_threadpool != nullptr) {
-    Device* device = immutable_state_.params().device;
     user_device_ = RenamedDevice::NewRenamedDevice(
-        device->name(), device, false, false, args.user_intra_op_threadpool);
+        kernel_device_->name(), kernel_device_, false, false,
+        args.user_intra_op_threadpool);
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::Reset(const Executor::Args& args) {
+  if (device_context_) {
+    device_context_->Unref();
+    device_context_ = nullptr;
+  }
+  delete slice_reader_cache_;
+  user_device_.reset();
+  work_queue_.reset();
+  DCHECK(done_cb_ == nullptr);
+  DCHECK_EQ(num_outstanding_ops_, 0);
+  DCHECK(status_.ok());
+  {
+    mutex_lock l(num_deferred_ops_mu_);
+    DCHECK_EQ(num_deferred_ops_, 0);
+    finish_when_deferred_ops_done_ = false;
+  }
+  propagator_.Reset(args.step_id);
+  InitializeStep(args);
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::Release(bool step_ok) {
+  // A failed step may leave tensors behind in the propagator, and states that
+  // log verbosely track extra per-step information, so neither is reused. Nor
+  // are the states of captured steps, which run on another device.
+  if (step_ok && !vlog_ && kernel_device_ == executor_->kernel_device() &&
+      executor_->RecycleState(this)) {
+    return;
   }
+  delete this;
 }
 
 template <class PropagatorStateType>
@@ -454,6 +655,27 @@ void ExecutorState<PropagatorStateType>::RunTask(Closure&& c) {
   });
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleOnOtherThread(
+    const TaggedNode& tagged_node, int64 scheduled_nsec) {
+  if (!work_queue_) {
+    RunTask([=]() { Process(tagged_node, scheduled_nsec); });
+    return;
+  }
+  if (work_queue_->Push({tagged_node, scheduled_nsec})) {
+    // NOTE: The worker only dereferences `this` while it holds an item, and
+    // every queued item is counted in `num_outstanding_ops_`, so `this` cannot
+    // have been deleted at that point. Retiring only touches `queue`.
+    RunTask([this, queue = work_queue_]() {
+      typename WorkQueue::WorkerScope scope(queue.get());
+      ReadyItem item;
+      while (queue->PopOrRetire(scope.worker_id(), &item)) {
+        Process(item.tagged_node, item.scheduled_nsec);
+      }
+    });
+  }
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   TaggedNodeSeq ready;
@@ -463,7 +685,7 @@ void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   const Status get_context_status =
       device->TryGetDeviceContext(&device_context_);
   if (!get_context_status.ok()) {
-    delete this;
+    Release(/*step_ok=*/false);
     done(get_context_status);
     return;
   }
@@ -473,7 +695,7 @@ void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   propagator_.ActivateRoots(immutable_state_.root_nodes(), &ready);
   num_outstanding_ops_ = ready.size();
   if (ready.empty()) {
-    delete this;
+    Release(/*step_ok=*/true);
     done(Status::OK());
   } else {
     done_cb_ = std::move(done);
@@ -514,6 +736,8 @@ struct ExecutorState<PropagatorStateType>::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsInterface* stats;
+  // The time at which the kernel started, if its latency is recorded.
+  uint64 start_time_ns = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -556,6 +780,9 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
   OpKernel* op_kernel = item.kernel;
   Device* device = immutable_state_.params().device;
   const bool is_expensive = kernel_stats_->IsExpensive(item);
+  monitoring::SamplerCell* latency_cell = executor_->OpLatencyCell(item);
+  const uint64 start_time_ns =
+      latency_cell != nullptr ? EnvTime::NowNanos() : 0;
 
   if (TF_PREDICT_FALSE(MightTrace(event_collector_, is_expensive))) {
     tracing::ScopedRegion region(tracing::EventCategory::kCompute,
@@ -577,6 +804,10 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
       device->Compute(op_kernel, &ctx);
     }
   }
+  if (latency_cell != nullptr) {
+    latency_cell->Add((EnvTime::NowNanos() - start_time_ns) /
+                      static_cast<double>(EnvTime::kMicrosToNanos));
+  }
   nodestats::SetOpEnd(stats);
   if (outputs->size() < item.num_outputs) outputs->resize(item.num_outputs);
   s = ProcessOutputs(item, &ctx, outputs->data(), stats);
@@ -599,6 +830,12 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
     NodeExecStatsInterface* stats = state->stats;  // Shorthand
     Entry* first_input = state->first_input;       // Shorthand
 
+    monitoring::SamplerCell* latency_cell =
+        executor_->OpLatencyCell(*state->item);
+    if (latency_cell != nullptr) {
+      latency_cell->Add((EnvTime::NowNanos() - state->start_time_ns) /
+                        static_cast<double>(EnvTime::kMicrosToNanos));
+    }
     nodestats::SetOpEnd(stats);
     EntryVector outputs(state->item->num_outputs);
     Status s = ProcessOutputs(*state->item, &state->ctx, outputs.data(), stats);
@@ -626,6 +863,9 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
     if (completed) ScheduleFinish();
   };
   nodestats::SetOpStart(stats);
+  if (executor_->OpLatencyCell(item) != nullptr) {
+    state->start_time_ns = EnvTime::NowNanos();
+  }
   {
     profiler::AnnotatedTraceMe activity(
         [async_kernel, state] {
@@ -688,7 +928,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   if (user_device_) {
     params.device = user_device_.get();
   } else {
-    params.device = device;
+    params.device = kernel_device_;
   }
   params.log_memory = log_memory_;
   params.rendezvous = rendezvous_;
@@ -735,6 +975,10 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
   EntryVector outputs(1);
 
+  const string& function_name = immutable_state_.params().function_name;
+  ScopedMemoryDebugFunctionAnnotation function_annotation(
+      function_name.empty() ? nullptr : function_name.c_str());
+
   bool completed = false;
   inline_ready.push_back(tagged_node);
   while (!inline_ready.empty()) {
@@ -743,6 +987,11 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
     const NodeItem& item = tagged_node.get_node_item();
     const int id = item.node_id;
 
+    // Use the context the device assigned to this node, if any.
+    DeviceContext* node_context = immutable_state_.device_context(id);
+    params.op_device_context =
+        node_context != nullptr ? node_context : device_context_;
+
     propagator_.MaybeMarkStarted(tagged_node);
 
     params.track_allocations = false;
@@ -1164,7 +1413,7 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     if (inline_ready == nullptr) {
       // Schedule to run all the ready ops in thread pool.
       for (auto& tagged_node : *ready) {
-        RunTask([=]() { Process(tagged_node, scheduled_nsec); });
+        ScheduleOnOtherThread(tagged_node, scheduled_nsec);
       }
     } else {
       for (auto& tagged_node : *ready) {
@@ -1176,8 +1425,7 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
           if (curr_expensive_node) {
             // Dispatch to another thread since there is plenty of work to
             // do for this thread.
-            RunTask(std::bind(&ExecutorState::Process, this,
-                              *curr_expensive_node, scheduled_nsec));
+            ScheduleOnOtherThread(*curr_expensive_node, scheduled_nsec);
           }
           curr_expensive_node = &tagged_node;
         }
@@ -1189,8 +1437,7 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
       } else {
         // There are inline nodes to run already. We dispatch this expensive
         // node to other thread.
-        RunTask(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_nsec));
+        ScheduleOnOtherThread(*curr_expensive_node, scheduled_nsec);
       }
     }
   }
@@ -1227,6 +1474,10 @@ void ExecutorState<PropagatorStateType>::Finish() {
   int64 step_id = step_id_;
   CHECK(done_cb != nullptr);
   Device* device = immutable_state_.params().device;
+  if (memory_plan_ != nullptr) {
+    // Must happen before `done_cb`, after which the executor may be deleted.
+    memory_plan_->StepDone(status.ok());
+  }
 
   if (vlog_ && !status.ok() && VLOG_IS_ON(1)) {
     // Logs verbose information about the current state of active and pending
@@ -1278,7 +1529,7 @@ void ExecutorState<PropagatorStateType>::Finish() {
         collective_executor_->StartAbort(status);
       }
     }
-    delete this;
+    Release(status.ok());
     runner([step_id, status, done_cb = std::move(done_cb)]() {
       profiler::TraceMeConsumer activity(
           // From TraceMeProducer in KernelAndDeviceFunc::RunAsync,
@@ -1301,7 +1552,7 @@ void ExecutorState<PropagatorStateType>::Finish() {
     // the user until the step (and its side-effects) has actually completed.
     device->Sync([this, step_id, runner = std::move(runner),
                   done_cb = std::move(done_cb)](const Status& status) mutable {
-      delete this;
+      Release(status.ok());
       runner([step_id, status, done_cb = std::move(done_cb)]() {
         profiler::TraceMeConsumer activity(
             // From TraceMeProducer in KernelAndDeviceFunc::RunAsync,
@@ -1316,7 +1567,7 @@ void ExecutorState<PropagatorStateType>::Finish() {
       });
     });
   } else {
-    delete this;
+    Release(status.ok());
     runner([step_id, status, done_cb = std::move(done_cb)]() {
       profiler::TraceMeConsumer activity(
           // From TraceMeProducer in KernelAndDeviceFunc::RunAsync,
@@ -1332,15 +1583,60 @@ void ExecutorState<PropagatorStateType>::Finish() {
   }
 }
 
+ExecutorImpl::~ExecutorImpl() {
+  for (ExecutorState<SimplePropagatorState>* state : state_pool_) {
+    delete state;
+  }
+  if (memory_plan_ != nullptr) {
+    memory_plan_device_.reset();
+    // Tensors allocated from the plan may still be alive, e.g. fetched
+    // outputs, so the allocator deletes itself once they are freed.
+    memory_plan_->Release();
+  }
+}
+
+bool ExecutorImpl::RecycleState(ExecutorState<SimplePropagatorState>* state) {
+  mutex_lock l(state_pool_mu_);
+  if (state_pool_.size() >= kMaxPooledStates) return false;
+  state_pool_.push_back(state);
+  return true;
+}
+
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  if (capture_cache_ != nullptr) {
+    capture_cache_->RunAsync(args, std::move(done));
+  } else {
+    RunStep(args, nullptr, std::move(done));
+  }
+}
+
+void ExecutorImpl::RunStep(const Args& args, Device* kernel_device,
+                           DoneCallback done) {
+  const bool pooled = kernel_device == nullptr;
+  if (pooled) kernel_device = this->kernel_device();
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(
+         args, immutable_state_, &kernel_stats_, num_work_stealing_workers_,
+         memory_plan_, kernel_device, this))
         ->RunAsync(std::move(done));
+    return;
+  }
+  ExecutorState<SimplePropagatorState>* state = nullptr;
+  if (pooled) {
+    mutex_lock l(state_pool_mu_);
+    if (!state_pool_.empty()) {
+      state = state_pool_.back();
+      state_pool_.pop_back();
+    }
+  }
+  if (state != nullptr) {
+    state->Reset(args);
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
-        ->RunAsync(std::move(done));
+    state = new ExecutorState<SimplePropagatorState>(
+        args, immutable_state_, &kernel_stats_, num_work_stealing_workers_,
+        memory_plan_, kernel_device, this);
   }
+  state->RunAsync(std::move(done));
 }
 
 }  // namespace
@@ -1392,6 +1688,30 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING" executor, which behaves like the default
+// executor but dispatches expensive ready nodes through per-step work-stealing
+// deques rather than through the shared inter-op thread pool queue. Select it
+// with `ConfigProto.experimental.executor_type = "WORK_STEALING"`.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl =
+          absl::make_unique<ExecutorImpl>(params, /*use_work_stealing=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
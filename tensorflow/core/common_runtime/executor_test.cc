@@ -25,10 +25,14 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/immutable_executor_state.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/propagator_state.h"
+#include "tensorflow/core/common_runtime/simple_propagator_state.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -37,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -82,7 +87,13 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type_.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> exec;
+      TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &exec));
+      exec_ = exec.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -101,6 +112,8 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  // If non-empty, `Create()` uses the executor registered under this name.
+  string executor_type_;
 };
 
 // A float val -> Tensor<float>
@@ -205,6 +218,63 @@ TEST_F(ExecutorTest, SelfAdd) {
   EXPECT_EQ(1024.0, V(out));  // b=v10=2*v9=4*v8=...=1024*a=1024.0
 }
 
+// Runs the same executor for many steps, sequentially and concurrently, so
+// that steps reuse the pooled per-step states, including after a failed step.
+TEST_F(ExecutorTest, RepeatedRunsReuseStates) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                               V(1.0 * i), false));
+    TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args,
+                               V(2.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(1.0 * i + 2.0, V(out));
+  }
+
+  // A failed step is not reused, and does not affect later steps.
+  {
+    Rendezvous* aborted = NewLocalRendezvous();
+    aborted->StartAbort(errors::Aborted("Testing aborted step"));
+    EXPECT_TRUE(errors::IsAborted(Run(aborted)));
+    aborted->Unref();
+  }
+
+  // Run the concurrent steps from their own threads, since `Run()` blocks and
+  // the executor schedules its nodes onto `thread_pool_`.
+  const int kNumConcurrentSteps = 16;
+  thread::ThreadPool callers(Env::Default(), "callers", kNumConcurrentSteps);
+  BlockingCounter done(kNumConcurrentSteps);
+  for (int i = 0; i < kNumConcurrentSteps; ++i) {
+    callers.Schedule([this, i, &done]() {
+      Rendezvous* rendez = NewLocalRendezvous();
+      Rendezvous::Args args;
+      TF_CHECK_OK(rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                               V(1.0 * i), false));
+      TF_CHECK_OK(rendez->Send(Key(ALICE, kIncarnation, BOB, "b"), args,
+                               V(1.0 * i), false));
+      TF_CHECK_OK(Run(rendez));
+      Tensor out = V(-1);
+      bool is_dead = false;
+      TF_CHECK_OK(rendez->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out,
+                               &is_dead));
+      EXPECT_EQ(2.0 * i, V(out));
+      rendez->Unref();
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+}
+
 // Builds a graph which adds N copies of one variable "in". I.e.,
 //     a + a + a + ... + a
 // The returned graph is parenthesized ramdonly. I.e.,
@@ -255,6 +325,26 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  executor_type_ = "WORK_STEALING";
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -290,6 +380,24 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  executor_type_ = "WORK_STEALING";
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -433,7 +541,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void BM_executor_with_type(int iters, int width, int depth,
+                                  const char* executor_type) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -472,7 +581,16 @@ static void BM_executor(int iters, int width, int depth) {
 #endif  // PLATFORM_GOOGLE
   FixupSourceAndSinkEdges(g);
   testing::StartTiming();
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  BM_executor_with_type(iters, width, depth, "");
+}
+
+static void BM_executor_work_stealing(int iters, int width, int depth) {
+  BM_executor_with_type(iters, width, depth, "WORK_STEALING");
 }
 
 // Tall skinny graphs
@@ -486,6 +604,10 @@ BENCHMARK(BM_executor)->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
 
+BENCHMARK(BM_executor_work_stealing)->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 1024);
+
 static void BM_const_identity(int iters, int width, int outputs_per_const) {
 #ifdef PLATFORM_GOOGL
   BenchmarkUseRealTime();
@@ -514,6 +636,93 @@ BENCHMARK(BM_const_identity)->ArgPair(1, 100);
 BENCHMARK(BM_const_identity)->ArgPair(100, 1);
 BENCHMARK(BM_const_identity)->ArgPair(100, 100);
 
+// Measures the cost per node of propagating outputs, without running kernels
+// or scheduling closures, through a graph with no control flow. Such graphs
+// are run with `SimplePropagatorState`, but `PropagatorState` can run them
+// too, which gives a baseline. The graph has `depth` layers of `width`
+// Identity nodes, where each node has a single data input from the previous
+// layer, and a NoOp per layer that waits on the whole layer.
+template <class PropagatorStateType>
+static void BM_PropagatorHelper(int iters, int width, int depth) {
+  testing::StopTiming();
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  std::vector<Node*> layer;
+  for (int i = 0; i < width; ++i) {
+    layer.push_back(test::graph::Constant(g.get(), V(1.0)));
+  }
+  for (int d = 0; d < depth; ++d) {
+    for (Node*& n : layer) n = test::graph::Identity(g.get(), n);
+    test::graph::NoOp(g.get(), layer);
+  }
+  FixupSourceAndSinkEdges(g.get());
+  const int64 num_nodes = g->num_nodes();
+
+  std::unique_ptr<Device> device =
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0");
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel =
+      [&device, version](const std::shared_ptr<const NodeProperties>& props,
+                         OpKernel** kernel) {
+        return CreateNonCachedKernel(device.get(), nullptr, props, version,
+                                     kernel);
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  ImmutableExecutorState immutable_state(params);
+  TF_CHECK_OK(immutable_state.Initialize(*g));
+
+  typename PropagatorStateType::TaggedNodeSeq ready;
+  EntryVector outputs;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    PropagatorStateType propagator(immutable_state, i, /*vlog=*/false);
+    typename PropagatorStateType::TaggedNodeReadyQueue queue;
+    propagator.ActivateRoots(immutable_state.root_nodes(), &ready);
+    int64 num_propagated = 0;
+    while (true) {
+      for (const auto& tagged_node : ready) queue.push_back(tagged_node);
+      ready.clear();
+      if (queue.empty()) break;
+      const auto tagged_node = queue.front();
+      queue.pop_front();
+      // Forward the first input, if any, to every output, as Identity would.
+      const NodeItem& item = tagged_node.get_node_item();
+      outputs.clear();
+      outputs.resize(item.num_outputs);
+      if (item.num_inputs > 0 && item.num_outputs > 0) {
+        outputs[0] = std::move(propagator.GetInputTensors(tagged_node)[0]);
+      }
+      propagator.PropagateOutputs(tagged_node, &outputs, &ready);
+      ++num_propagated;
+    }
+    CHECK_EQ(num_propagated, num_nodes);
+  }
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(strings::StrCat("Nodes = ", num_nodes));
+  SetBenchmarkItemsProcessed(num_nodes * static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+}
+
+static void BM_PropagatorState(int iters, int width, int depth) {
+  BM_PropagatorHelper<PropagatorState>(iters, width, depth);
+}
+
+static void BM_SimplePropagatorState(int iters, int width, int depth) {
+  BM_PropagatorHelper<SimplePropagatorState>(iters, width, depth);
+}
+
+BENCHMARK(BM_PropagatorState)->ArgPair(16, 1024);
+BENCHMARK(BM_PropagatorState)->ArgPair(1024, 16);
+BENCHMARK(BM_PropagatorState)->ArgPair(1024, 200);
+
+BENCHMARK(BM_SimplePropagatorState)->ArgPair(16, 1024);
+BENCHMARK(BM_SimplePropagatorState)->ArgPair(1024, 16);
+BENCHMARK(BM_SimplePropagatorState)->ArgPair(1024, 200);
+
 static void BM_FeedInputFetchOutput(int iters) {
   testing::StopTiming();
   Graph* g = new Graph(OpRegistry::Global());
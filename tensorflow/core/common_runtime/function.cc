@@ -943,6 +943,7 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
     DeleteNonCachedKernel(kernel);
   };
   params.session_metadata = session_metadata_;
+  params.function_name = fbody->fdef.signature().name();
   std::unique_ptr<Executor> exec;
   TF_RETURN_IF_ERROR(NewExecutor(executor_type, params, *g, &exec));
   {
@@ -0,0 +1,200 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 11020
+#define TF_CUDA_MALLOC_ASYNC_SUPPORTED 1
+#endif
+
+/*static*/ bool GpuCudaMallocAsyncAllocator::IsSupported(
+    PlatformGpuId platform_gpu_id) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  int driver_version = 0;
+  if (cuDriverGetVersion(&driver_version) != CUDA_SUCCESS ||
+      driver_version < 11020) {
+    return false;
+  }
+  int supported = 0;
+  CUresult res = cuDeviceGetAttribute(
+      &supported, CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED,
+      platform_gpu_id.value());
+  return res == CUDA_SUCCESS && supported != 0;
+#else
+  return false;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
+    PlatformGpuId platform_gpu_id, size_t pool_size, size_t release_threshold,
+    const string& name)
+    : name_(name) {
+  stream_exec_ =
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie();
+  stats_.bytes_limit = static_cast<int64>(pool_size);
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUmemPoolProps props = {};
+  props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+  props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  props.location.id = platform_gpu_id.value();
+  CUmemoryPool pool;
+  CUresult res = cuMemPoolCreate(&pool, &props);
+  if (res != CUDA_SUCCESS) {
+    LOG(FATAL) << "cuMemPoolCreate failed for GPU " << platform_gpu_id.value()
+               << ": " << res;
+  }
+  pool_ = pool;
+  cuuint64_t threshold = release_threshold;
+  res = cuMemPoolSetAttribute(pool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD,
+                              &threshold);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "Failed to set the release threshold of the memory pool of "
+               << name_ << ": " << res;
+  }
+  VLOG(1) << name_ << " pool size: " << pool_size
+          << ", release threshold: " << release_threshold;
+#else
+  LOG(FATAL) << "GpuCudaMallocAsyncAllocator requires CUDA 11.2 or later.";
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  if (pool_ == nullptr) return;
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  // The pool may only be destroyed once the frees queued on the stream ran.
+  if (stream_ != nullptr) {
+    cuStreamSynchronize(static_cast<CUstream>(stream_));
+  }
+  CUresult res = cuMemPoolDestroy(static_cast<CUmemoryPool>(pool_));
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemPoolDestroy failed for " << name_ << ": " << res;
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GpuCudaMallocAsyncAllocator::SetStream(void* stream) {
+  mutex_lock l(mu_);
+  stream_ = stream;
+}
+
+void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
+                                               size_t num_bytes) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  // The pool hands out blocks aligned to at least 256 bytes, which satisfies
+  // every alignment TensorFlow asks for.
+  DCHECK_LE(alignment, 256);
+  mutex_lock l(mu_);
+  if (stats_.bytes_in_use + static_cast<int64>(num_bytes) >
+      *stats_.bytes_limit) {
+    LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+                 << num_bytes << " bytes with " << stats_.bytes_in_use
+                 << " of " << *stats_.bytes_limit << " bytes in use.";
+    return nullptr;
+  }
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUdeviceptr ptr = 0;
+  CUresult res =
+      cuMemAllocFromPoolAsync(&ptr, num_bytes, static_cast<CUmemoryPool>(pool_),
+                              static_cast<CUstream>(stream_));
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemAllocFromPoolAsync failed to allocate " << num_bytes
+               << " bytes: " << res;
+    return nullptr;
+  }
+  void* rv = reinterpret_cast<void*>(ptr);
+  sizes_[rv] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += num_bytes;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, num_bytes);
+  return rv;
+#else
+  return nullptr;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GpuCudaMallocAsyncAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  mutex_lock l(mu_);
+  auto it = sizes_.find(ptr);
+  if (it == sizes_.end()) {
+    LOG(ERROR) << name_ << " asked to free unknown pointer " << ptr;
+    return;
+  }
+  stats_.bytes_in_use -= it->second;
+  sizes_.erase(it);
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUresult res = cuMemFreeAsync(reinterpret_cast<CUdeviceptr>(ptr),
+                                static_cast<CUstream>(stream_));
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemFreeAsync failed to free " << ptr << ": " << res;
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+size_t GpuCudaMallocAsyncAllocator::RequestedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = sizes_.find(ptr);
+  CHECK(it != sizes_.end()) << name_ << " does not own " << ptr;
+  return it->second;
+}
+
+absl::optional<AllocatorStats> GpuCudaMallocAsyncAllocator::GetStats() {
+  mutex_lock l(mu_);
+  AllocatorStats stats = stats_;
+#if defined(TF_CUDA_MALLOC_ASYNC_SUPPORTED) && CUDA_VERSION >= 11030
+  // The memory the pool holds from the driver, including the freed memory it
+  // keeps below the release threshold. CUDA 11.3 added these attributes.
+  cuuint64_t reserved = 0;
+  if (cuMemPoolGetAttribute(static_cast<CUmemoryPool>(pool_),
+                            CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                            &reserved) == CUDA_SUCCESS) {
+    stats.bytes_reserved = reserved;
+  }
+  cuuint64_t peak_reserved = 0;
+  if (cuMemPoolGetAttribute(static_cast<CUmemoryPool>(pool_),
+                            CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH,
+                            &peak_reserved) == CUDA_SUCCESS) {
+    stats.peak_bytes_reserved = peak_reserved;
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  return stats;
+}
+
+void GpuCudaMallocAsyncAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,92 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator backed by a CUDA stream-ordered memory pool
+// (cuMemAllocFromPoolAsync / cuMemFreeAsync, CUDA 11.2 and later).
+//
+// Unlike GPUBFCAllocator, which carves allocations out of memory it reserved
+// from the driver and never gives back, the driver manages the pool: memory
+// freed to the pool is kept for reuse up to `release_threshold` bytes, and
+// the rest is returned to the system the next time the stream synchronizes,
+// so that other processes sharing the GPU can use it.
+//
+// Allocations and frees are ordered on the stream set with SetStream(),
+// which must be the stream that the kernels using the memory run on, like
+// the memory of GPUBFCAllocator. Before a stream is set, they are ordered on
+// the legacy default stream, which synchronizes with every other stream.
+// Since both call into the driver, they must not be called from a stream
+// callback.
+//
+// Allocations beyond `pool_size` bytes in use fail. The allocator keeps the
+// size of every allocation to maintain the AllocatorStats.
+class GpuCudaMallocAsyncAllocator : public Allocator {
+ public:
+  // Returns true if the driver and the device `platform_gpu_id` support
+  // stream-ordered memory pools.
+  static bool IsSupported(PlatformGpuId platform_gpu_id);
+
+  GpuCudaMallocAsyncAllocator(PlatformGpuId platform_gpu_id, size_t pool_size,
+                              size_t release_threshold, const string& name);
+  ~GpuCudaMallocAsyncAllocator() override;
+
+  string Name() override { return name_; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override { return true; }
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override {
+    return RequestedSize(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Orders the allocations and frees after the work queued on `stream`, a
+  // CUstream.
+  void SetStream(void* stream);
+
+ private:
+  se::StreamExecutor* stream_exec_;  // Not owned.
+  // A CUmemoryPool and a CUstream, kept opaque so that this header does not
+  // depend on cuda.h.
+  void* pool_ = nullptr;
+  void* stream_ = nullptr;
+  const string name_;
+
+  mutable mutex mu_;
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<const void*, size_t> sizes_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuCudaMallocAsyncAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
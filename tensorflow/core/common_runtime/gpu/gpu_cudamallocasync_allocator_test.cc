@@ -0,0 +1,155 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+// The benchmarks mirror those of gpu_bfc_allocator_test.cc, so that the two
+// allocators can be compared on the same allocation patterns.
+
+namespace tensorflow {
+namespace {
+
+class GpuCudaMallocAsyncAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!GpuCudaMallocAsyncAllocator::IsSupported(PlatformGpuId(0))) {
+      GTEST_SKIP() << "Stream-ordered memory pools are not supported.";
+    }
+  }
+};
+
+TEST_F(GpuCudaMallocAsyncAllocatorTest, Stats) {
+  GpuCudaMallocAsyncAllocator a(PlatformGpuId(0), 1 << 30, 0,
+                                "GPU_0_cuda_malloc_async");
+  void* p1 = a.AllocateRaw(256, 1024);
+  void* p2 = a.AllocateRaw(256, 4096);
+  ASSERT_NE(p1, nullptr);
+  ASSERT_NE(p2, nullptr);
+  EXPECT_EQ(a.RequestedSize(p1), 1024);
+  EXPECT_EQ(a.AllocatedSize(p2), 4096);
+
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_allocs, 2);
+  EXPECT_EQ(stats->bytes_in_use, 5120);
+  EXPECT_EQ(stats->peak_bytes_in_use, 5120);
+  EXPECT_EQ(stats->largest_alloc_size, 4096);
+  EXPECT_EQ(*stats->bytes_limit, 1 << 30);
+
+  a.DeallocateRaw(p2);
+  stats = a.GetStats();
+  EXPECT_EQ(stats->bytes_in_use, 1024);
+  EXPECT_EQ(stats->peak_bytes_in_use, 5120);
+
+  a.ClearStats();
+  stats = a.GetStats();
+  EXPECT_EQ(stats->num_allocs, 0);
+  EXPECT_EQ(stats->peak_bytes_in_use, 1024);
+  EXPECT_EQ(stats->largest_alloc_size, 0);
+  a.DeallocateRaw(p1);
+}
+
+TEST_F(GpuCudaMallocAsyncAllocatorTest, PoolSizeIsEnforced) {
+  GpuCudaMallocAsyncAllocator a(PlatformGpuId(0), 1 << 20, 0,
+                                "GPU_0_cuda_malloc_async");
+  void* p1 = a.AllocateRaw(256, 768 << 10);
+  ASSERT_NE(p1, nullptr);
+  EXPECT_EQ(a.AllocateRaw(256, 512 << 10), nullptr);
+  a.DeallocateRaw(p1);
+  void* p2 = a.AllocateRaw(256, 512 << 10);
+  EXPECT_NE(p2, nullptr);
+  a.DeallocateRaw(p2);
+}
+
+TEST_F(GpuCudaMallocAsyncAllocatorTest, ReleaseThresholdKeepsFreedMemory) {
+  GpuCudaMallocAsyncAllocator a(PlatformGpuId(0), 1 << 30, 1 << 30,
+                                "GPU_0_cuda_malloc_async");
+  // Memory freed below the release threshold is reused by later allocations.
+  for (int i = 0; i < 100; ++i) {
+    void* p = a.AllocateRaw(256, 64 << 20);
+    ASSERT_NE(p, nullptr);
+    a.DeallocateRaw(p);
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  EXPECT_EQ(stats->num_allocs, 100);
+  EXPECT_EQ(stats->bytes_in_use, 0);
+  EXPECT_EQ(stats->peak_bytes_in_use, 64 << 20);
+}
+
+static void BM_CudaMallocAsyncAllocation(int iters) {
+  PlatformGpuId platform_gpu_id(0);
+  if (!GpuCudaMallocAsyncAllocator::IsSupported(platform_gpu_id)) return;
+  GpuCudaMallocAsyncAllocator a(platform_gpu_id, 1uLL << 33, 1uLL << 33,
+                                "GPU_0_cuda_malloc_async");
+  // Exercise a few different allocation sizes
+  std::vector<size_t> sizes = {256,        4096,      16384,    524288,
+                               512,        1048576,   10485760, 104857600,
+                               1048576000, 2048576000};
+  int size_index = 0;
+
+  while (--iters > 0) {
+    size_t bytes = sizes[size_index++ % sizes.size()];
+    void* p = a.AllocateRaw(1, bytes);
+    a.DeallocateRaw(p);
+  }
+}
+BENCHMARK(BM_CudaMallocAsyncAllocation);
+
+// A more complex benchmark that defers deallocation of an object for
+// "delay" allocations.
+static void BM_CudaMallocAsyncAllocationDelayed(int iters, int delay) {
+  PlatformGpuId platform_gpu_id(0);
+  if (!GpuCudaMallocAsyncAllocator::IsSupported(platform_gpu_id)) return;
+  GpuCudaMallocAsyncAllocator a(platform_gpu_id, 1 << 30, 1 << 30,
+                                "GPU_0_cuda_malloc_async");
+  // Exercise a few different allocation sizes
+  std::vector<int> sizes = {256, 4096, 16384, 4096, 512, 1024, 1024};
+  int size_index = 0;
+
+  std::vector<void*> ptrs(delay, nullptr);
+  int pindex = 0;
+  while (--iters > 0) {
+    if (ptrs[pindex] != nullptr) {
+      a.DeallocateRaw(ptrs[pindex]);
+      ptrs[pindex] = nullptr;
+    }
+    int bytes = sizes[size_index++ % sizes.size()];
+    ptrs[pindex] = a.AllocateRaw(1, bytes);
+    pindex = (pindex + 1) % ptrs.size();
+  }
+  for (void* p : ptrs) {
+    if (p != nullptr) {
+      a.DeallocateRaw(p);
+    }
+  }
+}
+BENCHMARK(BM_CudaMallocAsyncAllocationDelayed)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
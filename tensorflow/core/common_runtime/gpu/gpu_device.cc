@@ -35,6 +35,7 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
@@ -42,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
@@ -61,6 +63,8 @@ limitations under the License.
 #if GOOGLE_CUDA
 #include "third_party/gpus/cudnn/cudnn.h"
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
 #elif TENSORFLOW_USE_ROCM
 #include "tensorflow/core/platform/rocm.h"
 #endif
@@ -239,7 +243,8 @@ class BaseGPUDevice::StreamGroupFactory {
   BaseGPUDevice::StreamGroup* GetOrCreate(TfGpuId tf_gpu_id,
                                           int stream_group_within_gpu,
                                           se::StreamExecutor* executor,
-                                          const GPUOptions& options) {
+                                          const GPUOptions& options,
+                                          int num_compute_streams) {
     mutex_lock guard(lock_);
     StreamGroup* group =
         &streams_[key_type(tf_gpu_id.value(), stream_group_within_gpu)];
@@ -292,6 +297,13 @@ class BaseGPUDevice::StreamGroupFactory {
                 << "] = " << group->device_to_device.back();
       }
     }
+    while (group->secondary_compute.size() + 1 < num_compute_streams) {
+      se::Stream* stream = GetStream(executor, group->priority);
+      stream->Init();
+      group->secondary_compute.push_back(stream);
+      VLOG(2) << "Created secondary_compute_stream[" << stream_group_within_gpu
+              << "] = " << group->secondary_compute.back();
+    }
     return group;
   }
 
@@ -332,6 +344,10 @@ class BaseGPUDevice::StreamGroupFactory {
         }
         stream.device_to_device.pop_back();
       }
+      for (se::Stream* secondary : stream.secondary_compute) {
+        delete secondary;
+      }
+      stream.secondary_compute.clear();
     }
     streams_.clear();
   }
@@ -376,6 +392,96 @@ class BaseGPUDevice::StreamGroupFactory {
   TF_DISALLOW_COPY_AND_ASSIGN(StreamGroupFactory);
 };
 
+// Wraps the GPU allocator of a device with several compute streams. A buffer
+// freed once its last use is queued on one stream must not be handed to a
+// kernel on another stream before that use has run, so the wrapper returns
+// freed buffers to the allocator only once every compute stream has passed
+// the point at which they were freed. Deallocations are batched and the
+// events recorded on the next allocation, launch or sync, since buffers may
+// also be freed from stream callbacks, which must not call into the driver.
+class BaseGPUDevice::MultiStreamAllocator : public Allocator {
+ public:
+  // Does not take ownership of 'allocator', 'em' or 'streams'.
+  MultiStreamAllocator(Allocator* allocator, EventMgr* em,
+                       const gtl::InlinedVector<se::Stream*, 4>& streams)
+      : allocator_(allocator), em_(em), streams_(streams) {}
+
+  string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    Flush();
+    return allocator_->AllocateRaw(alignment, num_bytes);
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    Flush();
+    return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    mutex_lock l(mu_);
+    pending_.push_back(ptr);
+  }
+
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+
+  int64 AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+
+  void ClearStats() override { allocator_->ClearStats(); }
+
+  // Queues the deallocation of the buffers freed so far behind the work
+  // already queued on every compute stream.
+  void Flush() {
+    std::vector<void*> ptrs;
+    {
+      mutex_lock l(mu_);
+      if (pending_.empty()) return;
+      ptrs.swap(pending_);
+    }
+    DeallocateAfter(allocator_, em_, streams_, 0, std::move(ptrs));
+  }
+
+ private:
+  // Waits for the streams from 'index' on, one at a time, then deallocates
+  // 'ptrs'. Captures nothing owned by the wrapper, which may be destroyed
+  // first.
+  static void DeallocateAfter(Allocator* allocator, EventMgr* em,
+                              const gtl::InlinedVector<se::Stream*, 4>& streams,
+                              int index, std::vector<void*> ptrs) {
+    if (index == streams.size()) {
+      for (void* ptr : ptrs) allocator->DeallocateRaw(ptr);
+      return;
+    }
+    em->ThenExecute(streams[index], [allocator, em, streams, index,
+                                     ptrs = std::move(ptrs)]() mutable {
+      DeallocateAfter(allocator, em, streams, index + 1, std::move(ptrs));
+    });
+  }
+
+  Allocator* const allocator_;  // Not owned.
+  EventMgr* const em_;          // Not owned.
+  const gtl::InlinedVector<se::Stream*, 4> streams_;
+  mutex mu_;
+  std::vector<void*> pending_ TF_GUARDED_BY(mu_);
+};
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              TfGpuId tf_gpu_id,
@@ -395,14 +501,17 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete gpu_device_info_;
-  gpu_allocator_->DeallocateRaw(scratch_);
+  for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
+  if (multi_stream_allocator_) multi_stream_allocator_->Flush();
   device_context_->Unref();
+  mutex_lock l(device_contexts_mu_);
+  for (auto& item : device_contexts_) item.second->Unref();
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
+  while (scratch_.size() < compute_streams_.size()) {
     DCHECK(stream_);
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
@@ -416,7 +525,7 @@ Status BaseGPUDevice::InitScratchBuffers() {
         se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
     TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
         &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    scratch_.push_back(static_cast<char*>(scratch_buffer));
   }
   return Status::OK();
 }
@@ -430,8 +539,20 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   executor_ = executor_status.ValueOrDie();
 
+  // Number of compute streams to spread the nodes of each graph over.
+  int64 num_compute_streams = 1;
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar("TF_GPU_COMPUTE_STREAMS", 1, &num_compute_streams));
+  if (num_compute_streams < 1 ||
+      num_compute_streams > gpu_stream_util::kMaxComputeStreams) {
+    LOG(ERROR) << "Illegal TF_GPU_COMPUTE_STREAMS=" << num_compute_streams
+               << " set to 1 instead.";
+    num_compute_streams = 1;
+  }
+
   stream_ = StreamGroupFactory::Global().GetOrCreate(
-      tf_gpu_id_, 0, executor_, options.config.gpu_options());
+      tf_gpu_id_, 0, executor_, options.config.gpu_options(),
+      num_compute_streams);
   device_context_ =
       new GPUDeviceContext(0, stream_->compute,
 #if TENSORFLOW_USE_ROCM
@@ -461,13 +582,37 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
       // owning its own.
       timing_counter =
           GPUProcessState::singleton()->GPUAllocatorCounter(tf_gpu_id_);
-      DCHECK(timing_counter);
+      // Only the BFC allocator supports timestamps.
+      timestamped_allocator_ = timing_counter != nullptr;
     }
     kernel_tracker_.reset(new GPUKernelTracker(
         tracker_params, Env::Default(), stream_->compute, timing_counter,
         timestamped_allocator_ ? gpu_allocator_ : nullptr, em_));
   }
 
+  // A stream-ordered allocator orders its allocations and frees on the
+  // stream of the kernels that use the memory.
+  if (auto* async_allocator =
+          dynamic_cast<GpuCudaMallocAsyncAllocator*>(gpu_allocator_)) {
+    async_allocator->SetStream(
+        stream_->compute->implementation()->GpuStreamMemberHack());
+  }
+
+  compute_streams_.push_back(stream_->compute);
+  if (num_compute_streams > 1 && kernel_tracker_) {
+    // The tracker follows the kernels of a single stream.
+    LOG(WARNING) << "TF_GPU_COMPUTE_STREAMS is ignored when the GPU kernel "
+                    "tracker is enabled.";
+  } else if (num_compute_streams > 1) {
+    compute_streams_.insert(compute_streams_.end(),
+                            stream_->secondary_compute.begin(),
+                            stream_->secondary_compute.begin() +
+                                (num_compute_streams - 1));
+    multi_stream_allocator_.reset(
+        new MultiStreamAllocator(gpu_allocator_, em_, compute_streams_));
+    gpu_allocator_ = multi_stream_allocator_.get();
+  }
+
   gpu_device_info_ = new GpuDeviceInfo;
   gpu_device_info_->stream = stream_->compute;
   gpu_device_info_->default_context = device_context_;
@@ -563,6 +708,7 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     }
   }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  PrepareStream(gpu_device_context);
   ScopedMemoryDebugAnnotation op_annotation(op_kernel->name_view().data(),
                                             context->step_id());
   op_kernel->Compute(context);
@@ -602,11 +748,129 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
 // Based on the semantics of Device::Sync this call should wait for
 // all streams not just the current one.
 Status BaseGPUDevice::Sync() {
+  if (multi_stream_allocator_) multi_stream_allocator_->Flush();
   return tensorflow_gpu_device_info()
       ->stream->parent()
       ->BlockHostUntilAllStreamsAreDone();
 }
 
+void BaseGPUDevice::PrepareStream(GPUDeviceContext* gpu_device_context) {
+  if (!multi_stream_allocator_) return;
+  multi_stream_allocator_->Flush();
+  se::Stream* stream = gpu_device_context->stream();
+  for (se::Stream* other : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(other);
+  }
+}
+
+Status BaseGPUDevice::FillContextMap(
+    const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+  if (compute_streams_.size() <= 1) return Status::OK();
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.num_streams = compute_streams_.size();
+  std::vector<gpu_stream_util::StreamAssignment> assignments;
+  TF_RETURN_IF_ERROR(
+      gpu_stream_util::AssignStreams(graph, opts, &assignments));
+  device_context_map->assign(graph->num_node_ids(), nullptr);
+  mutex_lock l(device_contexts_mu_);
+  for (const Node* n : graph->nodes()) {
+    if (!n->IsOp()) continue;
+    const gpu_stream_util::StreamAssignment& assignment = assignments[n->id()];
+    GPUDeviceContext* context =
+        GetDeviceContextLocked(assignment.stream_id, assignment.wait_mask);
+    context->Ref();
+    (*device_context_map)[n->id()] = context;
+  }
+  return Status::OK();
+}
+
+GPUDeviceContext* BaseGPUDevice::GetDeviceContextLocked(int stream_id,
+                                                        uint32 wait_mask) {
+  GPUDeviceContext*& context = device_contexts_[{stream_id, wait_mask}];
+  if (context == nullptr) {
+    gtl::InlinedVector<se::Stream*, 4> wait_streams;
+    for (int i = 0; i < compute_streams_.size(); ++i) {
+      if (wait_mask & (1u << i)) wait_streams.push_back(compute_streams_[i]);
+    }
+    context = new GPUDeviceContext(stream_id, compute_streams_[stream_id],
+#if TENSORFLOW_USE_ROCM
+                                   stream_->nccl,
+#endif
+                                   stream_->host_to_device,
+                                   stream_->device_to_host,
+                                   stream_->device_to_device, wait_streams);
+  }
+  return context;
+}
+
+#if GOOGLE_CUDA
+namespace {
+
+// An executable CUDA graph launched on a compute stream.
+class CudaCapturedGraph : public Device::CapturedGraph {
+ public:
+  CudaCapturedGraph(se::Stream* stream, se::gpu::GpuGraphExecHandle graph_exec)
+      : stream_(stream), graph_exec_(graph_exec) {}
+
+  ~CudaCapturedGraph() override {
+    se::gpu::GpuDriver::DestroyGraphExec(context(), graph_exec_);
+  }
+
+  Status Launch() override {
+    return se::gpu::GpuDriver::GraphLaunch(
+        context(), graph_exec_, se::gpu::AsGpuStreamValue(stream_));
+  }
+
+ private:
+  se::gpu::GpuContext* context() const {
+    return se::gpu::AsGpuStream(stream_)->parent()->gpu_context();
+  }
+
+  se::Stream* const stream_;
+  const se::gpu::GpuGraphExecHandle graph_exec_;
+};
+
+}  // namespace
+#endif  // GOOGLE_CUDA
+
+Status BaseGPUDevice::BeginGraphCapture() {
+#if GOOGLE_CUDA
+  if (compute_streams_.size() > 1 || kernel_tracker_ || sync_every_op_) {
+    return errors::Unimplemented(
+        "Graph capture requires a single compute stream, without kernel "
+        "tracking or sync_every_op");
+  }
+  se::Stream* stream = compute_streams_[0];
+  // The kernels of a step are launched by several threads, and the capture
+  // is ended by the thread that finishes the step.
+  return se::gpu::GpuDriver::StreamBeginCapture(
+      se::gpu::AsGpuStream(stream)->parent()->gpu_context(),
+      se::gpu::AsGpuStreamValue(stream), /*relaxed=*/true);
+#else
+  return Device::BeginGraphCapture();
+#endif  // GOOGLE_CUDA
+}
+
+Status BaseGPUDevice::EndGraphCapture(std::unique_ptr<CapturedGraph>* graph) {
+#if GOOGLE_CUDA
+  se::Stream* stream = compute_streams_[0];
+  se::gpu::GpuContext* context =
+      se::gpu::AsGpuStream(stream)->parent()->gpu_context();
+  se::gpu::GpuGraphHandle cuda_graph = nullptr;
+  TF_RETURN_IF_ERROR(se::gpu::GpuDriver::StreamEndCapture(
+      context, se::gpu::AsGpuStreamValue(stream), &cuda_graph));
+  se::gpu::GpuGraphExecHandle graph_exec = nullptr;
+  Status status =
+      se::gpu::GpuDriver::GraphInstantiate(context, cuda_graph, &graph_exec);
+  se::gpu::GpuDriver::DestroyGraph(context, cuda_graph);
+  TF_RETURN_IF_ERROR(status);
+  graph->reset(new CudaCapturedGraph(stream, graph_exec));
+  return Status::OK();
+#else
+  return Device::EndGraphCapture(graph);
+#endif  // GOOGLE_CUDA
+}
+
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
                                  OpKernelContext* context,
                                  AsyncOpKernel::DoneCallback done) {
@@ -623,6 +887,7 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << stream_id << "]";
 
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  PrepareStream(gpu_device_context);
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
@@ -995,11 +1260,11 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, compute_streams_.size());
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      compute_streams_[stream_id]->implementation()->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_gpu_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1016,7 +1281,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
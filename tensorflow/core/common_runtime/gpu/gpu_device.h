@@ -20,9 +20,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_DEVICE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_DEVICE_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -69,6 +71,18 @@ class BaseGPUDevice : public LocalDevice {
   void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
                     AsyncOpKernel::DoneCallback done) override;
 
+  // Spreads the nodes of 'graph' over the compute streams of the device when
+  // more than one is enabled with TF_GPU_COMPUTE_STREAMS.
+  Status FillContextMap(
+      const Graph* graph,
+      std::vector<DeviceContext*>* device_context_map) override;
+
+  // Captures the work queued on the compute stream into a CUDA graph. Only
+  // supported with a single compute stream, without kernel tracking and
+  // without sync_every_op.
+  Status BeginGraphCapture() override;
+  Status EndGraphCapture(std::unique_ptr<CapturedGraph>* graph) override;
+
   Status MakeTensorFromProto(const TensorProto& tensor_proto,
                              const AllocatorAttributes alloc_attrs,
                              Tensor* tensor) override;
@@ -136,14 +150,29 @@ class BaseGPUDevice : public LocalDevice {
     se::Stream* host_to_device = nullptr;
     se::Stream* device_to_host = nullptr;
     gtl::InlinedVector<se::Stream*, 4> device_to_device;
+    // Compute streams besides 'compute', used by devices that spread the
+    // nodes of a graph over several streams.
+    gtl::InlinedVector<se::Stream*, 4> secondary_compute;
     int priority = 0;
   };
   class StreamGroupFactory;
+  class MultiStreamAllocator;
 
   StreamGroup* stream_;
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
+  // Eigen scratch buffers, one per compute stream.
+  std::vector<char*> scratch_;
   GPUDeviceContext* device_context_;
+  // The compute streams, indexed by stream id. Holds stream_->compute alone
+  // unless TF_GPU_COMPUTE_STREAMS enables more.
+  gtl::InlinedVector<se::Stream*, 4> compute_streams_;
+  // Wraps gpu_allocator_ when there is more than one compute stream.
+  std::unique_ptr<MultiStreamAllocator> multi_stream_allocator_;
+  mutex device_contexts_mu_;
+  // Contexts keyed by compute stream id and the mask of the streams they
+  // wait for. Each holds one reference.
+  std::map<std::pair<int, uint32>, GPUDeviceContext*> device_contexts_
+      TF_GUARDED_BY(device_contexts_mu_);
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   mutex trace_mu_;
   TfGpuId tf_gpu_id_;
@@ -157,6 +186,14 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns the context for ops on compute stream 'stream_id' that must wait
+  // for the streams in 'wait_mask', creating it if needed.
+  GPUDeviceContext* GetDeviceContextLocked(int stream_id, uint32 wait_mask)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(device_contexts_mu_);
+
+  // Queues waits on the streams the op's context depends on.
+  void PrepareStream(GPUDeviceContext* gpu_device_context);
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
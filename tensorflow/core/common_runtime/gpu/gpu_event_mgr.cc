@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -27,6 +28,13 @@ namespace {
 //  - Is this the right number of threads?
 //  - Should EventMgrs be shared between GPUDevices on a multi-GPU machine?
 static const int kNumThreads = 2;
+
+bool UseHostCallbacks() {
+  bool use_host_callbacks;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS", false,
+                                 &use_host_callbacks));
+  return use_host_callbacks;
+}
 }  // namespace
 
 namespace gpu_event_mgr {
@@ -94,13 +102,22 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      use_host_callbacks_(UseHostCallbacks()),
       threadpool_(Env::Default(), "GPU_Event_Manager", kNumThreads) {
   gpu_event_mgr::InitThreadpoolLabels(&threadpool_);
-  StartPollingLoop();
+  // Without events to poll, no thread needs to wait for the GPU.
+  if (!use_host_callbacks_) StartPollingLoop();
 }
 
 EventMgr::~EventMgr() {
   StopPollingLoop();
+  {
+    // The pending host callbacks refer to this object.
+    mutex_lock l(callback_mu_);
+    while (num_pending_funcs_ > 0 || draining_) {
+      callbacks_done_.wait(l);
+    }
+  }
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -242,6 +259,60 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
   }
 }
 
+// Completion through host callbacks avoids the polling loop's sleep between
+// the GPU finishing the work and the callback running, and the thread
+// it keeps busy while events are pending. A stream callback may not call
+// into the driver and blocks its stream until it returns, so it only appends
+// the function to a queue; one threadpool thread runs everything that
+// completed in the meantime as a batch.
+void EventMgr::ThenExecuteFromHostCallback(se::Stream* stream,
+                                           std::function<void()> func) {
+  {
+    mutex_lock l(callback_mu_);
+    ++num_pending_funcs_;
+  }
+  if (!stream->ok()) {
+    // The stream runs no more callbacks. Like an event on a failed stream,
+    // the function runs right away.
+    OnHostCallback(std::move(func));
+    return;
+  }
+  stream->ThenDoHostCallback(
+      [this, func = std::move(func)]() mutable {
+        OnHostCallback(std::move(func));
+      });
+}
+
+void EventMgr::OnHostCallback(std::function<void()> func) {
+  mutex_lock l(callback_mu_);
+  completed_funcs_.push_back(std::move(func));
+  if (!draining_) {
+    draining_ = true;
+    threadpool_.Schedule([this]() { DrainCompletedFuncs(); });
+  }
+}
+
+void EventMgr::DrainCompletedFuncs() {
+  std::vector<std::function<void()>> batch;
+  while (true) {
+    {
+      mutex_lock l(callback_mu_);
+      num_pending_funcs_ -= batch.size();
+      batch.clear();
+      if (completed_funcs_.empty()) {
+        draining_ = false;
+        if (num_pending_funcs_ == 0) callbacks_done_.notify_all();
+        return;
+      }
+      batch.swap(completed_funcs_);
+    }
+    VLOG(2) << "DrainCompletedFuncs batch " << batch.size();
+    for (auto& func : batch) {
+      func();
+    }
+  }
+}
+
 EventMgrFactory* EventMgrFactory::Singleton() {
   static EventMgrFactory* instance = new EventMgrFactory;
   return instance;
@@ -68,6 +68,10 @@ class EventMgr {
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
   inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
+    if (use_host_callbacks_) {
+      ThenExecuteFromHostCallback(stream, std::move(func));
+      return;
+    }
     ToFreeVector to_free;
     {
       mutex_lock l(mu_);
@@ -83,6 +87,10 @@ class EventMgr {
   friend class EventMgrFactory;
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  // If true, completions are signalled by host callbacks queued on the
+  // streams instead of by events found recorded by the polling loop. Set by
+  // the TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS environment variable.
+  const bool use_host_callbacks_;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
@@ -129,6 +137,31 @@ class EventMgr {
   void StartPollingLoop();
   void StopPollingLoop();
 
+  // Queues a host callback on `stream` that hands `func` to
+  // OnHostCallback() once the work queued before it has completed.
+  void ThenExecuteFromHostCallback(se::Stream* stream,
+                                   std::function<void()> func);
+
+  // Called from a stream callback, which must not call into the driver:
+  // appends `func` to the completed functions and makes sure a threadpool
+  // thread is draining them.
+  void OnHostCallback(std::function<void()> func);
+
+  // Runs the completed functions in batches, in completion order, until none
+  // is left.
+  void DrainCompletedFuncs();
+
+  // Guards the host callback state. Separate from mu_ so that stream
+  // callbacks never wait for a thread that is queueing work on a stream.
+  mutex callback_mu_;
+  condition_variable callbacks_done_;
+  // The functions passed to ThenExecute() that have not run yet.
+  int64 num_pending_funcs_ TF_GUARDED_BY(callback_mu_) = 0;
+  // The functions whose stream work has completed, in completion order.
+  std::vector<std::function<void()>> completed_funcs_
+      TF_GUARDED_BY(callback_mu_);
+  bool draining_ TF_GUARDED_BY(callback_mu_) = false;
+
   // A stack of unused events
   std::vector<se::Event*> free_events_ TF_GUARDED_BY(mu_);
 
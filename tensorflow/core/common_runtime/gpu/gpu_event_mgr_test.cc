@@ -138,6 +138,35 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Tests that functions run in stream order when host callbacks signal their
+// completion.
+TEST(EventMgr, HostCallbacks) {
+  setenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS", "true", 1);
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  {
+    TEST_EventMgr em(stream_exec, GPUOptions());
+    std::vector<int> order;
+    Notification note;
+    for (int i = 0; i < 100; ++i) {
+      em.ThenExecute(stream.get(), [i, &order, &note]() {
+        order.push_back(i);
+        if (i == 99) note.Notify();
+      });
+    }
+    note.WaitForNotification();
+    ASSERT_EQ(order.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(order[i], i);
+    }
+    // The destructor waits for the functions that are still queued.
+    em.ThenExecute(stream.get(), []() {});
+  }
+  unsetenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS");
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -433,7 +462,7 @@ class EMBenchmarkHelper {
   }
 };
 
-static void BM_no_ops(int iters, int threads) {
+static void BM_no_ops_impl(int iters, int threads, bool host_callbacks) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -444,7 +473,9 @@ static void BM_no_ops(int iters, int threads) {
   std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
   CHECK(stream);
   stream->Init();
+  if (host_callbacks) setenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS", "1", 1);
   TEST_EventMgr em(stream_exec, GPUOptions());
+  unsetenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS");
   testing::StartTiming();
   std::atomic<int> counter;
   counter.store(0, std::memory_order_seq_cst);
@@ -463,10 +494,20 @@ static void BM_no_ops(int iters, int threads) {
     Env::Default()->SleepForMicroseconds(1);
   }
 }
+static void BM_no_ops(int iters, int threads) {
+  BM_no_ops_impl(iters, threads, false);
+}
 BENCHMARK(BM_no_ops)->Arg(4);
 BENCHMARK(BM_no_ops)->Arg(8);
 BENCHMARK(BM_no_ops)->Arg(32);
 
+static void BM_no_ops_host_callbacks(int iters, int threads) {
+  BM_no_ops_impl(iters, threads, true);
+}
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(4);
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(8);
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(32);
+
 // Benchmark functions are defined at top level.  In order to provide a real,
 // persistent GPUDevice to the following function it also needs to be at top
 // level.  But then we can't clean it up without a cuda runtime error, so we
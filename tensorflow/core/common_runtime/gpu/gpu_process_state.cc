@@ -15,11 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamalloc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_debug_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_host_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
@@ -53,6 +55,16 @@ bool useCudaMemoryGuardAllocator() {
          std::strcmp(debug_allocator_str, "memory_guard") == 0;
 }
 
+// Returns true if the GPU memory should come from a stream-ordered CUDA
+// memory pool instead of the BFC allocator, as requested by `allocator_type`
+// or by the TF_GPU_ALLOCATOR environment variable.
+bool useCudaMallocAsyncAllocator(const string& allocator_type) {
+  if (allocator_type == "cuda_malloc_async") return true;
+  const char* allocator_str = std::getenv("TF_GPU_ALLOCATOR");
+  return allocator_str != nullptr &&
+         std::strcmp(allocator_str, "cuda_malloc_async") == 0;
+}
+
 }  // namespace
 
 /*static*/ GPUProcessState* GPUProcessState::singleton(GPUProcessState* ps) {
@@ -93,7 +105,8 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
   if (allocator_parts.allocator == nullptr) {
     // Validate allocator types.
-    if (!allocator_type.empty() && allocator_type != "BFC") {
+    if (!allocator_type.empty() && allocator_type != "BFC" &&
+        allocator_type != "cuda_malloc_async") {
       LOG(ERROR) << "Invalid allocator type: " << allocator_type;
       return nullptr;
     }
@@ -105,20 +118,50 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
     while (bus_id >= gpu_visitors_.size()) {
       gpu_visitors_.push_back({});
     }
-    GPUMemAllocator* sub_allocator = new GPUMemAllocator(
-        GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
-        platform_gpu_id,
-        (options.per_process_gpu_memory_fraction() > 1.0 ||
-         options.experimental().use_unified_memory()),
-        gpu_visitors_[bus_id], {});
-    GPUBFCAllocator* gpu_bfc_allocator =
-        new GPUBFCAllocator(sub_allocator, total_bytes, options,
-                            strings::StrCat("GPU_", tf_gpu_id.value(), "_bfc"));
-    Allocator* gpu_allocator = gpu_bfc_allocator;
+    bool use_cuda_malloc_async = useCudaMallocAsyncAllocator(allocator_type);
+    if (use_cuda_malloc_async &&
+        !GpuCudaMallocAsyncAllocator::IsSupported(platform_gpu_id)) {
+      LOG(WARNING) << "GPU " << platform_gpu_id.value()
+                   << " does not support stream-ordered memory pools, which "
+                      "need CUDA 11.2 or later. Using the BFC allocator.";
+      use_cuda_malloc_async = false;
+    }
+    GPUMemAllocator* sub_allocator = nullptr;
+    GPUBFCAllocator* gpu_bfc_allocator = nullptr;
+    Allocator* gpu_allocator;
     SharedCounter* timing_counter = nullptr;
-    if (options.experimental().timestamped_allocator()) {
-      timing_counter = new SharedCounter;
-      gpu_bfc_allocator->SetTimingCounter(timing_counter);
+    if (use_cuda_malloc_async) {
+      // By default, a pool that may grow keeps no freed memory from the
+      // driver, and one that may not keeps all of it, like the BFC allocator.
+      int64 release_threshold_mb;
+      TF_CHECK_OK(ReadInt64FromEnvVar(
+          "TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD_MB",
+          options.allow_growth() ? 0 : total_bytes >> 20,
+          &release_threshold_mb));
+      LOG(INFO) << "Using CUDA malloc async allocator for GPU.";
+      if (options.experimental().timestamped_allocator()) {
+        LOG(WARNING) << "The CUDA malloc async allocator ignores "
+                        "timestamped_allocator.";
+      }
+      gpu_allocator = new GpuCudaMallocAsyncAllocator(
+          platform_gpu_id, total_bytes,
+          std::min<size_t>(release_threshold_mb << 20, total_bytes),
+          strings::StrCat("GPU_", tf_gpu_id.value(), "_cuda_malloc_async"));
+    } else {
+      sub_allocator = new GPUMemAllocator(
+          GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+          platform_gpu_id,
+          (options.per_process_gpu_memory_fraction() > 1.0 ||
+           options.experimental().use_unified_memory()),
+          gpu_visitors_[bus_id], {});
+      gpu_bfc_allocator = new GPUBFCAllocator(
+          sub_allocator, total_bytes, options,
+          strings::StrCat("GPU_", tf_gpu_id.value(), "_bfc"));
+      gpu_allocator = gpu_bfc_allocator;
+      if (options.experimental().timestamped_allocator()) {
+        timing_counter = new SharedCounter;
+        gpu_bfc_allocator->SetTimingCounter(timing_counter);
+      }
     }
 
     // If true, checks for memory overwrites by writing
@@ -176,6 +219,10 @@ SharedCounter* GPUProcessState::GPUAllocatorCounter(TfGpuId tf_gpu_id) {
   }
 
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
+  if (allocator_parts.bfc_allocator == nullptr) {
+    // Only the BFC allocator keeps the timing counter.
+    return nullptr;
+  }
   if (allocator_parts.counter.get() == nullptr) {
     SharedCounter* timing_counter = new SharedCounter;
     allocator_parts.bfc_allocator->SetTimingCounter(timing_counter);
@@ -238,9 +285,22 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     while (gpu_host_free_visitors_.size() <= numa_node) {
       gpu_host_free_visitors_.push_back({});
     }
+    // Track the pinned regions so that IsGpuHostMemory() can tell them apart
+    // from pageable memory.
+    std::vector<SubAllocator::Visitor> alloc_visitors =
+        gpu_host_alloc_visitors_[numa_node];
+    alloc_visitors.push_back([this](void* ptr, int, size_t num_bytes) {
+      mutex_lock l(gpu_host_regions_mu_);
+      gpu_host_regions_[static_cast<const char*>(ptr)] = num_bytes;
+    });
+    std::vector<SubAllocator::Visitor> free_visitors =
+        gpu_host_free_visitors_[numa_node];
+    free_visitors.push_back([this](void* ptr, int, size_t) {
+      mutex_lock l(gpu_host_regions_mu_);
+      gpu_host_regions_.erase(static_cast<const char*>(ptr));
+    });
     SubAllocator* sub_allocator =
-        new GpuHostAllocator(se, numa_node, gpu_host_alloc_visitors_[numa_node],
-                             gpu_host_free_visitors_[numa_node]);
+        new GpuHostAllocator(se, numa_node, alloc_visitors, free_visitors);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64 gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -284,6 +344,16 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   }
 }
 
+bool GPUProcessState::IsGpuHostMemory(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  tf_shared_lock l(gpu_host_regions_mu_);
+  // Find the last region starting at or before `p`.
+  auto it = gpu_host_regions_.upper_bound(p);
+  if (it == gpu_host_regions_.begin()) return false;
+  --it;
+  return p < it->first + it->second;
+}
+
 void GPUProcessState::AddGPUAllocVisitor(int bus_id,
                                          const SubAllocator::Visitor& visitor) {
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
@@ -91,6 +91,10 @@ class GPUProcessState {
 
   virtual Allocator* GetGpuHostAllocator(int numa_node);
 
+  // Returns true if `ptr` points into pinned memory obtained from one of the
+  // GpuHostAllocators, i.e. memory the GPU can DMA from and to directly.
+  virtual bool IsGpuHostMemory(const void* ptr);
+
   // Registers a Visitor to be invoked on new chunks of memory allocated by the
   // SubAllocator of every GPU proximate to the specified bus.  The AllocVisitor
   // is provided with a memory pointer, a GPU id, and the size of the area it
@@ -143,7 +147,7 @@ class GPUProcessState {
   struct AllocatorParts {
     std::unique_ptr<Allocator> allocator;
     std::unique_ptr<SharedCounter> counter;
-    GPUBFCAllocator* bfc_allocator;
+    GPUBFCAllocator* bfc_allocator;  // null for other allocators
     SubAllocator* sub_allocator;  // owned by allocator
     std::unique_ptr<Allocator> recording_allocator;
   };
@@ -156,6 +160,12 @@ class GPUProcessState {
       TF_GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_host_free_visitors_
       TF_GUARDED_BY(mu_);
+
+  // Extents of the regions handed out by the GpuHostAllocators, keyed by start
+  // address. May be acquired while holding `mu_`, but not vice versa.
+  mutex gpu_host_regions_mu_;
+  std::map<const char*, size_t> gpu_host_regions_
+      TF_GUARDED_BY(gpu_host_regions_mu_);
 };
 
 }  // namespace tensorflow
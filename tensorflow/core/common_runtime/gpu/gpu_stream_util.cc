@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+namespace {
+
+// Returns true if the effects of 'n' are not ordered by its data inputs.
+bool IsOrdered(const Node* n) {
+  if (n->op_def().is_stateful()) return true;
+  for (const DataType dtype : n->input_types()) {
+    if (dtype == DT_RESOURCE || IsRefType(dtype)) return true;
+  }
+  return false;
+}
+
+bool IsPinnedToDefaultStream(const Node* n) {
+  return n->IsArg() || n->IsRetval() || n->IsSend() || n->IsRecv() ||
+         n->IsFunctionCall() || n->IsIfNode() || n->IsWhileNode() ||
+         n->IsCaseNode() || n->IsControlFlow() || IsOrdered(n);
+}
+
+// Returns true if the executor runs 'n' without handing it to the device, so
+// that 'n' never waits on the streams of its inputs itself.
+bool IsTransparent(const Node* n) {
+  return n->IsConstant() || n->type_string() == "NoOp";
+}
+
+}  // namespace
+
+Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
+                     std::vector<StreamAssignment>* assignments) {
+  if (opts.num_streams < 1 || opts.num_streams > kMaxComputeStreams) {
+    return errors::InvalidArgument("num_streams must be in [1, ",
+                                   kMaxComputeStreams, "]; was ",
+                                   opts.num_streams);
+  }
+  assignments->assign(graph->num_node_ids(), StreamAssignment());
+  if (opts.num_streams == 1) return Status::OK();
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph, &order);
+
+  // Assign the streams, continuing chains and spreading the other nodes.
+  std::vector<bool> passed_on(graph->num_node_ids(), false);
+  int next_stream = 0;
+  for (const Node* n : order) {
+    // NoOps launch nothing and have no data outputs to continue.
+    if (!n->IsOp() || n->type_string() == "NoOp") continue;
+    StreamAssignment& assignment = (*assignments)[n->id()];
+    if (IsPinnedToDefaultStream(n)) {
+      assignment.stream_id = 0;
+      continue;
+    }
+    const Node* chain = nullptr;
+    for (const Edge* e : n->in_edges()) {
+      const Node* src = e->src();
+      if (!e->IsControlEdge() && src->IsOp() && !passed_on[src->id()]) {
+        chain = src;
+        break;
+      }
+    }
+    if (chain != nullptr) {
+      passed_on[chain->id()] = true;
+      assignment.stream_id = (*assignments)[chain->id()].stream_id;
+    } else {
+      assignment.stream_id = next_stream;
+      next_stream = (next_stream + 1) % opts.num_streams;
+    }
+  }
+
+  // Work out the streams each node must wait for. A transparent node exposes
+  // the streams of its own inputs to its consumers in place of its own.
+  const uint32 all_streams = (1u << opts.num_streams) - 1;
+  std::vector<uint32> exposed(graph->num_node_ids(), 0);
+  for (const Node* n : order) {
+    if (!n->IsOp()) continue;
+    uint32 inputs = 0;
+    for (const Edge* e : n->in_edges()) {
+      const Node* src = e->src();
+      if (!src->IsOp()) continue;
+      inputs |= IsTransparent(src)
+                    ? exposed[src->id()]
+                    : 1u << (*assignments)[src->id()].stream_id;
+    }
+    StreamAssignment& assignment = (*assignments)[n->id()];
+    if (IsTransparent(n)) {
+      exposed[n->id()] = inputs;
+    } else {
+      const uint32 wait = IsOrdered(n) ? all_streams : inputs;
+      assignment.wait_mask = wait & ~(1u << assignment.stream_id);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
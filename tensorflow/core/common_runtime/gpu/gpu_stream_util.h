@@ -0,0 +1,60 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
+
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+
+// The largest number of compute streams AssignStreams() spreads nodes over.
+constexpr int kMaxComputeStreams = 8;
+
+struct AssignStreamsOpts {
+  int num_streams = 1;
+};
+
+struct StreamAssignment {
+  // The compute stream the node's kernels are launched on.
+  int stream_id = 0;
+  // Bit i is set if the work queued on compute stream i must complete before
+  // the node's kernels run. Never contains the node's own stream.
+  uint32 wait_mask = 0;
+};
+
+// Assigns the nodes of 'graph' to 'opts.num_streams' compute streams, and
+// returns the result in 'assignments', indexed by node id.
+//
+// A node stays on the stream of the first of its producers that has not
+// already passed its stream on to another consumer, so that chains of
+// kernels run on one stream while independent branches are spread over the
+// streams round-robin. Nodes at the boundaries of the graph (arguments,
+// return values, sends, receives, function calls and control flow) run on
+// stream 0, as do stateful nodes and nodes reading resources or refs; the
+// latter also wait for every other stream, as their effects are not ordered
+// by the dataflow alone.
+Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
+                     std::vector<StreamAssignment>* assignments);
+
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
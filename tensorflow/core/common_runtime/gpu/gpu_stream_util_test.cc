@@ -0,0 +1,151 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class GpuStreamUtilTest : public ::testing::Test {
+ protected:
+  void Assign(const Scope& root, int num_streams) {
+    graph_.reset(new Graph(OpRegistry::Global()));
+    TF_ASSERT_OK(root.ToGraph(graph_.get()));
+    gpu_stream_util::AssignStreamsOpts opts;
+    opts.num_streams = num_streams;
+    TF_ASSERT_OK(gpu_stream_util::AssignStreams(graph_.get(), opts,
+                                                &assignments_));
+    ASSERT_EQ(assignments_.size(), graph_->num_node_ids());
+  }
+
+  const gpu_stream_util::StreamAssignment& Get(const string& name) {
+    for (const Node* n : graph_->nodes()) {
+      if (n->name() == name) return assignments_[n->id()];
+    }
+    LOG(FATAL) << "No node named " << name;
+  }
+
+  std::unique_ptr<Graph> graph_;
+  std::vector<gpu_stream_util::StreamAssignment> assignments_;
+};
+
+TEST_F(GpuStreamUtilTest, BogusOpts) {
+  Graph graph(OpRegistry::Global());
+  std::vector<gpu_stream_util::StreamAssignment> assignments;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.num_streams = 0;
+  EXPECT_FALSE(
+      gpu_stream_util::AssignStreams(&graph, opts, &assignments).ok());
+  opts.num_streams = gpu_stream_util::kMaxComputeStreams + 1;
+  EXPECT_FALSE(
+      gpu_stream_util::AssignStreams(&graph, opts, &assignments).ok());
+}
+
+TEST_F(GpuStreamUtilTest, SingleStream) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  auto a = ops::Neg(root.WithOpName("a"), x);
+  auto b = ops::Exp(root.WithOpName("b"), x);
+  ops::Add(root.WithOpName("c"), a, b);
+  Assign(root, 1);
+  for (const auto& assignment : assignments_) {
+    EXPECT_EQ(assignment.stream_id, 0);
+    EXPECT_EQ(assignment.wait_mask, 0u);
+  }
+}
+
+TEST_F(GpuStreamUtilTest, ChainsStayOnOneStream) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  auto x1 = ops::Square(root.WithOpName("x1"), x);
+  ops::Square(root.WithOpName("x2"), x1);
+  auto y = ops::Const(root.WithOpName("y"), 1.0f, {2, 2});
+  auto y1 = ops::Tanh(root.WithOpName("y1"), y);
+  ops::Tanh(root.WithOpName("y2"), y1);
+  Assign(root, 2);
+
+  const int x_stream = Get("x").stream_id;
+  const int y_stream = Get("y").stream_id;
+  EXPECT_NE(x_stream, y_stream);
+  for (const string& name : {"x1", "x2"}) {
+    EXPECT_EQ(Get(name).stream_id, x_stream) << name;
+    EXPECT_EQ(Get(name).wait_mask, 0u) << name;
+  }
+  for (const string& name : {"y1", "y2"}) {
+    EXPECT_EQ(Get(name).stream_id, y_stream) << name;
+    EXPECT_EQ(Get(name).wait_mask, 0u) << name;
+  }
+}
+
+TEST_F(GpuStreamUtilTest, BranchesAreSpread) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  auto a = ops::Neg(root.WithOpName("a"), x);
+  auto b = ops::Exp(root.WithOpName("b"), x);
+  ops::Add(root.WithOpName("c"), a, b);
+  Assign(root, 4);
+
+  const auto& a_assignment = Get("a");
+  const auto& b_assignment = Get("b");
+  const auto& c_assignment = Get("c");
+  EXPECT_NE(a_assignment.stream_id, b_assignment.stream_id);
+  // The constant does not launch anything, so neither branch waits.
+  EXPECT_EQ(a_assignment.wait_mask, 0u);
+  EXPECT_EQ(b_assignment.wait_mask, 0u);
+  // The join continues one branch and waits for the other.
+  const int other = c_assignment.stream_id == a_assignment.stream_id
+                        ? b_assignment.stream_id
+                        : a_assignment.stream_id;
+  EXPECT_EQ(c_assignment.wait_mask, 1u << other);
+}
+
+TEST_F(GpuStreamUtilTest, WaitsThroughNoOps) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  auto a = ops::Neg(root.WithOpName("a"), x);
+  auto barrier = ops::NoOp(
+      root.WithOpName("barrier").WithControlDependencies({a.operation}));
+  auto y = ops::Const(root.WithOpName("y"), 1.0f, {2, 2});
+  ops::Exp(root.WithOpName("b").WithControlDependencies({barrier}), y);
+  Assign(root, 2);
+
+  const int a_stream = Get("a").stream_id;
+  ASSERT_NE(Get("b").stream_id, a_stream);
+  EXPECT_EQ(Get("b").wait_mask, 1u << a_stream);
+}
+
+TEST_F(GpuStreamUtilTest, ResourceOpsWaitForAllStreams) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  ops::Neg(root.WithOpName("a"), x);
+  auto v = ops::VarHandleOp(root.WithOpName("v"), DT_FLOAT, {2, 2});
+  ops::ReadVariableOp(root.WithOpName("read"), v, DT_FLOAT);
+  Assign(root, 4);
+
+  EXPECT_EQ(Get("v").stream_id, 0);
+  EXPECT_EQ(Get("v").wait_mask, 0xeu);
+  EXPECT_EQ(Get("read").stream_id, 0);
+  EXPECT_EQ(Get("read").wait_mask, 0xeu);
+}
+
+}  // namespace
+}  // namespace tensorflow
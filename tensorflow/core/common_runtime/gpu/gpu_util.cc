@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -31,9 +35,11 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 // IMPLEMENTATION NOTE:
@@ -109,6 +115,175 @@ void* GetBase(const Tensor* src) {
 
 void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+namespace {
+
+// Size of each pinned staging buffer, and the number of buffers used by one
+// staged copy.
+constexpr int64 kStagingChunkBytes = 1 << 20;
+constexpr int kNumStagingBuffers = 4;
+
+// Returns the minimum size of a copy between pageable host memory and a GPU
+// that is staged through pinned buffers. Smaller copies are issued directly.
+// Staging is disabled if TF_GPU_STAGED_COPY_MIN_BYTES is not positive.
+int64 StagedCopyMinBytes() {
+  static const int64 min_bytes = [] {
+    int64 value;
+    Status status = ReadInt64FromEnvVar("TF_GPU_STAGED_COPY_MIN_BYTES",
+                                        4 * kStagingChunkBytes, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << "StagedCopyMinBytes: " << status.error_message();
+    }
+    return value;
+  }();
+  return min_bytes;
+}
+
+// Copies a buffer between pageable host memory and the GPU through a ring of
+// pinned staging buffers taken from the GpuHostAllocator.
+//
+// A copy from pageable memory is staged by the driver through its own pinned
+// buffer and blocks the calling thread until it completes. Here the pageable
+// data instead moves in chunks of kStagingChunkBytes, each of which is copied
+// on the host into (or out of) a free staging buffer while the other buffers
+// are being DMA'd. A buffer is refilled from the EventMgr callback that fires
+// once its previous chunk has been transferred.
+//
+// The object deletes itself after invoking `done`.
+class StagedCopy {
+ public:
+  StagedCopy(bool host_to_device, char* host_ptr, char* gpu_ptr,
+             int64 total_bytes, se::Stream* stream, EventMgr* event_mgr,
+             Allocator* staging_allocator, TensorReference input_ref,
+             StatusCallback done)
+      : host_to_device_(host_to_device),
+        host_ptr_(host_ptr),
+        gpu_ptr_(gpu_ptr),
+        total_bytes_(total_bytes),
+        stream_(stream),
+        event_mgr_(event_mgr),
+        staging_allocator_(staging_allocator),
+        input_ref_(input_ref),
+        done_(std::move(done)) {}
+
+  // Starts the copy. Returns false, leaving `this` to be deleted by the caller,
+  // if no pinned staging buffer could be obtained.
+  bool Start() {
+    const int num_chunks =
+        (total_bytes_ + kStagingChunkBytes - 1) / kStagingChunkBytes;
+    // Failing to get a staging buffer only means the copy is issued directly.
+    AllocationAttributes attr;
+    attr.retry_on_failure = false;
+    std::vector<char*> buffers;
+    for (int i = 0; i < std::min(kNumStagingBuffers, num_chunks); ++i) {
+      void* buffer = staging_allocator_->AllocateRaw(
+          Allocator::kAllocatorAlignment, kStagingChunkBytes, attr);
+      if (buffer == nullptr) break;
+      if (!GPUProcessState::singleton()->IsGpuHostMemory(buffer)) {
+        // The allocator is not backed by pinned memory.
+        staging_allocator_->DeallocateRaw(buffer);
+        break;
+      }
+      buffers.push_back(static_cast<char*>(buffer));
+    }
+    if (buffers.empty()) return false;
+    {
+      mutex_lock l(mu_);
+      num_active_buffers_ = buffers.size();
+    }
+    for (char* buffer : buffers) {
+      IssueNextChunk(buffer);
+    }
+    return true;
+  }
+
+ private:
+  // Transfers the next chunk through `buffer`, or releases `buffer` if all
+  // chunks have been issued.
+  void IssueNextChunk(char* buffer) {
+    int64 offset;
+    int64 num_bytes;
+    {
+      mutex_lock l(mu_);
+      offset = next_offset_;
+      num_bytes = std::min(kStagingChunkBytes, total_bytes_ - offset);
+      next_offset_ += num_bytes;
+    }
+    if (num_bytes == 0) {
+      staging_allocator_->DeallocateRaw(buffer);
+      bool last;
+      {
+        mutex_lock l(mu_);
+        last = --num_active_buffers_ == 0;
+      }
+      if (last) Finish();
+      return;
+    }
+    DeviceMemoryBase gpu_chunk(gpu_ptr_ + offset, num_bytes);
+    if (host_to_device_) {
+      memcpy(buffer, host_ptr_ + offset, num_bytes);
+      stream_->ThenMemcpy(&gpu_chunk, buffer, num_bytes);
+      event_mgr_->ThenExecute(stream_,
+                              [this, buffer]() { IssueNextChunk(buffer); });
+    } else {
+      stream_->ThenMemcpy(buffer, gpu_chunk, num_bytes);
+      event_mgr_->ThenExecute(stream_, [this, buffer, offset, num_bytes]() {
+        memcpy(host_ptr_ + offset, buffer, num_bytes);
+        IssueNextChunk(buffer);
+      });
+    }
+  }
+
+  void Finish() {
+    if (!stream_->ok()) {
+      LOG(FATAL) << (host_to_device_ ? "CPU->GPU" : "GPU->CPU")
+                 << " staged Memcpy failed";
+    }
+    input_ref_.Unref();
+    done_(Status::OK());
+    delete this;
+  }
+
+  const bool host_to_device_;
+  char* const host_ptr_;
+  char* const gpu_ptr_;
+  const int64 total_bytes_;
+  se::Stream* const stream_;
+  EventMgr* const event_mgr_;
+  Allocator* const staging_allocator_;
+  TensorReference input_ref_;
+  StatusCallback done_;
+
+  mutex mu_;
+  int64 next_offset_ TF_GUARDED_BY(mu_) = 0;
+  int num_active_buffers_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Copies `total_bytes` between `host_ptr` and `gpu_ptr` on `stream` through
+// pinned staging buffers if `host_ptr` is large pageable memory. Returns false
+// if the caller should issue the copy directly instead; otherwise `done` is
+// called with the input reference released once the copy is complete.
+bool MaybeStageCopy(bool host_to_device, void* host_ptr, void* gpu_ptr,
+                    int64 total_bytes, se::Stream* stream,
+                    const DeviceBase::GpuDeviceInfo* dev_info,
+                    const TensorReference& input_ref,
+                    const StatusCallback& done) {
+  const int64 min_bytes = StagedCopyMinBytes();
+  if (min_bytes <= 0 || total_bytes < min_bytes) return false;
+  GPUProcessState* process_state = GPUProcessState::singleton();
+  if (process_state->IsGpuHostMemory(host_ptr)) return false;
+  auto* copy = new StagedCopy(
+      host_to_device, static_cast<char*>(host_ptr), static_cast<char*>(gpu_ptr),
+      total_bytes, stream, dev_info->event_mgr,
+      process_state->GetGpuHostAllocator(0), input_ref, done);
+  if (!copy->Start()) {
+    delete copy;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 /*static*/
 void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
                               const DeviceContext* device_context,
@@ -276,14 +451,19 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = gpu_tensor->TotalBytes();
+  // Use of the input may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*gpu_tensor);
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
-    DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     void* dst_ptr = GetBase(cpu_tensor);
+    if (MaybeStageCopy(/*host_to_device=*/false, dst_ptr, src_ptr, total_bytes,
+                       send_device_to_host_stream, dev_info, input_ref,
+                       done)) {
+      return;
+    }
+    DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
   }
-  // Use of the input may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*gpu_tensor);
   dev_info->event_mgr->ThenExecute(
       send_device_to_host_stream,
       [send_device_to_host_stream, done, input_ref]() {
@@ -323,15 +503,20 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   }
 
   const int64 total_bytes = cpu_tensor->TotalBytes();
+  // Use of cpu_tensor may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*cpu_tensor);
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
+    if (MaybeStageCopy(/*host_to_device=*/true, src_ptr, dst_ptr, total_bytes,
+                       recv_host_to_device_stream, dev_info, input_ref,
+                       done)) {
+      return;
+    }
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
     recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
   }
-  // Use of cpu_tensor may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*cpu_tensor);
   dev_info->event_mgr->ThenExecute(
       recv_host_to_device_stream,
       [recv_host_to_device_stream, done, input_ref]() {
@@ -35,7 +35,8 @@ class GPUDeviceContext : public DeviceContext {
 #endif
                    se::Stream* host_to_device_stream,
                    se::Stream* device_to_host_stream,
-                   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream)
+                   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream,
+                   gtl::InlinedVector<se::Stream*, 4> wait_streams = {})
       : stream_id_(stream_id),
         stream_(stream),
 #if TENSORFLOW_USE_ROCM
@@ -43,7 +44,8 @@ class GPUDeviceContext : public DeviceContext {
 #endif
         host_to_device_stream_(host_to_device_stream),
         device_to_host_stream_(device_to_host_stream),
-        device_to_device_stream_(device_to_device_stream) {
+        device_to_device_stream_(device_to_device_stream),
+        wait_streams_(wait_streams) {
   }
 
   ~GPUDeviceContext() override {}
@@ -58,6 +60,11 @@ class GPUDeviceContext : public DeviceContext {
     return device_to_device_stream_[index % device_to_device_stream_.size()];
   }
   int stream_id() const { return stream_id_; }
+  // Streams whose queued work must complete before the kernels of an op using
+  // this context run on stream().
+  const gtl::InlinedVector<se::Stream*, 4>& wait_streams() const {
+    return wait_streams_;
+  }
 
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
@@ -92,6 +99,8 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  // Other compute streams to wait for before launching kernels on stream_.
+  gtl::InlinedVector<se::Stream*, 4> wait_streams_;
 };
 
 }  // namespace tensorflow
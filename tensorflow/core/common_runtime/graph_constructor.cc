@@ -44,6 +44,8 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -57,6 +59,11 @@ namespace {
 // can skip expensive duplicates check in 'AddControlEdge'.
 static constexpr const bool kDoNotCheckDuplicates = true;
 
+// Smaller graphs are not worth preparing their nodes in parallel.
+constexpr int kMinNodesForParallelPreparation = 4096;
+// Rough cost in cycles of looking up, validating and typing one NodeDef.
+constexpr int64 kNodePreparationCost = 10000;
+
 inline bool IsMerge(const NodeDef& node_def) {
   return node_def.op() == "Merge" || node_def.op() == "RefMerge" ||
          node_def.op() == "_XlaMerge";
@@ -97,7 +104,8 @@ class GraphConstructor {
           importing(false),
           validate_nodes(in.validate_nodes),
           validate_colocation_constraints(false),
-          add_default_attributes(in.add_default_attributes) {}
+          add_default_attributes(in.add_default_attributes),
+          num_threads(in.num_threads) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
@@ -149,6 +157,11 @@ class GraphConstructor {
     // value to the Node when they are missing from the NodeDef.
     bool add_default_attributes = true;
 
+    // Number of threads preparing the nodes of large graphs. Only used when
+    // not `importing`, since then NodeDefs are not rewritten before they are
+    // validated.
+    int num_threads = 1;
+
     string default_device;
   };
 
@@ -209,6 +222,7 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  Status PrepareNodesInParallel();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -226,7 +240,10 @@ class GraphConstructor {
            absl::flat_hash_set<int>* unvisited);
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
+  Status PrepareNode(NodeDef&& node_def,
+                     std::shared_ptr<NodeProperties>* props) const;
   Status MakeNode(NodeDef&& node_def, Node** node);
+  Status MakeNode(std::shared_ptr<NodeProperties> props, Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -267,6 +284,13 @@ class GraphConstructor {
   // already unique in the graph.
   string FindUniqueName(StringPiece original_name);
 
+  // Returns the i^th node in the graph for error messages, which must not have
+  // been converted yet. Unlike get_node_def(i), it may have been prepared.
+  const NodeDef& UnconvertedNodeDef(int i) const {
+    return prepared_nodes_.empty() ? get_node_def(i)
+                                   : prepared_nodes_[i]->node_def;
+  }
+
   // Decrement pending count for users of `processed` and add the ones that now
   // have all of their pending inputs satisfied to `ready_`.
   void UpdatePendingCountAndReady(int processed, bool is_next_iteration);
@@ -316,6 +340,10 @@ class GraphConstructor {
   // Intermediate datastructure used to track the destinations of back edges.
   absl::flat_hash_set<int> merge_node_indices_;
 
+  // Properties of the nodes in the graph when they were prepared in parallel,
+  // indexed like node_defs_, or empty. Each entry is moved into its node.
+  std::vector<std::shared_ptr<NodeProperties>> prepared_nodes_;
+
   // Mapping from node name to the index within node_defs_.
   struct NodeInfo {
     explicit NodeInfo(int i) : gdef_index(i), node(nullptr) {}
@@ -772,6 +800,57 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
+Status GraphConstructor::PrepareNode(
+    NodeDef&& node_def, std::shared_ptr<NodeProperties>* props) const {
+  const OpDef* op_def;
+  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
+  if (opts_.add_default_attributes) {
+    AddDefaultsToNodeDef(*op_def, &node_def);
+  }
+  if (opts_.validate_nodes) {
+    TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
+  }
+  DataTypeVector inputs;
+  DataTypeVector outputs;
+  Status s = InOutTypesForNode(node_def, *op_def, &inputs, &outputs);
+  if (!s.ok()) return AttachDef(s, node_def);
+  *props = std::make_shared<NodeProperties>(
+      op_def, std::move(node_def), std::move(inputs), std::move(outputs));
+  return Status::OK();
+}
+
+Status GraphConstructor::PrepareNodesInParallel() {
+  const int num_nodes = node_def_count();
+  if (opts_.importing || opts_.num_threads <= 1 ||
+      num_nodes < kMinNodesForParallelPreparation) {
+    return Status::OK();
+  }
+  std::vector<NodeDef> node_defs(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    node_defs[i] = consume_node_def(i);
+  }
+  std::vector<std::shared_ptr<NodeProperties>> props(num_nodes);
+  std::vector<Status> statuses(num_nodes);
+  {
+    thread::ThreadPool pool(Env::Default(), "graph_constructor",
+                            opts_.num_threads);
+    pool.ParallelFor(num_nodes, kNodePreparationCost,
+                     [&](int64 begin, int64 end) {
+                       for (int64 i = begin; i < end; ++i) {
+                         statuses[i] =
+                             PrepareNode(std::move(node_defs[i]), &props[i]);
+                       }
+                     });
+  }
+  // Reports the error of the first node in the GraphDef, independently of
+  // the scheduling.
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  prepared_nodes_ = std::move(props);
+  return Status::OK();
+}
+
 Status GraphConstructor::MakeNode(NodeDef&& node_def, Node** node) {
   // Add the node to the graph.
   Status status;
@@ -783,6 +862,17 @@ Status GraphConstructor::MakeNode(NodeDef&& node_def, Node** node) {
   return Status::OK();
 }
 
+Status GraphConstructor::MakeNode(std::shared_ptr<NodeProperties> props,
+                                  Node** node) {
+  Status status;
+  *node = g_->AddNode(std::move(props), &status);
+  if (!status.ok()) return status;
+  if (opts_.expect_device_spec) {
+    (*node)->set_assigned_device_name((*node)->def().device());
+  }
+  return Status::OK();
+}
+
 Status GraphConstructor::ValidateShape(Node* node) {
   if (!opts_.importing || !opts_.validate_shape) return Status::OK();
   TF_RETURN_IF_ERROR(refiner_->AddNode(node));
@@ -1071,7 +1161,7 @@ void GraphConstructor::DFS(int cur_node, std::vector<int>* cur_branch,
             std::find(cur_branch->begin(), cur_branch->end(), next_node);
         LOG(WARNING) << "Cycle detected:";
         while (iter != cur_branch->end()) {
-          LOG(WARNING) << SummarizeNodeDef(get_node_def(*iter));
+          LOG(WARNING) << SummarizeNodeDef(UnconvertedNodeDef(*iter));
           ++iter;
         }
         LOG(WARNING) << "End of cycle";
@@ -1113,6 +1203,7 @@ Status GraphConstructor::Convert() {
     // avoid unnecessarily copying `*library()` here.
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
   }
+  TF_RETURN_IF_ERROR(PrepareNodesInParallel());
 
   std::vector<InputInfo> inputs;
   int processed = 0;
@@ -1130,7 +1221,16 @@ Status GraphConstructor::Convert() {
     inputs.clear();
     bool has_data_back_edge = false;
 
-    NodeDef node_def = consume_node_def(o);
+    // A prepared node lends its NodeDef to the loop below until it is added
+    // to the graph.
+    std::shared_ptr<NodeProperties> props;
+    NodeDef node_def;
+    if (prepared_nodes_.empty()) {
+      node_def = consume_node_def(o);
+    } else {
+      props = std::move(prepared_nodes_[o]);
+      node_def = std::move(props->node_def);
+    }
 
     // input_already_exists[i] is true iff the i-th input of the node we're
     // importing refers to a preexisting node in g_ (i.e. input[i] existed prior
@@ -1231,7 +1331,7 @@ Status GraphConstructor::Convert() {
 
     if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
-    } else {
+    } else if (props == nullptr) {
       const OpDef* op_def;
       TF_RETURN_IF_ERROR(
           g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
@@ -1243,7 +1343,12 @@ Status GraphConstructor::Convert() {
       }
     }
 
-    TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    if (props != nullptr) {
+      props->node_def = std::move(node_def);
+      TF_RETURN_IF_ERROR(MakeNode(std::move(props), &node));
+    } else {
+      TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    }
 
     if (opts_.importing) {
       // Use interned original node name so StringPiece remains valid.
@@ -1287,7 +1392,7 @@ Status GraphConstructor::Convert() {
                  << " NODES IN A CYCLE";
     for (int64 i = 0; i < node_def_count(); i++) {
       if (pending_count_[i] != 0) {
-        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(get_node_def(i))
+        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(UnconvertedNodeDef(i))
                      << " WITH PENDING COUNT = " << pending_count_[i];
       }
     }
@@ -52,6 +52,11 @@ struct GraphConstructorOptions {
   // If true, GraphConstructor will add attributes with their default
   // value to the Node when they are missing from the NodeDef.
   bool add_default_attributes = true;
+
+  // If greater than one, the NodeDefs of large graphs are validated and their
+  // input and output types computed on this many threads, before the nodes
+  // are added to the graph and linked in topological order.
+  int num_threads = 1;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
@@ -822,6 +822,51 @@ TEST_F(GraphConstructorTest, TypeMismatch) {
        "expected int32."});
 }
 
+TEST_F(GraphConstructorTest, ConvertLargeGraphInParallel) {
+  const int kNumMuls = 5000;
+  GraphDef gdef;
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  // Lists each node before its inputs, so that the graph must be linked in
+  // topological rather than GraphDef order.
+  for (int i = kNumMuls - 1; i >= 0; --i) {
+    NodeDef* mul = gdef.add_node();
+    mul->set_name(strings::StrCat("mul", i));
+    mul->set_op("TestMul");
+    mul->add_input(i == 0 ? "input" : strings::StrCat("mul", i - 1));
+    mul->add_input("input:1");
+  }
+  NodeDef* default_attr = gdef.add_node();
+  default_attr->set_name("default_attr");
+  default_attr->set_op("TestDefaultAttr");
+
+  GraphConstructorOptions opts;
+  opts.num_threads = 4;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &graph_));
+  EXPECT_EQ(kNumMuls + 4, graph_.num_nodes());
+  EXPECT_TRUE(HasEdge("input", 0, "mul0", 0));
+  EXPECT_TRUE(HasEdge("input", 1, "mul0", 1));
+  EXPECT_TRUE(HasEdge("mul41", 0, "mul42", 0));
+  EXPECT_TRUE(HasEdge("input", 1, "mul4999", 1));
+  Node* node = FindNode("default_attr");
+  ASSERT_TRUE(node != nullptr);
+  int value = 0;
+  TF_EXPECT_OK(GetNodeAttr(node->attrs(), "default_int", &value));
+  EXPECT_EQ(31415, value);
+  EXPECT_EQ(DT_FLOAT, FindNode("mul42")->output_type(0));
+
+  // Errors are reported for the first invalid node, without changing the
+  // graph.
+  Graph graph(OpRegistry::Global());
+  gdef.mutable_node(10)->set_op("DoesNotExist");
+  gdef.mutable_node(20)->add_input("input");
+  Status s = ConvertGraphDefToGraph(opts, gdef, &graph);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(s.error_message().find("DoesNotExist") != string::npos) << s;
+  EXPECT_EQ(2, graph.num_nodes());
+}
+
 TEST_F(GraphConstructorTest, EmptyGraph) {
   ExpectOK("");
   ExpectVersions(0, 0);
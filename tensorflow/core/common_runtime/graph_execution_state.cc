@@ -49,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -62,11 +63,25 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The base graph of a session is converted from the whole GraphDef, so the
+// nodes of large graphs are prepared on all cores.
+GraphConstructorOptions BaseGraphConstructorOptions() {
+  GraphConstructorOptions opts;
+  opts.num_threads = port::MaxParallelism();
+  return opts;
+}
+
+}  // namespace
+
 GraphExecutionState::GraphExecutionState(
     std::unique_ptr<GraphDef>&& graph_def,
     std::unique_ptr<FunctionLibraryDefinition>&& flib_def,
     const GraphExecutionStateOptions& options)
     : stateful_placements_(options.stateful_placements),
+      placement_cost_feedback_(options.placement_cost_feedback),
+      cheap_node_max_compute_micros_(options.cheap_node_max_compute_micros),
       original_graph_def_(std::move(graph_def)),
       device_set_(options.device_set),
       session_options_(options.session_options),
@@ -103,7 +118,8 @@ GraphExecutionState::~GraphExecutionState() {
     // construct a Graph* in this case.
     if (!options.session_options->config.graph_options().place_pruned_graph()) {
       auto base_graph = absl::make_unique<Graph>(OpRegistry::Global());
-      TF_RETURN_IF_ERROR(ConvertGraphDefToGraph({}, *ret->original_graph_def_,
+      TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(BaseGraphConstructorOptions(),
+                                                *ret->original_graph_def_,
                                                 base_graph.get()));
       TF_RETURN_IF_ERROR(ret->InitBaseGraph(std::move(base_graph)));
     }
@@ -112,8 +128,9 @@ GraphExecutionState::~GraphExecutionState() {
     auto ret = absl::WrapUnique(
         new GraphExecutionState(nullptr, std::move(flib_def), options));
     auto base_graph = absl::make_unique<Graph>(OpRegistry::Global());
-    TF_RETURN_IF_ERROR(
-        ConvertGraphDefToGraph({}, std::move(graph_def), base_graph.get()));
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(BaseGraphConstructorOptions(),
+                                              std::move(graph_def),
+                                              base_graph.get()));
     TF_RETURN_IF_ERROR(ret->InitBaseGraph(std::move(base_graph)));
     *out_state = std::move(ret);
   }
@@ -254,6 +271,9 @@ Status GraphExecutionState::Extend(
   combined_options.session_options = session_options_;
   combined_options.session_handle = session_handle_;
   combined_options.stateful_placements = stateful_placements_;
+  combined_options.placement_cost_feedback = placement_cost_feedback_;
+  combined_options.cheap_node_max_compute_micros =
+      cheap_node_max_compute_micros_;
 
   TF_RETURN_IF_ERROR(AddDefaultAttrsToGraphDef(&gdef, *flib_def_, 0));
   auto flib_def = absl::make_unique<FunctionLibraryDefinition>(
@@ -616,6 +636,10 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
                     session_options_->config.allow_soft_placement(),
                 session_options_ != nullptr &&
                     session_options_->config.log_device_placement());
+  if (placement_cost_feedback_ != nullptr) {
+    placer.SetCostFeedback(placement_cost_feedback_,
+                           cheap_node_max_compute_micros_);
+  }
   // TODO(mrry): Consider making the Placer cancellable.
   TF_RETURN_IF_ERROR(placer.Run());
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/build_graph_options.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
@@ -47,6 +48,13 @@ struct GraphExecutionStateOptions {
   // A map from node name to device name, representing the unchangeable
   // placement of stateful nodes.
   std::unordered_map<string, string> stateful_placements;
+  // If non-null, the measured costs of a previous run of the graph, which the
+  // Placer uses to keep cheap nodes on the device of their inputs. See
+  // Placer::SetCostFeedback(). Not owned; must outlive the
+  // GraphExecutionState.
+  const CostGraphDef* placement_cost_feedback = nullptr;
+  // Nodes measured to take at most this long are considered cheap.
+  int64 cheap_node_max_compute_micros = 10;
 };
 
 // A ClientGraph is simply a sub-graph of the full graph as induced by
@@ -171,6 +179,9 @@ class GraphExecutionState {
   // device names.
   std::unordered_map<string, string> stateful_placements_;  // Immutable after
                                                             // ctor.
+  const CostGraphDef* const placement_cost_feedback_;  // Not owned.
+  const int64 cheap_node_max_compute_micros_;
+
   void SaveStatefulNodes(Graph* graph);
   void RestoreStatefulNodes(Graph* graph);
 
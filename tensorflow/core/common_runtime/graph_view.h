@@ -83,6 +83,9 @@ struct NodeItem {
                                                      // node.
   bool is_any_input_ref_typed : 1;  // True iff any IsRefType(dt) for dt in this
                                     // node's input types.
+  bool has_single_pending_input : 1;  // True iff the graph has no control
+                                      // flow and this node waits on exactly
+                                      // one in-edge.
 
   // The kernel for this node.
   OpKernel* kernel = nullptr;
@@ -0,0 +1,315 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Non-negative remainder of `a` divided by `n`.
+int Mod(int a, int n) { return ((a % n) + n) % n; }
+
+// The exec_key differentiates between instances, and the source device
+// between the rings of different tasks that run the same step.
+string HierarchicalBufKey(const string& exec_key, int pass, int step,
+                          int chunk_idx, int source_dev_idx) {
+  return strings::StrCat(exec_key, ":h", pass, ":", step, ":", chunk_idx, ":",
+                         source_dev_idx);
+}
+
+}  // namespace
+
+HierarchicalReducer::HierarchicalReducer() : col_params_(nullptr) {}
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  const CollGroupParams& group = col_params->group;
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HierarchicalReduce only implements reductions");
+  }
+  if (group.num_tasks <= 0 || group.group_size % group.num_tasks != 0) {
+    return errors::InvalidArgument(
+        "HierarchicalReduce requires the same number of devices on every "
+        "task, but group ",
+        group.group_key, " has ", group.group_size, " devices on ",
+        group.num_tasks, " tasks");
+  }
+  const int devs_per_task = group.group_size / group.num_tasks;
+  for (int di = 0; di < group.group_size; ++di) {
+    if (group.task_names[di] !=
+        group.task_names[(di / devs_per_task) * devs_per_task]) {
+      return errors::InvalidArgument(
+          "HierarchicalReduce requires the same number of devices on every "
+          "task, but device ",
+          group.device_names[di], " is not in the expected task");
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like `RingReducer`, this implementation does not require non-overlapping
+  // collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+
+  Status s = RunPhases();
+  if (s.ok()) {
+    ca_->ConsumeFinalValue(col_ctx_->output);
+  } else {
+    LOG(ERROR) << "Aborting HierarchicalReduce with " << s;
+    col_ctx_->col_exec->StartAbort(s);
+  }
+  ca_.reset();
+  tmp_chunks_.clear();
+  done(s);
+}
+
+Status HierarchicalReducer::RunPhases() {
+  const int group_size = col_params_->group.group_size;
+  const int num_tasks = col_params_->group.num_tasks;
+  const int devs_per_task = group_size / num_tasks;
+  // Devices are sorted so that the devices of each task are adjacent.
+  const int dev_idx = col_params_->default_rank;
+  const int task_idx = dev_idx / devs_per_task;
+  const int local_rank = dev_idx % devs_per_task;
+
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, devs_per_task * num_tasks,
+                                  col_ctx_->device->GetAllocator(attr)));
+  tmp_chunks_.clear();
+  tmp_chunks_.reserve(devs_per_task * num_tasks);
+  for (int i = 0; i < devs_per_task * num_tasks; ++i) {
+    tmp_chunks_.push_back(ca_->TempChunk(i));
+  }
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (gpu_info) {
+    // The temp buffers allocated above are not guaranteed to be valid (e.g.
+    // for RDMA write) until the queued work on the compute stream completes.
+    Notification note;
+    TF_RETURN_IF_ERROR(gpu_info->default_context->ThenExecute(
+        col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); }));
+    note.WaitForNotification();
+  }
+
+  // Shard `s` consists of chunks [s * num_tasks, (s + 1) * num_tasks).
+  auto shard_chunks = [num_tasks](int shard) {
+    std::vector<int> chunks;
+    chunks.reserve(num_tasks);
+    for (int t = 0; t < num_tasks; ++t) chunks.push_back(shard * num_tasks + t);
+    return chunks;
+  };
+  const int next_local = task_idx * devs_per_task +
+                         Mod(local_rank + 1, devs_per_task);
+  const int prev_local = task_idx * devs_per_task +
+                         Mod(local_rank - 1, devs_per_task);
+
+  // Phase 1: local reduce-scatter of the shards.
+  for (int step = 0; step < devs_per_task - 1; ++step) {
+    TF_RETURN_IF_ERROR(RingStep(
+        /*pass=*/1, step, shard_chunks(Mod(local_rank - step, devs_per_task)),
+        next_local, shard_chunks(Mod(local_rank - step - 1, devs_per_task)),
+        prev_local, /*reduce=*/true));
+  }
+
+  // Phase 2: all-reduce of the owned shard across tasks.
+  const int owned_shard = Mod(local_rank + 1, devs_per_task);
+  auto owned_chunk = [owned_shard, num_tasks](int t) {
+    return owned_shard * num_tasks + Mod(t, num_tasks);
+  };
+  const int next_task =
+      Mod(task_idx + 1, num_tasks) * devs_per_task + local_rank;
+  const int prev_task =
+      Mod(task_idx - 1, num_tasks) * devs_per_task + local_rank;
+  for (int step = 0; step < num_tasks - 1; ++step) {
+    TF_RETURN_IF_ERROR(RingStep(/*pass=*/2, step,
+                                {owned_chunk(task_idx - step)}, next_task,
+                                {owned_chunk(task_idx - step - 1)}, prev_task,
+                                /*reduce=*/true));
+  }
+  if (col_params_->final_op) {
+    TF_RETURN_IF_ERROR(FinalizeChunk(owned_chunk(task_idx + 1)));
+  }
+  for (int step = 0; step < num_tasks - 1; ++step) {
+    TF_RETURN_IF_ERROR(RingStep(/*pass=*/3, step,
+                                {owned_chunk(task_idx + 1 - step)}, next_task,
+                                {owned_chunk(task_idx - step)}, prev_task,
+                                /*reduce=*/false));
+  }
+
+  // Phase 3: local all-gather of the shards.
+  for (int step = 0; step < devs_per_task - 1; ++step) {
+    TF_RETURN_IF_ERROR(RingStep(
+        /*pass=*/4, step,
+        shard_chunks(Mod(local_rank + 1 - step, devs_per_task)), next_local,
+        shard_chunks(Mod(local_rank - step, devs_per_task)), prev_local,
+        /*reduce=*/false));
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::RingStep(int pass, int step,
+                                     const std::vector<int>& send_chunks,
+                                     int send_to_dev_idx,
+                                     const std::vector<int>& recv_chunks,
+                                     int recv_from_dev_idx, bool reduce) {
+  const CollGroupParams& group = col_params_->group;
+  const string& exec_key = col_ctx_->exec_key;
+  OpKernelContext* op_ctx = col_ctx_->op_ctx;
+  // Chunks at the tail of the tensor may be empty, in which case neither side
+  // of the ring transfers them.
+  std::vector<Tensor> send_tensors;
+  for (int c : send_chunks) {
+    if (ca_->ChunkBytes(c) > 0) send_tensors.push_back(ca_->ChunkAlias(c));
+  }
+  std::vector<int> nonempty_recv_chunks;
+  std::vector<Tensor> recv_tensors;
+  for (int c : recv_chunks) {
+    if (ca_->ChunkBytes(c) == 0) continue;
+    nonempty_recv_chunks.push_back(c);
+    recv_tensors.push_back(reduce ? tmp_chunks_[c] : ca_->ChunkAlias(c));
+  }
+
+  mutex mu;
+  Status status;
+  BlockingCounter pending(send_tensors.size() + recv_tensors.size());
+  auto done = [&mu, &status, &pending](const Status& s) {
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    pending.DecrementCount();
+  };
+  int send_idx = 0;
+  for (int c : send_chunks) {
+    if (ca_->ChunkBytes(c) == 0) continue;
+    col_ctx_->col_exec->remote_access()->PostToPeer(
+        group.device_names[send_to_dev_idx], group.task_names[send_to_dev_idx],
+        HierarchicalBufKey(exec_key, pass, step, c,
+                           col_params_->default_rank),
+        col_ctx_->device, op_ctx->op_device_context(),
+        op_ctx->output_alloc_attr(0), &send_tensors[send_idx++],
+        col_ctx_->device_locality, op_ctx->cancellation_manager(), done);
+  }
+  for (int i = 0; i < nonempty_recv_chunks.size(); ++i) {
+    col_ctx_->col_exec->remote_access()->RecvFromPeer(
+        group.device_names[recv_from_dev_idx],
+        group.task_names[recv_from_dev_idx],
+        col_params_->task.is_local[recv_from_dev_idx],
+        HierarchicalBufKey(exec_key, pass, step, nonempty_recv_chunks[i],
+                           recv_from_dev_idx),
+        col_ctx_->device, op_ctx->op_device_context(),
+        op_ctx->output_alloc_attr(0), &recv_tensors[i],
+        col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/,
+        op_ctx->cancellation_manager(), done);
+  }
+  pending.Wait();
+  TF_RETURN_IF_ERROR(status);
+
+  if (reduce) {
+    for (int i = 0; i < nonempty_recv_chunks.size(); ++i) {
+      Tensor chunk = ca_->ChunkAlias(nonempty_recv_chunks[i]);
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op, &chunk, &recv_tensors[i]));
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::FinalizeChunk(int chunk_idx) {
+  if (ca_->ChunkBytes(chunk_idx) == 0) return Status::OK();
+  Tensor group_size_tensor = ca_->Scalar(col_params_->group.group_size);
+  if (col_params_->group.device_type != "CPU") {
+    Tensor host_value = group_size_tensor;
+    group_size_tensor = ca_->Scalar(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+        AllocationAttributes());
+    Notification note;
+    Status status;
+    col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+        &host_value, col_ctx_->device, &group_size_tensor,
+        [&note, &status](const Status& s) {
+          status = s;
+          note.Notify();
+        });
+    note.WaitForNotification();
+    TF_RETURN_IF_ERROR(status);
+  }
+  Tensor chunk = ca_->ChunkAlias(chunk_idx);
+  return collective_util::ComputeBinOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->final_op, &chunk, &group_size_tensor);
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Hierarchical implementation of collective all-reduce, for groups spanning
+// several tasks that each contribute the same number of devices.
+//
+// With L devices per task and T tasks the tensor is split into L shards of T
+// chunks each, and the reduction runs in three phases of ring steps:
+//  1. A ring reduce-scatter among the L devices of each task, after which the
+//     device with local rank l holds the task-wide sum of shard (l + 1) % L.
+//  2. A ring all-reduce of that shard among the T devices, one per task, that
+//     hold it. Only these rings cross task boundaries, each carries 1/L of
+//     the tensor, and they have T rather than L * T members.
+//  3. A ring all-gather of the shards among the devices of each task.
+//
+// Selected by the "hierarchical" communication hint.
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer();
+  ~HierarchicalReducer() override {}
+
+  // Checks that the devices of every task are adjacent in the group and that
+  // all tasks have the same number of devices.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // No-op for hierarchical reduce.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Runs the three phases on the chunks of `ca_`.
+  Status RunPhases();
+
+  // Performs one ring step: sends `send_chunks` to the device at
+  // `send_to_dev_idx` and receives `recv_chunks` from the device at
+  // `recv_from_dev_idx`. Received chunks are merged into the local value if
+  // `reduce` is true and overwrite it otherwise.
+  Status RingStep(int pass, int step, const std::vector<int>& send_chunks,
+                  int send_to_dev_idx, const std::vector<int>& recv_chunks,
+                  int recv_from_dev_idx, bool reduce);
+
+  // Applies the final op to chunk `chunk_idx`.
+  Status FinalizeChunk(int chunk_idx);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  // Scratch space for the received chunks, indexed like the chunks of `ca_`.
+  std::vector<Tensor> tmp_chunks_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
@@ -0,0 +1,234 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <atomic>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+Status InitializeParams(CollectiveParams* cp) {
+  HierarchicalReducer* reducer = new HierarchicalReducer;
+  core::ScopedUnref unref(reducer);
+  return reducer->InitializeCollectiveParams(cp);
+}
+
+std::unique_ptr<OpKernel> GetKernel(const NodeDef& node, DeviceBase* device) {
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()), node,
+      TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device);
+}
+
+CollectiveParams MakeParams(int num_tasks, int num_devices_per_task) {
+  CollectiveParams cp;
+  cp.name = "test_collective";
+  cp.group.group_key = 5;
+  cp.group.group_size = num_tasks * num_devices_per_task;
+  cp.group.device_type = DEVICE_CPU;
+  cp.group.num_tasks = num_tasks;
+  cp.group.same_num_devices_per_task = true;
+  cp.instance.instance_key = 17;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.impl_details.collective_name = "HierarchicalReduce";
+  for (int ti = 0; ti < num_tasks; ++ti) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+    cp.group.num_devices_per_task[task_name] = num_devices_per_task;
+    for (int di = 0; di < num_devices_per_task; ++di) {
+      cp.group.device_names.push_back(strings::StrCat(task_name, "/cpu:", di));
+      cp.group.task_names.push_back(task_name);
+      // This test runs in a single process so is_local is always true.
+      cp.task.is_local.push_back(true);
+    }
+  }
+  return cp;
+}
+
+class HierarchicalReducerTest : public ::testing::Test {
+ protected:
+  ~HierarchicalReducerTest() override {
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_tasks, int num_devices_per_task) {
+    col_params_ = MakeParams(num_tasks, num_devices_per_task);
+    std::vector<std::unique_ptr<Device>> devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    for (const string& dev_name : col_params_.group.device_names) {
+      devices.push_back(absl::make_unique<ThreadPoolDevice>(
+          sess_opts, dev_name, Bytes(4 << 20), DeviceLocality(),
+          cpu_allocator()));
+    }
+    dev_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(devices));
+    dev_resolver_ = absl::make_unique<DeviceResolverLocal>(dev_mgr_.get());
+    work_queue_ = std::make_shared<UnboundedWorkQueue>(Env::Default(), "test");
+    rma_ = new CollectiveRemoteAccessLocal(dev_mgr_.get(), dev_resolver_.get(),
+                                           kStepId);
+    col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma_, kStepId,
+                                           dev_mgr_.get(), &gpu_ring_order_,
+                                           work_queue_);
+  }
+
+  // Runs the reduction on device `rank` with `tensor` as input and output.
+  Status DoReduce(int rank, Tensor* tensor) {
+    Device* device;
+    TF_CHECK_OK(
+        dev_mgr_->LookupDevice(col_params_.group.device_names[rank], &device));
+    CollectiveParams col_params = col_params_;
+    col_params.default_rank = rank;
+    std::unique_ptr<OpKernel> merge_op = GetBinOp("Add", DT_FLOAT, device);
+    std::unique_ptr<OpKernel> final_op = GetBinOp("Div", DT_FLOAT, device);
+    col_params.merge_op = merge_op.get();
+    col_params.final_op = final_op.get();
+
+    OpKernelContext::Params op_params;
+    op_params.step_id = kStepId;
+    op_params.device = device;
+    op_params.cancellation_manager = &cancellation_manager_;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    inputs.push_back(TensorValue(tensor));
+    op_params.inputs = &inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+        {AllocatorAttributes()});
+    op_params.input_alloc_attrs = &input_aa;
+    DeviceContext* dev_ctx = new DeviceContext;
+    op_params.op_device_context = dev_ctx;
+    int forward_from = 0;
+    op_params.forward_from_array = &forward_from;
+    AllocatorAttributes generic_alloc_attr;
+    op_params.output_attr_array = &generic_alloc_attr;
+    op_params.op_kernel = merge_op.get();
+    OpKernelContext ctx(&op_params, 1);
+
+    string exec_key = strings::StrCat(col_params.instance.instance_key, ":0:0");
+    HierarchicalReducer* reducer = new HierarchicalReducer;
+    core::ScopedUnref unref(reducer);
+    auto col_ctx = std::make_shared<CollectiveContext>(
+        col_exec_, /*nccl_communicator*/ nullptr, dev_mgr_.get(), &ctx,
+        &op_params, col_params, exec_key, kStepId, tensor, tensor);
+    TF_CHECK_OK(reducer->InitializeCollectiveContext(col_ctx));
+    Status status;
+    reducer->Run([&status](Status s) { status = s; });
+    dev_ctx->Unref();
+    return status;
+  }
+
+  void RunTest(int num_tasks, int num_devices_per_task, int tensor_len) {
+    Init(num_tasks, num_devices_per_task);
+    const int group_size = col_params_.group.group_size;
+    col_params_.instance.shape = TensorShape({tensor_len});
+    TF_ASSERT_OK(InitializeParams(&col_params_));
+
+    std::vector<float> expected(tensor_len, 0.0f);
+    std::vector<Tensor> tensors;
+    for (int rank = 0; rank < group_size; ++rank) {
+      Tensor t(DT_FLOAT, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        t.flat<float>()(i) = rank * 10 + i;
+        expected[i] += rank * 10 + i;
+      }
+      tensors.push_back(t);
+    }
+    std::vector<Status> statuses(group_size);
+    std::atomic<int> done(0);
+    for (int rank = 0; rank < group_size; ++rank) {
+      SchedClosure([this, rank, &tensors, &statuses, &done] {
+        statuses[rank] = DoReduce(rank, &tensors[rank]);
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (int rank = 0; rank < group_size; ++rank) {
+      TF_EXPECT_OK(statuses[rank]);
+      for (int i = 0; i < tensor_len; ++i) {
+        EXPECT_FLOAT_EQ(expected[i] / group_size,
+                        tensors[rank].flat<float>()(i))
+            << "Mismatch at device " << rank << " index " << i;
+      }
+    }
+  }
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  string gpu_ring_order_;
+  CollectiveParams col_params_;
+  CancellationManager cancellation_manager_;
+};
+
+TEST_F(HierarchicalReducerTest, InitializeParamsRejectsUnevenTasks) {
+  CollectiveParams cp = MakeParams(2, 2);
+  TF_EXPECT_OK(InitializeParams(&cp));
+  // Move the last device of task 0 to task 1.
+  cp.group.task_names[1] = cp.group.task_names[2];
+  EXPECT_TRUE(errors::IsInvalidArgument(InitializeParams(&cp)));
+}
+
+TEST_F(HierarchicalReducerTest, SingleTask) { RunTest(1, 4, 1001); }
+
+TEST_F(HierarchicalReducerTest, SingleDevicePerTask) { RunTest(3, 1, 1001); }
+
+TEST_F(HierarchicalReducerTest, TwoTasks) { RunTest(2, 4, 4096); }
+
+TEST_F(HierarchicalReducerTest, ThreeTasksShortTensor) { RunTest(3, 2, 7); }
+
+TEST_F(HierarchicalReducerTest, FourTasks) { RunTest(4, 4, 9408); }
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -40,6 +41,9 @@ ImmutableExecutorState::~ImmutableExecutorState() {
       params_.delete_kernel(item->kernel);
     }
   }
+  for (DeviceContext* dc : device_context_map_) {
+    if (dc != nullptr) dc->Unref();
+  }
 }
 
 namespace {
@@ -257,6 +261,10 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
+
+  // Ask the device to assign the nodes to its streams, if it has several.
+  TF_RETURN_IF_ERROR(
+      params_.device->FillContextMap(&graph, &device_context_map_));
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
@@ -370,6 +378,8 @@ void ImmutableExecutorState::InitializePending(const Graph* graph,
     if (!requires_control_flow_) {
       atomic_pending_counts_[id] = max_pending;
     }
+    gview_.node(id)->has_single_pending_input =
+        !requires_control_flow_ && max_pending == 1;
   }
 }
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_view.h"
 #include "tensorflow/core/common_runtime/local_executor_params.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
@@ -101,6 +102,13 @@ class ImmutableExecutorState {
 
   bool requires_control_flow_support() const { return requires_control_flow_; }
 
+  // Returns the DeviceContext the device assigned to the node with the given
+  // id, or nullptr if the device uses a single context for the whole graph.
+  DeviceContext* device_context(int node_id) const {
+    return device_context_map_.empty() ? nullptr
+                                       : device_context_map_[node_id];
+  }
+
   // Copies the pending counts for nodes in this graph to the given array.
   //
   // This method provides a more efficient way of initializing
@@ -155,6 +163,11 @@ class ImmutableExecutorState {
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
+  // Per-node DeviceContexts filled in by Device::FillContextMap(), indexed by
+  // node id. Empty if the device uses a single context. Owns one reference on
+  // each non-null entry.
+  std::vector<DeviceContext*> device_context_map_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableExecutorState);
 };
 
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
@@ -260,5 +261,34 @@ void Benchmark::RunWithRendezvousArgs(
   testing::StopTiming();
 }
 
+std::vector<double> Benchmark::RunRepetitions(int iters, int repetitions) {
+  std::vector<double> seconds;
+  if (!device_ || iters == 0) {
+    return seconds;
+  }
+  Executor::Args args;
+  args.rendezvous = rendez_;
+  args.runner = [this](std::function<void()> closure) {
+    pool_->Schedule(closure);
+  };
+  static const int kWarmupRuns = 3;
+  for (int i = 0; i < kWarmupRuns; ++i) {
+    TF_CHECK_OK(exec_->Run(args));
+  }
+  TF_CHECK_OK(device_->Sync());
+
+  Env* env = Env::Default();
+  seconds.reserve(repetitions);
+  for (int r = 0; r < repetitions; ++r) {
+    const uint64 start_nanos = env->NowNanos();
+    for (int i = 0; i < iters; ++i) {
+      TF_CHECK_OK(exec_->Run(args));
+    }
+    TF_CHECK_OK(device_->Sync());
+    seconds.push_back((env->NowNanos() - start_nanos) * 1e-9);
+  }
+  return seconds;
+}
+
 }  // end namespace test
 }  // end namespace tensorflow
@@ -82,6 +82,12 @@ class Benchmark {
       const std::vector<std::pair<string, Tensor>>& inputs,
       const std::vector<string>& outputs, ::testing::benchmark::State& state);
 
+  // Executes the graph `iters` times in each of `repetitions` repetitions,
+  // after warmup runs, and returns the wall time of each repetition in
+  // seconds. Does not use the timers of the benchmark framework, so that
+  // callers can measure the noise between repetitions themselves.
+  std::vector<double> RunRepetitions(int iters, int repetitions);
+
  private:
   thread::ThreadPool* pool_ = nullptr;  // Not owned.
   Device* device_ = nullptr;            // Not owned.
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <string>
 
 namespace tensorflow {
 
@@ -47,6 +48,25 @@ struct LocalExecutorParams {
                        OpKernel**)>
       create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If positive, the executor records the allocations made through the
+  // device's default allocator during this many successful steps, and then
+  // serves them from a precomputed arena (see `StaticMemoryPlanAllocator`).
+  int static_memory_plan_warmup_steps = 0;
+
+  // If true, the executor records the compute time of each kernel into the
+  // per-op-type latency histogram (see `metrics::GetOpLatencyUsecsCell`).
+  bool record_op_latency = false;
+
+  // If true, the executor captures the work its kernels queue on the device
+  // into a graph for each recurring argument signature, and replays it
+  // instead of running the kernels (see `StepCaptureCache`).
+  bool capture_device_graphs = false;
+
+  // The name of the tf.function whose body the executor runs, if any. The
+  // allocations made by its kernels are attributed to it (see
+  // `ScopedMemoryDebugFunctionAnnotation`).
+  std::string function_name;
 };
 
 }  // end namespace tensorflow
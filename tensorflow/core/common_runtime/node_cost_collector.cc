@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/node_cost_collector.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/env_time.h"
+
+namespace tensorflow {
+namespace {
+
+int64 ComputeTimeNanos(const NodeExecStats& stats) {
+  if (stats.op_end_rel_nanos() > 0) {
+    return stats.op_end_rel_nanos() - stats.op_start_rel_nanos();
+  }
+  if (stats.all_end_rel_nanos() > 0) return stats.all_end_rel_nanos();
+  return stats.all_end_rel_micros() * EnvTime::kMicrosToNanos;
+}
+
+}  // namespace
+
+void NodeCostCollector::AddStep(const StepStats& step_stats) {
+  mutex_lock l(mu_);
+  ++num_steps_;
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& stats : device_stats.node_stats()) {
+      NodeCost& cost =
+          costs_[std::make_pair(device_stats.device(), stats.node_name())];
+      ++cost.num_runs;
+      cost.total_nanos += ComputeTimeNanos(stats);
+      for (const NodeOutput& output : stats.output()) {
+        if (output.slot() < 0) continue;
+        if (output.slot() >= cost.output_bytes.size()) {
+          cost.output_bytes.resize(output.slot() + 1, 0);
+        }
+        int64& bytes = cost.output_bytes[output.slot()];
+        bytes = std::max<int64>(bytes, output.tensor_description()
+                                           .allocation_description()
+                                           .requested_bytes());
+      }
+    }
+  }
+}
+
+int64 NodeCostCollector::num_steps() const {
+  mutex_lock l(mu_);
+  return num_steps_;
+}
+
+RunMetadata NodeCostCollector::Summary() const {
+  RunMetadata run_metadata;
+  StepStats* step_stats = run_metadata.mutable_step_stats();
+  mutex_lock l(mu_);
+  DeviceStepStats* device_stats = nullptr;
+  for (const auto& it : costs_) {
+    const string& device = it.first.first;
+    const NodeCost& cost = it.second;
+    if (device_stats == nullptr || device_stats->device() != device) {
+      device_stats = step_stats->add_dev_stats();
+      device_stats->set_device(device);
+    }
+    NodeExecStats* stats = device_stats->add_node_stats();
+    stats->set_node_name(it.first.second);
+    const int64 nanos = cost.total_nanos / cost.num_runs;
+    stats->set_op_end_rel_nanos(nanos);
+    stats->set_all_end_rel_nanos(nanos);
+    stats->set_op_end_rel_micros(nanos / EnvTime::kMicrosToNanos);
+    stats->set_all_end_rel_micros(nanos / EnvTime::kMicrosToNanos);
+    for (int slot = 0; slot < cost.output_bytes.size(); ++slot) {
+      NodeOutput* output = stats->add_output();
+      output->set_slot(slot);
+      output->mutable_tensor_description()
+          ->mutable_allocation_description()
+          ->set_requested_bytes(cost.output_bytes[slot]);
+    }
+  }
+  return run_metadata;
+}
+
+Status NodeCostCollector::WriteSummary(Env* env, const string& path) const {
+  return WriteBinaryProto(env, path, Summary());
+}
+
+namespace {
+
+mutex registered_node_costs_mu(LINKER_INITIALIZED);
+
+std::shared_ptr<const StepStats>* registered_node_costs
+    TF_GUARDED_BY(registered_node_costs_mu) = nullptr;
+
+}  // namespace
+
+void RegisterNodeCosts(const StepStats& node_costs) {
+  mutex_lock l(registered_node_costs_mu);
+  auto merged = std::make_shared<StepStats>();
+  if (registered_node_costs != nullptr) {
+    *merged = **registered_node_costs;
+  } else {
+    registered_node_costs = new std::shared_ptr<const StepStats>();
+  }
+  // The cost models take the most expensive of the devices a node ran on, so
+  // appending the devices of each model keeps the most expensive node of
+  // each name.
+  merged->MergeFrom(node_costs);
+  *registered_node_costs = std::move(merged);
+}
+
+std::shared_ptr<const StepStats> RegisteredNodeCosts() {
+  mutex_lock l(registered_node_costs_mu);
+  if (registered_node_costs == nullptr) return nullptr;
+  return *registered_node_costs;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_NODE_COST_COLLECTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_NODE_COST_COLLECTOR_H_
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+// Name of the file, in the assets.extra directory of a SavedModel, holding
+// the node costs measured while serving the model.
+constexpr char kNodeCostsFilename[] = "node_costs.pb";
+
+// Aggregates the compute time and output sizes of the nodes over the sampled
+// steps of a session, so that they can be persisted with the model and feed
+// the Grappler cost models when it is loaded again.
+//
+// Thread-safe.
+class NodeCostCollector {
+ public:
+  // Adds the node stats of one step.
+  void AddStep(const StepStats& step_stats);
+
+  int64 num_steps() const;
+
+  // Returns the average compute time and the largest output sizes of each
+  // node on each device, as the step stats of a RunMetadata: the format of
+  // the profiles read by the Grappler cost models (TF_GRAPPLER_PROFILE).
+  RunMetadata Summary() const;
+
+  // Writes Summary() in binary format to `path`.
+  Status WriteSummary(Env* env, const string& path) const;
+
+ private:
+  struct NodeCost {
+    int64 num_runs = 0;
+    int64 total_nanos = 0;
+    // The largest requested bytes of each output, by slot.
+    std::vector<int64> output_bytes;
+  };
+
+  mutable mutex mu_;
+  int64 num_steps_ TF_GUARDED_BY(mu_) = 0;
+  // By device and node name.
+  std::map<std::pair<string, string>, NodeCost> costs_ TF_GUARDED_BY(mu_);
+};
+
+// Registers the node costs of a loaded model, e.g. read from the
+// kNodeCostsFilename of a SavedModel, for the cost models of Grappler. The
+// costs of all the models loaded in the process are merged: for nodes of the
+// same name, the cost models use the most expensive one.
+void RegisterNodeCosts(const StepStats& node_costs);
+
+// Returns the node costs registered so far, or null if there are none.
+std::shared_ptr<const StepStats> RegisteredNodeCosts();
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_NODE_COST_COLLECTOR_H_
@@ -0,0 +1,144 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/numa_partitioned_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+NUMAPartitionedAllocator::NUMAPartitionedAllocator(
+    int num_nodes, size_t per_node_memory_limit, int default_node,
+    const SubAllocatorFactory& sub_allocator_factory, const string& name)
+    : name_(name), default_node_(default_node) {
+  CHECK_GT(num_nodes, 0);
+  CHECK_GE(default_node, 0);
+  CHECK_LT(default_node, num_nodes);
+  arenas_.reserve(num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    // Regions are attributed to the arena that owns them rather than to the
+    // node reported by the SubAllocator, which may be kNUMANoAffinity.
+    SubAllocator* sub_allocator = sub_allocator_factory(
+        node,
+        [this, node](void* ptr, int /*numa_node*/, size_t num_bytes) {
+          AddRegion(ptr, node, num_bytes);
+        },
+        [this](void* ptr, int /*numa_node*/, size_t /*num_bytes*/) {
+          RemoveRegion(ptr);
+        });
+    arenas_.emplace_back(new BFCAllocator(
+        sub_allocator, per_node_memory_limit, true /*allow_growth*/,
+        strings::StrCat(name, "_numa_", node)));
+  }
+  VLOG(1) << "Created " << name << " with " << num_nodes
+          << " NUMA arenas of up to " << per_node_memory_limit
+          << " bytes each";
+}
+
+NUMAPartitionedAllocator::~NUMAPartitionedAllocator() {
+  // Destroy the arenas before `regions_`: destroying an arena frees its
+  // regions, which invokes RemoveRegion().
+  arenas_.clear();
+}
+
+void NUMAPartitionedAllocator::AddRegion(void* ptr, int numa_node,
+                                         size_t num_bytes) {
+  mutex_lock l(regions_mu_);
+  regions_[static_cast<const char*>(ptr)] = Region{num_bytes, numa_node};
+}
+
+void NUMAPartitionedAllocator::RemoveRegion(void* ptr) {
+  mutex_lock l(regions_mu_);
+  regions_.erase(static_cast<const char*>(ptr));
+}
+
+int NUMAPartitionedAllocator::NodeForCurrentThread() const {
+  const int node = port::NUMAGetThreadNodeAffinity();
+  if (node < 0 || node >= num_nodes()) return default_node_;
+  return node;
+}
+
+int NUMAPartitionedAllocator::NodeForPointer(const void* ptr) const {
+  const char* p = static_cast<const char*>(ptr);
+  tf_shared_lock l(regions_mu_);
+  // Find the last region starting at or before `p`.
+  auto it = regions_.upper_bound(p);
+  if (it == regions_.begin()) return -1;
+  --it;
+  if (p >= it->first + it->second.num_bytes) return -1;
+  return it->second.numa_node;
+}
+
+BFCAllocator* NUMAPartitionedAllocator::ArenaForPointer(
+    const void* ptr) const {
+  const int node = NodeForPointer(ptr);
+  CHECK_GE(node, 0) << "Pointer " << ptr << " was not allocated by " << name_;
+  return arenas_[node].get();
+}
+
+void* NUMAPartitionedAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  return arenas_[NodeForCurrentThread()]->AllocateRaw(alignment, num_bytes,
+                                                      allocation_attr);
+}
+
+void NUMAPartitionedAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  ArenaForPointer(ptr)->DeallocateRaw(ptr);
+}
+
+size_t NUMAPartitionedAllocator::RequestedSize(const void* ptr) const {
+  return ArenaForPointer(ptr)->RequestedSize(ptr);
+}
+
+size_t NUMAPartitionedAllocator::AllocatedSize(const void* ptr) const {
+  return ArenaForPointer(ptr)->AllocatedSize(ptr);
+}
+
+int64 NUMAPartitionedAllocator::AllocationId(const void* ptr) const {
+  return ArenaForPointer(ptr)->AllocationId(ptr);
+}
+
+absl::optional<AllocatorStats> NUMAPartitionedAllocator::GetStats() {
+  AllocatorStats total;
+  int64 bytes_limit = 0;
+  for (const auto& arena : arenas_) {
+    absl::optional<AllocatorStats> stats = arena->GetStats();
+    if (!stats) continue;
+    total.num_allocs += stats->num_allocs;
+    total.bytes_in_use += stats->bytes_in_use;
+    total.peak_bytes_in_use += stats->peak_bytes_in_use;
+    total.largest_alloc_size =
+        std::max(total.largest_alloc_size, stats->largest_alloc_size);
+    total.bytes_reserved += stats->bytes_reserved;
+    total.peak_bytes_reserved += stats->peak_bytes_reserved;
+    total.largest_free_block_bytes = std::max(total.largest_free_block_bytes,
+                                              stats->largest_free_block_bytes);
+    if (stats->bytes_limit) bytes_limit += *stats->bytes_limit;
+  }
+  total.bytes_limit = bytes_limit;
+  return total;
+}
+
+void NUMAPartitionedAllocator::ClearStats() {
+  for (const auto& arena : arenas_) arena->ClearStats();
+}
+
+}  // namespace tensorflow
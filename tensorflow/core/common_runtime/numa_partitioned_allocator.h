@@ -0,0 +1,122 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_NUMA_PARTITIONED_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_NUMA_PARTITIONED_ALLOCATOR_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A CPU allocator that keeps one BFCAllocator arena per NUMA node.
+//
+// AllocateRaw() serves the request from the arena of the calling thread's
+// NUMA node (as reported by port::NUMAGetThreadNodeAffinity()), so that a
+// thread pinned to a node gets memory that is local to it. Threads without a
+// node affinity are served from `default_node`. DeallocateRaw() and the size
+// queries find the owning arena from the address, so memory may be freed from
+// any thread.
+//
+// Each arena is backed by a SubAllocator created by `sub_allocator_factory`
+// for its node; the factory receives an extra visitor which it must install
+// on the SubAllocator so that the regions of each arena can be tracked.
+class NUMAPartitionedAllocator : public Allocator {
+ public:
+  typedef std::function<SubAllocator*(int numa_node,
+                                      SubAllocator::Visitor alloc_visitor,
+                                      SubAllocator::Visitor free_visitor)>
+      SubAllocatorFactory;
+
+  // Creates `num_nodes` arenas of at most `per_node_memory_limit` bytes each.
+  NUMAPartitionedAllocator(int num_nodes, size_t per_node_memory_limit,
+                           int default_node,
+                           const SubAllocatorFactory& sub_allocator_factory,
+                           const string& name);
+  ~NUMAPartitionedAllocator() override;
+
+  string Name() override { return name_; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  bool TracksAllocationSizes() const override { return true; }
+
+  size_t RequestedSize(const void* ptr) const override;
+
+  size_t AllocatedSize(const void* ptr) const override;
+
+  int64 AllocationId(const void* ptr) const override;
+
+  // Returns the sum of the per-node stats. `peak_bytes_in_use` and
+  // `peak_bytes_reserved` are the sum of the per-node peaks, which is an upper
+  // bound on the true peak of the whole allocator.
+  absl::optional<AllocatorStats> GetStats() override;
+
+  void ClearStats() override;
+
+  int num_nodes() const { return static_cast<int>(arenas_.size()); }
+
+  // Returns the node whose arena would serve an allocation made by the calling
+  // thread.
+  int NodeForCurrentThread() const;
+
+  // Returns the node whose arena owns `ptr`, or -1 if `ptr` was not allocated
+  // by this allocator.
+  int NodeForPointer(const void* ptr) const;
+
+ private:
+  struct Region {
+    size_t num_bytes;
+    int numa_node;
+  };
+
+  void AddRegion(void* ptr, int numa_node, size_t num_bytes);
+  void RemoveRegion(void* ptr);
+
+  // Returns the arena owning `ptr`. CHECK-fails if there is none.
+  BFCAllocator* ArenaForPointer(const void* ptr) const;
+
+  const string name_;
+  const int default_node_;
+  std::vector<std::unique_ptr<BFCAllocator>> arenas_;
+
+  // Maps the start address of every region handed to an arena by its
+  // SubAllocator to the region's extent. Regions are only added or removed
+  // when an arena grows or shrinks, so lookups take a shared lock.
+  mutable mutex regions_mu_;
+  std::map<const char*, Region> regions_ TF_GUARDED_BY(regions_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NUMAPartitionedAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_NUMA_PARTITIONED_ALLOCATOR_H_
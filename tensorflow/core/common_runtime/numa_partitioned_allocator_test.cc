@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/numa_partitioned_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Builds arenas backed by plain (non-NUMA) memory, so that the test also runs
+// on single-node hosts.
+NUMAPartitionedAllocator::SubAllocatorFactory TestSubAllocatorFactory(
+    std::vector<int>* region_nodes) {
+  return [region_nodes](int numa_node, SubAllocator::Visitor alloc_visitor,
+                        SubAllocator::Visitor free_visitor) {
+    SubAllocator::Visitor record = [region_nodes, numa_node](void*, int,
+                                                             size_t) {
+      region_nodes->push_back(numa_node);
+    };
+    return new BasicCPUAllocator(port::kNUMANoAffinity,
+                                 {std::move(alloc_visitor), record},
+                                 {std::move(free_visitor)});
+  };
+}
+
+TEST(NUMAPartitionedAllocatorTest, AllocatesFromDefaultNode) {
+  std::vector<int> region_nodes;
+  NUMAPartitionedAllocator a(2, 1 << 20, /*default_node=*/1,
+                             TestSubAllocatorFactory(&region_nodes), "test");
+  EXPECT_EQ(2, a.num_nodes());
+  if (port::NUMAGetThreadNodeAffinity() != port::kNUMANoAffinity) {
+    GTEST_SKIP() << "Test thread is pinned to a NUMA node";
+  }
+  EXPECT_EQ(1, a.NodeForCurrentThread());
+
+  void* p = a.AllocateRaw(64, 1024);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(1, a.NodeForPointer(p));
+  EXPECT_EQ(std::vector<int>({1}), region_nodes);
+  EXPECT_EQ(1024, a.RequestedSize(p));
+  EXPECT_LE(1024, a.AllocatedSize(p));
+  EXPECT_LT(0, a.AllocationId(p));
+  a.DeallocateRaw(p);
+}
+
+TEST(NUMAPartitionedAllocatorTest, UnknownPointer) {
+  std::vector<int> region_nodes;
+  NUMAPartitionedAllocator a(2, 1 << 20, /*default_node=*/0,
+                             TestSubAllocatorFactory(&region_nodes), "test");
+  int on_stack = 0;
+  EXPECT_EQ(-1, a.NodeForPointer(&on_stack));
+  void* p = a.AllocateRaw(64, 256);
+  EXPECT_EQ(-1, a.NodeForPointer(&on_stack));
+  a.DeallocateRaw(p);
+  // Deallocating a null pointer is a no-op.
+  a.DeallocateRaw(nullptr);
+}
+
+TEST(NUMAPartitionedAllocatorTest, StatsAreAggregated) {
+  std::vector<int> region_nodes;
+  NUMAPartitionedAllocator a(2, 1 << 20, /*default_node=*/0,
+                             TestSubAllocatorFactory(&region_nodes), "test");
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(a.AllocateRaw(64, 4096));
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(4, stats->num_allocs);
+  EXPECT_EQ(4 * 4096, stats->bytes_in_use);
+  EXPECT_EQ(4096, stats->largest_alloc_size);
+  EXPECT_EQ(2 << 20, *stats->bytes_limit);
+
+  for (void* p : ptrs) a.DeallocateRaw(p);
+  stats = a.GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(4 * 4096, stats->peak_bytes_in_use);
+  a.ClearStats();
+  stats = a.GetStats();
+  EXPECT_EQ(0, stats->num_allocs);
+  EXPECT_EQ(0, stats->peak_bytes_in_use);
+}
+
+}  // namespace
+}  // namespace tensorflow
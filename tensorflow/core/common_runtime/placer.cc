@@ -155,6 +155,59 @@ Placer::Placer(Graph* graph, const string& function_name,
 
 Placer::~Placer() {}
 
+void Placer::SetCostFeedback(const CostGraphDef* cost_graph,
+                             int64 cheap_node_max_compute_micros) {
+  node_costs_.clear();
+  for (const CostGraphDef::Node& node : cost_graph->node()) {
+    node_costs_[node.name()] = &node;
+  }
+  cheap_node_max_compute_micros_ = cheap_node_max_compute_micros;
+}
+
+int Placer::DeviceFromCostFeedback(const Node* node,
+                                   const std::vector<Device*>& devices) const {
+  if (node_costs_.empty() || node->op_def().is_stateful() ||
+      node->num_inputs() == 0) {
+    return -1;
+  }
+  auto it = node_costs_.find(node->name());
+  if (it == node_costs_.end() ||
+      it->second->compute_cost() > cheap_node_max_compute_micros_) {
+    return -1;
+  }
+  int64 output_bytes = 0;
+  for (const auto& output : it->second->output_info()) {
+    output_bytes += output.size();
+  }
+
+  // All data inputs must come from a single, already placed device.
+  int input_device = -1;
+  const Node* input_node = nullptr;
+  int64 input_bytes = 0;
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    if (IsRefType(e->src()->output_type(e->src_output()))) return -1;
+    const int device = e->src()->assigned_device_name_index();
+    if (!e->src()->has_assigned_device_name() ||
+        (input_device != -1 && device != input_device)) {
+      return -1;
+    }
+    input_device = device;
+    input_node = e->src();
+    auto input_it = node_costs_.find(e->src()->name());
+    if (input_it == node_costs_.end() ||
+        e->src_output() >= input_it->second->output_info_size()) {
+      return -1;
+    }
+    input_bytes += input_it->second->output_info(e->src_output()).size();
+  }
+  if (input_node == nullptr || output_bytes > input_bytes ||
+      !CanAssignToDevice(input_node->assigned_device_name(), devices)) {
+    return -1;
+  }
+  return input_device;
+}
+
 Status Placer::Run() {
   if (devices_->devices().empty()) {
     return errors::FailedPrecondition("No devices are registered");
@@ -238,6 +291,16 @@ Status Placer::Run() {
       }
     }
 
+    // Heuristic C: If the node was measured to be cheap, place it with its
+    // inputs, so that its (no larger) outputs cross devices instead of its
+    // inputs. This moves e.g. cheap host-bound ops off an accelerator.
+    if (assigned_device == -1) {
+      assigned_device = DeviceFromCostFeedback(node, *devices);
+      if (assigned_device != -1) {
+        VLOG(2) << "Placing cheap node " << node->name() << " with its inputs";
+      }
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
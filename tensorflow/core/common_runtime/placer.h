@@ -18,7 +18,9 @@ limitations under the License.
 
 #include <string>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -80,6 +82,17 @@ class Placer {
 
   ~Placer();
 
+  // Optionally provides the measured costs of a previous run of this graph,
+  // e.g. the cost graph returned in RunMetadata, keyed by node name. The
+  // Placer then also places a stateless node that was cheap to compute on the
+  // device of its inputs (Heuristic C in Run()) if that does not increase the
+  // number of bytes crossing devices. Nodes without measured costs are placed
+  // as usual.
+  //
+  // "cost_graph" is borrowed by this Placer and must outlive it.
+  void SetCostFeedback(const CostGraphDef* cost_graph,
+                       int64 cheap_node_max_compute_micros);
+
   // Assigns each node in this Placer's graph to a device in its
   // set of devices.
   //
@@ -93,6 +106,11 @@ class Placer {
   bool CanAssignToDevice(const string& candidate_device_name,
                          const std::vector<Device*>& devices) const;
 
+  // Returns the device index of the inputs of "node" if Heuristic C applies to
+  // it, or -1.
+  int DeviceFromCostFeedback(const Node* node,
+                             const std::vector<Device*>& devices) const;
+
   Graph* const graph_;  // Not owned.
   const string function_name_;
   const FunctionLibraryDefinition* const flib_def_;  // Not owned.
@@ -101,6 +119,10 @@ class Placer {
   const bool allow_soft_placement_;
   const bool log_device_placement_;
 
+  // Measured costs by node name. Empty unless SetCostFeedback() was called.
+  absl::flat_hash_map<StringPiece, const CostGraphDef::Node*> node_costs_;
+  int64 cheap_node_max_compute_micros_ = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(Placer);
 };
 
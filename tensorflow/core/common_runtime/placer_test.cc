@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_def_builder_util.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function_testlib.h"
@@ -418,6 +419,47 @@ TEST_F(PlacerTest, TestNoConstraints) {
   EXPECT_DEVICE_TYPE(g, "n2", "FakeGPU");
 }
 
+// Test that measured costs keep cheap nodes on the device of their inputs when
+// that does not increase the bytes crossing devices.
+TEST_F(PlacerTest, TestCostFeedback) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                 b.opts().WithName("cheap"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 1),
+                 b.opts().WithName("expensive"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                 b.opts().WithName("cheap_large_output"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 1),
+                 b.opts().WithName("unmeasured"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  CostGraphDef cost_graph;
+  auto add_node = [&cost_graph](const string& name, int64 compute_cost,
+                                const std::vector<int64>& output_sizes) {
+    CostGraphDef::Node* node = cost_graph.add_node();
+    node->set_name(name);
+    node->set_compute_cost(compute_cost);
+    for (int64 size : output_sizes) node->add_output_info()->set_size(size);
+  };
+  add_node("in", 5, {100, 100});
+  add_node("cheap", 1, {100});
+  add_node("expensive", 1000, {100});
+  add_node("cheap_large_output", 1, {400});
+
+  Placer placer(&g, "", &g.flib_def(), &devices_, nullptr, true, false);
+  placer.SetCostFeedback(&cost_graph, /*cheap_node_max_compute_micros=*/10);
+  TF_EXPECT_OK(placer.Run());
+  EXPECT_DEVICE_TYPE(g, "in", "FakeCPU");
+  EXPECT_COLOCATED(g, "in", "cheap");
+  EXPECT_DEVICE_TYPE(g, "expensive", "FakeGPU");
+  EXPECT_DEVICE_TYPE(g, "cheap_large_output", "FakeGPU");
+  EXPECT_DEVICE_TYPE(g, "unmeasured", "FakeGPU");
+}
+
 // Test that a graph with no constraints but using kernels that have a specified
 // device priority will successfully assign nodes to the device with higher
 // priority
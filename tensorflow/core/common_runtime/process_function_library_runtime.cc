@@ -14,7 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 
+#include <algorithm>
 #include <iterator>
+#include <list>
+#include <memory>
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
@@ -47,9 +50,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/reffed_status_callback.h"
 #if !defined(IS_MOBILE_PLATFORM)
@@ -642,8 +648,117 @@ Status GetGraphAndArgRets(
   return Status::OK();
 }
 
+// Process-wide cache of the optimized and partitioned forms of multi-device
+// functions, keeping the most recently used ones. Its capacity is read from
+// the TF_SHARED_MULTI_DEVICE_FUNCTIONS environment variable on each use, and
+// it is disabled by default.
+template <typename T>
+class SharedMultiDeviceFunctionCache {
+ public:
+  static SharedMultiDeviceFunctionCache* Global() {
+    static SharedMultiDeviceFunctionCache* cache =
+        new SharedMultiDeviceFunctionCache;
+    return cache;
+  }
+
+  bool enabled() const { return Capacity() > 0; }
+
+  std::shared_ptr<const T> Lookup(const string& key) {
+    mutex_lock l(mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+
+  void Insert(const string& key, std::shared_ptr<const T> value) {
+    const int64 capacity = Capacity();
+    mutex_lock l(mu_);
+    if (index_.contains(key)) return;
+    entries_.emplace_front(key, std::move(value));
+    index_[key] = entries_.begin();
+    while (entries_.size() > capacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  using Entries = std::list<std::pair<string, std::shared_ptr<const T>>>;
+
+  static int64 Capacity() {
+    int64 capacity;
+    Status s = ReadInt64FromEnvVar("TF_SHARED_MULTI_DEVICE_FUNCTIONS", 0,
+                                   &capacity);
+    if (!s.ok()) {
+      LOG(WARNING) << "Not sharing multi-device functions: " << s;
+      return 0;
+    }
+    return capacity;
+  }
+
+  mutex mu_;
+  Entries entries_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, typename Entries::iterator> index_
+      TF_GUARDED_BY(mu_);
+};
+
+uint64 DeterministicFingerprint(const protobuf::Message& message) {
+  string serialized;
+  SerializeToStringDeterministic(message, &serialized);
+  return Fingerprint64(serialized);
+}
+
 }  // anonymous namespace
 
+string ProcessFunctionLibraryRuntime::SharedMultiDeviceFunctionKey(
+    const string& function_name, AttrSlice attrs, const FunctionDef& fdef,
+    const FunctionLibraryDefinition& reachable_lib_def,
+    const FunctionLibraryRuntime::InstantiateOptions& options) const {
+  // Collected graphs are only produced when the function is optimized.
+  if (!SharedMultiDeviceFunctionCache<SharedMultiDeviceFunction>::Global()
+           ->enabled() ||
+      options.graph_collector != nullptr) {
+    return "";
+  }
+  // The library is keyed by content rather than by address.
+  FunctionLibraryRuntime::InstantiateOptions key_options = options;
+  key_options.lib_def = nullptr;
+  string key = Canonicalize(function_name, attrs, key_options);
+
+  uint64 library_fingerprint = DeterministicFingerprint(fdef);
+  std::vector<string> function_names = reachable_lib_def.ListFunctionNames();
+  std::sort(function_names.begin(), function_names.end());
+  for (const string& name : function_names) {
+    library_fingerprint = FingerprintCat64(
+        library_fingerprint,
+        DeterministicFingerprint(*reachable_lib_def.Find(name)));
+    library_fingerprint =
+        FingerprintCat64(library_fingerprint,
+                         Fingerprint64(reachable_lib_def.FindGradient(name)));
+  }
+  absl::StrAppend(&key, "|", library_fingerprint, "|",
+                  options.is_component_function, "|",
+                  options.default_device_to_target, "|",
+                  options.optimize_graph_fn != nullptr);
+
+  std::vector<string> composite_devices;
+  for (const auto& composite : options.composite_devices) {
+    composite_devices.push_back(absl::StrCat(
+        composite.first, "=", absl::StrJoin(*composite.second, ",")));
+  }
+  std::sort(composite_devices.begin(), composite_devices.end());
+  absl::StrAppend(&key, "|", absl::StrJoin(composite_devices, ";"));
+
+  std::vector<string> devices;
+  for (const Device* device : device_set()->devices()) {
+    devices.push_back(device->name());
+  }
+  std::sort(devices.begin(), devices.end());
+  absl::StrAppend(&key, "|", absl::StrJoin(devices, ","));
+  return key;
+}
+
 Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     const string& function_name, AttrSlice attrs,
     const FunctionLibraryRuntime::InstantiateOptions& options,
@@ -687,6 +802,30 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
 
   TF_RETURN_IF_ERROR(ValidateMultiDeviceOptions(*fdef, options));
 
+  FunctionLibraryDefinition reachable_lib_def =
+      lib_def->ReachableDefinitions(*fdef);
+  auto* shared_cache =
+      SharedMultiDeviceFunctionCache<SharedMultiDeviceFunction>::Global();
+  const string shared_key = SharedMultiDeviceFunctionKey(
+      function_name, attrs, *fdef, reachable_lib_def, options);
+  if (!shared_key.empty()) {
+    std::shared_ptr<const SharedMultiDeviceFunction> shared =
+        shared_cache->Lookup(shared_key);
+    if (shared != nullptr) {
+      // Another runtime already optimized and partitioned this function, so
+      // only its component functions are instantiated here.
+      VLOG(1) << "Reusing the partitions of MultiDevice function \""
+              << function_name << "\"";
+      auto data = absl::make_unique<MultiDeviceFunctionData>(
+          function_name, function_key, shared->num_outputs,
+          FunctionLibraryDefinition(shared->lib_def), shared->ret_types);
+      data->glue_ = shared->glue;
+      TF_RETURN_IF_ERROR(InstantiateComponentFunctions(options, data.get()));
+      *handle = AddMultiDeviceHandle(std::move(data), function_key);
+      return Status::OK();
+    }
+  }
+
   std::unique_ptr<Graph> graph;
   std::vector<Node*> arg_nodes, ret_nodes;
   std::vector<string> ret_node_names;
@@ -728,7 +867,7 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
 
   auto data = absl::make_unique<MultiDeviceFunctionData>(
       function_name, function_key, ret_node_names.size(),
-      lib_def->ReachableDefinitions(*fdef), std::move(ret_types));
+      std::move(reachable_lib_def), std::move(ret_types));
 
   // Do not run function/graph optimization passes for component functions,
   // since they have already processed the main function.
@@ -894,8 +1033,8 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   gtl::InlinedVector<Status, 4> instantiate_status(subgraph_size);
   BlockingCounter counter(static_cast<int>(subgraph_size));
   auto runner = [this, subgraph_size](std::function<void()> fn) {
-    // NOTE: Only use thread pool to instantiate sub-function when there are
-    // more than 8 sub-functions. We want to avoid cost of switching thread when
+    // NOTE: Only use thread pool to convert sub-function when there are more
+    // than 8 sub-functions. We want to avoid cost of switching thread when
     // there are only a few sub-functions.
     if (default_thread_pool_ != nullptr && subgraph_size > 8) {
       default_thread_pool_->Schedule(fn);
@@ -907,8 +1046,8 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     Status* status = &instantiate_status[i];
     string unique_name = name_generator.GetName();
     ComponentFunctionData* comp_data = &data->glue_[pair.first];
-    runner([this, &pair, dev_set, comp_data, unique_name, data_lib_def,
-            &control_ret, &options, status, &counter, &data] {
+    runner([&pair, dev_set, comp_data, unique_name, data_lib_def, &control_ret,
+            status, &counter] {
       const string& target = pair.first;
 
       const string& device_type =
@@ -931,27 +1070,71 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
         return;
       }
       status->Update(data_lib_def->AddFunctionDef(shard));
-      if (!status->ok()) {
-        counter.DecrementCount();
-        return;
-      }
+      comp_data->name = unique_name;
+      counter.DecrementCount();
+    });
+    i += 1;
+  }
+  counter.Wait();
+  StatusGroup group;
+  for (auto& status : instantiate_status) {
+    group.Update(status);
+  }
+  TF_RETURN_IF_ERROR(group.as_summary_status());
+
+  TF_RETURN_IF_ERROR(InstantiateComponentFunctions(options, data.get()));
+  if (!shared_key.empty()) {
+    shared_cache->Insert(shared_key,
+                         std::make_shared<SharedMultiDeviceFunction>(*data));
+  }
+
+  *handle = AddMultiDeviceHandle(std::move(data), function_key);
+  VLOG(2) << "Instantiated MultiDevice function \"" << function_name
+          << "\" with handle " << *handle;
+  return Status::OK();
+}
+
+Status ProcessFunctionLibraryRuntime::InstantiateComponentFunctions(
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    MultiDeviceFunctionData* data) {
+  const int num_components = data->glue_.size();
+  gtl::InlinedVector<Status, 4> instantiate_status(num_components);
+  BlockingCounter counter(num_components);
+  auto runner = [this, num_components](std::function<void()> fn) {
+    // NOTE: Only use thread pool to instantiate sub-function when there are
+    // more than 8 sub-functions. We want to avoid cost of switching thread when
+    // there are only a few sub-functions.
+    if (default_thread_pool_ != nullptr && num_components > 8) {
+      default_thread_pool_->Schedule(fn);
+    } else {
+      fn();
+    }
+  };
+  int i = 0;
+  for (auto& pair : data->glue_) {
+    Status* status = &instantiate_status[i];
+    const string& target = pair.first;
+    ComponentFunctionData* comp_data = &pair.second;
+    runner([this, &target, comp_data, &options, status, &counter, data] {
       FunctionLibraryRuntime::InstantiateOptions opts;
       opts.executor_type = options.executor_type;
       opts.target = target;
-      opts.lib_def = data_lib_def;
+      opts.lib_def = &data->lib_def_;
       opts.create_kernels_eagerly = options.create_kernels_eagerly;
       opts.state_handle = options.state_handle;
-      auto attrs = AttrSlice(&shard.attr());
-      VLOG(1) << "Start instantiating component function " << unique_name
+      const string& name = comp_data->name;
+      const FunctionDef* shard = data->lib_def_.Find(name);
+      auto attrs = AttrSlice(&shard->attr());
+      VLOG(1) << "Start instantiating component function " << name
               << " on device " << target;
-      VLOG(4) << DebugString(shard);
+      VLOG(4) << DebugString(*shard);
 
       auto* component_handle = new FunctionLibraryRuntime::Handle;
-      auto done = [this, status, unique_name, comp_data, component_handle,
-                   &data, &counter](const Status& s) {
+      auto done = [this, status, name, comp_data, component_handle, data,
+                   &counter](const Status& s) {
         status->Update(s);
 
-        VLOG(1) << "Finished instantiating component function " << unique_name
+        VLOG(1) << "Finished instantiating component function " << name
                 << " with handle " << *component_handle << " status: " << s;
         if (status->ok()) {
           {
@@ -969,12 +1152,12 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
       FunctionLibraryRuntime* flr = GetFLR(opts.target);
       if (flr != nullptr) {
         // Initialize local function synchronously.
-        Status s = flr->Instantiate(unique_name, attrs, opts, component_handle);
+        Status s = flr->Instantiate(name, attrs, opts, component_handle);
         done(s);
       } else {
         opts.ret_indices = comp_data->ret_indices;
         // Initialize remote function asynchronously.
-        InstantiateRemote(unique_name, attrs, opts, component_handle, done);
+        InstantiateRemote(name, attrs, opts, component_handle, done);
       }
     });
     i += 1;
@@ -984,12 +1167,23 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   for (auto& status : instantiate_status) {
     group.Update(status);
   }
-  TF_RETURN_IF_ERROR(group.as_summary_status());
-
-  *handle = AddMultiDeviceHandle(std::move(data), function_key);
-  VLOG(2) << "Instantiated MultiDevice function \"" << function_name
-          << "\" with handle " << *handle;
-  return Status::OK();
+  // A function run by the single-threaded executor entirely on a local
+  // device, without Send/Recv nodes, has no use for a rendezvous.
+  if (options.executor_type == "SINGLE_THREADED_EXECUTOR" &&
+      num_components == 1 && !data->is_cross_process_ &&
+      GetFLR(data->glue_.begin()->first) != nullptr) {
+    const FunctionDef* shard =
+        data->lib_def_.Find(data->glue_.begin()->second.name);
+    data->runs_without_rendezvous_ =
+        shard != nullptr &&
+        std::none_of(shard->node_def().begin(), shard->node_def().end(),
+                     [](const NodeDef& node) {
+                       return node.op() == "_Send" || node.op() == "_Recv" ||
+                              node.op() == "_HostSend" ||
+                              node.op() == "_HostRecv";
+                     });
+  }
+  return group.as_summary_status();
 }
 
 Status ProcessFunctionLibraryRuntime::GetOutputDevices(
@@ -1382,9 +1576,19 @@ void ProcessFunctionLibraryRuntime::Run(
     FunctionLibraryRuntime::Handle handle, gtl::ArraySlice<Tensor> args,
     std::vector<Tensor>* rets,
     FunctionLibraryRuntime::DoneCallback done) const {
+  bool multi_device = false;
+  bool runs_without_rendezvous = false;
+  {
+    tf_shared_lock l(mu_);
+    auto it = mdevice_data_.find(handle);
+    if (it != mdevice_data_.end()) {
+      multi_device = true;
+      runs_without_rendezvous = it->second->runs_without_rendezvous_;
+    }
+  }
   FunctionLibraryRuntime::Options new_opts = opts;
   Rendezvous* created_rendezvous = nullptr;
-  if (!opts.rendezvous) {
+  if (!opts.rendezvous && !runs_without_rendezvous) {
     Status s = CreateRendezvous(opts, &created_rendezvous);
     if (!s.ok()) {
       done(s);
@@ -1414,11 +1618,6 @@ void ProcessFunctionLibraryRuntime::Run(
     delete function_rets;
     done(status);
   };
-  bool multi_device;
-  {
-    tf_shared_lock l(mu_);
-    multi_device = mdevice_data_.find(handle) != mdevice_data_.end();
-  }
   if (multi_device) {
     auto get_component_args = [&args](const ComponentFunctionData& comp_data,
                                       InternalArgs* comp_args) -> Status {
@@ -240,6 +240,9 @@ class ProcessFunctionLibraryRuntime {
   struct ComponentFunctionData {
     // The handle for the instantiated component function.
     FunctionLibraryRuntime::Handle handle;
+    // The name of the component function in the library of the multi-device
+    // function.
+    string name;
     // arg_indices.size() is the number of arguments to the component function.
     // The i-th argument of the component function comes from the
     // `arg_indices[i]`-th argument of the multi-device function.
@@ -272,7 +275,8 @@ class ProcessFunctionLibraryRuntime {
           num_outputs_(num_outputs),
           ret_types_(std::move(ret_types)),
           is_cross_process_(false),
-          has_remote_outputs(false) {}
+          has_remote_outputs(false),
+          runs_without_rendezvous_(false) {}
 
     const string function_name_;
     const string function_key_;
@@ -288,12 +292,33 @@ class ProcessFunctionLibraryRuntime {
     bool is_cross_process_;
     // Indicates whether this function has remote outputs.
     bool has_remote_outputs;
+    // Indicates whether this function can never use a rendezvous, i.e. it
+    // has a single local component function without Send/Recv nodes.
+    bool runs_without_rendezvous_;
 
     // Maps the device name to the information about the component function
     // be run on this device.
     std::unordered_map<string, ComponentFunctionData> glue_;
   };
 
+  // The optimized and partitioned form of a multi-device function, before its
+  // component functions are instantiated on their runtimes. It only depends on
+  // the function library, the instantiation options and the devices, so it can
+  // be shared by all runtimes of the process.
+  struct SharedMultiDeviceFunction {
+    explicit SharedMultiDeviceFunction(const MultiDeviceFunctionData& data)
+        : lib_def(data.lib_def_),
+          num_outputs(data.num_outputs_),
+          ret_types(data.ret_types_),
+          glue(data.glue_) {}
+
+    const FunctionLibraryDefinition lib_def;
+    const int num_outputs;
+    const DataTypeVector ret_types;
+    // The handles of the component functions are not meaningful.
+    std::unordered_map<string, ComponentFunctionData> glue;
+  };
+
   struct CleanUpItem {
     string device;
     uint64 step_id;
@@ -367,6 +392,20 @@ class ProcessFunctionLibraryRuntime {
       const FunctionLibraryRuntime::InstantiateOptions& options,
       FunctionLibraryRuntime::Handle* handle);
 
+  // Instantiates the component functions in `data->glue_` on their devices,
+  // and sets their handles.
+  Status InstantiateComponentFunctions(
+      const FunctionLibraryRuntime::InstantiateOptions& options,
+      MultiDeviceFunctionData* data);
+
+  // Returns the key under which the optimized and partitioned form of
+  // `function_name` is shared across runtimes, or an empty string if it must
+  // not be shared.
+  string SharedMultiDeviceFunctionKey(
+      const string& function_name, AttrSlice attrs, const FunctionDef& fdef,
+      const FunctionLibraryDefinition& reachable_lib_def,
+      const FunctionLibraryRuntime::InstantiateOptions& options) const;
+
   void InstantiateRemote(
       const string& function_name, AttrSlice attrs,
       const FunctionLibraryRuntime::InstantiateOptions& options,
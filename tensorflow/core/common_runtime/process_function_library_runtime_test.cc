@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 
+#include <stdlib.h>
+
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -1012,6 +1014,68 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_CreateKernelsEagerly) {
   EXPECT_TRUE(errors::IsInternal(status));
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_SharedAcrossRuntimes) {
+  int num_optimizations = 0;
+  auto inst_opts = MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"});
+  inst_opts.optimize_graph_fn =
+      [&num_optimizations](std::vector<string>, std::vector<string>,
+                           FunctionLibraryDefinition*, const DeviceSet&,
+                           Device*, std::unique_ptr<Graph>*) {
+        ++num_optimizations;
+        return Status::OK();
+      };
+  auto run_on_new_runtime = [this, &inst_opts]() {
+    Init({test::function::XTimesTwo()});
+    auto x = test::AsTensor<float>({1, 2, 3, 4});
+    Tensor y;
+    TF_CHECK_OK(Run("XTimesTwo", FunctionLibraryRuntime::Options(),
+                    {{"T", DT_FLOAT}}, inst_opts, {x}, {&y}));
+    test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
+  };
+
+  setenv("TF_SHARED_MULTI_DEVICE_FUNCTIONS", "16", /*overwrite=*/1);
+  run_on_new_runtime();
+  EXPECT_EQ(1, num_optimizations);
+  // Another runtime reuses the partitions of the same function.
+  run_on_new_runtime();
+  EXPECT_EQ(1, num_optimizations);
+  // Different devices are partitioned again.
+  inst_opts.target = "CPU:1";
+  inst_opts.input_devices = CompleteDevices({"CPU:1"});
+  inst_opts.output_devices = CompleteDevices({"CPU:1"});
+  run_on_new_runtime();
+  EXPECT_EQ(2, num_optimizations);
+
+  unsetenv("TF_SHARED_MULTI_DEVICE_FUNCTIONS");
+  run_on_new_runtime();
+  EXPECT_EQ(3, num_optimizations);
+}
+
+TEST_F(ProcessFunctionLibraryRuntimeTest,
+       MultiDevice_SingleThreadedExecutorWithoutRendezvous) {
+  Init({test::function::XTimesTwo()});
+  auto inst_opts = MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"});
+  inst_opts.executor_type = "SINGLE_THREADED_EXECUTOR";
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(Instantiate("XTimesTwo", {{"T", DT_FLOAT}}, inst_opts, &handle));
+
+  auto x = test::AsTensor<float>({1, 2, 3, 4});
+  std::vector<Tensor> out;
+  Notification done;
+  Status status;
+  proc_flr_->Run(FunctionLibraryRuntime::Options(), handle, {x}, &out,
+                 [&status, &done](const Status& s) {
+                   status = s;
+                   done.Notify();
+                 });
+  done.WaitForNotification();
+  TF_CHECK_OK(status);
+  ASSERT_EQ(1, out.size());
+  test::ExpectTensorEqual<float>(out[0], test::AsTensor<float>({2, 4, 6, 8}));
+  // The single local component cannot contain Send/Recv nodes.
+  EXPECT_TRUE(rendezvous_ref_counts_.empty());
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_StateHandle) {
   auto T = DT_INT32;
   // The expected sequence of outputs from this function is [6, 4, 0, 1, ...].
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/process_state.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 #include <vector>
 
 #include "absl/base/call_once.h"
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/numa_partitioned_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -44,7 +47,73 @@ namespace tensorflow {
 }
 
 ProcessState::ProcessState()
-    : numa_enabled_(false), cpu_allocators_cached_(0) {}
+    : numa_enabled_(false),
+      cpu_allocators_cached_(0),
+      numa_partitioned_cpu_allocator_(nullptr) {}
+
+namespace {
+
+// Returns true iff GetCPUAllocator(kNUMANoAffinity) should return a
+// NUMAPartitionedAllocator.
+bool UseNUMAPartitionedCPUAllocator() {
+  static const bool use_numa_partitioned = [] {
+    bool value = false;
+    Status status = ReadBoolFromEnvVar("TF_CPU_ALLOCATOR_NUMA_PARTITIONED",
+                                       false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+    }
+    return value && port::NUMAEnabled() && port::NUMANumNodes() > 1;
+  }();
+  return use_numa_partitioned;
+}
+
+}  // namespace
+
+Allocator* ProcessState::GetNUMAPartitionedCPUAllocator() {
+  Allocator* allocator =
+      numa_partitioned_cpu_allocator_.load(std::memory_order_acquire);
+  if (allocator != nullptr) return allocator;
+
+  mutex_lock lock(mu_);
+  allocator = numa_partitioned_cpu_allocator_.load(std::memory_order_relaxed);
+  if (allocator != nullptr) return allocator;
+
+  const int num_nodes = port::NUMANumNodes();
+  int64 cpu_mem_limit_in_mb = -1;
+  Status status = ReadInt64FromEnvVar("TF_CPU_BFC_MEM_LIMIT_IN_MB",
+                                      1LL << 16 /*64GB max by default*/,
+                                      &cpu_mem_limit_in_mb);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+  }
+  const int64 per_node_mem_limit =
+      cpu_mem_limit_in_mb * (1LL << 20) / num_nodes;
+  std::vector<SubAllocator::Visitor> alloc_visitors = cpu_alloc_visitors_;
+  std::vector<SubAllocator::Visitor> free_visitors = cpu_free_visitors_;
+  allocator = new NUMAPartitionedAllocator(
+      num_nodes, per_node_mem_limit, /*default_node=*/0,
+      [alloc_visitors, free_visitors](int numa_node,
+                                      SubAllocator::Visitor alloc_visitor,
+                                      SubAllocator::Visitor free_visitor) {
+        std::vector<SubAllocator::Visitor> node_alloc_visitors =
+            alloc_visitors;
+        node_alloc_visitors.push_back(std::move(alloc_visitor));
+        std::vector<SubAllocator::Visitor> node_free_visitors = free_visitors;
+        node_free_visitors.push_back(std::move(free_visitor));
+        return new BasicCPUAllocator(numa_node, node_alloc_visitors,
+                                     node_free_visitors);
+      },
+      "numa_partitioned_cpu_allocator");
+  VLOG(2) << "Using NUMAPartitionedAllocator with " << num_nodes
+          << " nodes and a memory limit of " << cpu_mem_limit_in_mb
+          << " MB for ProcessState CPU allocator";
+  if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
+    allocator = new TrackingAllocator(allocator, true);
+  }
+  numa_partitioned_cpu_allocator_.store(allocator, std::memory_order_release);
+  return allocator;
+}
 
 string ProcessState::MemDesc::DebugString() {
   return strings::StrCat((loc == CPU ? "CPU " : "GPU "), dev_index,
@@ -62,6 +131,9 @@ ProcessState::MemDesc ProcessState::PtrType(const void* ptr) {
 }
 
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
+  if (numa_node == port::kNUMANoAffinity && UseNUMAPartitionedCPUAllocator()) {
+    return GetNUMAPartitionedCPUAllocator();
+  }
   if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
 
   // Check if allocator for the numa node is in lock-free cache.
@@ -100,11 +172,26 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       DCHECK(sub_allocator);
-      allocator =
+      BFCAllocator* bfc_allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
                            "bfc_cpu_allocator_for_gpu" /*name*/);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
+      int64 thread_cache_kb = 0;
+      status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_LOCAL_CACHE_KB", 0,
+                                   &thread_cache_kb);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      if (thread_cache_kb > 0) {
+        // Only cache chunks small enough that several of them fit in a
+        // thread's cache.
+        const size_t max_cached_bytes_per_thread = thread_cache_kb << 10;
+        bfc_allocator->EnableThreadLocalCache(
+            std::min<size_t>(64 << 10, max_cached_bytes_per_thread / 4),
+            max_cached_bytes_per_thread);
+      }
+      allocator = bfc_allocator;
     } else if (sub_allocator) {
       DCHECK(sub_allocator);
       allocator =
@@ -140,6 +227,9 @@ void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
   CHECK_EQ(0, cpu_allocators_.size())  // Crash OK
       << "AddCPUAllocVisitor must be called prior to first call to "
          "ProcessState::GetCPUAllocator";
+  CHECK(numa_partitioned_cpu_allocator_.load() == nullptr)  // Crash OK
+      << "AddCPUAllocVisitor must be called prior to first call to "
+         "ProcessState::GetCPUAllocator";
   cpu_alloc_visitors_.push_back(std::move(visitor));
 }
 
@@ -148,6 +238,9 @@ void ProcessState::AddCPUFreeVisitor(SubAllocator::Visitor visitor) {
   CHECK_EQ(0, cpu_allocators_.size())  // Crash OK
       << "AddCPUFreeVisitor must be called prior to first call to "
          "ProcessState::GetCPUAllocator";
+  CHECK(numa_partitioned_cpu_allocator_.load() == nullptr)  // Crash OK
+      << "AddCPUFreeVisitor must be called prior to first call to "
+         "ProcessState::GetCPUAllocator";
   cpu_free_visitors_.push_back(std::move(visitor));
 }
 
@@ -160,6 +253,7 @@ void ProcessState::TestOnlyReset() {
     if (a != default_cpu_allocator) delete a;
   }
   cpu_allocators_.clear();
+  delete numa_partitioned_cpu_allocator_.exchange(nullptr);
   for (Allocator* a : cpu_al_) {
     delete a;
   }
@@ -64,7 +64,11 @@ class ProcessState : public ProcessStateInterface {
   MemDesc PtrType(const void* ptr);
 
   // Returns the one CPUAllocator used for the given numa_node.
-  // Treats numa_node == kNUMANoAffinity as numa_node == 0.
+  // Treats numa_node == kNUMANoAffinity as numa_node == 0, unless the
+  // environment variable TF_CPU_ALLOCATOR_NUMA_PARTITIONED is true and the
+  // host has more than one NUMA node, in which case a NUMAPartitionedAllocator
+  // is returned that serves each allocation from the arena of the calling
+  // thread's NUMA node.
   Allocator* GetCPUAllocator(int numa_node) override;
 
   // Registers alloc visitor for the CPU allocator(s).
@@ -91,6 +95,9 @@ class ProcessState : public ProcessStateInterface {
   // cleaning up everything. Never use in production.
   void TestOnlyReset();
 
+  // Returns the NUMA-partitioned CPU allocator, creating it on first use.
+  Allocator* GetNUMAPartitionedCPUAllocator();
+
   static ProcessState* instance_;
   bool numa_enabled_;
 
@@ -109,6 +116,10 @@ class ProcessState : public ProcessStateInterface {
   std::atomic<int> cpu_allocators_cached_;
   std::array<Allocator*, 8> cpu_allocators_cache_;
 
+  // Created on first use by GetNUMAPartitionedCPUAllocator(). Published with
+  // release semantics so that it can be read without locking `mu_`.
+  std::atomic<Allocator*> numa_partitioned_cpu_allocator_;
+
   // Optional RecordingAllocators that wrap the corresponding
   // Allocators for runtime attribute use analysis.
   MDMap mem_desc_map_;
@@ -29,10 +29,14 @@ namespace tensorflow {
 // session.
 class RenamedDevice : public Device {
  public:
+  // If `default_allocator` is not null, it serves the requests for allocators
+  // with default attributes instead of the underlying device's allocator. It
+  // is not owned and must outlive the renamed device.
   static std::unique_ptr<Device> NewRenamedDevice(
       const string& new_base, Device* underlying, bool owns_underlying,
       bool isolate_session_state,
-      thread::ThreadPoolInterface* underlying_threadpool = nullptr);
+      thread::ThreadPoolInterface* underlying_threadpool = nullptr,
+      Allocator* default_allocator = nullptr);
 
   ~RenamedDevice() override;
 
@@ -55,6 +59,9 @@ class RenamedDevice : public Device {
   }
 
   Allocator* GetAllocator(AllocatorAttributes attr) override {
+    if (default_allocator_ != nullptr && attr.value == 0) {
+      return default_allocator_;
+    }
     return underlying_device_->GetAllocator(attr);
   }
 
@@ -152,10 +159,12 @@ class RenamedDevice : public Device {
  private:
   RenamedDevice(Device* underlying, const DeviceAttributes& attributes,
                 bool owns_underlying, bool isolate_session_state,
-                thread::ThreadPoolInterface* underlying_threadpool);
+                thread::ThreadPoolInterface* underlying_threadpool,
+                Allocator* default_allocator);
   Device* const underlying_device_;
   const bool owns_underlying_device_;
   const bool isolate_session_state_;
+  Allocator* const default_allocator_;  // Not owned; may be null.
 
   std::unique_ptr<thread::ThreadPool> underlying_threadpool_;
   // eigen_worker_threads_ is stored here so that we can pass the pointer
@@ -28,7 +28,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -384,11 +386,21 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
   int send_to_rank = (rf->rank + 1) % group_size_;
   int send_to_dev_idx = col_params_->instance.impl_details
                             .subdiv_permutations[rf->subdiv_idx][send_to_rank];
+  Tensor* send_tensor = &rf->chunk;
+  if (wire_data_type_ != DT_INVALID) {
+    rf->wire_chunk = Tensor(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0)),
+        wire_data_type_, rf->chunk.shape());
+    CompressChunk(rf->chunk, &rf->wire_chunk);
+    metrics::RecordCollectiveCompressedBytes(rf->chunk.TotalBytes(),
+                                             rf->wire_chunk.TotalBytes());
+    send_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->remote_access()->PostToPeer(
       col_params_->group.device_names[send_to_dev_idx],
       col_params_->group.task_names[send_to_dev_idx], send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0), send_tensor,
       col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
       done);
 }
@@ -404,6 +416,17 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  StatusCallback recv_done = done;
+  if (wire_data_type_ != DT_INVALID) {
+    rf->wire_chunk = Tensor(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0)),
+        wire_data_type_, dst_tensor->shape());
+    recv_done = [rf, dst_tensor, done](const Status& s) {
+      if (s.ok()) DecompressChunk(rf->wire_chunk, dst_tensor);
+      done(s);
+    };
+    dst_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->group.device_names[rf->recv_dev_idx],
       col_params_->group.task_names[rf->recv_dev_idx],
@@ -411,7 +434,30 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
       col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
       col_ctx_->device_locality, rf->subdiv_idx,
-      col_ctx_->op_ctx->cancellation_manager(), done);
+      col_ctx_->op_ctx->cancellation_manager(), recv_done);
+}
+
+/*static*/ void RingAlg::CompressChunk(const Tensor& src, Tensor* dst) {
+  const float* src_data = src.unaligned_flat<float>().data();
+  if (dst->dtype() == DT_BFLOAT16) {
+    RoundFloatToBFloat16(src_data, dst->unaligned_flat<bfloat16>().data(),
+                         src.NumElements());
+  } else {
+    DCHECK_EQ(dst->dtype(), DT_HALF);
+    dst->unaligned_flat<Eigen::half>() =
+        src.unaligned_flat<float>().cast<Eigen::half>();
+  }
+}
+
+/*static*/ void RingAlg::DecompressChunk(const Tensor& src, Tensor* dst) {
+  if (src.dtype() == DT_BFLOAT16) {
+    BFloat16ToFloat(src.unaligned_flat<bfloat16>().data(),
+                    dst->unaligned_flat<float>().data(), src.NumElements());
+  } else {
+    DCHECK_EQ(src.dtype(), DT_HALF);
+    dst->unaligned_flat<float>() =
+        src.unaligned_flat<Eigen::half>().cast<float>();
+  }
 }
 
 string RingAlg::FieldState() {
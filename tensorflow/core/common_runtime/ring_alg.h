@@ -81,6 +81,7 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // chunk converted to wire_data_type_ for transfer
     Status status;
     string DebugString() const;
   };
@@ -90,6 +91,10 @@ class RingAlg : public CollectiveImplementationInterface {
   void DispatchSend(RingField* rf, const StatusCallback& done);
   void DispatchRecv(RingField* rf, const StatusCallback& done);
 
+  // Convert a DT_FLOAT chunk to and from `wire_data_type_`.
+  static void CompressChunk(const Tensor& src, Tensor* dst);
+  static void DecompressChunk(const Tensor& src, Tensor* dst);
+
   // For constructing log messages for debugging.
   string FieldState();
   string TensorDebugString(const Tensor& tensor);
@@ -120,6 +125,10 @@ class RingAlg : public CollectiveImplementationInterface {
   mutex status_mu_;
   Status status_ TF_GUARDED_BY(status_mu_);
   std::vector<RingField> rfv_;
+  // If not DT_INVALID, chunks are converted from DT_FLOAT to this type on the
+  // sending side and back on the receiving side. Only DT_HALF and DT_BFLOAT16
+  // on host-memory tensors are supported.
+  DataType wire_data_type_ = DT_INVALID;
 };
 
 }  // namespace tensorflow
@@ -42,6 +42,17 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
+namespace {
+
+// Returns the type in which chunks are sent for `communication_hint`, or
+// DT_INVALID if they are sent uncompressed.
+DataType WireDataType(const string& communication_hint) {
+  if (communication_hint == "ring_fp16") return DT_HALF;
+  if (communication_hint == "ring_bf16") return DT_BFLOAT16;
+  return DT_INVALID;
+}
+
+}  // namespace
 
 RingReducer::~RingReducer() { group_size_tensor_ready_.WaitForNotification(); }
 
@@ -49,6 +60,17 @@ Status RingReducer::InitializeCollectiveParams(CollectiveParams* col_params) {
   // TODO(b/113171733): change CHECKs to return errors.
   CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
   CHECK_EQ(col_params->instance.impl_details.collective_name, "RingReduce");
+  const string& hint = col_params->instance.impl_details.communication_hint;
+  if (WireDataType(hint) != DT_INVALID &&
+      (col_params->instance.data_type != DT_FLOAT ||
+       col_params->group.device_type != DEVICE_CPU)) {
+    return errors::InvalidArgument(
+        "Communication hint ", hint,
+        " requires a DT_FLOAT reduction on CPU devices, got ",
+        DataTypeString(col_params->instance.data_type), " on ",
+        col_params->group.device_type.type_string(), " devices in ",
+        col_params->name);
+  }
   return RingAlg::InitializeCollectiveParams(col_params);
 }
 
@@ -64,6 +86,8 @@ void RingReducer::Run(StatusCallback done) {
   num_subdivs_ = static_cast<int>(
       col_params_->instance.impl_details.subdiv_permutations.size());
   CHECK_GT(num_subdivs_, 0);
+  wire_data_type_ =
+      WireDataType(col_params_->instance.impl_details.communication_hint);
 
   if (VLOG_IS_ON(1)) {
     string buf;
@@ -28,6 +28,11 @@ namespace tensorflow {
 class Device;
 
 // Ring-algorithm implementation of collective all-reduce.
+//
+// The communication hints "ring_fp16" and "ring_bf16" make a DT_FLOAT
+// reduction on CPU devices send its chunks as DT_HALF or DT_BFLOAT16, halving
+// the bytes on the wire. Partial sums are accumulated in DT_FLOAT on every
+// device, so only the transfers lose precision.
 class RingReducer : public RingAlg {
  public:
   RingReducer() : RingAlg(REDUCTION_COLLECTIVE, "Reduce") {}
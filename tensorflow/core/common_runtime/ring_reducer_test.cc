@@ -367,6 +367,41 @@ class RingReducerTest : public ::testing::Test {
     }
   }
 
+  // Runs a DT_FLOAT reduction on CPU devices that sends its chunks compressed
+  // according to `communication_hint`.
+  void RunCompressedTest(const string& communication_hint, int num_workers,
+                         int num_devices, int tensor_len) {
+    Init(num_workers, num_devices, DT_FLOAT, DEVICE_CPU, /*num_subdivs=*/1,
+         /*fail_after=*/0);
+    const int group_size = num_workers * num_devices;
+    std::vector<float> expected(tensor_len, 0.0f);
+    for (int di = 0; di < group_size; ++di) {
+      DeviceInstance* instance = instances_[di];
+      instance->col_params_.instance.impl_details.communication_hint =
+          communication_hint;
+      instance->InitTensor(DT_FLOAT, TensorShape({tensor_len}),
+                           [&expected, di](Tensor* t) {
+                             for (int i = 0; i < t->NumElements(); ++i) {
+                               float value = 0.25f * (di + i % 7);
+                               t->flat<float>()(i) = value;
+                               expected[i] += value;
+                             }
+                           });
+    }
+    Reduce(/*fail_after=*/0);
+    for (int di = 0; di < group_size; ++di) {
+      TF_EXPECT_OK(instances_[di]->status_);
+      const Tensor& actual = instances_[di]->tensor_;
+      for (int i = 0; i < tensor_len; ++i) {
+        // The partial sum is rounded once per hop of the ring, and the final
+        // value once more on its way back.
+        const float want = expected[i] / group_size;
+        EXPECT_NEAR(want, actual.flat<float>()(i), 2e-2 * want)
+            << "Mismatch at device " << di << " index " << i;
+      }
+    }
+  }
+
   std::unique_ptr<OpKernel> GetCollectiveReduce(const CollectiveParams& params,
                                                 Tensor* input,
                                                 const DeviceType& device_type,
@@ -406,6 +441,14 @@ class RingReducerTest : public ::testing::Test {
     reducer->group_size_tensor_ready_.Notify();  // To unblock destructor.
   }
 
+  Status InitializeParams(CollectiveParams* cp) {
+    RingReducer* reducer = new RingReducer;
+    core::ScopedUnref unref(reducer);
+    Status status = reducer->InitializeCollectiveParams(cp);
+    reducer->group_size_tensor_ready_.Notify();  // To unblock destructor.
+    return status;
+  }
+
   class DeviceInstance {
    public:
     DeviceInstance(int rank, const string& dev_name,
@@ -661,6 +704,26 @@ TEST_F(RingReducerTest, AutomaticSubdivUpperBound) {
   RunSubdivPermsTest(&cp, {{0, 1, 2, 3}, {0, 1, 2, 3}}, {0, 0});
 }
 
+TEST_F(RingReducerTest, CompressionRequiresFloatOnCpu) {
+  CollectiveParams cp = SetUpCollectiveParams(2, 2);
+  cp.instance.impl_details.communication_hint = "ring_fp16";
+  // SetUpCollectiveParams places the group on GPU devices.
+  EXPECT_TRUE(errors::IsInvalidArgument(InitializeParams(&cp)));
+  cp.group.device_type = DeviceType(DEVICE_CPU);
+  cp.instance.data_type = DT_DOUBLE;
+  EXPECT_TRUE(errors::IsInvalidArgument(InitializeParams(&cp)));
+}
+
+#if !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+TEST_F(RingReducerTest, Fp16WireCompression) {
+  RunCompressedTest("ring_fp16", 2, 4, 1001);
+}
+
+TEST_F(RingReducerTest, Bf16WireCompression) {
+  RunCompressedTest("ring_bf16", 2, 4, 4096);
+}
+#endif
+
 // TODO(b/113171733): change to use TEST_P.
 #define DEF_TEST(B, T, W, D, S, L, A)                                         \
   TEST_F(RingReducerTest,                                                     \
@@ -45,6 +45,11 @@ SimplePropagatorState::SimplePropagatorState(
 
 SimplePropagatorState::~SimplePropagatorState() {}
 
+void SimplePropagatorState::Reset(int64 step_id) {
+  step_id_ = step_id;
+  immutable_state_.copy_pending_counts(pending_.get());
+}
+
 void SimplePropagatorState::ActivateRoots(
     gtl::ArraySlice<const NodeItem*> roots, TaggedNodeSeq* ready) {
   for (const NodeItem* item : roots) {
@@ -89,17 +94,11 @@ void SimplePropagatorState::PropagateOutputs(const TaggedNode& tagged_node,
       input_tensors_[dst_loc] = (*outputs)[src_slot];
     }
 
-    int32 previous_num_pending =
-        pending_[dst_id].fetch_sub(1, std::memory_order_release);
-    if (previous_num_pending == 1) ready->emplace_back(&gview.node_ref(dst_id));
+    DecrementPending(gview.node_ref(dst_id), ready);
   }
 
   for (const ControlEdgeInfo& e : item->output_control_edges()) {
-    const int dst_id = e.dst_id;
-
-    int32 previous_num_pending =
-        pending_[dst_id].fetch_sub(1, std::memory_order_release);
-    if (previous_num_pending == 1) ready->emplace_back(&gview.node_ref(dst_id));
+    DecrementPending(gview.node_ref(e.dst_id), ready);
   }
 }
 
@@ -50,11 +50,17 @@ class SimplePropagatorState {
                         int64 step_id, bool vlog);
   ~SimplePropagatorState();
 
+  // Prepares the state for another step of the same graph, reusing its
+  // buffers. REQUIRES: the previous step completed successfully, so that every
+  // input tensor has been consumed.
+  void Reset(int64 step_id);
+
   // A `TaggedNode` corresponds to a single invocation of a node's kernel,
   // and it is created when the kernel becomes runnable.
   struct TaggedNode {
     const NodeItem* node_item;
 
+    TaggedNode() = default;
     explicit TaggedNode(const NodeItem* node_item) : node_item(node_item) {}
 
     const NodeItem& get_node_item() const { return *node_item; }
@@ -160,8 +166,24 @@ class SimplePropagatorState {
                         const ImmutableExecutorState::FrameInfo& finfo,
                         bool vlog);
 
+  // Records that one in-edge of `dst` has been satisfied, and adds `dst` to
+  // `*ready` if it was the last one.
+  void DecrementPending(const NodeItem& dst, TaggedNodeSeq* ready) {
+    if (dst.has_single_pending_input) {
+      // The edge being satisfied is the only one, so this thread is the only
+      // writer of the count and no read-modify-write is needed. The store
+      // keeps the count accurate for `DumpState()`. The happens-before
+      // relation with the consumer is established when `dst` is scheduled.
+      pending_[dst.node_id].store(0, std::memory_order_relaxed);
+      ready->emplace_back(&dst);
+    } else if (pending_[dst.node_id].fetch_sub(
+                   1, std::memory_order_release) == 1) {
+      ready->emplace_back(&dst);
+    }
+  }
+
   const ImmutableExecutorState& immutable_state_;
-  const int64 step_id_;
+  int64 step_id_;
   const bool vlog_;
 
   // The i-th node's j-th input is stored at
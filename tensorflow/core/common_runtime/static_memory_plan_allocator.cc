@@ -0,0 +1,204 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundedBytes(size_t num_bytes) {
+  return (num_bytes + Allocator::kAllocatorAlignment - 1) &
+         ~(Allocator::kAllocatorAlignment - 1);
+}
+
+}  // namespace
+
+StaticMemoryPlanAllocator::StaticMemoryPlanAllocator(Allocator* base,
+                                                     int warmup_steps)
+    : base_(base), warmup_steps_remaining_(std::max(1, warmup_steps)) {}
+
+StaticMemoryPlanAllocator::~StaticMemoryPlanAllocator() {
+  if (arena_ != nullptr) base_->DeallocateRaw(arena_);
+}
+
+string StaticMemoryPlanAllocator::Name() {
+  return strings::StrCat("static_memory_plan_", base_->Name());
+}
+
+void* StaticMemoryPlanAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const size_t rounded_bytes = RoundedBytes(num_bytes);
+  {
+    mutex_lock l(mu_);
+    ++num_outstanding_;
+    if (arena_ != nullptr && num_bytes > 0 &&
+        alignment <= kAllocatorAlignment &&
+        allocation_attr.freed_by_func == nullptr) {
+      auto it = slot_class_for_size_.find(rounded_bytes);
+      if (it != slot_class_for_size_.end()) {
+        SlotClass& slot_class = slot_classes_[it->second];
+        if (!slot_class.free_slots.empty()) {
+          char* ptr = slot_class.free_slots.back();
+          slot_class.free_slots.pop_back();
+          return ptr;
+        }
+      }
+    }
+  }
+  void* ptr = base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  mutex_lock l(mu_);
+  if (ptr == nullptr) {
+    // The caller will not free a failed allocation.
+    DecrementOutstandingLocked();
+    return nullptr;
+  }
+  if (planning_ && arena_ == nullptr && num_bytes > 0) {
+    recorded_buffers_[ptr] = rounded_bytes;
+    SizeStats& stats = size_stats_[rounded_bytes];
+    stats.peak = std::max(stats.peak, ++stats.live);
+  }
+  return ptr;
+}
+
+void StaticMemoryPlanAllocator::DeallocateRaw(void* ptr) {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    SlotClass* slot_class = SlotClassForPointerLocked(ptr);
+    if (slot_class != nullptr) {
+      slot_class->free_slots.push_back(static_cast<char*>(ptr));
+      delete_self = DecrementOutstandingLocked();
+      ptr = nullptr;
+    } else {
+      auto it = recorded_buffers_.find(ptr);
+      if (it != recorded_buffers_.end()) {
+        --size_stats_[it->second].live;
+        recorded_buffers_.erase(it);
+      }
+    }
+  }
+  if (ptr != nullptr) {
+    // Not served from the plan; return it to `base_` outside of `mu_`.
+    base_->DeallocateRaw(ptr);
+    mutex_lock l(mu_);
+    delete_self = DecrementOutstandingLocked();
+  }
+  if (delete_self) delete this;
+}
+
+void StaticMemoryPlanAllocator::StepDone(bool ok) {
+  mutex_lock l(mu_);
+  if (!ok || !planning_ || arena_ != nullptr) return;
+  if (--warmup_steps_remaining_ > 0) return;
+  BuildPlanLocked();
+}
+
+void StaticMemoryPlanAllocator::BuildPlanLocked() {
+  planning_ = false;
+  size_t total_bytes = 0;
+  for (const auto& it : size_stats_) {
+    total_bytes += it.first * it.second.peak;
+  }
+  if (total_bytes == 0) return;
+
+  // A failure to reserve the arena only costs performance, so do not retry.
+  AllocationAttributes arena_attr;
+  arena_attr.retry_on_failure = false;
+  void* arena =
+      base_->AllocateRaw(kAllocatorAlignment, total_bytes, arena_attr);
+  if (arena == nullptr) {
+    LOG(WARNING) << "Could not reserve " << total_bytes << " bytes for the "
+                 << "static memory plan of " << base_->Name()
+                 << "; continuing with dynamic allocation.";
+    size_stats_.clear();
+    return;
+  }
+  arena_ = static_cast<char*>(arena);
+  arena_bytes_ = total_bytes;
+
+  // Lay out the slots of each size contiguously, in increasing size order.
+  char* next = arena_;
+  slot_classes_.reserve(size_stats_.size());
+  for (const auto& it : size_stats_) {
+    if (it.second.peak == 0) continue;
+    slot_class_for_size_[it.first] = slot_classes_.size();
+    slot_classes_.push_back(SlotClass{it.first, next, {}});
+    SlotClass& slot_class = slot_classes_.back();
+    slot_class.free_slots.reserve(it.second.peak);
+    // Push in reverse so that slots are handed out in address order.
+    for (int64 i = it.second.peak - 1; i >= 0; --i) {
+      slot_class.free_slots.push_back(next + i * it.first);
+    }
+    next += it.first * it.second.peak;
+  }
+  DCHECK_EQ(next, arena_ + arena_bytes_);
+  size_stats_.clear();
+  VLOG(1) << "Built static memory plan of " << total_bytes << " bytes in "
+          << slot_classes_.size() << " size classes for " << base_->Name();
+}
+
+bool StaticMemoryPlanAllocator::DecrementOutstandingLocked() {
+  --num_outstanding_;
+  return released_ && num_outstanding_ == 0;
+}
+
+StaticMemoryPlanAllocator::SlotClass*
+StaticMemoryPlanAllocator::SlotClassForPointerLocked(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  if (arena_ == nullptr || p < arena_ || p >= arena_ + arena_bytes_) {
+    return nullptr;
+  }
+  // Find the last class starting at or before `p`.
+  auto it = std::upper_bound(
+      slot_classes_.begin(), slot_classes_.end(), p,
+      [](const char* p, const SlotClass& c) { return p < c.begin; });
+  DCHECK(it != slot_classes_.begin());
+  return &*(--it);
+}
+
+void StaticMemoryPlanAllocator::Release() {
+  bool delete_self;
+  {
+    mutex_lock l(mu_);
+    released_ = true;
+    delete_self = num_outstanding_ == 0;
+  }
+  if (delete_self) delete this;
+}
+
+bool StaticMemoryPlanAllocator::has_plan() const {
+  tf_shared_lock l(mu_);
+  return arena_ != nullptr;
+}
+
+size_t StaticMemoryPlanAllocator::plan_bytes() const {
+  tf_shared_lock l(mu_);
+  return arena_bytes_;
+}
+
+bool StaticMemoryPlanAllocator::Owns(const void* ptr) const {
+  tf_shared_lock l(mu_);
+  const char* p = static_cast<const char*>(ptr);
+  return arena_ != nullptr && p >= arena_ && p < arena_ + arena_bytes_;
+}
+
+}  // namespace tensorflow
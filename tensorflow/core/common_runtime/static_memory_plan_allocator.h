@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_ALLOCATOR_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that replaces the dynamic allocations of an executor's steps
+// with a precomputed arena plan once the allocation pattern has been observed.
+//
+// For the first `warmup_steps` steps (as reported by StepDone()) every request
+// is forwarded to `base`, and the allocator records, for every (aligned)
+// allocation size, the peak number of buffers of that size that were live at
+// the same time. After the last warmup step it reserves a single arena from
+// `base` that holds that many slots for every recorded size, at fixed
+// offsets, and serves subsequent requests of a recorded size from a free slot
+// of that size. This is similar to the offset-based arena planning done by
+// TFLite, but since the executor runs nodes in a nondeterministic order the
+// plan only fixes slot offsets per size rather than buffer lifetimes.
+//
+// Requests that do not fit the plan -- an unrecorded size (e.g. because a
+// shape changed), a larger alignment, or more concurrent buffers of one size
+// than were seen during warmup -- are forwarded to `base`, so the plan never
+// changes the result of a step, only where its buffers live.
+//
+// Tensors allocated by this allocator may outlive its owner (e.g. fetched
+// outputs). The owner must therefore call Release() instead of deleting the
+// allocator; the allocator deletes itself once its last buffer is freed.
+class StaticMemoryPlanAllocator : public Allocator {
+ public:
+  StaticMemoryPlanAllocator(Allocator* base, int warmup_steps);
+
+  string Name() override;
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  // Must be called once at the end of every step that used this allocator.
+  // Steps that failed are not counted towards the warmup.
+  void StepDone(bool ok);
+
+  // Gives up the owner's reference. The allocator is deleted as soon as it
+  // holds no outstanding buffers.
+  void Release();
+
+  // Returns true once the plan has been built.
+  bool has_plan() const;
+
+  // Returns the number of bytes reserved for the plan's arena.
+  size_t plan_bytes() const;
+
+  // Returns true iff `ptr` was served from the plan's arena.
+  bool Owns(const void* ptr) const;
+
+ private:
+  ~StaticMemoryPlanAllocator() override;
+
+  // Live and peak buffer counts of one size, recorded during warmup.
+  struct SizeStats {
+    int64 live = 0;
+    int64 peak = 0;
+  };
+
+  // The slots of one size in the arena.
+  struct SlotClass {
+    size_t slot_bytes;
+    char* begin;
+    std::vector<char*> free_slots;
+  };
+
+  void BuildPlanLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the class owning `ptr`, or nullptr if `ptr` is outside the arena.
+  SlotClass* SlotClassForPointerLocked(const void* ptr)
+      TF_SHARED_LOCKS_REQUIRED(mu_);
+
+  // Decrements the outstanding buffer count and returns true if the caller
+  // must delete this allocator.
+  bool DecrementOutstandingLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;
+
+  mutable mutex mu_;
+  int warmup_steps_remaining_ TF_GUARDED_BY(mu_);
+  // Set to false when the plan could not be built; from then on every request
+  // is forwarded to `base_`.
+  bool planning_ TF_GUARDED_BY(mu_) = true;
+  std::map<size_t, SizeStats> size_stats_ TF_GUARDED_BY(mu_);
+  // Sizes of the buffers allocated from `base_` while recording.
+  absl::flat_hash_map<void*, size_t> recorded_buffers_ TF_GUARDED_BY(mu_);
+
+  char* arena_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t arena_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // Ordered by `begin`, i.e. by position in the arena.
+  std::vector<SlotClass> slot_classes_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<size_t, int> slot_class_for_size_ TF_GUARDED_BY(mu_);
+
+  int64 num_outstanding_ TF_GUARDED_BY(mu_) = 0;
+  bool released_ TF_GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlanAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_ALLOCATOR_H_
@@ -0,0 +1,119 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Runs one "step" that allocates two live buffers of 1000 bytes and one of
+// 4096 bytes, and frees them all.
+void RunStep(StaticMemoryPlanAllocator* a, std::vector<void*>* ptrs) {
+  ptrs->clear();
+  ptrs->push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+  ptrs->push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+  ptrs->push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 4096));
+  for (void* p : *ptrs) {
+    ASSERT_NE(nullptr, p);
+    a->DeallocateRaw(p);
+  }
+  a->StepDone(true);
+}
+
+TEST(StaticMemoryPlanAllocatorTest, RecordsThenServesFromPlan) {
+  auto* a = new StaticMemoryPlanAllocator(cpu_allocator(), 2);
+  std::vector<void*> ptrs;
+  RunStep(a, &ptrs);
+  EXPECT_FALSE(a->has_plan());
+  // A failed step does not count towards the warmup.
+  a->StepDone(false);
+  EXPECT_FALSE(a->has_plan());
+  RunStep(a, &ptrs);
+  ASSERT_TRUE(a->has_plan());
+  // 1000 bytes are rounded up to 1024.
+  EXPECT_EQ(2 * 1024 + 4096, a->plan_bytes());
+
+  for (int step = 0; step < 3; ++step) {
+    void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+    void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+    void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    EXPECT_TRUE(a->Owns(p0));
+    EXPECT_TRUE(a->Owns(p1));
+    EXPECT_TRUE(a->Owns(p2));
+    EXPECT_NE(p0, p1);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p0) %
+                     Allocator::kAllocatorAlignment);
+    a->DeallocateRaw(p0);
+    a->DeallocateRaw(p1);
+    a->DeallocateRaw(p2);
+    a->StepDone(true);
+  }
+  a->Release();
+}
+
+TEST(StaticMemoryPlanAllocatorTest, FallsBackWhenShapesDeviate) {
+  auto* a = new StaticMemoryPlanAllocator(cpu_allocator(), 1);
+  std::vector<void*> ptrs;
+  RunStep(a, &ptrs);
+  ASSERT_TRUE(a->has_plan());
+
+  // An unrecorded size.
+  void* unplanned = a->AllocateRaw(Allocator::kAllocatorAlignment, 8192);
+  EXPECT_FALSE(a->Owns(unplanned));
+  // More concurrent buffers of a size than were recorded.
+  void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  EXPECT_TRUE(a->Owns(p0));
+  EXPECT_FALSE(a->Owns(p1));
+  // A larger alignment than the arena guarantees.
+  void* aligned = a->AllocateRaw(4 * Allocator::kAllocatorAlignment, 1000);
+  EXPECT_FALSE(a->Owns(aligned));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) %
+                   (4 * Allocator::kAllocatorAlignment));
+
+  a->DeallocateRaw(unplanned);
+  a->DeallocateRaw(p0);
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(aligned);
+  // The freed slot is reused.
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  EXPECT_EQ(p0, p2);
+  a->DeallocateRaw(p2);
+  a->Release();
+}
+
+TEST(StaticMemoryPlanAllocatorTest, TensorsOutliveRelease) {
+  auto* a = new StaticMemoryPlanAllocator(cpu_allocator(), 1);
+  {
+    Tensor t(a, DT_FLOAT, TensorShape({16}));
+    a->StepDone(true);
+  }
+  ASSERT_TRUE(a->has_plan());
+  Tensor planned(a, DT_FLOAT, TensorShape({16}));
+  EXPECT_TRUE(a->Owns(planned.tensor_data().data()));
+  // The allocator is deleted when `planned` is destroyed.
+  a->Release();
+  planned.flat<float>().setConstant(1.0f);
+  EXPECT_EQ(1.0f, planned.flat<float>()(15));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,426 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_capture_cache.h"
+
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns true if the kernels of `op` queue their work on the device without
+// waiting for it, calling back to the host or copying host memory, so that
+// their work can be captured. Reductions and softmax are left out because
+// Eigen frees their scratch buffers from stream callbacks, and transposes
+// because they copy their permutation from the host.
+bool IsCapturableOp(const string& op) {
+  static const auto* const kCapturableOps = new absl::flat_hash_set<string>({
+      // Nodes without device work.
+      FunctionLibraryDefinition::kArgOp,
+      FunctionLibraryDefinition::kRetOp,
+      "Const",
+      "ExpandDims",
+      "Identity",
+      "NoOp",
+      "Reshape",
+      "Squeeze",
+      // Library calls.
+      "BatchMatMulV2",
+      "Conv2D",
+      "FusedBatchNormV3",
+      "MatMul",
+      "_FusedConv2D",
+      "_FusedMatMul",
+      // Element-wise kernels.
+      "Add",
+      "AddV2",
+      "BiasAdd",
+      "Elu",
+      "Exp",
+      "Log",
+      "Maximum",
+      "Minimum",
+      "Mul",
+      "Neg",
+      "RealDiv",
+      "Relu",
+      "Relu6",
+      "Rsqrt",
+      "Selu",
+      "Sigmoid",
+      "Sqrt",
+      "Square",
+      "Sub",
+      "Tanh",
+  });
+  return kCapturableOps->contains(op);
+}
+
+// Returns true if tensors of `dtype` are in device memory, as plain buffers
+// whose address identifies them.
+bool IsDeviceBuffer(DataType dtype) {
+  return MTypeFromDType(dtype) == DEVICE_MEMORY && DataTypeCanUseMemcpy(dtype);
+}
+
+// An allocator that keeps the buffers freed through it allocated until
+// Release(), so that the buffers a captured step used stay valid for its
+// replays.
+//
+// Tensors allocated by this allocator may outlive its owner (e.g. returned
+// values). The owner must therefore call Release() instead of deleting the
+// allocator; the allocator deletes itself once its last buffer is freed.
+class PinningAllocator : public Allocator {
+ public:
+  explicit PinningAllocator(Allocator* base) : base_(base) {}
+
+  string Name() override { return strings::StrCat("pinning_", base_->Name()); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    void* ptr = base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+    if (ptr != nullptr) {
+      mutex_lock l(mu_);
+      live_.insert(ptr);
+    }
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    bool delete_this;
+    {
+      mutex_lock l(mu_);
+      live_.erase(ptr);
+      if (!released_) {
+        pinned_.push_back(ptr);
+        return;
+      }
+      base_->DeallocateRaw(ptr);
+      delete_this = live_.empty();
+    }
+    if (delete_this) delete this;
+  }
+
+  // Frees the pinned buffers and gives up the owner's reference. The
+  // allocator is deleted as soon as it holds no live buffers.
+  void Release() {
+    bool delete_this;
+    {
+      mutex_lock l(mu_);
+      released_ = true;
+      for (void* ptr : pinned_) base_->DeallocateRaw(ptr);
+      pinned_.clear();
+      delete_this = live_.empty();
+    }
+    if (delete_this) delete this;
+  }
+
+  // Returns true iff `ptr` is a buffer allocated by this allocator that has
+  // not been freed.
+  bool Owns(const void* ptr) {
+    mutex_lock l(mu_);
+    return live_.contains(ptr);
+  }
+
+ private:
+  ~PinningAllocator() override {}
+
+  Allocator* const base_;
+
+  mutex mu_;
+  absl::flat_hash_set<const void*> live_ TF_GUARDED_BY(mu_);
+  // Buffers freed by their tensors but not yet returned to `base_`.
+  std::vector<void*> pinned_ TF_GUARDED_BY(mu_);
+  bool released_ TF_GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PinningAllocator);
+};
+
+// A call frame that forwards the arguments of another one, and keeps the
+// return values instead of setting them, so that a step may still be run
+// again after its capture fails.
+class RecordingCallFrame : public CallFrameInterface {
+ public:
+  explicit RecordingCallFrame(CallFrameInterface* frame)
+      : frame_(frame), retvals_(frame->num_retvals()) {}
+
+  size_t num_args() const override { return frame_->num_args(); }
+  size_t num_retvals() const override { return frame_->num_retvals(); }
+
+  Status GetArg(int index, const Tensor** val) override {
+    return frame_->GetArg(index, val);
+  }
+
+  Status SetRetval(int index, const Tensor& val) override {
+    if (index < 0 || index >= retvals_.size()) {
+      return errors::InvalidArgument("SetRetval ", index, " is not within [0, ",
+                                     retvals_.size(), ")");
+    }
+    retvals_[index] = val;
+    return Status::OK();
+  }
+
+  std::vector<Tensor>* retvals() { return &retvals_; }
+
+ private:
+  CallFrameInterface* const frame_;  // Not owned.
+  std::vector<Tensor> retvals_;
+};
+
+}  // namespace
+
+struct StepCaptureCache::Entry {
+  ~Entry() {
+    graph.reset();
+    retvals.clear();
+    device.reset();
+    if (allocator != nullptr) allocator->Release();
+  }
+
+  // Returns true if no one but this entry references the buffers of
+  // `retvals` that were allocated by the captured step.
+  bool RetvalsAreFree() {
+    for (Tensor& retval : retvals) {
+      TensorBuffer* buf = DMAHelper::buffer(&retval);
+      if (buf == nullptr || !allocator->Owns(buf->root_buffer()->data())) {
+        continue;
+      }
+      if (!buf->RefCountIsOne() || !buf->root_buffer()->RefCountIsOne()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The number of steps of the signature that ran normally.
+  int num_runs = 0;
+
+  // Set when the step is captured. The kernels of the captured step run on
+  // `device`, which allocates from `allocator`.
+  PinningAllocator* allocator = nullptr;  // Owned through Release().
+  std::unique_ptr<Device> device;
+  std::unique_ptr<Device::CapturedGraph> graph;
+  std::vector<Tensor> retvals;
+};
+
+/* static */ Status StepCaptureCache::CanCapture(const Graph& graph) {
+  for (const Node* n : graph.op_nodes()) {
+    if (!IsCapturableOp(n->type_string())) {
+      return errors::Unimplemented("Cannot capture ", n->type_string(),
+                                   " node ", n->name());
+    }
+    if (n->IsArg() || n->IsRetval()) {
+      const DataType dtype =
+          n->IsArg() ? n->output_type(0) : n->input_type(0);
+      if (!IsDeviceBuffer(dtype)) {
+        return errors::Unimplemented("Cannot capture ", n->name(), " of type ",
+                                     DataTypeString(dtype),
+                                     ", which is not in device memory");
+      }
+    } else if (n->op_def().is_stateful()) {
+      return errors::Unimplemented("Cannot capture stateful node ", n->name());
+    }
+  }
+  return Status::OK();
+}
+
+StepCaptureCache::StepCaptureCache(Device* device, RunStepFn run_step)
+    : device_(device), run_step_(std::move(run_step)) {}
+
+StepCaptureCache::~StepCaptureCache() {}
+
+void StepCaptureCache::RunAsync(const Executor::Args& args,
+                                Executor::DoneCallback done) {
+  CallFrameInterface* frame = args.call_frame;
+  if (frame == nullptr) {
+    run_step_(args, nullptr, std::move(done));
+    return;
+  }
+  Key key;
+  for (int i = 0; i < frame->num_args(); ++i) {
+    const Tensor* arg;
+    Status s = frame->GetArg(i, &arg);
+    if (!s.ok() || !IsDeviceBuffer(arg->dtype())) {
+      run_step_(args, nullptr, std::move(done));
+      return;
+    }
+    key.push_back(reinterpret_cast<int64>(DMAHelper::base(arg)));
+    key.push_back(arg->dtype());
+    key.push_back(arg->dims());
+    for (int d = 0; d < arg->dims(); ++d) key.push_back(arg->dim_size(d));
+  }
+
+  enum { kRun, kCapture, kReplay } action = kRun;
+  Entry* entry = nullptr;
+  Status status;
+  {
+    mutex_lock l(mu_);
+    if (capturing_) {
+      // The work of this step must not be captured with the other one.
+      waiting_steps_.push_back(
+          [this, args, done = std::move(done)]() { RunAsync(args, done); });
+      return;
+    }
+    if (!disabled_) {
+      auto it = entries_.find(key);
+      if (it == entries_.end() && entries_.size() < kMaxEntries) {
+        it = entries_.emplace(std::move(key), absl::make_unique<Entry>())
+                 .first;
+      }
+      if (it != entries_.end()) entry = it->second.get();
+    }
+    if (entry == nullptr) {
+      // Runs normally.
+    } else if (entry->graph != nullptr) {
+      if (entry->RetvalsAreFree()) {
+        action = kReplay;
+        for (int i = 0; i < entry->retvals.size() && status.ok(); ++i) {
+          status = frame->SetRetval(i, entry->retvals[i]);
+        }
+        if (status.ok()) status = entry->graph->Launch();
+      }
+    } else if (entry->num_runs > 0 && num_running_ == 0) {
+      action = kCapture;
+      capturing_ = true;
+    } else {
+      ++entry->num_runs;
+    }
+    ++num_running_;
+  }
+
+  Executor::DoneCallback step_done = [this, done = std::move(done)](
+                                         const Status& s) {
+    {
+      mutex_lock l(mu_);
+      --num_running_;
+    }
+    done(s);
+  };
+  switch (action) {
+    case kRun:
+      run_step_(args, nullptr, std::move(step_done));
+      break;
+    case kCapture:
+      Capture(entry, args, std::move(step_done));
+      break;
+    case kReplay:
+      if (status.ok()) {
+        FinishStep(args.sync_on_finish, std::move(step_done));
+      } else {
+        step_done(status);
+      }
+      break;
+  }
+}
+
+void StepCaptureCache::Capture(Entry* entry, const Executor::Args& args,
+                               Executor::DoneCallback done) {
+  VLOG(1) << "Capturing a step on " << device_->name();
+  if (entry->allocator == nullptr) {
+    entry->allocator =
+        new PinningAllocator(device_->GetAllocator(AllocatorAttributes()));
+    entry->device = RenamedDevice::NewRenamedDevice(
+        device_->name(), device_, false, false, nullptr, entry->allocator);
+  }
+  Status status = device_->BeginGraphCapture();
+  if (!status.ok()) {
+    CaptureDone(entry, status, nullptr, {});
+    run_step_(args, nullptr, std::move(done));
+    return;
+  }
+
+  auto* frame = new RecordingCallFrame(args.call_frame);
+  Executor::Args capture_args = args;
+  capture_args.call_frame = frame;
+  // Waiting for the device would invalidate the capture.
+  capture_args.sync_on_finish = false;
+  run_step_(capture_args, entry->device.get(),
+            [this, entry, frame, args, done = std::move(done)](
+                const Status& step_status) mutable {
+              std::unique_ptr<RecordingCallFrame> frame_owner(frame);
+              std::unique_ptr<Device::CapturedGraph> graph;
+              Status status = device_->EndGraphCapture(&graph);
+              if (!step_status.ok()) {
+                CaptureDone(entry, step_status, nullptr, {});
+                done(step_status);
+                return;
+              }
+              // The captured work has not run yet.
+              if (status.ok()) status = graph->Launch();
+              if (!status.ok()) {
+                CaptureDone(entry, status, nullptr, {});
+                run_step_(args, nullptr, std::move(done));
+                return;
+              }
+              std::vector<Tensor>* retvals = frame->retvals();
+              for (int i = 0; i < retvals->size() && status.ok(); ++i) {
+                status = args.call_frame->SetRetval(i, (*retvals)[i]);
+              }
+              CaptureDone(entry, Status::OK(), std::move(graph),
+                          std::move(*retvals));
+              if (status.ok()) {
+                FinishStep(args.sync_on_finish, std::move(done));
+              } else {
+                done(status);
+              }
+            });
+}
+
+void StepCaptureCache::CaptureDone(
+    Entry* entry, const Status& status,
+    std::unique_ptr<Device::CapturedGraph> graph,
+    std::vector<Tensor> retvals) {
+  std::vector<std::function<void()>> waiting_steps;
+  {
+    mutex_lock l(mu_);
+    capturing_ = false;
+    if (status.ok()) {
+      entry->graph = std::move(graph);
+      entry->retvals = std::move(retvals);
+    } else {
+      LOG(WARNING) << "Running the steps on " << device_->name()
+                   << " without capturing them: " << status;
+      disabled_ = true;
+      entries_.clear();
+    }
+    waiting_steps.swap(waiting_steps_);
+  }
+  for (auto& step : waiting_steps) step();
+}
+
+void StepCaptureCache::FinishStep(bool sync, Executor::DoneCallback done) {
+  if (sync) {
+    device_->Sync(done);
+  } else {
+    done(Status::OK());
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,111 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_CAPTURE_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_CAPTURE_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Captures the work that the steps of an executor queue on its device into
+// device graphs (see `Device::BeginGraphCapture()`), and replays the graphs
+// instead of running the kernels of later steps.
+//
+// Steps are keyed by the signature of their arguments: the address, type and
+// shape of every argument in the call frame. The first step of a signature
+// runs normally, so that the kernels initialize their libraries and autotune
+// outside of the capture. The second one is captured, with every buffer its
+// kernels allocate kept allocated for the signature, so that the captured
+// work can be replayed on the arguments of any later step of the signature.
+// A replayed step returns the return values of the captured step again.
+//
+// A step is not replayed while the caller still references the return values
+// of an earlier step of its signature, which the replay would overwrite; it
+// runs normally instead. Steps that arrive while a step is captured wait for
+// the capture to end. If a capture fails, the cache disables itself and
+// every later step runs normally.
+class StepCaptureCache {
+ public:
+  // Runs a step normally. If `kernel_device` is not null, the kernels of the
+  // step run on it instead of on the executor's device.
+  typedef std::function<void(const Executor::Args& args, Device* kernel_device,
+                             Executor::DoneCallback done)>
+      RunStepFn;
+
+  // The largest number of signatures the cache holds. Steps of further
+  // signatures run normally.
+  static constexpr int kMaxEntries = 16;
+
+  // Returns OK if the steps of `graph` may be captured: its arguments and
+  // return values are in device memory, and its nodes are stateless ops
+  // whose kernels queue their work on the device without waiting for it.
+  static Status CanCapture(const Graph& graph);
+
+  StepCaptureCache(Device* device, RunStepFn run_step);
+  ~StepCaptureCache();
+
+  // Runs, captures or replays the step of `args`.
+  void RunAsync(const Executor::Args& args, Executor::DoneCallback done);
+
+ private:
+  struct Entry;
+  typedef std::vector<int64> Key;
+
+  // Captures the step of `args` into `entry`.
+  void Capture(Entry* entry, const Executor::Args& args,
+               Executor::DoneCallback done);
+
+  // Ends the capture of `entry`, disabling the cache if `status` is not OK,
+  // and runs the steps that waited for it.
+  void CaptureDone(Entry* entry, const Status& status,
+                   std::unique_ptr<Device::CapturedGraph> graph,
+                   std::vector<Tensor> retvals);
+
+  // Calls `done` once the work of a replayed or captured step has finished
+  // on the device, if `sync` is true.
+  void FinishStep(bool sync, Executor::DoneCallback done);
+
+  Device* const device_;  // Not owned.
+  const RunStepFn run_step_;
+
+  mutex mu_;
+  bool disabled_ TF_GUARDED_BY(mu_) = false;
+  bool capturing_ TF_GUARDED_BY(mu_) = false;
+  // The number of steps started and not yet done.
+  int num_running_ TF_GUARDED_BY(mu_) = 0;
+  // The steps that arrived during the current capture.
+  std::vector<std::function<void()>> waiting_steps_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<Key, std::unique_ptr<Entry>> entries_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepCaptureCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_CAPTURE_CACHE_H_
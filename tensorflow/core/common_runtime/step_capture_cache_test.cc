@@ -0,0 +1,223 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_capture_cache.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/function_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A device whose captured graphs count their launches.
+class FakeDevice : public Device {
+ public:
+  FakeDevice() : Device(nullptr, MakeAttributes()) {}
+
+  Status Sync() override {
+    ++num_syncs;
+    return Status::OK();
+  }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+  Status BeginGraphCapture() override {
+    ++num_captures;
+    return begin_capture_status;
+  }
+
+  Status EndGraphCapture(std::unique_ptr<CapturedGraph>* graph) override {
+    graph->reset(new FakeGraph(&num_launches));
+    return Status::OK();
+  }
+
+  int num_syncs = 0;
+  int num_captures = 0;
+  int num_launches = 0;
+  Status begin_capture_status;
+
+ private:
+  class FakeGraph : public CapturedGraph {
+   public:
+    explicit FakeGraph(int* num_launches) : num_launches_(num_launches) {}
+    Status Launch() override {
+      ++*num_launches_;
+      return Status::OK();
+    }
+
+   private:
+    int* const num_launches_;
+  };
+
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attributes;
+    attributes.set_name("/job:a/replica:0/task:0/device:GPU:0");
+    attributes.set_device_type(DEVICE_GPU);
+    return attributes;
+  }
+};
+
+class StepCaptureCacheTest : public ::testing::Test {
+ protected:
+  StepCaptureCacheTest()
+      : cache_(&device_, [this](const Executor::Args& args,
+                                Device* kernel_device,
+                                Executor::DoneCallback done) {
+          RunStep(args, kernel_device, std::move(done));
+        }) {}
+
+  // Doubles the argument of the step, allocating the result from the device
+  // the kernels run on.
+  void RunStep(const Executor::Args& args, Device* kernel_device,
+               Executor::DoneCallback done) {
+    ++num_runs_;
+    last_sync_on_finish_ = args.sync_on_finish;
+    last_kernel_device_ = kernel_device;
+    Device* device = kernel_device != nullptr ? kernel_device : &device_;
+    const Tensor* arg;
+    TF_ASSERT_OK(args.call_frame->GetArg(0, &arg));
+    Tensor retval(device->GetAllocator(AllocatorAttributes()), DT_FLOAT,
+                  arg->shape());
+    retval.flat<float>() = arg->flat<float>() * 2.0f;
+    TF_ASSERT_OK(args.call_frame->SetRetval(0, retval));
+    done(Status::OK());
+  }
+
+  // Runs a step on `arg` through the cache and returns its result.
+  Tensor Run(const Tensor& arg) {
+    FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+    TF_CHECK_OK(frame.SetArgs({arg}));
+    Executor::Args args;
+    args.call_frame = &frame;
+    args.sync_on_finish = true;
+    Status status;
+    cache_.RunAsync(args, [&status](const Status& s) { status = s; });
+    TF_CHECK_OK(status);
+    std::vector<Tensor> retvals;
+    TF_CHECK_OK(frame.ConsumeRetvals(&retvals, false));
+    return retvals[0];
+  }
+
+  FakeDevice device_;
+  StepCaptureCache cache_;
+  int num_runs_ = 0;
+  bool last_sync_on_finish_ = false;
+  Device* last_kernel_device_ = nullptr;
+};
+
+TEST_F(StepCaptureCacheTest, CapturesTheSecondStepAndReplaysTheNextOnes) {
+  const Tensor arg = test::AsTensor<float>({1, 2});
+
+  test::ExpectTensorEqual<float>(Run(arg), test::AsTensor<float>({2, 4}));
+  EXPECT_EQ(num_runs_, 1);
+  EXPECT_EQ(last_kernel_device_, nullptr);
+  EXPECT_EQ(device_.num_captures, 0);
+
+  test::ExpectTensorEqual<float>(Run(arg), test::AsTensor<float>({2, 4}));
+  EXPECT_EQ(num_runs_, 2);
+  EXPECT_NE(last_kernel_device_, nullptr);
+  EXPECT_FALSE(last_sync_on_finish_);
+  EXPECT_EQ(device_.num_captures, 1);
+  // The captured work is launched, and then waited for.
+  EXPECT_EQ(device_.num_launches, 1);
+  EXPECT_EQ(device_.num_syncs, 1);
+
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectTensorEqual<float>(Run(arg), test::AsTensor<float>({2, 4}));
+  }
+  EXPECT_EQ(num_runs_, 2);
+  EXPECT_EQ(device_.num_captures, 1);
+  EXPECT_EQ(device_.num_launches, 4);
+  EXPECT_EQ(device_.num_syncs, 4);
+}
+
+TEST_F(StepCaptureCacheTest, SignaturesAreCapturedSeparately) {
+  const Tensor arg = test::AsTensor<float>({1, 2});
+  const Tensor other_shape = test::AsTensor<float>({1, 2, 3});
+  // Same shape, different address.
+  const Tensor other_address = test::AsTensor<float>({1, 2});
+
+  Run(arg);
+  Run(arg);
+  EXPECT_EQ(device_.num_captures, 1);
+  test::ExpectTensorEqual<float>(Run(other_shape),
+                                 test::AsTensor<float>({2, 4, 6}));
+  test::ExpectTensorEqual<float>(Run(other_address),
+                                 test::AsTensor<float>({2, 4}));
+  EXPECT_EQ(num_runs_, 4);
+  EXPECT_EQ(device_.num_captures, 1);
+}
+
+TEST_F(StepCaptureCacheTest, ReferencedRetvalsAreNotOverwritten) {
+  const Tensor arg = test::AsTensor<float>({1, 2});
+  Run(arg);
+  const Tensor captured = Run(arg);
+  EXPECT_EQ(num_runs_, 2);
+
+  // Replaying would overwrite `captured`.
+  const Tensor result = Run(arg);
+  EXPECT_EQ(num_runs_, 3);
+  EXPECT_EQ(device_.num_launches, 1);
+  EXPECT_NE(result.tensor_data().data(), captured.tensor_data().data());
+}
+
+TEST_F(StepCaptureCacheTest, FailedCaptureDisablesTheCache) {
+  device_.begin_capture_status = errors::Unimplemented("No capture");
+  const Tensor arg = test::AsTensor<float>({1, 2});
+  for (int i = 0; i < 4; ++i) {
+    test::ExpectTensorEqual<float>(Run(arg), test::AsTensor<float>({2, 4}));
+  }
+  EXPECT_EQ(num_runs_, 4);
+  EXPECT_EQ(device_.num_captures, 1);
+  EXPECT_EQ(device_.num_launches, 0);
+}
+
+TEST(StepCaptureCacheCanCaptureTest, CapturableGraph) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto y = ops::Relu(root.WithOpName("y"), ops::Square(root, x));
+  ops::_Retval(root.WithOpName("retval"), y, 0);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+  TF_EXPECT_OK(StepCaptureCache::CanCapture(graph));
+}
+
+TEST(StepCaptureCacheCanCaptureTest, HostMemoryArgument) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_INT32, 0);
+  ops::_Retval(root.WithOpName("retval"), ops::Square(root, x), 0);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+  EXPECT_FALSE(StepCaptureCache::CanCapture(graph).ok());
+}
+
+TEST(StepCaptureCacheCanCaptureTest, UnknownOp) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  ops::_Retval(root.WithOpName("retval"), ops::Softmax(root, x), 0);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+  EXPECT_FALSE(StepCaptureCache::CanCapture(graph).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
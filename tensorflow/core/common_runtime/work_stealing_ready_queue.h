@@ -0,0 +1,205 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// WorkStealingReadyQueue is an internal helper class for the "WORK_STEALING"
+// executor. It holds the ready nodes of a single step in a fixed number of
+// per-worker deques instead of in the inter-op thread pool queue.
+//
+// A worker is a closure that the executor submits to its runner. Each worker
+// owns one deque: it pushes and pops newly ready nodes at the back of its own
+// deque (LIFO, which keeps producer/consumer chains hot in cache) and, once
+// its deque is empty, steals from the front of its peers' deques (FIFO, which
+// takes the oldest and typically largest pieces of work). Items pushed from a
+// thread that is not a worker of this queue (e.g. the completion callback of
+// an asynchronous kernel) are distributed round-robin.
+//
+// The queue only tells the caller when to start a new worker; it never runs
+// closures itself:
+//
+//    if (queue->Push(item)) runner([queue] { RunWorker(queue); });
+//
+//    void RunWorker(queue) {
+//      WorkStealingReadyQueue<T>::WorkerScope scope(queue.get());
+//      T item;
+//      while (queue->PopOrRetire(scope.worker_id(), &item)) Process(item);
+//    }
+//
+// At most `num_workers` workers are active at any time. Push() and
+// PopOrRetire() cooperate so that an item pushed concurrently with the last
+// worker retiring is never stranded: either the pusher observes the retirement
+// and asks for a new worker, or the retiring worker observes the item and
+// keeps running.
+template <typename T>
+class WorkStealingReadyQueue {
+ public:
+  explicit WorkStealingReadyQueue(int num_workers)
+      : num_workers_(num_workers > 0 ? num_workers : 1),
+        deques_(new Deque[num_workers_]) {}
+
+  ~WorkStealingReadyQueue() {
+    DCHECK_EQ(num_items_.load(), 0);
+    DCHECK_EQ(num_active_workers_.load(), 0);
+  }
+
+  int num_workers() const { return num_workers_; }
+
+  // Registers the calling thread as a worker of `queue` for the lifetime of
+  // the scope. Worker ids are handed out round-robin, so two workers may
+  // occasionally share a deque, which is safe but loses some locality. Scopes
+  // nest, so that an executor that runs inline inside a kernel of another
+  // executor does not clobber the outer state.
+  class WorkerScope {
+   public:
+    explicit WorkerScope(WorkStealingReadyQueue* queue)
+        : saved_queue_(current_queue_), saved_worker_id_(current_worker_id_) {
+      current_queue_ = queue;
+      current_worker_id_ = queue->next_worker_id_.fetch_add(
+                               1, std::memory_order_relaxed) %
+                           queue->num_workers_;
+    }
+    ~WorkerScope() {
+      current_queue_ = saved_queue_;
+      current_worker_id_ = saved_worker_id_;
+    }
+
+    int worker_id() const { return current_worker_id_; }
+
+   private:
+    const WorkStealingReadyQueue* const saved_queue_;
+    const int saved_worker_id_;
+    TF_DISALLOW_COPY_AND_ASSIGN(WorkerScope);
+  };
+
+  // Adds `item` to the queue. Returns true iff the caller must start a new
+  // worker (which in turn must call PopOrRetire() until it returns false).
+  bool Push(T item) {
+    int target;
+    if (current_queue_ == this) {
+      target = current_worker_id_;
+    } else {
+      target = next_push_target_.fetch_add(1, std::memory_order_relaxed) %
+               num_workers_;
+    }
+    {
+      mutex_lock l(deques_[target].mu);
+      deques_[target].items.push_back(std::move(item));
+    }
+    num_items_.fetch_add(1, std::memory_order_seq_cst);
+    return TryAddWorker();
+  }
+
+  // Removes an item, preferring the back of `worker_id`'s own deque and
+  // falling back to the front of the other deques. Returns false when the
+  // queue is empty, in which case the calling worker has retired and must not
+  // touch the queue again.
+  bool PopOrRetire(int worker_id, T* item) {
+    while (true) {
+      if (TryPop(worker_id, item)) return true;
+      // Retire, then re-check for items pushed after the failed pop. Order
+      // matters: see the comment in the class description.
+      num_active_workers_.fetch_sub(1, std::memory_order_seq_cst);
+      if (num_items_.load(std::memory_order_seq_cst) <= 0 || !TryAddWorker()) {
+        return false;
+      }
+    }
+  }
+
+  // Returns the number of items currently in the queue (for testing).
+  int64 num_items() const { return num_items_.load(); }
+
+  // Returns the number of workers that have not yet retired (for testing).
+  int num_active_workers() const { return num_active_workers_.load(); }
+
+ private:
+  struct Deque {
+    mutex mu;
+    std::deque<T> items TF_GUARDED_BY(mu);
+  };
+
+  bool TryAddWorker() {
+    int active = num_active_workers_.load(std::memory_order_seq_cst);
+    while (active < num_workers_) {
+      if (num_active_workers_.compare_exchange_weak(
+              active, active + 1, std::memory_order_seq_cst)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool TryPop(int worker_id, T* item) {
+    {
+      Deque& own = deques_[worker_id];
+      mutex_lock l(own.mu);
+      if (!own.items.empty()) {
+        *item = std::move(own.items.back());
+        own.items.pop_back();
+        num_items_.fetch_sub(1, std::memory_order_seq_cst);
+        return true;
+      }
+    }
+    for (int i = 1; i < num_workers_; ++i) {
+      Deque& victim = deques_[(worker_id + i) % num_workers_];
+      mutex_lock l(victim.mu);
+      if (!victim.items.empty()) {
+        *item = std::move(victim.items.front());
+        victim.items.pop_front();
+        num_items_.fetch_sub(1, std::memory_order_seq_cst);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static thread_local const WorkStealingReadyQueue* current_queue_;
+  static thread_local int current_worker_id_;
+
+  const int num_workers_;
+  std::unique_ptr<Deque[]> deques_;
+
+  // Align the hot counters at 64 bytes to avoid false-sharing, assuming the
+  // cacheline size is 64 bytes or smaller.
+  alignas(64) std::atomic<int64> num_items_{0};
+  alignas(64) std::atomic<int> num_active_workers_{0};
+  std::atomic<int> next_worker_id_{0};
+  std::atomic<int> next_push_target_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingReadyQueue);
+};
+
+template <typename T>
+thread_local const WorkStealingReadyQueue<T>*
+    WorkStealingReadyQueue<T>::current_queue_ = nullptr;
+
+template <typename T>
+thread_local int WorkStealingReadyQueue<T>::current_worker_id_ = 0;
+
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+typedef WorkStealingReadyQueue<int> Queue;
+
+TEST(WorkStealingReadyQueueTest, PushFromOutsideStartsWorkers) {
+  Queue queue(2);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  // Both workers have been requested; a third push must not start another.
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_EQ(3, queue.num_items());
+  EXPECT_EQ(2, queue.num_active_workers());
+
+  int item;
+  int sum = 0;
+  while (queue.PopOrRetire(0, &item)) sum += item;
+  EXPECT_EQ(6, sum);
+  EXPECT_EQ(0, queue.num_items());
+  // Retire the second (never started) worker.
+  EXPECT_FALSE(queue.PopOrRetire(1, &item));
+  EXPECT_EQ(0, queue.num_active_workers());
+}
+
+TEST(WorkStealingReadyQueueTest, OwnerPopsLifoThiefStealsFifo) {
+  Queue queue(2);
+  {
+    Queue::WorkerScope scope(&queue);
+    ASSERT_EQ(0, scope.worker_id());
+    EXPECT_TRUE(queue.Push(1));
+    queue.Push(2);
+    queue.Push(3);
+    int item;
+    ASSERT_TRUE(queue.PopOrRetire(scope.worker_id(), &item));
+    EXPECT_EQ(3, item);
+  }
+  // Worker 1 has an empty deque and steals the oldest item from worker 0.
+  int item;
+  ASSERT_TRUE(queue.PopOrRetire(1, &item));
+  EXPECT_EQ(1, item);
+  ASSERT_TRUE(queue.PopOrRetire(1, &item));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(queue.PopOrRetire(1, &item));
+  EXPECT_EQ(1, queue.num_active_workers());
+  EXPECT_FALSE(queue.PopOrRetire(0, &item));
+  EXPECT_EQ(0, queue.num_active_workers());
+}
+
+TEST(WorkStealingReadyQueueTest, NestedScopesRestoreOuterQueue) {
+  Queue outer(1);
+  Queue inner(1);
+  Queue::WorkerScope outer_scope(&outer);
+  {
+    Queue::WorkerScope inner_scope(&inner);
+    inner.Push(1);
+    EXPECT_EQ(1, inner.num_items());
+    int item;
+    ASSERT_TRUE(inner.PopOrRetire(inner_scope.worker_id(), &item));
+    EXPECT_FALSE(inner.PopOrRetire(inner_scope.worker_id(), &item));
+  }
+  outer.Push(2);
+  int item;
+  ASSERT_TRUE(outer.PopOrRetire(outer_scope.worker_id(), &item));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(outer.PopOrRetire(outer_scope.worker_id(), &item));
+}
+
+// Each processed item fans out into two children until a fixed depth is
+// reached, with items pushed from inside the workers. Checks that every item
+// is processed exactly once and that all workers retire.
+TEST(WorkStealingReadyQueueTest, ConcurrentFanOut) {
+  constexpr int kDepth = 12;
+  constexpr int kNumWorkers = 4;
+  auto queue = std::make_shared<Queue>(kNumWorkers);
+  std::atomic<int> processed{0};
+  const int expected = (1 << (kDepth + 1)) - 1;
+  BlockingCounter done(expected);
+  {
+    // Destroying the pool waits for the workers to retire.
+    thread::ThreadPool pool(Env::Default(), "test", kNumWorkers);
+
+    std::function<void()> run_worker;
+    run_worker = [&]() {
+      Queue::WorkerScope scope(queue.get());
+      int depth;
+      while (queue->PopOrRetire(scope.worker_id(), &depth)) {
+        processed.fetch_add(1);
+        if (depth < kDepth) {
+          for (int i = 0; i < 2; ++i) {
+            if (queue->Push(depth + 1)) pool.Schedule(run_worker);
+          }
+        }
+        done.DecrementCount();
+      }
+    };
+    if (queue->Push(0)) pool.Schedule(run_worker);
+    done.Wait();
+  }
+  EXPECT_EQ(expected, processed.load());
+  EXPECT_EQ(0, queue->num_items());
+  EXPECT_EQ(0, queue->num_active_workers());
+}
+
+}  // namespace
+}  // namespace tensorflow
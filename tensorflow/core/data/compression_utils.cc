@@ -17,64 +17,65 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 namespace tensorflow {
 namespace data {
 
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out) {
-  // Step 1: Determine the total uncompressed size. This requires serializing
-  // non-memcopyable tensors, which we save to use again later.
-  std::vector<TensorProto> non_memcpy_components;
+  // Each component is compressed with the codec that suits its bytes, e.g.
+  // snappy after shuffling the bytes of floats, or not at all when its bytes
+  // don't compress, as is often the case of dense floats.
+  out->set_per_component_codecs(true);
+  std::string* data = out->mutable_data();
+  std::string compressed;
   int64 total_size = 0;
-  for (auto& component : element) {
-    if (DataTypeCanUseMemcpy(component.dtype())) {
-      // Some datatypes can be memcopied, allowing us to save two copies
-      // (AsProtoTensorContent and SerializeToArray).
-      total_size += DMAHelper::buffer(&component)->size();
-    } else {
-      non_memcpy_components.emplace_back();
-      component.AsProtoTensorContent(&non_memcpy_components.back());
-      total_size += non_memcpy_components.back().ByteSizeLong();
-    }
-  }
-
-  // Step 2: Write the tensor data to a buffer, and compress that buffer.
-  // We use tstring for access to resize_uninitialized.
-  tstring uncompressed;
-  uncompressed.resize_uninitialized(total_size);
-  // Position in `uncompressed` to write the next component.
-  char* position = uncompressed.mdata();
-  int non_memcpy_component_index = 0;
   for (auto& component : element) {
     CompressedComponentMetadata* metadata =
         out->mutable_component_metadata()->Add();
     metadata->set_dtype(component.dtype());
     component.shape().AsProto(metadata->mutable_tensor_shape());
+    StringPiece bytes;
+    int element_size = 1;
+    std::string serialized;
     if (DataTypeCanUseMemcpy(component.dtype())) {
-      const TensorBuffer* buffer = DMAHelper::buffer(&component);
-      memcpy(position, buffer->data(), buffer->size());
-      metadata->set_tensor_size_bytes(buffer->size());
+      // Some datatypes can be memcopied, allowing us to save two copies
+      // (AsProtoTensorContent and SerializeToString).
+      bytes = component.tensor_data();
+      element_size = DataTypeSize(component.dtype());
     } else {
-      TensorProto& proto = non_memcpy_components[non_memcpy_component_index++];
-      proto.SerializeToArray(position, proto.ByteSizeLong());
-      metadata->set_tensor_size_bytes(proto.ByteSizeLong());
+      TensorProto proto;
+      component.AsProtoTensorContent(&proto);
+      if (!proto.SerializeToString(&serialized)) {
+        return errors::Internal("Failed to serialize a component of type ",
+                                DataTypeString(component.dtype()));
+      }
+      bytes = serialized;
     }
-    position += metadata->tensor_size_bytes();
-  }
-  DCHECK_EQ(position, uncompressed.mdata() + total_size);
-
-  if (!port::Snappy_Compress(uncompressed.mdata(), total_size,
-                             out->mutable_data())) {
-    return errors::Internal("Failed to compress using snappy.");
+    TensorCodec codec = CompressTensorData(bytes, element_size, &compressed);
+    metadata->set_tensor_size_bytes(bytes.size());
+    metadata->set_codec(codec);
+    if (codec == TENSOR_CODEC_NONE) {
+      data->append(bytes.data(), bytes.size());
+      metadata->set_compressed_size_bytes(bytes.size());
+    } else {
+      data->append(compressed);
+      metadata->set_compressed_size_bytes(compressed.size());
+    }
+    total_size += bytes.size();
   }
   VLOG(3) << "Compressed element from " << total_size << " bytes to "
-          << out->data().size() << " bytes";
+          << data->size() << " bytes";
   return Status::OK();
 }
 
-Status UncompressElement(const CompressedElement& compressed,
-                         std::vector<Tensor>* out) {
+namespace {
+
+// Uncompresses an element whose components were compressed together in a
+// single snappy stream, the format before per-component codecs.
+Status UncompressSnappyElement(const CompressedElement& compressed,
+                               std::vector<Tensor>* out) {
   int num_components = compressed.component_metadata_size();
   out->clear();
   out->reserve(num_components);
@@ -146,5 +147,60 @@ Status UncompressElement(const CompressedElement& compressed,
   return Status::OK();
 }
 
+}  // namespace
+
+Status UncompressElement(const CompressedElement& compressed,
+                         std::vector<Tensor>* out) {
+  if (!compressed.per_component_codecs()) {
+    return UncompressSnappyElement(compressed, out);
+  }
+  int num_components = compressed.component_metadata_size();
+  out->clear();
+  out->reserve(num_components);
+  const std::string& data = compressed.data();
+  size_t offset = 0;
+  for (int i = 0; i < num_components; ++i) {
+    const CompressedComponentMetadata& metadata =
+        compressed.component_metadata(i);
+    const size_t compressed_size = metadata.compressed_size_bytes();
+    if (compressed_size > data.size() - offset) {
+      return errors::Internal("Component ", i, " of ", compressed_size,
+                              " compressed bytes is past the end of the ",
+                              data.size(), " bytes of the element");
+    }
+    const StringPiece bytes(data.data() + offset, compressed_size);
+    offset += compressed_size;
+    const TensorCodec codec = static_cast<TensorCodec>(metadata.codec());
+    if (DataTypeCanUseMemcpy(metadata.dtype())) {
+      out->emplace_back(metadata.dtype(), metadata.tensor_shape());
+      StringPiece buf = out->back().tensor_data();
+      if (buf.size() != metadata.tensor_size_bytes()) {
+        return errors::Internal("Component ", i, " has ", buf.size(),
+                                " bytes whereas its metadata suggests ",
+                                metadata.tensor_size_bytes());
+      }
+      TF_RETURN_IF_ERROR(UncompressTensorData(
+          codec, bytes, DataTypeSize(metadata.dtype()),
+          const_cast<char*>(buf.data()), buf.size()));
+    } else {
+      // We use tstring for access to resize_uninitialized.
+      tstring tensor_proto_str;
+      tensor_proto_str.resize_uninitialized(metadata.tensor_size_bytes());
+      TF_RETURN_IF_ERROR(UncompressTensorData(codec, bytes, /*element_size=*/1,
+                                              tensor_proto_str.mdata(),
+                                              tensor_proto_str.size()));
+      TensorProto tp;
+      if (!tp.ParseFromString(tensor_proto_str)) {
+        return errors::Internal("Could not parse TensorProto");
+      }
+      out->emplace_back();
+      if (!out->back().FromProto(tp)) {
+        return errors::Internal("Could not parse Tensor");
+      }
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace data
 }  // namespace tensorflow
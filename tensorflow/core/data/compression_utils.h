@@ -25,7 +25,8 @@ namespace data {
 // Compresses the components of `element` into the `CompressedElement` proto.
 //
 // In addition to writing the actual compressed bytes, `Compress` fills
-// out the per-component metadata for the `CompressedElement`.
+// out the per-component metadata for the `CompressedElement`, including the
+// codec chosen for each component.
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out);
 
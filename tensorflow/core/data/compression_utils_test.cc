@@ -16,7 +16,11 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 namespace tensorflow {
 namespace data {
@@ -43,11 +47,58 @@ std::vector<std::vector<Tensor>> TestCases() {
       {CreateTensor<tstring>(TensorShape{1}, {"a"}),
        CreateTensor<int64>(TensorShape{1}, {1})},  // mixed tstring/int64
       {},                                          // empty
+      CreateTensors<float>(TensorShape{1000},
+                           {std::vector<float>(1000, 0.5f)}),  // float
   };
 }
 
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
+TEST(CompressionUtilsTest, ComponentsUseTheirOwnCodec) {
+  std::vector<float> smooth(10000);
+  for (size_t i = 0; i < smooth.size(); ++i) smooth[i] = 1.0f + i * 1e-6f;
+  random::PhiloxRandom philox(7, 7);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> random(10000);
+  for (int32& v : random) v = rnd.Rand32();
+  std::vector<Tensor> element = {
+      test::AsTensor<float>(smooth), test::AsTensor<int32>(random),
+      test::AsTensor<int64>(std::vector<int64>(10000, 0))};
+
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, &compressed));
+  ASSERT_EQ(compressed.component_metadata_size(), 3);
+  EXPECT_EQ(compressed.component_metadata(0).codec(),
+            TENSOR_CODEC_SHUFFLE_SNAPPY);
+  EXPECT_EQ(compressed.component_metadata(1).codec(), TENSOR_CODEC_NONE);
+  EXPECT_NE(compressed.component_metadata(2).codec(), TENSOR_CODEC_NONE);
+
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  ASSERT_EQ(round_trip_element.size(), 3);
+  test::ExpectTensorEqual<float>(round_trip_element[0], element[0]);
+  test::ExpectTensorEqual<int32>(round_trip_element[1], element[1]);
+  test::ExpectTensorEqual<int64>(round_trip_element[2], element[2]);
+}
+
+TEST(CompressionUtilsTest, UncompressSnappyElement) {
+  // An element compressed before components had their own codecs.
+  Tensor component = test::AsTensor<int64>({1, 2, 3});
+  CompressedElement compressed;
+  CompressedComponentMetadata* metadata = compressed.add_component_metadata();
+  metadata->set_dtype(DT_INT64);
+  component.shape().AsProto(metadata->mutable_tensor_shape());
+  metadata->set_tensor_size_bytes(component.tensor_data().size());
+  ASSERT_TRUE(port::Snappy_Compress(component.tensor_data().data(),
+                                    component.tensor_data().size(),
+                                    compressed.mutable_data()));
+
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(UncompressElement(compressed, &element));
+  ASSERT_EQ(element.size(), 1);
+  test::ExpectTensorEqual<int64>(element[0], component);
+}
+
 }  // namespace data
 }  // namespace tensorflow
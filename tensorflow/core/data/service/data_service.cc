@@ -56,13 +56,15 @@ std::string ProcessingModeToString(ProcessingMode mode) {
 
 Status DataServiceDispatcherClient::WorkerHeartbeat(
     const std::string& worker_address, const std::vector<int64>& current_tasks,
-    std::vector<TaskDef>& new_tasks, std::vector<int64>& tasks_to_delete) {
+    const WorkerLoad& load, std::vector<TaskDef>& new_tasks,
+    std::vector<int64>& tasks_to_delete) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   WorkerHeartbeatRequest req;
   req.set_worker_address(worker_address);
   for (int64 task : current_tasks) {
     req.add_current_tasks(task);
   }
+  *req.mutable_load() = load;
   WorkerHeartbeatResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->WorkerHeartbeat(&client_ctx, req, &resp);
@@ -150,11 +152,13 @@ Status DataServiceDispatcherClient::RegisterDataset(GraphDef dataset,
 
 Status DataServiceDispatcherClient::CreateJob(int64 dataset_id,
                                               ProcessingMode processing_mode,
+                                              int64 num_consumers,
                                               int64& job_client_id) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   CreateJobRequest req;
   req.set_dataset_id(dataset_id);
   req.set_processing_mode(ProcessingModeDef(processing_mode));
+  req.set_num_consumers(num_consumers);
   CreateJobResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->CreateJob(&client_ctx, req, &resp);
@@ -169,13 +173,15 @@ Status DataServiceDispatcherClient::CreateJob(int64 dataset_id,
 
 Status DataServiceDispatcherClient::GetOrCreateJob(
     int64 dataset_id, ProcessingMode processing_mode,
-    const std::string& job_name, int job_name_index, int64& job_client_id) {
+    const std::string& job_name, int job_name_index, int64 num_consumers,
+    int64& job_client_id) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   GetOrCreateJobRequest req;
   req.set_dataset_id(dataset_id);
   req.set_processing_mode(ProcessingModeDef(processing_mode));
   req.set_job_name(job_name);
   req.set_job_name_index(job_name_index);
+  req.set_num_consumers(num_consumers);
   GetOrCreateJobResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->GetOrCreateJob(&client_ctx, req, &resp);
@@ -241,6 +247,24 @@ Status DataServiceDispatcherClient::GetWorkers(
   return Status::OK();
 }
 
+Status DataServiceDispatcherClient::GetWorkerStats(
+    std::vector<WorkerStats>& workers, double& starvation) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetWorkerStatsRequest req;
+  GetWorkerStatsResponse resp;
+  grpc::ClientContext ctx;
+  grpc::Status s = stub_->GetWorkerStats(&ctx, req, &resp);
+  if (!s.ok()) {
+    return grpc_util::WrapError("Failed to get worker stats", s);
+  }
+  workers.clear();
+  for (auto& worker : resp.workers()) {
+    workers.push_back(worker);
+  }
+  starvation = resp.starvation();
+  return Status::OK();
+}
+
 Status DataServiceDispatcherClient::EnsureInitialized() {
   mutex_lock l(mu_);
   if (stub_) {
@@ -256,17 +280,62 @@ Status DataServiceDispatcherClient::EnsureInitialized() {
   return Status::OK();
 }
 
+mutex LocalWorkers::mu_(LINKER_INITIALIZED);
+LocalWorkers::AddressToWorkerMap* LocalWorkers::local_workers_ =
+    new AddressToWorkerMap();
+
+void LocalWorkers::Add(const std::string& worker_address,
+                       std::shared_ptr<LocalWorker> worker) {
+  DCHECK(worker != nullptr) << "Adding a nullptr local worker is disallowed.";
+  VLOG(1) << "Register local worker at address " << worker_address;
+  mutex_lock l(mu_);
+  (*local_workers_)[worker_address] = std::move(worker);
+}
+
+std::shared_ptr<LocalWorker> LocalWorkers::Get(
+    const std::string& worker_address) {
+  tf_shared_lock l(mu_);
+  auto it = local_workers_->find(worker_address);
+  if (it == local_workers_->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void LocalWorkers::Remove(const std::string& worker_address) {
+  VLOG(1) << "Remove local worker at address " << worker_address;
+  mutex_lock l(mu_);
+  local_workers_->erase(worker_address);
+}
+
 Status DataServiceWorkerClient::GetElement(int64 task_id,
                                            CompressedElement& element,
                                            bool& end_of_sequence) {
-  TF_RETURN_IF_ERROR(EnsureInitialized());
+  return GetElement(task_id, /*consumer_index=*/0, /*round_index=*/0, element,
+                    end_of_sequence);
+}
+
+Status DataServiceWorkerClient::GetElement(int64 task_id, int64 consumer_index,
+                                           int64 round_index,
+                                           CompressedElement& element,
+                                           bool& end_of_sequence) {
   GetElementRequest req;
   req.set_task_id(task_id);
+  req.set_consumer_index(consumer_index);
+  req.set_round_index(round_index);
   GetElementResponse resp;
-  grpc::ClientContext ctx;
-  grpc::Status s = stub_->GetElement(&ctx, req, &resp);
-  if (!s.ok()) {
-    return grpc_util::WrapError("Failed to get element", s);
+  std::shared_ptr<LocalWorker> local_worker = LocalWorkers::Get(address_);
+  if (local_worker != nullptr) {
+    // The element is moved out of the worker's response without being
+    // serialized.
+    TF_RETURN_IF_ERROR(local_worker->GetElement(&req, &resp));
+  } else {
+    TF_RETURN_IF_ERROR(EnsureInitialized());
+    grpc::ClientContext ctx;
+    grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+    if (!s.ok()) {
+      return grpc_util::WrapError("Failed to get element", s);
+    }
   }
   end_of_sequence = resp.end_of_sequence();
   if (!end_of_sequence) {
@@ -16,10 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace data {
@@ -78,9 +82,11 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // registered with the dispatcher, this will register the worker. The
   // dispatcher will report which new tasks the worker should run, and which
   // tasks it should delete. This is stored into `new_tasks` and
-  // `tasks_to_delete`.
+  // `tasks_to_delete`. `load` reports the load of the worker since its
+  // previous heartbeat.
   Status WorkerHeartbeat(const std::string& worker_address,
                          const std::vector<int64>& current_tasks,
+                         const WorkerLoad& load,
                          std::vector<TaskDef>& new_tasks,
                          std::vector<int64>& tasks_to_delete);
 
@@ -101,16 +107,18 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   Status RegisterDataset(GraphDef dataset, int64& dataset_id);
 
   // Creates a new tf.data service job for the specified dataset. The id for the
-  // created job will be stored in `job_client_id`.
+  // created job will be stored in `job_client_id`. If `num_consumers` is
+  // positive, the job's consumers read in coordinated rounds.
   Status CreateJob(int64 dataset_id, ProcessingMode processing_mode,
-                   int64& job_client_id);
+                   int64 num_consumers, int64& job_client_id);
 
   // Gets the job id for the job represented by the tuple
   // (job_name, job_name_index), and stores the id in `job_client_id`. If the
-  // job doesn't exist yet, it will be created.
+  // job doesn't exist yet, it will be created. If `num_consumers` is positive,
+  // the job's consumers read in coordinated rounds.
   Status GetOrCreateJob(int64 dataset_id, ProcessingMode processing_mode,
                         const std::string& job_name, int job_name_index,
-                        int64& job_client_id);
+                        int64 num_consumers, int64& job_client_id);
 
   // Releases a job client id, indicating that the id will no longer be used to
   // read from the job.
@@ -126,6 +134,12 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // stored in `workers`.
   Status GetWorkers(std::vector<WorkerInfo>& workers);
 
+  // Queries the dispatcher for the load of its workers. The per-worker
+  // statistics will be stored in `workers`, and their mean starvation in
+  // `starvation`.
+  Status GetWorkerStats(std::vector<WorkerStats>& workers,
+                        double& starvation);
+
  protected:
   Status EnsureInitialized() override;
 
@@ -136,7 +150,41 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   std::unique_ptr<DispatcherService::Stub> stub_;
 };
 
-// Client for communicating with the tf.data service worker.
+// A tf.data service worker which can serve elements to clients running in the
+// same process without going through gRPC.
+class LocalWorker {
+ public:
+  virtual ~LocalWorker() = default;
+
+  virtual Status GetElement(const GetElementRequest* request,
+                            GetElementResponse* response) = 0;
+};
+
+// Registry of the tf.data service workers running in the current process,
+// keyed by the address they registered with the dispatcher. Workers are
+// co-located with their clients in sidecar deployments, where sending every
+// element through gRPC costs a serialization, a copy and a parse.
+class LocalWorkers {
+ public:
+  // Adds `worker` under `worker_address`, replacing any previous worker with
+  // the same address.
+  static void Add(const std::string& worker_address,
+                  std::shared_ptr<LocalWorker> worker);
+  // Returns the worker registered under `worker_address`, or nullptr if there
+  // is none.
+  static std::shared_ptr<LocalWorker> Get(const std::string& worker_address);
+  // Removes the worker registered under `worker_address`, if any.
+  static void Remove(const std::string& worker_address);
+
+ private:
+  using AddressToWorkerMap =
+      absl::flat_hash_map<std::string, std::shared_ptr<LocalWorker>>;
+  static mutex mu_;
+  static AddressToWorkerMap* local_workers_ TF_GUARDED_BY(mu_);
+};
+
+// Client for communicating with the tf.data service worker. Elements of
+// workers in the same process are fetched through `LocalWorkers`.
 class DataServiceWorkerClient : public DataServiceClientBase {
  public:
   DataServiceWorkerClient(const std::string& address,
@@ -149,6 +197,13 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   Status GetElement(int64 task_id, CompressedElement& element,
                     bool& end_of_sequence);
 
+  // Like `GetElement` above, but for a task of a job with coordinated reads:
+  // fetches the element of round `round_index` for consumer `consumer_index`.
+  // If the task has reached the end of its input, `end_of_sequence` is `true`
+  // for all consumers of the round.
+  Status GetElement(int64 task_id, int64 consumer_index, int64 round_index,
+                    CompressedElement& element, bool& end_of_sequence);
+
  protected:
   Status EnsureInitialized() override;
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
@@ -37,7 +38,29 @@ namespace data {
 
 namespace {
 constexpr const char kProtocol[] = "grpc+local";
-}
+
+// Local worker which returns `num_elements` copies of `element` for any task.
+class FakeLocalWorker : public LocalWorker {
+ public:
+  FakeLocalWorker(const CompressedElement& element, int num_elements)
+      : element_(element), num_elements_(num_elements) {}
+
+  Status GetElement(const GetElementRequest* request,
+                    GetElementResponse* response) override {
+    if (num_elements_ == 0) {
+      response->set_end_of_sequence(true);
+      return Status::OK();
+    }
+    --num_elements_;
+    *response->mutable_compressed_element() = element_;
+    return Status::OK();
+  }
+
+ private:
+  const CompressedElement element_;
+  int num_elements_;
+};
+}  // namespace
 
 TEST(DataService, ParseParallelEpochsProcessingMode) {
   ProcessingMode mode;
@@ -74,5 +97,101 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, GetWorkerStats) {
+  TestCluster cluster(0);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  auto heartbeat = [&dispatcher](const std::string& address,
+                                 int64 elements_produced,
+                                 int64 processing_time_us, int64 interval_us) {
+    WorkerLoad load;
+    load.set_elements_produced(elements_produced);
+    load.set_processing_time_us(processing_time_us);
+    load.set_interval_us(interval_us);
+    std::vector<TaskDef> new_tasks;
+    std::vector<int64> tasks_to_delete;
+    return dispatcher.WorkerHeartbeat(address, /*current_tasks=*/{}, load,
+                                      new_tasks, tasks_to_delete);
+  };
+  // The first heartbeats register the workers without reporting any load.
+  TF_ASSERT_OK(heartbeat("localhost:1", 0, 0, 0));
+  TF_ASSERT_OK(heartbeat("localhost:2", 0, 0, 0));
+  std::vector<WorkerStats> workers;
+  double starvation = -1.0;
+  TF_ASSERT_OK(dispatcher.GetWorkerStats(workers, starvation));
+  EXPECT_TRUE(workers.empty());
+  EXPECT_EQ(0.0, starvation);
+
+  TF_ASSERT_OK(heartbeat("localhost:1", /*elements_produced=*/100,
+                         /*processing_time_us=*/1000000,
+                         /*interval_us=*/2000000));
+  TF_ASSERT_OK(heartbeat("localhost:2", /*elements_produced=*/10,
+                         /*processing_time_us=*/1000000,
+                         /*interval_us=*/1000000));
+  TF_ASSERT_OK(dispatcher.GetWorkerStats(workers, starvation));
+  ASSERT_EQ(2, workers.size());
+  absl::flat_hash_map<std::string, WorkerStats> stats;
+  for (const WorkerStats& worker : workers) {
+    stats[worker.worker_address()] = worker;
+  }
+  EXPECT_DOUBLE_EQ(100.0, stats["localhost:1"].production_rate());
+  EXPECT_DOUBLE_EQ(0.5, stats["localhost:1"].starvation());
+  EXPECT_DOUBLE_EQ(10.0, stats["localhost:2"].production_rate());
+  EXPECT_DOUBLE_EQ(1.0, stats["localhost:2"].starvation());
+  EXPECT_DOUBLE_EQ(0.75, starvation);
+
+  // An idle interval lowers starvation but keeps the production rate.
+  TF_ASSERT_OK(heartbeat("localhost:2", 0, 0, /*interval_us=*/1000000));
+  TF_ASSERT_OK(dispatcher.GetWorkerStats(workers, starvation));
+  for (const WorkerStats& worker : workers) {
+    if (worker.worker_address() == "localhost:2") {
+      EXPECT_DOUBLE_EQ(10.0, worker.production_rate());
+      EXPECT_DOUBLE_EQ(0.5, worker.starvation());
+    }
+  }
+}
+
+TEST(DataService, LocalWorkers) {
+  const std::string address = "localhost:1234";
+  EXPECT_EQ(nullptr, LocalWorkers::Get(address));
+  auto worker = std::make_shared<FakeLocalWorker>(CompressedElement(), 0);
+  LocalWorkers::Add(address, worker);
+  EXPECT_EQ(worker, LocalWorkers::Get(address));
+  EXPECT_EQ(nullptr, LocalWorkers::Get("localhost:1235"));
+  LocalWorkers::Remove(address);
+  EXPECT_EQ(nullptr, LocalWorkers::Get(address));
+}
+
+TEST(DataService, GetElementFromLocalWorker) {
+  // Nothing listens on this address, so elements can only come from the
+  // local worker.
+  const std::string address = "localhost:1";
+  CompressedElement element;
+  element.add_component_metadata()->set_dtype(DT_INT64);
+  LocalWorkers::Add(address, std::make_shared<FakeLocalWorker>(
+                                 element, /*num_elements=*/2));
+  DataServiceWorkerClient client(address, kProtocol);
+  for (int i = 0; i < 2; ++i) {
+    CompressedElement result;
+    bool end_of_sequence = true;
+    TF_ASSERT_OK(client.GetElement(/*task_id=*/0, result, end_of_sequence));
+    EXPECT_FALSE(end_of_sequence);
+    ASSERT_EQ(1, result.component_metadata_size());
+    EXPECT_EQ(DT_INT64, result.component_metadata(0).dtype());
+  }
+  CompressedElement result;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(client.GetElement(/*task_id=*/0, result, end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+  LocalWorkers::Remove(address);
+}
+
+TEST(DataService, ClusterWorkersAreLocal) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  EXPECT_NE(nullptr, LocalWorkers::Get(cluster.WorkerAddress(0)));
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -12,6 +12,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/dispatcher_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -50,8 +51,10 @@ namespace {
 constexpr char kJournalDir[] = "tf_data_dispatcher_journal";
 // The name of the datasets directory inside the dispatcher's working directory.
 constexpr char kDatasetsDir[] = "datasets";
+// The weight of the latest heartbeat in the smoothed worker statistics.
+constexpr double kLoadSmoothingFactor = 0.5;
 
-constexpr std::array<const char*, 8> kNodeNameSharingOps = {
+constexpr std::array<const char*, 9> kNodeNameSharingOps = {
     "HashTable",
     "HashTableV2",
     "MutableHashTable",
@@ -60,6 +63,7 @@ constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "MutableDenseHashTableV2",
     "MutableHashTableOfTensors",
     "MutableHashTableOfTensorsV2",
+    "ShardedMutableHashTable",
 };
 
 using Dataset = DispatcherState::Dataset;
@@ -211,6 +215,7 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
     TF_RETURN_IF_ERROR(CreateTasksForWorker(worker_address));
     TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, correct_tasks));
   }
+  UpdateWorkerStats(worker_address, request->load());
 
   absl::flat_hash_set<int64> current_tasks;
   current_tasks.insert(request->current_tasks().cbegin(),
@@ -240,6 +245,7 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
     task_def->set_job_id(task->job_id);
     task_def->set_task_id(task->task_id);
     task_def->set_processing_mode(ProcessingModeDef(task->processing_mode));
+    task_def->set_num_consumers(task->num_consumers);
   }
   for (int64 current_task : current_tasks) {
     if (!correct_tasks_set.contains(current_task)) {
@@ -393,7 +399,8 @@ Status DataServiceDispatcherImpl::CreateJob(const CreateJobRequest* request,
   {
     mutex_lock l(mu_);
     TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(), processing_mode,
-                                 absl::optional<NamedJobKey>(), job));
+                                 absl::optional<NamedJobKey>(),
+                                 request->num_consumers(), job));
     int64 job_client_id;
     TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
     response->set_job_client_id(job_client_id);
@@ -422,7 +429,8 @@ Status DataServiceDispatcherImpl::GetOrCreateJob(
     Status s = state_.NamedJobByKey(key, job);
     if (s.ok()) {
       TF_RETURN_IF_ERROR(ValidateMatchingJob(job, requested_processing_mode,
-                                             request->dataset_id()));
+                                             request->dataset_id(),
+                                             request->num_consumers()));
       int64 job_client_id;
       TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
       response->set_job_client_id(job_client_id);
@@ -432,8 +440,9 @@ Status DataServiceDispatcherImpl::GetOrCreateJob(
     } else if (!errors::IsNotFound(s)) {
       return s;
     }
-    TF_RETURN_IF_ERROR(
-        CreateJob(request->dataset_id(), requested_processing_mode, key, job));
+    TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(),
+                                 requested_processing_mode, key,
+                                 request->num_consumers(), job));
     int64 job_client_id;
     TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
     response->set_job_client_id(job_client_id);
@@ -462,10 +471,11 @@ Status DataServiceDispatcherImpl::ReleaseJobClient(
   return Status::OK();
 }
 
-// Validates that the job matches the given processing_mode and dataset_id.
+// Validates that the job matches the given processing_mode, dataset_id and
+// num_consumers.
 Status DataServiceDispatcherImpl::ValidateMatchingJob(
     std::shared_ptr<const Job> job, ProcessingMode processing_mode,
-    int64 dataset_id) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    int64 dataset_id, int64 num_consumers) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   DCHECK(job->named_job_key.has_value());
   std::string job_name = job->named_job_key->name;
   if (job->processing_mode != processing_mode) {
@@ -478,13 +488,21 @@ Status DataServiceDispatcherImpl::ValidateMatchingJob(
         "processing mode <",
         actual, ">");
   }
+  if (job->num_consumers != num_consumers) {
+    return errors::FailedPrecondition(
+        "Tried to create a job with name ", job_name, " and num_consumers ",
+        num_consumers,
+        " but there is already an existing job with that name using "
+        "num_consumers ",
+        job->num_consumers);
+  }
   return Status::OK();
 }
 
 Status DataServiceDispatcherImpl::CreateJob(
     int64 dataset_id, ProcessingMode processing_mode,
-    absl::optional<NamedJobKey> named_job_key, std::shared_ptr<const Job>& job)
-    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    absl::optional<NamedJobKey> named_job_key, int64 num_consumers,
+    std::shared_ptr<const Job>& job) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   switch (processing_mode) {
     case ProcessingMode::PARALLEL_EPOCHS:
     case ProcessingMode::DISTRIBUTED_EPOCH:
@@ -493,6 +511,10 @@ Status DataServiceDispatcherImpl::CreateJob(
       return errors::Internal(
           absl::StrCat("ProcessingMode ", processing_mode, " not recognized"));
   }
+  if (num_consumers < 0) {
+    return errors::InvalidArgument(
+        "num_consumers must be non-negative, but got ", num_consumers);
+  }
   int64 job_id = state_.NextAvailableJobId();
   if (processing_mode == ProcessingMode::DISTRIBUTED_EPOCH) {
     TF_RETURN_IF_ERROR(MakeDistributedEpochJob(job_id, dataset_id));
@@ -507,6 +529,7 @@ Status DataServiceDispatcherImpl::CreateJob(
     key->set_name(named_job_key->name);
     key->set_index(named_job_key->index);
   }
+  create_job->set_num_consumers(num_consumers);
   TF_RETURN_IF_ERROR(Apply(update));
   TF_RETURN_IF_ERROR(state_.JobFromId(job_id, job));
   return Status::OK();
@@ -565,6 +588,7 @@ Status DataServiceDispatcherImpl::CreateTask(std::shared_ptr<const Job> job,
   create_task->set_dataset_id(job->dataset_id);
   create_task->set_processing_mode(ProcessingModeDef(job->processing_mode));
   create_task->set_worker_address(worker_address);
+  create_task->set_num_consumers(job->num_consumers);
   TF_RETURN_IF_ERROR(Apply(update));
   TF_RETURN_IF_ERROR(state_.TaskFromId(task_id, task));
   return Status::OK();
@@ -631,6 +655,7 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
   }
   task_def->set_task_id(task->task_id);
   task_def->set_processing_mode(ProcessingModeDef(task->processing_mode));
+  task_def->set_num_consumers(task->num_consumers);
   ProcessTaskResponse resp;
   WorkerService::Stub* stub;
   TF_RETURN_IF_ERROR(GetOrCreateWorkerStub(task->worker_address, stub));
@@ -661,11 +686,13 @@ Status DataServiceDispatcherImpl::GetTasks(const GetTasksRequest* request,
   TF_RETURN_IF_ERROR(s);
   std::vector<std::shared_ptr<const Task>> tasks;
   TF_RETURN_IF_ERROR(state_.TasksForJob(job->job_id, tasks));
-  for (const auto& task : tasks) {
+  std::vector<double> weights = TaskWeights(tasks);
+  for (int i = 0; i < tasks.size(); ++i) {
     TaskInfo* task_info = response->mutable_task_info()->Add();
-    task_info->set_worker_address(task->worker_address);
-    task_info->set_task_id(task->task_id);
+    task_info->set_worker_address(tasks[i]->worker_address);
+    task_info->set_task_id(tasks[i]->task_id);
     task_info->set_job_id(job->job_id);
+    task_info->set_weight(weights[i]);
   }
   response->set_job_finished(job->finished);
   VLOG(3) << "Found " << response->task_info_size()
@@ -688,6 +715,80 @@ Status DataServiceDispatcherImpl::GetWorkers(const GetWorkersRequest* request,
   return Status::OK();
 }
 
+Status DataServiceDispatcherImpl::GetWorkerStats(
+    const GetWorkerStatsRequest* request, GetWorkerStatsResponse* response) {
+  TF_RETURN_IF_ERROR(CheckStarted());
+  mutex_lock l(mu_);
+  double total_starvation = 0.0;
+  for (const auto& worker : state_.ListWorkers()) {
+    auto it = worker_stats_.find(worker->address);
+    if (it == worker_stats_.end()) {
+      continue;
+    }
+    *response->add_workers() = it->second;
+    total_starvation += it->second.starvation();
+  }
+  if (response->workers_size() > 0) {
+    response->set_starvation(total_starvation / response->workers_size());
+  }
+  VLOG(3) << "Returning stats for " << response->workers_size()
+          << " workers from GetWorkerStats";
+  return Status::OK();
+}
+
+void DataServiceDispatcherImpl::UpdateWorkerStats(
+    const std::string& worker_address, const WorkerLoad& load)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (load.interval_us() <= 0) {
+    // The first heartbeat of a worker does not cover an interval yet.
+    return;
+  }
+  const bool first_report = !worker_stats_.contains(worker_address);
+  WorkerStats& stats = worker_stats_[worker_address];
+  stats.set_worker_address(worker_address);
+  auto smooth = [](double previous, double sample) {
+    return kLoadSmoothingFactor * sample +
+           (1.0 - kLoadSmoothingFactor) * previous;
+  };
+  const double starvation =
+      std::min(1.0, static_cast<double>(load.processing_time_us()) /
+                        load.interval_us());
+  stats.set_starvation(first_report ? starvation
+                                    : smooth(stats.starvation(), starvation));
+  // Idle intervals say nothing about how fast the worker can produce.
+  if (load.elements_produced() > 0 && load.processing_time_us() > 0) {
+    const double rate = load.elements_produced() * 1e6 /
+                        static_cast<double>(load.processing_time_us());
+    stats.set_production_rate(stats.production_rate() == 0.0
+                                  ? rate
+                                  : smooth(stats.production_rate(), rate));
+  }
+}
+
+std::vector<double> DataServiceDispatcherImpl::TaskWeights(
+    const std::vector<std::shared_ptr<const Task>>& tasks)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::vector<double> weights;
+  weights.reserve(tasks.size());
+  double total_rate = 0.0;
+  int num_known_rates = 0;
+  for (const auto& task : tasks) {
+    auto it = worker_stats_.find(task->worker_address);
+    const double rate =
+        it == worker_stats_.end() ? 0.0 : it->second.production_rate();
+    weights.push_back(rate);
+    if (rate > 0.0) {
+      total_rate += rate;
+      ++num_known_rates;
+    }
+  }
+  // Tasks on workers whose rate is not known yet get the mean weight.
+  for (double& weight : weights) {
+    weight = weight > 0.0 ? weight * num_known_rates / total_rate : 1.0;
+  }
+  return weights;
+}
+
 Status DataServiceDispatcherImpl::CheckStarted() LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   if (!started_) {
@@ -74,6 +74,8 @@ class DataServiceDispatcherImpl {
   Status GetTasks(const GetTasksRequest* request, GetTasksResponse* response);
   Status GetWorkers(const GetWorkersRequest* request,
                     GetWorkersResponse* response);
+  Status GetWorkerStats(const GetWorkerStatsRequest* request,
+                        GetWorkerStatsResponse* response);
 
  private:
   struct DistributedEpochJob {
@@ -114,6 +116,7 @@ class DataServiceDispatcherImpl {
   // dispatcher state with the new job, but does not assign tasks to workers.
   Status CreateJob(int64 dataset_id, ProcessingMode processing_mode,
                    absl::optional<DispatcherState::NamedJobKey> named_job_key,
+                   int64 num_consumers,
                    std::shared_ptr<const DispatcherState::Job>& job)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Creates tasks for the specified worker, one task for every unfinished job.
@@ -143,10 +146,19 @@ class DataServiceDispatcherImpl {
   // Assigns a task to the worker indicated by its `worker_address` field.
   Status AssignTask(std::shared_ptr<const DispatcherState::Task> task)
       LOCKS_EXCLUDED(mu_);
-  // Validates that an existing job matches the given processing_mode and
-  // dataset_id, returning an error status describing any difference.
+  // Validates that an existing job matches the given processing_mode,
+  // dataset_id and num_consumers, returning an error status describing any
+  // difference.
   Status ValidateMatchingJob(std::shared_ptr<const DispatcherState::Job> job,
-                             ProcessingMode processing_mode, int64 dataset_id)
+                             ProcessingMode processing_mode, int64 dataset_id,
+                             int64 num_consumers)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Folds the load reported in a heartbeat into `worker_stats_`.
+  void UpdateWorkerStats(const std::string& worker_address,
+                         const WorkerLoad& load) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Computes the weight of each of `tasks`, see `TaskInfo.weight`.
+  std::vector<double> TaskWeights(
+      const std::vector<std::shared_ptr<const DispatcherState::Task>>& tasks)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Checks that the dispatcher has started, returning UNAVAILABLE if it hasn't.
   Status CheckStarted() LOCKS_EXCLUDED(mu_);
@@ -187,6 +199,10 @@ class DataServiceDispatcherImpl {
   // DISTRIBUTED_EPOCH.
   absl::flat_hash_map<int64, std::unique_ptr<DistributedEpochJob>>
       distributed_epoch_jobs_ TF_GUARDED_BY(mu_);
+  // Load statistics keyed by worker address. These are rebuilt from
+  // heartbeats, so they are not journaled.
+  absl::flat_hash_map<std::string, WorkerStats> worker_stats_
+      TF_GUARDED_BY(mu_);
 
   absl::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
@@ -85,7 +85,7 @@ void DispatcherState::CreateJob(const CreateJobUpdate& create_job) {
   }
   auto job = std::make_shared<Job>(job_id, create_job.dataset_id(),
                                    ProcessingMode(create_job.processing_mode()),
-                                   named_job_key);
+                                   named_job_key, create_job.num_consumers());
   DCHECK(!jobs_.contains(job_id));
   jobs_[job_id] = job;
   tasks_by_job_[job_id] = std::vector<std::shared_ptr<Task>>();
@@ -126,7 +126,8 @@ void DispatcherState::CreateTask(const CreateTaskUpdate& create_task) {
   task = std::make_shared<Task>(task_id, create_task.job_id(),
                                 create_task.dataset_id(),
                                 ProcessingMode(create_task.processing_mode()),
-                                create_task.worker_address());
+                                create_task.worker_address(),
+                                create_task.num_consumers());
   tasks_by_job_[create_task.job_id()].push_back(task);
   tasks_by_worker_[create_task.worker_address()][task->task_id] = task;
   next_available_task_id_ = std::max(next_available_task_id_, task_id + 1);
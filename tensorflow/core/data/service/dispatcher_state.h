@@ -96,16 +96,21 @@ class DispatcherState {
   // A job for processing a dataset.
   struct Job {
     explicit Job(int64 job_id, int64 dataset_id, ProcessingMode processing_mode,
-                 absl::optional<NamedJobKey> named_job_key)
+                 absl::optional<NamedJobKey> named_job_key,
+                 int64 num_consumers)
         : job_id(job_id),
           dataset_id(dataset_id),
           processing_mode(processing_mode),
-          named_job_key(named_job_key) {}
+          named_job_key(named_job_key),
+          num_consumers(num_consumers) {}
 
     const int64 job_id;
     const int64 dataset_id;
     const ProcessingMode processing_mode;
     const absl::optional<NamedJobKey> named_job_key;
+    // The number of consumers reading in coordinated rounds, or 0 if the
+    // consumers read independently.
+    const int64 num_consumers;
     int64 num_clients = 0;
     int64 last_client_released_micros = -1;
     bool finished = false;
@@ -114,18 +119,20 @@ class DispatcherState {
   struct Task {
     explicit Task(int64 task_id, int64 job_id, int64 dataset_id,
                   ProcessingMode processing_mode,
-                  const std::string& worker_address)
+                  const std::string& worker_address, int64 num_consumers)
         : task_id(task_id),
           job_id(job_id),
           dataset_id(dataset_id),
           processing_mode(processing_mode),
-          worker_address(worker_address) {}
+          worker_address(worker_address),
+          num_consumers(num_consumers) {}
 
     const int64 task_id;
     const int64 job_id;
     const int64 dataset_id;
     const ProcessingMode processing_mode;
     const std::string worker_address;
+    const int64 num_consumers;
     bool finished = false;
   };
 
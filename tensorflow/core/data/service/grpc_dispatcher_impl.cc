@@ -47,6 +47,7 @@ HANDLER(ReleaseJobClient);
 HANDLER(GetOrCreateJob);
 HANDLER(GetTasks);
 HANDLER(GetWorkers);
+HANDLER(GetWorkerStats);
 #undef HANDLER
 
 }  // namespace data
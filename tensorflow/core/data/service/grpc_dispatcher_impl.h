@@ -46,6 +46,7 @@ class GrpcDispatcherImpl : public DispatcherService::Service {
   HANDLER(GetOrCreateJob);
   HANDLER(GetTasks);
   HANDLER(GetWorkers);
+  HANDLER(GetWorkerStats);
 #undef HANDLER
 
  private:
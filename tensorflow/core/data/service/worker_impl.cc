@@ -48,6 +48,39 @@ auto* tf_data_service_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/data/service/created",
                                     "Whether a tf.data service server "
                                     "has been created.");
+
+// Moves the element produced by a task's iterator into `element`.
+Status MoveCompressedElement(std::vector<Tensor>& outputs,
+                             CompressedElement& element) {
+  if (outputs.size() != 1) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but the "
+        "dataset produced ",
+        outputs.size(), " outputs");
+  }
+  if (outputs[0].dtype() != DT_VARIANT) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with type ",
+        DataTypeString(outputs[0].dtype()));
+  }
+  if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with shape ",
+        outputs[0].shape());
+  }
+  Variant& variant = outputs[0].scalar<Variant>()();
+  CompressedElement* compressed = variant.get<CompressedElement>();
+  if (compressed == nullptr) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a CompressedElement variant tensor, but "
+        "it produced ",
+        variant.TypeName());
+  }
+  compressed->Swap(&element);
+  return Status::OK();
+}
 }  // namespace
 
 DataServiceWorkerImpl::DataServiceWorkerImpl(
@@ -61,6 +94,7 @@ DataServiceWorkerImpl::~DataServiceWorkerImpl() {
   cancelled_ = true;
   task_completion_cv_.notify_one();
   heartbeat_cv_.notify_one();
+  round_cv_.notify_all();
 }
 
 Status DataServiceWorkerImpl::Start(const std::string& worker_address) {
@@ -187,51 +221,121 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
       return Status::OK();
     }
     auto& task = it->second;
+    if (task->task_def.num_consumers() > 0) {
+      return GetCoordinatedElement(*request, l, *response);
+    }
     TF_RETURN_IF_ERROR(EnsureTaskInitialized(*task));
+    const int64 start_us = Env::Default()->NowMicros();
     TF_RETURN_IF_ERROR(task->iterator->GetNext(&outputs, &end_of_sequence));
+    processing_time_us_ += Env::Default()->NowMicros() - start_us;
+    if (!end_of_sequence) {
+      ++elements_produced_;
+    }
     if (end_of_sequence) {
-      VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
-      task->finished = true;
-      pending_completed_tasks_.insert(request->task_id());
-      task_completion_cv_.notify_one();
+      FinishTask(*task);
     }
   }
 
   if (!end_of_sequence) {
     VLOG(3) << "Producing an element for task " << request->task_id();
-    if (outputs.size() != 1) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but the "
-          "dataset produced ",
-          outputs.size(), " outputs");
+    TF_RETURN_IF_ERROR(MoveCompressedElement(
+        outputs, *response->mutable_compressed_element()));
+  }
+  response->set_end_of_sequence(end_of_sequence);
+
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetCoordinatedElement(
+    const GetElementRequest& request, mutex_lock& l,
+    GetElementResponse& response) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  while (true) {
+    if (cancelled_) {
+      return errors::Cancelled("Worker is shutting down");
     }
-    if (outputs[0].dtype() != DT_VARIANT) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with type ",
-          DataTypeString(outputs[0].dtype()));
+    // The task may be deleted while we wait, so it is looked up after every
+    // wait.
+    auto it = tasks_.find(request.task_id());
+    if (it == tasks_.end() || it->second->finished) {
+      response.set_end_of_sequence(true);
+      return Status::OK();
     }
-    if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with shape ",
-          outputs[0].shape());
+    Task& task = *it->second;
+    const int64 num_consumers = task.task_def.num_consumers();
+    const int64 consumer = request.consumer_index();
+    if (consumer < 0 || consumer >= num_consumers) {
+      return errors::InvalidArgument(
+          "Consumer index for task ", request.task_id(),
+          " must be in the range [0, ", num_consumers, "), but got ", consumer);
     }
-    Variant& variant = outputs[0].scalar<Variant>()();
-    CompressedElement* compressed = variant.get<CompressedElement>();
-    if (compressed == nullptr) {
+    if (request.round_index() < task.round) {
       return errors::FailedPrecondition(
-          "Expected dataset to produce a CompressedElement variant tensor, but "
-          "it produced ",
-          variant.TypeName());
+          "Requested an element of round ", request.round_index(),
+          " from task ", request.task_id(),
+          ", but the task has already moved on to round ", task.round);
+    }
+    if (request.round_index() == task.round) {
+      if (!task.served[consumer]) {
+        task.served[consumer] = true;
+        if (++task.num_served == num_consumers) {
+          round_cv_.notify_all();
+        }
+      }
+      // Elements are kept until the round completes, so that consumers can
+      // retry failed requests.
+      *response.mutable_compressed_element() = task.round_elements[consumer];
+      response.set_end_of_sequence(false);
+      return Status::OK();
     }
-    compressed->Swap(response->mutable_compressed_element());
+    if (task.round < 0 || task.num_served == num_consumers) {
+      TF_RETURN_IF_ERROR(StartRound(task, request.round_index()));
+      continue;
+    }
+    VLOG(3) << "Waiting for " << num_consumers - task.num_served
+            << " consumers to finish round " << task.round << " of task "
+            << request.task_id();
+    round_cv_.wait_for(l, std::chrono::microseconds(kRetryIntervalMicros));
   }
-  response->set_end_of_sequence(end_of_sequence);
+}
 
+Status DataServiceWorkerImpl::StartRound(Task& task, int64 round)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  TF_RETURN_IF_ERROR(EnsureTaskInitialized(task));
+  const int64 num_consumers = task.task_def.num_consumers();
+  std::vector<CompressedElement> elements(num_consumers);
+  for (CompressedElement& element : elements) {
+    std::vector<Tensor> outputs;
+    bool end_of_sequence = false;
+    const int64 start_us = Env::Default()->NowMicros();
+    TF_RETURN_IF_ERROR(task.iterator->GetNext(&outputs, &end_of_sequence));
+    processing_time_us_ += Env::Default()->NowMicros() - start_us;
+    if (end_of_sequence) {
+      // A partial round is dropped, so that all consumers reach the end of
+      // the task in the same round.
+      FinishTask(task);
+      return Status::OK();
+    }
+    ++elements_produced_;
+    TF_RETURN_IF_ERROR(MoveCompressedElement(outputs, element));
+  }
+  VLOG(3) << "Produced round " << round << " of task "
+          << task.task_def.task_id();
+  task.round = round;
+  task.round_elements = std::move(elements);
+  task.served.assign(num_consumers, false);
+  task.num_served = 0;
   return Status::OK();
 }
 
+void DataServiceWorkerImpl::FinishTask(Task& task)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  VLOG(3) << "Reached end_of_sequence for task " << task.task_def.task_id();
+  task.finished = true;
+  pending_completed_tasks_.insert(task.task_def.task_id());
+  task_completion_cv_.notify_one();
+  round_cv_.notify_all();
+}
+
 Status DataServiceWorkerImpl::GetWorkerTasks(
     const GetWorkerTasksRequest* request, GetWorkerTasksResponse* response) {
   mutex_lock l(mu_);
@@ -323,16 +427,28 @@ void DataServiceWorkerImpl::HeartbeatThread() LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
   std::vector<int64> current_tasks;
+  WorkerLoad load;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
     }
+    // The load is reset even if the heartbeat fails, so that every report
+    // covers a single interval.
+    const int64 now_us = Env::Default()->NowMicros();
+    if (last_heartbeat_us_ > 0) {
+      load.set_elements_produced(elements_produced_);
+      load.set_processing_time_us(processing_time_us_);
+      load.set_interval_us(now_us - last_heartbeat_us_);
+    }
+    elements_produced_ = 0;
+    processing_time_us_ = 0;
+    last_heartbeat_us_ = now_us;
   }
   std::vector<TaskDef> new_tasks;
   std::vector<int64> tasks_to_delete;
   TF_RETURN_IF_ERROR(dispatcher_->WorkerHeartbeat(
-      worker_address_, current_tasks, new_tasks, tasks_to_delete));
+      worker_address_, current_tasks, load, new_tasks, tasks_to_delete));
   mutex_lock l(mu_);
   for (const auto& task : new_tasks) {
     Status s = ProcessTaskInternal(task);
@@ -346,6 +462,7 @@ Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
             << " at the request of the dispatcher";
     tasks_.erase(task_id);
   }
+  round_cv_.notify_all();
   return Status::OK();
 }
 
@@ -29,10 +29,10 @@ namespace tensorflow {
 namespace data {
 
 // A TensorFlow DataService serves dataset elements over RPC.
-class DataServiceWorkerImpl {
+class DataServiceWorkerImpl : public LocalWorker {
  public:
   explicit DataServiceWorkerImpl(const experimental::WorkerConfig& config);
-  ~DataServiceWorkerImpl();
+  ~DataServiceWorkerImpl() override;
 
   // Starts the worker. The worker needs to know its own address so that it can
   // register with the dispatcher. This is set in `Start` instead of in the
@@ -49,7 +49,7 @@ class DataServiceWorkerImpl {
 
   /// Client-facing API.
   Status GetElement(const GetElementRequest* request,
-                    GetElementResponse* response);
+                    GetElementResponse* response) override;
   Status GetWorkerTasks(const GetWorkerTasksRequest* request,
                         GetWorkerTasksResponse* response);
 
@@ -65,6 +65,16 @@ class DataServiceWorkerImpl {
     // standalone::Dataset so that we don't need to store the dataset here.
     std::unique_ptr<standalone::Dataset> dataset;
     std::unique_ptr<standalone::Iterator> iterator;
+
+    // State of tasks with coordinated reads, guarded by the worker's `mu_`.
+    // The round whose elements are buffered in `round_elements`, or -1 before
+    // the first round.
+    int64 round = -1;
+    // The elements of `round`, one for each consumer.
+    std::vector<CompressedElement> round_elements;
+    // Which consumers have fetched their element of `round`.
+    std::vector<bool> served;
+    int64 num_served = 0;
   };
 
   // Sends task status to the dispatcher and checks for dispatcher commands.
@@ -72,6 +82,16 @@ class DataServiceWorkerImpl {
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status EnsureTaskInitialized(Task& task);
+  // Gets the element of a task with coordinated reads for the consumer and
+  // round given in `request`, waiting on `round_cv_` until the previous round
+  // of the task has been fetched by all of its consumers.
+  Status GetCoordinatedElement(const GetElementRequest& request,
+                               mutex_lock& l, GetElementResponse& response)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Produces the elements of round `round` of `task`.
+  Status StartRound(Task& task, int64 round) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Marks `task` as finished, so that the dispatcher is notified.
+  void FinishTask(Task& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // A thread for notifying the dispatcher when tasks complete.
   void TaskCompletionThread() LOCKS_EXCLUDED(mu_);
   // A thread for doing periodic heartbeats to the dispatcher.
@@ -92,12 +112,19 @@ class DataServiceWorkerImpl {
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
+  // The load since the previous heartbeat, see `WorkerLoad`.
+  int64 elements_produced_ TF_GUARDED_BY(mu_) = 0;
+  int64 processing_time_us_ TF_GUARDED_BY(mu_) = 0;
+  // The time of the previous heartbeat, or 0 before the first heartbeat.
+  int64 last_heartbeat_us_ TF_GUARDED_BY(mu_) = 0;
   // A thread for notifying the dispatcher when tasks complete.
   std::unique_ptr<Thread> task_completion_thread_;
   condition_variable task_completion_cv_ TF_GUARDED_BY(mu_);
   // A thread for performing regular heartbeats to the dispatcher.
   std::unique_ptr<Thread> heartbeat_thread_;
   condition_variable heartbeat_cv_ TF_GUARDED_BY(mu_);
+  // Notified when a round of a task with coordinated reads completes.
+  condition_variable round_cv_ TF_GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(DataServiceWorkerImpl);
 };
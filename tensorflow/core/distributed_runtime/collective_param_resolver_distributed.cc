@@ -380,33 +380,71 @@ void CollectiveParamResolverDistributed::CompleteInstanceDistributed(
     return CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
   } else if (InstanceIsCached(cp->group.group_key, cp->instance.instance_key)) {
     return CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
-  } else {
-    CompleteInstanceCall* call = new CompleteInstanceCall(
-        cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
-        group_leader_, worker_cache_);
-    CancellationToken abortion_token =
-        abortion_cancel_mgr_.get_cancellation_token();
-    bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
-        abortion_token, [call] { call->Cancel(); });
-    if (already_aborted) {
-      done(errors::Cancelled("collective ops already aborted"));
-      delete call;
+  }
+  const bool share_call = cp->instance.type != BROADCAST_COLLECTIVE;
+  const int32 group_key = cp->group.group_key;
+  const int32 instance_key = cp->instance.instance_key;
+  if (share_call) {
+    mutex_lock l(pending_instance_mu_);
+    auto it = pending_instance_calls_.find({group_key, instance_key});
+    if (it != pending_instance_calls_.end()) {
+      VLOG(2) << "CompleteInstanceDistributed " << device
+              << " waits for the call in flight for instance " << instance_key;
+      it->second.push_back(
+          [this, device, gr, cp, done](const Status& s) {
+            if (s.ok()) {
+              CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
+            } else {
+              done(s);
+            }
+          });
       return;
     }
-    call->Start([this, device, gr, cp, call, abortion_token, done](Status s) {
-      abortion_cancel_mgr_.DeregisterCallback(abortion_token);
-      if (s.ok()) {
-        s = UpdateInstanceCache(gr, cp, call->resp_);
-      }
-      if (s.ok()) {
-        CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
-      } else {
-        done(s);
-      }
-      delete call;
-    });
+    pending_instance_calls_[{group_key, instance_key}];
+  }
+  CompleteInstanceCall* call = new CompleteInstanceCall(
+      cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
+      group_leader_, worker_cache_);
+  CancellationToken abortion_token =
+      abortion_cancel_mgr_.get_cancellation_token();
+  bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
+      abortion_token, [call] { call->Cancel(); });
+  if (already_aborted) {
+    Status s = errors::Cancelled("collective ops already aborted");
+    if (share_call) FinishInstanceCall(group_key, instance_key, s);
+    done(s);
+    delete call;
     return;
   }
+  call->Start([this, device, gr, cp, call, abortion_token, share_call,
+               group_key, instance_key, done](Status s) {
+    abortion_cancel_mgr_.DeregisterCallback(abortion_token);
+    if (s.ok()) {
+      s = UpdateInstanceCache(gr, cp, call->resp_);
+    }
+    delete call;
+    if (share_call) FinishInstanceCall(group_key, instance_key, s);
+    if (s.ok()) {
+      CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
+    } else {
+      done(s);
+    }
+  });
+}
+
+void CollectiveParamResolverDistributed::FinishInstanceCall(
+    int32 group_key, int32 instance_key, const Status& s) {
+  std::vector<InstanceCallWaiter> waiters;
+  {
+    mutex_lock l(pending_instance_mu_);
+    auto it = pending_instance_calls_.find({group_key, instance_key});
+    if (it == pending_instance_calls_.end()) return;
+    waiters = std::move(it->second);
+    pending_instance_calls_.erase(it);
+  }
+  for (const InstanceCallWaiter& waiter : waiters) {
+    waiter(s);
+  }
 }
 
 void CollectiveParamResolverDistributed::StartAbort(const Status& s) {
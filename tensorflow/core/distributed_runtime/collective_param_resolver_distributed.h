@@ -15,6 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
@@ -82,15 +86,35 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
   // Finish populating *cp.  Semantics are like those of
   // CompleteInstanceLocal but will make a remote call to the group
   // leader if necessary.
+  //
+  // The local devices of an instance that is not a broadcast share one
+  // remote call: while the call of one device is in flight, the others wait
+  // for its response instead of issuing their own. A broadcast needs a call
+  // per device, since the leader learns the source from them.
   void CompleteInstanceDistributed(const string& device, const GroupRec* gr,
                                    CollectiveParams* cp,
                                    CancellationManager* cancel_mgr,
                                    const StatusCallback& done)
       TF_LOCKS_EXCLUDED(instance_mu_, gr->mu, group_mu_);
 
+  // Called with the status of the remote call for an instance.
+  typedef std::function<void(const Status&)> InstanceCallWaiter;
+
+  // Runs the waiters of the remote call for (group_key, instance_key) with
+  // `s`, after the instance cache has been updated.
+  void FinishInstanceCall(int32 group_key, int32 instance_key, const Status& s)
+      TF_LOCKS_EXCLUDED(pending_instance_mu_);
+
   WorkerCacheInterface* worker_cache_;  // Not owned
   const string group_leader_;
   CancellationManager abortion_cancel_mgr_;
+
+  mutex pending_instance_mu_;
+  // The local devices waiting for the remote call in flight for a
+  // (group_key, instance_key), other than the device that issued it.
+  absl::flat_hash_map<std::pair<int32, int32>,
+                      std::vector<InstanceCallWaiter>>
+      pending_instance_calls_ TF_GUARDED_BY(pending_instance_mu_);
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 
+#include <atomic>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/test.h"
@@ -75,14 +78,35 @@ class FakeWorker : public TestWorkerInterface {
                              const CompleteInstanceRequest* request,
                              CompleteInstanceResponse* response,
                              StatusCallback done) override {
+    ++num_complete_instance_calls_;
+    if (delay_complete_instance_) {
+      // Keeps the call in flight while the other devices of the caller ask
+      // for the same instance.
+      Env::Default()->SchedClosureAfter(
+          10000, [this, request, response, done]() {
+            param_resolver_->CompleteInstanceAsync(request, response, &cm_,
+                                                   done);
+          });
+      return;
+    }
     param_resolver_->CompleteInstanceAsync(request, response, &cm_, done);
   }
 
+  int num_complete_instance_calls() const {
+    return num_complete_instance_calls_;
+  }
+
+  void set_delay_complete_instance(bool delay) {
+    delay_complete_instance_ = delay;
+  }
+
  private:
   string name_;
   DeviceMgr* device_mgr_;
   CancellationManager cm_;
   CollectiveParamResolverDistributed* param_resolver_;
+  std::atomic<int> num_complete_instance_calls_{0};
+  bool delay_complete_instance_ = false;
 };
 
 class FakeCache : public TestWorkerCache {
@@ -330,6 +354,19 @@ TEST_F(DeviceResDistTest, Workers2Devices2) {
   ValidateCollectiveParams(num_workers, num_devices);
 }
 
+TEST_F(DeviceResDistTest, DevicesShareCompleteInstanceCalls) {
+  const int num_workers = 3;
+  const int num_devices = 4;
+  DefineWorkers(num_workers, num_devices, "CPU", /*nccl*/ false);
+  DefineCollectiveParams(num_workers, num_devices, "CPU");
+  const string leader = "/job:worker/replica:0/task:0";
+  workers_[leader]->set_delay_complete_instance(true);
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+  // One call per worker other than the leader.
+  EXPECT_EQ(workers_[leader]->num_complete_instance_calls(), num_workers - 1);
+}
+
 TEST_F(DeviceResDistTest, DifferentIncarnation) {
   const int num_workers = 2;
   const int num_devices = 1;
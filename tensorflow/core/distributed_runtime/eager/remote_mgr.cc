@@ -15,14 +15,36 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/eager/remote_mgr.h"
 
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/distributed_runtime/eager/remote_tensor_handle.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace eager {
+namespace {
+
+int64 RemoteTensorCacheCapacityBytes() {
+  int64 capacity_bytes;
+  Status s = ReadInt64FromEnvVar("TF_EAGER_REMOTE_TENSOR_CACHE_BYTES", 0,
+                                 &capacity_bytes);
+  if (!s.ok()) {
+    LOG(WARNING) << "Disabling the remote tensor cache: " << s;
+    return 0;
+  }
+  return capacity_bytes;
+}
+
+}  // namespace
+
+RemoteMgr::RemoteMgr(bool is_master, EagerContext* ctx)
+    : is_master_(is_master),
+      remote_tensor_cache_capacity_bytes_(RemoteTensorCacheCapacityBytes()),
+      parent_(ctx) {}
 
 void RemoteMgr::AddOperationOutputs(
     const gtl::ArraySlice<tensorflow::TensorHandle*> handles,
@@ -196,6 +218,70 @@ Status RemoteMgr::DeserializeRemoteTensorHandle(const RemoteTensorHandle& in,
   return Status::OK();
 }
 
+TensorHandle* RemoteMgr::LookupRemoteTensorCopy(const Fprint128& fingerprint,
+                                                const Device* device,
+                                                uint64 context_view_id) {
+  TensorHandle* failed_copy = nullptr;
+  {
+    mutex_lock l(remote_tensor_cache_mu_);
+    auto index_it = remote_tensor_copy_index_.find(
+        RemoteTensorCopyKey{fingerprint, device, context_view_id});
+    if (index_it == remote_tensor_copy_index_.end()) {
+      return nullptr;
+    }
+    RemoteTensorCopyList::iterator copy = index_it->second;
+    if (copy->handle->RemoteCopyStatus(device).ok()) {
+      remote_tensor_copies_.splice(remote_tensor_copies_.begin(),
+                                   remote_tensor_copies_, copy);
+      copy->handle->Ref();
+      return copy->handle;
+    }
+    failed_copy = EraseRemoteTensorCopy(copy);
+  }
+  // Unrefs outside of the lock, since releasing a remote handle may enqueue
+  // its deletion on the remote worker.
+  failed_copy->Unref();
+  return nullptr;
+}
+
+void RemoteMgr::CacheRemoteTensorCopy(const Fprint128& fingerprint,
+                                      const Device* device,
+                                      uint64 context_view_id, int64 num_bytes,
+                                      TensorHandle* handle) {
+  if (num_bytes > remote_tensor_cache_capacity_bytes_) {
+    return;
+  }
+  std::vector<TensorHandle*> evicted;
+  {
+    mutex_lock l(remote_tensor_cache_mu_);
+    const RemoteTensorCopyKey key{fingerprint, device, context_view_id};
+    auto index_it = remote_tensor_copy_index_.find(key);
+    if (index_it != remote_tensor_copy_index_.end()) {
+      evicted.push_back(EraseRemoteTensorCopy(index_it->second));
+    }
+    handle->Ref();
+    remote_tensor_copies_.push_front({key, num_bytes, handle});
+    remote_tensor_copy_index_[key] = remote_tensor_copies_.begin();
+    remote_tensor_cache_bytes_ += num_bytes;
+    while (remote_tensor_cache_bytes_ > remote_tensor_cache_capacity_bytes_) {
+      evicted.push_back(
+          EraseRemoteTensorCopy(std::prev(remote_tensor_copies_.end())));
+    }
+  }
+  for (TensorHandle* h : evicted) {
+    h->Unref();
+  }
+}
+
+TensorHandle* RemoteMgr::EraseRemoteTensorCopy(
+    RemoteTensorCopyList::iterator copy) {
+  TensorHandle* handle = copy->handle;
+  remote_tensor_cache_bytes_ -= copy->num_bytes;
+  remote_tensor_copy_index_.erase(copy->key);
+  remote_tensor_copies_.erase(copy);
+  return handle;
+}
+
 EagerExecutor& RemoteMgr::GetOrCreateExecutorForStream(uint64 stream_id) {
   mutex_lock l(executor_map_mu_);
   auto it = executor_map_.find(stream_id);
@@ -16,11 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_MGR_H_
 
+#include <list>
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/distributed_runtime/eager/remote_tensor_handle.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
@@ -32,13 +34,15 @@ const int64 kInvalidRemoteOpId = -1;
 // TODO(fishx): Move remote state from context to this class.
 class RemoteMgr {
  public:
-  RemoteMgr(bool is_master, EagerContext* ctx)
-      : is_master_(is_master), parent_(ctx) {}
+  RemoteMgr(bool is_master, EagerContext* ctx);
 
   ~RemoteMgr() {
     for (const auto& entry : remote_tensor_handle_map_) {
       entry.second->Unref();
     }
+    for (const auto& entry : remote_tensor_copies_) {
+      entry.handle->Unref();
+    }
   }
 
   bool IsMaster() { return is_master_; }
@@ -76,6 +80,27 @@ class RemoteMgr {
   Status DeserializeRemoteTensorHandle(const RemoteTensorHandle& in,
                                        TensorHandle** out);
 
+  // Copies of local tensors to remote devices are cached by content when the
+  // TF_EAGER_REMOTE_TENSOR_CACHE_BYTES environment variable bounds the bytes
+  // they may hold, so that constants and weights are sent only once.
+  bool RemoteTensorCacheEnabled() const {
+    return remote_tensor_cache_capacity_bytes_ > 0;
+  }
+
+  // Returns a new reference to the cached handle holding the copy on `device`
+  // of a local tensor whose content has `fingerprint`, or nullptr. Copies
+  // which failed are dropped from the cache.
+  TensorHandle* LookupRemoteTensorCopy(const Fprint128& fingerprint,
+                                       const Device* device,
+                                       uint64 context_view_id);
+
+  // Caches `handle`, the copy on `device` of a local tensor of `num_bytes`
+  // bytes whose content has `fingerprint`, and evicts the least recently used
+  // copies beyond the capacity. The cache takes a reference on `handle`.
+  void CacheRemoteTensorCopy(const Fprint128& fingerprint, const Device* device,
+                             uint64 context_view_id, int64 num_bytes,
+                             TensorHandle* handle);
+
   EagerExecutor& GetOrCreateExecutorForStream(uint64 stream_id);
 
   void DeleteExecutorForStream(uint64 stream_id);
@@ -124,6 +149,48 @@ class RemoteMgr {
   MirroredResourceShapeMap mirrored_resource_shape_map_
       TF_GUARDED_BY(mirrored_resource_shape_mu_);
 
+  struct RemoteTensorCopyKey {
+    Fprint128 fingerprint;
+    const Device* device;
+    uint64 context_view_id;
+
+    bool operator==(const RemoteTensorCopyKey& other) const {
+      return fingerprint == other.fingerprint && device == other.device &&
+             context_view_id == other.context_view_id;
+    }
+  };
+  struct RemoteTensorCopyKeyHash {
+    std::size_t operator()(const RemoteTensorCopyKey& key) const {
+      return FingerprintCat64(
+          Fprint128Hasher()(key.fingerprint),
+          FingerprintCat64(reinterpret_cast<uint64>(key.device),
+                           key.context_view_id));
+    }
+  };
+  struct RemoteTensorCopy {
+    RemoteTensorCopyKey key;
+    int64 num_bytes;
+    tensorflow::TensorHandle* handle;
+  };
+  using RemoteTensorCopyList = std::list<RemoteTensorCopy>;
+
+  // Drops the cached `copy` and returns the handle whose reference the cache
+  // held.
+  tensorflow::TensorHandle* EraseRemoteTensorCopy(
+      RemoteTensorCopyList::iterator copy)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(remote_tensor_cache_mu_);
+
+  const int64 remote_tensor_cache_capacity_bytes_;
+  mutex remote_tensor_cache_mu_;
+  // Cached copies of local tensors on remote devices, most recently used
+  // first. The list owns references on the handles it contains.
+  RemoteTensorCopyList remote_tensor_copies_
+      TF_GUARDED_BY(remote_tensor_cache_mu_);
+  std::unordered_map<RemoteTensorCopyKey, RemoteTensorCopyList::iterator,
+                     RemoteTensorCopyKeyHash>
+      remote_tensor_copy_index_ TF_GUARDED_BY(remote_tensor_cache_mu_);
+  int64 remote_tensor_cache_bytes_ TF_GUARDED_BY(remote_tensor_cache_mu_) = 0;
+
   EagerContext* parent_;  // not owned.
 
   mutex executor_map_mu_;
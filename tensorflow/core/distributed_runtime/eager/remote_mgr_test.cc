@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/eager/remote_mgr.h"
 
+#include <stdlib.h>
+
 #include <memory>
 
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
@@ -153,6 +155,53 @@ TEST_F(RemoteMgrTest, SetRemoteShapeWithClusterUpdate) {
   handle->Unref();
 }
 
+TEST_F(RemoteMgrTest, CacheRemoteTensorCopies) {
+  setenv("TF_EAGER_REMOTE_TENSOR_CACHE_BYTES", "100", /*overwrite=*/1);
+  RemoteMgr remote_mgr(true, ctx_);
+  unsetenv("TF_EAGER_REMOTE_TENSOR_CACHE_BYTES");
+  ASSERT_TRUE(remote_mgr.RemoteTensorCacheEnabled());
+  const uint64 view_id = ctx_->GetContextViewId();
+  const Fprint128 first = Fingerprint128("first");
+  const Fprint128 second = Fingerprint128("second");
+
+  TensorHandle* handle = TensorHandle::CreateLazyRemoteHandle(
+      /*op_id=*/1, /*output_num=*/0, DT_FLOAT, remote_device_,
+      /*is_ready=*/true, ctx_);
+  remote_mgr.CacheRemoteTensorCopy(first, remote_device_, view_id, 60, handle);
+  handle->Unref();
+  TensorHandle* cached =
+      remote_mgr.LookupRemoteTensorCopy(first, remote_device_, view_id);
+  EXPECT_EQ(handle, cached);
+  cached->Unref();
+  EXPECT_EQ(nullptr,
+            remote_mgr.LookupRemoteTensorCopy(second, remote_device_, view_id));
+  EXPECT_EQ(nullptr, remote_mgr.LookupRemoteTensorCopy(first, remote_device_,
+                                                       view_id + 1));
+
+  // Exceeding the capacity evicts the least recently used copy.
+  handle = TensorHandle::CreateLazyRemoteHandle(
+      /*op_id=*/2, /*output_num=*/0, DT_FLOAT, remote_device_,
+      /*is_ready=*/true, ctx_);
+  remote_mgr.CacheRemoteTensorCopy(second, remote_device_, view_id, 60, handle);
+  handle->Unref();
+  EXPECT_EQ(nullptr,
+            remote_mgr.LookupRemoteTensorCopy(first, remote_device_, view_id));
+  cached = remote_mgr.LookupRemoteTensorCopy(second, remote_device_, view_id);
+  EXPECT_EQ(handle, cached);
+  cached->Unref();
+
+  // Copies which failed are not reused.
+  handle = TensorHandle::CreateUnshapedRemoteHandle(
+      /*op_id=*/3, /*output_num=*/0, /*remote_task=*/"", DT_FLOAT,
+      remote_device_, ctx_);
+  remote_mgr.CacheRemoteTensorCopy(first, remote_device_, view_id, 10, handle);
+  handle->PoisonRemote(errors::Internal("Failed copy"), remote_device_,
+                       view_id);
+  handle->Unref();
+  EXPECT_EQ(nullptr,
+            remote_mgr.LookupRemoteTensorCopy(first, remote_device_, view_id));
+}
+
 }  // namespace
 }  // namespace eager
 }  // namespace tensorflow
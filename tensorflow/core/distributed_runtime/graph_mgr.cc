@@ -43,6 +43,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -245,6 +247,9 @@ Status GraphMgr::InitItem(
     // Construct the root executor for the subgraph.
     params.device = unit->device;
     params.function_library = lib;
+    params.static_memory_plan_warmup_steps =
+        config_proto.experimental().static_memory_plan_warmup_steps();
+    params.record_op_latency = config_proto.experimental().record_op_latency();
     params.create_kernel =
         [handle, lib, opseg](const std::shared_ptr<const NodeProperties>& props,
                              OpKernel** kernel) {
@@ -292,11 +297,58 @@ Status GraphMgr::InitItem(
   return Status::OK();
 }
 
+absl::optional<uint64> GraphMgr::RegisteredGraphKey(
+    const string& session, const GraphDef& gdef,
+    const GraphOptions& graph_options, const DebugOptions& debug_options,
+    const ConfigProto& config_proto, int64 collective_graph_key) {
+  // tfdbg publishes the graph when it is registered.
+  if (!debug_options.debug_tensor_watch_opts().empty()) {
+    return absl::nullopt;
+  }
+  // The kernels of stateful ops are shared by all the graphs of a session
+  // through the op segment, and the kernels of functions may be, so a graph
+  // with either is only shared within its session.
+  bool session_local = gdef.library().function_size() > 0;
+  for (int i = 0; i < gdef.node_size() && !session_local; ++i) {
+    const OpDef* op_def;
+    session_local =
+        !OpRegistry::Global()->LookUpOpDef(gdef.node(i).op(), &op_def).ok() ||
+        op_def->is_stateful();
+  }
+  uint64 key = DeterministicProtoHash64(gdef);
+  key = Hash64Combine(key, DeterministicProtoHash64(graph_options));
+  key = Hash64Combine(key, DeterministicProtoHash64(config_proto));
+  key = Hash64Combine(key, static_cast<uint64>(collective_graph_key));
+  if (session_local) {
+    key = Hash64Combine(key, Hash64(session));
+  }
+  return key;
+}
+
 Status GraphMgr::Register(
     const string& handle, const GraphDef& gdef, WorkerSession* session,
     const GraphOptions& graph_options, const DebugOptions& debug_options,
     const ConfigProto& config_proto, int64 collective_graph_key,
     DistributedFunctionLibraryRuntime* cluster_flr, string* graph_handle) {
+  const absl::optional<uint64> key =
+      RegisteredGraphKey(handle, gdef, graph_options, debug_options,
+                         config_proto, collective_graph_key);
+  if (key) {
+    mutex_lock l(mu_);
+    auto it = registered_graphs_.find(*key);
+    if (it != registered_graphs_.end()) {
+      Item* item = it->second;
+      item->Ref();
+      ++item->num_handles;
+      *graph_handle =
+          strings::Printf("%016llx", static_cast<long long>(++next_id_));
+      CHECK(table_.insert({*graph_handle, item}).second);
+      VLOG(1) << "Graph " << *graph_handle << " shares the executors of "
+              << item->handle;
+      return Status::OK();
+    }
+  }
+
   Item* item = new Item;
   Status s = InitItem(handle, gdef, session, graph_options, debug_options,
                       config_proto, collective_graph_key, cluster_flr, item);
@@ -311,11 +363,23 @@ Status GraphMgr::Register(
     *graph_handle =
         strings::Printf("%016llx", static_cast<long long>(++next_id_));
     item->handle = *graph_handle;
+    item->num_handles = 1;
     CHECK(table_.insert({*graph_handle, item}).second);
+    // An identical graph registered concurrently keeps its own executors.
+    if (key && registered_graphs_.emplace(*key, item).second) {
+      item->registered_graph_key = key;
+    }
   }
   return Status::OK();
 }
 
+void GraphMgr::RemoveHandle(Item* item) {
+  if (--item->num_handles > 0) return;
+  if (item->registered_graph_key) {
+    registered_graphs_.erase(*item->registered_graph_key);
+  }
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
   // Removes one item from table_.
@@ -328,6 +392,7 @@ Status GraphMgr::Deregister(const string& handle) {
     }
     item = iter->second;
     table_.erase(iter);
+    RemoveHandle(item);
   }
   item->Unref();
   return Status::OK();
@@ -340,6 +405,7 @@ Status GraphMgr::DeregisterAll() {
     mutex_lock l(mu_);
     for (const auto& entry : table_) {
       items.push_back(entry.second);
+      RemoveHandle(entry.second);
     }
     table_.clear();
   }
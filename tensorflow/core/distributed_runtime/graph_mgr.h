@@ -19,6 +19,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
@@ -74,6 +75,12 @@ class GraphMgr {
 
   // Registers a graph. Fills in "handle". The registered graph retains a
   // reference to cluster_flr to do cross process function calls.
+  //
+  // Registering a graph identical to one that is still registered, with the
+  // same options, returns a new handle to the executors of the latter instead
+  // of partitioning, optimizing and building executors again. Graphs with
+  // stateful ops or functions are only shared within a session, since their
+  // kernels are owned by the session.
   Status Register(const string& handle, const GraphDef& gdef,
                   WorkerSession* session, const GraphOptions& graph_options,
                   const DebugOptions& debug_options,
@@ -142,6 +149,11 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // The key of the item in `registered_graphs_`, if it can be shared.
+    absl::optional<uint64> registered_graph_key;
+    // The number of handles in `table_` that refer to the item.
+    int num_handles = 0;
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -163,6 +175,22 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Registered graphs that can be shared, keyed by a hash of their GraphDef
+  // and options. Does not hold a reference: an item is removed when its last
+  // handle is deregistered.
+  std::unordered_map<uint64, Item*> registered_graphs_ TF_GUARDED_BY(mu_);
+
+  // Returns the key of "gdef" in registered_graphs_, or nullopt if its
+  // registrations cannot be shared.
+  absl::optional<uint64> RegisteredGraphKey(
+      const string& session, const GraphDef& gdef,
+      const GraphOptions& graph_options, const DebugOptions& debug_options,
+      const ConfigProto& config_proto, int64 collective_graph_key);
+
+  // Removes a handle to "item", and the item from registered_graphs_ with
+  // its last handle.
+  void RemoveHandle(Item* item) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               CollectiveExecutor::Handle* ce_handle,
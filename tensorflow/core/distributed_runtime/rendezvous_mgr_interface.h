@@ -84,6 +84,16 @@ class RendezvousMgrInterface {
                               const Rendezvous::ParsedKey& parsed,
                               Rendezvous::DoneCallback done) = 0;
 
+  // As above, but the receive can be cancelled through
+  // `recv_args.cancellation_manager`, in which case "done" runs with a
+  // Cancelled status and the tensor stays available to later receives.
+  //
+  // This method is used by the rpc handler of RecvTensors.
+  virtual void RecvLocalAsync(int64 step_id,
+                              const Rendezvous::ParsedKey& parsed,
+                              const Rendezvous::Args& recv_args,
+                              Rendezvous::DoneCallback done) = 0;
+
   // Synchronous wrapper for RecvLocalAsync.
   virtual Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                            Tensor* val, bool* is_dead) = 0;
@@ -523,11 +523,18 @@ std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
 Status GrpcServer::Create(const ServerDef& server_def, Env* env,
                           const DeviceMgr* local_device_mgr,
                           std::unique_ptr<ServerInterface>* out_server) {
-  std::unique_ptr<GrpcServer> ret(
-      new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   GrpcServerOptions options;
   options.rendezvous_mgr_func = NewRpcRendezvousMgr;
   options.local_device_mgr = local_device_mgr;
+  return Create(server_def, env, options, out_server);
+}
+
+/* static */
+Status GrpcServer::Create(const ServerDef& server_def, Env* env,
+                          const GrpcServerOptions& options,
+                          std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<GrpcServer> ret(
+      new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   Status s = ret->Init(options);
   if (!s.ok()) {
     LOG(ERROR) << s;
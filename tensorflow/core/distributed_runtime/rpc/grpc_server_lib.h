@@ -90,6 +90,13 @@ class GrpcServer : public ServerInterface {
   static Status Create(const ServerDef& server_def, Env* env,
                        const DeviceMgr* local_device_mgr,
                        std::unique_ptr<ServerInterface>* out_server);
+  // Creates a server with custom `options`, e.g. for a transport that
+  // provides its own RendezvousMgr through `options.rendezvous_mgr_func` and
+  // registers its services through `options.service_func`. Unset functions
+  // fall back to the gRPC defaults.
+  static Status Create(const ServerDef& server_def, Env* env,
+                       const GrpcServerOptions& options,
+                       std::unique_ptr<ServerInterface>* out_server);
 
   // Destruction is only supported in the factory method. Clean
   // shutdown is not currently implemented for this server type.
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 // (Omitted internal-only flag)
 
@@ -139,6 +140,36 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, require_ack, /*compress=*/false,
+                           result);
+}
+
+// Encodes the content of "val" compressed, if it is large enough and its
+// bytes compress well. Returns false otherwise.
+static bool EncodeCompressedTensorToByteBuffer(const Tensor& val,
+                                               RecvTensorResponse* response,
+                                               ::grpc::ByteBuffer* result) {
+  // Smaller tensors are latency bound, and gain little from compression.
+  const int64 kMinCompressedTensorBytes = 16 << 10;
+  if (!DataTypeCanUseMemcpy(val.dtype()) ||
+      val.TotalBytes() < kMinCompressedTensorBytes) {
+    return false;
+  }
+  string compressed;
+  const TensorCodec codec = CompressTensorData(
+      val.tensor_data(), DataTypeSize(val.dtype()), &compressed);
+  if (codec == TENSOR_CODEC_NONE) return false;
+  response->set_tensor_codec(codec);
+  TensorProto* proto = response->mutable_tensor();
+  proto->set_dtype(val.dtype());
+  val.shape().AsProto(proto->mutable_tensor_shape());
+  proto->set_tensor_content(std::move(compressed));
+  EncodeRecvTensorResponseToByteBuffer(*response, result);
+  return true;
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              bool compress, ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   const int64 kProtoBufLimitBytes = 1LL << 31;
 
@@ -155,6 +186,10 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
   response.set_require_ack(require_ack);
   response.set_send_start_micros(Env::Default()->NowMicros());
+  if (compress && !is_dead &&
+      EncodeCompressedTensorToByteBuffer(val, &response, result)) {
+    return;
+  }
   if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
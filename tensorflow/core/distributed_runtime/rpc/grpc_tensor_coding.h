@@ -49,6 +49,13 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// Like above, but if "compress" is true, compresses the tensor content when
+// it is large and its bytes compress well, and records the codec in
+// "RecvTensorResponse::tensor_codec". Only receivers that set
+// "RecvTensorRequest::accept_compressed_tensor" can decode the result.
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              bool compress, ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -19,10 +19,12 @@ limitations under the License.
 #include "grpcpp/support/slice.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 namespace tensorflow {
 
@@ -98,6 +100,36 @@ TEST_F(GrpcTensorCodingTest, Simple) {
   DoTest<Eigen::half>(DT_HALF);
 }
 
+TEST_F(GrpcTensorCodingTest, CompressedTensor) {
+  for (int64 elems : {100, 100000}) {
+    Tensor a(DT_FLOAT, TensorShape({elems}));
+    test::FillFn<float>(&a, [](int i) { return 1.0f + i * 1e-6f; });
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorToByteBuffer(false, a, false, /*compress=*/true, &buf);
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+    RecvTensorResponse response;
+    ASSERT_TRUE(response.ParseFromString(tmp));
+    if (elems == 100) {
+      // Too small to be worth compressing.
+      EXPECT_EQ(response.tensor_codec(), TENSOR_CODEC_NONE);
+      continue;
+    }
+    EXPECT_EQ(response.tensor_codec(), TENSOR_CODEC_SHUFFLE_SNAPPY);
+    const string& content = response.tensor().tensor_content();
+    EXPECT_LT(content.size(), a.TotalBytes());
+    Tensor b(DT_FLOAT, a.shape());
+    TF_ASSERT_OK(UncompressTensorData(
+        TENSOR_CODEC_SHUFFLE_SNAPPY, content, sizeof(float),
+        const_cast<char*>(b.tensor_data().data()), b.TotalBytes()));
+    test::ExpectTensorEqual<float>(a, b);
+  }
+}
+
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
 }  // namespace tensorflow
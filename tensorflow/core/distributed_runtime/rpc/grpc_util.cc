@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/lib/random/random.h"
 
 namespace tensorflow {
@@ -91,6 +92,44 @@ bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, protobuf::Message* dst) {
   return dst->ParseFromZeroCopyStream(&reader);
 }
 
+namespace {
+
+// A TensorBuffer that holds a reference to a received gRPC slice.
+class GrpcSliceBuffer : public TensorBuffer {
+ public:
+  GrpcSliceBuffer(const ::grpc::Slice& slice, const char* data,
+                  size_t num_bytes)
+      : TensorBuffer(const_cast<char*>(data)),
+        slice_(slice),
+        num_bytes_(num_bytes) {}
+
+  size_t size() const override { return num_bytes_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(num_bytes_);
+    proto->set_allocator_name("grpc");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t num_bytes_;
+};
+
+}  // namespace
+
+TensorBuffer* GrpcByteSource::AliasBuffer(const char* data, size_t num_bytes) {
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) return nullptr;
+  for (const ::grpc::Slice& slice : slices) {
+    const char* begin = reinterpret_cast<const char*>(slice.begin());
+    if (data < begin || data + num_bytes > begin + slice.size()) continue;
+    if (num_bytes < slice.size() / 2) return nullptr;
+    return new GrpcSliceBuffer(slice, data, num_bytes);
+  }
+  return nullptr;
+}
+
 // Overload of GrpcParseProto so we can decode a TensorResponse without
 // extra copying.  This overload is used by the RPCState class in
 // grpc_state.h.
@@ -53,6 +53,11 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the slice of buffer_ that holds `data` if the aliased bytes make
+  // up most of it, so that a large tensor payload does not pin much more
+  // memory than it uses.
+  TensorBuffer* AliasBuffer(const char* data, size_t num_bytes) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
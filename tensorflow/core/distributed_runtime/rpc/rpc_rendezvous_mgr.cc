@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <atomic>
+#include <map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -25,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -33,11 +38,42 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Returns the time, in microseconds, for which receives of CPU tensors from
+// the same remote worker are held back to be coalesced into one RecvTensors
+// call. Batching is disabled if it is 0, which is the default.
+int64 RecvTensorsBatchWindowMicros() {
+  static const int64 window_micros = [] {
+    int64 value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_RECV_TENSORS_BATCH_WINDOW_US", 0,
+                                    &value));
+    return value;
+  }();
+  return window_micros;
+}
+
+// Returns true if remote workers may compress the tensors they send in reply
+// to RecvTensor calls, which saves bandwidth on slow links at the cost of
+// CPU time on both ends. Disabled by default.
+bool AcceptCompressedTensors() {
+  static const bool accept = [] {
+    bool value;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RECV_TENSOR_COMPRESSION", false,
+                                   &value));
+    return value;
+  }();
+  return accept;
+}
+
+// Set once a remote worker has rejected a RecvTensors call, after which all
+// tensors are received individually.
+std::atomic<bool> recv_tensors_unimplemented(false);
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
@@ -49,8 +85,32 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
                            DoneCallback done) override;
 
  private:
+  // A receive waiting to be coalesced with others into a RecvTensors call.
+  struct BatchedRecv {
+    Rendezvous::ParsedKey parsed;
+    Rendezvous::Args recv_args;
+    DoneCallback done;
+  };
+  using RecvBatch = std::vector<BatchedRecv>;
+  // Receives are batched per source worker and cancellation manager.
+  using BatchKey = std::pair<string, CancellationManager*>;
+
   ~RpcRemoteRendezvous() override {}
 
+  // Receives one tensor with a RecvTensor call.
+  void RecvOneFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                              const Rendezvous::Args& args, DoneCallback done);
+
+  // Issues the receives batched under `key`.
+  void FlushRecvBatch(const BatchKey& key);
+
+  // Receives the tensors of `batch` from `src_worker` with RecvTensors
+  // calls, until all of them have been received.
+  void RecvBatchFromRemoteAsync(const string& src_worker, RecvBatch batch);
+
+  mutex batch_mu_;
+  std::map<BatchKey, RecvBatch> pending_batches_ TF_GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -70,6 +130,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    req_.set_accept_compressed_tensor(AcceptCompressedTensors());
   }
 
   void Reset() {
@@ -230,10 +291,223 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// Used to retrieve several CPU tensors from one remote process at once.
+class RpcRecvTensorsCall : public BaseRecvTensorCall {
+ public:
+  RpcRecvTensorsCall(WorkerInterface* wi, int64 step_id,
+                     const std::vector<string>& keys)
+      : wi_(wi) {
+    req_.set_step_id(step_id);
+    for (const string& key : keys) req_.add_rendezvous_key(key);
+    req_.set_request_id(GetUniqueRequestId());
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [this, abort_checked,
+               recv_done = std::move(recv_done)](const Status& s) {
+      abort_checked->WaitForNotification();
+      if (!s.ok()) {
+        mutex_lock l(mu_);
+        status_.Update(s);
+      }
+      recv_done();
+    };
+    wi_->RecvTensorsAsync(&opts_, &req_, &resp_, std::move(cb));
+
+    // As in RpcRecvTensorCall, `StartAbort` may have been called before the
+    // RPC registered its cancellation with `opts_`.
+    Status s;
+    {
+      mutex_lock l(mu_);
+      s = status_;
+    }
+    if (!s.ok()) {
+      opts_.StartCancel();
+    }
+    abort_checked->Notify();
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  const RecvTensorsResponse& response() const { return resp_; }
+
+ private:
+  WorkerInterface* const wi_;  // Not owned.
+  CallOptions opts_;
+  RecvTensorsRequest req_;
+  RecvTensorsResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorsCall);
+};
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  const int64 window_micros = RecvTensorsBatchWindowMicros();
+  string src_worker;
+  string src_rel_device;
+  if (window_micros > 0 && !recv_tensors_unimplemented &&
+      parsed.src.type == DEVICE_CPU && parsed.dst.type == DEVICE_CPU &&
+      DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                       &src_rel_device)) {
+    const BatchKey key(src_worker, recv_args.cancellation_manager);
+    bool schedule_flush;
+    {
+      mutex_lock l(batch_mu_);
+      RecvBatch& batch = pending_batches_[key];
+      schedule_flush = batch.empty();
+      batch.push_back({parsed, recv_args, std::move(done)});
+    }
+    if (schedule_flush) {
+      Ref();
+      env_->env->SchedClosureAfter(window_micros, [this, key]() {
+        FlushRecvBatch(key);
+        Unref();
+      });
+    }
+    return;
+  }
+  RecvOneFromRemoteAsync(parsed, recv_args, std::move(done));
+}
+
+void RpcRemoteRendezvous::FlushRecvBatch(const BatchKey& key) {
+  RecvBatch batch;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(key);
+    if (it == pending_batches_.end()) return;
+    batch = std::move(it->second);
+    pending_batches_.erase(it);
+  }
+  RecvBatchFromRemoteAsync(key.first, std::move(batch));
+}
+
+void RpcRemoteRendezvous::RecvBatchFromRemoteAsync(const string& src_worker,
+                                                   RecvBatch batch) {
+  if (batch.size() == 1 || recv_tensors_unimplemented) {
+    for (BatchedRecv& recv : batch) {
+      RecvOneFromRemoteAsync(recv.parsed, recv.recv_args, std::move(recv.done));
+    }
+    return;
+  }
+  metrics::RecordRecvTensorsBatchSize(batch.size());
+
+  auto fail = [&batch](const Status& s) {
+    for (BatchedRecv& recv : batch) {
+      recv.done(s, Args(), recv.recv_args, Tensor{}, false);
+    }
+  };
+  WorkerSession* sess = session();
+  std::vector<Device*> dst_devices(batch.size());
+  std::vector<string> keys;
+  for (int i = 0; i < batch.size(); ++i) {
+    Status s = sess->device_mgr()->LookupDevice(batch[i].parsed.dst_device,
+                                                &dst_devices[i]);
+    if (!s.ok()) {
+      fail(s);
+      return;
+    }
+    keys.push_back(string(batch[i].parsed.FullKey()));
+  }
+  std::shared_ptr<WorkerCacheInterface> worker_cache =
+      sess->GetSharedWorkerCache();
+  WorkerInterface* rwi = worker_cache->GetOrCreateWorker(src_worker);
+  if (rwi == nullptr) {
+    fail(errors::Internal("No worker known as ", src_worker));
+    return;
+  }
+
+  RpcRecvTensorsCall* call = new RpcRecvTensorsCall(rwi, step_id_, keys);
+  RegisterCall(call, batch.front().recv_args);
+  if (!call->status().ok()) {
+    DeregisterCall(call);
+    worker_cache->ReleaseWorker(src_worker, rwi);
+    Status s = call->status();
+    delete call;
+    fail(s);
+    return;
+  }
+
+  Ref();
+  call->Start([this, call, src_worker, rwi, worker_cache, dst_devices,
+               batch = std::move(batch)]() mutable {
+    DeregisterCall(call);
+    Status s = call->status();
+    worker_cache->ReleaseWorker(src_worker, rwi);
+    if (errors::IsUnimplemented(s)) {
+      LOG(INFO) << src_worker << " does not support RecvTensors, receiving "
+                << "tensors individually instead.";
+      recv_tensors_unimplemented = true;
+      s = Status::OK();
+    }
+
+    // Tensors that became available before the others are returned first.
+    // The remaining ones are requested again before the received ones are
+    // delivered, since delivering them may complete the step.
+    const RecvTensorsResponse& resp = call->response();
+    std::vector<int> response_index(batch.size(), -1);
+    if (s.ok()) {
+      for (int i = 0; i < resp.key_index_size(); ++i) {
+        const int key_index = resp.key_index(i);
+        if (key_index >= 0 && key_index < batch.size() &&
+            i < resp.response_size()) {
+          response_index[key_index] = i;
+        }
+      }
+      RecvBatch missing;
+      for (int i = 0; i < batch.size(); ++i) {
+        if (response_index[i] < 0) missing.push_back(std::move(batch[i]));
+      }
+      if (!missing.empty()) {
+        RecvBatchFromRemoteAsync(src_worker, std::move(missing));
+      }
+    }
+
+    for (int i = 0; i < batch.size(); ++i) {
+      BatchedRecv& recv = batch[i];
+      if (!s.ok()) {
+        recv.done(s, Args(), recv.recv_args, Tensor{}, false);
+        continue;
+      }
+      if (response_index[i] < 0) continue;
+      const RecvTensorResponse& tensor_response =
+          resp.response(response_index[i]);
+      Allocator* allocator =
+          dst_devices[i]->GetAllocator(recv.recv_args.alloc_attrs);
+      Tensor val;
+      Status tensor_status;
+      if (!tensor_response.is_dead() &&
+          !val.FromProto(allocator, tensor_response.tensor())) {
+        tensor_status = errors::Internal("Cannot parse tensor for ",
+                                         recv.parsed.FullKey());
+      }
+      recv.done(tensor_status, Args(), recv.recv_args, val,
+                tensor_response.is_dead());
+    }
+    delete call;
+    Unref();
+  });
+}
+
+void RpcRemoteRendezvous::RecvOneFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -287,6 +287,46 @@ TEST_F(RpcRendezvousMgrTest, TransferDummyDeviceContext) {
   dc->Unref();
 }
 
+TEST_F(RpcRendezvousMgrTest, CancelRecvLocalAsync) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  {
+    RemoteRendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+  }
+  CancellationManager cm;
+  Rendezvous::Args recv_args;
+  recv_args.cancellation_manager = &cm;
+  Notification n;
+  Status status;
+  rmgr_.RecvLocalAsync(step_id, key, recv_args,
+                       [&n, &status](const Status& s,
+                                     const Rendezvous::Args send_args,
+                                     const Rendezvous::Args recv_args,
+                                     const Tensor& val, bool is_dead) {
+                         status = s;
+                         n.Notify();
+                       });
+  cm.StartCancel();
+  n.WaitForNotification();
+  EXPECT_TRUE(errors::IsCancelled(status));
+
+  // The cancelled receive no longer waits for the tensor.
+  {
+    RemoteRendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Send(key, Rendezvous::Args(), V("peach"), false));
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    TF_ASSERT_OK(rendez->Recv(key, Rendezvous::Args(), &val, &val_dead));
+    EXPECT_EQ(V(val), "peach");
+  }
+  rmgr_.Cleanup(step_id);
+}
+
 TEST_F(RpcRendezvousMgrTest, RemoteRecvOne) {
   const int64 step_id = 123;
   const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
@@ -20,11 +20,39 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 namespace tensorflow {
 
 TensorResponse::Source::~Source() {}
 
+namespace {
+
+// Replaces the compressed content of `response->tensor()`, if any, by its
+// uncompressed bytes.
+Status UncompressTensorContent(RecvTensorResponse* response) {
+  const TensorCodec codec =
+      static_cast<TensorCodec>(response->tensor_codec());
+  if (codec == TENSOR_CODEC_NONE) return Status::OK();
+  TensorProto* proto = response->mutable_tensor();
+  if (!DataTypeCanUseMemcpy(proto->dtype()) ||
+      !TensorShape::IsValid(proto->tensor_shape())) {
+    return errors::InvalidArgument("Cannot uncompress tensor from response");
+  }
+  const int element_size = DataTypeSize(proto->dtype());
+  const size_t size =
+      TensorShape(proto->tensor_shape()).num_elements() * element_size;
+  string content;
+  content.resize(size);
+  TF_RETURN_IF_ERROR(UncompressTensorData(codec, proto->tensor_content(),
+                                          element_size, &content[0], size));
+  proto->set_tensor_content(std::move(content));
+  response->set_tensor_codec(TENSOR_CODEC_NONE);
+  return Status::OK();
+}
+
+}  // namespace
+
 void TensorResponse::Clear() {
   on_host_ = false;
   device_ = nullptr;
@@ -53,6 +81,7 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
+  TF_RETURN_IF_ERROR(UncompressTensorContent(&meta_));
   if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
@@ -88,6 +117,7 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    TF_RETURN_IF_ERROR(UncompressTensorContent(&meta_));
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -144,8 +174,34 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 
 }  // namespace
 
+bool TensorResponse::AliasTensorContent(Source* source,
+                                        protobuf::io::CodedInputStream* input,
+                                        DataType dtype,
+                                        const TensorShape& shape,
+                                        int num_bytes) {
+  // Memory that is not obtained from allocator_ is only acceptable if the
+  // tensor has no special placement requirements.
+  if (alloc_attrs_.gpu_compatible() || alloc_attrs_.nic_compatible()) {
+    return false;
+  }
+  if (shape.num_elements() * DataTypeSize(dtype) != num_bytes) return false;
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < num_bytes ||
+      reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return false;
+  }
+  TensorBuffer* buf =
+      source->AliasBuffer(static_cast<const char*>(data), num_bytes);
+  if (buf == nullptr) return false;
+  tensor_ = Tensor(dtype, shape, buf);
+  buf->Unref();
+  return input->Skip(num_bytes);
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -196,12 +252,13 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (AliasTensorContent(source, input, tensor_meta->dtype(), shape,
+                               num_bytes)) {
+          break;
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -235,7 +292,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -277,10 +334,16 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
+// A compressed tensor content is not the size of the tensor, and its
+// RecvTensorResponse has a tensor_codec field, so ParseFast rejects it and
+// ParseSlow uncompresses it.
 bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
   }
+  if (!UncompressTensorContent(&meta_).ok()) {
+    return false;
+  }
 
   Tensor parsed(meta_.tensor().dtype());
   if (!parsed.FromProto(allocator_, meta_.tensor())) {
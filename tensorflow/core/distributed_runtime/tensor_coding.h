@@ -64,6 +64,15 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a new buffer, owned by the caller, that shares the `num_bytes`
+    // bytes at `data` without copying them, or nullptr if the Source cannot
+    // provide one. `data` points into memory yielded by the stream returned
+    // by the last call to contents(), and the returned buffer must keep that
+    // memory alive after the Source is destroyed.
+    virtual TensorBuffer* AliasBuffer(const char* data, size_t num_bytes) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -92,8 +101,15 @@ class TensorResponse {
   DeviceBase* device() const { return device_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
+  // Makes tensor_ share the next `num_bytes` bytes of `input` if `source` can
+  // alias them, and skips them. Returns false, without consuming any input,
+  // if the bytes must be copied instead.
+  bool AliasTensorContent(Source* source, protobuf::io::CodedInputStream* input,
+                          DataType dtype, const TensorShape& shape,
+                          int num_bytes);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
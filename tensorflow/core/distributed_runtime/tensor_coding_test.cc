@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/tensor_compression.h"
 
 namespace tensorflow {
 
@@ -133,6 +136,30 @@ class TensorResponseTest : public ::testing::Test {
   }
 };
 
+TEST_F(TensorResponseTest, CompressedTensorContent) {
+  Tensor src(DT_FLOAT, TensorShape({100, 100}));
+  test::FillFn<float>(&src, [](int i) { return 1.0f + i * 1e-6f; });
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  TensorProto* tensor_proto = proto.mutable_tensor();
+  tensor_proto->set_dtype(DT_FLOAT);
+  src.shape().AsProto(tensor_proto->mutable_tensor_shape());
+  const TensorCodec codec = CompressTensorData(
+      src.tensor_data(), sizeof(float), tensor_proto->mutable_tensor_content());
+  ASSERT_NE(codec, TENSOR_CODEC_NONE);
+  proto.set_tensor_codec(codec);
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(response.tensor(), src);
+}
+
 TEST_F(TensorResponseTest, Simple) {
   DoTest<float>(DT_FLOAT);
   DoTest<double>(DT_DOUBLE);
@@ -156,6 +183,96 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// A buffer that aliases memory owned by the test.
+class UnownedBuffer : public TensorBuffer {
+ public:
+  UnownedBuffer(const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), size_(size) {}
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {}
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+};
+
+// Presents an encoded response in a single block, placed so that `payload`
+// starts on an aligned address, and lets TensorResponse alias it.
+class AliasingSource : public TensorResponse::Source {
+ public:
+  AliasingSource(const string& encoded, const string& payload) {
+    const size_t payload_offset = encoded.find(payload);
+    CHECK_NE(payload_offset, string::npos);
+    storage_.resize(encoded.size() + EIGEN_MAX_ALIGN_BYTES);
+    const intptr_t payload_addr =
+        reinterpret_cast<intptr_t>(storage_.data()) + payload_offset;
+    const size_t pad = (EIGEN_MAX_ALIGN_BYTES -
+                        payload_addr % EIGEN_MAX_ALIGN_BYTES) %
+                       EIGEN_MAX_ALIGN_BYTES;
+    data_ = storage_.data() + pad;
+    size_ = encoded.size();
+    memcpy(data_, encoded.data(), size_);
+  }
+  ~AliasingSource() override { DeleteStream(); }
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    DeleteStream();
+    stream_ = new (&space_) protobuf::io::ArrayInputStream(data_, size_);
+    return stream_;
+  }
+
+  TensorBuffer* AliasBuffer(const char* data, size_t num_bytes) override {
+    ++num_aliased_;
+    return new UnownedBuffer(data, num_bytes);
+  }
+
+  int num_aliased() const { return num_aliased_; }
+  const char* data() const { return data_; }
+
+ private:
+  void DeleteStream() {
+    if (stream_) {
+      stream_->~ArrayInputStream();
+    }
+  }
+
+  string storage_;
+  char* data_;
+  int size_;
+  int num_aliased_ = 0;
+  protobuf::io::ArrayInputStream* stream_ = nullptr;
+  char space_[sizeof(protobuf::io::ArrayInputStream)];
+};
+
+TEST_F(TensorResponseTest, AliasesAlignedContent) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&src, 1.0f);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  AliasingSource source(encoded, string(src.tensor_data()));
+
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(1, source.num_aliased());
+  const Tensor& result = response.tensor();
+  EXPECT_GE(result.tensor_data().data(), source.data());
+  EXPECT_LT(result.tensor_data().data(), source.data() + encoded.size());
+  test::ExpectTensorEqual<float>(src, result);
+
+  // Tensors that must be placed in special memory are always copied.
+  AllocatorAttributes gpu_compatible;
+  gpu_compatible.set_gpu_compatible(true);
+  response.InitAlloc(&cpu_device, gpu_compatible);
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(1, source.num_aliased());
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -28,6 +28,56 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// State shared by the rendezvous callbacks of one RecvTensors call.
+struct RecvTensorsState {
+  RecvTensorsResponse* response;
+  StatusCallback done;
+  CancellationManager cancellation_manager;
+
+  mutex mu;
+  // One hold per issued receive, plus one released once all are issued.
+  int pending TF_GUARDED_BY(mu) = 0;
+  bool issued_all TF_GUARDED_BY(mu) = false;
+  bool cancelled TF_GUARDED_BY(mu) = false;
+  bool any_received TF_GUARDED_BY(mu) = false;
+  Status status TF_GUARDED_BY(mu);
+};
+
+// Drops one hold on `state`. Once a tensor has been received (or a receive
+// has failed) and all receives have been issued, the receives that are still
+// waiting are cancelled, so that the call never blocks on a tensor that is
+// produced only after the caller consumes one of the others.
+void ReleaseRecvTensorsHold(CallOptions* opts,
+                            const std::shared_ptr<RecvTensorsState>& state) {
+  bool start_cancel = false;
+  bool finished = false;
+  Status status;
+  {
+    mutex_lock l(state->mu);
+    finished = --state->pending == 0;
+    if (!finished && state->issued_all && !state->cancelled &&
+        (state->any_received || !state->status.ok())) {
+      state->cancelled = true;
+      start_cancel = true;
+    }
+    status = state->status;
+    if (finished && status.ok() && !state->any_received) {
+      status = errors::Cancelled("RecvTensors was cancelled");
+    }
+  }
+  // Cancellation runs the callbacks of the cancelled receives, which take
+  // `state->mu`.
+  if (start_cancel) state->cancellation_manager.StartCancel();
+  if (finished) {
+    opts->ClearCancelCallback();
+    state->done(status);
+  }
+}
+
+}  // namespace
+
 Worker::Worker(WorkerEnv* env) : env_(env), recent_request_ids_(100000) {
   // Enable log history collection in StatusGroup so that recent warning and
   // error log messages will be attached to the root error status to be
@@ -463,4 +513,88 @@ void Worker::RecvTensorAsync(CallOptions* opts,
   done(errors::Unimplemented("Worker::RecvTensorAsync()"));
 }
 
+void Worker::RecvTensorsAsync(CallOptions* opts,
+                              const RecvTensorsRequest* request,
+                              RecvTensorsResponse* response,
+                              StatusCallback done) {
+  Status s = recent_request_ids_.TrackUnique(request->request_id(),
+                                             "RecvTensors (Worker)", *request);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  const int num_keys = request->rendezvous_key_size();
+  std::vector<Rendezvous::ParsedKey> parsed(num_keys);
+  std::vector<Device*> src_devs(num_keys, nullptr);
+  for (int i = 0; i < num_keys; ++i) {
+    s = Rendezvous::ParseKey(request->rendezvous_key(i), &parsed[i]);
+    if (s.ok()) {
+      s = PrepareRecvTensor(parsed[i], &src_devs[i]);
+    }
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+
+  auto state = std::make_shared<RecvTensorsState>();
+  state->response = response;
+  state->done = std::move(done);
+  {
+    mutex_lock l(state->mu);
+    state->pending = num_keys + 1;
+  }
+  opts->SetCancelCallback(
+      [state]() { state->cancellation_manager.StartCancel(); });
+
+  const int64 step_id = request->step_id();
+  Rendezvous::Args recv_args;
+  recv_args.cancellation_manager = &state->cancellation_manager;
+  for (int i = 0; i < num_keys; ++i) {
+    Device* src_dev = src_devs[i];
+    env_->rendezvous_mgr->RecvLocalAsync(
+        step_id, parsed[i], recv_args,
+        [opts, state, i, src_dev](const Status& status,
+                                  const Rendezvous::Args& send_args,
+                                  const Rendezvous::Args& recv_args,
+                                  const Tensor& val, const bool is_dead) {
+          Status s = status;
+          if (s.ok() && src_dev->tensorflow_gpu_device_info() &&
+              !send_args.alloc_attrs.on_host()) {
+            s = errors::InvalidArgument(
+                "RecvTensors does not support tensors in device memory on ",
+                src_dev->name());
+          }
+          RecvTensorResponse tensor_response;
+          if (s.ok()) {
+            tensor_response.set_is_dead(is_dead);
+            tensor_response.set_send_start_micros(Env::Default()->NowMicros());
+            if (is_dead) {
+              tensor_response.mutable_tensor()->set_dtype(val.dtype());
+            } else {
+              val.AsProtoTensorContent(tensor_response.mutable_tensor());
+            }
+          }
+          {
+            mutex_lock l(state->mu);
+            if (s.ok()) {
+              state->response->add_key_index(i);
+              state->response->add_response()->Swap(&tensor_response);
+              state->any_received = true;
+            } else if (!errors::IsCancelled(s)) {
+              // Keys cancelled because another one was received are simply
+              // left out of the response.
+              state->status.Update(s);
+            }
+          }
+          ReleaseRecvTensorsHold(opts, state);
+        });
+  }
+  {
+    mutex_lock l(state->mu);
+    state->issued_all = true;
+  }
+  ReleaseRecvTensorsHold(opts, state);
+}
+
 }  // namespace tensorflow
@@ -75,6 +75,9 @@ struct MemoryDebugAnnotation {
   const char* pending_region_type = nullptr;
   int32 pending_data_type = 0;
   const TensorShape* pending_shape = nullptr;
+  // The tf.function being executed, if any. Set by
+  // ScopedMemoryDebugFunctionAnnotation, and kept by the op annotations.
+  const char* pending_function_name = nullptr;
 };
 
 // Wrapper class of MemoryDebugAnnotation for RAII.
@@ -139,9 +142,34 @@ class ScopedMemoryDebugAnnotation {
   // Stores the previous values in case the annotations are nested.
   MemoryDebugAnnotation last_annotation_;
 
+  friend class ScopedMemoryDebugFunctionAnnotation;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ScopedMemoryDebugAnnotation);
 };
 
+// Attributes the allocations made by the current thread to the tf.function
+// `function_name` until destruction, in addition to the op annotations.
+// `function_name` must outlive this object.
+class ScopedMemoryDebugFunctionAnnotation {
+ public:
+  explicit ScopedMemoryDebugFunctionAnnotation(const char* function_name)
+      : last_function_name_(
+            ScopedMemoryDebugAnnotation::annotation_.pending_function_name) {
+    ScopedMemoryDebugAnnotation::annotation_.pending_function_name =
+        function_name;
+  }
+
+  ~ScopedMemoryDebugFunctionAnnotation() {
+    ScopedMemoryDebugAnnotation::annotation_.pending_function_name =
+        last_function_name_;
+  }
+
+ private:
+  const char* const last_function_name_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedMemoryDebugFunctionAnnotation);
+};
+
 // Runtime statistics collected by an allocator. Exactly the same as
 // stream_executor::AllocatorStats, but independently defined to preserve the
 // mutual independence of StreamExecutor and TensorFlow.
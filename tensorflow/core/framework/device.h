@@ -151,6 +151,47 @@ class Device : public DeviceBase {
     return Status::OK();
   }
 
+  // Fills in `device_context_map` with a DeviceContext* per node id of
+  // `graph`, for devices that execute nodes on more than one stream. Leaving
+  // the map empty means every node uses the context from
+  // TryGetDeviceContext().
+  //
+  // The caller takes ownership of one reference on each non-null entry of the
+  // map, and should call Unref().
+  virtual Status FillContextMap(
+      const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+    return Status::OK();
+  }
+
+  // The work queued on a device between BeginGraphCapture() and
+  // EndGraphCapture(), which can be queued again without running the kernels
+  // that produced it.
+  class CapturedGraph {
+   public:
+    virtual ~CapturedGraph() {}
+
+    // Queues the captured work on the device. The buffers the work read and
+    // wrote when it was captured must still be allocated.
+    virtual Status Launch() = 0;
+  };
+
+  // Starts capturing the work that kernels queue on the device, instead of
+  // running it, until EndGraphCapture() is called. Nothing may wait for the
+  // device to finish while the work is captured, and the device must not run
+  // other steps concurrently. Returns an error if the device cannot capture
+  // its work.
+  virtual Status BeginGraphCapture() {
+    return errors::Unimplemented(
+        "Graph capture is not supported on this device.");
+  }
+
+  // Ends the capture started by BeginGraphCapture() and returns the captured
+  // work in `graph`. The captured work has not run yet.
+  virtual Status EndGraphCapture(std::unique_ptr<CapturedGraph>* graph) {
+    return errors::Unimplemented(
+        "Graph capture is not supported on this device.");
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 namespace metrics {
@@ -48,6 +50,14 @@ auto* graph_pending_queue_length_histogram = monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count 30 (> 191k)
     {monitoring::Buckets::Exponential(1, 1.5, 30)});
 
+auto* run_handler_queueing_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler/queueing_latency",
+     "The time (in microseconds) a step waited for a RunHandler, by the "
+     "priority requested in RunHandlerPoolOptions.",
+     "priority"},
+    // Power of 2 with bucket count 20 (> 500ms)
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
 auto* graph_run_input_tensor_bytes = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -64,6 +74,27 @@ auto* graph_unused_outputs = monitoring::Counter<1>::New(
     "/tensorflow/core/graph_unused_outputs",
     "The number of unused outputs for ops of a given type.", "name");
 
+auto* collective_compressed_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/collective_compressed_bytes",
+    "The number of bytes sent by compressed collectives, before (raw) and "
+    "after (wire) compression.",
+    "kind");
+
+auto* recv_tensors_batch_size = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/recv_tensors_batch_size",
+     "The number of rendezvous keys requested by each batched RecvTensors "
+     "call."},
+    {monitoring::Buckets::Exponential(1, 2, 10)});
+
+auto* op_latency_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/op_latency_usecs",
+     "The compute time of the kernels in microseconds, by op type and device "
+     "type. Only recorded by the executors of sessions with "
+     "`record_op_latency` set.",
+     "op_type", "device_type"},
+    // Power of 2 with bucket count 24 (> 16 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 auto* tf_data_autotune_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/autotune", "tf.data autotuning", "name");
 
@@ -83,6 +114,14 @@ auto* tf_data_bytes_fetched_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/bytes_fetched",
     "The number of bytes fetched from tf.data Dataset iterator.");
 
+auto* tf_data_checkpoint_bytes = monitoring::Sampler<2>::New(
+    {"/tensorflow/data/checkpoint_bytes",
+     "The number of bytes of buffered elements written to a checkpoint by a "
+     "tf.data iterator, by dataset type and checkpoint mode.",
+     "name", "mode"},
+    // Power of 4 with bucket count 18 (> 16GB)
+    {monitoring::Buckets::Exponential(1, 4, 18)});
+
 auto* tf_data_elements_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/elements", "tf.data elements", "name");
 
@@ -114,6 +153,36 @@ auto* tf_data_getnext_time_between_msecs_histogram =
                                         200., 225., 250., 300., 350., 400.,
                                         450., 500., 1000., 10000.})});
 
+auto* tf_data_stage_throughput = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/pipeline/stage_throughput",
+    "The number of elements per second produced by a stage of a tf.data input "
+    "pipeline over the last interval.",
+    "pipeline", "stage");
+
+auto* tf_data_stage_processing_time = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/pipeline/stage_processing_time",
+    "The processing time per element, in microseconds, of a stage of a "
+    "tf.data input pipeline over the last interval.",
+    "pipeline", "stage");
+
+auto* tf_data_stage_buffer_utilization = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/pipeline/stage_buffer_utilization",
+    "The percentage of the buffer limit in use in a stage of a tf.data input "
+    "pipeline, or -1 if the stage has no tunable buffer.",
+    "pipeline", "stage");
+
+auto* tf_data_pipeline_wait_time = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/data/pipeline/wait_time",
+    "The average time, in microseconds, the consumer of a tf.data input "
+    "pipeline waited for an element over the last interval.",
+    "pipeline");
+
+auto* tf_data_pipeline_bottleneck = monitoring::Gauge<string, 1>::New(
+    "/tensorflow/data/pipeline/bottleneck",
+    "The stage of a tf.data input pipeline which spent the most time per "
+    "element of the pipeline over the last interval, given its parallelism.",
+    "pipeline");
+
 auto* tf_data_optimization_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
@@ -194,10 +263,31 @@ void RecordTFDataExperiment(const string& name) {
   tf_data_experiment_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataCheckpointBytes(const string& name, const string& mode,
+                                 int64 num_bytes) {
+  tf_data_checkpoint_bytes->GetCell(name, mode)->Add(num_bytes);
+}
+
 void RecordTFDataFingerprint(const string& name) {
   tf_data_fingerprint_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataStageStats(const string& pipeline, const string& stage,
+                            int64 elements_per_sec, int64 processing_time_us,
+                            int64 buffer_utilization_percent) {
+  tf_data_stage_throughput->GetCell(pipeline, stage)->Set(elements_per_sec);
+  tf_data_stage_processing_time->GetCell(pipeline, stage)
+      ->Set(processing_time_us);
+  tf_data_stage_buffer_utilization->GetCell(pipeline, stage)
+      ->Set(buffer_utilization_percent);
+}
+
+void RecordTFDataPipelineStats(const string& pipeline, int64 wait_time_us,
+                               const string& bottleneck) {
+  tf_data_pipeline_wait_time->GetCell(pipeline)->Set(wait_time_us);
+  tf_data_pipeline_bottleneck->GetCell(pipeline)->Set(bottleneck);
+}
+
 void RecordTFDataGetNextDuration(uint64 duration_us) {
   static auto* tfdata_getnext_duration_cell =
       tf_data_getnext_duration_usecs_histogram->GetCell();
@@ -264,6 +354,16 @@ void UpdateGraphPendingQueueLength(uint64 len) {
   graph_pending_queue_length_cell->Add(len);
 }
 
+void RecordRunHandlerQueueingTime(int64 priority, uint64 duration_us) {
+  run_handler_queueing_latency_usecs->GetCell(strings::StrCat(priority))
+      ->Add(duration_us);
+}
+
+monitoring::SamplerCell* GetOpLatencyUsecsCell(const string& op_type,
+                                               const string& device_type) {
+  return op_latency_usecs->GetCell(op_type, device_type);
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -317,5 +417,16 @@ void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
 
+void RecordCollectiveCompressedBytes(int64 raw_bytes, int64 wire_bytes) {
+  collective_compressed_bytes->GetCell("raw")->IncrementBy(raw_bytes);
+  collective_compressed_bytes->GetCell("wire")->IncrementBy(wire_bytes);
+}
+
+void RecordRecvTensorsBatchSize(int64 num_keys) {
+  static auto* recv_tensors_batch_size_cell =
+      recv_tensors_batch_size->GetCell();
+  recv_tensors_batch_size_cell->Add(num_keys);
+}
+
 }  // namespace metrics
 }  // namespace tensorflow
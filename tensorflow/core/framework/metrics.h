@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
 
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -59,6 +60,12 @@ void RecordTFDataBytesFetched(int64 num_bytes);
 // Records the number of times tf.data experiment is applied to input pipelines.
 void RecordTFDataExperiment(const string& name);
 
+// Records the number of bytes of buffered elements a tf.data iterator of
+// dataset type `name` wrote to a checkpoint, and whether `mode` was "buffer",
+// writing the elements, or "replay", recording how to read them again.
+void RecordTFDataCheckpointBytes(const string& name, const string& mode,
+                                 int64 num_bytes);
+
 // Records the time spent in ItertatorResource::GetNext() in microseconds.
 void RecordTFDataGetNextDuration(uint64 duration_us);
 
@@ -68,6 +75,20 @@ void RecordTFDataGetNextDuration(uint64 duration_us);
 // This elapsed time corresponds to time spent outside the GetNext() function.
 void RecordTFDataGetNextTimeBetween(uint64 duration_us);
 
+// Records the activity of the stage `stage` of the tf.data input pipeline
+// `pipeline` over the last interval: the number of elements it produced per
+// second, its processing time per element in microseconds, and the percentage
+// of its buffer limit in use (-1 if it has no tunable buffer).
+void RecordTFDataStageStats(const string& pipeline, const string& stage,
+                            int64 elements_per_sec, int64 processing_time_us,
+                            int64 buffer_utilization_percent);
+
+// Records the average time, in microseconds, that the consumer of the tf.data
+// input pipeline `pipeline` waited for an element over the last interval, and
+// the stage identified as its bottleneck (empty if it produced no element).
+void RecordTFDataPipelineStats(const string& pipeline, int64 wait_time_us,
+                               const string& bottleneck);
+
 // Records the number of times each tf.data fingerprint is used
 // to measure duplicate pre-processing.
 //
@@ -97,9 +118,27 @@ void RecordGraphOutputTensors(const size_t size);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the time a step of priority `priority` spent waiting for a
+// RunHandler in RunHandlerPool::Get(), in microseconds.
+void RecordRunHandlerQueueingTime(int64 priority, uint64 duration_us);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
+// Records the bytes of a tensor chunk sent by a compressed collective, before
+// (`raw_bytes`) and after (`wire_bytes`) conversion to the wire type.
+void RecordCollectiveCompressedBytes(int64 raw_bytes, int64 wire_bytes);
+
+// Records the number of rendezvous keys coalesced into one RecvTensors call.
+void RecordRecvTensorsBatchSize(int64 num_keys);
+
+// Returns the cell of the histogram of the compute latencies, in microseconds,
+// of the kernels of type `op_type` on devices of type `device_type`. Callers
+// recording many samples should look the cell up once and keep it, as the
+// cells are never deleted.
+monitoring::SamplerCell* GetOpLatencyUsecsCell(const string& op_type,
+                                               const string& device_type);
+
 // Updates the metrics stored about time spent building graphs.
 //
 // By "GraphBuild", we refer to building a client graph, which is a sub-graph of
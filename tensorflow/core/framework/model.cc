@@ -609,15 +609,16 @@ class AsyncKnownRatio : public Node {
       parameter = gtl::FindOrNull(parameters_, kParallelism);
     }
 
-    if (parameter) {
-      if (ratio_ == 0) {
-        result += (*parameter)->value * AverageBufferedElementSize();
-      } else {
-        // The estimation is currently not accurate for MapAndBatchDataset for
-        // the maximum buffer size does not match `num_parallel_calls`
-        // parameter.
-        result += (*parameter)->value * AverageBufferedElementSize() / ratio_;
-      }
+    if (!parameter) {
+      return Node::MaximumBufferedBytes();
+    }
+    if (ratio_ == 0) {
+      result += (*parameter)->value * AverageBufferedElementSize();
+    } else {
+      // The estimation is currently not accurate for MapAndBatchDataset for
+      // the maximum buffer size does not match `num_parallel_calls`
+      // parameter.
+      result += (*parameter)->value * AverageBufferedElementSize() / ratio_;
     }
     return result;
   }
@@ -1076,6 +1077,31 @@ double Node::TotalMaximumBufferedBytes() const {
   return total_bytes[long_name()];
 }
 
+absl::flat_hash_map<string, double> Node::MaximumBufferedBytesPerNode() const {
+  absl::flat_hash_map<string, double> result;
+  tf_shared_lock l(mu_);
+  if (!autotune_) {
+    return result;
+  }
+  for (const auto& node : CollectNodes(TraversalOrder::BFS, IsAutotuneNode)) {
+    tf_shared_lock l(node->mu_);
+    result[node->long_name()] = node->MaximumBufferedBytes();
+  }
+  result[long_name()] = MaximumBufferedBytes();
+  return result;
+}
+
+std::vector<Node::Stats> Node::StatsPerNode() const {
+  std::vector<Stats> result;
+  tf_shared_lock l(mu_);
+  result.push_back(StatsLocked());
+  for (const auto& node : CollectNodes(TraversalOrder::BFS, IsAnyNode)) {
+    tf_shared_lock l(node->mu_);
+    result.push_back(node->StatsLocked());
+  }
+  return result;
+}
+
 double Node::TotalProcessingTime(
     absl::flat_hash_map<string, double>* processing_times) {
   // Create a hash map to store the per-element CPU time spent in the subtree
@@ -1334,8 +1360,26 @@ void Node::TotalMaximumBufferedBytesHelper(
   total_bytes->insert(std::make_pair(long_name(), result));
 }
 
+Node::Stats Node::StatsLocked() const TF_SHARED_LOCKS_REQUIRED(mu_) {
+  Stats stats;
+  stats.long_name = long_name();
+  stats.num_elements = num_elements_;
+  stats.processing_time = processing_time_;
+  auto* parallelism = gtl::FindOrNull(parameters_, kParallelism);
+  if (parallelism) {
+    stats.parallelism = std::max(1.0, (*parallelism)->value);
+  }
+  if (parallelism || gtl::FindOrNull(parameters_, kBufferSize)) {
+    const double maximum_buffered_bytes = MaximumBufferedBytes();
+    if (maximum_buffered_bytes > 0) {
+      stats.buffer_utilization = buffered_bytes_ / maximum_buffered_bytes;
+    }
+  }
+  return stats;
+}
+
 double Node::MaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_) {
-  return 0;
+  return buffered_bytes_;
 }
 
 void Model::AddNode(Node::Factory factory, const string& name,
@@ -1377,6 +1421,30 @@ void Model::FlushMetrics() {
   }
 }
 
+absl::flat_hash_map<string, double> Model::MaximumBufferedBytesPerNode() {
+  std::shared_ptr<Node> output;
+  {
+    tf_shared_lock l(mu_);
+    output = output_;
+  }
+  if (!output) {
+    return {};
+  }
+  return output->MaximumBufferedBytesPerNode();
+}
+
+std::vector<Node::Stats> Model::StatsPerNode() {
+  std::shared_ptr<Node> output;
+  {
+    tf_shared_lock l(mu_);
+    output = output_;
+  }
+  if (!output) {
+    return {};
+  }
+  return output->StatsPerNode();
+}
+
 void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
                      int64 ram_budget, double model_input_time) {
   switch (algorithm) {
@@ -1455,6 +1523,7 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
   double output_time = 0;
   double new_output_time;
   double new_value;
+  absl::flat_hash_map<string, double> previous_values;
   for (int i = 0; i < kMaxIterations; ++i) {
     absl::flat_hash_map<string, double> gradients;
     new_output_time = OutputTime(snapshot, model_input_time, &gradients);
@@ -1478,6 +1547,7 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
       }
     }
     for (auto& pair : parameters) {
+      previous_values[pair.first] = pair.second->value;
       new_value = pair.second->value -
                   kDescentStep * gradients[pair.first] / max_abs_derivative;
       // Projection on a feasible interval.
@@ -1489,6 +1559,14 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
         pair.second->value = new_value;
       }
     }
+    // If the step made the worst-case total buffer size exceed the memory
+    // budget, we return to the last point that was within the budget.
+    if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      for (auto& pair : parameters) {
+        pair.second->value = previous_values[pair.first];
+      }
+      break;
+    }
     output_time = new_output_time;
   }
   VLOG(2) << "Number of tunable parameters: " << parameters.size();
@@ -1536,11 +1614,19 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
     }
     double best_delta = -1.0L;
     Parameter* best_parameter = nullptr;
+    bool over_ram_budget = false;
     for (auto& pair : parameters) {
       if (pair.second->value >= pair.second->max) {
         continue;
       }
       pair.second->value++;
+      // Increases that would make the worst-case total buffer size exceed the
+      // memory budget are not considered.
+      if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+        over_ram_budget = true;
+        pair.second->value--;
+        continue;
+      }
       double new_output_time =
           OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
       double delta = output_time - new_output_time;
@@ -1551,6 +1637,11 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
       }
       pair.second->value--;
     }
+    if (!best_parameter && over_ram_budget) {
+      VLOG(2) << "Reached the best output time within the RAM budget of "
+              << ram_budget << " bytes.";
+      break;
+    }
     if (!best_parameter) {
       VLOG(2) << "Failed to find a tunable parameter that would decrease the "
                  "output time. This means that the autotuning optimization got "
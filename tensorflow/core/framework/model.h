@@ -138,6 +138,21 @@ class Node {
     std::shared_ptr<Node> output;
   };
 
+  // The cumulative counters and the buffer state of a node, from which the
+  // activity of the node over an interval can be derived.
+  struct Stats {
+    string long_name;
+    // The number of elements produced by the node.
+    int64 num_elements = 0;
+    // The aggregate processing time of the node, in nanoseconds.
+    int64 processing_time = 0;
+    // The parallelism of the node, or 1 if it has no parallelism parameter.
+    double parallelism = 1;
+    // The fraction of the buffer limit of the node currently used, or -1 if the
+    // node does not have a tunable buffer.
+    double buffer_utilization = -1;
+  };
+
   using Factory = std::function<std::shared_ptr<Node>(Args)>;
   using NodeVector = std::vector<std::shared_ptr<Node>>;
   using NodePairList =
@@ -366,6 +381,15 @@ class Node {
   // would be used by the subtree nodes if all of their buffers were full.
   double TotalMaximumBufferedBytes() const TF_LOCKS_EXCLUDED(mu_);
 
+  // Returns the buffer limit, in bytes, of each node in the subtree for which
+  // autotuning is enabled, keyed by the long name of the node.
+  absl::flat_hash_map<string, double> MaximumBufferedBytesPerNode() const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the stats of the nodes of the subtree rooted in this node, in
+  // breadth-first order starting with this node.
+  std::vector<Stats> StatsPerNode() const TF_LOCKS_EXCLUDED(mu_);
+
   // Returns the per-element CPU time spent in the subtree rooted in this node.
   // If `processing_times` is not `nullptr`, collects the per-element CPU time
   // spent in each node of the subtree.
@@ -523,10 +547,15 @@ class Node {
       absl::flat_hash_map<string, double>* total_bytes) const
       TF_SHARED_LOCKS_REQUIRED(mu_);
 
+  // Returns the stats of the node itself.
+  Stats StatsLocked() const TF_SHARED_LOCKS_REQUIRED(mu_);
+
   // Compute and return the maximum buffered bytes on the node itself. By
-  // default non-tunable nodes are assumed not to buffer any bytes, so the
-  // tunable nodes as subclasses are expected to override this method to ensure
-  // that the optimization algorithm respects the memory budget.
+  // default the buffer of a node is assumed not to be tunable, so its limit is
+  // the number of bytes currently buffered (e.g. the shuffle buffer or the
+  // in-memory cache). Nodes with tunable buffers are expected to override this
+  // method to ensure that the optimization algorithm respects the memory
+  // budget.
   virtual double MaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_);
 
   // Stores the time passed to the last call to `Node::record_start()` on the
@@ -635,6 +664,16 @@ class Model {
   void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
                 double model_input_time) TF_LOCKS_EXCLUDED(mu_);
 
+  // Returns the buffer limit, in bytes, of each node of the model for which
+  // autotuning is enabled, keyed by the long name of the node. The limits
+  // reflect the parameter values chosen by the last optimization.
+  absl::flat_hash_map<string, double> MaximumBufferedBytesPerNode()
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the stats of the nodes of the model, in breadth-first order
+  // starting with the output node.
+  std::vector<Node::Stats> StatsPerNode() TF_LOCKS_EXCLUDED(mu_);
+
   // Removes the given node.
   void RemoveNode(std::shared_ptr<Node> node) TF_LOCKS_EXCLUDED(mu_);
 
@@ -660,7 +699,8 @@ class Model {
   // parameter whose increase in parallelism decreases the output time the most.
   // This process is repeated until all parameters reach their maximum values or
   // the projected output time is less than or equal to the processing time
-  // needed to produce an element divided by CPU budget.
+  // needed to produce an element divided by CPU budget. Increases that would
+  // make the total buffer limit exceed the RAM budget are not considered.
   void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
                          double model_input_time);
 
@@ -670,7 +710,8 @@ class Model {
   // projecting resulting values on the feasible intervals. Improvement step is
   // repeated until either the output time improvement is smaller than threshold
   // value or the output time is less than the processing time needed to produce
-  // an element divided by CPU budget.
+  // an element divided by CPU budget. A step that would make the total buffer
+  // limit exceed the RAM budget is undone and ends the optimization.
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
                                double model_input_time);
 
@@ -949,6 +949,88 @@ TEST_P(OptimizeZeroRamBudgetTest, Model) {
 INSTANTIATE_TEST_SUITE_P(Test, OptimizeZeroRamBudgetTest,
                          ::testing::Values(0, 1));
 
+class OptimizeRamBudgetTest
+    : public ::testing::TestWithParam<model::AutotuneAlgorithm> {};
+
+TEST_P(OptimizeRamBudgetTest, Model) {
+  const model::AutotuneAlgorithm algorithm = GetParam();
+
+  std::shared_ptr<mutex> mutex1 = std::make_shared<mutex>();
+  std::shared_ptr<condition_variable> cv1 =
+      std::make_shared<condition_variable>();
+  std::shared_ptr<Node> node1 = model::MakeAsyncKnownRatioNode(
+      {1, "1", nullptr}, 1,
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(-1, mutex1, cv1), 1,
+                            10)});
+  node1->record_buffer_event(10, 1);
+  node1->record_element();
+  node1->record_bytes_produced(10);
+  node1->add_processing_time(100);
+
+  // A node without tunable parameters, such as shuffle, whose buffer counts
+  // against the RAM budget.
+  std::shared_ptr<Node> node2 = model::MakeKnownRatioNode({2, "2", node1}, 1);
+  node2->record_buffer_event(50, 1);
+
+  model::Model model;
+  model.AddNode([&node1](model::Node::Args args) { return node1; }, "1",
+                nullptr, &node1);
+  model.AddNode([&node2](model::Node::Args args) { return node2; }, "2", node1,
+                &node2);
+
+  // Each unit of parallelism buffers 10 bytes, so a budget of 100 bytes leaves
+  // room for a parallelism of at most 5 next to the 50 bytes of `node2`.
+  model.Optimize(algorithm, 64, 100, 0);
+  EXPECT_GE(node1->parameter_value("parallelism"), 1);
+  EXPECT_LE(node1->parameter_value("parallelism"), 5);
+  if (algorithm == model::AutotuneAlgorithm::HILL_CLIMB) {
+    EXPECT_EQ(node1->parameter_value("parallelism"), 5);
+  }
+
+  auto buffered_bytes = model.MaximumBufferedBytesPerNode();
+  EXPECT_EQ(buffered_bytes.size(), 2);
+  EXPECT_EQ(buffered_bytes[node1->long_name()],
+            10 * node1->parameter_value("parallelism"));
+  EXPECT_EQ(buffered_bytes[node2->long_name()], 50);
+}
+
+INSTANTIATE_TEST_SUITE_P(Test, OptimizeRamBudgetTest, ::testing::Values(0, 1));
+
+TEST(StatsPerNodeTest, Model) {
+  std::shared_ptr<Node> node1 = model::MakeAsyncKnownRatioNode(
+      {1, "1", nullptr}, 1,
+      {model::MakeParameter(
+          "parallelism", std::make_shared<SharedState>(4, nullptr, nullptr), 1,
+          4)});
+  // Two buffered elements of 10 bytes, out of a limit of 4 elements.
+  node1->record_buffer_event(20, 2);
+  node1->add_processing_time(100);
+  std::shared_ptr<Node> node2 = model::MakeKnownRatioNode({2, "2", node1}, 1);
+  node2->record_element();
+  node2->record_element();
+  node2->add_processing_time(30);
+
+  model::Model model;
+  model.AddNode([&node1](model::Node::Args args) { return node1; }, "1",
+                nullptr, &node1);
+  model.AddNode([&node2](model::Node::Args args) { return node2; }, "2", node1,
+                &node2);
+
+  std::vector<Node::Stats> stats = model.StatsPerNode();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].long_name, node1->long_name());
+  EXPECT_EQ(stats[0].num_elements, 0);
+  EXPECT_EQ(stats[0].processing_time, 100);
+  EXPECT_EQ(stats[0].parallelism, 4);
+  EXPECT_DOUBLE_EQ(stats[0].buffer_utilization, 0.5);
+  EXPECT_EQ(stats[1].long_name, node2->long_name());
+  EXPECT_EQ(stats[1].num_elements, 2);
+  EXPECT_EQ(stats[1].processing_time, 30);
+  EXPECT_EQ(stats[1].parallelism, 1);
+  EXPECT_EQ(stats[1].buffer_utilization, -1);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -70,11 +70,16 @@ class RendezvousInterface {
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
 
+    // Returns the fingerprint of FullKey() computed once when the key was
+    // parsed, which rendezvous implementations may use as a table key.
+    uint64 hash() const { return hash_; }
+
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     std::string buf_;
+    uint64 hash_ = 0;
   };
 
   // The caller is a tensor producer and it sends a message (a tensor
@@ -176,6 +181,13 @@ class Rendezvous : public RendezvousInterface, public core::RefCounted {
                                const FrameAndIter& frame_iter);
 
   static Status ParseKey(StringPiece key, ParsedKey* out);
+
+  // Sets "*out" to "key" with its frame and iteration replaced by
+  // "frame_iter", reusing the parsed device names of "key" instead of parsing
+  // the new key again. "key" must have been returned by ParseKey().
+  static void ReplaceFrameAndIter(const ParsedKey& key,
+                                  const FrameAndIter& frame_iter,
+                                  ParsedKey* out);
 };
 
 // Returns a Rendezvous instance that is limited to use only by
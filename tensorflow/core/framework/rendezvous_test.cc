@@ -65,6 +65,36 @@ TEST(RendezvousTest, Key) {
       Rendezvous::ParseKey(strings::StrCat(key, ";", key), &parsed).ok());
 }
 
+TEST(RendezvousTest, ReplaceFrameAndIter) {
+  const string key = Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/CPU:0", 7890,
+      "/job:mnist/replica:1/task:2/device:GPU:0", "var0", FrameAndIter(0, 0));
+  Rendezvous::ParsedKey parsed;
+  TF_ASSERT_OK(Rendezvous::ParseKey(key, &parsed));
+
+  Rendezvous::ParsedKey in_loop;
+  Rendezvous::ReplaceFrameAndIter(parsed, FrameAndIter(3, 12), &in_loop);
+  const string in_loop_key = Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/CPU:0", 7890,
+      "/job:mnist/replica:1/task:2/device:GPU:0", "var0", FrameAndIter(3, 12));
+  Rendezvous::ParsedKey expected;
+  TF_ASSERT_OK(Rendezvous::ParseKey(in_loop_key, &expected));
+  EXPECT_EQ(in_loop.FullKey(), expected.FullKey());
+  EXPECT_EQ(in_loop.hash(), expected.hash());
+  EXPECT_NE(in_loop.hash(), parsed.hash());
+  EXPECT_EQ(in_loop.src_device, expected.src_device);
+  EXPECT_EQ(in_loop.src_incarnation, 7890);
+  EXPECT_EQ(in_loop.src.type, "CPU");
+  EXPECT_EQ(in_loop.dst_device, expected.dst_device);
+  EXPECT_EQ(in_loop.dst.type, "GPU");
+  EXPECT_EQ(in_loop.edge_name, "var0");
+
+  // Copies keep the fingerprint.
+  Rendezvous::ParsedKey copy(in_loop);
+  EXPECT_EQ(copy.hash(), expected.hash());
+  EXPECT_EQ(copy.edge_name, "var0");
+}
+
 class LocalRendezvousTest : public ::testing::Test {
  public:
   LocalRendezvousTest() : threads_(Env::Default(), "test", 16) {
@@ -51,12 +51,18 @@ namespace tensorflow {
 // shared mutex prevents them from overlapping with dense writes, which is
 // necessary as dense writes can change the shape the of the tensor.
 //
+// A variable can also be frozen, e.g. once a serving model has been restored,
+// by running `_FreezeVariableOp` on it. A frozen variable can no longer be
+// modified, so dense reads alias its tensor and sparse reads access it in
+// place, without ever switching to copy-on-read mode or copying it.
+//
 // Transitioning a variable from copy-on-read mode to copy-on-write mode is
-// currently not supported. To upgrade a variable from copy-on-write to
-// copy-on-read use `EnsureSparseVariableAccess()`, and then grab the variable's
-// mutex as desired. To access the variable in dense mode grab the mutex either
-// directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
-// modified and then call `PrepareToUpdateVariable` on them in any order.
+// currently not supported, except by freezing it. To upgrade a variable from
+// copy-on-write to copy-on-read use `EnsureSparseVariableAccess()`, and then
+// grab the variable's mutex as desired. To access the variable in dense mode
+// grab the mutex either directly or via `MaybeLockVariableInputMutexesInOrder`
+// on all variables being modified and then call `PrepareToUpdateVariable` on
+// them in any order.
 class Var : public ResourceBase {
  public:
   explicit Var(DataType dtype) : tensor_(dtype) {}
@@ -87,6 +93,11 @@ class Var : public ResourceBase {
   // so desired.
   std::atomic<bool> copy_on_read_mode{false};
 
+  // Also fake-guarded by mu_. Set by `_FreezeVariableOp`, and never unset.
+  // Once this is true copy_on_read_mode is false and all operations that would
+  // modify the variable fail.
+  std::atomic<bool> frozen{false};
+
  private:
   mutex mu_;
   Tensor tensor_;
@@ -21,8 +21,10 @@ limitations under the License.
 #include <cmath>
 #include <list>
 #include <memory>
+#include <set>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -822,6 +824,13 @@ class RunHandlerPool::Impl {
     return !free_handlers_.empty();
   }
 
+  // Returns true if a request of `priority` may take a free handler, i.e. no
+  // request of a higher priority is waiting for one.
+  bool CanAdmitLocked(int64 priority) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return has_free_handler() && (waiting_priorities_.empty() ||
+                                  priority >= *waiting_priorities_.rbegin());
+  }
+
   std::unique_ptr<RunHandler> Get(
       int64 step_id, int64 timeout_in_ms,
       const RunOptions::Experimental::RunHandlerPoolOptions& options)
@@ -837,23 +846,35 @@ class RunHandlerPool::Impl {
     uint64 version;
     int num_active_requests;
     RunHandler::Impl* handler_impl;
+    const int64 priority = options.priority();
+    const uint64 request_time_us = EnvTime::NowMicros();
     {
       mutex_lock l(mu_);
-      if (!has_free_handler()) {
+      if (!CanAdmitLocked(priority)) {
         profiler::TraceMe activity(
             [&] {
               return strings::StrCat("WaitingForHandler#step_id=", step_id,
                                      "#");
             },
             profiler::TraceMeLevel::kInfo);
+        // Requests waiting for a handler are admitted in priority order, so a
+        // high priority step does not queue behind lower priority ones when
+        // the pool is saturated.
+        PendingRequest request{this, priority};
+        auto waiting_it = waiting_priorities_.insert(priority);
+        bool admitted = true;
         if (timeout_in_ms == 0) {
-          mu_.Await(Condition(this, &Impl::has_free_handler));
-        } else if (!mu_.AwaitWithDeadline(
-                       Condition(this, &Impl::has_free_handler),
-                       EnvTime::NowNanos() + timeout_in_ms * 1000 * 1000)) {
-          return nullptr;
+          mu_.Await(Condition(&PendingRequest::CanAdmit, &request));
+        } else {
+          admitted = mu_.AwaitWithDeadline(
+              Condition(&PendingRequest::CanAdmit, &request),
+              EnvTime::NowNanos() + timeout_in_ms * 1000 * 1000);
         }
+        waiting_priorities_.erase(waiting_it);
+        if (!admitted) return nullptr;
       }
+      metrics::RecordRunHandlerQueueingTime(
+          priority, EnvTime::NowMicros() - request_time_us);
       // Remove the last entry from free_handlers_ and add to the end of
       // sorted_active_handlers_.
       handler_impl = free_handlers_.back();
@@ -862,7 +883,6 @@ class RunHandlerPool::Impl {
 
       num_active_requests = sorted_active_handlers_.size() + 1;
       thread_work_sources->resize(num_active_requests);
-      int priority = options.priority();
       auto it = sorted_active_handlers_.cbegin();
       bool new_handler_inserted = false;
       for (int i = 0; i < num_active_requests; ++i) {
@@ -923,7 +943,24 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  int GetNumWaitingRequestsForTesting() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return waiting_priorities_.size();
+  }
+
  private:
+  // A request blocked in Get() until it can be admitted.
+  struct PendingRequest {
+    Impl* pool_impl;
+    int64 priority;
+
+    // Evaluated by `mu_.Await()`, which holds `mu_`.
+    static bool CanAdmit(PendingRequest* request)
+        TF_NO_THREAD_SAFETY_ANALYSIS {
+      return request->pool_impl->CanAdmitLocked(request->priority);
+    }
+  };
+
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
@@ -950,6 +987,8 @@ class RunHandlerPool::Impl {
   std::list<RunHandler::Impl*> sorted_active_handlers_ TF_GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ TF_GUARDED_BY(mu_);
   std::vector<std::unique_ptr<RunHandler::Impl>> handlers_ TF_GUARDED_BY(mu_);
+  // Priorities of the requests waiting in Get() for a free handler.
+  std::multiset<int64> waiting_priorities_ TF_GUARDED_BY(mu_);
 
   // Histogram of elapsed runtime of every handler (in ms).
   histogram::Histogram time_hist_ TF_GUARDED_BY(mu_);
@@ -1092,6 +1131,10 @@ std::vector<int64> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+int RunHandlerPool::GetNumWaitingRequestsForTesting() const {
+  return impl_->GetNumWaitingRequestsForTesting();
+}
+
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
 void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
@@ -62,7 +62,10 @@ class RunHandlerPool {
   // and is being used by a client.  It becomes 'inactive' once more when the
   // unique_ptr is destroyed.
   //
-  // Will block unless there is an inactive handler.
+  // Will block unless there is an inactive handler. Blocked requests are
+  // handed inactive handlers in decreasing order of `options.priority()`, and
+  // the time spent waiting is recorded per priority in the
+  // /tensorflow/core/run_handler/queueing_latency metric.
   std::unique_ptr<RunHandler> Get(
       int64 step_id = 0, int64 timeout_in_ms = 0,
       const RunOptions::Experimental::RunHandlerPoolOptions& options =
@@ -72,6 +75,9 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Returns the number of requests blocked in Get().
+  int GetNumWaitingRequestsForTesting() const;
+
  private:
   class Impl;
   friend class RunHandler;
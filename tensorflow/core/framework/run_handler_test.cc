@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
@@ -113,6 +114,67 @@ TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   EXPECT_EQ(sorted_active_list[3], 1);
 }
 
+TEST(RunHandlerUtilTest, PriorityAdmissionTest) {
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(1, 1));
+
+  // Take every handler in the pool.
+  std::vector<std::unique_ptr<RunHandler>> blocking_handles;
+  const int32 kMaxConcurrentHandlers = 128;  // Copied from run_handler.cc.
+  for (int i = 0; i < kMaxConcurrentHandlers; ++i) {
+    blocking_handles.push_back(pool->Get(i));
+  }
+
+  // Queue a low priority request, then a high priority one.
+  auto tp = std::make_unique<thread::ThreadPool>(Env::Default(), "test", 2);
+  mutex mu;
+  std::vector<int64> admitted_priorities;
+  std::vector<std::unique_ptr<RunHandler>> admitted_handles;
+  BlockingCounter counter(2);
+  auto request = [&](int64 priority) {
+    RunOptions::Experimental::RunHandlerPoolOptions options;
+    options.set_priority(priority);
+    auto handle = pool->Get(/*step_id=*/1000 + priority, 0, options);
+    {
+      mutex_lock l(mu);
+      admitted_priorities.push_back(priority);
+      admitted_handles.push_back(std::move(handle));
+    }
+    counter.DecrementCount();
+  };
+  tp->Schedule([&request]() { request(1); });
+  while (pool->GetNumWaitingRequestsForTesting() < 1) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  tp->Schedule([&request]() { request(2); });
+  while (pool->GetNumWaitingRequestsForTesting() < 2) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+
+  // The first free handler goes to the high priority request even though it
+  // arrived last.
+  blocking_handles[0].reset();
+  while (true) {
+    {
+      mutex_lock l(mu);
+      if (!admitted_priorities.empty()) break;
+    }
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  {
+    mutex_lock l(mu);
+    ASSERT_EQ(admitted_priorities.size(), 1);
+    EXPECT_EQ(admitted_priorities[0], 2);
+  }
+  EXPECT_EQ(pool->GetNumWaitingRequestsForTesting(), 1);
+
+  blocking_handles[1].reset();
+  counter.Wait();
+  EXPECT_EQ(admitted_priorities[1], 1);
+  EXPECT_EQ(pool->GetNumWaitingRequestsForTesting(), 0);
+  admitted_handles.clear();
+  blocking_handles.clear();
+}
+
 TEST(RunHandlerThreadPool, EnqueueTask) {
   Eigen::MaxSizeVector<mutex> waiters_mu(2);
   waiters_mu.resize(2);
@@ -505,6 +505,10 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(NodeDef node_def, Status* status);
 
+  // Same as above, for a node whose OpDef and input/output types the caller
+  // has already computed against this graph's op registry.
+  Node* AddNode(std::shared_ptr<NodeProperties> props, Status* status);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
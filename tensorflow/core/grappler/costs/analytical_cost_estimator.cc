@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/costs/virtual_scheduler.h"
@@ -111,7 +112,7 @@ AnalyticalCostEstimator::AnalyticalCostEstimator(
     Cluster* cluster, bool use_static_shapes,
     bool use_aggressive_shape_inference)
     : AnalyticalCostEstimator(
-          cluster, absl::make_unique<OpLevelCostEstimator>(),
+          cluster, NewOpLevelCostEstimator(),
           ReadyNodeManagerFactory("FirstReady"), use_static_shapes,
           use_aggressive_shape_inference) {}
 
@@ -36,7 +36,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -2344,10 +2347,122 @@ Status GraphProperties::UpdateEnqueue(
   return Status::OK();
 }
 
+namespace {
+
+// The properties inferred statically for a graph.
+struct StaticProperties {
+  absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
+      input_properties;
+  absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
+      output_properties;
+  std::unordered_set<string> incompatible_shape_nodes;
+  int64 size_bytes = 0;
+};
+
+// Caches the properties inferred statically for the most recent graphs. The
+// optimizers of a meta optimizer iteration, and the iterations themselves,
+// infer the properties of the graph one after another, and most of them leave
+// the graph unchanged, so that all but the first inference are redundant.
+class StaticPropertiesCache {
+ public:
+  static StaticPropertiesCache* Global() {
+    static StaticPropertiesCache* cache = new StaticPropertiesCache();
+    return cache;
+  }
+
+  std::shared_ptr<const StaticProperties> Lookup(uint64 fingerprint) {
+    mutex_lock l(mu_);
+    for (auto it = properties_.begin(); it != properties_.end(); ++it) {
+      if (it->first == fingerprint) {
+        properties_.splice(properties_.begin(), properties_, it);
+        return properties_.front().second;
+      }
+    }
+    return nullptr;
+  }
+
+  void Insert(uint64 fingerprint,
+              std::shared_ptr<const StaticProperties> properties) {
+    if (properties->size_bytes > kCapacityBytes) return;
+    mutex_lock l(mu_);
+    size_bytes_ += properties->size_bytes;
+    properties_.emplace_front(fingerprint, std::move(properties));
+    while (size_bytes_ > kCapacityBytes) {
+      size_bytes_ -= properties_.back().second->size_bytes;
+      properties_.pop_back();
+    }
+  }
+
+ private:
+  // Only holds a few graphs, so that evicting the graphs which are no longer
+  // optimized is cheap.
+  static constexpr int64 kCapacityBytes = 64 << 20;
+
+  mutex mu_;
+  // From the most to the least recently used.
+  std::list<std::pair<uint64, std::shared_ptr<const StaticProperties>>>
+      properties_ TF_GUARDED_BY(mu_);
+  int64 size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+constexpr int64 StaticPropertiesCache::kCapacityBytes;
+
+// Returns the fingerprint of the static inference of the properties of
+// `item`, with the given options.
+uint64 StaticPropertiesFingerprint(const GrapplerItem& item,
+                                   bool assume_valid_feeds,
+                                   bool aggressive_shape_inference,
+                                   bool include_input_tensor_values,
+                                   bool include_output_tensor_values) {
+  string serialized_graph;
+  SerializeToStringDeterministic(item.graph, &serialized_graph);
+  uint64 fingerprint = Fingerprint64(serialized_graph);
+  fingerprint = FingerprintCat64(
+      fingerprint, (assume_valid_feeds ? 1 : 0) |
+                       (aggressive_shape_inference ? 2 : 0) |
+                       (include_input_tensor_values ? 4 : 0) |
+                       (include_output_tensor_values ? 8 : 0));
+  if (!assume_valid_feeds) {
+    for (const auto& feed : item.feed) {
+      fingerprint = FingerprintCat64(fingerprint, Fingerprint64(feed.first));
+    }
+  }
+  return fingerprint;
+}
+
+int64 PropertiesSizeBytes(
+    const absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>&
+        properties) {
+  int64 size_bytes = 0;
+  for (const auto& node_properties : properties) {
+    size_bytes += node_properties.first.size();
+    for (const OpInfo::TensorProperties& tensor_properties :
+         node_properties.second) {
+      size_bytes += tensor_properties.ByteSizeLong();
+    }
+  }
+  return size_bytes;
+}
+
+}  // namespace
+
 Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
                                         bool include_output_tensor_values) {
+  const uint64 fingerprint = StaticPropertiesFingerprint(
+      item_, assume_valid_feeds, aggressive_shape_inference,
+      include_input_tensor_values, include_output_tensor_values);
+  std::shared_ptr<const StaticProperties> cached =
+      StaticPropertiesCache::Global()->Lookup(fingerprint);
+  if (cached != nullptr) {
+    VLOG(2) << "Reusing the properties inferred for an identical graph";
+    input_properties_ = cached->input_properties;
+    output_properties_ = cached->output_properties;
+    incompatible_shape_nodes_ = cached->incompatible_shape_nodes;
+    return Status::OK();
+  }
+
   FunctionLibraryDefinition function_library(OpRegistry::Global(),
                                              item_.graph.library());
   absl::flat_hash_map<string, absl::flat_hash_set<int>> fed_ports;
@@ -2580,6 +2695,14 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   VerboseLogUnknownDimensionSources(item_.graph, input_properties_,
                                     output_properties_);
 
+  auto properties = std::make_shared<StaticProperties>();
+  properties->input_properties = input_properties_;
+  properties->output_properties = output_properties_;
+  properties->incompatible_shape_nodes = incompatible_shape_nodes_;
+  properties->size_bytes = PropertiesSizeBytes(input_properties_) +
+                           PropertiesSizeBytes(output_properties_);
+  StaticPropertiesCache::Global()->Insert(fingerprint, std::move(properties));
+
   return Status::OK();
 }
 
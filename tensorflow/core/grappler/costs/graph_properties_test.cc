@@ -218,6 +218,33 @@ TEST_F(GraphPropertiesTest, ClearProperties) {
   }
 }
 
+TEST_F(GraphPropertiesTest, InfersMutatedGraph) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 3}));
+  Output b = ops::Identity(s.WithOpName("b"), a);
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  const auto output_shape = [this, &item]() {
+    GraphProperties properties(item);
+    TF_CHECK_OK(properties.InferStatically(false));
+    return PropToString(properties.GetOutputProperties("b").at(0));
+  };
+  EXPECT_EQ("float: [2,3]", output_shape());
+
+  // The properties inferred for the original graph are not reused.
+  NodeDef* placeholder = item.graph.mutable_node(0);
+  ASSERT_EQ("a", placeholder->name());
+  TensorShape({4, 3}).AsProto(
+      (*placeholder->mutable_attr())["shape"].mutable_shape());
+  EXPECT_EQ("float: [4,3]", output_shape());
+
+  TensorShape({2, 3}).AsProto(
+      (*placeholder->mutable_attr())["shape"].mutable_shape());
+  EXPECT_EQ("float: [2,3]", output_shape());
+}
+
 TEST_F(GraphPropertiesTest, DynamicProperties) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false,
                                           cluster_->GetDeviceNames());
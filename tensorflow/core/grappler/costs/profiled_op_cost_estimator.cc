@@ -0,0 +1,111 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/node_cost_collector.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+int64 ExecutionTimeNanos(const NodeExecStats& stats) {
+  if (stats.all_end_rel_nanos() > 0) return stats.all_end_rel_nanos();
+  return stats.all_end_rel_micros() * 1000;
+}
+
+}  // namespace
+
+ProfiledOpCostEstimator::ProfiledOpCostEstimator(const StepStats& step_stats) {
+  // A node can be profiled on several devices, e.g. the GPU kernels of a node
+  // are also traced on the streams of the GPU. Sums the execution times of the
+  // node on each device, and keeps the longest one.
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    absl::flat_hash_map<string, int64> device_times;
+    for (const NodeExecStats& stats : device_stats.node_stats()) {
+      // The tracers may suffix the node name with ':' and the op type, which
+      // node names can't contain.
+      const string node_name =
+          stats.node_name().substr(0, stats.node_name().find(':'));
+      device_times[node_name] += ExecutionTimeNanos(stats);
+    }
+    for (const auto& device_time : device_times) {
+      Costs::NanoSeconds& execution_time = execution_times_[device_time.first];
+      execution_time = std::max(execution_time,
+                                Costs::NanoSeconds(device_time.second));
+    }
+  }
+}
+
+Costs ProfiledOpCostEstimator::PredictCosts(
+    const OpContext& op_context) const {
+  Costs costs = OpLevelCostEstimator::PredictCosts(op_context);
+  auto it = execution_times_.find(op_context.name);
+  if (it == execution_times_.end()) return costs;
+
+  // The measured time includes the memory accesses of the node.
+  costs.execution_time = it->second;
+  costs.compute_time = it->second;
+  costs.memory_time = Costs::Duration::zero();
+  costs.intermediate_memory_time = Costs::Duration::zero();
+  costs.intermediate_memory_read_time = Costs::Duration::zero();
+  costs.intermediate_memory_write_time = Costs::Duration::zero();
+  costs.inaccurate = false;
+  costs.num_ops_with_unknown_shapes = 0;
+  return costs;
+}
+
+const StepStats* GlobalGrapplerProfile() {
+  static const StepStats* profile = []() -> const StepStats* {
+    string path;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_GRAPPLER_PROFILE", "", &path));
+    if (path.empty()) return nullptr;
+    RunMetadata run_metadata;
+    Status status = ReadBinaryProto(Env::Default(), path, &run_metadata);
+    if (!status.ok()) {
+      status = ReadTextProto(Env::Default(), path, &run_metadata);
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to read the grappler profile " << path << ": "
+                   << status;
+      return nullptr;
+    }
+    return new StepStats(std::move(*run_metadata.mutable_step_stats()));
+  }();
+  return profile;
+}
+
+std::unique_ptr<OpLevelCostEstimator> NewOpLevelCostEstimator() {
+  const StepStats* profile = GlobalGrapplerProfile();
+  if (profile != nullptr) {
+    return absl::make_unique<ProfiledOpCostEstimator>(*profile);
+  }
+  std::shared_ptr<const StepStats> node_costs = RegisteredNodeCosts();
+  if (node_costs != nullptr) {
+    return absl::make_unique<ProfiledOpCostEstimator>(*node_costs);
+  }
+  return absl::make_unique<OpLevelCostEstimator>();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,61 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_PROFILED_OP_COST_ESTIMATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_PROFILED_OP_COST_ESTIMATOR_H_
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Predicts the execution time of the nodes profiled in a StepStats, typically
+// collected in production with RunOptions::FULL_TRACE, from their measured
+// execution times, and the costs of the other nodes analytically. Nodes are
+// matched by name, so the profile should come from the graph being optimized.
+class ProfiledOpCostEstimator : public OpLevelCostEstimator {
+ public:
+  explicit ProfiledOpCostEstimator(const StepStats& step_stats);
+  ~ProfiledOpCostEstimator() override {}
+
+  Costs PredictCosts(const OpContext& op_context) const override;
+
+  // Returns the number of nodes with a measured execution time.
+  int num_profiled_nodes() const { return execution_times_.size(); }
+
+ private:
+  absl::flat_hash_map<string, Costs::NanoSeconds> execution_times_;
+};
+
+// Returns the profile in the RunMetadata file, binary or text, named by the
+// environment variable TF_GRAPPLER_PROFILE, or nullptr if it is not set or
+// can't be read.
+const StepStats* GlobalGrapplerProfile();
+
+// Returns a ProfiledOpCostEstimator of the global profile if there is one, else
+// of the node costs registered by the loaded models (see RegisterNodeCosts),
+// and an OpLevelCostEstimator otherwise.
+std::unique_ptr<OpLevelCostEstimator> NewOpLevelCostEstimator();
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_PROFILED_OP_COST_ESTIMATOR_H_
@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+void AddNodeStats(const string& node_name, int64 micros,
+                  DeviceStepStats* device_stats) {
+  NodeExecStats* stats = device_stats->add_node_stats();
+  stats->set_node_name(node_name);
+  stats->set_all_end_rel_micros(micros);
+}
+
+OpContext MatMulContext(const string& name) {
+  OpContext op_context;
+  op_context.name = name;
+  op_context.op_info.set_op("MatMul");
+  for (int i = 0; i < 2; ++i) {
+    OpInfo::TensorProperties* input = op_context.op_info.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(256);
+    input->mutable_shape()->add_dim()->set_size(256);
+  }
+  DeviceProperties* device = op_context.op_info.mutable_device();
+  device->set_type("CPU");
+  device->set_num_cores(1);
+  device->set_frequency(1000);
+  return op_context;
+}
+
+TEST(ProfiledOpCostEstimatorTest, UsesMeasuredTimes) {
+  StepStats step_stats;
+  DeviceStepStats* cpu = step_stats.add_dev_stats();
+  cpu->set_device("/device:CPU:0");
+  AddNodeStats("matmul", 10, cpu);
+  AddNodeStats("matmul", 5, cpu);
+  DeviceStepStats* stream = step_stats.add_dev_stats();
+  stream->set_device("/device:GPU:0/stream:all");
+  AddNodeStats("matmul:MatMul", 7, stream);
+
+  ProfiledOpCostEstimator estimator(step_stats);
+  EXPECT_EQ(1, estimator.num_profiled_nodes());
+
+  // The time on the CPU, which is the longest, of the profiled node.
+  Costs costs = estimator.PredictCosts(MatMulContext("matmul"));
+  EXPECT_EQ(Costs::NanoSeconds(15000), costs.execution_time);
+  EXPECT_EQ(Costs::NanoSeconds(15000), costs.compute_time);
+  EXPECT_FALSE(costs.inaccurate);
+
+  // The other nodes are estimated analytically.
+  const OpContext other = MatMulContext("other_matmul");
+  EXPECT_EQ(OpLevelCostEstimator().PredictCosts(other).execution_time,
+            estimator.PredictCosts(other).execution_time);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
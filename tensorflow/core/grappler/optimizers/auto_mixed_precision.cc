@@ -26,6 +26,10 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -38,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -56,6 +61,10 @@ const char kCastToFp16[] = "CastToFp16";
 const char kCastToBf16[] = "CastToBf16";
 const char kCastToFp32[] = "CastToFp32";
 
+// The time spent by the executor to run a cast on the CPU, on top of its
+// kernel. It dominates the casts of small tensors.
+constexpr double kCpuCastOverheadNanoseconds = 1000;
+
 // Instances of this class represent unique type attribute identifiers within a
 // node. It handles regular type attributes, list type attributes (where
 // type_index is set to the index in the type list), and fixed types.
@@ -923,6 +932,29 @@ int GetCudnnVersion(const Cluster& cluster) {
   return 0;
 }
 
+// Reads the speedups of the bfloat16 kernels of ops over their float32 kernels
+// on the CPU, as measured on the host, from the environment variable
+// TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS, which holds comma separated
+// "<op>=<speedup>" pairs, e.g. "MatMul=1.8,BatchMatMulV2=1.6". The ops which
+// are not listed are assumed to run as fast in both types.
+Status ReadCpuSpeedups(absl::flat_hash_map<string, float>* speedups) {
+  string value;
+  TF_RETURN_IF_ERROR(
+      ReadStringFromEnvVar("TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS", "", &value));
+  for (const string& entry :
+       str_util::Split(value, ',', str_util::SkipEmpty())) {
+    std::vector<string> op_and_speedup = str_util::Split(entry, '=');
+    float speedup;
+    if (op_and_speedup.size() != 2 ||
+        !strings::safe_strtof(op_and_speedup[1], &speedup) || speedup <= 0) {
+      return errors::InvalidArgument(
+          "Invalid entry in TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS: ", entry);
+    }
+    (*speedups)[op_and_speedup[0]] = speedup;
+  }
+  return Status::OK();
+}
+
 class AutoMixedPrecisionImpl {
  public:
   AutoMixedPrecisionImpl(Cluster* cluster,
@@ -951,7 +983,10 @@ class AutoMixedPrecisionImpl {
       case AutoMixedPrecisionMode::CUDA:
         return std::make_unique<AutoMixedPrecisionListsCuda>(cuda_version_,
                                                              cudnn_version_);
+      // The clusters with ops without bfloat16 Eigen kernels are kept in
+      // float32 by RemoveUnprofitableClusters.
       case AutoMixedPrecisionMode::MKL:
+      case AutoMixedPrecisionMode::CPU:
         return std::make_unique<AutoMixedPrecisionListsMkl>();
     }
   }
@@ -991,6 +1026,10 @@ class AutoMixedPrecisionImpl {
       absl::flat_hash_set<int>* allow_set) const;
   void MakeCastsAllowIfAllOutputsAllow(
       absl::flat_hash_set<int>* allow_set) const;
+  Status RemoveUnprofitableClusters(
+      const std::vector<absl::flat_hash_set<const NodeDef*>>&
+          tensor_list_clusters,
+      absl::flat_hash_set<int>* allow_set) const;
   NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_f16,
                         const string& device) const;
   Status ChangeTypeAttrsAndAddCasts(const absl::flat_hash_set<int>& allow_set);
@@ -1255,12 +1294,12 @@ Status AutoMixedPrecisionImpl::Optimize() {
       "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "", &optimization_level));
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
-  if (force_all_fp16_ && mode_ == AutoMixedPrecisionMode::MKL) {
+  if (force_all_fp16_ && mode_ != AutoMixedPrecisionMode::CUDA) {
     // Many ops do not support bfloat16 on the CPU so we disallowing forcing to
     // bfloat16.
     return errors::InvalidArgument(
         "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL cannot be set to "
-        "UNSAFE_FORCE_ALL when MKL is used");
+        "UNSAFE_FORCE_ALL when bfloat16 is used on the CPU");
   }
 
   std::unique_ptr<AutoMixedPrecisionLists> mp_lists =
@@ -1285,6 +1324,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
             (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node));
         break;
       case AutoMixedPrecisionMode::MKL:
+      case AutoMixedPrecisionMode::CPU:
         should_process = !MustPreserve(node) && IsOnDevice(node, DEVICE_CPU);
         break;
     }
@@ -1394,6 +1434,12 @@ Status AutoMixedPrecisionImpl::Optimize() {
   VLOG(2) << "Finding existing casts that can be made allow";
   MakeCastsAllowIfAllOutputsAllow(&allow_set);
 
+  if (mode_ == AutoMixedPrecisionMode::CPU) {
+    VLOG(2) << "Removing the clusters which are not faster in bfloat16";
+    TF_RETURN_IF_ERROR(
+        RemoveUnprofitableClusters(tensor_list_clusters, &allow_set));
+  }
+
   VLOG(2) << "Beginning final pass to change type attributes and insert Cast "
              "ops at paint boundaries";
   TF_RETURN_IF_ERROR(ChangeTypeAttrsAndAddCasts(allow_set));
@@ -1885,6 +1931,153 @@ void AutoMixedPrecisionImpl::MakeCastsAllowIfAllOutputsAllow(
   }
 }
 
+// Removes from allow_set the clusters of connected allow nodes, including the
+// Tensor List nodes which must have the same color, whose predicted float32
+// kernel time multiplied by the speedups of their ops in bfloat16 does not
+// save more than the time of the casts added at the boundary of the cluster,
+// or which have ops without a bfloat16 kernel.
+Status AutoMixedPrecisionImpl::RemoveUnprofitableClusters(
+    const std::vector<absl::flat_hash_set<const NodeDef*>>&
+        tensor_list_clusters,
+    absl::flat_hash_set<int>* allow_set) const {
+  absl::flat_hash_map<string, float> speedups;
+  TF_RETURN_IF_ERROR(ReadCpuSpeedups(&speedups));
+
+  GrapplerItem item;
+  item.graph = *graph_;
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(/*assume_valid_feeds=*/false));
+  std::unique_ptr<OpLevelCostEstimator> estimator = NewOpLevelCostEstimator();
+  auto predict_kernel_time = [&](const NodeDef& node) -> double {
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.op_info.set_op(node.op());
+    *op_context.op_info.mutable_attr() = node.attr();
+    for (const auto& input : properties.GetInputProperties(node.name())) {
+      *op_context.op_info.add_inputs() = input;
+    }
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+    return estimator->PredictCosts(op_context).execution_time.count();
+  };
+  auto predict_cast_time = [&](const NodeDef& node, int port) -> double {
+    const auto& outputs = properties.GetOutputProperties(node.name());
+    if (port >= outputs.size()) return kCpuCastOverheadNanoseconds;
+    OpContext op_context;
+    op_context.op_info.set_op("Cast");
+    *op_context.op_info.add_inputs() = outputs[port];
+    OpInfo::TensorProperties* output = op_context.op_info.add_outputs();
+    *output = outputs[port];
+    output->set_dtype(target_dtype_);
+    *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+    return kCpuCastOverheadNanoseconds +
+           estimator->PredictCosts(op_context).execution_time.count();
+  };
+
+  absl::flat_hash_map<const NodeDef*, int> tensor_list_cluster_index;
+  for (int i = 0; i < tensor_list_clusters.size(); ++i) {
+    for (const NodeDef* node : tensor_list_clusters[i]) {
+      tensor_list_cluster_index[node] = i;
+    }
+  }
+
+  absl::flat_hash_set<int> visited;
+  for (int root_idx = 0; root_idx < graph_type_view_.num_nodes(); ++root_idx) {
+    if (!allow_set->count(root_idx) || visited.count(root_idx)) continue;
+    std::vector<int> cluster;
+    std::vector<int> to_visit = {root_idx};
+    visited.insert(root_idx);
+    auto visit = [&](int idx) {
+      if (allow_set->count(idx) && visited.insert(idx).second) {
+        to_visit.push_back(idx);
+      }
+    };
+    while (!to_visit.empty()) {
+      const int idx = to_visit.back();
+      to_visit.pop_back();
+      cluster.push_back(idx);
+      for (int fanin : graph_type_view_.GetFanin(idx)) visit(fanin);
+      for (int fanout : graph_type_view_.GetFanout(idx)) visit(fanout);
+      auto it =
+          tensor_list_cluster_index.find(graph_type_view_.GetNode(idx)->node);
+      if (it == tensor_list_cluster_index.end()) continue;
+      for (const NodeDef* node : tensor_list_clusters[it->second]) {
+        const absl::optional<int> node_type_idx = graph_type_view_.GetNodeIndex(
+            *GetTensorListFloat32NodeTypeId(*node));
+        if (node_type_idx.has_value()) visit(node_type_idx.value());
+      }
+    }
+
+    bool has_bf16_kernels = true;
+    double saved_nanoseconds = 0;
+    double cast_nanoseconds = 0;
+    absl::flat_hash_set<const NodeDef*> costed_nodes;
+    absl::flat_hash_set<string> cast_tensors;
+    for (int idx : cluster) {
+      const NodeTypeId& node_type = *graph_type_view_.GetNode(idx);
+      const NodeDef& node = *node_type.node;
+      if (!IsFloat32(node_type)) continue;
+      if (!SupportsF16(node_type)) has_bf16_kernels = false;
+      if (costed_nodes.insert(&node).second) {
+        auto it = speedups.find(node.op());
+        if (it != speedups.end()) {
+          saved_nanoseconds += predict_kernel_time(node) * (1 - 1 / it->second);
+        }
+      }
+      // The float32 inputs produced outside of the cluster are cast to
+      // bfloat16, except the constants, whose casts are folded.
+      for (int port :
+           node_type_map_.GetInputPorts(node, node_type.type_attr)) {
+        GraphView::InputPort node_input(&node, port);
+        MutableGraphView::OutputPort fanin =
+            graph_view_.GetRegularFanin(node_input);
+        if (fanin.node == nullptr || IsConstant(*fanin.node)) continue;
+        const absl::optional<int> fanin_idx = graph_type_view_.GetNodeIndex(
+            fanin.node->name(),
+            node_type_map_.GetOutputTypeAttr(*fanin.node, fanin.port_id));
+        if (!fanin_idx.has_value() || allow_set->count(fanin_idx.value()) ||
+            !IsFloat32(*graph_type_view_.GetNode(fanin_idx.value()))) {
+          continue;
+        }
+        if (cast_tensors
+                .insert(strings::StrCat(fanin.node->name(), ":",
+                                        fanin.port_id))
+                .second) {
+          cast_nanoseconds += predict_cast_time(*fanin.node, fanin.port_id);
+        }
+      }
+      // The outputs consumed outside of the cluster are cast back to float32.
+      for (int port :
+           node_type_map_.GetOutputPorts(node, node_type.type_attr)) {
+        GraphView::OutputPort output_port(&node, port);
+        for (const auto& fanout : graph_view_.GetFanout(output_port)) {
+          const absl::optional<int> fanout_idx = graph_type_view_.GetNodeIndex(
+              fanout.node->name(),
+              node_type_map_.GetInputTypeAttr(*fanout.node, fanout.port_id));
+          if (fanout_idx.has_value() && !allow_set->count(fanout_idx.value())) {
+            cast_nanoseconds += predict_cast_time(node, port);
+            break;
+          }
+        }
+      }
+    }
+
+    if (has_bf16_kernels && saved_nanoseconds > cast_nanoseconds) continue;
+    VLOG(1) << "Keeping a cluster of " << cluster.size()
+            << " type attributes in float32: "
+            << (has_bf16_kernels
+                    ? strings::StrCat("converting it would save ",
+                                      saved_nanoseconds,
+                                      "ns of kernel time, and add ",
+                                      cast_nanoseconds, "ns of casts")
+                    : "some of its ops have no bfloat16 kernel");
+    for (int idx : cluster) allow_set->erase(idx);
+  }
+  return Status::OK();
+}
+
 // Changes all allow-painted type attributes to DT_HALF or DT_BFLOAT16, and
 // inserts Cast nodes at node outputs for all edges that connect
 // allow-painted <-> non-allow-painted type attributes.
@@ -2009,6 +2202,12 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
                  << " graph optimizer";
     return Status::OK();
   }
+  if (mode_ == AutoMixedPrecisionMode::CPU && !ShouldIgnorePerformance() &&
+      !port::TestCPUFeature(port::CPUFeature::AVX512_BF16)) {
+    LOG(WARNING) << "No AVX512-BF16 support detected, skipping " << name()
+                 << " graph optimizer";
+    return Status::OK();
+  }
 
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
@@ -13,8 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || \
-    (INTEL_MKL && defined(ENABLE_INTEL_MKL_BFLOAT16))
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || !INTEL_MKL || \
+    defined(ENABLE_INTEL_MKL_BFLOAT16)
 
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
@@ -1357,9 +1357,76 @@ TEST_F(AutoMixedPrecisionMklTest, TensorListSetGet) {
 #endif  // ENABLE_INTEL_MKL_BFLOAT16
 #endif  // INTEL_MKL
 
+#if !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM) && !INTEL_MKL
+
+class AutoMixedPrecisionCpuTest : public GrapplerTest {
+ protected:
+  void SetUp() override {
+    // Runs the optimizer on hosts without AVX512-BF16 too.
+    setenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_IGNORE_PERFORMANCE", "1",
+           /*overwrite=*/1);
+    setenv("TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS", "MatMul=2",
+           /*overwrite=*/1);
+    virtual_cluster_.reset(new SingleMachine(/* timeout_s = */ 10, 1, 0));
+    TF_CHECK_OK(virtual_cluster_->Provision());
+  }
+  void TearDown() override {
+    unsetenv("TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS");
+    TF_CHECK_OK(virtual_cluster_->Shutdown());
+  }
+
+  // Builds input -> Exp -> MatMul -> Relu -> fetch, with matrices of `size`
+  // rows and columns, and returns the type of the MatMul once optimized.
+  DataType OptimizedMatMulType(int size) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output input = ops::Const(s.WithOpName("input"), 1.f / size, {size, size});
+    Output deny1 = ops::Exp(s.WithOpName("deny1"), input);
+    Output allow1 = ops::MatMul(s.WithOpName("allow1"), deny1, deny1);
+    Output clr1 = ops::Relu(s.WithOpName("clr1"), allow1);
+    Output fetch = ops::Identity(s.WithOpName("fetch"), clr1);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+
+    AutoMixedPrecision optimizer{AutoMixedPrecisionMode::CPU};
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+    VLOG(1) << output.DebugString();
+
+    auto tensors = EvaluateNodes(output, item.fetch);
+    EXPECT_EQ(tensors.size(), tensors_expected.size());
+    for (int i = 0; i < tensors.size(); ++i) {
+      test::ExpectClose(tensors_expected[i], tensors[i], -1, 1e-2);
+    }
+    GraphView output_view(&output);
+    EXPECT_EQ(output_view.GetNode("deny1")->attr().at("T").type(), DT_FLOAT);
+    return output_view.GetNode("allow1")->attr().at("T").type();
+  }
+
+  std::unique_ptr<Cluster> virtual_cluster_;
+};
+
+TEST_F(AutoMixedPrecisionCpuTest, ConvertsClustersWhichPayOff) {
+  EXPECT_EQ(OptimizedMatMulType(256), DT_BFLOAT16);
+}
+
+TEST_F(AutoMixedPrecisionCpuTest, KeepsSmallClustersInFloat32) {
+  // The casts take longer than the MatMul saves.
+  EXPECT_EQ(OptimizedMatMulType(4), DT_FLOAT);
+}
+
+TEST_F(AutoMixedPrecisionCpuTest, KeepsClustersWithoutSpeedupsInFloat32) {
+  unsetenv("TF_AUTO_MIXED_PRECISION_CPU_SPEEDUPS");
+  EXPECT_EQ(OptimizedMatMulType(256), DT_FLOAT);
+}
+
+#endif  // !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM) && !INTEL_MKL
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
 
-#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM || (INTEL_MKL &&
-        // defined(ENABLE_INTEL_MKL_BFLOAT16))
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM || !INTEL_MKL ||
+        // defined(ENABLE_INTEL_MKL_BFLOAT16)
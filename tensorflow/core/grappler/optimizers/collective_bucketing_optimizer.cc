@@ -0,0 +1,280 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/collective_bucketing_optimizer.h"
+
+#include <map>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kCollectiveReduceV2[] = "CollectiveReduceV2";
+
+struct Member {
+  NodeDef* node;
+  int topo_index;
+  TensorShape shape;
+};
+
+// Reductions can share a bucket iff they agree on everything but their data
+// input and instance key.
+string BucketKey(const NodeDef& node) {
+  string key = strings::StrCat(node.device(), "|", node.input(1), "|",
+                               node.input(2));
+  const std::map<string, AttrValue> attrs(node.attr().begin(),
+                                          node.attr().end());
+  for (const auto& attr : attrs) {
+    strings::StrAppend(&key, "|", attr.first, "=",
+                       SummarizeAttrValue(attr.second));
+  }
+  return key;
+}
+
+NodeDef* AddConstNode(const string& name, const string& device,
+                      const Tensor& value, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(device);
+  (*node->mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent(
+      (*node->mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+Tensor Int32Vector(const std::vector<int32>& values) {
+  Tensor t(DT_INT32, TensorShape({static_cast<int64>(values.size())}));
+  for (int i = 0; i < values.size(); ++i) t.vec<int32>()(i) = values[i];
+  return t;
+}
+
+// Returns true if `node` transitively depends on one of `members`. Only nodes
+// at or after `min_topo_index` in topological order can reach a member.
+bool DependsOnAny(const NodeDef& node,
+                  const absl::flat_hash_set<const NodeDef*>& members,
+                  int min_topo_index, const NodeMap& node_map,
+                  const absl::flat_hash_map<const NodeDef*, int>& topo_index) {
+  std::vector<const NodeDef*> stack = {&node};
+  absl::flat_hash_set<const NodeDef*> visited = {&node};
+  while (!stack.empty()) {
+    const NodeDef* current = stack.back();
+    stack.pop_back();
+    for (const string& input : current->input()) {
+      const NodeDef* input_node = node_map.GetNode(input);
+      if (input_node == nullptr || !visited.insert(input_node).second) continue;
+      if (members.contains(input_node)) return true;
+      auto it = topo_index.find(input_node);
+      if (it != topo_index.end() && it->second >= min_topo_index) {
+        stack.push_back(input_node);
+      }
+    }
+  }
+  return false;
+}
+
+// Replaces the reductions in `bucket` by a single reduction of their
+// concatenated inputs.
+void FuseBucket(const std::vector<Member>& bucket, GraphDef* graph) {
+  const NodeDef& first = *bucket.front().node;
+  const string prefix = strings::StrCat(first.name(), "/bucket");
+  const string& device = first.device();
+  const DataType dtype = first.attr().at("T").type();
+
+  AddConstNode(strings::StrCat(prefix, "/flat_shape"), device,
+               Int32Vector({-1}), graph);
+  Tensor axis(DT_INT32, TensorShape({}));
+  axis.scalar<int32>()() = 0;
+  AddConstNode(strings::StrCat(prefix, "/axis"), device, axis, graph);
+
+  NodeDef* concat = graph->add_node();
+  concat->set_name(strings::StrCat(prefix, "/concat"));
+  concat->set_op("ConcatV2");
+  concat->set_device(device);
+  NodeDef* reduce = graph->add_node();
+  reduce->set_name(strings::StrCat(prefix, "/reduce"));
+  reduce->set_op(kCollectiveReduceV2);
+  reduce->set_device(device);
+  *reduce->mutable_attr() = first.attr();
+  reduce->add_input(concat->name());
+  for (int i = 1; i < 4; ++i) reduce->add_input(first.input(i));
+  Tensor sizes(DT_INT64, TensorShape({static_cast<int64>(bucket.size())}));
+
+  for (int i = 0; i < bucket.size(); ++i) {
+    NodeDef* member = bucket[i].node;
+    NodeDef* flatten = graph->add_node();
+    flatten->set_name(strings::StrCat(prefix, "/flatten_", i));
+    flatten->set_op("Reshape");
+    flatten->set_device(device);
+    flatten->add_input(member->input(0));
+    flatten->add_input(strings::StrCat(prefix, "/flat_shape"));
+    (*flatten->mutable_attr())["T"].set_type(dtype);
+    (*flatten->mutable_attr())["Tshape"].set_type(DT_INT32);
+    concat->add_input(flatten->name());
+    // The fused reduction must not start before any member would have.
+    for (int j = 4; j < member->input_size(); ++j) {
+      reduce->add_input(member->input(j));
+    }
+    sizes.vec<int64>()(i) = bucket[i].shape.num_elements();
+  }
+  concat->add_input(strings::StrCat(prefix, "/axis"));
+  (*concat->mutable_attr())["N"].set_i(bucket.size());
+  (*concat->mutable_attr())["T"].set_type(dtype);
+  (*concat->mutable_attr())["Tidx"].set_type(DT_INT32);
+
+  AddConstNode(strings::StrCat(prefix, "/sizes"), device, sizes, graph);
+  NodeDef* split = graph->add_node();
+  split->set_name(strings::StrCat(prefix, "/split"));
+  split->set_op("SplitV");
+  split->set_device(device);
+  split->add_input(reduce->name());
+  split->add_input(strings::StrCat(prefix, "/sizes"));
+  split->add_input(strings::StrCat(prefix, "/axis"));
+  (*split->mutable_attr())["num_split"].set_i(bucket.size());
+  (*split->mutable_attr())["T"].set_type(dtype);
+  (*split->mutable_attr())["Tlen"].set_type(DT_INT64);
+
+  // Each member becomes the reshape of its part of the result, so that its
+  // consumers do not need to be rewired.
+  for (int i = 0; i < bucket.size(); ++i) {
+    NodeDef* member = bucket[i].node;
+    std::vector<int32> dims;
+    for (int64 dim : bucket[i].shape.dim_sizes()) dims.push_back(dim);
+    const string shape_name = strings::StrCat(prefix, "/shape_", i);
+    AddConstNode(shape_name, device, Int32Vector(dims), graph);
+    member->set_op("Reshape");
+    member->clear_input();
+    member->add_input(strings::StrCat(split->name(), ":", i));
+    member->add_input(shape_name);
+    member->clear_attr();
+    (*member->mutable_attr())["T"].set_type(dtype);
+    (*member->mutable_attr())["Tshape"].set_type(DT_INT32);
+  }
+}
+
+}  // namespace
+
+Status CollectiveBucketingOptimizer::Init(
+    const tensorflow::RewriterConfig_CustomGraphOptimizer* config) {
+  if (config == nullptr) return Status::OK();
+  const auto& params = config->parameter_map();
+  auto it = params.find("bucket_bytes");
+  if (it != params.end()) {
+    if (it->second.i() <= 0) {
+      return errors::InvalidArgument(
+          "bucket_bytes must be positive, got: ", it->second.i());
+    }
+    bucket_bytes_ = it->second.i();
+  }
+  return Status::OK();
+}
+
+Status CollectiveBucketingOptimizer::Optimize(Cluster* cluster,
+                                              const GrapplerItem& item,
+                                              GraphDef* output) {
+  int num_reductions = 0;
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() == kCollectiveReduceV2) ++num_reductions;
+  }
+  if (num_reductions < 2) {
+    return errors::Aborted("Nothing to do.");
+  }
+
+  *output = item.graph;
+  TF_RETURN_IF_ERROR(TopologicalSort(output));
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+
+  NodeMap node_map(output);
+  absl::flat_hash_map<const NodeDef*, int> topo_index;
+  for (int i = 0; i < output->node_size(); ++i) {
+    topo_index[&output->node(i)] = i;
+  }
+
+  // Buckets in the order in which they were opened.
+  std::vector<std::vector<Member>> buckets;
+  absl::flat_hash_map<string, int> open_bucket;
+  absl::flat_hash_map<int, int64> bucket_bytes;
+  for (int i = 0; i < output->node_size(); ++i) {
+    NodeDef* node = output->mutable_node(i);
+    if (node->op() != kCollectiveReduceV2 || node->input_size() < 4) continue;
+    const std::vector<OpInfo::TensorProperties>& inputs =
+        properties.GetInputProperties(node->name());
+    if (inputs.empty()) continue;
+    const PartialTensorShape shape(inputs[0].shape());
+    if (!shape.IsFullyDefined() || inputs[0].dtype() == DT_INVALID) continue;
+    Member member{node, i, TensorShape()};
+    shape.AsTensorShape(&member.shape);
+    const int64 bytes =
+        member.shape.num_elements() * DataTypeSize(inputs[0].dtype());
+
+    const string key = BucketKey(*node);
+    auto it = open_bucket.find(key);
+    if (it != open_bucket.end()) {
+      std::vector<Member>& bucket = buckets[it->second];
+      absl::flat_hash_set<const NodeDef*> members;
+      for (const Member& m : bucket) members.insert(m.node);
+      if (bucket_bytes[it->second] + bytes <= bucket_bytes_ &&
+          !DependsOnAny(*node, members, bucket.front().topo_index, node_map,
+                        topo_index)) {
+        bucket.push_back(member);
+        bucket_bytes[it->second] += bytes;
+        continue;
+      }
+    }
+    open_bucket[key] = buckets.size();
+    bucket_bytes[buckets.size()] = bytes;
+    buckets.push_back({member});
+  }
+
+  int num_fused = 0;
+  for (const std::vector<Member>& bucket : buckets) {
+    if (bucket.size() < 2) continue;
+    FuseBucket(bucket, output);
+    num_fused += bucket.size();
+  }
+  if (num_fused == 0) {
+    return errors::Aborted("Nothing to do.");
+  }
+  VLOG(1) << "Fused " << num_fused << " of " << num_reductions
+          << " CollectiveReduceV2 ops into buckets of at most " << bucket_bytes_
+          << " bytes";
+  return Status::OK();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(CollectiveBucketingOptimizer,
+                            "collective_bucketing");
+
+}  // namespace grappler
+}  // namespace tensorflow
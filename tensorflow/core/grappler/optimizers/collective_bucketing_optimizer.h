@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuses CollectiveReduceV2 ops into size-bounded buckets.
+//
+// Reductions that run on the same device, in the same group and with the same
+// attributes are visited in topological order, i.e. in the order in which
+// their inputs (typically gradients) become available during backprop, and
+// greedily packed into buckets of at most `bucket_bytes` bytes. Each bucket
+// is replaced by one CollectiveReduceV2 of the concatenation of its flattened
+// inputs, whose result is split and reshaped back into the original outputs.
+// A bucket only depends on its own members, so its reduction is issued as
+// soon as its last member is computed and overlaps with the rest of backprop.
+//
+// A reduction is never added to a bucket whose members it depends on. Every
+// member of a collective group must run this optimizer on an equivalent
+// graph, since the fused reduction reuses the instance key of the first
+// member of its bucket.
+//
+// Registered as the custom optimizer "collective_bucketing"; the bucket size
+// is set through the "bucket_bytes" parameter.
+class CollectiveBucketingOptimizer : public CustomGraphOptimizer {
+ public:
+  static constexpr int64 kDefaultBucketBytes = 25 << 20;
+
+  CollectiveBucketingOptimizer() = default;
+  ~CollectiveBucketingOptimizer() override = default;
+
+  string name() const override { return "collective_bucketing"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override;
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimize_output, double result) override {}
+
+ private:
+  int64 bucket_bytes_ = kDefaultBucketBytes;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_OPTIMIZER_H_
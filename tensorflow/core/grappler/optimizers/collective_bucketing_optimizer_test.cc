@@ -0,0 +1,146 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/collective_bucketing_optimizer.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+constexpr char kDevice[] = "/device:CPU:0";
+
+class CollectiveBucketingOptimizerTest : public GrapplerTest {
+ protected:
+  static NodeDef Placeholder(const string& name, DataType dtype,
+                             const TensorShape& shape) {
+    return NDef(name, "Placeholder", {}, {{"dtype", dtype}, {"shape", shape}},
+                kDevice);
+  }
+
+  static NodeDef Reduce(const string& name, const string& input) {
+    return NDef(name, "CollectiveReduceV2",
+                {input, "group_size", "group_key", "instance_key"},
+                {{"T", DT_FLOAT},
+                 {"merge_op", "Add"},
+                 {"final_op", "Id"},
+                 {"communication_hint", "auto"},
+                 {"timeout_seconds", 0.0f}},
+                kDevice);
+  }
+
+  static GrapplerItem MakeItem(const std::vector<NodeDef>& nodes,
+                               const std::vector<string>& fetch) {
+    std::vector<NodeDef> all_nodes = {
+        Placeholder("group_size", DT_INT32, TensorShape({})),
+        Placeholder("group_key", DT_INT32, TensorShape({})),
+        Placeholder("instance_key", DT_INT32, TensorShape({}))};
+    all_nodes.insert(all_nodes.end(), nodes.begin(), nodes.end());
+    GrapplerItem item;
+    item.graph = test::function::GDef(all_nodes);
+    item.fetch = fetch;
+    return item;
+  }
+
+  static int CountOp(const GraphDef& graph, const string& op) {
+    int count = 0;
+    for (const NodeDef& node : graph.node()) {
+      if (node.op() == op) ++count;
+    }
+    return count;
+  }
+};
+
+TEST_F(CollectiveBucketingOptimizerTest, FusesIndependentReductions) {
+  GrapplerItem item = MakeItem(
+      {Placeholder("a", DT_FLOAT, TensorShape({2, 2})),
+       Placeholder("b", DT_FLOAT, TensorShape({3})),
+       Placeholder("c", DT_FLOAT, TensorShape({5})), Reduce("reduce_a", "a"),
+       Reduce("reduce_b", "b"), Reduce("reduce_c", "c")},
+      {"reduce_a", "reduce_b", "reduce_c"});
+
+  CollectiveBucketingOptimizer optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(1, CountOp(output, "CollectiveReduceV2"));
+  EXPECT_EQ(1, CountOp(output, "ConcatV2"));
+  EXPECT_EQ(1, CountOp(output, "SplitV"));
+  NodeMap node_map(&output);
+  for (const string& name : item.fetch) {
+    const NodeDef* node = node_map.GetNode(name);
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ("Reshape", node->op());
+    EXPECT_EQ(kDevice, node->device());
+    EXPECT_EQ("SplitV", node_map.GetNode(node->input(0))->op());
+  }
+}
+
+TEST_F(CollectiveBucketingOptimizerTest, DoesNotFuseDependentReductions) {
+  GrapplerItem item = MakeItem(
+      {Placeholder("a", DT_FLOAT, TensorShape({4})), Reduce("reduce_a", "a"),
+       NDef("b", "Identity", {"reduce_a"}, {{"T", DT_FLOAT}}, kDevice),
+       Reduce("reduce_b", "b")},
+      {"reduce_b"});
+
+  CollectiveBucketingOptimizer optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+TEST_F(CollectiveBucketingOptimizerTest, RespectsBucketBytes) {
+  GrapplerItem item = MakeItem(
+      {Placeholder("a", DT_FLOAT, TensorShape({4})),
+       Placeholder("b", DT_FLOAT, TensorShape({4})),
+       Placeholder("c", DT_FLOAT, TensorShape({4})),
+       Placeholder("d", DT_FLOAT, TensorShape({4})), Reduce("reduce_a", "a"),
+       Reduce("reduce_b", "b"), Reduce("reduce_c", "c"),
+       Reduce("reduce_d", "d")},
+      {"reduce_a", "reduce_b", "reduce_c", "reduce_d"});
+
+  // Each input has 16 bytes, so every bucket holds two of them.
+  RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["bucket_bytes"].set_i(32);
+  CollectiveBucketingOptimizer optimizer;
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(2, CountOp(output, "CollectiveReduceV2"));
+  EXPECT_EQ(2, CountOp(output, "SplitV"));
+}
+
+TEST_F(CollectiveBucketingOptimizerTest, RejectsNonPositiveBucketBytes) {
+  RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["bucket_bytes"].set_i(0);
+  CollectiveBucketingOptimizer optimizer;
+  EXPECT_TRUE(errors::IsInvalidArgument(optimizer.Init(&config)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -34,7 +34,11 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
@@ -63,6 +67,39 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 const int64 kMaxConstantSize = 10 * 1024 * 1024;
 
 namespace {
+
+// Folding nodes whose outputs are larger than their inputs by at least this
+// many bytes must save more time than it takes to load the bytes added to the
+// model.
+constexpr int64 kMinCostedConstantGrowth = 64 * 1024;
+// The time to load a byte of a model, from disk or over the network.
+constexpr double kLoadNanosecondsPerByte = 1.0;
+
+// Returns true if the predicted time to compute `node` on the CPU exceeds the
+// time to load `added_bytes` of folded outputs.
+bool FoldingSavesLoadTime(
+    const NodeDef& node,
+    const std::vector<OpInfo::TensorProperties>& input_props,
+    const std::vector<OpInfo::TensorProperties>& output_props,
+    int64 added_bytes) {
+  static const OpLevelCostEstimator* estimator =
+      NewOpLevelCostEstimator().release();
+  static const DeviceProperties* cpu = new DeviceProperties(GetLocalCPUInfo());
+  OpContext op_context;
+  op_context.name = node.name();
+  op_context.op_info.set_op(node.op());
+  *op_context.op_info.mutable_attr() = node.attr();
+  for (const auto& input_prop : input_props) {
+    *op_context.op_info.add_inputs() = input_prop;
+  }
+  for (const auto& output_prop : output_props) {
+    *op_context.op_info.add_outputs() = output_prop;
+  }
+  *op_context.op_info.mutable_device() = *cpu;
+  return estimator->PredictCosts(op_context).execution_time.count() >
+         added_bytes * kLoadNanosecondsPerByte;
+}
+
 template <typename T>
 bool AllValuesAre(const TensorProto& proto, const T& value) {
   Tensor tensor;
@@ -1014,6 +1051,14 @@ bool ConstantFolding::IsFoldableUncached(
           // CreateNodeDef() where the actual encoded size is checked.
           return false;
         }
+        // Nor if the output is much larger than the inputs, and cheap to
+        // compute, e.g. a broadcast, as it would only make the model larger
+        // and slower to load.
+        if (num_bytes - input_size_bytes >= kMinCostedConstantGrowth &&
+            !FoldingSavesLoadTime(node, input_props, output_props,
+                                  num_bytes - input_size_bytes)) {
+          return false;
+        }
       }
     }
   }
@@ -3029,6 +3029,48 @@ TEST_F(ConstantFoldingTest, LargeConstantNoSizeIncrease) {
   EXPECT_LT(output.ByteSizeLong(), sizeof(float) * large_constant_size + 500);
 }
 
+TEST_F(ConstantFoldingTest, LargeCheapOutputNotFolded) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output value =
+      ops::Const(scope.WithOpName("value"), {1.0f, 2.0f, 3.0f, 4.0f});
+  // A 256KiB tile is faster to compute than to load from the model.
+  Output large_multiples =
+      ops::Const(scope.WithOpName("large_multiples"), {16 * 1024});
+  Output large = ops::Tile(scope.WithOpName("large"), value, large_multiples);
+  Output small_multiples =
+      ops::Const(scope.WithOpName("small_multiples"), {16});
+  Output small = ops::Tile(scope.WithOpName("small"), value, small_multiples);
+  Output large_out = ops::Identity(scope.WithOpName("large_out"), large);
+  Output small_out = ops::Identity(scope.WithOpName("small_out"), small);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch = {"large_out", "small_out"};
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "large") {
+      EXPECT_EQ(node.op(), "Tile");
+      ++found;
+    } else if (node.name() == "small") {
+      EXPECT_EQ(node.op(), "Const");
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
 TEST_F(ConstantFoldingTest, MaterializeBroadcastGradientArgs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output a =
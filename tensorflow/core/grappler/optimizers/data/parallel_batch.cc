@@ -33,7 +33,8 @@ Status ParallelBatch::OptimizeAndCollectStats(Cluster* cluster,
   MutableGraphView graph(output);
 
   for (NodeDef& node : *output->mutable_node()) {
-    if (node.op() == "BatchDatasetV2" || node.op() == "PaddedBatchDatasetV2") {
+    if (node.op() == "BatchDatasetV2" || node.op() == "PaddedBatchDatasetV2" ||
+        node.op() == "BucketByTokenBudgetDataset") {
       (*node.mutable_attr())["parallel_copy"].set_b(true);
       stats->num_changes++;
     }
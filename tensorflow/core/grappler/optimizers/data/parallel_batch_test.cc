@@ -72,6 +72,28 @@ TEST(ParallelBatch, PaddedBatch) {
   EXPECT_TRUE(output.node(index).attr().at("parallel_copy").b());
 }
 
+TEST(ParallelBatch, BucketByTokenBudget) {
+  using test::function::NDef;
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"}, {}),
+       NDef("max_tokens", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       NDef("batch", "BucketByTokenBudgetDataset",
+            {"range", "max_tokens", "drop_remainder"}, {})});
+
+  ParallelBatch optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  int index = graph_utils::FindGraphNodeWithName("batch", output);
+  EXPECT_TRUE(output.node(index).attr().at("parallel_copy").b());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,62 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kExpandDimsPrefix = "vectorized/expand_dims";
+
+class ExpandDimsVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kExpandDimsPrefix);
+
+    Output tensor, dim;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &tensor));
+    TF_RETURN_IF_ERROR(inputs.unstacked(1, &dim));
+
+    // Non-negative dimensions are shifted past the new leading dimension,
+    // while negative dimensions already count from the end:
+    // dim + cast(dim >= 0)
+    Output shift = ops::Cast(
+        s, ops::GreaterEqual(s, dim, ops::ZerosLike(s, dim)), dim.type());
+    Output vectorized_expand_dims =
+        ops::ExpandDims(s, tensor, ops::Add(s, dim, shift));
+
+    TF_RETURN_IF_ERROR(status);
+
+    // Add output mappings
+    outputs->push_back({vectorized_expand_dims.node(), 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("ExpandDims", ExpandDimsVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kImageResizePrefix = "vectorized/image_resize";
+
+// Returns shape[begin:end], where an `end` of 0 means the end of the shape.
+Output SliceShape(Scope* s, Output shape, int begin, int end) {
+  Output const_vec_1 = ops::Const(*s, {1});
+  return ops::StridedSlice(*s, shape, ops::Const(*s, {begin}),
+                           ops::Const(*s, {end}), const_vec_1,
+                           ops::StridedSlice::Attrs().EndMask(end == 0));
+}
+
+// Vectorizer for the image resize ops, which take a 4-D
+// [batch, height, width, channels] input and resize each image in the batch
+// independently. The stacked 5-D input is folded into a single batch, resized
+// with the original op and unfolded again.
+class ImageResizeVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kImageResizePrefix);
+
+    Output images, size;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &images));
+    TF_RETURN_IF_ERROR(inputs.unstacked(1, &size));
+
+    // tf.reshape(images, tf.concat([[-1], tf.shape(images)[2:]], 0))
+    Output shape = ops::Shape(s, images);
+    Output merged_images = ops::Reshape(
+        s, images,
+        ops::Concat(s, {ops::Const(s, {-1}), SliceShape(&s, shape, 2, 0)},
+                    ops::Const(s, 0)));
+    TF_RETURN_IF_ERROR(status);
+
+    Node* resize_node;
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(merged_images.node(), merged_images.index())
+                            .Input(size.node(), size.index());
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &resize_node));
+    Output resized(resize_node, 0);
+
+    // tf.reshape(resized,
+    //            tf.concat([tf.shape(images)[:2], tf.shape(resized)[1:]], 0))
+    Output vectorized_resize = ops::Reshape(
+        s, resized,
+        ops::Concat(s,
+                    {SliceShape(&s, shape, 0, 2),
+                     SliceShape(&s, ops::Shape(s, resized), 1, 0)},
+                    ops::Const(s, 0)));
+
+    TF_RETURN_IF_ERROR(status);
+
+    // Add output mappings
+    outputs->push_back({vectorized_resize.node(), 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("ResizeArea", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeBicubic", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeBilinear", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeNearestNeighbor", ImageResizeVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kSqueezePrefix = "vectorized/squeeze";
+
+class SqueezeVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    std::vector<int32> squeeze_dims;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node.attrs(), "squeeze_dims", &squeeze_dims));
+    // Without explicit dimensions, Squeeze removes every dimension of size 1,
+    // which would include the leading dimension when the batch size is 1.
+    if (squeeze_dims.empty()) {
+      return errors::Unimplemented(
+          "Cannot vectorize Squeeze without explicit squeeze_dims.");
+    }
+    for (int32& dim : squeeze_dims) {
+      if (dim >= 0) ++dim;
+    }
+
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kSqueezePrefix);
+
+    Output tensor;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &tensor));
+
+    Output vectorized_squeeze = ops::Squeeze(
+        s, tensor,
+        ops::Squeeze::Attrs().Axis(gtl::ArraySlice<int>(squeeze_dims)));
+
+    TF_RETURN_IF_ERROR(status);
+
+    // Add output mappings
+    outputs->push_back({vectorized_squeeze.node(), 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("Squeeze", SqueezeVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Vectorizer for ops that independently transform each element of their first
+// input, e.g. string ops such as StringLower or decoding ops such as DecodeRaw.
+// Any other inputs (such as the pattern of RegexReplace) are op parameters and
+// must be unstacked. Since such ops act on each element of their first input,
+// the vectorized op is the same as the original.
+class ElementwiseOpVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    if (inputs.size() == 0) {
+      return errors::Internal("Failed to vectorize ", node.type_string(),
+                              ". The op should have at least 1 input.");
+    }
+    NodeBuilder::NodeOut input;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &input));
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(input);
+    for (int i = 1; i < inputs.size(); ++i) {
+      NodeBuilder::NodeOut parameter;
+      TF_RETURN_IF_ERROR(inputs.unstacked(i, &parameter));
+      node_builder = node_builder.Input(parameter);
+    }
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    Node* new_node;
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    for (int i = 0; i < node.num_outputs(); ++i) {
+      outputs->push_back({new_node, i, true});
+    }
+    return Status::OK();
+  }
+};
+
+// String
+REGISTER_VECTORIZER("AsString", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("DecodeBase64", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("EncodeBase64", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("RegexFullMatch", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("RegexReplace", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexFullMatch", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexReplace", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringLength", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringLower", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringStrip", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucket", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketFast", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketStrong", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToNumber", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("StringUpper", ElementwiseOpVectorizer);
+
+// Decoding
+REGISTER_VECTORIZER("DecodeCompressed", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("DecodeRaw", ElementwiseOpVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -922,6 +923,18 @@ Status CwiseTestHelper(DataType input_type, const string& op_type,
              : Status::OK();
 }
 
+class StringUnaryTest : public ::testing::TestWithParam<const char*> {};
+
+TEST_P(StringUnaryTest, VectorizeStringUnary) {
+  TF_EXPECT_OK(CwiseTestHelper(DT_STRING, GetParam(), 1));
+}
+
+INSTANTIATE_TEST_CASE_P(Test, StringUnaryTest,
+                        ::testing::Values("DecodeBase64", "EncodeBase64",
+                                          "StringLength", "StringLower",
+                                          "StringStrip", "StringToNumber",
+                                          "StringUpper"));
+
 class BitwiseUnaryTest : public ::testing::TestWithParam<const char*> {};
 
 TEST_P(BitwiseUnaryTest, VectorizeCwiseBitwiseUnary) {
@@ -1380,6 +1393,150 @@ TEST(VectorizerTest, VectorizeIdentity) {
   EXPECT_EQ(vectorized->node_def_size(), 1);
 }
 
+TEST(VectorizerTest, VectorizeRegexReplace) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/{"ret0: string"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Pattern", tstring("a+")),
+       FunctionDefHelper::Const("Rewrite", tstring("b")),
+       {{"RegexReplace"},
+        "RegexReplace",
+        {"arg0", "Pattern:output:0", "Rewrite:output:0"},
+        {{"replace_global", true}}}},
+      /*ret_def=*/{{"ret0", "RegexReplace:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& regex_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("RegexReplace", *vectorized));
+  EXPECT_EQ(regex_node.input(0), vectorized->signature().input_arg(0).name());
+  EXPECT_EQ(GetRetval(*vectorized, 0),
+            strings::StrCat(regex_node.name(), ":output:0"));
+}
+
+TEST(VectorizerTest, VectorizeDecodeRaw) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/{"ret0: float"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {{{"DecodeRaw"},
+        "DecodeRaw",
+        {"arg0"},
+        {{"out_type", DT_FLOAT}, {"little_endian", true}}}},
+      /*ret_def=*/{{"ret0", "DecodeRaw:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  EXPECT_TRUE(
+      function_utils::ContainsFunctionNodeWithOp("DecodeRaw", *vectorized));
+}
+
+TEST(VectorizerTest, VectorizeExpandDims) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: int32"},
+      /*out_def=*/{"ret0: int32"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Dim", 0),
+       {{"ExpandDims"},
+        "ExpandDims",
+        {"arg0", "Dim:output:0"},
+        {{"T", DT_INT32}, {"Tdim", DT_INT32}}}},
+      /*ret_def=*/{{"ret0", "ExpandDims:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& expand_dims_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("ExpandDims", *vectorized));
+  EXPECT_EQ(GetRetval(*vectorized, 0),
+            strings::StrCat(expand_dims_node.name(), ":output:0"));
+}
+
+TEST(VectorizerTest, VectorizeSqueeze) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: int32"},
+      /*out_def=*/{"ret0: int32"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {{{"Squeeze"},
+        "Squeeze",
+        {"arg0"},
+        {{"T", DT_INT32}, {"squeeze_dims", gtl::ArraySlice<int>({0, -1})}}}},
+      /*ret_def=*/{{"ret0", "Squeeze:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& squeeze_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("Squeeze", *vectorized));
+  std::vector<int32> squeeze_dims;
+  TF_ASSERT_OK(GetNodeAttr(squeeze_node, "squeeze_dims", &squeeze_dims));
+  EXPECT_EQ(squeeze_dims, std::vector<int32>({1, -1}));
+}
+
+TEST(VectorizerTest, VectorizeSqueezeWithoutDims) {
+  // Squeezing all dimensions of size 1 could also squeeze the batch dimension,
+  // so the function is left unvectorized.
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: int32"},
+      /*out_def=*/{"ret0: int32"},
+      /*attr_def=*/{},
+      /*node_def=*/{{{"Squeeze"}, "Squeeze", {"arg0"}, {{"T", DT_INT32}}}},
+      /*ret_def=*/{{"ret0", "Squeeze:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_TRUE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+}
+
+TEST(VectorizerTest, VectorizeResizeBilinear) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: float"},
+      /*out_def=*/{"ret0: float"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Size", gtl::ArraySlice<int>({32, 32})),
+       {{"ResizeBilinear"},
+        "ResizeBilinear",
+        {"arg0", "Size:output:0"},
+        {{"T", DT_FLOAT}, {"half_pixel_centers", true}}}},
+      /*ret_def=*/{{"ret0", "ResizeBilinear:resized_images:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& resize_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("ResizeBilinear", *vectorized));
+  bool half_pixel_centers;
+  TF_ASSERT_OK(
+      GetNodeAttr(resize_node, "half_pixel_centers", &half_pixel_centers));
+  EXPECT_TRUE(half_pixel_centers);
+}
+
 }  // namespace
 }  // namespace vectorization_utils
 }  // namespace grappler
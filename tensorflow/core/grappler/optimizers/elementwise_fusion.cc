@@ -0,0 +1,265 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include <functional>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+
+// Returns the arities of the ops evaluated by the _FusedElementwise kernel.
+// Keep in sync with kernels/fused_elementwise_op.cc.
+const absl::flat_hash_map<string, int>& FusableOpArities() {
+  static const auto* arities = new absl::flat_hash_map<string, int>({
+      {"Abs", 1},     {"Exp", 1},     {"Log", 1},     {"Neg", 1},
+      {"Reciprocal", 1}, {"Inv", 1},  {"Relu", 1},    {"Rsqrt", 1},
+      {"Sigmoid", 1}, {"Sqrt", 1},    {"Square", 1},  {"Tanh", 1},
+      {"Add", 2},     {"AddV2", 2},   {"Sub", 2},     {"Mul", 2},
+      {"Div", 2},     {"RealDiv", 2}, {"Maximum", 2}, {"Minimum", 2},
+      {"SquaredDifference", 2},
+  });
+  return *arities;
+}
+
+bool IsKnownScalar(const OpInfo::TensorProperties& properties) {
+  return !properties.shape().unknown_rank() &&
+         properties.shape().dim_size() == 0;
+}
+
+// The nodes fused into a single _FusedElementwise node.
+struct FusedTree {
+  // The node computing the output, which becomes the fused node.
+  NodeDef* root;
+  // The other nodes, which are removed.
+  std::vector<const NodeDef*> absorbed_nodes;
+  std::vector<string> inputs;
+  std::vector<string> control_inputs;
+  std::vector<string> fused_ops;
+  std::vector<int> operands;
+};
+
+class ElementwiseFuser {
+ public:
+  ElementwiseFuser(const GrapplerItem& item, const GraphProperties& properties,
+                   GraphDef* graph)
+      : nodes_to_preserve_(item.NodesToPreserve()),
+        properties_(properties),
+        graph_(graph),
+        node_map_(graph) {}
+
+  // Fuses the trees of elementwise ops of the graph, and returns the number of
+  // fused trees.
+  int Fuse() {
+    std::vector<FusedTree> trees;
+    absl::flat_hash_set<const NodeDef*> absorbed;
+    // Visits the consumers before their inputs, so that each tree is found
+    // from its root.
+    for (int i = graph_->node_size() - 1; i >= 0; --i) {
+      NodeDef* node = graph_->mutable_node(i);
+      if (absorbed.contains(node) || !IsFusable(*node)) continue;
+      FusedTree tree;
+      tree.root = node;
+      BuildTree(node, &tree);
+      if (tree.fused_ops.size() < 2) continue;
+      absorbed.insert(tree.absorbed_nodes.begin(), tree.absorbed_nodes.end());
+      trees.push_back(std::move(tree));
+    }
+
+    std::set<string> nodes_to_delete;
+    for (const FusedTree& tree : trees) {
+      for (const NodeDef* node : tree.absorbed_nodes) {
+        nodes_to_delete.insert(node->name());
+      }
+      RewriteRoot(tree);
+    }
+    EraseNodesFromGraph(nodes_to_delete, graph_);
+    return trees.size();
+  }
+
+ private:
+  bool IsFusable(const NodeDef& node) const {
+    auto arity = FusableOpArities().find(node.op());
+    if (arity == FusableOpArities().end() || !NodeIsOnCpu(&node)) return false;
+    const AttrValue* type = AttrSlice(node).Find("T");
+    if (type == nullptr ||
+        (type->type() != DT_FLOAT && type->type() != DT_DOUBLE)) {
+      return false;
+    }
+    if (node.input_size() < arity->second) return false;
+    for (int i = 0; i < arity->second; ++i) {
+      if (IsControlInput(node.input(i))) return false;
+    }
+
+    // The kernel only broadcasts scalars.
+    if (!properties_.HasInputProperties(node.name()) ||
+        !properties_.HasOutputProperties(node.name())) {
+      return false;
+    }
+    const auto& outputs = properties_.GetOutputProperties(node.name());
+    if (outputs.size() != 1 || !ShapeIsSymbolicallyDefined(outputs[0])) {
+      return false;
+    }
+    const auto& inputs = properties_.GetInputProperties(node.name());
+    if (inputs.size() != arity->second) return false;
+    for (const OpInfo::TensorProperties& input : inputs) {
+      if (!IsKnownScalar(input) && !ShapesSymbolicallyEqual(input, outputs[0]))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns true if `fanin` can be evaluated as part of `consumer` in `tree`:
+  // its result is only consumed by `consumer`, and has the shape of the output.
+  bool CanAbsorb(const NodeDef& fanin, const NodeDef& consumer,
+                 const FusedTree& tree) const {
+    if (nodes_to_preserve_.count(fanin.name()) > 0 || !IsFusable(fanin) ||
+        fanin.device() != tree.root->device() ||
+        fanin.attr().at("T").type() != tree.root->attr().at("T").type()) {
+      return false;
+    }
+    for (const NodeDef* fanout : node_map_.GetOutputs(fanin.name())) {
+      if (fanout != &consumer) return false;
+    }
+    for (const string& input : consumer.input()) {
+      if (IsControlInput(input) && NodeName(input) == fanin.name()) {
+        return false;
+      }
+    }
+    return ShapesSymbolicallyEqual(
+        properties_.GetOutputProperties(fanin.name())[0],
+        properties_.GetOutputProperties(tree.root->name())[0]);
+  }
+
+  void BuildTree(const NodeDef* root, FusedTree* tree) {
+    absl::flat_hash_map<string, int> input_indices;
+    // Returns the operand of the result of `node`, as -1 - the index of its
+    // op, since the number of inputs is only known once the tree is built.
+    std::function<int(const NodeDef&)> add_node =
+        [&](const NodeDef& node) -> int {
+      const int arity = FusableOpArities().at(node.op());
+      std::vector<int> node_operands;
+      for (int i = 0; i < arity; ++i) {
+        const string& input = node.input(i);
+        const NodeDef* fanin = node_map_.GetNode(input);
+        if (fanin != nullptr && CanAbsorb(*fanin, node, *tree)) {
+          tree->absorbed_nodes.push_back(fanin);
+          node_operands.push_back(add_node(*fanin));
+          continue;
+        }
+        auto it = input_indices.emplace(input, tree->inputs.size()).first;
+        if (it->second == tree->inputs.size()) tree->inputs.push_back(input);
+        node_operands.push_back(it->second);
+      }
+      for (int i = arity; i < node.input_size(); ++i) {
+        tree->control_inputs.push_back(node.input(i));
+      }
+      tree->operands.insert(tree->operands.end(), node_operands.begin(),
+                            node_operands.end());
+      tree->fused_ops.push_back(node.op());
+      return -static_cast<int>(tree->fused_ops.size());
+    };
+    add_node(*root);
+
+    const int num_inputs = tree->inputs.size();
+    for (int& operand : tree->operands) {
+      if (operand < 0) operand = num_inputs - 1 - operand;
+    }
+  }
+
+  void RewriteRoot(const FusedTree& tree) {
+    NodeDef* root = tree.root;
+    const DataType type = root->attr().at("T").type();
+    root->set_op(kFusedElementwise);
+    root->clear_input();
+    for (const string& input : tree.inputs) root->add_input(input);
+    absl::flat_hash_set<string> control_inputs;
+    for (const string& input : tree.control_inputs) {
+      if (control_inputs.insert(input).second) root->add_input(input);
+    }
+
+    // Keeps the internal attributes, e.g. the colocation constraints.
+    for (auto it = root->mutable_attr()->begin();
+         it != root->mutable_attr()->end();) {
+      if (absl::StartsWith(it->first, "_")) {
+        ++it;
+      } else {
+        it = root->mutable_attr()->erase(it);
+      }
+    }
+    auto* attr = root->mutable_attr();
+    SetAttrValue(type, &(*attr)["T"]);
+    SetAttrValue(static_cast<int64>(tree.inputs.size()),
+                 &(*attr)["num_inputs"]);
+    SetAttrValue(tree.fused_ops, &(*attr)["fused_ops"]);
+    SetAttrValue(tree.operands, &(*attr)["operands"]);
+  }
+
+  const std::unordered_set<string> nodes_to_preserve_;
+  const GraphProperties& properties_;
+  GraphDef* graph_;
+  NodeMap node_map_;
+};
+
+}  // namespace
+
+Status ElementwiseFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                   GraphDef* optimized_graph) {
+  // Do a quick check to determine if we can skip this optimizer.
+  int num_fusable_ops = 0;
+  for (const NodeDef& node : item.graph.node()) {
+    if (FusableOpArities().contains(node.op()) && NodeIsOnCpu(&node)) {
+      ++num_fusable_ops;
+    }
+  }
+  if (num_fusable_ops < 2) return errors::Aborted("Nothing to do.");
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false,
+      /*aggressive_shape_inference=*/false,
+      /*include_input_tensor_values=*/false,
+      /*include_output_tensor_values=*/false));
+
+  *optimized_graph = item.graph;
+  TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
+  const int num_fused_trees =
+      ElementwiseFuser(item, properties, optimized_graph).Fuse();
+  if (num_fused_trees == 0) return errors::Aborted("Nothing to do.");
+  VLOG(1) << "Fused " << num_fused_trees << " trees of elementwise ops";
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,49 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuses the trees of elementwise ops on the CPU, e.g. Mul -> Add -> Tanh ->
+// Mul, into a single _FusedElementwise node, which evaluates them block by
+// block, so that the intermediate results are never written to memory.
+class ElementwiseFusion : public GraphOptimizer {
+ public:
+  ElementwiseFusion() {}
+  explicit ElementwiseFusion(RewriterConfig::Toggle opt_level) {}
+
+  ~ElementwiseFusion() override {}
+
+  string name() const override { return "elementwise_fusion"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
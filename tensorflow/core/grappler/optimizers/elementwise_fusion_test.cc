@@ -0,0 +1,128 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ElementwiseFusionTest : public GrapplerTest {};
+
+TEST_F(ElementwiseFusionTest, FusesTree) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({8, 100}));
+  auto y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                            ops::Placeholder::Shape({8, 100}));
+  auto half = ops::Const(s.WithOpName("half"), 0.5f, {});
+  auto mul = ops::Mul(s.WithOpName("mul"), x, y);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, x);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  auto scale = ops::Mul(s.WithOpName("scale"), tanh, half);
+  auto out = ops::Identity(s.WithOpName("out"), scale);
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mul");
+    EXPECT_NE(node.name(), "add");
+    EXPECT_NE(node.name(), "tanh");
+    if (node.name() == "scale") {
+      ++found;
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "y");
+      EXPECT_EQ(node.input(2), "half");
+      EXPECT_EQ(node.attr().at("num_inputs").i(), 3);
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      EXPECT_EQ(std::vector<string>(fused_ops.begin(), fused_ops.end()),
+                std::vector<string>({"Mul", "AddV2", "Tanh", "Mul"}));
+      const auto& operands = node.attr().at("operands").list().i();
+      EXPECT_EQ(std::vector<int64>(operands.begin(), operands.end()),
+                std::vector<int64>({0, 1, 3, 0, 4, 5, 2}));
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>(TensorShape({8, 100}));
+  auto y_t = GenerateRandomTensor<DT_FLOAT>(TensorShape({8, 100}));
+  auto expected =
+      EvaluateNodes(item.graph, item.fetch, {{"x", x_t}, {"y", y_t}});
+  auto tensors = EvaluateNodes(output, item.fetch, {{"x", x_t}, {"y", y_t}});
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], expected[0], 1e-6);
+}
+
+TEST_F(ElementwiseFusionTest, KeepsSharedAndFetchedResults) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4, 4}));
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+  auto abs = ops::Abs(s.WithOpName("abs"), exp);
+  auto sqrt = ops::Sqrt(s.WithOpName("sqrt"), abs);
+
+  GrapplerItem item;
+  item.fetch = {"neg", "abs", "sqrt"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // `exp` has two consumers, and `abs` is fetched.
+  ElementwiseFusion optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status)) << status;
+}
+
+TEST_F(ElementwiseFusionTest, SkipsBroadcasts) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4, 4}));
+  auto row = ops::Placeholder(s.WithOpName("row"), DT_FLOAT,
+                              ops::Placeholder::Shape({4}));
+  auto add = ops::Add(s.WithOpName("add"), x, row);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+
+  GrapplerItem item;
+  item.fetch = {"relu"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status)) << status;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 
+#include <cmath>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
@@ -24,6 +27,9 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
@@ -394,6 +400,166 @@ Status EraseOutputShapeAttrs(TransposeContext* context) {
   return Status::OK();
 }
 
+// Returns the rank of output `port` of `node`, or -1 if it is unknown.
+int GetOutputRank(const TransposeContext& context, const NodeDef& node,
+                  int port) {
+  const auto& outputs =
+      context.graph_properties->GetOutputProperties(node.name());
+  if (port >= outputs.size() || outputs[port].shape().unknown_rank()) {
+    return -1;
+  }
+  return outputs[port].shape().dim_size();
+}
+
+Costs::NanoSeconds PredictExecutionTime(const TransposeContext& context,
+                                        const OpLevelCostEstimator& estimator,
+                                        const NodeDef& node) {
+  OpContext op_context;
+  op_context.name = node.name();
+  op_context.op_info.set_op(node.op());
+  *op_context.op_info.mutable_attr() = node.attr();
+  for (const auto& input :
+       context.graph_properties->GetInputProperties(node.name())) {
+    *op_context.op_info.add_inputs() = input;
+  }
+  for (const auto& output :
+       context.graph_properties->GetOutputProperties(node.name())) {
+    *op_context.op_info.add_outputs() = output;
+  }
+  *op_context.op_info.mutable_device() =
+      context.virtual_placer->get_device(node);
+  return estimator.PredictCosts(op_context).execution_time;
+}
+
+// Predicts the execution time of transposing output `port` of `node`.
+Costs::NanoSeconds PredictTransposeTime(const TransposeContext& context,
+                                        const OpLevelCostEstimator& estimator,
+                                        const NodeDef& node, int port) {
+  const auto& tensor =
+      context.graph_properties->GetOutputProperties(node.name())[port];
+  OpContext op_context;
+  op_context.op_info.set_op("Transpose");
+  *op_context.op_info.add_inputs() = tensor;
+  OpInfo::TensorProperties* permutation = op_context.op_info.add_inputs();
+  permutation->set_dtype(DT_INT32);
+  permutation->mutable_shape()->add_dim()->set_size(tensor.shape().dim_size());
+  *op_context.op_info.add_outputs() = tensor;
+  *op_context.op_info.mutable_device() =
+      context.virtual_placer->get_device(node);
+  return estimator.PredictCosts(op_context).execution_time;
+}
+
+// Partitions the layout sensitive nodes to convert into regions, connected
+// through layout agnostic nodes, and keeps the nodes of a region in the source
+// format unless the kernel time saved in the destination format, declared by
+// the transposer factory, exceeds the time of the transposes added at the
+// boundary of the region.
+Status AssignDataFormatsByCost(TransposeContext* context,
+                               TransposerFactory* transposer_factory) {
+  utils::MutableGraphView* graph_view = context->graph_view.get();
+  const int num_nodes = graph_view->NumNodes();
+  auto is_region_node = [&](int index) {
+    const utils::MutableNodeView& node = *graph_view->GetNode(index);
+    const NodeDef& node_def = *node.node();
+    auto transposer = transposer_factory->GetTransposer(node_def);
+    if (transposer == nullptr || !transposer->ShouldProcess(*context, node)) {
+      return false;
+    }
+    return IsLayoutSensitiveOp(node_def) ||
+           GetOutputRank(*context, node_def, 0) == 4;
+  };
+  std::unique_ptr<OpLevelCostEstimator> estimator = NewOpLevelCostEstimator();
+
+  std::vector<int> regions(num_nodes, -1);
+  int num_regions = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (regions[i] >= 0 ||
+        !IsLayoutSensitiveOp(*graph_view->GetNode(i)->node()) ||
+        !is_region_node(i)) {
+      continue;
+    }
+    const int region = num_regions++;
+    std::vector<int> members = {i};
+    regions[i] = region;
+    for (int next = 0; next < members.size(); ++next) {
+      const auto* node = graph_view->GetNode(members[next]);
+      auto visit = [&](int index) {
+        if (regions[index] < 0 && is_region_node(index)) {
+          regions[index] = region;
+          members.push_back(index);
+        }
+      };
+      for (const auto& fanin : node->GetRegularFanins()) {
+        visit(fanin.node_index());
+      }
+      for (const auto& fanouts : node->GetRegularFanouts()) {
+        for (const auto& fanout : fanouts) visit(fanout.node_index());
+      }
+    }
+
+    bool is_required = false;
+    double saved_nanoseconds = 0;
+    double transpose_nanoseconds = 0;
+    for (int member : members) {
+      const auto* node = graph_view->GetNode(member);
+      const NodeDef& node_def = *node->node();
+      if (IsLayoutSensitiveOp(node_def)) {
+        const float src_time = TransposerFactory::GetRelativeKernelTime(
+            node_def, context->target_device, context->src_format);
+        const float dst_time = TransposerFactory::GetRelativeKernelTime(
+            node_def, context->target_device, context->dst_format);
+        if (std::isinf(src_time) && !std::isinf(dst_time)) {
+          is_required = true;
+          break;
+        }
+        if (src_time > dst_time) {
+          saved_nanoseconds +=
+              PredictExecutionTime(*context, *estimator, node_def).count() *
+              (src_time - dst_time) / dst_time;
+        }
+      }
+      for (int port : GetDataFaninPorts(*node)) {
+        const auto& fanin = node->GetRegularFanin(port);
+        if (regions[fanin.node_index()] != region &&
+            GetOutputRank(*context, *fanin.node_view()->node(),
+                          fanin.index()) == 4) {
+          transpose_nanoseconds +=
+              PredictTransposeTime(*context, *estimator,
+                                   *fanin.node_view()->node(), fanin.index())
+                  .count();
+        }
+      }
+      for (int port : GetDataFanoutPorts(*node)) {
+        if (port >= node->GetRegularFanouts().size() ||
+            GetOutputRank(*context, node_def, port) != 4) {
+          continue;
+        }
+        for (const auto& fanout : node->GetRegularFanout(port)) {
+          if (regions[fanout.node_index()] != region) {
+            transpose_nanoseconds +=
+                PredictTransposeTime(*context, *estimator, node_def, port)
+                    .count();
+            break;
+          }
+        }
+      }
+    }
+    if (is_required || saved_nanoseconds > transpose_nanoseconds) continue;
+
+    VLOG(2) << "Keeping a region of " << members.size() << " nodes in "
+            << context->src_format << ": converting it would save "
+            << saved_nanoseconds << "ns of kernel time, and add "
+            << transpose_nanoseconds << "ns of transposes";
+    for (int member : members) {
+      const NodeDef& node_def = *graph_view->GetNode(member)->node();
+      if (IsLayoutSensitiveOp(node_def)) {
+        context->nodes_in_src_format.insert(node_def.name());
+      }
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 // When there is a GPU, the computation graph is converted to NCHW format.
@@ -414,6 +580,7 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   const bool is_aggressive = opt_level_ == RewriterConfig::AGGRESSIVE;
 
   TransposeContext context;
+  bool assign_data_formats_by_cost = false;
   if (num_gpus > 0) {
     TF_RETURN_IF_ERROR(
         TransposeContext::InitializeTransposeContext(item, cluster, &context));
@@ -429,6 +596,12 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
       case RewriterConfig::NCHW_TO_NHWC:
         context.AssignDeviceAndDataFormats(kCPU, kNCHW, kNHWC);
         break;
+      // The CPU kernels are never faster in NCHW, so only the regions in NCHW
+      // may be worth converting.
+      case RewriterConfig::COST_BASED_ON_CPU:
+        context.AssignDeviceAndDataFormats(kCPU, kNCHW, kNHWC);
+        assign_data_formats_by_cost = true;
+        break;
       // TODO(intel-tf): Add functionality for NHWC_TO_NCHW layout conversion on
       // CPU.
       case RewriterConfig::NHWC_TO_NCHW:
@@ -443,6 +616,9 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   }
 
   TransposerFactory transposer_factory;
+  if (assign_data_formats_by_cost) {
+    TF_RETURN_IF_ERROR(AssignDataFormatsByCost(&context, &transposer_factory));
+  }
   TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(&context, &transposer_factory));
   if (context.graph.node_size() > context.num_nodes || is_aggressive) {
     TF_RETURN_IF_ERROR(ExpandLayoutAgnosticOp(&context, &transposer_factory));
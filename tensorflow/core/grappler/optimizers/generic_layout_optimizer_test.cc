@@ -357,6 +357,45 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
 #endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
 }
 
+TEST_F(GenericLayoutOptimizerTest, CostBasedOnCPU) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "Layouts are only assigned by cost on CPU-only clusters";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/CPU:0");
+  // The CPU kernel of Conv2D requires NHWC.
+  auto conv = SimpleConv2D(&s, 4, 2, "VALID", "/CPU:0");
+  Output conv_fetch = ops::Identity(s.WithOpName("ConvFetch"), {conv});
+  // The CPU kernel of BiasAdd runs as fast in NCHW, so converting it would
+  // only add transposes.
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 3, 4, 4}));
+  Output bias = ops::Const(s.WithOpName("bias"), {1.0f, 2.0f, 3.0f}, {3});
+  Output bias_add =
+      ops::BiasAdd(s.WithOpName("BiasAdd"), x, bias,
+                   ops::BiasAdd::Attrs().DataFormat("NCHW"));
+  Output bias_add_fetch =
+      ops::Identity(s.WithOpName("BiasAddFetch"), {bias_add});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"ConvFetch", "BiasAddFetch"};
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::COST_BASED_ON_CPU);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+
+  Status status;
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NHWC");
+  auto* bias_add_node = graph_view.GetNode("BiasAdd");
+  ASSERT_NE(bias_add_node, nullptr);
+  VerifyDataFormatAttributeMatch(bias_add_node, "NCHW");
+  VerifyRegularFaninMatch(bias_add_node, 0, "x", 0);
+}
+
 TEST_F(GenericLayoutOptimizerTest, NoOptimizeIntegerConvolution) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto conv = SimpleConv2D<int32>(&s, 4, 2, "VALID", "");
@@ -67,6 +67,9 @@ struct TransposeContext {
   // to this.
   int num_nodes;
   absl::flat_hash_set<string> nodes_to_preserve;
+  // Layout sensitive nodes which are cheaper to run in the source format,
+  // including the transposes around them.
+  absl::flat_hash_set<string> nodes_in_src_format;
   std::unique_ptr<GraphProperties> graph_properties;
   std::unique_ptr<utils::MutableGraphView> graph_view;
   std::unique_ptr<const VirtualPlacer> virtual_placer;
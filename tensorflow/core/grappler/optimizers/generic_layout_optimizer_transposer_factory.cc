@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer_factory.h"
 
+#include <limits>
+
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/grappler/op_types.h"
 
 namespace tensorflow {
@@ -142,5 +145,34 @@ std::shared_ptr<Transposer> TransposerFactory::GetTransposer(
   return nullptr;
 }
 
+float TransposerFactory::GetRelativeKernelTime(const NodeDef& node,
+                                               absl::string_view device_type,
+                                               absl::string_view data_format) {
+#ifndef INTEL_MKL
+  const bool is_channels_first =
+      data_format.size() > 1 && data_format[1] == 'C';
+  if (device_type == kCPU && is_channels_first) {
+    // The Eigen kernels only support NHWC and NDHWC.
+    static const auto* channels_last_ops = new absl::flat_hash_set<string>(
+        {"AvgPool", "AvgPoolGrad", "Conv2D", "Conv2DBackpropFilter",
+         "Conv2DBackpropInput", "Conv3D", "Conv3DBackpropFilterV2",
+         "Conv3DBackpropInputV2", "DepthToSpace", "DepthwiseConv2dNative",
+         "DepthwiseConv2dNativeBackpropFilter",
+         "DepthwiseConv2dNativeBackpropInput", "MaxPool", "MaxPoolGrad",
+         "MaxPoolGradGrad", "MaxPoolGradGradV2", "MaxPoolGradV2", "MaxPoolV2",
+         "SpaceToDepth"});
+    if (channels_last_ops->contains(node.op())) {
+      return std::numeric_limits<float>::infinity();
+    }
+    // The batch norm kernels transpose their NCHW inputs and outputs.
+    if (IsFusedBatchNorm(node) || IsFusedBatchNormEx(node) ||
+        IsFusedBatchNormGrad(node)) {
+      return 3.0f;
+    }
+  }
+#endif  // !INTEL_MKL
+  return 1.0f;
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
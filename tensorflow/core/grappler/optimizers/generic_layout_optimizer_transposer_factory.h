@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
 
 namespace tensorflow {
@@ -30,6 +31,14 @@ class TransposerFactory {
 
   std::shared_ptr<Transposer> GetTransposer(const NodeDef& node);
 
+  // Returns the execution time of the kernel of the layout sensitive `node` on
+  // `device_type` in `data_format`, relative to its execution time in the
+  // fastest data format, or infinity if the kernel doesn't support
+  // `data_format`.
+  static float GetRelativeKernelTime(const NodeDef& node,
+                                     absl::string_view device_type,
+                                     absl::string_view data_format);
+
  protected:
   template <typename T>
   std::shared_ptr<Transposer> GetOrCreateIfNotFound(const string& key) {
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <memory>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -23,6 +24,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
@@ -30,6 +32,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -37,10 +41,12 @@ limitations under the License.
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
@@ -440,9 +446,145 @@ void RecomputeSubgraph(
   }
 }
 
+int64 KnownTensorSize(const OpInfo::TensorProperties& properties) {
+  const TensorShapeProto& shape = properties.shape();
+  if (shape.unknown_rank()) return 0;
+  int64 num_elements = 1;
+  for (const auto& dim : shape.dim()) {
+    if (dim.size() < 0) return 0;
+    num_elements *= dim.size();
+  }
+  return num_elements * DataTypeSize(properties.dtype());
+}
+
+Costs::NanoSeconds PredictComputeTime(
+    const NodeDef& node, const GraphProperties& properties,
+    const std::unordered_map<string, const NodeDef*>& name_to_node,
+    const OpLevelCostEstimator& estimator) {
+  OpContext op_context;
+  op_context.name = node.name();
+  op_context.device_name = node.device();
+  op_context.op_info = BuildOpInfoWithoutDevice(
+      node, name_to_node, properties.GetInputProperties(node.name()));
+  for (const auto& output : properties.GetOutputProperties(node.name())) {
+    *op_context.op_info.add_outputs() = output;
+  }
+  *op_context.op_info.mutable_device() = GetDeviceInfo(node.device());
+  return estimator.PredictCosts(op_context).compute_time;
+}
+
+// Keeps the subgraphs which add the least compute time per byte of the
+// activations they no longer keep alive until the targets run, until they
+// free the memory used beyond `budget_bytes` at the peak estimated by
+// GraphMemory. Keeps none of them if the peak is within the budget, and all of
+// them if it can't be estimated.
+void SelectRecomputationsWithinBudget(
+    const GrapplerItem& item, Cluster* cluster, int64 budget_bytes,
+    std::vector<RecomputedSubGraph>* subgraphs) {
+  if (subgraphs->empty()) return;
+  if (cluster == nullptr) {
+    VLOG(1) << "No cluster to estimate the peak memory with, recomputing "
+               "every candidate subgraph";
+    return;
+  }
+  GraphMemory memory(item);
+  Status status = memory.InferStatically(cluster->GetDevices());
+  if (!status.ok() || memory.GetWorstCaseMemoryUsage() < 0) {
+    VLOG(1) << "Failed to estimate the peak memory, recomputing every "
+               "candidate subgraph: "
+            << status;
+    return;
+  }
+  const int64 excess_bytes = memory.GetWorstCaseMemoryUsage() - budget_bytes;
+  if (excess_bytes <= 0) {
+    VLOG(1) << "The estimated peak memory of "
+            << memory.GetWorstCaseMemoryUsage()
+            << " bytes is within the recomputation budget";
+    subgraphs->clear();
+    return;
+  }
+
+  GraphProperties properties(item);
+  if (!properties
+           .InferStatically(/*assume_valid_feeds=*/false,
+                            /*aggressive_shape_inference=*/false,
+                            /*include_input_tensor_values=*/false,
+                            /*include_output_tensor_values=*/false)
+           .ok()) {
+    return;
+  }
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  std::unique_ptr<OpLevelCostEstimator> estimator = NewOpLevelCostEstimator();
+
+  struct Candidate {
+    int subgraph;
+    double nanoseconds_per_byte;
+    int64 freed_bytes;
+  };
+  std::vector<Candidate> candidates;
+  for (int i = 0; i < subgraphs->size(); ++i) {
+    const RecomputedSubGraph& subgraph = (*subgraphs)[i];
+    std::unordered_set<string> source_nodes;
+    double compute_nanoseconds = 0;
+    for (const NodeDef* node : subgraph.recomputed_source_nodes) {
+      source_nodes.insert(node->name());
+      if (properties.HasInputProperties(node->name())) {
+        compute_nanoseconds +=
+            PredictComputeTime(*node, properties, name_to_node, *estimator)
+                .count();
+      }
+    }
+    // The activations read by the targets are freed by the forward pass once
+    // the targets read their recomputed copies instead.
+    std::unordered_set<string> activations;
+    int64 freed_bytes = 0;
+    for (const NodeDef* target : subgraph.target_nodes) {
+      for (const string& input : target->input()) {
+        const TensorId tensor = ParseTensorName(input);
+        const string node_name(tensor.node());
+        if (IsControlInput(input) || source_nodes.count(node_name) == 0 ||
+            !activations.insert(tensor.ToString()).second ||
+            !properties.HasOutputProperties(node_name)) {
+          continue;
+        }
+        const auto& outputs = properties.GetOutputProperties(node_name);
+        if (tensor.index() < outputs.size()) {
+          freed_bytes += KnownTensorSize(outputs[tensor.index()]);
+        }
+      }
+    }
+    if (freed_bytes > 0) {
+      candidates.push_back(
+          {i, compute_nanoseconds / freed_bytes, freed_bytes});
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.nanoseconds_per_byte < b.nanoseconds_per_byte;
+            });
+
+  std::vector<RecomputedSubGraph> selected_subgraphs;
+  int64 freed_bytes = 0;
+  for (const Candidate& candidate : candidates) {
+    if (freed_bytes >= excess_bytes) break;
+    selected_subgraphs.push_back((*subgraphs)[candidate.subgraph]);
+    freed_bytes += candidate.freed_bytes;
+  }
+  VLOG(1) << "Recomputing " << selected_subgraphs.size() << " of "
+          << subgraphs->size() << " candidate subgraphs to free " << freed_bytes
+          << " of the " << excess_bytes
+          << " bytes used beyond the recomputation budget";
+  subgraphs->swap(selected_subgraphs);
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
-                                GraphDef* graph, const GrapplerItem& item) {
+                                int64 recomputation_budget_bytes,
+                                Cluster* cluster, GraphDef* graph,
+                                const GrapplerItem& item) {
   // The topological numberings and NodeMap will be stale as soon as we start
   // modifying the graph in RecomputeSubgraph. However, RecomputeSubgraph only
   // looks up nodes which were in the original graph, and preserves the graph
@@ -488,6 +630,11 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                   node.attr().count(kRecomputeHint) > 0);
         },
         is_target);
+    if (recomputation_budget_bytes > 0) {
+      SelectRecomputationsWithinBudget(item, cluster,
+                                       recomputation_budget_bytes,
+                                       &recomputed_subgraphs);
+    }
   } else if (optimization_level == RewriterConfig::MANUAL) {
     recomputed_subgraphs = GetOpGroupsToRecompute(
         graph, node_map,
@@ -1376,6 +1523,182 @@ Status FindAssignNodesToRelax(const GraphDef& graph,
   return Status::OK();
 }
 
+// The elementwise ops whose kernels allocate their output with
+// forward_input_or_allocate_output() from any of their inputs of the shape of
+// the output, and may thus be told which input buffer to reuse.
+bool IsBufferReusingOp(const NodeDef& node) {
+#ifdef INTEL_MKL
+  // The MKL layout pass rewrites some of these ops into kernels which always
+  // allocate their output.
+  return false;
+#else
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"Abs", "Add", "AddV2", "Div", "Exp", "Log", "Maximum", "Minimum", "Mul",
+       "Neg", "RealDiv", "Reciprocal", "Rsqrt", "Sigmoid", "Sqrt", "Square",
+       "SquaredDifference", "Sub", "Tanh"});
+  if (ops->find(node.op()) == ops->end()) return false;
+  const DataType type = GetDataTypeFromAttr(node, "T");
+  return (type == DT_HALF || type == DT_BFLOAT16 || type == DT_FLOAT ||
+          type == DT_DOUBLE) &&
+         (NodeIsOnCpu(&node) || NodeIsOnGpu(&node));
+#endif  // INTEL_MKL
+}
+
+// Returns the peak of the memory used by the tensors of the topologically
+// sorted `graph` when its nodes run in order, assuming that each tensor is
+// freed once its last consumer ran, and that the output 0 of the nodes of
+// `reused_inputs` is written in the buffer of the given input. The tensors of
+// unknown sizes are ignored.
+int64 EstimatePeakMemory(
+    const GraphDef& graph, const GraphProperties& properties,
+    const std::unordered_set<string>& nodes_to_preserve,
+    const std::unordered_map<const NodeDef*, int>& reused_inputs) {
+  std::unordered_map<string, int> last_use;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    for (const string& input : graph.node(i).input()) {
+      if (!IsControlInput(input)) {
+        const TensorId tensor = ParseTensorName(input);
+        last_use[strings::StrCat(tensor.node(), ":", tensor.index())] = i;
+      }
+    }
+  }
+  // The size of the buffers held by the live tensors.
+  std::unordered_map<string, int64> live_tensors;
+  int64 used_memory = 0;
+  int64 peak_memory = 0;
+  const std::vector<OpInfo::TensorProperties> no_outputs;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    const NodeDef& node = graph.node(i);
+    const auto& outputs = properties.HasOutputProperties(node.name())
+                              ? properties.GetOutputProperties(node.name())
+                              : no_outputs;
+    auto reused_input = reused_inputs.find(&node);
+    for (int port = 0; port < outputs.size(); ++port) {
+      const string output = strings::StrCat(node.name(), ":", port);
+      if (last_use.find(output) == last_use.end() &&
+          nodes_to_preserve.find(node.name()) == nodes_to_preserve.end()) {
+        continue;
+      }
+      if (port == 0 && reused_input != reused_inputs.end()) {
+        // Takes the buffer of the input, which is dead.
+        const TensorId tensor =
+            ParseTensorName(node.input(reused_input->second));
+        auto it = live_tensors.find(
+            strings::StrCat(tensor.node(), ":", tensor.index()));
+        if (it != live_tensors.end()) {
+          live_tensors[output] = it->second;
+          live_tensors.erase(it);
+          continue;
+        }
+      }
+      const int64 size = KnownTensorSize(outputs[port]);
+      live_tensors[output] = size;
+      used_memory += size;
+    }
+    peak_memory = std::max(peak_memory, used_memory);
+
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) continue;
+      const TensorId tensor = ParseTensorName(input);
+      const string name = strings::StrCat(tensor.node(), ":", tensor.index());
+      auto it = live_tensors.find(name);
+      if (it != live_tensors.end() && last_use[name] == i &&
+          nodes_to_preserve.find(string(tensor.node())) ==
+              nodes_to_preserve.end()) {
+        used_memory -= it->second;
+        live_tensors.erase(it);
+      }
+    }
+  }
+  return peak_memory;
+}
+
+// Reserves, for the output of the elementwise ops, the buffer of an input
+// which they are the only consumer of, so that the executor writes the output
+// in place instead of allocating a new buffer. The input must be produced by
+// an elementwise op as well: its buffer is then never shared with another
+// tensor, e.g. a constant, which the reservation would not detect, since the
+// executor honors it without checking the reference count of the buffer.
+bool BufferReusePass(GrapplerItem* item) {
+  GraphDef* graph = &item->graph;
+  // The previous reservations, which the graph may no longer allow since it
+  // was rewritten by other optimizers, are planned again.
+  bool updated_graph = false;
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (IsBufferReusingOp(node) && node.attr().count("_forward_input") > 0) {
+      node.mutable_attr()->erase("_forward_input");
+      updated_graph = true;
+    }
+  }
+
+  if (!TopologicalSort(graph).ok()) return updated_graph;
+  GraphProperties properties(*item);
+  if (!properties
+           .InferStatically(/*assume_valid_feeds=*/false,
+                            /*aggressive_shape_inference=*/false,
+                            /*include_input_tensor_values=*/false,
+                            /*include_output_tensor_values=*/false)
+           .ok()) {
+    return updated_graph;
+  }
+  const std::unordered_set<string> nodes_to_preserve = item->NodesToPreserve();
+  NodeMap node_map(graph);
+
+  std::unordered_map<const NodeDef*, int> reused_inputs;
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (!IsBufferReusingOp(node) ||
+        node.attr().count("_scoped_allocator") > 0 ||
+        !properties.HasInputProperties(node.name()) ||
+        !properties.HasOutputProperties(node.name())) {
+      continue;
+    }
+    const auto& inputs = properties.GetInputProperties(node.name());
+    const auto& outputs = properties.GetOutputProperties(node.name());
+    if (outputs.size() != 1 || !ShapeIsSymbolicallyDefined(outputs[0])) {
+      continue;
+    }
+    for (int i = 0; i < inputs.size() && i < node.input_size(); ++i) {
+      const TensorId tensor = ParseTensorName(node.input(i));
+      const NodeDef* producer = node_map.GetNode(node.input(i));
+      if (tensor.index() != 0 || producer == nullptr ||
+          !IsBufferReusingOp(*producer) ||
+          nodes_to_preserve.find(producer->name()) != nodes_to_preserve.end() ||
+          producer->device() != node.device() ||
+          inputs[i].dtype() != outputs[0].dtype() ||
+          !ShapesSymbolicallyEqual(inputs[i], outputs[0])) {
+        continue;
+      }
+      // The buffer must only be read by this input of the node.
+      const auto& fanouts = node_map.GetOutputs(producer->name());
+      int num_reads = 0;
+      for (const string& input : node.input()) {
+        if (!IsControlInput(input) && NodeName(input) == producer->name()) {
+          ++num_reads;
+        }
+      }
+      if (fanouts.size() != 1 || num_reads != 1) continue;
+
+      SetAttrValue(std::vector<int>({i, 0}),
+                   &(*node.mutable_attr())["_forward_input"]);
+      reused_inputs[&node] = i;
+      updated_graph = true;
+      break;
+    }
+  }
+
+  if (VLOG_IS_ON(1) && !reused_inputs.empty()) {
+    VLOG(1) << "Reserved " << reused_inputs.size()
+            << " input buffers for outputs, lowering the estimated peak memory "
+               "from "
+            << EstimatePeakMemory(*graph, properties, nodes_to_preserve, {})
+            << " to "
+            << EstimatePeakMemory(*graph, properties, nodes_to_preserve,
+                                  reused_inputs)
+            << " bytes";
+  }
+  return updated_graph;
+}
+
 }  // namespace
 
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1387,7 +1710,10 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
        optimization_level_ == RewriterConfig::HEURISTICS ||
        optimization_level_ == RewriterConfig::MANUAL);
-  if (!run_recomputation_pass && nodes_to_relax.empty() && item.fetch.empty()) {
+  bool run_buffer_reuse_pass =
+      optimization_level_ == RewriterConfig::BUFFER_REUSE_HEURISTICS;
+  if (!run_recomputation_pass && !run_buffer_reuse_pass &&
+      nodes_to_relax.empty() && item.fetch.empty()) {
     return errors::Aborted("Nothing to do.");
   }
 
@@ -1395,9 +1721,9 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   RelaxAssignNodes(nodes_to_relax, &optimized_item.graph);
 
   if (run_recomputation_pass) {
-    RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
-                               &optimized_item.graph, item);
+    RecomputationRewritingPass(
+        optimization_level_, recomputation_targets_name_scope_,
+        recomputation_budget_bytes_, cluster, &optimized_item.graph, item);
   }
 
   std::unordered_set<string> skip_list;
@@ -1438,6 +1764,12 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
   }
 
+  // Runs last, since the other passes rewire the inputs of the nodes.
+  if (run_buffer_reuse_pass) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    BufferReusePass(&optimized_item);
+  }
+
   optimized_graph->Swap(&optimized_item.graph);
   return Status::OK();
 }
@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -448,6 +449,45 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, RecomputationBudget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/cpu:0");
+  Output a = ops::Variable(s.WithOpName("a"), {128, 128}, DT_FLOAT);
+  Output b = ops::Relu(s.WithOpName("b"), a);
+  Output c = ops::Square(s.WithOpName("c"), b);
+  Output d = ops::AddN(s.WithOpName("gradients/d"), {c});
+  Output e = ops::AddN(s.WithOpName("gradients/e"), {d, b});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  auto count_recomputed_nodes = [](const GraphDef& graph) {
+    int count = 0;
+    for (const NodeDef& node : graph.node()) {
+      if (absl::StartsWith(node.name(), "Recomputed/")) ++count;
+    }
+    return count;
+  };
+
+  // The peak memory is within the budget.
+  MemoryOptimizer within_budget(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                                "gradients/",
+                                /*recomputation_budget_bytes=*/1LL << 30);
+  GraphDef output;
+  TF_EXPECT_OK(within_budget.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(0, count_recomputed_nodes(output));
+
+  MemoryOptimizer over_budget(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                              "gradients/",
+                              /*recomputation_budget_bytes=*/1);
+  TF_EXPECT_OK(over_budget.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(2, count_recomputed_nodes(output));
+  NodeMap node_map(&output);
+  EXPECT_EQ("Recomputed/b", node_map.GetNode("gradients/e")->input(1));
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -644,6 +684,69 @@ TEST_F(RelaxAllocatorConstraintsTest, AssignNodeInFanout) {
 #endif
 }
 
+class BufferReuseTest : public GrapplerTest {};
+
+TEST_F(BufferReuseTest, ReusesDeadInputs) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({16, 16}));
+  Output c = ops::Const(s.WithOpName("c"), 2.0f, {16, 16});
+  // The buffer of `x` is fed, and the one of `c` is the constant.
+  Output exp = ops::Exp(s.WithOpName("exp"), x);
+  Output mul = ops::Mul(s.WithOpName("mul"), c, exp);
+  // `mul` has two consumers.
+  Output tanh = ops::Tanh(s.WithOpName("tanh"), mul);
+  Output sub = ops::Sub(s.WithOpName("sub"), tanh, mul);
+  Output neg = ops::Neg(s.WithOpName("neg"), sub);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"neg"};
+
+  MemoryOptimizer optimizer(RewriterConfig::BUFFER_REUSE_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  std::unordered_map<string, std::vector<int>> forward_inputs;
+  for (const NodeDef& node : output.node()) {
+    if (node.attr().count("_forward_input") > 0) {
+      const auto& list = node.attr().at("_forward_input").list().i();
+      forward_inputs[node.name()] = std::vector<int>(list.begin(), list.end());
+    }
+  }
+  EXPECT_EQ(forward_inputs.size(), 3);
+  EXPECT_EQ(forward_inputs["mul"], std::vector<int>({1, 0}));
+  EXPECT_EQ(forward_inputs["sub"], std::vector<int>({0, 0}));
+  EXPECT_EQ(forward_inputs["neg"], std::vector<int>({0, 0}));
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>(TensorShape({16, 16}));
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, {{"x", x_t}});
+  auto tensors = EvaluateNodes(output, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(BufferReuseTest, KeepsFetchedInputs) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({16, 16}));
+  Output exp = ops::Exp(s.WithOpName("exp"), x);
+  Output log = ops::Log(s.WithOpName("log"), exp);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"exp", "log"};
+
+  MemoryOptimizer optimizer(RewriterConfig::BUFFER_REUSE_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    EXPECT_EQ(node.attr().count("_forward_input"), 0) << node.name();
+  }
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -36,12 +37,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/pipeline_parallel.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/shape_optimizer.h"
@@ -51,8 +55,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -90,7 +97,8 @@ int NumIterations(const RewriterConfig& cfg) {
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
          name == "loop_optimizer" || name == "auto_mixed_precision" ||
-         name == "auto_mixed_precision_mkl";
+         name == "auto_mixed_precision_mkl" ||
+         name == "auto_mixed_precision_cpu";
 }
 
 // Creates a function library stub from a real function library: copy only
@@ -187,6 +195,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
              cfg_.experimental_disable_compressed_tensor_optimization()));
   MK_OPT("shape", new ShapeOptimizer());
   MK_OPT("remap", new Remapper(cfg_.remapping()));
+  MK_OPT("elementwise_fusion",
+         new ElementwiseFusion(cfg_.elementwise_fusion()));
   MK_OPT("layout", new GenericLayoutOptimizer(
                        /*optimization level*/ cfg_.layout_optimizer(),
                        /*CPU layout conversion*/ cfg_.cpu_layout_conversion()));
@@ -194,11 +204,16 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new AutoMixedPrecision(AutoMixedPrecisionMode::CUDA));
   MK_OPT("auto_mixed_precision_mkl",
          new AutoMixedPrecision(AutoMixedPrecisionMode::MKL));
+  MK_OPT("auto_mixed_precision_cpu",
+         new AutoMixedPrecision(AutoMixedPrecisionMode::CPU));
   MK_OPT("memory", new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination",
          new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
   MK_OPT("arithmetic", new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", new AutoParallel(cfg_.auto_parallel().num_replicas()));
+  MK_OPT("pipeline_parallel",
+         new PipelineParallel(cfg_.pipeline_parallel().num_stages(),
+                              cfg_.pipeline_parallel().num_micro_batches()));
   MK_OPT("loop", new LoopOptimizer(cfg_.loop_optimization(), cpu_device_));
   MK_OPT("dependency", new DependencyOptimizer(cfg_.dependency_optimization()));
   MK_OPT("debug_stripper", new DebugStripper());
@@ -261,6 +276,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::MKL));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())) {
+    optimizers->push_back(
+        MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU));
+  }
   if (cfg_.pin_to_host_optimization() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   }
@@ -276,6 +295,10 @@ Status MetaOptimizer::InitializeOptimizers(
   if (cfg_.remapping() != RewriterConfig::OFF) {
     optimizers->push_back(MakeUnique<Remapper>(cfg_.remapping()));
   }
+  if (cfg_.elementwise_fusion() == RewriterConfig::ON) {
+    optimizers->push_back(
+        MakeUnique<ElementwiseFusion>(cfg_.elementwise_fusion()));
+  }
   if (cfg_.loop_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
         MakeUnique<LoopOptimizer>(cfg_.loop_optimization(), cpu_device_));
@@ -287,20 +310,24 @@ Status MetaOptimizer::InitializeOptimizers(
   auto global_jit_level =
       config_proto_.graph_options().optimizer_options().global_jit_level();
   if (MemoryOptimizerEnabled(cfg_.memory_optimization(), global_jit_level)) {
-    if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->push_back(
-          // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
-    } else {
-      optimizers->push_back(MakeUnique<MemoryOptimizer>(
-          cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
-    }
+    // Use the default target node name prefix "gradients/" if none is set.
+    const string recomputation_targets_name_scope =
+        cfg_.memory_optimizer_target_node_name_scope().empty()
+            ? "gradients/"
+            : cfg_.memory_optimizer_target_node_name_scope();
+    optimizers->push_back(MakeUnique<MemoryOptimizer>(
+        cfg_.memory_optimization(), recomputation_targets_name_scope,
+        cfg_.memory_optimizer_recomputation_budget_bytes()));
   }
   if (cfg_.auto_parallel().enable()) {
     optimizers->push_back(
         MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas()));
   }
+  if (cfg_.pipeline_parallel().enable()) {
+    optimizers->push_back(MakeUnique<PipelineParallel>(
+        cfg_.pipeline_parallel().num_stages(),
+        cfg_.pipeline_parallel().num_micro_batches()));
+  }
   if (cfg_.scoped_allocator_optimization()) {
     optimizers->push_back(MakeUnique<ScopedAllocatorOptimizer>(
         cfg_.scoped_allocator_optimization(), cfg_.scoped_allocator_opts()));
@@ -396,8 +423,9 @@ void MetaOptimizer::InitializeVerifiers(
   }
 }
 
-Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                                    GraphDef* optimized_graph) {
+Status MetaOptimizer::OptimizeGraph(
+    Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) const {
   int min_graph_nodes = cfg_.min_graph_nodes() == 0 ? kDefaultMinGraphNodes
                                                     : cfg_.min_graph_nodes();
   if (item.graph.node_size() < min_graph_nodes) {
@@ -529,7 +557,7 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  optimization_results->push_back(optimization_result);
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -546,7 +574,8 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
 
 Status MetaOptimizer::RunOptimizer(
     GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
-    GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
+    GraphDef* optimized_graph,
+    GraphOptimizationResult* optimization_result) const {
   const uint64 start_us = Env::Default()->NowMicros();
 
   // If optimizer doesn't need a function library, we will replace it with a
@@ -703,7 +732,8 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   const auto producer = item.graph.versions().producer();
 
   // 1. Optimize main graph
-  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph));
+  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph,
+                                   &optimization_results_));
   VLOG(1) << "Optimized main graph.";
   GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
@@ -780,13 +810,15 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
+  // Optimizes the independent functions concurrently, created on first use.
+  std::unique_ptr<thread::ThreadPool> thread_pool;
   while (optimize_function_library) {
     optimize_function_library = false;
 
-    int function_idx = 0;
+    // The library of the optimized graph is only updated after the pass, so
+    // the functions stay valid.
+    std::vector<const FunctionDef*> funcs;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -806,87 +838,157 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // and in function instantiation.
       if (data::IsTFDataFunction(func)) continue;
 
-      VLOG(3) << "Optimize function: function=" << func_name << " ["
-              << function_idx++ << " of "
-              << optimized_graph->library().function_size() << "]";
-
       // Function optimization might specialize nested function calls, so we
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    // Functions are optimized in the library order, and see the optimized
+    // bodies of the functions they call that precede them. Groups them into
+    // waves, such that a function only calls functions of earlier waves among
+    // the preceding ones, so that the functions of a wave are independent and
+    // can be optimized concurrently, with the same result.
+    std::vector<std::vector<const FunctionDef*>> waves;
+    absl::flat_hash_map<string, int> func_waves;
+    for (const FunctionDef* func : funcs) {
+      int wave = 0;
+      for (const string& callee :
+           flib.ReachableDefinitions(*func).ListFunctionNames()) {
+        const int* callee_wave = gtl::FindOrNull(func_waves, callee);
+        if (callee_wave != nullptr) wave = std::max(wave, *callee_wave + 1);
       }
+      func_waves[func->signature().name()] = wave;
+      if (wave == waves.size()) waves.emplace_back();
+      waves[wave].push_back(func);
+    }
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+    int function_idx = 0;
+    for (const std::vector<const FunctionDef*>& wave : waves) {
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+      std::vector<GrapplerFunctionItem> func_items(wave.size());
+      for (int i = 0; i < wave.size(); ++i) {
+        const FunctionDef& func = *wave[i];
+        const string& func_name = func.signature().name();
+        VLOG(3) << "Optimize function: function=" << func_name << " ["
+                << function_idx++ << " of "
+                << optimized_graph->library().function_size() << "]";
+
+        // Make a GrapplerItem from a FunctionDef.
+        GrapplerFunctionItem& func_item = func_items[i];
+        TF_RETURN_IF_ERROR(
+            MakeGrapplerFunctionItem(func, flib, producer, &func_item));
+
+        // If we need to compute the gradient of optimized function at runtime,
+        // we can't perform non-differentiable rewrites.
+        func_item.optimization_options().allow_non_differentiable_rewrites =
+            !differentiable_functions.contains(func_name);
+
+        // Device set available to the function is defined only by the runtime,
+        // when we instantiate and execute the function. We can't use all
+        // devices available to the main graph, because after partitioning the
+        // function call node might execute on a remote worker.
+        if (!func_item.devices().empty()) {
+          return errors::Internal(
+              "GrapplerFunctionItem devices must be empty.");
+        }
+
+        // We are not allowed to prune certain types of ops from the graph
+        // instantiated by the function definition, because we must guarantee
+        // function execution semantics wrt side effects (see
+        // function_optimizer.cc).
+        func_item.optimization_options()
+            .allow_pruning_stateful_and_dataset_ops = false;
       }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      // Optimize function body graphs.
+      std::vector<GraphDef> optimized_func_graphs(wave.size());
+      std::vector<std::vector<GraphOptimizationResult>> func_results(
+          wave.size());
+      std::vector<Status> statuses(wave.size());
+      const auto optimize_function = [&](int i) {
+        GrapplerFunctionItem& func_item = func_items[i];
+        if (is_tpu_graph) {
+          // Skip optimizing functions if this is a TPU graph. Currently,
+          // Grappler passes do not handle TPU functions correctly in a variety
+          // of ways (Note that due to the pre-placement TPU graph rewriting
+          // passes, the TPU-related ops are encapsulated away into functions).
+          // For example, TPU graphs contain TPUReplicateMetadata node that
+          // carries relevant TPU metadata and Grappler passes could prune that
+          // away. Grappler passes could also cause issues around shape
+          // inference. Since the desired and existing behavior is to not
+          // optimize TPU functions with Grappler, this check preserves that.
+          // The only exception is implementation selector what is required to
+          // swap in some TPU specific lowering code and is verified the work
+          // correctly on TPUs.
+          ImplementationSelector implementation_selector;
+
+          // Implementation selector needs to have access to valid function
+          // signature and attributes, and it doesn't need actual function
+          // body.
+          FunctionDefLibrary func_item_function_library;
+          func_item_function_library.Swap(func_item.graph.mutable_library());
+          *func_item.graph.mutable_library() =
+              GetFunctionDefLibraryStub(func_item_function_library);
+
+          statuses[i] = implementation_selector.Optimize(
+              cluster, func_item, &optimized_func_graphs[i]);
+        } else {
+          GrapplerFunctionItem func_item_copy = func_item;
+          statuses[i] =
+              OptimizeGraph(cluster, std::move(func_item_copy),
+                            &optimized_func_graphs[i], &func_results[i]);
         }
+      };
+      if (wave.size() == 1) {
+        optimize_function(0);
+      } else {
+        if (thread_pool == nullptr) {
+          thread_pool = MakeUnique<thread::ThreadPool>(
+              Env::Default(), "meta_optimizer_functions",
+              port::MaxParallelism());
+        }
+        BlockingCounter counter(wave.size());
+        for (int i = 0; i < wave.size(); ++i) {
+          thread_pool->Schedule([&optimize_function, &counter, i]() {
+            optimize_function(i);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
       }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+      // Update the library in the library order, so that it does not depend
+      // on the order in which the functions were optimized.
+      for (int i = 0; i < wave.size(); ++i) {
+        TF_RETURN_IF_ERROR(statuses[i]);
+        for (GraphOptimizationResult& result : func_results[i]) {
+          optimization_results_.push_back(std::move(result));
+        }
+        GraphDef& optimized_func_graph = optimized_func_graphs[i];
+
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library.
+        for (const FunctionDef& func_def :
+             optimized_func_graph.library().function()) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
+        }
+
+        // Convert optimized graph back to FunctionDef.
+        FunctionDef optimized_func;
+        GrapplerFunctionItem& func_item = func_items[i];
+        func_item.SwapFunctionBody(std::move(optimized_func_graph));
+        TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
 
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+        // Replace optimized function with a new FunctionDef.
+        TF_RETURN_IF_ERROR(flib.ReplaceFunction(wave[i]->signature().name(),
+                                                optimized_func));
+      }
     }
 
     // If optimized at least one function, update the graph library.
@@ -938,17 +1040,20 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.constant_folding() != RewriterConfig::OFF ||
          rewrite_cfg.shape_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.remapping() != RewriterConfig::OFF ||
+         rewrite_cfg.elementwise_fusion() == RewriterConfig::ON ||
          rewrite_cfg.common_subgraph_elimination() != RewriterConfig::OFF ||
          rewrite_cfg.arithmetic_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.loop_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.dependency_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.auto_parallel().enable() ||
+         rewrite_cfg.pipeline_parallel().enable() ||
          rewrite_cfg.memory_optimization() != RewriterConfig::NO_MEM_OPT ||
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
+         AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -956,11 +1061,25 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
 Status RunMetaOptimizer(GrapplerItem&& item, const ConfigProto& cfg,
                         DeviceBase* cpu_device, Cluster* cluster,
                         GraphDef* optimized_graph) {
+  OptimizedGraphCache* cache = OptimizedGraphCache::Global();
+  uint64 fingerprint = 0;
+  if (cache != nullptr) {
+    fingerprint = OptimizedGraphCache::Fingerprint(
+        item, cfg, /*has_cpu_device=*/cpu_device != nullptr, cluster);
+    if (cache->Lookup(fingerprint, optimized_graph)) {
+      VLOG(1) << "Found the optimized graph of grappler item " << item.id
+              << " in the cache";
+      return Status::OK();
+    }
+  }
+
   MetaOptimizer optimizer(cpu_device, cfg);
   optimizer.set_deadline_usec(
       DeadlineMicroSeconds(cfg.graph_options().rewrite_options()));
-  return optimizer.OptimizeConsumeItem(cluster, std::move(item),
-                                       optimized_graph);
+  TF_RETURN_IF_ERROR(optimizer.OptimizeConsumeItem(cluster, std::move(item),
+                                                   optimized_graph));
+  if (cache != nullptr) cache->Insert(fingerprint, *optimized_graph);
+  return Status::OK();
 }
 
 Status OptimizeGraph(
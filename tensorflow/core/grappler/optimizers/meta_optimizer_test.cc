@@ -597,6 +597,56 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneFunctionBody) {
   test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
 }
 
+TEST_F(MetaOptimizerTest, OptimizeIndependentFunctionsDeterministically) {
+  using test::function::NDef;
+  constexpr int kNumFunctions = 16;
+
+  // Square<i> computes x*x, and an unused x+x which should be pruned.
+  std::vector<FunctionDef> function_library;
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  std::vector<string> fetch;
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const string name = absl::StrCat("Square", i);
+    FunctionDef square = FunctionDefHelper::Create(
+        name, {"x:float"}, {"z:float"}, {},
+        {{{"unused"}, "Add", {"x", "x"}, {{"T", DT_FLOAT}}},
+         {{"square"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+        /*ret_def=*/
+        {{"z", "square:z:0"}});
+    (*square.mutable_attr())["_noinline"].set_b(true);
+    function_library.push_back(square);
+    nodes.push_back(NDef(absl::StrCat("square", i), name, {"x"}, {}, kDevice));
+    fetch.push_back(absl::StrCat("square", i));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.fetch = fetch;
+  item.graph = test::function::GDef(nodes, function_library);
+
+  ConfigProto config_proto;
+  GraphDef output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto).Optimize(nullptr, item,
+                                                             &output));
+  EXPECT_EQ(kNumFunctions, output.library().function_size());
+  for (const FunctionDef& func : output.library().function()) {
+    for (const NodeDef& node : func.node_def()) {
+      EXPECT_NE("unused", node.name()) << func.signature().name();
+    }
+  }
+
+  // The functions are optimized concurrently, but the library does not depend
+  // on the order in which they are optimized.
+  for (int i = 0; i < 3; ++i) {
+    GraphDef other_output;
+    TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                     .Optimize(nullptr, item, &other_output));
+    EXPECT_EQ(output.library().DebugString(),
+              other_output.library().DebugString());
+  }
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
   using test::function::NDef;
   using FDH = FunctionDefHelper;
@@ -0,0 +1,202 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+uint64 FingerprintProto(const protobuf::MessageLite& proto) {
+  string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  return Fingerprint64(serialized);
+}
+
+uint64 FingerprintStrings(uint64 fingerprint,
+                          const std::vector<string>& strings) {
+  fingerprint = FingerprintCat64(fingerprint, strings.size());
+  for (const string& s : strings) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(s));
+  }
+  return fingerprint;
+}
+
+}  // namespace
+
+OptimizedGraphCache::OptimizedGraphCache(int64 capacity_bytes,
+                                         const string& dir)
+    : capacity_bytes_(capacity_bytes), dir_(dir) {}
+
+OptimizedGraphCache* OptimizedGraphCache::Global() {
+  static OptimizedGraphCache* cache = []() -> OptimizedGraphCache* {
+    int64 capacity_mb;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRAPPLER_CACHE_MB", 0, &capacity_mb));
+    string dir;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_GRAPPLER_CACHE_DIR", "", &dir));
+    if (capacity_mb <= 0 && dir.empty()) return nullptr;
+    if (!dir.empty()) {
+      Status status = Env::Default()->RecursivelyCreateDir(dir);
+      if (!status.ok()) {
+        LOG(WARNING) << "Not caching optimized graphs in " << dir << ": "
+                     << status;
+        dir.clear();
+      }
+    }
+    return new OptimizedGraphCache(std::max<int64>(capacity_mb, 0) << 20,
+                                   dir);
+  }();
+  return cache;
+}
+
+uint64 OptimizedGraphCache::Fingerprint(const GrapplerItem& item,
+                                        const ConfigProto& config,
+                                        bool has_cpu_device,
+                                        const Cluster* cluster) {
+  // The graphs on disk may be read by processes running another version.
+  uint64 fingerprint = Fingerprint64(TF_VERSION_STRING);
+  fingerprint = FingerprintCat64(fingerprint, FingerprintProto(item.graph));
+
+  fingerprint = FingerprintCat64(fingerprint, item.feed.size());
+  for (const auto& feed : item.feed) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(feed.first));
+    fingerprint = FingerprintCat64(fingerprint, feed.second.dtype());
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(feed.second.shape().DebugString()));
+  }
+  fingerprint = FingerprintStrings(fingerprint, item.fetch);
+  fingerprint = FingerprintStrings(fingerprint, item.init_ops);
+  fingerprint = FingerprintStrings(
+      fingerprint,
+      {item.save_op, item.restore_op, item.save_restore_loc_tensor});
+  fingerprint = FingerprintCat64(fingerprint, item.queue_runners.size());
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    fingerprint = FingerprintCat64(fingerprint, FingerprintProto(queue_runner));
+  }
+  fingerprint = FingerprintStrings(fingerprint, item.keep_ops);
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  fingerprint = FingerprintStrings(fingerprint, devices);
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  fingerprint = FingerprintCat64(
+      fingerprint, (options.allow_non_differentiable_rewrites ? 1 : 0) |
+                       (options.allow_pruning_stateful_and_dataset_ops << 1) |
+                       (options.optimize_function_library << 2) |
+                       (options.is_eager_mode << 3) | (has_cpu_device << 4));
+
+  // The graph options hold the rewriter config, and the other options which
+  // the optimizers read.
+  fingerprint =
+      FingerprintCat64(fingerprint, FingerprintProto(config.graph_options()));
+
+  if (cluster != nullptr) {
+    std::vector<std::pair<string, const DeviceProperties*>> cluster_devices;
+    for (const auto& device : cluster->GetDevices()) {
+      cluster_devices.emplace_back(device.first, &device.second);
+    }
+    std::sort(cluster_devices.begin(), cluster_devices.end());
+    for (const auto& device : cluster_devices) {
+      fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device.first));
+      fingerprint =
+          FingerprintCat64(fingerprint, FingerprintProto(*device.second));
+    }
+  }
+  return fingerprint;
+}
+
+bool OptimizedGraphCache::Lookup(uint64 fingerprint, GraphDef* graph) {
+  {
+    mutex_lock l(mu_);
+    auto it = index_.find(fingerprint);
+    if (it != index_.end()) {
+      graphs_.splice(graphs_.begin(), graphs_, it->second);
+      *graph = it->second->second;
+      return true;
+    }
+  }
+  if (dir_.empty()) return false;
+
+  Env* env = Env::Default();
+  const string path = FilePath(fingerprint);
+  if (!env->FileExists(path).ok()) return false;
+  Status status = ReadBinaryProto(env, path, graph);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read the optimized graph " << path << ": "
+                 << status;
+    return false;
+  }
+  mutex_lock l(mu_);
+  InsertInMemory(fingerprint, *graph);
+  return true;
+}
+
+void OptimizedGraphCache::Insert(uint64 fingerprint, const GraphDef& graph) {
+  {
+    mutex_lock l(mu_);
+    InsertInMemory(fingerprint, graph);
+  }
+  if (dir_.empty()) return;
+
+  // Writes the graph to a temporary file and renames it, so that other
+  // processes never read a partially written graph.
+  Env* env = Env::Default();
+  const string path = FilePath(fingerprint);
+  string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) return;
+  Status status = WriteBinaryProto(env, temp_path, graph);
+  if (status.ok()) status = env->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write the optimized graph " << path << ": "
+                 << status;
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+}
+
+void OptimizedGraphCache::InsertInMemory(uint64 fingerprint,
+                                         const GraphDef& graph) {
+  const int64 graph_bytes = graph.ByteSizeLong();
+  if (graph_bytes > capacity_bytes_ || index_.count(fingerprint) > 0) return;
+  graphs_.emplace_front(fingerprint, graph);
+  index_[fingerprint] = graphs_.begin();
+  size_bytes_ += graph_bytes;
+  while (size_bytes_ > capacity_bytes_) {
+    size_bytes_ -= graphs_.back().second.ByteSizeLong();
+    index_.erase(graphs_.back().first);
+    graphs_.pop_back();
+  }
+}
+
+string OptimizedGraphCache::FilePath(uint64 fingerprint) const {
+  return io::JoinPath(
+      dir_, strings::StrCat("grappler_", strings::Hex(fingerprint), ".pb"));
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
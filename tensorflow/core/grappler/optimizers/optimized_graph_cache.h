@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A cache of the graphs optimized by the meta optimizer, keyed by a
+// fingerprint of everything their optimization depends on, so that identical
+// graphs are only optimized once: by a process, in memory, and by the
+// processes sharing a directory, on disk.
+//
+// The global cache is configured by environment variables:
+//   TF_GRAPPLER_CACHE_MB: the size of the graphs kept in memory, in megabytes.
+//     The least recently used graphs are evicted beyond it. Defaults to 0.
+//   TF_GRAPPLER_CACHE_DIR: a directory in which the graphs are also written,
+//     one binary GraphDef per fingerprint. Defaults to none.
+//
+// This class is thread-safe.
+class OptimizedGraphCache {
+ public:
+  // Does not write the graphs on disk if `dir` is empty.
+  OptimizedGraphCache(int64 capacity_bytes, const string& dir);
+
+  // Returns the cache of this process, or nullptr if it is disabled.
+  static OptimizedGraphCache* Global();
+
+  // Returns the fingerprint of the optimization of `item` with the options
+  // of `config`, with or without a CPU device to evaluate constants on, for
+  // the devices of `cluster`, which may be null. The id of `item` is ignored.
+  static uint64 Fingerprint(const GrapplerItem& item,
+                            const ConfigProto& config, bool has_cpu_device,
+                            const Cluster* cluster);
+
+  // Returns the optimized graph of `fingerprint` in `graph` and true if the
+  // cache holds it, in memory or on disk, and false otherwise.
+  bool Lookup(uint64 fingerprint, GraphDef* graph);
+
+  // Inserts `graph` as the optimized graph of `fingerprint`.
+  void Insert(uint64 fingerprint, const GraphDef& graph);
+
+ private:
+  // Keeps `graph` in memory, evicting the least recently used graphs beyond
+  // the capacity.
+  void InsertInMemory(uint64 fingerprint, const GraphDef& graph)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  string FilePath(uint64 fingerprint) const;
+
+  const int64 capacity_bytes_;
+  const string dir_;
+
+  mutex mu_;
+  // The graphs in memory, from the most to the least recently used.
+  std::list<std::pair<uint64, GraphDef>> graphs_ TF_GUARDED_BY(mu_);
+  std::unordered_map<uint64, std::list<std::pair<uint64, GraphDef>>::iterator>
+      index_ TF_GUARDED_BY(mu_);
+  int64 size_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OptimizedGraphCache);
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+GraphDef MakeGraph(const string& name, int num_nodes) {
+  GraphDef graph;
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = graph.add_node();
+    node->set_name(strings::StrCat(name, "_", i));
+    node->set_op("NoOp");
+  }
+  return graph;
+}
+
+GrapplerItem MakeItem() {
+  GrapplerItem item;
+  item.id = "item";
+  item.graph = MakeGraph("node", 3);
+  item.fetch.push_back("node_2");
+  return item;
+}
+
+TEST(OptimizedGraphCacheTest, Fingerprint) {
+  const ConfigProto config;
+  const uint64 fingerprint = OptimizedGraphCache::Fingerprint(
+      MakeItem(), config, /*has_cpu_device=*/true, /*cluster=*/nullptr);
+
+  GrapplerItem other_id = MakeItem();
+  other_id.id = "other_item";
+  EXPECT_EQ(fingerprint, OptimizedGraphCache::Fingerprint(
+                             other_id, config, true, nullptr));
+
+  GrapplerItem other_fetch = MakeItem();
+  other_fetch.fetch = {"node_1"};
+  EXPECT_NE(fingerprint, OptimizedGraphCache::Fingerprint(
+                             other_fetch, config, true, nullptr));
+
+  GrapplerItem other_graph = MakeItem();
+  other_graph.graph = MakeGraph("node", 4);
+  EXPECT_NE(fingerprint, OptimizedGraphCache::Fingerprint(
+                             other_graph, config, true, nullptr));
+
+  ConfigProto other_config;
+  other_config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_remapping(RewriterConfig::OFF);
+  EXPECT_NE(fingerprint, OptimizedGraphCache::Fingerprint(
+                             MakeItem(), other_config, true, nullptr));
+
+  EXPECT_NE(fingerprint,
+            OptimizedGraphCache::Fingerprint(MakeItem(), config, false,
+                                             nullptr));
+}
+
+TEST(OptimizedGraphCacheTest, EvictsLeastRecentlyUsed) {
+  const GraphDef graph_a = MakeGraph("a", 10);
+  const GraphDef graph_b = MakeGraph("b", 10);
+  const GraphDef graph_c = MakeGraph("c", 10);
+  // Holds two of the graphs.
+  OptimizedGraphCache cache(
+      graph_a.ByteSizeLong() + graph_b.ByteSizeLong() + 1, /*dir=*/"");
+
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup(1, &graph));
+  cache.Insert(1, graph_a);
+  cache.Insert(2, graph_b);
+  ASSERT_TRUE(cache.Lookup(1, &graph));
+  EXPECT_EQ(graph.DebugString(), graph_a.DebugString());
+
+  cache.Insert(3, graph_c);
+  EXPECT_TRUE(cache.Lookup(1, &graph));
+  EXPECT_FALSE(cache.Lookup(2, &graph));
+  ASSERT_TRUE(cache.Lookup(3, &graph));
+  EXPECT_EQ(graph.DebugString(), graph_c.DebugString());
+}
+
+TEST(OptimizedGraphCacheTest, SharesGraphsOnDisk) {
+  const string dir = io::JoinPath(testing::TmpDir(), "optimized_graph_cache");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  const GraphDef graph_a = MakeGraph("a", 10);
+
+  OptimizedGraphCache writer(/*capacity_bytes=*/0, dir);
+  writer.Insert(42, graph_a);
+
+  OptimizedGraphCache reader(/*capacity_bytes=*/0, dir);
+  GraphDef graph;
+  ASSERT_TRUE(reader.Lookup(42, &graph));
+  EXPECT_EQ(graph.DebugString(), graph_a.DebugString());
+  EXPECT_FALSE(reader.Lookup(43, &graph));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
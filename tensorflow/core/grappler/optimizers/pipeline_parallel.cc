@@ -0,0 +1,489 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/pipeline_parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/devices.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/grappler/utils/transitive_fanin.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kPipelineParallelPrefix[] = "PipelineParallel";
+
+// Returns the position of the gradient input of `node` if it applies a
+// gradient to a variable, or -1.
+int GradientInputPosition(const NodeDef& node) {
+  static const auto* const kGradientPositions =
+      new std::unordered_map<string, int>({{"ApplyGradientDescent", 2},
+                                           {"ApplyProximalGradientDescent", 4},
+                                           {"ApplyAdadelta", 6},
+                                           {"ApplyAdagrad", 3},
+                                           {"ApplyProximalAdagrad", 5},
+                                           {"ApplyAdagradDA", 3},
+                                           {"ApplyFtrl", 3},
+                                           {"ApplyMomentum", 3},
+                                           {"ApplyAdam", 9},
+                                           {"ApplyRMSProp", 7},
+                                           {"ApplyCenteredRMSProp", 8}});
+  StringPiece op = node.op();
+  // The resource variants take the same inputs.
+  absl::ConsumePrefix(&op, "Resource");
+  auto it = kGradientPositions->find(string(op));
+  if (it == kGradientPositions->end() || it->second >= node.input_size()) {
+    return -1;
+  }
+  return it->second;
+}
+
+// Returns true if `name` is in the name scope of tf.gradients() or of a
+// GradientTape, and then sets `*forward` to the name of the node it computes
+// the gradient of, or to the empty string if it is not known.
+bool IsBackwardNode(const string& name, string* forward) {
+  std::vector<StringPiece> scopes = absl::StrSplit(name, '/');
+  for (size_t i = 0; i + 1 < scopes.size(); ++i) {
+    const StringPiece scope = scopes[i];
+    if (scope != "gradients" && !absl::StartsWith(scope, "gradients_") &&
+        !absl::StartsWith(scope, "gradient_tape")) {
+      continue;
+    }
+    // The gradient of node "a/b" is in the name scope "gradients/a/b_grad".
+    forward->clear();
+    for (size_t j = i + 1; j + 1 < scopes.size(); ++j) {
+      if (absl::EndsWith(scopes[j], "_grad")) {
+        std::vector<StringPiece> path(scopes.begin() + i + 1,
+                                      scopes.begin() + j + 1);
+        path.back().remove_suffix(strlen("_grad"));
+        *forward = absl::StrJoin(path, "/");
+        break;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+// Splits `costs` in `num_ranges` contiguous ranges, or fewer if there are
+// fewer costs, minimizing the largest sum of a range. Returns the range of
+// every cost.
+std::vector<int> SplitInRanges(const std::vector<int64>& costs,
+                               int num_ranges) {
+  const int n = costs.size();
+  // Returns the number of ranges of sums at most `limit` greedily cut.
+  auto count_ranges = [&](int64 limit) {
+    int count = 1;
+    int64 sum = 0;
+    for (int64 cost : costs) {
+      if (sum + cost > limit) {
+        ++count;
+        sum = 0;
+      }
+      sum += cost;
+    }
+    return count;
+  };
+  int64 low = 0;
+  int64 high = 0;
+  for (int64 cost : costs) {
+    low = std::max(low, cost);
+    high += cost;
+  }
+  // The smallest largest sum of a range.
+  while (low < high) {
+    const int64 mid = low + (high - low) / 2;
+    if (count_ranges(mid) <= num_ranges) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  std::vector<int> ranges(n);
+  int range = 0;
+  int64 sum = 0;
+  for (int i = 0; i < n; ++i) {
+    // Cuts a range when it is full, or to leave a cost for each range left.
+    if (i > 0 && range + 1 < num_ranges &&
+        (sum + costs[i] > low || n - i <= num_ranges - 1 - range)) {
+      ++range;
+      sum = 0;
+    }
+    ranges[i] = range;
+    sum += costs[i];
+  }
+  return ranges;
+}
+
+bool IsPinnedToCpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+         parsed.has_type && parsed.type == DEVICE_CPU;
+}
+
+string MicroBatchPrefix(int micro_batch) {
+  return strings::StrCat(kPipelineParallelPrefix, "-MicroBatch-",
+                         micro_batch);
+}
+
+}  // namespace
+
+std::vector<string> PipelineParallel::GetStageDevices(Cluster* cluster) const {
+  std::vector<string> devices;
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.second.type() == "GPU") devices.push_back(device.first);
+    }
+    std::sort(devices.begin(), devices.end());
+  }
+  if (devices.empty()) {
+    const int num_gpus = GetNumAvailableGPUs();
+    for (int i = 0; i < num_gpus; ++i) {
+      devices.push_back(strings::StrCat("/device:GPU:", i));
+    }
+  }
+  return devices;
+}
+
+std::unordered_map<string, Costs::NanoSeconds>
+PipelineParallel::EstimateNodeCosts(Cluster* cluster,
+                                    const GrapplerItem& item) const {
+  std::unordered_map<string, Costs::NanoSeconds> costs;
+  if (cluster == nullptr) return costs;
+  VirtualCluster vcluster(cluster->GetDevices());
+  Status s = vcluster.Provision();
+  if (s.ok()) s = vcluster.Initialize(item);
+  RunMetadata metadata;
+  if (s.ok()) s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    VLOG(1) << "Failed to estimate the node costs, assuming equal costs: "
+            << s;
+    return costs;
+  }
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      costs[node_stats.node_name()] =
+          Costs::NanoSeconds(node_stats.op_end_rel_nanos());
+    }
+  }
+  return costs;
+}
+
+Status PipelineParallel::AssignStages(
+    const GraphDef& graph, const std::unordered_set<string>& pipelined,
+    const std::unordered_map<string, Costs::NanoSeconds>& costs,
+    std::unordered_map<string, int>* stages) {
+  auto cost_of = [&costs](const string& name) {
+    auto it = costs.find(name);
+    // Every node takes at least a nanosecond.
+    return it == costs.end() ? 1 : std::max<int64>(it->second.count(), 1);
+  };
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(graph, &topo_order));
+
+  // Cuts the forward nodes in stages of about the same cost.
+  std::vector<const NodeDef*> forward;
+  std::vector<const NodeDef*> backward;
+  std::vector<int64> forward_costs;
+  string forward_name;
+  for (const NodeDef* node : topo_order) {
+    if (pipelined.count(node->name()) == 0) continue;
+    if (IsBackwardNode(node->name(), &forward_name)) {
+      backward.push_back(node);
+    } else {
+      forward.push_back(node);
+      forward_costs.push_back(cost_of(node->name()));
+    }
+  }
+  const std::vector<int> forward_stages =
+      SplitInRanges(forward_costs, num_stages_);
+  std::vector<int64> forward_stage_costs(num_stages_, 0);
+  for (size_t i = 0; i < forward.size(); ++i) {
+    (*stages)[forward[i]->name()] = forward_stages[i];
+    forward_stage_costs[forward_stages[i]] += forward_costs[i];
+  }
+
+  // Runs every backward node in the stage of its forward node or, if it is
+  // not known, in the earliest stage of its inputs: the gradients flow from
+  // the last stage to the first one.
+  std::vector<int64> backward_stage_costs(num_stages_, 0);
+  for (const NodeDef* node : backward) {
+    IsBackwardNode(node->name(), &forward_name);
+    int stage = -1;
+    auto it = stages->find(forward_name);
+    if (!forward_name.empty() && it != stages->end()) {
+      stage = it->second;
+    } else {
+      for (const string& input : node->input()) {
+        auto input_it = stages->find(NodeName(input));
+        if (input_it != stages->end() &&
+            (stage == -1 || input_it->second < stage)) {
+          stage = input_it->second;
+        }
+      }
+    }
+    if (stage == -1) stage = num_stages_ - 1;
+    (*stages)[node->name()] = stage;
+    backward_stage_costs[stage] += cost_of(node->name());
+  }
+
+  // The forward and the backward passes of the micro-batches are pipelined
+  // through the stages, and each pass takes num_micro_batches + num_stages - 1
+  // times its slowest stage.
+  stage_costs_.clear();
+  int64 total_cost = 0;
+  for (int i = 0; i < num_stages_; ++i) {
+    stage_costs_.emplace_back(forward_stage_costs[i] +
+                              backward_stage_costs[i]);
+    total_cost += stage_costs_.back().count();
+  }
+  const int64 step_time =
+      (num_micro_batches_ + num_stages_ - 1) *
+      (*std::max_element(forward_stage_costs.begin(),
+                         forward_stage_costs.end()) +
+       *std::max_element(backward_stage_costs.begin(),
+                         backward_stage_costs.end()));
+  const double busy_time =
+      static_cast<double>(num_micro_batches_) * total_cost / num_stages_;
+  predicted_bubble_overhead_ =
+      step_time > 0 ? 1.0 - busy_time / step_time : 0.0;
+  return Status::OK();
+}
+
+Status PipelineParallel::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                  GraphDef* output) {
+  if (num_stages_ < 2) {
+    return errors::InvalidArgument(
+        "Pipeline parallelism requires at least 2 stages, got ", num_stages_);
+  }
+  if (num_micro_batches_ < 1) {
+    return errors::InvalidArgument(
+        "Pipeline parallelism requires at least 1 micro-batch, got ",
+        num_micro_batches_);
+  }
+  if (item.fetch.empty()) {
+    return errors::InvalidArgument("No fetch nodes provided.");
+  }
+  const std::vector<string> devices = GetStageDevices(cluster);
+  if (devices.empty()) {
+    return errors::InvalidArgument("Pipeline parallelism requires GPUs.");
+  }
+
+  // The gradients applied to the variables.
+  std::vector<const NodeDef*> train_nodes;
+  TF_RETURN_IF_ERROR(
+      ComputeTransitiveFanin(item.graph, item.fetch, &train_nodes));
+  std::vector<const NodeDef*> apply_nodes;
+  std::vector<string> gradients;
+  for (const NodeDef* node : train_nodes) {
+    const int position = GradientInputPosition(*node);
+    if (position >= 0) {
+      apply_nodes.push_back(node);
+      gradients.push_back(NodeName(node->input(position)));
+    }
+  }
+  if (apply_nodes.empty()) {
+    return errors::InvalidArgument("No gradients applied to variables.");
+  }
+
+  // The nodes computing the gradients are pipelined, except the variables,
+  // the feeds and the input pipeline before the dequeue of the batch.
+  std::vector<const NodeDef*> gradient_nodes;
+  TF_RETURN_IF_ERROR(
+      ComputeTransitiveFanin(item.graph, gradients, &gradient_nodes));
+  std::unordered_set<string> not_pipelined;
+  for (const auto& init : item.init_ops) {
+    not_pipelined.insert(NodeName(init));
+  }
+  for (const auto& feed : item.feed) {
+    not_pipelined.insert(NodeName(feed.first));
+  }
+  const NodeDef* dequeue_node = nullptr;
+  for (const NodeDef* node : gradient_nodes) {
+    if (IsVariable(*node)) not_pipelined.insert(node->name());
+    if (dequeue_node == nullptr && IsDequeueOp(*node)) dequeue_node = node;
+  }
+  if (dequeue_node != nullptr) {
+    std::vector<const NodeDef*> input_nodes;
+    TF_RETURN_IF_ERROR(ComputeTransitiveFanin(
+        item.graph, {dequeue_node->name()}, &input_nodes));
+    for (const NodeDef* node : input_nodes) {
+      if (node != dequeue_node) not_pipelined.insert(node->name());
+    }
+  } else if (num_micro_batches_ > 1) {
+    return errors::InvalidArgument(
+        "Micro-batches require the batch to be dequeued from a queue.");
+  }
+  std::unordered_set<string> pipelined;
+  for (const NodeDef* node : gradient_nodes) {
+    if (not_pipelined.count(node->name()) == 0) {
+      pipelined.insert(node->name());
+    }
+  }
+
+  std::unordered_map<string, int> stages;
+  TF_RETURN_IF_ERROR(AssignStages(item.graph, pipelined,
+                                  EstimateNodeCosts(cluster, item), &stages));
+  // The variables and their updates run in the stage of their gradients.
+  std::unordered_map<string, string> node_devices;
+  for (size_t i = 0; i < apply_nodes.size(); ++i) {
+    auto it = stages.find(gradients[i]);
+    if (it == stages.end()) continue;
+    const string& device = devices[it->second % devices.size()];
+    node_devices[apply_nodes[i]->name()] = device;
+    node_devices[NodeName(apply_nodes[i]->input(0))] = device;
+  }
+  for (const auto& stage : stages) {
+    node_devices[stage.first] = devices[stage.second % devices.size()];
+  }
+
+  *output = item.graph;
+  std::unordered_map<string, NodeDef*> nodes;
+  for (NodeDef& node : *output->mutable_node()) {
+    nodes[node.name()] = &node;
+  }
+  // The first micro-batch keeps the original nodes, the others get copies
+  // reading the inputs of their micro-batch.
+  for (int i = 1; i < num_micro_batches_; ++i) {
+    const string prefix = MicroBatchPrefix(i);
+    for (const NodeDef& original : item.graph.node()) {
+      if (pipelined.count(original.name()) == 0) continue;
+      NodeDef* node = output->add_node();
+      *node = original;
+      node->set_name(AddPrefixToNodeName(original.name(), prefix));
+      for (string& input : *node->mutable_input()) {
+        if (pipelined.count(NodeName(input)) > 0) {
+          input = AddPrefixToNodeName(input, prefix);
+        }
+      }
+    }
+  }
+
+  // Applies the average of the gradients of the micro-batches.
+  if (num_micro_batches_ > 1) {
+    for (const NodeDef* original : apply_nodes) {
+      NodeDef* apply = nodes[original->name()];
+      const int position = GradientInputPosition(*apply);
+      const string gradient = apply->input(position);
+      const DataType dtype = apply->attr().at("T").type();
+
+      NodeDef* add = output->add_node();
+      add->set_name(strings::StrCat(kPipelineParallelPrefix, "-AddN-",
+                                    apply->name()));
+      add->set_op("AddN");
+      add->add_input(gradient);
+      for (int i = 1; i < num_micro_batches_; ++i) {
+        add->add_input(AddPrefixToNodeName(gradient, MicroBatchPrefix(i)));
+      }
+      (*add->mutable_attr())["N"].set_i(num_micro_batches_);
+      (*add->mutable_attr())["T"].set_type(dtype);
+
+      NodeDef* count = output->add_node();
+      count->set_name(strings::StrCat(kPipelineParallelPrefix,
+                                      "-NumMicroBatches-", apply->name()));
+      count->set_op("Const");
+      Tensor value(dtype, TensorShape({}));
+      TF_RETURN_IF_ERROR(SetTensorValue(dtype, num_micro_batches_, &value));
+      value.AsProtoTensorContent((*count->mutable_attr())["value"]
+                                     .mutable_tensor());
+      (*count->mutable_attr())["dtype"].set_type(dtype);
+
+      NodeDef* div = output->add_node();
+      div->set_name(strings::StrCat(kPipelineParallelPrefix, "-Div-",
+                                    apply->name()));
+      div->set_op("RealDiv");
+      div->add_input(add->name());
+      div->add_input(count->name());
+      (*div->mutable_attr())["T"].set_type(dtype);
+      *apply->mutable_input(position) = div->name();
+
+      auto it = node_devices.find(apply->name());
+      if (it != node_devices.end()) {
+        node_devices[add->name()] = it->second;
+        node_devices[count->name()] = it->second;
+        node_devices[div->name()] = it->second;
+      }
+    }
+  }
+
+  // Places the nodes, keeping the dequeue and the nodes pinned to the CPU
+  // on their device, and colocated nodes together.
+  for (NodeDef& node : *output->mutable_node()) {
+    // The copies of the nodes of the other micro-batches run on the same
+    // device as the original.
+    StringPiece name = node.name();
+    if (absl::ConsumePrefix(&name, strings::StrCat(kPipelineParallelPrefix,
+                                                    "-MicroBatch-"))) {
+      name.remove_prefix(name.find('/') + 1);
+    }
+    auto it = node_devices.find(string(name));
+    if (it == node_devices.end() || IsDequeueOp(node) ||
+        IsPinnedToCpu(node)) {
+      continue;
+    }
+    node.set_device(it->second);
+    auto colocation = node.attr().find(kColocationAttrName);
+    if (colocation == node.attr().end()) continue;
+    for (const string& group : colocation->second.list().s()) {
+      StringPiece target = group;
+      if (absl::ConsumePrefix(&target, kColocationGroupPrefix)) {
+        auto target_it = node_devices.find(string(target));
+        if (target_it != node_devices.end()) {
+          node.set_device(target_it->second);
+        }
+      }
+    }
+  }
+
+  LOG(INFO) << "Pipelined " << pipelined.size() << " nodes in "
+            << num_stages_ << " stages of estimated costs "
+            << absl::StrJoin(stage_costs_, ", ",
+                             [](string* out, Costs::NanoSeconds cost) {
+                               strings::StrAppend(out, cost.count(), "ns");
+                             })
+            << " and " << num_micro_batches_
+            << " micro-batches, predicted bubble overhead: "
+            << predicted_bubble_overhead_ * 100 << "%";
+  return Status::OK();
+}
+
+void PipelineParallel::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                const GraphDef& optimize_output,
+                                double result) {
+  // Nothing to do for PipelineParallel.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PIPELINE_PARALLEL_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PIPELINE_PARALLEL_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Parallelizes a training graph too big for one GPU by splitting it in
+// pipeline stages placed on different GPUs.
+//
+// The nodes computing the gradients of the variables, forward and backward,
+// are split in `num_stages` stages of about the same cost, estimated by the
+// VirtualScheduler of the cluster: the forward nodes are cut in contiguous
+// ranges of their topological order, and every backward node runs in the
+// stage of its forward node, so that the activations stay on their GPU. The
+// variables and the nodes applying their gradients run in the stage of the
+// gradients.
+//
+// These nodes are replicated for each of the `num_micro_batches`
+// micro-batches of the training step, which dequeue their own batch from the
+// input queue. The first micro-batch keeps the original node names, so that
+// fetches read its values. The variables are updated once per step, with the
+// average of the gradients of the micro-batches. Since stage i of a
+// micro-batch only waits for stage i - 1 of the same micro-batch, the stages
+// of different micro-batches run concurrently, and the graph partitioning
+// inserts the Send/Recv pairs between the stages.
+class PipelineParallel : public GraphOptimizer {
+ public:
+  PipelineParallel(int num_stages, int num_micro_batches)
+      : num_stages_(num_stages), num_micro_batches_(num_micro_batches) {}
+  ~PipelineParallel() override {}
+
+  string name() const override { return "pipeline_parallel"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimize_output, double result) override;
+
+  // The estimated cost of a micro-batch in each stage, forward and backward,
+  // and the predicted fraction of the step time the GPUs are idle, waiting
+  // for the pipeline to fill and drain or for slower stages, as of the last
+  // call to Optimize().
+  const std::vector<Costs::NanoSeconds>& stage_costs() const {
+    return stage_costs_;
+  }
+  double predicted_bubble_overhead() const {
+    return predicted_bubble_overhead_;
+  }
+
+ private:
+  // Returns the devices of the stages.
+  std::vector<string> GetStageDevices(Cluster* cluster) const;
+  // Estimates the execution time of the nodes of `item` on `cluster`.
+  std::unordered_map<string, Costs::NanoSeconds> EstimateNodeCosts(
+      Cluster* cluster, const GrapplerItem& item) const;
+  // Assigns a stage to every node of `pipelined`, the nodes computing the
+  // gradients, and returns them by name.
+  Status AssignStages(
+      const GraphDef& graph, const std::unordered_set<string>& pipelined,
+      const std::unordered_map<string, Costs::NanoSeconds>& costs,
+      std::unordered_map<string, int>* stages);
+
+  const int num_stages_;
+  const int num_micro_batches_;
+  std::vector<Costs::NanoSeconds> stage_costs_;
+  double predicted_bubble_overhead_ = 0;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PIPELINE_PARALLEL_H_
@@ -0,0 +1,193 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/pipeline_parallel.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kGpu0[] = "/job:localhost/replica:0/task:0/device:GPU:0";
+constexpr char kGpu1[] = "/job:localhost/replica:0/task:0/device:GPU:1";
+
+class PipelineParallelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(24);
+    gpu_device.set_memory_size(1 << 30);
+    cluster_.reset(
+        new VirtualCluster({{kGpu0, gpu_device}, {kGpu1, gpu_device}}));
+    TF_CHECK_OK(cluster_->Provision());
+  }
+
+  void TearDown() override { TF_CHECK_OK(cluster_->Shutdown()); }
+
+  // Builds a training step of two layers reading their batch from a queue.
+  GrapplerItem TrainingItem() const {
+    tensorflow::Scope s = tensorflow::Scope::DisabledShapeInferenceScope();
+    Output constant_a = ops::Const(s.WithOpName("constant_a"), 1.0f, {1});
+    Output constant_b = ops::Const(s.WithOpName("constant_b"), 1, {1});
+    Output var = ops::Variable(s.WithOpName("var"), {1}, DT_FLOAT);
+    Output assign = ops::Assign(s.WithOpName("assign"), {var}, {constant_a});
+    Output fifo_queue =
+        ops::FIFOQueue(s.WithOpName("fifo_queue"), {DT_FLOAT});
+    auto dequeue = ops::QueueDequeueMany(s.WithOpName("dequeue"),
+                                         {fifo_queue}, {constant_b},
+                                         {DT_FLOAT});
+    Output layer1 = ops::Mul(s.WithOpName("layer1"), dequeue[0], var);
+    Output layer2 = ops::Mul(s.WithOpName("layer2"), layer1, layer1);
+    Output ones = ops::OnesLike(s.WithOpName("gradients/OnesLike"), layer2);
+    Output grad2 =
+        ops::Mul(s.WithOpName("gradients/layer2_grad/Mul"), ones, layer1);
+    Output grad1 = ops::Mul(s.WithOpName("gradients/layer1_grad/Mul"), grad2,
+                            dequeue[0]);
+    Output learning_rate =
+        ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+    Output apply_gradient = ops::ApplyGradientDescent(
+        s.WithOpName("apply_gradient"), {var}, {learning_rate}, {grad1});
+
+    GrapplerItem item;
+    item.init_ops.push_back("assign");
+    item.fetch.push_back("apply_gradient");
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+
+  std::unique_ptr<VirtualCluster> cluster_;
+};
+
+const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+  for (const NodeDef& node : graph.node()) {
+    if (node.name() == name) return &node;
+  }
+  return nullptr;
+}
+
+TEST_F(PipelineParallelTest, AssignsStages) {
+  GrapplerItem item = TrainingItem();
+  PipelineParallel pipeline(2, 1);
+  GraphDef output;
+  TF_EXPECT_OK(pipeline.Optimize(cluster_.get(), item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+
+  const NodeDef* layer1 = FindNode(output, "layer1");
+  const NodeDef* layer2 = FindNode(output, "layer2");
+  ASSERT_NE(layer1, nullptr);
+  ASSERT_NE(layer2, nullptr);
+  EXPECT_FALSE(layer1->device().empty());
+  // The stages are contiguous in the topological order.
+  EXPECT_LE(layer1->device(), layer2->device());
+
+  // The backward nodes run in the stage of their forward node.
+  EXPECT_EQ(layer1->device(),
+            FindNode(output, "gradients/layer1_grad/Mul")->device());
+  EXPECT_EQ(layer2->device(),
+            FindNode(output, "gradients/layer2_grad/Mul")->device());
+  EXPECT_EQ(layer2->device(), FindNode(output, "gradients/OnesLike")->device());
+
+  // The variable is updated in the stage of its gradient.
+  EXPECT_EQ(layer1->device(), FindNode(output, "apply_gradient")->device());
+  EXPECT_EQ(layer1->device(), FindNode(output, "var")->device());
+  EXPECT_TRUE(FindNode(output, "dequeue")->device().empty());
+
+  EXPECT_EQ(2, pipeline.stage_costs().size());
+  // Without micro-batches, only one stage runs at a time.
+  EXPECT_GE(pipeline.predicted_bubble_overhead(), 0.5);
+  EXPECT_LT(pipeline.predicted_bubble_overhead(), 1.0);
+}
+
+TEST_F(PipelineParallelTest, MicroBatches) {
+  GrapplerItem item = TrainingItem();
+  PipelineParallel pipeline(2, 2);
+  GraphDef output;
+  TF_EXPECT_OK(pipeline.Optimize(cluster_.get(), item, &output));
+
+  // The pipelined nodes are copied for the second micro-batch, which
+  // dequeues its own batch.
+  const NodeDef* dequeue =
+      FindNode(output, "PipelineParallel-MicroBatch-1/dequeue");
+  ASSERT_NE(dequeue, nullptr);
+  EXPECT_EQ("fifo_queue", dequeue->input(0));
+  const NodeDef* layer1 =
+      FindNode(output, "PipelineParallel-MicroBatch-1/layer1");
+  ASSERT_NE(layer1, nullptr);
+  EXPECT_EQ("PipelineParallel-MicroBatch-1/dequeue", layer1->input(0));
+  EXPECT_EQ("var", layer1->input(1));
+  EXPECT_EQ(FindNode(output, "layer1")->device(), layer1->device());
+  EXPECT_EQ(nullptr, FindNode(output, "PipelineParallel-MicroBatch-1/var"));
+  EXPECT_EQ(nullptr,
+            FindNode(output, "PipelineParallel-MicroBatch-1/fifo_queue"));
+
+  // The variable is updated with the average of the gradients.
+  const NodeDef* add = FindNode(output, "PipelineParallel-AddN-apply_gradient");
+  ASSERT_NE(add, nullptr);
+  ASSERT_EQ(2, add->input_size());
+  EXPECT_EQ("gradients/layer1_grad/Mul", add->input(0));
+  EXPECT_EQ("PipelineParallel-MicroBatch-1/gradients/layer1_grad/Mul",
+            add->input(1));
+  const NodeDef* div = FindNode(output, "PipelineParallel-Div-apply_gradient");
+  ASSERT_NE(div, nullptr);
+  EXPECT_EQ("RealDiv", div->op());
+  EXPECT_EQ(add->name(), div->input(0));
+  EXPECT_EQ("PipelineParallel-NumMicroBatches-apply_gradient", div->input(1));
+  const NodeDef* apply = FindNode(output, "apply_gradient");
+  EXPECT_EQ(div->name(), apply->input(2));
+  EXPECT_EQ(apply->device(), div->device());
+
+  // Micro-batches fill the pipeline.
+  PipelineParallel no_micro_batches(2, 1);
+  TF_EXPECT_OK(no_micro_batches.Optimize(cluster_.get(), item, &output));
+  EXPECT_LT(pipeline.predicted_bubble_overhead(),
+            no_micro_batches.predicted_bubble_overhead());
+}
+
+TEST_F(PipelineParallelTest, InvalidArguments) {
+  GrapplerItem item = TrainingItem();
+  GraphDef output;
+  EXPECT_FALSE(
+      PipelineParallel(1, 1).Optimize(cluster_.get(), item, &output).ok());
+  EXPECT_FALSE(
+      PipelineParallel(2, 0).Optimize(cluster_.get(), item, &output).ok());
+
+  // Micro-batches need a queue to dequeue their batch from.
+  tensorflow::Scope s = tensorflow::Scope::DisabledShapeInferenceScope();
+  Output var = ops::Variable(s.WithOpName("var"), {1}, DT_FLOAT);
+  Output input = ops::Const(s.WithOpName("input"), 1.0f, {1});
+  Output grad = ops::Mul(s.WithOpName("gradients/mul_grad/Mul"), input, var);
+  Output learning_rate = ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+  Output apply_gradient = ops::ApplyGradientDescent(
+      s.WithOpName("apply_gradient"), {var}, {learning_rate}, {grad});
+  GrapplerItem no_queue;
+  no_queue.fetch.push_back("apply_gradient");
+  TF_CHECK_OK(s.ToGraphDef(&no_queue.graph));
+  EXPECT_FALSE(
+      PipelineParallel(2, 2).Optimize(cluster_.get(), no_queue, &output).ok());
+  TF_EXPECT_OK(
+      PipelineParallel(2, 1).Optimize(cluster_.get(), no_queue, &output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
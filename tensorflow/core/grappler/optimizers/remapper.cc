@@ -59,6 +59,17 @@ namespace grappler {
 //   (1) FusedBatchNorm + <Activation>
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
+// GatherV2 + SparseSegment{Sum,Mean,SqrtN}[WithNumSegments] ->
+// SparseSegment{Sum,Mean,SqrtN}[WithNumSegments] of the gathered tensor, whose
+// kernels gather and reduce rows in one pass:
+//   SparseSegmentSum(GatherV2(params, ids, 0), indices, segment_ids) ->
+//   SparseSegmentSum(params, GatherV2(ids, indices, 0), segment_ids)
+//
+// BatchMatMul + Softmax + BatchMatMul -> _FusedAttention, which does not
+// materialize the attention scores:
+//   (1) BatchMatMul(Softmax(BatchMatMul(q, k, adj_y) <* scale> <+ mask>), v)
+//   The scale is a scalar constant, and may also divide the scores.
+//
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
@@ -69,6 +80,7 @@ constexpr char kFusedConv2D[] = "_FusedConv2D";
 constexpr char kFusedMatMul[] = "_FusedMatMul";
 constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
+constexpr char kFusedAttention[] = "_FusedAttention";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -108,6 +120,29 @@ struct FusedBatchNormEx {
   int invalidated = kMissingIndex;
 };
 
+// GatherV2 whose output is only reduced by a SparseSegment reduction.
+struct SparseSegmentReductionWithGather {
+  SparseSegmentReductionWithGather() = default;
+
+  int gather = kMissingIndex;
+  int reduction = kMissingIndex;
+};
+
+// Scaled dot product attention: the product of the softmax of the optionally
+// scaled and masked scores BatchMatMul(query, key, adj_y=true) with the values.
+struct Attention {
+  Attention() = default;
+
+  int scores = kMissingIndex;
+  int scale = kMissingIndex;
+  int mask = kMissingIndex;
+  int softmax = kMissingIndex;
+  int output = kMissingIndex;
+  // Input port of the mask in the mask Add node.
+  int mask_port = 1;
+  float scale_value = 1.0f;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -809,6 +844,272 @@ bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+bool IsSparseSegmentReduction(const NodeDef& node) {
+  static const auto* const kOps = new absl::flat_hash_set<string>(
+      {"SparseSegmentSum", "SparseSegmentSumWithNumSegments",
+       "SparseSegmentMean", "SparseSegmentMeanWithNumSegments",
+       "SparseSegmentSqrtN", "SparseSegmentSqrtNWithNumSegments"});
+  return kOps->contains(node.op());
+}
+
+// Returns true if `node` is a constant scalar equal to zero.
+bool IsConstantScalarZero(const NodeDef& node) {
+  if (!IsConstant(node)) return false;
+  const auto value_attr = node.attr().find("value");
+  if (value_attr == node.attr().end()) return false;
+  Tensor value;
+  if (!value.FromProto(value_attr->second.tensor())) return false;
+  if (!TensorShapeUtils::IsScalar(value.shape())) return false;
+  if (value.dtype() == DT_INT32) return value.scalar<int32>()() == 0;
+  if (value.dtype() == DT_INT64) return value.scalar<int64>()() == 0;
+  return false;
+}
+
+bool FindSparseSegmentReductionWithGather(
+    const RemapperContext& ctx, int node_index,
+    SparseSegmentReductionWithGather* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsSparseSegmentReduction(*node_def)) return false;
+  if (node_view->NumRegularFanins() < 3) return false;
+
+  const auto& data_fanin = node_view->GetRegularFanin(0);
+  if (data_fanin.index() != 0) return false;
+  const auto* gather_view = data_fanin.node_view();
+  const auto* gather_def = gather_view->node();
+  if (gather_def->op() != "GatherV2") return false;
+  if (IsInPreserveSet(ctx, gather_def)) return false;
+  if (gather_def->device() != node_def->device()) return false;
+  if (GetDataTypeFromAttr(*node_def, "T") !=
+      GetDataTypeFromAttr(*gather_def, "Tparams")) {
+    return false;
+  }
+
+  int batch_dims = 0;
+  if (TryGetNodeAttr(*gather_def, "batch_dims", &batch_dims) &&
+      batch_dims != 0) {
+    return false;
+  }
+  if (gather_view->NumRegularFanins() != 3) return false;
+  const auto* axis_def = gather_view->GetRegularFanin(2).node_view()->node();
+  if (!IsConstantScalarZero(*axis_def)) return false;
+
+  // The gathered rows must not be used by anything but the reduction.
+  if (gather_view->GetRegularFanouts().size() != 1 ||
+      gather_view->GetRegularFanout(0).size() != 1) {
+    return false;
+  }
+
+  matched->gather = gather_view->node_index();
+  matched->reduction = node_index;
+  return true;
+}
+
+// Returns true if `node` is a constant holding a single floating point value,
+// which is returned in `value`.
+bool GetConstantScalarValue(const NodeDef& node, float* value) {
+  if (!IsConstant(node)) return false;
+  const auto value_attr = node.attr().find("value");
+  if (value_attr == node.attr().end()) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(value_attr->second.tensor())) return false;
+  if (tensor.NumElements() != 1) return false;
+  switch (tensor.dtype()) {
+    case DT_HALF:
+      *value = static_cast<float>(tensor.flat<Eigen::half>()(0));
+      return true;
+    case DT_FLOAT:
+      *value = tensor.flat<float>()(0);
+      return true;
+    case DT_DOUBLE:
+      *value = static_cast<float>(tensor.flat<double>()(0));
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsBatchMatMulWithAdjoints(const NodeDef& node, bool adj_x, bool adj_y) {
+  if (!IsAnyBatchMatMul(node)) return false;
+  bool node_adj_x = false;
+  bool node_adj_y = false;
+  TryGetNodeAttr(node, "adj_x", &node_adj_x);
+  TryGetNodeAttr(node, "adj_y", &node_adj_y);
+  return node_adj_x == adj_x && node_adj_y == adj_y;
+}
+
+// Returns true if a mask of `mask_shape` broadcasts to `scores_shape` without
+// alternating broadcast and non broadcast batch dimensions more than once, as
+// required by the _FusedAttention kernel.
+bool IsSupportedAttentionMask(const TensorShapeProto& mask_shape,
+                              const TensorShapeProto& scores_shape) {
+  const int rank = Rank(scores_shape);
+  const int mask_rank = Rank(mask_shape);
+  if (mask_rank < 0 || mask_rank > rank) return false;
+  // Number of runs of broadcast and of non broadcast batch dimensions.
+  int num_runs = 0;
+  bool last_broadcast = false;
+  for (int i = 0; i < rank; ++i) {
+    const auto& dim = scores_shape.dim(i);
+    const int mask_index = i - (rank - mask_rank);
+    bool broadcast = true;
+    if (mask_index >= 0) {
+      const auto& mask_dim = mask_shape.dim(mask_index);
+      if (mask_dim.size() != 1) {
+        if (!IsKnownSymbolically(mask_dim) || mask_dim.size() != dim.size()) {
+          return false;
+        }
+        broadcast = false;
+      }
+    }
+    if (i >= rank - 2 || dim.size() == 1) continue;
+    if (num_runs == 0 || broadcast != last_broadcast) ++num_runs;
+    last_broadcast = broadcast;
+  }
+  return num_runs <= 2;
+}
+
+bool FindAttention(const RemapperContext& ctx, int node_index,
+                   Attention* matched) {
+  if (!ctx.inferred_graph_properties) return false;
+
+  // Root of the pattern must be a BatchMatMul of the probabilities and values.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsBatchMatMulWithAdjoints(*node_def, false, false)) return false;
+  if (HasControlFaninOrFanout(*node_view)) return false;
+  if (node_view->NumRegularFanins() != 2) return false;
+
+  // The intermediate nodes are removed, so they must not be used elsewhere.
+  const auto is_fusable = [&](const utils::MutableNodeView& view) -> bool {
+    const auto* def = view.node();
+    return !HasControlFaninOrFanout(view) && HasAtMostOneFanoutAtPort0(view) &&
+           view.NumRegularFanouts() == 1 && !IsInPreserveSet(ctx, def) &&
+           def->device() == node_def->device() &&
+           HaveSameDataType(node_def, def);
+  };
+
+  const auto* softmax_view = node_view->GetRegularFanin(0).node_view();
+  if (!IsSoftmax(*softmax_view->node()) || !is_fusable(*softmax_view)) {
+    return false;
+  }
+
+  Attention attention;
+  attention.output = node_index;
+  attention.softmax = softmax_view->node_index();
+
+  // Optional mask, added to the scaled scores on either side.
+  const auto* scores_view = softmax_view->GetRegularFanin(0).node_view();
+  if (IsAdd(*scores_view->node()) && is_fusable(*scores_view) &&
+      scores_view->NumRegularFanins() == 2) {
+    for (int port : {1, 0}) {
+      const auto* lhs_view = scores_view->GetRegularFanin(1 - port).node_view();
+      const auto* lhs_def = lhs_view->node();
+      if (IsMul(*lhs_def) || IsRealDiv(*lhs_def) ||
+          IsAnyBatchMatMul(*lhs_def)) {
+        attention.mask = scores_view->node_index();
+        attention.mask_port = port;
+        scores_view = lhs_view;
+        break;
+      }
+    }
+    if (attention.mask == kMissingIndex) return false;
+  }
+
+  // Optional scale, multiplying the scores on either side or dividing them.
+  const auto* scale_view = scores_view;
+  const auto* scale_def = scale_view->node();
+  if ((IsMul(*scale_def) || IsRealDiv(*scale_def)) &&
+      is_fusable(*scale_view) && scale_view->NumRegularFanins() == 2) {
+    int scores_port = -1;
+    float value = 1.0f;
+    for (int port : {0, 1}) {
+      if (port == 1 && IsRealDiv(*scale_def)) break;
+      const auto* const_def =
+          scale_view->GetRegularFanin(1 - port).node_view()->node();
+      if (GetConstantScalarValue(*const_def, &value)) {
+        scores_port = port;
+        break;
+      }
+    }
+    if (scores_port < 0) return false;
+    if (IsRealDiv(*scale_def)) {
+      if (value == 0.0f) return false;
+      value = 1.0f / value;
+    }
+    attention.scale = scale_view->node_index();
+    attention.scale_value = value;
+    scores_view = scale_view->GetRegularFanin(scores_port).node_view();
+  }
+
+  if (!IsBatchMatMulWithAdjoints(*scores_view->node(), false, true) ||
+      !is_fusable(*scores_view) || scores_view->NumRegularFanins() != 2) {
+    return false;
+  }
+  attention.scores = scores_view->node_index();
+
+  const auto* scores_def = scores_view->node();
+  const auto& scores_props =
+      ctx.graph_properties.GetInputProperties(scores_def->name());
+  const auto& value_props =
+      ctx.graph_properties.GetInputProperties(node_def->name());
+  if (scores_props.size() != 2 || value_props.size() != 2) return false;
+  const TensorShapeProto& query_shape = scores_props[0].shape();
+  const TensorShapeProto& key_shape = scores_props[1].shape();
+  const TensorShapeProto& value_shape = value_props[1].shape();
+  const int rank = Rank(query_shape);
+  if (rank < 3 || Rank(key_shape) != rank || Rank(value_shape) != rank) {
+    return false;
+  }
+  // The fused op does not broadcast the batch dimensions.
+  const auto dims_equal = [](const TensorShapeProto::Dim& lhs,
+                             const TensorShapeProto::Dim& rhs) {
+    return !IsUnknown(lhs) && lhs.size() == rhs.size();
+  };
+  for (int i = 0; i < rank - 2; ++i) {
+    if (!dims_equal(query_shape.dim(i), key_shape.dim(i)) ||
+        !dims_equal(query_shape.dim(i), value_shape.dim(i))) {
+      return false;
+    }
+  }
+  // Neither the scale nor the mask may broadcast the scores.
+  if (attention.scale != kMissingIndex) {
+    const auto& props = ctx.graph_properties.GetOutputProperties(
+        ctx.graph_view.GetNode(attention.scale)->GetName());
+    const auto& scores_output =
+        ctx.graph_properties.GetOutputProperties(scores_def->name());
+    if (props.empty() || scores_output.empty() ||
+        !ShapesSymbolicallyEqual(props[0].shape(), scores_output[0].shape())) {
+      return false;
+    }
+  }
+  if (attention.mask != kMissingIndex) {
+    const auto* mask_add_def = ctx.graph_view.GetNode(attention.mask)->node();
+    const auto& props =
+        ctx.graph_properties.GetInputProperties(mask_add_def->name());
+    const auto& output_props =
+        ctx.graph_properties.GetOutputProperties(mask_add_def->name());
+    if (props.size() != 2 || output_props.empty()) return false;
+    const TensorShapeProto& mask_shape = props[attention.mask_port].shape();
+    const TensorShapeProto& scores_shape =
+        props[1 - attention.mask_port].shape();
+    if (!ShapesSymbolicallyEqual(scores_shape, output_props[0].shape()) ||
+        !IsSupportedAttentionMask(mask_shape, scores_shape)) {
+      return false;
+    }
+  }
+
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  const bool is_supported_type =
+      NodeIsOnCpu(node_def) ? dtype == DT_FLOAT || dtype == DT_DOUBLE
+                            : NodeIsOnGpu(node_def) &&
+                                  (dtype == DT_FLOAT || dtype == DT_HALF);
+  if (!is_supported_type) return false;
+
+  *matched = attention;
+  return true;
+}
+
 // NOTE(ezhulenev): See `BatchnormSpatialPersistentEnabled` documentation in the
 // `tensorflow/stream_executor/cuda/cuda_dnn.cc` for details.
 bool BatchnormSpatialPersistentEnabled() {
@@ -1620,6 +1921,91 @@ Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
   return mutation->Apply();
 }
 
+// Moves the gather of `matched` from the rows of params to their ids, so that
+// the reduction reads params rows directly instead of a gathered copy of them.
+// Both nodes keep their names, so that control dependencies are preserved.
+Status AddSparseSegmentReductionWithGatherNodes(
+    RemapperContext* ctx, const SparseSegmentReductionWithGather& matched,
+    std::vector<bool>* invalidated_nodes) {
+  auto* gather_view = ctx->graph_view.GetNode(matched.gather);
+  auto* reduction_view = ctx->graph_view.GetNode(matched.reduction);
+  const NodeDef& gather = *gather_view->node();
+  const NodeDef& reduction = *reduction_view->node();
+  VLOG(2) << "Fuse " << gather.op() << " into " << reduction.op()
+          << ": gather=" << gather.name()
+          << " reduction=" << reduction.name();
+
+  const string params = gather.input(0);
+  const string ids = gather.input(1);
+  const string indices = reduction.input(1);
+  AttrValue ids_type;
+  ids_type.set_type(GetDataTypeFromAttr(gather, "Tindices"));
+  AttrValue indices_type;
+  indices_type.set_type(GetDataTypeFromAttr(reduction, "Tidx"));
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  mutation->AddOrUpdateRegularFanin(gather_view, 0, ParseTensorName(ids));
+  mutation->AddOrUpdateRegularFanin(gather_view, 1, ParseTensorName(indices));
+  mutation->AddOrUpdateNodeAttr(gather_view, "Tparams", ids_type);
+  mutation->AddOrUpdateNodeAttr(gather_view, "Tindices", indices_type);
+  mutation->AddOrUpdateRegularFanin(reduction_view, 0, ParseTensorName(params));
+  mutation->AddOrUpdateRegularFanin(reduction_view, 1, {gather.name(), 0});
+  mutation->AddOrUpdateNodeAttr(reduction_view, "Tidx", ids_type);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.gather] = true;
+  (*invalidated_nodes)[matched.reduction] = true;
+
+  return Status::OK();
+}
+
+Status AddFusedAttentionNode(RemapperContext* ctx, const Attention& matched,
+                             std::vector<bool>* invalidated_nodes,
+                             std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& scores = graph->node(matched.scores);
+  const NodeDef& output = graph->node(matched.output);
+  VLOG(2) << "Fuse attention: scores=" << scores.name()
+          << " output=" << output.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(output.name());
+  fused_op.set_op(kFusedAttention);
+  fused_op.set_device(output.device());
+  fused_op.add_input(scores.input(0));  // 0: query
+  fused_op.add_input(scores.input(1));  // 1: key
+  fused_op.add_input(output.input(1));  // 2: value
+  int num_args = 0;
+  if (matched.mask != kMissingIndex) {
+    const NodeDef& mask = graph->node(matched.mask);
+    fused_op.add_input(mask.input(matched.mask_port));  // 3: mask
+    ++num_args;
+  }
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = output.attr().at("T");
+  SetAttrValue(num_args, &(*attr)["num_args"]);
+  SetAttrValue(matched.scale_value, &(*attr)["scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.output] = true;
+  (*nodes_to_delete)[matched.scores] = true;
+  if (matched.scale != kMissingIndex) {
+    (*nodes_to_delete)[matched.scale] = true;
+  }
+  if (matched.mask != kMissingIndex) {
+    (*nodes_to_delete)[matched.mask] = true;
+  }
+  (*nodes_to_delete)[matched.softmax] = true;
+
+  return Status::OK();
+}
+
 #ifdef INTEL_MKL
 bool IsConv2DWithAdd(const RemapperContext& ctx, int node_index) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1667,6 +2053,7 @@ bool IsConv2DWithAdd(const RemapperContext& ctx, int node_index) {
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
+//   (5) Fusing BatchMatMul + Softmax + BatchMatMul into _FusedAttention.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1737,12 +2124,19 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
+  // Candidate for an attention fusion.
+  const auto is_attention_candidate = [&]() -> bool {
+    if (!IsBatchMatMulWithAdjoints(*node_def, false, false)) return false;
+    if (node_view->NumRegularFanins() < 1) return false;
+    return IsSoftmax(*node_view->GetRegularFanin(0).node_view()->node());
+  };
+
 #ifdef INTEL_MKL
   return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
-         IsConv2DWithAdd(ctx, node_index);
+         IsConv2DWithAdd(ctx, node_index) || is_attention_candidate();
 #else
   return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
-         is_batch_norm_fusion_candidate();
+         is_batch_norm_fusion_candidate() || is_attention_candidate();
 #endif  // INTEL_MKL
 }
 
@@ -1894,6 +2288,27 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap GatherV2+SparseSegmentReduction into a SparseSegmentReduction of
+    // the gathered params. The gradient of the fused reduction with respect to
+    // params is dense, unlike the one of GatherV2.
+    SparseSegmentReductionWithGather sparse_segment_reduction_with_gather;
+    if (allow_non_differentiable_rewrites &&
+        FindSparseSegmentReductionWithGather(
+            ctx, i, &sparse_segment_reduction_with_gather)) {
+      TF_RETURN_IF_ERROR(AddSparseSegmentReductionWithGatherNodes(
+          &ctx, sparse_segment_reduction_with_gather, &invalidated_nodes));
+      continue;
+    }
+
+    // Remap BatchMatMul+Softmax+BatchMatMul into the _FusedAttention.
+    Attention attention;
+    if (allow_non_differentiable_rewrites &&
+        FindAttention(ctx, i, &attention)) {
+      TF_RETURN_IF_ERROR(AddFusedAttentionNode(
+          &ctx, attention, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
@@ -980,5 +980,196 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
 }
 #endif  // !INTEL_MKL
 
+TEST_F(RemapperTest, FuseGatherIntoSparseSegmentReduction) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto params = ops::Const(s.WithOpName("params"),
+                           {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f},
+                           {4, 2});
+  auto ids = ops::Const(s.WithOpName("ids"), {3, 0, 2}, {3});
+  auto axis = ops::Const(s.WithOpName("axis"), 0, {});
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+  auto indices = ops::Const(s.WithOpName("indices"), {0, 1, 1, 2, 0}, {5});
+  auto segment_ids =
+      ops::Const(s.WithOpName("segment_ids"), {0, 0, 1, 1, 3}, {5});
+  auto sum = ops::SparseSegmentSum(s.WithOpName("sum"), gather, indices,
+                                   segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), sum);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "sum") {
+      EXPECT_EQ(node.op(), "SparseSegmentSum");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "params");
+      EXPECT_EQ(node.input(1), "gather");
+      EXPECT_EQ(node.input(2), "segment_ids");
+      found++;
+    } else if (node.name() == "gather") {
+      EXPECT_EQ(node.op(), "GatherV2");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "ids");
+      EXPECT_EQ(node.input(1), "indices");
+      EXPECT_EQ(node.attr().at("Tparams").type(), DT_INT32);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+}
+
+TEST_F(RemapperTest, DoNotFuseGatherWithOtherConsumers) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto params = ops::Const(s.WithOpName("params"), {1.0f, 2.0f, 3.0f, 4.0f},
+                           {2, 2});
+  auto ids = ops::Const(s.WithOpName("ids"), {1, 0}, {2});
+  auto axis = ops::Const(s.WithOpName("axis"), 0, {});
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+  auto indices = ops::Const(s.WithOpName("indices"), {0, 1}, {2});
+  auto segment_ids = ops::Const(s.WithOpName("segment_ids"), {0, 0}, {2});
+  auto mean = ops::SparseSegmentMean(s.WithOpName("mean"), gather, indices,
+                                     segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), mean);
+  auto other = ops::Identity(s.WithOpName("other"), gather);
+
+  GrapplerItem item;
+  item.fetch = {"fetch", "other"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "mean") {
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "gather");
+    }
+  }
+}
+
+TEST_F(RemapperTest, FuseAttention) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto query_shape = ops::Placeholder::Shape({2, 3, 4, 8});
+  auto key_shape = ops::Placeholder::Shape({2, 3, 6, 8});
+  auto value_shape = ops::Placeholder::Shape({2, 3, 6, 5});
+  auto mask_shape = ops::Placeholder::Shape({2, 1, 1, 6});
+
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT, query_shape);
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT, key_shape);
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT, value_shape);
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT, mask_shape);
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto scale = ops::Const(s.WithOpName("scale"), 8.0f, {});
+  auto scaled = ops::RealDiv(s.WithOpName("scaled"), scores, scale);
+  auto masked = ops::AddV2(s.WithOpName("masked"), mask, scaled);
+  auto probabilities = ops::Softmax(s.WithOpName("probabilities"), masked);
+  auto attention =
+      ops::BatchMatMulV2(s.WithOpName("attention"), probabilities, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+  auto query_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 4, 8});
+  auto key_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 6, 8});
+  auto value_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 6, 5});
+  auto mask_t = GenerateRandomTensor<DT_FLOAT>({2, 1, 1, 6});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"query", query_t},
+               {"key", key_t},
+               {"value", value_t},
+               {"mask", mask_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "scores");
+    EXPECT_NE(node.name(), "scaled");
+    EXPECT_NE(node.name(), "masked");
+    EXPECT_NE(node.name(), "probabilities");
+    if (node.name() == "attention") {
+      EXPECT_EQ(node.op(), "_FusedAttention");
+      ASSERT_EQ(node.input_size(), 4);
+      EXPECT_EQ(node.input(0), "query");
+      EXPECT_EQ(node.input(1), "key");
+      EXPECT_EQ(node.input(2), "value");
+      EXPECT_EQ(node.input(3), "mask");
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+      EXPECT_EQ(node.attr().at("scale").f(), 0.125f);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, DoNotFuseAttentionWithFetchedProbabilities) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto shape = ops::Placeholder::Shape({2, 4, 8});
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT, shape);
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT, shape);
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT, shape);
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto probabilities = ops::Softmax(s.WithOpName("probabilities"), scores);
+  auto attention =
+      ops::BatchMatMulV2(s.WithOpName("attention"), probabilities, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+  auto other = ops::Identity(s.WithOpName("other"), probabilities);
+
+  GrapplerItem item;
+  item.fetch = {"fetch", "other"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "attention") {
+      EXPECT_EQ(node.op(), "BatchMatMulV2");
+    }
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/profiled_op_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
@@ -33,6 +34,7 @@ static Costs::NanoSeconds PredictExecutionTime(
     const GraphProperties& properties, const OpLevelCostEstimator& estimator,
     const VirtualPlacer& placer, const NodeDef& node) {
   OpContext op_context;
+  op_context.name = node.name();
   op_context.op_info.set_op(node.op());
   *op_context.op_info.mutable_attr() = node.attr();
 
@@ -98,7 +100,7 @@ Status EstimateEarliestExecutionTimes(
       properties.InferStatically(/*assume_valid_feeds=*/true,
                                  /*aggressive_shape_inference=*/false,
                                  /*include_tensor_values=*/false));
-  OpLevelCostEstimator estimator;
+  std::unique_ptr<OpLevelCostEstimator> estimator = NewOpLevelCostEstimator();
   VirtualPlacer placer(cluster->GetDevices());
 
   while (!ready_nodes.empty()) {
@@ -106,7 +108,7 @@ Status EstimateEarliestExecutionTimes(
     ready_nodes.pop_front();
 
     Costs::NanoSeconds execution_time =
-        PredictExecutionTime(properties, estimator, placer, *node);
+        PredictExecutionTime(properties, *estimator, placer, *node);
     Costs::NanoSeconds completion_time =
         execution_time + (*completion_times)[node];
     (*completion_times)[node] = completion_time;
@@ -169,7 +171,7 @@ Status EstimateRequiredTimes(
       properties.InferStatically(/*assume_valid_feeds=*/true,
                                  /*aggressive_shape_inference=*/false,
                                  /*include_tensor_values=*/false));
-  OpLevelCostEstimator estimator;
+  std::unique_ptr<OpLevelCostEstimator> estimator = NewOpLevelCostEstimator();
   VirtualPlacer placer(cluster->GetDevices());
 
   while (!ready_nodes.empty()) {
@@ -177,7 +179,7 @@ Status EstimateRequiredTimes(
     ready_nodes.pop_front();
 
     Costs::NanoSeconds execution_time =
-        PredictExecutionTime(properties, estimator, placer, *node);
+        PredictExecutionTime(properties, *estimator, placer, *node);
     Costs::NanoSeconds required_time = (*required_times)[node] - execution_time;
 
     for (const string& fanin_name : node->input()) {
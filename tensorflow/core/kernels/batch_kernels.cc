@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_policy.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
@@ -70,19 +71,35 @@ class BatchResource : public serving::BatchResourceBase {
                        const std::vector<int32>& allowed_batch_sizes,
                        FunctionLibraryRuntime::Handle fhandle,
                        bool enable_large_batch_splitting,
+                       int64 target_latency_micros,
+                       bool enable_ragged_batching,
                        std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
     std::shared_ptr<BatcherT> batcher;
     TF_RETURN_IF_ERROR(BatcherT::Create(batcher_options, &batcher));
 
+    std::shared_ptr<serving::LatencySloBatchPolicy> latency_slo_policy;
+    if (target_latency_micros > 0) {
+      serving::LatencySloBatchPolicy::Options policy_options;
+      policy_options.target_latency_micros = target_latency_micros;
+      policy_options.max_batch_size = max_batch_size;
+      policy_options.allowed_batch_sizes = allowed_batch_sizes;
+      policy_options.initial_batch_timeout_micros = batch_timeout_micros;
+      std::unique_ptr<serving::LatencySloBatchPolicy> policy;
+      TF_RETURN_IF_ERROR(
+          serving::LatencySloBatchPolicy::Create(policy_options, &policy));
+      latency_slo_policy = std::move(policy);
+    }
+
     resource->reset(new BatchResource(
         fhandle, std::move(batcher),
         GetBatcherQueueOptions(num_batch_threads, max_batch_size,
                                batch_timeout_micros, max_enqueued_batches,
                                allowed_batch_sizes,
                                enable_large_batch_splitting),
-        allowed_batch_sizes));
+        allowed_batch_sizes, std::move(latency_slo_policy),
+        enable_ragged_batching));
     return Status::OK();
   }
 
@@ -92,11 +109,15 @@ class BatchResource : public serving::BatchResourceBase {
   BatchResource(FunctionLibraryRuntime::Handle fhandle,
                 std::shared_ptr<BatcherT> batcher,
                 const BatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                std::shared_ptr<serving::LatencySloBatchPolicy>
+                    latency_slo_policy,
+                bool enable_ragged_batching)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), std::move(latency_slo_policy),
+            enable_ragged_batching),
         fhandle_(fhandle) {}
 
   void ProcessFuncBatchImpl(
@@ -164,6 +185,25 @@ class BatchFunctionKernel : public AsyncOpKernel {
       has_attribute_enable_large_batch_splitting_ = false;
     }
 
+    if (c->HasAttr("target_latency_micros")) {
+      OP_REQUIRES_OK(
+          c, c->GetAttr("target_latency_micros", &target_latency_micros_));
+    } else {
+      target_latency_micros_ = 0;
+    }
+
+    if (c->HasAttr("enable_ragged_batching")) {
+      OP_REQUIRES_OK(
+          c, c->GetAttr("enable_ragged_batching", &enable_ragged_batching_));
+    } else {
+      enable_ragged_batching_ = false;
+    }
+    OP_REQUIRES(c, !enable_ragged_batching_ || allowed_batch_sizes_.empty(),
+                errors::InvalidArgument(
+                    "allowed_batch_sizes must be empty when "
+                    "enable_ragged_batching is true, as ragged batches are "
+                    "not padded"));
+
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
   }
 
@@ -181,7 +221,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, fhandle_,
-          enable_large_batch_splitting_, &new_resource));
+          enable_large_batch_splitting_, target_latency_micros_,
+          enable_ragged_batching_, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -234,6 +275,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
   FunctionLibraryRuntime::Handle fhandle_;
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
+  int64 target_latency_micros_;
+  bool enable_ragged_batching_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("BatchFunction").Device(DEVICE_CPU),
@@ -267,6 +310,7 @@ class BatchKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle, false,
+          /*target_latency_micros=*/0, /*enable_ragged_batching=*/false,
           &new_resource));
       *r = new_resource.release();
       return Status::OK();
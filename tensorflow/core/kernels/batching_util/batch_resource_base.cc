@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include <limits>
+
+#include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/ops_util.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/percentile_sampler.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
@@ -74,6 +78,30 @@ void RecordBatchDelayMs(int64 batch_delay_ms, const string& model_name) {
   cell->GetCell(model_name)->Add(static_cast<double>(batch_delay_ms));
 }
 
+void RecordLatencySloPolicy(const LatencySloBatchPolicy& policy,
+                            const string& model_name) {
+  static auto* batch_timeout_cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/adaptive_batch_timeout_micros",
+      "Tracks the batch timeout adapted to the latency target of the batch "
+      "function by model_name (if available).",
+      "model_name");
+  static auto* batch_size_cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/adaptive_batch_size",
+      "Tracks the size from which batches are scheduled without waiting for "
+      "the timeout, adapted to the latency target of the batch function by "
+      "model_name (if available).",
+      "model_name");
+  static auto* p99_latency_cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/p99_latency_micros",
+      "Tracks the 99th percentile of the latency of the inputs of the batch "
+      "function, from their batching to the end of their processing, by "
+      "model_name (if available).",
+      "model_name");
+  batch_timeout_cell->GetCell(model_name)->Set(policy.batch_timeout_micros());
+  batch_size_cell->GetCell(model_name)->Set(policy.target_batch_size());
+  p99_latency_cell->GetCell(model_name)->Set(policy.p99_latency_micros());
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -87,6 +115,50 @@ using ::tensorflow::concat_split_util::Concat;
 using ::tensorflow::concat_split_util::Split;
 using TensorMatrix = std::vector<std::vector<Tensor>>;
 
+BatchResourceBase::BatchResourceBase(
+    bool has_process_batch_function, std::shared_ptr<BatcherT> batcher,
+    const BatcherT::QueueOptions& batcher_queue_options,
+    std::vector<int32> allowed_batch_sizes,
+    std::shared_ptr<LatencySloBatchPolicy> latency_slo_policy,
+    bool enable_ragged_batching)
+    : has_process_batch_function_(has_process_batch_function),
+      batcher_(std::move(batcher)),
+      batcher_queue_options_(batcher_queue_options),
+      allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+      latency_slo_policy_(std::move(latency_slo_policy)),
+      enable_ragged_batching_(enable_ragged_batching) {
+  // Completes the tasks of the cancelled steps without processing them.
+  batcher_queue_options_.expired_task_callback =
+      [](std::unique_ptr<BatchTask> task) {
+        const Status status = errors::DeadlineExceeded(
+            "The step was cancelled before its batch was processed");
+        if (task->is_partial) {
+          task->status->Update(status);
+        } else {
+          task->context->SetStatus(status);
+        }
+        task->done_callback();
+      };
+  if (latency_slo_policy_ != nullptr) {
+    LatencySloBatchPolicy* policy = latency_slo_policy_.get();
+    // The queues are destroyed with this resource, before the policy.
+    batcher_queue_options_.batch_timeout_micros_func = [policy] {
+      return policy->batch_timeout_micros();
+    };
+    batcher_queue_options_.schedulable_batch_size_func = [policy] {
+      return static_cast<size_t>(policy->target_batch_size());
+    };
+  }
+}
+
+uint64 BatchResourceBase::BatchTask::deadline_micros() const {
+  if (context != nullptr && context->cancellation_manager() != nullptr &&
+      context->cancellation_manager()->IsCancelled()) {
+    return 0;
+  }
+  return std::numeric_limits<uint64>::max();
+}
+
 Status BatchResourceBase::RegisterInput(
     int64 guid, OpKernelContext* context, const string& batcher_queue_name,
     AsyncOpKernel::DoneCallback done_callback) {
@@ -145,6 +217,7 @@ BatchResourceBase::GetBatcherQueueOptions(
   // Support for splitting large batch is still in progress.
   batcher_queue_options.enable_large_batch_splitting =
       enable_large_batch_splitting;
+  batcher_queue_options.enable_priority_scheduling = true;
   if (enable_large_batch_splitting) {
     batcher_queue_options.split_input_task_func =
         [](std::unique_ptr<BatchTask>* input_task,
@@ -201,6 +274,9 @@ Status BatchResourceBase::ConcatInputTensors(
   if (batch.num_tasks() == 0) {
     return errors::InvalidArgument("Empty batch.");
   }
+  if (enable_ragged_batching_) {
+    return ConcatRaggedInputTensors(batch, context, concatenated_tensors);
+  }
 
   const int padded_batch_size = RoundToLowestAllowedBatchSize(batch.size());
   const int padding_amount = padded_batch_size - batch.size();
@@ -328,6 +404,7 @@ Status BatchResourceBase::ConcatInputTensors(
     task->inputs.reserve(input_task.inputs.size());
     task->is_partial = true;
     task->status = input_task.status;
+    task->priority_level = input_task.priority_level;
 
     task->output = input_task.output;
     output_tasks->push_back(std::move(task));
@@ -373,6 +450,9 @@ Status BatchResourceBase::SplitOutputTensors(
     return errors::Internal("Batch size expected to be positive; was ",
                             batch->num_tasks());
   }
+  if (enable_ragged_batching_) {
+    return SplitRaggedOutputTensors(combined_outputs, batch);
+  }
 
   std::vector<int64> task_sizes_plus_optional_padding;
   task_sizes_plus_optional_padding.reserve(batch->num_tasks());
@@ -439,6 +519,158 @@ Status BatchResourceBase::SplitOutputTensors(
   return Status::OK();
 }
 
+Status BatchResourceBase::ConcatRaggedInputTensors(
+    const BatchT& batch, OpKernelContext* context,
+    std::vector<Tensor>* concatenated_tensors) const {
+  profiler::TraceMe trace_me([&batch]() {
+    return profiler::TraceMeEncode("ConcatRaggedInputTensors",
+                                   {{"batch_size", batch.size()}});
+  });
+  RecordProcessedBatchSize(batch.size(), GetModelName(context));
+
+  const int num_inputs = batch.task(0).inputs.size();
+  concatenated_tensors->reserve(2 * num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    std::vector<Tensor> to_concatenate;
+    to_concatenate.reserve(batch.num_tasks());
+    Tensor row_splits(DT_INT64,
+                      TensorShape({static_cast<int64>(batch.size()) + 1}));
+    auto row_splits_flat = row_splits.vec<int64>();
+    int64 num_rows = 0;
+    row_splits_flat(0) = 0;
+    for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+      const Tensor& input = batch.task(task_idx).inputs.at(i);
+      if (input.dims() < 2) {
+        return errors::InvalidArgument(
+            "Ragged batching requires inputs of rank 2 or more; input ", i,
+            " has shape ", input.shape().DebugString());
+      }
+      const int64 rows = input.dim_size(0);
+      const int64 length = input.dim_size(1);
+      // Shares the buffer of the input.
+      TensorShape values_shape = input.shape();
+      values_shape.RemoveDim(0);
+      values_shape.set_dim(0, rows * length);
+      Tensor values;
+      if (!values.CopyFrom(input, values_shape)) {
+        return errors::Internal("Failed to flatten input ", i, " of shape ",
+                                input.shape().DebugString());
+      }
+      to_concatenate.push_back(std::move(values));
+      for (int64 row = 0; row < rows; ++row) {
+        row_splits_flat(num_rows + 1) = row_splits_flat(num_rows) + length;
+        ++num_rows;
+      }
+    }
+
+    Tensor concatenated_tensor;
+    TF_RETURN_IF_ERROR(Concat(context, to_concatenate, &concatenated_tensor));
+    concatenated_tensors->push_back(std::move(concatenated_tensor));
+    concatenated_tensors->push_back(std::move(row_splits));
+  }
+  return Status::OK();
+}
+
+Status BatchResourceBase::SplitRaggedOutputTensors(
+    const std::vector<Tensor>& combined_outputs, BatchT* batch) const {
+  const int num_outputs = batch->task(0).context->num_outputs();
+  if (combined_outputs.size() != 2 * num_outputs) {
+    return errors::InvalidArgument(
+        "A ragged batch function must return values and row splits for each "
+        "of the ",
+        num_outputs, " outputs; got ", combined_outputs.size(), " tensors");
+  }
+
+  std::vector<int64> task_rows;
+  task_rows.reserve(batch->num_tasks());
+  const int64 num_rows = batch->size();
+  for (int j = 0; j < batch->num_tasks(); ++j) {
+    task_rows.push_back(batch->task(j).size());
+  }
+
+  for (int i = 0; i < num_outputs; ++i) {
+    const Tensor& values = combined_outputs[2 * i];
+    const Tensor& row_splits = combined_outputs[2 * i + 1];
+    if (values.dims() == 0) {
+      return errors::FailedPrecondition(
+          "Batched output tensor has 0 dimensions");
+    }
+    if (row_splits.dtype() != DT_INT64 || row_splits.dims() != 1) {
+      return errors::InvalidArgument(
+          "The row splits of output ", i, " must be an int64 vector; got ",
+          DataTypeString(row_splits.dtype()), " of shape ",
+          row_splits.shape().DebugString());
+    }
+
+    // The shape of the output of each task, and the size of its values.
+    std::vector<TensorShape> task_shapes;
+    std::vector<int64> task_values;
+    task_shapes.reserve(batch->num_tasks());
+    task_values.reserve(batch->num_tasks());
+    if (row_splits.NumElements() == 0) {
+      // One value per row.
+      if (values.dim_size(0) != num_rows) {
+        return errors::FailedPrecondition(
+            "Batched output ", i, " has no row splits, but its 0th dimension ",
+            values.dim_size(0), " is not the number of rows ", num_rows);
+      }
+      for (int j = 0; j < batch->num_tasks(); ++j) {
+        TensorShape shape = values.shape();
+        shape.set_dim(0, task_rows[j]);
+        task_shapes.push_back(shape);
+        task_values.push_back(task_rows[j]);
+      }
+    } else {
+      const auto splits = row_splits.vec<int64>();
+      if (splits.size() != num_rows + 1 || splits(0) != 0 ||
+          splits(num_rows) != values.dim_size(0)) {
+        return errors::FailedPrecondition(
+            "The row splits of batched output ", i,
+            " must start at 0, end at the 0th dimension of the values ",
+            values.dim_size(0), ", and have one more entry than the ",
+            num_rows, " rows; got ", splits.size(), " entries");
+      }
+      int64 row = 0;
+      for (int j = 0; j < batch->num_tasks(); ++j) {
+        const int64 rows = task_rows[j];
+        const int64 length = rows > 0 ? splits(row + 1) - splits(row) : 0;
+        for (int64 r = row; r < row + rows; ++r) {
+          if (splits(r + 1) - splits(r) != length) {
+            return errors::FailedPrecondition(
+                "The rows of an input of batched output ", i,
+                " have different lengths: ", length, " and ",
+                splits(r + 1) - splits(r));
+          }
+        }
+        TensorShape shape = values.shape();
+        shape.set_dim(0, length);
+        shape.InsertDim(0, rows);
+        task_shapes.push_back(shape);
+        task_values.push_back(rows * length);
+        row += rows;
+      }
+    }
+
+    std::vector<Tensor> split_tensor;
+    TF_RETURN_IF_ERROR(tensor::Split(values, task_values, &split_tensor));
+    for (int j = 0; j < batch->num_tasks(); ++j) {
+      Tensor output;
+      if (!output.CopyFrom(split_tensor[j], task_shapes[j])) {
+        return errors::Internal("Failed to reshape batched output ", i,
+                                " to ", task_shapes[j].DebugString());
+      }
+      BatchTask& task = *(batch->mutable_task(j));
+      if (task.is_partial) {
+        std::vector<Tensor>& tensor_vector = (*task.output)[task.split_index];
+        tensor_vector[i] = std::move(output);
+      } else {
+        task.context->set_output(i, output);
+      }
+    }
+  }
+  return Status::OK();
+}
+
 void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   if (batch->empty()) {
     return;
@@ -516,6 +748,9 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
           cleanup_fn(final_status);
         });
         final_status = run_status;
+        if (latency_slo_policy_ != nullptr) {
+          RecordLatencies(*batch, current_time, model_name);
+        }
         if (!final_status.ok()) {
           return;
         }
@@ -523,6 +758,20 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
       });
 }
 
+void BatchResourceBase::RecordLatencies(const BatchT& batch,
+                                        uint64 processing_start_nanos,
+                                        const string& model_name) const {
+  const uint64 now = EnvTime::NowNanos();
+  latency_slo_policy_->RecordBatch(
+      RoundToLowestAllowedBatchSize(batch.size()),
+      (now - processing_start_nanos) / EnvTime::kMicrosToNanos);
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    latency_slo_policy_->RecordTaskLatency(
+        (now - batch.task(i).start_time) / EnvTime::kMicrosToNanos);
+  }
+  RecordLatencySloPolicy(*latency_slo_policy_, model_name);
+}
+
 // Processes a batch of one or more BatchTask entries.
 void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   if (batch->empty()) {
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_policy.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
 #include "tensorflow/core/platform/context.h"
@@ -87,8 +88,19 @@ class BatchResourceBase : public ResourceBase {
 
     bool is_partial = false;
 
+    // The priority of the task in its queue, which batches the tasks of
+    // higher priority first. Subclasses may set it in CreateBatchTask().
+    int priority_level = 0;
+
     size_t size() const override { return inputs[0].shape().dim_size(0); }
 
+    // Past once the step of the task is cancelled, e.g. when its
+    // RunOptions.timeout_in_ms, which carries the deadline of the RPC it
+    // serves, expires: nobody reads its outputs anymore.
+    uint64 deadline_micros() const override;
+
+    int priority() const override { return priority_level; }
+
     uint64 start_time;
   };
 
@@ -99,14 +111,21 @@ class BatchResourceBase : public ResourceBase {
   using BatcherQueueT = BatchScheduler<BatchResourceBase::BatchTask>;
   using BatchT = Batch<BatchResourceBase::BatchTask>;
 
-  BatchResourceBase(bool has_process_batch_function,
-                    std::shared_ptr<BatcherT> batcher,
-                    const BatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
-      : has_process_batch_function_(has_process_batch_function),
-        batcher_(std::move(batcher)),
-        batcher_queue_options_(batcher_queue_options),
-        allowed_batch_sizes_(std::move(allowed_batch_sizes)) {}
+  // If `latency_slo_policy` is set, it adapts the batch timeout and the batch
+  // sizes of the queues to its latency target.
+  //
+  // If `enable_ragged_batching` is true, the inputs of the tasks may differ in
+  // their 1st dimension, e.g. the length of sequences, and are batched without
+  // padding: each input is passed to the batch function as the flat values of
+  // its rows, concatenated along the 0th dimension, followed by int64 row
+  // splits (see ConcatRaggedInputTensors). The function returns each output
+  // the same way (see SplitRaggedOutputTensors).
+  BatchResourceBase(
+      bool has_process_batch_function, std::shared_ptr<BatcherT> batcher,
+      const BatcherT::QueueOptions& batcher_queue_options,
+      std::vector<int32> allowed_batch_sizes,
+      std::shared_ptr<LatencySloBatchPolicy> latency_slo_policy = nullptr,
+      bool enable_ragged_batching = false);
 
   static BatcherT::QueueOptions GetBatcherQueueOptions(
       int32 num_batch_threads, int32 max_batch_size, int32 batch_timeout_micros,
@@ -160,8 +179,29 @@ class BatchResourceBase : public ResourceBase {
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
                             BatchT* batch) const;
 
+  // Concatenates the ith inputs of the tasks, of shapes [rows, length, ...],
+  // into the flat values of all their rows, of shape [sum(rows * length),
+  // ...], followed by the int64 row splits of the values, of shape
+  // [sum(rows) + 1]. The batch is not padded.
+  Status ConcatRaggedInputTensors(
+      const BatchT& batch, OpKernelContext* context,
+      std::vector<Tensor>* concatenated_tensors) const;
+
+  // Splits the outputs of a ragged batch function, a pair of values and int64
+  // row splits per output of the op. The values of a task, of its rows in the
+  // row splits, are reshaped to [rows, length, ...], so all the rows of a task
+  // must have the same length. Outputs with empty row splits have one value
+  // per row, and are split like the outputs of a dense batch.
+  Status SplitRaggedOutputTensors(const std::vector<Tensor>& combined_outputs,
+                                  BatchT* batch) const;
+
   void ProcessFuncBatch(std::unique_ptr<BatchT> batch) const;
 
+  // Records the processing time of `batch`, and the latencies of its tasks,
+  // in `latency_slo_policy_`.
+  void RecordLatencies(const BatchT& batch, uint64 processing_start_nanos,
+                       const string& model_name) const;
+
   // Processes a batch of one or more BatchTask entries.
   void ProcessBatch(std::unique_ptr<BatchT> batch) const;
 
@@ -194,6 +234,10 @@ class BatchResourceBase : public ResourceBase {
       TF_GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  std::shared_ptr<LatencySloBatchPolicy> latency_slo_policy_;
+
+  const bool enable_ragged_batching_;
 };
 
 }  // namespace serving
@@ -30,6 +30,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -64,6 +65,18 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the time, in Env::NowMicros(), after which nobody will read the
+  // outcome of the task, e.g. the deadline of the request it serves.
+  // Schedulers that support deadlines drop the tasks past theirs instead of
+  // processing them. No deadline by default.
+  virtual uint64 deadline_micros() const {
+    return std::numeric_limits<uint64>::max();
+  }
+
+  // Returns the priority of the task. Schedulers that support priorities
+  // batch the tasks of higher priority first. 0 by default.
+  virtual int priority() const { return 0; }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -0,0 +1,175 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_policy.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Weight of a new measurement in the moving averages of the processing times.
+constexpr double kProcessingTimeDecay = 0.1;
+
+}  // namespace
+
+Status LatencySloBatchPolicy::Create(
+    const Options& options, std::unique_ptr<LatencySloBatchPolicy>* policy) {
+  if (options.target_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be positive; was ",
+        options.target_latency_micros);
+  }
+  if (options.max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  if (options.initial_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "initial_batch_timeout_micros must be non-negative; was ",
+        options.initial_batch_timeout_micros);
+  }
+  if (options.headroom < 0 || options.headroom >= 1) {
+    return errors::InvalidArgument("headroom must be in [0, 1); was ",
+                                   options.headroom);
+  }
+  if (options.tasks_per_adjustment <= 0) {
+    return errors::InvalidArgument(
+        "tasks_per_adjustment must be positive; was ",
+        options.tasks_per_adjustment);
+  }
+  const std::vector<int32>& sizes = options.allowed_batch_sizes;
+  for (int i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] <= 0 || (i > 0 && sizes[i] <= sizes[i - 1])) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes must be positive and increasing");
+    }
+  }
+  policy->reset(new LatencySloBatchPolicy(options));
+  return Status::OK();
+}
+
+LatencySloBatchPolicy::LatencySloBatchPolicy(const Options& options)
+    : options_([&options] {
+        Options resolved = options;
+        if (resolved.max_batch_timeout_micros < 0) {
+          resolved.max_batch_timeout_micros = options.target_latency_micros / 2;
+        }
+        if (resolved.timeout_increment_micros < 0) {
+          resolved.timeout_increment_micros =
+              std::max<int64>(1, options.target_latency_micros / 20);
+        }
+        return resolved;
+      }()),
+      batch_timeout_micros_(std::min(options_.initial_batch_timeout_micros,
+                                     options_.max_batch_timeout_micros)) {
+  if (options_.allowed_batch_sizes.empty()) {
+    for (int size = 1; size < options_.max_batch_size; size *= 2) {
+      candidate_sizes_.push_back(size);
+    }
+    candidate_sizes_.push_back(options_.max_batch_size);
+  } else {
+    candidate_sizes_.assign(options_.allowed_batch_sizes.begin(),
+                            options_.allowed_batch_sizes.end());
+  }
+  target_index_ = candidate_sizes_.size() - 1;
+  target_batch_size_ = candidate_sizes_[target_index_];
+  processing_micros_.assign(candidate_sizes_.size(), -1);
+  latencies_micros_.reserve(options_.tasks_per_adjustment);
+}
+
+int LatencySloBatchPolicy::CandidateIndex(int batch_size) const {
+  const auto it = std::lower_bound(candidate_sizes_.begin(),
+                                   candidate_sizes_.end(), batch_size);
+  if (it == candidate_sizes_.end()) return candidate_sizes_.size() - 1;
+  return it - candidate_sizes_.begin();
+}
+
+void LatencySloBatchPolicy::RecordBatch(int batch_size,
+                                        int64 processing_micros) {
+  const int index = CandidateIndex(batch_size);
+  mutex_lock l(mu_);
+  double& average = processing_micros_[index];
+  if (average < 0) {
+    average = processing_micros;
+  } else {
+    average += kProcessingTimeDecay * (processing_micros - average);
+  }
+}
+
+void LatencySloBatchPolicy::RecordTaskLatency(int64 latency_micros) {
+  mutex_lock l(mu_);
+  latencies_micros_.push_back(latency_micros);
+  if (latencies_micros_.size() >= options_.tasks_per_adjustment) {
+    AdjustLocked();
+    latencies_micros_.clear();
+  }
+}
+
+int64 LatencySloBatchPolicy::EstimatedProcessingMicros(int batch_size) const {
+  mutex_lock l(mu_);
+  return EstimatedProcessingMicrosLocked(CandidateIndex(batch_size));
+}
+
+int64 LatencySloBatchPolicy::EstimatedProcessingMicrosLocked(
+    int index) const {
+  if (processing_micros_[index] >= 0) return processing_micros_[index];
+  // Assumes no batching gains beyond the largest smaller size measured, which
+  // errs on the side of the latency.
+  for (int i = index - 1; i >= 0; --i) {
+    if (processing_micros_[i] >= 0) {
+      return processing_micros_[i] * candidate_sizes_[index] /
+             candidate_sizes_[i];
+    }
+  }
+  return -1;
+}
+
+void LatencySloBatchPolicy::AdjustLocked() {
+  const int p99_index = latencies_micros_.size() * 99 / 100;
+  std::nth_element(latencies_micros_.begin(),
+                   latencies_micros_.begin() + p99_index,
+                   latencies_micros_.end());
+  const int64 p99 = latencies_micros_[p99_index];
+  p99_latency_micros_ = p99;
+
+  const int64 target = options_.target_latency_micros;
+  int64 timeout = batch_timeout_micros_;
+  if (p99 > target) {
+    timeout /= 2;
+    target_index_ = std::max(0, target_index_ - 1);
+  } else if (p99 < (1 - options_.headroom) * target) {
+    timeout = std::min(timeout + options_.timeout_increment_micros,
+                       options_.max_batch_timeout_micros);
+    if (target_index_ + 1 < candidate_sizes_.size()) {
+      const int64 processing =
+          EstimatedProcessingMicrosLocked(target_index_ + 1);
+      if (processing < 0 || timeout + processing <= target) ++target_index_;
+    }
+    // Leaves the processing time of the batch size in the target.
+    const int64 processing = EstimatedProcessingMicrosLocked(target_index_);
+    if (processing >= 0) {
+      timeout = std::max<int64>(0, std::min(timeout, target - processing));
+    }
+  }
+  batch_timeout_micros_ = timeout;
+  target_batch_size_ = candidate_sizes_[target_index_];
+}
+
+}  // namespace serving
+}  // namespace tensorflow
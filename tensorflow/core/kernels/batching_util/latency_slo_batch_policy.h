@@ -0,0 +1,134 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_POLICY_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_POLICY_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Adapts the batch timeout of a batching queue, and the size at which its
+// batches are scheduled without waiting for the timeout, so that batches are
+// as large as possible, hence the throughput as high as possible, while the
+// 99th percentile of the latency of the tasks stays within a target.
+//
+// The latency of a task runs from its enqueuing to the end of the processing
+// of its batch, i.e. at most the batch timeout, plus the wait for a batch
+// thread, plus the processing time of the batch. The policy measures the
+// processing time of each batch size (the cost curve), and every
+// `tasks_per_adjustment` tasks compares the p99 latency of these tasks to the
+// target:
+//  - Above the target, it halves the timeout and lowers the batch size to the
+//    next smaller candidate.
+//  - Below `(1 - headroom) * target`, it raises the timeout by
+//    `timeout_increment_micros` and the batch size to the next larger
+//    candidate, as long as the timeout plus the processing time of the batch
+//    size, measured or extrapolated from the smaller sizes, fit in the target.
+//
+// The candidate batch sizes are the allowed batch sizes if any, and the
+// powers of two up to the max batch size otherwise. The policy starts from
+// the largest one and the initial timeout, i.e. from the static
+// configuration of the queue.
+//
+// Thread-safe.
+class LatencySloBatchPolicy {
+ public:
+  struct Options {
+    // Target of the 99th percentile of the task latencies. Must be positive.
+    int64 target_latency_micros = 0;
+    int max_batch_size = 1000;
+    // The sizes the batches are padded to, if any, in increasing order.
+    std::vector<int32> allowed_batch_sizes;
+    int64 initial_batch_timeout_micros = 0;
+    // The largest batch timeout. Defaults to half the target latency.
+    int64 max_batch_timeout_micros = -1;
+    // Defaults to a twentieth of the target latency.
+    int64 timeout_increment_micros = -1;
+    // The fraction of the target the p99 latency must be below for the
+    // policy to grow the timeout and the batch size.
+    double headroom = 0.2;
+    // Larger numbers give less noisy p99 latencies, but adapt slower.
+    int tasks_per_adjustment = 200;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<LatencySloBatchPolicy>* policy);
+
+  // Records the processing time of a batch, of its padded size.
+  void RecordBatch(int batch_size, int64 processing_micros);
+
+  // Records the latency of a task, and adjusts the timeout and the batch size
+  // every `tasks_per_adjustment` tasks.
+  void RecordTaskLatency(int64 latency_micros);
+
+  int64 batch_timeout_micros() const {
+    return batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+
+  // The size at which batches are scheduled without waiting for the timeout.
+  int target_batch_size() const {
+    return target_batch_size_.load(std::memory_order_relaxed);
+  }
+
+  // The p99 latency of the tasks of the last adjustment, or 0 before the
+  // first one.
+  int64 p99_latency_micros() const {
+    return p99_latency_micros_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the average processing time of the batches of `batch_size`,
+  // extrapolated linearly from the largest smaller size measured if it was
+  // not measured, or -1 if no smaller size was measured either.
+  int64 EstimatedProcessingMicros(int batch_size) const;
+
+ private:
+  explicit LatencySloBatchPolicy(const Options& options);
+
+  // Returns the index of the smallest candidate size >= `batch_size`.
+  int CandidateIndex(int batch_size) const;
+
+  int64 EstimatedProcessingMicrosLocked(int index) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void AdjustLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+  std::vector<int> candidate_sizes_;
+
+  std::atomic<int64> batch_timeout_micros_;
+  std::atomic<int> target_batch_size_;
+  std::atomic<int64> p99_latency_micros_{0};
+
+  mutable mutex mu_;
+  int target_index_ TF_GUARDED_BY(mu_);
+  // Moving averages of the processing times of the candidate sizes, or -1 if
+  // not measured yet.
+  std::vector<double> processing_micros_ TF_GUARDED_BY(mu_);
+  std::vector<int64> latencies_micros_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_POLICY_H_
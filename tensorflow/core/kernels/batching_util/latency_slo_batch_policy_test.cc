@@ -0,0 +1,142 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_policy.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+LatencySloBatchPolicy::Options DefaultOptions() {
+  LatencySloBatchPolicy::Options options;
+  options.target_latency_micros = 10000;
+  options.max_batch_size = 32;
+  options.allowed_batch_sizes = {8, 16, 32};
+  options.initial_batch_timeout_micros = 4000;
+  options.timeout_increment_micros = 500;
+  options.tasks_per_adjustment = 100;
+  return options;
+}
+
+void RecordTasks(int num_tasks, int64 latency_micros,
+                 LatencySloBatchPolicy* policy) {
+  for (int i = 0; i < num_tasks; ++i) policy->RecordTaskLatency(latency_micros);
+}
+
+TEST(LatencySloBatchPolicyTest, InvalidOptions) {
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  LatencySloBatchPolicy::Options options = DefaultOptions();
+  options.target_latency_micros = 0;
+  EXPECT_FALSE(LatencySloBatchPolicy::Create(options, &policy).ok());
+  options = DefaultOptions();
+  options.allowed_batch_sizes = {16, 8};
+  EXPECT_FALSE(LatencySloBatchPolicy::Create(options, &policy).ok());
+  options = DefaultOptions();
+  options.headroom = 1;
+  EXPECT_FALSE(LatencySloBatchPolicy::Create(options, &policy).ok());
+}
+
+TEST(LatencySloBatchPolicyTest, StartsFromTheStaticConfiguration) {
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(DefaultOptions(), &policy));
+  EXPECT_EQ(policy->batch_timeout_micros(), 4000);
+  EXPECT_EQ(policy->target_batch_size(), 32);
+  EXPECT_EQ(policy->p99_latency_micros(), 0);
+}
+
+TEST(LatencySloBatchPolicyTest, ShrinksAboveTheTarget) {
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(DefaultOptions(), &policy));
+  RecordTasks(98, 5000, policy.get());
+  RecordTasks(2, 12000, policy.get());
+  EXPECT_EQ(policy->p99_latency_micros(), 12000);
+  EXPECT_EQ(policy->batch_timeout_micros(), 2000);
+  EXPECT_EQ(policy->target_batch_size(), 16);
+
+  RecordTasks(100, 12000, policy.get());
+  RecordTasks(100, 12000, policy.get());
+  EXPECT_EQ(policy->batch_timeout_micros(), 500);
+  EXPECT_EQ(policy->target_batch_size(), 8);
+}
+
+TEST(LatencySloBatchPolicyTest, HoldsWithinTheHeadroom) {
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(DefaultOptions(), &policy));
+  RecordTasks(100, 9000, policy.get());
+  EXPECT_EQ(policy->batch_timeout_micros(), 4000);
+  EXPECT_EQ(policy->target_batch_size(), 32);
+}
+
+TEST(LatencySloBatchPolicyTest, GrowsBelowTheTarget) {
+  LatencySloBatchPolicy::Options options = DefaultOptions();
+  options.initial_batch_timeout_micros = 0;
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(options, &policy));
+  RecordTasks(100, 20000, policy.get());
+  EXPECT_EQ(policy->target_batch_size(), 16);
+
+  // Nothing is known of the processing time of batches of 32 yet.
+  RecordTasks(100, 1000, policy.get());
+  EXPECT_EQ(policy->batch_timeout_micros(), 500);
+  EXPECT_EQ(policy->target_batch_size(), 32);
+}
+
+TEST(LatencySloBatchPolicyTest, LeavesTheProcessingTimeInTheTarget) {
+  LatencySloBatchPolicy::Options options = DefaultOptions();
+  options.initial_batch_timeout_micros = 0;
+  options.timeout_increment_micros = 4000;
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(options, &policy));
+  RecordTasks(100, 20000, policy.get());
+  ASSERT_EQ(policy->target_batch_size(), 16);
+
+  // Batches of 32 are extrapolated to take 8000us, which leaves no room for
+  // a 4000us timeout.
+  policy->RecordBatch(16, 4000);
+  EXPECT_EQ(policy->EstimatedProcessingMicros(32), 8000);
+  RecordTasks(100, 1000, policy.get());
+  EXPECT_EQ(policy->target_batch_size(), 16);
+  EXPECT_EQ(policy->batch_timeout_micros(), 4000);
+
+  // The timeout is capped so that it and the processing time fit.
+  policy->RecordBatch(16, 4000);
+  RecordTasks(100, 1000, policy.get());
+  EXPECT_EQ(policy->target_batch_size(), 16);
+  EXPECT_EQ(policy->batch_timeout_micros(), 5000);
+
+  // Batches of 32 turn out to be cheap.
+  policy->RecordBatch(32, 4000);
+  EXPECT_EQ(policy->EstimatedProcessingMicros(32), 4000);
+}
+
+TEST(LatencySloBatchPolicyTest, DefaultCandidateSizes) {
+  LatencySloBatchPolicy::Options options = DefaultOptions();
+  options.allowed_batch_sizes.clear();
+  options.max_batch_size = 12;
+  std::unique_ptr<LatencySloBatchPolicy> policy;
+  TF_ASSERT_OK(LatencySloBatchPolicy::Create(options, &policy));
+  EXPECT_EQ(policy->target_batch_size(), 12);
+  RecordTasks(100, 20000, policy.get());
+  EXPECT_EQ(policy->target_batch_size(), 8);
+  RecordTasks(100, 20000, policy.get());
+  EXPECT_EQ(policy->target_batch_size(), 4);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
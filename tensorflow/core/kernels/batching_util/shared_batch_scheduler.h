@@ -18,8 +18,10 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -194,6 +196,30 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If set, called each time the scheduler considers the open batch, in
+    // place of `batch_timeout_micros`. Lets a policy such as
+    // LatencySloBatchPolicy adapt the timeout online.
+    std::function<int64()> batch_timeout_micros_func;
+
+    // If set, called each time the scheduler considers the open batch, to get
+    // the size from which the open batch is schedulable without waiting for
+    // the timeout. It can be below `max_execution_batch_size`, e.g. when a
+    // policy such as LatencySloBatchPolicy trades throughput for latency.
+    std::function<size_t()> schedulable_batch_size_func;
+
+    // If set, the tasks past their BatchTask::deadline_micros() when their
+    // batch is about to be processed are removed from it, so that they don't
+    // consume batch slots, and passed to this callback instead, which must
+    // complete them (e.g. with a DEADLINE_EXCEEDED error). Called from a batch
+    // thread.
+    std::function<void(std::unique_ptr<TaskType>)> expired_task_callback;
+
+    // If true, when tasks wait in several closed batches, they are regrouped
+    // by decreasing BatchTask::priority() before the next batch is processed,
+    // so that the tasks of high priority skip the backlog of the others.
+    // Tasks of equal priority keep their order.
+    bool enable_priority_scheduling = false;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -345,6 +371,17 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Regroups the tasks of the closed batches in 'batches_' by decreasing
+  // priority, if they are not already in that order.
+  void RegroupClosedBatchesByPriority() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Moves the tasks of 'batch' past their deadline to 'expired_tasks', and
+  // returns the batch of the others.
+  std::unique_ptr<Batch<TaskType>> RemoveExpiredTasks(
+      std::unique_ptr<Batch<TaskType>> batch,
+      std::vector<std::unique_ptr<TaskType>>* expired_tasks)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -380,7 +417,8 @@ class Queue {
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
 
   // The number of batches currently being processed by batch threads.
-  // Incremented in ScheduleBatch() and decremented in ProcessBatch().
+  // Incremented in ScheduleBatch() and decremented in ProcessBatch(). Also
+  // counts the expired tasks being completed by ScheduleBatch() as a batch.
   int num_batches_being_processed_ TF_GUARDED_BY(mu_) = 0;
 
   // Used by CloseAndWaitUntilEmpty() to wait until the queue is empty, for
@@ -783,6 +821,7 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
   // The batch to schedule, which we may populate below. (If left as nullptr,
   // that means we are electing not to schedule a batch at this time.)
   std::unique_ptr<Batch<TaskType>> batch_to_schedule;
+  std::vector<std::unique_ptr<TaskType>> expired_tasks;
 
   {
     mutex_lock l(mu_);
@@ -792,14 +831,42 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
       StartNewBatch();
     }
 
-    if (batches_.size() >= 2) {
+    if (options_.enable_priority_scheduling && batches_.size() > 2) {
+      RegroupClosedBatchesByPriority();
+    }
+
+    while (batches_.size() >= 2) {
       // There is at least one closed batch that is ready to be scheduled.
-      ++num_batches_being_processed_;
       batch_to_schedule = std::move(batches_.front());
       batches_.pop_front();
+      if (options_.expired_task_callback) {
+        batch_to_schedule =
+            RemoveExpiredTasks(std::move(batch_to_schedule), &expired_tasks);
+      }
+      if (!batch_to_schedule->empty()) break;
+      batch_to_schedule = nullptr;
+    }
+
+    if (batch_to_schedule != nullptr) {
+      ++num_batches_being_processed_;
     } else {
       schedulable_batch_ = false;
     }
+    // The queue isn't empty until the expired tasks are completed.
+    if (!expired_tasks.empty()) {
+      ++num_batches_being_processed_;
+    }
+  }
+
+  if (!expired_tasks.empty()) {
+    for (auto& task : expired_tasks) {
+      options_.expired_task_callback(std::move(task));
+    }
+    mutex_lock l(mu_);
+    --num_batches_being_processed_;
+    if (empty_notification_ != nullptr && IsEmptyInternal()) {
+      empty_notification_->Notify();
+    }
   }
 
   return batch_to_schedule;
@@ -876,9 +943,100 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  size_t schedulable_batch_size = max_execution_batch_size();
+  if (options_.schedulable_batch_size_func) {
+    schedulable_batch_size = std::min(schedulable_batch_size,
+                                      options_.schedulable_batch_size_func());
+  }
+  const int64 batch_timeout_micros = options_.batch_timeout_micros_func
+                                         ? options_.batch_timeout_micros_func()
+                                         : options_.batch_timeout_micros;
+  return closed_ || open_batch->size() >= schedulable_batch_size ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::RegroupClosedBatchesByPriority() {
+  const int num_closed_batches = batches_.size() - 1;
+  bool in_order = true;
+  int previous_priority = std::numeric_limits<int>::max();
+  for (int i = 0; i < num_closed_batches && in_order; ++i) {
+    const Batch<TaskType>& batch = *batches_[i];
+    for (int j = 0; j < batch.num_tasks(); ++j) {
+      const int priority = batch.task(j).priority();
+      if (priority > previous_priority) {
+        in_order = false;
+        break;
+      }
+      previous_priority = priority;
+    }
+  }
+  if (in_order) return;
+
+  std::vector<std::unique_ptr<TaskType>> tasks;
+  for (int i = 0; i < num_closed_batches; ++i) {
+    // Batch only removes its last task.
+    const int first_task = tasks.size();
+    while (std::unique_ptr<TaskType> task = batches_.front()->RemoveTask()) {
+      tasks.push_back(std::move(task));
+    }
+    std::reverse(tasks.begin() + first_task, tasks.end());
+    batches_.pop_front();
+  }
+  std::stable_sort(tasks.begin(), tasks.end(),
+                   [](const std::unique_ptr<TaskType>& a,
+                      const std::unique_ptr<TaskType>& b) {
+                     return a->priority() > b->priority();
+                   });
+
+  std::vector<std::unique_ptr<Batch<TaskType>>> regrouped_batches;
+  for (auto& task : tasks) {
+    if (regrouped_batches.empty() ||
+        regrouped_batches.back()->size() + task->size() >
+            max_execution_batch_size()) {
+      if (!regrouped_batches.empty()) regrouped_batches.back()->Close();
+      regrouped_batches.emplace_back(
+          new Batch<TaskType>(++traceme_context_id_counter_));
+    }
+    regrouped_batches.back()->AddTask(std::move(task));
+  }
+  regrouped_batches.back()->Close();
+  for (auto it = regrouped_batches.rbegin(); it != regrouped_batches.rend();
+       ++it) {
+    batches_.push_front(std::move(*it));
+  }
+}
+
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::RemoveExpiredTasks(
+    std::unique_ptr<Batch<TaskType>> batch,
+    std::vector<std::unique_ptr<TaskType>>* expired_tasks) {
+  const uint64 now_micros = env_->NowMicros();
+  bool has_expired_tasks = false;
+  for (int i = 0; i < batch->num_tasks(); ++i) {
+    if (batch->task(i).deadline_micros() <= now_micros) {
+      has_expired_tasks = true;
+      break;
+    }
+  }
+  if (!has_expired_tasks) return batch;
+
+  std::vector<std::unique_ptr<TaskType>> tasks;
+  while (std::unique_ptr<TaskType> task = batch->RemoveTask()) {
+    tasks.push_back(std::move(task));
+  }
+  std::unique_ptr<Batch<TaskType>> live_batch(
+      new Batch<TaskType>(batch->traceme_context_id()));
+  for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+    if ((*it)->deadline_micros() <= now_micros) {
+      expired_tasks->push_back(std::move(*it));
+    } else {
+      live_batch->AddTask(std::move(*it));
+    }
+  }
+  live_batch->Close();
+  return live_batch;
 }
 
 template <typename TaskType>
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 
+#include <atomic>
+#include <limits>
+
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -28,14 +31,23 @@ namespace {
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size) : size_(size) {}
+  explicit FakeTask(size_t size,
+                    uint64 deadline_micros = std::numeric_limits<uint64>::max(),
+                    int priority = 0)
+      : size_(size), deadline_micros_(deadline_micros), priority_(priority) {}
 
   ~FakeTask() override = default;
 
   size_t size() const override { return size_; }
 
+  uint64 deadline_micros() const override { return deadline_micros_; }
+
+  int priority() const override { return priority_; }
+
  private:
   const size_t size_;
+  const uint64 deadline_micros_;
+  const int priority_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
 };
@@ -50,6 +62,16 @@ Status ScheduleTask(size_t task_size, BatchScheduler<FakeTask>* scheduler) {
   return status;
 }
 
+// Same as above, with a deadline and a priority.
+Status ScheduleTask(size_t task_size, uint64 deadline_micros, int priority,
+                    BatchScheduler<FakeTask>* scheduler) {
+  std::unique_ptr<FakeTask> task(
+      new FakeTask(task_size, deadline_micros, priority));
+  Status status = scheduler->Schedule(&task);
+  CHECK_EQ(status.ok(), task == nullptr);
+  return status;
+}
+
 // Creates a thread that waits on 'start' and then advances the fake clock in
 // 'env' in a loop until 'stop' is notified. Useful for allowing objects that
 // use the clock to be destroyed.
@@ -336,6 +358,179 @@ TEST(SharedBatchSchedulerTest,
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, ObeysDynamicTimeoutAndBatchSize) {
+  // Set up a fake clock, and never advance the time.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification first_batch_processed, second_batch_processed;
+    auto callback = [&first_batch_processed, &second_batch_processed](
+                        std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      if (batch->size() == 2) {
+        first_batch_processed.Notify();
+      } else if (batch->size() == 1) {
+        second_batch_processed.Notify();
+      } else {
+        EXPECT_TRUE(false) << "Unexpected batch size";
+      }
+    };
+
+    std::atomic<int64> batch_timeout_micros(1000);
+    std::atomic<size_t> schedulable_batch_size(2);
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 10;
+    queue_options.batch_timeout_micros = 1000 * 1000;
+    queue_options.max_enqueued_batches = 2;
+    queue_options.batch_timeout_micros_func = [&batch_timeout_micros] {
+      return batch_timeout_micros.load();
+    };
+    queue_options.schedulable_batch_size_func = [&schedulable_batch_size] {
+      return schedulable_batch_size.load();
+    };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // The open batch is scheduled once it reaches the schedulable size, well
+    // below the input batch size limit.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(first_batch_processed.HasBeenNotified());
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    first_batch_processed.WaitForNotification();
+
+    // Then as soon as a task is enqueued once the timeout drops to zero.
+    schedulable_batch_size = 10;
+    batch_timeout_micros = 0;
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    second_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, DropsExpiredTasks) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    constexpr uint64 kNoDeadline = std::numeric_limits<uint64>::max();
+    Notification first_batch_processing, first_batch_proceed;
+    mutex mu;
+    std::vector<std::vector<uint64>> batch_deadlines;
+    std::vector<uint64> expired_deadlines;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      if (!first_batch_processing.HasBeenNotified()) {
+        first_batch_processing.Notify();
+        first_batch_proceed.WaitForNotification();
+        return;
+      }
+      mutex_lock l(mu);
+      batch_deadlines.emplace_back();
+      for (int i = 0; i < batch->num_tasks(); ++i) {
+        batch_deadlines.back().push_back(batch->task(i).deadline_micros());
+      }
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 2;
+    queue_options.batch_timeout_micros = 1000 * 1000;
+    queue_options.max_enqueued_batches = 10;
+    queue_options.expired_task_callback =
+        [&](std::unique_ptr<FakeTask> task) {
+          mutex_lock l(mu);
+          expired_deadlines.push_back(task->deadline_micros());
+        };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Keep the batch thread busy while the tasks expire.
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    first_batch_processing.WaitForNotification();
+    TF_ASSERT_OK(ScheduleTask(1, 100, 0, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, kNoDeadline, 0, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, 101, 0, queue.get()));
+    env.AdvanceByMicroseconds(200);
+    first_batch_proceed.Notify();
+
+    // The last batch is only processed once the queue is closed, and none of
+    // its tasks is alive.
+    queue = nullptr;
+    mutex_lock l(mu);
+    EXPECT_EQ(batch_deadlines,
+              std::vector<std::vector<uint64>>({{kNoDeadline}}));
+    EXPECT_EQ(expired_deadlines, std::vector<uint64>({100, 101}));
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, PrioritizesClosedBatches) {
+  Notification first_batch_processing, first_batch_proceed;
+  // The (priority, size) of the tasks of each batch.
+  using Batches = std::vector<std::vector<std::pair<int, size_t>>>;
+  mutex mu;
+  Batches batches;
+  auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+    if (!first_batch_processing.HasBeenNotified()) {
+      first_batch_processing.Notify();
+      first_batch_proceed.WaitForNotification();
+      return;
+    }
+    mutex_lock l(mu);
+    batches.emplace_back();
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batches.back().emplace_back(batch->task(i).priority(),
+                                  batch->task(i).size());
+    }
+  };
+
+  SharedBatchScheduler<FakeTask>::Options options;
+  options.num_batch_threads = 1;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.input_batch_size_limit = 2;
+  queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+  queue_options.max_enqueued_batches = 10;
+  queue_options.enable_priority_scheduling = true;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+  // Keep the batch thread busy while the batches pile up.
+  TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  first_batch_processing.WaitForNotification();
+  constexpr uint64 kNoDeadline = std::numeric_limits<uint64>::max();
+  TF_ASSERT_OK(ScheduleTask(2, kNoDeadline, 0, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(2, kNoDeadline, 0, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(1, kNoDeadline, 1, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(1, kNoDeadline, 1, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(1, kNoDeadline, 0, queue.get()));
+  first_batch_proceed.Notify();
+
+  queue = nullptr;
+  mutex_lock l(mu);
+  EXPECT_EQ(batches,
+            Batches({{{1, 1}, {1, 1}}, {{0, 2}}, {{0, 2}}, {{0, 1}}}));
+}
+
 TEST(SharedBatchSchedulerTest, Fairness) {
   test_util::FakeClockEnv env(Env::Default());
   Notification start_teardown, stop_teardown;
@@ -24,6 +24,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/constant_op.h"
 
+#include <unordered_map>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -37,7 +39,9 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 
 namespace tensorflow {
@@ -67,6 +71,61 @@ NodeDef StripTensorDataFromNodeDef(OpKernelConstruction* ctx) {
   return ret;
 }
 
+// The constants on the CPU at least this large are shared by the kernels of
+// identical constants, e.g. the constants folded in several functions of a
+// model, so that their values are only held in memory once.
+constexpr int64 kMinSharedConstantBytes = 64 << 10;
+
+struct SharedConstant {
+  Tensor tensor;
+  int num_kernels;
+};
+
+mutex* shared_constants_mu() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+std::unordered_map<uint64, SharedConstant>* shared_constants() {
+  static auto* constants = new std::unordered_map<uint64, SharedConstant>;
+  return constants;
+}
+
+uint64 FingerprintConstant(const Tensor& tensor) {
+  uint64 fingerprint = Fingerprint64(tensor.tensor_data());
+  fingerprint = FingerprintCat64(fingerprint, tensor.dtype());
+  for (const int64 dim : tensor.shape().dim_sizes()) {
+    fingerprint = FingerprintCat64(fingerprint, dim);
+  }
+  return fingerprint;
+}
+
+// Replaces `tensor` by the identical shared constant if there is one, or
+// shares it otherwise. Returns false if another constant has the same
+// fingerprint, in which case `tensor` is not shared.
+bool ShareConstant(uint64 fingerprint, Tensor* tensor) {
+  mutex_lock l(*shared_constants_mu());
+  auto it = shared_constants()->find(fingerprint);
+  if (it == shared_constants()->end()) {
+    shared_constants()->emplace(fingerprint, SharedConstant{*tensor, 1});
+    return true;
+  }
+  const Tensor& shared = it->second.tensor;
+  if (shared.dtype() != tensor->dtype() || shared.shape() != tensor->shape() ||
+      shared.tensor_data() != tensor->tensor_data()) {
+    return false;
+  }
+  *tensor = shared;
+  ++it->second.num_kernels;
+  return true;
+}
+
+void ReleaseSharedConstant(uint64 fingerprint) {
+  mutex_lock l(*shared_constants_mu());
+  auto it = shared_constants()->find(fingerprint);
+  if (--it->second.num_kernels == 0) shared_constants()->erase(it);
+}
+
 }  // namespace
 
 ConstantOp::ConstantOp(OpKernelConstruction* ctx)
@@ -82,6 +141,12 @@ ConstantOp::ConstantOp(OpKernelConstruction* ctx)
       errors::InvalidArgument("Type mismatch between value (",
                               DataTypeString(tensor_.dtype()), ") and dtype (",
                               DataTypeString(ctx->output_type(0)), ")"));
+  if (ctx->device_type() == DEVICE_CPU &&
+      DataTypeCanUseMemcpy(tensor_.dtype()) &&
+      tensor_.TotalBytes() >= kMinSharedConstantBytes) {
+    shared_fingerprint_ = FingerprintConstant(tensor_);
+    is_shared_ = ShareConstant(shared_fingerprint_, &tensor_);
+  }
 }
 
 void ConstantOp::Compute(OpKernelContext* ctx) {
@@ -91,7 +156,9 @@ void ConstantOp::Compute(OpKernelContext* ctx) {
   }
 }
 
-ConstantOp::~ConstantOp() {}
+ConstantOp::~ConstantOp() {
+  if (is_shared_) ReleaseSharedConstant(shared_fingerprint_);
+}
 
 REGISTER_KERNEL_BUILDER(Name("Const").Device(DEVICE_CPU), ConstantOp);
 REGISTER_KERNEL_BUILDER(Name("Const").Device(DEVICE_TPU_SYSTEM), ConstantOp);
@@ -34,6 +34,9 @@ class ConstantOp : public OpKernel {
 
  private:
   Tensor tensor_;
+  // Set if tensor_ is shared with the identical constants of other kernels.
+  bool is_shared_ = false;
+  uint64 shared_fingerprint_ = 0;
   TF_DISALLOW_COPY_AND_ASSIGN(ConstantOp);
 };
 
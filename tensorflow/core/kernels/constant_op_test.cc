@@ -96,6 +96,47 @@ TEST_F(ConstantOpTest, PersistentMemoryTracking) {
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 }
 
+TEST_F(ConstantOpTest, SharesIdenticalLargeConstants) {
+  std::unique_ptr<Device> device(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:worker/replica:0/task:0"));
+  auto make_kernel = [&](const string& name, float value) {
+    Tensor tensor(DT_FLOAT, TensorShape({64 << 10}));
+    tensor.flat<float>().setConstant(value);
+    NodeDef const_node;
+    TF_CHECK_OK(NodeDefBuilder(name, "Const")
+                    .Attr("dtype", DT_FLOAT)
+                    .Attr("value", tensor)
+                    .Finalize(&const_node));
+    Status status;
+    std::unique_ptr<OpKernel> op(CreateOpKernel(DEVICE_CPU, device.get(),
+                                                cpu_allocator(), const_node,
+                                                TF_GRAPH_DEF_VERSION, &status));
+    TF_CHECK_OK(status);
+    return op;
+  };
+  auto output_data = [&](OpKernel* op) {
+    OpKernelContext::Params params;
+    params.device = device.get();
+    params.frame_iter = FrameAndIter(0, 0);
+    params.op_kernel = op;
+    OpKernelContext ctx(&params);
+    op->Compute(&ctx);
+    TF_CHECK_OK(ctx.status());
+    return ctx.mutable_output(0)->tensor_data().data();
+  };
+
+  std::unique_ptr<OpKernel> a = make_kernel("a", 1.0f);
+  std::unique_ptr<OpKernel> b = make_kernel("b", 1.0f);
+  std::unique_ptr<OpKernel> c = make_kernel("c", 2.0f);
+  EXPECT_EQ(output_data(a.get()), output_data(b.get()));
+  EXPECT_NE(output_data(a.get()), output_data(c.get()));
+
+  // The shared constant outlives the kernel which created it.
+  a.reset();
+  std::unique_ptr<OpKernel> d = make_kernel("d", 1.0f);
+  EXPECT_EQ(output_data(b.get()), output_data(d.get()));
+}
+
 // Returns graph containing "num" const nodes.  If 'sequential' is
 // true, make sure all constants are executed sequentially in the
 // graph by adding control dependencies.
@@ -0,0 +1,282 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/cpu_dispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+// The kernels are compiled for each instruction set with target attributes,
+// so the rest of the file is compiled for the baseline instruction set.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    !defined(TENSORFLOW_DISABLE_CPU_DISPATCH)
+#define TENSORFLOW_USE_CPU_DISPATCH (1)
+#include <immintrin.h>
+#endif
+
+namespace tensorflow {
+namespace cpu_dispatch {
+
+namespace {
+
+#ifdef TENSORFLOW_USE_CPU_DISPATCH
+
+namespace avx2 {
+
+#define TF_CPU_DISPATCH_TARGET __attribute__((target("avx2,fma")))
+
+typedef __m256 Packet;
+constexpr int kPacketSize = 8;
+
+TF_CPU_DISPATCH_TARGET inline Packet PLoad(const float* from) {
+  return _mm256_loadu_ps(from);
+}
+TF_CPU_DISPATCH_TARGET inline void PStore(float* to, Packet from) {
+  _mm256_storeu_ps(to, from);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PSet1(float value) {
+  return _mm256_set1_ps(value);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PAdd(Packet a, Packet b) {
+  return _mm256_add_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PSub(Packet a, Packet b) {
+  return _mm256_sub_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMul(Packet a, Packet b) {
+  return _mm256_mul_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PDiv(Packet a, Packet b) {
+  return _mm256_div_ps(a, b);
+}
+// Returns a * b + c.
+TF_CPU_DISPATCH_TARGET inline Packet PMadd(Packet a, Packet b, Packet c) {
+  return _mm256_fmadd_ps(a, b, c);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMin(Packet a, Packet b) {
+  return _mm256_min_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMax(Packet a, Packet b) {
+  return _mm256_max_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PFloor(Packet a) {
+  return _mm256_floor_ps(a);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PPow2(Packet n) {
+  const __m256i exponent =
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+}
+TF_CPU_DISPATCH_TARGET inline float PReduceSum(Packet a) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(a),
+                          _mm256_extractf128_ps(a, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+TF_CPU_DISPATCH_TARGET inline float PReduceMax(Packet a) {
+  __m128 max = _mm_max_ps(_mm256_castps256_ps128(a),
+                          _mm256_extractf128_ps(a, 1));
+  max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+  max = _mm_max_ss(max, _mm_shuffle_ps(max, max, 1));
+  return _mm_cvtss_f32(max);
+}
+
+#include "tensorflow/core/kernels/cpu_dispatch_impl.h"
+
+#undef TF_CPU_DISPATCH_TARGET
+
+}  // namespace avx2
+
+namespace avx512 {
+
+#define TF_CPU_DISPATCH_TARGET __attribute__((target("avx512f")))
+
+typedef __m512 Packet;
+constexpr int kPacketSize = 16;
+
+TF_CPU_DISPATCH_TARGET inline Packet PLoad(const float* from) {
+  return _mm512_loadu_ps(from);
+}
+TF_CPU_DISPATCH_TARGET inline void PStore(float* to, Packet from) {
+  _mm512_storeu_ps(to, from);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PSet1(float value) {
+  return _mm512_set1_ps(value);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PAdd(Packet a, Packet b) {
+  return _mm512_add_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PSub(Packet a, Packet b) {
+  return _mm512_sub_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMul(Packet a, Packet b) {
+  return _mm512_mul_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PDiv(Packet a, Packet b) {
+  return _mm512_div_ps(a, b);
+}
+// Returns a * b + c.
+TF_CPU_DISPATCH_TARGET inline Packet PMadd(Packet a, Packet b, Packet c) {
+  return _mm512_fmadd_ps(a, b, c);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMin(Packet a, Packet b) {
+  return _mm512_min_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PMax(Packet a, Packet b) {
+  return _mm512_max_ps(a, b);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PFloor(Packet a) {
+  return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+}
+TF_CPU_DISPATCH_TARGET inline Packet PPow2(Packet n) {
+  const __m512i exponent =
+      _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(exponent, 23));
+}
+TF_CPU_DISPATCH_TARGET inline float PReduceSum(Packet a) {
+  return _mm512_reduce_add_ps(a);
+}
+TF_CPU_DISPATCH_TARGET inline float PReduceMax(Packet a) {
+  return _mm512_reduce_max_ps(a);
+}
+
+#include "tensorflow/core/kernels/cpu_dispatch_impl.h"
+
+#undef TF_CPU_DISPATCH_TARGET
+
+}  // namespace avx512
+
+const Kernels kAvx2Kernels = {"AVX2",        avx2::Add,  avx2::Mul,
+                              avx2::Tanh,    avx2::Sigmoid, avx2::Sum,
+                              avx2::Softmax};
+
+const Kernels kAvx512Kernels = {"AVX-512",       avx512::Add,
+                                avx512::Mul,     avx512::Tanh,
+                                avx512::Sigmoid, avx512::Sum,
+                                avx512::Softmax};
+
+#endif  // TENSORFLOW_USE_CPU_DISPATCH
+
+const Kernels* SelectKernels() {
+  bool disabled;
+  Status status =
+      ReadBoolFromEnvVar("TF_DISABLE_CPU_DISPATCH", false, &disabled);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  if (disabled) return nullptr;
+  const Kernels* kernels = nullptr;
+#ifdef TENSORFLOW_USE_CPU_DISPATCH
+#if !defined(__AVX512F__)
+  if (port::TestCPUFeature(port::CPUFeature::AVX512F)) {
+    kernels = &kAvx512Kernels;
+  }
+#if !defined(__AVX2__) || !defined(__FMA__)
+  if (kernels == nullptr && port::TestCPUFeature(port::CPUFeature::AVX2) &&
+      port::TestCPUFeature(port::CPUFeature::FMA)) {
+    kernels = &kAvx2Kernels;
+  }
+#endif
+#endif
+#endif  // TENSORFLOW_USE_CPU_DISPATCH
+  if (kernels != nullptr) {
+    VLOG(1) << "Using the " << kernels->isa << " cwise and reduction kernels.";
+  }
+  return kernels;
+}
+
+}  // namespace
+
+const Kernels* GetKernels() {
+  static const Kernels* kernels = SelectKernels();
+  return kernels;
+}
+
+void ParallelUnary(const Eigen::ThreadPoolDevice& d, UnaryKernel kernel,
+                   double cost_per_element, const float* in, float* out,
+                   int64 size) {
+  d.parallelFor(size,
+                Eigen::TensorOpCost(sizeof(float), sizeof(float),
+                                    cost_per_element),
+                [kernel, in, out](Eigen::Index start, Eigen::Index limit) {
+                  kernel(in + start, out + start, limit - start);
+                });
+}
+
+void ParallelBinary(const Eigen::ThreadPoolDevice& d, BinaryKernel kernel,
+                    double cost_per_element, const float* in0,
+                    const float* in1, float* out, int64 size) {
+  d.parallelFor(size,
+                Eigen::TensorOpCost(2 * sizeof(float), sizeof(float),
+                                    cost_per_element),
+                [kernel, in0, in1, out](Eigen::Index start,
+                                        Eigen::Index limit) {
+                  kernel(in0 + start, in1 + start, out + start,
+                         limit - start);
+                });
+}
+
+void RowSums(const Eigen::ThreadPoolDevice& d, const Kernels& kernels,
+             const float* in, int64 rows, int64 cols, float* out) {
+  if (rows == 1) {
+    // Sums blocks of a single row in parallel, then the sums of the blocks.
+    constexpr int64 kBlockSize = 16384;
+    const int64 num_blocks = (cols + kBlockSize - 1) / kBlockSize;
+    std::vector<float> block_sums(num_blocks);
+    d.parallelFor(num_blocks,
+                  Eigen::TensorOpCost(kBlockSize * sizeof(float),
+                                      sizeof(float), kBlockSize),
+                  [&](Eigen::Index start, Eigen::Index limit) {
+                    for (int64 b = start; b < limit; ++b) {
+                      const int64 begin = b * kBlockSize;
+                      block_sums[b] = kernels.sum(
+                          in + begin, std::min(kBlockSize, cols - begin));
+                    }
+                  });
+    out[0] = kernels.sum(block_sums.data(), num_blocks);
+    return;
+  }
+  d.parallelFor(rows,
+                Eigen::TensorOpCost(cols * sizeof(float), sizeof(float), cols),
+                [&](Eigen::Index start, Eigen::Index limit) {
+                  for (int64 r = start; r < limit; ++r) {
+                    out[r] = kernels.sum(in + r * cols, cols);
+                  }
+                });
+}
+
+void RowSoftmax(const Eigen::ThreadPoolDevice& d, const Kernels& kernels,
+                const float* in, int64 rows, int64 cols, bool log,
+                float* out) {
+  // Reads each row twice and writes it twice, with an exp per element.
+  d.parallelFor(rows,
+                Eigen::TensorOpCost(2 * cols * sizeof(float),
+                                    2 * cols * sizeof(float), 20 * cols),
+                [&](Eigen::Index start, Eigen::Index limit) {
+                  for (int64 r = start; r < limit; ++r) {
+                    kernels.softmax(in + r * cols, cols, log, out + r * cols);
+                  }
+                });
+}
+
+}  // namespace cpu_dispatch
+}  // namespace tensorflow
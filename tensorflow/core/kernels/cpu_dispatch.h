@@ -0,0 +1,77 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CPU_DISPATCH_H_
+#define TENSORFLOW_CORE_KERNELS_CPU_DISPATCH_H_
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace cpu_dispatch {
+
+// The Eigen kernels are compiled for the instruction set chosen at build time,
+// which is the lowest common denominator of the machines a binary runs on.
+// This library compiles the hottest float kernels once per x86 vector
+// instruction set and picks, once per process, the best one the CPU supports.
+// Kernels use them only when that instruction set is better than the one
+// TensorFlow was built for, and use Eigen otherwise.
+
+typedef void (*UnaryKernel)(const float* in, float* out, int64 size);
+typedef void (*BinaryKernel)(const float* in0, const float* in1, float* out,
+                             int64 size);
+
+struct Kernels {
+  // Name of the instruction set the kernels are compiled for.
+  const char* isa;
+  BinaryKernel add;
+  BinaryKernel mul;
+  UnaryKernel tanh;
+  UnaryKernel sigmoid;
+  // Returns the sum of in[0, size).
+  float (*sum)(const float* in, int64 size);
+  // Writes the softmax, or log softmax if `log`, of in[0, size) to out.
+  void (*softmax)(const float* in, int64 size, bool log, float* out);
+};
+
+// Returns the kernels for the best instruction set of the CPU, or nullptr if
+// it is no better than the one TensorFlow was built for, or if the environment
+// variable TF_DISABLE_CPU_DISPATCH is true.
+const Kernels* GetKernels();
+
+// Helpers running the kernels over a thread pool. `cost_per_element` is the
+// estimated number of cycles per element of the kernel.
+void ParallelUnary(const Eigen::ThreadPoolDevice& d, UnaryKernel kernel,
+                   double cost_per_element, const float* in, float* out,
+                   int64 size);
+void ParallelBinary(const Eigen::ThreadPoolDevice& d, BinaryKernel kernel,
+                    double cost_per_element, const float* in0,
+                    const float* in1, float* out, int64 size);
+
+// Writes the sum of each row of the row major [rows, cols] matrix `in` to out.
+void RowSums(const Eigen::ThreadPoolDevice& d, const Kernels& kernels,
+             const float* in, int64 rows, int64 cols, float* out);
+
+// Writes the softmax, or log softmax if `log`, of each row of the row major
+// [rows, cols] matrix `in` to out.
+void RowSoftmax(const Eigen::ThreadPoolDevice& d, const Kernels& kernels,
+                const float* in, int64 rows, int64 cols, bool log, float* out);
+
+}  // namespace cpu_dispatch
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CPU_DISPATCH_H_
@@ -0,0 +1,192 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The float kernels of cpu_dispatch.h, written in terms of a packet type and
+// primitives defined for one instruction set.  Textually included by
+// cpu_dispatch.cc once per instruction set, inside a namespace defining:
+//
+//   Packet, kPacketSize
+//   TF_CPU_DISPATCH_TARGET, the target attribute of the instruction set
+//   PLoad, PStore, PSet1, PAdd, PSub, PMul, PDiv, PMadd, PMin, PMax, PFloor
+//   PPow2(n): 2^n for integral n in [-127, 127]
+//   PReduceSum, PReduceMax
+//
+// so there is intentionally no include guard.
+
+// Returns tanh(x), with the rational approximation Eigen uses for float.
+TF_CPU_DISPATCH_TARGET inline Packet PTanh(Packet x) {
+  // Anything outside of [-9, 9] is +/-1 in single precision.  PMin and PMax
+  // return their second operand if either is NaN, so NaN is propagated.
+  x = PMax(PSet1(-9.0f), PMin(PSet1(9.0f), x));
+  const Packet x2 = PMul(x, x);
+  // Odd numerator polynomial.
+  Packet p = PMadd(x2, PSet1(-2.76076847742355e-16f),
+                   PSet1(2.00018790482477e-13f));
+  p = PMadd(x2, p, PSet1(-8.60467152213735e-11f));
+  p = PMadd(x2, p, PSet1(5.12229709037114e-08f));
+  p = PMadd(x2, p, PSet1(1.48572235717979e-05f));
+  p = PMadd(x2, p, PSet1(6.37261928875436e-04f));
+  p = PMadd(x2, p, PSet1(4.89352455891786e-03f));
+  p = PMul(x, p);
+  // Even denominator polynomial.
+  Packet q = PMadd(x2, PSet1(1.19825839466702e-06f),
+                   PSet1(1.18534705686654e-04f));
+  q = PMadd(x2, q, PSet1(2.26843463243900e-03f));
+  q = PMadd(x2, q, PSet1(4.89352518554385e-03f));
+  return PDiv(p, q);
+}
+
+// Returns 1 / (1 + exp(-x)) as 0.5 + 0.5 * tanh(x / 2).
+TF_CPU_DISPATCH_TARGET inline Packet PSigmoid(Packet x) {
+  const Packet half = PSet1(0.5f);
+  return PMadd(PTanh(PMul(x, half)), half, half);
+}
+
+// Returns exp(x), with the Cephes polynomial Eigen uses for float.  Inputs
+// are clamped to [-88, 88], and exp(-88) is flushed to zero.
+TF_CPU_DISPATCH_TARGET inline Packet PExp(Packet x) {
+  x = PMax(PSet1(-88.0f), PMin(PSet1(88.0f), x));
+  // exp(x) = 2^m * exp(r), with m = floor(x / ln(2) + 0.5) and
+  // r = x - m * ln(2), where ln(2) is split in two for accuracy.
+  const Packet m = PFloor(PMadd(x, PSet1(1.44269504088896341f), PSet1(0.5f)));
+  Packet r = PSub(x, PMul(m, PSet1(0.693359375f)));
+  r = PSub(r, PMul(m, PSet1(-2.12194440e-4f)));
+  const Packet r2 = PMul(r, r);
+  Packet y = PMadd(PSet1(1.9875691500e-4f), r, PSet1(1.3981999507e-3f));
+  y = PMadd(y, r, PSet1(8.3334519073e-3f));
+  y = PMadd(y, r, PSet1(4.1665795894e-2f));
+  y = PMadd(y, r, PSet1(1.6666665459e-1f));
+  y = PMadd(y, r, PSet1(5.0000001201e-1f));
+  y = PMadd(y, r2, PAdd(r, PSet1(1.0f)));
+  return PMul(y, PPow2(m));
+}
+
+TF_CPU_DISPATCH_TARGET void Add(const float* in0, const float* in1,
+                                float* out, int64 size) {
+  int64 i = 0;
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    PStore(out + i, PAdd(PLoad(in0 + i), PLoad(in1 + i)));
+  }
+  for (; i < size; ++i) out[i] = in0[i] + in1[i];
+}
+
+TF_CPU_DISPATCH_TARGET void Mul(const float* in0, const float* in1,
+                                float* out, int64 size) {
+  int64 i = 0;
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    PStore(out + i, PMul(PLoad(in0 + i), PLoad(in1 + i)));
+  }
+  for (; i < size; ++i) out[i] = in0[i] * in1[i];
+}
+
+// The last partial packet of the transcendental kernels goes through a padded
+// buffer, so every element is computed by the same approximation.
+TF_CPU_DISPATCH_TARGET void Tanh(const float* in, float* out, int64 size) {
+  int64 i = 0;
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    PStore(out + i, PTanh(PLoad(in + i)));
+  }
+  if (i < size) {
+    float buffer[kPacketSize] = {};
+    std::copy(in + i, in + size, buffer);
+    PStore(buffer, PTanh(PLoad(buffer)));
+    std::copy(buffer, buffer + (size - i), out + i);
+  }
+}
+
+TF_CPU_DISPATCH_TARGET void Sigmoid(const float* in, float* out, int64 size) {
+  int64 i = 0;
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    PStore(out + i, PSigmoid(PLoad(in + i)));
+  }
+  if (i < size) {
+    float buffer[kPacketSize] = {};
+    std::copy(in + i, in + size, buffer);
+    PStore(buffer, PSigmoid(PLoad(buffer)));
+    std::copy(buffer, buffer + (size - i), out + i);
+  }
+}
+
+TF_CPU_DISPATCH_TARGET float Sum(const float* in, int64 size) {
+  // Four accumulators hide the latency of the additions.
+  Packet sum0 = PSet1(0.0f);
+  Packet sum1 = PSet1(0.0f);
+  Packet sum2 = PSet1(0.0f);
+  Packet sum3 = PSet1(0.0f);
+  int64 i = 0;
+  for (; i + 4 * kPacketSize <= size; i += 4 * kPacketSize) {
+    sum0 = PAdd(sum0, PLoad(in + i));
+    sum1 = PAdd(sum1, PLoad(in + i + kPacketSize));
+    sum2 = PAdd(sum2, PLoad(in + i + 2 * kPacketSize));
+    sum3 = PAdd(sum3, PLoad(in + i + 3 * kPacketSize));
+  }
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    sum0 = PAdd(sum0, PLoad(in + i));
+  }
+  float sum = PReduceSum(PAdd(PAdd(sum0, sum1), PAdd(sum2, sum3)));
+  for (; i < size; ++i) sum += in[i];
+  return sum;
+}
+
+TF_CPU_DISPATCH_TARGET void Softmax(const float* in, int64 size, bool log,
+                                    float* out) {
+  const float kLowest = -std::numeric_limits<float>::infinity();
+  int64 i = 0;
+  Packet max_packet = PSet1(kLowest);
+  for (; i + kPacketSize <= size; i += kPacketSize) {
+    max_packet = PMax(max_packet, PLoad(in + i));
+  }
+  float max = PReduceMax(max_packet);
+  for (; i < size; ++i) max = std::max(max, in[i]);
+  const Packet max_broadcast = PSet1(max);
+
+  // Writes exp(x - max) to out, or x - max for the log softmax, and sums
+  // exp(x - max).  The padding of the last partial packet is -inf, whose exp
+  // is zero.
+  Packet sum_packet = PSet1(0.0f);
+  for (i = 0; i + kPacketSize <= size; i += kPacketSize) {
+    const Packet shifted = PSub(PLoad(in + i), max_broadcast);
+    const Packet exp = PExp(shifted);
+    sum_packet = PAdd(sum_packet, exp);
+    PStore(out + i, log ? shifted : exp);
+  }
+  if (i < size) {
+    float buffer[kPacketSize];
+    std::fill(buffer, buffer + kPacketSize, kLowest);
+    std::copy(in + i, in + size, buffer);
+    const Packet shifted = PSub(PLoad(buffer), max_broadcast);
+    const Packet exp = PExp(shifted);
+    sum_packet = PAdd(sum_packet, exp);
+    PStore(buffer, log ? shifted : exp);
+    std::copy(buffer, buffer + (size - i), out + i);
+  }
+  const float sum = PReduceSum(sum_packet);
+
+  if (log) {
+    const float log_sum = std::log(sum);
+    const Packet log_sum_broadcast = PSet1(log_sum);
+    for (i = 0; i + kPacketSize <= size; i += kPacketSize) {
+      PStore(out + i, PSub(PLoad(out + i), log_sum_broadcast));
+    }
+    for (; i < size; ++i) out[i] -= log_sum;
+  } else {
+    const float inverse_sum = 1.0f / sum;
+    const Packet inverse_sum_broadcast = PSet1(inverse_sum);
+    for (i = 0; i + kPacketSize <= size; i += kPacketSize) {
+      PStore(out + i, PMul(PLoad(out + i), inverse_sum_broadcast));
+    }
+    for (; i < size; ++i) out[i] *= inverse_sum;
+  }
+}
@@ -0,0 +1,142 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/cpu_dispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace cpu_dispatch {
+namespace {
+
+// Sizes which are not multiples of the packet sizes, to cover the tails.
+const int64 kSizes[] = {1, 7, 8, 15, 17, 33, 100, 1001};
+
+std::vector<float> Values(int64 size) {
+  std::vector<float> values(size);
+  for (int64 i = 0; i < size; ++i) {
+    values[i] = (i * 37 % 101) / 5.0f - 10.0f;
+  }
+  return values;
+}
+
+class CpuDispatchTest : public ::testing::Test {
+ protected:
+  CpuDispatchTest()
+      : thread_pool_(Env::Default(), "cpu_dispatch_test", 4),
+        device_(thread_pool_.AsEigenThreadPool(), 4),
+        kernels_(GetKernels()) {}
+
+  thread::ThreadPool thread_pool_;
+  Eigen::ThreadPoolDevice device_;
+  const Kernels* kernels_;
+};
+
+TEST_F(CpuDispatchTest, AddAndMul) {
+  if (kernels_ == nullptr) return;
+  for (const int64 size : kSizes) {
+    const std::vector<float> x = Values(size);
+    std::vector<float> y(size);
+    for (int64 i = 0; i < size; ++i) y[i] = 0.5f * i;
+    std::vector<float> out(size);
+    kernels_->add(x.data(), y.data(), out.data(), size);
+    for (int64 i = 0; i < size; ++i) EXPECT_EQ(x[i] + y[i], out[i]);
+    kernels_->mul(x.data(), y.data(), out.data(), size);
+    for (int64 i = 0; i < size; ++i) EXPECT_EQ(x[i] * y[i], out[i]);
+  }
+}
+
+TEST_F(CpuDispatchTest, TanhAndSigmoid) {
+  if (kernels_ == nullptr) return;
+  for (const int64 size : kSizes) {
+    const std::vector<float> x = Values(size);
+    std::vector<float> out(size);
+    kernels_->tanh(x.data(), out.data(), size);
+    for (int64 i = 0; i < size; ++i) {
+      EXPECT_NEAR(std::tanh(x[i]), out[i], 1e-6);
+    }
+    kernels_->sigmoid(x.data(), out.data(), size);
+    for (int64 i = 0; i < size; ++i) {
+      EXPECT_NEAR(1.0f / (1.0f + std::exp(-x[i])), out[i], 1e-6);
+    }
+  }
+}
+
+TEST_F(CpuDispatchTest, PropagatesNaN) {
+  if (kernels_ == nullptr) return;
+  const float x[] = {std::numeric_limits<float>::quiet_NaN(), 1.0f};
+  float out[2];
+  kernels_->tanh(x, out, 2);
+  EXPECT_TRUE(std::isnan(out[0]));
+  kernels_->sigmoid(x, out, 2);
+  EXPECT_TRUE(std::isnan(out[0]));
+  kernels_->softmax(x, 2, false, out);
+  EXPECT_TRUE(std::isnan(out[1]));
+}
+
+TEST_F(CpuDispatchTest, RowSums) {
+  if (kernels_ == nullptr) return;
+  for (const int64 rows : {1, 3}) {
+    // Large enough to split the single row in blocks.
+    for (const int64 cols : {1, 17, 100000}) {
+      const std::vector<float> x = Values(rows * cols);
+      std::vector<float> out(rows);
+      RowSums(device_, *kernels_, x.data(), rows, cols, out.data());
+      for (int64 r = 0; r < rows; ++r) {
+        double expected = 0;
+        for (int64 c = 0; c < cols; ++c) expected += x[r * cols + c];
+        EXPECT_NEAR(expected, out[r], 1e-6 * cols);
+      }
+    }
+  }
+}
+
+TEST_F(CpuDispatchTest, RowSoftmax) {
+  if (kernels_ == nullptr) return;
+  const int64 rows = 5;
+  for (const int64 cols : kSizes) {
+    const std::vector<float> x = Values(rows * cols);
+    for (const bool log : {false, true}) {
+      std::vector<float> out(rows * cols);
+      RowSoftmax(device_, *kernels_, x.data(), rows, cols, log, out.data());
+      for (int64 r = 0; r < rows; ++r) {
+        const float* row = x.data() + r * cols;
+        const float max = *std::max_element(row, row + cols);
+        double sum = 0;
+        for (int64 c = 0; c < cols; ++c) sum += std::exp(row[c] - max);
+        for (int64 c = 0; c < cols; ++c) {
+          if (log) {
+            EXPECT_NEAR(row[c] - max - std::log(sum), out[r * cols + c],
+                        1e-5);
+          } else {
+            EXPECT_NEAR(std::exp(row[c] - max) / sum, out[r * cols + c],
+                        1e-6);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cpu_dispatch
+}  // namespace tensorflow
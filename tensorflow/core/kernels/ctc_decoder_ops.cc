@@ -311,42 +311,68 @@ class CTCBeamSearchDecoderOp : public OpKernel {
 
     log_prob_t.setZero();
 
-    std::vector<typename TTypes<T>::UnalignedConstMatrix> input_list_t;
-
-    input_list_t.reserve(max_time);
-    for (std::size_t t = 0; t < max_time; ++t) {
-      input_list_t.emplace_back(inputs_t.data() + t * batch_size * num_classes,
-                                batch_size, num_classes);
-    }
-
-    ctc::CTCBeamSearchDecoder<T> beam_search(num_classes, beam_width_,
-                                             &beam_scorer_, 1 /* batch_size */,
-                                             merge_repeated_);
-    Tensor input_chip(DataTypeToEnum<T>::v(), TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<T>();
-
-    std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<T> log_probs;
+    // The inputs of (batch entry b, time t) are contiguous, at
+    // inputs_t.data() + (t * batch_size + b) * num_classes.
+    typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> InputRow;
+    auto input_row = [&inputs_t, batch_size, num_classes](int64 t, int64 b) {
+      return InputRow(inputs_t.data() + (t * batch_size + b) * num_classes,
+                      num_classes);
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
 
-    // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(
-            input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
+    // The softmax normalization terms of all the steps do not depend on each
+    // other, unlike the steps, so they are computed upfront in parallel. This
+    // spreads a part of the work of long sequences over threads even for a
+    // single batch entry.
+    std::vector<T> norm_offsets(max_time * batch_size);
+    auto normalize = [&](const int64 begin, const int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const int64 t = i / batch_size;
+        const int64 b = i % batch_size;
+        if (t < seq_len_t(b)) {
+          norm_offsets[i] =
+              ctc::CTCBeamSearchDecoder<T>::LogNormalizer(input_row(t, b));
+        }
       }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          max_time * batch_size, 10 * num_classes, normalize);
 
-      beam_search.Reset();
+    std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
+    std::vector<Status> statuses(batch_size);
 
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+    // Batch entries are decoded in parallel, each shard with its own decoder.
+    // The default beam scorer has no state, so the shards share it.
+    auto decode = [&](const int64 begin, const int64 end) {
+      ctc::CTCBeamSearchDecoder<T> beam_search(num_classes, beam_width_,
+                                               &beam_scorer_,
+                                               1 /* batch_size */,
+                                               merge_repeated_);
+      std::vector<T> log_probs;
+      // Assumption: the blank index is num_classes - 1
+      for (int64 b = begin; b < end; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(decode_helper_.GetTopPaths());
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          beam_search.Step(input_row(t, b), norm_offsets[t * batch_size + b]);
+        }
+        statuses[b] = beam_search.TopPaths(decode_helper_.GetTopPaths(),
+                                           &best_paths_b, &log_probs,
+                                           merge_repeated_);
+        beam_search.Reset();
+        if (!statuses[b].ok()) continue;
+        for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
+    };
+    const int64 kCostPerUnit =
+        50 * max_time * beam_width_ * std::min(num_classes, 64);
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          kCostPerUnit, decode);
+    for (const Status& status : statuses) {
+      OP_REQUIRES_OK(ctx, status);
     }
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
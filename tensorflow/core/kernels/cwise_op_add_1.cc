@@ -14,12 +14,13 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/cwise_ops_common.h"
+#include "tensorflow/core/kernels/cwise_ops_cpu_dispatch.h"
 
 namespace tensorflow {
-REGISTER6(BinaryOp, CPU, "Add", functor::add, float, Eigen::half, double, int32,
-          int64, bfloat16);
-REGISTER6(BinaryOp, CPU, "AddV2", functor::add, float, Eigen::half, double,
-          int32, int64, bfloat16);
+REGISTER6(CpuDispatchBinaryOp, CPU, "Add", functor::add, float, Eigen::half,
+          double, int32, int64, bfloat16);
+REGISTER6(CpuDispatchBinaryOp, CPU, "AddV2", functor::add, float, Eigen::half,
+          double, int32, int64, bfloat16);
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 REGISTER3(BinaryOp, GPU, "Add", functor::add, float, Eigen::half, double);
@@ -14,11 +14,12 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/cwise_ops_common.h"
+#include "tensorflow/core/kernels/cwise_ops_cpu_dispatch.h"
 
 namespace tensorflow {
 
-REGISTER6(BinaryOp, CPU, "Mul", functor::mul, float, Eigen::half, double, uint8,
-          int32, bfloat16);
+REGISTER6(CpuDispatchBinaryOp, CPU, "Mul", functor::mul, float, Eigen::half,
+          double, uint8, int32, bfloat16);
 REGISTER6(BinaryOp, CPU, "MulNoNan", functor::mul_no_nan, Eigen::half, float,
           double, complex64, complex128, bfloat16);
 
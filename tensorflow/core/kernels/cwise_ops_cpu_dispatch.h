@@ -0,0 +1,145 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CWISE_OPS_CPU_DISPATCH_H_
+#define TENSORFLOW_CORE_KERNELS_CWISE_OPS_CPU_DISPATCH_H_
+
+#include "tensorflow/core/kernels/cpu_dispatch.h"
+#include "tensorflow/core/kernels/cwise_ops_common.h"
+
+namespace tensorflow {
+
+// Maps a cwise functor to its kernel in cpu_dispatch::Kernels, if any.  The
+// specializations only define the getter of their arity.
+template <typename Functor>
+struct CpuDispatchKernel {
+  static constexpr bool kSupported = false;
+  static cpu_dispatch::UnaryKernel GetUnary(const cpu_dispatch::Kernels&) {
+    return nullptr;
+  }
+  static cpu_dispatch::BinaryKernel GetBinary(const cpu_dispatch::Kernels&) {
+    return nullptr;
+  }
+};
+
+template <>
+struct CpuDispatchKernel<functor::add<float>> {
+  static constexpr bool kSupported = true;
+  static cpu_dispatch::BinaryKernel GetBinary(
+      const cpu_dispatch::Kernels& kernels) {
+    return kernels.add;
+  }
+};
+
+template <>
+struct CpuDispatchKernel<functor::mul<float>> {
+  static constexpr bool kSupported = true;
+  static cpu_dispatch::BinaryKernel GetBinary(
+      const cpu_dispatch::Kernels& kernels) {
+    return kernels.mul;
+  }
+};
+
+template <>
+struct CpuDispatchKernel<functor::tanh<float>> {
+  static constexpr bool kSupported = true;
+  static cpu_dispatch::UnaryKernel GetUnary(
+      const cpu_dispatch::Kernels& kernels) {
+    return kernels.tanh;
+  }
+};
+
+template <>
+struct CpuDispatchKernel<functor::sigmoid<float>> {
+  static constexpr bool kSupported = true;
+  static cpu_dispatch::UnaryKernel GetUnary(
+      const cpu_dispatch::Kernels& kernels) {
+    return kernels.sigmoid;
+  }
+};
+
+// UnaryOp, whose float CPU kernel is replaced by the one of cpu_dispatch.h for
+// the functors that have one, when it is better than the Eigen kernel.  The
+// kernel is chosen when the OpKernel is constructed.  Only registered for
+// CPUDevice.
+template <typename Device, typename Functor>
+class CpuDispatchUnaryOp : public UnaryOp<Device, Functor> {
+ public:
+  explicit CpuDispatchUnaryOp(OpKernelConstruction* ctx)
+      : UnaryOp<Device, Functor>(ctx),
+        kernel_(CpuDispatchKernel<Functor>::kSupported &&
+                        cpu_dispatch::GetKernels() != nullptr
+                    ? CpuDispatchKernel<Functor>::GetUnary(
+                          *cpu_dispatch::GetKernels())
+                    : nullptr) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    if (kernel_ == nullptr) {
+      UnaryOp<Device, Functor>::Compute(ctx);
+      return;
+    }
+    const Tensor& inp = ctx->input(0);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, inp.shape(), &out));
+    cpu_dispatch::ParallelUnary(
+        ctx->eigen_device<CPUDevice>(), kernel_,
+        Eigen::internal::functor_traits<typename Functor::func>::Cost,
+        inp.flat<float>().data(), out->flat<float>().data(),
+        inp.NumElements());
+  }
+
+ private:
+  const cpu_dispatch::UnaryKernel kernel_;
+};
+
+// BinaryOp, whose float CPU kernel for inputs of the same shape is replaced by
+// the one of cpu_dispatch.h for the functors that have one, when it is better
+// than the Eigen kernel.  Only registered for CPUDevice.
+template <typename Device, typename Functor>
+class CpuDispatchBinaryOp : public BinaryOp<Device, Functor> {
+ public:
+  explicit CpuDispatchBinaryOp(OpKernelConstruction* ctx)
+      : BinaryOp<Device, Functor>(ctx),
+        kernel_(CpuDispatchKernel<Functor>::kSupported &&
+                        cpu_dispatch::GetKernels() != nullptr
+                    ? CpuDispatchKernel<Functor>::GetBinary(
+                          *cpu_dispatch::GetKernels())
+                    : nullptr) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input_0 = ctx->input(0);
+    const Tensor& input_1 = ctx->input(1);
+    if (kernel_ == nullptr || input_0.shape() != input_1.shape()) {
+      BinaryOp<Device, Functor>::Compute(ctx);
+      return;
+    }
+    Tensor* out;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0, 1}, 0, input_0.shape(), &out));
+    cpu_dispatch::ParallelBinary(
+        ctx->eigen_device<CPUDevice>(), kernel_,
+        Eigen::internal::functor_traits<typename Functor::func>::Cost,
+        input_0.flat<float>().data(), input_1.flat<float>().data(),
+        out->flat<float>().data(), input_0.NumElements());
+  }
+
+ private:
+  const cpu_dispatch::BinaryKernel kernel_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CWISE_OPS_CPU_DISPATCH_H_
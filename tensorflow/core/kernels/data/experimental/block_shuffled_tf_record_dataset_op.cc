@@ -0,0 +1,431 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/block_shuffled_tf_record_dataset_op.h"
+
+#include <atomic>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kFileNames;
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kBlockSize;
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kWindowSize;
+/* static */ constexpr const char* const BlockShuffledTFRecordDatasetOp::kSeed;
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kSeed2;
+/* static */ constexpr const char* const
+    BlockShuffledTFRecordDatasetOp::kReshuffleEachIteration;
+
+namespace {
+
+constexpr char kSeedState[] = "seed";
+constexpr char kSeed2State[] = "seed2";
+constexpr char kNumRandomSamples[] = "num_random_samples";
+constexpr char kBlocksInitialized[] = "blocks_initialized";
+constexpr char kNextBlock[] = "next_block";
+constexpr char kOffset[] = "offset";
+constexpr char kRecordsLeft[] = "records_left";
+constexpr char kWindowSizeState[] = "window_size";
+constexpr char kWindow[] = "window";
+
+}  // namespace
+
+class BlockShuffledTFRecordDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+          int64 block_size, int64 window_size, RandomSeeds&& seeds,
+          bool reshuffle_each_iteration)
+      : DatasetBase(DatasetContext(ctx)),
+        filenames_(std::move(filenames)),
+        block_size_(block_size),
+        window_size_(window_size),
+        seeds_(std::move(seeds)),
+        reshuffle_each_iteration_(reshuffle_each_iteration) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(
+        Iterator::Params{this,
+                         name_utils::IteratorPrefix(kDatasetType, prefix)},
+        num_iterators_.fetch_add(1));
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+    return *dtypes;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    static std::vector<PartialTensorShape>* shapes =
+        new std::vector<PartialTensorShape>({{}});
+    return *shapes;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override { return Status::OK(); }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* filenames = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+    Node* block_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(block_size_, &block_size));
+    Node* window_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(window_size_, &window_size));
+    Node* seed = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed(), &seed));
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed2(), &seed2));
+    AttrValue reshuffle_each_iteration;
+    b->BuildAttrValue(reshuffle_each_iteration_, &reshuffle_each_iteration);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {filenames, block_size, window_size, seed, seed2},
+        {std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    Iterator(const Params& params, int64 iteration)
+        : DatasetIterator<Dataset>(params),
+          seed_(dataset()->seeds_.seed()),
+          seed2_(dataset()->seeds_.seed2()),
+          parent_generator_(seed_, seed2_),
+          generator_(&parent_generator_) {
+      if (dataset()->reshuffle_each_iteration_ && iteration > 0) {
+        // Derives the seeds of this iteration from the dataset seeds, so
+        // that the sequence of orders is still determined by the seeds.
+        random::PhiloxRandom seed_generator(seed_, seed2_);
+        seed_generator.Skip(iteration);
+        const random::PhiloxRandom::ResultType seeds = seed_generator();
+        seed_ = (static_cast<int64>(seeds[0]) << 32) | seeds[1];
+        seed2_ = (static_cast<int64>(seeds[2]) << 32) | seeds[3];
+        parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+      }
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (!blocks_initialized_) {
+        TF_RETURN_IF_ERROR(InitializeBlocks(ctx->env()));
+      }
+      while (window_.size() < dataset()->window_size_ &&
+             (records_left_ > 0 || next_block_ < blocks_.size())) {
+        tstring record;
+        TF_RETURN_IF_ERROR(ReadRecord(ctx->env(), &record));
+        window_.push_back(std::move(record));
+      }
+      if (window_.empty()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      const int64 index = Random() % window_.size();
+      out_tensors->emplace_back(ctx->allocator({}), DT_STRING, TensorShape({}));
+      out_tensors->back().scalar<tstring>()() = std::move(window_[index]);
+      window_[index] = std::move(window_.back());
+      window_.pop_back();
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kSeedState), seed_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kSeed2State), seed2_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kNumRandomSamples),
+                                             num_random_samples_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kBlocksInitialized),
+                                             blocks_initialized_ ? 1 : 0));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kNextBlock), next_block_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kOffset),
+                                             static_cast<int64>(offset_)));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kRecordsLeft), records_left_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(kWindowSizeState), static_cast<int64>(window_.size())));
+      for (int64 i = 0; i < window_.size(); ++i) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kWindow, "[", i, "]")), window_[i]));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSeedState), &seed_));
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSeed2State), &seed2_));
+      int64 num_random_samples;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNumRandomSamples),
+                                            &num_random_samples));
+      int64 blocks_initialized;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kBlocksInitialized),
+                                            &blocks_initialized));
+      ResetGenerator();
+      blocks_.clear();
+      blocks_initialized_ = false;
+      current_file_index_ = -1;
+      record_reader_.reset();
+      file_.reset();
+      if (blocks_initialized) {
+        // Shuffling the blocks again draws the same samples as before.
+        TF_RETURN_IF_ERROR(InitializeBlocks(ctx->env()));
+      }
+      generator_.Skip(num_random_samples - num_random_samples_);
+      num_random_samples_ = num_random_samples;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kNextBlock), &next_block_));
+      int64 offset;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
+      offset_ = offset;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kRecordsLeft), &records_left_));
+      int64 window_size;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kWindowSizeState), &window_size));
+      window_.clear();
+      window_.reserve(window_size);
+      for (int64 i = 0; i < window_size; ++i) {
+        tstring record;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kWindow, "[", i, "]")), &record));
+        window_.push_back(std::move(record));
+      }
+      if (records_left_ > 0) {
+        TF_RETURN_IF_ERROR(OpenFile(
+            ctx->env(), blocks_[next_block_ - 1].file_index));
+      }
+      return Status::OK();
+    }
+
+   private:
+    // A run of consecutive records of a file.
+    struct Block {
+      int64 file_index;
+      uint64 offset;
+      int64 num_records;
+    };
+
+    // Finds the blocks of all files and shuffles them. The blocks of a file
+    // are read from its record index if it has one, and found by scanning
+    // the record headers of the file otherwise.
+    Status InitializeBlocks(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (int64 i = 0; i < dataset()->filenames_.size(); ++i) {
+        std::vector<uint64> offsets;
+        Status s = io::ReadRecordIndex(
+            env, io::RecordIndexFilename(dataset()->filenames_[i]), &offsets);
+        if (s.ok()) {
+          for (int64 j = 0; j < offsets.size(); j += dataset()->block_size_) {
+            blocks_.push_back(
+                {i, offsets[j],
+                 std::min<int64>(dataset()->block_size_, offsets.size() - j)});
+          }
+          continue;
+        }
+        if (!errors::IsNotFound(s)) {
+          return s;
+        }
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(
+            env->NewRandomAccessFile(dataset()->filenames_[i], &file));
+        io::RecordReader reader(file.get());
+        uint64 offset = 0;
+        while (true) {
+          const uint64 block_offset = offset;
+          int num_skipped = 0;
+          Status s =
+              reader.SkipRecords(&offset, dataset()->block_size_, &num_skipped);
+          if (num_skipped > 0) {
+            blocks_.push_back({i, block_offset, num_skipped});
+          }
+          if (errors::IsOutOfRange(s)) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(s);
+        }
+      }
+      for (int64 i = blocks_.size() - 1; i > 0; --i) {
+        std::swap(blocks_[i], blocks_[Random() % (i + 1)]);
+      }
+      VLOG(2) << "Shuffled " << blocks_.size() << " blocks of "
+              << dataset()->filenames_.size() << " files";
+      blocks_initialized_ = true;
+      return Status::OK();
+    }
+
+    // Reads the next record of the current block, moving on to the next
+    // block if the current one is exhausted.
+    Status ReadRecord(Env* env, tstring* record)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (records_left_ == 0) {
+        const Block& block = blocks_[next_block_++];
+        TF_RETURN_IF_ERROR(OpenFile(env, block.file_index));
+        offset_ = block.offset;
+        records_left_ = block.num_records;
+      }
+      TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&offset_, record));
+      --records_left_;
+      return Status::OK();
+    }
+
+    Status OpenFile(Env* env, int64 file_index)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (file_index == current_file_index_) {
+        return Status::OK();
+      }
+      record_reader_.reset();
+      TF_RETURN_IF_ERROR(
+          env->NewRandomAccessFile(dataset()->filenames_[file_index], &file_));
+      record_reader_ = absl::make_unique<io::RecordReader>(file_.get());
+      current_file_index_ = file_index;
+      return Status::OK();
+    }
+
+    void ResetGenerator() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+      generator_ =
+          random::SingleSampleAdapter<random::PhiloxRandom>(&parent_generator_);
+      num_random_samples_ = 0;
+    }
+
+    random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_random_samples_++;
+      return generator_();
+    }
+
+    mutex mu_;
+    int64 seed_ TF_GUARDED_BY(mu_);
+    int64 seed2_ TF_GUARDED_BY(mu_);
+    random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
+    random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        TF_GUARDED_BY(mu_);
+    int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
+
+    // The blocks of all files, in the order in which they are read.
+    std::vector<Block> blocks_ TF_GUARDED_BY(mu_);
+    bool blocks_initialized_ TF_GUARDED_BY(mu_) = false;
+    // The index in `blocks_` of the block to read after the current one.
+    int64 next_block_ TF_GUARDED_BY(mu_) = 0;
+    // The offset of the next record of the current block, and the number of
+    // records left in it.
+    uint64 offset_ TF_GUARDED_BY(mu_) = 0;
+    int64 records_left_ TF_GUARDED_BY(mu_) = 0;
+    int64 current_file_index_ TF_GUARDED_BY(mu_) = -1;
+    std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::RecordReader> record_reader_ TF_GUARDED_BY(mu_);
+    // The records from which the next output is drawn.
+    std::vector<tstring> window_ TF_GUARDED_BY(mu_);
+  };
+
+  const std::vector<string> filenames_;
+  const int64 block_size_;
+  const int64 window_size_;
+  const RandomSeeds seeds_;
+  const bool reshuffle_each_iteration_;
+  // The number of iterators created so far, which selects the order of the
+  // next iterator when reshuffling.
+  mutable std::atomic<int64> num_iterators_{0};
+};
+
+BlockShuffledTFRecordDatasetOp::BlockShuffledTFRecordDatasetOp(
+    OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReshuffleEachIteration,
+                                   &reshuffle_each_iteration_));
+}
+
+void BlockShuffledTFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                                 DatasetBase** output) {
+  const Tensor* filenames_tensor;
+  OP_REQUIRES_OK(ctx, ctx->input(kFileNames, &filenames_tensor));
+  OP_REQUIRES(
+      ctx, filenames_tensor->dims() <= 1,
+      errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+  std::vector<string> filenames;
+  filenames.reserve(filenames_tensor->NumElements());
+  for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+    filenames.push_back(filenames_tensor->flat<tstring>()(i));
+  }
+
+  int64 block_size;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kBlockSize, &block_size));
+  OP_REQUIRES(ctx, block_size > 0 && block_size <= kint32max,
+              errors::InvalidArgument(
+                  "`block_size` must be in the range [1, ", kint32max,
+                  "], but got ", block_size));
+
+  int64 window_size;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kWindowSize, &window_size));
+  OP_REQUIRES(
+      ctx, window_size > 0,
+      errors::InvalidArgument("`window_size` must be positive, but got ",
+                              window_size));
+
+  int64 seed;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kSeed, &seed));
+  int64 seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kSeed2, &seed2));
+
+  *output = new Dataset(ctx, std::move(filenames), block_size, window_size,
+                        RandomSeeds(seed, seed2), reshuffle_each_iteration_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(
+    Name("BlockShuffledTFRecordDataset").Device(DEVICE_CPU),
+    BlockShuffledTFRecordDatasetOp);
+}  // namespace
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
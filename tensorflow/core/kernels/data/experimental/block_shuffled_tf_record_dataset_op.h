@@ -0,0 +1,64 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BLOCK_SHUFFLED_TF_RECORD_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BLOCK_SHUFFLED_TF_RECORD_DATASET_OP_H_
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Reads the records of uncompressed TFRecord files in shuffled order, while
+// only keeping a small window of records in memory.
+//
+// The files are split into blocks of `block_size` consecutive records, and
+// the blocks of all files are read in an order which is shuffled globally.
+// The records of the blocks being read pass through a shuffle window of
+// `window_size` records, which mixes records of neighbouring blocks. Memory
+// use is bounded by `window_size` records and the offsets of the blocks,
+// instead of the `buffer_size` records a `ShuffleDataset` needs to shuffle as
+// well.
+//
+// Block offsets are read from the record index of each file (see
+// lib/io/record_index.h), or found by scanning the record headers of files
+// without an index, when the iterator produces its first element. The order is determined by `seed` and `seed2`; if
+// `reshuffle_each_iteration` is set, every iterator uses a different order.
+class BlockShuffledTFRecordDatasetOp : public DatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "BlockShuffledTFRecord";
+  static constexpr const char* const kFileNames = "filenames";
+  static constexpr const char* const kBlockSize = "block_size";
+  static constexpr const char* const kWindowSize = "window_size";
+  static constexpr const char* const kSeed = "seed";
+  static constexpr const char* const kSeed2 = "seed2";
+  static constexpr const char* const kReshuffleEachIteration =
+      "reshuffle_each_iteration";
+
+  explicit BlockShuffledTFRecordDatasetOp(OpKernelConstruction* ctx);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override;
+
+ private:
+  class Dataset;
+  bool reshuffle_each_iteration_ = true;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BLOCK_SHUFFLED_TF_RECORD_DATASET_OP_H_
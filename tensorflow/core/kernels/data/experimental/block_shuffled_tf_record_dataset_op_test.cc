@@ -0,0 +1,309 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/block_shuffled_tf_record_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "block_shuffled_tf_record_dataset";
+
+class BlockShuffledTFRecordDatasetParams : public DatasetParams {
+ public:
+  BlockShuffledTFRecordDatasetParams(std::vector<tstring> filenames,
+                                     int64 block_size, int64 window_size,
+                                     int64 seed, int64 seed2,
+                                     bool reshuffle_each_iteration,
+                                     string node_name)
+      : DatasetParams({DT_STRING}, {PartialTensorShape({})},
+                      std::move(node_name)),
+        filenames_(std::move(filenames)),
+        block_size_(block_size),
+        window_size_(window_size),
+        seed_(seed),
+        seed2_(seed2),
+        reshuffle_each_iteration_(reshuffle_each_iteration) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    int num_files = filenames_.size();
+    return {CreateTensor<tstring>(TensorShape({num_files}), filenames_),
+            CreateTensor<int64>(TensorShape({}), {block_size_}),
+            CreateTensor<int64>(TensorShape({}), {window_size_}),
+            CreateTensor<int64>(TensorShape({}), {seed_}),
+            CreateTensor<int64>(TensorShape({}), {seed2_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {BlockShuffledTFRecordDatasetOp::kFileNames,
+                    BlockShuffledTFRecordDatasetOp::kBlockSize,
+                    BlockShuffledTFRecordDatasetOp::kWindowSize,
+                    BlockShuffledTFRecordDatasetOp::kSeed,
+                    BlockShuffledTFRecordDatasetOp::kSeed2};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{BlockShuffledTFRecordDatasetOp::kReshuffleEachIteration,
+                     reshuffle_each_iteration_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return BlockShuffledTFRecordDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<tstring> filenames_;
+  int64 block_size_;
+  int64 window_size_;
+  int64 seed_;
+  int64 seed2_;
+  bool reshuffle_each_iteration_;
+};
+
+class BlockShuffledTFRecordDatasetOpTest : public DatasetOpsTestBase {};
+
+Status CreateTestFiles(const std::vector<tstring>& filenames,
+                       const std::vector<std::vector<string>>& contents) {
+  if (filenames.size() != contents.size()) {
+    return errors::InvalidArgument(
+        "The number of files does not match with the contents");
+  }
+  for (int i = 0; i < filenames.size(); ++i) {
+    CompressionParams params;
+    params.output_buffer_size = 10;
+    params.compression_type = CompressionType::UNCOMPRESSED;
+    std::vector<absl::string_view> records(contents[i].begin(),
+                                           contents[i].end());
+    TF_RETURN_IF_ERROR(WriteDataToTFRecordFile(filenames[i], records, params));
+  }
+  return Status::OK();
+}
+
+std::vector<tstring> TestFiles() {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/block_shuffled_tf_record_1"),
+      absl::StrCat(testing::TmpDir(), "/block_shuffled_tf_record_2")};
+  std::vector<std::vector<string>> contents = {{"1", "22", "333", "4444"},
+                                               {"a", "bb", "ccc"}};
+  if (!CreateTestFiles(filenames, contents).ok()) {
+    VLOG(WARNING) << "Failed to create the test files: "
+                  << absl::StrJoin(filenames, ", ");
+  }
+  return filenames;
+}
+
+// Test case 1: a single block and a window of one record, which leaves the
+// records in file order.
+BlockShuffledTFRecordDatasetParams BlockShuffledTFRecordDatasetParams1() {
+  std::vector<tstring> filenames = TestFiles();
+  return BlockShuffledTFRecordDatasetParams({filenames[0]},
+                                            /*block_size=*/10,
+                                            /*window_size=*/1,
+                                            /*seed=*/1,
+                                            /*seed2=*/2,
+                                            /*reshuffle_each_iteration=*/true,
+                                            /*node_name=*/kNodeName);
+}
+
+// Test case 2: blocks smaller than the files.
+BlockShuffledTFRecordDatasetParams BlockShuffledTFRecordDatasetParams2() {
+  return BlockShuffledTFRecordDatasetParams(TestFiles(),
+                                            /*block_size=*/2,
+                                            /*window_size=*/1,
+                                            /*seed=*/1,
+                                            /*seed2=*/2,
+                                            /*reshuffle_each_iteration=*/true,
+                                            /*node_name=*/kNodeName);
+}
+
+// Test case 3: blocks and a window smaller than the files.
+BlockShuffledTFRecordDatasetParams BlockShuffledTFRecordDatasetParams3() {
+  return BlockShuffledTFRecordDatasetParams(TestFiles(),
+                                            /*block_size=*/2,
+                                            /*window_size=*/3,
+                                            /*seed=*/3,
+                                            /*seed2=*/4,
+                                            /*reshuffle_each_iteration=*/false,
+                                            /*node_name=*/kNodeName);
+}
+
+BlockShuffledTFRecordDatasetParams InvalidBlockSizeParams() {
+  return BlockShuffledTFRecordDatasetParams(TestFiles(),
+                                            /*block_size=*/0,
+                                            /*window_size=*/3,
+                                            /*seed=*/1,
+                                            /*seed2=*/2,
+                                            /*reshuffle_each_iteration=*/true,
+                                            /*node_name=*/kNodeName);
+}
+
+BlockShuffledTFRecordDatasetParams InvalidWindowSizeParams() {
+  return BlockShuffledTFRecordDatasetParams(TestFiles(),
+                                            /*block_size=*/2,
+                                            /*window_size=*/0,
+                                            /*seed=*/1,
+                                            /*seed2=*/2,
+                                            /*reshuffle_each_iteration=*/true,
+                                            /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> AllRecords() {
+  return CreateTensors<tstring>(
+      TensorShape({}),
+      {{"1"}, {"22"}, {"333"}, {"4444"}, {"a"}, {"bb"}, {"ccc"}});
+}
+
+std::vector<GetNextTestCase<BlockShuffledTFRecordDatasetParams>>
+GetNextTestCases() {
+  return {{/*dataset_params=*/BlockShuffledTFRecordDatasetParams1(),
+           /*expected_outputs=*/
+           CreateTensors<tstring>(TensorShape({}),
+                                  {{"1"}, {"22"}, {"333"}, {"4444"}})},
+          {/*dataset_params=*/BlockShuffledTFRecordDatasetParams2(),
+           /*expected_outputs=*/AllRecords(),
+           /*compare_order=*/false},
+          {/*dataset_params=*/BlockShuffledTFRecordDatasetParams3(),
+           /*expected_outputs=*/AllRecords(),
+           /*compare_order=*/false}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(BlockShuffledTFRecordDatasetOpTest,
+                         BlockShuffledTFRecordDatasetParams,
+                         GetNextTestCases())
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, KeepsBlocksContiguous) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams2();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &outputs, &end_of_sequence));
+  }
+  ASSERT_EQ(outputs.size(), 7);
+  // With a window of one record, the records of a block are produced in
+  // file order right after each other, e.g. "333" is always followed by
+  // "4444".
+  for (int i = 0; i + 1 < outputs.size(); ++i) {
+    const tstring& record = outputs[i].scalar<tstring>()();
+    const tstring& next = outputs[i + 1].scalar<tstring>()();
+    if (record == "1") EXPECT_EQ(next, "22");
+    if (record == "333") EXPECT_EQ(next, "4444");
+    if (record == "a") EXPECT_EQ(next, "bb");
+  }
+  EXPECT_NE(outputs.back().scalar<tstring>()(), "1");
+  EXPECT_NE(outputs.back().scalar<tstring>()(), "333");
+  EXPECT_NE(outputs.back().scalar<tstring>()(), "a");
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, ReadsBlocksFromRecordIndex) {
+  const tstring filename =
+      absl::StrCat(testing::TmpDir(), "/block_shuffled_tf_record_indexed");
+  TF_ASSERT_OK(CreateTestFiles({filename}, {{"1", "22", "333", "4444"}}));
+  // An index that only lists the first and the last record, which is only
+  // honored if the blocks come from the index.
+  std::unique_ptr<WritableFile> index_file;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(
+      io::RecordIndexFilename(filename), &index_file));
+  io::RecordIndexWriter index_writer(index_file.get());
+  const uint64 record_overhead =
+      io::RecordReader::kHeaderSize + io::RecordReader::kFooterSize;
+  TF_ASSERT_OK(index_writer.AddRecord(0));
+  TF_ASSERT_OK(index_writer.AddRecord(3 * record_overhead + 6));
+  TF_ASSERT_OK(index_writer.Finish());
+  TF_ASSERT_OK(index_file->Close());
+
+  auto dataset_params = BlockShuffledTFRecordDatasetParams(
+      {filename}, /*block_size=*/1, /*window_size=*/1, /*seed=*/1,
+      /*seed2=*/2, /*reshuffle_each_iteration=*/true, /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_EXPECT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}), {{"1"}, {"4444"}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(BlockShuffledTFRecordDatasetOp::kDatasetType)));
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_STRING}));
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({})}));
+}
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = BlockShuffledTFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(
+      name_utils::IteratorPrefix(BlockShuffledTFRecordDatasetOp::kDatasetType,
+                                 dataset_params.iterator_prefix())));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<BlockShuffledTFRecordDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/BlockShuffledTFRecordDatasetParams1(),
+           /*breakpoints=*/{0, 2, 5},
+           /*expected_outputs=*/
+           CreateTensors<tstring>(TensorShape({}),
+                                  {{"1"}, {"22"}, {"333"}, {"4444"}})},
+          {/*dataset_params=*/BlockShuffledTFRecordDatasetParams2(),
+           /*breakpoints=*/{0, 3, 8},
+           /*expected_outputs=*/AllRecords(),
+           /*compare_order=*/false},
+          {/*dataset_params=*/BlockShuffledTFRecordDatasetParams3(),
+           /*breakpoints=*/{0, 3, 8},
+           /*expected_outputs=*/AllRecords(),
+           /*compare_order=*/false}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(BlockShuffledTFRecordDatasetOpTest,
+                                 BlockShuffledTFRecordDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(BlockShuffledTFRecordDatasetOpTest, InvalidArguments) {
+  std::vector<BlockShuffledTFRecordDatasetParams> invalid_dataset_params = {
+      InvalidBlockSizeParams(), InvalidWindowSizeParams()};
+  for (const auto& dataset_params : invalid_dataset_params) {
+    EXPECT_EQ(Initialize(dataset_params).code(),
+              tensorflow::error::INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,529 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_token_budget_dataset_op.h"
+
+#include <deque>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kBucketBoundaries;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kMaxTokens;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kParallelCopy;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kExhausted[] = "exhausted";
+constexpr char kBucket[] = "bucket";
+constexpr char kReady[] = "ready";
+constexpr char kSize[] = "size";
+constexpr char kMaxLength[] = "max_length";
+
+using Batch = std::vector<std::vector<Tensor>>;
+
+}  // namespace
+
+class BucketByTokenBudgetDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::vector<int64> bucket_boundaries, int64 max_tokens,
+          std::vector<Tensor> padding_values, bool drop_remainder,
+          bool parallel_copy)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        max_tokens_(max_tokens),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        parallel_copy_(parallel_copy),
+        traceme_metadata_(
+            {{"max_tokens",
+              strings::Printf("%lld", static_cast<long long>(max_tokens))},
+             {"drop_remainder", drop_remainder ? "true" : "false"},
+             {"parallel_copy", parallel_copy ? "true" : "false"}}) {
+    input_->Ref();
+    const DataTypeVector& input_dtypes = input_->output_dtypes();
+    output_dtypes_.assign(input_dtypes.begin() + 1, input_dtypes.end());
+    const std::vector<PartialTensorShape>& input_shapes =
+        input_->output_shapes();
+    // Dimensions that are statically known need no padding, so only the
+    // batch dimension is added.
+    for (size_t i = 1; i < input_shapes.size(); ++i) {
+      output_shapes_.push_back(
+          PartialTensorShape({-1}).Concatenate(input_shapes[i]));
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_dtypes_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(max_tokens_);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64 Cardinality() const override {
+    int64 n = input_->Cardinality();
+    if (n == kInfiniteCardinality) return n;
+    return kUnknownCardinality;
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* bucket_boundaries = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+    Node* max_tokens = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(max_tokens_, &max_tokens));
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+
+    AttrValue parallel_copy;
+    b->BuildAttrValue(parallel_copy_, &parallel_copy);
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {1, bucket_boundaries},
+         {2, max_tokens},
+         {4, drop_remainder}},
+        {{3, padding_values}},
+        {{kParallelCopy, parallel_copy}, {kToutputTypes, output_types}},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          buckets_(params.dataset->bucket_boundaries_.size() + 1) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      Batch batch;
+      {
+        mutex_lock l(mu_);
+        while (ready_.empty() && input_impl_) {
+          std::vector<Tensor> element;
+          bool end_of_input = false;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input));
+          if (end_of_input) {
+            input_impl_.reset();
+            if (!dataset()->drop_remainder_) {
+              for (Bucket& bucket : buckets_) FlushBucket(&bucket);
+            }
+            break;
+          }
+          TF_RETURN_IF_ERROR(AddElement(std::move(element)));
+        }
+        if (ready_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        batch = std::move(ready_.front());
+        ready_.pop_front();
+      }
+      // Padding and copying happen outside of the lock, so that concurrent
+      // calls only serialize on reading the input.
+      *end_of_sequence = false;
+      return CopyBatch(ctx, batch, out_tensors);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kExhausted), ""));
+      }
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        const string prefix = strings::StrCat(kBucket, "_", i);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(prefix, "_", kMaxLength)),
+            buckets_[i].max_length));
+        TF_RETURN_IF_ERROR(WriteBatch(prefix, buckets_[i].elements, writer));
+      }
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(strings::StrCat(kReady, "_", kSize)), ready_.size()));
+      for (size_t i = 0; i < ready_.size(); ++i) {
+        TF_RETURN_IF_ERROR(
+            WriteBatch(strings::StrCat(kReady, "_", i), ready_[i], writer));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kExhausted))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        const string prefix = strings::StrCat(kBucket, "_", i);
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(prefix, "_", kMaxLength)),
+            &buckets_[i].max_length));
+        TF_RETURN_IF_ERROR(ReadBatch(prefix, reader, &buckets_[i].elements));
+      }
+      int64 num_ready;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(
+          full_name(strings::StrCat(kReady, "_", kSize)), &num_ready));
+      ready_.clear();
+      for (int64 i = 0; i < num_ready; ++i) {
+        Batch batch;
+        TF_RETURN_IF_ERROR(
+            ReadBatch(strings::StrCat(kReady, "_", i), reader, &batch));
+        ready_.push_back(std::move(batch));
+      }
+      return Status::OK();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return dataset()->traceme_metadata_;
+    }
+
+   private:
+    struct Bucket {
+      // The length of the longest element in `elements`.
+      int64 max_length = 0;
+      Batch elements;
+    };
+
+    // Adds `element`, whose first component is its length, to its bucket and
+    // moves the buckets that are full to `ready_`.
+    Status AddElement(std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (element.empty() || !TensorShapeUtils::IsScalar(element[0].shape()) ||
+          element[0].dtype() != DT_INT64) {
+        return errors::InvalidArgument(
+            "The first component of each element must be a scalar int64 "
+            "length.");
+      }
+      const int64 length = element[0].scalar<int64>()();
+      if (length < 0) {
+        return errors::InvalidArgument(
+            "Element length must be non-negative, got: ", length);
+      }
+      const std::vector<int64>& boundaries = dataset()->bucket_boundaries_;
+      Bucket& bucket =
+          buckets_[std::upper_bound(boundaries.begin(), boundaries.end(),
+                                    length) -
+                   boundaries.begin()];
+      const int64 max_tokens = dataset()->max_tokens_;
+      // A longer element may push the padded batch over the budget.
+      const int64 max_length = std::max(bucket.max_length, length);
+      if (!bucket.elements.empty() &&
+          static_cast<int64>(bucket.elements.size() + 1) * max_length >
+              max_tokens) {
+        FlushBucket(&bucket);
+      }
+      element.erase(element.begin());
+      bucket.elements.push_back(std::move(element));
+      bucket.max_length = std::max(bucket.max_length, length);
+      // No further element fits if one of the current maximum length does
+      // not, so the batch can be emitted right away.
+      if (static_cast<int64>(bucket.elements.size() + 1) * bucket.max_length >
+          max_tokens) {
+        FlushBucket(&bucket);
+      }
+      return Status::OK();
+    }
+
+    void FlushBucket(Bucket* bucket) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (bucket->elements.empty()) return;
+      ready_.push_back(std::move(bucket->elements));
+      bucket->elements.clear();
+      bucket->max_length = 0;
+    }
+
+    // Pads every component of `batch` to its largest size within the batch
+    // and stacks it into one tensor of `out_tensors`.
+    Status CopyBatch(IteratorContext* ctx, const Batch& batch,
+                     std::vector<Tensor>* out_tensors) {
+      const int64 num_batch_elements = batch.size();
+      const size_t num_components = dataset()->output_dtypes().size();
+      for (size_t component_index = 0; component_index < num_components;
+           ++component_index) {
+        const int rank = batch[0][component_index].dims();
+        TensorShape batch_component_shape({num_batch_elements});
+        for (int dim = 0; dim < rank; ++dim) batch_component_shape.AddDim(0);
+        for (int64 i = 0; i < num_batch_elements; ++i) {
+          const TensorShape& element_shape = batch[i][component_index].shape();
+          if (element_shape.dims() != rank) {
+            return errors::InvalidArgument(
+                "All elements in a batch must have the same rank for "
+                "component ",
+                component_index, ": expected rank ", rank,
+                " but got element with rank ", element_shape.dims());
+          }
+          for (int dim = 0; dim < rank; ++dim) {
+            if (element_shape.dim_size(dim) >
+                batch_component_shape.dim_size(dim + 1)) {
+              batch_component_shape.set_dim(dim + 1,
+                                            element_shape.dim_size(dim));
+            }
+          }
+        }
+
+        out_tensors->emplace_back(ctx->allocator({}),
+                                  dataset()->output_dtypes()[component_index],
+                                  batch_component_shape);
+        Tensor& batch_component = out_tensors->back();
+        TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+            &batch_component, dataset()->padding_values_[component_index]));
+
+        TensorShape component_shape = batch_component_shape;
+        component_shape.RemoveDim(0);
+        auto copy_element_fn = [component_index, &batch, &batch_component,
+                                &component_shape](int64 index) {
+          // Take the fast path if possible.
+          if (batch[index][component_index].shape() == component_shape) {
+            return batch_util::CopyElementToSlice(
+                batch[index][component_index], &batch_component, index);
+          }
+          return batch_util::CopyElementToLargerSlice(
+              batch[index][component_index], &batch_component, index);
+        };
+        BlockingCounter counter(num_batch_elements);
+        Status status;
+        mutex status_mu;
+        for (int64 i = 0; i < num_batch_elements; ++i) {
+          if (TF_PREDICT_FALSE(dataset()->parallel_copy_)) {
+            (*ctx->runner())(
+                [i, &status, &status_mu, &counter, &copy_element_fn]() {
+                  Status s = copy_element_fn(i);
+                  {
+                    mutex_lock l(status_mu);
+                    status.Update(s);
+                  }
+                  counter.DecrementCount();
+                });
+          } else {
+            status.Update(copy_element_fn(i));
+            counter.DecrementCount();
+          }
+        }
+        counter.Wait();
+        TF_RETURN_IF_ERROR(status);
+      }
+      return Status::OK();
+    }
+
+    Status WriteBatch(const string& prefix, const Batch& batch,
+                      IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(strings::StrCat(prefix, "_", kSize)), batch.size()));
+      for (size_t i = 0; i < batch.size(); ++i) {
+        for (size_t j = 0; j < batch[i].size(); ++j) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              full_name(strings::StrCat(prefix, "_", i, "_", j)),
+              batch[i][j]));
+        }
+      }
+      return Status::OK();
+    }
+
+    Status ReadBatch(const string& prefix, IteratorStateReader* reader,
+                     Batch* batch) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 size;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(
+          full_name(strings::StrCat(prefix, "_", kSize)), &size));
+      const size_t num_components = dataset()->output_dtypes().size();
+      batch->clear();
+      batch->resize(size);
+      for (int64 i = 0; i < size; ++i) {
+        (*batch)[i].resize(num_components);
+        for (size_t j = 0; j < num_components; ++j) {
+          TF_RETURN_IF_ERROR(reader->ReadTensor(
+              full_name(strings::StrCat(prefix, "_", i, "_", j)),
+              &(*batch)[i][j]));
+        }
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+    // Batches that are complete but have not been returned yet.
+    std::deque<Batch> ready_ TF_GUARDED_BY(mu_);
+  };
+
+  const DatasetBase* const input_;
+  const std::vector<int64> bucket_boundaries_;
+  const int64 max_tokens_;
+  const std::vector<Tensor> padding_values_;
+  const bool drop_remainder_;
+  const bool parallel_copy_;
+  DataTypeVector output_dtypes_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const TraceMeMetadata traceme_metadata_;
+};
+
+BucketByTokenBudgetDatasetOp::BucketByTokenBudgetDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kParallelCopy, &parallel_copy_));
+}
+
+void BucketByTokenBudgetDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                               DatasetBase* input,
+                                               DatasetBase** output) {
+  OP_REQUIRES(
+      ctx,
+      input->output_dtypes().size() >= 2 &&
+          input->output_dtypes()[0] == DT_INT64,
+      errors::InvalidArgument("The input dataset must produce an int64 length "
+                              "followed by at least one component."));
+
+  const Tensor* bucket_boundaries_t;
+  OP_REQUIRES_OK(ctx, ctx->input(kBucketBoundaries, &bucket_boundaries_t));
+  OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bucket_boundaries_t->shape()),
+              errors::InvalidArgument("`bucket_boundaries` must be a vector."));
+  std::vector<int64> bucket_boundaries;
+  bucket_boundaries.reserve(bucket_boundaries_t->NumElements());
+  for (int64 i = 0; i < bucket_boundaries_t->NumElements(); ++i) {
+    const int64 boundary = bucket_boundaries_t->vec<int64>()(i);
+    OP_REQUIRES(
+        ctx, bucket_boundaries.empty() || boundary > bucket_boundaries.back(),
+        errors::InvalidArgument(
+            "`bucket_boundaries` must be strictly increasing."));
+    bucket_boundaries.push_back(boundary);
+  }
+
+  int64 max_tokens = 0;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kMaxTokens, &max_tokens));
+  OP_REQUIRES(ctx, max_tokens > 0,
+              errors::InvalidArgument("`max_tokens` must be greater than 0."));
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  const size_t num_components = input->output_dtypes().size() - 1;
+  OP_REQUIRES(ctx, padding_values_list.size() == num_components,
+              errors::InvalidArgument(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of batched components (",
+                  num_components, ")"));
+  std::vector<Tensor> padding_values;
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i + 1],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and batched component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i + 1])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  bool drop_remainder = false;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
+
+  *output = new Dataset(ctx, input, std::move(bucket_boundaries), max_tokens,
+                        std::move(padding_values), drop_remainder,
+                        parallel_copy_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("BucketByTokenBudgetDataset").Device(DEVICE_CPU),
+                        BucketByTokenBudgetDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
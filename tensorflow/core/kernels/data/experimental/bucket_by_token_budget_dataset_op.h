@@ -0,0 +1,67 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Batches the elements of its input by length, so that each batch holds at
+// most `max_tokens` tokens after padding.
+//
+// The first component of every input element is a scalar int64 length; the
+// remaining components form the output element. An element of length `l`
+// goes into the bucket `i` with `bucket_boundaries[i-1] <= l <
+// bucket_boundaries[i]`. A bucket is emitted as a batch as soon as it holds
+// as many elements as fit into the budget when padded to the length of its
+// longest element, so that batches of short sequences hold more elements
+// than batches of long ones. An element that does not fit into the budget on
+// its own forms a batch by itself.
+//
+// Each component of a batch is padded with the matching `padding_values` to
+// the largest size of that component within the batch, i.e. never beyond the
+// width of its bucket. When `parallel_copy` is set, the elements are copied
+// into the batch in parallel on the iterator's thread pool.
+class BucketByTokenBudgetDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "BucketByTokenBudget";
+  static constexpr const char* const kInputDataset = "input_dataset";
+  static constexpr const char* const kBucketBoundaries = "bucket_boundaries";
+  static constexpr const char* const kMaxTokens = "max_tokens";
+  static constexpr const char* const kPaddingValues = "padding_values";
+  static constexpr const char* const kDropRemainder = "drop_remainder";
+  static constexpr const char* const kParallelCopy = "parallel_copy";
+  static constexpr const char* const kToutputTypes = "Toutput_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+
+  explicit BucketByTokenBudgetDatasetOp(OpKernelConstruction* ctx);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+  bool parallel_copy_ = false;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
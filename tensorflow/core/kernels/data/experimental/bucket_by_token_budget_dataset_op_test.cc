@@ -0,0 +1,276 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_token_budget_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "bucket_by_token_budget_dataset";
+
+class BucketByTokenBudgetDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  BucketByTokenBudgetDatasetParams(
+      T input_dataset_params, std::vector<int64> bucket_boundaries,
+      int64 max_tokens, std::vector<Tensor> padding_values,
+      bool drop_remainder, bool parallel_copy, DataTypeVector output_dtypes,
+      std::vector<PartialTensorShape> output_shapes, string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        max_tokens_(max_tokens),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        parallel_copy_(parallel_copy) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    std::vector<Tensor> input_tensors = {
+        CreateTensor<int64>(
+            TensorShape({static_cast<int64>(bucket_boundaries_.size())}),
+            bucket_boundaries_),
+        CreateTensor<int64>(TensorShape({}), {max_tokens_})};
+    for (const Tensor& padding_value : padding_values_) {
+      input_tensors.push_back(padding_value);
+    }
+    input_tensors.push_back(
+        CreateTensor<bool>(TensorShape({}), {drop_remainder_}));
+    return input_tensors;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {BucketByTokenBudgetDatasetOp::kInputDataset,
+                    BucketByTokenBudgetDatasetOp::kBucketBoundaries,
+                    BucketByTokenBudgetDatasetOp::kMaxTokens};
+    for (int i = 0; i < padding_values_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketByTokenBudgetDatasetOp::kPaddingValues, "_", i));
+    }
+    input_names->push_back(BucketByTokenBudgetDatasetOp::kDropRemainder);
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {BucketByTokenBudgetDatasetOp::kParallelCopy, parallel_copy_},
+        {BucketByTokenBudgetDatasetOp::kToutputTypes, output_dtypes_},
+        {BucketByTokenBudgetDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return BucketByTokenBudgetDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<int64> bucket_boundaries_;
+  int64 max_tokens_;
+  std::vector<Tensor> padding_values_;
+  bool drop_remainder_;
+  bool parallel_copy_;
+};
+
+class BucketByTokenBudgetDatasetOpTest : public DatasetOpsTestBase {};
+
+// Produces (length, sequence) elements: three sequences [0, 1], [2, 3],
+// [4, 5] of length 2 followed by four sequences [6], [7], [8], [9] of
+// length 1.
+ConcatenateDatasetParams SequenceDatasetParams() {
+  return ConcatenateDatasetParams(
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<int64>(TensorShape{3}, {2, 2, 2}),
+                          CreateTensor<int64>(TensorShape{3, 2},
+                                              {0, 1, 2, 3, 4, 5})},
+          /*node_name=*/"tensor_slice_0"),
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<int64>(TensorShape{4}, {1, 1, 1, 1}),
+                          CreateTensor<int64>(TensorShape{4, 1},
+                                              {6, 7, 8, 9})},
+          /*node_name=*/"tensor_slice_1"),
+      /*output_dtypes=*/{DT_INT64, DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({}), PartialTensorShape({-1})},
+      /*node_name=*/"concatenate");
+}
+
+BucketByTokenBudgetDatasetParams MakeParams(
+    std::vector<int64> bucket_boundaries, int64 max_tokens,
+    bool drop_remainder, bool parallel_copy) {
+  return BucketByTokenBudgetDatasetParams(
+      SequenceDatasetParams(), std::move(bucket_boundaries), max_tokens,
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {-1})},
+      drop_remainder, parallel_copy,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1, -1})}, kNodeName);
+}
+
+// Lengths 1 and 2 go into separate buckets; batches of length 2 hold two
+// sequences and batches of length 1 hold four.
+BucketByTokenBudgetDatasetParams TwoBucketsParams() {
+  return MakeParams(/*bucket_boundaries=*/{2}, /*max_tokens=*/4,
+                    /*drop_remainder=*/false, /*parallel_copy=*/false);
+}
+
+BucketByTokenBudgetDatasetParams TwoBucketsParallelCopyParams() {
+  return MakeParams(/*bucket_boundaries=*/{2}, /*max_tokens=*/4,
+                    /*drop_remainder=*/false, /*parallel_copy=*/true);
+}
+
+BucketByTokenBudgetDatasetParams TwoBucketsDropRemainderParams() {
+  return MakeParams(/*bucket_boundaries=*/{2}, /*max_tokens=*/4,
+                    /*drop_remainder=*/true, /*parallel_copy=*/false);
+}
+
+// All lengths share one bucket, so the first batch mixes lengths and pads.
+BucketByTokenBudgetDatasetParams OneBucketParams() {
+  return MakeParams(/*bucket_boundaries=*/{}, /*max_tokens=*/8,
+                    /*drop_remainder=*/false, /*parallel_copy=*/true);
+}
+
+// Every sequence exceeds the budget on its own and forms its own batch.
+BucketByTokenBudgetDatasetParams TinyBudgetParams() {
+  return MakeParams(/*bucket_boundaries=*/{2}, /*max_tokens=*/1,
+                    /*drop_remainder=*/false, /*parallel_copy=*/false);
+}
+
+BucketByTokenBudgetDatasetParams InvalidMaxTokensParams() {
+  return MakeParams(/*bucket_boundaries=*/{2}, /*max_tokens=*/0,
+                    /*drop_remainder=*/false, /*parallel_copy=*/false);
+}
+
+BucketByTokenBudgetDatasetParams InvalidBucketBoundariesParams() {
+  return MakeParams(/*bucket_boundaries=*/{4, 2}, /*max_tokens=*/4,
+                    /*drop_remainder=*/false, /*parallel_copy=*/false);
+}
+
+BucketByTokenBudgetDatasetParams InvalidPaddingValueDTypeParams() {
+  return BucketByTokenBudgetDatasetParams(
+      SequenceDatasetParams(), /*bucket_boundaries=*/{2}, /*max_tokens=*/4,
+      /*padding_values=*/{CreateTensor<float>(TensorShape{}, {-1.0})},
+      /*drop_remainder=*/false, /*parallel_copy=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1, -1})}, kNodeName);
+}
+
+std::vector<Tensor> TwoBucketsOutputs() {
+  return {CreateTensor<int64>(TensorShape{2, 2}, {0, 1, 2, 3}),
+          CreateTensor<int64>(TensorShape{4, 1}, {6, 7, 8, 9}),
+          CreateTensor<int64>(TensorShape{1, 2}, {4, 5})};
+}
+
+std::vector<GetNextTestCase<BucketByTokenBudgetDatasetParams>>
+GetNextTestCases() {
+  return {
+      {/*dataset_params=*/TwoBucketsParams(),
+       /*expected_outputs=*/TwoBucketsOutputs()},
+      {/*dataset_params=*/TwoBucketsParallelCopyParams(),
+       /*expected_outputs=*/TwoBucketsOutputs()},
+      {/*dataset_params=*/TwoBucketsDropRemainderParams(),
+       /*expected_outputs=*/
+       {CreateTensor<int64>(TensorShape{2, 2}, {0, 1, 2, 3}),
+        CreateTensor<int64>(TensorShape{4, 1}, {6, 7, 8, 9})}},
+      {/*dataset_params=*/OneBucketParams(),
+       /*expected_outputs=*/
+       {CreateTensor<int64>(TensorShape{4, 2}, {0, 1, 2, 3, 4, 5, 6, -1}),
+        CreateTensor<int64>(TensorShape{3, 1}, {7, 8, 9})}},
+      {/*dataset_params=*/TinyBudgetParams(),
+       /*expected_outputs=*/
+       {CreateTensor<int64>(TensorShape{1, 2}, {0, 1}),
+        CreateTensor<int64>(TensorShape{1, 2}, {2, 3}),
+        CreateTensor<int64>(TensorShape{1, 2}, {4, 5}),
+        CreateTensor<int64>(TensorShape{1, 1}, {6}),
+        CreateTensor<int64>(TensorShape{1, 1}, {7}),
+        CreateTensor<int64>(TensorShape{1, 1}, {8}),
+        CreateTensor<int64>(TensorShape{1, 1}, {9})}}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(BucketByTokenBudgetDatasetOpTest,
+                         BucketByTokenBudgetDatasetParams, GetNextTestCases())
+
+TEST_F(BucketByTokenBudgetDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = TwoBucketsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(BucketByTokenBudgetDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = TwoBucketsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(BucketByTokenBudgetDatasetOp::kDatasetType)));
+}
+
+TEST_F(BucketByTokenBudgetDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = TwoBucketsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64}));
+}
+
+TEST_F(BucketByTokenBudgetDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = TwoBucketsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({-1, -1})}));
+}
+
+TEST_F(BucketByTokenBudgetDatasetOpTest, Cardinality) {
+  auto dataset_params = TwoBucketsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<BucketByTokenBudgetDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/TwoBucketsParams(),
+           /*breakpoints=*/{0, 1, 2, 5},
+           /*expected_outputs=*/TwoBucketsOutputs()},
+          {/*dataset_params=*/OneBucketParams(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{4, 2}, {0, 1, 2, 3, 4, 5, 6, -1}),
+            CreateTensor<int64>(TensorShape{3, 1}, {7, 8, 9})}}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(BucketByTokenBudgetDatasetOpTest,
+                                 BucketByTokenBudgetDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+class ParameterizedInvalidArgumentTest
+    : public BucketByTokenBudgetDatasetOpTest,
+      public ::testing::WithParamInterface<BucketByTokenBudgetDatasetParams> {
+};
+
+TEST_P(ParameterizedInvalidArgumentTest, InvalidArguments) {
+  auto dataset_params = GetParam();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BucketByTokenBudgetDatasetOpTest, ParameterizedInvalidArgumentTest,
+    ::testing::ValuesIn({InvalidMaxTokensParams(),
+                         InvalidBucketBoundariesParams(),
+                         InvalidPaddingValueDTypeParams()}));
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/experimental/data_service_dataset_op.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <queue>
@@ -64,6 +65,8 @@ constexpr const char* const kMaxOutstandingRequests =
 constexpr const char* const kTaskRefreshIntervalHintMs =
   "task_refresh_interval_hint_ms";
 constexpr const char* const kIterationCounter = "iteration_counter";
+constexpr const char* const kConsumerIndex = "consumer_index";
+constexpr const char* const kNumConsumers = "num_consumers";
 constexpr const char* const kOutputTypes = "output_types";
 constexpr const char* const kOutputShapes = "output_shapes";
 
@@ -74,12 +77,20 @@ constexpr const char* const kOutputShapes = "output_shapes";
 // This dataset interleaves dataset elements produced by multiple tf.data
 // workers. We periodically query the dispatcher to determine which workers
 // to read from (in case workers are added or removed).
+//
+// If `num_consumers` is positive, the dataset is one of `num_consumers`
+// consumers of a shared job reading in coordinated rounds: in round r, every
+// consumer reads its element of round r from the r-th task of the job (modulo
+// the number of tasks, in task id order), so that the consumers receive
+// consecutive elements of the same worker in lockstep. This assumes that the
+// set of workers does not change while the job runs.
 class DataServiceDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, int64 dataset_id,
           ProcessingMode processing_mode, const std::string& address,
           const std::string& protocol, const std::string& job_name,
           int64 max_outstanding_requests, int64 task_refresh_interval_ms,
+          int64 consumer_index, int64 num_consumers,
           IterationCounter* iteration_counter, bool owns_resource,
           ResourceHandle iteration_counter_handle,
           const DataTypeVector& output_types,
@@ -92,6 +103,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         job_name_(job_name),
         max_outstanding_requests_(max_outstanding_requests),
         task_refresh_interval_ms_(task_refresh_interval_ms),
+        consumer_index_(consumer_index),
+        num_consumers_(num_consumers),
         iteration_counter_(iteration_counter),
         owns_resource_(owns_resource),
         iteration_counter_handle_(iteration_counter_handle),
@@ -167,13 +180,19 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     AttrValue task_refresh_interval_hint_ms;
     b->BuildAttrValue(task_refresh_interval_ms_,
                       &task_refresh_interval_hint_ms);
+    AttrValue consumer_index;
+    b->BuildAttrValue(consumer_index_, &consumer_index);
+    AttrValue num_consumers;
+    b->BuildAttrValue(num_consumers_, &num_consumers);
 
     TF_RETURN_IF_ERROR(
         b->AddDataset(this,
                       {dataset_id, processing_mode, address, protocol, job_name,
                        max_outstanding_requests, iteration_counter_handle},
                       {std::make_pair(kTaskRefreshIntervalHintMs,
-                                      task_refresh_interval_hint_ms)},
+                                      task_refresh_interval_hint_ms),
+                       std::make_pair(kConsumerIndex, consumer_index),
+                       std::make_pair(kNumConsumers, num_consumers)},
                       output));
     return Status::OK();
   }
@@ -184,8 +203,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     explicit Iterator(const Params& params, int64 iterator_index)
         : DatasetIterator<Dataset>(params),
           iterator_index_(iterator_index),
-          max_outstanding_requests_(params.dataset->max_outstanding_requests_) {
-    }
+          // Rounds are read one at a time, so that their elements are
+          // produced in order.
+          max_outstanding_requests_(
+              params.dataset->num_consumers_ > 0
+                  ? 1
+                  : params.dataset->max_outstanding_requests_) {}
 
     ~Iterator() override {
       VLOG(1) << "Destroying data service dataset iterator for job id "
@@ -228,9 +251,9 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       if (dataset()->job_name_.empty()) {
         TF_RETURN_IF_ERROR(grpc_util::Retry(
             [&]() {
-              return dispatcher_->CreateJob(dataset()->dataset_id_,
-                                            dataset()->processing_mode_,
-                                            job_client_id_);
+              return dispatcher_->CreateJob(
+                  dataset()->dataset_id_, dataset()->processing_mode_,
+                  dataset()->num_consumers_, job_client_id_);
             },
             /*description=*/
             strings::StrCat("create job with dispatcher at ",
@@ -241,7 +264,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
             [&]() {
               return dispatcher_->GetOrCreateJob(
                   dataset()->dataset_id_, dataset()->processing_mode_,
-                  dataset()->job_name_, iterator_index_, job_client_id_);
+                  dataset()->job_name_, iterator_index_,
+                  dataset()->num_consumers_, job_client_id_);
             },
             /*description=*/
             strings::StrCat("get or create job with dispatcher at ",
@@ -321,6 +345,11 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       bool in_use TF_GUARDED_BY(&Iterator::mu_) = false;
       // Indicates whether the worker has returned end_of_sequence for the task.
       bool end_of_sequence TF_GUARDED_BY(&Iterator::mu_) = false;
+      // The relative rate at which the worker produces elements, as reported
+      // by the dispatcher.
+      double weight TF_GUARDED_BY(&Iterator::mu_) = 1.0;
+      // The credit of the task in the weighted round-robin over tasks.
+      double current_weight TF_GUARDED_BY(&Iterator::mu_) = 0.0;
     };
 
     // Periodically refresh the task list.
@@ -378,10 +407,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
       for (int i = 0; i < tasks_.size(); ++i) {
         std::shared_ptr<Task> task = tasks_[i];
-        if (task_id_to_task.contains(task->task_id)) {
+        auto it = task_id_to_task.find(task->task_id);
+        if (it != task_id_to_task.end()) {
+          task->weight = TaskWeight(it->second);
           // Remove already-known tasks from `task_id_to_task`, so that at the
           // end of the loop, only new tasks remain.
-          task_id_to_task.erase(task->task_id);
+          task_id_to_task.erase(it);
         } else {
           // Task has been removed.
           if (task->end_of_sequence) {
@@ -404,8 +435,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         tasks_.push_back(std::make_shared<Task>(task_info.task_id(),
                                                 task_info.worker_address(),
                                                 std::move(worker)));
+        tasks_.back()->weight = TaskWeight(task_info);
       }
-      if (dataset()->max_outstanding_requests_ == model::kAutotune) {
+      if (dataset()->max_outstanding_requests_ == model::kAutotune &&
+          dataset()->num_consumers_ == 0) {
         // Adjust max_outstanding_requests to account for newly added tasks.
         max_outstanding_requests_ = tasks_.size();
       }
@@ -436,6 +469,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       });
       VLOG(1) << "Starting worker thread";
       std::shared_ptr<Task> task_to_process;
+      int64 round_index = 0;
       while (true) {
         {
           mutex_lock l(mu_);
@@ -461,24 +495,20 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           if (cancelled_ || job_finished_) {
             return;
           }
-          // Search for a task to update.
-          int num_tasks = tasks_.size();
-          for (int i = 0; i < num_tasks; ++i) {
-            int index = (next_task_index_ + i) % num_tasks;
-            std::shared_ptr<Task>& task = tasks_[index];
-            if (!task->in_use && !task->end_of_sequence) {
-              task->in_use = true;
-              task_to_process = task;
-              next_task_index_ = (index + 1) % num_tasks;
-              break;
-            }
+          if (dataset()->num_consumers_ > 0) {
+            round_index = next_round_index_++;
+            task_to_process = TaskForRound(round_index);
+          } else {
+            task_to_process = NextTask();
           }
           DCHECK(task_to_process != nullptr);
+          task_to_process->in_use = true;
           VLOG(3) << "Processing task " << task_to_process->task_id;
         }
         int64 deadline_micros =
             Env::Default()->NowMicros() + kRetryTimeoutMicros;
-        Status s = GetElement(task_to_process.get(), deadline_micros);
+        Status s =
+            GetElement(task_to_process.get(), round_index, deadline_micros);
         if (!s.ok()) {
           mutex_lock l(mu_);
           VLOG(1) << "Failed to get element from worker "
@@ -491,12 +521,13 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
     }
 
-    // Gets an element from a task and adds the element to `results_`.
+    // Gets an element from a task and adds the element to `results_`. For
+    // coordinated reads, the element of round `round_index` is fetched.
     //
     // If the task reaches end_of_sequence or is cancelled (e.g. due to a
     // worker dying), GetElement returns Status::OK() without adding to
     // `results_`.
-    Status GetElement(Task* task, int64 deadline_micros)
+    Status GetElement(Task* task, int64 round_index, int64 deadline_micros)
         TF_LOCKS_EXCLUDED(mu_) {
       VLOG(3) << "Getting an element for task id " << task->task_id;
       tensorflow::profiler::TraceMe activity(
@@ -504,8 +535,14 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       CompressedElement compressed;
       bool end_of_sequence;
       for (int num_retries = 0;; ++num_retries) {
-        Status s = task->worker->GetElement(task->task_id, compressed,
-                                            end_of_sequence);
+        Status s =
+            dataset()->num_consumers_ > 0
+                ? task->worker->GetElement(task->task_id,
+                                           dataset()->consumer_index_,
+                                           round_index, compressed,
+                                           end_of_sequence)
+                : task->worker->GetElement(task->task_id, compressed,
+                                           end_of_sequence);
         if (s.ok()) {
           break;
         }
@@ -551,6 +588,13 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       if (end_of_sequence) {
         task->end_of_sequence = true;
         finished_tasks_++;
+        if (dataset()->num_consumers_ > 0) {
+          // All consumers reach the end of a task in the same round, so
+          // reading stops there for all of them.
+          job_finished_ = true;
+          get_next_cv_.notify_all();
+          worker_thread_cv_.notify_all();
+        }
         return Status::OK();
       }
       results_.push(std::move(element));
@@ -559,6 +603,48 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       return Status::OK();
     }
 
+    static double TaskWeight(const TaskInfo& task_info) {
+      // Dispatchers which don't report weights leave them at 0.
+      return task_info.weight() > 0.0 ? task_info.weight() : 1.0;
+    }
+
+    // Chooses the next task to read from among the available tasks, by
+    // smooth weighted round-robin: tasks on faster workers are chosen more
+    // often, but slower ones are still interleaved evenly. With equal weights,
+    // this is plain round-robin.
+    std::shared_ptr<Task> NextTask() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::shared_ptr<Task> next_task;
+      double total_weight = 0.0;
+      for (const std::shared_ptr<Task>& task : tasks_) {
+        if (task->in_use || task->end_of_sequence) {
+          continue;
+        }
+        task->current_weight += task->weight;
+        total_weight += task->weight;
+        if (!next_task || task->current_weight > next_task->current_weight) {
+          next_task = task;
+        }
+      }
+      if (next_task) {
+        next_task->current_weight -= total_weight;
+      }
+      return next_task;
+    }
+
+    // Returns the task to read round `round_index` from, for coordinated
+    // reads. All consumers see the same tasks, so they agree on the task of
+    // every round.
+    std::shared_ptr<Task> TaskForRound(int64 round_index)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<std::shared_ptr<Task>> tasks = tasks_;
+      std::sort(tasks.begin(), tasks.end(),
+                [](const std::shared_ptr<Task>& a,
+                   const std::shared_ptr<Task>& b) {
+                  return a->task_id < b->task_id;
+                });
+      return tasks[round_index % tasks.size()];
+    }
+
     bool SpaceInBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       return results_.size() + outstanding_requests_ <
              max_outstanding_requests_;
@@ -587,8 +673,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // The number of threads in `worker_threads_` which are still running.
     int64 num_running_worker_threads_ TF_GUARDED_BY(mu_) = 0;
 
-    // The index of the next task in `tasks_` to read from.
-    int64 next_task_index_ TF_GUARDED_BY(mu_) = 0;
+    // The next round to read, for coordinated reads.
+    int64 next_round_index_ TF_GUARDED_BY(mu_) = 0;
 
     // The number tasks in the `tasks_` list that have reached end_of_sequence.
     int64 finished_tasks_ TF_GUARDED_BY(mu_) = 0;
@@ -618,6 +704,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
   const tstring job_name_;
   const int64 max_outstanding_requests_;
   const int64 task_refresh_interval_ms_;
+  const int64 consumer_index_;
+  const int64 num_consumers_;
   IterationCounter* const iteration_counter_;  // Owned
   const bool owns_resource_;
   const ResourceHandle iteration_counter_handle_;
@@ -633,6 +721,18 @@ DataServiceDatasetOp::DataServiceDatasetOp(OpKernelConstruction* ctx)
   if (task_refresh_interval_hint_ms_ == model::kAutotune) {
     task_refresh_interval_hint_ms_ = kDefaultTaskRefreshIntervalMs;
   }
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kConsumerIndex, &consumer_index_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kNumConsumers, &num_consumers_));
+  OP_REQUIRES(ctx, num_consumers_ >= 0,
+              errors::InvalidArgument(kNumConsumers,
+                                      " must be non-negative, but got ",
+                                      num_consumers_));
+  OP_REQUIRES(
+      ctx,
+      num_consumers_ == 0 ||
+          (consumer_index_ >= 0 && consumer_index_ < num_consumers_),
+      errors::InvalidArgument(kConsumerIndex, " must be in the range [0, ",
+                              num_consumers_, "), but got ", consumer_index_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
 }
@@ -661,6 +761,11 @@ void DataServiceDatasetOp::MakeDataset(OpKernelContext* ctx,
 
   tstring job_name;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kJobName, &job_name));
+  OP_REQUIRES(ctx, num_consumers_ == 0 || !job_name.empty(),
+              errors::InvalidArgument(
+                  "Coordinated reads require the consumers to share a job, "
+                  "but no ",
+                  kJobName, " was given."));
 
   int64 max_outstanding_requests;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kMaxOutstandingRequests,
@@ -704,8 +809,9 @@ void DataServiceDatasetOp::MakeDataset(OpKernelContext* ctx,
   *output =
       new Dataset(ctx, dataset_id, processing_mode, address, protocol, job_name,
                   max_outstanding_requests, task_refresh_interval_hint_ms_,
-                  iteration_counter, owns_resource, iteration_counter_handle,
-                  output_types_, output_shapes_);
+                  consumer_index_, num_consumers_, iteration_counter,
+                  owns_resource, iteration_counter_handle, output_types_,
+                  output_shapes_);
 }
 
 REGISTER_KERNEL_BUILDER(Name("DataServiceDataset").Device(DEVICE_CPU),
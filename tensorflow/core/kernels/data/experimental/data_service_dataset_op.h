@@ -58,6 +58,8 @@ class DataServiceDatasetOp : public DatasetOpKernel {
   class Dataset;
 
   int64 task_refresh_interval_hint_ms_;
+  int64 consumer_index_;
+  int64 num_consumers_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
 };
@@ -0,0 +1,462 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/experimental/persistent_cache_dataset_op.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/kernels/data/hash_utils.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/str_util.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kDirectory;
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kMaxSizeBytes;
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    PersistentCacheDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kCacheFileSuffix[] = ".cache";
+constexpr char kAccessFileSuffix[] = ".access";
+constexpr char kMode[] = "mode";
+constexpr char kOffset[] = "offset";
+constexpr char kInputImplEmpty[] = "input_impl_empty";
+
+// Returns the name of the empty file whose modification time records the last
+// time the cache entry `cache_file` was opened for reading.
+string AccessFile(const string& cache_file) {
+  return strings::StrCat(cache_file, kAccessFileSuffix);
+}
+
+// Deletes the least recently used cache entries in `directory`, except for
+// `keep`, until the entries take up at most `max_size_bytes`.
+Status EvictEntries(Env* env, const string& directory, int64 max_size_bytes,
+                    const string& keep) {
+  struct Entry {
+    string cache_file;
+    int64 size;
+    int64 last_access_nsec;
+  };
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(env->GetChildren(directory, &children));
+  std::vector<Entry> entries;
+  int64 total_size = 0;
+  for (const string& child : children) {
+    if (!absl::EndsWith(child, kCacheFileSuffix)) continue;
+    Entry entry;
+    entry.cache_file = io::JoinPath(directory, child);
+    FileStatistics stats;
+    // Another job may have evicted the entry in the meantime.
+    if (!env->Stat(entry.cache_file, &stats).ok()) continue;
+    entry.size = stats.length;
+    entry.last_access_nsec = stats.mtime_nsec;
+    if (env->Stat(AccessFile(entry.cache_file), &stats).ok()) {
+      entry.last_access_nsec =
+          std::max(entry.last_access_nsec, stats.mtime_nsec);
+    }
+    total_size += entry.size;
+    entries.push_back(std::move(entry));
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.last_access_nsec < b.last_access_nsec;
+            });
+  for (const Entry& entry : entries) {
+    if (total_size <= max_size_bytes) break;
+    if (entry.cache_file == keep) continue;
+    VLOG(2) << "Evicting persistent cache entry " << entry.cache_file;
+    env->DeleteFile(entry.cache_file).IgnoreError();
+    env->DeleteFile(AccessFile(entry.cache_file)).IgnoreError();
+    total_size -= entry.size;
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+class PersistentCacheDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, string directory,
+          int64 max_size_bytes, const string& fingerprint)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        directory_(std::move(directory)),
+        max_size_bytes_(max_size_bytes),
+        cache_file_(io::JoinPath(
+            directory_, strings::StrCat(fingerprint, kCacheFileSuffix))) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, strings::StrCat(prefix, "::", kDatasetType)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return strings::StrCat("PersistentCacheDatasetOp::Dataset");
+  }
+
+  int64 Cardinality() const override { return input_->Cardinality(); }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* directory = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(tstring(directory_), &directory));
+    Node* max_size_bytes = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(max_size_bytes_, &max_size_bytes));
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, directory, max_size_bytes}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      AbandonWrite();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      env_ = ctx->env();
+      TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(dataset()->directory_));
+      if (env_->FileExists(dataset()->cache_file_).ok()) {
+        Status s = InitializeReader();
+        if (s.ok()) {
+          mode_ = Mode::kRead;
+          return Status::OK();
+        }
+        LOG(WARNING) << "Failed to read persistent cache entry "
+                     << dataset()->cache_file_
+                     << ", recomputing it: " << s.ToString();
+      }
+      TF_RETURN_IF_ERROR(InitializeInput(ctx));
+      Status s = InitializeWriter();
+      if (s.ok()) {
+        mode_ = Mode::kWrite;
+      } else {
+        LOG(WARNING) << "Failed to create persistent cache entry "
+                     << dataset()->cache_file_ << ": " << s.ToString();
+        AbandonWrite();
+        mode_ = Mode::kPassThrough;
+      }
+      return Status::OK();
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (mode_ == Mode::kRead) {
+        return ReadElement(ctx, out_tensors, end_of_sequence);
+      }
+      if (!input_impl_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(
+          input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+      if (*end_of_sequence) {
+        input_impl_.reset();
+        if (mode_ == Mode::kWrite) {
+          Status s = FinishWrite();
+          if (!s.ok()) {
+            LOG(WARNING) << "Failed to finish persistent cache entry "
+                         << dataset()->cache_file_ << ": " << s.ToString();
+            AbandonWrite();
+          }
+          mode_ = Mode::kPassThrough;
+        }
+        return Status::OK();
+      }
+      if (mode_ == Mode::kWrite) {
+        Status s = WriteElement(*out_tensors);
+        if (!s.ok()) {
+          // E.g. the disk is full. The elements are still produced, but the
+          // entry is not created.
+          LOG(WARNING) << "Failed to write persistent cache entry "
+                       << dataset()->cache_file_ << ": " << s.ToString();
+          AbandonWrite();
+          mode_ = Mode::kPassThrough;
+        }
+      }
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kMode),
+                                             static_cast<int64>(mode_)));
+      if (mode_ == Mode::kRead) {
+        return writer->WriteScalar(full_name(kOffset),
+                                   static_cast<int64>(offset_));
+      }
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kInputImplEmpty), ""));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      int64 mode;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kMode), &mode));
+      // A partially written entry cannot be resumed, so iterators restored
+      // before the end of their input no longer write to the cache.
+      AbandonWrite();
+      if (static_cast<Mode>(mode) == Mode::kRead) {
+        input_impl_.reset();
+        if (!reader_) {
+          TF_RETURN_IF_ERROR(InitializeReader());
+        }
+        int64 offset;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
+        offset_ = offset;
+        mode_ = Mode::kRead;
+        return Status::OK();
+      }
+      reader_.reset();
+      mode_ = Mode::kPassThrough;
+      if (reader->Contains(full_name(kInputImplEmpty))) {
+        input_impl_.reset();
+        return Status::OK();
+      }
+      if (!input_impl_) {
+        TF_RETURN_IF_ERROR(InitializeInput(ctx));
+      }
+      return RestoreInput(ctx, reader, input_impl_);
+    }
+
+   private:
+    enum class Mode : int64 { kRead = 0, kWrite = 1, kPassThrough = 2 };
+
+    Status InitializeInput(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status InitializeReader() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::unique_ptr<ReadOnlyMemoryRegion> region;
+      TF_RETURN_IF_ERROR(env_->NewReadOnlyMemoryRegionFromFile(
+          dataset()->cache_file_, &region));
+      reader_ = absl::make_unique<io::MemmappedRecordReader>(std::move(region));
+      offset_ = 0;
+      // Marks the entry as recently used.
+      Status s =
+          WriteStringToFile(env_, AccessFile(dataset()->cache_file_), "");
+      if (!s.ok()) {
+        VLOG(1) << "Failed to update the access time of "
+                << dataset()->cache_file_ << ": " << s.ToString();
+      }
+      return Status::OK();
+    }
+
+    Status InitializeWriter() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      temp_file_ = strings::StrCat(dataset()->cache_file_, ".tmp.",
+                                   strings::Hex(random::New64()));
+      TF_RETURN_IF_ERROR(env_->NewWritableFile(temp_file_, &file_));
+      writer_ = absl::make_unique<io::RecordWriter>(file_.get());
+      return Status::OK();
+    }
+
+    // Each element is stored as one record per component.
+    Status ReadElement(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                       bool* end_of_sequence) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const DataTypeVector& dtypes = dataset()->output_dtypes();
+      out_tensors->clear();
+      out_tensors->reserve(dtypes.size());
+      for (int i = 0; i < dtypes.size(); ++i) {
+        StringPiece record;
+        Status s = reader_->ReadRecord(&offset_, &record);
+        if (errors::IsOutOfRange(s) && i == 0) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (errors::IsOutOfRange(s)) {
+          return errors::DataLoss("Persistent cache entry ",
+                                  dataset()->cache_file_,
+                                  " ends with an incomplete element.");
+        }
+        TF_RETURN_IF_ERROR(s);
+        TensorProto proto;
+        Tensor tensor;
+        if (!proto.ParseFromArray(record.data(), record.size()) ||
+            !tensor.FromProto(ctx->allocator({}), proto) ||
+            tensor.dtype() != dtypes[i]) {
+          return errors::DataLoss("Failed to parse component ", i,
+                                  " of an element of persistent cache entry ",
+                                  dataset()->cache_file_);
+        }
+        out_tensors->push_back(std::move(tensor));
+      }
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+    Status WriteElement(const std::vector<Tensor>& element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (const Tensor& tensor : element) {
+        TensorProto proto;
+        tensor.AsProtoTensorContent(&proto);
+        TF_RETURN_IF_ERROR(writer_->WriteRecord(proto.SerializeAsString()));
+      }
+      return Status::OK();
+    }
+
+    // Publishes the temporary file as the cache entry and evicts other
+    // entries, if needed.
+    Status FinishWrite() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      TF_RETURN_IF_ERROR(writer_->Close());
+      writer_.reset();
+      TF_RETURN_IF_ERROR(file_->Close());
+      file_.reset();
+      TF_RETURN_IF_ERROR(env_->RenameFile(temp_file_, dataset()->cache_file_));
+      temp_file_.clear();
+      if (dataset()->max_size_bytes_ > 0) {
+        TF_RETURN_IF_ERROR(EvictEntries(env_, dataset()->directory_,
+                                        dataset()->max_size_bytes_,
+                                        dataset()->cache_file_));
+      }
+      return Status::OK();
+    }
+
+    // Stops writing and deletes the partially written entry, if any.
+    void AbandonWrite() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      writer_.reset();
+      file_.reset();
+      if (!temp_file_.empty()) {
+        env_->DeleteFile(temp_file_).IgnoreError();
+        temp_file_.clear();
+      }
+    }
+
+    mutex mu_;
+    Env* env_ TF_GUARDED_BY(mu_) = nullptr;
+    Mode mode_ TF_GUARDED_BY(mu_) = Mode::kPassThrough;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    // Used in `kRead` mode.
+    std::unique_ptr<io::MemmappedRecordReader> reader_ TF_GUARDED_BY(mu_);
+    uint64 offset_ TF_GUARDED_BY(mu_) = 0;
+    // Used in `kWrite` mode.
+    string temp_file_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<WritableFile> file_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::RecordWriter> writer_ TF_GUARDED_BY(mu_);
+  };
+
+  const DatasetBase* const input_;
+  const string directory_;
+  const int64 max_size_bytes_;
+  const string cache_file_;
+};
+
+void PersistentCacheDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase* input,
+                                           DatasetBase** output) {
+  tstring directory;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<tstring>(ctx, kDirectory, &directory));
+  OP_REQUIRES(ctx, !directory.empty(),
+              errors::InvalidArgument("`directory` must not be empty."));
+  int64 max_size_bytes;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64>(ctx, kMaxSizeBytes, &max_size_bytes));
+  OP_REQUIRES(ctx, max_size_bytes >= 0,
+              errors::InvalidArgument("`max_size_bytes` must be >= 0, got ",
+                                      max_size_bytes));
+
+  SerializationContext::Params params;
+  std::vector<std::pair<string, Tensor>> input_list;
+  params.input_list = &input_list;
+  params.external_state_policy =
+      SerializationContext::ExternalStatePolicy::kIgnore;
+  GraphDef graph_def;
+  OP_REQUIRES_OK(
+      ctx, AsGraphDef(ctx, input, SerializationContext(params), &graph_def));
+  uint64 hash;
+  OP_REQUIRES_OK(ctx, HashGraph(graph_def, &hash));
+
+  *output =
+      new Dataset(ctx, input, directory, max_size_bytes,
+                  strings::StrCat(strings::Hex(hash, strings::kZeroPad16)));
+}
+
+namespace {
+
+REGISTER_KERNEL_BUILDER(Name("PersistentCacheDataset").Device(DEVICE_CPU),
+                        PersistentCacheDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PERSISTENT_CACHE_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PERSISTENT_CACHE_DATASET_OP_H_
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Caches the elements of its input in a directory shared by all jobs on a
+// host, e.g. on a local SSD.
+//
+// Cache entries are keyed by the fingerprint of the input dataset graph, so
+// that jobs running the same input pipeline share one entry without having to
+// agree on a file name. The first iterator over a dataset without an entry
+// writes its elements to a temporary file, which atomically becomes the entry
+// once the input is exhausted; iterators created after that read the entry
+// through a memory map instead of running the input pipeline. Concurrent
+// writers of the same entry do not coordinate: whichever finishes last
+// replaces the (identical) entry of the others.
+//
+// After an entry has been written, the least recently used other entries are
+// deleted until the entries fit into `max_size_bytes` (0 means unbounded).
+//
+// The input must produce the same elements whenever it is iterated over, since
+// the fingerprint does not capture e.g. an unseeded shuffle.
+class PersistentCacheDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "PersistentCache";
+  static constexpr const char* const kInputDataset = "input_dataset";
+  static constexpr const char* const kDirectory = "directory";
+  static constexpr const char* const kMaxSizeBytes = "max_size_bytes";
+  static constexpr const char* const kOutputTypes = "output_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+
+  explicit PersistentCacheDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PERSISTENT_CACHE_DATASET_OP_H_
@@ -0,0 +1,248 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/experimental/persistent_cache_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "persistent_cache_dataset";
+
+class PersistentCacheDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  PersistentCacheDatasetParams(T input_dataset_params, string directory,
+                               int64 max_size_bytes,
+                               DataTypeVector output_dtypes,
+                               std::vector<PartialTensorShape> output_shapes,
+                               string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        directory_(std::move(directory)),
+        max_size_bytes_(max_size_bytes) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<tstring>(TensorShape({}), {directory_}),
+            CreateTensor<int64>(TensorShape({}), {max_size_bytes_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {PersistentCacheDatasetOp::kInputDataset,
+                    PersistentCacheDatasetOp::kDirectory,
+                    PersistentCacheDatasetOp::kMaxSizeBytes};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{PersistentCacheDatasetOp::kOutputTypes, output_dtypes_},
+                    {PersistentCacheDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return PersistentCacheDatasetOp::kDatasetType;
+  }
+
+ private:
+  string directory_;
+  int64 max_size_bytes_;
+};
+
+string CacheDirectory() {
+  return io::JoinPath(testing::TmpDir(), "persistent_cache");
+}
+
+class PersistentCacheDatasetOpTest : public DatasetOpsTestBase {
+ public:
+  ~PersistentCacheDatasetOpTest() override {
+    int64 undeleted_files, undeleted_dirs;
+    Status s = Env::Default()->DeleteRecursively(
+        CacheDirectory(), &undeleted_files, &undeleted_dirs);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete " << CacheDirectory() << ": "
+                   << s.ToString();
+    }
+  }
+
+ protected:
+  // Returns the names of the cache entries in the cache directory.
+  std::vector<string> CacheEntries() {
+    std::vector<string> entries;
+    TF_CHECK_OK(Env::Default()->GetMatchingPaths(
+        io::JoinPath(CacheDirectory(), "*.cache"), &entries));
+    return entries;
+  }
+
+  // Iterates through a new iterator over a new dataset for `params` and
+  // checks that it produces `expected_outputs`.
+  Status CheckNewIterator(const PersistentCacheDatasetParams& params,
+                          const std::vector<Tensor>& expected_outputs) {
+    std::unique_ptr<TestDataset> dataset;
+    TF_RETURN_IF_ERROR(MakeDataset(params, &dataset));
+    std::unique_ptr<TestIterator> iterator;
+    TF_RETURN_IF_ERROR(MakeIterator(params, *dataset, &iterator));
+    return CheckIteratorGetNext(iterator.get(), expected_outputs,
+                                /*compare_order=*/true);
+  }
+};
+
+PersistentCacheDatasetParams RangeParams(int64 stop,
+                                         int64 max_size_bytes = 0) {
+  return PersistentCacheDatasetParams(
+      RangeDatasetParams(0, stop, 1), CacheDirectory(), max_size_bytes,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})}, kNodeName);
+}
+
+PersistentCacheDatasetParams InvalidMaxSizeBytesParams() {
+  return RangeParams(10, /*max_size_bytes=*/-1);
+}
+
+std::vector<GetNextTestCase<PersistentCacheDatasetParams>> GetNextTestCases() {
+  return {{/*dataset_params=*/RangeParams(10),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({}),
+                                {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8},
+                                 {9}})},
+          {/*dataset_params=*/RangeParams(0),
+           /*expected_outputs=*/{}}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(PersistentCacheDatasetOpTest,
+                         PersistentCacheDatasetParams, GetNextTestCases())
+
+TEST_F(PersistentCacheDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = RangeParams(10);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(PersistentCacheDatasetOp::kDatasetType)));
+}
+
+TEST_F(PersistentCacheDatasetOpTest, Cardinality) {
+  auto dataset_params = RangeParams(10);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(10));
+}
+
+TEST_F(PersistentCacheDatasetOpTest, PublishesEntryAtEndOfInput) {
+  auto dataset_params = RangeParams(3);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  EXPECT_TRUE(CacheEntries().empty());
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  EXPECT_EQ(CacheEntries().size(), 1);
+}
+
+TEST_F(PersistentCacheDatasetOpTest, ReadsExistingEntry) {
+  auto dataset_params = RangeParams(5);
+  auto expected_outputs =
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}, {2}, {3}, {4}});
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(expected_outputs, /*compare_order=*/true));
+  std::vector<string> entries = CacheEntries();
+  ASSERT_EQ(entries.size(), 1);
+  FileStatistics stats;
+  TF_ASSERT_OK(Env::Default()->Stat(entries[0], &stats));
+
+  // A dataset with the same input resolves to the same entry.
+  TF_ASSERT_OK(CheckNewIterator(dataset_params, expected_outputs));
+  EXPECT_EQ(CacheEntries(), entries);
+  FileStatistics new_stats;
+  TF_ASSERT_OK(Env::Default()->Stat(entries[0], &new_stats));
+  EXPECT_EQ(new_stats.mtime_nsec, stats.mtime_nsec);
+  TF_EXPECT_OK(
+      Env::Default()->FileExists(strings::StrCat(entries[0], ".access")));
+}
+
+TEST_F(PersistentCacheDatasetOpTest, DifferentInputsUseDifferentEntries) {
+  TF_ASSERT_OK(Initialize(RangeParams(3)));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}, {2}}),
+      /*compare_order=*/true));
+  TF_ASSERT_OK(CheckNewIterator(
+      RangeParams(2), CreateTensors<int64>(TensorShape({}), {{0}, {1}})));
+  EXPECT_EQ(CacheEntries().size(), 2);
+}
+
+TEST_F(PersistentCacheDatasetOpTest, EvictsLeastRecentlyUsedEntries) {
+  // Every entry is larger than the limit, so only the most recently written
+  // one is kept.
+  TF_ASSERT_OK(Initialize(RangeParams(3, /*max_size_bytes=*/1)));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}, {2}}),
+      /*compare_order=*/true));
+  std::vector<string> first_entries = CacheEntries();
+  ASSERT_EQ(first_entries.size(), 1);
+  TF_ASSERT_OK(CheckNewIterator(
+      RangeParams(2, /*max_size_bytes=*/1),
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}})));
+  std::vector<string> second_entries = CacheEntries();
+  ASSERT_EQ(second_entries.size(), 1);
+  EXPECT_NE(first_entries[0], second_entries[0]);
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<PersistentCacheDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/RangeParams(10),
+           /*breakpoints=*/{0, 4, 11},
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({}),
+                                {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8},
+                                 {9}})}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(PersistentCacheDatasetOpTest,
+                                 PersistentCacheDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(PersistentCacheDatasetOpTest, SaveAndRestoreWhileReadingEntry) {
+  auto dataset_params = RangeParams(6);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}, {2}, {3}, {4}, {5}}),
+      /*compare_order=*/true));
+  // The iterators below read the entry written above.
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(),
+      CreateTensors<int64>(TensorShape({}), {{0}, {1}, {2}, {3}, {4}, {5}}),
+      /*breakpoints=*/{0, 3, 7}, /*compare_order=*/true));
+}
+
+TEST_F(PersistentCacheDatasetOpTest, InvalidMaxSizeBytes) {
+  EXPECT_EQ(Initialize(InvalidMaxSizeBytesParams()).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -58,6 +58,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 #include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -74,6 +75,21 @@ namespace experimental {
     SnapshotDatasetV2Op::kShardFuncTarguments;
 /* static */ constexpr const int SnapshotDatasetV2Op::kFileFormatVersion;
 
+/* static */ int64 SnapshotDatasetV2Op::FileFormatVersion() {
+  static const int64 version = [] {
+    int64 version;
+    Status s = ReadInt64FromEnvVar("TF_DATA_SNAPSHOT_FILE_FORMAT_VERSION",
+                                   kFileFormatVersion, &version);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_DATA_SNAPSHOT_FILE_FORMAT_VERSION: "
+                 << s;
+      return static_cast<int64>(kFileFormatVersion);
+    }
+    return version;
+  }();
+  return version;
+}
+
 // ==== Snapshot Implementation ====
 
 /* The current snapshot on-disk layout is as follows:
@@ -637,7 +653,7 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::WriteMetadataFile(
   metadata.set_creation_timestamp(EnvTime::NowMicros());
   metadata.set_graph_hash(strings::StrCat(dataset()->hash_));
   metadata.set_run_id(strings::StrCat(run_id_));
-  metadata.set_version(kFileFormatVersion);
+  metadata.set_version(FileFormatVersion());
   for (const auto& output_dtype : dataset()->output_dtypes()) {
     metadata.add_dtype(output_dtype);
   }
@@ -735,7 +751,7 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::GetNextInternal(
           snapshot_util::ShardDirectory(run_dir_, shard_index);
       auto writer = std::make_unique<snapshot_util::AsyncWriter>(
           ctx->env(), shard_index, snapshot_shard_directory,
-          current_checkpoint_id_, dataset()->compression_, kFileFormatVersion,
+          current_checkpoint_id_, dataset()->compression_, FileFormatVersion(),
           dataset()->output_dtypes(), [this](Status s) {
             if (!s.ok()) {
               LOG(ERROR) << "AsyncWriter in snapshot writer failed: " << s;
@@ -66,6 +66,12 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
  private:
   static constexpr const int kFileFormatVersion = 2;
 
+  // Returns the file format version used to write new snapshots. Defaults to
+  // `kFileFormatVersion` and can be overridden through the
+  // TF_DATA_SNAPSHOT_FILE_FORMAT_VERSION environment variable, e.g. to write
+  // the chunked format (version 3).
+  static int64 FileFormatVersion();
+
   class Dataset;
 
   const int graph_def_version_;
@@ -47,6 +47,12 @@ namespace snapshot_util {
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderOutputBufferSizeBytes;
+/* static */ constexpr const size_t ChunkedWriter::kHeaderSize;
+/* static */ constexpr const size_t ChunkedWriter::kFooterSize;
+/* static */ constexpr const uint64 ChunkedWriter::kMagic;
+/* static */ constexpr const int64 ChunkedWriter::kChunkSizeBytes;
+/* static */ constexpr const int ChunkedReader::kNumReaderThreads;
+/* static */ constexpr const int ChunkedReader::kReadAheadChunks;
 
 std::string HashDirectory(const std::string& path, uint64 hash) {
   return io::JoinPath(
@@ -91,6 +97,10 @@ Status Writer::Create(Env* env, const std::string& filename,
       *out_writer =
           absl::make_unique<TFRecordWriter>(filename, compression_type);
       break;
+    case 3:
+      *out_writer =
+          absl::make_unique<ChunkedWriter>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot writer version: ", version,
                                      " is not supported.");
@@ -304,6 +314,114 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
 }
 #endif  // PLATFORM_GOOGLE
 
+ChunkedWriter::ChunkedWriter(const std::string& filename,
+                             const std::string& compression_type,
+                             const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes) {}
+
+Status ChunkedWriter::Initialize(tensorflow::Env* env) {
+  if (compression_type_ != io::compression::kNone &&
+      compression_type_ != io::compression::kSnappy) {
+    return errors::InvalidArgument("Compression ", compression_type_,
+                                   " is not supported by snapshot version 3.");
+  }
+  return env->NewWritableFile(filename_, &dest_);
+}
+
+Status ChunkedWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (tensors.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected ", dtypes_.size(),
+                                   " tensors but got ", tensors.size(), ".");
+  }
+  for (int i = 0, end = tensors.size(); i < end; ++i) {
+    const Tensor& tensor = tensors[i];
+    experimental::TensorMetadata* tensor_metadata =
+        chunk_metadata_.add_tensor_metadata();
+    tensor.shape().AsProto(tensor_metadata->mutable_tensor_shape());
+    const size_t start = chunk_data_.size();
+    if (DataTypeCanUseMemcpy(dtypes_[i])) {
+      const StringPiece data = tensor.tensor_data();
+      chunk_data_.append(data.data(), data.size());
+    } else {
+      TensorProto proto;
+      tensor.AsProtoTensorContent(&proto);
+      proto.AppendToString(&chunk_data_);
+    }
+    tensor_metadata->set_tensor_size_bytes(chunk_data_.size() - start);
+  }
+  ++chunk_num_elements_;
+  if (chunk_data_.size() >= kChunkSizeBytes) {
+    return FlushChunk();
+  }
+  return Status::OK();
+}
+
+Status ChunkedWriter::FlushChunk() {
+  if (chunk_num_elements_ == 0) {
+    return Status::OK();
+  }
+  profiler::TraceMe activity("SnapshotChunkedWriter::FlushChunk",
+                             profiler::TraceMeLevel::kInfo);
+  const std::string metadata = chunk_metadata_.SerializeAsString();
+  char header[kHeaderSize];
+  core::EncodeFixed64(header, metadata.size());
+
+  std::string compressed;
+  StringPiece data = chunk_data_;
+  if (compression_type_ == io::compression::kSnappy) {
+    if (!port::Snappy_Compress(chunk_data_.data(), chunk_data_.size(),
+                               &compressed)) {
+      return errors::Internal("Failed to compress using snappy.");
+    }
+    data = compressed;
+  }
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(dest_->Append(metadata));
+  TF_RETURN_IF_ERROR(dest_->Append(data));
+
+  experimental::SnapshotChunkInfo* info = index_.add_chunk();
+  info->set_offset(offset_);
+  info->set_size(sizeof(header) + metadata.size() + data.size());
+  info->set_num_elements(chunk_num_elements_);
+  offset_ += info->size();
+
+  chunk_metadata_.Clear();
+  chunk_data_.clear();
+  chunk_num_elements_ = 0;
+  return Status::OK();
+}
+
+Status ChunkedWriter::Sync() {
+  TF_RETURN_IF_ERROR(FlushChunk());
+  return dest_->Sync();
+}
+
+Status ChunkedWriter::Close() {
+  if (dest_ == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(FlushChunk());
+  const std::string index = index_.SerializeAsString();
+  char footer[kFooterSize];
+  core::EncodeFixed64(footer, offset_);
+  core::EncodeFixed64(footer + sizeof(uint64), index.size());
+  core::EncodeFixed64(footer + 2 * sizeof(uint64), kMagic);
+  TF_RETURN_IF_ERROR(dest_->Append(index));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  TF_RETURN_IF_ERROR(dest_->Close());
+  dest_ = nullptr;
+  return Status::OK();
+}
+
+ChunkedWriter::~ChunkedWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close snapshot file " << filename_ << ": " << s;
+  }
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -321,6 +439,10 @@ Status Reader::Create(Env* env, const std::string& filename,
       *out_reader =
           absl::make_unique<TFRecordReader>(filename, compression_type, dtypes);
       break;
+    case 3:
+      *out_reader =
+          absl::make_unique<ChunkedReader>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot reader version: ", version,
                                      " is not supported.");
@@ -841,6 +963,226 @@ Status CustomReader::ReadRecord(absl::Cord* record) {
 }
 #endif
 
+ChunkedReader::ChunkedReader(const std::string& filename,
+                             const string& compression_type,
+                             const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes) {}
+
+Status ChunkedReader::Initialize(Env* env) {
+  if (compression_type_ != io::compression::kNone &&
+      compression_type_ != io::compression::kSnappy) {
+    return errors::InvalidArgument("Compression ", compression_type_,
+                                   " is not supported by snapshot version 3.");
+  }
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename_, &file_size));
+  if (file_size < ChunkedWriter::kFooterSize) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " is too short to contain a chunk index.");
+  }
+  char footer[ChunkedWriter::kFooterSize];
+  StringPiece result;
+  TF_RETURN_IF_ERROR(file_->Read(file_size - sizeof(footer), sizeof(footer),
+                                 &result, footer));
+  if (result.size() != sizeof(footer) ||
+      core::DecodeFixed64(result.data() + 2 * sizeof(uint64)) !=
+          ChunkedWriter::kMagic) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " does not end with a chunk index. It may not "
+                            "have been closed properly.");
+  }
+  const uint64 index_offset = core::DecodeFixed64(result.data());
+  const uint64 index_size = core::DecodeFixed64(result.data() + sizeof(uint64));
+  if (index_offset + index_size + sizeof(footer) != file_size) {
+    return errors::DataLoss("Corrupted chunk index in snapshot file ",
+                            filename_, ".");
+  }
+  std::unique_ptr<char[]> scratch(new char[index_size]);
+  TF_RETURN_IF_ERROR(
+      file_->Read(index_offset, index_size, &result, scratch.get()));
+  if (result.size() != index_size ||
+      !index_.ParseFromArray(result.data(), result.size())) {
+    return errors::DataLoss("Could not parse the chunk index of snapshot file ",
+                            filename_, ".");
+  }
+  thread_pool_ = absl::make_unique<thread::ThreadPool>(
+      env, "snapshot_chunked_reader", kNumReaderThreads);
+  return Status::OK();
+}
+
+Status ChunkedReader::ReadTensors(std::vector<Tensor>* read_tensors) {
+  while (current_ == nullptr || position_ >= current_->elements.size()) {
+    TF_RETURN_IF_ERROR(NextChunk());
+  }
+  read_tensors->reserve(dtypes_.size());
+  for (auto& tensor : current_->elements[position_]) {
+    read_tensors->push_back(std::move(tensor));
+  }
+  ++position_;
+  return Status::OK();
+}
+
+Status ChunkedReader::SkipRecords(int64 num_records) {
+  while (num_records > 0) {
+    if (current_ != nullptr && position_ < current_->elements.size()) {
+      const int64 num_skipped =
+          std::min<int64>(num_records, current_->elements.size() - position_);
+      position_ += num_skipped;
+      num_records -= num_skipped;
+    } else if (pending_.empty() && next_chunk_ < index_.chunk_size() &&
+               index_.chunk(next_chunk_).num_elements() <= num_records) {
+      // The whole chunk is skipped, so there is no need to read it.
+      num_records -= index_.chunk(next_chunk_).num_elements();
+      ++next_chunk_;
+    } else {
+      TF_RETURN_IF_ERROR(NextChunk());
+    }
+  }
+  return Status::OK();
+}
+
+void ChunkedReader::ScheduleReads() {
+  while (pending_.size() < kReadAheadChunks &&
+         next_chunk_ < index_.chunk_size()) {
+    auto chunk = std::make_shared<Chunk>();
+    const experimental::SnapshotChunkInfo* info = &index_.chunk(next_chunk_++);
+    thread_pool_->Schedule([this, chunk, info]() {
+      chunk->status = ReadChunk(*info, &chunk->elements);
+      chunk->done.Notify();
+    });
+    pending_.push_back(std::move(chunk));
+  }
+}
+
+Status ChunkedReader::NextChunk() {
+  ScheduleReads();
+  if (pending_.empty()) {
+    current_ = nullptr;
+    return errors::OutOfRange("No more chunks in snapshot file ", filename_,
+                              ".");
+  }
+  current_ = std::move(pending_.front());
+  pending_.pop_front();
+  position_ = 0;
+  // Keep the reader threads busy while we wait for the current chunk.
+  ScheduleReads();
+  current_->done.WaitForNotification();
+  return current_->status;
+}
+
+Status ChunkedReader::ReadChunk(
+    const experimental::SnapshotChunkInfo& info,
+    std::vector<std::vector<Tensor>>* elements) const {
+  profiler::TraceMe activity(
+      [&]() { return absl::StrCat(kClassName, kSeparator, "ReadChunk"); },
+      profiler::TraceMeLevel::kInfo);
+  std::unique_ptr<char[]> scratch(new char[info.size()]);
+  StringPiece chunk;
+  TF_RETURN_IF_ERROR(
+      file_->Read(info.offset(), info.size(), &chunk, scratch.get()));
+  if (chunk.size() != info.size() ||
+      chunk.size() < ChunkedWriter::kHeaderSize) {
+    return errors::DataLoss("Truncated chunk at offset ", info.offset(),
+                            " of snapshot file ", filename_, ".");
+  }
+  const uint64 metadata_size = core::DecodeFixed64(chunk.data());
+  chunk.remove_prefix(ChunkedWriter::kHeaderSize);
+  experimental::SnapshotTensorMetadata metadata;
+  if (metadata_size > chunk.size() ||
+      !metadata.ParseFromArray(chunk.data(), metadata_size)) {
+    return errors::DataLoss("Could not parse the metadata of the chunk at "
+                            "offset ",
+                            info.offset(), " of snapshot file ", filename_,
+                            ".");
+  }
+  chunk.remove_prefix(metadata_size);
+  const int num_components = dtypes_.size();
+  if (metadata.tensor_metadata_size() != info.num_elements() * num_components) {
+    return errors::DataLoss("Expected ", info.num_elements() * num_components,
+                            " tensors in the chunk at offset ", info.offset(),
+                            " of snapshot file ", filename_, " but found ",
+                            metadata.tensor_metadata_size(), ".");
+  }
+
+  // Allocates the output tensors up front, so that the data of tensors with a
+  // trivially copyable dtype can be decoded directly into their buffers.
+  std::vector<struct iovec> iov(metadata.tensor_metadata_size());
+  std::vector<std::unique_ptr<char[]>> tensor_proto_strs(iov.size());
+  elements->resize(info.num_elements());
+  int64 total_size = 0;
+  for (int i = 0; i < iov.size(); ++i) {
+    const auto& tensor_metadata = metadata.tensor_metadata(i);
+    const DataType dtype = dtypes_[i % num_components];
+    std::vector<Tensor>& element = (*elements)[i / num_components];
+    if (DataTypeCanUseMemcpy(dtype)) {
+      TF_RETURN_IF_ERROR(
+          TensorShape::IsValidShape(tensor_metadata.tensor_shape()));
+      Tensor tensor(dtype, TensorShape(tensor_metadata.tensor_shape()));
+      if (tensor.TotalBytes() != tensor_metadata.tensor_size_bytes()) {
+        return errors::DataLoss("Tensor size mismatch in snapshot file ",
+                                filename_, ".");
+      }
+      iov[i].iov_base = const_cast<char*>(tensor.tensor_data().data());
+      iov[i].iov_len = tensor.TotalBytes();
+      element.push_back(std::move(tensor));
+    } else {
+      tensor_proto_strs[i] =
+          absl::make_unique<char[]>(tensor_metadata.tensor_size_bytes());
+      iov[i].iov_base = tensor_proto_strs[i].get();
+      iov[i].iov_len = tensor_metadata.tensor_size_bytes();
+      element.emplace_back();
+    }
+    total_size += iov[i].iov_len;
+  }
+
+  if (compression_type_ == io::compression::kSnappy) {
+    size_t size;
+    if (!port::Snappy_GetUncompressedLength(chunk.data(), chunk.size(),
+                                            &size) ||
+        size != total_size) {
+      return errors::DataLoss("Uncompressed size mismatch in the chunk at "
+                              "offset ",
+                              info.offset(), " of snapshot file ", filename_,
+                              ".");
+    }
+    if (!port::Snappy_UncompressToIOVec(chunk.data(), chunk.size(), iov.data(),
+                                        iov.size())) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
+  } else {
+    if (chunk.size() != total_size) {
+      return errors::DataLoss("Size mismatch in the chunk at offset ",
+                              info.offset(), " of snapshot file ", filename_,
+                              ".");
+    }
+    const char* position = chunk.data();
+    for (const auto& vec : iov) {
+      if (vec.iov_len > 0) {
+        memcpy(vec.iov_base, position, vec.iov_len);
+        position += vec.iov_len;
+      }
+    }
+  }
+
+  for (int i = 0; i < iov.size(); ++i) {
+    if (tensor_proto_strs[i] == nullptr) {
+      continue;
+    }
+    TensorProto proto;
+    if (!proto.ParseFromArray(tensor_proto_strs[i].get(), iov[i].iov_len)) {
+      return errors::DataLoss("Could not parse TensorProto");
+    }
+    Tensor& tensor = (*elements)[i / num_components][i % num_components];
+    if (!tensor.FromProto(proto)) {
+      return errors::DataLoss("Could not parse Tensor");
+    }
+  }
+  return Status::OK();
+}
+
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata) {
   string metadata_filename = io::JoinPath(dir, kMetadataFilename);
@@ -25,8 +25,11 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 
 namespace tensorflow {
 
@@ -36,9 +39,6 @@ namespace data {
 
 namespace experimental {
 
-class SnapshotMetadataRecord;
-class SnapshotTensorMetadata;
-
 }  // namespace experimental
 
 namespace snapshot_util {
@@ -163,6 +163,63 @@ class CustomWriter : public Writer {
   int num_complex_ = 0;
 };
 
+// Writes snapshots with a chunked file format (version 3).
+//
+// Elements are buffered into chunks of about `kChunkSizeBytes` bytes. Each
+// chunk stores the uncompressed metadata (shape and size) of its tensors,
+// followed by the raw bytes of the tensors with a trivially copyable dtype and
+// the serialized `TensorProto`s of all other tensors, optionally compressed as
+// a whole. An index of all chunks is written at the end of the file when the
+// writer is closed, so a file that was not closed can not be read.
+//
+// The file layout is:
+//
+//   chunk 0: | metadata size (8 bytes) | metadata | (compressed) tensor data |
+//   ...
+//   chunk N-1
+//   index: serialized `SnapshotChunkIndex`
+//   footer: | index offset (8 bytes) | index size (8 bytes) | magic (8 bytes) |
+class ChunkedWriter : public Writer {
+ public:
+  static constexpr const size_t kHeaderSize = sizeof(uint64);
+  static constexpr const size_t kFooterSize = 3 * sizeof(uint64);
+  // Little-endian encoding of "TFDCHUNK".
+  static constexpr const uint64 kMagic = 0x4b4e554843444654ULL;
+  static constexpr const int64 kChunkSizeBytes = 4 << 20;  // 4 MiB
+
+  ChunkedWriter(const std::string& filename,
+                const std::string& compression_type,
+                const DataTypeVector& dtypes);
+
+  Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  Status Sync() override;
+
+  Status Close() override;
+
+  ~ChunkedWriter() override;
+
+ protected:
+  Status Initialize(tensorflow::Env* env) override;
+
+ private:
+  // Writes the buffered elements (if any) to the file as a new chunk.
+  Status FlushChunk();
+
+  const std::string filename_;
+  const std::string compression_type_;
+  const DataTypeVector dtypes_;
+
+  std::unique_ptr<WritableFile> dest_;
+  uint64 offset_ = 0;
+  experimental::SnapshotChunkIndex index_;
+
+  // Elements buffered for the current chunk.
+  experimental::SnapshotTensorMetadata chunk_metadata_;
+  std::string chunk_data_;
+  int64 chunk_num_elements_ = 0;
+};
+
 // Interface class for reading snapshot files previous written with Writer.
 class Reader {
  public:
@@ -280,6 +337,70 @@ class CustomReader : public Reader {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
 };
 
+// Reads snapshots previously written with `ChunkedWriter`.
+//
+// Chunks are read and decoded ahead of the consumer by a small pool of
+// threads. Tensors with a trivially copyable dtype are decompressed directly
+// into the buffers of the output tensors. `SkipRecords` skips whole chunks
+// without reading them.
+class ChunkedReader : public Reader {
+ public:
+  static constexpr const int kNumReaderThreads = 2;
+  // Maximum number of chunks that are read ahead of the consumer.
+  static constexpr const int kReadAheadChunks = 4;
+
+  static constexpr const char* const kClassName = "SnapshotChunkedReader";
+  static constexpr const char* const kSeparator = "::";
+
+  ChunkedReader(const std::string& filename, const string& compression_type,
+                const DataTypeVector& dtypes);
+
+  Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  Status SkipRecords(int64 num_records) override;
+
+  ~ChunkedReader() override {}
+
+ protected:
+  Status Initialize(Env* env) override;
+
+ private:
+  // The decoded elements of a chunk, filled in by a reader thread.
+  struct Chunk {
+    Status status;
+    std::vector<std::vector<Tensor>> elements;
+    Notification done;
+  };
+
+  // Schedules reads of the next chunks until `kReadAheadChunks` are pending.
+  void ScheduleReads();
+
+  // Makes the next pending chunk the current one, waiting until it is decoded.
+  // Returns `OutOfRange` if there are no more chunks.
+  Status NextChunk();
+
+  // Reads and decodes the chunk described by `info`. Thread-safe.
+  Status ReadChunk(const experimental::SnapshotChunkInfo& info,
+                   std::vector<std::vector<Tensor>>* elements) const;
+
+  const std::string filename_;
+  const string compression_type_;
+  const DataTypeVector dtypes_;
+
+  std::unique_ptr<RandomAccessFile> file_;
+  experimental::SnapshotChunkIndex index_;
+  // Index of the next chunk to schedule a read for.
+  int next_chunk_ = 0;
+  std::deque<std::shared_ptr<Chunk>> pending_;
+  std::shared_ptr<Chunk> current_;
+  // Index of the next element of `current_` to be returned.
+  int64 position_ = 0;
+
+  // This has to be last, so that the pool, whose destructor waits for the
+  // scheduled reads to finish, is destroyed before the state they access.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+};
+
 // Writes snapshot metadata to the given directory.
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata);
@@ -89,6 +89,65 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kNone, 2);
   SnapshotRoundTrip(io::compression::kGzip, 2);
   SnapshotRoundTrip(io::compression::kSnappy, 2);
+
+  SnapshotRoundTrip(io::compression::kNone, 3);
+  SnapshotRoundTrip(io::compression::kSnappy, 3);
+}
+
+TEST(SnapshotUtilTest, ChunkedRejectsGzip) {
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      Writer::Create(Env::Default(), filename, io::compression::kGzip, 3,
+                     {DT_FLOAT}, &writer)));
+}
+
+void ChunkedSkipRecords(std::string compression_type) {
+  // Each element has about 1 MiB, so the file consists of several chunks.
+  constexpr int kNumElements = 20;
+  const DataTypeVector dtypes = {DT_FLOAT, DT_STRING};
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename, compression_type, 3,
+                              dtypes, &writer));
+  for (int i = 0; i < kNumElements; ++i) {
+    Tensor floats(DT_FLOAT, TensorShape({256, 1024}));
+    floats.flat<float>().setConstant(i);
+    Tensor str(strings::StrCat("element ", i));
+    TF_ASSERT_OK(writer->WriteTensors({floats, str}));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, compression_type, 3,
+                              dtypes, &reader));
+  int i = 0;
+  for (int num_skipped : {0, 1, 7, 2}) {
+    TF_ASSERT_OK(reader->SkipRecords(num_skipped));
+    i += num_skipped;
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    ASSERT_EQ(read_tensors.size(), 2);
+    EXPECT_EQ(read_tensors[0].shape(), TensorShape({256, 1024}));
+    EXPECT_EQ(read_tensors[0].flat<float>()(0), i);
+    EXPECT_EQ(read_tensors[0].flat<float>()(256 * 1024 - 1), i);
+    EXPECT_EQ(read_tensors[1].scalar<tstring>()(),
+              strings::StrCat("element ", i));
+    ++i;
+  }
+  TF_ASSERT_OK(reader->SkipRecords(kNumElements - i));
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, ChunkedSkipRecords) {
+  ChunkedSkipRecords(io::compression::kNone);
+  ChunkedSkipRecords(io::compression::kSnappy);
 }
 
 void SnapshotReaderBenchmarkLoop(int iters, std::string compression_type,
@@ -149,7 +208,17 @@ BENCHMARK(SnapshotCustomReaderNoneBenchmark);
 BENCHMARK(SnapshotCustomReaderGzipBenchmark);
 BENCHMARK(SnapshotCustomReaderSnappyBenchmark);
 BENCHMARK(SnapshotTFRecordReaderNoneBenchmark);
+void SnapshotChunkedReaderNoneBenchmark(int iters) {
+  SnapshotReaderBenchmarkLoop(iters, io::compression::kNone, 3);
+}
+
+void SnapshotChunkedReaderSnappyBenchmark(int iters) {
+  SnapshotReaderBenchmarkLoop(iters, io::compression::kSnappy, 3);
+}
+
 BENCHMARK(SnapshotTFRecordReaderGzipBenchmark);
+BENCHMARK(SnapshotChunkedReaderNoneBenchmark);
+BENCHMARK(SnapshotChunkedReaderSnappyBenchmark);
 
 void SnapshotWriterBenchmarkLoop(int iters, std::string compression_type,
                                  int version) {
@@ -38,7 +38,8 @@ namespace sql {
 // `QueryConnection` would then be renamed simply `Connection`.
 //
 // This class is not thread safe. Access to it is guarded by a mutex in
-// `SqlDatasetOp::Dataset::Iterator`.
+// `SqlDatasetOp::Dataset::Iterator`, or it is only used by the thread reading
+// its partition of the query in `SqlDatasetOp::Dataset::ParallelIterator`.
 class QueryConnection {
  public:
   virtual ~QueryConnection() {}
@@ -63,6 +64,15 @@ class QueryConnection {
   // undefined.
   virtual Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
+  // Retrieves up to `batch_size` next rows of the result set of the query
+  // from the most recent call to `Open()`.
+  //
+  // The rows are stored in `*out_tensors`, one vector per column, and their
+  // number in `*num_rows`. Fewer than `batch_size` rows are retrieved only
+  // at the end of the result set.
+  virtual Status GetNextBatch(IteratorContext* ctx, int64 batch_size,
+                              std::vector<Tensor>* out_tensors,
+                              int64* num_rows) = 0;
 };
 
 }  // namespace sql
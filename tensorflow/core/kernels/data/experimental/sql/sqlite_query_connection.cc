@@ -60,7 +60,36 @@ Status SqliteQueryConnection::GetNext(IteratorContext* ctx,
       DataType dt = output_types_[i];
       // TODO(mrry): Pass in the `IteratorContext::allocator()`.
       out_tensors->emplace_back(ctx->allocator({}), dt, TensorShape({}));
-      FillTensorWithResultSetEntry(dt, i, &out_tensors->back());
+      FillTensorWithResultSetEntry(dt, i, 0, &out_tensors->back());
+    }
+  }
+  return Status::OK();
+}
+
+Status SqliteQueryConnection::GetNextBatch(IteratorContext* ctx,
+                                           int64 batch_size,
+                                           std::vector<Tensor>* out_tensors,
+                                           int64* num_rows) {
+  if (!stmt_) TF_RETURN_IF_ERROR(PrepareQuery());
+  out_tensors->clear();
+  for (int i = 0; i < column_count_; i++) {
+    out_tensors->emplace_back(ctx->allocator({}), output_types_[i],
+                              TensorShape({batch_size}));
+  }
+  *num_rows = 0;
+  bool end_of_sequence = false;
+  while (*num_rows < batch_size) {
+    TF_RETURN_IF_ERROR(stmt_.Step(&end_of_sequence));
+    if (end_of_sequence) break;
+    for (int i = 0; i < column_count_; i++) {
+      FillTensorWithResultSetEntry(output_types_[i], i, *num_rows,
+                                   &(*out_tensors)[i]);
+    }
+    ++*num_rows;
+  }
+  if (*num_rows < batch_size) {
+    for (Tensor& tensor : *out_tensors) {
+      tensor = tensor.Slice(0, *num_rows);
     }
   }
   return Status::OK();
@@ -81,10 +110,10 @@ Status SqliteQueryConnection::PrepareQuery() {
 }
 
 void SqliteQueryConnection::FillTensorWithResultSetEntry(
-    const DataType& data_type, int column_index, Tensor* tensor) {
-#define CASE(T, M)                                                 \
-  case DataTypeToEnum<T>::value:                                   \
-    tensor->scalar<T>()() = static_cast<T>(stmt_.M(column_index)); \
+    const DataType& data_type, int column_index, int64 index, Tensor* tensor) {
+#define CASE(T, M)                                                    \
+  case DataTypeToEnum<T>::value:                                      \
+    tensor->flat<T>()(index) = static_cast<T>(stmt_.M(column_index)); \
     break;
 #define INT_CASE(T) CASE(T, ColumnInt)
 #define DOUBLE_CASE(T) CASE(T, ColumnDouble)
@@ -103,7 +132,7 @@ void SqliteQueryConnection::FillTensorWithResultSetEntry(
     TF_CALL_double(DOUBLE_CASE)
     TF_CALL_tstring(STRING_CASE)
     case DT_BOOL:
-      tensor->scalar<bool>()() = stmt_.ColumnInt(column_index) != 0;
+      tensor->flat<bool>()(index) = stmt_.ColumnInt(column_index) != 0;
       break;
     // Error preemptively thrown by SqlDatasetOp::MakeDataset in this case.
     default:
@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <deque>
 #include <utility>
 
 #include "tensorflow/core/framework/dataset.h"
@@ -22,17 +24,73 @@ limitations under the License.
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/util/batch_util.h"
 
 namespace tensorflow {
 namespace data {
 namespace experimental {
 namespace {
 
+constexpr char kPartitionColumn[] = "partition_column";
+constexpr char kNumPartitions[] = "num_partitions";
+constexpr char kBatchSize[] = "batch_size";
+
+// The number of rows fetched at once when the rows are emitted one at a time.
+constexpr int64 kDefaultFetchSize = 256;
+// The number of batches of rows each partition reads ahead.
+constexpr int64 kMaxBufferedBatches = 2;
+
+// Returns the queries reading `num_partitions` ranges of the values of the
+// integer column `partition_column` of the result of `query`, which are in
+// [min_value, max_value]. The rows where it is NULL are read by the first
+// query.
+std::vector<string> PartitionQueries(const string& query,
+                                     const string& partition_column,
+                                     int64 num_partitions, int64 min_value,
+                                     int64 max_value) {
+  const uint64 range =
+      static_cast<uint64>(max_value) - static_cast<uint64>(min_value);
+  const uint64 width = range / num_partitions + 1;
+  // Returns the first value of partition i; the later ones may be empty.
+  auto lower_bound = [&](int64 i) {
+    return static_cast<int64>(static_cast<uint64>(min_value) +
+                              std::min<uint64>(i * width, range));
+  };
+  std::vector<string> queries;
+  for (int64 i = 0; i < num_partitions; ++i) {
+    string condition;
+    if (i == 0) {
+      condition = strings::StrCat(partition_column, " < ", lower_bound(1),
+                                  " OR ", partition_column, " IS NULL");
+    } else if (i == num_partitions - 1) {
+      condition = strings::StrCat(partition_column, " >= ", lower_bound(i));
+    } else {
+      condition = strings::StrCat(partition_column, " >= ", lower_bound(i),
+                                  " AND ", partition_column, " < ",
+                                  lower_bound(i + 1));
+    }
+    queries.push_back(
+        strings::StrCat("SELECT * FROM (", query, ") WHERE ", condition));
+  }
+  return queries;
+}
+
 class SqlDatasetOp : public DatasetOpKernel {
  public:
   explicit SqlDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    // `ExperimentalSqlDataset` does not have the attributes of the parallel
+    // mode.
+    if (ctx->HasAttr(kPartitionColumn)) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kPartitionColumn, &partition_column_));
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kNumPartitions, &num_partitions_));
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kBatchSize, &batch_size_));
+    }
+    OP_REQUIRES(ctx, num_partitions_ == 1 || !partition_column_.empty(),
+                errors::InvalidArgument(
+                    "`partition_column` is required to read the query in ",
+                    num_partitions_, " partitions."));
     for (const DataType& dt : output_types_) {
       OP_REQUIRES(ctx,
                   dt == DT_STRING || dt == DT_INT8 || dt == DT_INT16 ||
@@ -44,9 +102,16 @@ class SqlDatasetOp : public DatasetOpKernel {
                       "DT_UINT8, DT_UINT16, DT_BOOL, DT_DOUBLE "));
     }
     for (const PartialTensorShape& pts : output_shapes_) {
-      OP_REQUIRES(ctx, pts.dims() == 0,
-                  errors::InvalidArgument(
-                      "Each element of `output_shapes_` must be a scalar."));
+      if (batch_size_ > 0) {
+        OP_REQUIRES(ctx, pts.dims() == 1,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a vector "
+                        "when `batch_size` is set."));
+      } else {
+        OP_REQUIRES(ctx, pts.dims() == 0,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a scalar."));
+      }
     }
   }
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
@@ -70,7 +135,8 @@ class SqlDatasetOp : public DatasetOpKernel {
                     driver_name.c_str())));
 
     *output = new Dataset(ctx, driver_name, data_source_name, query,
-                          output_types_, output_shapes_);
+                          output_types_, output_shapes_, partition_column_,
+                          num_partitions_, batch_size_);
   }
 
  private:
@@ -79,16 +145,25 @@ class SqlDatasetOp : public DatasetOpKernel {
     Dataset(OpKernelContext* ctx, const string& driver_name,
             const string& data_source_name, const string& query,
             const DataTypeVector& output_types,
-            const std::vector<PartialTensorShape>& output_shapes)
+            const std::vector<PartialTensorShape>& output_shapes,
+            const string& partition_column, int64 num_partitions,
+            int64 batch_size)
         : DatasetBase(DatasetContext(ctx)),
           driver_name_(driver_name),
           data_source_name_(data_source_name),
           query_(query),
           output_types_(output_types),
-          output_shapes_(output_shapes) {}
+          output_shapes_(output_shapes),
+          partition_column_(partition_column),
+          num_partitions_(num_partitions),
+          batch_size_(batch_size) {}
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
         const string& prefix) const override {
+      if (num_partitions_ > 1 || batch_size_ > 0) {
+        return absl::make_unique<ParallelIterator>(ParallelIterator::Params{
+            this, strings::StrCat(prefix, "::ParallelSql")});
+      }
       return absl::make_unique<Iterator>(
           Iterator::Params{this, strings::StrCat(prefix, "::Sql")});
     }
@@ -121,8 +196,23 @@ class SqlDatasetOp : public DatasetOpKernel {
           b->AddScalar(data_source_name_, &data_source_name_node));
       Node* query_node;
       TF_RETURN_IF_ERROR(b->AddScalar(query_, &query_node));
+      // The attributes are only added when set, since
+      // `ExperimentalSqlDataset` does not have them.
+      std::vector<std::pair<StringPiece, AttrValue>> attrs;
+      if (num_partitions_ > 1 || batch_size_ > 0) {
+        AttrValue partition_column;
+        b->BuildAttrValue(partition_column_, &partition_column);
+        AttrValue num_partitions;
+        b->BuildAttrValue(num_partitions_, &num_partitions);
+        AttrValue batch_size;
+        b->BuildAttrValue(batch_size_, &batch_size);
+        attrs = {{kPartitionColumn, partition_column},
+                 {kNumPartitions, num_partitions},
+                 {kBatchSize, batch_size}};
+      }
       TF_RETURN_IF_ERROR(b->AddDataset(
-          this, {driver_name_node, data_source_name_node, query_node}, output));
+          this, {driver_name_node, data_source_name_node, query_node}, attrs,
+          output));
       return Status::OK();
     }
 
@@ -220,14 +310,292 @@ class SqlDatasetOp : public DatasetOpKernel {
       bool query_connection_initialized_ TF_GUARDED_BY(mu_) = false;
       bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
     };
+
+    // Reads the rows in batches, and, if `num_partitions_` > 1, splits the
+    // query in ranges of `partition_column_` read concurrently by a thread
+    // and a connection each. The batches of the partitions are emitted in
+    // turn, which keeps the order of the rows deterministic.
+    class ParallelIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit ParallelIterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~ParallelIterator() override { CancelThreads(); }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (!initialized_) TF_RETURN_IF_ERROR(InitializeLocked(ctx));
+        next_calls_++;
+        return GetNextLocked(ctx, out_tensors, end_of_sequence, &l);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (initialized_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("next_calls"), next_calls_));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        CancelThreads();
+        mutex_lock l(mu_);
+        cancelled_ = false;
+        initialized_ = false;
+        next_calls_ = 0;
+        if (reader->Contains(full_name("next_calls"))) {
+          // As in `Iterator`, the rows are read again and dropped.
+          int64 next_calls;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("next_calls"), &next_calls));
+          TF_RETURN_IF_ERROR(InitializeLocked(ctx));
+          std::vector<Tensor> out_tensors;
+          bool end_of_sequence = false;
+          for (next_calls_ = 0; next_calls_ < next_calls; ++next_calls_) {
+            TF_RETURN_IF_ERROR(
+                GetNextLocked(ctx, &out_tensors, &end_of_sequence, &l));
+            out_tensors.clear();
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      struct Partition {
+        std::unique_ptr<sql::QueryConnection> connection;
+        // The batches read ahead, one tensor per column.
+        std::deque<std::vector<Tensor>> batches;
+        // Whether the thread reading the partition is done, with `status`.
+        bool done = false;
+        Status status;
+      };
+
+      int64 fetch_size() const {
+        return dataset()->batch_size_ > 0 ? dataset()->batch_size_
+                                          : kDefaultFetchSize;
+      }
+
+      // Opens the connections of the partitions and starts their threads.
+      Status InitializeLocked(IteratorContext* ctx)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::vector<string> queries = {dataset()->query_};
+        if (dataset()->num_partitions_ > 1) {
+          int64 min_value;
+          int64 max_value;
+          TF_RETURN_IF_ERROR(
+              GetPartitionColumnRange(ctx, &min_value, &max_value));
+          queries = PartitionQueries(
+              dataset()->query_, dataset()->partition_column_,
+              dataset()->num_partitions_, min_value, max_value);
+        }
+        partitions_.clear();
+        for (const string& query : queries) {
+          partitions_.push_back(absl::make_unique<Partition>());
+          Partition* partition = partitions_.back().get();
+          partition->connection = sql::DriverManager::CreateQueryConnection(
+              dataset()->driver_name_);
+          Status s = partition->connection->Open(
+              dataset()->data_source_name_, query, dataset()->output_types_);
+          if (!s.ok()) {
+            LOG(WARNING) << "Failed to connect to database: " << s;
+            partitions_.pop_back();
+            for (auto& opened : partitions_) {
+              opened->connection->Close().IgnoreError();
+            }
+            partitions_.clear();
+            return s;
+          }
+        }
+        initialized_ = true;
+        next_partition_ = 0;
+        batch_.clear();
+        batch_rows_ = 0;
+        next_row_ = 0;
+        std::shared_ptr<IteratorContext> new_ctx =
+            std::make_shared<IteratorContext>(*ctx);
+        for (auto& partition : partitions_) {
+          Partition* p = partition.get();
+          threads_.push_back(ctx->StartThread(
+              "tf_data_sql_partition",
+              [this, new_ctx, p]() { PartitionThread(new_ctx, p); }));
+        }
+        return Status::OK();
+      }
+
+      // Reads the smallest and the largest value of the partition column.
+      Status GetPartitionColumnRange(IteratorContext* ctx, int64* min_value,
+                                     int64* max_value) {
+        std::unique_ptr<sql::QueryConnection> connection =
+            sql::DriverManager::CreateQueryConnection(
+                dataset()->driver_name_);
+        const string& column = dataset()->partition_column_;
+        TF_RETURN_IF_ERROR(connection->Open(
+            dataset()->data_source_name_,
+            strings::StrCat("SELECT MIN(", column, "), MAX(", column,
+                            ") FROM (", dataset()->query_, ")"),
+            {DT_INT64, DT_INT64}));
+        std::vector<Tensor> range;
+        bool end_of_sequence = false;
+        Status s = connection->GetNext(ctx, &range, &end_of_sequence);
+        connection->Close().IgnoreError();
+        TF_RETURN_IF_ERROR(s);
+        if (end_of_sequence) {
+          return errors::Internal("Failed to read the range of ", column);
+        }
+        *min_value = range[0].scalar<int64>()();
+        *max_value = range[1].scalar<int64>()();
+        return Status::OK();
+      }
+
+      // Reads the batches of `partition` ahead of GetNext().
+      void PartitionThread(const std::shared_ptr<IteratorContext>& ctx,
+                           Partition* partition) {
+        const int64 batch_size = fetch_size();
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ &&
+                   partition->batches.size() >= kMaxBufferedBatches) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) return;
+          }
+          // The connection is only used by this thread.
+          std::vector<Tensor> batch;
+          int64 num_rows = 0;
+          Status s = partition->connection->GetNextBatch(
+              ctx.get(), batch_size, &batch, &num_rows);
+          mutex_lock l(mu_);
+          if (s.ok() && num_rows > 0) {
+            partition->batches.push_back(std::move(batch));
+          }
+          if (!s.ok() || num_rows < batch_size) {
+            partition->done = true;
+            partition->status = s;
+          }
+          cond_var_.notify_all();
+          if (partition->done) return;
+        }
+      }
+
+      // Waits with `l`, which holds `mu_`, for the batches of the partitions.
+      Status GetNextLocked(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence, mutex_lock* l)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (true) {
+          if (dataset()->batch_size_ == 0 && next_row_ < batch_rows_) {
+            // Emits the rows of the current batch one at a time.
+            out_tensors->clear();
+            for (const Tensor& column : batch_) {
+              out_tensors->emplace_back(ctx->allocator({}), column.dtype(),
+                                        TensorShape({}));
+              TF_RETURN_IF_ERROR(batch_util::CopySliceToElement(
+                  column, &out_tensors->back(), next_row_));
+            }
+            next_row_++;
+            *end_of_sequence = false;
+            return Status::OK();
+          }
+          // Takes the next batch from the partitions in turn, skipping those
+          // done.
+          int64 num_done = 0;
+          Partition* partition = nullptr;
+          while (partition == nullptr &&
+                 num_done < static_cast<int64>(partitions_.size())) {
+            Partition* candidate = partitions_[next_partition_].get();
+            while (!cancelled_ && candidate->batches.empty() &&
+                   !candidate->done) {
+              cond_var_.wait(*l);
+            }
+            if (cancelled_) return errors::Cancelled("Iterator was cancelled");
+            next_partition_ = (next_partition_ + 1) % partitions_.size();
+            if (!candidate->batches.empty()) {
+              partition = candidate;
+            } else {
+              TF_RETURN_IF_ERROR(candidate->status);
+              num_done++;
+            }
+          }
+          if (partition == nullptr) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          std::vector<Tensor> batch = std::move(partition->batches.front());
+          partition->batches.pop_front();
+          cond_var_.notify_all();
+          if (dataset()->batch_size_ > 0) {
+            *out_tensors = std::move(batch);
+            *end_of_sequence = false;
+            return Status::OK();
+          }
+          batch_ = std::move(batch);
+          batch_rows_ = batch_[0].dim_size(0);
+          next_row_ = 0;
+        }
+      }
+
+      // Stops the threads of the partitions and closes their connections.
+      void CancelThreads() TF_LOCKS_EXCLUDED(mu_) {
+        std::vector<std::unique_ptr<Thread>> threads;
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+          threads.swap(threads_);
+        }
+        // Joins the threads.
+        threads.clear();
+        mutex_lock l(mu_);
+        for (auto& partition : partitions_) {
+          Status s = partition->connection->Close();
+          if (!s.ok()) {
+            LOG(WARNING) << "Failed to close query connection: " << s;
+          }
+        }
+        partitions_.clear();
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      std::vector<std::unique_ptr<Partition>> partitions_ TF_GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<Thread>> threads_ TF_GUARDED_BY(mu_);
+      // The partition the next batch is taken from.
+      size_t next_partition_ TF_GUARDED_BY(mu_) = 0;
+      // The batch whose rows are emitted one at a time, and the next of them.
+      std::vector<Tensor> batch_ TF_GUARDED_BY(mu_);
+      int64 batch_rows_ TF_GUARDED_BY(mu_) = 0;
+      int64 next_row_ TF_GUARDED_BY(mu_) = 0;
+      int64 next_calls_ TF_GUARDED_BY(mu_) = 0;
+      bool initialized_ TF_GUARDED_BY(mu_) = false;
+      bool cancelled_ TF_GUARDED_BY(mu_) = false;
+    };
+
     const tstring driver_name_;
     const tstring data_source_name_;
     const tstring query_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
+    const string partition_column_;
+    const int64 num_partitions_;
+    const int64 batch_size_;
   };
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
+  string partition_column_;
+  int64 num_partitions_ = 1;
+  int64 batch_size_ = 0;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SqlDataset").Device(DEVICE_CPU), SqlDatasetOp);
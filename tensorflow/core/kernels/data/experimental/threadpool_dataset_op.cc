@@ -14,12 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include <memory>
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -387,10 +389,19 @@ class MaxIntraOpParallelismDatasetOp : public UnaryDatasetOpKernel {
   };
 };
 
+constexpr char kNumaNode[] = "numa_node";
+
 class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit PrivateThreadPoolDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    // `ExperimentalPrivateThreadPoolDataset` does not have the attr.
+    if (ctx->HasAttr(kNumaNode)) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kNumaNode, &numa_node_));
+    }
+    OP_REQUIRES(ctx, numa_node_ >= port::kNUMANoAffinity,
+                errors::InvalidArgument("`numa_node` must be >= -1"));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -399,18 +410,23 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
         ctx, ParseScalarArgument<int64>(ctx, "num_threads", &num_threads));
     OP_REQUIRES(ctx, num_threads >= 1,
                 errors::InvalidArgument("`num_threads` must be >= 1"));
-    *output = new Dataset(ctx, input, num_threads);
+    *output = new Dataset(ctx, input, num_threads, numa_node_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
-    Dataset(OpKernelContext* ctx, const DatasetBase* input, int num_threads)
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, int num_threads,
+            int numa_node)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
-          num_threads_(num_threads) {
+          num_threads_(num_threads),
+          numa_node_(numa_node) {
+      // The threads of the pool bind themselves to `numa_node`.
+      ThreadOptions thread_options;
+      thread_options.numa_node = numa_node;
       thread_pool_ = absl::make_unique<thread::ThreadPool>(
-          ctx->env(), ThreadOptions{}, "data_private_threadpool", num_threads,
+          ctx->env(), thread_options, "data_private_threadpool", num_threads,
           /*low_latency_hint=*/false);
       input_->Ref();
     }
@@ -455,8 +471,11 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
       Node* num_threads_node = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(num_threads_, &num_threads_node));
+      AttrValue numa_node_attr;
+      b->BuildAttrValue(numa_node_, &numa_node_attr);
       TF_RETURN_IF_ERROR(
-          b->AddDataset(this, {input_graph_node, num_threads_node}, output));
+          b->AddDataset(this, {input_graph_node, num_threads_node},
+                        {std::make_pair(kNumaNode, numa_node_attr)}, output));
       return Status::OK();
     }
 
@@ -480,6 +499,15 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           pool->Schedule(std::move(c));
         };
         params.runner_threadpool_size = dataset()->num_threads_;
+        const int numa_node = dataset()->numa_node_;
+        if (numa_node != port::kNUMANoAffinity) {
+          // Allocate the produced elements on the node the threads run on.
+          // Falls back to the default CPU allocator unless NUMA-specific
+          // allocators have been enabled for the process.
+          params.allocator_getter = [numa_node](AllocatorAttributes attrs) {
+            return cpu_allocator(numa_node);
+          };
+        }
         mutex_lock l(mu_);
         return input_impl_->GetNext(IteratorContext{std::move(params)},
                                     out_tensors, end_of_sequence);
@@ -514,8 +542,11 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
 
     const DatasetBase* const input_;
     const int64 num_threads_;
+    const int numa_node_;
     std::unique_ptr<thread::ThreadPool> thread_pool_;
   };
+
+  int numa_node_ = port::kNUMANoAffinity;
 };
 
 REGISTER_KERNEL_BUILDER(Name("MaxIntraOpParallelismDataset").Device(DEVICE_CPU),
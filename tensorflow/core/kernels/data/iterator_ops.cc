@@ -50,6 +50,7 @@ limitations under the License.
 #include "tensorflow/core/platform/resource.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -64,6 +65,46 @@ const char kIteratorVariantTypeName[] = "tensorflow::Iterator";
 const char kOutputShapes[] = "output_shapes";
 const char kOutputTypes[] = "output_types";
 
+// Returns how many bytes of freed element buffers each iterator may cache for
+// reuse, as set by TF_DATA_RECYCLED_BUFFERS_MB. Defaults to 0, i.e. elements
+// are allocated from the device allocator.
+int64 MaxRecycledBufferBytes() {
+  static const int64 max_bytes = [] {
+    int64 mb;
+    Status s = ReadInt64FromEnvVar("TF_DATA_RECYCLED_BUFFERS_MB", 0, &mb);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      return int64{0};
+    }
+    return mb << 20;
+  }();
+  return max_bytes;
+}
+
+// Creates the allocator of the elements of a new iterator, if buffers are to
+// be recycled.
+RecyclingAllocator* MaybeCreateElementAllocator(
+    OpKernelContext* ctx, const IteratorContext::Params& params) {
+  if (MaxRecycledBufferBytes() <= 0 ||
+      ctx->device()->attributes().device_type() != DEVICE_CPU) {
+    return nullptr;
+  }
+  return new RecyclingAllocator(params.allocator_getter(AllocatorAttributes()),
+                                MaxRecycledBufferBytes());
+}
+
+// Makes the default allocations of an iterator use `element_allocator`.
+void UseElementAllocator(RecyclingAllocator* element_allocator,
+                         IteratorContext::Params* params) {
+  if (element_allocator == nullptr) return;
+  params->allocator_getter =
+      [element_allocator, getter = std::move(params->allocator_getter)](
+          AllocatorAttributes attrs) -> Allocator* {
+    if (attrs.value == 0) return element_allocator;
+    return getter(attrs);
+  };
+}
+
 }  // namespace
 
 /* static */ constexpr const char* const
@@ -85,6 +126,7 @@ Status IteratorResource::GetNext(OpKernelContext* ctx,
     params.thread_factory = unbounded_thread_pool_.get_thread_factory();
     params.thread_pool = &unbounded_thread_pool_;
     params.cancellation_manager = &captured_state->cancellation_manager;
+    UseElementAllocator(captured_state->element_allocator, &params);
     std::function<void()> deregister_fn;
     TF_RETURN_IF_ERROR(RegisterCancellationCallback(
         ctx->cancellation_manager(),
@@ -152,6 +194,8 @@ Status IteratorResource::Restore(OpKernelContext* ctx,
   params.thread_factory = unbounded_thread_pool_.get_thread_factory();
   params.thread_pool = &unbounded_thread_pool_;
   params.cancellation_manager = &new_state->cancellation_manager;
+  new_state->element_allocator = MaybeCreateElementAllocator(ctx, params);
+  UseElementAllocator(new_state->element_allocator, &params);
   std::function<void()> deregister_fn;
   TF_RETURN_IF_ERROR(RegisterCancellationCallback(
       ctx->cancellation_manager(),
@@ -186,6 +230,8 @@ Status IteratorResource::SetIteratorFromDataset(OpKernelContext* ctx,
   params.thread_factory = unbounded_thread_pool_.get_thread_factory();
   params.thread_pool = &unbounded_thread_pool_;
   params.cancellation_manager = &new_state->cancellation_manager;
+  new_state->element_allocator = MaybeCreateElementAllocator(ctx, params);
+  UseElementAllocator(new_state->element_allocator, &params);
   std::function<void()> deregister_fn;
   TF_RETURN_IF_ERROR(RegisterCancellationCallback(
       ctx->cancellation_manager(),
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/recycling_allocator.h"
 #include "tensorflow/core/kernels/data/unbounded_thread_pool.h"
 #include "tensorflow/core/kernels/ops_util.h"
 
@@ -95,7 +96,10 @@ class IteratorResource : public ResourceBase {
           iterator(std::move(iterator)),
           last_get_next_end_time_us(0) {}
 
-    ~State() { cancellation_manager.StartCancel(); }
+    ~State() {
+      cancellation_manager.StartCancel();
+      if (element_allocator) element_allocator->Release();
+    }
 
     // Downcasts the given `IteratorBase` to a `DatasetBaseIterator`, and uses
     // it to set the `iterator` field.
@@ -111,6 +115,10 @@ class IteratorResource : public ResourceBase {
     CancellationManager cancellation_manager;
     std::unique_ptr<DatasetBaseIterator> iterator;
     uint64 last_get_next_end_time_us;
+    // If set, the iterator allocates its elements from `element_allocator`,
+    // which recycles the buffers freed by their consumers. Released, not
+    // deleted, by the state.
+    RecyclingAllocator* element_allocator = nullptr;
   };
 
   // For thread-local record-keeping state
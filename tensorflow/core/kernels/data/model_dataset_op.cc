@@ -17,13 +17,19 @@ limitations under the License.
 // On mobile we do not provide model dataset op because not all of its
 // dependencies are available there. The op is replaced with a no-op.
 #if !defined(IS_MOBILE_PLATFORM)
+#include <atomic>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/stats_utils.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -33,6 +39,9 @@ namespace {
 
 constexpr int64 kOptimizationPeriodThresholdMs = 60 * EnvTime::kSecondsToMillis;
 
+// The ID of the next pipeline, which labels its live stats.
+std::atomic<int64> next_pipeline_id(0);
+
 // Default share of available RAM that can be used by model's internal buffers.
 constexpr double kRamBudgetShare = 0.5;
 
@@ -115,7 +124,8 @@ class ModelDatasetOp::Dataset : public DatasetBase {
                                                   : dataset()->cpu_budget_),
           ram_budget_(dataset()->ram_budget_ == 0
                           ? kRamBudgetShare * port::AvailableRam()
-                          : dataset()->ram_budget_) {
+                          : dataset()->ram_budget_),
+          pipeline_name_(strings::StrCat(next_pipeline_id++)) {
       model_ = std::make_shared<model::Model>();
     }
 
@@ -145,11 +155,14 @@ class ModelDatasetOp::Dataset : public DatasetBase {
         int64 now_nanos = EnvTime::NowNanos();
         RecordInput(now_nanos);
       }
+      const int64 start_nanos = EnvTime::NowNanos();
       Status s = input_impl_->GetNext(IteratorContext(std::move(params)),
                                       out_tensors, end_of_sequence);
       int64 now_nanos = EnvTime::NowNanos();
       mutex_lock l(mu_);
       RecordOutput(now_nanos);
+      wait_time_ += now_nanos - start_nanos;
+      num_wait_events_++;
       return s;
     }
 
@@ -189,6 +202,7 @@ class ModelDatasetOp::Dataset : public DatasetBase {
     void ModelThread(const std::shared_ptr<IteratorContext>& ctx) {
       int64 last_optimization_ms = 0;
       int64 optimization_period_ms = 10;
+      int64 num_optimizations = 0;
       int64 current_time_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
       while (true) {
         {
@@ -210,6 +224,8 @@ class ModelDatasetOp::Dataset : public DatasetBase {
         }
         model_->Optimize(dataset()->algorithm_, cpu_budget_, ram_budget_,
                          /*model_input_time=*/0);
+        RecordBufferedBytesStats(ctx.get(), ++num_optimizations);
+        RecordPipelineStats();
         // Exponentially increase the period of running the optimization
         // until a threshold is reached.
         if (optimization_period_ms != kOptimizationPeriodThresholdMs) {
@@ -222,6 +238,73 @@ class ModelDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Exports the buffer limit chosen for each node of the model.
+    void RecordBufferedBytesStats(IteratorContext* ctx, int64 step) {
+      const auto& stats_aggregator = ctx->stats_aggregator();
+      if (!stats_aggregator) {
+        return;
+      }
+      for (const auto& pair : model_->MaximumBufferedBytesPerNode()) {
+        stats_aggregator->AddScalar(
+            stats_utils::MaximumBufferedBytesScalarName(pair.first),
+            static_cast<float>(pair.second), step);
+      }
+    }
+
+    // Exports the activity of each stage of the pipeline since the previous
+    // call, the time the consumer waited for elements, and the bottleneck: the
+    // stage which spent the most time, given its parallelism, to produce the
+    // elements consumed in the interval.
+    void RecordPipelineStats() TF_LOCKS_EXCLUDED(mu_) {
+      const int64 now_nanos = EnvTime::NowNanos();
+      const double interval_secs =
+          static_cast<double>(now_nanos - last_stats_time_nanos_) /
+          EnvTime::kSecondsToNanos;
+      absl::flat_hash_map<string, model::Node::Stats> stats;
+      string bottleneck;
+      double bottleneck_time = 0;
+      for (auto& node_stats : model_->StatsPerNode()) {
+        const model::Node::Stats* last =
+            gtl::FindOrNull(last_stats_, node_stats.long_name);
+        const int64 num_elements =
+            node_stats.num_elements - (last ? last->num_elements : 0);
+        const int64 processing_time =
+            node_stats.processing_time - (last ? last->processing_time : 0);
+        const double processing_time_per_element =
+            num_elements > 0 ? static_cast<double>(processing_time) /
+                                   static_cast<double>(num_elements)
+                             : 0;
+        metrics::RecordTFDataStageStats(
+            pipeline_name_, node_stats.long_name,
+            static_cast<int64>(num_elements / interval_secs),
+            static_cast<int64>(processing_time_per_element /
+                               EnvTime::kMicrosToNanos),
+            node_stats.buffer_utilization < 0
+                ? -1
+                : static_cast<int64>(100 * node_stats.buffer_utilization));
+        const double time = processing_time / node_stats.parallelism;
+        if (time > bottleneck_time) {
+          bottleneck = node_stats.long_name;
+          bottleneck_time = time;
+        }
+        stats[node_stats.long_name] = std::move(node_stats);
+      }
+      int64 wait_time_us = 0;
+      {
+        mutex_lock l(mu_);
+        if (num_wait_events_ > 0) {
+          wait_time_us =
+              wait_time_ / num_wait_events_ / EnvTime::kMicrosToNanos;
+        }
+        wait_time_ = 0;
+        num_wait_events_ = 0;
+      }
+      metrics::RecordTFDataPipelineStats(pipeline_name_, wait_time_us,
+                                         bottleneck);
+      last_stats_ = std::move(stats);
+      last_stats_time_nanos_ = now_nanos;
+    }
+
     void RecordInput(int64 time_nanos) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (last_output_time_ != 0) {
         DCHECK_LE(last_output_time_, time_nanos);
@@ -251,8 +334,18 @@ class ModelDatasetOp::Dataset : public DatasetBase {
     int64 num_input_events_ TF_GUARDED_BY(mu_) = 0;
     int64 input_time_ TF_GUARDED_BY(mu_) = 0;
     int64 last_output_time_ TF_GUARDED_BY(mu_) = 0;
+    // The time spent in, and the number of, the calls to `GetNext()` since
+    // the last call to `RecordPipelineStats()`.
+    int64 wait_time_ TF_GUARDED_BY(mu_) = 0;
+    int64 num_wait_events_ TF_GUARDED_BY(mu_) = 0;
+    // The stats of the model nodes at the last call to `RecordPipelineStats()`,
+    // only accessed by the model thread.
+    absl::flat_hash_map<string, model::Node::Stats> last_stats_;
+    int64 last_stats_time_nanos_ = EnvTime::NowNanos();
     const int64 cpu_budget_;
     const int64 ram_budget_;
+    // Labels the live stats of the pipeline.
+    const string pipeline_name_;
   };
 
   const DatasetBase* input_;
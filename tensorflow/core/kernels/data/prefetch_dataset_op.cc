@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include <cstring>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/metrics.h"
@@ -45,6 +46,7 @@ namespace data {
 /* static */ constexpr const char* const PrefetchDatasetOp::kOutputShapes;
 /* static */ constexpr const char* const PrefetchDatasetOp::kSlackPeriod;
 /* static */ constexpr const char* const PrefetchDatasetOp::kLegacyAutotune;
+/* static */ constexpr const char* const PrefetchDatasetOp::kPinHostMemory;
 
 // Determines the fraction of slack time by which to delay prefetching of data.
 constexpr double kSleepFactor = 0.2;
@@ -57,12 +59,13 @@ constexpr char kErrorMessageSuffix[] = ".error_message";
 class PrefetchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
-          int64 slack_period, bool legacy_autotune)
+          int64 slack_period, bool legacy_autotune, bool pin_host_memory)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
-        legacy_autotune_(legacy_autotune) {
+        legacy_autotune_(legacy_autotune),
+        pin_host_memory_(pin_host_memory) {
     input_->Ref();
   }
 
@@ -109,10 +112,13 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(slack_period_, &slack_period_attr);
     AttrValue legacy_autotune_attr;
     b->BuildAttrValue(legacy_autotune_, &legacy_autotune_attr);
+    AttrValue pin_host_memory_attr;
+    b->BuildAttrValue(pin_host_memory_, &pin_host_memory_attr);
     TF_RETURN_IF_ERROR(
         b->AddDataset(this, {input_graph_node, buffer_size},
                       {std::make_pair(kSlackPeriod, slack_period_attr),
-                       std::make_pair(kLegacyAutotune, legacy_autotune_attr)},
+                       std::make_pair(kLegacyAutotune, legacy_autotune_attr),
+                       std::make_pair(kPinHostMemory, pin_host_memory_attr)},
                       output));
     return Status::OK();
   }
@@ -219,15 +225,23 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
 
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
-      // Acquire both locks to ensure that the prefetch thread and
-      // all GetNext threads are blocked.
-      mutex_lock input_l(input_mu_);
-      mutex_lock l(*mu_);
-      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      std::vector<BufferElement> buffer;
+      {
+        // Acquire both locks to ensure that the prefetch thread and
+        // all GetNext threads are blocked.
+        mutex_lock input_l(input_mu_);
+        mutex_lock l(*mu_);
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+        // The tensors are reference counted: the elements are not copied.
+        buffer.assign(buffer_.begin(), buffer_.end());
+      }
+      // The buffer is written without holding the locks, so that the
+      // prefetch thread and GetNext() are not blocked while it is saved.
       TF_RETURN_IF_ERROR(
-          writer->WriteScalar(prefix(), kBufferSize, buffer_.size()));
-      for (size_t i = 0; i < buffer_.size(); i++) {
-        auto& buffer_element = buffer_[i];
+          writer->WriteScalar(prefix(), kBufferSize, buffer.size()));
+      int64 num_bytes = 0;
+      for (size_t i = 0; i < buffer.size(); i++) {
+        auto& buffer_element = buffer[i];
         TF_RETURN_IF_ERROR(WriteStatus(writer, i, buffer_element.status));
         if (buffer_element.status.ok()) {
           TF_RETURN_IF_ERROR(writer->WriteScalar(
@@ -238,8 +252,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                 absl::StrCat(prefix(), "::", i),
                 absl::StrCat(kBuffer, "[", j, "]"), buffer_element.value[j]));
           }
+          num_bytes += GetTotalBytes(buffer_element.value);
         }
       }
+      metrics::RecordTFDataCheckpointBytes(kDatasetType, "buffer", num_bytes);
       return Status::OK();
     }
 
@@ -453,6 +469,11 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           buffer_element.status = input_impl_->GetNext(
               ctx.get(), &buffer_element.value, &end_of_sequence);
         }
+        if (buffer_element.status.ok() && !end_of_sequence &&
+            dataset()->pin_host_memory_) {
+          buffer_element.status =
+              CopyToPinnedMemory(ctx.get(), &buffer_element.value);
+        }
         if (buffer_element.status.ok() && end_of_sequence) {
           mutex_lock l(*mu_);
           prefetch_thread_finished_ = true;
@@ -473,8 +494,41 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Moves the components of `element` that can be copied with memcpy to
+    // GPU-compatible (pinned) host memory. The copy happens in the background
+    // thread, ahead of the consumer, and turns the later host-to-device
+    // transfer of the element (e.g. by `prefetch_to_device` or the executor)
+    // into an asynchronous DMA on the device's host-to-device stream. Without
+    // a GPU there is no pinned memory and the element is left as is.
+    static Status CopyToPinnedMemory(IteratorContext* ctx,
+                                     std::vector<Tensor>* element) {
+      AllocatorAttributes attrs;
+      attrs.set_on_host(true);
+      attrs.set_gpu_compatible(true);
+      Allocator* pinned_allocator = ctx->allocator(attrs);
+      if (pinned_allocator == ctx->allocator({})) {
+        return Status::OK();
+      }
+      for (Tensor& component : *element) {
+        if (!DataTypeCanUseMemcpy(component.dtype()) ||
+            component.TotalBytes() == 0) {
+          continue;
+        }
+        Tensor pinned(pinned_allocator, component.dtype(), component.shape());
+        if (!pinned.IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate ", component.TotalBytes(),
+              " bytes of pinned host memory for a prefetched element.");
+        }
+        std::memcpy(const_cast<char*>(pinned.tensor_data().data()),
+                    component.tensor_data().data(), component.TotalBytes());
+        component = std::move(pinned);
+      }
+      return Status::OK();
+    }
+
     Status WriteStatus(IteratorStateWriter* writer, size_t index,
-                       const Status& status) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+                       const Status& status) {
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(absl::StrCat(prefix(), "::", index), CodeKey(),
                               static_cast<int64>(status.code())));
@@ -547,6 +601,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
   // Determines whether legacy autotuning should be used.
   const bool legacy_autotune_ = true;
 
+  // Determines whether buffered elements are moved to pinned host memory.
+  const bool pin_host_memory_ = false;
+
   TraceMeMetadata traceme_metadata_;
 };
 
@@ -558,6 +615,9 @@ PrefetchDatasetOp::PrefetchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kLegacyAutotune)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kLegacyAutotune, &legacy_autotune_));
   }
+  if (ctx->HasAttr(kPinHostMemory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kPinHostMemory, &pin_host_memory_));
+  }
 }
 
 void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -574,8 +634,8 @@ void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     metrics::RecordTFDataAutotune(kDatasetType);
   }
 
-  *output =
-      new Dataset(ctx, input, buffer_size, slack_period_, legacy_autotune_);
+  *output = new Dataset(ctx, input, buffer_size, slack_period_,
+                        legacy_autotune_, pin_host_memory_);
 }
 
 namespace {
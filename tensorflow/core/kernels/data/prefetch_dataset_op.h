@@ -31,6 +31,7 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kOutputShapes = "output_shapes";
   static constexpr const char* const kSlackPeriod = "slack_period";
   static constexpr const char* const kLegacyAutotune = "legacy_autotune";
+  static constexpr const char* const kPinHostMemory = "pin_host_memory";
 
   explicit PrefetchDatasetOp(OpKernelConstruction* ctx);
 
@@ -42,6 +43,7 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
   class Dataset;
   int64 slack_period_ = 0;
   bool legacy_autotune_ = true;
+  bool pin_host_memory_ = false;
 };
 
 }  // namespace data
@@ -29,13 +29,15 @@ class PrefetchDatasetParams : public DatasetParams {
                         DataTypeVector output_dtypes,
                         std::vector<PartialTensorShape> output_shapes,
                         int64 slack_period, bool legacy_autotune,
-                        int64 buffer_size_min, string node_name)
+                        int64 buffer_size_min, string node_name,
+                        bool pin_host_memory = false)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
         legacy_autotune_(legacy_autotune),
-        buffer_size_min_(buffer_size_min) {
+        buffer_size_min_(buffer_size_min),
+        pin_host_memory_(pin_host_memory) {
     input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
     iterator_prefix_ =
         name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
@@ -61,6 +63,8 @@ class PrefetchDatasetParams : public DatasetParams {
     attr_vector->emplace_back(PrefetchDatasetOp::kLegacyAutotune,
                               legacy_autotune_);
     attr_vector->emplace_back("buffer_size_min", buffer_size_min_);
+    attr_vector->emplace_back(PrefetchDatasetOp::kPinHostMemory,
+                              pin_host_memory_);
     return Status::OK();
   }
 
@@ -73,6 +77,7 @@ class PrefetchDatasetParams : public DatasetParams {
   int64 slack_period_;
   bool legacy_autotune_;
   int64 buffer_size_min_;
+  bool pin_host_memory_;
 };
 
 // Test case 1: positive buffer size.
@@ -177,6 +182,25 @@ PrefetchDatasetParams PrefetchDatasetParams6() {
       /*node_name=*/kNodeName);
 }
 
+// Test case 7: pinned host memory, with a component that cannot be pinned.
+PrefetchDatasetParams PrefetchDatasetParams7() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/
+      {CreateTensor<int64>(TensorShape{3, 1}, {0, 1, 2}),
+       CreateTensor<tstring>(TensorShape{3, 1}, {"a", "b", "c"})},
+      /*node_name=*/"tensor_slice");
+  return PrefetchDatasetParams(
+      /*input_dataset_params=*/tensor_slice_dataset_params,
+      /*buffer_size=*/2,
+      /*output_dtypes=*/{DT_INT64, DT_STRING},
+      /*output_shapes=*/{PartialTensorShape({1}), PartialTensorShape({1})},
+      /*slack_period=*/0,
+      /*legacy_autotune=*/true,
+      /*buffer_size_min=*/0,
+      /*node_name=*/kNodeName,
+      /*pin_host_memory=*/true);
+}
+
 PrefetchDatasetParams InvalidBufferSizePrefetchDatasetParams() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
       /*components=*/{CreateTensor<int64>(TensorShape{10, 1},
@@ -223,7 +247,16 @@ std::vector<GetNextTestCase<PrefetchDatasetParams>> GetNextTestCases() {
        /*expected_outputs=*/
        CreateTensors<int64>(
            TensorShape{1},
-           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})}};
+           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})},
+      {/*dataset_params=*/
+       PrefetchDatasetParams7(),
+       /*expected_outputs=*/
+       {CreateTensor<int64>(TensorShape{1}, {0}),
+        CreateTensor<tstring>(TensorShape{1}, {"a"}),
+        CreateTensor<int64>(TensorShape{1}, {1}),
+        CreateTensor<tstring>(TensorShape{1}, {"b"}),
+        CreateTensor<int64>(TensorShape{1}, {2}),
+        CreateTensor<tstring>(TensorShape{1}, {"c"})}}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
@@ -0,0 +1,103 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/recycling_allocator.h"
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr size_t RecyclingAllocator::kMinRecycledBytes;
+
+RecyclingAllocator::RecyclingAllocator(Allocator* base, size_t max_cached_bytes)
+    : base_(base), max_cached_bytes_(max_cached_bytes) {}
+
+RecyclingAllocator::~RecyclingAllocator() {
+  DCHECK(outstanding_buffers_.empty());
+  DCHECK(free_buffers_.empty());
+}
+
+void* RecyclingAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  size_t size_class = 0;
+  if (num_bytes >= kMinRecycledBytes && alignment <= kAllocatorAlignment) {
+    size_class = (num_bytes + kAllocatorAlignment - 1) / kAllocatorAlignment *
+                 kAllocatorAlignment;
+    mutex_lock l(mu_);
+    DCHECK(!released_);
+    auto it = free_buffers_.find(size_class);
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      void* ptr = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= size_class;
+      outstanding_buffers_.emplace(ptr, size_class);
+      return ptr;
+    }
+  }
+  void* ptr = size_class == 0
+                  ? base_->AllocateRaw(alignment, num_bytes)
+                  : base_->AllocateRaw(kAllocatorAlignment, size_class);
+  if (ptr != nullptr) {
+    mutex_lock l(mu_);
+    outstanding_buffers_.emplace(ptr, size_class);
+  }
+  return ptr;
+}
+
+void RecyclingAllocator::DeallocateRaw(void* ptr) {
+  bool cached = false;
+  bool delete_this = false;
+  {
+    mutex_lock l(mu_);
+    auto it = outstanding_buffers_.find(ptr);
+    DCHECK(it != outstanding_buffers_.end());
+    const size_t size_class = it->second;
+    outstanding_buffers_.erase(it);
+    if (size_class != 0 && !released_ &&
+        cached_bytes_ + size_class <= max_cached_bytes_) {
+      free_buffers_[size_class].push_back(ptr);
+      cached_bytes_ += size_class;
+      cached = true;
+    }
+    delete_this = released_ && outstanding_buffers_.empty();
+  }
+  if (!cached) base_->DeallocateRaw(ptr);
+  if (delete_this) delete this;
+}
+
+void RecyclingAllocator::Release() {
+  absl::flat_hash_map<size_t, std::vector<void*>> free_buffers;
+  bool delete_this;
+  {
+    mutex_lock l(mu_);
+    released_ = true;
+    std::swap(free_buffers, free_buffers_);
+    cached_bytes_ = 0;
+    delete_this = outstanding_buffers_.empty();
+  }
+  for (const auto& size_class_and_buffers : free_buffers) {
+    for (void* ptr : size_class_and_buffers.second) {
+      base_->DeallocateRaw(ptr);
+    }
+  }
+  if (delete_this) delete this;
+}
+
+size_t RecyclingAllocator::cached_bytes() {
+  mutex_lock l(mu_);
+  return cached_bytes_;
+}
+
+}  // namespace data
+}  // namespace tensorflow
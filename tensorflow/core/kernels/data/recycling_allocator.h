@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_RECYCLING_ALLOCATOR_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_RECYCLING_ALLOCATOR_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+// A `RecyclingAllocator` caches the buffers freed by the consumers of the
+// elements of an input pipeline, and hands them out again to the pipeline's
+// next allocations of the same size class. Pipelines tend to allocate the
+// same sizes over and over (e.g. the tensors of batches of a fixed shape), so
+// most allocations are then served without going to the underlying allocator.
+//
+// Buffers may be freed after the pipeline is gone, so the allocator is not
+// deleted directly: `Release()` stops the caching, and the allocator deletes
+// itself once all its buffers have been freed.
+class RecyclingAllocator : public Allocator {
+ public:
+  // Buffers smaller than this are not cached.
+  static constexpr size_t kMinRecycledBytes = 1024;
+
+  // Caches up to `max_cached_bytes` of freed buffers allocated from `base`,
+  // which must outlive the allocator.
+  RecyclingAllocator(Allocator* base, size_t max_cached_bytes);
+
+  std::string Name() override { return "recycling_" + base_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Frees the cached buffers, and deletes the allocator once all its
+  // outstanding buffers have been freed. No allocations may follow.
+  void Release();
+
+  // Returns the number of bytes of freed buffers currently cached.
+  size_t cached_bytes() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  ~RecyclingAllocator() override;
+
+  Allocator* const base_;  // Not owned.
+  const size_t max_cached_bytes_;
+  mutex mu_;
+  // Freed buffers, by size class.
+  absl::flat_hash_map<size_t, std::vector<void*>> free_buffers_
+      TF_GUARDED_BY(mu_);
+  // Outstanding buffers, with their size class, or 0 if they are not cached
+  // when freed.
+  absl::flat_hash_map<void*, size_t> outstanding_buffers_ TF_GUARDED_BY(mu_);
+  size_t cached_bytes_ TF_GUARDED_BY(mu_) = 0;
+  bool released_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_RECYCLING_ALLOCATOR_H_
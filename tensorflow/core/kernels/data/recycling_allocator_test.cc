@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/recycling_allocator.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Counts the allocations of the CPU allocator.
+class CountingAllocator : public Allocator {
+ public:
+  std::string Name() override { return "counting"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations;
+    ++num_outstanding;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    --num_outstanding;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  int num_allocations = 0;
+  int num_outstanding = 0;
+};
+
+TEST(RecyclingAllocatorTest, RecyclesBuffersOfTheSameSizeClass) {
+  CountingAllocator base;
+  auto* allocator = new RecyclingAllocator(&base, /*max_cached_bytes=*/1 << 20);
+  void* first = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  allocator->DeallocateRaw(first);
+  EXPECT_EQ(allocator->cached_bytes(), 4096);
+  void* second = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 4090);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(allocator->cached_bytes(), 0);
+  void* third = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 8192);
+  EXPECT_NE(first, third);
+  EXPECT_EQ(base.num_allocations, 2);
+  allocator->DeallocateRaw(second);
+  allocator->DeallocateRaw(third);
+  allocator->Release();
+  EXPECT_EQ(base.num_outstanding, 0);
+}
+
+TEST(RecyclingAllocatorTest, DoesNotCacheSmallBuffers) {
+  CountingAllocator base;
+  auto* allocator = new RecyclingAllocator(&base, /*max_cached_bytes=*/1 << 20);
+  void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 16);
+  allocator->DeallocateRaw(ptr);
+  EXPECT_EQ(allocator->cached_bytes(), 0);
+  EXPECT_EQ(base.num_outstanding, 0);
+  allocator->Release();
+}
+
+TEST(RecyclingAllocatorTest, CachesUpToTheLimit) {
+  CountingAllocator base;
+  auto* allocator = new RecyclingAllocator(&base, /*max_cached_bytes=*/8192);
+  std::vector<void*> buffers;
+  for (int i = 0; i < 3; ++i) {
+    buffers.push_back(
+        allocator->AllocateRaw(Allocator::kAllocatorAlignment, 4096));
+  }
+  for (void* ptr : buffers) allocator->DeallocateRaw(ptr);
+  EXPECT_EQ(allocator->cached_bytes(), 8192);
+  EXPECT_EQ(base.num_outstanding, 2);
+  allocator->Release();
+  EXPECT_EQ(base.num_outstanding, 0);
+}
+
+TEST(RecyclingAllocatorTest, BuffersOutliveRelease) {
+  CountingAllocator base;
+  auto* allocator = new RecyclingAllocator(&base, /*max_cached_bytes=*/1 << 20);
+  {
+    Tensor t(allocator, DT_FLOAT, TensorShape({1024}));
+    t.flat<float>().setZero();
+    allocator->Release();
+    EXPECT_EQ(base.num_outstanding, 1);
+  }
+  EXPECT_EQ(base.num_outstanding, 0);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
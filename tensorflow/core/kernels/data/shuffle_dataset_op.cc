@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -55,6 +57,9 @@ namespace data {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64 kMaxEpochsInBuffer = 3;
+// The buffered elements are saved in chunks of at most this many bytes, each
+// in its own checkpoint tensor, which is limited to 2GB.
+const int64 kMaxCheckpointChunkBytes = 256 << 20;
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kDataProduced[] = "data_produced";
@@ -69,12 +74,32 @@ constexpr char kSize[] = "size";
 constexpr char kSeedGenerator[] = "SeedGenerator";
 constexpr char kTFData[] = "tf_data";
 constexpr char kEpochNumRandomSamples[] = "epoch_num_random_samples";
+constexpr char kNumBufferChunks[] = "num_buffer_chunks";
+constexpr char kBufferChunk[] = "buffer_chunk";
+constexpr char kReplayNumRandomSamples[] = "replay_num_random_samples";
+constexpr char kReplayNumProduced[] = "replay_num_produced";
 constexpr char kShuffleDatasetV1[] = "ShuffleDataset";
 constexpr char kShuffleDatasetV2[] = "ShuffleDatasetV2";
 constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
 constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
+// Returns the largest number of input elements a shuffle iterator may have
+// read to be saved by replay: instead of its buffer, the checkpoint records
+// the number of elements it produced, and it is restored by producing them
+// again from the start of its input, with the same seeds. This requires a
+// deterministic input, and is disabled by default.
+int64 ShuffleReplayLimit() {
+  int64 limit;
+  Status s = ReadInt64FromEnvVar("TF_DATA_SHUFFLE_CHECKPOINT_REPLAY_LIMIT",
+                                 /*default_val=*/0, &limit);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return 0;
+  }
+  return limit;
+}
+
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx) {}
 
@@ -155,6 +180,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     Status Initialize(IteratorContext* ctx) override {
       mutex_lock l(mu_);
+      initial_num_random_samples_ = seed_generator_->num_random_samples();
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
       return Status::OK();
@@ -164,6 +190,22 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
       mutex_lock l(mu_);
+      return GetNextLocked(ctx, out_tensors, end_of_sequence);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args),
+                                       /*ratio=*/1);
+    }
+
+    Status GetNextLocked(IteratorContext* ctx,
+                         std::vector<Tensor>* out_tensors,
+                         bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // The splits of the input are not replayed.
+      if (ctx->split_provider()) replayable_ = false;
       int64 start_micros = EnvTime::NowMicros();
       int64 num_log_entries = 0;
       if (!input_impl_ && epoch_ == 0) {
@@ -213,6 +255,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           buffer_->at(slices_.back()->end % this->dataset()->buffer_size_) =
               std::move(input_element);
           num_elements_++;
+          num_input_elements_++;
           slices_.back()->end++;
         } else {
           input_impl_.reset();
@@ -255,6 +298,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                               this->dataset()->buffer_size_));
         slices_.front()->start++;
         num_elements_--;
+        num_produced_++;
       } else {
         DCHECK(input_impl_ == nullptr);
         *end_of_sequence = true;
@@ -262,13 +306,6 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return Status::OK();
     }
 
-   protected:
-    std::shared_ptr<model::Node> CreateNode(
-        IteratorContext* ctx, model::Node::Args args) const override {
-      return model::MakeKnownRatioNode(std::move(args),
-                                       /*ratio=*/1);
-    }
-
     void ResetRngs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       // Reset the generators based on the current iterator seeds.
       parent_generator_ = random::PhiloxRandom(seed_, seed2_);
@@ -279,7 +316,45 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
-      mutex_lock l(mu_);
+      std::vector<std::vector<Tensor>> elements;
+      {
+        mutex_lock l(mu_);
+        if (CanReplay()) return SaveReplayLocked(writer);
+        TF_RETURN_IF_ERROR(SaveStateLocked(ctx, writer, &elements));
+      }
+      // The elements are written without holding `mu_`, so that a large
+      // buffer does not block GetNext() while it is saved.
+      return SaveBuffer(writer, &elements);
+    }
+
+    bool CanReplay() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64 limit = ShuffleReplayLimit();
+      return replayable_ && limit > 0 && num_input_elements_ <= limit;
+    }
+
+    // Saves the seeds of the iterator and the number of elements it
+    // produced, from which RestoreInternal() replays it.
+    Status SaveReplayLocked(IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kEpochNumRandomSamples),
+                              seed_generator_->num_random_samples()));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(this->full_name(kReplayNumRandomSamples),
+                              initial_num_random_samples_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          this->full_name(kReplayNumProduced), num_produced_));
+      metrics::RecordTFDataCheckpointBytes(this->dataset()->op_type(),
+                                           "replay", 0);
+      return Status::OK();
+    }
+
+    // Saves the state of the iterator, except its buffered elements, which
+    // are returned in `*elements` in the order of the slices.
+    Status SaveStateLocked(SerializationContext* ctx,
+                           IteratorStateWriter* writer,
+                           std::vector<std::vector<Tensor>>* elements)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       // Save state needed to restore the random number generators.
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name(kEpochNumRandomSamples),
@@ -298,11 +373,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_RETURN_IF_ERROR(this->SaveInput(ctx, writer, input_impl_));
       }
 
-      // Save the epoch counter, buffer, and buffer slices.
+      // Save the epoch counter and buffer slices.
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
@@ -319,9 +393,52 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             writer->WriteScalar(this->full_name(kDataProduced), ""));
       }
 
+      // The tensors are reference counted: the elements are not copied.
+      elements->reserve(num_elements_);
+      for (const auto& slice : slices_) {
+        for (int64 i = slice->start; i < slice->end; ++i) {
+          elements->push_back(
+              buffer_->at(i % this->dataset()->buffer_size_));
+        }
+      }
       return Status::OK();
     }
 
+    // Writes `*elements` in chunks of at most kMaxCheckpointChunkBytes.
+    Status SaveBuffer(IteratorStateWriter* writer,
+                      std::vector<std::vector<Tensor>>* elements) {
+      int64 num_chunks = 0;
+      int64 num_bytes = 0;
+      std::vector<std::vector<Tensor>> chunk;
+      int64 chunk_bytes = 0;
+      for (auto& element : *elements) {
+        const int64 element_bytes = GetTotalBytes(element);
+        if (!chunk.empty() &&
+            chunk_bytes + element_bytes > kMaxCheckpointChunkBytes) {
+          TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+              writer, BufferChunkName(num_chunks++), chunk));
+          chunk.clear();
+          chunk_bytes = 0;
+        }
+        chunk.push_back(std::move(element));
+        chunk_bytes += element_bytes;
+        num_bytes += element_bytes;
+      }
+      if (!chunk.empty()) {
+        TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+            writer, BufferChunkName(num_chunks++), chunk));
+      }
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(this->full_name(kNumBufferChunks), num_chunks));
+      metrics::RecordTFDataCheckpointBytes(this->dataset()->op_type(),
+                                           "buffer", num_bytes);
+      return Status::OK();
+    }
+
+    string BufferChunkName(int64 chunk) const {
+      return absl::StrCat(prefix(), "::", kBufferChunk, "_", chunk);
+    }
+
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
       mutex_lock l(mu_);
@@ -329,6 +446,14 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64 num_random_samples;
       TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kEpochNumRandomSamples),
                                             &num_random_samples));
+      if (reader->Contains(this->full_name(kReplayNumProduced))) {
+        TF_RETURN_IF_ERROR(Replay(ctx, reader));
+        seed_generator_->set_num_random_samples(num_random_samples);
+        seed_generator_->Reset();
+        return Status::OK();
+      }
+      // The elements produced before the checkpoint are not known.
+      replayable_ = false;
       seed_generator_->set_num_random_samples(num_random_samples);
       seed_generator_->Reset();
       TF_RETURN_IF_ERROR(reader->ReadScalar(this->full_name(kNumRandomSamples),
@@ -359,8 +484,13 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       }
       buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
           this->dataset()->buffer_size_);
-      TF_RETURN_IF_ERROR(
-          ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      // Checkpoints written before the buffer was saved in chunks hold all
+      // the slots of the buffer.
+      const bool chunked = reader->Contains(this->full_name(kNumBufferChunks));
+      if (!chunked) {
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      }
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
@@ -375,10 +505,86 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         slices_.push_back(absl::make_unique<Slice>(start, end));
       }
       data_produced_ = reader->Contains(this->full_name(kDataProduced));
+      if (chunked) TF_RETURN_IF_ERROR(RestoreBuffer(reader));
 
       return Status::OK();
     }
 
+    // Reads the chunks of elements written by SaveBuffer() back in the slots
+    // of their slices.
+    Status RestoreBuffer(IteratorStateReader* reader)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 num_chunks;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(this->full_name(kNumBufferChunks), &num_chunks));
+      std::vector<std::vector<Tensor>> elements;
+      for (int64 i = 0; i < num_chunks; ++i) {
+        std::vector<std::vector<Tensor>> chunk;
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(reader, BufferChunkName(i), &chunk));
+        for (auto& element : chunk) elements.push_back(std::move(element));
+      }
+      if (static_cast<int64>(elements.size()) != num_elements_) {
+        return errors::DataLoss("Expected ", num_elements_,
+                                " buffered elements in the checkpoint, got ",
+                                elements.size());
+      }
+      size_t next = 0;
+      for (const auto& slice : slices_) {
+        for (int64 i = slice->start; i < slice->end; ++i) {
+          if (next == elements.size()) {
+            return errors::DataLoss(
+                "The slices of the checkpoint hold more than ",
+                elements.size(), " buffered elements.");
+          }
+          buffer_->at(i % this->dataset()->buffer_size_) =
+              std::move(elements[next++]);
+        }
+      }
+      return Status::OK();
+    }
+
+    // Restores the iterator by producing again, and dropping, the elements
+    // it produced before the checkpoint, starting with the same seeds.
+    Status Replay(IteratorContext* ctx, IteratorStateReader* reader)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 num_produced;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(
+          this->full_name(kReplayNumRandomSamples),
+          &initial_num_random_samples_));
+      TF_RETURN_IF_ERROR(reader->ReadScalar(
+          this->full_name(kReplayNumProduced), &num_produced));
+      seed_generator_->set_num_random_samples(initial_num_random_samples_);
+      seed_generator_->Reset();
+      seed_generator_->GenerateSeeds(&seed_, &seed2_);
+      num_random_samples_ = 0;
+      ResetRngs();
+      buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
+          this->dataset()->buffer_size_);
+      slices_.clear();
+      slices_.push_back(absl::make_unique<Slice>(0, 0));
+      input_impl_.reset();
+      epoch_ = 0;
+      num_elements_ = 0;
+      data_produced_ = false;
+      num_input_elements_ = 0;
+      num_produced_ = 0;
+      std::vector<Tensor> element;
+      bool end_of_sequence = false;
+      while (num_produced_ < num_produced) {
+        TF_RETURN_IF_ERROR(GetNextLocked(ctx, &element, &end_of_sequence));
+        if (end_of_sequence) {
+          return errors::DataLoss(
+              "Expected to replay ", num_produced,
+              " elements of the shuffle iterator, but its input ended after ",
+              num_produced_, ". Replayed checkpoints require a deterministic "
+              "input.");
+        }
+      }
+      VLOG(2) << "Replayed " << num_produced << " elements of " << prefix();
+      return Status::OK();
+    }
+
     TraceMeMetadata GetTraceMeMetadata() const override {
       return this->dataset()->traceme_metadata_;
     }
@@ -422,6 +628,15 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // The number of samples of `seed_generator_` when the iterator was
+    // initialized, from which its seeds were generated.
+    int64 initial_num_random_samples_ TF_GUARDED_BY(mu_) = 0;
+    // The number of elements read from the input and produced since the
+    // iterator was initialized.
+    int64 num_input_elements_ TF_GUARDED_BY(mu_) = 0;
+    int64 num_produced_ TF_GUARDED_BY(mu_) = 0;
+    // Whether the iterator can be restored by replaying its input.
+    bool replayable_ TF_GUARDED_BY(mu_) = true;
   };
 
   const DatasetBase* const input_;
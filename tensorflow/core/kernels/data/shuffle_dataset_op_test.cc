@@ -509,40 +509,52 @@ IteratorSaveAndRestoreTestCases() {
 class ParameterizedIteratorSaveAndRestoreTest
     : public ShuffleDatasetOpTest,
       public ::testing::WithParamInterface<
-          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {};
-
-TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
-  auto test_case = GetParam();
-  TF_ASSERT_OK(Initialize(test_case.dataset_params));
-
-  std::unique_ptr<SerializationContext> serialization_ctx;
-  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
-
-  bool end_of_sequence = false;
-  std::vector<Tensor> out_tensors;
-  int cur_iteration = 0;
-  const std::vector<int>& breakpoints = test_case.breakpoints;
-  for (int breakpoint : breakpoints) {
-    VariantTensorDataWriter writer;
-    TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
-    std::vector<const VariantTensorData*> data;
-    writer.GetData(&data);
-    VariantTensorDataReader reader(data);
-    TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
-                                 test_case.dataset_params.iterator_prefix(),
-                                 *dataset_, &iterator_));
-
-    while (cur_iteration <= breakpoint) {
-      std::vector<Tensor> next;
-      TF_EXPECT_OK(
-          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
-      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
-      cur_iteration++;
+          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {
+ protected:
+  void SaveAndRestore() {
+    auto test_case = GetParam();
+    TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+    std::unique_ptr<SerializationContext> serialization_ctx;
+    TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+
+    bool end_of_sequence = false;
+    std::vector<Tensor> out_tensors;
+    int cur_iteration = 0;
+    const std::vector<int>& breakpoints = test_case.breakpoints;
+    for (int breakpoint : breakpoints) {
+      VariantTensorDataWriter writer;
+      TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+      std::vector<const VariantTensorData*> data;
+      writer.GetData(&data);
+      VariantTensorDataReader reader(data);
+      TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                   test_case.dataset_params.iterator_prefix(),
+                                   *dataset_, &iterator_));
+
+      while (cur_iteration <= breakpoint) {
+        std::vector<Tensor> next;
+        TF_EXPECT_OK(
+            iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+        out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+        cur_iteration++;
+      }
     }
+
+    TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                             /*compare_order=*/true));
   }
+};
 
-  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
-                           /*compare_order=*/true));
+TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
+  SaveAndRestore();
+}
+
+TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorReplayAndRestore) {
+  // The checkpoints record the elements produced instead of the buffer.
+  setenv("TF_DATA_SHUFFLE_CHECKPOINT_REPLAY_LIMIT", "1000", /*overwrite=*/1);
+  SaveAndRestore();
+  unsetenv("TF_DATA_SHUFFLE_CHECKPOINT_REPLAY_LIMIT");
 }
 
 INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
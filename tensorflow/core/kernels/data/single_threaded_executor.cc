@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/single_threaded_executor.h"
 
+#include <deque>
+
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -32,6 +35,44 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 static const string& kSingleThreadedExecutor =
     *new string("SINGLE_THREADED_EXECUTOR");
 
+// Passed to transfer kernels in place of their dead inputs.
+static const Tensor* const kEmptyTensor = new Tensor;
+
+// Returns true if `n` has a control edge from a node other than the source.
+bool HasControlInputs(const Node* n) {
+  for (const Edge* e : n->in_edges()) {
+    if (e->IsControlEdge() && !e->src()->IsSource()) return true;
+  }
+  return false;
+}
+
+// Returns the nodes of `graph` in a topological order that runs every node
+// that does not depend on a "_Recv" node before the "_Recv" nodes, so that
+// the tensors sent to other partitions are sent before this partition waits
+// for the tensors that it receives.
+void GetOrderWithRecvsLast(const Graph& graph, std::vector<Node*>* order) {
+  std::vector<int> pending_counts(graph.num_node_ids());
+  std::deque<Node*> ready;
+  std::deque<Node*> ready_recvs;
+  for (Node* n : graph.nodes()) {
+    pending_counts[n->id()] = n->in_edges().size();
+    if (n->in_edges().empty()) {
+      (n->IsRecv() ? ready_recvs : ready).push_back(n);
+    }
+  }
+  while (!ready.empty() || !ready_recvs.empty()) {
+    std::deque<Node*>* queue = ready.empty() ? &ready_recvs : &ready;
+    Node* n = queue->front();
+    queue->pop_front();
+    order->push_back(n);
+    for (const Edge* e : n->out_edges()) {
+      if (--pending_counts[e->dst()->id()] == 0) {
+        (e->dst()->IsRecv() ? ready_recvs : ready).push_back(e->dst());
+      }
+    }
+  }
+}
+
 class SingleThreadedExecutorImpl : public Executor {
  public:
   explicit SingleThreadedExecutorImpl(const LocalExecutorParams& params)
@@ -47,10 +88,22 @@ class SingleThreadedExecutorImpl : public Executor {
   }
 
   Status Initialize(const Graph& graph) {
+    // Switch and Recv nodes may produce dead tensors, which must then be
+    // propagated through the graph.
+    bool has_recvs = false;
+    for (const Node* n : graph.op_nodes()) {
+      has_recvs |= n->IsRecv();
+      can_produce_dead_tensors_ |= n->IsSwitch() || n->IsRecv();
+    }
+
     // Topologicially sort `graph` to get a sequence of OpKernels.
     std::vector<Node*> ordered_nodes;
     ordered_nodes.reserve(graph.num_nodes());
-    GetReversePostOrder(graph, &ordered_nodes);
+    if (has_recvs) {
+      GetOrderWithRecvsLast(graph, &ordered_nodes);
+    } else {
+      GetReversePostOrder(graph, &ordered_nodes);
+    }
     int ordered_nodes_size = ordered_nodes.size();
     if (ordered_nodes_size != graph.num_nodes()) {
       return errors::InvalidArgument("Graph had ", graph.num_nodes(),
@@ -76,20 +129,15 @@ class SingleThreadedExecutorImpl : public Executor {
               DataTypeString(dt), " in outputs of node ", n->name());
         }
       }
-      if (n->IsControlFlow()) {
+      if (n->IsEnter() || n->IsExit() || n->IsNextIteration() ||
+          n->IsLoopCond()) {
         return errors::FailedPrecondition(
-            "Single-threaded executor does not support low level control flow, "
+            "Single-threaded executor does not support low level loops, "
             " but saw control flow node ",
             n->name(),
             ".  Perhaps your graph contains old-style control flow primitives? "
             "Try using tf.compat.v1.enable_control_flow_v2().");
       }
-      if (n->IsSend() || n->IsHostSend() || n->IsRecv() || n->IsHostRecv()) {
-        return errors::Unimplemented(
-            "Single-threaded executor does not support partitioned graphs.  "
-            "But saw send/recv node ",
-            n->name());
-      }
       if (n->IsCollective()) {
         return errors::Unimplemented(
             "Single-threaded executor does not support collective ops.  But "
@@ -113,8 +161,11 @@ class SingleThreadedExecutorImpl : public Executor {
       OpKernel* kernel;
       TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
 
+      // A constant that is guarded by a control edge may be dead, so it is
+      // only specialized when the graph cannot produce dead tensors.
       const Tensor* const_tensor;
-      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor())) {
+      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor()) &&
+          (!can_produce_dead_tensors_ || !HasControlInputs(n))) {
         // Nodes that produce a single constant tensor are handled specially:
         // we evaluate the tensor once, and propagate it to its consumers as
         // a `const Tensor*`, to avoid refcount manipulation.
@@ -133,6 +184,9 @@ class SingleThreadedExecutorImpl : public Executor {
         kernel_state.kernel = kernel;
         kernel_state.num_inputs = n->num_inputs();
         kernel_state.num_outputs = n->num_outputs();
+        kernel_state.is_merge = n->IsMerge();
+        kernel_state.is_transfer_node = IsTransferNode(n);
+        kernel_state.is_recv_or_switch = n->IsRecv() || n->IsSwitch();
         node_to_index_map[n] = kernel_index;
         if (kernel_index == 0) {
           kernel_state.input_start_index = 0;
@@ -201,6 +255,11 @@ class SingleThreadedExecutorImpl : public Executor {
           kernel_state.output_locations[e->src_output()].push_back(
               kernels_[node_to_index_map[e->dst()]].input_start_index +
               e->dst_input());
+        } else if (can_produce_dead_tensors_) {
+          auto it = node_to_index_map.find(e->dst());
+          if (it != node_to_index_map.end()) {
+            kernel_state.control_outputs.push_back(it->second);
+          }
         }
       }
 
@@ -276,6 +335,11 @@ class SingleThreadedExecutorImpl : public Executor {
     //   initialized, and manually destroy them.
     std::vector<Entry> inputs(total_num_inputs_);
 
+    // For the `i`th kernel, `dead_control_inputs[i]` is true if one of its
+    // control inputs is dead. Only used if the graph can produce dead tensors.
+    std::vector<bool> dead_control_inputs(
+        can_produce_dead_tensors_ ? kernels_.size() : 0);
+
     // TODO(mrry): Can we avoid copying into these vectors? Consider modifying
     // OpKernelContext to take the TensorValueVec as a pointer into `inputs`.
     TensorValueVec node_inputs;
@@ -388,6 +452,7 @@ class SingleThreadedExecutorImpl : public Executor {
       node_inputs.resize(num_inputs);
       input_alloc_attrs.clear();
       input_alloc_attrs.resize(num_inputs);
+      size_t num_dead_inputs = 0;
       for (size_t j = 0; j < num_inputs; ++j) {
         Entry& input = inputs[input_start_index + j];
         switch (input.state) {
@@ -402,10 +467,41 @@ class SingleThreadedExecutorImpl : public Executor {
             node_inputs[j].tensor = input.val.get();
             break;
           default:
-            DCHECK(false) << "Input did not have a valid value.";
+            // The producer of this input did not run, or its output was dead.
+            DCHECK(can_produce_dead_tensors_)
+                << "Input did not have a valid value.";
+            ++num_dead_inputs;
         }
         input_alloc_attrs[j] = input_alloc_attrs_[input_start_index + j];
       }
+
+      // A Merge node is dead if all its inputs are dead, and any other node if
+      // one of its inputs is dead. Dead nodes are not run, except for Send and
+      // Recv nodes, which forward the deadness to their peers.
+      bool is_dead = false;
+      if (can_produce_dead_tensors_) {
+        is_dead = dead_control_inputs[i] ||
+                  (kernel_state.is_merge ? num_dead_inputs == num_inputs
+                                         : num_dead_inputs > 0);
+        if (is_dead && !kernel_state.is_transfer_node) {
+          for (size_t j = 0; j < num_inputs; ++j) {
+            inputs[input_start_index + j].ClearVal();
+          }
+          for (size_t control_output : kernel_state.control_outputs) {
+            dead_control_inputs[control_output] = true;
+          }
+          continue;
+        }
+        params.is_input_dead =
+            kernel_state.is_transfer_node && num_dead_inputs > 0;
+        if (params.is_input_dead) {
+          for (size_t j = 0; j < num_inputs; ++j) {
+            if (node_inputs[j].tensor == nullptr) {
+              node_inputs[j].tensor = const_cast<Tensor*>(kEmptyTensor);
+            }
+          }
+        }
+      }
       params.op_kernel = kernel_state.kernel;
       params.output_attr_array = kernel_state.output_alloc_attrs.data();
       OpKernelContext ctx(&params, num_outputs);
@@ -420,10 +516,24 @@ class SingleThreadedExecutorImpl : public Executor {
       }
 
       // Forward the outputs of the kernel to the inputs of subsequent kernels.
+      if (is_dead) {
+        for (size_t control_output : kernel_state.control_outputs) {
+          dead_control_inputs[control_output] = true;
+        }
+      }
       for (size_t j = 0; j < num_outputs; ++j) {
         TensorValue val = ctx.release_output(j);
         const size_t num_destinations = kernel_state.output_locations[j].size();
-        if (num_destinations > 0) {
+        if (val.tensor == nullptr) {
+          // Switch and Recv nodes do not set their dead outputs.
+          if (num_destinations > 0 && !kernel_state.is_recv_or_switch) {
+            return errors::Internal("Missing ", j, "-th output from ",
+                                    FormatNodeDefForError(
+                                        kernel_state.kernel->def()));
+          }
+          continue;
+        }
+        if (num_destinations > 0 && !is_dead) {
           // TODO(mrry): Consider flattening the `output_locations` vector
           // to improve the cache-friendliness of this loop.
           for (size_t k = 0; k < num_destinations - 1; ++k) {
@@ -454,6 +564,10 @@ class SingleThreadedExecutorImpl : public Executor {
 
   // All following members are read-only after Initialize().
 
+  // True if the graph contains Switch or Recv nodes, and hence may produce
+  // dead tensors.
+  bool can_produce_dead_tensors_ = false;
+
   // The sum of the number of inputs for each node in the graph. This determines
   // the length of the flat `inputs` vector. See comment at the beginning of
   // `RunAsync()` for details.
@@ -474,6 +588,14 @@ class SingleThreadedExecutorImpl : public Executor {
 
     size_t num_outputs;
 
+    bool is_merge;
+    bool is_transfer_node;
+    bool is_recv_or_switch;
+
+    // The indices of the kernels that have a control edge from `kernel`. Only
+    // filled in if the graph can produce dead tensors.
+    std::vector<size_t> control_outputs;
+
     // For the `j`th output of `kernel`, `output_locations[j]` contains the
     // locations in the flat `inputs` vector to which that output must be
     // copied. See comment at the beginning of `Run()` for details.
@@ -35,14 +35,15 @@ namespace data {
 //
 // 1. Reference-typed tensors are not supported and will not be supported in
 //    future.
-// 2. Graphs with control flow (containing "Switch" and "Merge" nodes) are not
-//    currently supported. The current plan is to extend support to "functional"
-//    control flow after the TensorFlow APIs transition to building graphs in
-//    that form (e.g. `tf.cond_v2()`).
-// 3. Partitioned graphs (containing "_Recv" nodes) are not currently supported.
-//    The present implementation executes kernels one at a time in topological
-//    order, and cannot currently distinguish between disconnected subgraphs
-//    that are logically connected by subgraphs on a different device.
+// 2. Graphs with loops (containing "Enter", "Exit" and "NextIteration"
+//    nodes) are not currently supported. Conditionals (containing "Switch"
+//    and "Merge" nodes) are supported, by propagating dead tensors in
+//    topological order.
+// 3. Partitioned graphs (containing "_Recv" nodes) are supported, but each
+//    "_Recv" node blocks the caller thread until its tensor arrives. The
+//    "_Recv" nodes run after every node that does not depend on them, so
+//    a partition must not need a tensor that it receives in order to send
+//    the tensor that another of its "_Recv" nodes waits for.
 // 4. Memory logging is not currently supported.
 // 5. Allocation forwarding is not currently supported.
 // 6. Non-default device contexts are not currently supported. In effect, this
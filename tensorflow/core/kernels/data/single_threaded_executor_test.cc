@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -273,6 +274,121 @@ TEST_F(ExecutorTest, ControlDependenciesFromSpecialNodes) {
   EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
 }
 
+TEST_F(ExecutorTest, Conditional) {
+  // out = pred ? x + 2.0 : -x
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto sw = test::graph::Switch(g.get(), x, pred);
+  auto neg = test::graph::Unary(g.get(), "Neg", sw, 0);
+  auto pivot = test::graph::Identity(g.get(), sw, 1);
+  // The constant is dead when the false branch is taken.
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  g->AddControlEdge(pivot, two);
+  auto add = test::graph::Add(g.get(), pivot, two);
+  auto merge = test::graph::Merge(g.get(), neg, add);
+  test::graph::Retval(g.get(), 0, merge);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (const bool take_true_branch : {true, false}) {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(1.0), VB(take_true_branch)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(take_true_branch ? 3.0 : -1.0, V(retvals[0]));
+  }
+}
+
+#define ALICE "/job:j/replica:0/task:0/cpu:0"
+#define BOB "/job:j/replica:0/task:0/device:GPU:0"
+
+TEST_F(ExecutorTest, SendRecv) {
+  // c = a + b
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, 1, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, 1, BOB, "b"), args, V(2.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, 1, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_FALSE(is_dead);
+  EXPECT_EQ(3.0, V(out));  // out = 1.0 + 2.0 = 3.0
+}
+
+TEST_F(ExecutorTest, SendsBeforeRecvs) {
+  // The peer only sends "b" after it receives "a", so "a" must be sent before
+  // the executor waits for "b".
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto b = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  test::graph::Retval(g.get(), 0, b);
+  auto a = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  test::graph::Send(g.get(), a, "a", BOB, 1, ALICE);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  std::unique_ptr<Thread> peer(
+      Env::Default()->StartThread({}, "peer", [this]() {
+        Rendezvous::Args args;
+        Tensor a;
+        bool is_dead = false;
+        TF_CHECK_OK(
+            rendez_->Recv(Key(BOB, 1, ALICE, "a"), args, &a, &is_dead));
+        TF_CHECK_OK(
+            rendez_->Send(Key(ALICE, 1, BOB, "b"), args, V(2 * V(a)), false));
+      }));
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  Executor::Args args;
+  args.call_frame = &call_frame;
+  args.rendezvous = rendez_;
+  args.runner = runner_;
+  TF_ASSERT_OK(exec_->Run(args));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(2.0, V(retvals[0]));
+}
+
+TEST_F(ExecutorTest, SendDeadTensor) {
+  // The untaken branch of a conditional sends a dead tensor.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto sw = test::graph::Switch(g.get(), x, pred);
+  test::graph::Send(g.get(), test::graph::Identity(g.get(), sw, 0), "f", BOB,
+                    1, ALICE);
+  test::graph::Send(g.get(), test::graph::Identity(g.get(), sw, 1), "t", BOB,
+                    1, ALICE);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), VB(true)}));
+  Executor::Args args;
+  args.call_frame = &call_frame;
+  args.rendezvous = rendez_;
+  args.runner = runner_;
+  TF_ASSERT_OK(exec_->Run(args));
+  Rendezvous::Args rendez_args;
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, 1, ALICE, "t"), rendez_args, &out,
+                             &is_dead));
+  EXPECT_FALSE(is_dead);
+  EXPECT_EQ(1.0, V(out));
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, 1, ALICE, "f"), rendez_args, &out,
+                             &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
+#undef ALICE
+#undef BOB
+
 static void BM_executor(int iters, int width, int depth) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -27,6 +27,7 @@ ABSL_CONST_INIT const char kThreadUtilization[] = "thread_utilization";
 ABSL_CONST_INIT const char kBufferSize[] = "buffer_size";
 ABSL_CONST_INIT const char kBufferCapacity[] = "buffer_capacity";
 ABSL_CONST_INIT const char kBufferUtilization[] = "buffer_utilization";
+ABSL_CONST_INIT const char kMaximumBufferedBytes[] = "max_buffered_bytes";
 ABSL_CONST_INIT const char kFilteredElements[] = "filtered_elements";
 ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
@@ -53,6 +54,10 @@ string BufferUtilizationHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kBufferUtilization);
 }
 
+string MaximumBufferedBytesScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kMaximumBufferedBytes);
+}
+
 string FilterdElementsScalarName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFilteredElements);
 }
@@ -26,6 +26,7 @@ extern const char kThreadUtilization[];
 extern const char kBufferSize[];
 extern const char kBufferCapacity[];
 extern const char kBufferUtilization[];
+extern const char kMaximumBufferedBytes[];
 extern const char kFilteredElements[];
 extern const char kDroppedElements[];
 extern const char kFeaturesCount[];
@@ -49,6 +50,9 @@ string BufferCapacityScalarName(const string& prefix);
 // buffer size.) histogram metrics.
 string BufferUtilizationHistogramName(const string& prefix);
 
+// Name for the buffer limit (in bytes) chosen by autotuning scalar metrics.
+string MaximumBufferedBytesScalarName(const string& prefix);
+
 // Name for filtered elements scalar metrics.
 string FilterdElementsScalarName(const string& prefix);
 
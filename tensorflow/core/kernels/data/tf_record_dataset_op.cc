@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -43,6 +44,19 @@ constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64 kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64 kS3BlockSize = kCloudTpuBlockSize;
 
+// Returns true if uncompressed files should be read through memory maps when
+// their file system supports it, which avoids a copy of every record and the
+// read syscalls for local files.
+bool UseMemmappedFiles() {
+  static const bool use_mmap = [] {
+    bool value;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RECORD_DATASET_USE_MMAP",
+                                   /*default_val=*/false, &value));
+    return value;
+  }();
+  return use_mmap;
+}
+
 bool is_cloud_tpu_gcs_fs() {
 #if defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)
   return true;
@@ -119,11 +133,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(mu_);
       do {
         // We are currently processing a file, so try to read the next record.
-        if (reader_) {
+        if (reader_ || mmap_reader_) {
           out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
                                     TensorShape({}));
           Status s =
-              reader_->ReadRecord(&out_tensors->back().scalar<tstring>()());
+              ReadRecordLocked(&out_tensors->back().scalar<tstring>()());
           if (s.ok()) {
             static monitoring::CounterCell* bytes_counter =
                 metrics::GetTFDataBytesReadCounter(kDatasetType);
@@ -170,7 +184,10 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
                                              current_file_index_));
 
-      if (reader_) {
+      if (mmap_reader_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(kOffset), static_cast<int64>(mmap_offset_)));
+      } else if (reader_) {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(full_name(kOffset), reader_->TellOffset()));
       }
@@ -189,7 +206,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         int64 offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        if (mmap_reader_) {
+          mmap_offset_ = offset;
+        } else {
+          TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        }
       }
       return Status::OK();
     }
@@ -205,6 +226,20 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
+      if (UseMemmappedFiles() && dataset()->options_.compression_type ==
+                                     io::RecordReaderOptions::NONE) {
+        std::unique_ptr<ReadOnlyMemoryRegion> region;
+        Status s = env->NewReadOnlyMemoryRegionFromFile(next_filename, &region);
+        if (s.ok()) {
+          mmap_reader_ =
+              absl::make_unique<io::MemmappedRecordReader>(std::move(region));
+          mmap_offset_ = 0;
+          return Status::OK();
+        }
+        // Not every file system supports memory-mapped files.
+        VLOG(2) << "Reading " << next_filename
+                << " without a memory map: " << s;
+      }
       TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
       reader_ = absl::make_unique<io::SequentialRecordReader>(
           file_.get(), dataset()->options_);
@@ -215,6 +250,18 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      mmap_reader_.reset();
+    }
+
+    Status ReadRecordLocked(tstring* record) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!mmap_reader_) {
+        return reader_->ReadRecord(record);
+      }
+      // The record is copied once, from the mapped file into the tensor.
+      StringPiece data;
+      TF_RETURN_IF_ERROR(mmap_reader_->ReadRecord(&mmap_offset_, &data));
+      record->assign(data.data(), data.size());
+      return Status::OK();
     }
 
     mutex mu_;
@@ -224,6 +271,9 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+    // Used instead of `reader_` when the file is memory-mapped.
+    std::unique_ptr<io::MemmappedRecordReader> mmap_reader_ TF_GUARDED_BY(mu_);
+    uint64 mmap_offset_ TF_GUARDED_BY(mu_) = 0;
   };
 
   const std::vector<string> filenames_;
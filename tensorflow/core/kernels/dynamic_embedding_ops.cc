@@ -0,0 +1,152 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/lookup_ops.cc.
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/dynamic_embedding_table.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/lookup_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Gets the DynamicEmbeddingTable passed as the "table_handle" input.
+Status GetDynamicEmbeddingTable(OpKernelContext* ctx,
+                                lookup::DynamicEmbeddingTable** table) {
+  lookup::LookupInterface* lookup_table;
+  TF_RETURN_IF_ERROR(
+      lookup::GetResourceLookupTable("table_handle", ctx, &lookup_table));
+  *table = dynamic_cast<lookup::DynamicEmbeddingTable*>(lookup_table);
+  if (*table == nullptr) {
+    lookup_table->Unref();
+    return errors::InvalidArgument("Table ", ctx->op_kernel().name(),
+                                   " is not a DynamicEmbeddingTable.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_KERNEL_BUILDER(
+    Name("DynamicEmbeddingTable").Device(DEVICE_CPU),
+    LookupTableOp<lookup::DynamicEmbeddingTable, int64, float>);
+
+// Looks up the rows of a batch of ids, admitting new ids into the table.
+class DynamicEmbeddingLookupOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& keys = ctx->input(1);
+    const Tensor& initial_values = ctx->input(2);
+    TensorShape output_shape = keys.shape();
+    output_shape.AppendShape(table->value_shape());
+    Tensor* values;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &values));
+    OP_REQUIRES_OK(ctx, table->Lookup(keys, initial_values, values));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingLookup").Device(DEVICE_CPU),
+                        DynamicEmbeddingLookupOp);
+
+// Applies an Adagrad update to the rows of a batch of ids in place.
+class DynamicEmbeddingApplyAdagradOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& lr = ctx->input(3);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr must be a scalar, got shape ",
+                                        lr.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, table->ApplyAdagrad(ctx->input(1), ctx->input(2),
+                                            lr.scalar<float>()()));
+  }
+};
+REGISTER_KERNEL_BUILDER(
+    Name("DynamicEmbeddingApplyAdagrad").Device(DEVICE_CPU),
+    DynamicEmbeddingApplyAdagradOp);
+
+// Evicts the cold rows of a table.
+class DynamicEmbeddingEvictOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& ttl_seconds = ctx->input(1);
+    const Tensor& max_size = ctx->input(2);
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(ttl_seconds.shape()) &&
+                    TensorShapeUtils::IsScalar(max_size.shape()),
+                errors::InvalidArgument(
+                    "ttl_seconds and max_size must be scalars, got shapes ",
+                    ttl_seconds.shape().DebugString(), " and ",
+                    max_size.shape().DebugString()));
+    Tensor* num_evicted;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape({}), &num_evicted));
+    num_evicted->scalar<int64>()() = table->Evict(
+        ttl_seconds.scalar<int64>()(), max_size.scalar<int64>()());
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingEvict").Device(DEVICE_CPU),
+                        DynamicEmbeddingEvictOp);
+
+// Writes or applies an incremental checkpoint of a table.
+template <bool kSave>
+class DynamicEmbeddingDeltaOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& prefix = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(prefix.shape()),
+                errors::InvalidArgument("prefix must be a scalar, got shape ",
+                                        prefix.shape().DebugString()));
+    const string& prefix_string = prefix.scalar<tstring>()();
+    if (kSave) {
+      OP_REQUIRES_OK(ctx, table->SaveDelta(ctx->env(), prefix_string));
+    } else {
+      OP_REQUIRES_OK(ctx, table->LoadDelta(ctx->env(), prefix_string));
+    }
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingSaveDelta").Device(DEVICE_CPU),
+                        DynamicEmbeddingDeltaOp<true>);
+REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingLoadDelta").Device(DEVICE_CPU),
+                        DynamicEmbeddingDeltaOp<false>);
+
+}  // namespace tensorflow
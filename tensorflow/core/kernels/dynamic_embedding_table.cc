@@ -0,0 +1,441 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/dynamic_embedding_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace lookup {
+
+namespace {
+
+// Names of the tensors of a delta checkpoint.
+constexpr char kKeys[] = "keys";
+constexpr char kEmbeddings[] = "embeddings";
+constexpr char kSlots[] = "slots";
+constexpr char kFrequencies[] = "frequencies";
+constexpr char kRemovedKeys[] = "removed_keys";
+
+}  // namespace
+
+DynamicEmbeddingTable::DynamicEmbeddingTable(OpKernelContext* ctx,
+                                             OpKernel* kernel) {
+  Options options;
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "embedding_dim",
+                                  &options.embedding_dim));
+  OP_REQUIRES_OK(ctx,
+                 GetNodeAttr(kernel->def(), "num_slots", &options.num_slots));
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_slot_value",
+                                  &options.initial_slot_value));
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "min_frequency",
+                                  &options.min_frequency));
+  OP_REQUIRES(ctx, options.embedding_dim > 0,
+              errors::InvalidArgument("embedding_dim must be positive, got ",
+                                      options.embedding_dim));
+  options.env = ctx->env();
+  Init(options);
+}
+
+void DynamicEmbeddingTable::Init(const Options& options) {
+  options_ = options;
+  env_ = options.env != nullptr ? options.env : Env::Default();
+}
+
+size_t DynamicEmbeddingTable::size() const {
+  tf_shared_lock l(mu_);
+  return rows_.size();
+}
+
+int64 DynamicEmbeddingTable::FindOrCreateRow(int64 key, bool* created) {
+  auto it = rows_.find(key);
+  if (it != rows_.end()) {
+    *created = false;
+    return it->second;
+  }
+  *created = true;
+  int64 row;
+  if (!free_rows_.empty()) {
+    row = free_rows_.back();
+    free_rows_.pop_back();
+  } else {
+    row = row_info_.size();
+    row_info_.emplace_back();
+    embeddings_.resize(embeddings_.size() + options_.embedding_dim);
+    slots_.resize(slots_.size() + options_.num_slots * options_.embedding_dim);
+  }
+  if (options_.num_slots > 0) {
+    std::fill_n(Slot(row, 0), options_.num_slots * options_.embedding_dim,
+                options_.initial_slot_value);
+  }
+  row_info_[row] = {key, 0, env_->NowSeconds()};
+  rows_.emplace(key, row);
+  removed_.erase(key);
+  return row;
+}
+
+void DynamicEmbeddingTable::RemoveRow(int64 key, int64 row) {
+  rows_.erase(key);
+  free_rows_.push_back(row);
+  dirty_.erase(key);
+  removed_.insert(key);
+}
+
+void DynamicEmbeddingTable::ClearLocked() {
+  for (const auto& entry : rows_) removed_.insert(entry.first);
+  rows_.clear();
+  embeddings_.clear();
+  slots_.clear();
+  row_info_.clear();
+  free_rows_.clear();
+  pending_.clear();
+  dirty_.clear();
+}
+
+Status DynamicEmbeddingTable::Find(OpKernelContext* ctx, const Tensor& keys,
+                                   Tensor* values,
+                                   const Tensor& default_value) {
+  const auto key_values = keys.flat<int64>();
+  const float* default_row = default_value.flat<float>().data();
+  float* out = values->flat<float>().data();
+  const int64 dim = options_.embedding_dim;
+
+  tf_shared_lock l(mu_);
+  for (int64 i = 0; i < key_values.size(); ++i) {
+    auto it = rows_.find(key_values(i));
+    const float* row =
+        it != rows_.end() ? Embedding(it->second) : default_row;
+    std::copy_n(row, dim, out + i * dim);
+  }
+  return Status::OK();
+}
+
+Status DynamicEmbeddingTable::Insert(OpKernelContext* ctx, const Tensor& keys,
+                                     const Tensor& values) {
+  const auto key_values = keys.flat<int64>();
+  const float* in = values.flat<float>().data();
+  const int64 dim = options_.embedding_dim;
+
+  mutex_lock l(mu_);
+  for (int64 i = 0; i < key_values.size(); ++i) {
+    const int64 key = key_values(i);
+    bool created;
+    const int64 row = FindOrCreateRow(key, &created);
+    std::copy_n(in + i * dim, dim, Embedding(row));
+    dirty_.insert(key);
+  }
+  return Status::OK();
+}
+
+Status DynamicEmbeddingTable::Remove(OpKernelContext* ctx, const Tensor& keys) {
+  const auto key_values = keys.flat<int64>();
+
+  mutex_lock l(mu_);
+  for (int64 i = 0; i < key_values.size(); ++i) {
+    auto it = rows_.find(key_values(i));
+    if (it != rows_.end()) RemoveRow(it->first, it->second);
+  }
+  return Status::OK();
+}
+
+Status DynamicEmbeddingTable::ImportValues(OpKernelContext* ctx,
+                                           const Tensor& keys,
+                                           const Tensor& values) {
+  {
+    mutex_lock l(mu_);
+    ClearLocked();
+  }
+  return Insert(ctx, keys, values);
+}
+
+Status DynamicEmbeddingTable::ExportValues(OpKernelContext* ctx) {
+  tf_shared_lock l(mu_);
+  const int64 size = rows_.size();
+  const int64 dim = options_.embedding_dim;
+
+  Tensor* keys;
+  Tensor* values;
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output("keys", TensorShape({size}), &keys));
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output("values", TensorShape({size, dim}), &values));
+
+  auto keys_data = keys->flat<int64>();
+  float* values_data = values->flat<float>().data();
+  int64 i = 0;
+  for (const auto& entry : rows_) {
+    keys_data(i) = entry.first;
+    std::copy_n(Embedding(entry.second), dim, values_data + i * dim);
+    ++i;
+  }
+  return Status::OK();
+}
+
+int64 DynamicEmbeddingTable::MemoryUsed() const {
+  tf_shared_lock l(mu_);
+  return sizeof(DynamicEmbeddingTable) +
+         rows_.capacity() * (sizeof(std::pair<int64, int64>) + 1) +
+         (embeddings_.capacity() + slots_.capacity()) * sizeof(float) +
+         row_info_.capacity() * sizeof(RowInfo) +
+         free_rows_.capacity() * sizeof(int64) +
+         pending_.capacity() * (sizeof(std::pair<int64, PendingId>) + 1) +
+         (dirty_.capacity() + removed_.capacity()) * (sizeof(int64) + 1);
+}
+
+Status DynamicEmbeddingTable::Lookup(const Tensor& keys,
+                                     const Tensor& initial_values,
+                                     Tensor* values) {
+  const int64 dim = options_.embedding_dim;
+  const auto key_values = keys.flat<int64>();
+  const int64 num_keys = key_values.size();
+  const bool initial_value_per_key = initial_values.NumElements() != dim;
+  if (initial_value_per_key && initial_values.NumElements() != num_keys * dim) {
+    return errors::InvalidArgument(
+        "Expected initial values with ", dim, " or ", num_keys * dim,
+        " elements, got shape ", initial_values.shape().DebugString());
+  }
+  const float* initial = initial_values.flat<float>().data();
+  float* out = values->flat<float>().data();
+  const uint64 now = env_->NowSeconds();
+
+  mutex_lock l(mu_);
+  for (int64 i = 0; i < num_keys; ++i) {
+    const int64 key = key_values(i);
+    const float* initial_row = initial + (initial_value_per_key ? i * dim : 0);
+    int64 row;
+    auto it = rows_.find(key);
+    if (it != rows_.end()) {
+      row = it->second;
+    } else {
+      int64 frequency = 0;
+      if (options_.min_frequency > 1) {
+        PendingId& pending = pending_[key];
+        pending.last_access = now;
+        if (++pending.frequency < options_.min_frequency) {
+          std::copy_n(initial_row, dim, out + i * dim);
+          continue;
+        }
+        frequency = pending.frequency - 1;
+        pending_.erase(key);
+      }
+      bool created;
+      row = FindOrCreateRow(key, &created);
+      std::copy_n(initial_row, dim, Embedding(row));
+      row_info_[row].frequency = frequency;
+      dirty_.insert(key);
+    }
+    RowInfo& info = row_info_[row];
+    ++info.frequency;
+    info.last_access = now;
+    std::copy_n(Embedding(row), dim, out + i * dim);
+  }
+  return Status::OK();
+}
+
+Status DynamicEmbeddingTable::ApplyAdagrad(const Tensor& keys,
+                                           const Tensor& grads, float lr) {
+  if (options_.num_slots < 1) {
+    return errors::FailedPrecondition(
+        "Adagrad needs a table with at least one slot for its accumulator.");
+  }
+  const int64 dim = options_.embedding_dim;
+  const auto key_values = keys.flat<int64>();
+  if (grads.NumElements() != key_values.size() * dim) {
+    return errors::InvalidArgument("Expected gradients with ",
+                                   key_values.size() * dim,
+                                   " elements, got shape ",
+                                   grads.shape().DebugString());
+  }
+  const float* grad = grads.flat<float>().data();
+
+  mutex_lock l(mu_);
+  for (int64 i = 0; i < key_values.size(); ++i) {
+    auto it = rows_.find(key_values(i));
+    if (it == rows_.end()) continue;
+    float* embedding = Embedding(it->second);
+    float* accum = Slot(it->second, 0);
+    const float* g = grad + i * dim;
+    for (int64 j = 0; j < dim; ++j) {
+      accum[j] += g[j] * g[j];
+      embedding[j] -= lr * g[j] / std::sqrt(accum[j]);
+    }
+    dirty_.insert(it->first);
+  }
+  return Status::OK();
+}
+
+int64 DynamicEmbeddingTable::Evict(int64 ttl_seconds, int64 max_size) {
+  const uint64 now = env_->NowSeconds();
+  auto expired = [now, ttl_seconds](uint64 last_access) {
+    return ttl_seconds > 0 && last_access + ttl_seconds < now;
+  };
+
+  mutex_lock l(mu_);
+  std::vector<std::pair<int64, int64>> candidates;
+  for (const auto& entry : rows_) {
+    if (expired(row_info_[entry.second].last_access)) {
+      candidates.push_back(entry);
+    }
+  }
+  for (const auto& entry : candidates) RemoveRow(entry.first, entry.second);
+  int64 num_evicted = candidates.size();
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (expired(it->second.last_access)) {
+      pending_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+
+  if (max_size > 0 && rows_.size() > max_size) {
+    const int64 num_excess = rows_.size() - max_size;
+    candidates.assign(rows_.begin(), rows_.end());
+    // Evicts the least frequently used rows, and the least recently used
+    // among rows of the same frequency.
+    std::nth_element(candidates.begin(), candidates.begin() + num_excess - 1,
+                     candidates.end(),
+                     [this](const std::pair<int64, int64>& a,
+                            const std::pair<int64, int64>& b)
+                         TF_NO_THREAD_SAFETY_ANALYSIS {
+                           const RowInfo& x = row_info_[a.second];
+                           const RowInfo& y = row_info_[b.second];
+                           return std::tie(x.frequency, x.last_access) <
+                                  std::tie(y.frequency, y.last_access);
+                         });
+    for (int64 i = 0; i < num_excess; ++i) {
+      RemoveRow(candidates[i].first, candidates[i].second);
+    }
+    num_evicted += num_excess;
+  }
+  return num_evicted;
+}
+
+Status DynamicEmbeddingTable::SaveDelta(Env* env, const string& prefix) {
+  const int64 dim = options_.embedding_dim;
+  Tensor keys;
+  Tensor embeddings;
+  Tensor slots;
+  Tensor frequencies;
+  Tensor removed_keys;
+  {
+    mutex_lock l(mu_);
+    const int64 n = dirty_.size();
+    keys = Tensor(DT_INT64, TensorShape({n}));
+    embeddings = Tensor(DT_FLOAT, TensorShape({n, dim}));
+    slots = Tensor(DT_FLOAT, TensorShape({n, options_.num_slots, dim}));
+    frequencies = Tensor(DT_INT64, TensorShape({n}));
+    int64 i = 0;
+    for (int64 key : dirty_) {
+      const int64 row = rows_.at(key);
+      keys.flat<int64>()(i) = key;
+      std::copy_n(Embedding(row), dim,
+                  embeddings.flat<float>().data() + i * dim);
+      if (options_.num_slots > 0) {
+        std::copy_n(Slot(row, 0), options_.num_slots * dim,
+                    slots.flat<float>().data() + i * options_.num_slots * dim);
+      }
+      frequencies.flat<int64>()(i) = row_info_[row].frequency;
+      ++i;
+    }
+    removed_keys =
+        Tensor(DT_INT64, TensorShape({static_cast<int64>(removed_.size())}));
+    std::copy(removed_.begin(), removed_.end(),
+              removed_keys.flat<int64>().data());
+    dirty_.clear();
+    removed_.clear();
+  }
+
+  BundleWriter writer(env, prefix);
+  TF_RETURN_IF_ERROR(writer.Add(kKeys, keys));
+  TF_RETURN_IF_ERROR(writer.Add(kEmbeddings, embeddings));
+  TF_RETURN_IF_ERROR(writer.Add(kSlots, slots));
+  TF_RETURN_IF_ERROR(writer.Add(kFrequencies, frequencies));
+  TF_RETURN_IF_ERROR(writer.Add(kRemovedKeys, removed_keys));
+  Status s = writer.Finish();
+  if (!s.ok()) {
+    // Keeps the changes for the next delta.
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < keys.NumElements(); ++i) {
+      const int64 key = keys.flat<int64>()(i);
+      if (rows_.contains(key)) dirty_.insert(key);
+    }
+    for (int64 i = 0; i < removed_keys.NumElements(); ++i) {
+      const int64 key = removed_keys.flat<int64>()(i);
+      if (!rows_.contains(key)) removed_.insert(key);
+    }
+  }
+  return s;
+}
+
+Status DynamicEmbeddingTable::LoadDelta(Env* env, const string& prefix) {
+  BundleReader reader(env, prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  Tensor keys;
+  Tensor embeddings;
+  Tensor slots;
+  Tensor frequencies;
+  Tensor removed_keys;
+  TF_RETURN_IF_ERROR(reader.Lookup(kKeys, &keys));
+  TF_RETURN_IF_ERROR(reader.Lookup(kEmbeddings, &embeddings));
+  TF_RETURN_IF_ERROR(reader.Lookup(kSlots, &slots));
+  TF_RETURN_IF_ERROR(reader.Lookup(kFrequencies, &frequencies));
+  TF_RETURN_IF_ERROR(reader.Lookup(kRemovedKeys, &removed_keys));
+
+  const int64 dim = options_.embedding_dim;
+  const int64 n = keys.NumElements();
+  if (embeddings.shape() != TensorShape({n, dim}) ||
+      slots.shape() != TensorShape({n, options_.num_slots, dim}) ||
+      frequencies.shape() != TensorShape({n})) {
+    return errors::InvalidArgument(
+        "Delta ", prefix, " does not match a table with embedding_dim ", dim,
+        " and num_slots ", options_.num_slots, ": got embeddings of shape ",
+        embeddings.shape().DebugString(), " and slots of shape ",
+        slots.shape().DebugString());
+  }
+
+  mutex_lock l(mu_);
+  for (int64 i = 0; i < removed_keys.NumElements(); ++i) {
+    const int64 key = removed_keys.flat<int64>()(i);
+    auto it = rows_.find(key);
+    if (it != rows_.end()) RemoveRow(it->first, it->second);
+    removed_.erase(key);
+  }
+  const uint64 now = env_->NowSeconds();
+  for (int64 i = 0; i < n; ++i) {
+    const int64 key = keys.flat<int64>()(i);
+    bool created;
+    const int64 row = FindOrCreateRow(key, &created);
+    std::copy_n(embeddings.flat<float>().data() + i * dim, dim,
+                Embedding(row));
+    if (options_.num_slots > 0) {
+      std::copy_n(slots.flat<float>().data() + i * options_.num_slots * dim,
+                  options_.num_slots * dim, Slot(row, 0));
+    }
+    row_info_[row] = {key, frequencies.flat<int64>()(i), now};
+    pending_.erase(key);
+    dirty_.erase(key);
+  }
+  return Status::OK();
+}
+
+}  // namespace lookup
+}  // namespace tensorflow
@@ -0,0 +1,174 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DYNAMIC_EMBEDDING_TABLE_H_
+#define TENSORFLOW_CORE_KERNELS_DYNAMIC_EMBEDDING_TABLE_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// An embedding table from int64 ids to float rows of `embedding_dim` elements
+// that grows as unseen ids are looked up and evicts the ids that go cold.
+//
+// Besides its embedding, each row holds `num_slots` optimizer slots of the same
+// size, its access count and the time of its last access.  Lookup() returns
+// the rows of a batch of ids, admitting the ids seen at least `min_frequency`
+// times into the table, and ApplyAdagrad() updates the rows in place, so that
+// training does not need to copy rows in and out of a separate variable.
+//
+// Evict() drops the rows that were not accessed within a time to live and, past
+// a maximum size, the least frequently used ones.  The rows updated or dropped
+// since the previous SaveDelta() are tracked, so that each SaveDelta() writes
+// an incremental checkpoint; replaying a sequence of deltas with LoadDelta()
+// restores the table.
+//
+// The LookupInterface methods give access to the embeddings only: Find() does
+// not admit ids nor count accesses, and the rows created by Insert() and
+// ImportValues() start with initial slots.
+class DynamicEmbeddingTable : public LookupInterface {
+ public:
+  struct Options {
+    int64 embedding_dim = 1;
+    int64 num_slots = 0;
+    // Initial value of the optimizer slots of a new row.
+    float initial_slot_value = 0.0f;
+    // Number of lookups of an id before it is admitted into the table.
+    int64 min_frequency = 1;
+    // Clock used to time accesses; Env::Default() if null.
+    Env* env = nullptr;
+  };
+
+  explicit DynamicEmbeddingTable(const Options& options) { Init(options); }
+
+  // Reads the options from the attributes of the node defining the table.
+  DynamicEmbeddingTable(OpKernelContext* ctx, OpKernel* kernel);
+
+  size_t size() const override;
+
+  Status Find(OpKernelContext* ctx, const Tensor& keys, Tensor* values,
+              const Tensor& default_value) override;
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override;
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override;
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override;
+
+  Status ExportValues(OpKernelContext* ctx) override;
+
+  DataType key_dtype() const override { return DT_INT64; }
+
+  DataType value_dtype() const override { return DT_FLOAT; }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override {
+    return TensorShape({options_.embedding_dim});
+  }
+
+  int64 MemoryUsed() const override;
+
+  // Sets `values`, of shape `keys.shape + [embedding_dim]`, to the rows of
+  // `keys` and counts an access to each of them.  Ids that are not in the
+  // table get `initial_values`, which is either a single row or holds one row
+  // per id; once an id is admitted, its row starts from its initial value.
+  Status Lookup(const Tensor& keys, const Tensor& initial_values,
+                Tensor* values);
+
+  // Applies the Adagrad update of `grads`, of shape
+  // `keys.shape + [embedding_dim]`, to the rows of `keys` with learning rate
+  // `lr`.  The accumulator is the first slot.  Ids that are not in the table
+  // are skipped.
+  Status ApplyAdagrad(const Tensor& keys, const Tensor& grads, float lr);
+
+  // Evicts the rows that were not accessed in the last `ttl_seconds`, if
+  // positive, then the least frequently used rows beyond `max_size`, if
+  // positive.  Returns the number of evicted rows.
+  int64 Evict(int64 ttl_seconds, int64 max_size);
+
+  // Writes the rows updated and the ids removed since the previous call to a
+  // tensor bundle under `prefix`.
+  Status SaveDelta(Env* env, const string& prefix);
+
+  // Applies a delta written by SaveDelta() to the table.
+  Status LoadDelta(Env* env, const string& prefix);
+
+ private:
+  struct RowInfo {
+    int64 key;
+    int64 frequency;
+    uint64 last_access;
+  };
+
+  // Id that was looked up but not admitted yet.
+  struct PendingId {
+    int64 frequency;
+    uint64 last_access;
+  };
+
+  void Init(const Options& options);
+
+  // Returns the row of `key`, creating it if needed.
+  int64 FindOrCreateRow(int64 key, bool* created)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RemoveRow(int64 key, int64 row) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void ClearLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  float* Embedding(int64 row) TF_SHARED_LOCKS_REQUIRED(mu_) {
+    return &embeddings_[row * options_.embedding_dim];
+  }
+  float* Slot(int64 row, int64 slot) TF_SHARED_LOCKS_REQUIRED(mu_) {
+    return &slots_[(row * options_.num_slots + slot) * options_.embedding_dim];
+  }
+
+  Options options_;
+  Env* env_;
+
+  mutable mutex mu_;
+  // Maps each id in the table to its row.
+  absl::flat_hash_map<int64, int64> rows_ TF_GUARDED_BY(mu_);
+  std::vector<float> embeddings_ TF_GUARDED_BY(mu_);
+  std::vector<float> slots_ TF_GUARDED_BY(mu_);
+  std::vector<RowInfo> row_info_ TF_GUARDED_BY(mu_);
+  // Rows of removed ids, reused by later inserts.
+  std::vector<int64> free_rows_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<int64, PendingId> pending_ TF_GUARDED_BY(mu_);
+  // Ids updated, resp. removed, since the last SaveDelta().
+  absl::flat_hash_set<int64> dirty_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_set<int64> removed_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DynamicEmbeddingTable);
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DYNAMIC_EMBEDDING_TABLE_H_
@@ -0,0 +1,213 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/dynamic_embedding_table.h"
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+// Env whose clock is set by the test.
+class FakeClockEnv : public EnvWrapper {
+ public:
+  FakeClockEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64 NowMicros() const override { return now_seconds_ * 1000000; }
+  uint64 NowSeconds() const override { return now_seconds_; }
+
+  void SetNowSeconds(uint64 now_seconds) { now_seconds_ = now_seconds; }
+
+ private:
+  uint64 now_seconds_ = 100;
+};
+
+class DynamicEmbeddingTableTest : public ::testing::Test {
+ protected:
+  // Creates a table of 2-d embeddings.
+  core::RefCountPtr<DynamicEmbeddingTable> MakeTable(int64 num_slots,
+                                                     int64 min_frequency) {
+    DynamicEmbeddingTable::Options options;
+    options.embedding_dim = 2;
+    options.num_slots = num_slots;
+    options.initial_slot_value = 1.0f;
+    options.min_frequency = min_frequency;
+    options.env = &env_;
+    return core::RefCountPtr<DynamicEmbeddingTable>(
+        new DynamicEmbeddingTable(options));
+  }
+
+  static Tensor Lookup(DynamicEmbeddingTable* table,
+                       const std::vector<int64>& keys, float initial_value) {
+    const int64 n = keys.size();
+    Tensor values(DT_FLOAT, TensorShape({n, 2}));
+    TF_CHECK_OK(table->Lookup(test::AsTensor<int64>(keys),
+                              test::AsTensor<float>({initial_value, 0.0f}),
+                              &values));
+    return values;
+  }
+
+  FakeClockEnv env_;
+};
+
+TEST_F(DynamicEmbeddingTableTest, LookupAdmitsNewIds) {
+  auto table = MakeTable(/*num_slots=*/0, /*min_frequency=*/1);
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 0, 1, 0}, TensorShape({2, 2})),
+      Lookup(table.get(), {3, 5}, 1.0f));
+  EXPECT_EQ(2, table->size());
+  // Existing rows keep their value.
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 0, 2, 0}, TensorShape({2, 2})),
+      Lookup(table.get(), {5, 7}, 2.0f));
+  EXPECT_EQ(3, table->size());
+
+  // Per-id initial values.
+  Tensor values(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(table->Lookup(
+      test::AsTensor<int64>({7, 9}),
+      test::AsTensor<float>({0, 0, 4, 5}, TensorShape({2, 2})), &values));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({2, 0, 4, 5}, TensorShape({2, 2})), values);
+  EXPECT_TRUE(errors::IsInvalidArgument(table->Lookup(
+      test::AsTensor<int64>({7, 9}), test::AsTensor<float>({0, 0, 0}),
+      &values)));
+}
+
+TEST_F(DynamicEmbeddingTableTest, FrequencyFiltering) {
+  auto table = MakeTable(/*num_slots=*/0, /*min_frequency=*/3);
+  Lookup(table.get(), {1, 1, 2}, 1.0f);
+  EXPECT_EQ(0, table->size());
+  // The third lookup of id 1 admits it with the initial value of that lookup.
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({3, 0, 3, 0}, TensorShape({2, 2})),
+      Lookup(table.get(), {1, 2}, 3.0f));
+  EXPECT_EQ(1, table->size());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({3, 0, 4, 0}, TensorShape({2, 2})),
+      Lookup(table.get(), {1, 2}, 4.0f));
+  EXPECT_EQ(2, table->size());
+}
+
+TEST_F(DynamicEmbeddingTableTest, ApplyAdagrad) {
+  auto table = MakeTable(/*num_slots=*/1, /*min_frequency=*/1);
+  Lookup(table.get(), {1}, 1.0f);
+  // Id 2 is not in the table, so its gradient is dropped.
+  TF_ASSERT_OK(table->ApplyAdagrad(
+      test::AsTensor<int64>({1, 2}),
+      test::AsTensor<float>({3, 4, 1, 1}, TensorShape({2, 2})), 0.5f));
+  EXPECT_EQ(1, table->size());
+  // accum = 1 + g^2, value -= 0.5 * g / sqrt(accum).
+  test::ExpectTensorNear<float>(
+      test::AsTensor<float>({1 - 1.5f / std::sqrt(10.0f),
+                             -2.0f / std::sqrt(17.0f)},
+                            TensorShape({1, 2})),
+      Lookup(table.get(), {1}, 0.0f), 1e-6);
+
+  auto no_slots = MakeTable(/*num_slots=*/0, /*min_frequency=*/1);
+  EXPECT_TRUE(errors::IsFailedPrecondition(no_slots->ApplyAdagrad(
+      test::AsTensor<int64>({1}),
+      test::AsTensor<float>({1, 1}, TensorShape({1, 2})), 0.5f)));
+}
+
+TEST_F(DynamicEmbeddingTableTest, EvictExpiredRows) {
+  auto table = MakeTable(/*num_slots=*/0, /*min_frequency=*/1);
+  Lookup(table.get(), {1, 2}, 1.0f);
+  env_.SetNowSeconds(150);
+  Lookup(table.get(), {2, 3}, 1.0f);
+  env_.SetNowSeconds(170);
+  EXPECT_EQ(1, table->Evict(/*ttl_seconds=*/60, /*max_size=*/0));
+  EXPECT_EQ(2, table->size());
+  // Id 1 was evicted, so it gets its initial value again.
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({5, 0}, TensorShape({1, 2})),
+      Lookup(table.get(), {1}, 5.0f));
+}
+
+TEST_F(DynamicEmbeddingTableTest, EvictLeastFrequentlyUsedRows) {
+  auto table = MakeTable(/*num_slots=*/0, /*min_frequency=*/1);
+  Lookup(table.get(), {1, 1, 1, 2, 3, 3}, 1.0f);
+  env_.SetNowSeconds(200);
+  Lookup(table.get(), {4}, 1.0f);
+  // Ids 2 and 4 were used once, and 2 less recently.
+  EXPECT_EQ(1, table->Evict(/*ttl_seconds=*/0, /*max_size=*/3));
+  EXPECT_EQ(3, table->size());
+  Tensor values(DT_FLOAT, TensorShape({4, 2}));
+  TF_ASSERT_OK(table->Find(nullptr, test::AsTensor<int64>({1, 2, 3, 4}),
+                           &values, test::AsTensor<float>({-1, -1})));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 0, -1, -1, 1, 0, 1, 0}, TensorShape({4, 2})),
+      values);
+}
+
+TEST_F(DynamicEmbeddingTableTest, IncrementalCheckpoints) {
+  const string dir = io::JoinPath(testing::TmpDir(), "dynamic_embedding");
+  auto table = MakeTable(/*num_slots=*/1, /*min_frequency=*/1);
+  Lookup(table.get(), {1, 2, 3}, 1.0f);
+  TF_ASSERT_OK(table->SaveDelta(Env::Default(), io::JoinPath(dir, "delta0")));
+
+  TF_ASSERT_OK(table->ApplyAdagrad(
+      test::AsTensor<int64>({2}),
+      test::AsTensor<float>({1, 1}, TensorShape({1, 2})), 1.0f));
+  TF_ASSERT_OK(table->Remove(nullptr, test::AsTensor<int64>({3})));
+  Lookup(table.get(), {4}, 7.0f);
+  TF_ASSERT_OK(table->SaveDelta(Env::Default(), io::JoinPath(dir, "delta1")));
+
+  // The second delta only holds the changes since the first one.
+  BundleReader reader(Env::Default(), io::JoinPath(dir, "delta1"));
+  TF_ASSERT_OK(reader.status());
+  Tensor keys;
+  TF_ASSERT_OK(reader.Lookup("keys", &keys));
+  EXPECT_EQ(2, keys.NumElements());
+  Tensor removed_keys;
+  TF_ASSERT_OK(reader.Lookup("removed_keys", &removed_keys));
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({3}), removed_keys);
+
+  auto restored = MakeTable(/*num_slots=*/1, /*min_frequency=*/1);
+  TF_ASSERT_OK(
+      restored->LoadDelta(Env::Default(), io::JoinPath(dir, "delta0")));
+  TF_ASSERT_OK(
+      restored->LoadDelta(Env::Default(), io::JoinPath(dir, "delta1")));
+  EXPECT_EQ(3, restored->size());
+  const Tensor expected = Lookup(table.get(), {1, 2, 3, 4}, -1.0f);
+  test::ExpectTensorEqual<float>(expected,
+                                 Lookup(restored.get(), {1, 2, 3, 4}, -1.0f));
+  // The slots were restored too.
+  for (DynamicEmbeddingTable* t : {table.get(), restored.get()}) {
+    TF_ASSERT_OK(t->ApplyAdagrad(
+        test::AsTensor<int64>({2}),
+        test::AsTensor<float>({1, 1}, TensorShape({1, 2})), 1.0f));
+  }
+  test::ExpectTensorEqual<float>(Lookup(table.get(), {2}, 0.0f),
+                                 Lookup(restored.get(), {2}, 0.0f));
+
+  auto mismatched = MakeTable(/*num_slots=*/0, /*min_frequency=*/1);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      mismatched->LoadDelta(Env::Default(), io::JoinPath(dir, "delta0"))));
+}
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
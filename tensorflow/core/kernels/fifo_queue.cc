@@ -47,8 +47,49 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   }
 }
 
+Status FIFOQueue::DequeueManyLocked(OpKernelContext* ctx, int64 num_elements,
+                                    int64 index, Tuple* batch) {
+  DCHECK_GE(queues_[0].size(), num_elements);
+  Status status;
+  for (int i = 0; i < num_components(); ++i) {
+    auto begin = queues_[i].begin();
+    for (int64 k = 0; status.ok() && k < num_elements; ++k) {
+      // Releases the queue's reference first, so that the copy may be
+      // optimized to a move.
+      Tensor element = *begin[k].AccessTensor(ctx);
+      begin[k] = PersistentTensor();
+      status = batch_util::CopyElementToSlice(std::move(element), &(*batch)[i],
+                                              index + k);
+    }
+    // Keeps the components aligned, even if a copy failed.
+    queues_[i].erase(begin, begin + num_elements);
+  }
+  return status;
+}
+
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
+  // Fast path: when no enqueue is blocked ahead of this one and there is
+  // room, enqueues without registering an attempt.
+  bool enqueued = false;
+  bool flush = false;
+  {
+    mutex_lock l(mu_);
+    if (!closed_ && enqueue_attempts_.empty() &&
+        queues_[0].size() < static_cast<size_t>(capacity_)) {
+      for (int i = 0; i < num_components(); ++i) {
+        queues_[i].push_back(PersistentTensor(tuple[i]));
+      }
+      enqueued = true;
+      flush = !dequeue_attempts_.empty();
+    }
+  }
+  if (enqueued) {
+    if (flush) FlushUnlocked();
+    callback();
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -107,6 +148,32 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     return;
   }
 
+  bool enqueued = false;
+  bool flush = false;
+  {
+    mutex_lock l(mu_);
+    if (!closed_ && enqueue_attempts_.empty() &&
+        queues_[0].size() + batch_size <= static_cast<size_t>(capacity_)) {
+      Status status;
+      for (int64 index = 0; status.ok() && index < batch_size; ++index) {
+        for (int i = 0; i < num_components(); ++i) {
+          PersistentTensor element;
+          status = GetElementComponentFromBatch(tuple, index, i, ctx, &element);
+          if (!status.ok()) break;
+          queues_[i].push_back(element);
+        }
+      }
+      ctx->SetStatus(status);
+      enqueued = true;
+      flush = !dequeue_attempts_.empty();
+    }
+  }
+  if (enqueued) {
+    if (flush) FlushUnlocked();
+    callback();
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -153,6 +220,25 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 }
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
+  // Fast path: when no dequeue is blocked ahead of this one and an element is
+  // available, dequeues without registering an attempt.
+  bool dequeued = false;
+  bool flush = false;
+  Tuple tuple;
+  {
+    mutex_lock l(mu_);
+    if (dequeue_attempts_.empty() && !queues_[0].empty()) {
+      DequeueLocked(ctx, &tuple);
+      dequeued = true;
+      flush = !enqueue_attempts_.empty();
+    }
+  }
+  if (dequeued) {
+    if (flush) FlushUnlocked();
+    callback(tuple);
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -244,6 +330,38 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
     return;
   }
 
+  bool dequeued = false;
+  bool flush = false;
+  Tuple tuple;
+  {
+    mutex_lock l(mu_);
+    if (dequeue_attempts_.empty() &&
+        queues_[0].size() >= static_cast<size_t>(num_elements)) {
+      Status status;
+      tuple.reserve(num_components());
+      for (int i = 0; status.ok() && i < num_components(); ++i) {
+        Tensor element;
+        status = ctx->allocate_temp(component_dtypes_[i],
+                                    ManyOutShape(i, num_elements), &element);
+        tuple.emplace_back(element);
+      }
+      if (status.ok()) {
+        status = DequeueManyLocked(ctx, num_elements, 0, &tuple);
+      }
+      if (!status.ok()) {
+        ctx->SetStatus(status);
+        tuple.clear();
+      }
+      dequeued = true;
+      flush = !enqueue_attempts_.empty();
+    }
+  }
+  if (dequeued) {
+    if (flush) FlushUnlocked();
+    callback(tuple);
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -306,44 +424,38 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
               }
             }
 
-            RunResult result = kNoProgress;
-            for (; queue_size > 0; --queue_size) {
-              if (attempt->tuple.empty()) {
-                // Only allocate tuple when we have something to dequeue
-                // so we don't use excessive memory when there are many
-                // blocked dequeue attempts waiting.
-                attempt->tuple.reserve(num_components());
-                for (int i = 0; i < num_components(); ++i) {
-                  const TensorShape shape =
-                      ManyOutShape(i, attempt->elements_requested);
-                  Tensor element;
-                  attempt->context->SetStatus(attempt->context->allocate_temp(
-                      component_dtypes_[i], shape, &element));
-                  if (!attempt->context->status().ok()) return kComplete;
-                  attempt->tuple.emplace_back(element);
-                }
-              }
-              result = kProgress;
-              Tuple tuple;
-              DequeueLocked(attempt->context, &tuple);
-              const int64 index =
-                  attempt->tuple[0].dim_size(0) - attempt->elements_requested;
+            if (queue_size == 0) return kNoProgress;
+            if (attempt->tuple.empty()) {
+              // Only allocate tuple when we have something to dequeue
+              // so we don't use excessive memory when there are many
+              // blocked dequeue attempts waiting.
+              attempt->tuple.reserve(num_components());
               for (int i = 0; i < num_components(); ++i) {
-                attempt->context->SetStatus(batch_util::CopyElementToSlice(
-                    std::move(tuple[i]), &attempt->tuple[i], index));
+                const TensorShape shape =
+                    ManyOutShape(i, attempt->elements_requested);
+                Tensor element;
+                attempt->context->SetStatus(attempt->context->allocate_temp(
+                    component_dtypes_[i], shape, &element));
                 if (!attempt->context->status().ok()) return kComplete;
-              }
-              tuple.clear();
-              --attempt->elements_requested;
-              if (attempt->elements_requested == 0) {
-                tuple = attempt->tuple;
-                attempt->done_callback = [callback, tuple]() {
-                  callback(tuple);
-                };
-                return kComplete;
+                attempt->tuple.emplace_back(element);
               }
             }
-            return result;
+            const int64 num_dequeued =
+                std::min<int64>(queue_size, attempt->elements_requested);
+            const int64 index =
+                attempt->tuple[0].dim_size(0) - attempt->elements_requested;
+            attempt->context->SetStatus(DequeueManyLocked(
+                attempt->context, num_dequeued, index, &attempt->tuple));
+            if (!attempt->context->status().ok()) return kComplete;
+            attempt->elements_requested -= num_dequeued;
+            if (attempt->elements_requested == 0) {
+              Tuple tuple = attempt->tuple;
+              attempt->done_callback = [callback, tuple]() {
+                callback(tuple);
+              };
+              return kComplete;
+            }
+            return kProgress;
           });
     }
   }
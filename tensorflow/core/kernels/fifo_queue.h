@@ -61,6 +61,13 @@ class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Copies the first `num_elements` elements of queues_ into consecutive
+  // slices of the components of `batch`, starting at slice `index`, and
+  // removes them from queues_. Copies one component at a time.
+  Status DequeueManyLocked(OpKernelContext* ctx, int64 num_elements,
+                           int64 index, Tuple* batch)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   static Status GetElementComponentFromBatch(const Tuple& tuple, int64 index,
                                              int component,
                                              OpKernelContext* ctx,
@@ -0,0 +1,352 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_attention_op.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+using GPUDevice = Eigen::GpuDevice;
+
+namespace functor {
+
+// Computes blocks of query rows in parallel. The scores of a block of rows
+// are computed for one block of keys at a time, and folded into the output
+// with an online softmax: the running maximum and sum of each row are updated
+// and the partial output is rescaled when the maximum changes. So the scores
+// never exceed [kQueryBlock, kKeyBlock], which stays in cache.
+template <typename T>
+struct FusedAttention<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T, 3>::ConstTensor query,
+                  typename TTypes<T, 3>::ConstTensor key,
+                  typename TTypes<T, 3>::ConstTensor value,
+                  const AttentionMask<T>& mask, float scale,
+                  typename TTypes<T, 3>::Tensor output) {
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        Matrix;
+    typedef Eigen::Map<const Matrix> ConstMatrixMap;
+    typedef Eigen::Map<Matrix> MatrixMap;
+    typedef Eigen::Matrix<T, Eigen::Dynamic, 1> Vector;
+    const int64 kQueryBlock = 32;
+    const int64 kKeyBlock = 128;
+
+    const int64 batch = query.dimension(0);
+    const int64 num_queries = query.dimension(1);
+    const int64 depth = query.dimension(2);
+    const int64 num_keys = key.dimension(1);
+    const int64 value_depth = value.dimension(2);
+    const int64 num_query_blocks = Eigen::divup(num_queries, kQueryBlock);
+    const T lowest = -std::numeric_limits<T>::infinity();
+
+    auto compute_blocks = [&](int64 start, int64 limit) {
+      Matrix scores(kQueryBlock, kKeyBlock);
+      Matrix accumulator(kQueryBlock, value_depth);
+      Vector row_max(kQueryBlock);
+      Vector row_sum(kQueryBlock);
+
+      for (int64 i = start; i < limit; ++i) {
+        const int64 b = i / num_query_blocks;
+        const int64 query_begin = (i % num_query_blocks) * kQueryBlock;
+        const int64 block_queries =
+            std::min(kQueryBlock, num_queries - query_begin);
+        ConstMatrixMap query_block(
+            query.data() + (b * num_queries + query_begin) * depth,
+            block_queries, depth);
+        const T* mask_block =
+            mask.data == nullptr ? nullptr
+                                 : mask.data + mask.BatchOffset(b) +
+                                       query_begin * mask.query_stride;
+
+        accumulator.topRows(block_queries).setZero();
+        row_max.head(block_queries).setConstant(lowest);
+        row_sum.head(block_queries).setZero();
+
+        for (int64 key_begin = 0; key_begin < num_keys;
+             key_begin += kKeyBlock) {
+          const int64 block_keys = std::min(kKeyBlock, num_keys - key_begin);
+          ConstMatrixMap key_block(
+              key.data() + (b * num_keys + key_begin) * depth, block_keys,
+              depth);
+          ConstMatrixMap value_block(
+              value.data() + (b * num_keys + key_begin) * value_depth,
+              block_keys, value_depth);
+
+          auto block_scores = scores.topLeftCorner(block_queries, block_keys);
+          block_scores.noalias() = query_block * key_block.transpose();
+          block_scores *= static_cast<T>(scale);
+          if (mask_block != nullptr) {
+            for (int64 r = 0; r < block_queries; ++r) {
+              const T* mask_row = mask_block + r * mask.query_stride +
+                                  key_begin * mask.key_stride;
+              for (int64 c = 0; c < block_keys; ++c) {
+                block_scores(r, c) += mask_row[c * mask.key_stride];
+              }
+            }
+          }
+
+          for (int64 r = 0; r < block_queries; ++r) {
+            const T new_max =
+                std::max(row_max(r), block_scores.row(r).maxCoeff());
+            if (new_max == lowest) {
+              // Every key seen so far is masked out with -inf.
+              block_scores.row(r).setZero();
+              continue;
+            }
+            const T correction = std::exp(row_max(r) - new_max);
+            block_scores.row(r) =
+                (block_scores.row(r).array() - new_max).exp().matrix();
+            row_sum(r) = row_sum(r) * correction + block_scores.row(r).sum();
+            accumulator.row(r) *= correction;
+            row_max(r) = new_max;
+          }
+          accumulator.topRows(block_queries).noalias() +=
+              block_scores * value_block;
+        }
+
+        MatrixMap output_block(
+            output.data() + (b * num_queries + query_begin) * value_depth,
+            block_queries, value_depth);
+        output_block = (accumulator.topRows(block_queries).array().colwise() /
+                        row_sum.head(block_queries).array())
+                           .matrix();
+      }
+    };
+
+    // Each block of query rows reads all the keys and values of its batch.
+    const double cost_per_block =
+        kQueryBlock * num_keys * (depth + value_depth) * 2;
+    d.parallelFor(batch * num_query_blocks,
+                  Eigen::TensorOpCost(
+                      num_keys * (depth + value_depth) * sizeof(T),
+                      kQueryBlock * value_depth * sizeof(T), cost_per_block),
+                  compute_blocks);
+  }
+};
+
+}  // namespace functor
+
+namespace {
+
+// Returns in `mask` the layout of `mask_tensor`, broadcast to `scores_shape`.
+template <typename T>
+Status GetAttentionMask(const Tensor& mask_tensor,
+                        const TensorShape& scores_shape,
+                        AttentionMask<T>* mask) {
+  const int rank = scores_shape.dims();
+  if (mask_tensor.dims() > rank) {
+    return errors::InvalidArgument(
+        "mask must have at most ", rank, " dimensions, got ",
+        mask_tensor.shape().DebugString());
+  }
+  // The dimensions of the mask, left padded with ones, and their strides.
+  std::vector<int64> dims(rank, 1);
+  for (int i = 0; i < mask_tensor.dims(); ++i) {
+    dims[rank - mask_tensor.dims() + i] = mask_tensor.dim_size(i);
+  }
+  std::vector<int64> strides(rank, 1);
+  for (int i = rank - 2; i >= 0; --i) strides[i] = strides[i + 1] * dims[i + 1];
+  for (int i = 0; i < rank; ++i) {
+    if (dims[i] != 1 && dims[i] != scores_shape.dim_size(i)) {
+      return errors::InvalidArgument(
+          "mask of shape ", mask_tensor.shape().DebugString(),
+          " is not broadcastable to the scores of shape ",
+          scores_shape.DebugString());
+    }
+  }
+
+  // Merges the batch dimensions into runs of broadcast and of non broadcast
+  // dimensions, of which there can be at most two.
+  struct Run {
+    bool broadcast;
+    int64 size;
+    int64 stride;
+  };
+  std::vector<Run> runs;
+  for (int i = 0; i < rank - 2; ++i) {
+    if (scores_shape.dim_size(i) == 1) continue;
+    const bool broadcast = dims[i] == 1;
+    if (!runs.empty() && runs.back().broadcast == broadcast) {
+      runs.back().size *= scores_shape.dim_size(i);
+      runs.back().stride = broadcast ? 0 : strides[i];
+    } else {
+      runs.push_back({broadcast, scores_shape.dim_size(i),
+                      broadcast ? 0 : strides[i]});
+    }
+  }
+  if (runs.size() > 2) {
+    return errors::Unimplemented(
+        "mask of shape ", mask_tensor.shape().DebugString(),
+        " alternates broadcast and non broadcast batch dimensions of the "
+        "scores of shape ",
+        scores_shape.DebugString());
+  }
+
+  mask->data = mask_tensor.flat<T>().data();
+  if (runs.size() == 2) {
+    mask->batch_inner = runs[1].size;
+    mask->batch_outer_stride = runs[0].stride;
+    mask->batch_inner_stride = runs[1].stride;
+  } else if (runs.size() == 1) {
+    mask->batch_inner = runs[0].size;
+    mask->batch_inner_stride = runs[0].stride;
+  }
+  mask->query_stride = dims[rank - 2] == 1 ? 0 : strides[rank - 2];
+  mask->key_stride = dims[rank - 1] == 1 ? 0 : 1;
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename Device, typename T>
+class FusedAttentionOp : public OpKernel {
+ public:
+  explicit FusedAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, num_args <= 1,
+                errors::InvalidArgument(
+                    "_FusedAttention supports at most one mask, got num_args=",
+                    num_args));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+
+    const int rank = query.dims();
+    OP_REQUIRES(context, rank >= 3,
+                errors::InvalidArgument("query must have rank >= 3, got ",
+                                        query.shape().DebugString()));
+    OP_REQUIRES(
+        context, key.dims() == rank && value.dims() == rank,
+        errors::InvalidArgument(
+            "query, key and value must have the same rank, got ",
+            query.shape().DebugString(), ", ", key.shape().DebugString(),
+            " and ", value.shape().DebugString()));
+    int64 batch = 1;
+    for (int i = 0; i < rank - 2; ++i) {
+      OP_REQUIRES(
+          context,
+          key.dim_size(i) == query.dim_size(i) &&
+              value.dim_size(i) == query.dim_size(i),
+          errors::InvalidArgument(
+              "query, key and value must have the same batch dimensions, got ",
+              query.shape().DebugString(), ", ", key.shape().DebugString(),
+              " and ", value.shape().DebugString()));
+      batch *= query.dim_size(i);
+    }
+    const int64 num_queries = query.dim_size(rank - 2);
+    const int64 depth = query.dim_size(rank - 1);
+    const int64 num_keys = key.dim_size(rank - 2);
+    const int64 value_depth = value.dim_size(rank - 1);
+    OP_REQUIRES(context, key.dim_size(rank - 1) == depth,
+                errors::InvalidArgument(
+                    "query and key must have the same depth, got ",
+                    query.shape().DebugString(), " and ",
+                    key.shape().DebugString()));
+    OP_REQUIRES(context, value.dim_size(rank - 2) == num_keys,
+                errors::InvalidArgument(
+                    "key and value must have the same number of keys, got ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+
+    AttentionMask<T> mask;
+    if (context->num_inputs() > 3) {
+      TensorShape scores_shape = query.shape();
+      scores_shape.set_dim(rank - 1, num_keys);
+      OP_REQUIRES_OK(context, GetAttentionMask(context->input(3), scores_shape,
+                                               &mask));
+    }
+
+    TensorShape output_shape = query.shape();
+    output_shape.set_dim(rank - 1, value_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    const Device& d = context->eigen_device<Device>();
+    if (num_keys == 0) {
+      // The softmax of no scores is empty, and so is the sum of the values.
+      output->flat<T>().device(d) = output->flat<T>().constant(T(0));
+      return;
+    }
+
+    functor::FusedAttention<Device, T>()(
+        d, query.shaped<T, 3>({batch, num_queries, depth}),
+        key.shaped<T, 3>({batch, num_keys, depth}),
+        value.shaped<T, 3>({batch, num_keys, value_depth}), mask, scale_,
+        output->shaped<T, 3>({batch, num_queries, value_depth}));
+  }
+
+ private:
+  float scale_;
+};
+
+#define REGISTER_CPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedAttention").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedAttentionOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+#undef REGISTER_CPU
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                 \
+  template <>                                                               \
+  void FusedAttention<GPUDevice, T>::operator()(                            \
+      const GPUDevice& d, typename TTypes<T, 3>::ConstTensor query,         \
+      typename TTypes<T, 3>::ConstTensor key,                               \
+      typename TTypes<T, 3>::ConstTensor value,                             \
+      const AttentionMask<T>& mask, float scale,                            \
+      typename TTypes<T, 3>::Tensor output);
+
+TF_CALL_half(DECLARE_GPU_SPEC);
+TF_CALL_float(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedAttention").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedAttentionOp<GPUDevice, T>);
+
+TF_CALL_half(REGISTER_GPU);
+TF_CALL_float(REGISTER_GPU);
+#undef REGISTER_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
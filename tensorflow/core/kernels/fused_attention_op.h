@@ -0,0 +1,65 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Additive attention mask, broadcast to the [batch, num_queries, num_keys]
+// scores. The flattened batch index b is split into b / batch_inner and
+// b % batch_inner, which is enough for the masks used in practice, e.g. a
+// [batch, 1, 1, num_keys] padding mask of [batch, heads, ...] scores.
+template <typename T>
+struct AttentionMask {
+  // nullptr if there is no mask.
+  const T* data = nullptr;
+  int64 batch_inner = 1;
+  int64 batch_outer_stride = 0;
+  int64 batch_inner_stride = 0;
+  // 0 if the mask is broadcast along the dimension.
+  int64 query_stride = 0;
+  int64 key_stride = 0;
+
+  EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE int64 BatchOffset(int64 b) const {
+    return (b / batch_inner) * batch_outer_stride +
+           (b % batch_inner) * batch_inner_stride;
+  }
+};
+
+namespace functor {
+
+// Computes softmax(query * key^T * scale + mask) * value for each batch.
+template <typename Device, typename T>
+struct FusedAttention {
+  // query: [batch, num_queries, depth]
+  // key: [batch, num_keys, depth]
+  // value: [batch, num_keys, value_depth]
+  // output: [batch, num_queries, value_depth]
+  void operator()(const Device& d, typename TTypes<T, 3>::ConstTensor query,
+                  typename TTypes<T, 3>::ConstTensor key,
+                  typename TTypes<T, 3>::ConstTensor value,
+                  const AttentionMask<T>& mask, float scale,
+                  typename TTypes<T, 3>::Tensor output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
@@ -0,0 +1,169 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/fused_attention_op.h"
+#include "tensorflow/core/kernels/gpu_prim.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+constexpr int kThreadsPerBlock = 128;
+
+// Computes one output row per block. The block computes the scores of
+// kThreadsPerBlock keys at a time, one per thread, and folds them into the
+// output row with an online softmax, so the scores are never written to
+// global memory. The scaled query row and the output row are kept in shared
+// memory, in float.
+template <typename T>
+__global__ __launch_bounds__(kThreadsPerBlock) void FusedAttentionKernel(
+    const T* __restrict__ query, const T* __restrict__ key,
+    const T* __restrict__ value, AttentionMask<T> mask, float scale,
+    int64 num_queries, int64 num_keys, int64 depth, int64 value_depth,
+    T* __restrict__ output) {
+  typedef gpuprim::BlockReduce<float, kThreadsPerBlock> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  __shared__ float probabilities[kThreadsPerBlock];
+  __shared__ float block_max;
+  __shared__ float block_sum;
+
+  GPU_DYNAMIC_SHARED_MEM_DECL(sizeof(float), unsigned char, shared_memory);
+  float* query_row = reinterpret_cast<float*>(shared_memory);
+  float* output_row = query_row + depth;
+
+  const int64 row = blockIdx.x;
+  const int64 b = row / num_queries;
+  const int64 q = row % num_queries;
+  const int tid = threadIdx.x;
+  for (int64 i = tid; i < depth; i += kThreadsPerBlock) {
+    query_row[i] = static_cast<float>(query[row * depth + i]) * scale;
+  }
+  for (int64 j = tid; j < value_depth; j += kThreadsPerBlock) {
+    output_row[j] = 0.0f;
+  }
+  const T* mask_row = mask.data == nullptr
+                          ? nullptr
+                          : mask.data + mask.BatchOffset(b) +
+                                q * mask.query_stride;
+  __syncthreads();
+
+  const float lowest = -Eigen::NumTraits<float>::infinity();
+  float running_max = lowest;
+  float running_sum = 0.0f;
+  for (int64 key_begin = 0; key_begin < num_keys;
+       key_begin += kThreadsPerBlock) {
+    const int num_block_keys =
+        min(static_cast<int64>(kThreadsPerBlock), num_keys - key_begin);
+    const int64 k = key_begin + tid;
+    float score = lowest;
+    if (tid < num_block_keys) {
+      const T* key_row = key + (b * num_keys + k) * depth;
+      score = 0.0f;
+      for (int64 i = 0; i < depth; ++i) {
+        score += query_row[i] * static_cast<float>(key_row[i]);
+      }
+      if (mask_row != nullptr) {
+        score += static_cast<float>(mask_row[k * mask.key_stride]);
+      }
+    }
+    const float max =
+        BlockReduce(temp_storage).Reduce(score, gpuprim::Max(), num_block_keys);
+    if (tid == 0) block_max = max;
+    __syncthreads();
+
+    const float new_max = fmaxf(running_max, block_max);
+    // Every key seen so far may be masked out with -inf.
+    const bool all_masked = new_max == lowest;
+    const float correction = all_masked ? 1.0f : expf(running_max - new_max);
+    const float probability =
+        all_masked || tid >= num_block_keys ? 0.0f : expf(score - new_max);
+    probabilities[tid] = probability;
+    const float sum = BlockReduce(temp_storage).Sum(probability);
+    if (tid == 0) block_sum = sum;
+    __syncthreads();
+
+    running_sum = running_sum * correction + block_sum;
+    running_max = new_max;
+    const T* value_block = value + (b * num_keys + key_begin) * value_depth;
+    for (int64 j = tid; j < value_depth; j += kThreadsPerBlock) {
+      float accumulator = output_row[j] * correction;
+      for (int t = 0; t < num_block_keys; ++t) {
+        accumulator += probabilities[t] *
+                       static_cast<float>(value_block[t * value_depth + j]);
+      }
+      output_row[j] = accumulator;
+    }
+    // The probabilities and reduction results are overwritten by the next
+    // block of keys.
+    __syncthreads();
+  }
+
+  for (int64 j = tid; j < value_depth; j += kThreadsPerBlock) {
+    output[row * value_depth + j] =
+        static_cast<T>(output_row[j] / running_sum);
+  }
+}
+
+template <typename T>
+void LaunchFusedAttention(const GPUDevice& d,
+                          typename TTypes<T, 3>::ConstTensor query,
+                          typename TTypes<T, 3>::ConstTensor key,
+                          typename TTypes<T, 3>::ConstTensor value,
+                          const AttentionMask<T>& mask, float scale,
+                          typename TTypes<T, 3>::Tensor output) {
+  const int64 batch = query.dimension(0);
+  const int64 num_queries = query.dimension(1);
+  const int64 depth = query.dimension(2);
+  const int64 num_keys = key.dimension(1);
+  const int64 value_depth = value.dimension(2);
+  const int64 shared_memory_size = (depth + value_depth) * sizeof(float);
+  TF_CHECK_OK(GpuLaunchKernel(FusedAttentionKernel<T>, batch * num_queries,
+                              kThreadsPerBlock, shared_memory_size, d.stream(),
+                              query.data(), key.data(), value.data(), mask,
+                              scale, num_queries, num_keys, depth, value_depth,
+                              output.data()));
+}
+
+}  // namespace
+
+namespace functor {
+
+#define DEFINE_GPU_SPEC(T)                                                   \
+  template <>                                                                \
+  void FusedAttention<GPUDevice, T>::operator()(                             \
+      const GPUDevice& d, typename TTypes<T, 3>::ConstTensor query,          \
+      typename TTypes<T, 3>::ConstTensor key,                                \
+      typename TTypes<T, 3>::ConstTensor value,                              \
+      const AttentionMask<T>& mask, float scale,                             \
+      typename TTypes<T, 3>::Tensor output) {                                \
+    LaunchFusedAttention<T>(d, query, key, value, mask, scale, output);      \
+  }
+
+TF_CALL_half(DEFINE_GPU_SPEC);
+TF_CALL_float(DEFINE_GPU_SPEC);
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -0,0 +1,275 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor RandomTensor(const TensorShape& shape, uint64 seed) {
+  random::PhiloxRandom philox(seed);
+  random::SimplePhilox rng(&philox);
+  Tensor tensor(DT_FLOAT, shape);
+  auto values = tensor.flat<float>();
+  for (int64 i = 0; i < values.size(); ++i) {
+    values(i) = rng.RandFloat() * 2.0f - 1.0f;
+  }
+  return tensor;
+}
+
+// Computes softmax(query * key^T * scale + mask) * value of rank 4 inputs, in
+// double. `mask` is [batch, 1, 1, num_keys] or empty.
+Tensor ReferenceAttention(const Tensor& query, const Tensor& key,
+                          const Tensor& value, const Tensor* mask,
+                          float scale) {
+  const int64 batch = query.dim_size(0);
+  const int64 heads = query.dim_size(1);
+  const int64 num_queries = query.dim_size(2);
+  const int64 depth = query.dim_size(3);
+  const int64 num_keys = key.dim_size(2);
+  const int64 value_depth = value.dim_size(3);
+  auto q = query.tensor<float, 4>();
+  auto k = key.tensor<float, 4>();
+  auto v = value.tensor<float, 4>();
+  Tensor output(DT_FLOAT, {batch, heads, num_queries, value_depth});
+  auto out = output.tensor<float, 4>();
+  for (int64 b = 0; b < batch; ++b) {
+    for (int64 h = 0; h < heads; ++h) {
+      for (int64 i = 0; i < num_queries; ++i) {
+        std::vector<double> scores(num_keys);
+        double max = -std::numeric_limits<double>::infinity();
+        for (int64 j = 0; j < num_keys; ++j) {
+          double score = 0;
+          for (int64 d = 0; d < depth; ++d) {
+            score += q(b, h, i, d) * k(b, h, j, d);
+          }
+          score *= scale;
+          if (mask != nullptr) score += mask->tensor<float, 4>()(b, 0, 0, j);
+          scores[j] = score;
+          max = std::max(max, score);
+        }
+        double sum = 0;
+        for (double& score : scores) {
+          score = std::exp(score - max);
+          sum += score;
+        }
+        for (int64 d = 0; d < value_depth; ++d) {
+          double result = 0;
+          for (int64 j = 0; j < num_keys; ++j) {
+            result += scores[j] / sum * v(b, h, j, d);
+          }
+          out(b, h, i, d) = result;
+        }
+      }
+    }
+  }
+  return output;
+}
+
+class FusedAttentionOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_args, float scale) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_attention", "_FusedAttention")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_args, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("num_args", num_args)
+                     .Attr("scale", scale)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddInput(const Tensor& tensor) {
+    AddInputFromArray<float>(
+        tensor.shape(),
+        gtl::ArraySlice<float>(tensor.flat<float>().data(),
+                               tensor.NumElements()));
+  }
+
+  // Checks the op against the reference, with sizes which are not multiples
+  // of the blocks of the CPU kernel.
+  void RunAndCheck(int64 batch, int64 heads, int64 num_queries, int64 num_keys,
+                   int64 depth, bool with_mask) {
+    const float scale = 1.0f / std::sqrt(static_cast<float>(depth));
+    const Tensor query =
+        RandomTensor({batch, heads, num_queries, depth}, /*seed=*/1);
+    const Tensor key = RandomTensor({batch, heads, num_keys, depth}, 2);
+    const Tensor value = RandomTensor({batch, heads, num_keys, depth + 3}, 3);
+    Tensor mask(DT_FLOAT, {batch, 1, 1, num_keys});
+    auto mask_values = mask.flat<float>();
+    for (int64 i = 0; i < mask_values.size(); ++i) {
+      // Masks out every third key, starting from the second one.
+      mask_values(i) = i % num_keys % 3 == 1 ? -1e9f : 0.0f;
+    }
+
+    MakeOp(with_mask ? 1 : 0, scale);
+    AddInput(query);
+    AddInput(key);
+    AddInput(value);
+    if (with_mask) AddInput(mask);
+    TF_ASSERT_OK(RunOpKernel());
+
+    const Tensor expected = ReferenceAttention(query, key, value,
+                                               with_mask ? &mask : nullptr,
+                                               scale);
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+};
+
+TEST_F(FusedAttentionOpTest, Small) { RunAndCheck(2, 3, 5, 7, 4, false); }
+
+TEST_F(FusedAttentionOpTest, SmallWithMask) {
+  RunAndCheck(2, 3, 5, 7, 4, true);
+}
+
+TEST_F(FusedAttentionOpTest, MultipleBlocks) {
+  RunAndCheck(2, 2, 70, 300, 16, false);
+}
+
+TEST_F(FusedAttentionOpTest, MultipleBlocksWithMask) {
+  RunAndCheck(2, 2, 70, 300, 16, true);
+}
+
+TEST_F(FusedAttentionOpTest, NoKeys) {
+  MakeOp(0, 1.0f);
+  AddInput(RandomTensor({2, 3, 4}, 1));
+  AddInput(Tensor(DT_FLOAT, {2, 0, 4}));
+  AddInput(Tensor(DT_FLOAT, {2, 0, 5}));
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(DT_FLOAT, {2, 3, 5});
+  test::FillFn<float>(&expected, [](int) { return 0.0f; });
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedAttentionOpTest, MismatchedBatchDimensions) {
+  MakeOp(0, 1.0f);
+  AddInput(RandomTensor({2, 3, 4}, 1));
+  AddInput(RandomTensor({1, 5, 4}, 2));
+  AddInput(RandomTensor({1, 5, 4}, 3));
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedAttentionOpTest, MaskNotBroadcastable) {
+  MakeOp(1, 1.0f);
+  AddInput(RandomTensor({2, 3, 4}, 1));
+  AddInput(RandomTensor({2, 5, 4}, 2));
+  AddInput(RandomTensor({2, 5, 4}, 3));
+  AddInput(RandomTensor({2, 3, 4}, 4));
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedAttentionOpTest, MaskAlternatingBroadcast) {
+  // Broadcast along the 1st and 3rd batch dimensions, but not the 2nd.
+  MakeOp(1, 1.0f);
+  AddInput(RandomTensor({2, 3, 2, 3, 4}, 1));
+  AddInput(RandomTensor({2, 3, 2, 5, 4}, 2));
+  AddInput(RandomTensor({2, 3, 2, 5, 4}, 3));
+  AddInput(RandomTensor({1, 3, 1, 3, 5}, 4));
+  EXPECT_TRUE(errors::IsUnimplemented(RunOpKernel()));
+}
+
+// Performance benchmarks below.
+
+// Attention as it is built by Transformer models.
+static Graph* Attention(int batch, int heads, int seq_len, int depth,
+                        bool fused) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({batch, heads, seq_len, depth});
+  Node* query = test::graph::Constant(g, RandomTensor(shape, 1));
+  Node* key = test::graph::Constant(g, RandomTensor(shape, 2));
+  Node* value = test::graph::Constant(g, RandomTensor(shape, 3));
+  Node* mask = test::graph::Constant(
+      g, RandomTensor(TensorShape({batch, 1, 1, seq_len}), 4));
+  const float scale = 1.0f / std::sqrt(static_cast<float>(depth));
+
+  Node* output;
+  if (fused) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("attention"), "_FusedAttention")
+                    .Input(query)
+                    .Input(key)
+                    .Input(value)
+                    .Input({NodeBuilder::NodeOut(mask)})
+                    .Attr("T", DT_FLOAT)
+                    .Attr("num_args", 1)
+                    .Attr("scale", scale)
+                    .Finalize(g, &output));
+    return g;
+  }
+  Tensor scale_tensor(DT_FLOAT, TensorShape({}));
+  scale_tensor.scalar<float>()() = scale;
+  Node* scores;
+  TF_CHECK_OK(NodeBuilder(g->NewName("scores"), "BatchMatMulV2")
+                  .Input(query)
+                  .Input(key)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("adj_y", true)
+                  .Finalize(g, &scores));
+  TF_CHECK_OK(NodeBuilder(g->NewName("scaled"), "Mul")
+                  .Input(scores)
+                  .Input(test::graph::Constant(g, scale_tensor))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &scores));
+  TF_CHECK_OK(NodeBuilder(g->NewName("masked"), "AddV2")
+                  .Input(scores)
+                  .Input(mask)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &scores));
+  TF_CHECK_OK(NodeBuilder(g->NewName("probabilities"), "Softmax")
+                  .Input(scores)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &scores));
+  TF_CHECK_OK(NodeBuilder(g->NewName("attention"), "BatchMatMulV2")
+                  .Input(scores)
+                  .Input(value)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &output));
+  return g;
+}
+
+#define BM_Attention(B, H, S, D, FUSED, type)                               \
+  static void BM_Attention##_##B##_##H##_##S##_##D##_##FUSED##_##type(      \
+      int iters) {                                                          \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * H * S * S * D); \
+    test::Benchmark(#type, Attention(B, H, S, D, FUSED)).Run(iters);        \
+  }                                                                         \
+  BENCHMARK(BM_Attention##_##B##_##H##_##S##_##D##_##FUSED##_##type);
+
+BM_Attention(8, 8, 128, 64, false, cpu);
+BM_Attention(8, 8, 128, 64, true, cpu);
+BM_Attention(4, 8, 512, 64, false, cpu);
+BM_Attention(4, 8, 512, 64, true, cpu);
+BM_Attention(1, 16, 2048, 64, false, cpu);
+BM_Attention(1, 16, 2048, 64, true, cpu);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,304 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Evaluates the trees of elementwise operations fused by the grappler
+// elementwise fusion pass.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of elements evaluated at once. The intermediate results of a
+// block stay in the L1 cache, so that only the inputs and the output are read
+// from and written to memory.
+constexpr int64 kBlockSize = 512;
+
+enum class FusedOp {
+  kAbs,
+  kExp,
+  kLog,
+  kNeg,
+  kReciprocal,
+  kRelu,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kMaximum,
+  kMinimum,
+  kSquaredDifference,
+};
+
+struct FusedOpInfo {
+  const char* name;
+  FusedOp op;
+  int arity;
+  // The rough number of cycles spent per element.
+  int cost;
+};
+
+// Keep in sync with the ops fused by grappler/optimizers/elementwise_fusion.cc.
+constexpr FusedOpInfo kFusedOps[] = {
+    {"Abs", FusedOp::kAbs, 1, 1},
+    {"Exp", FusedOp::kExp, 1, 20},
+    {"Log", FusedOp::kLog, 1, 20},
+    {"Neg", FusedOp::kNeg, 1, 1},
+    {"Reciprocal", FusedOp::kReciprocal, 1, 5},
+    {"Inv", FusedOp::kReciprocal, 1, 5},
+    {"Relu", FusedOp::kRelu, 1, 1},
+    {"Rsqrt", FusedOp::kRsqrt, 1, 10},
+    {"Sigmoid", FusedOp::kSigmoid, 1, 25},
+    {"Sqrt", FusedOp::kSqrt, 1, 10},
+    {"Square", FusedOp::kSquare, 1, 1},
+    {"Tanh", FusedOp::kTanh, 1, 25},
+    {"Add", FusedOp::kAdd, 2, 1},
+    {"AddV2", FusedOp::kAdd, 2, 1},
+    {"Sub", FusedOp::kSub, 2, 1},
+    {"Mul", FusedOp::kMul, 2, 1},
+    {"Div", FusedOp::kDiv, 2, 5},
+    {"RealDiv", FusedOp::kDiv, 2, 5},
+    {"Maximum", FusedOp::kMaximum, 2, 1},
+    {"Minimum", FusedOp::kMinimum, 2, 1},
+    {"SquaredDifference", FusedOp::kSquaredDifference, 2, 2},
+};
+
+const FusedOpInfo* FindFusedOp(const string& name) {
+  for (const FusedOpInfo& info : kFusedOps) {
+    if (name == info.name) return &info;
+  }
+  return nullptr;
+}
+
+template <typename T>
+void EvaluateFusedOp(FusedOp op, const T* x, const T* y, int64 n, T* out) {
+  using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+  Eigen::Map<const Array> a(x, n);
+  Eigen::Map<const Array> b(y, n);
+  Eigen::Map<Array> result(out, n);
+  switch (op) {
+    case FusedOp::kAbs:
+      result = a.abs();
+      break;
+    case FusedOp::kExp:
+      result = a.exp();
+      break;
+    case FusedOp::kLog:
+      result = a.log();
+      break;
+    case FusedOp::kNeg:
+      result = -a;
+      break;
+    case FusedOp::kReciprocal:
+      result = a.inverse();
+      break;
+    case FusedOp::kRelu:
+      result = a.max(T(0));
+      break;
+    case FusedOp::kRsqrt:
+      result = a.rsqrt();
+      break;
+    case FusedOp::kSigmoid:
+      result = a.unaryExpr(Eigen::internal::scalar_logistic_op<T>());
+      break;
+    case FusedOp::kSqrt:
+      result = a.sqrt();
+      break;
+    case FusedOp::kSquare:
+      result = a.square();
+      break;
+    case FusedOp::kTanh:
+      result = a.tanh();
+      break;
+    case FusedOp::kAdd:
+      result = a + b;
+      break;
+    case FusedOp::kSub:
+      result = a - b;
+      break;
+    case FusedOp::kMul:
+      result = a * b;
+      break;
+    case FusedOp::kDiv:
+      result = a / b;
+      break;
+    case FusedOp::kMaximum:
+      result = a.max(b);
+      break;
+    case FusedOp::kMinimum:
+      result = a.min(b);
+      break;
+    case FusedOp::kSquaredDifference:
+      result = (a - b).square();
+      break;
+  }
+}
+
+}  // namespace
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_inputs", &num_inputs_));
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    std::vector<int32> operands;
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands));
+
+    int next_operand = 0;
+    for (int i = 0; i < fused_ops.size(); ++i) {
+      const FusedOpInfo* info = FindFusedOp(fused_ops[i]);
+      OP_REQUIRES(context, info != nullptr,
+                  errors::Unimplemented("Unsupported fused op: ",
+                                        fused_ops[i]));
+      OP_REQUIRES(
+          context, next_operand + info->arity <= operands.size(),
+          errors::InvalidArgument("Missing operands for the fused op ", i));
+      Instruction instruction;
+      instruction.op = info->op;
+      for (int j = 0; j < 2; ++j) {
+        // Unary ops ignore their second operand.
+        const int operand =
+            operands[next_operand + std::min(j, info->arity - 1)];
+        OP_REQUIRES(context, operand >= 0 && operand < num_inputs_ + i,
+                    errors::InvalidArgument("Invalid operand ", operand,
+                                            " of the fused op ", i));
+        instruction.operands[j] = operand;
+      }
+      next_operand += info->arity;
+      instructions_.push_back(instruction);
+      cost_per_element_ += info->cost;
+    }
+    OP_REQUIRES(context, next_operand == operands.size(),
+                errors::InvalidArgument("Expected ", next_operand,
+                                        " operands, got ", operands.size()));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(context, context->input_list("inputs", &inputs));
+
+    // The inputs have the shape of the output, or are broadcast scalars.
+    TensorShape shape;
+    std::vector<int> forwardable_inputs;
+    for (int i = 0; i < num_inputs_; ++i) {
+      if (TensorShapeUtils::IsScalar(inputs[i].shape())) continue;
+      if (forwardable_inputs.empty()) {
+        shape = inputs[i].shape();
+      } else {
+        OP_REQUIRES(context, inputs[i].shape() == shape,
+                    errors::InvalidArgument(
+                        "Inputs must have the same shape, or be scalars: ",
+                        shape.DebugString(), " vs. ",
+                        inputs[i].shape().DebugString()));
+      }
+      forwardable_inputs.push_back(i);
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                forwardable_inputs, 0, shape, &output));
+    const int64 size = shape.num_elements();
+    if (size == 0) return;
+
+    std::vector<const T*> input_data(num_inputs_);
+    for (int i = 0; i < num_inputs_; ++i) {
+      input_data[i] = inputs[i].flat<T>().data();
+    }
+    T* output_data = output->flat<T>().data();
+    const int num_instructions = instructions_.size();
+
+    // Evaluates the blocks [first_block, last_block).
+    auto evaluate = [&](int64 first_block, int64 last_block) {
+      // The broadcast scalars, followed by the results of the instructions.
+      std::vector<T> buffers((num_inputs_ + num_instructions) * kBlockSize);
+      for (int i = 0; i < num_inputs_; ++i) {
+        if (TensorShapeUtils::IsScalar(inputs[i].shape())) {
+          std::fill_n(buffers.data() + i * kBlockSize, kBlockSize,
+                      input_data[i][0]);
+        }
+      }
+      auto operand_data = [&](int operand, int64 begin) -> const T* {
+        if (operand < num_inputs_ &&
+            !TensorShapeUtils::IsScalar(inputs[operand].shape())) {
+          return input_data[operand] + begin;
+        }
+        return buffers.data() + operand * kBlockSize;
+      };
+      for (int64 block = first_block; block < last_block; ++block) {
+        const int64 begin = block * kBlockSize;
+        const int64 n = std::min(kBlockSize, size - begin);
+        for (int i = 0; i < num_instructions; ++i) {
+          const Instruction& instruction = instructions_[i];
+          // The last instruction writes the output directly.
+          T* result = i + 1 == num_instructions
+                          ? output_data + begin
+                          : buffers.data() + (num_inputs_ + i) * kBlockSize;
+          EvaluateFusedOp<T>(instruction.op,
+                             operand_data(instruction.operands[0], begin),
+                             operand_data(instruction.operands[1], begin), n,
+                             result);
+        }
+      }
+    };
+    const int64 num_blocks = (size + kBlockSize - 1) / kBlockSize;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          kBlockSize * cost_per_element_, evaluate);
+  }
+
+ private:
+  struct Instruction {
+    FusedOp op;
+    int operands[2];
+  };
+
+  int num_inputs_;
+  std::vector<Instruction> instructions_;
+  int64 cost_per_element_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedElementwiseOp);
+};
+
+#define REGISTER_KERNEL(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+TF_CALL_float(REGISTER_KERNEL);
+TF_CALL_double(REGISTER_KERNEL);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status MakeOp(int num_inputs, const std::vector<string>& fused_ops,
+                const std::vector<int>& operands) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("fused", "_FusedElementwise")
+                           .Input(FakeInput(num_inputs, DT_FLOAT))
+                           .Attr("fused_ops", fused_ops)
+                           .Attr("operands", operands)
+                           .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, Chain) {
+  // tanh(x * y + z) * x, on more elements than a block.
+  TF_ASSERT_OK(MakeOp(3, {"Mul", "AddV2", "Tanh", "Mul"},
+                      {0, 1, /**/ 3, 2, /**/ 4, /**/ 5, 0}));
+  const int size = 1500;
+  std::vector<float> x(size), y(size), z(size), expected_values(size);
+  for (int i = 0; i < size; ++i) {
+    x[i] = 0.001f * i - 0.7f;
+    y[i] = 0.5f - 0.002f * i;
+    z[i] = 0.1f;
+    expected_values[i] = std::tanh(x[i] * y[i] + z[i]) * x[i];
+  }
+  AddInputFromArray<float>(TensorShape({3, 500}), x);
+  AddInputFromArray<float>(TensorShape({3, 500}), y);
+  AddInputFromArray<float>(TensorShape({3, 500}), z);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 500}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, BroadcastsScalars) {
+  // relu(x - 1) * 2.
+  TF_ASSERT_OK(MakeOp(3, {"Sub", "Relu", "Mul"}, {0, 1, /**/ 3, /**/ 4, 2}));
+  AddInputFromArray<float>(TensorShape({4}), {-1, 0.5, 2, 3});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {0, 0, 2, 4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidPrograms) {
+  EXPECT_FALSE(MakeOp(1, {"Erf"}, {0}).ok());
+  EXPECT_FALSE(MakeOp(1, {"Neg"}, {1}).ok());
+  EXPECT_FALSE(MakeOp(1, {"Add"}, {0}).ok());
+  EXPECT_FALSE(MakeOp(1, {"Neg"}, {0, 0}).ok());
+}
+
+}  // namespace tensorflow
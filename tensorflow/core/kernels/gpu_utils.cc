@@ -22,6 +22,11 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 #include "absl/algorithm/container.h"
 #include "absl/base/call_once.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logger.h"
 #include "tensorflow/core/protobuf/autotuning.pb.h"
 #include "tensorflow/core/protobuf/conv_autotuning.pb.h"
@@ -282,6 +287,193 @@ Status BestCudnnConvAlgorithm(absl::Span<const AutotuneResult> results,
   return Status::OK();
 }
 
+namespace {
+
+// Encodes an optional algorithm as "<id>:<tensor ops>", or "-" if it is unset.
+string EncodeAlgorithmDesc(
+    const absl::optional<se::dnn::AlgorithmDesc>& algorithm) {
+  if (!algorithm.has_value()) return "-";
+  return strings::StrCat(algorithm->algo_id(), ":",
+                         algorithm->tensor_ops_enabled() ? 1 : 0);
+}
+
+bool DecodeAlgorithmDesc(StringPiece text,
+                         absl::optional<se::dnn::AlgorithmDesc>* algorithm) {
+  if (text == "-") {
+    algorithm->reset();
+    return true;
+  }
+  std::vector<string> fields = str_util::Split(text, ':');
+  int64 algo_id;
+  int32 tensor_ops;
+  if (fields.size() != 2 || !strings::safe_strto64(fields[0], &algo_id) ||
+      !strings::safe_strto32(fields[1], &tensor_ops)) {
+    return false;
+  }
+  *algorithm = se::dnn::AlgorithmDesc(algo_id, tensor_ops != 0);
+  return true;
+}
+
+// Describes the visible GPUs and the versions of their driver and of cuDNN.
+string DescribeGpuPlatform() {
+#if TENSORFLOW_USE_ROCM
+  const char* platform_name = "ROCM";
+#else
+  const char* platform_name = "CUDA";
+#endif
+  auto platform_or = se::MultiPlatformManager::PlatformWithName(platform_name);
+  if (!platform_or.ok()) return "";
+  se::Platform* platform = platform_or.ValueOrDie();
+  string description;
+  for (int i = 0; i < platform->VisibleDeviceCount(); ++i) {
+    auto executor_or = platform->ExecutorForDevice(i);
+    if (!executor_or.ok()) return "";
+    se::StreamExecutor* executor = executor_or.ValueOrDie();
+    const se::DeviceDescription& device = executor->GetDeviceDescription();
+    int cc_major = 0;
+    int cc_minor = 0;
+    device.cuda_compute_capability(&cc_major, &cc_minor);
+    strings::StrAppend(&description, "device ", i, ": ", device.name(),
+                       ", compute capability ", cc_major, ".", cc_minor,
+                       ", driver ", device.driver_version());
+    if (auto* dnn = executor->AsDnn()) {
+      auto version_or = dnn->GetVersion();
+      if (version_or.ok()) {
+        const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+        strings::StrAppend(&description, ", dnn ", version.major_version(),
+                           ".", version.minor_version(), ".",
+                           version.patch());
+      }
+    }
+    strings::StrAppend(&description, "\n");
+  }
+  return description;
+}
+
+}  // namespace
+
+string AutotuneConfigCodec<se::dnn::AlgorithmConfig>::Encode(
+    const se::dnn::AlgorithmConfig& config) {
+  return strings::StrCat(
+      EncodeAlgorithmDesc(config.algorithm()), " ",
+      config.scratch_size().has_value()
+          ? strings::StrCat(*config.scratch_size())
+          : "-",
+      " ", EncodeAlgorithmDesc(config.algorithm_no_scratch()));
+}
+
+bool AutotuneConfigCodec<se::dnn::AlgorithmConfig>::Decode(
+    StringPiece text, se::dnn::AlgorithmConfig* config) {
+  std::vector<string> fields = str_util::Split(text, ' ');
+  if (fields.size() != 3) return false;
+  absl::optional<se::dnn::AlgorithmDesc> algorithm;
+  absl::optional<se::dnn::AlgorithmDesc> algorithm_no_scratch;
+  if (!DecodeAlgorithmDesc(fields[0], &algorithm) ||
+      !DecodeAlgorithmDesc(fields[2], &algorithm_no_scratch)) {
+    return false;
+  }
+  *config = se::dnn::AlgorithmConfig();
+  if (algorithm.has_value()) config->set_algorithm(*algorithm);
+  if (algorithm_no_scratch.has_value()) {
+    config->set_algorithm_no_scratch(*algorithm_no_scratch);
+  }
+  if (fields[1] != "-") {
+    uint64 scratch_size;
+    if (!strings::safe_strtou64(fields[1], &scratch_size)) return false;
+    config->set_scratch_size(scratch_size);
+  }
+  return true;
+}
+
+string AutotuneConfigCodec<se::blas::AlgorithmConfig>::Encode(
+    const se::blas::AlgorithmConfig& config) {
+  return strings::StrCat(config.algorithm());
+}
+
+bool AutotuneConfigCodec<se::blas::AlgorithmConfig>::Decode(
+    StringPiece text, se::blas::AlgorithmConfig* config) {
+  int64 algorithm;
+  if (!strings::safe_strto64(text, &algorithm)) return false;
+  config->set_algorithm(algorithm);
+  return true;
+}
+
+AutotuneCacheFile* AutotuneCacheFile::Get() {
+  static AutotuneCacheFile* cache_file = []() -> AutotuneCacheFile* {
+    string dir;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_AUTOTUNE_CACHE_DIR", "", &dir));
+    if (dir.empty()) return nullptr;
+    const string platform = DescribeGpuPlatform();
+    if (platform.empty()) {
+      LOG(WARNING) << "Not caching autotune results: failed to describe the "
+                   << "GPU platform.";
+      return nullptr;
+    }
+    const string path = io::JoinPath(
+        dir, strings::StrCat("autotune_", strings::Hex(Hash64(platform)),
+                             ".txt"));
+
+    Env* env = Env::Default();
+    std::unordered_map<string, std::unordered_map<string, string>> entries;
+    string contents;
+    if (env->FileExists(path).ok() &&
+        ReadFileToString(env, path, &contents).ok()) {
+      for (StringPiece line : str_util::Split(contents, '\n')) {
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<string> fields = str_util::Split(line, '\t');
+        if (fields.size() != 3) continue;
+        entries[fields[0]][fields[1]] = fields[2];
+      }
+    }
+
+    std::unique_ptr<WritableFile> file;
+    Status status = env->NewAppendableFile(path, &file);
+    if (!status.ok()) {
+      LOG(WARNING) << "Not caching autotune results: " << status;
+      return nullptr;
+    }
+    if (contents.empty()) {
+      // Describes the platform in comments at the top of a new file.
+      string header;
+      for (StringPiece line : str_util::Split(platform, '\n')) {
+        if (!line.empty()) strings::StrAppend(&header, "# ", line, "\n");
+      }
+      if (!file->Append(header).ok() || !file->Flush().ok()) {
+        LOG(WARNING) << "Failed to write the autotune cache file " << path;
+      }
+    }
+    VLOG(1) << "Caching autotune results in " << path;
+    return new AutotuneCacheFile(std::move(entries), std::move(file));
+  }();
+  return cache_file;
+}
+
+AutotuneCacheFile::AutotuneCacheFile(
+    std::unordered_map<string, std::unordered_map<string, string>> entries,
+    std::unique_ptr<WritableFile> file)
+    : entries_(std::move(entries)), file_(std::move(file)) {}
+
+std::unordered_map<string, string> AutotuneCacheFile::Load(
+    const string& map_name) const {
+  auto it = entries_.find(map_name);
+  if (it == entries_.end()) return {};
+  return it->second;
+}
+
+void AutotuneCacheFile::Append(const string& map_name, const string& params,
+                               const string& config) {
+  // Each line is written at once, so that the lines which processes append
+  // concurrently are not interleaved.
+  const string line =
+      strings::StrCat(map_name, "\t", params, "\t", config, "\n");
+  mutex_lock lock(mu_);
+  Status status = file_->Append(line);
+  if (status.ok()) status = file_->Flush();
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to append to the autotune cache file: " << status;
+  }
+}
+
 }  // namespace tensorflow
 
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -18,6 +18,7 @@ limitations under the License.
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <memory>
 #include <unordered_map>
 
 #include "absl/types/span.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 
 namespace stream_executor {
@@ -37,6 +39,7 @@ namespace tensorflow {
 
 class NodeDef;
 class AutotuneResult;
+class WritableFile;
 
 // Return whether the redzone check is disabled.
 //
@@ -66,6 +69,65 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
   return typed;
 }
 
+// Encodes autotuned configs as the strings of an AutotuneCacheFile, and
+// decodes them. The autotune maps of configs without a specialization are not
+// persisted.
+template <typename Config>
+struct AutotuneConfigCodec {
+  static constexpr bool kPersistent = false;
+  static string Encode(const Config& config) { return ""; }
+  static bool Decode(StringPiece text, Config* config) { return false; }
+};
+
+template <>
+struct AutotuneConfigCodec<se::dnn::AlgorithmConfig> {
+  static constexpr bool kPersistent = true;
+  static string Encode(const se::dnn::AlgorithmConfig& config);
+  static bool Decode(StringPiece text, se::dnn::AlgorithmConfig* config);
+};
+
+template <>
+struct AutotuneConfigCodec<se::blas::AlgorithmConfig> {
+  static constexpr bool kPersistent = true;
+  static string Encode(const se::blas::AlgorithmConfig& config);
+  static bool Decode(StringPiece text, se::blas::AlgorithmConfig* config);
+};
+
+// A file of the configs accepted by the autotune maps, which lets processes
+// skip autotuning the parameters another process has already tuned.
+//
+// Enabled by setting the TF_AUTOTUNE_CACHE_DIR environment variable to a
+// directory. The file in it is named after the models of the visible GPUs and
+// the versions of their driver and of cuDNN, so that configs are only reused
+// with the hardware and libraries they were tuned with. Each line holds the
+// name of an autotune map, parameters and their config, separated by tabs;
+// processes append their lines, and the last line of parameters wins.
+class AutotuneCacheFile {
+ public:
+  // Returns the file of this process, or nullptr if it is not enabled.
+  static AutotuneCacheFile* Get();
+
+  // Returns the encoded configs of the map `map_name` read from the file when
+  // the process started, keyed by their parameters.
+  std::unordered_map<string, string> Load(const string& map_name) const;
+
+  // Appends the encoded config of `params` in the map `map_name` to the file.
+  void Append(const string& map_name, const string& params,
+              const string& config);
+
+ private:
+  AutotuneCacheFile(
+      std::unordered_map<string, std::unordered_map<string, string>> entries,
+      std::unique_ptr<WritableFile> file);
+
+  const std::unordered_map<string, std::unordered_map<string, string>>
+      entries_;
+  mutex mu_;
+  std::unique_ptr<WritableFile> file_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutotuneCacheFile);
+};
+
 // A helper class that looks up the best autotuned config from parameters.
 // Due to the noisy nature of autotune, especially with multiple devices, it
 // only accepts a config if its margin exceeds a threshold.
@@ -82,6 +144,14 @@ class AutoTuneMap {
   bool Find(const Parameters& params, Config* config) const {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
+    if (iter == params_config_map_.end() && !cached_configs_.empty()) {
+      // Falls back to the configs another process accepted.
+      auto cached = cached_configs_.find(params.ToString());
+      if (cached != cached_configs_.end()) {
+        *config = cached->second;
+        return true;
+      }
+    }
     if (iter == params_config_map_.end() ||
         (iter->second.score < min_score_threshold_ &&
          iter->second.count <= max_autotune_count_)) {
@@ -121,6 +191,7 @@ class AutoTuneMap {
     }
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
+      Persist(params, config);
     } else if (autotune_global_count_ >= max_autotune_global_count_) {
       // The autotuning exceeds the max iteration threshold and we accept the
       // the winner if it exists in the map, otherwise we accept the current
@@ -133,12 +204,14 @@ class AutoTuneMap {
         }
         params_config_map_.insert(
             std::make_pair(params, ValueType{config, min_score_threshold_, 1}));
+        Persist(params, config);
       } else {
         int promotes_times = min_score_threshold_ - winner->second.score;
         for (int i = 0; i < promotes_times; ++i) {
           VLOG(1) << GetActionSummary("promotes", params, config);
         }
         winner->second.score = min_score_threshold_;
+        Persist(params, winner->second.config);
       }
       VLOG(1) << GetActionSummary("accepts", params, config);
     }
@@ -163,6 +236,27 @@ class AutoTuneMap {
         5 * min_score_threshold_ * min_score_threshold_, min_warmup_iterations);
     max_autotune_global_count_ = 2 * max_autotune_count_;
     autotune_global_count_ = 0;
+
+    cache_file_ = AutotuneConfigCodec<Config>::kPersistent
+                      ? AutotuneCacheFile::Get()
+                      : nullptr;
+    if (cache_file_ != nullptr) {
+      for (const auto& entry : cache_file_->Load(name_)) {
+        Config config;
+        if (AutotuneConfigCodec<Config>::Decode(entry.second, &config)) {
+          cached_configs_.emplace(entry.first, config);
+        }
+      }
+      VLOG(1) << "autotune_map " << name_ << " loaded "
+              << cached_configs_.size() << " cached configs";
+    }
+  }
+
+  // Appends an accepted config to the autotune cache file, if it is enabled.
+  void Persist(const Parameters& params, const Config& config) {
+    if (cache_file_ == nullptr) return;
+    cache_file_->Append(name_, params.ToString(),
+                        AutotuneConfigCodec<Config>::Encode(config));
   }
 
   template <class Group, class Params, class Cfg>
@@ -194,6 +288,10 @@ class AutoTuneMap {
   int32 max_autotune_count_;
   int32 max_autotune_global_count_;
   int32 autotune_global_count_;
+  AutotuneCacheFile* cache_file_;
+  // The configs read from the autotune cache file, keyed by the strings of
+  // their parameters.
+  std::unordered_map<string, Config> cached_configs_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(AutoTuneMap);
 };
@@ -0,0 +1,66 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include "tensorflow/core/kernels/host_computed_output.h"
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/framework/tensor_reference.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+namespace tensorflow {
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+Status HostComputedOutput<GPUDevice>::Allocate(OpKernelContext* context,
+                                               const TensorShape& shape) {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  attr.set_gpu_compatible(true);
+  return context->allocate_temp(context->expected_output_dtype(index_), shape,
+                                &host_, attr);
+}
+
+Status HostComputedOutput<GPUDevice>::Finish(OpKernelContext* context) {
+  Tensor* output;
+  TF_RETURN_IF_ERROR(context->allocate_output(index_, host_.shape(), &output));
+  if (host_.NumElements() == 0) return Status::OK();
+
+  se::Stream* stream = context->op_device_context()->stream();
+  if (stream == nullptr) return errors::Internal("No GPU stream available.");
+  se::DeviceMemoryBase output_ptr(output->data(), output->TotalBytes());
+  if (!stream
+           ->ThenMemcpy(&output_ptr, host_.tensor_data().data(),
+                        host_.TotalBytes())
+           .ok()) {
+    return errors::Internal("Failed to copy output ", index_,
+                            " from the host to the device");
+  }
+  // Keeps the host tensor alive until the copy completes.
+  TensorReference host_ref(host_);
+  context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+      stream, [host_ref]() { host_ref.Unref(); });
+  return Status::OK();
+}
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_HOST_COMPUTED_OUTPUT_H_
+#define TENSORFLOW_CORE_KERNELS_HOST_COMPUTED_OUTPUT_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+// An output of a kernel which is computed on the host, by the CPU worker
+// threads of the device. Kernels use it to compute their outputs from inputs
+// which only live in host memory, such as strings, on the device which
+// consumes the outputs, so that the executor does not split them off to the
+// CPU device and copy their outputs back.
+//
+// Usage:
+//   HostComputedOutput<Device> output(/*index=*/0);
+//   OP_REQUIRES_OK(context, output.Allocate(context, shape));
+//   ... write output.tensor() on the host ...
+//   OP_REQUIRES_OK(context, output.Finish(context));
+template <typename Device>
+class HostComputedOutput;
+
+// On the CPU, the output is computed in place.
+template <>
+class HostComputedOutput<CPUDevice> {
+ public:
+  explicit HostComputedOutput(int index) : index_(index) {}
+
+  Status Allocate(OpKernelContext* context, const TensorShape& shape) {
+    return context->allocate_output(index_, shape, &output_);
+  }
+
+  Tensor* tensor() { return output_; }
+
+  Status Finish(OpKernelContext* context) { return Status::OK(); }
+
+ private:
+  const int index_;
+  Tensor* output_ = nullptr;
+};
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// On the GPU, the output is computed in pinned host memory, and Finish()
+// enqueues its copy to the device on the compute stream.
+template <>
+class HostComputedOutput<GPUDevice> {
+ public:
+  explicit HostComputedOutput(int index) : index_(index) {}
+
+  Status Allocate(OpKernelContext* context, const TensorShape& shape);
+
+  Tensor* tensor() { return &host_; }
+
+  Status Finish(OpKernelContext* context);
+
+ private:
+  const int index_;
+  Tensor host_;
+};
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_HOST_COMPUTED_OUTPUT_H_
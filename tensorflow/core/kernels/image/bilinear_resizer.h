@@ -0,0 +1,204 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_IMAGE_BILINEAR_RESIZER_H_
+#define TENSORFLOW_CORE_KERNELS_IMAGE_BILINEAR_RESIZER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The two input coordinates an output coordinate of a bilinear resize
+// interpolates between, and the weight of the upper one.
+struct CachedInterpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+// Computes the interpolation of the `out_size` output coordinates, whose
+// input coordinate is scaler(i, scale). `interpolation` has out_size + 1
+// elements, the last of which is zero.
+template <typename Scaler>
+inline void compute_interpolation_weights(const Scaler scaler,
+                                          const int64 out_size,
+                                          const int64 in_size,
+                                          const float scale,
+                                          CachedInterpolation* interpolation) {
+  interpolation[out_size].lower = 0;
+  interpolation[out_size].upper = 0;
+  for (int64 i = out_size - 1; i >= 0; --i) {
+    const float in = scaler(i, scale);
+    const float in_f = std::floor(in);
+    interpolation[i].lower =
+        std::max(static_cast<int64>(in_f), static_cast<int64>(0));
+    interpolation[i].upper =
+        std::min(static_cast<int64>(std::ceil(in)), in_size - 1);
+    interpolation[i].lerp = in - in_f;
+  }
+}
+
+// Resizes an image of `T` with bilinear interpolation, one output row at a
+// time, separably: each input row is first interpolated horizontally into a
+// buffer, and each output row is then the vertical interpolation of two such
+// buffers. Consecutive output rows mostly read the same input rows, so the
+// horizontal interpolation of an input row is reused until it is no longer
+// needed, and the vertical interpolation runs over whole rows with the
+// packets of the CPU.
+//
+// `Output` is float, or uint8 for uint8 images, in which case the resize
+// runs in fixed point with 11 bit weights.
+template <typename T, typename Output = float>
+class BilinearResizer {
+ public:
+  // `image` points to the first row of the image, with `in_row_size`
+  // elements per row. The lower and upper input coordinates of `xs` are
+  // multiplied by `channels`.
+  BilinearResizer(const T* image, int64 in_row_size,
+                  const CachedInterpolation* xs, int64 out_width, int channels)
+      : image_(image),
+        in_row_size_(in_row_size),
+        xs_(xs),
+        out_width_(out_width),
+        channels_(channels),
+        out_row_size_(out_width * channels) {
+    for (int i = 0; i < 2; ++i) {
+      rows_[i].resize(out_row_size_);
+      row_index_[i] = -1;
+    }
+    if (kFixedPoint) {
+      x_weights_.resize(out_width);
+      for (int64 x = 0; x < out_width; ++x) {
+        x_weights_[x] = ToFixedPoint(xs[x].lerp);
+      }
+    }
+  }
+
+  // Writes the output row which interpolates between the input rows of `y`
+  // to `output`.
+  void ResizeRow(const CachedInterpolation& y, Output* output) {
+    const int top = InterpolatedRow(y.lower, /*keep=*/-1);
+    const int bottom = InterpolatedRow(y.upper, /*keep=*/top);
+    LerpRows(rows_[top].data(), rows_[bottom].data(), y.lerp, output);
+  }
+
+ private:
+  static constexpr bool kFixedPoint =
+      std::is_same<T, uint8>::value && std::is_same<Output, uint8>::value;
+  static constexpr int kFractionBits = 11;
+  typedef typename std::conditional<kFixedPoint, int32, float>::type
+      Accumulator;
+
+  static int32 ToFixedPoint(float lerp) {
+    return static_cast<int32>(lerp * (1 << kFractionBits) + 0.5f);
+  }
+
+  // Returns the buffer holding input row `index` interpolated horizontally,
+  // interpolating it into the buffer other than `keep` if needed. If both
+  // buffers are free, the one holding the upper row is kept.
+  int InterpolatedRow(int64 index, int keep) {
+    for (int i = 0; i < 2; ++i) {
+      if (row_index_[i] == index) return i;
+    }
+    const int slot =
+        keep >= 0 ? 1 - keep : (row_index_[0] < row_index_[1] ? 0 : 1);
+    row_index_[slot] = index;
+    const T* row = image_ + index * in_row_size_;
+    Accumulator* out = rows_[slot].data();
+    switch (channels_) {
+      case 1:
+        InterpolateRow<1>(row, out);
+        break;
+      case 3:
+        InterpolateRow<3>(row, out);
+        break;
+      case 4:
+        InterpolateRow<4>(row, out);
+        break;
+      default:
+        InterpolateRow<0>(row, out);
+    }
+    return slot;
+  }
+
+  // Interpolates `row` horizontally. `kChannels` is 0 if the number of
+  // channels is not known at compile time.
+  template <int kChannels>
+  void InterpolateRow(const T* row, Accumulator* out) const {
+    const int channels = kChannels > 0 ? kChannels : channels_;
+    for (int64 x = 0; x < out_width_; ++x, out += channels) {
+      const T* left = row + xs_[x].lower;
+      const T* right = row + xs_[x].upper;
+      if (kFixedPoint) {
+        const int32 lerp = x_weights_[x];
+        for (int c = 0; c < channels; ++c) {
+          const int32 l = static_cast<int32>(left[c]);
+          const int32 r = static_cast<int32>(right[c]);
+          out[c] = (l << kFractionBits) + (r - l) * lerp;
+        }
+      } else {
+        const float lerp = xs_[x].lerp;
+        for (int c = 0; c < channels; ++c) {
+          const float l = static_cast<float>(left[c]);
+          const float r = static_cast<float>(right[c]);
+          out[c] = l + (r - l) * lerp;
+        }
+      }
+    }
+  }
+
+  void LerpRows(const float* top, const float* bottom, float lerp,
+                float* output) const {
+    typedef Eigen::Map<const Eigen::ArrayXf> ConstRow;
+    Eigen::Map<Eigen::ArrayXf>(output, out_row_size_) =
+        ConstRow(top, out_row_size_) +
+        (ConstRow(bottom, out_row_size_) - ConstRow(top, out_row_size_)) *
+            lerp;
+  }
+
+  void LerpRows(const int32* top, const int32* bottom, float lerp,
+                uint8* output) const {
+    // The horizontally interpolated values have 8 + 11 bits, so the
+    // interpolated value, with 8 + 22 bits, does not overflow.
+    const int32 weight = ToFixedPoint(lerp);
+    const int32 half = 1 << (2 * kFractionBits - 1);
+    for (int64 i = 0; i < out_row_size_; ++i) {
+      const int32 value = (top[i] << kFractionBits) +
+                          (bottom[i] - top[i]) * weight + half;
+      output[i] = static_cast<uint8>(value >> (2 * kFractionBits));
+    }
+  }
+
+  const T* const image_;
+  const int64 in_row_size_;
+  const CachedInterpolation* const xs_;
+  const int64 out_width_;
+  const int channels_;
+  const int64 out_row_size_;
+  std::vector<int32> x_weights_;
+  // The input rows interpolated horizontally, and their indices.
+  std::vector<Accumulator> rows_[2];
+  int64 row_index_[2];
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_IMAGE_BILINEAR_RESIZER_H_
@@ -20,7 +20,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/image/crop_and_resize_op.h"
 
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image/bilinear_resizer.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
@@ -254,6 +257,33 @@ struct CropAndResize<CPUDevice, T> {
             (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
                              : 0;
 
+        // The bilinear crops are resized separably, one row at a time. The
+        // pixels which sample outside of the image are extrapolated after
+        // each row is resized.
+        std::unique_ptr<BilinearResizer<T>> resizer;
+        std::vector<CachedInterpolation> xs;
+        std::vector<int> extrapolated_xs;
+        if (method_name == "bilinear") {
+          xs.resize(crop_width);
+          for (int x = 0; x < crop_width; ++x) {
+            const float in_x = (crop_width > 1)
+                                   ? x1 * (image_width - 1) + x * width_scale
+                                   : 0.5 * (x1 + x2) * (image_width - 1);
+            if (in_x < 0 || in_x > image_width - 1) {
+              xs[x] = {0, 0, 0.0f};
+              extrapolated_xs.push_back(x);
+              continue;
+            }
+            const int left_x_index = floorf(in_x);
+            const int right_x_index = ceilf(in_x);
+            xs[x] = {left_x_index * depth, right_x_index * depth,
+                     in_x - left_x_index};
+          }
+          resizer.reset(new BilinearResizer<T>(&image(b_in, 0, 0, 0),
+                                               image_width * depth, xs.data(),
+                                               crop_width, depth));
+        }
+
         for (int y = 0; y < crop_height; ++y) {
           const float in_y = (crop_height > 1)
                                  ? y1 * (image_height - 1) + y * height_scale
@@ -271,33 +301,11 @@ struct CropAndResize<CPUDevice, T> {
             const int bottom_y_index = ceilf(in_y);
             const float y_lerp = in_y - top_y_index;
 
-            for (int x = 0; x < crop_width; ++x) {
-              const float in_x = (crop_width > 1)
-                                     ? x1 * (image_width - 1) + x * width_scale
-                                     : 0.5 * (x1 + x2) * (image_width - 1);
-              if (in_x < 0 || in_x > image_width - 1) {
-                for (int d = 0; d < depth; ++d) {
-                  crops(b, y, x, d) = extrapolation_value;
-                }
-                continue;
-              }
-              const int left_x_index = floorf(in_x);
-              const int right_x_index = ceilf(in_x);
-              const float x_lerp = in_x - left_x_index;
-
+            resizer->ResizeRow({top_y_index, bottom_y_index, y_lerp},
+                               &crops(b, y, 0, 0));
+            for (int x : extrapolated_xs) {
               for (int d = 0; d < depth; ++d) {
-                const float top_left(static_cast<float>(
-                    image(b_in, top_y_index, left_x_index, d)));
-                const float top_right(static_cast<float>(
-                    image(b_in, top_y_index, right_x_index, d)));
-                const float bottom_left(static_cast<float>(
-                    image(b_in, bottom_y_index, left_x_index, d)));
-                const float bottom_right(static_cast<float>(
-                    image(b_in, bottom_y_index, right_x_index, d)));
-                const float top = top_left + (top_right - top_left) * x_lerp;
-                const float bottom =
-                    bottom_left + (bottom_right - bottom_left) * x_lerp;
-                crops(b, y, x, d) = top + (bottom - top) * y_lerp;
+                crops(b, y, x, d) = extrapolation_value;
               }
             }
           } else {  // method == "nearest"
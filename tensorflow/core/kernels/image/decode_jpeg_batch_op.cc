@@ -0,0 +1,427 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#define EIGEN_USE_THREADS
+#if GOOGLE_CUDA
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/kernels/image/decode_jpeg_batch_op.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image/bilinear_resizer.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/image_resizer_state.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/nvjpeg.h"
+#include "tensorflow/core/kernels/gpu_device_array.h"
+#endif  // GOOGLE_CUDA
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+#if GOOGLE_CUDA
+namespace functor {
+template <>
+void WriteDecodedJpegs<GPUDevice>::operator()(
+    const GPUDevice& d, const uint8* buffer,
+    const GpuDeviceArrayStruct<DecodedJpeg>& images,
+    typename TTypes<uint8, 4>::Tensor output);
+extern template struct WriteDecodedJpegs<GPUDevice>;
+}  // namespace functor
+#endif  // GOOGLE_CUDA
+
+namespace {
+
+// Decodes a batch of JPEG images to RGB. The decoding of the images is left to
+// the subclasses, which fill in the size of each encoded image, while this
+// class applies the crop windows and the resizing and allocates the outputs.
+class DecodeJpegBatchOpBase : public OpKernel {
+ public:
+  explicit DecodeJpegBatchOpBase(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("size", &size_));
+    OP_REQUIRES(context,
+                size_.empty() || (size_.size() == 2 && size_[0] > 0 &&
+                                  size_[1] > 0),
+                errors::InvalidArgument(
+                    "size must be empty or a positive [height, width]"));
+  }
+
+ protected:
+  bool resize() const { return !size_.empty(); }
+
+  // Checks the inputs and returns the encoded images.
+  Status GetContents(OpKernelContext* context,
+                     TTypes<tstring>::ConstVec* contents) {
+    const Tensor& contents_tensor = context->input(0);
+    if (!TensorShapeUtils::IsVector(contents_tensor.shape())) {
+      return errors::InvalidArgument("contents must be 1-D, got shape ",
+                                     contents_tensor.shape().DebugString());
+    }
+    const Tensor& crop_windows = context->input(1);
+    if (crop_windows.dims() != 2 || crop_windows.dim_size(1) != 4 ||
+        (crop_windows.dim_size(0) != 0 &&
+         crop_windows.dim_size(0) != contents_tensor.NumElements())) {
+      return errors::InvalidArgument(
+          "crop_windows must be [0, 4] or [batch, 4], got shape ",
+          crop_windows.shape().DebugString(), " for a batch of ",
+          contents_tensor.NumElements());
+    }
+    *contents = contents_tensor.vec<tstring>();
+    return Status::OK();
+  }
+
+  // Applies the crop windows and the resizing to `images`, whose windows are
+  // the whole decoded images on input, and allocates the outputs.
+  Status PrepareOutputs(OpKernelContext* context,
+                        std::vector<DecodedJpeg>* images, Tensor** output) {
+    const Tensor& crop_windows = context->input(1);
+    const int64 batch = images->size();
+    Tensor* image_shapes = nullptr;
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(1, TensorShape({batch, 2}), &image_shapes));
+    auto image_shapes_matrix = image_shapes->matrix<int32>();
+    int64 height = resize() ? size_[0] : 0;
+    int64 width = resize() ? size_[1] : 0;
+    for (int64 b = 0; b < batch; ++b) {
+      DecodedJpeg& image = (*images)[b];
+      if (crop_windows.NumElements() > 0) {
+        auto window = crop_windows.matrix<int32>();
+        const int32 y = window(b, 0);
+        const int32 x = window(b, 1);
+        const int32 h = window(b, 2);
+        const int32 w = window(b, 3);
+        if (y < 0 || x < 0 || h <= 0 || w <= 0 ||
+            static_cast<int64>(y) + h > image.crop_height ||
+            static_cast<int64>(x) + w > image.crop_width) {
+          return errors::InvalidArgument(
+              "Invalid crop window [", y, ", ", x, ", ", h, ", ", w,
+              "] of image ", b, " of size ", image.crop_height, "x",
+              image.crop_width);
+        }
+        image.crop_y = y;
+        image.crop_x = x;
+        image.crop_height = h;
+        image.crop_width = w;
+      }
+      image.height = resize() ? size_[0] : image.crop_height;
+      image.width = resize() ? size_[1] : image.crop_width;
+      height = std::max<int64>(height, image.height);
+      width = std::max<int64>(width, image.width);
+      image_shapes_matrix(b, 0) = image.height;
+      image_shapes_matrix(b, 1) = image.width;
+    }
+    return context->allocate_output(0, TensorShape({batch, height, width, 3}),
+                                    output);
+  }
+
+ private:
+  std::vector<int32> size_;
+};
+
+// Returns the largest ratio libjpeg can scale `image` down by while decoding,
+// for which its window is still at least as large as the resized image. This
+// skips most of the decoding work for the large images that are typically
+// resized to a small, fixed size, and leaves the bilinear resize to shrink the
+// window by less than 2x, where it does not alias much.
+int DctScaleRatio(const DecodedJpeg& image) {
+  for (int ratio = 8; ratio > 1; ratio /= 2) {
+    if (image.crop_height >= static_cast<int64>(image.height) * ratio &&
+        image.crop_width >= static_cast<int64>(image.width) * ratio) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+class DecodeJpegBatchOp : public DecodeJpegBatchOpBase {
+ public:
+  explicit DecodeJpegBatchOp(OpKernelConstruction* context)
+      : DecodeJpegBatchOpBase(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    TTypes<tstring>::ConstVec contents(nullptr, 0);
+    OP_REQUIRES_OK(context, GetContents(context, &contents));
+    const int64 batch = contents.size();
+    std::vector<DecodedJpeg> images(batch);
+    // The [height, width] of the encoded images.
+    std::vector<std::pair<int, int>> image_sizes(batch);
+    for (int64 b = 0; b < batch; ++b) {
+      int height, width;
+      OP_REQUIRES(context,
+                  jpeg::GetImageInfo(contents(b).data(), contents(b).size(),
+                                     &width, &height, nullptr),
+                  errors::InvalidArgument("Invalid JPEG data at index ", b));
+      images[b].crop_height = height;
+      images[b].crop_width = width;
+      image_sizes[b] = {height, width};
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, PrepareOutputs(context, &images, &output));
+    if (output->NumElements() == 0) return;
+    auto output_tensor = output->tensor<uint8, 4>();
+    output_tensor.device(context->eigen_cpu_device()) =
+        output_tensor.constant(0);
+
+    // Each image decodes and resizes independently.
+    std::vector<Status> statuses(batch);
+    auto decode = [&](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        statuses[b] = Decode(contents(b), image_sizes[b], images[b],
+                             output_tensor, b);
+      }
+    };
+    const int64 image_size = output->NumElements() / batch;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, batch,
+          /*cost_per_unit=*/image_size * 100, decode);
+    for (const Status& status : statuses) {
+      OP_REQUIRES_OK(context, status);
+    }
+  }
+
+ private:
+  // Decodes the window of image `b` with libjpeg, straight into its slot of
+  // the output if it is not resized.
+  Status Decode(const tstring& contents, const std::pair<int, int>& image_size,
+                const DecodedJpeg& image, TTypes<uint8, 4>::Tensor output,
+                int64 b) {
+    jpeg::UncompressFlags flags;
+    flags.components = 3;
+    flags.crop = true;
+    flags.crop_y = image.crop_y;
+    flags.crop_x = image.crop_x;
+    flags.crop_height = image.crop_height;
+    flags.crop_width = image.crop_width;
+    uint8* slot = &output(b, 0, 0, 0);
+    const int64 row_bytes = output.dimension(2) * 3;
+    if (!resize()) {
+      flags.stride = row_bytes;
+      uint8* decoded = jpeg::Uncompress(
+          contents.data(), contents.size(), flags, nullptr,
+          [&](int width, int height, int components) -> uint8* {
+            if (width != image.width || height != image.height) {
+              return nullptr;
+            }
+            return slot;
+          });
+      if (decoded == nullptr) {
+        return errors::InvalidArgument("Invalid JPEG data at index ", b);
+      }
+      return Status::OK();
+    }
+
+    // libjpeg scales the image down by the ratio in the DCT domain, at a
+    // fraction of the cost of a full decode. The window is scaled with it,
+    // rounding outwards.
+    const int ratio = DctScaleRatio(image);
+    if (ratio > 1) {
+      const int scaled_height = (image_size.first + ratio - 1) / ratio;
+      const int scaled_width = (image_size.second + ratio - 1) / ratio;
+      flags.ratio = ratio;
+      flags.crop_y = image.crop_y / ratio;
+      flags.crop_x = image.crop_x / ratio;
+      flags.crop_height =
+          std::min(scaled_height,
+                   (image.crop_y + image.crop_height + ratio - 1) / ratio) -
+          flags.crop_y;
+      flags.crop_width =
+          std::min(scaled_width,
+                   (image.crop_x + image.crop_width + ratio - 1) / ratio) -
+          flags.crop_x;
+    }
+    std::unique_ptr<uint8[]> decoded(jpeg::Uncompress(
+        contents.data(), contents.size(), flags, nullptr, nullptr, nullptr,
+        nullptr));
+    if (decoded == nullptr) {
+      return errors::InvalidArgument("Invalid JPEG data at index ", b);
+    }
+    // Resizes in fixed point, like the GPU kernel.
+    std::vector<CachedInterpolation> ys(image.height + 1);
+    std::vector<CachedInterpolation> xs(image.width + 1);
+    compute_interpolation_weights(
+        HalfPixelScaler(), image.height, flags.crop_height,
+        static_cast<float>(flags.crop_height) / image.height, ys.data());
+    compute_interpolation_weights(
+        HalfPixelScaler(), image.width, flags.crop_width,
+        static_cast<float>(flags.crop_width) / image.width, xs.data());
+    for (CachedInterpolation& x : xs) {
+      x.lower *= 3;
+      x.upper *= 3;
+    }
+    BilinearResizer<uint8, uint8> resizer(
+        decoded.get(), flags.crop_width * 3, xs.data(), image.width, 3);
+    for (int64 y = 0; y < image.height; ++y) {
+      resizer.ResizeRow(ys[y], slot + y * row_bytes);
+    }
+    return Status::OK();
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeJpegBatch").Device(DEVICE_CPU),
+                        DecodeJpegBatchOp);
+
+#if GOOGLE_CUDA
+
+Status NvjpegError(nvjpegStatus_t status, const char* call) {
+  return errors::Internal(call, " failed with nvJPEG status ", status);
+}
+
+#define NVJPEG_RETURN_IF_ERROR(call)                        \
+  do {                                                      \
+    nvjpegStatus_t status = (call);                         \
+    if (status != NVJPEG_STATUS_SUCCESS) {                  \
+      return NvjpegError(status, #call);                    \
+    }                                                       \
+  } while (0)
+
+// Decodes the batch with nvJPEG, whose batched decoder splits the work
+// between the host (Huffman decoding) and the GPU (IDCT and color
+// conversion), then crops, resizes and pads the images on the GPU.
+class DecodeJpegBatchGpuOp : public DecodeJpegBatchOpBase {
+ public:
+  explicit DecodeJpegBatchGpuOp(OpKernelConstruction* context)
+      : DecodeJpegBatchOpBase(context) {}
+
+  ~DecodeJpegBatchGpuOp() override {
+    if (state_ != nullptr) nvjpegJpegStateDestroy(state_);
+    if (handle_ != nullptr) nvjpegDestroy(handle_);
+  }
+
+  void Compute(OpKernelContext* context) override {
+    TTypes<tstring>::ConstVec contents(nullptr, 0);
+    OP_REQUIRES_OK(context, GetContents(context, &contents));
+    // The decoder state is shared by the invocations of the kernel.
+    mutex_lock l(mu_);
+    OP_REQUIRES_OK(context, InitNvjpeg());
+
+    const int64 batch = contents.size();
+    std::vector<DecodedJpeg> images(batch);
+    int64 buffer_size = 0;
+    for (int64 b = 0; b < batch; ++b) {
+      int components;
+      nvjpegChromaSubsampling_t subsampling;
+      int widths[NVJPEG_MAX_COMPONENT];
+      int heights[NVJPEG_MAX_COMPONENT];
+      const unsigned char* data =
+          reinterpret_cast<const unsigned char*>(contents(b).data());
+      OP_REQUIRES(context,
+                  nvjpegGetImageInfo(handle_, data, contents(b).size(),
+                                     &components, &subsampling, widths,
+                                     heights) == NVJPEG_STATUS_SUCCESS,
+                  errors::InvalidArgument("Invalid JPEG data at index ", b));
+      DecodedJpeg& image = images[b];
+      image.offset = buffer_size;
+      image.row_bytes = widths[0] * 3;
+      image.crop_height = heights[0];
+      image.crop_width = widths[0];
+      buffer_size += static_cast<int64>(heights[0]) * image.row_bytes;
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, PrepareOutputs(context, &images, &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor buffer;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_UINT8, TensorShape({buffer_size}), &buffer));
+    uint8* buffer_data = buffer.flat<uint8>().data();
+    std::vector<const unsigned char*> data(batch);
+    std::vector<size_t> lengths(batch);
+    std::vector<nvjpegImage_t> destinations(batch);
+    for (int64 b = 0; b < batch; ++b) {
+      data[b] = reinterpret_cast<const unsigned char*>(contents(b).data());
+      lengths[b] = contents(b).size();
+      destinations[b] = nvjpegImage_t();
+      destinations[b].channel[0] = buffer_data + images[b].offset;
+      destinations[b].pitch[0] = images[b].row_bytes;
+    }
+    const GPUDevice& device = context->eigen_gpu_device();
+    OP_REQUIRES_OK(context, DecodeBatch(data, lengths, &destinations,
+                                        device.stream()));
+
+    GpuDeviceArrayOnHost<DecodedJpeg> images_on_host(context, batch);
+    OP_REQUIRES_OK(context, images_on_host.Init());
+    for (int64 b = 0; b < batch; ++b) images_on_host.Set(b, images[b]);
+    OP_REQUIRES_OK(context, images_on_host.Finalize());
+    functor::WriteDecodedJpegs<GPUDevice>()(device, buffer_data,
+                                            images_on_host.data(),
+                                            output->tensor<uint8, 4>());
+  }
+
+ private:
+  Status InitNvjpeg() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (state_ != nullptr) return Status::OK();
+    if (handle_ == nullptr &&
+        nvjpegCreate(NVJPEG_BACKEND_DEFAULT, nullptr, &handle_) !=
+            NVJPEG_STATUS_SUCCESS) {
+      handle_ = nullptr;
+      return errors::Unavailable(
+          "nvJPEG is not available, decode the images on the CPU instead");
+    }
+    NVJPEG_RETURN_IF_ERROR(nvjpegJpegStateCreate(handle_, &state_));
+    return Status::OK();
+  }
+
+  Status DecodeBatch(const std::vector<const unsigned char*>& data,
+                     const std::vector<size_t>& lengths,
+                     std::vector<nvjpegImage_t>* destinations,
+                     cudaStream_t stream) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    NVJPEG_RETURN_IF_ERROR(nvjpegDecodeBatchedInitialize(
+        handle_, state_, data.size(), /*max_cpu_threads=*/1,
+        NVJPEG_OUTPUT_RGBI));
+    NVJPEG_RETURN_IF_ERROR(nvjpegDecodeBatched(handle_, state_, data.data(),
+                                               lengths.data(),
+                                               destinations->data(), stream));
+    return Status::OK();
+  }
+
+  mutex mu_;
+  nvjpegHandle_t handle_ TF_GUARDED_BY(mu_) = nullptr;
+  nvjpegJpegState_t state_ TF_GUARDED_BY(mu_) = nullptr;
+};
+
+#undef NVJPEG_RETURN_IF_ERROR
+
+REGISTER_KERNEL_BUILDER(Name("DecodeJpegBatch")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("contents")
+                            .HostMemory("crop_windows")
+                            .HostMemory("image_shapes"),
+                        DecodeJpegBatchGpuOp);
+
+#endif  // GOOGLE_CUDA
+
+}  // namespace
+
+}  // namespace tensorflow
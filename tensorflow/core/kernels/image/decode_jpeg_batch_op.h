@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_IMAGE_DECODE_JPEG_BATCH_OP_H_
+#define TENSORFLOW_CORE_KERNELS_IMAGE_DECODE_JPEG_BATCH_OP_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/core/kernels/gpu_device_array_gpu.h"
+#endif  // GOOGLE_CUDA
+
+namespace tensorflow {
+
+// Where one decoded RGB image of a batch lives in the decoding buffer, and
+// which part of it is written to its slot of the padded output.
+struct DecodedJpeg {
+  // Offset of the first byte of the decoded image in the buffer.
+  int64 offset = 0;
+  // Distance in bytes between two rows of the decoded image.
+  int32 row_bytes = 0;
+  // The window of the decoded image which is written to the output.
+  int32 crop_y = 0;
+  int32 crop_x = 0;
+  int32 crop_height = 0;
+  int32 crop_width = 0;
+  // The size the window is resized to. Equal to the window size if the image
+  // is not resized.
+  int32 height = 0;
+  int32 width = 0;
+};
+
+// Returns channel `c` of pixel (`y`, `x`) of the window of `image`, resized
+// with bilinear interpolation and half pixel centers. `y` and `x` must be
+// smaller than the resized height and width.
+EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE uint8 DecodedJpegValue(
+    const uint8* buffer, const DecodedJpeg& image, int64 y, int64 x, int c) {
+  const uint8* window = buffer + image.offset +
+                        static_cast<int64>(image.crop_y) * image.row_bytes +
+                        static_cast<int64>(image.crop_x) * 3 + c;
+  if (image.height == image.crop_height && image.width == image.crop_width) {
+    return window[y * image.row_bytes + x * 3];
+  }
+  const float in_y = Eigen::numext::maxi(
+      (y + 0.5f) * image.crop_height / image.height - 0.5f, 0.0f);
+  const float in_x = Eigen::numext::maxi(
+      (x + 0.5f) * image.crop_width / image.width - 0.5f, 0.0f);
+  const int64 last_y = image.crop_height - 1;
+  const int64 last_x = image.crop_width - 1;
+  // Non-negative, so truncation rounds down.
+  const int64 top = Eigen::numext::mini(static_cast<int64>(in_y), last_y);
+  const int64 left = Eigen::numext::mini(static_cast<int64>(in_x), last_x);
+  const int64 bottom = Eigen::numext::mini(top + 1, last_y);
+  const int64 right = Eigen::numext::mini(left + 1, last_x);
+  const float y_lerp = Eigen::numext::mini(in_y - top, 1.0f);
+  const float x_lerp = Eigen::numext::mini(in_x - left, 1.0f);
+  const uint8* top_row = window + top * image.row_bytes;
+  const uint8* bottom_row = window + bottom * image.row_bytes;
+  const float top_value =
+      top_row[left * 3] + (top_row[right * 3] - top_row[left * 3]) * x_lerp;
+  const float bottom_value =
+      bottom_row[left * 3] +
+      (bottom_row[right * 3] - bottom_row[left * 3]) * x_lerp;
+  return static_cast<uint8>(top_value + (bottom_value - top_value) * y_lerp +
+                            0.5f);
+}
+
+#if GOOGLE_CUDA
+namespace functor {
+
+// Writes the windows of the RGB images decoded to `buffer` to the zero padded
+// [batch, height, width, 3] `output`, resizing them if needed.
+template <typename Device>
+struct WriteDecodedJpegs {
+  void operator()(const Device& d, const uint8* buffer,
+                  const GpuDeviceArrayStruct<DecodedJpeg>& images,
+                  typename TTypes<uint8, 4>::Tensor output);
+};
+
+}  // namespace functor
+#endif  // GOOGLE_CUDA
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_IMAGE_DECODE_JPEG_BATCH_OP_H_
@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/image/decode_jpeg_batch_op.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// One thread per output value. The values outside of the resized window of
+// each image are zero.
+__global__ void WriteDecodedJpegsKernel(
+    const uint8* __restrict__ buffer,
+    GpuDeviceArrayStruct<DecodedJpeg> images, int64 height, int64 width,
+    int64 output_size, uint8* __restrict__ output) {
+  const DecodedJpeg* images_ptr = GetGpuDeviceArrayOnDevice(&images);
+  GPU_1D_KERNEL_LOOP(index, output_size) {
+    const int c = index % 3;
+    const int64 x = index / 3 % width;
+    const int64 y = index / 3 / width % height;
+    const int64 b = index / 3 / width / height;
+    const DecodedJpeg& image = images_ptr[b];
+    output[index] = y < image.height && x < image.width
+                        ? DecodedJpegValue(buffer, image, y, x, c)
+                        : uint8(0);
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <>
+void WriteDecodedJpegs<GPUDevice>::operator()(
+    const GPUDevice& d, const uint8* buffer,
+    const GpuDeviceArrayStruct<DecodedJpeg>& images,
+    typename TTypes<uint8, 4>::Tensor output) {
+  const int64 output_size = output.size();
+  if (output_size == 0) return;
+  GpuLaunchConfig config = GetGpuLaunchConfig(output_size, d);
+  TF_CHECK_OK(GpuLaunchKernel(WriteDecodedJpegsKernel, config.block_count,
+                              config.thread_per_block, 0, d.stream(), buffer,
+                              images, output.dimension(1), output.dimension(2),
+                              output_size, output.data()));
+}
+
+template struct WriteDecodedJpegs<GPUDevice>;
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
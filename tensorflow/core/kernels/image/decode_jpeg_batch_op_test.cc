@@ -0,0 +1,224 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a JPEG encoded RGB image with smooth gradients, which survive the
+// compression well.
+tstring EncodeTestImage(int height, int width) {
+  std::vector<uint8> pixels(height * width * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8* pixel = &pixels[(y * width + x) * 3];
+      pixel[0] = 255 * y / height;
+      pixel[1] = 255 * x / width;
+      pixel[2] = 128;
+    }
+  }
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  return jpeg::Compress(pixels.data(), width, height, flags);
+}
+
+// Decodes a window of `contents` with libjpeg.
+Tensor DecodeWindow(const tstring& contents, int y, int x, int height,
+                    int width) {
+  jpeg::UncompressFlags flags;
+  flags.components = 3;
+  flags.crop = true;
+  flags.crop_y = y;
+  flags.crop_x = x;
+  flags.crop_height = height;
+  flags.crop_width = width;
+  std::unique_ptr<uint8[]> decoded(jpeg::Uncompress(
+      contents.data(), contents.size(), flags, nullptr, nullptr, nullptr,
+      nullptr));
+  CHECK(decoded != nullptr);
+  Tensor image(DT_UINT8, TensorShape({height, width, 3}));
+  std::copy_n(decoded.get(), image.NumElements(), image.flat<uint8>().data());
+  return image;
+}
+
+// Resizes `image` with bilinear interpolation and half pixel centers.
+Tensor ResizeBilinear(const Tensor& image, int height, int width) {
+  auto in = image.tensor<uint8, 3>();
+  const int in_height = image.dim_size(0);
+  const int in_width = image.dim_size(1);
+  Tensor resized(DT_UINT8, TensorShape({height, width, 3}));
+  auto out = resized.tensor<uint8, 3>();
+  for (int y = 0; y < height; ++y) {
+    const double in_y =
+        std::max((y + 0.5) * in_height / height - 0.5, 0.0);
+    const int top = std::min(static_cast<int>(in_y), in_height - 1);
+    const int bottom = std::min(top + 1, in_height - 1);
+    for (int x = 0; x < width; ++x) {
+      const double in_x = std::max((x + 0.5) * in_width / width - 0.5, 0.0);
+      const int left = std::min(static_cast<int>(in_x), in_width - 1);
+      const int right = std::min(left + 1, in_width - 1);
+      for (int c = 0; c < 3; ++c) {
+        const double top_value =
+            in(top, left, c) + (in(top, right, c) - in(top, left, c)) *
+                                   std::min(in_x - left, 1.0);
+        const double bottom_value =
+            in(bottom, left, c) +
+            (in(bottom, right, c) - in(bottom, left, c)) *
+                std::min(in_x - left, 1.0);
+        out(y, x, c) = std::round(top_value + (bottom_value - top_value) *
+                                                  std::min(in_y - top, 1.0));
+      }
+    }
+  }
+  return resized;
+}
+
+class DecodeJpegBatchOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const std::vector<int32>& size) {
+    TF_ASSERT_OK(NodeDefBuilder("decode_jpeg_batch", "DecodeJpegBatch")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("size", size)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddInputs(const std::vector<tstring>& contents,
+                 const std::vector<int32>& crop_windows) {
+    AddInputFromArray<tstring>(
+        TensorShape({static_cast<int64>(contents.size())}), contents);
+    AddInputFromArray<int32>(
+        TensorShape({static_cast<int64>(crop_windows.size() / 4), 4}),
+        crop_windows);
+  }
+
+  // Checks that the output slot of image `b` holds `expected`, followed by
+  // zeros.
+  void ExpectImage(int b, const Tensor& expected, int tolerance) {
+    auto output = GetOutput(0)->tensor<uint8, 4>();
+    auto image = expected.tensor<uint8, 3>();
+    for (int y = 0; y < output.dimension(1); ++y) {
+      for (int x = 0; x < output.dimension(2); ++x) {
+        for (int c = 0; c < 3; ++c) {
+          const bool inside =
+              y < expected.dim_size(0) && x < expected.dim_size(1);
+          EXPECT_NEAR(inside ? image(y, x, c) : 0, output(b, y, x, c),
+                      tolerance)
+              << "image " << b << " at " << y << ", " << x << ", " << c;
+        }
+      }
+    }
+    EXPECT_EQ(expected.dim_size(0), GetOutput(1)->matrix<int32>()(b, 0));
+    EXPECT_EQ(expected.dim_size(1), GetOutput(1)->matrix<int32>()(b, 1));
+  }
+};
+
+TEST_F(DecodeJpegBatchOpTest, PadsToLargestImage) {
+  const tstring small = EncodeTestImage(5, 17);
+  const tstring large = EncodeTestImage(40, 9);
+  MakeOp({});
+  AddInputs({small, large}, {});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({2, 40, 17, 3}), GetOutput(0)->shape());
+  ExpectImage(0, DecodeWindow(small, 0, 0, 5, 17), 0);
+  ExpectImage(1, DecodeWindow(large, 0, 0, 40, 9), 0);
+}
+
+TEST_F(DecodeJpegBatchOpTest, Crops) {
+  const tstring first = EncodeTestImage(50, 60);
+  const tstring second = EncodeTestImage(30, 20);
+  MakeOp({});
+  AddInputs({first, second}, {10, 17, 25, 30, 3, 0, 20, 20});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({2, 25, 30, 3}), GetOutput(0)->shape());
+  ExpectImage(0, DecodeWindow(first, 10, 17, 25, 30), 0);
+  ExpectImage(1, DecodeWindow(second, 3, 0, 20, 20), 0);
+}
+
+TEST_F(DecodeJpegBatchOpTest, CropsAndResizes) {
+  const tstring first = EncodeTestImage(50, 60);
+  const tstring second = EncodeTestImage(30, 20);
+  MakeOp({16, 24});
+  AddInputs({first, second}, {10, 17, 25, 30, 3, 0, 8, 20});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({2, 16, 24, 3}), GetOutput(0)->shape());
+  // The fixed point interpolation of the kernel may round differently.
+  ExpectImage(0, ResizeBilinear(DecodeWindow(first, 10, 17, 25, 30), 16, 24),
+              1);
+  ExpectImage(1, ResizeBilinear(DecodeWindow(second, 3, 0, 8, 20), 16, 24),
+              1);
+}
+
+TEST_F(DecodeJpegBatchOpTest, DownscalesWhileDecoding) {
+  // The crop window is 8x the size of the output, so the images decode at 1/8
+  // of their size, averaging blocks of 8x8 pixels. On these gradients, that
+  // matches resizing the full size window.
+  const tstring contents = EncodeTestImage(200, 160);
+  MakeOp({20, 16});
+  AddInputs({contents}, {8, 16, 160, 128});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectImage(
+      0, ResizeBilinear(DecodeWindow(contents, 8, 16, 160, 128), 20, 16), 3);
+}
+
+TEST_F(DecodeJpegBatchOpTest, DownscalesAndResizesWhileDecoding) {
+  // Decodes at 1/4 of the size, to a 28x35 window, then resizes it.
+  const tstring contents = EncodeTestImage(120, 150);
+  MakeOp({16, 20});
+  AddInputs({contents}, {4, 8, 112, 140});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectImage(
+      0, ResizeBilinear(DecodeWindow(contents, 4, 8, 112, 140), 16, 20), 3);
+}
+
+TEST_F(DecodeJpegBatchOpTest, EmptyBatch) {
+  MakeOp({8, 8});
+  AddInputs({}, {});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({0, 8, 8, 3}), GetOutput(0)->shape());
+  EXPECT_EQ(TensorShape({0, 2}), GetOutput(1)->shape());
+}
+
+TEST_F(DecodeJpegBatchOpTest, CropWindowOutOfBounds) {
+  MakeOp({});
+  AddInputs({EncodeTestImage(10, 10)}, {5, 0, 6, 10});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(DecodeJpegBatchOpTest, InvalidJpeg) {
+  MakeOp({});
+  AddInputs({EncodeTestImage(10, 10), "not a jpeg"}, {});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
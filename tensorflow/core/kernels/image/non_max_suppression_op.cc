@@ -291,35 +291,64 @@ struct ResultCandidate {
   float box_coord[4];
 };
 
+// Corners and areas of the boxes selected for a class, stored as separate
+// arrays so that a candidate can be compared against a block of them with a
+// loop the compiler vectorizes.
+struct SelectedBoxes {
+  explicit SelectedBoxes(int capacity) {
+    ymin.reserve(capacity);
+    xmin.reserve(capacity);
+    ymax.reserve(capacity);
+    xmax.reserve(capacity);
+    area.reserve(capacity);
+  }
+
+  void Add(float y_min, float x_min, float y_max, float x_max, float a) {
+    ymin.push_back(y_min);
+    xmin.push_back(x_min);
+    ymax.push_back(y_max);
+    xmax.push_back(x_max);
+    area.push_back(a);
+  }
+
+  std::vector<float> ymin, xmin, ymax, xmax, area;
+};
+
+// The number of selected boxes compared with a candidate at once.
+constexpr int kSuppressionBlockSize = 16;
+
+// Returns true if the IOU of the box with the given corners and area with one
+// of the selected boxes `begin` to `end` exceeds `iou_threshold`. Computes the
+// same IOU as IOU() above, but without branches in the loop.
+bool IsSuppressedByBlock(const SelectedBoxes& selected, int begin, int end,
+                         float y_min, float x_min, float y_max, float x_max,
+                         float area, float iou_threshold) {
+  const float* ymin_j = selected.ymin.data();
+  const float* xmin_j = selected.xmin.data();
+  const float* ymax_j = selected.ymax.data();
+  const float* xmax_j = selected.xmax.data();
+  const float* area_j = selected.area.data();
+  bool suppressed = false;
+  for (int j = begin; j < end; ++j) {
+    const float intersection_ymin = std::max(y_min, ymin_j[j]);
+    const float intersection_xmin = std::max(x_min, xmin_j[j]);
+    const float intersection_ymax = std::min(y_max, ymax_j[j]);
+    const float intersection_xmax = std::min(x_max, xmax_j[j]);
+    const float intersection_area =
+        std::max(intersection_ymax - intersection_ymin, 0.0f) *
+        std::max(intersection_xmax - intersection_xmin, 0.0f);
+    const float iou =
+        intersection_area / (area + area_j[j] - intersection_area);
+    suppressed |= (area_j[j] > 0.0f) & (iou > iou_threshold);
+  }
+  return suppressed;
+}
+
 void DoNMSPerClass(int batch_idx, int class_idx, const float* boxes_data,
                    const float* scores_data, int num_boxes, int q,
                    int num_classes, const int size_per_class,
                    const float score_threshold, const float iou_threshold,
                    std::vector<ResultCandidate>& result_candidate_vec) {
-  std::vector<float> class_scores_data;
-  class_scores_data.reserve(num_boxes);
-  std::vector<float> class_boxes_data;
-  class_boxes_data.reserve(num_boxes * 4);
-
-  for (int box_idx = 0; box_idx < num_boxes; ++box_idx) {
-    class_scores_data.push_back(scores_data[box_idx * num_classes + class_idx]);
-    for (int cid = 0; cid < 4; ++cid) {
-      if (q > 1) {
-        class_boxes_data.push_back(
-            boxes_data[(box_idx * q + class_idx) * 4 + cid]);
-      } else {
-        class_boxes_data.push_back(boxes_data[box_idx * 4 + cid]);
-      }
-    }
-  }
-
-  // Copy class_boxes_data to a tensor
-  TensorShape boxesShape({num_boxes, 4});
-  Tensor boxes(DT_FLOAT, boxesShape);
-  std::copy_n(class_boxes_data.begin(), class_boxes_data.size(),
-              boxes.unaligned_flat<float>().data());
-
-  // Do NMS, get the candidate indices of form vector<int>
   // Data structure for selection candidate in NMS.
   struct Candidate {
     int box_index;
@@ -328,49 +357,55 @@ void DoNMSPerClass(int batch_idx, int class_idx, const float* boxes_data,
   auto cmp = [](const Candidate bs_i, const Candidate bs_j) {
     return bs_i.score > bs_j.score;
   };
+  // Only the boxes scoring above the threshold are ever looked at.
   std::vector<Candidate> candidate_vector;
-  for (int i = 0; i < class_scores_data.size(); ++i) {
-    if (class_scores_data[i] > score_threshold) {
-      candidate_vector.emplace_back(Candidate({i, class_scores_data[i]}));
+  for (int i = 0; i < num_boxes; ++i) {
+    const float score = scores_data[i * num_classes + class_idx];
+    if (score > score_threshold) {
+      candidate_vector.push_back({i, score});
     }
   }
-
-  std::vector<int> selected;
-  std::vector<float> selected_boxes;
-  Candidate next_candidate;
-
   std::sort(candidate_vector.begin(), candidate_vector.end(), cmp);
-  const Tensor const_boxes = boxes;
-  typename TTypes<float, 2>::ConstTensor boxes_data_t =
-      const_boxes.tensor<float, 2>();
+
+  SelectedBoxes selected(size_per_class);
+  int num_selected = 0;
   int candidate_idx = 0;
-  float iou;
-  while (selected.size() < size_per_class &&
+  while (num_selected < size_per_class &&
          candidate_idx < candidate_vector.size()) {
-    next_candidate = candidate_vector[candidate_idx++];
+    const Candidate& next_candidate = candidate_vector[candidate_idx++];
+    const int id = next_candidate.box_index;
+    const float* box = boxes_data + (q > 1 ? id * q + class_idx : id) * 4;
+    const float y_min = std::min(box[0], box[2]);
+    const float x_min = std::min(box[1], box[3]);
+    const float y_max = std::max(box[0], box[2]);
+    const float x_max = std::max(box[1], box[3]);
+    const float area = (y_max - y_min) * (x_max - x_min);
 
     // Overlapping boxes are likely to have similar scores,
     // therefore we iterate through the previously selected boxes backwards
-    // in order to see if `next_candidate` should be suppressed.
+    // in order to see if `next_candidate` should be suppressed. Boxes without
+    // area never suppress nor get suppressed.
     bool should_select = true;
-    for (int j = selected.size() - 1; j >= 0; --j) {
-      iou = IOU<float>(boxes_data_t, next_candidate.box_index, selected[j]);
-      if (iou > iou_threshold) {
-        should_select = false;
-        break;
+    if (area > 0.0f) {
+      for (int end = num_selected; end > 0; end -= kSuppressionBlockSize) {
+        const int begin = std::max(end - kSuppressionBlockSize, 0);
+        if (IsSuppressedByBlock(selected, begin, end, y_min, x_min, y_max,
+                                x_max, area, iou_threshold)) {
+          should_select = false;
+          break;
+        }
       }
     }
 
     if (should_select) {
       // Add the selected box to the result candidate. Sorted by score
-      int id = next_candidate.box_index;
-      result_candidate_vec[selected.size() + size_per_class * class_idx] = {
-          next_candidate.box_index,
+      result_candidate_vec[num_selected + size_per_class * class_idx] = {
+          id,
           next_candidate.score,
           class_idx,
-          {boxes_data_t(id, 0), boxes_data_t(id, 1), boxes_data_t(id, 2),
-           boxes_data_t(id, 3)}};
-      selected.push_back(next_candidate.box_index);
+          {box[0], box[1], box[2], box[3]}};
+      selected.Add(y_min, x_min, y_max, x_max, area);
+      ++num_selected;
     }
   }
 }
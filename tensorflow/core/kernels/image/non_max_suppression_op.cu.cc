@@ -719,6 +719,492 @@ class NonMaxSuppressionV4GPUOp : public OpKernel {
   bool pad_to_max_output_size_;
 };
 
+// Writes the score of class c of box i of batch b to
+// class_scores[(b * num_classes + c) * num_boxes + i], so that the boxes of
+// each batch and class, a segment, are contiguous, and sets box_indices to i.
+__global__ void TransposeClassScores(const int num_elements,
+                                     const float* scores, const int num_boxes,
+                                     const int num_classes,
+                                     float* class_scores, int* box_indices) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int box = idx % num_boxes;
+    const int segment = idx / num_boxes;
+    const int batch = segment / num_classes;
+    const int class_idx = segment % num_classes;
+    class_scores[idx] =
+        scores[(batch * num_boxes + box) * num_classes + class_idx];
+    box_indices[idx] = box;
+  }
+}
+
+// Sets offsets[i] to i * segment_size.
+__global__ void SegmentOffsets(const int num_offsets, const int segment_size,
+                               int* offsets) {
+  for (int idx : GpuGridRangeX(num_offsets)) {
+    offsets[idx] = idx * segment_size;
+  }
+}
+
+// Gathers the boxes of each segment in the order of their sorted scores. The
+// boxes are [batch, num_boxes, q, 4], where q is 1 when the classes share
+// their boxes.
+__global__ void GatherSortedClassBoxes(const int num_elements,
+                                       const float4* boxes,
+                                       const int* sorted_box_indices,
+                                       const int num_boxes,
+                                       const int num_classes, const int q,
+                                       float4* sorted_boxes) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int segment = idx / num_boxes;
+    const int batch = segment / num_classes;
+    const int class_idx = q > 1 ? segment % num_classes : 0;
+    const int box = sorted_box_indices[idx];
+    sorted_boxes[idx] = boxes[(batch * num_boxes + box) * q + class_idx];
+  }
+}
+
+// Sets counts[s] to the number of scores of segment s, sorted in descending
+// order, above `threshold`. Counts must be zeroed beforehand.
+__global__ void CountSortedAboveThreshold(const int num_elements,
+                                          const float* sorted_scores,
+                                          const int num_boxes,
+                                          const float threshold,
+                                          int* counts) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int box = idx % num_boxes;
+    if (sorted_scores[idx] > threshold &&
+        (box == num_boxes - 1 || !(sorted_scores[idx + 1] > threshold))) {
+      counts[idx / num_boxes] = box + 1;
+    }
+  }
+}
+
+// Copies the boxes that NMS selected from a segment to the candidates of its
+// batch.
+__global__ void WriteSelectedCandidates(
+    const int num_selected, const int* selected_indices,
+    const float* sorted_scores, const float4* sorted_boxes,
+    const float class_idx, float* candidate_scores, float4* candidate_boxes,
+    float* candidate_classes) {
+  for (int idx : GpuGridRangeX(num_selected)) {
+    const int box = selected_indices[idx];
+    candidate_scores[idx] = sorted_scores[box];
+    candidate_boxes[idx] = sorted_boxes[box];
+    candidate_classes[idx] = class_idx;
+  }
+}
+
+__device__ EIGEN_STRONG_INLINE float ClipToUnit(float x) {
+  return fminf(fmaxf(x, 0.0f), 1.0f);
+}
+
+// Writes the first per_batch_size of the num_candidates candidates of each
+// batch, sorted by score, to the outputs, and zeros past the candidates
+// scoring above `threshold`. The unused candidates score `threshold`.
+__global__ void WriteCombinedNMSOutputs(
+    const int num_elements, const int per_batch_size, const int num_candidates,
+    const float threshold, const float* sorted_candidate_scores,
+    const int* sorted_candidate_indices, const float4* candidate_boxes,
+    const float* candidate_classes, const bool clip_boxes,
+    float4* nmsed_boxes, float* nmsed_scores, float* nmsed_classes) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int batch = idx / per_batch_size;
+    const int j = idx % per_batch_size;
+    const int k = batch * num_candidates + j;
+    if (j < num_candidates && sorted_candidate_scores[k] > threshold) {
+      const int candidate = sorted_candidate_indices[k];
+      float4 box = candidate_boxes[candidate];
+      if (clip_boxes) {
+        box.x = ClipToUnit(box.x);
+        box.y = ClipToUnit(box.y);
+        box.z = ClipToUnit(box.z);
+        box.w = ClipToUnit(box.w);
+      }
+      nmsed_boxes[idx] = box;
+      nmsed_scores[idx] = sorted_candidate_scores[k];
+      nmsed_classes[idx] = candidate_classes[candidate];
+    } else {
+      nmsed_boxes[idx] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+      nmsed_scores[idx] = 0.0f;
+      nmsed_classes[idx] = 0.0f;
+    }
+  }
+}
+
+// Sets valid_detections[b] to the number of candidates of batch b scoring
+// above `threshold`, capped at per_batch_size.
+__global__ void CountValidDetections(const int num_batches,
+                                     const int num_candidates,
+                                     const int per_batch_size,
+                                     const float threshold,
+                                     const float* sorted_candidate_scores,
+                                     int* valid_detections) {
+  const int limit = min(num_candidates, per_batch_size);
+  for (int batch : GpuGridRangeX(num_batches)) {
+    const float* scores = sorted_candidate_scores + batch * num_candidates;
+    int count = 0;
+    while (count < limit && scores[count] > threshold) ++count;
+    valid_detections[batch] = count;
+  }
+}
+
+// Runs CombinedNonMaxSuppression on the GPU.
+//
+// The scores of every batch and class are sorted at once with a segmented
+// sort, and the boxes of each (batch, class) segment that score above
+// `score_threshold` go through NmsGpu, the bitmask NMS of the other ops. The
+// boxes each class selects become the candidates of its batch, and a second
+// segmented sort orders the candidates of every batch by score to produce
+// the outputs. The only host synchronizations are reading the number of boxes
+// above the score threshold in every segment, and the one in each NmsGpu call.
+Status DoCombinedNMS(OpKernelContext* context, const Tensor& boxes,
+                     const Tensor& scores, const int max_size_per_class,
+                     const int total_size_per_batch, const float iou_threshold,
+                     const float score_threshold, const bool pad_per_class,
+                     const bool clip_boxes) {
+  const int num_batches = boxes.dim_size(0);
+  const int num_boxes = boxes.dim_size(1);
+  const int q = boxes.dim_size(2);
+  const int num_classes = scores.dim_size(2);
+  const int size_per_class =
+      std::max(std::min(max_size_per_class, num_boxes), 0);
+  int per_batch_size = total_size_per_batch;
+  if (pad_per_class) {
+    per_batch_size = std::max(
+        std::min(total_size_per_batch, max_size_per_class * num_classes), 0);
+  }
+  const int num_segments = num_batches * num_classes;
+  const int num_elements = num_segments * num_boxes;
+  // The candidates of a batch: up to size_per_class boxes of every class.
+  const int num_candidates = num_classes * size_per_class;
+
+  Tensor* nmsed_boxes = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      0, TensorShape({num_batches, per_batch_size, 4}), &nmsed_boxes));
+  Tensor* nmsed_scores = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      1, TensorShape({num_batches, per_batch_size}), &nmsed_scores));
+  Tensor* nmsed_classes = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      2, TensorShape({num_batches, per_batch_size}), &nmsed_classes));
+  Tensor* valid_detections = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      3, TensorShape({num_batches}), &valid_detections));
+
+  auto device = context->eigen_gpu_device();
+  auto cuda_stream = GetGpuStream(context);
+  if (num_batches == 0) return Status::OK();
+  if (num_elements == 0 || num_candidates == 0 || per_batch_size == 0) {
+    // Nothing can be selected.
+    for (Tensor* output : {nmsed_boxes, nmsed_scores, nmsed_classes}) {
+      if (output->NumElements() == 0) continue;
+      auto config = GetGpuLaunchConfig(output->NumElements(), device);
+      TF_CHECK_OK(GpuLaunchKernel(SetZero<float>, config.block_count,
+                                  config.thread_per_block, 0, device.stream(),
+                                  config.virtual_thread_count,
+                                  output->flat<float>().data()));
+    }
+    auto config = GetGpuLaunchConfig(num_batches, device);
+    TF_CHECK_OK(GpuLaunchKernel(SetZero<int>, config.block_count,
+                                config.thread_per_block, 0, device.stream(),
+                                config.virtual_thread_count,
+                                valid_detections->flat<int>().data()));
+    return Status::OK();
+  }
+
+  // Sort the boxes of every segment by score.
+  size_t sort_temp_storage_bytes = 0;
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          nullptr, sort_temp_storage_bytes, static_cast<float*>(nullptr),
+          static_cast<float*>(nullptr), static_cast<int*>(nullptr),
+          static_cast<int*>(nullptr), num_elements, num_segments,
+          static_cast<int*>(nullptr), static_cast<int*>(nullptr), 0,
+          8 * sizeof(float),  // sort all bits
+          cuda_stream));
+  Tensor d_sort_buffer;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT8, TensorShape({(int64)sort_temp_storage_bytes}),
+      &d_sort_buffer));
+  Tensor d_class_scores, d_sorted_scores;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_FLOAT, TensorShape({num_elements}), &d_class_scores));
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_FLOAT, TensorShape({num_elements}), &d_sorted_scores));
+  Tensor d_box_indices, d_sorted_box_indices;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_elements}), &d_box_indices));
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_elements}), &d_sorted_box_indices));
+  Tensor d_offsets;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_segments + 1}), &d_offsets));
+  Tensor d_sorted_boxes;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_FLOAT, TensorShape({num_elements, 4}), &d_sorted_boxes));
+
+  auto config = GetGpuLaunchConfig(num_elements, device);
+  TF_CHECK_OK(GpuLaunchKernel(
+      TransposeClassScores, config.block_count, config.thread_per_block, 0,
+      device.stream(), config.virtual_thread_count,
+      scores.flat<float>().data(), num_boxes, num_classes,
+      d_class_scores.flat<float>().data(), d_box_indices.flat<int>().data()));
+  config = GetGpuLaunchConfig(num_segments + 1, device);
+  TF_CHECK_OK(GpuLaunchKernel(SegmentOffsets, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count, num_boxes,
+                              d_offsets.flat<int>().data()));
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          d_sort_buffer.flat<int8>().data(), sort_temp_storage_bytes,
+          d_class_scores.flat<float>().data(),
+          d_sorted_scores.flat<float>().data(),
+          d_box_indices.flat<int>().data(),
+          d_sorted_box_indices.flat<int>().data(), num_elements, num_segments,
+          d_offsets.flat<int>().data(), d_offsets.flat<int>().data() + 1, 0,
+          8 * sizeof(float),  // sort all bits
+          cuda_stream));
+  config = GetGpuLaunchConfig(num_elements, device);
+  const float4* sorted_boxes =
+      reinterpret_cast<const float4*>(d_sorted_boxes.flat<float>().data());
+  TF_CHECK_OK(GpuLaunchKernel(
+      GatherSortedClassBoxes, config.block_count, config.thread_per_block, 0,
+      device.stream(), config.virtual_thread_count,
+      reinterpret_cast<const float4*>(boxes.flat<float>().data()),
+      d_sorted_box_indices.flat<int>().data(), num_boxes, num_classes, q,
+      reinterpret_cast<float4*>(d_sorted_boxes.flat<float>().data())));
+
+  // Read the number of boxes above the score threshold in every segment.
+  Tensor d_counts;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_segments}), &d_counts));
+  config = GetGpuLaunchConfig(num_segments, device);
+  TF_CHECK_OK(GpuLaunchKernel(SetZero<int>, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count,
+                              d_counts.flat<int>().data()));
+  config = GetGpuLaunchConfig(num_elements, device);
+  TF_CHECK_OK(GpuLaunchKernel(CountSortedAboveThreshold, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count,
+                              d_sorted_scores.flat<float>().data(), num_boxes,
+                              score_threshold, d_counts.flat<int>().data()));
+  TF_RETURN_IF_CUDA_ERROR(cudaGetLastError());
+  AllocatorAttributes alloc_attr;
+  alloc_attr.set_on_host(true);
+  alloc_attr.set_gpu_compatible(true);
+  Tensor h_counts;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_segments}), &h_counts, alloc_attr));
+  gpuEvent_t copy_done;
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuEventCreateWithFlags(&copy_done, gpuEventDisableTiming));
+  device.memcpyDeviceToHost(h_counts.flat<int>().data(),
+                            d_counts.flat<int>().data(),
+                            num_segments * sizeof(int));
+  TF_RETURN_IF_CUDA_ERROR(gpuEventRecord(copy_done, device.stream()));
+  TF_RETURN_IF_CUDA_ERROR(gpuEventSynchronize(copy_done));
+  gpuEventDestroy(copy_done);
+
+  // Run NMS on every segment and collect the selected boxes of each batch.
+  // The candidates a class leaves unused score `score_threshold`, which sorts
+  // them after the selected boxes, all of which score above it.
+  const int total_candidates = num_batches * num_candidates;
+  Tensor d_candidate_scores, d_candidate_classes, d_candidate_boxes;
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_FLOAT,
+                                            TensorShape({total_candidates}),
+                                            &d_candidate_scores));
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_FLOAT,
+                                            TensorShape({total_candidates}),
+                                            &d_candidate_classes));
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_FLOAT,
+                                            TensorShape({total_candidates, 4}),
+                                            &d_candidate_boxes));
+  config = GetGpuLaunchConfig(total_candidates, device);
+  TF_CHECK_OK(GpuLaunchKernel(SetToValue<float>, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count,
+                              d_candidate_scores.flat<float>().data(),
+                              score_threshold));
+  float* candidate_scores = d_candidate_scores.flat<float>().data();
+  float* candidate_classes = d_candidate_classes.flat<float>().data();
+  float4* candidate_boxes =
+      reinterpret_cast<float4*>(d_candidate_boxes.flat<float>().data());
+  Tensor d_selected_indices;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT32, TensorShape({num_boxes}), &d_selected_indices));
+  const int* counts = h_counts.flat<int>().data();
+  for (int segment = 0; segment < num_segments; ++segment) {
+    if (counts[segment] == 0) continue;
+    const int offset = segment * num_boxes;
+    int num_selected = 0;
+    // Boxes may be given with x1>x2 or y1>y2, so let NmsGpu flip them.
+    TF_RETURN_IF_ERROR(NmsGpu(d_sorted_boxes.flat<float>().data() + offset * 4,
+                              counts[segment], iou_threshold,
+                              d_selected_indices.flat<int>().data(),
+                              &num_selected, context, size_per_class,
+                              /*flip_boxes=*/true));
+    num_selected = std::min(num_selected, size_per_class);
+    if (num_selected == 0) continue;
+    const int batch = segment / num_classes;
+    const int class_idx = segment % num_classes;
+    const int candidate_offset =
+        batch * num_candidates + class_idx * size_per_class;
+    config = GetGpuLaunchConfig(num_selected, device);
+    TF_CHECK_OK(GpuLaunchKernel(
+        WriteSelectedCandidates, config.block_count, config.thread_per_block,
+        0, device.stream(), config.virtual_thread_count,
+        d_selected_indices.flat<int>().data(),
+        d_sorted_scores.flat<float>().data() + offset, sorted_boxes + offset,
+        static_cast<float>(class_idx), candidate_scores + candidate_offset,
+        candidate_boxes + candidate_offset,
+        candidate_classes + candidate_offset));
+  }
+
+  // Sort the candidates of every batch by score.
+  Tensor d_candidate_indices, d_sorted_candidate_indices;
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_INT32,
+                                            TensorShape({total_candidates}),
+                                            &d_candidate_indices));
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_INT32,
+                                            TensorShape({total_candidates}),
+                                            &d_sorted_candidate_indices));
+  Tensor d_sorted_candidate_scores;
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataType::DT_FLOAT,
+                                            TensorShape({total_candidates}),
+                                            &d_sorted_candidate_scores));
+  config = GetGpuLaunchConfig(total_candidates, device);
+  TF_CHECK_OK(GpuLaunchKernel(Iota<int>, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count, 0,
+                              d_candidate_indices.flat<int>().data()));
+  config = GetGpuLaunchConfig(num_batches + 1, device);
+  TF_CHECK_OK(GpuLaunchKernel(SegmentOffsets, config.block_count,
+                              config.thread_per_block, 0, device.stream(),
+                              config.virtual_thread_count, num_candidates,
+                              d_offsets.flat<int>().data()));
+  size_t candidate_sort_bytes = 0;
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          nullptr, candidate_sort_bytes, static_cast<float*>(nullptr),
+          static_cast<float*>(nullptr), static_cast<int*>(nullptr),
+          static_cast<int*>(nullptr), total_candidates, num_batches,
+          static_cast<int*>(nullptr), static_cast<int*>(nullptr), 0,
+          8 * sizeof(float),  // sort all bits
+          cuda_stream));
+  if (candidate_sort_bytes > sort_temp_storage_bytes) {
+    TF_RETURN_IF_ERROR(context->allocate_temp(
+        DataType::DT_INT8, TensorShape({(int64)candidate_sort_bytes}),
+        &d_sort_buffer));
+  }
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          d_sort_buffer.flat<int8>().data(), candidate_sort_bytes,
+          candidate_scores, d_sorted_candidate_scores.flat<float>().data(),
+          d_candidate_indices.flat<int>().data(),
+          d_sorted_candidate_indices.flat<int>().data(), total_candidates,
+          num_batches, d_offsets.flat<int>().data(),
+          d_offsets.flat<int>().data() + 1, 0,
+          8 * sizeof(float),  // sort all bits
+          cuda_stream));
+
+  config = GetGpuLaunchConfig(num_batches * per_batch_size, device);
+  TF_CHECK_OK(GpuLaunchKernel(
+      WriteCombinedNMSOutputs, config.block_count, config.thread_per_block, 0,
+      device.stream(), config.virtual_thread_count, per_batch_size,
+      num_candidates, score_threshold,
+      d_sorted_candidate_scores.flat<float>().data(),
+      d_sorted_candidate_indices.flat<int>().data(), candidate_boxes,
+      candidate_classes, clip_boxes,
+      reinterpret_cast<float4*>(nmsed_boxes->flat<float>().data()),
+      nmsed_scores->flat<float>().data(),
+      nmsed_classes->flat<float>().data()));
+  config = GetGpuLaunchConfig(num_batches, device);
+  TF_CHECK_OK(GpuLaunchKernel(
+      CountValidDetections, config.block_count, config.thread_per_block, 0,
+      device.stream(), num_batches, num_candidates, per_batch_size,
+      score_threshold, d_sorted_candidate_scores.flat<float>().data(),
+      valid_detections->flat<int>().data()));
+  TF_RETURN_IF_CUDA_ERROR(cudaGetLastError());
+  return Status::OK();
+}
+
+class CombinedNonMaxSuppressionGPUOp : public OpKernel {
+ public:
+  explicit CombinedNonMaxSuppressionGPUOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("pad_per_class", &pad_per_class_));
+    OP_REQUIRES_OK(context, context->GetAttr("clip_boxes", &clip_boxes_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // boxes: [batch_size, num_anchors, q, 4]
+    const Tensor& boxes = context->input(0);
+    // scores: [batch_size, num_anchors, num_classes]
+    const Tensor& scores = context->input(1);
+    OP_REQUIRES(context, boxes.dims() == 4,
+                errors::InvalidArgument("boxes must be 4-D",
+                                        boxes.shape().DebugString()));
+    OP_REQUIRES(context, scores.dims() == 3,
+                errors::InvalidArgument("scores must be 3-D",
+                                        scores.shape().DebugString()));
+    OP_REQUIRES(
+        context, (boxes.dim_size(0) == scores.dim_size(0)),
+        errors::InvalidArgument("boxes and scores must have same batch size"));
+    const int num_classes = scores.dim_size(2);
+    OP_REQUIRES(
+        context, boxes.dim_size(2) == num_classes || boxes.dim_size(2) == 1,
+        errors::InvalidArgument(
+            "third dimension of boxes must be either 1 or num classes"));
+    OP_REQUIRES(context, boxes.dim_size(3) == 4,
+                errors::InvalidArgument("boxes must have 4 columns"));
+    OP_REQUIRES(context, scores.dim_size(1) == boxes.dim_size(1),
+                errors::InvalidArgument("scores has incompatible shape"));
+
+    // max_output_size: scalar
+    const Tensor& max_output_size = context->input(2);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(max_output_size.shape()),
+        errors::InvalidArgument("max_size_per_class must be 0-D, got shape ",
+                                max_output_size.shape().DebugString()));
+    const int max_size_per_class = max_output_size.scalar<int>()();
+    // max_total_size: scalar
+    const Tensor& max_total_size = context->input(3);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(max_total_size.shape()),
+        errors::InvalidArgument("max_total_size must be 0-D, got shape ",
+                                max_total_size.shape().DebugString()));
+    const int max_total_size_per_batch = max_total_size.scalar<int>()();
+    OP_REQUIRES(context, max_total_size_per_batch > 0,
+                errors::InvalidArgument("max_total_size must be > 0"));
+    // iou_threshold: scalar
+    const Tensor& iou_threshold = context->input(4);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(iou_threshold.shape()),
+                errors::InvalidArgument("iou_threshold must be 0-D, got shape ",
+                                        iou_threshold.shape().DebugString()));
+    const float iou_threshold_val = iou_threshold.scalar<float>()();
+    // score_threshold: scalar
+    const Tensor& score_threshold = context->input(5);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(score_threshold.shape()),
+        errors::InvalidArgument("score_threshold must be 0-D, got shape ",
+                                score_threshold.shape().DebugString()));
+    const float score_threshold_val = score_threshold.scalar<float>()();
+    OP_REQUIRES(context, iou_threshold_val >= 0 && iou_threshold_val <= 1,
+                errors::InvalidArgument("iou_threshold must be in [0, 1]"));
+
+    OP_REQUIRES_OK(context,
+                   DoCombinedNMS(context, boxes, scores, max_size_per_class,
+                                 max_total_size_per_batch, iou_threshold_val,
+                                 score_threshold_val, pad_per_class_,
+                                 clip_boxes_));
+  }
+
+ private:
+  bool pad_per_class_;
+  bool clip_boxes_;
+};
+
 REGISTER_KERNEL_BUILDER(Name("NonMaxSuppressionV2")
                             .TypeConstraint<float>("T")
                             .Device(DEVICE_GPU)
@@ -742,5 +1228,13 @@ REGISTER_KERNEL_BUILDER(Name("NonMaxSuppressionV4")
                             .HostMemory("score_threshold"),
                         NonMaxSuppressionV4GPUOp);
 
+REGISTER_KERNEL_BUILDER(Name("CombinedNonMaxSuppression")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("max_output_size_per_class")
+                            .HostMemory("max_total_size")
+                            .HostMemory("iou_threshold")
+                            .HostMemory("score_threshold"),
+                        CombinedNonMaxSuppressionGPUOp);
+
 }  // namespace tensorflow
 #endif
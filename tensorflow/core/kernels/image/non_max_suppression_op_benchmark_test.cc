@@ -56,11 +56,19 @@ static Graph* BM_CombinedNonMaxSuppression(int batches, int box_num,
   }                                                                          \
   BENCHMARK(BM_CombinedNMS_##DEVICE##_##B##_##BN##_##CN##_##Q);
 
-#define BM_Batch(BN, CN, Q)                            \
-  BM_CombinedNonMaxSuppressionDev(cpu, 1, BN, CN, Q);  \
-  BM_CombinedNonMaxSuppressionDev(cpu, 28, BN, CN, Q); \
-  BM_CombinedNonMaxSuppressionDev(cpu, 32, BN, CN, Q); \
-  BM_CombinedNonMaxSuppressionDev(cpu, 64, BN, CN, Q);
+#define BM_BatchDev(DEVICE, BN, CN, Q)                    \
+  BM_CombinedNonMaxSuppressionDev(DEVICE, 1, BN, CN, Q);  \
+  BM_CombinedNonMaxSuppressionDev(DEVICE, 28, BN, CN, Q); \
+  BM_CombinedNonMaxSuppressionDev(DEVICE, 32, BN, CN, Q); \
+  BM_CombinedNonMaxSuppressionDev(DEVICE, 64, BN, CN, Q);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define BM_Batch(BN, CN, Q)  \
+  BM_BatchDev(cpu, BN, CN, Q); \
+  BM_BatchDev(gpu, BN, CN, Q);
+#else
+#define BM_Batch(BN, CN, Q) BM_BatchDev(cpu, BN, CN, Q);
+#endif
 
 #define BN_Boxes_Number(CN, Q) \
   BM_Batch(500, CN, Q);        \
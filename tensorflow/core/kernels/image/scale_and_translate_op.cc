@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/image/scale_and_translate_op.h"
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -572,23 +574,63 @@ struct GatherSpans<CPUDevice, T> {
     const int64 output_width = resized_images.dimension(2);
 
     const int64 input_pix_per_batch = input_width * input_height * channels;
+    const int64 intermediate_row_size = input_width * channels;
     const int64 intermediate_pix_per_batch =
-        input_width * output_height * channels;
-    const int64 output_pix_per_batch = output_width * output_height * channels;
+        output_height * intermediate_row_size;
+    const int64 output_row_size = output_width * channels;
+    const int64 output_pix_per_batch = output_height * output_row_size;
     float* intermediate_ptr = intermediate_buffer.data();
-
     const T* image_ptr = images.data();
     float* out_ptr = resized_images.data();
-    for (int b = 0; b < batch_size; ++b, image_ptr += input_pix_per_batch,
-             intermediate_ptr += intermediate_pix_per_batch,
-             out_ptr += output_pix_per_batch) {
-      GatherRows(row_span_size, row_starts.data(), row_weights.data(),
-                 image_ptr, input_height, input_width, output_height,
-                 input_width, channels, intermediate_ptr);
-      GatherColumns(col_span_size, col_starts.data(), col_weights.data(),
-                    intermediate_ptr, output_height, input_width, output_height,
-                    output_width, channels, out_ptr);
-    }
+
+    // Both passes are parallel over the output rows of all images. A range
+    // of rows of one image is gathered by offsetting the row starts, weights
+    // and buffers to its first row.
+    auto for_each_image_rows =
+        [&](int64 start, int64 limit,
+            const std::function<void(int64, int64, int64)>& fn) {
+          while (start < limit) {
+            const int64 b = start / output_height;
+            const int64 y = start - b * output_height;
+            const int64 rows = std::min(limit - start, output_height - y);
+            fn(b, y, rows);
+            start += rows;
+          }
+        };
+    auto gather_rows = [&](int64 start, int64 limit) {
+      for_each_image_rows(start, limit, [&](int64 b, int64 y, int64 rows) {
+        GatherRows(row_span_size, row_starts.data() + y,
+                   row_weights.data() + y * row_span_size,
+                   image_ptr + b * input_pix_per_batch, input_height,
+                   input_width, rows, input_width, channels,
+                   intermediate_ptr + b * intermediate_pix_per_batch +
+                       y * intermediate_row_size);
+      });
+    };
+    auto gather_columns = [&](int64 start, int64 limit) {
+      for_each_image_rows(start, limit, [&](int64 b, int64 y, int64 rows) {
+        GatherColumns(col_span_size, col_starts.data(), col_weights.data(),
+                      intermediate_ptr + b * intermediate_pix_per_batch +
+                          y * intermediate_row_size,
+                      rows, input_width, rows, output_width, channels,
+                      out_ptr + b * output_pix_per_batch + y * output_row_size);
+      });
+    };
+    const int64 num_rows = batch_size * output_height;
+    const Eigen::TensorOpCost rows_cost(
+        row_span_size * intermediate_row_size * sizeof(T),
+        intermediate_row_size * sizeof(float),
+        row_span_size * intermediate_row_size *
+            (Eigen::TensorOpCost::AddCost<float>() +
+             Eigen::TensorOpCost::MulCost<float>()));
+    d.parallelFor(num_rows, rows_cost, gather_rows);
+    const Eigen::TensorOpCost columns_cost(
+        col_span_size * output_row_size * sizeof(float),
+        output_row_size * sizeof(float),
+        col_span_size * output_row_size *
+            (Eigen::TensorOpCost::AddCost<float>() +
+             Eigen::TensorOpCost::MulCost<float>()));
+    d.parallelFor(num_rows, columns_cost, gather_columns);
   }
 };
 
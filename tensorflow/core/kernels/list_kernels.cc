@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/concat_lib.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
@@ -296,6 +297,13 @@ class TensorListReserve : public OpKernel {
  public:
   explicit TensorListReserve(OpKernelConstruction* c) : OpKernel(c) {
     OP_REQUIRES_OK(c, c->GetAttr("element_dtype", &element_dtype_));
+    // On the CPU, the elements of reserved lists may be copied into a slab
+    // when they are set, so that stacking them needs no copy. Disabled by
+    // default.
+    if (c->device_type() == DEVICE_CPU) {
+      OP_REQUIRES_OK(
+          c, ReadBoolFromEnvVar("TF_TENSOR_LIST_SLABS", false, &use_slab_));
+    }
   }
 
   void Compute(OpKernelContext* c) override {
@@ -306,6 +314,20 @@ class TensorListReserve : public OpKernel {
     output.element_shape = element_shape;
     output.element_dtype = element_dtype_;
     output.tensors().resize(num_elements, Tensor(DT_INVALID));
+    TensorShape slab_shape;
+    if (use_slab_ && num_elements > 0 &&
+        DataTypeCanUseMemcpy(element_dtype_) &&
+        element_shape.AsTensorShape(&slab_shape)) {
+      const int64 element_bytes =
+          slab_shape.num_elements() * DataTypeSize(element_dtype_);
+      if (element_bytes > 0 &&
+          element_bytes % Allocator::kAllocatorAlignment == 0) {
+        slab_shape.InsertDim(0, num_elements);
+        Tensor slab;
+        OP_REQUIRES_OK(c, c->allocate_temp(element_dtype_, slab_shape, &slab));
+        output.SetSlab(std::move(slab));
+      }
+    }
     Tensor* result;
     AllocatorAttributes attr;
     attr.set_on_host(true);
@@ -315,6 +337,7 @@ class TensorListReserve : public OpKernel {
 
  private:
   DataType element_dtype_;
+  bool use_slab_ = false;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TensorListReserve").Device(DEVICE_CPU),
@@ -393,7 +416,8 @@ REGISTER_KERNEL_BUILDER(
 
 class TensorListSetItem : public OpKernel {
  public:
-  explicit TensorListSetItem(OpKernelConstruction* c) : OpKernel(c) {
+  explicit TensorListSetItem(OpKernelConstruction* c)
+      : OpKernel(c), on_host_(c->device_type() == DEVICE_CPU) {
     OP_REQUIRES_OK(c, c->GetAttr("element_dtype", &element_dtype_));
   }
 
@@ -419,11 +443,17 @@ class TensorListSetItem : public OpKernel {
                     " list shape: ", l->element_shape.DebugString()));
     TensorList* output_list = nullptr;
     OP_REQUIRES_OK(c, ForwardInputOrCreateNewList(c, 0, 0, *l, &output_list));
-    output_list->tensors()[index] = value;
+    Tensor element;
+    if (on_host_ && output_list->WriteToSlab(index, value, &element)) {
+      output_list->tensors()[index] = std::move(element);
+    } else {
+      output_list->tensors()[index] = value;
+    }
   }
 
  private:
   DataType element_dtype_;
+  const bool on_host_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TensorListSetItem").Device(DEVICE_CPU),
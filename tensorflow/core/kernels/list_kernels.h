@@ -113,6 +113,15 @@ class TensorListStack : public OpKernel {
                     partial_element_shape.DebugString()));
     TensorShape output_shape = element_shape;
     output_shape.InsertDim(0, tensor_list->tensors().size());
+    // Elements that were copied into the slab of the list are already
+    // stacked.
+    Tensor view;
+    if (std::is_same<Device, CPUDevice>::value &&
+        tensor_list->SlabView(0, tensor_list->tensors().size(), &view) &&
+        view.shape() == output_shape) {
+      c->set_output(0, view);
+      return;
+    }
     Tensor* output;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() == 0) {
@@ -595,6 +604,24 @@ class TensorListGather : public OpKernel {
                                 partial_element_shape.DebugString()));
     TensorShape output_shape = element_shape;
     output_shape.InsertDim(0, indices.NumElements());
+    // Consecutive elements that were copied into the slab of the list are
+    // already stacked.
+    if (std::is_same<Device, CPUDevice>::value && indices.NumElements() > 0) {
+      const auto indices_flat = indices.flat<int32>();
+      const int begin = indices_flat(0);
+      bool consecutive = true;
+      for (int index = 1; index < indices.NumElements() && consecutive;
+           ++index) {
+        consecutive = indices_flat(index) == begin + index;
+      }
+      Tensor view;
+      if (consecutive &&
+          tensor_list->SlabView(begin, begin + indices.NumElements(), &view) &&
+          view.shape() == output_shape) {
+        c->set_output(0, view);
+        return;
+      }
+    }
     Tensor* output;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() == 0) {
@@ -20,6 +20,7 @@ limitations under the License.
 #include <type_traits>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
@@ -301,6 +302,21 @@ inline uint64 HashScalar(const T& key) {
 
 inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
 
+// Hashes the keys of a ShardedMutableHashTable. The bits of HashScalar() are
+// mixed, since the hash tables of the shards need well distributed hashes.
+struct ShardedTableKeyHash {
+  template <typename T>
+  size_t operator()(const T& key) const {
+    uint64 hash = HashScalar(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+  }
+};
+
 // If the given shape is a scalar return {1} instead. Otherwise leave it alone.
 TensorShape MaybeVectorizeShape(const TensorShape& shape) {
   if (shape.dims() == 0) {
@@ -311,6 +327,282 @@ TensorShape MaybeVectorizeShape(const TensorShape& shape) {
 
 }  // namespace
 
+// Lookup table that spreads its entries over `num_shards` hash tables, each
+// guarded by its own lock, so that concurrent finds and inserts of different
+// keys rarely contend.  Values are tensors of shape `value_shape`, which may be
+// a scalar or a vector, and are stored contiguously in each shard.
+//
+// Batched operations group their keys by shard, so that each lock is taken
+// once per batch, and prefetch the buckets of upcoming keys while probing the
+// current one.  The order of the keys within a shard is preserved, so the last
+// of duplicate keys in an insert wins, as in MutableHashTableOfScalars.
+template <class K, class V>
+class ShardedMutableHashTable final : public LookupInterface {
+ public:
+  ShardedMutableHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(value_shape_) ||
+                    TensorShapeUtils::IsVector(value_shape_),
+                errors::InvalidArgument(
+                    "Default value must be a scalar or a vector, got shape ",
+                    value_shape_.DebugString()));
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards > 0,
+                errors::InvalidArgument("num_shards must be positive, got ",
+                                        num_shards));
+    num_shards_ = num_shards;
+    shards_.reset(new Shard[num_shards_]);
+    value_dim_ = value_shape_.num_elements();
+  }
+
+  size_t size() const override {
+    size_t size = 0;
+    for (int64 s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      size += shards_[s].index.size();
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat<V>();
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+
+    std::vector<int64> order;
+    std::vector<int64> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 k = offsets[s]; k < offsets[s + 1]; ++k) {
+        if (k + kPrefetchDistance < offsets[s + 1]) {
+          shard.index.prefetch(key_values(order[k + kPrefetchDistance]));
+        }
+        const int64 i = order[k];
+        auto it = shard.index.find(SubtleMustCopyIfIntegral(key_values(i)));
+        if (it != shard.index.end()) {
+          const int64 slot = it->second * value_dim_;
+          for (int64 j = 0; j < value_dim_; ++j) {
+            value_values(i * value_dim_ + j) = shard.values[slot + j];
+          }
+        } else {
+          for (int64 j = 0; j < value_dim_; ++j) {
+            value_values(i * value_dim_ + j) = default_flat(j);
+          }
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    std::vector<int64> order;
+    std::vector<int64> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      Shard* shard = &shards_[s];
+      mutex_lock l(shard->mu);
+      InsertLocked(key_values, value_values, order, offsets[s],
+                   offsets[s + 1], shard);
+    }
+    return Status::OK();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    std::vector<int64> order;
+    std::vector<int64> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      Shard* shard = &shards_[s];
+      mutex_lock l(shard->mu);
+      for (int64 k = offsets[s]; k < offsets[s + 1]; ++k) {
+        auto it =
+            shard->index.find(SubtleMustCopyIfIntegral(key_values(order[k])));
+        if (it == shard->index.end()) continue;
+        // Releases the memory held by the removed value, e.g. for strings.
+        for (int64 j = 0; j < value_dim_; ++j) {
+          shard->values[it->second * value_dim_ + j] = V();
+        }
+        shard->free_slots.push_back(it->second);
+        shard->index.erase(it);
+      }
+    }
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    std::vector<int64> order;
+    std::vector<int64> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    // Holds all the locks, acquired in shard order, so that no find observes a
+    // partially imported table.
+    std::vector<mutex_lock> locks;
+    locks.reserve(num_shards_);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      locks.emplace_back(shards_[s].mu);
+    }
+    for (int64 s = 0; s < num_shards_; ++s) {
+      Shard* shard = &shards_[s];
+      shard->index.clear();
+      shard->values.clear();
+      shard->num_slots = 0;
+      shard->free_slots.clear();
+      InsertLocked(key_values, value_values, order, offsets[s],
+                   offsets[s + 1], shard);
+    }
+    return Status::OK();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    std::vector<tf_shared_lock> locks;
+    locks.reserve(num_shards_);
+    int64 size = 0;
+    for (int64 s = 0; s < num_shards_; ++s) {
+      locks.emplace_back(shards_[s].mu);
+      size += shards_[s].index.size();
+    }
+
+    TensorShape values_shape({size});
+    values_shape.AppendShape(value_shape_);
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output("values", values_shape, &values));
+
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64 i = 0;
+    for (int64 s = 0; s < num_shards_; ++s) {
+      const Shard& shard = shards_[s];
+      for (const auto& entry : shard.index) {
+        keys_data(i) = entry.first;
+        const int64 slot = entry.second * value_dim_;
+        for (int64 j = 0; j < value_dim_; ++j) {
+          values_data(i * value_dim_ + j) = shard.values[slot + j];
+        }
+        ++i;
+      }
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64 MemoryUsed() const override {
+    int64 ret = sizeof(ShardedMutableHashTable) + num_shards_ * sizeof(Shard);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      ret += shards_[s].index.capacity() *
+                 (sizeof(std::pair<K, int64>) + 1) +
+             shards_[s].values.capacity() * sizeof(V) +
+             shards_[s].free_slots.capacity() * sizeof(int64);
+    }
+    return ret;
+  }
+
+ private:
+  // Number of keys ahead of the current one whose buckets are prefetched.
+  static constexpr int64 kPrefetchDistance = 8;
+
+  struct Shard {
+    mutable mutex mu;
+    // Maps each key to its slot in `values`.
+    absl::flat_hash_map<K, int64, ShardedTableKeyHash> index TF_GUARDED_BY(mu);
+    // The value of slot `i` is `values[i * value_dim_ : (i + 1) * value_dim_]`.
+    std::vector<V> values TF_GUARDED_BY(mu);
+    int64 num_slots TF_GUARDED_BY(mu) = 0;
+    // Slots of removed keys, reused by later inserts.
+    std::vector<int64> free_slots TF_GUARDED_BY(mu);
+  };
+
+  int64 ShardIndex(const K& key) const {
+    // The shard tables consume the low bits of the hash, so the shard is
+    // picked from the high bits to keep the keys of a shard well spread.
+    const uint64 hash = ShardedTableKeyHash()(key);
+    return static_cast<int64>(((hash >> 32) * num_shards_) >> 32);
+  }
+
+  // Sets `order` to the indices of `keys` sorted by shard, with the keys of
+  // shard `s` at `order[offsets[s] : offsets[s + 1]]` in their original order.
+  void GroupByShard(typename TTypes<K>::ConstFlat keys,
+                    std::vector<int64>* order,
+                    std::vector<int64>* offsets) const {
+    const int64 num_keys = keys.size();
+    std::vector<int64> key_shards(num_keys);
+    offsets->assign(num_shards_ + 1, 0);
+    for (int64 i = 0; i < num_keys; ++i) {
+      key_shards[i] = ShardIndex(SubtleMustCopyIfIntegral(keys(i)));
+      ++(*offsets)[key_shards[i] + 1];
+    }
+    for (int64 s = 0; s < num_shards_; ++s) {
+      (*offsets)[s + 1] += (*offsets)[s];
+    }
+    std::vector<int64> next(offsets->begin(), offsets->end() - 1);
+    order->resize(num_keys);
+    for (int64 i = 0; i < num_keys; ++i) {
+      (*order)[next[key_shards[i]]++] = i;
+    }
+  }
+
+  void InsertLocked(typename TTypes<K>::ConstFlat keys,
+                    typename TTypes<V>::ConstFlat values,
+                    const std::vector<int64>& order, int64 begin, int64 end,
+                    Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    for (int64 k = begin; k < end; ++k) {
+      if (k + kPrefetchDistance < end) {
+        shard->index.prefetch(keys(order[k + kPrefetchDistance]));
+      }
+      const int64 i = order[k];
+      auto result =
+          shard->index.emplace(SubtleMustCopyIfIntegral(keys(i)), int64{0});
+      if (result.second) {
+        if (!shard->free_slots.empty()) {
+          result.first->second = shard->free_slots.back();
+          shard->free_slots.pop_back();
+        } else {
+          result.first->second = shard->num_slots++;
+          shard->values.resize(shard->num_slots * value_dim_);
+        }
+      }
+      const int64 slot = result.first->second * value_dim_;
+      for (int64 j = 0; j < value_dim_; ++j) {
+        shard->values[slot + j] =
+            SubtleMustCopyIfIntegral(values(i * value_dim_ + j));
+      }
+    }
+  }
+
+  TensorShape value_shape_;
+  int64 value_dim_;
+  int64 num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
@@ -1076,6 +1368,33 @@ REGISTER_KERNEL(tstring, int64);
 
 #undef REGISTER_KERNEL
 
+// Register the ShardedMutableHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("ShardedMutableHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::ShardedMutableHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(int64, int32);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, tstring);
+REGISTER_KERNEL(int64, Variant);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableDenseHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                            \
   REGISTER_KERNEL_BUILDER(                                                 \
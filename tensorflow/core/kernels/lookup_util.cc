@@ -15,48 +15,184 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/lookup_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
 #include "tensorflow/core/framework/op_requires.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
 namespace {
 
-static const int kInputBufferSize = 1 * 1024 * 1024; /* bytes */
 static const int kLineNumber = -1;
 static const int kWholeLine = -2;
 
-Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
-                             int64* num_lines) {
-  std::unique_ptr<RandomAccessFile> file;
-  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(vocab_file, &file));
-
-  io::InputBuffer input_buffer(file.get(), kInputBufferSize);
-  string line;
-  Status s = input_buffer.ReadLine(&line);
-  int64 next_id = 0;
-  while (s.ok()) {
-    next_id++;
-    s = input_buffer.ReadLine(&line);
+// The text file is read in rounds of about this many bytes, which bounds the
+// memory used to initialize a table from a large file.
+static const int64 kRoundSize = 64 << 20; /* bytes */
+// The bytes of a round are split in shards of at least this many bytes.
+static const int64 kMinShardSize = 1 << 20; /* bytes */
+
+// Returns the number of shards to process `size` bytes in.
+int64 NumShards(size_t size, thread::ThreadPool* thread_pool) {
+  const int64 num_threads =
+      thread_pool == nullptr ? 1 : thread_pool->NumThreads();
+  return std::max<int64>(
+      1, std::min<int64>(num_threads, size / kMinShardSize));
+}
+
+// Calls fn(i) for i in [0, num_shards), in parallel in `thread_pool` if not
+// null.
+void ForEachShard(int64 num_shards, thread::ThreadPool* thread_pool,
+                  const std::function<void(int64)>& fn) {
+  auto work = [&fn](int64 begin, int64 end) {
+    for (int64 i = begin; i < end; ++i) fn(i);
+  };
+  if (thread_pool == nullptr || num_shards == 1) {
+    work(0, num_shards);
+    return;
   }
-  if (!errors::IsOutOfRange(s)) {
-    return s;
+  // The cost makes every shard a unit of work of its own.
+  Shard(thread_pool->NumThreads(), thread_pool, num_shards, kRoundSize, work);
+}
+
+// Reads the next round of lines of `file`, of `file_size` bytes, at
+// `*offset` into `*buf`, and moves `*offset` past them. The round ends after
+// its last complete line, or at the end of the file.
+Status ReadRound(RandomAccessFile* file, uint64 file_size,
+                 thread::ThreadPool* thread_pool, uint64* offset,
+                 string* buf) {
+  size_t size = std::min<uint64>(kRoundSize, file_size - *offset);
+  while (true) {
+    buf->resize(size);
+    const int64 num_reads = NumShards(size, thread_pool);
+    std::vector<Status> statuses(num_reads);
+    ForEachShard(num_reads, thread_pool, [&](int64 i) {
+      const size_t begin = size * i / num_reads;
+      const size_t n = size * (i + 1) / num_reads - begin;
+      char* scratch = &(*buf)[begin];
+      StringPiece result;
+      Status s = file->Read(*offset + begin, n, &result, scratch);
+      if (result.size() == n) {
+        if (result.data() != scratch) memcpy(scratch, result.data(), n);
+        s = Status::OK();
+      } else if (s.ok() || errors::IsOutOfRange(s)) {
+        s = errors::DataLoss("Unexpected end of file at ",
+                             *offset + begin + result.size());
+      }
+      statuses[i] = s;
+    });
+    for (const Status& s : statuses) TF_RETURN_IF_ERROR(s);
+    if (*offset + size == file_size) break;
+    size_t end = size;
+    while (end > 0 && (*buf)[end - 1] != '\n') --end;
+    if (end > 0) {
+      buf->resize(end);
+      break;
+    }
+    // The round is in the middle of a line, read a longer one.
+    size = std::min<uint64>(2 * size, file_size - *offset);
   }
-  *num_lines = next_id;
+  *offset += buf->size();
   return Status::OK();
 }
 
-// Iterator that reads a text file. Each iteration process one line, it parses
-// the line and populates the keys and values tensors used for initialization
-// with a single key and corresponding value.
+// Splits the round `buf` in `num_shards` ranges of whole lines, and returns
+// their `num_shards` + 1 bounds.
+std::vector<size_t> SplitRound(const string& buf, int64 num_shards) {
+  std::vector<size_t> bounds(num_shards + 1, buf.size());
+  bounds[0] = 0;
+  for (int64 i = 1; i < num_shards; ++i) {
+    size_t b = std::max<size_t>(bounds[i - 1], buf.size() * i / num_shards);
+    if (b > 0 && b < buf.size() && buf[b - 1] != '\n') {
+      const char* newline =
+          static_cast<const char*>(memchr(&buf[b], '\n', buf.size() - b));
+      b = newline == nullptr ? buf.size() : newline - buf.data() + 1;
+    }
+    bounds[i] = b;
+  }
+  return bounds;
+}
+
+// Returns the number of lines of `data`, which starts at the beginning of a
+// line. Like InputBuffer::ReadLine(), a last line without a newline only
+// counts if it is not empty once a trailing '\r' is removed.
+int64 CountLines(StringPiece data) {
+  int64 num_lines = std::count(data.begin(), data.end(), '\n');
+  const size_t tail_begin = data.rfind('\n') + 1;  // 0 if there is none.
+  const StringPiece tail = data.substr(tail_begin);
+  if (!tail.empty() && tail != "\r") ++num_lines;
+  return num_lines;
+}
+
+// Returns the line of `data` at `*pos` without its newline and a trailing
+// '\r', and moves `*pos` past it.
+StringPiece NextLine(StringPiece data, size_t* pos) {
+  size_t end = data.find('\n', *pos);
+  if (end == StringPiece::npos) end = data.size();
+  StringPiece line = data.substr(*pos, end - *pos);
+  *pos = std::min(end + 1, data.size());
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return line;
+}
+
+// Sets `*field` to the field `index` of `line`, like
+// str_util::Split(line, delimiter)[index]. Returns false if the line has
+// fewer fields.
+bool GetField(StringPiece line, char delimiter, int64 index,
+              StringPiece* field) {
+  size_t begin = 0;
+  for (int64 i = 0; i < index; ++i) {
+    const size_t d = line.find(delimiter, begin);
+    if (d == StringPiece::npos) return false;
+    begin = d + 1;
+  }
+  const size_t end = line.find(delimiter, begin);
+  *field = line.substr(
+      begin, end == StringPiece::npos ? StringPiece::npos : end - begin);
+  return true;
+}
+
+Status GetNumLinesInTextFile(RandomAccessFile* file, uint64 file_size,
+                             thread::ThreadPool* thread_pool,
+                             int64* num_lines) {
+  *num_lines = 0;
+  uint64 offset = 0;
+  string buf;
+  while (offset < file_size) {
+    TF_RETURN_IF_ERROR(
+        ReadRound(file, file_size, thread_pool, &offset, &buf));
+    const int64 num_shards = NumShards(buf.size(), thread_pool);
+    const std::vector<size_t> bounds = SplitRound(buf, num_shards);
+    std::vector<int64> counts(num_shards);
+    ForEachShard(num_shards, thread_pool, [&](int64 i) {
+      counts[i] = CountLines(
+          StringPiece(buf).substr(bounds[i], bounds[i + 1] - bounds[i]));
+    });
+    for (int64 count : counts) *num_lines += count;
+  }
+  return Status::OK();
+}
+
+// Iterator that reads a text file. It parses each line and populates the keys
+// and values tensors used for initialization with a key and corresponding
+// value per line.
 //
 // What information of the line to populate the key or values is specified by
 // providing key_index and value_index.
+//
+// The file is read in rounds of lines, which are split in shards parsed in
+// parallel in `thread_pool`. Each iteration returns the keys and values of a
+// shard, which the table inserts at once.
 class TextFileLineIterator
     : public InitializableLookupTable::InitTableIterator {
  public:
@@ -77,22 +213,27 @@ class TextFileLineIterator
   //   delimiter.
   Status Init(const string& filename, int64 vocab_size, char delimiter,
               DataType key_dtype, int64 key_index, DataType value_dtype,
-              int64 value_index, Env* env) {
+              int64 value_index, Env* env, thread::ThreadPool* thread_pool) {
     filename_ = filename;
     vocab_size_ = vocab_size;
     delimiter_ = delimiter;
-    key_ = Tensor(key_dtype, TensorShape({}));
-    value_ = Tensor(value_dtype, TensorShape({}));
+    key_dtype_ = key_dtype;
+    value_dtype_ = value_dtype;
     key_index_ = key_index;
     value_index_ = value_index;
-    env_ = env;
+    thread_pool_ = thread_pool;
 
     status_ = env->NewRandomAccessFile(filename_, &file_);
     if (!status_.ok()) return status_;
+    status_ = env->GetFileSize(filename_, &file_size_);
+    if (!status_.ok()) return status_;
 
-    input_buffer_.reset(new io::InputBuffer(file_.get(), kInputBufferSize));
     valid_ = true;
+    offset_ = 0;
     next_id_ = 0;
+    truncated_ = false;
+    shards_.clear();
+    shard_index_ = 0;
     ignore_split_ = std::max(key_index_, value_index_) < 0;
     Next();
     return status_;
@@ -101,151 +242,213 @@ class TextFileLineIterator
   void Next() override {
     if (!valid_) return;
 
-    string line;
-    status_ = input_buffer_->ReadLine(&line);
-    if (!status_.ok()) {
-      if (errors::IsOutOfRange(status_) && vocab_size_ != -1 &&
-          next_id_ != vocab_size_) {
-        status_ = errors::InvalidArgument("Invalid vocab_size in ", filename_,
-                                          ": expected ", vocab_size_,
-                                          " but got ", next_id_);
+    ++shard_index_;
+    while (true) {
+      while (shard_index_ < shards_.size() &&
+             shards_[shard_index_].num_lines == 0) {
+        ++shard_index_;
       }
-      valid_ = false;
-      return;
-    }
-    if (vocab_size_ != -1 && next_id_ >= vocab_size_) {
-      LOG(WARNING) << "Truncated " << filename_ << " before its end at "
-                   << vocab_size_ << " records.";
-      LOG(WARNING) << "next_id_  : " << next_id_;
-      status_ = errors::OutOfRange("Finished reading ", vocab_size_,
-                                   " of lines from ", filename_);
-      valid_ = false;
-      return;
-    }
-    if (line.empty()) {
-      status_ = errors::InvalidArgument("Invalid content in ", filename_,
-                                        ": empty line found at position ",
-                                        input_buffer_->Tell(), ".");
-      valid_ = false;
-      return;
-    }
-
-    std::vector<string> tokens;
-    if (!ignore_split_) {
-      tokens = str_util::Split(line, delimiter_);
-      if (static_cast<size_t>(std::max(key_index_, value_index_)) >=
-          tokens.size()) {
-        status_ = errors::InvalidArgument(
-            "Invalid number of columns in ", filename_, " line ", next_id_,
-            " (", line, ") : expected ", std::max(key_index_, value_index_),
-            " got ", tokens.size());
+      if (shard_index_ < shards_.size()) return;
+      status_ = NextRound();
+      if (!status_.ok()) {
         valid_ = false;
+        shards_.clear();
         return;
       }
     }
-    status_ = SetValue(line, tokens, key_index_, &key_);
-    if (!status_.ok()) {
-      valid_ = false;
-      return;
-    }
-    status_ = SetValue(line, tokens, value_index_, &value_);
-    if (!status_.ok()) {
-      valid_ = false;
-      return;
-    }
-
-    next_id_++;
   }
 
   bool Valid() const override { return valid_; }
 
-  const Tensor& keys() const override { return key_; }
+  const Tensor& keys() const override { return shards_[shard_index_].keys; }
 
-  const Tensor& values() const override { return value_; }
+  const Tensor& values() const override {
+    return shards_[shard_index_].values;
+  }
 
   Status status() const override { return status_; }
 
   int64 total_size() const override {
-    if (vocab_size_ == -1) {
-      int64 new_size = -1;
-      Status status = GetNumLinesInTextFile(env_, filename_, &new_size);
+    if (vocab_size_ != -1) return vocab_size_;
+    if (num_lines_ == -1) {
+      Status status = GetNumLinesInTextFile(file_.get(), file_size_,
+                                            thread_pool_, &num_lines_);
       if (!status.ok()) {
         LOG(WARNING) << "Unable to get line count: " << status;
-        new_size = -1;
+        num_lines_ = -1;
       }
-      *const_cast<int64*>(&vocab_size_) = new_size;
     }
-    return vocab_size_;
+    return num_lines_;
   }
 
  private:
-  Tensor key_;
-  Tensor value_;
+  // The lines of a round in [begin, end), and their keys and values.
+  struct LineShard {
+    size_t begin;
+    size_t end;
+    int64 first_id;
+    int64 num_lines;
+    Tensor keys;
+    Tensor values;
+  };
+
+  DataType key_dtype_;
+  DataType value_dtype_;
   bool valid_;  // true if the iterator points to an existing range.
   int64 key_index_;
   int64 value_index_;
-  Env* env_;
-  int64 next_id_;
+  thread::ThreadPool* thread_pool_;  // Not owned, may be null.
+  uint64 file_size_;
+  uint64 offset_;  // Of the next round in the file.
+  int64 next_id_;  // Of the first line of the next round.
   int64 vocab_size_;
+  mutable int64 num_lines_ = -1;
+  bool truncated_;  // true if lines after vocab_size_ were skipped.
   string filename_;
   char delimiter_;
   Status status_;
   bool ignore_split_;
-  std::unique_ptr<RandomAccessFile> file_;  // must outlive input_buffer_
-  std::unique_ptr<io::InputBuffer> input_buffer_;
+  std::unique_ptr<RandomAccessFile> file_;
+  std::vector<LineShard> shards_;
+  size_t shard_index_;
+
+  // Reads and parses the next round of lines into shards_. Returns
+  // OutOfRange after the last line of the file or of the vocabulary.
+  Status NextRound() {
+    shards_.clear();
+    shard_index_ = 0;
+    if (offset_ >= file_size_ ||
+        (vocab_size_ != -1 && next_id_ >= vocab_size_)) {
+      if (truncated_ || offset_ < file_size_) {
+        LOG(WARNING) << "Truncated " << filename_ << " before its end at "
+                     << vocab_size_ << " records.";
+        return errors::OutOfRange("Finished reading ", vocab_size_,
+                                  " of lines from ", filename_);
+      }
+      if (vocab_size_ != -1 && next_id_ != vocab_size_) {
+        return errors::InvalidArgument("Invalid vocab_size in ", filename_,
+                                       ": expected ", vocab_size_,
+                                       " but got ", next_id_);
+      }
+      return errors::OutOfRange("Finished reading ", filename_);
+    }
+
+    const uint64 round_offset = offset_;
+    string buf;
+    TF_RETURN_IF_ERROR(
+        ReadRound(file_.get(), file_size_, thread_pool_, &offset_, &buf));
+    const int64 num_shards = NumShards(buf.size(), thread_pool_);
+    const std::vector<size_t> bounds = SplitRound(buf, num_shards);
+    shards_.resize(num_shards);
+    ForEachShard(num_shards, thread_pool_, [&](int64 i) {
+      LineShard& shard = shards_[i];
+      shard.begin = bounds[i];
+      shard.end = bounds[i + 1];
+      shard.num_lines = CountLines(
+          StringPiece(buf).substr(shard.begin, shard.end - shard.begin));
+    });
+    for (LineShard& shard : shards_) {
+      shard.first_id = next_id_;
+      if (vocab_size_ != -1 && next_id_ + shard.num_lines > vocab_size_) {
+        shard.num_lines = vocab_size_ - next_id_;
+        truncated_ = true;
+      }
+      next_id_ += shard.num_lines;
+    }
+
+    std::vector<Status> statuses(num_shards);
+    ForEachShard(num_shards, thread_pool_, [&](int64 i) {
+      statuses[i] = ParseShard(buf, round_offset, &shards_[i]);
+    });
+    // The error of the first invalid line of the round.
+    for (const Status& s : statuses) TF_RETURN_IF_ERROR(s);
+    return Status::OK();
+  }
+
+  // Parses the lines of `shard` in the round `buf` at `round_offset` in the
+  // file into its keys and values.
+  Status ParseShard(const string& buf, uint64 round_offset,
+                    LineShard* shard) const {
+    shard->keys = Tensor(key_dtype_, TensorShape({shard->num_lines}));
+    shard->values = Tensor(value_dtype_, TensorShape({shard->num_lines}));
+    const StringPiece data(buf.data(), shard->end);
+    size_t pos = shard->begin;
+    for (int64 i = 0; i < shard->num_lines; ++i) {
+      const int64 line_id = shard->first_id + i;
+      const StringPiece line = NextLine(data, &pos);
+      if (line.empty()) {
+        return errors::InvalidArgument("Invalid content in ", filename_,
+                                       ": empty line found at position ",
+                                       round_offset + pos, ".");
+      }
+      StringPiece key_field;
+      StringPiece value_field;
+      if (!ignore_split_ &&
+          ((key_index_ >= 0 &&
+            !GetField(line, delimiter_, key_index_, &key_field)) ||
+           (value_index_ >= 0 &&
+            !GetField(line, delimiter_, value_index_, &value_field)))) {
+        return errors::InvalidArgument(
+            "Invalid number of columns in ", filename_, " line ", line_id,
+            " (", line, ") : expected ", std::max(key_index_, value_index_),
+            " got ", std::count(line.begin(), line.end(), delimiter_) + 1);
+      }
+      TF_RETURN_IF_ERROR(SetValue(line, key_field, key_index_, line_id, i,
+                                  &shard->keys));
+      TF_RETURN_IF_ERROR(SetValue(line, value_field, value_index_, line_id, i,
+                                  &shard->values));
+    }
+    return Status::OK();
+  }
 
-  // Set the corresponding value from line or tokens based on 'index' into the
-  // tensor 't'. The value is transformed to the given data type 'dtype'.
-  Status SetValue(const string& line, const std::vector<string>& tokens,
-                  int64 index, Tensor* tensor) {
+  // Set the corresponding value from line or field based on 'index' into
+  // element 'i' of the tensor 't'. The value is transformed to the given
+  // data type 'dtype'.
+  Status SetValue(StringPiece line, StringPiece field, int64 index,
+                  int64 line_id, int64 i, Tensor* tensor) const {
     if (index == kLineNumber) {
-      tensor->flat<int64>()(0) = next_id_;
+      tensor->flat<int64>()(i) = line_id;
       return Status::OK();
     }
-    const string& token = (index == kWholeLine) ? line : tokens[index];
+    const StringPiece token = (index == kWholeLine) ? line : field;
     const DataType& dtype = tensor->dtype();
     switch (dtype) {
       case DT_INT32: {
         int32 value;
-        if (!strings::safe_strto32(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+        if (!strings::safe_strto32(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid int32.");
         }
-        tensor->flat<int32>()(0) = value;
+        tensor->flat<int32>()(i) = value;
       } break;
       case DT_INT64: {
         int64 value;
-        if (!strings::safe_strto64(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+        if (!strings::safe_strto64(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid int64.");
         }
-        tensor->flat<int64>()(0) = value;
+        tensor->flat<int64>()(i) = value;
       } break;
       case DT_FLOAT: {
         float value;
-        if (!strings::safe_strtof(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+        if (!strings::safe_strtof(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid float.");
         }
-        tensor->flat<float>()(0) = value;
+        tensor->flat<float>()(i) = value;
       } break;
       case DT_DOUBLE: {
         double value;
-        if (!strings::safe_strtod(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+        if (!strings::safe_strtod(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid double.");
         }
-        tensor->flat<double>()(0) = value;
+        tensor->flat<double>()(i) = value;
       } break;
       case DT_STRING:
-        tensor->flat<tstring>()(0) = token;
+        tensor->flat<tstring>()(i).assign(token.data(), token.size());
         break;
       default:
-        valid_ = false;
         return errors::InvalidArgument("Data type ", DataTypeString(dtype),
                                        " not supported.");
     }
@@ -354,6 +557,16 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    char delimiter, int32 key_index,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table) {
+  return InitializeTableFromTextFile(filename, vocab_size, delimiter,
+                                     key_index, value_index, env,
+                                     /*thread_pool=*/nullptr, table);
+}
+
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table) {
   if (key_index == kLineNumber && table->key_dtype() != DT_INT64) {
     return errors::InvalidArgument(
         "Key index for line number requires table key dtype of int64, got ",
@@ -380,7 +593,8 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
 
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
-                               key_index, value_dtype, value_index, env));
+                               key_index, value_dtype, value_index, env,
+                               thread_pool));
   // For initialization from files, ignore if the table is already
   // initialized. The table shared name should contain the filename to
   // avoid trying to initialize the same table from the same file at the same
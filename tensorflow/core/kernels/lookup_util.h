@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
 namespace data {
@@ -56,6 +57,15 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table);
 
+// Same as above, but reads and parses the file in parallel in `thread_pool`,
+// if not null: the file is read in rounds of lines, which are split in shards
+// of lines parsed concurrently and inserted in the table a shard at a time.
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table);
+
 // Initializes `table` from `dataset` by iterating over it. Caller retains
 // ownership of `dataset`.
 void InitializeTableFromDataset(OpKernelContext* ctx,
@@ -92,7 +92,7 @@ class MatmulParameters {
     // clang-format off
     return strings::StrCat(
         transa_, ", ", transb_, ", ",
-        m_, ", ", n_, ", ", k_,
+        m_, ", ", n_, ", ", k_, ", ",
         dtype_, ", ", device_id_);
     // clang-format on
   }
@@ -0,0 +1,337 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mips_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace {
+
+using RowMajorMatrixXf =
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using ConstRowMajorMatrixMap = Eigen::Map<const RowMajorMatrixXf>;
+
+// Number of items whose distances to the centroids are computed by one matrix
+// product in AssignToCentroids.
+constexpr int64 kAssignmentBlockSize = 256;
+
+// Largest magnitude of an int8 code.
+constexpr float kMaxCode = 127.0f;
+
+// Returns the inner product of a float query with the int8 codes of an item.
+inline float DotWithCodes(const float* query, const int8* codes, int64 dim) {
+  float sum = 0.0f;
+  for (int64 j = 0; j < dim; ++j) {
+    sum += query[j] * static_cast<float>(codes[j]);
+  }
+  return sum;
+}
+
+// Orders search results by decreasing score, and equal scores by increasing
+// position in the index.
+struct ResultGreater {
+  bool operator()(const std::pair<float, int64>& a,
+                  const std::pair<float, int64>& b) const {
+    if (a.first != b.first) return a.first > b.first;
+    return a.second < b.second;
+  }
+};
+
+}  // namespace
+
+string MipsIndex::DebugString() const {
+  tf_shared_lock l(mu_);
+  return strings::StrCat("MipsIndex[size=", ids_.size(), ", dim=", dim_,
+                         ", num_lists=", centroids_.size() / std::max<int64>(
+                                                                 dim_, 1),
+                         "]");
+}
+
+int64 MipsIndex::MemoryUsed() const {
+  tf_shared_lock l(mu_);
+  return sizeof(MipsIndex) + centroids_.size() * sizeof(float) +
+         list_offsets_.size() * sizeof(int64) + codes_.size() * sizeof(int8) +
+         scales_.size() * sizeof(float) + ids_.size() * sizeof(int64);
+}
+
+int64 MipsIndex::size() const {
+  tf_shared_lock l(mu_);
+  return ids_.size();
+}
+
+int64 MipsIndex::dim() const {
+  tf_shared_lock l(mu_);
+  return dim_;
+}
+
+int64 MipsIndex::num_lists() const {
+  tf_shared_lock l(mu_);
+  return list_offsets_.empty() ? 0 : list_offsets_.size() - 1;
+}
+
+void MipsIndex::AssignToCentroids(const float* items, int64 num_items,
+                                  int64 dim,
+                                  const std::vector<float>& centroids,
+                                  thread::ThreadPool* thread_pool,
+                                  std::vector<int64>* assignments) {
+  const int64 num_centroids = centroids.size() / dim;
+  ConstRowMajorMatrixMap centroids_matrix(centroids.data(), num_centroids,
+                                          dim);
+  const Eigen::VectorXf centroid_norms =
+      centroids_matrix.rowwise().squaredNorm();
+  assignments->resize(num_items);
+
+  // The nearest centroid of x minimizes |c|^2 - 2 x.c, computed for blocks of
+  // items by a matrix product.
+  auto assign = [&](int64 start, int64 limit) {
+    RowMajorMatrixXf scores;
+    for (int64 begin = start; begin < limit; begin += kAssignmentBlockSize) {
+      const int64 end = std::min(begin + kAssignmentBlockSize, limit);
+      ConstRowMajorMatrixMap block(items + begin * dim, end - begin, dim);
+      scores.noalias() = block * centroids_matrix.transpose();
+      for (int64 i = 0; i < end - begin; ++i) {
+        int64 nearest;
+        (centroid_norms.transpose() - 2.0f * scores.row(i)).minCoeff(&nearest);
+        (*assignments)[begin + i] = nearest;
+      }
+    }
+  };
+  const int64 cost_per_item = 2 * num_centroids * dim;
+  thread_pool->ParallelFor(num_items, cost_per_item, assign);
+}
+
+void MipsIndex::TrainCentroids(const BuildOptions& options,
+                               TTypes<float>::ConstMatrix items,
+                               thread::ThreadPool* thread_pool,
+                               std::vector<float>* centroids) {
+  const int64 num_items = items.dimension(0);
+  const int64 dim = items.dimension(1);
+  const int64 num_lists = options.num_lists;
+  random::PhiloxRandom random(options.seed);
+  random::SimplePhilox rng(&random);
+
+  // Sample the training items, with replacement when there are more items
+  // than needed.
+  const int64 num_samples =
+      std::min(num_items, num_lists * options.max_training_items_per_list);
+  std::vector<float> samples(num_samples * dim);
+  for (int64 i = 0; i < num_samples; ++i) {
+    const int64 item =
+        num_samples == num_items ? i : rng.Uniform64(num_items);
+    std::copy_n(&items(item, 0), dim, samples.begin() + i * dim);
+  }
+
+  // Initialize the centroids with distinct random samples.
+  std::vector<int64> order(num_samples);
+  std::iota(order.begin(), order.end(), 0);
+  for (int64 i = 0; i < num_lists; ++i) {
+    std::swap(order[i], order[i + rng.Uniform64(num_samples - i)]);
+  }
+  centroids->resize(num_lists * dim);
+  for (int64 l = 0; l < num_lists; ++l) {
+    std::copy_n(samples.begin() + order[l] * dim, dim,
+                centroids->begin() + l * dim);
+  }
+
+  // Lloyd iterations. Empty lists are reseeded with a random sample.
+  std::vector<int64> assignments;
+  std::vector<int64> counts(num_lists);
+  for (int iteration = 0; iteration < options.num_iterations; ++iteration) {
+    AssignToCentroids(samples.data(), num_samples, dim, *centroids,
+                      thread_pool, &assignments);
+    std::fill(centroids->begin(), centroids->end(), 0.0f);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int64 i = 0; i < num_samples; ++i) {
+      const int64 l = assignments[i];
+      ++counts[l];
+      float* centroid = centroids->data() + l * dim;
+      const float* sample = samples.data() + i * dim;
+      for (int64 j = 0; j < dim; ++j) centroid[j] += sample[j];
+    }
+    for (int64 l = 0; l < num_lists; ++l) {
+      float* centroid = centroids->data() + l * dim;
+      if (counts[l] == 0) {
+        std::copy_n(samples.begin() + rng.Uniform64(num_samples) * dim, dim,
+                    centroid);
+        continue;
+      }
+      const float inverse_count = 1.0f / counts[l];
+      for (int64 j = 0; j < dim; ++j) centroid[j] *= inverse_count;
+    }
+  }
+}
+
+Status MipsIndex::Build(const BuildOptions& options,
+                        TTypes<float>::ConstMatrix items,
+                        TTypes<int64>::ConstVec ids,
+                        thread::ThreadPool* thread_pool) {
+  const int64 num_items = items.dimension(0);
+  const int64 dim = items.dimension(1);
+  if (ids.size() != num_items) {
+    return errors::InvalidArgument("Expected ", num_items, " ids, got ",
+                                   ids.size());
+  }
+  if (dim <= 0) {
+    return errors::InvalidArgument("Items must have at least one dimension");
+  }
+  if (options.num_lists < 1 || options.num_lists > num_items) {
+    return errors::InvalidArgument("num_lists must be in [1, ", num_items,
+                                   "], got ", options.num_lists);
+  }
+  if (options.num_iterations < 0) {
+    return errors::InvalidArgument("num_iterations must be >= 0, got ",
+                                   options.num_iterations);
+  }
+
+  std::vector<float> centroids;
+  TrainCentroids(options, items, thread_pool, &centroids);
+  std::vector<int64> assignments;
+  AssignToCentroids(items.data(), num_items, dim, centroids, thread_pool,
+                    &assignments);
+
+  // Group the items by list with a counting sort.
+  const int64 num_lists = options.num_lists;
+  std::vector<int64> list_offsets(num_lists + 1, 0);
+  for (int64 i = 0; i < num_items; ++i) ++list_offsets[assignments[i] + 1];
+  std::partial_sum(list_offsets.begin(), list_offsets.end(),
+                   list_offsets.begin());
+  std::vector<int64> positions(num_items);
+  {
+    std::vector<int64> next(list_offsets.begin(), list_offsets.end() - 1);
+    for (int64 i = 0; i < num_items; ++i) {
+      positions[i] = next[assignments[i]]++;
+    }
+  }
+
+  // Quantize each item to int8 codes with a scale of its largest magnitude.
+  std::vector<int8> codes(num_items * dim);
+  std::vector<float> scales(num_items);
+  std::vector<int64> item_ids(num_items);
+  auto quantize = [&](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const float* item = &items(i, 0);
+      const int64 position = positions[i];
+      float max_abs = 0.0f;
+      for (int64 j = 0; j < dim; ++j) {
+        max_abs = std::max(max_abs, std::abs(item[j]));
+      }
+      const float scale = max_abs / kMaxCode;
+      const float inverse_scale = max_abs > 0.0f ? kMaxCode / max_abs : 0.0f;
+      int8* item_codes = codes.data() + position * dim;
+      for (int64 j = 0; j < dim; ++j) {
+        item_codes[j] = static_cast<int8>(std::max(
+            -kMaxCode, std::min(kMaxCode, std::round(item[j] * inverse_scale))));
+      }
+      scales[position] = scale;
+      item_ids[position] = ids(i);
+    }
+  };
+  thread_pool->ParallelFor(num_items, 4 * dim, quantize);
+
+  mutex_lock l(mu_);
+  dim_ = dim;
+  centroids_.swap(centroids);
+  list_offsets_.swap(list_offsets);
+  codes_.swap(codes);
+  scales_.swap(scales);
+  ids_.swap(item_ids);
+  return Status::OK();
+}
+
+Status MipsIndex::Search(TTypes<float>::ConstMatrix queries,
+                         int64 num_probes, thread::ThreadPool* thread_pool,
+                         TTypes<float>::Matrix scores,
+                         TTypes<int64>::Matrix ids) const {
+  tf_shared_lock l(mu_);
+  const int64 num_queries = queries.dimension(0);
+  const int64 k = scores.dimension(1);
+  if (num_queries > 0 && queries.dimension(1) != dim_) {
+    return errors::InvalidArgument("Expected queries of dimension ", dim_,
+                                   ", got ", queries.dimension(1));
+  }
+  if (num_probes < 1) {
+    return errors::InvalidArgument("num_probes must be >= 1, got ",
+                                   num_probes);
+  }
+  const int64 num_lists =
+      list_offsets_.empty() ? 0 : list_offsets_.size() - 1;
+  num_probes = std::min(num_probes, num_lists);
+  const int64 num_items = ids_.size();
+  const int64 dim = dim_;
+
+  auto search = [&](int64 start, int64 limit) {
+    Eigen::VectorXf list_scores;
+    std::vector<int64> lists(num_lists);
+    std::vector<float> item_scores;
+    for (int64 q = start; q < limit; ++q) {
+      const float* query = &queries(q, 0);
+      gtl::TopN<std::pair<float, int64>, ResultGreater> top(k);
+      if (num_lists > 0) {
+        // Probe the lists whose centroids have the highest inner products.
+        list_scores.noalias() =
+            ConstRowMajorMatrixMap(centroids_.data(), num_lists, dim) *
+            Eigen::Map<const Eigen::VectorXf>(query, dim);
+        std::iota(lists.begin(), lists.end(), 0);
+        std::partial_sort(lists.begin(), lists.begin() + num_probes,
+                          lists.end(), [&list_scores](int64 a, int64 b) {
+                            return list_scores(a) > list_scores(b);
+                          });
+      }
+      for (int64 p = 0; p < num_probes; ++p) {
+        const int64 begin = list_offsets_[lists[p]];
+        const int64 end = list_offsets_[lists[p] + 1];
+        item_scores.resize(end - begin);
+        for (int64 i = begin; i < end; ++i) {
+          item_scores[i - begin] =
+              scales_[i] * DotWithCodes(query, codes_.data() + i * dim, dim);
+        }
+        for (int64 i = begin; i < end; ++i) {
+          top.push({item_scores[i - begin], i});
+        }
+      }
+      std::unique_ptr<std::vector<std::pair<float, int64>>> results(
+          top.Extract());
+      for (int64 r = 0; r < k; ++r) {
+        if (r < static_cast<int64>(results->size())) {
+          scores(q, r) = (*results)[r].first;
+          ids(q, r) = ids_[(*results)[r].second];
+        } else {
+          scores(q, r) = -std::numeric_limits<float>::infinity();
+          ids(q, r) = -1;
+        }
+      }
+    }
+  };
+  const int64 average_probed_items =
+      num_lists > 0 ? num_probes * num_items / num_lists : 0;
+  const int64 cost_per_query = 2 * dim * (num_lists + average_probed_items);
+  thread_pool->ParallelFor(num_queries, cost_per_query, search);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
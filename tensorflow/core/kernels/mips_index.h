@@ -0,0 +1,111 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MIPS_INDEX_H_
+#define TENSORFLOW_CORE_KERNELS_MIPS_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An inverted file (IVF) index for approximate maximum inner product search
+// over a resident set of items.
+//
+// Build() partitions the items into `num_lists` lists by k-means, trained on a
+// sample of the items, and stores each item as int8 codes with a float scale,
+// which takes a quarter of the memory of the float items.  Search() scores the
+// centroids of the lists against each query, then scores the items of the
+// `num_probes` lists with the highest inner product and returns the top k of
+// them.  With num_probes == num_lists the search is exhaustive and its only
+// error is the quantization error of the items.
+//
+// Searches hold a shared lock and may run concurrently; Build() replaces the
+// whole index under an exclusive lock.
+class MipsIndex : public ResourceBase {
+ public:
+  struct BuildOptions {
+    int64 num_lists = 1;
+    // Number of Lloyd iterations of the k-means training.
+    int num_iterations = 10;
+    // Maximum number of items per list sampled to train the k-means.
+    int64 max_training_items_per_list = 256;
+    uint64 seed = 0;
+  };
+
+  MipsIndex() = default;
+
+  string DebugString() const override;
+  int64 MemoryUsed() const override;
+
+  // Replaces the index with `items`, a [n, dim] float matrix, whose rows are
+  // returned by Search() as the corresponding element of `ids`.
+  Status Build(const BuildOptions& options,
+               TTypes<float>::ConstMatrix items,
+               TTypes<int64>::ConstVec ids,
+               thread::ThreadPool* thread_pool) TF_LOCKS_EXCLUDED(mu_);
+
+  // Writes to row i of `scores` and `ids`, both [num_queries, k], the inner
+  // products and ids of the top k items found for row i of `queries`, in
+  // decreasing order of inner product.  Rows with fewer than k items found are
+  // padded with a score of -infinity and an id of -1.
+  Status Search(TTypes<float>::ConstMatrix queries, int64 num_probes,
+                thread::ThreadPool* thread_pool,
+                TTypes<float>::Matrix scores,
+                TTypes<int64>::Matrix ids) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int64 size() const TF_LOCKS_EXCLUDED(mu_);
+  int64 dim() const TF_LOCKS_EXCLUDED(mu_);
+  int64 num_lists() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Trains num_lists centroids on a sample of `items`.
+  static void TrainCentroids(const BuildOptions& options,
+                             TTypes<float>::ConstMatrix items,
+                             thread::ThreadPool* thread_pool,
+                             std::vector<float>* centroids);
+
+  // Writes to `assignments` the nearest of `centroids`, by L2 distance, to
+  // each row of the row major [num_items, dim] matrix `items`.
+  static void AssignToCentroids(const float* items, int64 num_items,
+                                int64 dim, const std::vector<float>& centroids,
+                                thread::ThreadPool* thread_pool,
+                                std::vector<int64>* assignments);
+
+  mutable mutex mu_;
+  int64 dim_ TF_GUARDED_BY(mu_) = 0;
+  // [num_lists, dim] centroids of the lists.
+  std::vector<float> centroids_ TF_GUARDED_BY(mu_);
+  // The items of list l are the items [list_offsets_[l], list_offsets_[l + 1]).
+  std::vector<int64> list_offsets_ TF_GUARDED_BY(mu_);
+  // [size, dim] int8 codes, scale and id of the items, grouped by list.  Item
+  // i is approximated by scales_[i] * codes_[i * dim_ .. (i + 1) * dim_).
+  std::vector<int8> codes_ TF_GUARDED_BY(mu_);
+  std::vector<float> scales_ TF_GUARDED_BY(mu_);
+  std::vector<int64> ids_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MIPS_INDEX_H_
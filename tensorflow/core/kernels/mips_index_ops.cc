@@ -0,0 +1,138 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/clustering_ops.cc.
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/mips_index.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
+
+namespace tensorflow {
+
+// Builds the index from a matrix of items, creating it if needed.
+class MipsIndexBuildOp : public OpKernel {
+ public:
+  explicit MipsIndexBuildOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_lists", &options_.num_lists));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_iterations", &options_.num_iterations));
+    int64 seed;
+    OP_REQUIRES_OK(context, context->GetAttr("seed", &seed));
+    options_.seed = seed;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& items = context->input(1);
+    const Tensor& ids = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(items.shape()),
+                errors::InvalidArgument("items must be a matrix, got shape ",
+                                        items.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids must be a vector, got shape ",
+                                        ids.shape().DebugString()));
+
+    core::RefCountPtr<MipsIndex> index;
+    OP_REQUIRES_OK(context,
+                   LookupOrCreateResource<MipsIndex>(
+                       context, HandleFromInput(context, 0), &index,
+                       [](MipsIndex** index) {
+                         *index = new MipsIndex();
+                         return Status::OK();
+                       }));
+    OP_REQUIRES_OK(
+        context,
+        index->Build(options_, items.matrix<float>(), ids.vec<int64>(),
+                     context->device()->tensorflow_cpu_worker_threads()->workers));
+  }
+
+ private:
+  MipsIndex::BuildOptions options_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("MipsIndexBuild").Device(DEVICE_CPU),
+                        MipsIndexBuildOp);
+
+// Returns the top k items of the index for each query.
+class MipsIndexSearchOp : public OpKernel {
+ public:
+  explicit MipsIndexSearchOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_probes", &num_probes_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& queries = context->input(1);
+    const Tensor& k_tensor = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(queries.shape()),
+                errors::InvalidArgument("queries must be a matrix, got shape ",
+                                        queries.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(k_tensor.shape()),
+                errors::InvalidArgument("k must be a scalar, got shape ",
+                                        k_tensor.shape().DebugString()));
+    const int32 k = k_tensor.scalar<int32>()();
+    OP_REQUIRES(context, k >= 0,
+                errors::InvalidArgument("Need k >= 0, got ", k));
+
+    core::RefCountPtr<MipsIndex> index;
+    OP_REQUIRES_OK(context,
+                   LookupResource(context, HandleFromInput(context, 0), &index));
+
+    const TensorShape output_shape({queries.dim_size(0), k});
+    Tensor* scores = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &scores));
+    Tensor* ids = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, output_shape, &ids));
+    OP_REQUIRES_OK(
+        context,
+        index->Search(
+            queries.matrix<float>(), num_probes_,
+            context->device()->tensorflow_cpu_worker_threads()->workers,
+            scores->matrix<float>(), ids->matrix<int64>()));
+  }
+
+ private:
+  int64 num_probes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("MipsIndexSearch").Device(DEVICE_CPU),
+                        MipsIndexSearchOp);
+
+class MipsIndexSizeOp : public OpKernel {
+ public:
+  explicit MipsIndexSizeOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    core::RefCountPtr<MipsIndex> index;
+    OP_REQUIRES_OK(context,
+                   LookupResource(context, HandleFromInput(context, 0), &index));
+    Tensor* size = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, TensorShape(), &size));
+    size->scalar<int64>()() = index->size();
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("MipsIndexSize").Device(DEVICE_CPU),
+                        MipsIndexSizeOp);
+
+REGISTER_RESOURCE_HANDLE_KERNEL(MipsIndex);
+
+}  // namespace tensorflow
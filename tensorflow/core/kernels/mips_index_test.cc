@@ -0,0 +1,218 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mips_index.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor RandomMatrix(int64 rows, int64 cols, uint64 seed) {
+  random::PhiloxRandom philox(seed);
+  random::SimplePhilox rng(&philox);
+  Tensor matrix(DT_FLOAT, TensorShape({rows, cols}));
+  auto values = matrix.flat<float>();
+  for (int64 i = 0; i < values.size(); ++i) {
+    values(i) = rng.RandFloat() * 2.0f - 1.0f;
+  }
+  return matrix;
+}
+
+Tensor Ids(int64 n) {
+  Tensor ids(DT_INT64, TensorShape({n}));
+  auto values = ids.vec<int64>();
+  for (int64 i = 0; i < n; ++i) values(i) = 1000 + i;
+  return ids;
+}
+
+class MipsIndexTest : public ::testing::Test {
+ protected:
+  MipsIndexTest() : thread_pool_(Env::Default(), "mips_index_test", 4) {}
+
+  core::RefCountPtr<MipsIndex> NewIndex() {
+    return core::RefCountPtr<MipsIndex>(new MipsIndex());
+  }
+
+  thread::ThreadPool thread_pool_;
+};
+
+TEST_F(MipsIndexTest, ExhaustiveSearchMatchesBruteForce) {
+  const int64 num_items = 500;
+  const int64 dim = 16;
+  const int64 num_queries = 20;
+  const int64 k = 5;
+  const Tensor items = RandomMatrix(num_items, dim, 1);
+  const Tensor ids = Ids(num_items);
+  const Tensor queries = RandomMatrix(num_queries, dim, 2);
+
+  auto index = NewIndex();
+  MipsIndex::BuildOptions options;
+  options.num_lists = 8;
+  TF_ASSERT_OK(index->Build(options, items.matrix<float>(),
+                            ids.vec<int64>(), &thread_pool_));
+  EXPECT_EQ(num_items, index->size());
+  EXPECT_EQ(dim, index->dim());
+  EXPECT_EQ(8, index->num_lists());
+
+  Tensor scores(DT_FLOAT, TensorShape({num_queries, k}));
+  Tensor result_ids(DT_INT64, TensorShape({num_queries, k}));
+  TF_ASSERT_OK(index->Search(queries.matrix<float>(), options.num_lists,
+                             &thread_pool_, scores.matrix<float>(),
+                             result_ids.matrix<int64>()));
+
+  auto item_matrix = items.matrix<float>();
+  auto query_matrix = queries.matrix<float>();
+  for (int64 q = 0; q < num_queries; ++q) {
+    std::vector<float> exact(num_items);
+    for (int64 i = 0; i < num_items; ++i) {
+      for (int64 j = 0; j < dim; ++j) {
+        exact[i] += query_matrix(q, j) * item_matrix(i, j);
+      }
+    }
+    std::vector<float> sorted = exact;
+    std::sort(sorted.begin(), sorted.end(), std::greater<float>());
+    for (int64 r = 0; r < k; ++r) {
+      // The scores are computed from int8 codes, so only approximately equal
+      // the exact inner products.
+      EXPECT_NEAR(sorted[r], scores.matrix<float>()(q, r), 0.1);
+      const int64 id = result_ids.matrix<int64>()(q, r);
+      ASSERT_GE(id, 1000);
+      ASSERT_LT(id, 1000 + num_items);
+      EXPECT_NEAR(exact[id - 1000], scores.matrix<float>()(q, r), 0.1);
+      if (r > 0) {
+        EXPECT_GE(scores.matrix<float>()(q, r - 1),
+                  scores.matrix<float>()(q, r));
+      }
+    }
+  }
+}
+
+TEST_F(MipsIndexTest, PadsMissingResults) {
+  const Tensor items = RandomMatrix(3, 4, 3);
+  const Tensor ids = Ids(3);
+  const Tensor queries = RandomMatrix(2, 4, 4);
+
+  auto index = NewIndex();
+  MipsIndex::BuildOptions options;
+  TF_ASSERT_OK(index->Build(options, items.matrix<float>(),
+                            ids.vec<int64>(), &thread_pool_));
+
+  Tensor scores(DT_FLOAT, TensorShape({2, 5}));
+  Tensor result_ids(DT_INT64, TensorShape({2, 5}));
+  TF_ASSERT_OK(index->Search(queries.matrix<float>(), 1, &thread_pool_,
+                             scores.matrix<float>(),
+                             result_ids.matrix<int64>()));
+  for (int64 q = 0; q < 2; ++q) {
+    for (int64 r = 0; r < 3; ++r) {
+      EXPECT_NE(-1, result_ids.matrix<int64>()(q, r));
+    }
+    for (int64 r = 3; r < 5; ++r) {
+      EXPECT_EQ(-std::numeric_limits<float>::infinity(),
+                scores.matrix<float>()(q, r));
+      EXPECT_EQ(-1, result_ids.matrix<int64>()(q, r));
+    }
+  }
+}
+
+TEST_F(MipsIndexTest, SearchEmptyIndex) {
+  const Tensor queries = RandomMatrix(2, 4, 5);
+  auto index = NewIndex();
+  Tensor scores(DT_FLOAT, TensorShape({2, 1}));
+  Tensor result_ids(DT_INT64, TensorShape({2, 1}));
+  EXPECT_FALSE(index->Search(queries.matrix<float>(), 1, &thread_pool_,
+                             scores.matrix<float>(),
+                             result_ids.matrix<int64>())
+                   .ok());
+}
+
+TEST_F(MipsIndexTest, InvalidArguments) {
+  const Tensor items = RandomMatrix(10, 4, 6);
+  auto index = NewIndex();
+  MipsIndex::BuildOptions options;
+
+  // Mismatched number of ids.
+  const Tensor few_ids = Ids(9);
+  EXPECT_FALSE(index->Build(options, items.matrix<float>(),
+                            few_ids.vec<int64>(), &thread_pool_)
+                   .ok());
+
+  // More lists than items.
+  const Tensor ids = Ids(10);
+  options.num_lists = 11;
+  EXPECT_FALSE(index->Build(options, items.matrix<float>(), ids.vec<int64>(),
+                            &thread_pool_)
+                   .ok());
+
+  options.num_lists = 2;
+  TF_ASSERT_OK(index->Build(options, items.matrix<float>(), ids.vec<int64>(),
+                            &thread_pool_));
+
+  // Queries of the wrong dimension.
+  const Tensor queries = RandomMatrix(2, 5, 7);
+  Tensor scores(DT_FLOAT, TensorShape({2, 1}));
+  Tensor result_ids(DT_INT64, TensorShape({2, 1}));
+  EXPECT_FALSE(index->Search(queries.matrix<float>(), 1, &thread_pool_,
+                             scores.matrix<float>(),
+                             result_ids.matrix<int64>())
+                   .ok());
+}
+
+static void BM_MipsIndexSearch(int iters, int num_items, int num_lists) {
+  testing::StopTiming();
+  const int64 dim = 64;
+  const int64 num_queries = 128;
+  const int64 k = 10;
+  thread::ThreadPool thread_pool(Env::Default(), "mips_index_bench", 8);
+  const Tensor items = RandomMatrix(num_items, dim, 8);
+  const Tensor ids = Ids(num_items);
+  const Tensor queries = RandomMatrix(num_queries, dim, 9);
+  core::RefCountPtr<MipsIndex> index(new MipsIndex());
+  MipsIndex::BuildOptions options;
+  options.num_lists = num_lists;
+  TF_CHECK_OK(index->Build(options, items.matrix<float>(), ids.vec<int64>(),
+                           &thread_pool));
+  Tensor scores(DT_FLOAT, TensorShape({num_queries, k}));
+  Tensor result_ids(DT_INT64, TensorShape({num_queries, k}));
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_queries);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(index->Search(queries.matrix<float>(), 8, &thread_pool,
+                              scores.matrix<float>(),
+                              result_ids.matrix<int64>()));
+  }
+}
+
+BENCHMARK(BM_MipsIndexSearch)
+    ->ArgPair(100000, 64)
+    ->ArgPair(100000, 256)
+    ->ArgPair(1000000, 1024);
+
+}  // namespace
+}  // namespace tensorflow
@@ -1455,6 +1455,17 @@ BM_TopKCPU(128, 1000, 100, 16, "topk_r_128_c_1000_k_100_th_16");
 BM_TopKCPU(128, 1000, 500, 16, "topk_r_128_c_1000_k_500_th_16");
 BM_TopKCPU(128, 1000, 1000, 16, "topk_r_128_c_1000_k_1000_th_16");
 
+// Few rows with many columns, as in retrieval scoring. With one thread the
+// rows are sorted one per thread; otherwise they are split into blocks.
+BM_TopKCPU(1, 1000000, 10, 1, "topk_r_1_c_1000000_k_10_th_1");
+BM_TopKCPU(1, 1000000, 10, 16, "topk_r_1_c_1000000_k_10_th_16");
+BM_TopKCPU(1, 1000000, 1000, 1, "topk_r_1_c_1000000_k_1000_th_1");
+BM_TopKCPU(1, 1000000, 1000, 16, "topk_r_1_c_1000000_k_1000_th_16");
+BM_TopKCPU(1, 10000000, 100, 1, "topk_r_1_c_10000000_k_100_th_1");
+BM_TopKCPU(1, 10000000, 100, 16, "topk_r_1_c_10000000_k_100_th_16");
+BM_TopKCPU(4, 1000000, 100, 1, "topk_r_4_c_1000000_k_100_th_1");
+BM_TopKCPU(4, 1000000, 100, 16, "topk_r_4_c_1000000_k_100_th_16");
+
 // From NMT Codebase:
 //   batch_sizes: 16, 128
 //   vocab_sizes: 10000 for small dataset, 35000 for large.
@@ -0,0 +1,421 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/op_benchmark_suite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/reporter.h"
+
+namespace tensorflow {
+namespace test {
+namespace {
+
+using Attrs = std::vector<std::pair<string, AttrValue>>;
+
+template <typename T>
+std::pair<string, AttrValue> A(const string& name, const T& value) {
+  AttrValue attr;
+  SetAttrValue(value, &attr);
+  return {name, attr};
+}
+
+std::pair<string, AttrValue> A(const string& name,
+                               const std::vector<int32>& value) {
+  AttrValue attr;
+  SetAttrValue(gtl::ArraySlice<int32>(value), &attr);
+  return {name, attr};
+}
+
+Node* Op(Graph* g, const string& op, const std::vector<Node*>& inputs,
+         const Attrs& attrs = {}) {
+  NodeBuilder builder(g->NewName("n"), op);
+  for (Node* input : inputs) builder.Input(input);
+  for (const auto& attr : attrs) builder.Attr(attr.first, attr.second);
+  Node* ret;
+  TF_CHECK_OK(builder.Finalize(g, &ret));
+  return ret;
+}
+
+// Uniform in [0.5, 1.5), so that Log, Sqrt, Pow... stay finite.
+Node* Floats(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  t.flat<float>() = t.flat<float>() + 0.5f;
+  return graph::Constant(g, t);
+}
+
+Node* Bools(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_BOOL, shape);
+  auto flat = t.flat<bool>();
+  for (int64 i = 0; i < flat.size(); ++i) flat(i) = (i * 7) % 3 == 0;
+  return graph::Constant(g, t);
+}
+
+// Pseudo-random in [0, limit).
+Node* Indices(Graph* g, int64 size, int32 limit) {
+  Tensor t(DT_INT32, TensorShape({size}));
+  auto flat = t.flat<int32>();
+  for (int64 i = 0; i < size; ++i) flat(i) = (i * 7919) % limit;
+  return graph::Constant(g, t);
+}
+
+Node* Int32s(Graph* g, const std::vector<int32>& values) {
+  return graph::Constant(g, AsTensor<int32>(values));
+}
+
+Node* Int32(Graph* g, int32 value) {
+  return graph::Constant(g, Tensor(value));
+}
+
+std::vector<OpBenchmark>* BuildOpBenchmarkSuite() {
+  auto* suite = new std::vector<OpBenchmark>;
+  auto add = [suite](const string& name, int64 items,
+                     std::function<void(Graph*)> body) {
+    suite->push_back({name,
+                      [body]() {
+                        Graph* g = new Graph(OpRegistry::Global());
+                        body(g);
+                        return g;
+                      },
+                      items});
+  };
+
+  const TensorShape kMatrix({1024, 1024});
+  const int64 kElements = kMatrix.num_elements();
+  const TensorShape kRow({1024});
+  const TensorShape kImages({32, 56, 56, 64});
+  const int64 kImageElements = kImages.num_elements();
+
+  // Elementwise math and activations.
+  for (const char* op :
+       {"Abs",       "Neg",      "Exp",        "Log",       "Log1p",
+        "Expm1",     "Sqrt",     "Rsqrt",      "Square",    "Reciprocal",
+        "Sign",      "Floor",    "Ceil",       "Round",     "Rint",
+        "Sin",       "Cos",      "Tanh",       "Sigmoid",   "Erf",
+        "Relu",      "Relu6",    "Elu",        "Selu",      "Softplus",
+        "Softsign",  "LeakyRelu", "IsFinite",  "ZerosLike", "OnesLike",
+        "Identity",  "Softmax",  "LogSoftmax", "L2Loss"}) {
+    add(strings::StrCat(op, "/1024x1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Floats(g, kMatrix)});
+    });
+  }
+  for (const char* op :
+       {"AddV2", "Sub", "Mul", "RealDiv", "DivNoNan", "Maximum", "Minimum",
+        "Pow", "SquaredDifference", "FloorDiv", "FloorMod", "Less",
+        "LessEqual", "Greater", "GreaterEqual", "Equal", "NotEqual",
+        "ReluGrad", "Relu6Grad", "SigmoidGrad", "TanhGrad"}) {
+    add(strings::StrCat(op, "/1024x1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Floats(g, kMatrix), Floats(g, kMatrix)});
+    });
+  }
+  // Broadcasts of a row, e.g. biases and per-channel scales.
+  for (const char* op : {"AddV2", "Mul", "BiasAdd"}) {
+    add(strings::StrCat(op, "/1024x1024_1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Floats(g, kMatrix), Floats(g, kRow)});
+    });
+  }
+  add("BiasAddGrad/1024x1024", kElements,
+      [=](Graph* g) { Op(g, "BiasAddGrad", {Floats(g, kMatrix)}); });
+  add("AddN/4x1024x1024", 4 * kElements, [=](Graph* g) {
+    Op(g, "AddN",
+       {Floats(g, kMatrix), Floats(g, kMatrix), Floats(g, kMatrix),
+        Floats(g, kMatrix)});
+  });
+  for (const char* op : {"LogicalAnd", "LogicalOr"}) {
+    add(strings::StrCat(op, "/1024x1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Bools(g, kMatrix), Bools(g, kMatrix)});
+    });
+  }
+  add("LogicalNot/1024x1024", kElements,
+      [=](Graph* g) { Op(g, "LogicalNot", {Bools(g, kMatrix)}); });
+  for (const char* op : {"Select", "SelectV2"}) {
+    add(strings::StrCat(op, "/1024x1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Bools(g, kMatrix), Floats(g, kMatrix), Floats(g, kMatrix)});
+    });
+  }
+
+  // Reductions.
+  for (const char* op : {"Sum", "Mean", "Max", "Min", "Prod"}) {
+    for (int axis : {0, 1}) {
+      add(strings::StrCat(op, "/1024x1024_axis", axis), kElements,
+          [=](Graph* g) {
+            graph::Reduce(g, op, Floats(g, kMatrix), Int32(g, axis),
+                          /*keep_dims=*/false);
+          });
+    }
+  }
+  for (const char* op : {"ArgMax", "ArgMin"}) {
+    add(strings::StrCat(op, "/1024x1024_axis1"), kElements, [=](Graph* g) {
+      Op(g, op, {Floats(g, kMatrix), Int32(g, 1)});
+    });
+  }
+  for (const char* op : {"All", "Any"}) {
+    add(strings::StrCat(op, "/1024x1024_axis1"), kElements, [=](Graph* g) {
+      graph::Reduce(g, op, Bools(g, kMatrix), Int32(g, 1),
+                    /*keep_dims=*/false);
+    });
+  }
+  add("Cumsum/1024x1024_axis1", kElements, [=](Graph* g) {
+    graph::Cumsum(g, Floats(g, kMatrix), Int32(g, 1));
+  });
+  add("TopKV2/1024x1024_k10", kElements, [=](Graph* g) {
+    Op(g, "TopKV2", {Floats(g, kMatrix), Int32(g, 10)});
+  });
+
+  // Matmuls, counted in multiply-adds.
+  add("MatMul/512x512x512", 512 * 512 * 512, [](Graph* g) {
+    graph::Matmul(g, Floats(g, TensorShape({512, 512})),
+                  Floats(g, TensorShape({512, 512})), false, false);
+  });
+  add("MatMul/128x1024x1024", 128 * 1024 * 1024, [](Graph* g) {
+    graph::Matmul(g, Floats(g, TensorShape({128, 1024})),
+                  Floats(g, TensorShape({1024, 1024})), false, false);
+  });
+  add("MatMul/512x512x512_transpose_b", 512 * 512 * 512, [](Graph* g) {
+    graph::Matmul(g, Floats(g, TensorShape({512, 512})),
+                  Floats(g, TensorShape({512, 512})), false, true);
+  });
+  add("BatchMatMulV2/32x128x64x128", 32 * 128 * 64 * 128, [](Graph* g) {
+    Op(g, "BatchMatMulV2",
+       {Floats(g, TensorShape({32, 128, 64})),
+        Floats(g, TensorShape({32, 64, 128}))});
+  });
+
+  // Convolutions and pooling, on NHWC images.
+  const Attrs kSame = {A("strides", std::vector<int32>({1, 1, 1, 1})),
+                       A("padding", "SAME")};
+  add("Conv2D/32x56x56x64_3x3x64", kImageElements * 3 * 3 * 64,
+      [=](Graph* g) {
+        Op(g, "Conv2D",
+           {Floats(g, kImages), Floats(g, TensorShape({3, 3, 64, 64}))},
+           kSame);
+      });
+  add("Conv2D/32x28x28x128_1x1x256", 32 * 28 * 28 * 128 * 256, [=](Graph* g) {
+    Op(g, "Conv2D",
+       {Floats(g, TensorShape({32, 28, 28, 128})),
+        Floats(g, TensorShape({1, 1, 128, 256}))},
+       kSame);
+  });
+  add("Conv2DBackpropInput/32x56x56x64_3x3x64", kImageElements * 3 * 3 * 64,
+      [=](Graph* g) {
+        Op(g, "Conv2DBackpropInput",
+           {Int32s(g, {32, 56, 56, 64}), Floats(g, TensorShape({3, 3, 64, 64})),
+            Floats(g, kImages)},
+           kSame);
+      });
+  add("Conv2DBackpropFilter/32x56x56x64_3x3x64", kImageElements * 3 * 3 * 64,
+      [=](Graph* g) {
+        Op(g, "Conv2DBackpropFilter",
+           {Floats(g, kImages), Int32s(g, {3, 3, 64, 64}), Floats(g, kImages)},
+           kSame);
+      });
+  add("DepthwiseConv2dNative/32x56x56x64_3x3", kImageElements * 3 * 3,
+      [=](Graph* g) {
+        Op(g, "DepthwiseConv2dNative",
+           {Floats(g, kImages), Floats(g, TensorShape({3, 3, 64, 1}))},
+           kSame);
+      });
+  for (const char* op : {"MaxPool", "AvgPool"}) {
+    add(strings::StrCat(op, "/32x56x56x64_3x3_stride2"), kImageElements,
+        [=](Graph* g) {
+          Op(g, op, {Floats(g, kImages)},
+             {A("ksize", std::vector<int32>({1, 3, 3, 1})),
+              A("strides", std::vector<int32>({1, 2, 2, 1})),
+              A("padding", "SAME")});
+        });
+  }
+  add("FusedBatchNormV3/32x56x56x64", kImageElements, [=](Graph* g) {
+    const TensorShape channels({64});
+    Op(g, "FusedBatchNormV3",
+       {Floats(g, kImages), Floats(g, channels), Floats(g, channels),
+        Floats(g, channels), Floats(g, channels)});
+  });
+
+  // Losses.
+  add("SoftmaxCrossEntropyWithLogits/1024x1000", 1024 * 1000, [](Graph* g) {
+    const TensorShape shape({1024, 1000});
+    Op(g, "SoftmaxCrossEntropyWithLogits",
+       {Floats(g, shape), Floats(g, shape)});
+  });
+  add("SparseSoftmaxCrossEntropyWithLogits/1024x1000", 1024 * 1000,
+      [](Graph* g) {
+        Op(g, "SparseSoftmaxCrossEntropyWithLogits",
+           {Floats(g, TensorShape({1024, 1000})), Indices(g, 1024, 1000)});
+      });
+
+  // Data movement.
+  for (DataType dtype : {DT_INT32, DT_HALF, DT_BFLOAT16}) {
+    add(strings::StrCat("Cast/1024x1024_float_to_", DataTypeString(dtype)),
+        kElements,
+        [=](Graph* g) { graph::Cast(g, Floats(g, kMatrix), dtype); });
+  }
+  for (int axis : {0, 1}) {
+    add(strings::StrCat("ConcatV2/2x1024x512_axis", axis), kElements,
+        [=](Graph* g) {
+          const TensorShape half({1024, 512});
+          graph::ConcatV2(g, {Floats(g, half), Floats(g, half)},
+                          Int32(g, axis));
+        });
+  }
+  add("Pack/4x256x1024", kElements, [](Graph* g) {
+    const TensorShape quarter({256, 1024});
+    Op(g, "Pack",
+       {Floats(g, quarter), Floats(g, quarter), Floats(g, quarter),
+        Floats(g, quarter)});
+  });
+  add("Split/1024x1024_axis1_4", kElements, [=](Graph* g) {
+    Op(g, "Split", {Int32(g, 1), Floats(g, kMatrix)}, {A("num_split", 4)});
+  });
+  add("Slice/1024x1024_512x512", kElements / 4, [=](Graph* g) {
+    Op(g, "Slice",
+       {Floats(g, kMatrix), Int32s(g, {256, 256}), Int32s(g, {512, 512})});
+  });
+  add("StridedSlice/1024x1024_stride2", kElements / 4, [=](Graph* g) {
+    Op(g, "StridedSlice",
+       {Floats(g, kMatrix), Int32s(g, {0, 0}), Int32s(g, {1024, 1024}),
+        Int32s(g, {2, 2})});
+  });
+  add("Transpose/1024x1024", kElements, [=](Graph* g) {
+    Op(g, "Transpose", {Floats(g, kMatrix), Int32s(g, {1, 0})});
+  });
+  add("Transpose/32x56x56x64_nhwc_to_nchw", kImageElements, [=](Graph* g) {
+    Op(g, "Transpose", {Floats(g, kImages), Int32s(g, {0, 3, 1, 2})});
+  });
+  add("Reshape/1024x1024", kElements, [=](Graph* g) {
+    Op(g, "Reshape", {Floats(g, kMatrix), Int32s(g, {-1})});
+  });
+  add("ExpandDims/1024x1024", kElements, [=](Graph* g) {
+    Op(g, "ExpandDims", {Floats(g, kMatrix), Int32(g, 0)});
+  });
+  add("Squeeze/1x1024x1024", kElements, [](Graph* g) {
+    Op(g, "Squeeze", {Floats(g, TensorShape({1, 1024, 1024}))});
+  });
+  add("Tile/1024x1_1024", kElements, [](Graph* g) {
+    Op(g, "Tile", {Floats(g, TensorShape({1024, 1})), Int32s(g, {1, 1024})});
+  });
+  add("Pad/1024x1024_1", kElements, [=](Graph* g) {
+    Op(g, "Pad",
+       {Floats(g, kMatrix),
+        graph::Constant(g, AsTensor<int32>({1, 1, 1, 1}, {2, 2}))});
+  });
+  add("ReverseV2/1024x1024_axis1", kElements, [=](Graph* g) {
+    Op(g, "ReverseV2", {Floats(g, kMatrix), Int32s(g, {1})});
+  });
+  add("Fill/1024x1024", kElements, [](Graph* g) {
+    Op(g, "Fill",
+       {Int32s(g, {1024, 1024}), graph::Constant(g, Tensor(1.0f))});
+  });
+  add("Range/1048576", 1 << 20, [](Graph* g) {
+    Op(g, "Range", {Int32(g, 0), Int32(g, 1 << 20), Int32(g, 1)});
+  });
+  add("OneHot/65536_128", 65536 * 128, [](Graph* g) {
+    Op(g, "OneHot",
+       {Indices(g, 65536, 128), Int32(g, 128), graph::Constant(g, Tensor(1.0f)),
+        graph::Constant(g, Tensor(0.0f))});
+  });
+  // Embedding lookups and their gradients.
+  add("GatherV2/65536x64_65536", 65536 * 64, [](Graph* g) {
+    graph::Gather(g, Floats(g, TensorShape({65536, 64})),
+                  Indices(g, 65536, 65536), Int32(g, 0));
+  });
+  add("UnsortedSegmentSum/65536x64_1024", 65536 * 64, [](Graph* g) {
+    Op(g, "UnsortedSegmentSum",
+       {Floats(g, TensorShape({65536, 64})), Indices(g, 65536, 1024),
+        Int32(g, 1024)});
+  });
+
+  // Random number generation.
+  for (const char* op :
+       {"RandomUniform", "RandomStandardNormal", "TruncatedNormal"}) {
+    add(strings::StrCat(op, "/1024x1024"), kElements, [=](Graph* g) {
+      Op(g, op, {Int32s(g, {1024, 1024})}, {A("dtype", DT_FLOAT)});
+    });
+  }
+  return suite;
+}
+
+double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  const size_t n = values.size();
+  return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+}  // namespace
+
+const std::vector<OpBenchmark>& OpBenchmarkSuite() {
+  static const std::vector<OpBenchmark>* suite = BuildOpBenchmarkSuite();
+  return *suite;
+}
+
+OpBenchmarkStats RunOpBenchmark(const OpBenchmark& benchmark,
+                                const OpBenchmarkOptions& options) {
+  CHECK_GT(options.repetitions, 0);
+  Benchmark runner(options.device, benchmark.build_graph());
+
+  // Estimates the time of a run to size the repetitions.
+  const double estimate = runner.RunRepetitions(1, 1)[0];
+  OpBenchmarkStats stats;
+  stats.runs_per_repetition = std::max<int64>(
+      1, std::min<int64>(1000000, std::ceil(options.min_repetition_seconds /
+                                            std::max(estimate, 1e-9))));
+
+  std::vector<double> seconds_per_run =
+      runner.RunRepetitions(stats.runs_per_repetition, options.repetitions);
+  for (double& seconds : seconds_per_run) {
+    seconds /= stats.runs_per_repetition;
+    stats.seconds_per_run.UpdateStat(seconds);
+  }
+  stats.median_seconds_per_run = Median(seconds_per_run);
+  return stats;
+}
+
+Status ReportOpBenchmark(const string& report_prefix,
+                         const OpBenchmark& benchmark,
+                         const OpBenchmarkStats& stats) {
+  if (report_prefix.empty()) return Status::OK();
+  TestReporter reporter(report_prefix, benchmark.name);
+  TF_RETURN_IF_ERROR(reporter.Initialize());
+  const int64 runs =
+      stats.runs_per_repetition * stats.seconds_per_run.count();
+  const double mean = stats.seconds_per_run.avg();
+  TF_RETURN_IF_ERROR(reporter.Benchmark(
+      runs, /*cpu_time=*/0, /*wall_time=*/mean * runs,
+      /*throughput=*/mean > 0 ? benchmark.items_per_run / mean : 0));
+  TF_RETURN_IF_ERROR(
+      reporter.SetProperty("median_wall_time", stats.median_seconds_per_run));
+  TF_RETURN_IF_ERROR(
+      reporter.SetProperty("min_wall_time", stats.seconds_per_run.min()));
+  TF_RETURN_IF_ERROR(
+      reporter.SetProperty("max_wall_time", stats.seconds_per_run.max()));
+  TF_RETURN_IF_ERROR(reporter.SetProperty(
+      "stddev_wall_time", stats.seconds_per_run.std_deviation()));
+  TF_RETURN_IF_ERROR(reporter.SetProperty(
+      "repetitions", static_cast<double>(stats.seconds_per_run.count())));
+  return reporter.Close();
+}
+
+}  // namespace test
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_OP_BENCHMARK_SUITE_H_
+#define TENSORFLOW_CORE_KERNELS_OP_BENCHMARK_SUITE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/stats_calculator.h"
+
+namespace tensorflow {
+namespace test {
+
+// A benchmark of the suite: one op on representative shapes.
+struct OpBenchmark {
+  // "<op>/<shape>", e.g. "MatMul/512x512x512". Stable across builds, so that
+  // results can be compared.
+  string name;
+
+  // Returns a new graph running the op once on constant inputs.
+  std::function<Graph*()> build_graph;
+
+  // Elements processed by a run of the graph, for the throughput.
+  int64 items_per_run = 0;
+};
+
+// Returns the benchmarks of the unified op benchmark suite, which covers the
+// ops most used by production models on CPU: elementwise math and
+// activations, matmuls and convolutions, normalization, reductions, and data
+// movement (casts, concats, gathers, transposes...).
+const std::vector<OpBenchmark>& OpBenchmarkSuite();
+
+struct OpBenchmarkOptions {
+  string device = "cpu";
+
+  // Number of timed repetitions. Their spread measures the noise.
+  int repetitions = 10;
+
+  // Each repetition runs the graph enough times to take at least this long,
+  // so that timer resolution and scheduling jitter stay small.
+  double min_repetition_seconds = 0.05;
+};
+
+// Timings of a benchmark over the repetitions.
+struct OpBenchmarkStats {
+  int64 runs_per_repetition = 0;
+  // Seconds per run of each repetition.
+  Stat<double> seconds_per_run;
+  // Less sensitive to outlier repetitions than the mean, so that is what
+  // builds are compared on.
+  double median_seconds_per_run = 0;
+};
+
+// Runs `benchmark` after warmup runs and returns its timings.
+OpBenchmarkStats RunOpBenchmark(const OpBenchmark& benchmark,
+                                const OpBenchmarkOptions& options);
+
+// Writes `stats` as a BenchmarkEntries proto to the file
+// `<report_prefix><benchmark name>` (see TestReporter). The wall time is the
+// mean per run, and the extras hold the median, min, max and standard
+// deviation per run, and the number of repetitions. Does nothing if
+// `report_prefix` is empty.
+Status ReportOpBenchmark(const string& report_prefix,
+                         const OpBenchmark& benchmark,
+                         const OpBenchmarkStats& stats);
+
+}  // namespace test
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_OP_BENCHMARK_SUITE_H_
@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs the op benchmark suite and writes one BenchmarkEntries file per
+// benchmark, to be compared across builds with
+// tensorflow/tools/test/compare_benchmarks.py:
+//
+//   op_benchmark_suite_main --report_prefix=/tmp/before/ --filter=MatMul
+//   ... rebuild ...
+//   op_benchmark_suite_main --report_prefix=/tmp/after/ --filter=MatMul
+//   compare_benchmarks.py /tmp/before/ /tmp/after/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/kernels/op_benchmark_suite.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/reporter.h"
+
+namespace tensorflow {
+namespace {
+
+int Main(int argc, char** argv) {
+  string filter;
+  test::OpBenchmarkOptions options;
+  const char* env_prefix = getenv(TestReporter::kTestReporterEnv);
+  string report_prefix = env_prefix != nullptr ? env_prefix : "";
+  std::vector<Flag> flag_list = {
+      Flag("filter", &filter,
+           "only run the benchmarks whose name contains this string"),
+      Flag("repetitions", &options.repetitions,
+           "number of timed repetitions of each benchmark"),
+      Flag("min_repetition_seconds",
+           [&options](float value) {
+             options.min_repetition_seconds = value;
+             return true;
+           },
+           options.min_repetition_seconds, "minimum duration of a repetition"),
+      Flag("report_prefix", &report_prefix,
+           "prefix of the BenchmarkEntries files, e.g. a directory ending "
+           "with '/'. Defaults to $TEST_REPORT_FILE_PREFIX"),
+  };
+  const string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc > 1 || options.repetitions <= 0) {
+    LOG(ERROR) << usage;
+    return 1;
+  }
+
+  printf("%-50s %14s %8s %14s\n", "Benchmark", "Median (us)", "Stddev",
+         "Items/s");
+  for (const test::OpBenchmark& benchmark : test::OpBenchmarkSuite()) {
+    if (!absl::StrContains(benchmark.name, filter)) continue;
+    const test::OpBenchmarkStats stats =
+        test::RunOpBenchmark(benchmark, options);
+    const double median = stats.median_seconds_per_run;
+    printf("%-50s %14.2f %7.2f%% %14.4g\n", benchmark.name.c_str(),
+           median * 1e6,
+           100 * stats.seconds_per_run.std_deviation() /
+               stats.seconds_per_run.avg(),
+           median > 0 ? benchmark.items_per_run / median : 0.0);
+    fflush(stdout);
+    const Status status =
+        test::ReportOpBenchmark(report_prefix, benchmark, stats);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to report " << benchmark.name << ": " << status;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) { return tensorflow::Main(argc, argv); }
@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/op_benchmark_suite.h"
+
+#include <set>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+namespace test {
+namespace {
+
+TEST(OpBenchmarkSuiteTest, NamesAreUnique) {
+  std::set<string> names;
+  for (const OpBenchmark& benchmark : OpBenchmarkSuite()) {
+    EXPECT_TRUE(names.insert(benchmark.name).second) << benchmark.name;
+    EXPECT_GT(benchmark.items_per_run, 0) << benchmark.name;
+  }
+  EXPECT_GE(names.size(), 100);
+}
+
+TEST(OpBenchmarkSuiteTest, AllGraphsRun) {
+  for (const OpBenchmark& benchmark : OpBenchmarkSuite()) {
+    SCOPED_TRACE(benchmark.name);
+    Benchmark runner("cpu", benchmark.build_graph());
+    EXPECT_EQ(1, runner.RunRepetitions(1, 1).size());
+  }
+}
+
+TEST(OpBenchmarkSuiteTest, ReportsStats) {
+  OpBenchmark benchmark;
+  benchmark.name = "AddV2/16";
+  benchmark.items_per_run = 16;
+  benchmark.build_graph = []() {
+    Graph* g = new Graph(OpRegistry::Global());
+    Tensor t(DT_FLOAT, TensorShape({16}));
+    t.flat<float>().setRandom();
+    graph::Binary(g, "AddV2", graph::Constant(g, t), graph::Constant(g, t));
+    return g;
+  };
+  OpBenchmarkOptions options;
+  options.repetitions = 3;
+  options.min_repetition_seconds = 0.001;
+  const OpBenchmarkStats stats = RunOpBenchmark(benchmark, options);
+  EXPECT_GE(stats.runs_per_repetition, 1);
+  EXPECT_EQ(3, stats.seconds_per_run.count());
+  EXPECT_GT(stats.median_seconds_per_run, 0);
+  EXPECT_GE(stats.median_seconds_per_run, stats.seconds_per_run.min());
+  EXPECT_LE(stats.median_seconds_per_run, stats.seconds_per_run.max());
+
+  const string prefix = io::JoinPath(testing::TmpDir(), "op_benchmark_");
+  TF_ASSERT_OK(ReportOpBenchmark(prefix, benchmark, stats));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), prefix + "AddV2__16",
+                                &contents));
+  BenchmarkEntries entries;
+  ASSERT_TRUE(entries.ParseFromString(contents));
+  ASSERT_EQ(1, entries.entry_size());
+  const BenchmarkEntry& entry = entries.entry(0);
+  EXPECT_EQ("AddV2/16", entry.name());
+  EXPECT_EQ(3 * stats.runs_per_repetition, entry.iters());
+  EXPECT_NEAR(stats.seconds_per_run.avg(), entry.wall_time(), 1e-12);
+  EXPECT_EQ(stats.median_seconds_per_run,
+            entry.extras().at("median_wall_time").double_value());
+  EXPECT_EQ(3, entry.extras().at("repetitions").double_value());
+  EXPECT_EQ(1, entry.extras().count("stddev_wall_time"));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace tensorflow
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/partitioned_function_ops.h"
 
+#include <algorithm>
+
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
@@ -29,6 +32,8 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #ifndef __ANDROID__
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
@@ -39,6 +44,47 @@ limitations under the License.
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 namespace tensorflow {
+namespace {
+
+// Returns true if the body of `fdef` has at most `max_nodes` nodes, all of
+// which may be placed on the `target` device and run by the single-threaded
+// executor without a rendezvous: no loops, nested functions, collectives,
+// Send/Recv or reference-typed outputs.
+bool CanRunInline(const FunctionLibraryDefinition& flib,
+                  const FunctionDef& fdef,
+                  const DeviceNameUtils::ParsedName& target,
+                  int64 max_nodes) {
+  static const auto* const kUnsupportedOps = new absl::flat_hash_set<string>(
+      {"Enter", "RefEnter", "Exit", "RefExit", "NextIteration",
+       "RefNextIteration", "LoopCond", "If", "StatelessIf", "While",
+       "StatelessWhile", "Case", "StatelessCase", "PartitionedCall",
+       "StatefulPartitionedCall", "SymbolicGradient", "_Send", "_Recv",
+       "_HostSend", "_HostRecv"});
+  if (fdef.node_def_size() > max_nodes) return false;
+  if (fdef.attr().count("_XlaMustCompile")) return false;
+  for (const NodeDef& node : fdef.node_def()) {
+    if (kUnsupportedOps->contains(node.op()) ||
+        absl::StartsWith(node.op(), "Collective") ||
+        flib.Find(node.op()) != nullptr) {
+      return false;
+    }
+    const OpDef* op_def;
+    if (!flib.LookUpOpDef(node.op(), &op_def).ok()) return false;
+    for (const OpDef::ArgDef& output : op_def->output_arg()) {
+      if (output.is_ref()) return false;
+    }
+    if (!node.device().empty()) {
+      DeviceNameUtils::ParsedName device;
+      if (!DeviceNameUtils::ParseFullName(node.device(), &device) ||
+          !DeviceNameUtils::IsSpecification(device, target)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
 
 PartitionedCallOp::PartitionedCallOp(OpKernelConstruction* ctx)
     : AsyncOpKernel(ctx),
@@ -71,6 +117,11 @@ PartitionedCallOp::PartitionedCallOp(OpKernelConstruction* ctx)
                                 "tensorflow::ConfigProto proto."));
   }
   OP_REQUIRES_OK(ctx, ctx->GetAttr("executor_type", &executor_type_));
+  // Functions on the CPU with at most this many nodes are run inline by the
+  // single-threaded executor, without a rendezvous. Disabled by default.
+  OP_REQUIRES_OK(ctx,
+                 ReadInt64FromEnvVar("TF_PARTITIONED_CALL_INLINE_MAX_NODES", 0,
+                                     &max_inline_nodes_));
 }
 
 PartitionedCallOp::~PartitionedCallOp() {
@@ -100,22 +151,26 @@ void PartitionedCallOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   // via, e.g., virtual device annotations and a list of device names
   // supplied through an attribute.
   //
-  // TODO(akshayka): Add a fastpath for functions that execute on a single
-  // device.
+  // Small functions that execute on a single CPU device take a fast path, see
+  // `CanRunInline()`.
   FunctionLibraryRuntime::Handle handle;
   // If we are instantiating the function, we can efficiently extract the
   // inputs while instantiating. Else, we extract them separately below.
   std::vector<Tensor> inputs;
   bool inputs_extracted = false;
+  bool run_inline;
   {
     mutex_lock l(mu_);
     auto it = handles_.find(lib);
     if (it == handles_.end()) {
-      OP_REQUIRES_OK_ASYNC(ctx, Instantiate(lib, ctx, &inputs, &handle), done);
+      OP_REQUIRES_OK_ASYNC(
+          ctx, Instantiate(lib, ctx, &inputs, &handle, &run_inline), done);
       inputs_extracted = true;
       handles_[lib] = handle;
+      if (run_inline) inline_libs_.insert(lib);
     } else {
       handle = it->second;
+      run_inline = inline_libs_.count(lib) > 0;
     }
   }
 
@@ -128,7 +183,7 @@ void PartitionedCallOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
     }
   }
 
-  RunFunction(handle, inputs, lib, ctx, done);
+  RunFunction(handle, inputs, lib, ctx, run_inline, done);
 }
 
 Status PartitionedCallOp::FillOutputDevices(
@@ -168,7 +223,8 @@ Status PartitionedCallOp::FillOutputDevices(
 Status PartitionedCallOp::Instantiate(FunctionLibraryRuntime* lib,
                                       OpKernelContext* ctx,
                                       std::vector<Tensor>* inputs,
-                                      FunctionLibraryRuntime::Handle* handle) {
+                                      FunctionLibraryRuntime::Handle* handle,
+                                      bool* run_inline) {
   FunctionLibraryRuntime::InstantiateOptions opts;
   const auto* config = (ctx->function_library())
                            ? ctx->function_library()->config_proto()
@@ -225,6 +281,24 @@ Status PartitionedCallOp::Instantiate(FunctionLibraryRuntime* lib,
   TF_RETURN_IF_ERROR(
       FillOutputDevices(*lib, *cpu_device, AttrSlice(&func_->attr()), &opts));
 
+  *run_inline = false;
+  if (max_inline_nodes_ > 0 && executor_type_.empty() &&
+      !shared_rendezvous_ && lib->device() != nullptr &&
+      lib->device()->device_type() == DEVICE_CPU &&
+      std::all_of(opts.input_devices.begin(), opts.input_devices.end(),
+                  [&opts](const string& device) {
+                    return device == opts.target;
+                  })) {
+    const FunctionLibraryDefinition* flib = lib->GetFunctionLibraryDefinition();
+    *run_inline = CanRunInline(*flib, *flib->Find(func_->name()),
+                               lib->device()->parsed_name(), max_inline_nodes_);
+  }
+  if (*run_inline) {
+    VLOG(1) << "Running function " << func_->name() << " inline";
+    opts.executor_type = "SINGLE_THREADED_EXECUTOR";
+    opts.create_kernels_eagerly = true;
+  }
+
   TF_RETURN_IF_ERROR(
       lib->Instantiate(func_->name(), AttrSlice(&func_->attr()), opts, handle));
   return Status::OK();
@@ -233,7 +307,8 @@ Status PartitionedCallOp::Instantiate(FunctionLibraryRuntime* lib,
 void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
                                     const std::vector<Tensor>& inputs,
                                     FunctionLibraryRuntime* lib,
-                                    OpKernelContext* ctx, DoneCallback done) {
+                                    OpKernelContext* ctx, bool run_inline,
+                                    DoneCallback done) {
   FunctionLibraryRuntime::Options run_opts;
   ResourceMgr* resource_mgr = lib->device()->resource_manager();
   ScopedStepContainer* step_container = new ScopedStepContainer(
@@ -247,7 +322,7 @@ void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
   // TODO(akshayka): Consider selecting a runner on a per-device basis,
   // i.e., using device-specific threadpools when available.
   run_opts.runner = ctx->runner();
-  run_opts.run_all_kernels_inline = ctx->run_all_kernels_inline();
+  run_opts.run_all_kernels_inline = run_inline || ctx->run_all_kernels_inline();
   run_opts.source_device =
       lib->device() == nullptr ? "" : lib->device()->name();
   run_opts.allow_dead_tensors = true;
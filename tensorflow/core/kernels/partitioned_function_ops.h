@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
 
 namespace tensorflow {
 
@@ -47,18 +48,20 @@ class PartitionedCallOp : public AsyncOpKernel {
 
   Status Instantiate(FunctionLibraryRuntime* lib, OpKernelContext* ctx,
                      std::vector<Tensor>* inputs,
-                     FunctionLibraryRuntime::Handle* handle);
+                     FunctionLibraryRuntime::Handle* handle, bool* run_inline);
 
   void RunFunction(FunctionLibraryRuntime::Handle handle,
                    const std::vector<Tensor>& inputs,
                    FunctionLibraryRuntime* lib, OpKernelContext* ctx,
-                   DoneCallback done);
+                   bool run_inline, DoneCallback done);
 
   // Using unique pointers to avoid including proto headers in kernel headers
   std::unique_ptr<NameAttrList> func_;
   std::unique_ptr<ConfigProto> config_proto_;
   string executor_type_;
   bool shared_rendezvous_;
+  // Maximum number of nodes of a function run by the inline fast path.
+  int64 max_inline_nodes_;
   mutex mu_;
   // Cache the handle per FLR because this kernel may be instantiated for
   // a stateful op, different invocations of it may use different FLRs.
@@ -66,6 +69,8 @@ class PartitionedCallOp : public AsyncOpKernel {
   // different FLRs.
   gtl::FlatMap<FunctionLibraryRuntime*, FunctionLibraryRuntime::Handle> handles_
       TF_GUARDED_BY(mu_);
+  // The FLRs whose handle runs on the inline fast path.
+  gtl::FlatSet<FunctionLibraryRuntime*> inline_libs_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/kernels/ruy_support.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/padding.h"
 
@@ -391,6 +392,16 @@ class Im2ColConvFunctor {
         meta::QuantizedGemm(context, transpose_a, transpose_b, im2col_buffer,
                             filter_data, chunk_output_data, m, n, k,
                             -input_offset, -filter_offset, lda, ldb, ldc);
+      } else if (ruy_support::IsSupportedAndEnabled() &&
+                 std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
+                 std::is_same<T3, qint32>() && (output_offset == 0) &&
+                 (output_mult == 1) && (output_shift == 0) &&
+                 (transpose_c == false) &&
+                 ruy_support::CanUseOffsets(-input_offset, -filter_offset)) {
+        ruy_support::QuantizedGemm(context, transpose_a, transpose_b,
+                                   im2col_buffer, filter_data,
+                                   chunk_output_data, m, n, k, -input_offset,
+                                   -filter_offset, lda, ldb, ldc);
       } else if (std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
                  std::is_same<T3, qint32>() && (output_offset == 0) &&
                  (output_mult == 1) && (output_shift == 0)) {
@@ -30,13 +30,77 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/ruy_support.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
 
 class QuantizedMatMulTest : public OpsTestBase {
  protected:
+  // Multiplies random a and b matrices, large enough for the optimized GEMM
+  // libraries to use their packed kernels, and compares the result with
+  // integer arithmetic.
+  void TestLargeRandom(bool transpose_a, bool transpose_b, float a_min,
+                       float a_max, float b_min, float b_max) {
+    const int m = 67;
+    const int n = 45;
+    const int k = 131;
+    TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMul")
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("Toutput", DataTypeToEnum<qint32>::v())
+                     .Attr("transpose_a", transpose_a)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    random::PhiloxRandom philox(7);
+    random::SimplePhilox rng(&philox);
+    std::vector<quint8> a_values(m * k);
+    for (quint8& value : a_values) {
+      value = static_cast<uint8>(rng.Uniform(256));
+    }
+    std::vector<quint8> b_values(k * n);
+    for (quint8& value : b_values) {
+      value = static_cast<uint8>(rng.Uniform(256));
+    }
+    AddInputFromArray<quint8>(
+        transpose_a ? TensorShape({k, m}) : TensorShape({m, k}), a_values);
+    AddInputFromArray<quint8>(
+        transpose_b ? TensorShape({n, k}) : TensorShape({k, n}), b_values);
+    AddInputFromArray<float>(TensorShape({1}), {a_min});
+    AddInputFromArray<float>(TensorShape({1}), {a_max});
+    AddInputFromArray<float>(TensorShape({1}), {b_min});
+    AddInputFromArray<float>(TensorShape({1}), {b_max});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const int32 offset_a =
+        FloatToQuantizedUnclamped<quint8>(0.0f, a_min, a_max);
+    const int32 offset_b =
+        FloatToQuantizedUnclamped<quint8>(0.0f, b_min, b_max);
+    std::vector<qint32> expected_values(m * n);
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        int32 sum = 0;
+        for (int l = 0; l < k; ++l) {
+          const int32 a = a_values[transpose_a ? l * m + i : i * k + l].value;
+          const int32 b = b_values[transpose_b ? j * k + l : l * n + j].value;
+          sum += (a - offset_a) * (b - offset_b);
+        }
+        expected_values[i * n + j] = sum;
+      }
+    }
+    Tensor expected(allocator(), DT_QINT32, TensorShape({m, n}));
+    test::FillValues<qint32>(&expected, expected_values);
+    test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
+  }
 };
 
 // Runs two small matrices through the operator, and leaves all the parameters
@@ -355,4 +419,23 @@ TEST_F(QuantizedMatMulTest, Medium_WithParams) {
   test::ExpectTensorNear<float>(expected_float, output_float, 15.0);
 }
 
+TEST_F(QuantizedMatMulTest, Large) {
+  TestLargeRandom(false, false, -1.0f, 1.0f, -0.5f, 2.0f);
+}
+
+TEST_F(QuantizedMatMulTest, Large_Transposed) {
+  TestLargeRandom(true, true, -1.0f, 1.0f, -0.5f, 2.0f);
+}
+
+// Offsets outside of [0, 255] can't be ruy zero points.
+TEST_F(QuantizedMatMulTest, Large_OffsetsOutOfRange) {
+  TestLargeRandom(false, true, 1.0f, 2.0f, -3.0f, -1.0f);
+}
+
+TEST_F(QuantizedMatMulTest, Large_RuyDisabled) {
+  ruy_support::SetEnabled(false);
+  TestLargeRandom(false, true, -1.0f, 1.0f, -0.5f, 2.0f);
+  ruy_support::SetEnabled(true);
+}
+
 }  // namespace tensorflow
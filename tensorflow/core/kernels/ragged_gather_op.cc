@@ -12,6 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#define EIGEN_USE_THREADS
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 #include <limits>
 #include <memory>
 #include <string>
@@ -23,6 +29,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/util/util.h"
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/kernels/gpu_device_array.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 namespace tensorflow {
 
 namespace {
@@ -245,9 +255,8 @@ class RaggedGatherOpBase : public OpKernel {
     const SPLITS_TYPE value_size =
         num_elements == 0 ? 0
                           : (num_elements / params_dense_values_in.dim_size(0));
-    CallWriteValueSlices(params_dense_values_in, value_slices, value_size,
-                         values_out);
-    return ::tensorflow::Status::OK();
+    return CallWriteValueSlices(context, params_dense_values_in, value_slices,
+                                value_size, values_out);
   }
 
  protected:
@@ -256,8 +265,8 @@ class RaggedGatherOpBase : public OpKernel {
   // this allows us to have two instantiations of this class (one for each
   // index type), rather than 14 (one for each index type and value type),
   // which cuts the binary size of this op from ~300k to <90k.
-  virtual void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
+  virtual ::tensorflow::Status CallWriteValueSlices(
+      OpKernelContext* context, const Tensor& params_dense_values_in,
       const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const = 0;
 };
@@ -268,12 +277,13 @@ class RaggedGatherOp : public RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE> {
   using RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE>::RaggedGatherOpBase;
 
  private:
-  void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
+  ::tensorflow::Status CallWriteValueSlices(
+      OpKernelContext* context, const Tensor& params_dense_values_in,
       const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const override {
     WriteValueSlices<VALUE_TYPE>(params_dense_values_in, value_slices,
                                  value_size, values_out);
+    return ::tensorflow::Status::OK();
   }
 };
 
@@ -299,4 +309,101 @@ TF_CALL_qint16(REGISTER_CPU_KERNEL);
 #undef REGISTER_CPU_KERNEL
 #undef REGISTER_CPU_KERNEL_WITH_INDEX_TYPE
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+template <typename VALUE_TYPE, typename SPLITS_TYPE>
+void RaggedGatherGPUImpl(const Eigen::GpuDevice& gpu_device,
+                         const int32 value_size,
+                         const GpuDeviceArrayStruct<SPLITS_TYPE>& slice_starts,
+                         const GpuDeviceArrayStruct<int32>& slice_offsets,
+                         const VALUE_TYPE* params_dense_values,
+                         const int32 num_values, VALUE_TYPE* values);
+#define DECLARE_GPU_SPLITS_TYPE(T, SPLITS_TYPE)                         \
+  extern template void RaggedGatherGPUImpl(                             \
+      const Eigen::GpuDevice& gpu_device, const int32 value_size,       \
+      const GpuDeviceArrayStruct<SPLITS_TYPE>& slice_starts,            \
+      const GpuDeviceArrayStruct<int32>& slice_offsets,                 \
+      const T* params_dense_values, const int32 num_values, T* values);
+#define DECLARE_GPU(T)              \
+  DECLARE_GPU_SPLITS_TYPE(T, int32) \
+  DECLARE_GPU_SPLITS_TYPE(T, int64)
+
+TF_CALL_int32(DECLARE_GPU);
+TF_CALL_int64(DECLARE_GPU);
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU);
+TF_CALL_COMPLEX_TYPES(DECLARE_GPU);
+
+#undef DECLARE_GPU
+#undef DECLARE_GPU_SPLITS_TYPE
+
+// The splits and indices, which are small compared to the values, are read
+// and written in host memory, like on CPU. The slices of values to gather are
+// then copied to the device, and gathered there.
+template <typename INDEX_TYPE, typename VALUE_TYPE, typename SPLITS_TYPE>
+class RaggedGatherGpuOp : public RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE> {
+ public:
+  using RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE>::RaggedGatherOpBase;
+
+ private:
+  ::tensorflow::Status CallWriteValueSlices(
+      OpKernelContext* context, const Tensor& params_dense_values_in,
+      const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
+      SPLITS_TYPE value_size, Tensor* values_out) const override {
+    if (values_out->NumElements() == 0) return ::tensorflow::Status::OK();
+    if (params_dense_values_in.NumElements() >=
+            std::numeric_limits<int32>::max() ||
+        values_out->NumElements() >= std::numeric_limits<int32>::max()) {
+      return errors::InvalidArgument(
+          "RaggedGather on GPU supports less than 2^31 values");
+    }
+
+    // The output rows of a slice start after the rows of the slices before.
+    const int num_slices = value_slices.size();
+    GpuDeviceArrayOnHost<SPLITS_TYPE> slice_starts(context, num_slices);
+    GpuDeviceArrayOnHost<int32> slice_offsets(context, num_slices);
+    TF_RETURN_IF_ERROR(slice_starts.Init());
+    TF_RETURN_IF_ERROR(slice_offsets.Init());
+    int32 offset = 0;
+    for (int i = 0; i < num_slices; ++i) {
+      slice_starts.Set(i, value_slices[i].first);
+      slice_offsets.Set(i, offset);
+      offset += value_slices[i].second - value_slices[i].first;
+    }
+    TF_RETURN_IF_ERROR(slice_starts.Finalize());
+    TF_RETURN_IF_ERROR(slice_offsets.Finalize());
+
+    RaggedGatherGPUImpl<VALUE_TYPE, SPLITS_TYPE>(
+        context->eigen_gpu_device(), value_size, slice_starts.data(),
+        slice_offsets.data(), params_dense_values_in.flat<VALUE_TYPE>().data(),
+        offset, values_out->flat<VALUE_TYPE>().data());
+    return ::tensorflow::Status::OK();
+  }
+};
+
+#define REGISTER_GPU_KERNEL_WITH_INDEX_TYPE(index_type, value_type, \
+                                            splits_type)            \
+  REGISTER_KERNEL_BUILDER(                                          \
+      Name("RaggedGather")                                          \
+          .Device(DEVICE_GPU)                                       \
+          .TypeConstraint<index_type>("Tindices")                   \
+          .TypeConstraint<value_type>("Tvalues")                    \
+          .TypeConstraint<splits_type>("Tsplits")                   \
+          .HostMemory("params_nested_splits")                       \
+          .HostMemory("indices")                                    \
+          .HostMemory("output_nested_splits"),                      \
+      RaggedGatherGpuOp<index_type, value_type, splits_type>);
+#define REGISTER_GPU_KERNEL(value_type)                         \
+  REGISTER_GPU_KERNEL_WITH_INDEX_TYPE(int32, value_type, int32) \
+  REGISTER_GPU_KERNEL_WITH_INDEX_TYPE(int64, value_type, int32) \
+  REGISTER_GPU_KERNEL_WITH_INDEX_TYPE(int32, value_type, int64) \
+  REGISTER_GPU_KERNEL_WITH_INDEX_TYPE(int64, value_type, int64)
+TF_CALL_int32(REGISTER_GPU_KERNEL);
+TF_CALL_int64(REGISTER_GPU_KERNEL);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_KERNEL);
+TF_CALL_COMPLEX_TYPES(REGISTER_GPU_KERNEL);
+#undef REGISTER_GPU_KERNEL
+#undef REGISTER_GPU_KERNEL_WITH_INDEX_TYPE
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 }  // namespace tensorflow
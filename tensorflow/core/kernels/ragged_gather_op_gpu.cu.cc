@@ -0,0 +1,90 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/gpu_device_array_gpu.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+namespace {
+
+template <typename T, typename SPLITS_TYPE>
+__global__ void RaggedGatherKernel(
+    const int32 size, const int32 value_size,
+    GpuDeviceArrayStruct<SPLITS_TYPE> slice_starts,
+    GpuDeviceArrayStruct<int32> slice_offsets,
+    const T* __restrict__ params_dense_values, T* __restrict__ values) {
+  const SPLITS_TYPE* slice_starts_ptr =
+      GetGpuDeviceArrayOnDevice(&slice_starts);
+  const int32* slice_offsets_ptr = GetGpuDeviceArrayOnDevice(&slice_offsets);
+  const int num_slices = slice_offsets.size;
+  for (int i : GpuGridRangeX(size)) {
+    const int32 row = i / value_size;
+    // The slice of the row is the last one starting at or before it.
+    const int slice = gpu_helper::upper_bound<int32, int>(
+                          slice_offsets_ptr, num_slices, row) -
+                      1;
+    const int64 params_row =
+        slice_starts_ptr[slice] + (row - slice_offsets_ptr[slice]);
+    values[i] =
+        ldg(params_dense_values + params_row * value_size + i % value_size);
+  }
+}
+
+}  // namespace
+
+template <typename VALUE_TYPE, typename SPLITS_TYPE>
+void RaggedGatherGPUImpl(const Eigen::GpuDevice& gpu_device,
+                         const int32 value_size,
+                         const GpuDeviceArrayStruct<SPLITS_TYPE>& slice_starts,
+                         const GpuDeviceArrayStruct<int32>& slice_offsets,
+                         const VALUE_TYPE* params_dense_values,
+                         const int32 num_values, VALUE_TYPE* values) {
+  const int32 size = num_values * value_size;
+  if (size == 0) return;
+  GpuLaunchConfig config = GetGpuLaunchConfig(size, gpu_device);
+  TF_CHECK_OK(GpuLaunchKernel(RaggedGatherKernel<VALUE_TYPE, SPLITS_TYPE>,
+                              config.block_count, config.thread_per_block, 0,
+                              gpu_device.stream(), size, value_size,
+                              slice_starts, slice_offsets, params_dense_values,
+                              values));
+}
+
+#define REGISTER_GPU_SPLITS_TYPE(T, SPLITS_TYPE)                        \
+  template void RaggedGatherGPUImpl(                                    \
+      const Eigen::GpuDevice& gpu_device, const int32 value_size,       \
+      const GpuDeviceArrayStruct<SPLITS_TYPE>& slice_starts,            \
+      const GpuDeviceArrayStruct<int32>& slice_offsets,                 \
+      const T* params_dense_values, const int32 num_values, T* values);
+#define REGISTER_GPU(T)              \
+  REGISTER_GPU_SPLITS_TYPE(T, int32) \
+  REGISTER_GPU_SPLITS_TYPE(T, int64)
+
+TF_CALL_int32(REGISTER_GPU);
+TF_CALL_int64(REGISTER_GPU);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU);
+TF_CALL_COMPLEX_TYPES(REGISTER_GPU);
+
+#undef REGISTER_GPU
+#undef REGISTER_GPU_SPLITS_TYPE
+
+}  // namespace tensorflow
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -12,6 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#define EIGEN_USE_THREADS
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include "tensorflow/core/kernels/ragged_range_op.h"
+
 #include <limits>
 #include <memory>
 #include <string>
@@ -22,10 +30,55 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#if GOOGLE_CUDA
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+using stream_executor::cuda::ScopedActivateExecutorContext;
+#elif TENSORFLOW_USE_ROCM
+#include "tensorflow/core/platform/rocm.h"
+using stream_executor::rocm::ScopedActivateExecutorContext;
+#endif  // TENSORFLOW_USE_ROCM
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 namespace tensorflow {
 
 using errors::InvalidArgument;
 
+namespace {
+
+// Checks the shapes of the `starts`, `limits` and `deltas` inputs, and returns
+// the number of output rows: the size of the non-broadcast inputs, or 1 if all
+// inputs are scalars.
+Status GetNumRows(const Tensor& starts_in, const Tensor& limits_in,
+                  const Tensor& deltas_in, int64* nrows) {
+  // Check input tensor shapes.
+  if (starts_in.shape().dims() > 1) {
+    return InvalidArgument("starts must be a scalar or vector");
+  }
+  if (limits_in.shape().dims() > 1) {
+    return InvalidArgument("limits must be a scalar or vector");
+  }
+  if (deltas_in.shape().dims() > 1) {
+    return InvalidArgument("deltas must be a scalar or vector");
+  }
+
+  std::vector<int64> in_sizes;
+  for (const Tensor* in : {&starts_in, &limits_in, &deltas_in}) {
+    if (in->shape().dims() == 1) in_sizes.push_back(in->shape().dim_size(0));
+  }
+  for (int i = 1; i < in_sizes.size(); ++i) {
+    if (in_sizes[i] != in_sizes[i - 1]) {
+      return InvalidArgument(
+          "starts, limits, and deltas must have the same shape");
+    }
+  }
+  *nrows = in_sizes.empty() ? 1 : in_sizes[0];
+  return Status::OK();
+}
+
+}  // namespace
+
 template <typename T, typename SPLITS_TYPE>
 class RaggedRangeOp : public OpKernel {
  public:
@@ -36,32 +89,16 @@ class RaggedRangeOp : public OpKernel {
     const Tensor& limits_in = context->input(1);
     const Tensor& deltas_in = context->input(2);
 
-    // Check input tensor shapes.
-    OP_REQUIRES(context, starts_in.shape().dims() <= 1,
-                InvalidArgument("starts must be a scalar or vector"));
-    OP_REQUIRES(context, limits_in.shape().dims() <= 1,
-                InvalidArgument("limits must be a scalar or vector"));
-    OP_REQUIRES(context, deltas_in.shape().dims() <= 1,
-                InvalidArgument("deltas must be a scalar or vector"));
+    int64 num_rows;
+    OP_REQUIRES_OK(context,
+                   GetNumRows(starts_in, limits_in, deltas_in, &num_rows));
+    SPLITS_TYPE nrows = num_rows;
 
     // Determine which tensors we need to broadcast.
     bool broadcast_starts = starts_in.shape().dims() == 0;
     bool broadcast_limits = limits_in.shape().dims() == 0;
     bool broadcast_deltas = deltas_in.shape().dims() == 0;
 
-    // nrows (number of output rows) is the size of the non-broadcast inputs,
-    // or 1 if all inputs are scalars.
-    std::vector<int> in_sizes;
-    if (!broadcast_starts) in_sizes.push_back(starts_in.shape().dim_size(0));
-    if (!broadcast_limits) in_sizes.push_back(limits_in.shape().dim_size(0));
-    if (!broadcast_deltas) in_sizes.push_back(deltas_in.shape().dim_size(0));
-    for (int i = 1; i < in_sizes.size(); ++i) {
-      OP_REQUIRES(context, in_sizes[i] == in_sizes[i - 1],
-                  InvalidArgument("starts, limits, and deltas must have the "
-                                  "same shape"));
-    }
-    SPLITS_TYPE nrows = in_sizes.empty() ? 1 : in_sizes[0];
-
     const auto& starts = starts_in.flat<T>();
     const auto& limits = limits_in.flat<T>();
     const auto& deltas = deltas_in.flat<T>();
@@ -131,4 +168,133 @@ TF_CALL_int32(REGISTER_CPU_KERNEL);
 TF_CALL_int64(REGISTER_CPU_KERNEL);
 #undef REGISTER_CPU_KERNEL
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+typedef Eigen::GpuDevice GPUDevice;
+
+// Computes the row splits on the device, and copies their last value, the
+// number of values, to the host to allocate the values.
+template <typename T, typename SPLITS_TYPE>
+class RaggedRangeGpuOp : public AsyncOpKernel {
+ public:
+  using AsyncOpKernel::AsyncOpKernel;
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& starts_in = context->input(0);
+    const Tensor& limits_in = context->input(1);
+    const Tensor& deltas_in = context->input(2);
+
+    int64 nrows;
+    OP_REQUIRES_OK_ASYNC(
+        context, GetNumRows(starts_in, limits_in, deltas_in, &nrows), done);
+    OP_REQUIRES_ASYNC(
+        context, nrows < std::numeric_limits<int32>::max(),
+        InvalidArgument("RaggedRange on GPU supports less than 2^31 rows"),
+        done);
+
+    Tensor* rt_nested_splits_out = nullptr;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_output(0, TensorShape({nrows + 1}),
+                                 &rt_nested_splits_out),
+        done);
+    Tensor invalid_delta;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DT_INT32, TensorShape({}), &invalid_delta),
+        done);
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        functor::RaggedRangeSplits<GPUDevice, T, SPLITS_TYPE>()(
+            context, d, starts_in.flat<T>(), limits_in.flat<T>(),
+            deltas_in.flat<T>(), rt_nested_splits_out->flat<SPLITS_TYPE>(),
+            invalid_delta.scalar<int32>()),
+        done);
+
+    // Copy the number of values and the delta check to the host.
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    Tensor nvals_host;
+    Tensor invalid_delta_host;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DataTypeToEnum<SPLITS_TYPE>::value,
+                               TensorShape({}), &nvals_host, host_attr),
+        done);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DT_INT32, TensorShape({}), &invalid_delta_host,
+                               host_attr),
+        done);
+    auto stream = context->op_device_context()->stream();
+    se::DeviceMemoryBase nvals_ptr(
+        rt_nested_splits_out->flat<SPLITS_TYPE>().data() + nrows,
+        sizeof(SPLITS_TYPE));
+    se::DeviceMemoryBase invalid_delta_ptr(
+        invalid_delta.scalar<int32>().data(), sizeof(int32));
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(nvals_host.scalar<SPLITS_TYPE>().data(), nvals_ptr,
+                         sizeof(SPLITS_TYPE))
+            .ThenMemcpy(invalid_delta_host.scalar<int32>().data(),
+                        invalid_delta_ptr, sizeof(int32))
+            .ok(),
+        errors::Internal("RaggedRange: failed to copy the number of values "
+                         "from device"),
+        done);
+
+    auto create_values = [context, starts_in, deltas_in, rt_nested_splits_out,
+                          nvals_host, invalid_delta_host, done]() {
+      // Ensure that within the callback, the proper GPU settings are
+      // configured.
+      auto stream = context->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{stream->parent()};
+
+      OP_REQUIRES_ASYNC(context, invalid_delta_host.scalar<int32>()() == 0,
+                        InvalidArgument("Requires delta != 0"), done);
+      const SPLITS_TYPE nvals = nvals_host.scalar<SPLITS_TYPE>()();
+      OP_REQUIRES_ASYNC(
+          context, nvals < std::numeric_limits<int32>::max(),
+          InvalidArgument("RaggedRange on GPU supports less than 2^31 values"),
+          done);
+      Tensor* rt_dense_values_out = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          context->allocate_output(1, TensorShape({nvals}),
+                                   &rt_dense_values_out),
+          done);
+      const Tensor& rt_nested_splits = *rt_nested_splits_out;
+      functor::RaggedRangeValues<GPUDevice, T, SPLITS_TYPE>()(
+          context->eigen_device<GPUDevice>(), starts_in.flat<T>(),
+          deltas_in.flat<T>(), rt_nested_splits.flat<SPLITS_TYPE>(),
+          rt_dense_values_out->flat<T>());
+      done();
+    };
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, create_values);
+  }
+};
+
+#define REGISTER_GPU_KERNEL(TYPE)                                \
+  REGISTER_KERNEL_BUILDER(Name("RaggedRange")                    \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int32>("Tsplits"), \
+                          RaggedRangeGpuOp<TYPE, int32>);        \
+  REGISTER_KERNEL_BUILDER(Name("RaggedRange")                    \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int64>("Tsplits"), \
+                          RaggedRangeGpuOp<TYPE, int64>);
+TF_CALL_float(REGISTER_GPU_KERNEL);
+TF_CALL_double(REGISTER_GPU_KERNEL);
+TF_CALL_int32(REGISTER_GPU_KERNEL);
+TF_CALL_int64(REGISTER_GPU_KERNEL);
+#undef REGISTER_GPU_KERNEL
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 }  // namespace tensorflow
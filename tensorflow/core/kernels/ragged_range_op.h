@@ -0,0 +1,53 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_RAGGED_RANGE_OP_H_
+#define TENSORFLOW_CORE_KERNELS_RAGGED_RANGE_OP_H_
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Computes the `nrows + 1` row splits of RaggedRange, as the prefix sum of the
+// sizes of the ranges. `starts`, `limits` and `deltas` have either `nrows`
+// elements or a single broadcast one. Sets `invalid_delta` to 1 if any delta
+// is zero, and 0 otherwise.
+template <typename Device, typename T, typename SPLITS_TYPE>
+struct RaggedRangeSplits {
+  Status operator()(OpKernelContext* context, const Device& d,
+                    typename TTypes<T>::ConstFlat starts,
+                    typename TTypes<T>::ConstFlat limits,
+                    typename TTypes<T>::ConstFlat deltas,
+                    typename TTypes<SPLITS_TYPE>::Flat splits,
+                    typename TTypes<int32>::Scalar invalid_delta);
+};
+
+// Writes the values of the ranges, row `i` being `values[splits[i]:
+// splits[i + 1]]`.
+template <typename Device, typename T, typename SPLITS_TYPE>
+struct RaggedRangeValues {
+  void operator()(const Device& d, typename TTypes<T>::ConstFlat starts,
+                  typename TTypes<T>::ConstFlat deltas,
+                  typename TTypes<SPLITS_TYPE>::ConstFlat splits,
+                  typename TTypes<T>::Flat values);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_RAGGED_RANGE_OP_H_
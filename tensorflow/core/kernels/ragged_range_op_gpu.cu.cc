@@ -0,0 +1,187 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include <type_traits>
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/gpu_prim.h"
+#include "tensorflow/core/kernels/ragged_range_op.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// Returns the number of elements in the specified range, like
+// RaggedRangeOp::RangeSize().
+template <typename T, typename SPLITS_TYPE>
+__device__ typename std::enable_if<std::is_integral<T>::value,
+                                   SPLITS_TYPE>::type
+RangeSize(T start, T limit, T delta) {
+  if (((delta > 0) && (limit < start)) || ((delta < 0) && (limit > start))) {
+    return 0;
+  }
+  const T abs_delta = delta < 0 ? -delta : delta;
+  const T abs_size = limit < start ? start - limit : limit - start;
+  return (abs_size + abs_delta - 1) / abs_delta;
+}
+
+template <typename T, typename SPLITS_TYPE>
+__device__ typename std::enable_if<!std::is_integral<T>::value,
+                                   SPLITS_TYPE>::type
+RangeSize(T start, T limit, T delta) {
+  if (((delta > 0) && (limit < start)) || ((delta < 0) && (limit > start))) {
+    return 0;
+  }
+  return Eigen::numext::ceil(Eigen::numext::abs((limit - start) / delta));
+}
+
+template <typename T, typename SPLITS_TYPE>
+__global__ void RaggedRangeSizesKernel(const int nrows,
+                                       const T* __restrict__ starts,
+                                       const int starts_stride,
+                                       const T* __restrict__ limits,
+                                       const int limits_stride,
+                                       const T* __restrict__ deltas,
+                                       const int deltas_stride,
+                                       SPLITS_TYPE* __restrict__ sizes,
+                                       int32* __restrict__ invalid_delta) {
+  for (int row : GpuGridRangeX(nrows)) {
+    const T start = ldg(starts + row * starts_stride);
+    const T limit = ldg(limits + row * limits_stride);
+    const T delta = ldg(deltas + row * deltas_stride);
+    if (delta == T(0)) {
+      *invalid_delta = 1;
+      sizes[row] = 0;
+    } else {
+      sizes[row] = RangeSize<T, SPLITS_TYPE>(start, limit, delta);
+    }
+  }
+}
+
+template <typename T, typename SPLITS_TYPE>
+__global__ void RaggedRangeValuesKernel(const int nrows, const int nvals,
+                                        const T* __restrict__ starts,
+                                        const int starts_stride,
+                                        const T* __restrict__ deltas,
+                                        const int deltas_stride,
+                                        const SPLITS_TYPE* __restrict__ splits,
+                                        T* __restrict__ values) {
+  for (int i : GpuGridRangeX(nvals)) {
+    // The row of the value is the last one starting at or before it.
+    const int row = gpu_helper::upper_bound<SPLITS_TYPE, int>(
+                        splits + 1, nrows, static_cast<SPLITS_TYPE>(i));
+    const T start = ldg(starts + row * starts_stride);
+    const T delta = ldg(deltas + row * deltas_stride);
+    values[i] = start + static_cast<T>(i - ldg(splits + row)) * delta;
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T, typename SPLITS_TYPE>
+struct RaggedRangeSplits<GPUDevice, T, SPLITS_TYPE> {
+  Status operator()(OpKernelContext* context, const GPUDevice& d,
+                    typename TTypes<T>::ConstFlat starts,
+                    typename TTypes<T>::ConstFlat limits,
+                    typename TTypes<T>::ConstFlat deltas,
+                    typename TTypes<SPLITS_TYPE>::Flat splits,
+                    typename TTypes<int32>::Scalar invalid_delta) {
+    const int nrows = splits.size() - 1;
+    d.memset(splits.data(), 0, sizeof(SPLITS_TYPE));
+    d.memset(invalid_delta.data(), 0, sizeof(int32));
+    if (nrows == 0) return Status::OK();
+
+    Tensor sizes;
+    TF_RETURN_IF_ERROR(context->allocate_temp(
+        DataTypeToEnum<SPLITS_TYPE>::value, TensorShape({nrows}), &sizes));
+    SPLITS_TYPE* sizes_ptr = sizes.flat<SPLITS_TYPE>().data();
+    GpuLaunchConfig config = GetGpuLaunchConfig(nrows, d);
+    TF_RETURN_IF_ERROR(GpuLaunchKernel(
+        RaggedRangeSizesKernel<T, SPLITS_TYPE>, config.block_count,
+        config.thread_per_block, 0, d.stream(), nrows, starts.data(),
+        starts.size() == 1 ? 0 : 1, limits.data(), limits.size() == 1 ? 0 : 1,
+        deltas.data(), deltas.size() == 1 ? 0 : 1, sizes_ptr,
+        invalid_delta.data()));
+
+    // The splits are the inclusive prefix sum of the sizes, after the
+    // leading 0.
+    size_t temp_storage_bytes = 0;
+    auto err = gpuprim::DeviceScan::InclusiveSum(
+        /*d_temp_storage=*/nullptr, temp_storage_bytes, sizes_ptr,
+        splits.data() + 1, nrows, d.stream());
+    if (err != gpuSuccess) {
+      return errors::Internal(
+          "Could not launch InclusiveSum to get temp storage: ",
+          GpuGetErrorString(err), ".");
+    }
+    Tensor temp_storage;
+    TF_RETURN_IF_ERROR(context->allocate_temp(
+        DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+        &temp_storage));
+    err = gpuprim::DeviceScan::InclusiveSum(
+        temp_storage.flat<int8>().data(), temp_storage_bytes, sizes_ptr,
+        splits.data() + 1, nrows, d.stream());
+    if (err != gpuSuccess) {
+      return errors::Internal("Could not launch InclusiveSum: ",
+                              GpuGetErrorString(err), ".");
+    }
+    return Status::OK();
+  }
+};
+
+template <typename T, typename SPLITS_TYPE>
+struct RaggedRangeValues<GPUDevice, T, SPLITS_TYPE> {
+  void operator()(const GPUDevice& d, typename TTypes<T>::ConstFlat starts,
+                  typename TTypes<T>::ConstFlat deltas,
+                  typename TTypes<SPLITS_TYPE>::ConstFlat splits,
+                  typename TTypes<T>::Flat values) {
+    const int nvals = values.size();
+    if (nvals == 0) return;
+    GpuLaunchConfig config = GetGpuLaunchConfig(nvals, d);
+    TF_CHECK_OK(GpuLaunchKernel(
+        RaggedRangeValuesKernel<T, SPLITS_TYPE>, config.block_count,
+        config.thread_per_block, 0, d.stream(),
+        static_cast<int>(splits.size() - 1), nvals, starts.data(),
+        starts.size() == 1 ? 0 : 1, deltas.data(), deltas.size() == 1 ? 0 : 1,
+        splits.data(), values.data()));
+  }
+};
+
+#define DEFINE_GPU_SPECS(T)                                 \
+  template struct RaggedRangeSplits<GPUDevice, T, int32>;   \
+  template struct RaggedRangeSplits<GPUDevice, T, int64>;   \
+  template struct RaggedRangeValues<GPUDevice, T, int32>;   \
+  template struct RaggedRangeValues<GPUDevice, T, int64>;
+
+TF_CALL_float(DEFINE_GPU_SPECS);
+TF_CALL_double(DEFINE_GPU_SPECS);
+TF_CALL_int32(DEFINE_GPU_SPECS);
+TF_CALL_int64(DEFINE_GPU_SPECS);
+
+#undef DEFINE_GPU_SPECS
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -225,4 +225,24 @@ REGISTER_KERNEL_BUILDER(Name("RaggedTensorToSparse")
                             .TypeConstraint<int64>("Tsplits"),
                         RaggedTensorToSparseOp<int64>);
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// The values are forwarded unchanged, so only the splits, indices and dense
+// shape need to be in host memory.
+REGISTER_KERNEL_BUILDER(Name("RaggedTensorToSparse")
+                            .Device(DEVICE_GPU)
+                            .TypeConstraint<int32>("Tsplits")
+                            .HostMemory("rt_nested_splits")
+                            .HostMemory("sparse_indices")
+                            .HostMemory("sparse_dense_shape"),
+                        RaggedTensorToSparseOp<int32>);
+
+REGISTER_KERNEL_BUILDER(Name("RaggedTensorToSparse")
+                            .Device(DEVICE_GPU)
+                            .TypeConstraint<int64>("Tsplits")
+                            .HostMemory("rt_nested_splits")
+                            .HostMemory("sparse_indices")
+                            .HostMemory("sparse_dense_shape"),
+                        RaggedTensorToSparseOp<int64>);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 }  // namespace tensorflow
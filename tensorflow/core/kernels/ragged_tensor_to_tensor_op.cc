@@ -15,6 +15,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 #include <stddef.h>
 
 #include <algorithm>
@@ -41,8 +45,40 @@ limitations under the License.
 #include "tensorflow/core/util/bcast.h"
 #include "tensorflow/core/util/ragged_to_dense_util.h"
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/kernels/gpu_device_array.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 namespace tensorflow {
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+template <typename VALUE_TYPE, typename INDEX_TYPE>
+void RaggedTensorToTensorGPUImpl(
+    const Eigen::GpuDevice& gpu_device, const int32 value_element_size,
+    const GpuDeviceArrayStruct<VALUE_TYPE>& default_value,
+    const GpuDeviceArrayStruct<INDEX_TYPE>& output_index,
+    const VALUE_TYPE* values, const int32 output_size, VALUE_TYPE* output);
+#define REGISTER_GPU_INDEX_TYPE(T, INDEX_TYPE)                                \
+  extern template void RaggedTensorToTensorGPUImpl(                           \
+      const Eigen::GpuDevice& gpu_device, const int32 value_element_size,     \
+      const GpuDeviceArrayStruct<T>& default_value,                           \
+      const GpuDeviceArrayStruct<INDEX_TYPE>& output_index, const T* values, \
+      const int32 output_size, T* output);
+#define REGISTER_GPU(T)             \
+  REGISTER_GPU_INDEX_TYPE(T, int32) \
+  REGISTER_GPU_INDEX_TYPE(T, int64)
+
+TF_CALL_int32(REGISTER_GPU);
+TF_CALL_int64(REGISTER_GPU);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU);
+TF_CALL_COMPLEX_TYPES(REGISTER_GPU);
+
+#undef REGISTER_GPU
+#undef REGISTER_GPU_INDEX_TYPE
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 namespace {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 using ::std::vector;
@@ -430,6 +466,35 @@ void copy_array<Eigen::half, int32>(Eigen::half* dst, const Eigen::half* src,
   slow_copy_array(dst, src, size);
 }
 
+// Broadcasts the default value to the shape of an element of the output,
+// unless it is a scalar or already has that shape, in memory of type `attr`.
+template <typename VALUE_TYPE>
+Status BroadcastDefaultValue(OpKernelContext* context,
+                             const Tensor& default_value_tensor,
+                             const TensorShape& element_shape,
+                             AllocatorAttributes attr, Tensor* bcast_default) {
+  if (default_value_tensor.NumElements() == element_shape.num_elements() ||
+      default_value_tensor.NumElements() == 1) {
+    *bcast_default = default_value_tensor;
+    return Status::OK();
+  }
+  const auto& src_shape = default_value_tensor.shape();
+  BCast bcast(BCast::FromShape(src_shape), BCast::FromShape(element_shape),
+              /*fewer_dims_optimization=*/true);
+  // Note: bcast should always be valid, since we rejected any incompatible
+  // shapes when we called ValidateDefaultValueShape().
+  if (!bcast.IsValid()) {
+    return errors::InvalidArgument("Error broadcasting default_value");
+  }
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      default_value_tensor.dtype(), element_shape, bcast_default, attr));
+  const CPUDevice& device = context->eigen_device<CPUDevice>();
+  functor::BroadcastTo<CPUDevice, VALUE_TYPE>()(
+      device, context, *bcast_default, element_shape, default_value_tensor,
+      src_shape, bcast);
+  return Status::OK();
+}
+
 template <typename VALUE_TYPE, typename INDEX_TYPE>
 class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
  public:
@@ -458,27 +523,11 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
     // Broadcast the default value to value_element_size.  (We can skip this
     // if default_value_tensor.NumElements() == 1, since we use std::fill
     // when that's true.)
-    const VALUE_TYPE* default_value =
-        default_value_tensor.flat<VALUE_TYPE>().data();
-    Tensor bcast_default;  // Temporary tensor for result of broadcast
-    if (default_value_tensor.NumElements() != value_element_size &&
-        default_value_tensor.NumElements() != 1) {
-      const auto& src_shape = default_value_tensor.shape();
-      BCast bcast(BCast::FromShape(src_shape), BCast::FromShape(element_shape),
-                  /*fewer_dims_optimization=*/true);
-      // Note: bcast should always be valid, since we rejected any incompatible
-      // shapes when we called ValidateDefaultValueShape().
-      OP_REQUIRES(context, bcast.IsValid(),
-                  errors::InvalidArgument("Error broadcasting default_value"));
-      OP_REQUIRES_OK(context,
-                     context->allocate_temp(default_value_tensor.dtype(),
-                                            element_shape, &bcast_default));
-      const CPUDevice& device = context->eigen_device<CPUDevice>();
-      functor::BroadcastTo<CPUDevice, VALUE_TYPE>()(
-          device, context, bcast_default, element_shape, default_value_tensor,
-          src_shape, bcast);
-      default_value = bcast_default.flat<VALUE_TYPE>().data();
-    }
+    Tensor bcast_default;
+    OP_REQUIRES_OK(context, BroadcastDefaultValue<VALUE_TYPE>(
+                                context, default_value_tensor, element_shape,
+                                AllocatorAttributes(), &bcast_default));
+    const VALUE_TYPE* default_value = bcast_default.flat<VALUE_TYPE>().data();
 
     // Loop through the output_index vector, finding contiguous regions that
     // should be copied.  Once we find the end of a contiguous region, copy it
@@ -564,5 +613,96 @@ TF_CALL_qint16(REGISTER_CPU_KERNEL);
 
 #undef REGISTER_CPU_KERNEL
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+// The row partitions, which are small compared to the values, are read in
+// host memory to compute the output index of each value, like on CPU. The
+// values are then copied to the output on the device.
+template <typename VALUE_TYPE, typename INDEX_TYPE>
+class RaggedTensorToTensorGpuOp
+    : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
+ public:
+  explicit RaggedTensorToTensorGpuOp(OpKernelConstruction* context)
+      : RaggedTensorToTensorBaseOp<INDEX_TYPE>(context) {}
+
+  void SetOutput(OpKernelContext* context, int ragged_rank,
+                 const vector<INDEX_TYPE>& output_index,
+                 Tensor* output_tensor) override {
+    if (output_tensor->NumElements() == 0) return;
+
+    const auto& values_tensor = context->input(kValueInputIndex);
+    const auto& default_value_tensor = context->input(kDefaultValueInputIndex);
+    TensorShape element_shape = output_tensor->shape();
+    element_shape.RemoveDimRange(0, ragged_rank + 1);
+    const int64 value_element_size = element_shape.num_elements();
+    OP_REQUIRES(
+        context,
+        output_tensor->NumElements() < std::numeric_limits<int32>::max() &&
+            values_tensor.NumElements() < std::numeric_limits<int32>::max(),
+        errors::InvalidArgument(
+            "RaggedTensorToTensor on GPU supports less than 2^31 elements"));
+    OP_REQUIRES(context,
+                output_index.size() * value_element_size <=
+                    values_tensor.NumElements(),
+                errors::InvalidArgument(
+                    "The row partition tensors point past the values"));
+
+    // The default value is in host memory: it is broadcast there, and copied
+    // to the device with the output index.
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    Tensor bcast_default;
+    OP_REQUIRES_OK(context, BroadcastDefaultValue<VALUE_TYPE>(
+                                context, default_value_tensor, element_shape,
+                                host_attr, &bcast_default));
+    const auto& bcast_default_flat = bcast_default.flat<VALUE_TYPE>();
+    GpuDeviceArrayOnHost<VALUE_TYPE> default_value(context,
+                                                   bcast_default_flat.size());
+    OP_REQUIRES_OK(context, default_value.Init());
+    for (int i = 0; i < bcast_default_flat.size(); ++i) {
+      default_value.Set(i, bcast_default_flat(i));
+    }
+    OP_REQUIRES_OK(context, default_value.Finalize());
+
+    GpuDeviceArrayOnHost<INDEX_TYPE> output_index_on_gpu(context,
+                                                         output_index.size());
+    OP_REQUIRES_OK(context, output_index_on_gpu.Init());
+    for (int i = 0; i < output_index.size(); ++i) {
+      output_index_on_gpu.Set(i, output_index[i]);
+    }
+    OP_REQUIRES_OK(context, output_index_on_gpu.Finalize());
+
+    RaggedTensorToTensorGPUImpl<VALUE_TYPE, INDEX_TYPE>(
+        context->eigen_gpu_device(), value_element_size, default_value.data(),
+        output_index_on_gpu.data(), values_tensor.flat<VALUE_TYPE>().data(),
+        output_tensor->NumElements(), output_tensor->flat<VALUE_TYPE>().data());
+  }
+};
+
+#define REGISTER_GPU_KERNEL_INDEX_TYPE(value_type, index_type)       \
+  REGISTER_KERNEL_BUILDER(Name("RaggedTensorToTensor")               \
+                              .Device(DEVICE_GPU)                    \
+                              .TypeConstraint<value_type>("T")       \
+                              .TypeConstraint<index_type>("Tindex")  \
+                              .HostMemory("shape")                   \
+                              .HostMemory("default_value")           \
+                              .HostMemory("row_partition_tensors"),  \
+                          RaggedTensorToTensorGpuOp<value_type, index_type>);
+
+#define REGISTER_GPU_KERNEL(value_type)                          \
+  REGISTER_GPU_KERNEL_INDEX_TYPE(value_type, tensorflow::int64); \
+  REGISTER_GPU_KERNEL_INDEX_TYPE(value_type, tensorflow::int32);
+
+TF_CALL_int32(REGISTER_GPU_KERNEL);
+TF_CALL_int64(REGISTER_GPU_KERNEL);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_KERNEL);
+TF_CALL_COMPLEX_TYPES(REGISTER_GPU_KERNEL);
+
+#undef REGISTER_GPU_KERNEL
+#undef REGISTER_GPU_KERNEL_INDEX_TYPE
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/gpu_device_array_gpu.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+namespace {
+
+template <typename T>
+__global__ void FillWithDefaultValueKernel(
+    const int32 output_size, const int32 value_element_size,
+    GpuDeviceArrayStruct<T> default_value, T* __restrict__ output) {
+  const T* default_value_ptr = GetGpuDeviceArrayOnDevice(&default_value);
+  const bool broadcast = default_value.size == 1;
+  for (int i : GpuGridRangeX(output_size)) {
+    output[i] = default_value_ptr[broadcast ? 0 : i % value_element_size];
+  }
+}
+
+template <typename T, typename INDEX_TYPE>
+__global__ void ScatterValuesKernel(
+    const int32 values_size, const int32 value_element_size,
+    GpuDeviceArrayStruct<INDEX_TYPE> output_index,
+    const T* __restrict__ values, T* __restrict__ output) {
+  const INDEX_TYPE* output_index_ptr = GetGpuDeviceArrayOnDevice(&output_index);
+  for (int i : GpuGridRangeX(values_size)) {
+    const INDEX_TYPE element = output_index_ptr[i / value_element_size];
+    if (element >= 0) {
+      output[element * value_element_size + i % value_element_size] =
+          ldg(values + i);
+    }
+  }
+}
+
+}  // namespace
+
+template <typename VALUE_TYPE, typename INDEX_TYPE>
+void RaggedTensorToTensorGPUImpl(
+    const Eigen::GpuDevice& gpu_device, const int32 value_element_size,
+    const GpuDeviceArrayStruct<VALUE_TYPE>& default_value,
+    const GpuDeviceArrayStruct<INDEX_TYPE>& output_index,
+    const VALUE_TYPE* values, const int32 output_size, VALUE_TYPE* output) {
+  GpuLaunchConfig config = GetGpuLaunchConfig(output_size, gpu_device);
+  TF_CHECK_OK(GpuLaunchKernel(FillWithDefaultValueKernel<VALUE_TYPE>,
+                              config.block_count, config.thread_per_block, 0,
+                              gpu_device.stream(), output_size,
+                              value_element_size, default_value, output));
+
+  const int32 values_size = output_index.size * value_element_size;
+  if (values_size == 0) return;
+  config = GetGpuLaunchConfig(values_size, gpu_device);
+  TF_CHECK_OK(GpuLaunchKernel(ScatterValuesKernel<VALUE_TYPE, INDEX_TYPE>,
+                              config.block_count, config.thread_per_block, 0,
+                              gpu_device.stream(), values_size,
+                              value_element_size, output_index, values,
+                              output));
+}
+
+#define REGISTER_GPU_INDEX_TYPE(T, INDEX_TYPE)                                \
+  template void RaggedTensorToTensorGPUImpl(                                  \
+      const Eigen::GpuDevice& gpu_device, const int32 value_element_size,     \
+      const GpuDeviceArrayStruct<T>& default_value,                           \
+      const GpuDeviceArrayStruct<INDEX_TYPE>& output_index, const T* values, \
+      const int32 output_size, T* output);
+#define REGISTER_GPU(T)             \
+  REGISTER_GPU_INDEX_TYPE(T, int32) \
+  REGISTER_GPU_INDEX_TYPE(T, int64)
+
+TF_CALL_int32(REGISTER_GPU);
+TF_CALL_int64(REGISTER_GPU);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU);
+TF_CALL_COMPLEX_TYPES(REGISTER_GPU);
+
+#undef REGISTER_GPU
+#undef REGISTER_GPU_INDEX_TYPE
+
+}  // namespace tensorflow
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
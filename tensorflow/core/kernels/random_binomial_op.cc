@@ -418,6 +418,7 @@ class RandomBinomialOp : public OpKernel {
                     "For Philox algorithm, the size of state must be at least ",
                     PHILOX_MIN_STATE_SIZE, "; got ", var_tensor_flat.size()));
 
+    OP_REQUIRES_OK(ctx, EnsureVariableIsMutable(var.get()));
     OP_REQUIRES_OK(ctx, PrepareToUpdateVariable<Device, StateElementType>(
                             ctx, var_tensor, var->copy_on_read_mode.load()));
     auto var_data = var_tensor_flat.data();
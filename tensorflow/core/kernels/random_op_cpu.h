@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/random_op.h"
 #include "tensorflow/core/kernels/random_ops_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
@@ -86,12 +87,14 @@ struct FillPhiloxRandomTask<Distribution, false> {
     const int kGroupSize = Distribution::kResultElementCount;
 
     gen.Skip(start_group);
+    // Generates the Philox samples of 16 groups at a time, vectorized.
+    random::BatchedPhiloxRandom<16> batched_gen(gen);
     int64 offset = start_group * kGroupSize;
 
     // First fill all the full-size groups
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
     for (int64 index = start_group; index < limit_group_full; ++index) {
-      auto samples = dist(&gen);
+      auto samples = dist(&batched_gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
     }
@@ -99,7 +102,7 @@ struct FillPhiloxRandomTask<Distribution, false> {
     // If there are any remaining elements that need to be filled, process them
     if (limit_group_full < limit_group) {
       int64 remaining_size = size - limit_group_full * kGroupSize;
-      auto samples = dist(&gen);
+      auto samples = dist(&batched_gen);
       std::copy(&samples[0], &samples[0] + remaining_size, data + offset);
     }
   }
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/cpu_dispatch.h"
 #include "tensorflow/core/kernels/reduction_ops.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -273,6 +274,42 @@ template <typename Reducer>
 struct ReduceFunctor<CPUDevice, Reducer>
     : ReduceFunctorBase<CPUDevice, Reducer> {};
 
+// Full specialization for float sums, that uses the kernel of cpu_dispatch.h
+// for reductions of the innermost dimensions when the CPU has a better
+// instruction set than the one TensorFlow was built for.
+template <>
+struct ReduceFunctor<CPUDevice, Eigen::internal::SumReducer<float>>
+    : ReduceFunctorBase<CPUDevice, Eigen::internal::SumReducer<float>> {
+  typedef ReduceFunctorBase<CPUDevice, Eigen::internal::SumReducer<float>>
+      Base;
+
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static void Reduce(OpKernelContext* ctx, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes,
+                     const Eigen::internal::SumReducer<float>& reducer) {
+    const cpu_dispatch::Kernels* kernels = cpu_dispatch::GetKernels();
+    if (kernels == nullptr || out.size() == 0 || in.size() == 0 ||
+        !ReducesInnermostDims(reduction_axes, IN_T::NumDimensions)) {
+      Base::Reduce(ctx, out, in, reduction_axes, reducer);
+      return;
+    }
+    const int64 rows = out.size();
+    cpu_dispatch::RowSums(ctx->eigen_device<CPUDevice>(), *kernels, in.data(),
+                          rows, in.size() / rows, out.data());
+  }
+
+ private:
+  template <typename ReductionAxes>
+  static bool ReducesInnermostDims(const ReductionAxes& reduction_axes,
+                                   int rank) {
+    const int num_axes = Eigen::internal::array_size<ReductionAxes>::value;
+    for (int i = 0; i < num_axes; ++i) {
+      if (reduction_axes[i] != rank - num_axes + i) return false;
+    }
+    return true;
+  }
+};
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/regex_cache.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of regular expressions, and of sets, the global cache holds.
+constexpr int64 kGlobalCapacity = 256;
+
+}  // namespace
+
+template <typename T>
+std::shared_ptr<const T> RegexCache::LruMap<T>::Find(const string& key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) return nullptr;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+template <typename T>
+std::shared_ptr<const T> RegexCache::LruMap<T>::Insert(
+    const string& key, std::shared_ptr<const T> value, int64 capacity,
+    std::shared_ptr<const T>* evicted) {
+  std::shared_ptr<const T> existing = Find(key);
+  if (existing != nullptr) return existing;
+  entries_.emplace_front(key, std::move(value));
+  index_.emplace(key, entries_.begin());
+  if (static_cast<int64>(entries_.size()) > capacity) {
+    index_.erase(entries_.back().first);
+    *evicted = std::move(entries_.back().second);
+    entries_.pop_back();
+  }
+  return entries_.front().second;
+}
+
+RegexCache* RegexCache::Global() {
+  static RegexCache* cache = new RegexCache(kGlobalCapacity);
+  return cache;
+}
+
+Status RegexCache::Lookup(const string& pattern,
+                          std::shared_ptr<const RE2>* regex) {
+  {
+    mutex_lock l(mu_);
+    *regex = regexes_.Find(pattern);
+  }
+  if (*regex == nullptr) {
+    // Compiles the pattern without holding the lock.
+    auto compiled = std::make_shared<const RE2>(pattern);
+    std::shared_ptr<const RE2> evicted;
+    mutex_lock l(mu_);
+    *regex = regexes_.Insert(pattern, std::move(compiled), capacity_,
+                             &evicted);
+  }
+  if (!(*regex)->ok()) {
+    return errors::InvalidArgument("Invalid pattern: ", pattern,
+                                   ", error: ", (*regex)->error());
+  }
+  return Status::OK();
+}
+
+Status RegexCache::LookupSet(const std::vector<string>& patterns,
+                             RE2::Anchor anchor,
+                             std::shared_ptr<const RE2::Set>* set) {
+  // The patterns are prefixed by their lengths, so that different lists of
+  // patterns have different keys.
+  string key = strings::StrCat(static_cast<int>(anchor));
+  for (const string& pattern : patterns) {
+    strings::StrAppend(&key, ":", pattern.size(), ":", pattern);
+  }
+  {
+    mutex_lock l(mu_);
+    *set = sets_.Find(key);
+  }
+  if (*set != nullptr) return Status::OK();
+
+  // Compiles the set without holding the lock. Invalid sets are not cached.
+  auto compiled = std::make_shared<RE2::Set>(RE2::DefaultOptions, anchor);
+  for (const string& pattern : patterns) {
+    string error;
+    if (compiled->Add(pattern, &error) < 0) {
+      return errors::InvalidArgument("Invalid pattern: ", pattern,
+                                     ", error: ", error);
+    }
+  }
+  if (!compiled->Compile()) {
+    return errors::ResourceExhausted(
+        "Out of memory compiling a set of ", patterns.size(), " patterns");
+  }
+  std::shared_ptr<const RE2::Set> evicted;
+  mutex_lock l(mu_);
+  *set = sets_.Insert(key, std::move(compiled), capacity_, &evicted);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_REGEX_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_REGEX_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "re2/re2.h"
+#include "re2/set.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A cache of compiled regular expressions, keyed by their patterns, which
+// kernels taking their patterns as tensors share. The least recently used
+// entries are evicted once the cache holds `capacity` regular expressions
+// and `capacity` sets.
+//
+// This class is thread-safe.
+class RegexCache {
+ public:
+  explicit RegexCache(int64 capacity) : capacity_(capacity) {}
+
+  // Returns the cache shared by all kernels.
+  static RegexCache* Global();
+
+  // Returns `pattern` compiled, or an InvalidArgument error if it is not a
+  // valid regular expression.
+  Status Lookup(const string& pattern, std::shared_ptr<const RE2>* regex);
+
+  // Returns `patterns` compiled into a set which matches them all in one
+  // pass over a string, or an InvalidArgument error if one of them is not a
+  // valid regular expression. Pattern i is reported as match i.
+  Status LookupSet(const std::vector<string>& patterns, RE2::Anchor anchor,
+                   std::shared_ptr<const RE2::Set>* set);
+
+ private:
+  template <typename T>
+  class LruMap {
+   public:
+    // Returns the value of `key` and marks it as the most recently used, or
+    // nullptr if it is not in the map.
+    std::shared_ptr<const T> Find(const string& key);
+
+    // Inserts `value` as the value of `key`, unless another thread inserted
+    // one first, and returns the value of `key`. The least recently used
+    // value is moved to `evicted` if the map holds more than `capacity`
+    // values, so that it can be destroyed outside of the lock.
+    std::shared_ptr<const T> Insert(const string& key,
+                                    std::shared_ptr<const T> value,
+                                    int64 capacity,
+                                    std::shared_ptr<const T>* evicted);
+
+   private:
+    typedef std::list<std::pair<string, std::shared_ptr<const T>>> List;
+    // The entries, from the most to the least recently used.
+    List entries_;
+    std::unordered_map<string, typename List::iterator> index_;
+  };
+
+  const int64 capacity_;
+  mutex mu_;
+  LruMap<RE2> regexes_ TF_GUARDED_BY(mu_);
+  LruMap<RE2::Set> sets_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RegexCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_REGEX_CACHE_H_
@@ -18,10 +18,9 @@ limitations under the License.
 #include "re2/re2.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/regex_cache.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/platform/mutex.h"
-#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -43,10 +42,8 @@ class RegexFullMatchOp : public OpKernel {
                 errors::InvalidArgument("Pattern must be scalar, but received ",
                                         pattern_tensor->shape().DebugString()));
     const string pattern = pattern_tensor->flat<tstring>()(0);
-    std::shared_ptr<RE2> regex = CachedRE2(pattern);
-    OP_REQUIRES(ctx, regex->ok(),
-                errors::InvalidArgument("Invalid pattern: ", pattern,
-                                        ", error: ", regex->error()));
+    std::shared_ptr<const RE2> regex;
+    OP_REQUIRES_OK(ctx, RegexCache::Global()->Lookup(pattern, &regex));
 
     Tensor* output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
@@ -58,27 +55,6 @@ class RegexFullMatchOp : public OpKernel {
   }
 
  private:
-  std::shared_ptr<RE2> CachedRE2(const string& pattern) {
-    {
-      tf_shared_lock l(mu_);
-      if (regex_ != nullptr && regex_->pattern() == pattern) {
-        return regex_;
-      }
-    }
-    // Construct the new RE2 object before acquiring the lock.
-    auto regex = std::make_shared<RE2>(pattern);
-    {
-      mutex_lock l(mu_);
-      // Swap instead of assigning so that we destruct the old
-      // RE2 object (when necessary) after releasing the lock.
-      regex_.swap(regex);
-      return regex_;
-    }
-  }
-
-  mutex mu_;
-  std::shared_ptr<RE2> regex_ TF_GUARDED_BY(mu_);
-
   TF_DISALLOW_COPY_AND_ASSIGN(RegexFullMatchOp);
 };
 
@@ -0,0 +1,108 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "re2/re2.h"
+#include "re2/set.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/regex_cache.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The rough number of cycles the DFA of a set spends per input byte.
+constexpr int64 kCostPerByte = 20;
+
+}  // namespace
+
+// Matches every string of `input` against all of `patterns` at once, with an
+// RE2::Set, which runs a single DFA for all of the patterns.
+class RegexSetMatchOp : public OpKernel {
+ public:
+  explicit RegexSetMatchOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    bool full_match;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("full_match", &full_match));
+    anchor_ = full_match ? RE2::ANCHOR_BOTH : RE2::UNANCHORED;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor* input_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("input", &input_tensor));
+    const auto& input_flat = input_tensor->flat<tstring>();
+
+    const Tensor* patterns_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("patterns", &patterns_tensor));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(patterns_tensor->shape()),
+                errors::InvalidArgument(
+                    "Patterns must be a vector, but received ",
+                    patterns_tensor->shape().DebugString()));
+    const auto& patterns_flat = patterns_tensor->vec<tstring>();
+    const int64 num_patterns = patterns_flat.size();
+
+    TensorShape output_shape = input_tensor->shape();
+    output_shape.AddDim(num_patterns);
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output("output", output_shape, &output_tensor));
+    auto output = output_tensor->flat_inner_dims<bool>();
+    output.setConstant(false);
+    if (num_patterns == 0) return;
+
+    std::vector<string> patterns(num_patterns);
+    for (int64 i = 0; i < num_patterns; ++i) {
+      patterns[i] = patterns_flat(i);
+    }
+    std::shared_ptr<const RE2::Set> set;
+    OP_REQUIRES_OK(ctx,
+                   RegexCache::Global()->LookupSet(patterns, anchor_, &set));
+    if (input_flat.size() == 0) return;
+
+    int64 total_bytes = 0;
+    for (int64 i = 0; i < input_flat.size(); ++i) {
+      total_bytes += input_flat(i).size();
+    }
+    const int64 cost_per_string =
+        kCostPerByte * std::max<int64>(1, total_bytes / input_flat.size());
+    auto match = [&](int64 begin, int64 end) {
+      std::vector<int> matches;
+      for (int64 i = begin; i < end; ++i) {
+        if (!set->Match(input_flat(i), &matches)) continue;
+        for (int m : matches) output(i, m) = true;
+      }
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), cost_per_string, match);
+  }
+
+ private:
+  RE2::Anchor anchor_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RegexSetMatchOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("RegexSetMatch").Device(DEVICE_CPU),
+                        RegexSetMatchOp);
+
+}  // namespace tensorflow
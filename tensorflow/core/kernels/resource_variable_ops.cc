@@ -393,18 +393,25 @@ class AssignVariableOp : public OpKernel {
                                   (*ptr)->is_initialized = true;
                                   return Status::OK();
                                 }));
+    // In copy-on-read mode sparse updates write to the variable's buffer in
+    // place, so it must not be shared with `value`. If we are the last user
+    // of `value` we can nevertheless adopt its buffer instead of copying it.
+    AllocatorAttributes attr;
+    attr.set_gpu_compatible(true);
+    attr.set_nic_compatible(true);
+    std::unique_ptr<Tensor> input_alias = context->forward_input(
+        1, OpKernelContext::Params::kNoReservation /*output_index*/, dtype_,
+        value.shape(), DEVICE_MEMORY, attr);
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, EnsureVariableIsMutable(variable.get()));
     OP_REQUIRES(context, variable->tensor()->dtype() == dtype_,
                 errors::InvalidArgument(
                     "Trying to assign variable with wrong dtype. Expected ",
                     DataTypeString(variable->tensor()->dtype()), " got ",
                     DataTypeString(dtype_)));
-    if (variable->copy_on_read_mode.load()) {
+    if (variable->copy_on_read_mode.load() && input_alias == nullptr) {
       PersistentTensor unused;
       Tensor* tmp;
-      AllocatorAttributes attr;
-      attr.set_gpu_compatible(true);
-      attr.set_nic_compatible(true);
       OP_REQUIRES_OK(context,
                      context->allocate_persistent(value.dtype(), value.shape(),
                                                   &unused, &tmp, attr));
@@ -463,6 +470,7 @@ class AssignVariableOp<Device, Variant> : public OpKernel {
         attr);
 
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, EnsureVariableIsMutable(variable.get()));
     OP_REQUIRES(context, variable->tensor()->dtype() == DT_VARIANT,
                 errors::InvalidArgument(
                     "Trying to assign variable with wrong dtype. Expected ",
@@ -540,6 +548,7 @@ class AssignUpdateVariableOp : public OpKernel {
     // PrepareToUpdateVariable() for commutative operations like Op ==
     // ADD if value's refcount was 1.
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, EnsureVariableIsMutable(variable.get()));
     Tensor* var_tensor = variable->tensor();
     OP_REQUIRES(context, var_tensor->shape().IsSameSize(value.shape()),
                 errors::InvalidArgument("Cannot update variable with shape ",
@@ -620,6 +629,34 @@ REGISTER_KERNEL_BUILDER(Name("VarIsInitializedOp")
                         IsResourceInitialized<Var>);
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+class FreezeVariableOp : public OpKernel {
+ public:
+  explicit FreezeVariableOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* context) override {
+    core::RefCountPtr<Var> variable;
+    OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
+                                           &variable));
+    mutex_lock ml(*variable->mu());
+    OP_REQUIRES(context, variable->is_initialized,
+                errors::FailedPrecondition(
+                    "Trying to freeze an uninitialized resource variable"));
+    // Nothing can write to the buffer of a frozen variable anymore, so reads
+    // may alias it again even if it was in copy-on-read mode.
+    variable->copy_on_read_mode.store(false);
+    variable->frozen.store(true);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("_FreezeVariableOp").Device(DEVICE_CPU),
+                        FreezeVariableOp);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+REGISTER_KERNEL_BUILDER(
+    Name("_FreezeVariableOp").Device(DEVICE_GPU).HostMemory("resource"),
+    FreezeVariableOp);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 template <typename Device, typename T, typename Index>
 class ResourceGatherOp : public OpKernel {
  public:
@@ -630,7 +667,9 @@ class ResourceGatherOp : public OpKernel {
   void Compute(OpKernelContext* c) override {
     core::RefCountPtr<Var> v;
     OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
-    OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
+    if (!v->frozen.load()) {
+      OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
+    }
     // NOTE: We hold the lock for the whole gather operation instead
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
@@ -796,7 +835,9 @@ class ResourceGatherNdOp : public OpKernel {
   void Compute(OpKernelContext* c) override {
     core::RefCountPtr<Var> v;
     OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
-    OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
+    if (!v->frozen.load()) {
+      OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
+    }
     // NOTE: We hold the lock for the whole gather operation instead
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
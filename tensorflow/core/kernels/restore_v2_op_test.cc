@@ -26,14 +26,17 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -356,5 +359,46 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+TEST_F(RestoreV2OpTest, RestoreFromMultipleShards) {
+  // Writes a bundle with 3 data shards of 4 tensors each.
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_sharded");
+  const int kNumShards = 3;
+  const int kTensorsPerShard = 4;
+  std::vector<tstring> shard_prefixes;
+  std::vector<tstring> tensor_names;
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    shard_prefixes.push_back(strings::StrCat(prefix, "_part_", shard));
+    BundleWriter writer(Env::Default(), shard_prefixes.back());
+    for (int i = 0; i < kTensorsPerShard; ++i) {
+      tensor_names.push_back(strings::StrCat("tensor_", shard, "_", i));
+      TF_ASSERT_OK(writer.Add(tensor_names.back(),
+                              test::AsTensor<int32>({shard, i, 10})));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(Env::Default(), shard_prefixes, prefix));
+
+  const int num_tensors = tensor_names.size();
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Attr("dtypes", DataTypeVector(num_tensors, DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  AddInputFromArray<tstring>(TensorShape({num_tensors}), tensor_names);
+  AddInputFromArray<tstring>(TensorShape({num_tensors}),
+                             std::vector<tstring>(num_tensors, ""));
+  TF_ASSERT_OK(RunOpKernel());
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    for (int i = 0; i < kTensorsPerShard; ++i) {
+      test::ExpectTensorEqual<int32>(
+          test::AsTensor<int32>({shard, i, 10}),
+          *GetOutput(shard * kTensorsPerShard + i));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
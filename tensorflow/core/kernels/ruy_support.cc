@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/ruy_support.h"
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/logging.h"
+
+// Android builds use gemmlowp/meta on Arm and don't link ruy.
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__)) && \
+    !defined(TENSORFLOW_DISABLE_RUY) && !defined(__ANDROID__)
+#define TENSORFLOW_USE_RUY (1)
+#endif
+
+#ifdef TENSORFLOW_USE_RUY
+#include <memory>
+
+#include "ruy/context.h"  // from @ruy
+#include "ruy/matrix.h"  // from @ruy
+#include "ruy/mul_params.h"  // from @ruy
+#include "ruy/ruy.h"  // from @ruy
+#endif
+
+namespace tensorflow {
+namespace ruy_support {
+
+namespace {
+
+bool g_enabled = true;
+
+#ifdef TENSORFLOW_USE_RUY
+
+// A ruy::Context must not be used by two multiplications at once, and holds
+// the packed matrix caches and worker threads of the multiplications run on it,
+// so every thread running quantized kernels gets its own.
+ruy::Context* GetContext(OpKernelContext* tf_context) {
+  static thread_local std::unique_ptr<ruy::Context> context;
+  if (!context) {
+    context.reset(new ruy::Context);
+  }
+  context->set_max_num_threads(
+      tf_context->device()->tensorflow_cpu_worker_threads()->num_threads);
+  return context.get();
+}
+
+void MakeMatrix(int rows, int cols, bool column_major, int stride,
+                const quint8* data, int offset, ruy::Matrix<uint8>* matrix) {
+  ruy::MakeSimpleLayout(
+      rows, cols, column_major ? ruy::Order::kColMajor : ruy::Order::kRowMajor,
+      matrix->mutable_layout());
+  matrix->mutable_layout()->set_stride(stride);
+  matrix->set_data(&data->value);
+  matrix->set_zero_point(static_cast<uint8>(-offset));
+}
+
+#endif  // TENSORFLOW_USE_RUY
+
+}  // namespace
+
+void SetEnabled(bool enabled) { g_enabled = enabled; }
+
+bool IsSupportedAndEnabled() {
+#ifdef TENSORFLOW_USE_RUY
+  return g_enabled;
+#else
+  return false;
+#endif
+}
+
+bool CanUseOffsets(int offset_a, int offset_b) {
+  return offset_a >= -255 && offset_a <= 0 && offset_b >= -255 &&
+         offset_b <= 0;
+}
+
+void QuantizedGemm(OpKernelContext* tf_context, bool transpose_a,
+                   bool transpose_b, const quint8* a_data, const quint8* b_data,
+                   qint32* c_data, int m, int n, int k, int offset_a,
+                   int offset_b, int lda, int ldb, int ldc) {
+#ifdef TENSORFLOW_USE_RUY
+  DCHECK(CanUseOffsets(offset_a, offset_b));
+  ruy::Matrix<uint8> lhs;
+  MakeMatrix(m, k, transpose_a, lda, a_data, offset_a, &lhs);
+  ruy::Matrix<uint8> rhs;
+  MakeMatrix(k, n, transpose_b, ldb, b_data, offset_b, &rhs);
+  ruy::Matrix<int32> dst;
+  ruy::MakeSimpleLayout(m, n, ruy::Order::kRowMajor, dst.mutable_layout());
+  dst.mutable_layout()->set_stride(ldc);
+  dst.set_data(&c_data->value);
+
+  // With an int32 destination ruy returns the raw accumulators, without any
+  // multiplier, bias or clamping.
+  ruy::MulParams<int32, int32> mul_params;
+  ruy::Mul(lhs, rhs, mul_params, GetContext(tf_context), &dst);
+#else
+  LOG(FATAL) << "QuantizedGemm: Ruy not supported.";
+#endif
+}
+
+}  // namespace ruy_support
+}  // namespace tensorflow
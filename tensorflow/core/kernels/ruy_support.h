@@ -0,0 +1,63 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
+#define TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
+
+#include "tensorflow/core/framework/numeric_types.h"
+
+namespace tensorflow {
+
+class OpKernelContext;
+
+namespace ruy_support {
+
+// Ruy is the matrix multiplication library used by TensorFlow Lite. Its 8-bit
+// kernels select at runtime between AVX-512 VNNI, AVX-512 and AVX2 on x86, and
+// between the dot product and plain NEON instructions on Arm, so the quantized
+// kernels use it in preference to gemmlowp where it is supported.
+
+// Toggles the codepath. Enabled by default (true) on supported platforms.
+void SetEnabled(bool enabled);
+
+// Returns true if the codepath is supported and is enabled. Use this call
+// before calling QuantizedGemm. If the codepath is not supported and
+// QuantizedGemm is called, the library will log a FATAL error.
+bool IsSupportedAndEnabled();
+
+// Returns true if QuantizedGemm can take offsets offset_a and offset_b. Ruy
+// represents offsets as uint8 zero points, so they must be in [-255, 0].
+bool CanUseOffsets(int offset_a, int offset_b);
+
+// Calculates the quantized matrix multiplication, with the same semantics as
+// meta::QuantizedGemm:
+//
+// for (i, j) in [0, m) x [0, n) do
+//   c_data[i, j] :=
+//     sum((a_data[i, l] + offset_a) * (b_data[l, j] + offset_b)) : l in [0, k)
+//
+// If transpose_a is false the lhs operand has row major layout, otherwise
+// column major. Similarly transpose_b describes the layout of the rhs operand.
+// lda, ldb, and ldc are the strides of the lhs operand, rhs operand and the
+// row major result arrays.
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int offset_a, int offset_b, int lda,
+                   int ldb, int ldc);
+
+}  // namespace ruy_support
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
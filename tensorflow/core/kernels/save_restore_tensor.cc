@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <map>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -274,7 +275,14 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    Tensor memmapped_tensor;
+    if (shape_and_slice.empty() && IsMemmappedBundle(reader_prefix)) {
+      // Back the full tensor with the data file, if possible.
+      TF_RETURN_IF_ERROR(
+          reader->LookupMemmapped(tensor_name, &memmapped_tensor));
+      context->set_output(idx, memmapped_tensor);
+      restored_tensor = &memmapped_tensor;
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -352,20 +360,29 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
   std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
   std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
+  std::vector<std::unique_ptr<RestoreOp> > shard_restore_ops;
 
   BundleReader default_reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(default_reader.status());
 
-  std::vector<string> mismatched_errors;
+  // Looks up all the keys at once, so that every index block is read once.
+  std::vector<StringPiece> sorted_names;
+  sorted_names.reserve(sorted_name_idx.size());
   for (const size_t i : sorted_name_idx) {
-    TensorShape restored_full_shape;
-    DataType original_dtype;
-    const string& tensor_name = tensor_names_flat(i);
-    TF_RETURN_IF_ERROR(default_reader.LookupDtypeAndShape(
-        tensor_name, &original_dtype, &restored_full_shape));
+    sorted_names.emplace_back(tensor_names_flat(i));
+  }
+  std::vector<DataType> original_dtypes;
+  std::vector<TensorShape> restored_full_shapes;
+  TF_RETURN_IF_ERROR(default_reader.LookupDtypesAndShapes(
+      sorted_names, &original_dtypes, &restored_full_shapes));
+
+  std::vector<string> mismatched_errors;
+  for (size_t j = 0; j < sorted_name_idx.size(); ++j) {
+    const size_t i = sorted_name_idx[j];
+    const DataType original_dtype = original_dtypes[j];
     if (dtypes[i] != original_dtype) {
       string error_msg = strings::StrCat(
-          "tensor_name = ", tensor_name, "; expected dtype ",
+          "tensor_name = ", sorted_names[j], "; expected dtype ",
           DataTypeString(dtypes[i]), " does not equal original dtype ",
           DataTypeString(original_dtype));
       mismatched_errors.emplace_back(error_msg);
@@ -376,28 +393,62 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  // If the bundle has several data shards, the small tensors of each shard
+  // are restored in the thread pool as well, one shard per thread and in file
+  // order, so that the shards are read in parallel.
+  // Mapping the tensors of a read-only bundle reads nothing, so they are all
+  // mapped from the op thread, through the mappings of its reader.
+  const bool memmapped = IsMemmappedBundle(prefix_string);
+  const bool restore_shards_in_pool =
+      !memmapped && default_reader.num_shards() > 1;
+  std::map<int32, std::vector<std::pair<int64, RestoreOp*> > > shard_ops;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
     auto op =
         new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
-    if (op->should_run_in_pool(&default_reader)) {
+    if (!memmapped && op->should_run_in_pool(&default_reader)) {
       pool_restore_ops.emplace_back(op);
+      continue;
+    }
+    int32 shard_id = -1;
+    int64 offset = -1;
+    if (restore_shards_in_pool) {
+      // Ignore status here; we'll catch the error later.
+      default_reader.LookupDataLocation(tensor_name, &shard_id, &offset)
+          .IgnoreError();
+    }
+    if (shard_id >= 0) {
+      shard_restore_ops.emplace_back(op);
+      shard_ops[shard_id].emplace_back(offset, op);
     } else {
       direct_restore_ops.emplace_back(op);
     }
   }
+  for (auto& shard : shard_ops) {
+    std::sort(shard.second.begin(), shard.second.end());
+  }
 
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
     std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
+    if (!pool_restore_ops.empty() || !shard_ops.empty()) {
       reader_pool.reset(
           new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
       for (auto& op : pool_restore_ops) {
         reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
       }
+      for (auto& shard : shard_ops) {
+        reader_pool->Schedule([&shard, &prefix_string]() {
+          BundleReader reader(Env::Default(), prefix_string);
+          for (auto& offset_and_op : shard.second) {
+            RestoreOp* op = offset_and_op.second;
+            op->status =
+                reader.status().ok() ? op->run(&reader) : reader.status();
+          }
+        });
+      }
     }
 
     // Read small tensors from the op thread
@@ -410,6 +461,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto& op : pool_restore_ops) {
     TF_RETURN_IF_ERROR(op->status);
   }
+  for (auto& op : shard_restore_ops) {
+    TF_RETURN_IF_ERROR(op->status);
+  }
 
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 
@@ -160,6 +162,73 @@ class SaveV2 : public OpKernel {
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+// Snapshots a list of named tensors and saves them using the tensor bundle
+// library on a background thread.  The snapshot shares the tensor buffers
+// unless "deep_copy" is set.
+class AsyncSaveV2 : public OpKernel {
+ public:
+  explicit AsyncSaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("deep_copy", &deep_copy_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    const Tensor& shape_and_slices = context->input(2);
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+    const int num_tensors = static_cast<int>(tensor_names.NumElements());
+    const string& prefix_string = prefix.scalar<tstring>()();
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+    const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
+
+    std::vector<AsyncCheckpointWriter::Entry> entries(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      AsyncCheckpointWriter::Entry& entry = entries[i];
+      entry.key = tensor_names_flat(i);
+      const Tensor& tensor = context->input(i + kFixedInputs);
+      if (!shape_and_slices_flat(i).empty()) {
+        const string& shape_spec = shape_and_slices_flat(i);
+        TensorShape slice_shape;
+        entry.slice = TensorSlice(tensor.dims());
+        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
+                                    shape_spec, &entry.full_shape,
+                                    &entry.slice, &slice_shape));
+        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
+                    errors::InvalidArgument("Slice in shape_and_slice "
+                                            "specification does not match the "
+                                            "shape of the tensor to save: ",
+                                            shape_spec, ", tensor: ",
+                                            tensor.shape().DebugString()));
+        entry.is_slice = true;
+      }
+      entry.tensor = deep_copy_ ? tensor::DeepCopy(tensor) : tensor;
+    }
+    VLOG(1) << "Queueing asynchronous save, prefix_string: " << prefix_string;
+    AsyncCheckpointWriter::Global()->Save(prefix_string, std::move(entries));
+  }
+
+ private:
+  bool deep_copy_;
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaveV2").Device(DEVICE_CPU), AsyncSaveV2);
+
+// Waits for all the saves queued by AsyncSaveV2 to complete.
+class AsyncSaveV2Wait : public OpKernel {
+ public:
+  explicit AsyncSaveV2Wait(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    OP_REQUIRES_OK(context, AsyncCheckpointWriter::Global()->Wait());
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaveV2Wait").Device(DEVICE_CPU),
+                        AsyncSaveV2Wait);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
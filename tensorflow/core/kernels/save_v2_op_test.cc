@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -340,5 +341,53 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class AsyncSaveV2OpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "AsyncSaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_INT32}))  // tensors
+                     .Attr("deep_copy", true)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(AsyncSaveV2OpTest, SavesSnapshot) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async");
+  MakeOp();
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  AddInputFromArray<tstring>(TensorShape({2}), {"tensor_float", "tensor_int"});
+  AddInputFromArray<tstring>(TensorShape({2}), {"", "4 0,2"});
+  AddInput<float>(TensorShape({2, 4}),
+                  [](int x) -> float { return static_cast<float>(x) / 10; });
+  AddInput<int32>(TensorShape({2}), [](int x) -> int32 { return x + 1; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Updates made after the op returns are not saved.
+  mutable_input(3).tensor->flat<float>().setZero();
+  mutable_input(4).tensor->flat<int32>().setZero();
+  TF_ASSERT_OK(AsyncCheckpointWriter::Global()->Wait());
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_float", &val));
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(static_cast<float>(i) / 10, val.flat<float>()(i));
+  }
+  TensorShape shape;
+  TF_ASSERT_OK(reader.LookupTensorShape("tensor_int", &shape));
+  EXPECT_EQ(TensorShape({4}), shape);
+  TensorSlice slice;
+  TF_ASSERT_OK(TensorSlice::Parse("0,2", &slice));
+  Tensor part(DT_INT32, TensorShape({2}));
+  TF_ASSERT_OK(reader.LookupSlice("tensor_int", slice, &part));
+  EXPECT_EQ(1, part.flat<int32>()(0));
+  EXPECT_EQ(2, part.flat<int32>()(1));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -54,6 +54,23 @@ struct SegmentSumFunctor {
                   typename TTypes<T, 2>::Tensor output);
 };
 
+// Functor for SparseSegmentReductionGPUOp.
+// is_mean, is_sqrtn: whether to divide each output row by the number, or the
+//                square root of the number, of rows in its segment.
+// default_value: value of the output rows of empty segments.
+// data: input data reshaped to {data_rows, data.size/data_rows}.
+// indices: rows of 'data' to reduce.
+// segment_ids: sorted map from 'indices' to output segment ids.
+// output: output reshaped to {output_rows, output.size/output_rows}
+template <typename T, typename Index, typename SegmentId>
+struct SparseSegmentReductionFunctor {
+  void operator()(const GPUDevice& d, bool is_mean, bool is_sqrtn,
+                  T default_value, typename TTypes<T, 2>::ConstTensor data,
+                  typename TTypes<Index>::ConstVec indices,
+                  typename TTypes<SegmentId>::ConstVec segment_ids,
+                  typename TTypes<T, 2>::Tensor output);
+};
+
 #endif
 
 template <typename Device, typename T, typename Index, typename InitialValueF,
@@ -124,6 +124,65 @@ __global__ void UnsortedSegmentCustomKernel(
   }
 }
 
+// Half precision sums are accumulated in float.
+template <typename T>
+struct SparseSegmentAccumulator {
+  using type = T;
+};
+
+template <>
+struct SparseSegmentAccumulator<Eigen::half> {
+  using type = float;
+};
+
+// SparseSegmentReductionKernel gathers and reduces the rows of each segment in
+// one pass. Every output row is computed by one warp, whose lanes stride over
+// its columns so that the rows gathered from 'data' are read coalesced. The
+// rows of a segment are found by binary search in the sorted 'segment_ids'.
+// Out of range indices are skipped.
+template <typename T, typename Index, typename SegmentId>
+__global__ void SparseSegmentReductionKernel(
+    const bool is_mean, const bool is_sqrtn, const T default_value,
+    const int64 data_rows, const int64 num_cols, const T* __restrict__ data,
+    const int64 num_indices, const Index* __restrict__ indices,
+    const SegmentId* __restrict__ segment_ids, const int64 output_rows,
+    T* __restrict__ output) {
+  using Accumulator = typename SparseSegmentAccumulator<T>::type;
+  for (int64 thread_index : GpuGridRangeX(output_rows * TF_RED_WARPSIZE)) {
+    const int64 segment = thread_index / TF_RED_WARPSIZE;
+    const int64 lane = thread_index % TF_RED_WARPSIZE;
+    const int64 begin = gpu_helper::lower_bound<SegmentId, int64>(
+        segment_ids, num_indices, static_cast<SegmentId>(segment));
+    const int64 end =
+        begin + gpu_helper::lower_bound<SegmentId, int64>(
+                    segment_ids + begin, num_indices - begin,
+                    static_cast<SegmentId>(segment + 1));
+    T* out = output + segment * num_cols;
+    if (begin == end) {
+      for (int64 col = lane; col < num_cols; col += TF_RED_WARPSIZE) {
+        out[col] = default_value;
+      }
+      continue;
+    }
+    Accumulator scale(1);
+    if (is_mean) {
+      scale = Accumulator(1) / static_cast<Accumulator>(end - begin);
+    } else if (is_sqrtn) {
+      scale = Accumulator(1) / Eigen::numext::sqrt(
+                                   static_cast<Accumulator>(end - begin));
+    }
+    for (int64 col = lane; col < num_cols; col += TF_RED_WARPSIZE) {
+      Accumulator sum(0);
+      for (int64 i = begin; i < end; ++i) {
+        const int64 row = ldg(indices + i);
+        if (row < 0 || row >= data_rows) continue;
+        sum += static_cast<Accumulator>(ldg(data + row * num_cols + col));
+      }
+      out[col] = static_cast<T>(sum * scale);
+    }
+  }
+}
+
 namespace functor {
 
 template <typename T, typename Index>
@@ -207,6 +266,27 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
   }
 };
 
+template <typename T, typename Index, typename SegmentId>
+void SparseSegmentReductionFunctor<T, Index, SegmentId>::operator()(
+    const GPUDevice& d, bool is_mean, bool is_sqrtn, T default_value,
+    typename TTypes<T, 2>::ConstTensor data,
+    typename TTypes<Index>::ConstVec indices,
+    typename TTypes<SegmentId>::ConstVec segment_ids,
+    typename TTypes<T, 2>::Tensor output) {
+  if (output.size() == 0) {
+    return;
+  }
+  const int64 output_rows = output.dimension(0);
+  GpuLaunchConfig config =
+      GetGpuLaunchConfig(output_rows * TF_RED_WARPSIZE, d);
+  TF_CHECK_OK(GpuLaunchKernel(
+      SparseSegmentReductionKernel<T, Index, SegmentId>, config.block_count,
+      config.thread_per_block, 0, d.stream(), is_mean, is_sqrtn,
+      default_value, data.dimension(0), data.dimension(1), data.data(),
+      indices.size(), indices.data(), segment_ids.data(), output_rows,
+      output.data()));
+}
+
 #define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index) \
   template struct SegmentSumFunctor<T, Index>
 
@@ -247,12 +327,24 @@ TF_CALL_int32(DEFINE_SUM_GPU_SPECS);
 TF_CALL_COMPLEX_TYPES(DEFINE_SUM_GPU_SPECS);
 #endif
 
+#define DEFINE_SPARSE_GPU_SPECS_INDEX(T, Index)                \
+  template struct SparseSegmentReductionFunctor<T, Index, int32>; \
+  template struct SparseSegmentReductionFunctor<T, Index, int64>;
+
+#define DEFINE_SPARSE_GPU_SPECS(T)         \
+  DEFINE_SPARSE_GPU_SPECS_INDEX(T, int32); \
+  DEFINE_SPARSE_GPU_SPECS_INDEX(T, int64);
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_SPARSE_GPU_SPECS);
+
 #undef DEFINE_SORTED_GPU_SPECS_INDEX
 #undef DEFINE_SORTED_GPU_SPECS
 #undef DEFINE_REAL_UNSORTED_GPU_SPECS_INDEX
 #undef DEFINE_SUM_UNSORTED_GPU_SPECS_INDEX
 #undef DEFINE_REAL_GPU_SPECS
 #undef DEFINE_SUM_GPU_SPECS
+#undef DEFINE_SPARSE_GPU_SPECS_INDEX
+#undef DEFINE_SPARSE_GPU_SPECS
 
 }  // namespace functor
 }  // namespace tensorflow
@@ -826,6 +826,190 @@ class SparseSegmentReductionSumWithNumSegmentsOp
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+// GPU version of SparseSegmentReductionOpBase. The rows of 'input' selected by
+// 'indices' are gathered and reduced by the same kernel, without materializing
+// the gathered rows. Since the output shape depends on the last segment id
+// when 'num_segments' is not given, that id is first copied to the host.
+//
+// Unlike the CPU kernel, this kernel does not report unsorted segment ids,
+// whose results are undefined, and skips out of range indices.
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionGPUOpBase : public AsyncOpKernel {
+ public:
+  explicit SparseSegmentReductionGPUOpBase(OpKernelConstruction* context,
+                                           bool is_mean, bool is_sqrtn,
+                                           bool has_num_segments,
+                                           T default_value)
+      : AsyncOpKernel(context),
+        is_mean_(is_mean),
+        is_sqrtn_(is_sqrtn),
+        has_num_segments_(has_num_segments),
+        default_value_(default_value) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(indices.shape()),
+                      errors::InvalidArgument("indices should be a vector."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(segment_ids.shape()),
+        errors::InvalidArgument("segment_ids should be a vector."), done);
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES_ASYNC(context, num_indices == segment_ids.NumElements(),
+                      errors::InvalidArgument(
+                          "segment_ids and indices should have same size."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVectorOrHigher(input.shape()),
+        errors::InvalidArgument("input must be at least rank 1, got shape ",
+                                input.shape().DebugString()),
+        done);
+
+    if (has_num_segments_) {
+      const Tensor& num_segments = context->input(3);
+      OP_REQUIRES_ASYNC(
+          context, num_segments.shape().dims() == 0,
+          errors::InvalidArgument("num_segments should be a scalar, not shape ",
+                                  num_segments.shape().DebugString()),
+          done);
+      const int64 output_rows =
+          internal::SubtleMustCopy(num_segments.scalar<int32>()());
+      OP_REQUIRES_ASYNC(context, output_rows >= 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      ComputeWithOutputRows(context, output_rows);
+      done();
+      return;
+    }
+    if (num_indices == 0) {
+      ComputeWithOutputRows(context, 0);
+      done();
+      return;
+    }
+
+    se::DeviceMemoryBase last_segment_id_device(
+        const_cast<Tensor&>(segment_ids).template flat<SegmentId>().data() +
+        (num_indices - 1));
+    ScratchSpace<SegmentId> last_segment_id_host(context, 1,
+                                                 /* on_host */ true);
+    auto stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(last_segment_id_host.mutable_data(),
+                         last_segment_id_device, sizeof(SegmentId))
+            .ok(),
+        errors::Internal("SparseSegmentReductionGPUOp: failed to copy "
+                         "output_rows from device"),
+        done);
+
+    auto compute = [this, context, last_segment_id_host, done]() {
+      // Ensure that within the callback, the proper GPU settings are
+      // configured.
+      auto stream = context->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{stream->parent()};
+
+      const int64 output_rows = *last_segment_id_host.data() + 1;
+      OP_REQUIRES_ASYNC(context, output_rows > 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      ComputeWithOutputRows(context, output_rows);
+      done();
+    };
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, compute);
+  }
+
+ private:
+  void ComputeWithOutputRows(OpKernelContext* context, int64 output_rows) {
+    const Tensor& input = context->input(0);
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    functor::SparseSegmentReductionFunctor<T, Index, SegmentId>()(
+        context->eigen_device<GPUDevice>(), is_mean_, is_sqrtn_,
+        default_value_, input.flat_outer_dims<T>(),
+        context->input(1).vec<Index>(), context->input(2).vec<SegmentId>(),
+        output->flat_outer_dims<T>());
+  }
+
+  const bool is_mean_;
+  const bool is_sqrtn_;
+  const bool has_num_segments_;
+  const T default_value_;
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionMeanGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionMeanGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, true /*is_mean*/, false /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionMeanWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionMeanWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, true /*is_mean*/, false /*is_sqrtn*/,
+            true /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionSqrtNGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSqrtNGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, false /*is_mean*/, true /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionSqrtNWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSqrtNWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, false /*is_mean*/, true /*is_sqrtn*/,
+            true /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionSumGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSumGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, false /*is_mean*/, false /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+template <class T, typename Index, typename SegmentId>
+class SparseSegmentReductionSumWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSumWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, false /*is_mean*/, false /*is_sqrtn*/,
+            true /* has_num_segments */, T(0) /* default_value */) {}
+};
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 // Implements the common logic for the gradients of SparseSegmentReduction
 // kernels.
 //
@@ -100,11 +100,9 @@ void SendOp::Compute(OpKernelContext* ctx) {
     return;
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
-    GetRendezvousKey(key_prefix_, frame_iter, &in_loop_parsed.buf_);
+    Rendezvous::ReplaceFrameAndIter(parsed_key_, frame_iter, &in_loop_parsed);
     VLOG(2) << "Send " << in_loop_parsed.buf_ << " using "
             << reinterpret_cast<uintptr_t>(ctx->rendezvous());
-    OP_REQUIRES_OK(ctx,
-                   Rendezvous::ParseKey(in_loop_parsed.buf_, &in_loop_parsed));
 
     ctx->SetStatus(ctx->rendezvous()->Send(in_loop_parsed, args, ctx->input(0),
                                            ctx->is_input_dead()));
@@ -206,11 +204,9 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
                                  make_recv_callback(ctx, std::move(done)));
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
-    GetRendezvousKey(key_prefix_, frame_iter, &in_loop_parsed.buf_);
+    Rendezvous::ReplaceFrameAndIter(parsed_key_, frame_iter, &in_loop_parsed);
     VLOG(2) << "Recv " << in_loop_parsed.buf_ << " using "
             << reinterpret_cast<uintptr_t>(ctx->rendezvous());
-    OP_REQUIRES_OK_ASYNC(
-        ctx, Rendezvous::ParseKey(in_loop_parsed.buf_, &in_loop_parsed), done);
     ctx->rendezvous()->RecvAsync(in_loop_parsed, args,
                                  make_recv_callback(ctx, std::move(done)));
   }
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/cpu_dispatch.h"
 #include "tensorflow/core/kernels/softmax_op_functor.h"
 
 namespace tensorflow {
@@ -43,6 +44,22 @@ struct SoftmaxFunctorBase {
 template <typename T>
 struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
+// Full specialization for float, that uses the kernel of cpu_dispatch.h when
+// the CPU has a better instruction set than the one TensorFlow was built for.
+template <>
+struct SoftmaxFunctor<CPUDevice, float> : SoftmaxFunctorBase<CPUDevice, float> {
+  void operator()(const CPUDevice& d, TTypes<float>::ConstMatrix logits,
+                  TTypes<float>::Matrix softmax, const bool log) {
+    const cpu_dispatch::Kernels* kernels = cpu_dispatch::GetKernels();
+    if (kernels == nullptr) {
+      SoftmaxFunctorBase<CPUDevice, float>::operator()(d, logits, softmax, log);
+      return;
+    }
+    cpu_dispatch::RowSoftmax(d, *kernels, logits.data(), logits.dimension(0),
+                             logits.dimension(1), log, softmax.data());
+  }
+};
+
 }  // namespace functor
 
 template <typename Device, typename T>
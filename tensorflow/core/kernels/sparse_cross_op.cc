@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 // Contains OP to generate sparse crosses.
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 #include <assert.h>
 
 #include <limits>
@@ -27,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/host_computed_output.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/fingerprint.h"
@@ -656,11 +661,12 @@ GenerateKeyedColumnsFromInput(const OpInputList& indices_list_in,
 // the output SparseTensor.
 // It also output_start_indices which contains the start indices for each
 // input in the output SparseTensor.
-template <typename InternalType>
+template <typename Device, typename InternalType>
 Status CreateOutputTensors(
     const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns,
-    int64 batch_size, OpKernelContext* context, Tensor** indices_out,
-    Tensor** values_out, Tensor** shape_out,
+    int64 batch_size, OpKernelContext* context,
+    HostComputedOutput<Device>* indices_out,
+    HostComputedOutput<Device>* values_out, Tensor** shape_out,
     std::vector<int64>* output_start_indices) {
   // Calculates dimensions for output tensors.
   int64 cross_count_total = 0;
@@ -674,10 +680,10 @@ Status CreateOutputTensors(
   }
 
   // Allocates tensors.
-  TF_RETURN_IF_ERROR(context->allocate_output(
-      0, TensorShape({cross_count_total, 2}), indices_out));
-  TF_RETURN_IF_ERROR(context->allocate_output(
-      1, TensorShape({cross_count_total}), values_out));
+  TF_RETURN_IF_ERROR(
+      indices_out->Allocate(context, TensorShape({cross_count_total, 2})));
+  TF_RETURN_IF_ERROR(
+      values_out->Allocate(context, TensorShape({cross_count_total})));
   TF_RETURN_IF_ERROR(context->allocate_output(2, TensorShape({2}), shape_out));
 
   // Sets shape.
@@ -688,7 +694,7 @@ Status CreateOutputTensors(
   return Status::OK();
 }
 
-template <bool HASHED_OUTPUT, typename InternalType>
+template <typename Device, bool HASHED_OUTPUT, typename InternalType>
 class SparseCrossOp : public OpKernel {
  public:
   explicit SparseCrossOp(OpKernelConstruction* context) : OpKernel(context) {
@@ -721,8 +727,8 @@ class SparseCrossOp : public OpKernel {
     const tstring k_feature_separator = "_X_";
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Crosser crosser(
         columns, num_buckets_, hash_key_, k_feature_separator);
-    Tensor* indices_out;
-    Tensor* values_out;
+    HostComputedOutput<Device> indices_out(/*index=*/0);
+    HostComputedOutput<Device> values_out(/*index=*/1);
     Tensor* shape_out;
     const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<int64> output_start_indices(batch_size);
@@ -732,7 +738,7 @@ class SparseCrossOp : public OpKernel {
                             &values_out, &shape_out, &output_start_indices));
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Updater updater(
-        output_start_indices, indices_out, values_out);
+        output_start_indices, indices_out.tensor(), values_out.tensor());
     auto do_work = [&columns, crosser, updater](int64 begin, int64 end) {
       for (int b = begin; b < end; b++) {
         ProductIterator<InternalType> product_iterator(columns, b);
@@ -751,6 +757,8 @@ class SparseCrossOp : public OpKernel {
     const int kCostPerUnit = 5000 * indices_list_in.size();
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
           kCostPerUnit, do_work);
+    OP_REQUIRES_OK(context, indices_out.Finish(context));
+    OP_REQUIRES_OK(context, values_out.Finish(context));
   }
 
  private:
@@ -783,8 +791,8 @@ class SparseCrossV2Op : public OpKernel {
     std::vector<std::unique_ptr<ColumnInterface<tstring>>> columns =
         GenerateColumnsFromInput<tstring>(indices_list_in, values_list_in,
                                           shapes_list_in, dense_list_in);
-    Tensor* indices_out;
-    Tensor* values_out;
+    HostComputedOutput<CPUDevice> indices_out(/*index=*/0);
+    HostComputedOutput<CPUDevice> values_out(/*index=*/1);
     Tensor* shape_out;
     const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<int64> output_start_indices(batch_size);
@@ -793,8 +801,8 @@ class SparseCrossV2Op : public OpKernel {
         CreateOutputTensors(columns, batch_size, context, &indices_out,
                             &values_out, &shape_out, &output_start_indices));
     StringCrosser<tstring> crosser(columns, 0, 0, separator);
-    OutputUpdater<tstring> updater(output_start_indices, indices_out,
-                                   values_out);
+    OutputUpdater<tstring> updater(output_start_indices, indices_out.tensor(),
+                                   values_out.tensor());
     auto do_work = [&columns, crosser, updater](int64 begin, int64 end) {
       for (int b = begin; b < end; b++) {
         ProductIterator<tstring> product_iterator(columns, b);
@@ -813,9 +821,12 @@ class SparseCrossV2Op : public OpKernel {
     const int kCostPerUnit = 5000 * indices_list_in.size();
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
           kCostPerUnit, do_work);
+    OP_REQUIRES_OK(context, indices_out.Finish(context));
+    OP_REQUIRES_OK(context, values_out.Finish(context));
   }
 };
 
+template <typename Device>
 class SparseCrossHashedOp : public OpKernel {
  public:
   explicit SparseCrossHashedOp(OpKernelConstruction* context)
@@ -852,8 +863,8 @@ class SparseCrossHashedOp : public OpKernel {
         GenerateKeyedColumnsFromInput<int64>(indices_list_in, values_list_in,
                                              shapes_list_in, dense_list_in,
                                              key_);
-    Tensor* indices_out;
-    Tensor* values_out;
+    HostComputedOutput<Device> indices_out(/*index=*/0);
+    HostComputedOutput<Device> values_out(/*index=*/1);
     Tensor* shape_out;
     const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<int64> output_start_indices(batch_size);
@@ -863,7 +874,8 @@ class SparseCrossHashedOp : public OpKernel {
                             &values_out, &shape_out, &output_start_indices));
     const tstring unused_sep;
     HashCrosserV2 crosser(columns, num_buckets, 0, unused_sep);
-    OutputUpdater<int64> updater(output_start_indices, indices_out, values_out);
+    OutputUpdater<int64> updater(output_start_indices, indices_out.tensor(),
+                                 values_out.tensor());
     auto do_work = [&columns, crosser, updater, strong_hash](int64 begin,
                                                              int64 end) {
       for (int b = begin; b < end; b++) {
@@ -883,6 +895,8 @@ class SparseCrossHashedOp : public OpKernel {
     const int kCostPerUnit = 5000 * indices_list_in.size();
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
           kCostPerUnit, do_work);
+    OP_REQUIRES_OK(context, indices_out.Finish(context));
+    OP_REQUIRES_OK(context, values_out.Finish(context));
   }
 };
 
@@ -890,30 +904,62 @@ REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<tstring>("out_type")
                             .TypeConstraint<tstring>("internal_type"),
-                        SparseCrossOp<false, StringPiece>);
+                        SparseCrossOp<CPUDevice, false, StringPiece>);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<tstring>("out_type")
                             .TypeConstraint<int64>("internal_type"),
-                        SparseCrossOp<false, tstring>);
+                        SparseCrossOp<CPUDevice, false, tstring>);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<int64>("out_type")
                             .TypeConstraint<tstring>("internal_type"),
-                        SparseCrossOp<true, int64>);
+                        SparseCrossOp<CPUDevice, true, int64>);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<int64>("out_type")
                             .TypeConstraint<int64>("internal_type"),
-                        SparseCrossOp<true, int64>);
+                        SparseCrossOp<CPUDevice, true, int64>);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCrossV2").Device(DEVICE_CPU),
                         SparseCrossV2Op);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCrossHashed").Device(DEVICE_CPU),
-                        SparseCrossHashedOp);
+                        SparseCrossHashedOp<CPUDevice>);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// The inputs may be strings, which only live in host memory, so the GPU
+// kernels of the hashed crosses cross them on the host and copy the crosses
+// to the device.
+#define REGISTER_GPU_SPARSE_CROSS(internal_type)                               \
+  REGISTER_KERNEL_BUILDER(Name("SparseCross")                                  \
+                              .Device(DEVICE_GPU)                              \
+                              .HostMemory("indices")                           \
+                              .HostMemory("values")                            \
+                              .HostMemory("shapes")                            \
+                              .HostMemory("dense_inputs")                      \
+                              .HostMemory("output_shape")                      \
+                              .TypeConstraint<int64>("out_type")               \
+                              .TypeConstraint<internal_type>("internal_type"), \
+                          SparseCrossOp<GPUDevice, true, int64>);
+REGISTER_GPU_SPARSE_CROSS(tstring);
+REGISTER_GPU_SPARSE_CROSS(int64);
+#undef REGISTER_GPU_SPARSE_CROSS
+
+REGISTER_KERNEL_BUILDER(Name("SparseCrossHashed")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("indices")
+                            .HostMemory("values")
+                            .HostMemory("shapes")
+                            .HostMemory("dense_inputs")
+                            .HostMemory("num_buckets")
+                            .HostMemory("strong_hash")
+                            .HostMemory("salt")
+                            .HostMemory("output_shape"),
+                        SparseCrossHashedOp<GPUDevice>);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 }  // namespace tensorflow
@@ -19,6 +19,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -255,63 +258,77 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
     const int lhs_index_a = ADJ_A ? 1 : 0;
     const int rhs_index_a = ADJ_A ? 0 : 1;
-
-    out.setZero();
-
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
-
-    if (rhs_right < kNumVectorize) {
-      // Disable vectorization if the RHS of output is too small
-      auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
-
+    const int64 out_rows = out.dimension(0);
+
+    // Converts A to CSR form by a stable counting sort of its entries on their
+    // output rows: the entries of output row m are entries
+    // csr_entries[row_begin[m]] ... csr_entries[row_begin[m + 1] - 1] of A, in
+    // their original order. This lets the output rows be computed in parallel,
+    // each one summed in the same order as a sequential pass over A would.
+    std::vector<Tindices> rows(nnz);
+    std::vector<Tindices> cols(nnz);
+    std::vector<int64> row_begin(out_rows + 1, 0);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+      if (!FastBoundsCheck(k, lhs_right)) {
+        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+      }
+      if (!FastBoundsCheck(m, out_rows)) {
+        return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+      }
+      rows[i] = m;
+      cols[i] = k;
+      ++row_begin[m + 1];
+    }
+    for (int64 m = 0; m < out_rows; ++m) {
+      row_begin[m + 1] += row_begin[m];
+    }
+    std::vector<int64> csr_entries(nnz);
+    {
+      std::vector<int64> row_end(row_begin.begin(), row_begin.end() - 1);
       for (std::size_t i = 0; i < nnz; ++i) {
-        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-        if (!FastBoundsCheck(k, lhs_right)) {
-          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-        }
-        if (!FastBoundsCheck(m, out.dimension(0))) {
-          return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-        }
-        const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-        for (std::size_t n = 0; n < rhs_right; ++n) {
-          const T b_value = maybe_adjoint_b(k, n);
-          out(m, n) += a_value * b_value;
-        }
+        csr_entries[row_end[rows[i]]++] = i;
       }
-    } else {
-      // Vectorization via Eigen.
-      const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k) * a_value;                  \
-  }
+    }
 
-      if (ADJ_B) {
-        // Perform transpose and conjugation on B once, since we chip out B's
-        // columns in the nnz loop.
-        Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
-        Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-            b.swap_layout().shuffle(shuffle).conjugate();
-        LOOP_NNZ(col_major_conj_b);
-      } else {
-        LOOP_NNZ(b);
-      }
-#undef LOOP_NNZ
+    // Perform transpose and conjugation on B once, so that the rows of B
+    // which are scaled into the output rows are contiguous.
+    Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b;
+    if (ADJ_B) {
+      Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
+      col_major_conj_b = b.swap_layout().shuffle(shuffle).conjugate();
     }
+    const T* b_data = ADJ_B ? col_major_conj_b.data() : b.data();
+
+    auto compute_rows = [&](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index m = begin; m < end; ++m) {
+        T* out_row = &out(m, 0);
+        std::fill(out_row, out_row + rhs_right, T(0));
+        for (int64 j = row_begin[m]; j < row_begin[m + 1]; ++j) {
+          const int64 i = csr_entries[j];
+          const Tindices k = cols[i];
+          const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+          const T* b_row = b_data + k * rhs_right;
+          if (rhs_right < kNumVectorize) {
+            for (std::size_t n = 0; n < rhs_right; ++n) {
+              out_row[n] += a_value * b_row[n];
+            }
+          } else {
+            // Vectorization via Eigen.
+            typename TTypes<T>::Vec out_vec(out_row, rhs_right);
+            typename TTypes<T>::ConstVec b_vec(b_row, rhs_right);
+            out_vec += b_vec * a_value;
+          }
+        }
+      }
+    };
+    const double nnz_per_row = static_cast<double>(nnz) / out_rows;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/(nnz_per_row + 1) * rhs_right * sizeof(T),
+        /*bytes_stored=*/rhs_right * sizeof(T),
+        /*compute_cycles=*/(nnz_per_row + 1) * rhs_right);
+    d.parallelFor(out_rows, cost, compute_rows);
     return Status::OK();
   }
 };
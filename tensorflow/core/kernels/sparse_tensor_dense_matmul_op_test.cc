@@ -117,4 +117,8 @@ BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, false, true);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, false);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, true);
 
+// Highly sparse feature matrices.
+BM_SparseTensorDenseMatmul(65536, 65536, 1048576, 64, false, false);
+BM_SparseTensorDenseMatmul(65536, 65536, 1048576, 64, false, true);
+
 }  // end namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -64,10 +66,25 @@ class StringJoinOp : public OpKernel {
 
     std::vector<StringPiece> strings(input_list.size());
     for (size_t i = 0; i < input_shape.num_elements(); ++i) {
+      size_t size = input_list.size() == 0
+                        ? 0
+                        : separator_.size() * (input_list.size() - 1);
       for (int j = 0; j < input_list.size(); ++j) {
         strings[j] = (is_scalar[j]) ? inputs[j](0) : inputs[j](i);
+        size += strings[j].size();
+      }
+      // Joins straight into the output string, which is allocated once.
+      tstring& output = output_flat(i);
+      output.resize_uninitialized(size);
+      char* joined = output.mdata();
+      for (int j = 0; j < input_list.size(); ++j) {
+        if (j > 0) {
+          memcpy(joined, separator_.data(), separator_.size());
+          joined += separator_.size();
+        }
+        memcpy(joined, strings[j].data(), strings[j].size());
+        joined += strings[j].size();
       }
-      output_flat(i) = absl::StrJoin(strings, separator_);
     }
   }
 
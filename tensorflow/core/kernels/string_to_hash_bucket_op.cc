@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 #include "tensorflow/core/kernels/string_to_hash_bucket_op.h"
 
 #include "tensorflow/core/lib/hash/hash.h"
@@ -63,9 +67,21 @@ REGISTER_KERNEL_BUILDER(Name("StringToHashBucket").Device(DEVICE_CPU),
                         LegacyStringToHashBucketOp);
 
 REGISTER_KERNEL_BUILDER(Name("StringToHashBucketFast").Device(DEVICE_CPU),
-                        StringToHashBucketOp<Fingerprint64>);
+                        StringToHashBucketOp<CPUDevice, Fingerprint64>);
 
 REGISTER_KERNEL_BUILDER(Name("StringToHashBucketStrong").Device(DEVICE_CPU),
-                        StringToKeyedHashBucketOp<StrongKeyedHash>);
+                        StringToKeyedHashBucketOp<CPUDevice, StrongKeyedHash>);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+REGISTER_KERNEL_BUILDER(Name("StringToHashBucketFast")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("input"),
+                        StringToHashBucketOp<GPUDevice, Fingerprint64>);
+
+REGISTER_KERNEL_BUILDER(Name("StringToHashBucketStrong")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("input"),
+                        StringToKeyedHashBucketOp<GPUDevice, StrongKeyedHash>);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 }  // namespace tensorflow
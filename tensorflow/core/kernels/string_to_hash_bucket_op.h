@@ -20,13 +20,20 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/host_computed_output.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
-template <uint64 hash(StringPiece)>
+// The rough number of cycles hashing a string into a bucket takes.
+constexpr int64 kStringToHashBucketCost = 100;
+
+// Strings only live in host memory, so on the GPU the strings are hashed on
+// the host and the bucket ids are copied to the device.
+template <typename Device, uint64 hash(StringPiece)>
 class StringToHashBucketOp : public OpKernel {
  public:
   explicit StringToHashBucketOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
@@ -38,21 +45,25 @@ class StringToHashBucketOp : public OpKernel {
     OP_REQUIRES_OK(context, context->input("input", &input_tensor));
     const auto& input_flat = input_tensor->flat<tstring>();
 
-    Tensor* output_tensor = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output("output", input_tensor->shape(),
-                                            &output_tensor));
-    auto output_flat = output_tensor->flat<int64>();
-
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    HostComputedOutput<Device> output(/*index=*/0);
+    OP_REQUIRES_OK(context, output.Allocate(context, input_tensor->shape()));
+    auto output_flat = output.tensor()->flat<int64>();
+
+    auto hash_strings = [this, &input_flat, &output_flat](int64 begin,
+                                                          int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 input_hash = hash(input_flat(i));
+        const uint64 bucket_id = input_hash % num_buckets_;
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        output_flat(i) = static_cast<int64>(bucket_id);
+      }
+    };
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), kStringToHashBucketCost, hash_strings);
+    OP_REQUIRES_OK(context, output.Finish(context));
   }
 
  private:
@@ -61,7 +72,7 @@ class StringToHashBucketOp : public OpKernel {
   TF_DISALLOW_COPY_AND_ASSIGN(StringToHashBucketOp);
 };
 
-template <uint64 hash(const uint64 (&)[2], const string&)>
+template <typename Device, uint64 hash(const uint64 (&)[2], const string&)>
 class StringToKeyedHashBucketOp : public OpKernel {
  public:
   explicit StringToKeyedHashBucketOp(OpKernelConstruction* ctx)
@@ -80,21 +91,25 @@ class StringToKeyedHashBucketOp : public OpKernel {
     OP_REQUIRES_OK(context, context->input("input", &input_tensor));
     const auto& input_flat = input_tensor->flat<tstring>();
 
-    Tensor* output_tensor = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output("output", input_tensor->shape(),
-                                            &output_tensor));
-    auto output_flat = output_tensor->flat<int64>();
-
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    HostComputedOutput<Device> output(/*index=*/0);
+    OP_REQUIRES_OK(context, output.Allocate(context, input_tensor->shape()));
+    auto output_flat = output.tensor()->flat<int64>();
+
+    auto hash_strings = [this, &input_flat, &output_flat](int64 begin,
+                                                          int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 input_hash = hash(key_, input_flat(i));
+        const uint64 bucket_id = input_hash % num_buckets_;
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        output_flat(i) = static_cast<int64>(bucket_id);
+      }
+    };
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), kStringToHashBucketCost, hash_strings);
+    OP_REQUIRES_OK(context, output.Finish(context));
   }
 
  private:
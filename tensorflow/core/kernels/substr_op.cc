@@ -141,19 +141,19 @@ class SubstrOp : public OpKernel {
       switch (ndims) {
         case 1: {
           // Reshape tensors according to BCast results
-          auto input = input_tensor.shaped<tstring, 1>(bcast.x_reshape());
+          auto input = input_tensor.flat<tstring>();
           auto output = output_tensor->shaped<tstring, 1>(bcast.result_shape());
           auto pos_shaped = pos_tensor.shaped<T, 1>(bcast.y_reshape());
           auto len_shaped = len_tensor.shaped<T, 1>(bcast.y_reshape());
 
-          // Allocate temporary buffer for broadcasted input tensor
-          Tensor input_buffer;
-          OP_REQUIRES_OK(context, context->allocate_temp(
-                                      DT_STRING, output_shape, &input_buffer));
-          TTypes<tstring, 1>::Tensor input_bcast =
-              input_buffer.shaped<tstring, 1>(bcast.result_shape());
-          input_bcast =
-              input.broadcast(BCast::ToIndexArray<1>(bcast.x_bcast()));
+          // Broadcast the indices of the input strings rather than the
+          // strings, which would copy each of them.
+          Tensor input_index_buffer;
+          OP_REQUIRES_OK(context, BroadcastInputIndices<1>(
+                                      context, input_tensor, bcast,
+                                      output_shape, &input_index_buffer));
+          TTypes<int64, 1>::Tensor input_index_bcast =
+              input_index_buffer.shaped<int64, 1>(bcast.result_shape());
 
           // Allocate temporary buffer for broadcasted position tensor
           Tensor pos_buffer;
@@ -177,7 +177,7 @@ class SubstrOp : public OpKernel {
 
           // Iterate through broadcasted tensors and perform substr
           for (int i = 0; i < output_shape.dim_size(0); ++i) {
-            StringPiece in(input_bcast(i));
+            StringPiece in(input(input_index_bcast(i)));
             const T pos = tensorflow::internal::SubtleMustCopy(pos_bcast(i));
             const T len = tensorflow::internal::SubtleMustCopy(len_bcast(i));
             T byte_pos = pos;
@@ -192,8 +192,7 @@ class SubstrOp : public OpKernel {
               case CharUnit::BYTE:
                 byte_pos = AdjustedPosIndex(byte_pos, in);
                 OP_REQUIRES(
-                    context,
-                    FastBoundsCheck(byte_pos, input_bcast(i).size() + 1),
+                    context, FastBoundsCheck(byte_pos, in.size() + 1),
                     errors::InvalidArgument("pos ", pos, " out of range for ",
                                             "string b'", in, "' at index ", i));
             }
@@ -204,19 +203,19 @@ class SubstrOp : public OpKernel {
         }
         case 2: {
           // Reshape tensors according to BCast results
-          auto input = input_tensor.shaped<tstring, 2>(bcast.x_reshape());
+          auto input = input_tensor.flat<tstring>();
           auto output = output_tensor->shaped<tstring, 2>(bcast.result_shape());
           auto pos_shaped = pos_tensor.shaped<T, 2>(bcast.y_reshape());
           auto len_shaped = len_tensor.shaped<T, 2>(bcast.y_reshape());
 
-          // Allocate temporary buffer for broadcasted input tensor
-          Tensor input_buffer;
-          OP_REQUIRES_OK(context, context->allocate_temp(
-                                      DT_STRING, output_shape, &input_buffer));
-          TTypes<tstring, 2>::Tensor input_bcast =
-              input_buffer.shaped<tstring, 2>(bcast.result_shape());
-          input_bcast =
-              input.broadcast(BCast::ToIndexArray<2>(bcast.x_bcast()));
+          // Broadcast the indices of the input strings rather than the
+          // strings, which would copy each of them.
+          Tensor input_index_buffer;
+          OP_REQUIRES_OK(context, BroadcastInputIndices<2>(
+                                      context, input_tensor, bcast,
+                                      output_shape, &input_index_buffer));
+          TTypes<int64, 2>::Tensor input_index_bcast =
+              input_index_buffer.shaped<int64, 2>(bcast.result_shape());
 
           // Allocate temporary buffer for broadcasted position tensor
           Tensor pos_buffer;
@@ -241,7 +240,7 @@ class SubstrOp : public OpKernel {
           // Iterate through broadcasted tensors and perform substr
           for (int i = 0; i < output_shape.dim_size(0); ++i) {
             for (int j = 0; j < output_shape.dim_size(1); ++j) {
-              StringPiece in(input_bcast(i, j));
+              StringPiece in(input(input_index_bcast(i, j)));
               const T pos =
                   tensorflow::internal::SubtleMustCopy(pos_bcast(i, j));
               const T len =
@@ -278,6 +277,29 @@ class SubstrOp : public OpKernel {
   }
 
  private:
+  // Allocates `input_indices` with `output_shape`, and fills it with the index
+  // in the flattened input of the string each output is a substring of.
+  template <int NDIM>
+  static Status BroadcastInputIndices(OpKernelContext* context,
+                                      const Tensor& input_tensor,
+                                      const BCast& bcast,
+                                      const TensorShape& output_shape,
+                                      Tensor* input_indices) {
+    Tensor indices;
+    TF_RETURN_IF_ERROR(
+        context->allocate_temp(DT_INT64, input_tensor.shape(), &indices));
+    auto indices_flat = indices.flat<int64>();
+    for (int64 i = 0; i < indices_flat.size(); ++i) {
+      indices_flat(i) = i;
+    }
+    TF_RETURN_IF_ERROR(
+        context->allocate_temp(DT_INT64, output_shape, input_indices));
+    input_indices->shaped<int64, NDIM>(bcast.result_shape()) =
+        indices.shaped<int64, NDIM>(bcast.x_reshape())
+            .broadcast(BCast::ToIndexArray<NDIM>(bcast.x_bcast()));
+    return Status::OK();
+  }
+
   // This adjusts the requested position. Note it does not perform any bound
   // checks.
   static inline T AdjustedPosIndex(const T pos_requested, const StringPiece s) {
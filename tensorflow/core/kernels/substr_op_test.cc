@@ -169,6 +169,29 @@ void BM_SubstrUTF8(int iters, int batch_size) {
   test::Benchmark("cpu", g).Run(iters);
 }
 
+// Takes 8 substrings of each input string, broadcasting the input.
+void BM_SubstrBroadcast(int iters, int batch_size) {
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters));
+  testing::UseRealTime();
+  Tensor input = GetTestTensor(batch_size);
+  Tensor position(DT_INT32, TensorShape({8, batch_size}));
+  test::FillFn<int32>(&position,
+                      [batch_size](int i) { return i / batch_size; });
+  Tensor length(DT_INT32, TensorShape({8, batch_size}));
+  length.flat<int32>().setConstant(30);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(NodeBuilder("substr_op", "Substr")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, position))
+                  .Input(test::graph::Constant(g, length))
+                  .Attr("unit", kByteUnit)
+                  .Finalize(g, nullptr /* node */));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
 BENCHMARK(BM_SubstrByte)
     ->Arg(1)
     ->Arg(8)
@@ -185,5 +208,6 @@ BENCHMARK(BM_SubstrUTF8)
     ->Arg(64)
     ->Arg(128)
     ->Arg(256);
+BENCHMARK(BM_SubstrBroadcast)->Arg(1)->Arg(32)->Arg(256)->Arg(4096);
 
 }  // end namespace tensorflow
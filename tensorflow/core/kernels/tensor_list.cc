@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/tensor_list.h"
 
+#include <cstring>
+
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
@@ -124,4 +126,56 @@ bool TensorList::Decode(const VariantTensorData& data) {
 
 const char TensorList::kTypeName[] = "tensorflow::TensorList";
 
+TensorList::Slab::Slab(Tensor buffer)
+    : buffer(std::move(buffer)),
+      element_shape(this->buffer.shape()),
+      written(this->buffer.dim_size(0)) {
+  element_shape.RemoveDim(0);
+  element_bytes = this->buffer.TotalBytes() / this->buffer.dim_size(0);
+}
+
+void TensorList::SetSlab(Tensor buffer) {
+  DCHECK_GT(buffer.dim_size(0), 0);
+  tensors_->slab_ = std::make_shared<Slab>(std::move(buffer));
+}
+
+bool TensorList::WriteToSlab(int index, const Tensor& value, Tensor* element) {
+  Slab* slab = tensors_->slab_.get();
+  if (slab == nullptr || index < 0 || index >= slab->buffer.dim_size(0) ||
+      value.dtype() != slab->buffer.dtype() ||
+      value.shape() != slab->element_shape) {
+    return false;
+  }
+  {
+    mutex_lock l(slab->mu);
+    if (slab->written[index]) return false;
+    slab->written[index] = true;
+  }
+  Tensor slot = slab->buffer.SubSlice(index);
+  const StringPiece src = value.tensor_data();
+  std::memcpy(const_cast<char*>(slot.tensor_data().data()), src.data(),
+              src.size());
+  *element = std::move(slot);
+  return true;
+}
+
+bool TensorList::SlabView(int begin, int end, Tensor* view) const {
+  const Slab* slab = tensors_->slab_.get();
+  if (slab == nullptr || begin < 0 || begin >= end ||
+      end > slab->buffer.dim_size(0) || end > tensors().size()) {
+    return false;
+  }
+  const char* base = slab->buffer.tensor_data().data();
+  for (int i = begin; i < end; ++i) {
+    const Tensor& t = tensors()[i];
+    if (t.dtype() != slab->buffer.dtype() ||
+        t.tensor_data().data() != base + i * slab->element_bytes ||
+        t.shape() != slab->element_shape) {
+      return false;
+    }
+  }
+  *view = slab->buffer.Slice(begin, end);
+  return true;
+}
+
 }  // namespace tensorflow
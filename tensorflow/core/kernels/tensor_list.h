@@ -15,12 +15,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 #define TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 
+#include <memory>
 #include <utility>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -134,17 +136,49 @@ class TensorList {
     out.max_num_elements = max_num_elements;
     // This performs a copy of the std::vector.
     out.tensors_->values_ = tensors_->values_;
+    out.tensors_->slab_ = tensors_->slab_;
     return out;
   }
 
+  // Sets a preallocated host buffer of shape `[n] + element_shape`, which the
+  // first `n` elements may be copied into by `WriteToSlab()`, so that stacking
+  // or gathering consecutive elements returns a view of the buffer instead of
+  // a copy. The size of an element must be a multiple of
+  // `Allocator::kAllocatorAlignment`, so that the views stay aligned. The
+  // buffer is shared with the copies of this list.
+  void SetSlab(Tensor buffer);
+
+  // Copies `value`, which must be in host memory, into element `index` of the
+  // slab and returns the view of it in `*element`. Each element of the slab is
+  // written at most once, by this list or one of its copies, so that views
+  // are never modified. Returns false if there is no slab, `value` does not
+  // match its element type, or the element was already written.
+  bool WriteToSlab(int index, const Tensor& value, Tensor* element);
+
+  // Returns true if the elements in [begin, end) are the views of the
+  // corresponding elements of the slab, and sets `*view` to the slab's view of
+  // all of them.
+  bool SlabView(int begin, int end, Tensor* view) const;
+
   // Is this TensorList the only one with a reference to the underlying
   // container?
   bool RefCountIsOne() const { return tensors_->RefCountIsOne(); }
 
  private:
+  struct Slab {
+    explicit Slab(Tensor buffer);
+
+    const Tensor buffer;
+    TensorShape element_shape;
+    int64 element_bytes;
+    mutex mu;
+    std::vector<bool> written TF_GUARDED_BY(mu);
+  };
+
   class Tensors : public core::RefCounted {
    public:
     std::vector<Tensor> values_;
+    std::shared_ptr<Slab> slab_;
   };
   Tensors* tensors_;
 };
@@ -99,6 +99,62 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// Orders the columns of a row by decreasing value, and equal values by
+// increasing column.
+template <typename T>
+struct StableTopKComparator {
+  explicit StableTopKComparator(const T* data) : input_data(data) {}
+
+  bool operator()(const int32 a, const int32 b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+
+  const T* input_data;
+};
+
+// Pushes the columns [begin, end) of a row, in increasing order, into filter.
+// Once filter is full, a column is only kept if its value is greater than the
+// one of the bottom of filter, since it comes after all the columns in filter.
+// Columns are tested kTopKFilterSize at a time with a branch-free comparison
+// that the compiler vectorizes, so that blocks of columns that can not enter
+// filter, which is most of them for k << num_cols, are skipped cheaply.
+template <typename T>
+void PushTopK(const T* input_data, int32 begin, int32 end,
+              gtl::TopN<int32, StableTopKComparator<T>>* filter) {
+  constexpr int32 kTopKFilterSize = 16;
+  int32 c = begin;
+  for (; c < end && filter->size() < filter->limit(); ++c) {
+    filter->push(c);
+  }
+  if (c == end) return;
+  T threshold = input_data[filter->peek_bottom()];
+  while (c < end) {
+    const int32 block_end = std::min(c + kTopKFilterSize, end);
+    if (block_end - c == kTopKFilterSize) {
+      bool any_greater = false;
+      for (int32 i = 0; i < kTopKFilterSize; ++i) {
+        any_greater |= threshold < input_data[c + i];
+      }
+      if (!any_greater) {
+        c = block_end;
+        continue;
+      }
+    }
+    for (; c < block_end; ++c) {
+      if (threshold < input_data[c]) {
+        filter->push(c);
+        threshold = input_data[filter->peek_bottom()];
+      }
+    }
+  }
+}
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -139,15 +195,7 @@ struct TopKFunctor<CPUDevice, T> {
     auto SortIndices = [&](int64 start_batch, int64 limit_batch) {
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32 a, const int32 b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
+        const StableTopKComparator<T> stable_comp(input_data);
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
@@ -180,11 +228,9 @@ struct TopKFunctor<CPUDevice, T> {
           }
         } else {
           // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
+          gtl::TopN<int32, StableTopKComparator<T>> filter(k, stable_comp);
           filter.reserve(num_cols);
-          for (int32 c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
+          PushTopK<T>(input_data, 0, num_cols, &filter);
 
           int32 i = 0;
           if (sorted) {
@@ -222,11 +268,94 @@ struct TopKFunctor<CPUDevice, T> {
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // When there are fewer rows than threads, split long rows into blocks of
+    // at least kMinBlockCols columns whose top k are found in parallel and
+    // then merged.
+    constexpr int64 kMinBlockCols = 1 << 14;
+    int64 num_blocks = 1;
+    if (k < num_cols && num_rows < worker_threads.num_threads) {
+      const int64 min_block_cols = std::max<int64>(kMinBlockCols, 8 * k);
+      num_blocks = std::min<int64>(
+          (worker_threads.num_threads + num_rows - 1) / num_rows,
+          num_cols / min_block_cols);
+    }
+    if (num_blocks > 1) {
+      return ComputeBlocked(context, sorted, k, input, num_rows, num_cols,
+                            num_blocks, values, indices);
+    }
+
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+ private:
+  // Finds the top k of every row by splitting the row into num_blocks blocks,
+  // finding the top k of all blocks in parallel, and then selecting the top k
+  // of the num_blocks * k candidates of every row.
+  static Status ComputeBlocked(OpKernelContext* context, bool sorted, int k,
+                               const typename TTypes<T, 2>::ConstTensor& input,
+                               const int64 num_rows, const int64 num_cols,
+                               const int64 num_blocks,
+                               typename TTypes<T, 2>::Tensor values,
+                               typename TTypes<int, 2>::Tensor indices) {
+    const int64 num_row_candidates = num_blocks * k;
+    std::vector<int32> candidates(num_rows * num_row_candidates);
+
+    auto SelectBlocks = [&](int64 start_block, int64 limit_block) {
+      for (int64 i = start_block; i < limit_block; ++i) {
+        const int64 b = i / num_blocks;
+        const int64 block = i % num_blocks;
+        const int32 begin = block * num_cols / num_blocks;
+        const int32 end = (block + 1) * num_cols / num_blocks;
+        const T* input_data = &input(b, 0);
+        gtl::TopN<int32, StableTopKComparator<T>> filter(
+            k, StableTopKComparator<T>(input_data));
+        filter.reserve(k + 1);
+        PushTopK<T>(input_data, begin, end, &filter);
+        // Every block has more than k columns, so filter is full.
+        std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+                  candidates.begin() + i * k);
+      }
+    };
+
+    auto MergeBlocks = [&](int64 start_batch, int64 limit_batch) {
+      for (int64 b = start_batch; b < limit_batch; ++b) {
+        const T* input_data = &input(b, 0);
+        const StableTopKComparator<T> stable_comp(input_data);
+        auto begin = candidates.begin() + b * num_row_candidates;
+        auto end = begin + num_row_candidates;
+        if (sorted) {
+          std::partial_sort(begin, begin + k, end, stable_comp);
+        } else {
+          std::nth_element(begin, begin + k - 1, end, stable_comp);
+        }
+        std::copy(begin, begin + k, &indices(b, 0));
+        std::transform(
+            begin, begin + k, &values(b, 0),
+            [input_data](const int32 loc) { return input_data[loc]; });
+      }
+    };
+
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    const double select_cost = cmp_cost * static_cast<double>(num_cols) /
+                               static_cast<double>(num_blocks);
+    const double merge_cost =
+        cmp_cost * static_cast<double>(
+                       num_row_candidates *
+                       Eigen::numext::log2(static_cast<float>(k + 1)));
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_blocks, static_cast<int64>(select_cost),
+          SelectBlocks);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          static_cast<int64>(merge_cost), MergeBlocks);
+
+    return Status::OK();
+  }
 };
 
 }  // namespace functor
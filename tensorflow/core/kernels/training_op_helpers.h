@@ -25,11 +25,21 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Returns an error if `var` has been frozen, and so must not be modified.
+inline Status EnsureVariableIsMutable(const Var* var) {
+  if (var->frozen.load()) {
+    return errors::FailedPrecondition(
+        "Trying to modify a frozen resource variable");
+  }
+  return Status::OK();
+}
+
 // Must be called before performing a sparse operation on a variable. Ensures
 // that no concurrent dense operations can happen while holding the variable's
-// lock.
+// lock. Sparse reads of frozen variables do not need to call this.
 template <typename Device, typename T>
 Status EnsureSparseVariableAccess(OpKernelContext* ctx, Var* var) {
+  TF_RETURN_IF_ERROR(EnsureVariableIsMutable(var));
   if (var->copy_on_read_mode.load()) {
     return Status::OK();
   }
@@ -247,6 +257,7 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
       *out = *var->tensor();
       return Status::OK();
     }
+    TF_RETURN_IF_ERROR(EnsureVariableIsMutable(var.get()));
     TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(
         ctx, var->tensor(), var->copy_on_read_mode.load()));
     *out = *var->tensor();
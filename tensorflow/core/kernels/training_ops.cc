@@ -17,7 +17,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_ops.h"
 
 #include <algorithm>  // NOLINT
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -3688,6 +3690,289 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Optimizers implemented by SparseApplyAdamOp.
+enum class SparseAdamVariant { kAdam, kAdamW, kLamb };
+
+// Applies Adam, AdamW or LAMB to the rows of var, m and v selected by indices,
+// without densifying the gradient. The gradients of duplicate indices are first
+// summed by a hash-accumulate pass, so that every row is updated exactly once,
+// and the rows are then updated in parallel. If lazy_update is false, the
+// moments of the rows without gradient also decay and these rows are updated
+// too, as the dense optimizer would do for the densified gradient.
+//
+// Note, this op works on cpu only.
+template <typename T, typename Tindex, SparseAdamVariant variant>
+class SparseApplyAdamOp : public OpKernel {
+ public:
+  explicit SparseApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("lazy_update", &lazy_update_));
+  }
+
+  void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
+    const bool sparse = true;
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+
+    Tensor var;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor m;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &m));
+    Tensor v;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, sparse, &v));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, m.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    OP_REQUIRES(
+        ctx, v.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(2)));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(m.shape()),
+                errors::InvalidArgument("var and m do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        m.shape().DebugString()));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(v.shape()),
+                errors::InvalidArgument("var and v do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        v.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(var.shape()),
+                errors::InvalidArgument("var must be at least 1 dimensional"));
+
+    static const char* const kScalarNames[] = {
+        "beta1_power", "beta2_power", "lr",          "beta1",
+        "beta2",       "epsilon",     "weight_decay"};
+    const int num_scalars = variant == SparseAdamVariant::kAdam ? 6 : 7;
+    for (int i = 0; i < num_scalars; ++i) {
+      const Tensor& scalar = ctx->input(3 + i);
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                  errors::InvalidArgument(kScalarNames[i], " is not a scalar: ",
+                                          scalar.shape().DebugString()));
+    }
+    const T one(1);
+    const T beta1_power = ctx->input(3).scalar<T>()();
+    const T beta2_power = ctx->input(4).scalar<T>()();
+    Hyperparameters params;
+    params.lr = ctx->input(5).scalar<T>()();
+    params.beta1 = ctx->input(6).scalar<T>()();
+    params.beta2 = ctx->input(7).scalar<T>()();
+    params.epsilon = ctx->input(8).scalar<T>()();
+    params.weight_decay = variant == SparseAdamVariant::kAdam
+                              ? T(0)
+                              : ctx->input(9).scalar<T>()();
+    params.alpha =
+        params.lr * Eigen::numext::sqrt(one - beta2_power) / (one - beta1_power);
+    params.m_correction = one / (one - beta1_power);
+    params.v_correction = one / (one - beta2_power);
+
+    const Tensor& grad = ctx->input(3 + num_scalars);
+    const Tensor& indices = ctx->input(4 + num_scalars);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices must be one-dimensional"));
+    OP_REQUIRES(ctx, grad.dims() == var.dims(),
+                errors::InvalidArgument("var and grad must have the same rank ",
+                                        var.shape().DebugString(), " ",
+                                        grad.shape().DebugString()));
+
+    int64 inner_dim = 1;
+    for (int d = 1; d < var.dims(); d++) {
+      OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
+                  errors::InvalidArgument(strings::StrCat(
+                      "var and grad must match in dimension ", d)));
+      inner_dim *= grad.dim_size(d);
+    }
+    const Tindex N = indices.dim_size(0);
+    OP_REQUIRES(
+        ctx, grad.dim_size(0) == N,
+        errors::InvalidArgument(
+            "grad must be the same size as indices in the first dimension."));
+    OP_REQUIRES(ctx, inner_dim > 0,
+                errors::InvalidArgument(
+                    "Inner dimension should be greater than zero."));
+
+    const Tindex first_dim_size = var.dim_size(0);
+    const auto indices_vec = indices.vec<Tindex>();
+
+    // Sum the gradients of duplicate indices. Each unique index is mapped to
+    // the row of unique_grad that accumulates its gradients.
+    absl::flat_hash_map<Tindex, Tindex> unique_positions;
+    unique_positions.reserve(N);
+    std::vector<Tindex> unique_indices;
+    unique_indices.reserve(N);
+    std::vector<Tindex> positions(N);
+    for (Tindex i = 0; i < N; ++i) {
+      const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+      OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
+                  errors::InvalidArgument(
+                      strings::StrCat("Index ", index, " at offset ", i,
+                                      " in indices is out of range")));
+      const auto inserted = unique_positions.emplace(
+          index, static_cast<Tindex>(unique_indices.size()));
+      if (inserted.second) {
+        unique_indices.push_back(index);
+      }
+      positions[i] = inserted.first->second;
+    }
+    const Tindex num_unique = unique_indices.size();
+
+    Tensor unique_grad = grad;
+    if (num_unique < N) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                             TensorShape({num_unique, inner_dim}),
+                                             &unique_grad));
+      auto grad_flat = grad.flat_outer_dims<T>();
+      auto unique_grad_flat = unique_grad.matrix<T>();
+      unique_grad_flat.setZero();
+      for (Tindex i = 0; i < N; ++i) {
+        unique_grad_flat.template chip<0>(positions[i]) +=
+            grad_flat.template chip<0>(i);
+      }
+    }
+    const auto unique_grad_flat = unique_grad.flat_outer_dims<T>();
+
+    auto var_flat = var.flat_outer_dims<T>();
+    auto m_flat = m.flat_outer_dims<T>();
+    auto v_flat = v.flat_outer_dims<T>();
+
+    // This op is implemented only for CPU device.
+    const auto& d = ctx->eigen_cpu_device();
+    const int in_bytes = inner_dim * sizeof(T) * 4;
+    const int out_bytes = inner_dim * sizeof(T) * 3;
+    const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 6 +
+                                    Eigen::TensorOpCost::MulCost<T>() * 6 +
+                                    Eigen::TensorOpCost::DivCost<T>());
+    const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
+
+    if (lazy_update_) {
+      const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
+        for (Tindex i = start_idx; i < end_idx; ++i) {
+          const Tindex index = unique_indices[i];
+          UpdateRow(params, &unique_grad_flat(i, 0), inner_dim,
+                    &var_flat(index, 0), &m_flat(index, 0), &v_flat(index, 0));
+        }
+      };
+      d.parallelFor(num_unique, cost, shard);
+    } else {
+      // Rows without gradient are updated with a zero gradient.
+      std::vector<Tindex> grad_rows(first_dim_size, -1);
+      for (Tindex i = 0; i < num_unique; ++i) {
+        grad_rows[unique_indices[i]] = i;
+      }
+      const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
+        for (Tindex index = start_idx; index < end_idx; ++index) {
+          const Tindex i = grad_rows[index];
+          UpdateRow(params, i < 0 ? nullptr : &unique_grad_flat(i, 0),
+                    inner_dim, &var_flat(index, 0), &m_flat(index, 0),
+                    &v_flat(index, 0));
+        }
+      };
+      d.parallelFor(first_dim_size, cost, shard);
+    }
+
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  struct Hyperparameters {
+    T lr;
+    T beta1;
+    T beta2;
+    T epsilon;
+    T weight_decay;
+    // Adam step size, corrected for the bias of both moments.
+    T alpha;
+    // Bias corrections of the first and second moments, used by LAMB.
+    T m_correction;
+    T v_correction;
+  };
+
+  // Updates one row of var, m and v of inner_dim elements. grad is the summed
+  // gradient of the row, or null if the row has no gradient.
+  static void UpdateRow(const Hyperparameters& p, const T* grad,
+                        int64 inner_dim, T* var_row, T* m_row, T* v_row) {
+    typename TTypes<T>::UnalignedFlat var(var_row, inner_dim);
+    typename TTypes<T>::UnalignedFlat m(m_row, inner_dim);
+    typename TTypes<T>::UnalignedFlat v(v_row, inner_dim);
+    const T one(1);
+    if (grad != nullptr) {
+      typename TTypes<T>::UnalignedConstFlat g(grad, inner_dim);
+      m += (g - m) * (one - p.beta1);
+      v += (g.square() - v) * (one - p.beta2);
+    } else {
+      m = m * p.beta1;
+      v = v * p.beta2;
+    }
+
+    switch (variant) {
+      case SparseAdamVariant::kAdam:
+        var -= (m * p.alpha) / (v.sqrt() + p.epsilon);
+        break;
+      case SparseAdamVariant::kAdamW:
+        var -= (m * p.alpha) / (v.sqrt() + p.epsilon) +
+               var * (p.lr * p.weight_decay);
+        break;
+      case SparseAdamVariant::kLamb: {
+        // The trust ratio is computed per row, which is the unit of update of
+        // an embedding table.
+        Eigen::Tensor<T, 1, Eigen::RowMajor> update(inner_dim);
+        update = (m * p.m_correction) /
+                     ((v * p.v_correction).sqrt() + p.epsilon) +
+                 var * p.weight_decay;
+        Eigen::Tensor<T, 0, Eigen::RowMajor> var_norm =
+            var.square().sum().sqrt();
+        Eigen::Tensor<T, 0, Eigen::RowMajor> update_norm =
+            update.square().sum().sqrt();
+        T trust_ratio = one;
+        if (var_norm() > T(0) && update_norm() > T(0)) {
+          trust_ratio = var_norm() / update_norm();
+        }
+        var -= update * (p.lr * trust_ratio);
+        break;
+      }
+    }
+  }
+
+  bool use_exclusive_lock_;
+  bool lazy_update_;
+};
+
+#define REGISTER_KERNELS(T, Tindices)                                     \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("ResourceSparseApplyAdam")                                     \
+          .Device(DEVICE_CPU)                                             \
+          .TypeConstraint<T>("T")                                         \
+          .TypeConstraint<Tindices>("Tindices"),                          \
+      SparseApplyAdamOp<T, Tindices, SparseAdamVariant::kAdam>);          \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("ResourceSparseApplyAdamW")                                    \
+          .Device(DEVICE_CPU)                                             \
+          .TypeConstraint<T>("T")                                         \
+          .TypeConstraint<Tindices>("Tindices"),                          \
+      SparseApplyAdamOp<T, Tindices, SparseAdamVariant::kAdamW>);         \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("ResourceSparseApplyLamb")                                     \
+          .Device(DEVICE_CPU)                                             \
+          .TypeConstraint<T>("T")                                         \
+          .TypeConstraint<Tindices>("Tindices"),                          \
+      SparseApplyAdamOp<T, Tindices, SparseAdamVariant::kLamb>);
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_KERNELS(T, int32);   \
+  REGISTER_KERNELS(T, int64);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdaMaxOp : public OpKernel {
  public:
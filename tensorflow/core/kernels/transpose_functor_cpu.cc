@@ -15,6 +15,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -25,44 +26,285 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/math/math_util.h"
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 namespace tensorflow {
 namespace {
 
+// Side of the square tiles that are transposed in registers.
+constexpr int64 kTileSize = 8;
+constexpr int64 kCacheLineSize = 64;
+
+template <typename T, bool conjugate>
+EIGEN_ALWAYS_INLINE T TransposeValue(const T& value) {
+  if (conjugate) {
+    return Eigen::numext::conj(value);
+  } else {
+    return value;
+  }
+}
+
+// Transposes the rows x cols matrix at `in`, whose rows are `in_stride` apart,
+// into the cols x rows matrix at `out`, whose rows are `out_stride` apart.
+template <typename T, bool conjugate>
+void TransposeMatrixSimple(const T* in, int64 in_stride, T* out,
+                           int64 out_stride, int64 rows, int64 cols) {
+  for (int64 j = 0; j < cols; ++j) {
+    for (int64 i = 0; i < rows; ++i) {
+      out[j * out_stride + i] =
+          TransposeValue<T, conjugate>(in[i * in_stride + j]);
+    }
+  }
+}
+
+// Transposes a kTileSize x kTileSize tile as blocks of kPacketSize packets of
+// Scalar, which are transposed with shuffles.
+template <typename Scalar>
+struct TransposeTileWithPackets {
+  typedef typename Eigen::internal::packet_traits<Scalar>::type Packet;
+  static constexpr int kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+  static constexpr bool kEnabled =
+      kPacketSize > 1 && kTileSize % kPacketSize == 0;
+
+  static void Run(const Scalar* in, int64 in_stride, Scalar* out,
+                  int64 out_stride) {
+    for (int64 i = 0; i < kTileSize; i += kPacketSize) {
+      for (int64 j = 0; j < kTileSize; j += kPacketSize) {
+        Eigen::internal::PacketBlock<Packet, kPacketSize> block;
+        for (int k = 0; k < kPacketSize; ++k) {
+          block.packet[k] = Eigen::internal::ploadu<Packet>(
+              in + (i + k) * in_stride + j);
+        }
+        Eigen::internal::ptranspose(block);
+        for (int k = 0; k < kPacketSize; ++k) {
+          Eigen::internal::pstoreu(out + (j + k) * out_stride + i,
+                                   block.packet[k]);
+        }
+      }
+    }
+  }
+};
+
+// Transposes a kTileSize x kTileSize tile. Only bits are moved, so 32 and 64
+// bit types are transposed as float and double packets when the packets tile
+// evenly, e.g. with SSE, AVX or NEON.
+template <typename T, bool conjugate>
+struct TransposeTile {
+  static void Run(const T* in, int64 in_stride, T* out, int64 out_stride) {
+    TransposeMatrixSimple<T, conjugate>(in, in_stride, out, out_stride,
+                                        kTileSize, kTileSize);
+  }
+};
+
+template <typename T, typename Scalar,
+          bool use_packets = TransposeTileWithPackets<Scalar>::kEnabled>
+struct TransposeTileAs {
+  static void Run(const T* in, int64 in_stride, T* out, int64 out_stride) {
+    TransposeMatrixSimple<T, false>(in, in_stride, out, out_stride, kTileSize,
+                                    kTileSize);
+  }
+};
+
+template <typename T, typename Scalar>
+struct TransposeTileAs<T, Scalar, true> {
+  static void Run(const T* in, int64 in_stride, T* out, int64 out_stride) {
+    static_assert(sizeof(T) == sizeof(Scalar), "Scalar must alias T");
+    TransposeTileWithPackets<Scalar>::Run(reinterpret_cast<const Scalar*>(in),
+                                          in_stride,
+                                          reinterpret_cast<Scalar*>(out),
+                                          out_stride);
+  }
+};
+
+template <>
+struct TransposeTile<uint32, false> : TransposeTileAs<uint32, float> {};
+template <>
+struct TransposeTile<uint64, false> : TransposeTileAs<uint64, double> {};
+
+// Same as TransposeMatrixSimple, tile by tile.
+template <typename T, bool conjugate>
+void TransposeMatrix(const T* in, int64 in_stride, T* out, int64 out_stride,
+                     int64 rows, int64 cols) {
+  int64 i = 0;
+  for (; i + kTileSize <= rows; i += kTileSize) {
+    int64 j = 0;
+    for (; j + kTileSize <= cols; j += kTileSize) {
+      TransposeTile<T, conjugate>::Run(in + i * in_stride + j, in_stride,
+                                       out + j * out_stride + i, out_stride);
+    }
+    TransposeMatrixSimple<T, conjugate>(in + i * in_stride + j, in_stride,
+                                        out + j * out_stride + i, out_stride,
+                                        kTileSize, cols - j);
+  }
+  TransposeMatrixSimple<T, conjugate>(in + i * in_stride, in_stride, out + i,
+                                      out_stride, rows - i, cols);
+}
+
+// Transposes `in` in tasks run by `device`, which handle either contiguous
+// rows, when the innermost dimension is not permuted, or cache blocks of a
+// matrix transpose of the innermost input dimension with the dimension that
+// becomes innermost in the output, made of kTileSize x kTileSize tiles.
+//
+// Dimensions of size 1 are dropped and dimensions that stay adjacent are
+// merged first, so e.g. NHWC -> NCHW becomes a batch of [H * W, C] matrix
+// transposes.
 template <typename T, bool conjugate>
-void TransposeSimple(const CPUDevice& device, const Tensor& in,
-                     const gtl::ArraySlice<int32> perm, Tensor* out) {
-  const int ndims = in.dims();
-  gtl::InlinedVector<int64, 8> in_strides = ComputeStride<int64>(in.shape());
-  gtl::InlinedVector<int64, 8> out_strides = ComputeStride<int64>(out->shape());
+void TransposeUsingTiles(const CPUDevice& device, const Tensor& in,
+                         const gtl::ArraySlice<int32> perm, Tensor* out) {
+  const int64 num_elements = in.NumElements();
+  if (num_elements == 0) return;
   const T* p = reinterpret_cast<const T*>(in.tensor_data().data());
   T* q = reinterpret_cast<T*>(const_cast<char*>((out->tensor_data().data())));
-  auto transpose_fn = [=, &in_strides, &out_strides, &perm](int64 begin,
-                                                            int64 end) {
-    for (int64 o_idx = begin; o_idx < end; ++o_idx) {
-      int64 i_idx = 0;
-      int64 t = o_idx;
-      for (int i = 0; i < ndims; ++i) {
-        const int64 ratio = t / out_strides[i];
-        t -= ratio * out_strides[i];
-        i_idx += ratio * in_strides[perm[i]];
+
+  // Drop the dimensions of size 1.
+  gtl::InlinedVector<int32, 8> squeezed_index(in.dims(), -1);
+  TensorShape squeezed_shape;
+  for (int i = 0; i < in.dims(); ++i) {
+    if (in.dim_size(i) == 1) continue;
+    squeezed_index[i] = squeezed_shape.dims();
+    squeezed_shape.AddDim(in.dim_size(i));
+  }
+  internal::TransposePermsVec squeezed_perm;
+  for (int32 d : perm) {
+    if (squeezed_index[d] >= 0) squeezed_perm.push_back(squeezed_index[d]);
+  }
+
+  internal::TransposePermsVec new_perm;
+  internal::TransposeDimsVec dims;
+  if (squeezed_shape.dims() >= 2) {
+    internal::ReduceTransposeDimensions(squeezed_shape, squeezed_perm,
+                                        &new_perm, &dims);
+  }
+  const int ndims = dims.size();
+  if (ndims < 2) {
+    // Nothing is permuted.
+    auto copy_fn = [p, q](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        q[i] = TransposeValue<T, conjugate>(p[i]);
       }
-      if (conjugate) {
-        q[o_idx] = Eigen::numext::conj(p[i_idx]);
-      } else {
-        q[o_idx] = p[i_idx];
+    };
+    device.parallelFor(num_elements,
+                       Eigen::TensorOpCost(sizeof(T), sizeof(T), 1),
+                       std::move(copy_fn));
+    return;
+  }
+
+  internal::TransposeDimsVec in_strides(ndims, 1);
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * dims[i + 1];
+  }
+  // Sizes and strides of the output dimensions.
+  internal::TransposeDimsVec out_dims(ndims);
+  internal::TransposeDimsVec out_in_strides(ndims);
+  for (int i = 0; i < ndims; ++i) {
+    out_dims[i] = dims[new_perm[i]];
+    out_in_strides[i] = in_strides[new_perm[i]];
+  }
+  internal::TransposeDimsVec out_strides(ndims, 1);
+  for (int i = ndims - 2; i >= 0; --i) {
+    out_strides[i] = out_strides[i + 1] * out_dims[i + 1];
+  }
+
+  if (new_perm[ndims - 1] == ndims - 1) {
+    // The innermost dimension is not permuted: copy rows of it, iterating over
+    // the outer output dimensions.
+    const int64 row_size = dims[ndims - 1];
+    auto copy_rows_fn = [=, &out_dims, &out_in_strides, &out_strides](
+                            int64 begin, int64 end) {
+      internal::TransposeDimsVec index(ndims - 1);
+      int64 in_offset = 0;
+      int64 t = begin * row_size;
+      for (int i = 0; i < ndims - 1; ++i) {
+        index[i] = t / out_strides[i];
+        t -= index[i] * out_strides[i];
+        in_offset += index[i] * out_in_strides[i];
+      }
+      for (int64 row = begin; row < end; ++row) {
+        const T* src = p + in_offset;
+        T* dst = q + row * row_size;
+        if (conjugate) {
+          for (int64 i = 0; i < row_size; ++i) {
+            dst[i] = TransposeValue<T, conjugate>(src[i]);
+          }
+        } else {
+          std::copy(src, src + row_size, dst);
+        }
+        for (int i = ndims - 2; i >= 0; --i) {
+          in_offset += out_in_strides[i];
+          if (++index[i] < out_dims[i]) break;
+          in_offset -= index[i] * out_in_strides[i];
+          index[i] = 0;
+        }
       }
+    };
+    device.parallelFor(num_elements / row_size,
+                       Eigen::TensorOpCost(row_size * sizeof(T),
+                                           row_size * sizeof(T), ndims),
+                       std::move(copy_rows_fn));
+    return;
+  }
+
+  // The innermost input dimension, of stride 1, becomes the output dimension
+  // `col_dim`, and the input dimension `row_dim` becomes innermost in the
+  // output, so that every other dimension indexes [rows, cols] matrices.
+  int col_dim = 0;
+  while (new_perm[col_dim] != ndims - 1) ++col_dim;
+  const int row_dim = new_perm[ndims - 1];
+  const int64 rows = dims[row_dim];
+  const int64 cols = dims[ndims - 1];
+  const int64 row_stride = in_strides[row_dim];
+  const int64 col_stride = out_strides[col_dim];
+  // The other output dimensions, in which the matrices are batched.
+  internal::TransposeDimsVec batch_dims;
+  internal::TransposeDimsVec batch_in_strides;
+  internal::TransposeDimsVec batch_out_strides;
+  for (int i = 0; i < ndims - 1; ++i) {
+    if (i == col_dim) continue;
+    batch_dims.push_back(out_dims[i]);
+    batch_in_strides.push_back(out_in_strides[i]);
+    batch_out_strides.push_back(out_strides[i]);
+  }
+
+  // Blocks span one cache line of many input rows, so that both the input
+  // lines and the longer output rows are fully used while they are in cache.
+  const int64 block_rows = 32 * kTileSize;
+  const int64 block_cols =
+      std::max<int64>(kTileSize, kCacheLineSize / sizeof(T));
+  const int64 row_blocks = MathUtil::CeilOfRatio(rows, block_rows);
+  const int64 col_blocks = MathUtil::CeilOfRatio(cols, block_cols);
+  const int64 num_blocks =
+      num_elements / (rows * cols) * row_blocks * col_blocks;
+  auto transpose_blocks_fn = [=, &batch_dims, &batch_in_strides,
+                              &batch_out_strides](int64 begin, int64 end) {
+    for (int64 block = begin; block < end; ++block) {
+      const int64 col_block = block % col_blocks;
+      const int64 row_block = block / col_blocks % row_blocks;
+      int64 batch = block / col_blocks / row_blocks;
+      int64 in_offset = 0;
+      int64 out_offset = 0;
+      for (int i = batch_dims.size() - 1; i >= 0; --i) {
+        const int64 index = batch % batch_dims[i];
+        batch /= batch_dims[i];
+        in_offset += index * batch_in_strides[i];
+        out_offset += index * batch_out_strides[i];
+      }
+      const int64 row = row_block * block_rows;
+      const int64 col = col_block * block_cols;
+      TransposeMatrix<T, conjugate>(
+          p + in_offset + row * row_stride + col, row_stride,
+          q + out_offset + col * col_stride + row, col_stride,
+          std::min(block_rows, rows - row), std::min(block_cols, cols - col));
     }
   };
-  double cycles_per_element =
-      (conjugate ? 1 : 0) + ndims * (Eigen::TensorOpCost::DivCost<int64>() +
-                                     2 * Eigen::TensorOpCost::MulCost<int64>() +
-                                     2 * Eigen::TensorOpCost::AddCost<int64>());
-  Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T),
-                           /*bytes_stored=*/sizeof(T), cycles_per_element);
-  device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
+  const int64 block_elements = block_rows * block_cols;
+  device.parallelFor(num_blocks,
+                     Eigen::TensorOpCost(block_elements * sizeof(T),
+                                         block_elements * sizeof(T),
+                                         block_elements),
+                     std::move(transpose_blocks_fn));
 }
 
 }  // namespace
@@ -71,39 +313,7 @@ template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
-    switch (in.dims()) {
-      case 2:
-        internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 3:
-        internal::TransposeUsingEigen<CPUDevice, T, 3>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 4:
-        internal::TransposeUsingEigen<CPUDevice, T, 4>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 5:
-        internal::TransposeUsingEigen<CPUDevice, T, 5>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 6:
-        internal::TransposeUsingEigen<CPUDevice, T, 6>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 7:
-        internal::TransposeUsingEigen<CPUDevice, T, 7>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 8:
-        internal::TransposeUsingEigen<CPUDevice, T, 8>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      default:
-        TransposeSimple<T, conjugate>(d, in, perm, out);
-        break;
-    }
+    TransposeUsingTiles<T, conjugate>(d, in, perm, out);
   }
 };
 
@@ -0,0 +1,243 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Transposes element by element.
+template <typename T>
+Tensor ReferenceTranspose(const Tensor& in, const std::vector<int32>& perm,
+                          bool conjugate) {
+  TensorShape out_shape;
+  for (int32 d : perm) out_shape.AddDim(in.dim_size(d));
+  Tensor out(in.dtype(), out_shape);
+  const int ndims = in.dims();
+  std::vector<int64> in_strides(ndims, 1);
+  std::vector<int64> out_strides(ndims, 1);
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * in.dim_size(i + 1);
+    out_strides[i] = out_strides[i + 1] * out_shape.dim_size(i + 1);
+  }
+  auto in_values = in.flat<T>();
+  auto out_values = out.flat<T>();
+  for (int64 o = 0; o < out.NumElements(); ++o) {
+    int64 i = 0;
+    int64 t = o;
+    for (int d = 0; d < ndims; ++d) {
+      i += t / out_strides[d] * in_strides[perm[d]];
+      t %= out_strides[d];
+    }
+    out_values(o) =
+        conjugate ? Eigen::numext::conj(in_values(i)) : in_values(i);
+  }
+  return out;
+}
+
+template <typename T>
+T TestValue(int i) {
+  return static_cast<T>(i % 251);
+}
+
+template <>
+complex64 TestValue<complex64>(int i) {
+  return complex64(i % 251, i % 13);
+}
+
+template <>
+complex128 TestValue<complex128>(int i) {
+  return complex128(i % 251, i % 13);
+}
+
+template <>
+tstring TestValue<tstring>(int i) {
+  return strings::StrCat(i);
+}
+
+class TransposeFunctorTest : public ::testing::Test {
+ protected:
+  TransposeFunctorTest()
+      : pool_(Env::Default(), "test", 4),
+        device_(pool_.AsEigenThreadPool(), 4) {}
+
+  // Checks DoTranspose against the reference for every permutation of the
+  // dimensions of `shape`.
+  template <typename T>
+  void CheckAllPermutations(const TensorShape& shape, bool conjugate = false) {
+    Tensor in(DataTypeToEnum<T>::value, shape);
+    test::FillFn<T>(&in, TestValue<T>);
+    std::vector<int32> perm(shape.dims());
+    std::iota(perm.begin(), perm.end(), 0);
+    do {
+      SCOPED_TRACE(strings::StrCat("shape ", shape.DebugString(), " perm ",
+                                   absl::StrJoin(perm, ",")));
+      Tensor out(in.dtype(),
+                 ReferenceTranspose<T>(in, perm, conjugate).shape());
+      if (conjugate) {
+        TF_ASSERT_OK(DoConjugateTranspose(device_, in, perm, &out));
+      } else {
+        TF_ASSERT_OK(DoTranspose(device_, in, perm, &out));
+      }
+      test::ExpectTensorEqual<T>(ReferenceTranspose<T>(in, perm, conjugate),
+                                 out);
+    } while (std::next_permutation(perm.begin(), perm.end()));
+  }
+
+  thread::ThreadPool pool_;
+  CPUDevice device_;
+};
+
+TEST_F(TransposeFunctorTest, Rank2) {
+  CheckAllPermutations<float>(TensorShape({1, 1}));
+  CheckAllPermutations<float>(TensorShape({7, 13}));
+  CheckAllPermutations<float>(TensorShape({300, 70}));
+  CheckAllPermutations<uint8>(TensorShape({300, 70}));
+  CheckAllPermutations<double>(TensorShape({300, 70}));
+}
+
+TEST_F(TransposeFunctorTest, Rank4) {
+  for (const TensorShape& shape :
+       {TensorShape({2, 5, 7, 3}), TensorShape({3, 17, 9, 33}),
+        TensorShape({2, 1, 130, 20}), TensorShape({4, 9, 1, 1})}) {
+    CheckAllPermutations<uint8>(shape);
+    CheckAllPermutations<int16>(shape);
+    CheckAllPermutations<float>(shape);
+    CheckAllPermutations<double>(shape);
+    CheckAllPermutations<complex64>(shape, /*conjugate=*/true);
+  }
+}
+
+TEST_F(TransposeFunctorTest, Rank5) {
+  CheckAllPermutations<float>(TensorShape({3, 4, 5, 6, 17}));
+  CheckAllPermutations<complex128>(TensorShape({2, 9, 1, 10, 11}));
+}
+
+TEST_F(TransposeFunctorTest, Strings) {
+  CheckAllPermutations<tstring>(TensorShape({3, 10, 9}));
+}
+
+TEST_F(TransposeFunctorTest, Empty) {
+  CheckAllPermutations<float>(TensorShape({2, 3, 0, 5}));
+}
+
+TEST_F(TransposeFunctorTest, MoreThanEightDimensions) {
+  const TensorShape shape({2, 1, 3, 2, 1, 2, 3, 2, 1, 2});
+  Tensor in(DT_FLOAT, shape);
+  test::FillIota<float>(&in, 0.0f);
+  const std::vector<int32> perm = {9, 3, 0, 7, 2, 8, 1, 6, 4, 5};
+  Tensor expected = ReferenceTranspose<float>(in, perm, false);
+  Tensor out(DT_FLOAT, expected.shape());
+  TF_ASSERT_OK(DoTranspose(device_, in, perm, &out));
+  test::ExpectTensorEqual<float>(expected, out);
+}
+
+// Performance benchmarks below.
+
+struct TransposeBenchmarkCase {
+  TensorShape shape;
+  std::vector<int32> perm;
+};
+
+// Permutations between the layouts of mixed layout graphs.
+const TransposeBenchmarkCase& GetTransposeBenchmarkCase(int index) {
+  static const auto* const kCases = new std::vector<TransposeBenchmarkCase>({
+      // NHWC -> NCHW.
+      {TensorShape({32, 56, 56, 64}), {0, 3, 1, 2}},
+      // NCHW -> NHWC.
+      {TensorShape({32, 64, 56, 56}), {0, 2, 3, 1}},
+      // NHWC -> NCHW of RGB images.
+      {TensorShape({32, 224, 224, 3}), {0, 3, 1, 2}},
+      // NDHWC -> NCDHW.
+      {TensorShape({8, 16, 32, 32, 64}), {0, 4, 1, 2, 3}},
+      // NCDHW -> NDHWC.
+      {TensorShape({8, 64, 16, 32, 32}), {0, 2, 3, 4, 1}},
+      // Splitting attention heads.
+      {TensorShape({32, 128, 16, 64}), {0, 2, 1, 3}},
+      // Matrix transpose.
+      {TensorShape({4096, 4096}), {1, 0}},
+  });
+  return (*kCases)[index];
+}
+
+template <int NDIMS>
+void TransposeUsingEigen(const CPUDevice& d, const Tensor& in,
+                         const std::vector<int32>& perm, Tensor* out) {
+  internal::TransposeUsingEigen<CPUDevice, float, NDIMS>(
+      d, in, perm, /*conjugate=*/false, out);
+}
+
+void BM_Transpose(int iters, int index, bool eigen) {
+  testing::StopTiming();
+  const TransposeBenchmarkCase& c = GetTransposeBenchmarkCase(index);
+  Tensor in(DT_FLOAT, c.shape);
+  in.flat<float>().setRandom();
+  TensorShape out_shape;
+  for (int32 d : c.perm) out_shape.AddDim(c.shape.dim_size(d));
+  Tensor out(DT_FLOAT, out_shape);
+
+  const int num_threads = port::MaxParallelism();
+  thread::ThreadPool pool(Env::Default(), "transpose", num_threads);
+  CPUDevice device(pool.AsEigenThreadPool(), num_threads);
+  testing::BytesProcessed(static_cast<int64>(iters) * 2 * in.TotalBytes());
+  testing::SetLabel(strings::StrCat(c.shape.DebugString(), " perm ",
+                                    absl::StrJoin(c.perm, ",")));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (!eigen) {
+      TF_CHECK_OK(DoTranspose(device, in, c.perm, &out));
+    } else if (c.shape.dims() == 2) {
+      TransposeUsingEigen<2>(device, in, c.perm, &out);
+    } else if (c.shape.dims() == 4) {
+      TransposeUsingEigen<4>(device, in, c.perm, &out);
+    } else {
+      TransposeUsingEigen<5>(device, in, c.perm, &out);
+    }
+  }
+}
+
+void BM_TransposeTiled(int iters, int index) {
+  BM_Transpose(iters, index, /*eigen=*/false);
+}
+
+void BM_TransposeEigen(int iters, int index) {
+  BM_Transpose(iters, index, /*eigen=*/true);
+}
+
+BENCHMARK(BM_TransposeTiled)
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(5)->Arg(6);
+BENCHMARK(BM_TransposeEigen)
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(5)->Arg(6);
+
+}  // namespace
+}  // namespace tensorflow
@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,12 +28,17 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+// The minimum number of elements per hash partition for which the unique
+// elements of a vector are found in parallel, one partition per thread.
+constexpr int64 kMinElementsPerPartition = 64 * 1024;
+
 // `UniqueOpHashMap` defines the map type that is used when elements of type
 // `T` are to be uniquified. By default, we use `absl::flat_hash_map<T, TIndex>`
 // as the map type. Subsequent specializations are provided for
@@ -149,27 +156,47 @@ class UniqueOp : public OpKernel {
       // to them as in the general case.
       auto Tin = input.flat<T>();
       const int64 N = static_cast<int64>(Tin.size());
+      auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+      const int num_partitions = static_cast<int>(std::min<int64>(
+          worker_threads->num_threads, N / kMinElementsPerPartition));
 
-      typename UniqueOpHashMap<T, TIndex>::map_type uniq;
-      uniq.reserve(2 * N);
-      for (Eigen::Index i = 0, j = 0; i < N; ++i) {
-        auto it = uniq.emplace(Tin(i), j);
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
+      if (num_partitions > 1) {
+        std::vector<int64> first_indices;
+        ParallelUnique(context, num_partitions, Tin, idx_vec, &first_indices);
+
+        uniq_size = static_cast<int64>(first_indices.size());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        auto Tout = output->flat<T>();
+
+        for (int64 j = 0; j < uniq_size; ++j) {
+          Tout(j) = Tin(first_indices[j]);
+        }
+      } else {
+        typename UniqueOpHashMap<T, TIndex>::map_type uniq;
+        uniq.reserve(2 * N);
+        for (Eigen::Index i = 0, j = 0; i < N; ++i) {
+          auto it = uniq.emplace(Tin(i), j);
+          idx_vec(i) = it.first->second;
+          if (it.second) {
+            ++j;
+          }
         }
-      }
 
-      uniq_size = static_cast<int64>(uniq.size());
-      TensorShape output_shape(input.shape());
-      output_shape.set_dim(axis, uniq_size);
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK(context,
-                     context->allocate_output(0, output_shape, &output));
-      auto Tout = output->flat<T>();
+        uniq_size = static_cast<int64>(uniq.size());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        auto Tout = output->flat<T>();
 
-      for (const auto& it : uniq) {
-        Tout(it.second) = it.first;
+        for (const auto& it : uniq) {
+          Tout(it.second) = it.first;
+        }
       }
     } else {
       // General implementation when unique is run over multiple elements.
@@ -237,6 +264,70 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Returns the partition of `value` among `num_partitions` partitions.
+  static int PartitionOf(const T& value, int num_partitions) {
+    // Multiplicative hashing spreads the identity hashes of integers.
+    const uint64 h =
+        static_cast<uint64>(hash<T>{}(value)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<int>(((h >> 32) * num_partitions) >> 32);
+  }
+
+  // Finds the unique elements of `Tin` with one hash map per partition of
+  // their hashes, which are filled in parallel, and numbers them in the order
+  // of their first occurrences, as the sequential implementation does. Sets
+  // `idx_vec`, and returns the index of the first occurrence of each unique
+  // element in `first_indices`.
+  static void ParallelUnique(OpKernelContext* context, int num_partitions,
+                             typename TTypes<T>::ConstFlat Tin,
+                             typename TTypes<TIndex>::Vec idx_vec,
+                             std::vector<int64>* first_indices) {
+    const int64 N = static_cast<int64>(Tin.size());
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+
+    std::vector<int32> partitions(N);
+    Shard(worker_threads->num_threads, worker_threads->workers, N,
+          /*cost_per_unit=*/20, [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              partitions[i] = PartitionOf(Tin(i), num_partitions);
+            }
+          });
+
+    // Numbers the unique elements of each partition in the order of their
+    // first occurrences, in `idx_vec`.
+    std::vector<uint8> is_first(N);
+    Shard(worker_threads->num_threads, worker_threads->workers, num_partitions,
+          /*cost_per_unit=*/N, [&](int64 begin, int64 end) {
+            for (int64 p = begin; p < end; ++p) {
+              typename UniqueOpHashMap<T, TIndex>::map_type uniq;
+              uniq.reserve(2 * N / num_partitions);
+              for (int64 i = 0; i < N; ++i) {
+                if (partitions[i] != p) continue;
+                const TIndex j = static_cast<TIndex>(uniq.size());
+                auto it = uniq.emplace(Tin(i), j);
+                idx_vec(i) = it.first->second;
+                is_first[i] = it.second;
+              }
+            }
+          });
+
+    // Renumbers the unique elements of all the partitions together, in the
+    // order of their first occurrences.
+    std::vector<std::vector<TIndex>> global_indices(num_partitions);
+    for (int64 i = 0; i < N; ++i) {
+      if (!is_first[i]) continue;
+      global_indices[partitions[i]].push_back(
+          static_cast<TIndex>(first_indices->size()));
+      first_indices->push_back(i);
+    }
+    Shard(worker_threads->num_threads, worker_threads->workers, N,
+          /*cost_per_unit=*/5, [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              idx_vec(i) = global_indices[partitions[i]][idx_vec(i)];
+            }
+          });
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
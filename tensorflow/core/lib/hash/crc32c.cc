@@ -263,6 +263,49 @@ uint32 Extend(uint32 crc, const char *buf, size_t size) {
   return l ^ 0xffffffffu;
 }
 
+namespace {
+
+// Reversed representation of the crc32c polynomial.
+constexpr uint32 kPolynomial = 0x82f63b78;
+
+// Returns a * b modulo the crc32c polynomial, in the reversed representation
+// where the highest bit is the coefficient of x^0.
+uint32 MultiplyModP(uint32 a, uint32 b) {
+  uint32 product = 0;
+  for (uint32 m = 1u << 31; m != 0; m >>= 1) {
+    if (a & m) product ^= b;
+    b = (b & 1) ? (b >> 1) ^ kPolynomial : b >> 1;
+  }
+  return product;
+}
+
+// Returns x^(8 * n) modulo the crc32c polynomial.
+uint32 ShiftByBytes(size_t n) {
+  // powers[k] is x^(2^k), so that powers[3] shifts by one byte.
+  static const uint32 *powers = [] {
+    // size_t has at most 64 bits, so k is at most 3 + 63.
+    uint32 *powers = new uint32[67];
+    powers[0] = 1u << 30;
+    for (int k = 1; k < 67; ++k) {
+      powers[k] = MultiplyModP(powers[k - 1], powers[k - 1]);
+    }
+    return powers;
+  }();
+  uint32 result = 1u << 31;
+  for (int k = 3; n != 0; n >>= 1, ++k) {
+    if (n & 1) result = MultiplyModP(powers[k], result);
+  }
+  return result;
+}
+
+}  // namespace
+
+uint32 Combine(uint32 crc_a, uint32 crc_b, size_t len_b) {
+  // Appending B to A shifts the crc32c of A by the length of B. The pre- and
+  // post-conditioning of the crc32c cancel out.
+  return MultiplyModP(ShiftByBytes(len_b), crc_a) ^ crc_b;
+}
+
 #if defined(PLATFORM_GOOGLE)
 uint32 Extend(uint32 crc, const absl::Cord &cord) {
   for (absl::string_view fragment : cord.Chunks()) {
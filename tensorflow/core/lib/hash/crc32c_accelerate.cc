@@ -16,20 +16,25 @@ limitations under the License.
 #include <stddef.h>
 #include <stdint.h>
 
-// SSE4.2 accelerated CRC32c.
+#include "tensorflow/core/lib/hash/crc32c.h"
 
-// See if the SSE4.2 crc32c instruction is available.
+// Hardware accelerated CRC32c: SSE4.2 on x86-64, the CRC32 extension on ARMv8.
+
+// See if the SSE4.2 crc32c instruction is available. The instructions are
+// enabled per function, so they do not require building with -msse4.2; their
+// use is guarded by a runtime check of the CPU.
 #undef USE_SSE_CRC32C
-#ifdef __SSE4_2__
+#undef USE_ARM_CRC32C
 #if defined(__x86_64__) && defined(__GNUC__) && \
-    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
 #define USE_SSE_CRC32C 1
 #elif defined(__x86_64__) && defined(__clang__)
 #if __has_builtin(__builtin_cpu_supports)
 #define USE_SSE_CRC32C 1
 #endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define USE_ARM_CRC32C 1
 #endif
-#endif /* __SSE4_2__ */
 
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
@@ -39,12 +44,20 @@ limitations under the License.
 
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#define CRC32C_U8(crc, v) _mm_crc32_u8(crc, v)
+#define CRC32C_U64(crc, v) _mm_crc32_u64(crc, v)
+#elif defined(USE_ARM_CRC32C)
+#include <arm_acle.h>
+#define CRC32C_TARGET
+#define CRC32C_U8(crc, v) __crc32cb(crc, v)
+#define CRC32C_U64(crc, v) __crc32cd(crc, v)
 #endif
 
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,10 +67,45 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
+#ifdef USE_SSE_CRC32C
 bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+#else
+// Building with the CRC32 extension requires a CPU that supports it.
+bool CanAccelerate() { return true; }
+#endif
 
-uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
+namespace {
+
+// Large buffers are processed as three interleaved streams of kStride bytes,
+// which hides the latency of the crc32 instruction, and the crcs of the
+// streams are then combined.
+constexpr size_t kStride = 1024;
+
+// Shifts a crc register by a fixed number of zero bytes, one byte of the
+// register at a time.
+struct ShiftTable {
+  explicit ShiftTable(size_t num_bytes) {
+    for (int k = 0; k < 4; ++k) {
+      for (uint32_t b = 0; b < 256; ++b) {
+        // Combine() shifts crc_a by len_b bytes.
+        table[k][b] = Combine(b << (8 * k), 0, num_bytes);
+      }
+    }
+  }
+
+  uint32_t Shift(uint32_t crc) const {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+           table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+  }
+
+  uint32_t table[4][256];
+};
+
+}  // namespace
+
+// Hardware optimized crc32c computation.
+CRC32C_TARGET uint32_t AcceleratedExtend(uint32_t crc, const char *buf,
+                                         size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
@@ -70,23 +118,42 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   if (x <= e) {
     // Process bytes until finished or p is 8-byte aligned
     while (p != x) {
-      l = _mm_crc32_u8(l, *p);
+      l = CRC32C_U8(l, *p);
       p++;
     }
   }
 
-  // Process bytes 16 at a time
   uint64_t l64 = l;
+  if ((e - p) >= 3 * kStride) {
+    static const ShiftTable *const one_stride = new ShiftTable(kStride);
+    static const ShiftTable *const two_strides = new ShiftTable(2 * kStride);
+    // Process bytes 3 * kStride at a time
+    do {
+      const uint8_t *p1 = p + kStride;
+      const uint8_t *p2 = p + 2 * kStride;
+      uint64_t l1 = 0;
+      uint64_t l2 = 0;
+      for (size_t i = 0; i < kStride; i += 8) {
+        l64 = CRC32C_U64(l64, *reinterpret_cast<const uint64_t *>(p + i));
+        l1 = CRC32C_U64(l1, *reinterpret_cast<const uint64_t *>(p1 + i));
+        l2 = CRC32C_U64(l2, *reinterpret_cast<const uint64_t *>(p2 + i));
+      }
+      l64 = two_strides->Shift(l64) ^ one_stride->Shift(l1) ^ l2;
+      p += 3 * kStride;
+    } while ((e - p) >= 3 * kStride);
+  }
+
+  // Process bytes 16 at a time
   while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
+    l64 = CRC32C_U64(l64, *reinterpret_cast<const uint64_t *>(p));
+    l64 = CRC32C_U64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
     p += 16;
   }
 
   // Process remaining bytes one at a time.
   l = l64;
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = CRC32C_U8(l, *p);
     p++;
   }
 
@@ -62,6 +62,41 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+TEST(CRC, LargeBuffers) {
+  // Large buffers are processed in interleaved streams by the accelerated
+  // code. Compares with the crc32c computed one byte at a time.
+  std::string input(20000, 0);
+  for (int i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<char>(i * 7 + (i >> 8));
+  }
+  for (size_t offset : {0, 1, 5}) {
+    for (size_t len : {3071, 3072, 3073, 9000, 19990}) {
+      uint32 expected = 0;
+      for (size_t i = 0; i < len; ++i) {
+        expected = Extend(expected, input.data() + offset + i, 1);
+      }
+      EXPECT_EQ(expected, Value(input.data() + offset, len))
+          << "offset: " << offset << " len: " << len;
+    }
+  }
+}
+
+TEST(CRC, Combine) {
+  ASSERT_EQ(Value("hello world", 11),
+            Combine(Value("hello ", 6), Value("world", 5), 5));
+  ASSERT_EQ(Value("hello", 5), Combine(Value("hello", 5), Value("", 0), 0));
+  ASSERT_EQ(Value("hello", 5), Combine(Value("", 0), Value("hello", 5), 5));
+
+  std::string input(100000, 'x');
+  for (int i = 0; i < input.size(); i += 3) input[i] = static_cast<char>(i);
+  for (size_t split : {1, 4096, 65537}) {
+    ASSERT_EQ(Value(input.data(), input.size()),
+              Combine(Value(input.data(), split),
+                      Value(input.data() + split, input.size() - split),
+                      input.size() - split));
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
@@ -0,0 +1,63 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A FilterPolicy summarizes the keys of each data block of a table into a
+// small filter, stored in the table, that tells whether a key may be in the
+// block.  Lookups of keys that are not in the table can then skip reading
+// the block.
+
+#ifndef TENSORFLOW_CORE_LIB_IO_FILTER_POLICY_H_
+#define TENSORFLOW_CORE_LIB_IO_FILTER_POLICY_H_
+
+#include <string>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+
+namespace tensorflow {
+namespace table {
+
+class FilterPolicy {
+ public:
+  virtual ~FilterPolicy();
+
+  // Return the name of this policy.  The name is stored in the table next to
+  // the filters, and a table is only read with the filters of a policy of
+  // the same name.  So the name must change if the encoding of the filters
+  // changes in an incompatible way.
+  virtual const char* Name() const = 0;
+
+  // keys[0,n-1] contains a list of keys (potentially with duplicates).
+  // Append a filter that summarizes keys[0,n-1] to *dst.
+  virtual void CreateFilter(const StringPiece* keys, int n,
+                            std::string* dst) const = 0;
+
+  // "filter" contains the data appended by a preceding call to
+  // CreateFilter() on this class.  Returns true if the key was in the list
+  // passed to CreateFilter(), and may return true or false otherwise.
+  virtual bool KeyMayMatch(const StringPiece& key,
+                           const StringPiece& filter) const = 0;
+};
+
+// Return a new filter policy that uses a bloom filter with approximately
+// the specified number of bits per key.  A good value for bits_per_key is
+// 10, which yields a filter with ~1% false positive rate.
+//
+// Callers must delete the result after any table using it has been closed.
+const FilterPolicy* NewBloomFilterPolicy(int bits_per_key);
+
+}  // namespace table
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_FILTER_POLICY_H_
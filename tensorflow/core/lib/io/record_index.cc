@@ -0,0 +1,106 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+
+string RecordIndexFilename(StringPiece filename) {
+  return strings::StrCat(filename, kRecordIndexSuffix);
+}
+
+/* static */ constexpr size_t RecordIndexWriter::kFooterSize;
+
+RecordIndexWriter::RecordIndexWriter(WritableFile* dest) : dest_(dest) {}
+
+Status RecordIndexWriter::AddRecord(uint64 offset) {
+  if (finished_) {
+    return errors::FailedPrecondition("Record index was already finished");
+  }
+  char encoded[sizeof(uint64)];
+  core::EncodeFixed64(encoded, offset);
+  crc_ = crc32c::Extend(crc_, encoded, sizeof(encoded));
+  ++num_records_;
+  return dest_->Append(StringPiece(encoded, sizeof(encoded)));
+}
+
+Status RecordIndexWriter::Finish() {
+  if (finished_) {
+    return Status::OK();
+  }
+  finished_ = true;
+  char footer[kFooterSize];
+  core::EncodeFixed64(footer, num_records_);
+  core::EncodeFixed32(footer + sizeof(uint64), crc32c::Mask(crc_));
+  core::EncodeFixed64(footer + sizeof(uint64) + sizeof(uint32),
+                      kRecordIndexMagic);
+  return dest_->Append(StringPiece(footer, sizeof(footer)));
+}
+
+Status ReadRecordIndex(Env* env, const string& filename,
+                       std::vector<uint64>* offsets) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  if (file_size < RecordIndexWriter::kFooterSize) {
+    return errors::DataLoss("Record index ", filename, " is truncated");
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+
+  char footer[RecordIndexWriter::kFooterSize];
+  StringPiece result;
+  TF_RETURN_IF_ERROR(file->Read(file_size - sizeof(footer), sizeof(footer),
+                                &result, footer));
+  if (result.size() != sizeof(footer) ||
+      core::DecodeFixed64(result.data() + sizeof(uint64) + sizeof(uint32)) !=
+          kRecordIndexMagic) {
+    return errors::DataLoss(filename, " is not a record index");
+  }
+  const uint64 num_records = core::DecodeFixed64(result.data());
+  const uint32 masked_crc = core::DecodeFixed32(result.data() + sizeof(uint64));
+  if (num_records != (file_size - sizeof(footer)) / sizeof(uint64) ||
+      (file_size - sizeof(footer)) % sizeof(uint64) != 0) {
+    return errors::DataLoss("Record index ", filename, " has ", file_size,
+                            " bytes, which does not match its ", num_records,
+                            " records");
+  }
+
+  std::unique_ptr<char[]> data(new char[num_records * sizeof(uint64)]);
+  TF_RETURN_IF_ERROR(
+      file->Read(0, num_records * sizeof(uint64), &result, data.get()));
+  if (result.size() != num_records * sizeof(uint64)) {
+    return errors::DataLoss("Record index ", filename, " is truncated");
+  }
+  if (crc32c::Unmask(masked_crc) !=
+      crc32c::Value(result.data(), result.size())) {
+    return errors::DataLoss("Corrupted record index ", filename);
+  }
+  offsets->clear();
+  offsets->reserve(num_records);
+  for (uint64 i = 0; i < num_records; ++i) {
+    offsets->push_back(core::DecodeFixed64(result.data() + i * sizeof(uint64)));
+  }
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+class WritableFile;
+
+namespace io {
+
+// A record index is an optional sidecar of a TFRecord file that lists the
+// offset of every record in the file, so that readers can seek to the n-th
+// record, skip records or split a file into shards without scanning it.
+//
+// The index of "<filename>" is stored in "<filename>.index". The offsets are
+// those of the uncompressed record stream, so they can only be used to seek
+// in uncompressed files.
+//
+// Format of an index:
+//  uint64    offset[num_records]
+//  uint64    num_records
+//  uint32    masked crc of offset[]
+//  uint64    magic number
+constexpr char kRecordIndexSuffix[] = ".index";
+constexpr uint64 kRecordIndexMagic = 0x7466726563696478ull;  // "tfrecidx"
+
+// Returns the name of the index of the TFRecord file `filename`.
+string RecordIndexFilename(StringPiece filename);
+
+// Writes a record index, one offset at a time.
+//
+// Note: this class is not thread safe; external synchronization required.
+class RecordIndexWriter {
+ public:
+  static constexpr size_t kFooterSize =
+      sizeof(uint64) + sizeof(uint32) + sizeof(uint64);
+
+  // Creates a writer that appends the index to "*dest".
+  // "*dest" must be initially empty.
+  // "*dest" must remain live while this writer is in use.
+  explicit RecordIndexWriter(WritableFile* dest);
+
+  // Appends the offset of the next record.
+  Status AddRecord(uint64 offset);
+
+  // Writes the footer of the index. Does *not* close the WritableFile.
+  //
+  // After calling Finish(), any further calls to `AddRecord()` are invalid.
+  Status Finish();
+
+ private:
+  WritableFile* dest_;
+  uint64 num_records_ = 0;
+  uint32 crc_ = 0;
+  bool finished_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordIndexWriter);
+};
+
+// Reads the record offsets stored in the index `filename` into `*offsets`.
+// Returns NOT_FOUND if the index does not exist, DATA_LOSS if it is
+// corrupted, or something else for an error.
+Status ReadRecordIndex(Env* env, const string& filename,
+                       std::vector<uint64>* offsets);
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
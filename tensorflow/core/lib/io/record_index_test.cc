@@ -0,0 +1,149 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+const std::vector<string>& Records() {
+  static const std::vector<string>* records = new std::vector<string>(
+      {"abc", "", "defghij", string(1000, 'x'), "klmnopqrstuvwxyz"});
+  return *records;
+}
+
+// Writes `Records()` to `filename` along with its index.
+void WriteRecords(const string& filename) {
+  Env* env = Env::Default();
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(env->NewWritableFile(filename, &file));
+  std::unique_ptr<WritableFile> index_file;
+  TF_ASSERT_OK(
+      env->NewWritableFile(RecordIndexFilename(filename), &index_file));
+  RecordWriter writer(file.get(), index_file.get());
+  for (const string& record : Records()) {
+    TF_ASSERT_OK(writer.WriteRecord(record));
+  }
+  TF_ASSERT_OK(writer.Close());
+  TF_ASSERT_OK(file->Close());
+  TF_ASSERT_OK(index_file->Close());
+}
+
+TEST(RecordIndexTest, Filename) {
+  EXPECT_EQ("/tmp/data.tfrecord.index",
+            RecordIndexFilename("/tmp/data.tfrecord"));
+}
+
+TEST(RecordIndexTest, RandomAccess) {
+  const string filename = JoinPath(testing::TmpDir(), "random_access");
+  WriteRecords(filename);
+
+  std::vector<uint64> offsets;
+  TF_ASSERT_OK(
+      ReadRecordIndex(Env::Default(), RecordIndexFilename(filename), &offsets));
+  ASSERT_EQ(Records().size(), offsets.size());
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+  RecordReader reader(file.get());
+  // Reads the records backwards, seeking to each one through the index.
+  for (int i = offsets.size() - 1; i >= 0; --i) {
+    uint64 offset = offsets[i];
+    tstring record;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(Records()[i], record);
+    if (i + 1 < offsets.size()) {
+      EXPECT_EQ(offsets[i + 1], offset);
+    }
+  }
+}
+
+TEST(RecordIndexTest, EmptyFile) {
+  const string filename = JoinPath(testing::TmpDir(), "empty");
+  Env* env = Env::Default();
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(env->NewWritableFile(filename, &file));
+  std::unique_ptr<WritableFile> index_file;
+  TF_ASSERT_OK(
+      env->NewWritableFile(RecordIndexFilename(filename), &index_file));
+  {
+    RecordWriter writer(file.get(), index_file.get());
+  }
+  TF_ASSERT_OK(index_file->Close());
+
+  std::vector<uint64> offsets = {1, 2};
+  TF_ASSERT_OK(ReadRecordIndex(env, RecordIndexFilename(filename), &offsets));
+  EXPECT_TRUE(offsets.empty());
+}
+
+TEST(RecordIndexTest, MissingIndex) {
+  std::vector<uint64> offsets;
+  EXPECT_TRUE(errors::IsNotFound(ReadRecordIndex(
+      Env::Default(), JoinPath(testing::TmpDir(), "missing.index"),
+      &offsets)));
+}
+
+TEST(RecordIndexTest, CorruptedIndex) {
+  const string filename = JoinPath(testing::TmpDir(), "corrupted");
+  WriteRecords(filename);
+  const string index_filename = RecordIndexFilename(filename);
+  Env* env = Env::Default();
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, index_filename, &contents));
+  std::vector<uint64> offsets;
+
+  // Flip a bit of an offset.
+  string corrupted = contents;
+  corrupted[sizeof(uint64)] ^= 0x1;
+  TF_ASSERT_OK(WriteStringToFile(env, index_filename, corrupted));
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadRecordIndex(env, index_filename, &offsets)));
+
+  // Drop an offset.
+  corrupted = contents.substr(sizeof(uint64));
+  TF_ASSERT_OK(WriteStringToFile(env, index_filename, corrupted));
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadRecordIndex(env, index_filename, &offsets)));
+
+  // Not an index at all.
+  TF_ASSERT_OK(WriteStringToFile(env, index_filename, "not an index"));
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadRecordIndex(env, index_filename, &offsets)));
+}
+
+TEST(RecordIndexTest, AddRecordAfterFinish) {
+  const string filename = JoinPath(testing::TmpDir(), "finished.index");
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(filename, &file));
+  RecordIndexWriter writer(file.get());
+  TF_ASSERT_OK(writer.AddRecord(0));
+  TF_ASSERT_OK(writer.Finish());
+  EXPECT_TRUE(errors::IsFailedPrecondition(writer.AddRecord(16)));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
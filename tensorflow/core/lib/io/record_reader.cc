@@ -241,6 +241,48 @@ Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
   return Status::OK();
 }
 
+MemmappedRecordReader::MemmappedRecordReader(
+    std::unique_ptr<ReadOnlyMemoryRegion> region)
+    : region_(std::move(region)) {}
+
+Status MemmappedRecordReader::ReadChecksummed(uint64 offset, size_t n,
+                                              StringPiece* result) {
+  const uint64 size = region_->length();
+  if (offset >= size) {
+    return errors::OutOfRange("eof");
+  }
+  if (n > size - offset || size - offset - n < sizeof(uint32)) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  const char* data = static_cast<const char*>(region_->data()) + offset;
+  const uint32 masked_crc = core::DecodeFixed32(data + n);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data, n)) {
+    return errors::DataLoss("corrupted record at ", offset);
+  }
+  *result = StringPiece(data, n);
+  return Status::OK();
+}
+
+Status MemmappedRecordReader::ReadRecord(uint64* offset, StringPiece* record) {
+  // Read header data.
+  TF_RETURN_IF_ERROR(ReadChecksummed(*offset, sizeof(uint64), record));
+  const uint64 length = core::DecodeFixed64(record->data());
+
+  // Read data
+  Status s = ReadChecksummed(*offset + RecordReader::kHeaderSize, length,
+                             record);
+  if (!s.ok()) {
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated record at ", *offset, "' failed with ",
+                           s.error_message());
+    }
+    return s;
+  }
+
+  *offset += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  return Status::OK();
+}
+
 SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
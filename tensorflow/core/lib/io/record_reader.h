@@ -31,6 +31,7 @@ limitations under the License.
 namespace tensorflow {
 
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -128,6 +129,33 @@ class RecordReader {
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
+// Reads uncompressed TFRecord files from a read-only memory region, e.g. a
+// memory-mapped local file.
+//
+// Records are returned as views into the region instead of being copied into
+// an intermediate buffer, and stay valid as long as the reader is alive. Each
+// record is checksummed as in RecordReader.
+//
+// Note: this class is not thread safe; external synchronization required.
+class MemmappedRecordReader {
+ public:
+  explicit MemmappedRecordReader(std::unique_ptr<ReadOnlyMemoryRegion> region);
+
+  // Points *record to the data of the record at "*offset" and updates
+  // *offset to point to the offset of the next record. Returns OK on
+  // success, OUT_OF_RANGE for end of file, or something else for an error.
+  Status ReadRecord(uint64* offset, StringPiece* record);
+
+ private:
+  // Points *result to the `n` bytes at `offset` after checking them against
+  // the masked crc that follows them.
+  Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result);
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedRecordReader);
+};
+
 // High-level interface to read TFRecord files.
 //
 // Note: this class is not thread safe; external synchronization required.
@@ -158,6 +158,74 @@ TEST(RecordReaderWriterTest, TestBasics) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestMemmapped) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  io::MemmappedRecordReader reader(std::move(region));
+  uint64 offset = 0;
+  StringPiece record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("", record);
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("defg", record);
+  EXPECT_EQ(GetFileSize(fname), offset);
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
+TEST(RecordReaderWriterTest, TestMemmappedCorruption) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_corrupt";
+  string contents;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abcdef"));
+    TF_CHECK_OK(writer.Close());
+  }
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+
+  // Flip a data byte.
+  string corrupted = contents;
+  corrupted[io::RecordReader::kHeaderSize] ^= 1;
+  TF_CHECK_OK(WriteStringToFile(env, fname, corrupted));
+  {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+    io::MemmappedRecordReader reader(std::move(region));
+    uint64 offset = 0;
+    StringPiece record;
+    EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecord(&offset, &record)));
+  }
+
+  // Drop the footer.
+  TF_CHECK_OK(WriteStringToFile(
+      env, fname,
+      contents.substr(0, contents.size() - io::RecordReader::kFooterSize)));
+  {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+    io::MemmappedRecordReader reader(std::move(region));
+    uint64 offset = 0;
+    StringPiece record;
+    EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecord(&offset, &record)));
+  }
+}
+
 TEST(RecordReaderWriterTest, TestSkipBasic) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_skip_basic_test";
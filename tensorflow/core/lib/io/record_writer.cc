@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/record_writer.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
@@ -87,6 +88,12 @@ RecordWriter::RecordWriter(WritableFile* dest,
 #endif
 }
 
+RecordWriter::RecordWriter(WritableFile* dest, WritableFile* index_dest,
+                           const RecordWriterOptions& options)
+    : RecordWriter(dest, options) {
+  index_writer_ = absl::make_unique<RecordIndexWriter>(index_dest);
+}
+
 RecordWriter::~RecordWriter() {
   if (dest_ != nullptr) {
     Status s = Close();
@@ -110,6 +117,7 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   char footer[kFooterSize];
   PopulateHeader(header, data.data(), data.size());
   PopulateFooter(footer, data.data(), data.size());
+  TF_RETURN_IF_ERROR(IndexRecord(data.size()));
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
   return dest_->Append(StringPiece(footer, sizeof(footer)));
@@ -130,14 +138,25 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
   char footer[kFooterSize];
   PopulateHeader(header, data);
   PopulateFooter(footer, data);
+  TF_RETURN_IF_ERROR(IndexRecord(data.size()));
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
   return dest_->Append(StringPiece(footer, sizeof(footer)));
 }
 #endif
 
+Status RecordWriter::IndexRecord(size_t n) {
+  if (index_writer_ == nullptr) return Status::OK();
+  TF_RETURN_IF_ERROR(index_writer_->AddRecord(offset_));
+  offset_ += kHeaderSize + n + kFooterSize;
+  return Status::OK();
+}
+
 Status RecordWriter::Close() {
   if (dest_ == nullptr) return Status::OK();
+  if (index_writer_ != nullptr) {
+    TF_RETURN_IF_ERROR(index_writer_->Finish());
+  }
   if (IsZlibCompressed(options_) || IsSnappyCompressed(options_)) {
     Status s = dest_->Close();
     delete dest_;
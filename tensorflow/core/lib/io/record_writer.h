@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/snappy/snappy_compression_options.h"
 #include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
@@ -71,6 +74,13 @@ class RecordWriter {
   RecordWriter(WritableFile* dest,
                const RecordWriterOptions& options = RecordWriterOptions());
 
+  // Create a writer that will append data to "*dest" and the offset of each
+  // record to the record index "*index_dest" (see record_index.h).
+  // "*dest" and "*index_dest" must be initially empty.
+  // "*dest" and "*index_dest" must remain live while this Writer is in use.
+  RecordWriter(WritableFile* dest, WritableFile* index_dest,
+               const RecordWriterOptions& options = RecordWriterOptions());
+
   // Calls Close() and logs if an error occurs.
   //
   // TODO(jhseu): Require that callers explicitly call Close() and remove the
@@ -88,7 +98,8 @@ class RecordWriter {
   // WritableFile.
   Status Flush();
 
-  // Writes all output to the file. Does *not* close the WritableFile.
+  // Writes all output to the file, and the footer of the record index if
+  // there is one. Does *not* close the WritableFiles.
   //
   // After calling Close(), any further calls to `WriteRecord()` or `Flush()`
   // are invalid.
@@ -108,8 +119,15 @@ class RecordWriter {
 #endif
 
  private:
+  // Appends the offset of the next record of `n` bytes to the index.
+  Status IndexRecord(size_t n);
+
   WritableFile* dest_;
   RecordWriterOptions options_;
+  // Only set when writing a record index.
+  std::unique_ptr<RecordIndexWriter> index_writer_;
+  // The offset of the next record in the uncompressed record stream.
+  uint64 offset_ = 0;
 
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
@@ -15,10 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/table.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/cache.h"
+#include "tensorflow/core/lib/io/filter_block.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/table_options.h"
 #include "tensorflow/core/lib/io/two_level_iterator.h"
@@ -28,12 +33,18 @@ namespace tensorflow {
 namespace table {
 
 struct Table::Rep {
-  ~Rep() { delete index_block; }
+  ~Rep() {
+    delete filter;
+    delete[] filter_data;
+    delete index_block;
+  }
 
   Options options;
   Status status;
   RandomAccessFile* file;
   uint64 cache_id;
+  FilterBlockReader* filter = nullptr;
+  const char* filter_data = nullptr;  // Owned by the rep if not null
 
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block* index_block;
@@ -72,8 +83,12 @@ Status Table::Open(const Options& options, RandomAccessFile* file, uint64 size,
     rep->file = file;
     rep->metaindex_handle = footer.metaindex_handle();
     rep->index_block = index_block;
-    rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
+    rep->cache_id = options.block_cache_id;
+    if (options.block_cache != nullptr && rep->cache_id == 0) {
+      rep->cache_id = options.block_cache->NewId();
+    }
     *table = new Table(rep);
+    (*table)->ReadMeta(footer);
   } else {
     if (index_block) delete index_block;
   }
@@ -81,6 +96,46 @@ Status Table::Open(const Options& options, RandomAccessFile* file, uint64 size,
   return s;
 }
 
+void Table::ReadMeta(const Footer& footer) {
+  if (rep_->options.filter_policy == nullptr) {
+    return;  // Do not need any metadata
+  }
+
+  BlockContents contents;
+  if (!ReadBlock(rep_->file, footer.metaindex_handle(), &contents).ok()) {
+    // Do not propagate errors since meta info is not needed for operation
+    return;
+  }
+  Block* meta = new Block(contents);
+
+  Iterator* iter = meta->NewIterator();
+  string key = "filter.";
+  key.append(rep_->options.filter_policy->Name());
+  iter->Seek(key);
+  if (iter->Valid() && iter->key() == StringPiece(key)) {
+    ReadFilter(iter->value());
+  }
+  delete iter;
+  delete meta;
+}
+
+void Table::ReadFilter(const StringPiece& filter_handle_value) {
+  StringPiece v = filter_handle_value;
+  BlockHandle filter_handle;
+  if (!filter_handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  BlockContents block;
+  if (!ReadBlock(rep_->file, filter_handle, &block).ok()) {
+    return;
+  }
+  if (block.heap_allocated) {
+    rep_->filter_data = block.data.data();  // Will need to delete later
+  }
+  rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
+}
+
 Table::~Table() { delete rep_; }
 
 static void DeleteBlock(void* arg, void* ignored) {
@@ -163,7 +218,7 @@ Status Table::InternalGet(const StringPiece& k, void* arg,
   Status s;
   Iterator* iiter = rep_->index_block->NewIterator();
   iiter->Seek(k);
-  if (iiter->Valid()) {
+  if (iiter->Valid() && BlockMayContain(iiter->value(), k)) {
     Iterator* block_iter = BlockReader(this, iiter->value());
     block_iter->Seek(k);
     if (block_iter->Valid()) {
@@ -179,6 +234,66 @@ Status Table::InternalGet(const StringPiece& k, void* arg,
   return s;
 }
 
+bool Table::BlockMayContain(const StringPiece& index_value,
+                            const StringPiece& key) const {
+  if (rep_->filter == nullptr) return true;
+  BlockHandle handle;
+  StringPiece input = index_value;
+  if (!handle.DecodeFrom(&input).ok()) return true;
+  return rep_->filter->KeyMayMatch(handle.offset(), key);
+}
+
+bool Table::KeyMayMatch(const StringPiece& key) const {
+  Iterator* index_iter = rep_->index_block->NewIterator();
+  index_iter->Seek(key);
+  const bool result = !index_iter->Valid()
+                          ? !index_iter->status().ok()
+                          : BlockMayContain(index_iter->value(), key);
+  delete index_iter;
+  return result;
+}
+
+Status Table::MultiGet(
+    const std::vector<StringPiece>& keys,
+    const std::function<void(size_t, const StringPiece&)>& found) const {
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  Status s;
+  Iterator* index_iter = rep_->index_block->NewIterator();
+  Iterator* block_iter = nullptr;
+  string block_handle;  // The index value of the block of block_iter.
+  for (size_t i : order) {
+    const StringPiece& key = keys[i];
+    index_iter->Seek(key);
+    if (!index_iter->Valid()) {
+      // This key, and all the following ones, are past the last block.
+      s = index_iter->status();
+      break;
+    }
+    if (!BlockMayContain(index_iter->value(), key)) continue;
+    if (block_iter == nullptr || index_iter->value() != block_handle) {
+      delete block_iter;
+      block_iter = BlockReader(const_cast<Table*>(this), index_iter->value());
+      block_handle.assign(index_iter->value().data(),
+                          index_iter->value().size());
+    }
+    block_iter->Seek(key);
+    if (!block_iter->status().ok()) {
+      s = block_iter->status();
+      break;
+    }
+    if (block_iter->Valid() && block_iter->key() == key) {
+      found(i, block_iter->value());
+    }
+  }
+  delete block_iter;
+  delete index_iter;
+  return s;
+}
+
 uint64 Table::ApproximateOffsetOf(const StringPiece& key) const {
   Iterator* index_iter = rep_->index_block->NewIterator();
   index_iter->Seek(key);
@@ -18,6 +18,9 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <functional>
+#include <vector>
+
 #include "tensorflow/core/lib/io/iterator.h"
 
 namespace tensorflow {
@@ -26,6 +29,7 @@ class RandomAccessFile;
 
 namespace table {
 
+class Footer;
 struct Options;
 
 // A Table is a sorted map from strings to strings.  Tables are
@@ -61,6 +65,20 @@ class Table {
   // be close to the file length.
   uint64 ApproximateOffsetOf(const StringPiece& key) const;
 
+  // Returns false if "key" is certainly not in the table, which the filter
+  // of its block tells without reading the block.  Returns true if the key
+  // may be in the table, including when the table has no filters.
+  bool KeyMayMatch(const StringPiece& key) const;
+
+  // Looks up all of "keys", and calls found(i, value) for every keys[i] that
+  // is in the table, in sorted key order.  Every block holding some of
+  // the keys is read once, and the blocks that the filters tell cannot hold
+  // any of them are not read at all.  Returns the first error reading a
+  // block, after which the remaining keys are not looked up.
+  Status MultiGet(
+      const std::vector<StringPiece>& keys,
+      const std::function<void(size_t, const StringPiece&)>& found) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -68,6 +86,14 @@ class Table {
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const StringPiece&);
 
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const StringPiece& filter_handle_value);
+
+  // Returns false if the filter tells that the block of "index_value", an
+  // encoded BlockHandle, does not hold "key".
+  bool BlockMayContain(const StringPiece& index_value,
+                       const StringPiece& key) const;
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
@@ -18,10 +18,13 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include "tensorflow/core/platform/types.h"
+
 namespace tensorflow {
 namespace table {
 
 class Cache;
+class FilterPolicy;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -68,6 +71,18 @@ struct Options {
 
   // If non-null, use the specified cache for blocks.
   Cache* block_cache = nullptr;
+
+  // The id of the blocks of the table in block_cache.  If zero, every
+  // opened table gets a new id.  Tables opened several times, from the same
+  // file, may pass the same non-zero id to share their cached blocks.  Tables
+  // with different contents must not share an id.
+  uint64 block_cache_id = 0;
+
+  // If non-null, the builder stores a filter of the keys of every block,
+  // created with this policy, and the table uses the filters of a policy
+  // with the same name to skip reading blocks that cannot hold a key.
+  // Tables built without filters, or with another policy, are read as usual.
+  const FilterPolicy* filter_policy = nullptr;
 };
 
 }  // namespace table
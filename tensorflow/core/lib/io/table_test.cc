@@ -24,10 +24,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -236,6 +238,7 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.filter_policy = options.filter_policy;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -247,6 +250,10 @@ class TableConstructor : public Constructor {
 
   uint64 BytesRead() const { return source_->BytesRead(); }
 
+  uint64 FileSize() const { return source_->Size(); }
+
+  const Table* table() const { return table_; }
+
  private:
   void Reset() {
     delete table_;
@@ -264,12 +271,20 @@ enum TestType { TABLE_TEST, BLOCK_TEST };
 struct TestArgs {
   TestType type;
   int restart_interval;
+  bool bloom_filter;
 };
 
 static const TestArgs kTestArgList[] = {
-    {TABLE_TEST, 16}, {TABLE_TEST, 1}, {TABLE_TEST, 1024},
-    {BLOCK_TEST, 16}, {BLOCK_TEST, 1}, {BLOCK_TEST, 1024},
+    {TABLE_TEST, 16, false},  {TABLE_TEST, 1, false},
+    {TABLE_TEST, 1024, false}, {TABLE_TEST, 16, true},
+    {BLOCK_TEST, 16, false},  {BLOCK_TEST, 1, false},
+    {BLOCK_TEST, 1024, false},
 };
+
+static const FilterPolicy* BloomPolicy() {
+  static const FilterPolicy* policy = NewBloomFilterPolicy(10);
+  return policy;
+}
 static const int kNumTestArgs = sizeof(kTestArgList) / sizeof(kTestArgList[0]);
 
 class Harness : public ::testing::Test {
@@ -285,6 +300,9 @@ class Harness : public ::testing::Test {
     // Use shorter block size for tests to exercise block boundary
     // conditions more.
     options_.block_size = 256;
+    if (args.bloom_filter) {
+      options_.filter_policy = BloomPolicy();
+    }
     switch (args.type) {
       case TABLE_TEST:
         constructor_ = new TableConstructor();
@@ -633,5 +651,80 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+// Builds a table of the keys k0000 to k<n - 1> with 100 byte values, in
+// blocks of about 1KB.
+static void BuildNumberedTable(TableConstructor* c, int n,
+                               const FilterPolicy* policy) {
+  for (int i = 0; i < n; ++i) {
+    c->Add(strings::Printf("k%04d", i), string(100, 'a' + i % 26));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  options.filter_policy = policy;
+  c->Finish(options, &keys, &kvmap);
+}
+
+TEST(TableTest, FilterExcludesMissingKeys) {
+  TableConstructor c;
+  BuildNumberedTable(&c, 1000, BloomPolicy());
+  const uint64 bytes_read = c.BytesRead();
+  int false_positives = 0;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(c.table()->KeyMayMatch(strings::Printf("k%04d", i)));
+    if (c.table()->KeyMayMatch(strings::Printf("k%04da", i))) {
+      ++false_positives;
+    }
+  }
+  // 10 bits per key give about 1% of false positives.
+  EXPECT_LT(false_positives, 50);
+  // The filters are read with the table, the blocks are never read.
+  EXPECT_EQ(c.BytesRead(), bytes_read);
+  EXPECT_FALSE(c.table()->KeyMayMatch("z"));
+}
+
+TEST(TableTest, KeyMayMatchWithoutFilter) {
+  TableConstructor c;
+  BuildNumberedTable(&c, 100, nullptr);
+  EXPECT_TRUE(c.table()->KeyMayMatch("k0010"));
+  EXPECT_TRUE(c.table()->KeyMayMatch("k0010a"));
+  EXPECT_FALSE(c.table()->KeyMayMatch("z"));
+}
+
+TEST(TableTest, MultiGet) {
+  const FilterPolicy* no_policy = nullptr;
+  for (const FilterPolicy* policy : {BloomPolicy(), no_policy}) {
+    TableConstructor c;
+    BuildNumberedTable(&c, 1000, policy);
+    std::vector<string> key_strings;
+    for (int i = 999; i >= 0; i -= 3) {
+      key_strings.push_back(strings::Printf("k%04d", i));
+      key_strings.push_back(strings::Printf("k%04da", i));
+    }
+    key_strings.push_back("z");
+    std::vector<StringPiece> keys(key_strings.begin(), key_strings.end());
+
+    const uint64 bytes_read = c.BytesRead();
+    std::vector<string> values(keys.size());
+    Status s = c.table()->MultiGet(
+        keys, [&values](size_t i, const StringPiece& value) {
+          values[i] = string(value);
+        });
+    ASSERT_TRUE(s.ok()) << s;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (i % 2 == 0 && i + 1 < keys.size()) {
+        const int n = 999 - 3 * (i / 2);
+        EXPECT_EQ(values[i], string(100, 'a' + n % 26)) << keys[i];
+      } else {
+        EXPECT_TRUE(values[i].empty()) << keys[i];
+      }
+    }
+    // Every block holds a requested key, and is read once.
+    EXPECT_LT(c.BytesRead() - bytes_read, c.FileSize());
+  }
+}
+
 }  // namespace table
 }  // namespace tensorflow
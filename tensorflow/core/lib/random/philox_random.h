@@ -190,6 +190,50 @@ class PhiloxRandom {
     return counter;
   }
 
+  // Returns the next kBatchSize groups of four random numbers in `results`,
+  // the same as kBatchSize calls of operator() would. The rounds of all the
+  // groups are run in lockstep on arrays of their counters, so that the
+  // compiler vectorizes the multiplications across groups (eight groups per
+  // instruction with AVX2, sixteen with AVX-512). Only available on the host.
+  template <int kBatchSize>
+  void GenerateBatch(ResultType* results) {
+    uint32 c0[kBatchSize];
+    uint32 c1[kBatchSize];
+    uint32 c2[kBatchSize];
+    uint32 c3[kBatchSize];
+    // The counter of group i is counter_ + i, with the carries propagated
+    // without branches.
+    for (int i = 0; i < kBatchSize; ++i) {
+      c0[i] = counter_[0] + static_cast<uint32>(i);
+      c1[i] = counter_[1] + (c0[i] < counter_[0]);
+      c2[i] = counter_[2] + (c1[i] < counter_[1]);
+      c3[i] = counter_[3] + (c2[i] < counter_[2]);
+    }
+    Skip(kBatchSize);
+
+    uint32 key0 = key_[0];
+    uint32 key1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        const uint64 product0 = static_cast<uint64>(kPhiloxM4x32A) * c0[i];
+        const uint64 product1 = static_cast<uint64>(kPhiloxM4x32B) * c2[i];
+        c0[i] = static_cast<uint32>(product1 >> 32) ^ c1[i] ^ key0;
+        c1[i] = static_cast<uint32>(product1);
+        c2[i] = static_cast<uint32>(product0 >> 32) ^ c3[i] ^ key1;
+        c3[i] = static_cast<uint32>(product0);
+      }
+      key0 += kPhiloxW32A;
+      key1 += kPhiloxW32B;
+    }
+
+    for (int i = 0; i < kBatchSize; ++i) {
+      results[i][0] = c0[i];
+      results[i][1] = c1[i];
+      results[i][2] = c2[i];
+      results[i][3] = c3[i];
+    }
+  }
+
  private:
   // We use the same constants as recommended by the original paper.
   static constexpr uint32 kPhiloxW32A = 0x9E3779B9;
@@ -252,6 +296,34 @@ class PhiloxRandom {
   Key key_;
 };
 
+// A generator which returns the same stream of groups as the PhiloxRandom it
+// is constructed from, but computes them kBatchSize groups at a time with
+// PhiloxRandom::GenerateBatch(). The distributions accept it in place of a
+// PhiloxRandom. Only available on the host.
+template <int kBatchSize>
+class BatchedPhiloxRandom {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+  using ResultElementType = PhiloxRandom::ResultElementType;
+  static constexpr int kResultElementCount = PhiloxRandom::kResultElementCount;
+
+  explicit BatchedPhiloxRandom(const PhiloxRandom& gen) : gen_(gen) {}
+
+  ResultType operator()() {
+    if (next_ == kBatchSize) {
+      gen_.GenerateBatch<kBatchSize>(batch_);
+      next_ = 0;
+    }
+    return batch_[next_++];
+  }
+
+ private:
+  PhiloxRandom gen_;
+  ResultType batch_[kBatchSize];
+  // The index of the next group of batch_ to return.
+  int next_ = kBatchSize;
+};
+
 }  // namespace random
 }  // namespace tensorflow
 
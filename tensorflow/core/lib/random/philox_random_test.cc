@@ -68,6 +68,30 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// This test checks that generating samples in batches, across a counter
+// carry, is equivalent to generating them one group at a time.
+TEST(PhiloxRandomTest, BatchMatchTest) {
+  constexpr int kBatchSize = 16;
+  constexpr int kBatchCount = 4;
+
+  PhiloxRandom::ResultType counter;
+  counter[0] = 0xFFFFFFF0u;
+  counter[1] = 0xFFFFFFFFu;
+  PhiloxRandom::Key key;
+  key[0] = static_cast<uint32>(GetTestSeed());
+  key[1] = static_cast<uint32>(GetTestSeed() >> 32);
+
+  PhiloxRandom gen(counter, key);
+  BatchedPhiloxRandom<kBatchSize> batched_gen(gen);
+  for (int i = 0; i < kBatchSize * kBatchCount; ++i) {
+    PhiloxRandom::ResultType expected = gen();
+    PhiloxRandom::ResultType actual = batched_gen();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(expected[j], actual[j]) << i << " " << j;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
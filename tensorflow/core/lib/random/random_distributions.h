@@ -58,7 +58,9 @@ PHILOX_DEVICE_INLINE Int SignedAdd(Int a,
 //   Generator: a generator type that returns a number of uint32 upon each
 //              invocation. It needs to define kResultElementCount for the
 //              sample count for each invocation, and ResultType for the
-//              actual returned sample type.
+//              actual returned sample type. operator() also accepts any other
+//              generator with the same ResultType, such as a
+//              BatchedPhiloxRandom in place of a PhiloxRandom.
 //   RealType: the data type of the real numbers that will be returned by the
 //             distribution. This could be either float or double for now.
 // This class is meant to be implemented through specialization. The default
@@ -79,8 +81,8 @@ class UniformDistribution<Generator, Eigen::half> {
   typedef Array<Eigen::half, kResultElementCount> ResultType;
   typedef Eigen::half ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -103,8 +105,8 @@ class UniformDistribution<Generator, bfloat16> {
   typedef Array<bfloat16, kResultElementCount> ResultType;
   typedef bfloat16 ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -127,8 +129,8 @@ class UniformDistribution<Generator, float> {
   typedef Array<float, kResultElementCount> ResultType;
   typedef float ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -151,8 +153,8 @@ class UniformDistribution<Generator, double> {
   typedef Array<double, kResultElementCount> ResultType;
   typedef double ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -179,8 +181,8 @@ class UniformDistribution<Generator, int32> {
   UniformDistribution(int32 lo, int32 hi)
       : lo_(lo), range_(static_cast<uint32>(hi) - static_cast<uint32>(lo)) {}
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -214,8 +216,8 @@ class UniformDistribution<Generator, int64> {
   UniformDistribution(int64 lo, int64 hi)
       : lo_(lo), range_(static_cast<uint64>(hi) - static_cast<uint64>(lo)) {}
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -252,8 +254,8 @@ class UniformFullIntDistribution32 {
   typedef Array<IntType, kResultElementCount> ResultType;
   typedef IntType ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -276,8 +278,8 @@ class UniformFullIntDistribution64 {
   typedef Array<IntType, kResultElementCount> ResultType;
   typedef IntType ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -399,8 +401,8 @@ class NormalDistribution<Generator, Eigen::half> {
   typedef Array<Eigen::half, kResultElementCount> ResultType;
   typedef Eigen::half ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -426,8 +428,8 @@ class NormalDistribution<Generator, bfloat16> {
   typedef Array<bfloat16, kResultElementCount> ResultType;
   typedef bfloat16 ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     static_assert(kResultElementCount % 2 == 0,
@@ -456,8 +458,8 @@ class NormalDistribution<Generator, float> {
   typedef Array<float, kResultElementCount> ResultType;
   typedef float ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -480,8 +482,8 @@ class NormalDistribution<Generator, double> {
   typedef Array<double, kResultElementCount> ResultType;
   typedef double ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
 #elif TENSORFLOW_USE_ROCM
@@ -117,6 +118,10 @@ struct NcclManager::Communicator {
   const int num_devices;
   std::vector<CommunicatorMember> members;
   const string key;
+  // The number of collectives assigned to this communicator, used to balance
+  // single-node collectives over communicators on the same devices. Guarded
+  // by the mutex of the containing NcclManager.
+  int64 num_collectives = 0;
 };
 
 namespace {
@@ -148,6 +153,36 @@ void StringToNcclUniqueId(const string& str_id, ncclUniqueId* nccl_id) {
   }
 }
 
+int ReadPositiveIntFromEnvVar(StringPiece env_var_name) {
+  int64 value;
+  TF_CHECK_OK(ReadInt64FromEnvVar(env_var_name, 1, &value));
+  if (value < 1) {
+    LOG(ERROR) << "Ignoring " << env_var_name << "=" << value
+               << ", which is not positive.";
+    return 1;
+  }
+  return static_cast<int>(value);
+}
+
+int NumCommunicators() {
+#if TENSORFLOW_USE_ROCM
+  // On ROCm, every communicator of a device borrows the nccl stream of the
+  // device context, so more communicators would not run concurrently.
+  return 1;
+#else
+  return ReadPositiveIntFromEnvVar("TF_NCCL_NUM_COMMUNICATORS");
+#endif
+}
+
+int MaxGroupLaunches() {
+#if NCCL_MAJOR >= 2
+  return ReadPositiveIntFromEnvVar("TF_NCCL_MAX_GROUP_LAUNCHES");
+#else
+  // NCCL 1 has no group primitives.
+  return 1;
+#endif
+}
+
 }  // namespace
 
 // A `Collective` encapsulates state for a collective instance at one node.
@@ -225,8 +260,12 @@ struct NcclManager::Collective : public core::RefCounted {
   Status status;
 };
 
-NcclManager::NcclManager() {
-  VLOG(2) << "New NcclManager " << this;
+NcclManager::NcclManager()
+    : num_communicators_(NumCommunicators()),
+      max_group_launches_(MaxGroupLaunches()) {
+  VLOG(2) << "New NcclManager " << this << " num_communicators "
+          << num_communicators_ << " max_group_launches "
+          << max_group_launches_;
 #if TENSORFLOW_USE_ROCM
   ++instance_count;
 #endif
@@ -285,6 +324,10 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     return status_;
   }
 
+  // The streams that the new communicator must not share: those of its other
+  // members, and those of the communicators on the same devices.
+  std::set<NcclStream*> used_streams;
+  int num_matching_communicators = 0;
   if (collective->communicator_key.empty()) {
     // For single-node collectives, when the caller does not specify a
     // `communicator_key`, we identify a communicator uniquely by the set of
@@ -301,14 +344,21 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     // Since it's expected that a small number of distinct communicators will
     // be needed, communicators_ is not garbage collected currently.
     //
+    // Up to `num_communicators_` communicators are created for the same
+    // devices, each on its own communication streams, and collectives are
+    // assigned to the least used one, so that independent collectives can run
+    // concurrently.
+    //
     // Launching of kernels must be serialized so that, given collectives A and
     // B, and an order of them (e.g., A before B), then for each comm_stream
     // involved, the kernel for A is launched before the kernel for B. This is
     // guaranteed currently by a global mutex controlling additions of the
     // kernels to per-stream launch queues.  The launch queues are processed by
     // LoopKernelLaunches.
+    Communicator* least_used = nullptr;
     for (auto& comm : communicators_) {
-      if (comm->num_devices == collective->num_global_devices) {
+      if (comm->num_devices == collective->num_global_devices &&
+          comm->key.empty()) {
         int i;
         for (i = 0; i < collective->num_local_devices; ++i) {
           if (comm->members[i].nccl_stream->executor !=
@@ -317,11 +367,22 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
           }
         }
         if (i == collective->num_local_devices) {
-          *communicator = comm.get();
-          return Status::OK();
+          ++num_matching_communicators;
+          for (const CommunicatorMember& member : comm->members) {
+            used_streams.insert(member.nccl_stream);
+          }
+          if (least_used == nullptr ||
+              comm->num_collectives < least_used->num_collectives) {
+            least_used = comm.get();
+          }
         }
       }
     }
+    if (num_matching_communicators >= num_communicators_) {
+      ++least_used->num_collectives;
+      *communicator = least_used;
+      return Status::OK();
+    }
   } else {
 #if NCCL_MAJOR < 2
     return errors::Internal(
@@ -344,7 +405,6 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   }
 
   auto* env = Env::Default();
-  std::set<NcclStream*> used_streams;
 
   // Create and initialize a new communicator.
   // Note that this is done under the lock; performance is not expected to
@@ -426,6 +486,7 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   communicators_.emplace_back(
       new Communicator(std::move(members), collective->communicator_key));
   *communicator = communicators_.back().get();
+  ++(*communicator)->num_collectives;
   return Status::OK();
 }
 
@@ -695,19 +756,134 @@ size_t ComputeBufferSize(const NcclManager::Participant* p,
 }
 }  // namespace
 
-void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
+Status NcclManager::LaunchKernel(Collective* collective, int p_idx,
+                                 NcclStream* nccl_stream) {
 #if TENSORFLOW_USE_ROCM
   se::Stream* comm_stream = nccl_stream->stream;
 #else
   se::Stream* comm_stream = nccl_stream->stream.get();
 #endif
-  ScopedActivateExecutorContext scoped_context(nccl_stream->executor);
   const cudaStream_t* cu_stream = reinterpret_cast<const cudaStream_t*>(
       comm_stream->implementation()->GpuStreamMemberHack());
 
+  ncclDataType_t data_type = ToNcclType(collective->data_type);
+  Participant* p = collective->participants[p_idx].get();
+  auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
+  ncclResult_t nccl_result = ncclSuccess;
+  switch (collective->type) {
+    case kAllReduce: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+
+      VLOG(2) << "call NcclAllReduce collective_key "
+              << collective->collective_key << " participant " << p_idx
+              << " num_participants " << collective->participants.size()
+              << " sendbuff " << sendbuff << " recvbuff " << recvbuff
+              << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
+              << " cuda_stream " << cu_stream;
+      profiler::AnnotatedTraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "ncclAllReduce",
+            {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
+             {"collective_type", "all_reduce"}});
+      });
+      nccl_result = ncclAllReduce(sendbuff, recvbuff, p->input->NumElements(),
+                                  data_type, collective->reduction_op,
+                                  nccl_comm, *cu_stream);
+      break;
+    }
+    case kBroadcast: {
+      const void* sendbuff = nullptr;
+      void* recvbuff = nullptr;
+      int num_elements = -1;
+      if (p->input) {
+        sendbuff = p->input->tensor_data().data();
+        num_elements = p->input->NumElements();
+      }
+      if (p->output) {
+        recvbuff = const_cast<char*>(p->output->tensor_data().data());
+        num_elements = p->output->NumElements();
+      } else {
+        // Operate in-place if no output (for the src node).
+        recvbuff = const_cast<void*>(sendbuff);
+      }
+      if (num_elements < 0) {
+        return errors::Internal(
+            "Both input and output are null in ncclBroadcast");
+      }
+      VLOG(2) << "call NcclBroadcast collective_key "
+              << collective->collective_key << " participant " << p_idx
+              << " sendbuff " << sendbuff << " recvbuff " << recvbuff
+              << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
+              << " cuda_stream " << cu_stream;
+      profiler::AnnotatedTraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "ncclBroadcast",
+            {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
+             {"collective_type", "broadcast"}});
+      });
+      nccl_result =
+          ncclBroadcast(sendbuff, recvbuff, num_elements, data_type,
+                        collective->root_rank, nccl_comm, *cu_stream);
+      break;
+    }
+    case kReduce: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff =
+          p->output ? const_cast<char*>(p->output->tensor_data().data())
+                    : nullptr;
+      profiler::AnnotatedTraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "buffer_size",
+            {{"output_size", ComputeBufferSize(p, collective->data_type)},
+             {"collective_type", "reduce"}});
+      });
+      nccl_result = ncclReduce(sendbuff, recvbuff, p->input->NumElements(),
+                               data_type, collective->reduction_op,
+                               collective->root_rank, nccl_comm, *cu_stream);
+      break;
+    }
+    case kAllGather: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+
+      VLOG(2) << "call NcclAllGather collective_key "
+              << collective->collective_key << " participant " << p_idx
+              << " sendbuff " << sendbuff << " sendcount "
+              << p->input->NumElements() << " recvbuff " << recvbuff
+              << " recvcount " << p->output->NumElements() << " nccl_comm "
+              << nccl_comm << " comm_stream " << comm_stream
+              << " cuda_stream " << cu_stream;
+      profiler::AnnotatedTraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "ncclAllGather",
+            {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
+             {"collective_type", "all_gather"}});
+      });
+      nccl_result = ncclAllGather(sendbuff, recvbuff, p->input->NumElements(),
+                                  data_type, nccl_comm, *cu_stream);
+      break;
+    }
+  }
+  if (nccl_result != ncclSuccess) {
+    return errors::Unknown("Error invoking NCCL: ",
+                           ncclGetErrorString(nccl_result));
+  }
+  return Status::OK();
+}
+
+void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
+#if TENSORFLOW_USE_ROCM
+  se::Stream* comm_stream = nccl_stream->stream;
+#else
+  se::Stream* comm_stream = nccl_stream->stream.get();
+#endif
+  ScopedActivateExecutorContext scoped_context(nccl_stream->executor);
+
   while (true) {
-    // Find collective to run.
-    std::pair<Collective*, int> next_launch;
+    // Find the collectives to run: up to `max_group_launches_` of those ready,
+    // in the order they became ready.
+    std::vector<std::pair<Collective*, int>> launches;
     {
       VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
       mutex_lock l(nccl_stream->mu);
@@ -718,134 +894,63 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         }
         nccl_stream->cv.wait(l);
       }
-      next_launch = nccl_stream->pending_launches_.back();
-      nccl_stream->pending_launches_.pop_back();
+      while (!nccl_stream->pending_launches_.empty() &&
+             launches.size() < static_cast<size_t>(max_group_launches_)) {
+        launches.push_back(nccl_stream->pending_launches_.back());
+        nccl_stream->pending_launches_.pop_back();
+      }
     }
 
-    // Launch the nccl kernel.
-    Collective* collective = next_launch.first;
-    tensorflow::profiler::TraceMeConsumer traceme("Run Collective",
-                                                  collective->trace_context);
-
-    ncclDataType_t data_type = ToNcclType(collective->data_type);
-    int p_idx = next_launch.second;
-    Participant* p = collective->participants[p_idx].get();
-    auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
-    ncclResult_t nccl_result = ncclSuccess;
-    switch (collective->type) {
-      case kAllReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
-
-        VLOG(2) << "call NcclAllReduce collective_key "
-                << collective->collective_key << " participant " << p_idx
-                << " num_participants " << collective->participants.size()
-                << " sendbuff " << sendbuff << " recvbuff " << recvbuff
-                << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
-                << " cuda_stream " << cu_stream;
-        profiler::AnnotatedTraceMe traceme([&] {
-          return profiler::TraceMeEncode(
-              "ncclAllReduce",
-              {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
-               {"collective_type", "all_reduce"}});
-        });
-        nccl_result = ncclAllReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                    data_type, collective->reduction_op,
-                                    nccl_comm, *cu_stream);
-        break;
-      }
-      case kBroadcast: {
-        const void* sendbuff = nullptr;
-        void* recvbuff = nullptr;
-        int num_elements = -1;
-        if (p->input) {
-          sendbuff = p->input->tensor_data().data();
-          num_elements = p->input->NumElements();
-        }
-        if (p->output) {
-          recvbuff = const_cast<char*>(p->output->tensor_data().data());
-          num_elements = p->output->NumElements();
-        } else {
-          // Operate in-place if no output (for the src node).
-          recvbuff = const_cast<void*>(sendbuff);
-        }
-        if (num_elements < 0) {
-          p->done_callback(errors::Internal(
-              "Both input and output are null in ncclBroadcast"));
-          collective->Unref();
-          continue;
+    // Launch the nccl kernels. Several kernels are launched as one group, so
+    // that NCCL can batch them.
+    std::vector<Status> statuses;
+    statuses.reserve(launches.size());
+#if NCCL_MAJOR >= 2
+    const bool grouped = launches.size() > 1;
+    ncclResult_t group_result = ncclSuccess;
+    if (grouped) {
+      VLOG(2) << "ncclGroupStart for " << launches.size() << " kernels";
+      group_result = ncclGroupStart();
+    }
+#endif
+    for (const auto& launch : launches) {
+      tensorflow::profiler::TraceMeConsumer traceme(
+          "Run Collective", launch.first->trace_context);
+      statuses.push_back(LaunchKernel(launch.first, launch.second,
+                                      nccl_stream));
+    }
+#if NCCL_MAJOR >= 2
+    if (grouped) {
+      ncclResult_t end_result = ncclGroupEnd();
+      if (group_result == ncclSuccess) group_result = end_result;
+      if (group_result != ncclSuccess) {
+        // The kernels of the group may not have been launched.
+        for (Status& status : statuses) {
+          status.Update(errors::Unknown("Error invoking NCCL: ",
+                                        ncclGetErrorString(group_result)));
         }
-        VLOG(2) << "call NcclBroadcast collective_key "
-                << collective->collective_key << " participant " << p_idx
-                << " sendbuff " << sendbuff << " recvbuff " << recvbuff
-                << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
-                << " cuda_stream " << cu_stream;
-        profiler::AnnotatedTraceMe traceme([&] {
-          return profiler::TraceMeEncode(
-              "ncclBroadcast",
-              {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
-               {"collective_type", "broadcast"}});
-        });
-        nccl_result =
-            ncclBroadcast(sendbuff, recvbuff, num_elements, data_type,
-                          collective->root_rank, nccl_comm, *cu_stream);
-        break;
-      }
-      case kReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff =
-            p->output ? const_cast<char*>(p->output->tensor_data().data())
-                      : nullptr;
-        profiler::AnnotatedTraceMe traceme([&] {
-          return profiler::TraceMeEncode(
-              "buffer_size",
-              {{"output_size", ComputeBufferSize(p, collective->data_type)},
-               {"collective_type", "reduce"}});
-        });
-        nccl_result = ncclReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                 data_type, collective->reduction_op,
-                                 collective->root_rank, nccl_comm, *cu_stream);
-        break;
       }
-      case kAllGather: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+    }
+#endif
 
-        VLOG(2) << "call NcclAllGather collective_key "
+    for (int i = 0; i < launches.size(); ++i) {
+      Collective* collective = launches[i].first;
+      const int p_idx = launches[i].second;
+      Status status = statuses[i];
+      // Run the done_callback when the nccl kernel finishes running.
+      auto done_callback = [collective, p_idx, status]() {
+        VLOG(2) << "done Nccl kernel collective_key "
                 << collective->collective_key << " participant " << p_idx
-                << " sendbuff " << sendbuff << " sendcount "
-                << p->input->NumElements() << " recvbuff " << recvbuff
-                << " recvcount " << p->output->NumElements() << " nccl_comm "
-                << nccl_comm << " comm_stream " << comm_stream
-                << " cuda_stream " << cu_stream;
-        profiler::AnnotatedTraceMe traceme([&] {
-          return profiler::TraceMeEncode(
-              "ncclAllGather",
-              {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
-               {"collective_type", "all_gather"}});
-        });
-        nccl_result = ncclAllGather(sendbuff, recvbuff, p->input->NumElements(),
-                                    data_type, nccl_comm, *cu_stream);
-        break;
-      }
+                << " status " << status;
+        // If the kernel failed, propagate the error, but note that if other
+        // members of the collective did launch their kernels, then they are
+        // hanging.
+        collective->participants[p_idx]->done_callback(status);
+        collective->Unref();
+      };
+      Participant* p = collective->participants[p_idx].get();
+      p->event_mgr->ThenExecute(comm_stream, done_callback);
     }
-
-    // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, p_idx, nccl_result]() {
-      VLOG(2) << "done Nccl kernel collective_key "
-              << collective->collective_key << " participant " << p_idx
-              << " ncclResult " << nccl_result;
-      if (nccl_result == ncclSuccess) {
-        collective->participants[p_idx]->done_callback(Status::OK());
-      } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[p_idx]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
-      }
-      collective->Unref();
-    };
-    p->event_mgr->ThenExecute(comm_stream, done_callback);
   }
 }
 
@@ -46,6 +46,19 @@ namespace tensorflow {
 //
 // See nccl_ops.cc for example usage, including description of memory
 // management and stream synchronization.
+//
+// By default, the collectives of a set of local devices run on one
+// communicator, whose kernels each device launches on one stream in the order
+// the collectives became ready. Two environment variables, read when the
+// NcclManager is created, let independent collectives overlap:
+//  - TF_NCCL_NUM_COMMUNICATORS: the number of communicators, each with its own
+//    stream per device, that single-node collectives on the same devices are
+//    spread over. Collectives on different communicators may run
+//    concurrently; a collective still waits for the producers of its inputs
+//    on the tensor streams.
+//  - TF_NCCL_MAX_GROUP_LAUNCHES: the number of queued kernels a stream may
+//    launch together between ncclGroupStart() and ncclGroupEnd(), which
+//    batches the many small collectives of a step into fewer launches.
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
@@ -241,6 +254,18 @@ class NcclManager {
   void RunCollective(Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
 
+  // Launches the NCCL kernel of participant `p_idx` of `collective` on the
+  // stream of `nccl_stream`.
+  static Status LaunchKernel(Collective* collective, int p_idx,
+                             NcclStream* nccl_stream);
+
+  // The number of communicators that single-node collectives on the same
+  // devices are spread over.
+  const int num_communicators_;
+
+  // The largest number of kernels a stream launches as one NCCL group.
+  const int max_group_launches_;
+
   mutex mu_;
 
   // Maps key to collectives currently being assembled or run.
@@ -862,6 +862,50 @@ TYPED_TEST(NcclManagerTest, BroadcastInconsistentSource) {
 // environment, on a single node with multiple GPUS. So tests that rely
 // upon such simulation need to be skipped on the ROCm platform
 
+// Runs many reductions on the same devices over several communicators, with
+// their kernels launched in groups.
+TYPED_TEST(NcclManagerTest, MultipleCommunicatorsAndGroupedLaunches) {
+  setenv("TF_NCCL_NUM_COMMUNICATORS", "3", 1 /* replace */);
+  setenv("TF_NCCL_MAX_GROUP_LAUNCHES", "4", 1 /* replace */);
+  NcclManager nccl_manager;
+  unsetenv("TF_NCCL_NUM_COMMUNICATORS");
+  unsetenv("TF_NCCL_MAX_GROUP_LAUNCHES");
+
+  const int num_ranks = this->NumGPUs();
+  const int num_collectives = 20;
+  std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+  for (int i = 0; i < num_collectives; ++i) {
+    test_cases.emplace_back(this->MakeReductionTestCase(
+        /*num_nodes=*/1, num_ranks, ncclSum, TensorShape({100, i % 4 + 1}),
+        1.1f * i));
+  }
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    this->work_queue_->Schedule([this, rank, num_ranks, &test_cases,
+                                 &nccl_manager]() {
+      auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+      auto* info = device->tensorflow_gpu_device_info();
+      auto* stream = device->tensorflow_gpu_device_info()->stream;
+      for (int i = 0; i < test_cases.size(); ++i) {
+        typename TestFixture::TestCase* test_case = test_cases[i].get();
+        auto participant = absl::make_unique<NcclManager::Participant>(
+            device->executor(), stream, info, &test_case->ins[rank],
+            &test_case->outs[rank], /*global_rank=*/-1,
+            this->CreateDoneCallback(test_case));
+        nccl_manager.AddToAllReduce(
+            std::move(participant),
+            {strings::StrCat("allreduce", i),
+             /*num_local_devices=*/num_ranks,
+             /*num_global_devices=*/num_ranks,
+             /*communicator_key=*/"", /*source_rank=*/-1},
+            ncclSum);
+      }
+    });
+  }
+  for (int i = 0; i < test_cases.size(); ++i) {
+    this->VerifyResults(test_cases[i].get());
+  }
+}
+
 TYPED_TEST(NcclManagerTest, AbortThenReset) {
   using NodeState = typename TestFixture::NodeState;
   using TestCase = typename TestFixture::TestCase;
@@ -54,6 +54,16 @@ REGISTER_OP("BatchFunction")
     // NOTE: Support for `enable_large_batch_splitting == true` is still
     // developed in progress.
     .Attr("enable_large_batch_splitting: bool = false")
+    // If 'target_latency_micros' is positive, the batch timeout and the size
+    // from which batches are processed without waiting for the timeout are
+    // adapted online so that the 99th percentile of the latencies stays below
+    // it, starting from 'batch_timeout_micros' and 'max_batch_size'.
+    .Attr("target_latency_micros: int = 0")
+    // If 'enable_ragged_batching' is true, the inputs may differ in their 1st
+    // dimension and are batched without padding. The function then takes the
+    // flat values and the int64 row splits of each input, and returns the
+    // values and the row splits of each output.
+    .Attr("enable_ragged_batching: bool = false")
     // TODO(apassos): Fix this shape inference function. It requires shape
     // inference of function calls.
     .SetShapeFn(shape_inference::UnknownShape);
@@ -15,6 +15,8 @@
 
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/shape_inference.h"
 
 namespace tensorflow {
 
@@ -40,4 +42,58 @@ REGISTER_OP("NearestNeighbors")
     .Output("nearest_center_distances: float32")
     .SetShapeFn(shape_inference::UnknownShape);
 
+REGISTER_RESOURCE_HANDLE_OP(MipsIndex);
+
+REGISTER_OP("MipsIndexBuild")
+    .Input("index_handle: resource")
+    .Input("items: float32")
+    .Input("ids: int64")
+    .Attr("num_lists: int >= 1")
+    .Attr("num_iterations: int >= 0 = 10")
+    .Attr("seed: int = 0")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      shape_inference::ShapeHandle items;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &items));
+      shape_inference::ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &ids));
+      shape_inference::DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(items, 0), c->Dim(ids, 0), &unused_dim));
+      return Status::OK();
+    });
+
+REGISTER_OP("MipsIndexSearch")
+    .Input("index_handle: resource")
+    .Input("queries: float32")
+    .Input("k: int32")
+    .Output("scores: float32")
+    .Output("ids: int64")
+    .Attr("num_probes: int >= 1 = 8")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      shape_inference::ShapeHandle queries;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &queries));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      shape_inference::DimensionHandle k;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(2, &k));
+      shape_inference::ShapeHandle output =
+          c->Matrix(c->Dim(queries, 0), k);
+      c->set_output(0, output);
+      c->set_output(1, output);
+      return Status::OK();
+    });
+
+REGISTER_OP("MipsIndexSize")
+    .Input("index_handle: resource")
+    .Output("size: int64")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
@@ -511,6 +511,39 @@ REGISTER_OP("DecodeAndCropJpeg")
       return Status::OK();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeJpegBatch")
+    .Input("contents: string")
+    .Input("crop_windows: int32")
+    .Attr("size: list(int) = []")
+    .Output("images: uint8")
+    .Output("image_shapes: int32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      DimensionHandle batch = c->Dim(contents, 0);
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &crop_windows));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_windows, 1), 4, &unused));
+
+      std::vector<int32> size;
+      TF_RETURN_IF_ERROR(c->GetAttr("size", &size));
+      DimensionHandle height = c->UnknownDim();
+      DimensionHandle width = c->UnknownDim();
+      if (!size.empty()) {
+        if (size.size() != 2 || size[0] <= 0 || size[1] <= 0) {
+          return errors::InvalidArgument(
+              "size must be empty or a positive [height, width]");
+        }
+        height = c->MakeDim(size[0]);
+        width = c->MakeDim(size[1]);
+      }
+      c->set_output(0, c->MakeShape({batch, height, width, c->MakeDim(3)}));
+      c->set_output(1, c->Matrix(batch, 2));
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
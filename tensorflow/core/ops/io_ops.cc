@@ -55,6 +55,25 @@ Status TwoElementOutput(InferenceContext* c) {
   return Status::OK();
 }
 
+Status SaveV2Shape(InferenceContext* c) {
+  ShapeHandle unused;
+  ShapeHandle s;
+  DimensionHandle unused_dim;
+
+  // Validate prefix.
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+
+  // Validate tensor_names and shapes_and_slices.
+  for (int i = 1; i <= 2; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+    TF_RETURN_IF_ERROR(
+        c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
+  }
+  // TODO(mrry): Attempt to parse the shapes_and_slices values and use
+  // them to constrain the shape of the remaining inputs.
+  return Status::OK();
+}
+
 }  // namespace
 
 REGISTER_OP("SaveV2")
@@ -64,24 +83,21 @@ REGISTER_OP("SaveV2")
     .Input("tensors: dtypes")
     .Attr("dtypes: list(type)")
     .SetIsStateful()
-    .SetShapeFn([](InferenceContext* c) {
-      ShapeHandle unused;
-      ShapeHandle s;
-      DimensionHandle unused_dim;
+    .SetShapeFn(SaveV2Shape);
 
-      // Validate prefix.
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+REGISTER_OP("AsyncSaveV2")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .Attr("deep_copy: bool = false")
+    .SetIsStateful()
+    .SetShapeFn(SaveV2Shape);
 
-      // Validate tensor_names and shapes_and_slices.
-      for (int i = 1; i <= 2; ++i) {
-        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
-        TF_RETURN_IF_ERROR(
-            c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
-      }
-      // TODO(mrry): Attempt to parse the shapes_and_slices values and use
-      // them to constrain the shape of the remaining inputs.
-      return Status::OK();
-    });
+REGISTER_OP("AsyncSaveV2Wait")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
 
 REGISTER_OP("RestoreV2")
     .Input("prefix: string")
@@ -65,6 +65,13 @@ Status ScalarOutput(InferenceContext* c) {
   c->set_output(0, c->Scalar());
   return Status::OK();
 }
+
+Status TwoScalarInputs(InferenceContext* c) {
+  ShapeHandle handle;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &handle));
+  return Status::OK();
+}
 }  // namespace
 
 REGISTER_OP("LookupTableFind")
@@ -408,6 +415,24 @@ REGISTER_OP("MutableHashTableOfTensorsV2")
       return MutableHashTableShape(c, /*key=*/c->Scalar(), /*value=*/value_s);
     });
 
+REGISTER_OP("ShardedMutableHashTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("value_shape: shape = {}")
+    .Attr("num_shards: int >= 1 = 64")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      PartialTensorShape value_p;
+      TF_RETURN_IF_ERROR(c->GetAttr("value_shape", &value_p));
+      ShapeHandle value_s;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromPartialTensorShape(value_p, &value_s));
+      return MutableHashTableShape(c, /*key=*/c->Scalar(), /*value=*/value_s);
+    });
+
 REGISTER_OP("MutableDenseHashTable")
     .Input("empty_key: key_dtype")
     .Output("table_handle: Ref(string)")
@@ -519,4 +544,82 @@ REGISTER_OP("InitializeTableFromDataset")
       return Status::OK();
     });
 
+REGISTER_OP("DynamicEmbeddingTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("embedding_dim: int >= 1")
+    .Attr("num_slots: int >= 0 = 0")
+    .Attr("initial_slot_value: float = 0.1")
+    .Attr("min_frequency: int >= 1 = 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      int64 embedding_dim;
+      TF_RETURN_IF_ERROR(c->GetAttr("embedding_dim", &embedding_dim));
+      c->set_output(0, c->Scalar());
+      c->set_output_handle_shapes_and_types(
+          0, std::vector<ShapeAndType>{{c->Scalar(), DT_INT64},
+                                       {c->Vector(embedding_dim), DT_FLOAT}});
+      return Status::OK();
+    });
+
+REGISTER_OP("DynamicEmbeddingLookup")
+    .Input("table_handle: resource")
+    .Input("keys: int64")
+    .Input("initial_values: float")
+    .Output("values: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+      ShapeHandle row = c->Vector(InferenceContext::kUnknownDim);
+      auto* handle_data = c->input_handle_shapes_and_types(0);
+      if (handle_data != nullptr && handle_data->size() == 2) {
+        row = (*handle_data)[1].shape;
+      }
+      ShapeHandle values;
+      TF_RETURN_IF_ERROR(c->Concatenate(c->input(1), row, &values));
+      c->set_output(0, values);
+      return Status::OK();
+    });
+
+REGISTER_OP("DynamicEmbeddingApplyAdagrad")
+    .Input("table_handle: resource")
+    .Input("keys: int64")
+    .Input("grads: float")
+    .Input("lr: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &handle));
+      return Status::OK();
+    });
+
+REGISTER_OP("DynamicEmbeddingEvict")
+    .Input("table_handle: resource")
+    .Input("ttl_seconds: int64")
+    .Input("max_size: int64")
+    .Output("num_evicted: int64")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      for (int i = 0; i < 3; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &handle));
+      }
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    });
+
+REGISTER_OP("DynamicEmbeddingSaveDelta")
+    .Input("table_handle: resource")
+    .Input("prefix: string")
+    .SetIsStateful()
+    .SetShapeFn(TwoScalarInputs);
+
+REGISTER_OP("DynamicEmbeddingLoadDelta")
+    .Input("table_handle: resource")
+    .Input("prefix: string")
+    .SetIsStateful()
+    .SetShapeFn(TwoScalarInputs);
+
 }  // namespace tensorflow
@@ -978,6 +978,44 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("inputs: num_inputs * T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("num_inputs: int >= 1")
+    .Attr("fused_ops: list(string) >= 1")
+    .Attr("operands: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      // The inputs have the shape of the output, or are broadcast scalars.
+      ShapeHandle output = c->Scalar();
+      bool all_scalars = true;
+      for (int i = 0; i < c->num_inputs(); ++i) {
+        ShapeHandle input = c->input(i);
+        if (c->RankKnown(input) && c->Rank(input) == 0) continue;
+        if (all_scalars) {
+          output = input;
+          all_scalars = false;
+        } else {
+          TF_RETURN_IF_ERROR(c->Merge(output, input, &output));
+        }
+      }
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Evaluates a tree of elementwise operations in a single pass over its inputs.
+
+The operations are specified by `fused_ops`, a list of TF op names (e.g. "Mul"),
+which are evaluated in order. Their operands are listed in order in `operands`:
+an operand `k` is the input `k` if `k < num_inputs`, and the result of the
+operation `k - num_inputs` otherwise, which must precede the operation. The
+last operation produces the output. The inputs must have the same shape, or be
+scalars which are broadcast.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
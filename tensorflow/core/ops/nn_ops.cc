@@ -1198,6 +1198,61 @@ REGISTER_OP("LogSoftmax")
 
 // --------------------------------------------------------------------------
 
+REGISTER_OP("_FusedAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {half, float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query;
+      ShapeHandle key;
+      ShapeHandle value;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &query));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 3, &key));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 3, &value));
+
+      // The batch dimensions must be equal, they are not broadcast.
+      ShapeHandle batch;
+      ShapeHandle key_batch;
+      ShapeHandle value_batch;
+      TF_RETURN_IF_ERROR(c->Subshape(query, 0, -2, &batch));
+      TF_RETURN_IF_ERROR(c->Subshape(key, 0, -2, &key_batch));
+      TF_RETURN_IF_ERROR(c->Subshape(value, 0, -2, &value_batch));
+      TF_RETURN_IF_ERROR(c->Merge(batch, key_batch, &batch));
+      TF_RETURN_IF_ERROR(c->Merge(batch, value_batch, &batch));
+
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(query, -1), c->Dim(key, -1), &unused));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(key, -2), c->Dim(value, -2), &unused));
+
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          batch, c->Matrix(c->Dim(query, -2), c->Dim(value, -1)), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes softmax(query * key^T * scale + mask) * value, without materializing
+the [..., num_queries, num_keys] attention scores.
+
+`query` is [..., num_queries, depth], `key` is [..., num_keys, depth] and
+`value` is [..., num_keys, value_depth], with the same batch dimensions. `args`
+is empty, or holds an additive mask which must be broadcastable to the
+[..., num_queries, num_keys] scores without changing their shape.
+
+Internal operation: reserved for internal use. Do not invoke this operator
+directly in Python. A fusion optimization is expected to create these
+operators.
+)doc");
+
+// --------------------------------------------------------------------------
+
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
     .Input("features: T")
     .Input("labels: T")
@@ -210,6 +210,13 @@ REGISTER_OP("AssignSubVariableOp")
     .Attr("dtype: type")
     .SetShapeFn(CreateAssignShapeFn);
 
+// Freezes a resource variable for serving: it can no longer be modified, and
+// reads never copy it. Internal op.
+REGISTER_OP("_FreezeVariableOp")
+    .Input("resource: resource")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
 REGISTER_OP("VarIsInitializedOp")
     .Input("resource: resource")
     .Output("is_initialized: bool")
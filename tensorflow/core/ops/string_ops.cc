@@ -74,6 +74,21 @@ REGISTER_OP("StaticRegexFullMatch")
     .Output("output: bool")
     .SetShapeFn(shape_inference::UnchangedShape);
 
+REGISTER_OP("RegexSetMatch")
+    .Input("input: string")
+    .Input("patterns: string")
+    .Output("output: bool")
+    .Attr("full_match: bool = true")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle patterns;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &patterns));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->input(0), c->Vector(c->Dim(patterns, 0)), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
 REGISTER_OP("StringToHashBucketFast")
     .Input("input: string")
     .Output("output: int64")
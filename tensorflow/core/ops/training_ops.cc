@@ -867,6 +867,79 @@ REGISTER_OP("ResourceApplyAdamWithAmsgrad")
     .Attr("use_locking: bool = false")
     .SetShapeFn(ApplyAdamWithAmsgradShapeFn</*is_resource=*/true>);
 
+template <bool has_weight_decay>
+static Status SparseApplyAdamShapeFn(InferenceContext* c) {
+  ShapeHandle unused;
+  ShapeHandle s = ShapeOrHandleShape</*is_resource=*/true>(c, 0);  // var
+  TF_RETURN_IF_ERROR(
+      c->Merge(s, ShapeOrHandleShape</*is_resource=*/true>(c, 1), &s));  // m
+  TF_RETURN_IF_ERROR(
+      c->Merge(s, ShapeOrHandleShape</*is_resource=*/true>(c, 2), &s));  // v
+  // beta1_power, beta2_power, lr, beta1, beta2, epsilon and weight_decay.
+  const int num_scalars = has_weight_decay ? 7 : 6;
+  for (int i = 3; i < 3 + num_scalars; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  return HandleGradAndIndicesInputs</*is_sparse=*/true, /*is_resource=*/true>(
+      c, 3 + num_scalars /* grad_idx */, &s);
+}
+
+REGISTER_OP("ResourceSparseApplyAdam")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {half, float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("use_locking: bool = false")
+    .Attr("lazy_update: bool = true")
+    .SetShapeFn(SparseApplyAdamShapeFn</*has_weight_decay=*/false>);
+
+REGISTER_OP("ResourceSparseApplyAdamW")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("weight_decay: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {half, float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("use_locking: bool = false")
+    .Attr("lazy_update: bool = true")
+    .SetShapeFn(SparseApplyAdamShapeFn</*has_weight_decay=*/true>);
+
+REGISTER_OP("ResourceSparseApplyLamb")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("weight_decay: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {half, float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("use_locking: bool = false")
+    .Attr("lazy_update: bool = true")
+    .SetShapeFn(SparseApplyAdamShapeFn</*has_weight_decay=*/true>);
+
 template <bool is_resource>
 static Status ApplyAdaMaxShapeFn(InferenceContext* c) {
   ShapeHandle unused;
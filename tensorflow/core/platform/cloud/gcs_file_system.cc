@@ -798,12 +798,17 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  if (GetEnvVar(kReadaheadBlocks, strings::safe_strtou64, &value)) {
+    readahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "readahead blocks = " << readahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -1002,8 +1007,17 @@ Status GcsFileSystem::NewRandomAccessFile(
                                StringPiece* result, char* scratch) {
           *result = StringPiece();
           size_t bytes_transferred;
-          TF_RETURN_IF_ERROR(
-              LoadBufferFromGCS(fname, offset, n, scratch, &bytes_transferred));
+          if (n > block_size_) {
+            // Reads larger than the buffer (e.g. of large checkpoint tensors)
+            // go through the block cache, which fetches their blocks
+            // concurrently if readahead is enabled.
+            tf_shared_lock l(block_cache_lock_);
+            TF_RETURN_IF_ERROR(file_block_cache_->Read(
+                fname, offset, n, scratch, &bytes_transferred));
+          } else {
+            TF_RETURN_IF_ERROR(LoadBufferFromGCS(fname, offset, n, scratch,
+                                                 &bytes_transferred));
+          }
           *result = StringPiece(scratch, bytes_transferred);
           if (bytes_transferred < n) {
             return errors::OutOfRange("EOF reached, ", result->size(),
@@ -1036,7 +1050,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), readahead_blocks_));
   return file_block_cache;
 }
 
@@ -14,9 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -45,7 +47,11 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
       RemoveFile_Locked(key.first);
     }
   }
+  return Insert_Locked(key);
+}
 
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Insert_Locked(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -58,6 +64,87 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
   return new_entry;
 }
 
+void RamFileBlockCache::Prefetch(const Key& key) {
+  std::shared_ptr<Block> block;
+  {
+    mutex_lock lock(mu_);
+    auto entry = block_map_.find(key);
+    if (entry != block_map_.end()) {
+      if (BlockNotStale(entry->second)) {
+        // The block is already cached, or being fetched.
+        return;
+      }
+      RemoveFile_Locked(key.first);
+    }
+    block = Insert_Locked(key);
+  }
+  readahead_pool_->Schedule([this, key, block] {
+    // Errors are not reported here: a block in the ERROR state is fetched
+    // again by the next read that needs it.
+    if (MaybeFetch(key, block).ok()) {
+      UpdateLRU(key, block).IgnoreError();
+    }
+  });
+}
+
+size_t RamFileBlockCache::UpdateReadahead(const string& filename,
+                                          size_t offset, size_t n, bool eof) {
+  mutex_lock lock(mu_);
+  if (eof) {
+    // There is nothing left to read ahead.
+    readahead_map_.erase(filename);
+    return 0;
+  }
+  // Never read ahead more than half of the cache, so that blocks fetched ahead
+  // of time are not evicted before they are read.
+  const size_t max_window =
+      std::min(max_readahead_blocks_, max_bytes_ / block_size_ / 2);
+  // A read is sequential if it starts where the previous read of the file
+  // ended, or at the start of the file.
+  ReadaheadState& state = readahead_map_[filename];
+  if (offset == state.next_offset) {
+    state.window = std::min(std::max<size_t>(1, 2 * state.window), max_window);
+  } else {
+    state.window = 0;
+  }
+  state.next_offset = offset + n;
+  return state.window;
+}
+
+Status RamFileBlockCache::ParallelFetch(const string& filename, size_t offset,
+                                        size_t n, char* buffer,
+                                        size_t* bytes_transferred) {
+  const size_t num_chunks = (n + block_size_ - 1) / block_size_;
+  std::vector<Status> statuses(num_chunks);
+  std::vector<size_t> chunk_bytes(num_chunks, 0);
+  auto fetch_chunk = [&](size_t i) {
+    const size_t chunk_offset = i * block_size_;
+    statuses[i] = block_fetcher_(filename, offset + chunk_offset,
+                                 std::min(block_size_, n - chunk_offset),
+                                 buffer + chunk_offset, &chunk_bytes[i]);
+  };
+  BlockingCounter counter(num_chunks - 1);
+  for (size_t i = 1; i < num_chunks; ++i) {
+    readahead_pool_->Schedule([&fetch_chunk, &counter, i] {
+      fetch_chunk(i);
+      counter.DecrementCount();
+    });
+  }
+  fetch_chunk(0);
+  counter.Wait();
+  // The result ends at the first short chunk; errors past the end of the file
+  // are ignored.
+  *bytes_transferred = 0;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    TF_RETURN_IF_ERROR(statuses[i]);
+    *bytes_transferred += chunk_bytes[i];
+    if (chunk_bytes[i] < std::min(block_size_, n - i * block_size_)) {
+      break;
+    }
+  }
+  return Status::OK();
+}
+
 // Remove blocks from the cache until we do not exceed our maximum size.
 void RamFileBlockCache::Trim() {
   while (!lru_list_.empty() && cache_size_ > max_bytes_) {
@@ -79,15 +166,21 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
     block->lru_iterator = lru_list_.begin();
   }
 
-  // Check for inconsistent state. If there is a block later in the same file
-  // in the cache, and our current block is not block size, this likely means
-  // we have inconsistent state within the cache. Note: it's possible some
-  // incomplete reads may still go undetected.
+  // Check for inconsistent state. If there is a non-empty block later in the
+  // same file in the cache, and our current block is not block size, this
+  // likely means we have inconsistent state within the cache. Empty blocks and
+  // blocks that are still being fetched may have been read ahead past the end
+  // of the file. Note: it's possible some incomplete reads may still go
+  // undetected.
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
     auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    while (fcmp != block_map_.begin() && key < (--fcmp)->first) {
+      mutex_lock l(fcmp->second->mu);
+      if (fcmp->second->state == FetchState::FINISHED &&
+          !fcmp->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -173,7 +266,11 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   }
   if (!IsCacheEnabled() || (n > max_bytes_)) {
     // The cache is effectively disabled, so we pass the read through to the
-    // fetcher without breaking it up into blocks.
+    // fetcher without caching it, in a single request unless readahead is
+    // enabled.
+    if (readahead_pool_ != nullptr && n > block_size_) {
+      return ParallelFetch(filename, offset, n, buffer, bytes_transferred);
+    }
     return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
   }
   // Calculate the block-aligned start and end of the read.
@@ -182,7 +279,14 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (readahead_pool_ != nullptr) {
+    // Fetch the blocks after the first one concurrently with it.
+    for (size_t pos = start + block_size_; pos < finish; pos += block_size_) {
+      Prefetch(std::make_pair(filename, pos));
+    }
+  }
   size_t total_bytes_transferred = 0;
+  bool eof = false;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
     Key key = std::make_pair(filename, pos);
@@ -220,10 +324,17 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     }
     if (data.size() < block_size_) {
       // The block was a partial block and thus signals EOF at its upper bound.
+      eof = true;
       break;
     }
   }
   *bytes_transferred = total_bytes_transferred;
+  if (readahead_pool_ != nullptr) {
+    const size_t window = UpdateReadahead(filename, offset, n, eof);
+    for (size_t i = 0; i < window; ++i) {
+      Prefetch(std::make_pair(filename, finish + i * block_size_));
+    }
+  }
   return Status::OK();
 }
 
@@ -272,6 +383,7 @@ void RamFileBlockCache::Flush() {
   lru_list_.clear();
   lra_list_.clear();
   cache_size_ = 0;
+  readahead_map_.clear();
 }
 
 void RamFileBlockCache::RemoveFile(const string& filename) {
@@ -280,6 +392,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  readahead_map_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -38,6 +39,13 @@ namespace tensorflow {
 ///
 /// This class should be shared by read-only random access files on a remote
 /// filesystem (e.g. GCS).
+///
+/// If `max_readahead_blocks` is positive, the cache detects sequential reads of
+/// a file and fetches the blocks that follow them ahead of time, doubling the
+/// readahead window (up to `max_readahead_blocks` blocks, and at most half of
+/// the cache) for every consecutive sequential read. The blocks of a single
+/// read, and reads that bypass the cache because they exceed `max_bytes`, are
+/// then also fetched concurrently with one request per block.
 class RamFileBlockCache : public FileBlockCache {
  public:
   /// The callback executed when a block is not found in the cache, and needs to
@@ -51,21 +59,30 @@ class RamFileBlockCache : public FileBlockCache {
       BlockFetcher;
 
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t max_readahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        max_readahead_blocks_(max_readahead_blocks) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (block_size_ > 0 && max_readahead_blocks_ > 0) {
+      readahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_readahead_FBC", static_cast<int>(max_readahead_blocks_)));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying readahead_pool_ will block until all scheduled fetches are
+    // done.
+    readahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -131,6 +148,8 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The maximum number of blocks fetched ahead of a sequential read.
+  const size_t max_readahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -197,6 +216,24 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
 
+  /// Insert a new empty block for `key`, with mu_ already held.
+  std::shared_ptr<Block> Insert_Locked(const Key& key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Fetch the block at `key` in the background, unless it is already cached.
+  void Prefetch(const Key& key) TF_LOCKS_EXCLUDED(mu_);
+
+  /// Update the sequential access state of `filename` after a read of `n`
+  /// bytes at `offset`, and return the number of blocks to read ahead. `eof`
+  /// indicates that the read reached the end of the file.
+  size_t UpdateReadahead(const string& filename, size_t offset, size_t n,
+                         bool eof) TF_LOCKS_EXCLUDED(mu_);
+
+  /// Read `n` bytes at `offset` directly from the fetcher, with one concurrent
+  /// request per block.
+  Status ParallelFetch(const string& filename, size_t offset, size_t n,
+                       char* buffer, size_t* bytes_transferred);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
@@ -218,6 +255,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// The cache pruning thread that removes files with expired blocks.
   std::unique_ptr<Thread> pruning_thread_;
 
+  /// The threads that fetch blocks ahead of reads, if readahead is enabled.
+  std::unique_ptr<thread::ThreadPool> readahead_pool_;
+
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
@@ -243,6 +283,17 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// \brief The sequential access state of a file.
+  struct ReadaheadState {
+    /// The offset at which the next read must start to be sequential.
+    size_t next_offset = 0;
+    /// The number of blocks to read ahead of the next sequential read.
+    size_t window = 0;
+  };
+
+  /// A filename->readahead state map.
+  std::map<string, ReadaheadState> readahead_map_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
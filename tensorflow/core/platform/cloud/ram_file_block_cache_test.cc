@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
+#include <algorithm>
 #include <cstring>
+#include <set>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
@@ -566,5 +568,123 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+// Returns a fetcher for a file of `file_size` bytes, which records the offsets
+// of the blocks that it fetches in `offsets`.
+RamFileBlockCache::BlockFetcher RecordingFetcher(
+    size_t file_size, mutex* mu, std::multiset<size_t>* offsets) {
+  return [file_size, mu, offsets](const string& filename, size_t offset,
+                                  size_t n, char* buffer,
+                                  size_t* bytes_transferred) {
+    {
+      mutex_lock l(*mu);
+      offsets->insert(offset);
+    }
+    *bytes_transferred =
+        offset < file_size ? std::min(n, file_size - offset) : 0;
+    memset(buffer, 'x', *bytes_transferred);
+    return Status::OK();
+  };
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadOnSequentialReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::multiset<size_t> offsets;
+  {
+    RamFileBlockCache cache(block_size, 16 * block_size, 0,
+                            RecordingFetcher(1024, &mu, &offsets),
+                            Env::Default(), /*max_readahead_blocks=*/4);
+    std::vector<char> out;
+    // The readahead window grows from 1 to 2 and then 4 blocks.
+    for (size_t offset = 0; offset < 4 * block_size; offset += block_size) {
+      TF_EXPECT_OK(ReadCache(&cache, "", offset, block_size, &out));
+      EXPECT_EQ(out.size(), block_size);
+    }
+    // The cache destructor waits for the blocks being read ahead.
+  }
+  std::multiset<size_t> expected;
+  for (size_t offset = 0; offset < 8 * block_size; offset += block_size) {
+    expected.insert(offset);
+  }
+  EXPECT_EQ(offsets, expected);
+}
+
+TEST(RamFileBlockCacheTest, NoReadaheadOnRandomReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::multiset<size_t> offsets;
+  {
+    RamFileBlockCache cache(block_size, 16 * block_size, 0,
+                            RecordingFetcher(1024, &mu, &offsets),
+                            Env::Default(), /*max_readahead_blocks=*/4);
+    std::vector<char> out;
+    TF_EXPECT_OK(ReadCache(&cache, "", 4 * block_size, block_size, &out));
+    TF_EXPECT_OK(ReadCache(&cache, "", block_size, block_size, &out));
+    TF_EXPECT_OK(ReadCache(&cache, "", 8 * block_size, block_size, &out));
+  }
+  EXPECT_EQ(offsets, std::multiset<size_t>(
+                         {block_size, 4 * block_size, 8 * block_size}));
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadPastEndOfFile) {
+  const size_t block_size = 16;
+  const size_t file_size = 40;
+  mutex mu;
+  std::multiset<size_t> offsets;
+  RamFileBlockCache cache(block_size, 16 * block_size, 0,
+                          RecordingFetcher(file_size, &mu, &offsets),
+                          Env::Default(), /*max_readahead_blocks=*/4);
+  std::vector<char> out;
+  for (size_t offset = 0; offset < 3 * block_size / 2;
+       offset += block_size / 2) {
+    TF_EXPECT_OK(ReadCache(&cache, "", offset, block_size / 2, &out));
+    EXPECT_EQ(out.size(), block_size / 2);
+  }
+  // The last block of the file is partial, but the (empty) blocks read ahead
+  // after it must not be mistaken for an inconsistency.
+  TF_EXPECT_OK(ReadCache(&cache, "", 3 * block_size / 2, block_size, &out));
+  EXPECT_EQ(out.size(), file_size - 3 * block_size / 2);
+  Status status = ReadCache(&cache, "", file_size, block_size / 2, &out);
+  EXPECT_EQ(status.code(), error::OUT_OF_RANGE);
+}
+
+TEST(RamFileBlockCacheTest, ParallelFetchWhenCacheDisabled) {
+  // This fetcher won't respond until all blocks of the read are being fetched
+  // concurrently, or 10 seconds have elapsed.
+  const int blocks = 4;
+  BlockingCounter counter(blocks);
+  auto fetcher = [&counter](const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+    counter.DecrementCount();
+    if (!counter.WaitFor(std::chrono::seconds(10))) {
+      return errors::FailedPrecondition("desired concurrency not reached");
+    }
+    memset(buffer, 'a' + offset / n, n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  const size_t block_size = 8;
+  RamFileBlockCache cache(block_size, 0, 0, fetcher, Env::Default(),
+                          /*max_readahead_blocks=*/blocks);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, blocks * block_size, &out));
+  EXPECT_EQ(string(out.begin(), out.end()),
+            "aaaaaaaabbbbbbbbccccccccdddddddd");
+}
+
+TEST(RamFileBlockCacheTest, ParallelFetchPastEndOfFile) {
+  const size_t block_size = 8;
+  const size_t file_size = 20;
+  mutex mu;
+  std::multiset<size_t> offsets;
+  RamFileBlockCache cache(block_size, 0, 0,
+                          RecordingFetcher(file_size, &mu, &offsets),
+                          Env::Default(), /*max_readahead_blocks=*/2);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, 5 * block_size, &out));
+  EXPECT_EQ(out.size(), file_size);
+  EXPECT_EQ(offsets.size(), 5);
+}
+
 }  // namespace
 }  // namespace tensorflow
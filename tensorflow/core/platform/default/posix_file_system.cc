@@ -25,14 +25,28 @@ limitations under the License.
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define TF_POSIX_HAS_IO_URING 1
+#endif
+#endif
+
 #include "tensorflow/core/platform/default/posix_file_system.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -42,6 +56,241 @@ namespace tensorflow {
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+#if defined(TF_POSIX_HAS_IO_URING)
+
+// Issues the asynchronous reads of all files on one io_uring instance, and
+// runs their callbacks on a single completion thread, so that any number of
+// reads can be in flight without tying up a thread each.
+//
+// Disabled unless the TF_POSIX_FILE_SYSTEM_USE_IO_URING environment variable
+// is set to "1" or "true", or if the kernel does not support io_uring.
+class IoUring {
+ public:
+  // Returns the process-wide ring, or nullptr if io_uring is not used.
+  static IoUring* Get() {
+    static IoUring* ring = []() -> IoUring* {
+      const char* enabled = std::getenv("TF_POSIX_FILE_SYSTEM_USE_IO_URING");
+      if (enabled == nullptr ||
+          (strcmp(enabled, "1") != 0 && strcasecmp(enabled, "true") != 0)) {
+        return nullptr;
+      }
+      IoUring* ring = new IoUring;
+      Status s = ring->Init();
+      if (!s.ok()) {
+        LOG(WARNING) << "Reading files without io_uring: " << s;
+        delete ring;
+        return nullptr;
+      }
+      return ring;
+    }();
+    return ring;
+  }
+
+  // Reads `n` bytes of `fd` at `offset` into `scratch`, resubmitting short
+  // reads, and then calls `*done`. Returns false without taking `*done` if
+  // too many reads are in flight already.
+  bool Read(int fd, const string& filename, uint64 offset, size_t n,
+            char* scratch,
+            std::function<void(const Status&, StringPiece)>* done) {
+    mutex_lock l(mu_);
+    if (in_flight_ >= sq_entries_) {
+      return false;
+    }
+    ++in_flight_;
+    Request* request = new Request;
+    request->fd = fd;
+    request->filename = filename;
+    request->offset = offset;
+    request->n = n;
+    request->scratch = scratch;
+    request->done = std::move(*done);
+    Submit(request);
+    return true;
+  }
+
+ private:
+  static constexpr unsigned kEntries = 256;
+
+  struct Request {
+    int fd;
+    string filename;
+    uint64 offset;
+    size_t n;
+    char* scratch;
+    size_t bytes_read = 0;
+    struct iovec iov;
+    std::function<void(const Status&, StringPiece)> done;
+  };
+
+  IoUring() = default;
+
+  ~IoUring() {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+  }
+
+  Status Init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, kEntries, &params);
+    if (ring_fd_ < 0) {
+      return IOError("io_uring_setup", errno);
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    TF_RETURN_IF_ERROR(Map(sq_ring_size_, IORING_OFF_SQ_RING, &sq_ring_));
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      TF_RETURN_IF_ERROR(Map(cq_ring_size_, IORING_OFF_CQ_RING, &cq_ring_));
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes;
+    TF_RETURN_IF_ERROR(Map(sqes_size_, IORING_OFF_SQES, &sqes));
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    completion_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "tf_io_uring_completion", [this] { Complete(); }));
+    return Status::OK();
+  }
+
+  Status Map(size_t size, off_t offset, void** result) {
+    *result = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    if (*result == MAP_FAILED) {
+      *result = nullptr;
+      return IOError("io_uring mmap", errno);
+    }
+    return Status::OK();
+  }
+
+  // Queues a read of the rest of `request` and submits it to the kernel.
+  void Submit(Request* request) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    // Bounds the length of each read as in PosixRandomAccessFile::Read().
+    request->iov.iov_base = request->scratch + request->bytes_read;
+    request->iov.iov_len =
+        std::min<size_t>(request->n - request->bytes_read, INT32_MAX);
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = request->fd;
+    sqe->off = request->offset + request->bytes_read;
+    sqe->addr = reinterpret_cast<uint64>(&request->iov);
+    sqe->len = 1;
+    sqe->user_data = reinterpret_cast<uint64>(request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    // The submission queue always has room: there are at most `sq_entries_`
+    // reads in flight, and the kernel consumes queued entries on every call.
+    while (true) {
+      const unsigned to_submit =
+          tail + 1 - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+      if (to_submit == 0) break;
+      if (syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr,
+                  0) >= 0) {
+        break;
+      }
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        // The entry stays queued and is submitted with the next read.
+        LOG(ERROR) << "io_uring_enter() failed: " << strerror(errno);
+        break;
+      }
+    }
+  }
+
+  // Reaps completed reads and runs their callbacks. Never returns.
+  void Complete() {
+    while (true) {
+      if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                  nullptr, 0) < 0 &&
+          errno != EINTR) {
+        LOG(ERROR) << "io_uring_enter() failed: " << strerror(errno);
+      }
+      unsigned head = *cq_head_;
+      const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        Request* request = reinterpret_cast<Request*>(cqe.user_data);
+        const int res = cqe.res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        Finish(request, res);
+      }
+    }
+  }
+
+  // Handles the completion of a read of `request` that returned `res`.
+  void Finish(Request* request, int res) {
+    Status s;
+    if (res > 0) {
+      request->bytes_read += res;
+    } else if (res == 0) {
+      s = Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    } else if (res != -EINTR && res != -EAGAIN) {
+      s = IOError(request->filename, -res);
+    }
+    if (s.ok() && request->bytes_read < request->n) {
+      // Retry.
+      mutex_lock l(mu_);
+      Submit(request);
+      return;
+    }
+    {
+      mutex_lock l(mu_);
+      --in_flight_;
+    }
+    request->done(s, StringPiece(request->scratch, request->bytes_read));
+    delete request;
+  }
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  mutex mu_;
+  // The number of reads submitted and not completed yet.
+  unsigned in_flight_ TF_GUARDED_BY(mu_) = 0;
+  std::unique_ptr<Thread> completion_thread_;
+};
+
+#endif  // TF_POSIX_HAS_IO_URING
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -92,6 +341,19 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+  void ReadAsync(
+      uint64 offset, size_t n, char* scratch,
+      std::function<void(const Status&, StringPiece)> done) const override {
+#if defined(TF_POSIX_HAS_IO_URING)
+    IoUring* ring = IoUring::Get();
+    if (n > 0 && ring != nullptr &&
+        ring->Read(fd_, filename_, offset, n, scratch, &done)) {
+      return;
+    }
+#endif  // TF_POSIX_HAS_IO_URING
+    RandomAccessFile::ReadAsync(offset, n, scratch, std::move(done));
+  }
 };
 
 class PosixWritableFile : public WritableFile {
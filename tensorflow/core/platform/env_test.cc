@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/null_file_system.h"
@@ -90,6 +92,50 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadAsync) {
+#if defined(__linux__)
+  // Exercises the io_uring reads if the kernel supports them.
+  setenv("TF_POSIX_FILE_SYSTEM_USE_IO_URING", "1", /*overwrite=*/0);
+#endif
+  const string filename = io::JoinPath(BaseDir(), "read_async");
+  const string input = CreateTestFile(env_, filename, 1 << 20);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_ASSERT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // Keeps more reads in flight than the io_uring queue holds.
+  constexpr int kNumReads = 1000;
+  constexpr int kReadSize = 4096;
+  std::vector<string> scratch(kNumReads, string(kReadSize, '\0'));
+  std::vector<Status> statuses(kNumReads);
+  std::vector<StringPiece> results(kNumReads);
+  BlockingCounter counter(kNumReads);
+  for (int i = 0; i < kNumReads; ++i) {
+    f->ReadAsync(i * 1000, kReadSize, &scratch[i][0],
+                 [i, &statuses, &results, &counter](const Status& s,
+                                                    StringPiece result) {
+                   statuses[i] = s;
+                   results[i] = result;
+                   counter.DecrementCount();
+                 });
+  }
+  counter.Wait();
+  for (int i = 0; i < kNumReads; ++i) {
+    TF_EXPECT_OK(statuses[i]);
+    EXPECT_EQ(input.substr(i * 1000, kReadSize), results[i]);
+  }
+
+  // Reading past EOF should give an OUT_OF_RANGE error.
+  char eof_scratch[10];
+  Notification done;
+  f->ReadAsync(input.size() - 4, sizeof(eof_scratch), eof_scratch,
+               [&input, &done](const Status& s, StringPiece result) {
+                 EXPECT_EQ(error::OUT_OF_RANGE, s.code());
+                 EXPECT_EQ(input.substr(input.size() - 4), result);
+                 done.Notify();
+               });
+  done.WaitForNotification();
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
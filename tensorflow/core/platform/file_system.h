@@ -751,6 +751,25 @@ class RandomAccessFile {
   virtual tensorflow::Status Read(uint64 offset, size_t n, StringPiece* result,
                                   char* scratch) const = 0;
 
+  /// \brief Reads up to `n` bytes from the file starting at `offset`, without
+  /// blocking the calling thread if the filesystem supports it.
+  ///
+  /// Calls `done` with the status and the result of the read, with the same
+  /// semantics as `Read()`, once it completes. `done` may be called on another
+  /// thread, or before `ReadAsync()` returns; it should not block. `scratch`
+  /// and the file must stay live until `done` is called.
+  ///
+  /// The default implementation calls `Read()` on the calling thread.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadAsync(
+      uint64 offset, size_t n, char* scratch,
+      std::function<void(const Status&, StringPiece)> done) const {
+    StringPiece result;
+    Status s = Read(offset, n, &result, scratch);
+    done(s, result);
+  }
+
   // TODO(ebrevdo): Remove this ifdef when absl is updated.
 #if defined(PLATFORM_GOOGLE)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
@@ -39,6 +39,7 @@ limitations under the License.
 #include <cmath>
 #include <cstdlib>
 
+#include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
@@ -70,6 +71,30 @@ static const int kExecutorPoolSize = 25;
 static const int kUploadRetries = 3;
 static const int kDownloadRetries = 3;
 static const char* kExecutorTag = "TransferManagerExecutor";
+// The environment variable that overrides the number of threads uploading and
+// downloading the parts of multi part transfers.
+static const char* kS3MultiPartConcurrency = "S3_MULTI_PART_CONCURRENCY";
+
+// The environment variables that configure the block cache for reads. They
+// have the same meaning as their GCS_READ_CACHE_* counterparts, and the cache
+// is disabled unless S3_READ_CACHE_MAX_SIZE_MB is set.
+static const char* kS3ReadCacheBlockSize = "S3_READ_CACHE_BLOCK_SIZE_MB";
+static const uint64 kS3ReadCacheDefaultBlockSizeMB = 16;
+static const char* kS3ReadCacheMaxSize = "S3_READ_CACHE_MAX_SIZE_MB";
+static const char* kS3ReadCacheMaxStaleness = "S3_READ_CACHE_MAX_STALENESS";
+static const char* kS3ReadCacheReadaheadBlocks =
+    "S3_READ_CACHE_READAHEAD_BLOCKS";
+
+// Returns the value of the environment variable `name`, or `default_value` if
+// it is unset or not a number.
+uint64 GetEnvUint64(const char* name, uint64 default_value) {
+  const char* value_str = getenv(name);
+  uint64 value;
+  if (value_str == nullptr || !strings::safe_strtou64(value_str, &value)) {
+    return default_value;
+  }
+  return value;
+}
 
 Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   static mutex cfg_lock(LINKER_INITIALIZED);
@@ -344,16 +369,50 @@ class S3RandomAccessFile : public RandomAccessFile {
   bool use_multi_part_download_;
 };
 
+// A random access file whose reads go through the block cache of the
+// S3FileSystem, which fetches blocks from the S3RandomAccessFile logic.
+class S3CachedRandomAccessFile : public RandomAccessFile {
+ public:
+  S3CachedRandomAccessFile(const string& fname, FileBlockCache* block_cache)
+      : fname_(fname), block_cache_(block_cache) {}
+
+  Status Name(StringPiece* result) const override {
+    *result = fname_;
+    return Status::OK();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    *result = StringPiece();
+    size_t bytes_transferred;
+    TF_RETURN_IF_ERROR(
+        block_cache_->Read(fname_, offset, n, scratch, &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      return errors::OutOfRange("EOF reached, ", result->size(),
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  const string fname_;
+  FileBlockCache* const block_cache_;  // not owned
+};
+
 class S3WritableFile : public WritableFile {
  public:
   S3WritableFile(
       const string& bucket, const string& object,
       std::shared_ptr<Aws::Transfer::TransferManager> transfer_manager,
-      std::shared_ptr<Aws::S3::S3Client> s3_client)
+      std::shared_ptr<Aws::S3::S3Client> s3_client,
+      std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         s3_client_(s3_client),
         transfer_manager_(transfer_manager),
+        file_cache_erase_(std::move(file_cache_erase)),
         sync_needed_(true),
         outfile_(Aws::MakeShared<Aws::Utils::TempFile>(
             kS3FileSystemAllocationTag, kS3TempFileTemplate,
@@ -421,6 +480,7 @@ class S3WritableFile : public WritableFile {
                              handle->GetFailedParts().size(), " failed parts. ",
                              handle->GetLastError().GetMessage());
     }
+    file_cache_erase_();
     outfile_->clear();
     outfile_->seekp(offset);
     sync_needed_ = false;
@@ -432,6 +492,7 @@ class S3WritableFile : public WritableFile {
   string object_;
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
   std::shared_ptr<Aws::Transfer::TransferManager> transfer_manager_;
+  std::function<void()> file_cache_erase_;
   bool sync_needed_;
   std::shared_ptr<Aws::Utils::TempFile> outfile_;
 };
@@ -486,6 +547,31 @@ S3FileSystem::S3FileSystem()
     }
   }
 
+  executor_pool_size_ = static_cast<int>(
+      GetEnvUint64(kS3MultiPartConcurrency, kExecutorPoolSize));
+  if (executor_pool_size_ <= 0) {
+    executor_pool_size_ = kExecutorPoolSize;
+  }
+
+  const size_t block_size =
+      GetEnvUint64(kS3ReadCacheBlockSize, kS3ReadCacheDefaultBlockSizeMB) *
+      1024 * 1024;
+  const size_t max_bytes = GetEnvUint64(kS3ReadCacheMaxSize, 0) * 1024 * 1024;
+  const uint64 max_staleness = GetEnvUint64(kS3ReadCacheMaxStaleness, 0);
+  const size_t readahead_blocks = GetEnvUint64(kS3ReadCacheReadaheadBlocks, 0);
+  VLOG(1) << "S3 cache max size = " << max_bytes << " ; "
+          << "block size = " << block_size << " ; "
+          << "max staleness = " << max_staleness << " ; "
+          << "readahead blocks = " << readahead_blocks;
+  file_block_cache_.reset(new RamFileBlockCache(
+      block_size, max_bytes, max_staleness,
+      [this](const string& filename, size_t offset, size_t n, char* buffer,
+             size_t* bytes_transferred) {
+        return LoadBufferFromS3(filename, offset, n, buffer,
+                                bytes_transferred);
+      },
+      Env::Default(), readahead_blocks));
+
   auto upload_pair = std::pair<Aws::Transfer::TransferDirection,
                                std::shared_ptr<Aws::Transfer::TransferManager>>(
       Aws::Transfer::TransferDirection::UPLOAD,
@@ -550,7 +636,7 @@ S3FileSystem::GetTransferManager(
     config.bufferSize = this->multi_part_chunk_size_[direction];
     // must be larger than pool size * multi part chunk size
     config.transferBufferMaxHeapSize =
-        (kExecutorPoolSize + 1) * this->multi_part_chunk_size_[direction];
+        (executor_pool_size_ + 1) * this->multi_part_chunk_size_[direction];
     this->transfer_managers_[direction] =
         Aws::Transfer::TransferManager::Create(config);
   }
@@ -562,7 +648,7 @@ S3FileSystem::GetExecutor() {
   if (this->executor_.get() == nullptr) {
     this->executor_ =
         Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(
-            kExecutorTag, kExecutorPoolSize);
+            kExecutorTag, executor_pool_size_);
   }
   return this->executor_;
 }
@@ -581,6 +667,10 @@ Status S3FileSystem::NewRandomAccessFile(
 
   // check if an override was defined for this file. used for testing
   bool use_mpd = this->use_multi_part_download_ && use_multi_part_download;
+  if (use_multi_part_download && file_block_cache_->IsCacheEnabled()) {
+    result->reset(new S3CachedRandomAccessFile(fname, file_block_cache_.get()));
+    return Status::OK();
+  }
   result->reset(new S3RandomAccessFile(
       bucket, object, use_mpd,
       this->GetTransferManager(Aws::Transfer::TransferDirection::DOWNLOAD),
@@ -588,6 +678,27 @@ Status S3FileSystem::NewRandomAccessFile(
   return Status::OK();
 }
 
+Status S3FileSystem::LoadBufferFromS3(const string& fname, size_t offset,
+                                      size_t n, char* buffer,
+                                      size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+  S3RandomAccessFile file(
+      bucket, object, use_multi_part_download_,
+      this->GetTransferManager(Aws::Transfer::TransferDirection::DOWNLOAD),
+      this->GetS3Client());
+  StringPiece result;
+  Status status = file.Read(offset, n, &result, buffer);
+  if (!status.ok() && !errors::IsOutOfRange(status)) {
+    return status;
+  }
+  // Reads past the end of the object are partial (or empty) blocks for the
+  // block cache.
+  *bytes_transferred = result.size();
+  return Status::OK();
+}
+
 Status S3FileSystem::NewWritableFile(const string& fname,
                                      TransactionToken* token,
                                      std::unique_ptr<WritableFile>* result) {
@@ -596,7 +707,8 @@ Status S3FileSystem::NewWritableFile(const string& fname,
   result->reset(new S3WritableFile(
       bucket, object,
       this->GetTransferManager(Aws::Transfer::TransferDirection::UPLOAD),
-      this->GetS3Client()));
+      this->GetS3Client(),
+      [this, fname]() { file_block_cache_->RemoveFile(fname); }));
 
   return Status::OK();
 }
@@ -616,7 +728,8 @@ Status S3FileSystem::NewAppendableFile(const string& fname,
   result->reset(new S3WritableFile(
       bucket, object,
       this->GetTransferManager(Aws::Transfer::TransferDirection::UPLOAD),
-      this->GetS3Client()));
+      this->GetS3Client(),
+      [this, fname]() { file_block_cache_->RemoveFile(fname); }));
 
   while (true) {
     status = reader->Read(offset, kS3ReadAppendableFileBufferSize, &read_chunk,
@@ -789,6 +902,7 @@ Status S3FileSystem::DeleteFile(const string& fname, TransactionToken* token) {
   if (!deleteObjectOutcome.IsSuccess()) {
     return CreateStatusFromAwsError(deleteObjectOutcome.GetError());
   }
+  file_block_cache_->RemoveFile(fname);
   return Status::OK();
 }
 
@@ -1183,6 +1297,10 @@ Status S3FileSystem::RenameFile(const string& src, const string& target,
       if (!deleteObjectOutcome.IsSuccess()) {
         return CreateStatusFromAwsError(deleteObjectOutcome.GetError());
       }
+      file_block_cache_->RemoveFile(
+          strings::StrCat("s3://", src_bucket, "/", src_key.c_str()));
+      file_block_cache_->RemoveFile(
+          strings::StrCat("s3://", target_bucket, "/", target_key.c_str()));
     }
     listObjectsRequest.SetMarker(listObjectsResult.GetNextMarker());
   } while (listObjectsResult.GetIsTruncated());
@@ -22,6 +22,7 @@ limitations under the License.
 #include <aws/s3/model/CompletedMultipartUpload.h>
 #include <aws/transfer/TransferManager.h>
 
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
@@ -123,6 +124,9 @@ class S3FileSystem : public FileSystem {
   std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> GetExecutor();
   std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> executor_;
 
+  // number of threads of the executor, shared by all multi part transfers
+  int executor_pool_size_;
+
   Status CopyFile(const Aws::String& source_bucket,
                   const Aws::String& source_key,
                   const Aws::String& target_bucket,
@@ -151,6 +155,15 @@ class S3FileSystem : public FileSystem {
   std::map<Aws::Transfer::TransferDirection, uint64> multi_part_chunk_size_;
 
   bool use_multi_part_download_;
+
+  // Loads file contents from S3 for a given filename, offset, and length.
+  Status LoadBufferFromS3(const string& fname, size_t offset, size_t n,
+                          char* buffer, size_t* bytes_transferred);
+
+  // The block cache of reads, which is disabled unless configured. It is
+  // declared last so that its readahead threads stop before the clients that
+  // they use are destroyed.
+  std::unique_ptr<FileBlockCache> file_block_cache_;
 };
 
 /// S3 implementation of a file system with retry on failures.
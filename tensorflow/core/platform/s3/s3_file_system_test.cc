@@ -332,5 +332,47 @@ TEST_F(S3FileSystemTest, NewRandomAccessBigFile) {
   TF_EXPECT_OK(ReadLargeFile());
 }
 
+TEST_F(S3FileSystemTest, NewRandomAccessFileWithBlockCache) {
+  setenv("S3_READ_CACHE_BLOCK_SIZE_MB", "1", 1);
+  setenv("S3_READ_CACHE_MAX_SIZE_MB", "16", 1);
+  setenv("S3_READ_CACHE_READAHEAD_BLOCKS", "4", 1);
+  S3FileSystem cached_fs;
+  unsetenv("S3_READ_CACHE_BLOCK_SIZE_MB");
+  unsetenv("S3_READ_CACHE_MAX_SIZE_MB");
+  unsetenv("S3_READ_CACHE_READAHEAD_BLOCKS");
+
+  const string fname = TmpDir("RandomAccessFileWithBlockCache");
+  string content(3 * 1024 * 1024 + 17, 'a');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = 'a' + i % 26;
+  }
+  TF_ASSERT_OK(WriteString(fname, content));
+
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_ASSERT_OK(cached_fs.NewRandomAccessFile(fname, &reader));
+  // Read the file sequentially, so that the following blocks are read ahead.
+  const size_t chunk_size = 256 * 1024;
+  string got(chunk_size, 0);
+  StringPiece result;
+  for (size_t offset = 0; offset < content.size(); offset += chunk_size) {
+    Status status = reader->Read(offset, chunk_size, &result, &got[0]);
+    if (offset + chunk_size <= content.size()) {
+      TF_EXPECT_OK(status);
+    } else {
+      EXPECT_EQ(error::OUT_OF_RANGE, status.code());
+    }
+    EXPECT_EQ(content.substr(offset, chunk_size), result);
+  }
+
+  // Overwriting the file through the same file system drops its cached blocks.
+  std::unique_ptr<WritableFile> writer;
+  TF_ASSERT_OK(cached_fs.NewWritableFile(fname, &writer));
+  TF_ASSERT_OK(writer->Append("overwritten"));
+  TF_ASSERT_OK(writer->Close());
+  got.resize(11);
+  TF_EXPECT_OK(reader->Read(0, 11, &result, &got[0]));
+  EXPECT_EQ("overwritten", result);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -27,6 +27,7 @@ static const char* const kCheckers[] = {
     "AcceleratorUtilizationChecker", "OperationChecker",
     "ExpensiveOperationChecker",
     "JobChecker",  // Internal checker.
+    "CriticalPathChecker",
 };
 
 class Checker {
@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This checker checks the chain of operations that bounds the step time.
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_CRITICAL_PATH_CHECKER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_CRITICAL_PATH_CHECKER_H_
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/profiler/internal/advisor/checker.h"
+#include "tensorflow/core/profiler/internal/tfprof_critical_path.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+// Options: "step" (defaults to the last step) and "top_n" (defaults to 3).
+class CriticalPathChecker : public Checker {
+ public:
+  string name() const override { return kCheckers[4]; }
+
+ private:
+  AdviceProto::Checker Check(const AdvisorOptionsProto::CheckerOption& options,
+                             const TFStats* stats) override {
+    if (!stats) {
+      absl::FPrintF(
+          stderr, "Missing profiles (e.g. graph, run_meta). Skip %s\n", name());
+      return reports_;
+    }
+    if (stats->steps().empty()) {
+      absl::FPrintF(stderr, "Missing RunMetadata info. Skip %s\n", name());
+      return reports_;
+    }
+    int64 step = *stats->steps().rbegin();
+    int top_n = 3;
+    auto option = options.options().find("step");
+    if (option != options.options().end() &&
+        !absl::SimpleAtoi(option->second, &step)) {
+      absl::FPrintF(stderr, "Invalid step: %s\n", option->second);
+    }
+    option = options.options().find("top_n");
+    if (option != options.options().end() &&
+        !absl::SimpleAtoi(option->second, &top_n)) {
+      absl::FPrintF(stderr, "Invalid top_n: %s\n", option->second);
+    }
+
+    std::vector<CriticalPathNode> nodes;
+    for (const auto& it : stats->nodes()) {
+      const TFGraphNode* node = it.second.get();
+      if (node->all_start_micros(step) <= 0) continue;
+      nodes.emplace_back();
+      CriticalPathNode& path_node = nodes.back();
+      path_node.name = node->name();
+      path_node.op = node->op();
+      path_node.start_micros = node->all_start_micros(step);
+      path_node.end_micros = node->latest_end_micros(step);
+      for (const auto& input : node->inputs()) {
+        path_node.inputs.push_back(input.second);
+      }
+    }
+    if (nodes.empty()) {
+      absl::FPrintF(stderr, "No node executed in step %d. Skip %s\n", step,
+                    name());
+      return reports_;
+    }
+    reports_.add_reports(
+        CriticalPathToString(AnalyzeCriticalPath(nodes), top_n));
+    return reports_;
+  }
+
+  AdviceProto::Checker reports_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_CRITICAL_PATH_CHECKER_H_
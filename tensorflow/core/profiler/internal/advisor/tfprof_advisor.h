@@ -19,6 +19,7 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "tensorflow/core/profiler/internal/advisor/accelerator_utilization_checker.h"
 #include "tensorflow/core/profiler/internal/advisor/checker.h"
+#include "tensorflow/core/profiler/internal/advisor/critical_path_checker.h"
 #include "tensorflow/core/profiler/internal/advisor/expensive_operation_checker.h"
 #include "tensorflow/core/profiler/internal/advisor/internal_checker_runner.h"
 #include "tensorflow/core/profiler/internal/advisor/operation_checker.h"
@@ -62,6 +63,12 @@ class Advisor {
           expensive_op_checker.Run(options.checkers().at(kCheckers[2]),
                                    stats_));
     }
+    if (options.checkers().find(kCheckers[4]) != options.checkers().end()) {
+      CriticalPathChecker critical_path_checker;
+      (*ret.mutable_checkers())[kCheckers[4]].MergeFrom(
+          critical_path_checker.Run(options.checkers().at(kCheckers[4]),
+                                    stats_));
+    }
     for (const auto& checker : ret.checkers()) {
       absl::FPrintF(stdout, "\n%s:\n", checker.first);
       for (const string& r : checker.second.reports()) {
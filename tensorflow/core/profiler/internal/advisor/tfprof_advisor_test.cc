@@ -75,6 +75,7 @@ TEST_F(TFProfAdvisorTest, Basics) {
   EXPECT_TRUE(advice.checkers().find(kCheckers[0]) != advice.checkers().end());
   EXPECT_TRUE(advice.checkers().find(kCheckers[1]) != advice.checkers().end());
   EXPECT_TRUE(advice.checkers().find(kCheckers[2]) != advice.checkers().end());
+  EXPECT_TRUE(advice.checkers().find(kCheckers[4]) != advice.checkers().end());
 }
 
 TEST_F(TFProfAdvisorTest, OperationChecker) {
@@ -103,5 +104,27 @@ TEST_F(TFProfAdvisorTest, ExpensiveOperationChecker) {
                                 "top 1 operation type: Conv2D"));
 }
 
+TEST_F(TFProfAdvisorTest, CriticalPathChecker) {
+  TFStats stats(std::unique_ptr<GraphDef>(new GraphDef()), nullptr, nullptr,
+                nullptr);
+  stats.AddNodeForTest(0, CreateNode("n1", "Conv2D", {}, 0, 100, 10));
+  std::unique_ptr<TFGraphNode> n2 = CreateNode("n2", "MatMul", {}, 0, 110, 30);
+  n2->AddInput("n1", 0, 0);
+  stats.AddNodeForTest(0, std::move(n2));
+  std::unique_ptr<TFGraphNode> n3 = CreateNode("n3", "Relu", {}, 0, 110, 5);
+  n3->AddInput("n1", 0, 0);
+  stats.AddNodeForTest(0, std::move(n3));
+  stats.BuildAllViews();
+
+  AdvisorOptionsProto options;
+  (*options.mutable_checkers())[kCheckers[4]];
+  AdviceProto advice = Advisor(&stats).Advise(options);
+  ASSERT_EQ(advice.checkers().at(kCheckers[4]).reports_size(), 1);
+  const string& report = advice.checkers().at(kCheckers[4]).reports(0);
+  EXPECT_TRUE(absl::StrContains(report, "step: 40us, critical path: 40us"));
+  EXPECT_TRUE(absl::StrContains(
+      report, "top 1 critical path operation type: MatMul"));
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
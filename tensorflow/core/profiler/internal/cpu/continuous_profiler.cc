@@ -0,0 +1,155 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/continuous_profiler.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/convert/xplane_to_op_metrics_db.h"
+#include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/op_metrics_db_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+auto* op_occurrences = monitoring::Counter<2>::New(
+    "/tensorflow/profiler/continuous/op_occurrences",
+    "The number of occurrences of the ops in the continuous profiling "
+    "windows.",
+    "op_name", "op_type");
+
+auto* op_self_time_usecs = monitoring::Counter<2>::New(
+    "/tensorflow/profiler/continuous/op_self_time_usecs",
+    "The self time of the ops in the continuous profiling windows.", "op_name",
+    "op_type");
+
+auto* recorded_windows = monitoring::Counter<0>::New(
+    "/tensorflow/profiler/continuous/recorded_windows",
+    "The number of continuous profiling windows recorded.");
+
+auto* dropped_events = monitoring::Counter<0>::New(
+    "/tensorflow/profiler/continuous/dropped_events",
+    "The number of TraceMe events dropped by the continuous profiler because "
+    "a thread exceeded its maximum number of events in a window.");
+
+}  // namespace
+
+ContinuousProfiler::ContinuousProfiler(const Options& options)
+    : options_(options), combiner_(&db_) {
+  DCHECK_GT(options_.window_ms, 0);
+  DCHECK_GE(options_.period_ms, options_.window_ms);
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "tf_continuous_profiler", [this] { Run(); }));
+}
+
+ContinuousProfiler::~ContinuousProfiler() {
+  {
+    mutex_lock lock(mutex_);
+    stopped_ = true;
+    stop_cv_.notify_all();
+  }
+  thread_.reset();  // Joins the thread.
+}
+
+OpMetricsDb ContinuousProfiler::GetOpMetricsDb() const {
+  mutex_lock lock(mutex_);
+  return db_;
+}
+
+int64 ContinuousProfiler::NumRecordedWindows() const {
+  mutex_lock lock(mutex_);
+  return num_recorded_windows_;
+}
+
+int64 ContinuousProfiler::NumSkippedWindows() const {
+  mutex_lock lock(mutex_);
+  return num_skipped_windows_;
+}
+
+void ContinuousProfiler::Run() {
+  const uint64 period_ns = options_.period_ms * EnvTime::kMillisToNanos;
+  uint64 next_window_ns = EnvTime::NowNanos();
+  while (true) {
+    TraceMeRecorder::Events events;
+    uint64 start_time_ns;
+    if (RecordWindow(&events, &start_time_ns)) {
+      Aggregate(start_time_ns, std::move(events));
+    } else {
+      mutex_lock lock(mutex_);
+      if (stopped_) return;
+      ++num_skipped_windows_;
+    }
+    next_window_ns += period_ns;
+    if (!WaitUntil(next_window_ns)) return;
+  }
+}
+
+bool ContinuousProfiler::RecordWindow(TraceMeRecorder::Events* events,
+                                      uint64* start_time_ns) {
+  if (!AcquireProfilerLock()) return false;
+  *start_time_ns = EnvTime::NowNanos();
+  if (!TraceMeRecorder::Start(options_.host_trace_level,
+                              options_.max_events_per_thread)) {
+    ReleaseProfilerLock();
+    return false;
+  }
+  const bool running = WaitUntil(
+      *start_time_ns + options_.window_ms * EnvTime::kMillisToNanos);
+  *events = TraceMeRecorder::Stop();
+  const uint64 num_dropped_events = TraceMeRecorder::NumDroppedEvents();
+  ReleaseProfilerLock();
+  if (num_dropped_events > 0) {
+    dropped_events->GetCell()->IncrementBy(num_dropped_events);
+  }
+  return running;
+}
+
+void ContinuousProfiler::Aggregate(uint64 start_time_ns,
+                                   TraceMeRecorder::Events events) {
+  MakeCompleteEvents(&events);
+  XPlane plane;
+  ConvertCompleteEventsToXPlane(start_time_ns, events, &plane);
+  OpMetricsDb window_db = ConvertHostThreadsXPlaneToOpMetricsDb(plane);
+  for (const OpMetrics& metrics : window_db.metrics_db()) {
+    if (IsIdleOp(metrics)) continue;
+    op_occurrences->GetCell(metrics.name(), metrics.category())
+        ->IncrementBy(metrics.occurrences());
+    op_self_time_usecs->GetCell(metrics.name(), metrics.category())
+        ->IncrementBy(metrics.self_time_ps() / 1000000);
+  }
+  recorded_windows->GetCell()->IncrementBy(1);
+  mutex_lock lock(mutex_);
+  combiner_.Combine(window_db);
+  ++num_recorded_windows_;
+}
+
+bool ContinuousProfiler::WaitUntil(uint64 deadline_ns) {
+  mutex_lock lock(mutex_);
+  while (!stopped_) {
+    const uint64 now_ns = EnvTime::NowNanos();
+    if (now_ns >= deadline_ns) return true;
+    stop_cv_.wait_for(lock, std::chrono::nanoseconds(deadline_ns - now_ns));
+  }
+  return false;
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
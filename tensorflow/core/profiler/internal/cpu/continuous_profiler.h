@@ -0,0 +1,105 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
+
+#include <memory>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/convert/op_metrics_db_combiner.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Profiles the TraceMe events of the host continuously, at a low overhead, so
+// that it can be left on in production.
+//
+// A background thread records the TraceMe events during a short window every
+// period (i.e. 1% of the time with the default options), with at most
+// max_events_per_thread events per thread in memory. Sampling whole windows,
+// rather than single events, keeps the nesting of the events, hence the self
+// times of the ops. The events of each window are aggregated into an
+// OpMetricsDb, and exported through the /tensorflow/profiler/continuous/
+// monitoring metrics.
+//
+// Windows are skipped while another profiling session holds the profiler lock,
+// so the continuous profiler never interferes with on-demand profiling.
+class ContinuousProfiler {
+ public:
+  struct Options {
+    // Only the TraceMe events of this level or lower are recorded.
+    int host_trace_level = 2;
+    // The duration of the recording windows, and the time between the starts
+    // of two windows.
+    int64 window_ms = 100;
+    int64 period_ms = 10000;
+    // The maximum number of events held per thread during a window.
+    size_t max_events_per_thread = 100000;
+  };
+
+  // Starts profiling in a background thread, until destruction.
+  explicit ContinuousProfiler(const Options& options);
+  ~ContinuousProfiler();
+
+  // Returns the metrics of the ops aggregated over all the windows so far.
+  OpMetricsDb GetOpMetricsDb() const TF_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of windows recorded, and skipped because another
+  // profiling session was active.
+  int64 NumRecordedWindows() const TF_LOCKS_EXCLUDED(mutex_);
+  int64 NumSkippedWindows() const TF_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Runs in the background thread.
+  void Run() TF_LOCKS_EXCLUDED(mutex_);
+
+  // Records the events of one window. Returns false if the profiler lock is
+  // held by another session, or if the profiler is stopped during the window.
+  bool RecordWindow(TraceMeRecorder::Events* events, uint64* start_time_ns)
+      TF_LOCKS_EXCLUDED(mutex_);
+
+  // Aggregates the events of a window into db_ and the monitoring metrics.
+  void Aggregate(uint64 start_time_ns, TraceMeRecorder::Events events)
+      TF_LOCKS_EXCLUDED(mutex_);
+
+  // Waits until the given time or until the profiler is stopped. Returns false
+  // if the profiler is stopped.
+  bool WaitUntil(uint64 deadline_ns) TF_LOCKS_EXCLUDED(mutex_);
+
+  const Options options_;
+
+  mutable mutex mutex_;
+  condition_variable stop_cv_;
+  bool stopped_ TF_GUARDED_BY(mutex_) = false;
+  OpMetricsDb db_ TF_GUARDED_BY(mutex_);
+  // Combines the windows into db_, which must be empty at its construction.
+  OpMetricsDbCombiner combiner_ TF_GUARDED_BY(mutex_);
+  int64 num_recorded_windows_ TF_GUARDED_BY(mutex_) = 0;
+  int64 num_skipped_windows_ TF_GUARDED_BY(mutex_) = 0;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
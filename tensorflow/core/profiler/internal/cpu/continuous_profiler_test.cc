@@ -0,0 +1,67 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/continuous_profiler.h"
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+ContinuousProfiler::Options TestOptions() {
+  ContinuousProfiler::Options options;
+  options.window_ms = 10;
+  options.period_ms = 20;
+  return options;
+}
+
+TEST(ContinuousProfilerTest, AggregatesOpsOfWindows) {
+  ContinuousProfiler profiler(TestOptions());
+  while (profiler.NumRecordedWindows() < 2) {
+    TraceMe traceme("my_matmul:MatMul");
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  OpMetricsDb db = profiler.GetOpMetricsDb();
+  bool found = false;
+  for (const OpMetrics& metrics : db.metrics_db()) {
+    if (metrics.name() != "my_matmul") continue;
+    found = true;
+    EXPECT_EQ(metrics.category(), "MatMul");
+    EXPECT_GT(metrics.occurrences(), 0);
+    EXPECT_GT(metrics.self_time_ps(), 0);
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(ContinuousProfilerTest, SkipsWindowsWhileAnotherSessionIsActive) {
+  ASSERT_TRUE(AcquireProfilerLock());
+  {
+    ContinuousProfiler profiler(TestOptions());
+    while (profiler.NumSkippedWindows() < 2) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    EXPECT_EQ(profiler.NumRecordedWindows(), 0);
+  }
+  ReleaseProfilerLock();
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
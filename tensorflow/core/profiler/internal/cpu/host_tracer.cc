@@ -22,9 +22,11 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
 #include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
 #include "tensorflow/core/profiler/lib/profiler_factory.h"
 #include "tensorflow/core/profiler/lib/profiler_interface.h"
@@ -44,7 +46,7 @@ namespace {
 // Thread-safety: This class is go/thread-compatible.
 class HostTracer : public ProfilerInterface {
  public:
-  explicit HostTracer(int host_trace_level);
+  HostTracer(int host_trace_level, bool enable_perf_counters);
   ~HostTracer() override;
 
   // Starts recording TraceMes.
@@ -63,6 +65,9 @@ class HostTracer : public ProfilerInterface {
   // Level of host tracing.
   const int host_trace_level_;
 
+  // Whether the hardware performance counters of the TF ops are recorded.
+  const bool enable_perf_counters_;
+
   // True if currently recording.
   bool recording_ = false;
 
@@ -73,8 +78,9 @@ class HostTracer : public ProfilerInterface {
   TraceMeRecorder::Events events_;
 };
 
-HostTracer::HostTracer(int host_trace_level)
-    : host_trace_level_(host_trace_level) {}
+HostTracer::HostTracer(int host_trace_level, bool enable_perf_counters)
+    : host_trace_level_(host_trace_level),
+      enable_perf_counters_(enable_perf_counters) {}
 
 HostTracer::~HostTracer() { Stop().IgnoreError(); }
 
@@ -86,6 +92,10 @@ Status HostTracer::Start() {
   if (!recording_) {
     return errors::Internal("Failed to start TraceMeRecorder");
   }
+  if (enable_perf_counters_ && !PerfCounters::Enable()) {
+    LOG(WARNING) << "Hardware performance counters are not supported, see "
+                    "/proc/sys/kernel/perf_event_paranoid.";
+  }
   start_timestamp_ns_ = EnvTime::NowNanos();
   return Status::OK();
 }
@@ -94,6 +104,7 @@ Status HostTracer::Stop() {
   if (!recording_) {
     return errors::Internal("TraceMeRecorder not started");
   }
+  if (enable_perf_counters_) PerfCounters::Disable();
   events_ = TraceMeRecorder::Stop();
   recording_ = false;
   return Status::OK();
@@ -158,7 +169,8 @@ Status HostTracer::CollectData(XSpace* space) {
 std::unique_ptr<ProfilerInterface> CreateHostTracer(
     const ProfileOptions& options) {
   if (options.host_tracer_level() == 0) return nullptr;
-  return absl::make_unique<HostTracer>(options.host_tracer_level());
+  return absl::make_unique<HostTracer>(options.host_tracer_level(),
+                                       options.enable_host_perf_counters());
 }
 
 auto register_host_tracer_factory = [] {
@@ -0,0 +1,156 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+#include <atomic>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace internal {
+
+std::atomic<int> g_perf_counters_enabled(0);
+
+}  // namespace internal
+
+namespace {
+
+#if defined(__linux__)
+const uint64 kCounterConfigs[PerfCounters::kNumCounters] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+};
+
+// Opens a counter of the calling thread, in the group of `group_fd` unless it
+// is -1.
+int OpenCounter(uint64 config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd,
+                 /*flags=*/0);
+}
+
+// The counters of a thread, in one group led by the cycles so that a single
+// read returns all of them, measured over the same time.
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+    leader_ = OpenCounter(kCounterConfigs[PerfCounters::kCycles], -1);
+    if (leader_ < 0) return;
+    fds_[0] = leader_;
+    index_[PerfCounters::kCycles] = num_fds_++;
+    for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+      if (i == PerfCounters::kCycles) continue;
+      const int fd = OpenCounter(kCounterConfigs[i], leader_);
+      if (fd < 0) continue;
+      fds_[num_fds_] = fd;
+      index_[i] = num_fds_++;
+    }
+  }
+
+  ~ThreadCounters() {
+    for (int i = 0; i < num_fds_; ++i) close(fds_[i]);
+  }
+
+  bool Read(PerfCounters::Values* values) const {
+    if (leader_ < 0) return false;
+    // The number of counters, the times the group was enabled and running,
+    // then the value of each counter in the order they were opened.
+    uint64 buffer[3 + PerfCounters::kNumCounters];
+    const ssize_t size = (3 + num_fds_) * sizeof(uint64);
+    if (read(leader_, buffer, size) != size) return false;
+    const uint64 time_enabled = buffer[1];
+    const uint64 time_running = buffer[2];
+    for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+      values->valid[i] = index_[i] >= 0;
+      if (!values->valid[i]) {
+        values->count[i] = 0;
+        continue;
+      }
+      uint64 count = buffer[3 + index_[i]];
+      // Extrapolates the count when the PMU was shared with other groups.
+      if (time_running > 0 && time_running < time_enabled) {
+        count = static_cast<uint64>(static_cast<double>(count) *
+                                    time_enabled / time_running);
+      }
+      values->count[i] = count;
+    }
+    return true;
+  }
+
+ private:
+  int leader_ = -1;
+  int fds_[PerfCounters::kNumCounters];
+  int num_fds_ = 0;
+  // The position of each counter in the group, or -1 if it is not counted.
+  int index_[PerfCounters::kNumCounters] = {-1, -1, -1, -1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ThreadCounters);
+};
+#endif
+
+}  // namespace
+
+const char* PerfCounters::Name(Counter counter) {
+  switch (counter) {
+    case kCycles:
+      return "cycles";
+    case kInstructions:
+      return "instructions";
+    case kLlcMisses:
+      return "llc_misses";
+    case kStalledCycles:
+      return "stalled_cycles";
+    default:
+      return "unknown";
+  }
+}
+
+bool PerfCounters::Enable() {
+  Values values;
+  if (!Read(&values)) return false;
+  internal::g_perf_counters_enabled.store(1, std::memory_order_release);
+  return true;
+}
+
+bool PerfCounters::Read(Values* values) {
+#if defined(__linux__)
+  static thread_local ThreadCounters counters;
+  return counters.Read(values);
+#else
+  return false;
+#endif
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
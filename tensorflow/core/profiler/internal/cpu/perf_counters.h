@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
+
+#include <atomic>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace internal {
+
+// Whether the hardware performance counters are enabled.
+// Static atomic so PerfCounters::IsEnabled can be fast and non-blocking.
+TF_EXPORT extern std::atomic<int> g_perf_counters_enabled;
+
+}  // namespace internal
+
+// Backend for the hardware performance counters of the kernel TraceMes.
+//
+// Each thread counts its own events with perf_event_open(2), so the counts
+// read by a thread at the start and at the end of a span are the events of
+// that span only, whichever threads run concurrently. The counters of a
+// thread are opened the first time it reads them while they are enabled, and
+// closed when the thread exits.
+//
+// Only supported on Linux, when the kernel allows the process to monitor
+// itself (see /proc/sys/kernel/perf_event_paranoid).
+class PerfCounters {
+ public:
+  enum Counter {
+    kCycles,
+    kInstructions,
+    // Misses of the last level cache (PERF_COUNT_HW_CACHE_MISSES).
+    kLlcMisses,
+    // Cycles stalled in the back-end of the pipeline, mostly waiting for
+    // memory. Not counted by all CPUs.
+    kStalledCycles,
+    kNumCounters,
+  };
+
+  struct Values {
+    uint64 count[kNumCounters] = {};
+    // Whether the CPU counts each counter.
+    bool valid[kNumCounters] = {};
+  };
+
+  // Returns the name of `counter`, as recorded in the TraceMe metadata.
+  static const char* Name(Counter counter);
+
+  // Enables the counters. Returns false if they are not supported.
+  static bool Enable();
+
+  static void Disable() {
+    internal::g_perf_counters_enabled.store(0, std::memory_order_release);
+  }
+
+  static bool IsEnabled() {
+    return internal::g_perf_counters_enabled.load(std::memory_order_acquire);
+  }
+
+  // Reads the counters of the calling thread. Returns false if they cannot be
+  // opened.
+  static bool Read(Values* values);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/annotated_traceme.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+void Spin() {
+  volatile double sum = 0;
+  for (int i = 0; i < 1000000; ++i) sum += i;
+}
+
+TEST(PerfCountersTest, Names) {
+  EXPECT_STREQ(PerfCounters::Name(PerfCounters::kCycles), "cycles");
+  EXPECT_STREQ(PerfCounters::Name(PerfCounters::kLlcMisses), "llc_misses");
+}
+
+TEST(PerfCountersTest, CountsTheThread) {
+  if (!PerfCounters::Enable()) {
+    LOG(INFO) << "Hardware performance counters are not supported, skipping.";
+    return;
+  }
+  PerfCounters::Values start, end;
+  ASSERT_TRUE(PerfCounters::Read(&start));
+  Spin();
+  ASSERT_TRUE(PerfCounters::Read(&end));
+  PerfCounters::Disable();
+
+  ASSERT_TRUE(end.valid[PerfCounters::kCycles]);
+  EXPECT_GT(end.count[PerfCounters::kCycles],
+            start.count[PerfCounters::kCycles]);
+  if (end.valid[PerfCounters::kInstructions]) {
+    // The loop retires at least a few instructions per iteration.
+    EXPECT_GT(end.count[PerfCounters::kInstructions] -
+                  start.count[PerfCounters::kInstructions],
+              1000000);
+  }
+}
+
+TEST(PerfCountersTest, AnnotatedTraceMeRecordsCounters) {
+  if (!PerfCounters::Enable()) {
+    LOG(INFO) << "Hardware performance counters are not supported, skipping.";
+    return;
+  }
+  TraceMeRecorder::Start(/*level=*/1);
+  {
+    AnnotatedTraceMe trace_me([] { return "kernel"; }, /*level=*/1);
+    Spin();
+  }
+  PerfCounters::Disable();
+  {
+    AnnotatedTraceMe trace_me([] { return "disabled"; }, /*level=*/1);
+  }
+  TraceMeRecorder::Events events = TraceMeRecorder::Stop();
+
+  ASSERT_EQ(events.size(), 1);
+  ASSERT_EQ(events[0].events.size(), 2);
+  EXPECT_TRUE(absl::StartsWith(events[0].events[0].name, "kernel#cycles="));
+  EXPECT_EQ(events[0].events[1].name, "disabled");
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
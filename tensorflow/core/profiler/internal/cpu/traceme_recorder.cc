@@ -56,12 +56,17 @@ namespace {
 //
 // Push writes at end_, and then advances it, allocating a block if needed.
 // PopAll takes ownership of events in the range [start_, end_).
-// The end_ pointer is atomic so Push and PopAll can be concurrent.
+// The start_ and end_ pointers are atomic so Push and PopAll can be concurrent,
+// and Push can bound the number of events in the queue.
 //
 // Push and PopAll are lock free and each might be called from at most one
 // thread. Push is only called by the owner thread. PopAll is called by the
 // owner thread when it shuts down, or by the tracing control thread.
 //
+// The blocks emptied by PopAll are kept in a free list, from which Push takes
+// its new blocks, so that a thread recording in successive sessions reuses
+// its blocks instead of allocating and freeing them in each session.
+//
 // Thus, PopAll might race with Push, so PopAll only removes events that were
 // in the queue when it was invoked. If Push is called while PopAll is active,
 // the new event remains in the queue. Thus, the tracing control thread should
@@ -83,19 +88,32 @@ class EventQueue {
   ~EventQueue() {
     DCHECK(Empty()) << "EventQueue destroyed without PopAll()";
     delete end_block_;
+    Block* block = free_blocks_.load(std::memory_order_acquire);
+    while (block != nullptr) {
+      Block* next = block->next;
+      delete block;
+      block = next;
+    }
   }
 
   // Add a new event to the back of the queue. Fast and lock-free.
-  void Push(TraceMeRecorder::Event&& event) {
+  // Returns false, dropping the event, if the queue already holds max_size
+  // events, unless max_size is TraceMeRecorder::kUnboundedEvents.
+  bool Push(TraceMeRecorder::Event&& event, size_t max_size) {
     size_t end = end_.load(std::memory_order_relaxed);
+    if (max_size != TraceMeRecorder::kUnboundedEvents &&
+        end - start_.load(std::memory_order_acquire) >= max_size) {
+      return false;
+    }
     new (&end_block_->events[end++ - end_block_->start].event)
         TraceMeRecorder::Event(std::move(event));
     if (TF_PREDICT_FALSE(end - end_block_->start == Block::kNumSlots)) {
-      auto* new_block = new Block{end, nullptr};
+      auto* new_block = AllocateBlock(end);
       end_block_->next = new_block;
       end_block_ = new_block;
     }
     end_.store(end, std::memory_order_release);  // Write index after contents.
+    return true;
   }
 
   // Retrieve and remove all events in the queue at the time of invocation.
@@ -108,9 +126,11 @@ class EventQueue {
     // Read index before contents.
     size_t end = end_.load(std::memory_order_acquire);
     std::vector<TraceMeRecorder::Event> result;
-    result.reserve(end - start_);
-    while (start_ != end) {
+    result.reserve(end - start_.load(std::memory_order_relaxed));
+    while (start_.load(std::memory_order_relaxed) != end) {
       result.emplace_back(Pop());
+      auto& event = result.back();
+      if (event.static_name != nullptr) event.name = event.static_name;
     }
     return result;
   }
@@ -118,7 +138,8 @@ class EventQueue {
  private:
   // Returns true if the queue is empty at the time of invocation.
   bool Empty() const {
-    return (start_ == end_.load(std::memory_order_acquire));
+    return (start_.load(std::memory_order_relaxed) ==
+            end_.load(std::memory_order_acquire));
   }
 
   // Remove one event off the front of the queue and return it.
@@ -126,17 +147,20 @@ class EventQueue {
   TraceMeRecorder::Event Pop() {
     DCHECK(!Empty());
     // Move the next event into the output.
-    auto& event = start_block_->events[start_++ - start_block_->start].event;
+    size_t start = start_.load(std::memory_order_relaxed);
+    auto& event = start_block_->events[start++ - start_block_->start].event;
     TraceMeRecorder::Event out = std::move(event);
     event.~Event();  // Events must be individually destroyed.
     // If we reach the end of a block, we own it and should delete it.
     // The next block is present: end always points to something.
-    if (TF_PREDICT_FALSE(start_ - start_block_->start == Block::kNumSlots)) {
+    if (TF_PREDICT_FALSE(start - start_block_->start == Block::kNumSlots)) {
       auto* next_block = start_block_->next;
-      delete start_block_;
+      FreeBlock(start_block_);
       start_block_ = next_block;
-      DCHECK_EQ(start_, start_block_->start);
+      DCHECK_EQ(start, start_block_->start);
     }
+    // Free the slot after its contents were moved and destroyed.
+    start_.store(start, std::memory_order_release);
     return out;
   }
 
@@ -160,12 +184,50 @@ class EventQueue {
 
   static_assert(sizeof(Block) <= Block::kSize, "");
 
+  // The maximum number of blocks kept in the free list, i.e. 1 MiB per thread.
+  static constexpr size_t kMaxFreeBlocks = 16;
+
+  // Returns a block whose first slot is `start`, from the free list if it is
+  // not empty. Only called by the producer thread, which is the only thread
+  // removing blocks from the free list, so the list does not suffer from ABA.
+  Block* AllocateBlock(size_t start) {
+    Block* block = free_blocks_.load(std::memory_order_acquire);
+    while (block != nullptr &&
+           !free_blocks_.compare_exchange_weak(block, block->next,
+                                               std::memory_order_acquire)) {
+    }
+    if (block == nullptr) return new Block{start, nullptr};
+    num_free_blocks_.fetch_sub(1, std::memory_order_relaxed);
+    block->start = start;
+    block->next = nullptr;
+    return block;
+  }
+
+  // Adds an emptied block to the free list, or deletes it if the list is full.
+  // Only called by the consumer thread.
+  void FreeBlock(Block* block) {
+    if (num_free_blocks_.load(std::memory_order_relaxed) >= kMaxFreeBlocks) {
+      delete block;
+      return;
+    }
+    block->next = free_blocks_.load(std::memory_order_relaxed);
+    while (!free_blocks_.compare_exchange_weak(block->next, block,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    }
+    num_free_blocks_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   // Head of list for reading. Only accessed by consumer thread.
   Block* start_block_;
-  size_t start_;
+  std::atomic<size_t> start_;  // Atomic: also read by producer thread.
   // Tail of list for writing. Accessed by producer thread.
   Block* end_block_;
   std::atomic<size_t> end_;  // Atomic: also read by consumer thread.
+  // Stack of emptied blocks, linked by `next`. Pushed to by the consumer
+  // thread and popped from by the producer thread.
+  std::atomic<Block*> free_blocks_{nullptr};
+  std::atomic<size_t> num_free_blocks_{0};
 };
 
 }  // namespace
@@ -189,8 +251,11 @@ class TraceMeRecorder::ThreadLocalRecorder {
     TraceMeRecorder::Get()->UnregisterThread(info_.tid);
   }
 
-  // Record is only called from the owner thread.
-  void Record(TraceMeRecorder::Event&& event) { queue_.Push(std::move(event)); }
+  // Record is only called from the owner thread. Returns false if the event
+  // was dropped because the queue already holds max_events events.
+  bool Record(TraceMeRecorder::Event&& event, size_t max_events) {
+    return queue_.Push(std::move(event), max_events);
+  }
 
   // Clear is called from the control thread when tracing starts/stops, or from
   // the owner thread when it shuts down (see destructor).
@@ -240,9 +305,15 @@ TraceMeRecorder::Events TraceMeRecorder::Clear() {
   return result;
 }
 
-bool TraceMeRecorder::StartRecording(int level) {
+bool TraceMeRecorder::StartRecording(int level, size_t max_events_per_thread) {
   level = std::max(0, level);
   mutex_lock lock(mutex_);
+  if (internal::g_trace_level.load(std::memory_order_acquire) ==
+      kTracingDisabled) {
+    max_events_per_thread_.store(max_events_per_thread,
+                                 std::memory_order_relaxed);
+    num_dropped_events_.store(0, std::memory_order_relaxed);
+  }
   // Change trace_level_ while holding mutex_.
   int expected = kTracingDisabled;
   bool started = internal::g_trace_level.compare_exchange_strong(
@@ -256,7 +327,12 @@ bool TraceMeRecorder::StartRecording(int level) {
 
 void TraceMeRecorder::Record(Event event) {
   static thread_local ThreadLocalRecorder thread_local_recorder;
-  thread_local_recorder.Record(std::move(event));
+  TraceMeRecorder* recorder = Get();
+  if (TF_PREDICT_FALSE(!thread_local_recorder.Record(
+          std::move(event),
+          recorder->max_events_per_thread_.load(std::memory_order_relaxed)))) {
+    recorder->num_dropped_events_.fetch_add(1, std::memory_order_relaxed);
+  }
 }
 
 TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
@@ -56,6 +56,10 @@ class TraceMeRecorder {
     std::string name;
     uint64 start_time;  // 0 = missing
     uint64 end_time;    // 0 = missing
+    // If not null, a name with static storage duration recorded instead of
+    // `name`, which saves building a string on the recording thread. Stop()
+    // copies it into `name`.
+    const char* static_name = nullptr;
   };
   struct ThreadInfo {
     uint32 tid;
@@ -70,7 +74,13 @@ class TraceMeRecorder {
   // Starts recording of TraceMe().
   // Only traces <= level will be recorded.
   // Level must be >= 0. If level is 0, no traces will be recorded.
-  static bool Start(int level) { return Get()->StartRecording(level); }
+  // If max_events_per_thread is not kUnboundedEvents, each thread holds at
+  // most that many events until Stop(), and drops the following ones, so that
+  // the memory used by the recorder stays bounded.
+  static bool Start(int level,
+                    size_t max_events_per_thread = kUnboundedEvents) {
+    return Get()->StartRecording(level, max_events_per_thread);
+  }
 
   // Stops recording and returns events recorded since Start().
   // Events passed to Record after Stop has started will be dropped.
@@ -84,6 +94,15 @@ class TraceMeRecorder {
   // Default value for trace_level_ when tracing is disabled
   static constexpr int kTracingDisabled = -1;
 
+  // Value of max_events_per_thread for which the events are not bounded.
+  static constexpr size_t kUnboundedEvents = 0;
+
+  // Returns the number of events dropped since the last Start() because
+  // their thread already held max_events_per_thread events.
+  static uint64 NumDroppedEvents() {
+    return Get()->num_dropped_events_.load(std::memory_order_relaxed);
+  }
+
   // Records an event. Non-blocking.
   static void Record(Event event);
 
@@ -103,7 +122,7 @@ class TraceMeRecorder {
   void RegisterThread(uint32 tid, ThreadLocalRecorder* thread);
   void UnregisterThread(uint32 tid);
 
-  bool StartRecording(int level);
+  bool StartRecording(int level, size_t max_events_per_thread);
   Events StopRecording();
 
   // Gathers events from all active threads, and clears their buffers.
@@ -116,6 +135,11 @@ class TraceMeRecorder {
       TF_GUARDED_BY(mutex_);
   // Events from threads that died during recording.
   TraceMeRecorder::Events orphaned_events_ TF_GUARDED_BY(mutex_);
+
+  // The maximum number of events held by each thread, or kUnboundedEvents.
+  // Atomic as it is read by the threads recording events.
+  std::atomic<size_t> max_events_per_thread_{kUnboundedEvents};
+  std::atomic<uint64> num_dropped_events_{0};
 };
 
 }  // namespace profiler
@@ -27,8 +27,10 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
 namespace profiler {
@@ -56,6 +58,74 @@ TEST(RecorderTest, SingleThreaded) {
               ElementsAre(Named("during1"), Named("during2")));
 }
 
+TEST(RecorderTest, BoundedEventsPerThread) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  TraceMeRecorder::Start(/*level=*/1, /*max_events_per_thread=*/2);
+  TraceMeRecorder::Record({1, "during1", start_time, end_time});
+  TraceMeRecorder::Record({2, "during2", start_time, end_time});
+  TraceMeRecorder::Record({3, "dropped1", start_time, end_time});
+  TraceMeRecorder::Record({4, "dropped2", start_time, end_time});
+  auto results = TraceMeRecorder::Stop();
+  EXPECT_EQ(TraceMeRecorder::NumDroppedEvents(), 2);
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events,
+              ElementsAre(Named("during1"), Named("during2")));
+
+  // The bound and the count of dropped events are reset by Start().
+  TraceMeRecorder::Start(/*level=*/1);
+  TraceMeRecorder::Record({5, "during3", start_time, end_time});
+  TraceMeRecorder::Record({6, "during4", start_time, end_time});
+  TraceMeRecorder::Record({7, "during5", start_time, end_time});
+  results = TraceMeRecorder::Stop();
+  EXPECT_EQ(TraceMeRecorder::NumDroppedEvents(), 0);
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events, ElementsAre(Named("during3"),
+                                             Named("during4"),
+                                             Named("during5")));
+}
+
+TEST(RecorderTest, StaticNames) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  TraceMeRecorder::Start(/*level=*/1);
+  TraceMeRecorder::Record(
+      {1, /*name=*/std::string(), start_time, end_time, "static_name"});
+  TraceMeRecorder::Record({2, "dynamic_name", start_time, end_time});
+  auto results = TraceMeRecorder::Stop();
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events,
+              ElementsAre(Named("static_name"), Named("dynamic_name")));
+}
+
+TEST(RecorderTest, ReusesBlocksAcrossSessions) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  // Enough events to fill several blocks, whose contents must not leak into
+  // the next session when the blocks are reused.
+  constexpr int kNumEvents = 10000;
+  for (int session = 0; session < 3; ++session) {
+    TraceMeRecorder::Start(/*level=*/1);
+    for (int i = 0; i < kNumEvents; ++i) {
+      TraceMeRecorder::Record(
+          {static_cast<uint64>(i), absl::StrCat(session, "_", i), start_time,
+           end_time});
+    }
+    auto results = TraceMeRecorder::Stop();
+    ASSERT_EQ(results.size(), 1);
+    ASSERT_EQ(results[0].events.size(), kNumEvents);
+    for (int i = 0; i < kNumEvents; ++i) {
+      EXPECT_EQ(results[0].events[i].name, absl::StrCat(session, "_", i));
+    }
+  }
+}
+
 void SpinNanos(int nanos) {
   uint64 deadline = Env::Default()->NowNanos() + nanos;
   while (Env::Default()->NowNanos() < deadline) {
@@ -191,6 +261,41 @@ TEST(RecorderTest, Multithreaded) {
   }
 }
 
+constexpr int kNumBenchmarkEvents = 1000;
+
+void BM_TraceMeStringName(int iters) {
+  TraceMeRecorder::Start(/*level=*/1);
+  for (int i = 0; i < iters; i += kNumBenchmarkEvents) {
+    for (int j = 0; j < kNumBenchmarkEvents; ++j) {
+      TraceMe traceme("a_kernel_name_too_long_for_sso");
+    }
+    testing::StopTiming();
+    TraceMeRecorder::Stop();
+    TraceMeRecorder::Start(/*level=*/1);
+    testing::StartTiming();
+  }
+  TraceMeRecorder::Stop();
+}
+
+BENCHMARK(BM_TraceMeStringName);
+
+void BM_TraceMeStaticName(int iters) {
+  static constexpr TraceMeStaticName kName("a_kernel_name_too_long_for_sso");
+  TraceMeRecorder::Start(/*level=*/1);
+  for (int i = 0; i < iters; i += kNumBenchmarkEvents) {
+    for (int j = 0; j < kNumBenchmarkEvents; ++j) {
+      TraceMe traceme(kName);
+    }
+    testing::StopTiming();
+    TraceMeRecorder::Stop();
+    TraceMeRecorder::Start(/*level=*/1);
+    testing::StartTiming();
+  }
+  TraceMeRecorder::Stop();
+}
+
+BENCHMARK(BM_TraceMeStaticName);
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
@@ -0,0 +1,200 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/tfprof_critical_path.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/profiler/internal/tfprof_utils.h"
+
+namespace tensorflow {
+namespace tfprof {
+namespace {
+
+// Returns the name of the node producing `input`, a NodeDef input of the form
+// "^node" or "node:output".
+string InputNodeName(const string& input) {
+  const size_t begin = !input.empty() && input[0] == '^' ? 1 : 0;
+  return input.substr(begin, input.find(':') - begin);
+}
+
+// Sorts by decreasing time, then by name for determinism.
+void SortByMicros(std::vector<CriticalPathEntry>* entries) {
+  std::sort(entries->begin(), entries->end(),
+            [](const CriticalPathEntry& a, const CriticalPathEntry& b) {
+              if (a.micros != b.micros) return a.micros > b.micros;
+              return a.name < b.name;
+            });
+}
+
+}  // namespace
+
+CriticalPath AnalyzeCriticalPath(const std::vector<CriticalPathNode>& nodes) {
+  CriticalPath ret;
+  if (nodes.empty()) return ret;
+
+  std::unordered_map<string, int> index;
+  int64 first_start = std::numeric_limits<int64>::max();
+  int last = 0;
+  for (int i = 0; i < nodes.size(); ++i) {
+    const CriticalPathNode& node = nodes[i];
+    index[node.name] = i;
+    ret.total_exec_micros += std::max<int64>(0, node.end_micros -
+                                                    node.start_micros);
+    first_start = std::min(first_start, node.start_micros);
+    if (node.end_micros > nodes[last].end_micros ||
+        (node.end_micros == nodes[last].end_micros &&
+         node.start_micros > nodes[last].start_micros)) {
+      last = i;
+    }
+  }
+  ret.step_micros = nodes[last].end_micros - first_start;
+
+  // Walks back from the last node to the input each node waited for. An
+  // input finishing after the node itself (e.g. the NextIteration of a loop
+  // feeding its Merge) cannot have delayed it and is skipped.
+  std::vector<int> path;
+  std::vector<bool> visited(nodes.size(), false);
+  for (int cur = last; cur >= 0;) {
+    visited[cur] = true;
+    path.push_back(cur);
+    int pred = -1;
+    for (const string& input : nodes[cur].inputs) {
+      auto it = index.find(input);
+      if (it == index.end() || visited[it->second]) continue;
+      const CriticalPathNode& in = nodes[it->second];
+      if (in.end_micros > nodes[cur].end_micros) continue;
+      if (pred < 0 || in.end_micros > nodes[pred].end_micros) {
+        pred = it->second;
+      }
+    }
+    cur = pred;
+  }
+  std::reverse(path.begin(), path.end());
+
+  std::map<string, CriticalPathEntry> ops;
+  int64 prev_end = std::numeric_limits<int64>::min();
+  for (int i : path) {
+    const CriticalPathNode& node = nodes[i];
+    const int64 start = std::max(node.start_micros, prev_end);
+    const int64 micros = std::max<int64>(0, node.end_micros - start);
+    prev_end = std::max(prev_end, node.end_micros);
+    ret.critical_path_micros += micros;
+
+    CriticalPathEntry entry;
+    entry.name = node.name;
+    entry.op = node.op;
+    entry.micros = micros;
+    entry.count = 1;
+    ret.path.push_back(entry);
+
+    CriticalPathEntry& op = ops[node.op];
+    op.name = node.op;
+    op.op = node.op;
+    op.micros += micros;
+    ++op.count;
+  }
+  for (const auto& op : ops) {
+    ret.ops.push_back(op.second);
+  }
+  SortByMicros(&ret.ops);
+  return ret;
+}
+
+Status CriticalPathNodesFromStepStats(const GraphDef& graph,
+                                      const StepStats& step_stats,
+                                      std::vector<CriticalPathNode>* nodes) {
+  std::unordered_map<string, const NodeDef*> node_defs;
+  for (const NodeDef& node_def : graph.node()) {
+    node_defs[node_def.name()] = &node_def;
+  }
+
+  nodes->clear();
+  std::unordered_map<string, int> index;
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      string name = node_stats.node_name();
+      // The stats of accelerator streams may be named "node:op".
+      const size_t pos = name.find(':');
+      if (node_defs.find(name) == node_defs.end() && pos != name.npos &&
+          node_defs.find(name.substr(0, pos)) != node_defs.end()) {
+        name = name.substr(0, pos);
+      }
+      const int64 start = node_stats.all_start_micros();
+      const int64 end = start + std::max(node_stats.op_end_rel_micros(),
+                                         node_stats.all_end_rel_micros());
+      auto it = index.find(name);
+      if (it == index.end()) {
+        index[name] = nodes->size();
+        nodes->emplace_back();
+        CriticalPathNode& node = nodes->back();
+        node.name = name;
+        node.start_micros = start;
+        node.end_micros = end;
+      } else {
+        CriticalPathNode& node = (*nodes)[it->second];
+        node.start_micros = std::min(node.start_micros, start);
+        node.end_micros = std::max(node.end_micros, end);
+      }
+    }
+  }
+  if (nodes->empty()) {
+    return errors::InvalidArgument("StepStats has no node stats.");
+  }
+
+  for (CriticalPathNode& node : *nodes) {
+    auto it = node_defs.find(node.name);
+    if (it == node_defs.end()) continue;
+    node.op = it->second->op();
+    for (const string& input : it->second->input()) {
+      node.inputs.push_back(InputNodeName(input));
+    }
+  }
+  return Status::OK();
+}
+
+string CriticalPathToString(const CriticalPath& path, int top_n) {
+  string ret = absl::StrFormat(
+      "step: %s, critical path: %s (%.2f%%), slack: %s, parallelism: %.2f\n",
+      FormatTime(path.step_micros), FormatTime(path.critical_path_micros),
+      100.0 * path.critical_path_micros / (path.step_micros + 1e-10),
+      FormatTime(path.slack_micros()), path.parallelism());
+  absl::StrAppendFormat(&ret, "%d nodes on the critical path\n",
+                        path.path.size());
+  for (int i = 0; i < top_n && i < path.ops.size(); ++i) {
+    const CriticalPathEntry& op = path.ops[i];
+    absl::StrAppendFormat(
+        &ret,
+        "top %d critical path operation type: %s, %s (%.2f%%), %d nodes\n",
+        i + 1, op.op, FormatTime(op.micros),
+        100.0 * op.micros / (path.critical_path_micros + 1e-10), op.count);
+  }
+  std::vector<CriticalPathEntry> nodes = path.path;
+  SortByMicros(&nodes);
+  for (int i = 0; i < top_n && i < nodes.size(); ++i) {
+    absl::StrAppendFormat(&ret, "top %d critical path node: %s (%s), %s\n",
+                          i + 1, nodes[i].name, nodes[i].op,
+                          FormatTime(nodes[i].micros));
+  }
+  return ret;
+}
+
+}  // namespace tfprof
+}  // namespace tensorflow
@@ -0,0 +1,97 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Finds the chain of graph nodes that bounds the time of a step.
+//
+// The critical path is built backwards from the node that finished last: each
+// node on the path is preceded by the input (data or control) that finished
+// last, i.e. the one the node was waiting for before it could start. The time
+// the step spends outside of the path nodes (waiting to be scheduled,
+// transferring tensors...) is the slack.
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CRITICAL_PATH_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CRITICAL_PATH_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+// A graph node executed in a step.
+struct CriticalPathNode {
+  string name;
+  string op;
+  int64 start_micros = 0;
+  int64 end_micros = 0;
+  // Names of the data and control inputs of the node.
+  std::vector<string> inputs;
+};
+
+// The time a node, or all the nodes of an op type, spent on the path.
+struct CriticalPathEntry {
+  string name;
+  string op;
+  int64 micros = 0;
+  int64 count = 0;
+};
+
+struct CriticalPath {
+  // From the first start to the last end of the nodes of the step.
+  int64 step_micros = 0;
+  // Time spent executing the nodes of the path. Time overlapping with the
+  // predecessor of a node (e.g. clock skew between devices) is not counted.
+  int64 critical_path_micros = 0;
+  // Sum of the execution times of all the nodes of the step.
+  int64 total_exec_micros = 0;
+
+  // The nodes of the path, in execution order.
+  std::vector<CriticalPathEntry> path;
+  // The op types of the path, by decreasing time.
+  std::vector<CriticalPathEntry> ops;
+
+  // Time of the step not spent executing the path.
+  int64 slack_micros() const { return step_micros - critical_path_micros; }
+  // Average number of nodes executing at the same time.
+  double parallelism() const {
+    return step_micros > 0 ? 1.0 * total_exec_micros / step_micros : 0;
+  }
+};
+
+// Returns the critical path of a step executing `nodes`. Inputs that are not
+// in `nodes` are ignored.
+CriticalPath AnalyzeCriticalPath(const std::vector<CriticalPathNode>& nodes);
+
+// Returns the nodes of `step_stats`, with the inputs of `graph`. A node
+// executed on several devices (e.g. on an accelerator and its streams) spans
+// from its first start to its last end. `graph` is the graph that was run,
+// e.g. the merged RunMetadata.partition_graphs, so that the _Send/_Recv nodes
+// connect the partitions.
+Status CriticalPathNodesFromStepStats(const GraphDef& graph,
+                                      const StepStats& step_stats,
+                                      std::vector<CriticalPathNode>* nodes);
+
+// Returns a report of `path` with its `top_n` most expensive op types and
+// nodes.
+string CriticalPathToString(const CriticalPath& path, int top_n);
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CRITICAL_PATH_H_
@@ -0,0 +1,154 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/tfprof_critical_path.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tfprof {
+namespace {
+
+CriticalPathNode Node(const string& name, const string& op, int64 start,
+                      int64 end, std::vector<string> inputs) {
+  CriticalPathNode node;
+  node.name = name;
+  node.op = op;
+  node.start_micros = start;
+  node.end_micros = end;
+  node.inputs = std::move(inputs);
+  return node;
+}
+
+std::vector<string> PathNames(const CriticalPath& path) {
+  std::vector<string> names;
+  for (const CriticalPathEntry& entry : path.path) {
+    names.push_back(entry.name);
+  }
+  return names;
+}
+
+TEST(CriticalPathTest, Diamond) {
+  // a -> {b, c} -> d, where b is the slowest branch.
+  const CriticalPath path = AnalyzeCriticalPath({
+      Node("a", "Const", 0, 10, {}),
+      Node("b", "MatMul", 10, 30, {"a"}),
+      Node("c", "Relu", 10, 15, {"a"}),
+      Node("d", "Add", 32, 40, {"b", "c"}),
+  });
+  EXPECT_EQ(PathNames(path), std::vector<string>({"a", "b", "d"}));
+  EXPECT_EQ(path.step_micros, 40);
+  EXPECT_EQ(path.critical_path_micros, 38);
+  EXPECT_EQ(path.slack_micros(), 2);
+  EXPECT_EQ(path.total_exec_micros, 43);
+  EXPECT_DOUBLE_EQ(path.parallelism(), 43.0 / 40);
+  ASSERT_EQ(path.ops.size(), 3);
+  EXPECT_EQ(path.ops[0].op, "MatMul");
+  EXPECT_EQ(path.ops[0].micros, 20);
+}
+
+TEST(CriticalPathTest, SkipsInputsFinishingLater) {
+  // The loop back edge of "merge" finishes after it and did not delay it.
+  const CriticalPath path = AnalyzeCriticalPath({
+      Node("enter", "Enter", 0, 5, {}),
+      Node("merge", "Merge", 5, 6, {"enter", "next_iteration"}),
+      Node("next_iteration", "NextIteration", 8, 9, {"merge"}),
+      Node("exit", "Exit", 10, 12, {"merge"}),
+  });
+  EXPECT_EQ(PathNames(path), std::vector<string>({"enter", "merge", "exit"}));
+  EXPECT_EQ(path.critical_path_micros, 8);
+}
+
+TEST(CriticalPathTest, OverlappingPredecessor) {
+  // Clock skew between devices: "b" seems to start before "a" ends.
+  const CriticalPath path = AnalyzeCriticalPath({
+      Node("a", "Send", 0, 10, {}),
+      Node("b", "Recv", 8, 12, {"a"}),
+  });
+  EXPECT_EQ(path.critical_path_micros, 12);
+  EXPECT_EQ(path.path[1].micros, 2);
+}
+
+TEST(CriticalPathTest, FromStepStats) {
+  GraphDef graph;
+  NodeDef* a = graph.add_node();
+  a->set_name("a");
+  a->set_op("Const");
+  NodeDef* b = graph.add_node();
+  b->set_name("b");
+  b->set_op("MatMul");
+  b->add_input("a:1");
+  NodeDef* c = graph.add_node();
+  c->set_name("c");
+  c->set_op("NoOp");
+  c->add_input("^b");
+
+  StepStats step_stats;
+  DeviceStepStats* cpu = step_stats.add_dev_stats();
+  cpu->set_device("/device:CPU:0");
+  NodeExecStats* stats = cpu->add_node_stats();
+  stats->set_node_name("a");
+  stats->set_all_start_micros(100);
+  stats->set_all_end_rel_micros(10);
+  stats = cpu->add_node_stats();
+  stats->set_node_name("c");
+  stats->set_all_start_micros(150);
+  stats->set_all_end_rel_micros(1);
+  DeviceStepStats* gpu = step_stats.add_dev_stats();
+  gpu->set_device("/device:GPU:0");
+  stats = gpu->add_node_stats();
+  stats->set_node_name("b");
+  stats->set_all_start_micros(110);
+  stats->set_all_end_rel_micros(5);
+  DeviceStepStats* stream = step_stats.add_dev_stats();
+  stream->set_device("/device:GPU:0/stream:all");
+  stats = stream->add_node_stats();
+  stats->set_node_name("b:MatMul");
+  stats->set_all_start_micros(112);
+  stats->set_op_end_rel_micros(30);
+
+  std::vector<CriticalPathNode> nodes;
+  TF_ASSERT_OK(CriticalPathNodesFromStepStats(graph, step_stats, &nodes));
+  ASSERT_EQ(nodes.size(), 3);
+  EXPECT_EQ(nodes[2].name, "b");
+  EXPECT_EQ(nodes[2].op, "MatMul");
+  EXPECT_EQ(nodes[2].start_micros, 110);
+  EXPECT_EQ(nodes[2].end_micros, 142);
+  EXPECT_EQ(nodes[2].inputs, std::vector<string>({"a"}));
+
+  const CriticalPath path = AnalyzeCriticalPath(nodes);
+  EXPECT_EQ(PathNames(path), std::vector<string>({"a", "b", "c"}));
+  EXPECT_EQ(path.step_micros, 51);
+  EXPECT_EQ(path.critical_path_micros, 43);
+
+  const string report = CriticalPathToString(path, 1);
+  EXPECT_TRUE(absl::StrContains(
+      report, "top 1 critical path operation type: MatMul"));
+  EXPECT_TRUE(absl::StrContains(report, "top 1 critical path node: b"));
+  EXPECT_FALSE(absl::StrContains(report, "top 2"));
+}
+
+TEST(CriticalPathTest, EmptyStepStats) {
+  std::vector<CriticalPathNode> nodes;
+  EXPECT_FALSE(
+      CriticalPathNodesFromStepStats(GraphDef(), StepStats(), &nodes).ok());
+  EXPECT_EQ(AnalyzeCriticalPath(nodes).step_micros, 0);
+}
+
+}  // namespace
+}  // namespace tfprof
+}  // namespace tensorflow
@@ -24,12 +24,18 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+#endif
 
 namespace tensorflow {
 namespace profiler {
 
 // Combination of TraceMe and ScopedAnnotation which share the same label.
 // Optimization are done to ensure the label generation are done once.
+// When the hardware performance counters are enabled, the events counted by
+// the thread during the TraceMe are appended to its metadata.
 class AnnotatedTraceMe {
  public:
   template <typename NameGeneratorT>
@@ -44,11 +50,42 @@ class AnnotatedTraceMe {
       }
       if (TF_PREDICT_TRUE(traceme_enabled)) {
         trace_me_.emplace([&name] { return std::move(name); }, level);
+#if !defined(IS_MOBILE_PLATFORM)
+        if (TF_PREDICT_FALSE(PerfCounters::IsEnabled())) {
+          perf_counters_.emplace();
+          if (!PerfCounters::Read(&*perf_counters_)) perf_counters_.reset();
+        }
+#endif
       }
     }
   }
 
+  ~AnnotatedTraceMe() {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(perf_counters_.has_value())) AppendPerfCounters();
+#endif
+  }
+
  private:
+#if !defined(IS_MOBILE_PLATFORM)
+  void AppendPerfCounters() {
+    PerfCounters::Values end;
+    if (!PerfCounters::Read(&end)) return;
+    for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+      if (!end.valid[i]) continue;
+      const auto counter = static_cast<PerfCounters::Counter>(i);
+      const uint64 start = perf_counters_->count[i];
+      // Counts extrapolated while the PMU is shared may not be monotonic.
+      const uint64 count = end.count[i] > start ? end.count[i] - start : 0;
+      trace_me_->AppendMetadata([counter, count] {
+        return TraceMeEncode({{PerfCounters::Name(counter), count}});
+      });
+    }
+  }
+
+  // The counters of the thread when the TraceMe started.
+  absl::optional<PerfCounters::Values> perf_counters_;
+#endif
   absl::optional<TraceMe> trace_me_;
   absl::optional<ScopedAnnotation> scoped_annotation_;
 };
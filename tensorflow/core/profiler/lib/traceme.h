@@ -78,6 +78,21 @@ inline int GetTFTraceMeLevel(bool is_expensive) {
 //          ... do some work ...
 //          ActivityEnd(id);
 //       The two static methods should be called within the same thread.
+// A handle to a TraceMe name with static storage duration, such as a string
+// literal. TraceMe records the handle instead of copying the name into a
+// string, which makes tracing cheaper for fine-grained activities:
+//   static constexpr TraceMeStaticName kName("my_kernel");
+//   TraceMe trace(kName);
+class TraceMeStaticName {
+ public:
+  explicit constexpr TraceMeStaticName(const char* name) : name_(name) {}
+
+  constexpr const char* name() const { return name_; }
+
+ private:
+  const char* name_;
+};
+
 class TraceMe {
  public:
   // Constructor that traces a user-defined activity labeled with name
@@ -97,6 +112,18 @@ class TraceMe {
 #endif
   }
 
+  // Constructor that traces an activity labeled with a static name, without
+  // copying the name.
+  explicit TraceMe(TraceMeStaticName name, int level = 1) {
+    DCHECK_GE(level, 1);
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(TraceMeRecorder::Active(level))) {
+      static_name_ = name.name();
+      start_time_ = EnvTime::NowNanos();
+    }
+#endif
+  }
+
   // Do not allow passing a temporary string as the overhead of generating that
   // string should only be incurred when tracing is enabled. Wrap the temporary
   // string generation (e.g., StrCat) in a lambda and use the name_generator
@@ -159,11 +186,20 @@ class TraceMe {
     //   start/stop session timestamp.
 #if !defined(IS_MOBILE_PLATFORM)
     if (TF_PREDICT_FALSE(start_time_ != kUntracedActivity)) {
-      if (TF_PREDICT_TRUE(TraceMeRecorder::Active())) {
-        TraceMeRecorder::Record({kCompleteActivity, std::move(no_init_.name),
-                                 start_time_, EnvTime::NowNanos()});
+      if (static_name_ != nullptr) {
+        if (TF_PREDICT_TRUE(TraceMeRecorder::Active())) {
+          TraceMeRecorder::Record({kCompleteActivity, std::string(),
+                                   start_time_, EnvTime::NowNanos(),
+                                   static_name_});
+        }
+        static_name_ = nullptr;
+      } else {
+        if (TF_PREDICT_TRUE(TraceMeRecorder::Active())) {
+          TraceMeRecorder::Record({kCompleteActivity, std::move(no_init_.name),
+                                   start_time_, EnvTime::NowNanos()});
+        }
+        no_init_.name.~string();
       }
-      no_init_.name.~string();
       start_time_ = kUntracedActivity;
     }
 #endif
@@ -184,6 +220,11 @@ class TraceMe {
 #if !defined(IS_MOBILE_PLATFORM)
     if (TF_PREDICT_FALSE(start_time_ != kUntracedActivity)) {
       if (TF_PREDICT_TRUE(TraceMeRecorder::Active())) {
+        if (static_name_ != nullptr) {
+          // The name is modified, so it is copied after all.
+          new (&no_init_.name) std::string(static_name_);
+          static_name_ = nullptr;
+        }
         traceme_internal::AppendMetadata(&no_init_.name, metadata_generator());
       }
     }
@@ -285,13 +326,17 @@ class TraceMe {
   TF_DISALLOW_COPY_AND_ASSIGN(TraceMe);
 
   // Wrap the name into a union so that we can avoid the cost of string
-  // initialization when tracing is disabled.
+  // initialization when tracing is disabled. Only initialized if the activity
+  // is traced and `static_name_` is null.
   union NoInit {
     NoInit() {}
     ~NoInit() {}
     std::string name;
   } no_init_;
 
+  // The name of an activity traced with a TraceMeStaticName.
+  const char* static_name_ = nullptr;
+
   uint64 start_time_ = kUntracedActivity;
 };
 
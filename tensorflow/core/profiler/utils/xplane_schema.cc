@@ -195,6 +195,10 @@ const StatTypeMap& GetStatTypeMap() {
       {"Raw Value", kRawValue},
       {"Scaled Value", kScaledValue},
       {"Thread Id", kThreadId},
+      {"cycles", kCycles},
+      {"instructions", kInstructions},
+      {"llc_misses", kLlcMisses},
+      {"stalled_cycles", kStalledCycles},
       // XLA metadata map related.
       {"SELF_DURATION_PS", kSelfDurationPs},
       {"MIN_DURATION_PS", kMinDurationPs},
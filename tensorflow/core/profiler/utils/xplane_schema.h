@@ -184,6 +184,10 @@ enum StatType {
   kRawValue,
   kScaledValue,
   kThreadId,
+  kCycles,
+  kInstructions,
+  kLlcMisses,
+  kStalledCycles,
   // XLA metadata map related.
   kSelfDurationPs,
   kMinDurationPs,
@@ -274,6 +274,28 @@ class Session {
         "RunCallable with threadpool is not supported for this session.");
   }
 
+  /// \brief Invokes the subgraph named by `handle` once for every element of
+  /// `feed_tensors_batch`, in order.
+  ///
+  /// This is equivalent to calling `RunCallable()` in a loop, but resolves
+  /// `handle` and crosses the API boundary only once, which amortizes the
+  /// per-call overhead for small subgraphs. Implementations may overlap
+  /// iterations of subgraphs that have no stateful ops. On success
+  /// `(*fetch_tensors_batch)[i]` holds the fetches of iteration `i`. On
+  /// failure the remaining iterations are skipped and `*fetch_tensors_batch`
+  /// holds the fetches of the iterations that completed. If `run_metadata` is
+  /// non-null it accumulates the metadata of all iterations.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status RunCallableBatch(
+      CallableHandle handle,
+      const std::vector<std::vector<Tensor>>& feed_tensors_batch,
+      std::vector<std::vector<Tensor>>* fetch_tensors_batch,
+      RunMetadata* run_metadata,
+      const thread::ThreadPoolOptions& threadpool_options) {
+    return errors::Unimplemented(
+        "RunCallableBatch is not supported for this session.");
+  }
+
   /// \brief Releases resources associated with the given `handle` in this
   /// session.
   /// NOTE: This API is still experimental and may change.
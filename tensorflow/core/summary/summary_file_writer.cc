@@ -21,19 +21,28 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 namespace {
 
+// In the background mode, producers are held back (or their events dropped)
+// once this many times max_queue events are waiting to be written.
+constexpr int kMaxPendingQueues = 4;
+
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
+  SummaryFileWriter(int max_queue, int flush_millis, Env* env,
+                    bool write_in_background, bool drop_when_full)
       : SummaryWriterInterface(),
         is_initialized_(false),
         max_queue_(max_queue),
         flush_millis_(flush_millis),
+        write_in_background_(write_in_background),
+        drop_when_full_(drop_when_full),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -45,6 +54,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
       TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(logdir));
     }
     mutex_lock ml(mu_);
+    mutex_lock wl(writer_mu_);
     events_writer_ =
         tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
@@ -52,6 +62,10 @@ class SummaryFileWriter : public SummaryWriterInterface {
         "Could not initialize events writer.");
     last_flush_ = env_->NowMicros();
     is_initialized_ = true;
+    if (write_in_background_) {
+      writer_thread_.reset(env_->StartThread(
+          ThreadOptions(), "tf_summary_writer", [this]() { WriterLoop(); }));
+    }
     return Status::OK();
   }
 
@@ -60,11 +74,29 @@ class SummaryFileWriter : public SummaryWriterInterface {
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
+    if (write_in_background_) {
+      // Waits until the writer thread has written and flushed all the events
+      // enqueued so far.
+      const uint64 flush_id = ++flushes_requested_;
+      work_cv_.notify_one();
+      while (flushes_completed_ < flush_id) {
+        done_cv_.wait(ml);
+      }
+      return TakeBackgroundStatus();
+    }
     return InternalFlush();
   }
 
   ~SummaryFileWriter() override {
     (void)Flush();  // Ignore errors.
+    if (writer_thread_) {
+      {
+        mutex_lock ml(mu_);
+        stopping_ = true;
+      }
+      work_cv_.notify_one();
+      writer_thread_.reset();
+    }
   }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
@@ -140,6 +172,9 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
+    if (write_in_background_) {
+      return EnqueueEvent(std::move(event), &ml);
+    }
     queue_.emplace_back(std::move(event));
     if (queue_.size() > max_queue_ ||
         env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
@@ -156,25 +191,109 @@ class SummaryFileWriter : public SummaryWriterInterface {
   }
 
   Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
+    const Status s = WriteEvents(queue_);
+    queue_.clear();
+    TF_RETURN_IF_ERROR(s);
+    last_flush_ = env_->NowMicros();
+    return Status::OK();
+  }
+
+  // Writes `events` to the events file, and flushes it.
+  Status WriteEvents(const std::vector<std::unique_ptr<Event>>& events)
+      TF_LOCKS_EXCLUDED(writer_mu_) {
+    mutex_lock ml(writer_mu_);
+    for (const std::unique_ptr<Event>& e : events) {
       events_writer_->WriteEvent(*e);
     }
-    queue_.clear();
     TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
                                     "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
     return Status::OK();
   }
 
+  // Hands `event` to the writer thread, which it wakes up once a batch of
+  // events is ready to be written. Returns the first error of the writer
+  // thread since the last one returned.
+  Status EnqueueEvent(std::unique_ptr<Event> event, mutex_lock* ml)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const size_t max_pending = kMaxPendingQueues * (max_queue_ + 1);
+    while (queue_.size() >= max_pending) {
+      if (drop_when_full_) {
+        LOG_EVERY_N(WARNING, 1000)
+            << "Dropping summary events: the summary writer is falling "
+               "behind.";
+        return TakeBackgroundStatus();
+      }
+      done_cv_.wait(*ml);
+    }
+    queue_.emplace_back(std::move(event));
+    if (BatchIsReady()) work_cv_.notify_one();
+    return TakeBackgroundStatus();
+  }
+
+  bool BatchIsReady() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.size() > max_queue_ ||
+           (!queue_.empty() &&
+            env_->NowMicros() - last_flush_ > 1000 * flush_millis_);
+  }
+
+  Status TakeBackgroundStatus() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status s = background_status_;
+    background_status_ = Status::OK();
+    return s;
+  }
+
+  // Writes the enqueued events in batches, off the threads of the ops.
+  void WriterLoop() {
+    while (true) {
+      std::vector<std::unique_ptr<Event>> batch;
+      uint64 flush_id;
+      {
+        mutex_lock ml(mu_);
+        while (!stopping_ && flushes_completed_ == flushes_requested_ &&
+               !BatchIsReady()) {
+          // Wakes up periodically to write the events older than
+          // flush_millis.
+          WaitForMilliseconds(&ml, &work_cv_, std::max(flush_millis_, 1));
+        }
+        if (stopping_ && queue_.empty()) return;
+        std::swap(batch, queue_);
+        flush_id = flushes_requested_;
+        done_cv_.notify_all();  // Makes room for blocked producers.
+      }
+      const Status s = WriteEvents(batch);
+      batch.clear();
+      mutex_lock ml(mu_);
+      background_status_.Update(s);
+      last_flush_ = env_->NowMicros();
+      flushes_completed_ = flush_id;
+      done_cv_.notify_all();
+    }
+  }
+
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
+  // If true, events are written by writer_thread_ instead of the ops.
+  const bool write_in_background_;
+  // If true, events are dropped rather than held back while writer_thread_
+  // is behind.
+  const bool drop_when_full_;
   uint64 last_flush_;
   Env* env_;
   mutex mu_;
   std::vector<std::unique_ptr<Event>> queue_ TF_GUARDED_BY(mu_);
+  mutex writer_mu_;
   // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(writer_mu_);
+  std::unique_ptr<Thread> writer_thread_;
+  // Signaled when events are ready to be written.
+  condition_variable work_cv_;
+  // Signaled when writer_thread_ has taken or written a batch of events.
+  condition_variable done_cv_;
+  uint64 flushes_requested_ TF_GUARDED_BY(mu_) = 0;
+  uint64 flushes_completed_ TF_GUARDED_BY(mu_) = 0;
+  Status background_status_ TF_GUARDED_BY(mu_);
+  bool stopping_ TF_GUARDED_BY(mu_) = false;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       TF_GUARDED_BY(mu_);
 };
@@ -185,7 +304,14 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  bool write_in_background;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SUMMARY_WRITE_IN_BACKGROUND",
+                                        false, &write_in_background));
+  bool drop_when_full;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SUMMARY_DROP_WHEN_FULL", false,
+                                        &drop_when_full));
+  SummaryFileWriter* w = new SummaryFileWriter(
+      max_queue, flush_millis, env, write_in_background, drop_when_full);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
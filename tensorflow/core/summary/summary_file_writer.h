@@ -33,6 +33,12 @@ namespace tensorflow {
 /// filename_suffix. The caller owns a reference to result if the
 /// returned status is ok. The Env object must not be destroyed until
 /// after the returned writer.
+///
+/// If the TF_SUMMARY_WRITE_IN_BACKGROUND environment variable is true,
+/// the summaries are written and flushed by a background thread instead of
+/// the ops, and write errors are reported by later calls. Ops are then held
+/// back while the thread falls behind by several queues, or, if
+/// TF_SUMMARY_DROP_WHEN_FULL is true, their summaries are dropped.
 Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
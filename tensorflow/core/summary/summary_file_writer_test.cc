@@ -231,5 +231,44 @@ TEST_F(SummaryFileWriterTest, WallTime) {
       [](const Event& e) { EXPECT_EQ(e.wall_time(), 7.023); }));
 }
 
+TEST_F(SummaryFileWriterTest, WriteInBackground) {
+  setenv("TF_SUMMARY_WRITE_IN_BACKGROUND", "1", /*overwrite=*/1);
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(4, 1000, testing::TmpDir(),
+                                      "background_test", &env_, &writer));
+  unsetenv("TF_SUMMARY_WRITE_IN_BACKGROUND");
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  for (int step = 0; step < 50; ++step) {
+    TF_CHECK_OK(writer->WriteScalar(step, one, "name"));
+  }
+  TF_CHECK_OK(writer->Flush());
+  writer->Unref();
+
+  std::vector<string> files;
+  TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+  int num_files = 0;
+  for (const string& f : files) {
+    if (!absl::StrContains(f, "background_test")) continue;
+    ++num_files;
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                         &read_file));
+    io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+    tstring record;
+    uint64 offset = 0;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));  // The file version.
+    // The events are written in order.
+    for (int step = 0; step < 50; ++step) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      Event e;
+      e.ParseFromString(record);
+      EXPECT_EQ(e.step(), step);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+  }
+  EXPECT_EQ(num_files, 1);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -108,6 +108,17 @@ class CTCBeamSearchDecoder : public CTCDecoder<T> {
   template <typename Vector>
   void Step(const Vector& log_input_t);
 
+  // Like Step, with the softmax normalization term of `log_input_t`,
+  // LogNormalizer(log_input_t), computed by the caller. This lets callers
+  // compute the terms of all the time steps at once, in parallel, before
+  // running the steps, which depend on each other.
+  template <typename Vector>
+  void Step(const Vector& log_input_t, T norm_offset);
+
+  // Returns log(sum(exp(input))), computed stably and vectorized.
+  template <typename Vector>
+  static T LogNormalizer(const Vector& input);
+
   template <typename Vector>
   T GetTopK(const int K, const Vector& input, std::vector<T>* top_k_logits,
             std::vector<int>* top_k_indices);
@@ -150,6 +161,12 @@ class CTCBeamSearchDecoder : public CTCDecoder<T> {
 
   gtl::TopN<BeamEntry*, CTCBeamComparer> leaves_;
   std::unique_ptr<BeamRoot> beam_root_;
+
+  // The labels that pass label selection at the current step, and their log
+  // probabilities. Selected once per step rather than once per beam, and
+  // kept across steps to reuse their storage.
+  std::vector<int> candidate_labels_;
+  std::vector<T> candidate_log_probs_;
   BaseBeamScorer<T, CTCBeamState>* beam_scorer_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
@@ -244,37 +261,53 @@ T CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::GetTopK(
   return std::max((*top_k_logits)[0], input(this->num_classes_ - 1));
 }
 
+template <typename T, typename CTCBeamState, typename CTCBeamComparer>
+template <typename Vector>
+T CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::LogNormalizer(
+    const Vector& input) {
+  // log(sum(exp(logit[j]))) = max_coeff + log(sum(exp(logit[j]-max_coeff))).
+  const T max_coeff = input.maxCoeff();
+  return max_coeff +
+         Eigen::numext::log((input.array() - max_coeff).exp().sum());
+}
+
 template <typename T, typename CTCBeamState, typename CTCBeamComparer>
 template <typename Vector>
 void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
     const Vector& raw_input) {
-  std::vector<T> top_k_logits;
-  std::vector<int> top_k_indices;
-  const bool top_k =
-      (label_selection_size_ > 0 && label_selection_size_ < raw_input.size());
-  // Number of character classes to consider in each step.
-  const int max_classes =
-      top_k ? label_selection_size_ : (this->num_classes_ - 1);
-  // Get max coefficient and remove it from raw_input later.
-  T max_coeff;
-  if (top_k) {
-    max_coeff = GetTopK(label_selection_size_, raw_input, &top_k_logits,
-                        &top_k_indices);
-  } else {
-    max_coeff = raw_input.maxCoeff();
-  }
-  // Get normalization term of softmax: log(sum(exp(logit[j]-max_coeff))).
-  T logsumexp = T(0.0);
-  for (int j = 0; j < raw_input.size(); ++j) {
-    logsumexp += Eigen::numext::exp(raw_input(j) - max_coeff);
-  }
-  logsumexp = Eigen::numext::log(logsumexp);
-  // Final normalization offset to get correct log probabilities.
-  T norm_offset = max_coeff + logsumexp;
+  Step(raw_input, LogNormalizer(raw_input));
+}
 
+template <typename T, typename CTCBeamState, typename CTCBeamComparer>
+template <typename Vector>
+void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
+    const Vector& raw_input, T norm_offset) {
+  // Select the labels that new leaves may end with, once for all the beams.
+  candidate_labels_.clear();
+  candidate_log_probs_.clear();
   const T label_selection_input_min =
-      (label_selection_margin_ >= 0) ? (max_coeff - label_selection_margin_)
-                                     : -std::numeric_limits<T>::infinity();
+      (label_selection_margin_ >= 0)
+          ? (raw_input.maxCoeff() - label_selection_margin_)
+          : -std::numeric_limits<T>::infinity();
+  // If input for a label looks very unpromising, never evaluate it with a
+  // scorer. We may compare logits instead of log probabilities, since the
+  // difference is the same in both cases.
+  if (label_selection_size_ > 0 && label_selection_size_ < raw_input.size()) {
+    std::vector<T> top_k_logits;
+    std::vector<int> top_k_indices;
+    GetTopK(label_selection_size_, raw_input, &top_k_logits, &top_k_indices);
+    for (int ind = 0; ind < label_selection_size_; ++ind) {
+      if (top_k_logits[ind] < label_selection_input_min) continue;
+      candidate_labels_.push_back(top_k_indices[ind]);
+      candidate_log_probs_.push_back(top_k_logits[ind] - norm_offset);
+    }
+  } else {
+    for (int label = 0; label < this->num_classes_ - 1; ++label) {
+      if (raw_input(label) < label_selection_input_min) continue;
+      candidate_labels_.push_back(label);
+      candidate_log_probs_.push_back(raw_input(label) - norm_offset);
+    }
+  }
 
   // Extract the beams sorted in decreasing new probability
   CHECK_EQ(this->num_classes_, raw_input.size());
@@ -336,16 +369,8 @@ void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
       continue;
     }
 
-    for (int ind = 0; ind < max_classes; ind++) {
-      const int label = top_k ? top_k_indices[ind] : ind;
-      const T logit = top_k ? top_k_logits[ind] : raw_input(ind);
-      // Perform label selection: if input for this label looks very
-      // unpromising, never evaluate it with a scorer.
-      // We may compare logits instead of log probabilities, 
-      // since the difference is the same in both cases.
-      if (logit < label_selection_input_min) {
-        continue;
-      }
+    for (int ind = 0; ind < candidate_labels_.size(); ind++) {
+      const int label = candidate_labels_[ind];
       BeamEntry& c = b->GetChild(label);
       if (!c.Active()) {
         //   Pblank(l=abcd @ t=6) = 0
@@ -356,7 +381,7 @@ void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
         //   Plabel(l=abcd @ t=6) = P(l=abc @ t=5) * P(d @ 6)
         beam_scorer_->ExpandState(b->state, b->label, &c.state, c.label);
         T previous = (c.label == b->label) ? b->oldp.blank : b->oldp.total;
-        c.newp.label = logit - norm_offset +
+        c.newp.label = candidate_log_probs_[ind] +
                        beam_scorer_->GetStateExpansionScore(c.state, previous);
         // P(l=abcd @ t=6) = Plabel(l=abcd @ t=6)
         c.newp.total = c.newp.label;
@@ -371,6 +371,45 @@ void ctc_beam_search_label_selection() {
   }
 }
 
+template <class T>
+void ctc_beam_search_precomputed_normalizer() {
+  const int timesteps = 4;
+  const int top_paths = 3;
+  const int num_classes = 5;
+  const T input_data[timesteps][num_classes] = {{0.1, 0.6, 0.1, 0.1, 0.1},
+                                                {0.2, 0.3, 2.0, 0.1, 0.5},
+                                                {1.5, 0.3, 0.2, 0.1, 0.5},
+                                                {0.2, 0.3, 0.2, 0.1, 3.0}};
+
+  typename tensorflow::ctc::CTCBeamSearchDecoder<T>::DefaultBeamScorer
+      default_scorer;
+  tensorflow::ctc::CTCBeamSearchDecoder<T> decoder(num_classes, top_paths,
+                                                   &default_scorer);
+  tensorflow::ctc::CTCBeamSearchDecoder<T> precomputed_decoder(
+      num_classes, top_paths, &default_scorer);
+  for (int t = 0; t < timesteps; ++t) {
+    Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> input(
+        &input_data[t][0], num_classes);
+    // The normalizer is log(sum(exp(input))).
+    T sum = 0;
+    for (int c = 0; c < num_classes; ++c) sum += std::exp(input_data[t][c]);
+    const T norm_offset = decoder.LogNormalizer(input);
+    EXPECT_NEAR(norm_offset, std::log(sum), 1e-5);
+    decoder.Step(input);
+    precomputed_decoder.Step(input, norm_offset);
+  }
+
+  std::vector<std::vector<int>> paths, precomputed_paths;
+  std::vector<T> log_probs, precomputed_log_probs;
+  EXPECT_TRUE(decoder.TopPaths(top_paths, &paths, &log_probs, false).ok());
+  EXPECT_TRUE(precomputed_decoder
+                  .TopPaths(top_paths, &precomputed_paths,
+                            &precomputed_log_probs, false)
+                  .ok());
+  EXPECT_EQ(paths, precomputed_paths);
+  EXPECT_EQ(log_probs, precomputed_log_probs);
+}
+
 TEST(CtcBeamSearch, FloatDecodingWithAndWithoutDictionary) {
   ctc_beam_search_decoding_with_and_without_dictionary<float>();
 }
@@ -395,4 +434,12 @@ TEST(CtcBeamSearch, DoubleLabelSelection) {
   ctc_beam_search_label_selection<double>();
 }
 
+TEST(CtcBeamSearch, FloatPrecomputedNormalizer) {
+  ctc_beam_search_precomputed_normalizer<float>();
+}
+
+TEST(CtcBeamSearch, DoublePrecomputedNormalizer) {
+  ctc_beam_search_precomputed_normalizer<double>();
+}
+
 }  // namespace
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -113,6 +114,68 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Points `*data` to the next `length` bytes of `stream`, which must alias a
+// flat array, and skips over them.
+bool ReadRawAliased(protobuf::io::CodedInputStream* stream, uint32 length,
+                    const uint8** data) {
+  *data = nullptr;
+  if (length == 0) return true;
+  const void* ptr;
+  int size;
+  if (!stream->GetDirectBufferPointer(&ptr, &size) ||
+      static_cast<uint32>(size) < length) {
+    return false;
+  }
+  *data = static_cast<const uint8*>(ptr);
+  return stream->Skip(length);
+}
+
+// Returns the number of varints in [begin, end), i.e. the number of bytes
+// without a continuation bit. The loop has no branches, so that the compiler
+// can vectorize it.
+size_t CountVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p < end; ++p) count += *p < 0x80;
+  return count;
+}
+
+// Decodes the packed varints in [begin, end) into `out`, dropping the values
+// past the first `capacity` ones. Returns false if a varint is truncated or
+// longer than 10 bytes.
+//
+// Packed int64 lists mostly hold small values (ids, counts, booleans), so
+// runs of eight one-byte varints are detected with a single load and mask,
+// and copied without decoding.
+template <typename T>
+bool DecodePackedVarints(const uint8* begin, const uint8* end, T* out,
+                         size_t capacity) {
+  constexpr uint64 kContinuationBits = 0x8080808080808080ULL;
+  const uint8* p = begin;
+  size_t index = 0;
+  while (p < end) {
+    if (end - p >= 8 && index + 8 <= capacity) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      if ((word & kContinuationBits) == 0) {
+        for (int i = 0; i < 8; ++i) out[index + i] = p[i];
+        index += 8;
+        p += 8;
+        continue;
+      }
+    }
+    uint64 value = 0;
+    for (int shift = 0;; shift += 7) {
+      if (p == end || shift > 63) return false;
+      const uint8 byte = *p++;
+      value |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (byte < 0x80) break;
+    }
+    if (index < capacity) out[index] = static_cast<T>(value);
+    ++index;
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -299,15 +362,19 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        const uint8* data;
+        if (!ReadRawAliased(&stream, packed_length, &data)) return false;
+
+        // Size the output once, then decode into it. A LimitedArraySlice may
+        // have room for fewer values than requested, see ParseFloatList.
+        const size_t initial_size = int64_list->size();
+        int64_list->resize(initial_size +
+                           CountVarints(data, data + packed_length));
+        if (!DecodePackedVarints(data, data + packed_length,
+                                 int64_list->data() + initial_size,
+                                 int64_list->size() - initial_size)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -1955,18 +2022,20 @@ inline int ParseInt64Feature(protobuf::io::CodedInputStream* stream,
           !stream->ReadVarint32(&packed_length)) {
         return -1;
       }
-      auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        protobuf_uint64 n;  // There is no API for int64
-        if (!stream->ReadVarint64(&n)) {
+      const uint8* data;
+      if (!ReadRawAliased(stream, packed_length, &data)) {
+        return -1;
+      }
+      num_elements = CountVarints(data, data + packed_length);
+      if (out != nullptr) {
+        if (!DecodePackedVarints(data, data + packed_length, out,
+                                 num_elements)) {
           return -1;
         }
-        if (out != nullptr) {
-          *out++ = n;
-        }
-        num_elements++;
+      } else if (packed_length > 0 && data[packed_length - 1] >= 0x80) {
+        // The last varint is truncated.
+        return -1;
       }
-      stream->PopLimit(packed_limit);
     } else if (peek_tag == kVarintTag(1)) {
       while (!stream->ExpectAtEnd()) {
         protobuf_uint64 n;  // There is no API for int64
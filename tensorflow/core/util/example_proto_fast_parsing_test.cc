@@ -213,6 +213,37 @@ TEST(FastParse, SingleInt64) {
   TestCorrectness(Serialize(example));
 }
 
+TEST(FastParse, PackedInt64OfMixedWidths) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["ids"]
+          .mutable_int64_list();
+  // Runs of one-byte varints, interleaved with wider and negative values.
+  for (int i = 0; i < 20; ++i) int64_list->add_value(i);
+  int64_list->add_value(kint64max);
+  for (int i = 0; i < 9; ++i) int64_list->add_value(127 - i);
+  int64_list->add_value(-1);
+  int64_list->add_value(kint64min);
+  int64_list->add_value(300);
+  for (int i = 0; i < 7; ++i) int64_list->add_value(1);
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  Example example;
+  (*example.mutable_features()->mutable_feature())["age"]
+      .mutable_int64_list()
+      ->add_value(300);
+  string serialized = Serialize(example);
+  // 300 is encoded as the varint "\xac\x02". Setting the continuation bit of
+  // its last byte makes the varint run past the end of the packed list.
+  const size_t pos = serialized.find("\xac\x02");
+  ASSERT_NE(string::npos, pos);
+  serialized[pos + 1] = static_cast<char>(0x82);
+  Example fast_example;
+  EXPECT_FALSE(TestFastParse(serialized, &fast_example));
+}
+
 static string ExampleWithSomeFeatures() {
   Example example;
 
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/memmapped_file_system.h"
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -31,6 +35,30 @@ uint64 DecodeUint64LittleEndian(const uint8* buffer) {
   return result;
 }
 
+// Skips the value of a field of wire type `wire_type` in `input`.
+bool SkipFieldValue(uint32 wire_type, protobuf::io::CodedInputStream* input) {
+  switch (wire_type) {
+    case 0: {  // Varint.
+      protobuf_uint64 value;
+      return input->ReadVarint64(&value);
+    }
+    case 1: {  // Fixed64.
+      protobuf_uint64 value;
+      return input->ReadLittleEndian64(&value);
+    }
+    case 2: {  // Length delimited.
+      uint32 length;
+      return input->ReadVarint32(&length) && input->Skip(length);
+    }
+    case 5: {  // Fixed32.
+      uint32 value;
+      return input->ReadLittleEndian32(&value);
+    }
+    default:  // Groups are not used by GraphDef.
+      return false;
+  }
+}
+
 }  // namespace
 
 namespace {
@@ -314,4 +342,80 @@ Status MemmappedEnv::InitializeFromFile(const string& package_filename) {
   return status;
 }
 
+Status ReadMemmappedGraphDef(Env* env, const string& filename,
+                             thread::ThreadPool* pool, GraphDef* graph_def) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(filename, &region));
+  if (region->length() > static_cast<uint64>(kint32max)) {
+    return errors::InvalidArgument("Can't parse ", filename,
+                                   " as binary proto: ", region->length(),
+                                   " bytes is more than the proto limit");
+  }
+  const uint8* data = static_cast<const uint8*>(region->data());
+  const int size = static_cast<int>(region->length());
+
+  // Finds the serialized nodes, and copies the other fields, which are
+  // parsed as a GraphDef without nodes.
+  struct NodeRange {
+    int offset;
+    int size;
+  };
+  std::vector<NodeRange> nodes;
+  string other_fields;
+  protobuf::io::CodedInputStream input(data, size);
+  input.SetTotalBytesLimit(kint32max, kint32max);
+  bool consumed = false;
+  while (true) {
+    const int field_start = input.CurrentPosition();
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) {
+      consumed = input.ConsumedEntireMessage();
+      break;
+    }
+    const uint32 field_number = tag >> 3;
+    const uint32 wire_type = tag & 7;
+    if (field_number == GraphDef::kNodeFieldNumber && wire_type == 2) {
+      uint32 length;
+      if (!input.ReadVarint32(&length)) break;
+      const int offset = input.CurrentPosition();
+      if (!input.Skip(length)) break;
+      nodes.push_back({offset, static_cast<int>(length)});
+      continue;
+    }
+    if (!SkipFieldValue(wire_type, &input)) break;
+    other_fields.append(reinterpret_cast<const char*>(data + field_start),
+                        input.CurrentPosition() - field_start);
+  }
+  if (!consumed || input.CurrentPosition() != size ||
+      !graph_def->ParseFromString(other_fields)) {
+    return errors::DataLoss("Can't parse ", filename, " as binary proto");
+  }
+
+  auto* node_defs = graph_def->mutable_node();
+  node_defs->Reserve(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) node_defs->Add();
+  std::atomic<bool> ok(true);
+  auto parse_nodes = [&](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      if (!node_defs->Mutable(i)->ParseFromArray(data + nodes[i].offset,
+                                                   nodes[i].size)) {
+        ok = false;
+      }
+    }
+  };
+  if (pool == nullptr) {
+    parse_nodes(0, nodes.size());
+  } else {
+    // The cost is the number of bytes parsed.
+    pool->ParallelFor(nodes.size(), size / std::max<size_t>(nodes.size(), 1),
+                      parse_nodes);
+  }
+  if (!ok) {
+    graph_def->Clear();
+    return errors::DataLoss("Can't parse the nodes of ", filename,
+                            " as binary proto");
+  }
+  return Status::OK();
+}
+
 }  // namespace tensorflow
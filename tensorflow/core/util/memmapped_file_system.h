@@ -20,7 +20,9 @@ limitations under the License.
 #include <string>
 #include <unordered_map>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -133,6 +135,18 @@ class MemmappedEnv : public EnvWrapper {
   std::unique_ptr<MemmappedFileSystem> memmapped_file_system_;
 };
 
+// Reads the GraphDef saved as binary proto in `filename`, usually
+// MemmappedFileSystem::kMemmappedPackageDefaultGraphDef of a MemmappedEnv.
+//
+// Unlike ReadBinaryProto(), the proto is parsed straight from the memory
+// region of the file, without buffering, and the nodes, whose attrs make
+// most of the parsing time of big graphs, are parsed in parallel on `pool`.
+// With a null `pool` they are parsed in the calling thread. The result is
+// meant to be moved into Session::Create(GraphDef&&), which moves the nodes
+// into the graph instead of copying them.
+Status ReadMemmappedGraphDef(Env* env, const string& filename,
+                             thread::ThreadPool* pool, GraphDef* graph_def);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_UTIL_MEMMAPPED_FILE_SYSTEM_H_
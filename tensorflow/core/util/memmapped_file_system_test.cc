@@ -17,9 +17,11 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 namespace tensorflow {
@@ -110,6 +112,55 @@ TEST(MemmappedFileSystemTest, SimpleTest) {
             memmapped_env.FileExists("bla-bla-bla").code());
 }
 
+TEST(MemmappedFileSystemTest, ReadGraphDef) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  Node* previous = ops::SourceOp("Const", b.opts()
+                                             .WithName("const")
+                                             .WithAttr("dtype", DT_FLOAT)
+                                             .WithAttr("value", Tensor(1.0f)));
+  for (int i = 0; i < 100; ++i) {
+    previous = ops::UnaryOp("Identity", previous,
+                            b.opts().WithName(strings::StrCat("identity", i)));
+  }
+  GraphDef graph_def;
+  TF_ASSERT_OK(b.ToGraphDef(&graph_def));
+  graph_def.mutable_versions()->set_producer(kTestGraphDefVersion);
+  graph_def.mutable_library()->add_function()->mutable_signature()->set_name(
+      "function");
+
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "memmapped_env_graph_def_test");
+  MemmappedFileSystemWriter writer;
+  TF_ASSERT_OK(writer.InitializeToFile(Env::Default(), filename));
+  TF_ASSERT_OK(writer.SaveProtobuf(
+      graph_def, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef));
+  TF_ASSERT_OK(writer.SaveProtobuf(graph_def.node(0), kProtoFileName));
+  TF_ASSERT_OK(writer.FlushAndClose());
+
+  MemmappedEnv memmapped_env(Env::Default());
+  TF_ASSERT_OK(memmapped_env.InitializeFromFile(filename));
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  for (thread::ThreadPool* p : {&pool, static_cast<thread::ThreadPool*>(
+                                           nullptr)}) {
+    GraphDef read_graph_def;
+    TF_ASSERT_OK(ReadMemmappedGraphDef(
+        &memmapped_env, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+        p, &read_graph_def));
+    EXPECT_EQ(graph_def.DebugString(), read_graph_def.DebugString());
+  }
+
+  // A NodeDef is not a GraphDef.
+  GraphDef read_graph_def;
+  EXPECT_EQ(error::DATA_LOSS,
+            ReadMemmappedGraphDef(&memmapped_env, kProtoFileName, &pool,
+                                  &read_graph_def)
+                .code());
+  EXPECT_EQ(error::NOT_FOUND,
+            ReadMemmappedGraphDef(&memmapped_env, kTensor1FileName, &pool,
+                                  &read_graph_def)
+                .code());
+}
+
 TEST(MemmappedFileSystemTest, NotInitialized) {
   MemmappedEnv memmapped_env(Env::Default());
   std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+constexpr int64 AsyncCheckpointWriter::kDefaultMaxInFlightMB;
+
+AsyncCheckpointWriter::AsyncCheckpointWriter(Env* env,
+                                             int64 max_in_flight_bytes)
+    : env_(env), max_in_flight_bytes_(max_in_flight_bytes) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "TF_async_checkpoint",
+                                  [this]() { WorkerLoop(); }));
+}
+
+AsyncCheckpointWriter::~AsyncCheckpointWriter() {
+  {
+    mutex_lock l(mu_);
+    shutdown_ = true;
+    cond_.notify_all();
+  }
+  // Joins the background thread, which drains the queue before exiting.
+  thread_.reset();
+}
+
+void AsyncCheckpointWriter::Save(const string& prefix,
+                                 std::vector<Entry> entries,
+                                 DoneCallback done) {
+  int64 bytes = 0;
+  for (const Entry& entry : entries) bytes += entry.tensor.TotalBytes();
+  mutex_lock l(mu_);
+  while (in_flight_bytes_ > 0 &&
+         in_flight_bytes_ + bytes > max_in_flight_bytes_) {
+    VLOG(1) << "Waiting for " << in_flight_bytes_
+            << " in-flight checkpoint bytes before saving " << prefix;
+    cond_.wait(l);
+  }
+  in_flight_bytes_ += bytes;
+  ++num_pending_;
+  queue_.push_back({prefix, std::move(entries), std::move(done), bytes});
+  cond_.notify_all();
+}
+
+Status AsyncCheckpointWriter::Wait() {
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) {
+    cond_.wait(l);
+  }
+  Status s = status_;
+  status_ = Status::OK();
+  return s;
+}
+
+int64 AsyncCheckpointWriter::in_flight_bytes() const {
+  mutex_lock l(mu_);
+  return in_flight_bytes_;
+}
+
+void AsyncCheckpointWriter::WorkerLoop() {
+  while (true) {
+    Request request;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !shutdown_) {
+        cond_.wait(l);
+      }
+      if (queue_.empty()) return;
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    const Status s = Write(request);
+    if (!s.ok()) {
+      LOG(ERROR) << "Asynchronous save of " << request.prefix
+                 << " failed: " << s;
+    }
+    if (request.done) request.done(s);
+    // Releases the snapshot before waking up the blocked savers.
+    request.entries.clear();
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+      in_flight_bytes_ -= request.bytes;
+      --num_pending_;
+      cond_.notify_all();
+    }
+  }
+}
+
+Status AsyncCheckpointWriter::Write(const Request& request) {
+  VLOG(1) << "Asynchronously writing " << request.entries.size()
+          << " tensors to " << request.prefix;
+  BundleWriter writer(env_, request.prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (const Entry& entry : request.entries) {
+    if (entry.is_slice) {
+      TF_RETURN_IF_ERROR(writer.AddSlice(entry.key, entry.full_shape,
+                                         entry.slice, entry.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(entry.key, entry.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+AsyncCheckpointWriter* AsyncCheckpointWriter::Global() {
+  static AsyncCheckpointWriter* writer = []() {
+    int64 max_in_flight_mb;
+    Status s = ReadInt64FromEnvVar("TF_ASYNC_CHECKPOINT_MAX_IN_FLIGHT_MB",
+                                   kDefaultMaxInFlightMB, &max_in_flight_mb);
+    if (!s.ok() || max_in_flight_mb <= 0) {
+      LOG(WARNING) << "Invalid TF_ASYNC_CHECKPOINT_MAX_IN_FLIGHT_MB, using "
+                   << kDefaultMaxInFlightMB << ": " << s;
+      max_in_flight_mb = kDefaultMaxInFlightMB;
+    }
+    return new AsyncCheckpointWriter(Env::Default(), max_in_flight_mb << 20);
+  }();
+  return writer;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,128 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Writes tensor bundles on a background thread.
+//
+// Save() takes a snapshot of the tensors to write and returns as soon as the
+// save is queued, so that the caller (typically a training step) does not wait
+// for serialization and file system writes.  A snapshot holds a reference to
+// each tensor buffer; resource variables copy their buffer before updating it
+// in place while such a reference exists, so the saved values are those at the
+// time of the Save() call.  Callers that mutate buffers in place regardless
+// (e.g. legacy reference variables) must pass deep copies.
+//
+// Bundles are written with BundleWriter, which only renames the metadata file
+// into place once all data is written, so a reader never observes a partially
+// written checkpoint under `prefix`.
+//
+// The total size of the snapshots that are queued or being written is capped
+// at `max_in_flight_bytes`: Save() blocks until enough earlier saves complete.
+// A single save larger than the cap is admitted once nothing else is in flight.
+//
+// Saves are written in the order in which they were queued.  Thread-safe.
+class AsyncCheckpointWriter {
+ public:
+  // One tensor, or one slice of a partitioned tensor, to save.
+  struct Entry {
+    string key;
+    Tensor tensor;
+    // If true, `tensor` holds `slice` of a tensor of shape `full_shape`, and
+    // is saved with BundleWriter::AddSlice().
+    bool is_slice = false;
+    TensorShape full_shape;
+    TensorSlice slice;
+  };
+
+  // Called with the result of writing one bundle, on the background thread.
+  typedef std::function<void(const Status&)> DoneCallback;
+
+  AsyncCheckpointWriter(Env* env, int64 max_in_flight_bytes);
+
+  // Waits for all queued saves to complete.
+  ~AsyncCheckpointWriter();
+
+  // Queues the bundle made of `entries` to be written under `prefix`.  `done`,
+  // if not null, is called once the bundle is written or failed to write.
+  void Save(const string& prefix, std::vector<Entry> entries,
+            DoneCallback done = nullptr);
+
+  // Blocks until all saves queued so far have completed.  Returns the first
+  // error encountered by a save since the previous call to Wait().
+  Status Wait();
+
+  // Returns the number of bytes held by queued or in-progress saves.
+  int64 in_flight_bytes() const;
+
+  // Returns the process-wide writer.  Its in-flight cap is read from the
+  // environment variable TF_ASYNC_CHECKPOINT_MAX_IN_FLIGHT_MB, and defaults to
+  // kDefaultMaxInFlightMB.
+  static AsyncCheckpointWriter* Global();
+
+  static constexpr int64 kDefaultMaxInFlightMB = 4096;
+
+ private:
+  struct Request {
+    string prefix;
+    std::vector<Entry> entries;
+    DoneCallback done;
+    int64 bytes;
+  };
+
+  void WorkerLoop();
+  Status Write(const Request& request);
+
+  Env* const env_;
+  const int64 max_in_flight_bytes_;
+
+  mutable mutex mu_;
+  condition_variable cond_;
+  std::deque<Request> queue_ TF_GUARDED_BY(mu_);
+  // Bytes held by the requests in `queue_` and the one being written.
+  int64 in_flight_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // Number of requests queued or being written.
+  int num_pending_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+
+  // Declared last, so that it is joined before the members it uses go away.
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncCheckpointWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
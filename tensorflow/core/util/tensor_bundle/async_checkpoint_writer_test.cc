@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+AsyncCheckpointWriter::Entry MakeEntry(const string& key,
+                                       const Tensor& tensor) {
+  AsyncCheckpointWriter::Entry entry;
+  entry.key = key;
+  entry.tensor = tensor;
+  return entry;
+}
+
+TEST(AsyncCheckpointWriterTest, SavesInBackground) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_simple");
+  AsyncCheckpointWriter writer(Env::Default(), 1 << 20);
+
+  std::vector<AsyncCheckpointWriter::Entry> entries;
+  entries.push_back(
+      MakeEntry("full", test::AsTensor<float>({1, 2, 3}, TensorShape({3}))));
+  AsyncCheckpointWriter::Entry slice =
+      MakeEntry("part", test::AsTensor<int32>({7, 8}, TensorShape({2})));
+  slice.is_slice = true;
+  slice.full_shape = TensorShape({4});
+  TF_ASSERT_OK(TensorSlice::Parse("2,2", &slice.slice));
+  entries.push_back(slice);
+
+  Notification done;
+  Status done_status = errors::Unknown("not called");
+  writer.Save(prefix, std::move(entries), [&](const Status& s) {
+    done_status = s;
+    done.Notify();
+  });
+  TF_ASSERT_OK(writer.Wait());
+  ASSERT_TRUE(done.HasBeenNotified());
+  TF_EXPECT_OK(done_status);
+  EXPECT_EQ(0, writer.in_flight_bytes());
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("full", &val));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3}, TensorShape({3})), val);
+  Tensor part(DT_INT32, TensorShape({2}));
+  TF_ASSERT_OK(reader.LookupSlice("part", slice.slice, &part));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>({7, 8}, TensorShape({2})), part);
+}
+
+TEST(AsyncCheckpointWriterTest, CapsInFlightBytes) {
+  Tensor tensor(DT_FLOAT, TensorShape({256}));
+  tensor.flat<float>().setZero();
+  // Only one save of `tensor` fits under the cap.
+  AsyncCheckpointWriter writer(Env::Default(), tensor.TotalBytes());
+
+  Notification release;
+  writer.Save(io::JoinPath(testing::TmpDir(), "async_cap_0"),
+              {MakeEntry("t", tensor)},
+              [&release](const Status& s) { release.WaitForNotification(); });
+  EXPECT_EQ(tensor.TotalBytes(), writer.in_flight_bytes());
+
+  Notification second_queued;
+  std::unique_ptr<Thread> saver(Env::Default()->StartThread(
+      ThreadOptions(), "saver", [&writer, &tensor, &second_queued]() {
+        writer.Save(io::JoinPath(testing::TmpDir(), "async_cap_1"),
+                    {MakeEntry("t", tensor)});
+        second_queued.Notify();
+      }));
+  EXPECT_FALSE(WaitForNotificationWithTimeout(&second_queued, 100 * 1000));
+
+  release.Notify();
+  second_queued.WaitForNotification();
+  saver.reset();
+  TF_EXPECT_OK(writer.Wait());
+  EXPECT_EQ(0, writer.in_flight_bytes());
+}
+
+TEST(AsyncCheckpointWriterTest, WaitReturnsFirstError) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_error");
+  AsyncCheckpointWriter writer(Env::Default(), 1 << 20);
+  const Tensor tensor = test::AsScalar<int32>(1);
+
+  Status done_status;
+  writer.Save(prefix, {MakeEntry("a", tensor), MakeEntry("a", tensor)},
+              [&done_status](const Status& s) { done_status = s; });
+  writer.Save(prefix, {MakeEntry("a", tensor)});
+  const Status s = writer.Wait();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+  EXPECT_EQ(s, done_status);
+  // The error is only reported once, and later saves still go through.
+  TF_EXPECT_OK(writer.Wait());
+  BundleReader reader(Env::Default(), prefix);
+  TF_EXPECT_OK(reader.status());
+  EXPECT_TRUE(reader.Contains("a"));
+}
+
+}  // namespace
+}  // namespace tensorflow
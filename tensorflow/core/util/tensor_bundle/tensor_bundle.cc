@@ -16,11 +16,14 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -35,13 +38,17 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap.h"
@@ -57,6 +64,11 @@ const int kTensorBundleVersion = 1;
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
 
+// Default size of the chunks in which large tensors are read in parallel, and
+// maximum number of chunks of a tensor read at the same time.
+static const int64 kDefaultParallelReadChunkSizeInMB = 16;
+static const int kMaxParallelReadsPerTensor = 8;
+
 // Key to the special BundleHeaderProto entry.  Do not change this, as clients
 // can make the assumption that the header is always the first entry in the
 // bundle.
@@ -213,6 +225,59 @@ tstring* GetStringBackingBuffer(const Tensor& val) {
   return const_cast<tstring*>(val.flat<tstring>().data());
 }
 
+// Reads file[offset, offset+size) into "destination", in chunks of
+// "chunk_size" bytes of which up to kMaxParallelReadsPerTensor are read at the
+// same time from closures scheduled on "env". Each chunk is checksummed by its
+// reader, and the crc32c of the whole range is stored into "crc32c".
+Status ReadInParallel(Env* env, RandomAccessFile* file, uint64 offset,
+                      size_t size, size_t chunk_size, char* destination,
+                      uint32* crc32c) {
+  const size_t num_chunks = (size + chunk_size - 1) / chunk_size;
+  const int num_readers =
+      std::min<size_t>(num_chunks, kMaxParallelReadsPerTensor);
+  std::atomic<size_t> next_chunk(0);
+  mutex mu;
+  Status status;
+  std::vector<uint32> chunk_crc32cs(num_chunks);
+  auto read_chunks = [&]() {
+    for (size_t i = next_chunk++; i < num_chunks; i = next_chunk++) {
+      const size_t chunk_offset = i * chunk_size;
+      const size_t n = std::min(chunk_size, size - chunk_offset);
+      char* chunk_destination = destination + chunk_offset;
+      StringPiece sp;
+      Status s = file->Read(offset + chunk_offset, n, &sp, chunk_destination);
+      if (!s.ok()) {
+        mutex_lock l(mu);
+        status.Update(s);
+        // Stops all readers.
+        next_chunk = num_chunks;
+        return;
+      }
+      if (sp.data() != chunk_destination) {
+        memmove(chunk_destination, sp.data(), n);
+      }
+      // Checksums the chunk while the other readers are still reading.
+      chunk_crc32cs[i] = crc32c::Value(chunk_destination, n);
+    }
+  };
+  BlockingCounter counter(num_readers - 1);
+  for (int i = 1; i < num_readers; ++i) {
+    env->SchedClosure([&read_chunks, &counter]() {
+      read_chunks();
+      counter.DecrementCount();
+    });
+  }
+  read_chunks();
+  counter.Wait();
+  TF_RETURN_IF_ERROR(status);
+  *crc32c = 0;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    const size_t n = std::min(chunk_size, size - i * chunk_size);
+    *crc32c = crc32c::Combine(*crc32c, chunk_crc32cs[i], n);
+  }
+  return Status::OK();
+}
+
 Status ParseEntryProto(StringPiece key, StringPiece value,
                        protobuf::MessageLite* out) {
   if (!out->ParseFromArray(value.data(), value.size())) {
@@ -377,8 +442,45 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// The filter policy of the metadata tables.  Ten bits per key rule out about
+// 99% of the keys that are not in a block without reading it.
+const table::FilterPolicy* BundleFilterPolicy() {
+  static const table::FilterPolicy* policy = table::NewBloomFilterPolicy(10);
+  return policy;
+}
+
+// Returns the index block cache shared by all the readers of the process, or
+// nullptr if TF_TABLE_SHARED_INDEX_CACHE_SIZE_IN_MB is not set.  Readers of
+// the same checkpoint, e.g. the restore ops of every variable, then read each
+// index block once.
+table::Cache* SharedIndexCache() {
+  static table::Cache* cache = [] {
+    int64 cache_size;
+    Status s = ReadInt64FromEnvVar("TF_TABLE_SHARED_INDEX_CACHE_SIZE_IN_MB", 0,
+                                   &cache_size);
+    if (!s.ok() || cache_size <= 0) return static_cast<table::Cache*>(nullptr);
+    return table::NewLRUCache(cache_size << 20);
+  }();
+  return cache;
+}
+
+// Returns the id of the blocks of the metadata file `filename` in the shared
+// index cache.  A file rewritten in place gets another id, as its size or
+// modification time changes.
+uint64 SharedIndexCacheId(Env* env, const string& filename,
+                          uint64 file_size) {
+  FileStatistics stat;
+  int64 mtime_nsec = 0;
+  if (env->Stat(filename, &stat).ok()) mtime_nsec = stat.mtime_nsec;
+  const uint64 id = Fingerprint64(
+      strings::StrCat(filename, ":", file_size, ":", mtime_nsec));
+  // Zero asks the table for a new id.
+  return id == 0 ? 1 : id;
+}
+
 table::Options TableBuilderOptions() {
   table::Options o;
+  o.filter_policy = BundleFilterPolicy();
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
   // To smoothen the transition, compressed writes are disabled for now
   // (version 1.2) with the intention that they will be enabled again at
@@ -403,8 +505,64 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
   return status;
 }
 
+// A tensor buffer in the memory mapping of a bundle data file, which it keeps
+// alive.
+class MemmappedTensorBuffer : public TensorBuffer {
+ public:
+  MemmappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                        const void* data, size_t size)
+      : TensorBuffer(const_cast<void*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("memmapped_bundle");
+  }
+  // The mapping is read-only, so the tensors are copied before any update.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+struct MemmappedBundles {
+  mutex mu;
+  // The number of registrations of each prefix.
+  std::unordered_map<string, int> counts TF_GUARDED_BY(mu);
+};
+
+MemmappedBundles* GetMemmappedBundles() {
+  static MemmappedBundles* bundles = new MemmappedBundles;
+  return bundles;
+}
+
 }  // namespace
 
+void RegisterMemmappedBundle(StringPiece prefix) {
+  MemmappedBundles* bundles = GetMemmappedBundles();
+  mutex_lock l(bundles->mu);
+  ++bundles->counts[string(prefix)];
+}
+
+void UnregisterMemmappedBundle(StringPiece prefix) {
+  MemmappedBundles* bundles = GetMemmappedBundles();
+  mutex_lock l(bundles->mu);
+  auto it = bundles->counts.find(string(prefix));
+  if (it != bundles->counts.end() && --it->second == 0) {
+    bundles->counts.erase(it);
+  }
+}
+
+bool IsMemmappedBundle(StringPiece prefix) {
+  MemmappedBundles* bundles = GetMemmappedBundles();
+  mutex_lock l(bundles->mu);
+  return bundles->counts.count(string(prefix)) > 0;
+}
+
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
       options_(options),
@@ -539,6 +697,7 @@ Status BundleWriter::Finish() {
     // platforms (e.g. Android).  The metadata file is small, so this is fine.
     table::Options options;
     options.compression = table::kNoCompression;
+    options.filter_policy = BundleFilterPolicy();
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
@@ -748,7 +907,8 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
       table_(nullptr),
       index_cache_(nullptr),
       iter_(nullptr),
-      need_to_swap_bytes_(false) {
+      need_to_swap_bytes_(false),
+      parallel_read_chunk_size_(kDefaultParallelReadChunkSizeInMB << 20) {
   const string filename = MetaFilename(prefix_);
   uint64 file_size;
   status_ = env_->GetFileSize(filename, &file_size);
@@ -761,12 +921,22 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   metadata_ = wrapper.release();
 
   table::Options o;
+  o.filter_policy = BundleFilterPolicy();
   int64 cache_size;
   Status s =
       ReadInt64FromEnvVar("TF_TABLE_INDEX_CACHE_SIZE_IN_MB", 0, &cache_size);
   if (s.ok() && cache_size > 0) {
     index_cache_ = table::NewLRUCache(cache_size << 20);
     o.block_cache = index_cache_;
+  } else if (SharedIndexCache() != nullptr) {
+    o.block_cache = SharedIndexCache();
+    o.block_cache_id = SharedIndexCacheId(env_, filename, file_size);
+  }
+  int64 chunk_size_in_mb;
+  s = ReadInt64FromEnvVar("TF_TENSOR_BUNDLE_READ_CHUNK_SIZE_IN_MB",
+                          kDefaultParallelReadChunkSizeInMB, &chunk_size_in_mb);
+  if (s.ok() && chunk_size_in_mb > 0) {
+    parallel_read_chunk_size_ = chunk_size_in_mb << 20;
   }
 
   status_ = table::Table::Open(o, metadata_, file_size, &table_);
@@ -823,6 +993,9 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
   TF_CHECK_OK(status_);
+  if (!table_->KeyMayMatch(key)) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
   Seek(key);
   if (!iter_->Valid() || iter_->key() != key) {
     return errors::NotFound("Key ", key, " not found in checkpoint");
@@ -887,20 +1060,27 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   if (DataTypeCanUseMemcpy(entry.dtype())) {
     char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
     size_t unused_bytes_read;
-    if (entry.size() > kBufferSize) {
+    if (entry.size() > 2 * parallel_read_chunk_size_) {
+      // Large tensors are read straight into their buffer, and checksummed,
+      // in parallel.
+      TF_RETURN_IF_ERROR(ReadInParallel(
+          env_, buffered_file->file(), entry.offset(), entry.size(),
+          parallel_read_chunk_size_, backing_buffer, &actual_crc32c));
+    } else if (entry.size() > kBufferSize) {
       StringPiece sp;
       TF_RETURN_IF_ERROR(buffered_file->file()->Read(
           entry.offset(), entry.size(), &sp, backing_buffer));
       if (sp.data() != backing_buffer) {
         memmove(backing_buffer, sp.data(), entry.size());
       }
+      actual_crc32c = crc32c::Value(backing_buffer, entry.size());
     } else {
       TF_RETURN_IF_ERROR(buffered_file->ReadNBytes(entry.size(), backing_buffer,
                                                    &unused_bytes_read));
+      actual_crc32c = crc32c::Value(backing_buffer, entry.size());
     }
     // Note that we compute the checksum *before* byte-swapping. The checksum
     // should be on the bytes in the order they appear in the file.
-    actual_crc32c = crc32c::Value(backing_buffer, entry.size());
     if (need_to_swap_bytes_) {
       TF_RETURN_IF_ERROR(ByteSwapTensor(ret));
     }
@@ -936,6 +1116,20 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::LookupDataLocation(StringPiece key, int32* shard_id,
+                                        int64* offset) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (entry.slices().empty()) {
+    *shard_id = entry.shard_id();
+    *offset = entry.offset();
+  } else {
+    *shard_id = -1;
+    *offset = -1;
+  }
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -950,6 +1144,59 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMemmapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape shape(entry.shape());
+
+  // The buffers of the tensors must be aligned like those of the allocators.
+  if (entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && shape.num_elements() > 0 &&
+      entry.offset() % Allocator::kAllocatorAlignment == 0) {
+    auto it = mapped_data_.find(entry.shard_id());
+    if (it == mapped_data_.end()) {
+      std::unique_ptr<ReadOnlyMemoryRegion> region;
+      const Status status = env_->NewReadOnlyMemoryRegionFromFile(
+          DataFilename(prefix_, entry.shard_id(), num_shards_), &region);
+      if (!status.ok()) {
+        VLOG(1) << "Reading " << prefix_ << " instead of mapping it: "
+                << status;
+        region = nullptr;
+      }
+      it = mapped_data_.emplace(entry.shard_id(), std::move(region)).first;
+    }
+    const std::shared_ptr<ReadOnlyMemoryRegion>& region = it->second;
+    if (region != nullptr) {
+      const uint64 expected_size =
+          shape.num_elements() * DataTypeSize(entry.dtype());
+      if (entry.size() != expected_size) {
+        return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                                "; stored size ", entry.size(),
+                                "; expected size ", expected_size);
+      }
+      if (entry.offset() + entry.size() > region->length()) {
+        return errors::DataLoss(
+            "Truncated bundle data file for key ", key, ": ", region->length(),
+            " bytes, entry ends at ", entry.offset() + entry.size());
+      }
+      MemmappedTensorBuffer* buffer = new MemmappedTensorBuffer(
+          region, static_cast<const char*>(region->data()) + entry.offset(),
+          entry.size());
+      *val = Tensor(entry.dtype(), shape, buffer);
+      buffer->Unref();
+      return Status::OK();
+    }
+  }
+
+  *val = Tensor(entry.dtype(), shape);
+  if (entry.slices().empty()) {
+    return GetValue(entry, val);
+  }
+  return GetSliceValue(key, entry, /* a full slice */ TensorSlice(shape.dims()),
+                       val);
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1104,6 +1351,7 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
 }
 
 bool BundleReader::Contains(StringPiece key) {
+  if (!table_->KeyMayMatch(key)) return false;
   Seek(key);
   return Valid() && (this->key() == key);
 }
@@ -1117,6 +1365,39 @@ Status BundleReader::LookupDtypeAndShape(StringPiece key, DataType* dtype,
   return Status::OK();
 }
 
+Status BundleReader::LookupDtypesAndShapes(
+    const std::vector<StringPiece>& keys, std::vector<DataType>* dtypes,
+    std::vector<TensorShape>* shapes) {
+  TF_CHECK_OK(status_);
+  dtypes->assign(keys.size(), DT_INVALID);
+  shapes->assign(keys.size(), TensorShape());
+  std::vector<bool> found(keys.size(), false);
+  Status parse_status;
+  TF_RETURN_IF_ERROR(table_->MultiGet(
+      keys, [&](size_t i, const StringPiece& value) {
+        if (!parse_status.ok()) return;
+        BundleEntryProto entry;
+        parse_status = ParseEntryProto(keys[i], value, &entry);
+        if (!parse_status.ok()) return;
+        if (!TensorShape::IsValid(entry.shape())) {
+          parse_status =
+              errors::DataLoss("Invalid tensor shape: ", keys[i], " ",
+                               entry.shape().ShortDebugString());
+          return;
+        }
+        (*dtypes)[i] = entry.dtype();
+        (*shapes)[i] = TensorShape(entry.shape());
+        found[i] = true;
+      }));
+  TF_RETURN_IF_ERROR(parse_status);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!found[i]) {
+      return errors::NotFound("Key ", keys[i], " not found in checkpoint");
+    }
+  }
+  return Status::OK();
+}
+
 Status BundleReader::LookupTensorShape(StringPiece key, TensorShape* shape) {
   DataType ignored;
   return LookupDtypeAndShape(key, &ignored, shape);
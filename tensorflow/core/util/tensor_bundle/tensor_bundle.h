@@ -62,8 +62,10 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -199,12 +201,32 @@ class BundleReader {
   Status LookupDtypeAndShape(StringPiece key, DataType* dtype,
                              TensorShape* shape) TF_MUST_USE_RESULT;
 
+  // Looks up the dtypes and the shapes of the tensors keyed by "keys" at
+  // once, which reads every index block holding some of them only once.
+  // Returns NotFound if some key is not in the bundle.
+  // REQUIRES: status().ok()
+  Status LookupDtypesAndShapes(const std::vector<StringPiece>& keys,
+                               std::vector<DataType>* dtypes,
+                               std::vector<TensorShape>* shapes)
+      TF_MUST_USE_RESULT;
+
   // Looks up the shape of the tensor keyed by "key".
   // Clears "shape" if not found.
   // REQUIRES: status().ok()
   Status LookupTensorShape(StringPiece key,
                            TensorShape* shape) TF_MUST_USE_RESULT;
 
+  // Looks up the data file shard and the offset in that shard at which the
+  // contents of the tensor keyed by "key" are stored.  Sets both to -1 if
+  // "key" refers to a partitioned tensor, whose slices are stored separately.
+  // REQUIRES: status().ok()
+  Status LookupDataLocation(StringPiece key, int32* shard_id,
+                            int64* offset) TF_MUST_USE_RESULT;
+
+  // Returns the number of data file shards in the bundle.
+  // REQUIRES: status().ok()
+  int num_shards() const { return num_shards_; }
+
   // Looks up the tensor keyed by "key".  If "key" refers to a partitioned
   // tensor, attempts to look up the full contents using all stored slices.
   //
@@ -219,6 +241,20 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensor keyed by "key" like Lookup(), but if possible sets
+  // "val" to a read-only tensor backed by a memory mapping of its data file
+  // instead of reading it into a new buffer. The pages of the tensor are then
+  // only read on first access, and may be shared by the processes serving the
+  // same bundle. Otherwise, e.g. for strings, slices, unaligned entries or
+  // file systems that can't map files, allocates "val" and calls Lookup().
+  //
+  // The stored checksum of a mapped tensor is not validated, which would read
+  // all its pages. The mapping outlives the reader as long as "val" does. The
+  // buffer of "val" doesn't own its memory, so resource variables assigned
+  // from it copy it before they update it.
+  // REQUIRES: status().ok()
+  Status LookupMemmapped(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -293,6 +329,11 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The memory mappings of the data files, by shard id, shared with the
+  // tensors returned by LookupMemmapped(). Null for the files that can't be
+  // mapped.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -306,11 +347,23 @@ class BundleReader {
   // differs from that of the current system's processor architecture.
   bool need_to_swap_bytes_;
 
+  // Tensors larger than twice this size are read in chunks of this size, in
+  // parallel.  Set by the TF_TENSOR_BUNDLE_READ_CHUNK_SIZE_IN_MB environment
+  // variable.
+  size_t parallel_read_chunk_size_;
+
   friend class TensorBundleAlignmentTest;  // For testing data alignment.
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
 };
 
+// Marks the bundle at "prefix" as read-only until a matching call to
+// UnregisterMemmappedBundle(), so that the restore ops back the tensors they
+// restore from it with BundleReader::LookupMemmapped(). Calls nest.
+void RegisterMemmappedBundle(StringPiece prefix);
+void UnregisterMemmappedBundle(StringPiece prefix);
+bool IsMemmappedBundle(StringPiece prefix);
+
 // A buffering wrapper for a WritableFile.  Useful if the caller wishes to issue
 // small writes to a file (e.g. writing out a list of small varints).
 // External synchronization must be used in the presence of concurrent callers.
@@ -989,6 +989,136 @@ TEST(TensorBundleTest, TruncatedTensorContents) {
   EXPECT_TRUE(errors::IsOutOfRange(reader.Lookup("key", &val)));
 }
 
+TEST(TensorBundleTest, ParallelReadOfLargeTensor) {
+  // Reads tensors larger than 2MB in parallel chunks of 1MB.
+  setenv("TF_TENSOR_BUNDLE_READ_CHUNK_SIZE_IN_MB", "1", 1);
+  Env* env = Env::Default();
+  Tensor expected(DT_FLOAT, TensorShape({3 << 20, 1}));
+  for (int64 i = 0; i < expected.NumElements(); ++i) {
+    expected.flat<float>()(i) = i;
+  }
+  {
+    BundleWriter writer(env, Prefix("large"));
+    TF_EXPECT_OK(writer.Add("small", Constant_2x3<float>(1.0)));
+    TF_EXPECT_OK(writer.Add("large", expected));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleReader reader(env, Prefix("large"));
+    TF_ASSERT_OK(reader.status());
+    Tensor val(DT_FLOAT, expected.shape());
+    TF_ASSERT_OK(reader.Lookup("large", &val));
+    test::ExpectTensorEqual<float>(expected, val);
+  }
+
+  // Truncates the data file, so that reading the last chunk hits EOF.
+  const string datafile = DataFilename(Prefix("large"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  TF_ASSERT_OK(WriteStringToFile(env, datafile,
+                                 StringPiece(data.data(), data.size() - 1)));
+  {
+    BundleReader reader(env, Prefix("large"));
+    TF_ASSERT_OK(reader.status());
+    Tensor val(DT_FLOAT, expected.shape());
+    EXPECT_TRUE(errors::IsOutOfRange(reader.Lookup("large", &val)));
+  }
+  unsetenv("TF_TENSOR_BUNDLE_READ_CHUNK_SIZE_IN_MB");
+}
+
+TEST(TensorBundleTest, LookupMemmapped) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(env, Prefix("aligned"), opts);
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(1.0)));
+    TF_EXPECT_OK(writer.Add("strings", Constant_2x3<tstring>("hello")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor floats, strings;
+  {
+    BundleReader reader(env, Prefix("aligned"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.LookupMemmapped("floats", &floats));
+    TF_ASSERT_OK(reader.LookupMemmapped("strings", &strings));
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMemmapped("none", &floats)));
+  }
+  // The mapping outlives the reader, and doesn't own its memory, which
+  // forbids updates in place.
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(1.0));
+  EXPECT_FALSE(floats.RefCountIsOne());
+  // Strings are read.
+  test::ExpectTensorEqual<tstring>(strings, Constant_2x3<tstring>("hello"));
+  EXPECT_TRUE(strings.RefCountIsOne());
+
+  {
+    BundleWriter writer(env, Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant<float>(1.0, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<float>(2.0, TensorShape({3}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleReader reader(env, Prefix("unaligned"));
+    TF_ASSERT_OK(reader.status());
+    Tensor a, b;
+    TF_ASSERT_OK(reader.LookupMemmapped("a", &a));
+    TF_ASSERT_OK(reader.LookupMemmapped("b", &b));
+    test::ExpectTensorEqual<float>(a, Constant<float>(1.0, TensorShape({3})));
+    test::ExpectTensorEqual<float>(b, Constant<float>(2.0, TensorShape({3})));
+    EXPECT_FALSE(a.RefCountIsOne());
+    // Not aligned, so read.
+    EXPECT_TRUE(b.RefCountIsOne());
+  }
+}
+
+TEST(TensorBundleTest, LookupDtypesAndShapes) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("batched"));
+    for (int i = 0; i < 1000; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("var_", i),
+                              Constant<float>(i, TensorShape({i % 5 + 1}))));
+    }
+    TF_EXPECT_OK(writer.Add("ints", Constant_2x3<int32>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(env, Prefix("batched"));
+  TF_ASSERT_OK(reader.status());
+
+  const std::vector<string> names = {"var_999", "ints", "var_0", "var_512"};
+  std::vector<StringPiece> keys(names.begin(), names.end());
+  std::vector<DataType> dtypes;
+  std::vector<TensorShape> shapes;
+  TF_ASSERT_OK(reader.LookupDtypesAndShapes(keys, &dtypes, &shapes));
+  EXPECT_EQ(dtypes, std::vector<DataType>({DT_FLOAT, DT_INT32, DT_FLOAT,
+                                           DT_FLOAT}));
+  EXPECT_EQ(shapes[0], TensorShape({5}));
+  EXPECT_EQ(shapes[1], TensorShape({2, 3}));
+  EXPECT_EQ(shapes[2], TensorShape({1}));
+  EXPECT_EQ(shapes[3], TensorShape({3}));
+
+  // Missing keys are reported, whether or not the filters rule them out.
+  EXPECT_TRUE(reader.Contains("var_7"));
+  EXPECT_FALSE(reader.Contains("var_1000"));
+  keys.push_back("var_1000");
+  Status s = reader.LookupDtypesAndShapes(keys, &dtypes, &shapes);
+  EXPECT_TRUE(errors::IsNotFound(s));
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "var_1000"));
+}
+
+TEST(TensorBundleTest, RegisterMemmappedBundle) {
+  EXPECT_FALSE(IsMemmappedBundle(Prefix("mapped")));
+  RegisterMemmappedBundle(Prefix("mapped"));
+  RegisterMemmappedBundle(Prefix("mapped"));
+  EXPECT_TRUE(IsMemmappedBundle(Prefix("mapped")));
+  EXPECT_FALSE(IsMemmappedBundle(Prefix("other")));
+  UnregisterMemmappedBundle(Prefix("mapped"));
+  EXPECT_TRUE(IsMemmappedBundle(Prefix("mapped")));
+  UnregisterMemmappedBundle(Prefix("mapped"));
+  EXPECT_FALSE(IsMemmappedBundle(Prefix("mapped")));
+}
+
 TEST(TensorBundleTest, HeaderEntry) {
   {
     BundleWriter writer(Env::Default(), Prefix("b"));
@@ -0,0 +1,163 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of bytes compressed to choose the codec of larger tensors.
+constexpr size_t kSampleBytes = 64 << 10;
+
+// Writes byte `b` of element `i` of `in` to out[b * n + i].
+void ShuffleBytes(const char* in, size_t size, int element_size, char* out) {
+  const size_t n = size / element_size;
+  for (int b = 0; b < element_size; ++b) {
+    char* plane = out + b * n;
+    for (size_t i = 0; i < n; ++i) {
+      plane[i] = in[i * element_size + b];
+    }
+  }
+  // Bytes past the last whole element are kept in place.
+  memcpy(out + n * element_size, in + n * element_size,
+         size - n * element_size);
+}
+
+// The inverse of ShuffleBytes.
+void UnshuffleBytes(const char* in, size_t size, int element_size, char* out) {
+  const size_t n = size / element_size;
+  for (int b = 0; b < element_size; ++b) {
+    const char* plane = in + b * n;
+    for (size_t i = 0; i < n; ++i) {
+      out[i * element_size + b] = plane[i];
+    }
+  }
+  memcpy(out + n * element_size, in + n * element_size,
+         size - n * element_size);
+}
+
+// Compresses `data` with `codec` into `*out`. Returns false if snappy is not
+// available.
+bool Compress(TensorCodec codec, StringPiece data, int element_size,
+              std::string* out) {
+  if (codec == TENSOR_CODEC_SNAPPY) {
+    return port::Snappy_Compress(data.data(), data.size(), out);
+  }
+  std::unique_ptr<char[]> shuffled(new char[data.size()]);
+  ShuffleBytes(data.data(), data.size(), element_size, shuffled.get());
+  return port::Snappy_Compress(shuffled.get(), data.size(), out);
+}
+
+// Returns true if `compressed_size` saves at least 1/8 of `size`.
+bool WorthCompressing(size_t compressed_size, size_t size) {
+  return compressed_size <= size - size / 8;
+}
+
+}  // namespace
+
+TensorCodec CompressTensorData(StringPiece data, int element_size,
+                               std::string* out) {
+  out->clear();
+  if (data.empty()) return TENSOR_CODEC_NONE;
+  const bool sampled = data.size() > kSampleBytes;
+  size_t sample_size = data.size();
+  if (sampled) {
+    sample_size = kSampleBytes - kSampleBytes % std::max(element_size, 1);
+  }
+  const StringPiece sample(data.data(), sample_size);
+
+  TensorCodec best = TENSOR_CODEC_NONE;
+  std::string best_compressed;
+  size_t best_size = sample_size;
+  std::string compressed;
+  for (TensorCodec codec : {TENSOR_CODEC_SNAPPY, TENSOR_CODEC_SHUFFLE_SNAPPY}) {
+    if (codec == TENSOR_CODEC_SHUFFLE_SNAPPY && element_size <= 1) break;
+    if (!Compress(codec, sample, element_size, &compressed)) {
+      return TENSOR_CODEC_NONE;
+    }
+    if (compressed.size() < best_size) {
+      best = codec;
+      best_size = compressed.size();
+      best_compressed.swap(compressed);
+    }
+  }
+  if (best == TENSOR_CODEC_NONE ||
+      !WorthCompressing(best_size, sample_size)) {
+    return TENSOR_CODEC_NONE;
+  }
+  if (!sampled) {
+    out->swap(best_compressed);
+    return best;
+  }
+  if (!Compress(best, data, element_size, out) ||
+      !WorthCompressing(out->size(), data.size())) {
+    out->clear();
+    return TENSOR_CODEC_NONE;
+  }
+  VLOG(3) << "Compressed " << data.size() << " tensor bytes to "
+          << out->size() << " bytes with codec " << best;
+  return best;
+}
+
+Status UncompressTensorData(TensorCodec codec, StringPiece compressed,
+                            int element_size, char* out, size_t size) {
+  if (codec == TENSOR_CODEC_NONE) {
+    if (compressed.size() != size) {
+      return errors::Internal("Expected ", size, " uncompressed bytes, got ",
+                              compressed.size());
+    }
+    memcpy(out, compressed.data(), size);
+    return Status::OK();
+  }
+  if (codec != TENSOR_CODEC_SNAPPY && codec != TENSOR_CODEC_SHUFFLE_SNAPPY) {
+    return errors::InvalidArgument("Unknown tensor codec ", codec);
+  }
+  size_t uncompressed_size;
+  if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
+                                          &uncompressed_size)) {
+    return errors::Internal(
+        "Could not get snappy uncompressed length. Compressed data size: ",
+        compressed.size());
+  }
+  if (uncompressed_size != size) {
+    return errors::Internal("Uncompressed size mismatch. Snappy expects ",
+                            uncompressed_size, " whereas the tensor has ",
+                            size);
+  }
+  if (codec == TENSOR_CODEC_SNAPPY) {
+    if (!port::Snappy_Uncompress(compressed.data(), compressed.size(), out)) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
+    return Status::OK();
+  }
+  std::unique_ptr<char[]> shuffled(new char[size]);
+  if (!port::Snappy_Uncompress(compressed.data(), compressed.size(),
+                               shuffled.get())) {
+    return errors::Internal("Failed to perform snappy decompression.");
+  }
+  UnshuffleBytes(shuffled.get(), size, element_size, out);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,59 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_COMPRESSION_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_COMPRESSION_H_
+
+#include <string>
+
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+
+namespace tensorflow {
+
+// Codecs for the bytes of a tensor sent over the wire. The values are stored
+// in protos, so they must not change.
+enum TensorCodec {
+  // The bytes are not compressed.
+  TENSOR_CODEC_NONE = 0,
+  // The bytes are compressed with snappy.
+  TENSOR_CODEC_SNAPPY = 1,
+  // The bytes of the elements are regrouped by position in the element, all
+  // the first bytes, then all the second bytes, and so on, and the result is
+  // compressed with snappy. The exponent and high mantissa bytes of floating
+  // point values are much more alike than the values themselves, so this
+  // compresses them far better than snappy alone.
+  TENSOR_CODEC_SHUFFLE_SNAPPY = 2,
+};
+
+// Compresses the `data` of a tensor whose elements are `element_size` bytes
+// long into `*out`, and returns the codec used.
+//
+// The codec is chosen by compressing a sample of `data` with each candidate:
+// byte shuffling is only tried for multi-byte elements. If no codec saves at
+// least 1/8 of the bytes, which is the case of dense, high-entropy floats,
+// returns TENSOR_CODEC_NONE and leaves `*out` empty, so that the caller can
+// send `data` as is.
+TensorCodec CompressTensorData(StringPiece data, int element_size,
+                               std::string* out);
+
+// Uncompresses `compressed`, produced by CompressTensorData with `codec`,
+// into the `size` bytes at `out`.
+Status UncompressTensorData(TensorCodec codec, StringPiece compressed,
+                            int element_size, char* out, size_t size);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_COMPRESSION_H_
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_compression.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Compresses `values` and checks that they round trip. Returns the codec.
+template <typename T>
+TensorCodec RoundTrip(const std::vector<T>& values) {
+  StringPiece data(reinterpret_cast<const char*>(values.data()),
+                   values.size() * sizeof(T));
+  std::string compressed;
+  TensorCodec codec = CompressTensorData(data, sizeof(T), &compressed);
+  if (codec == TENSOR_CODEC_NONE) {
+    EXPECT_TRUE(compressed.empty());
+    return codec;
+  }
+  EXPECT_LT(compressed.size(), data.size());
+  std::vector<T> uncompressed(values.size());
+  TF_EXPECT_OK(UncompressTensorData(
+      codec, compressed, sizeof(T),
+      reinterpret_cast<char*>(uncompressed.data()), data.size()));
+  EXPECT_EQ(uncompressed, values);
+  return codec;
+}
+
+TEST(TensorCompressionTest, Empty) {
+  EXPECT_EQ(RoundTrip(std::vector<float>()), TENSOR_CODEC_NONE);
+}
+
+TEST(TensorCompressionTest, SparseIntegers) {
+  for (int size : {100, 100000}) {
+    std::vector<int64> values(size, 0);
+    for (int i = 0; i < size; i += 17) values[i] = i;
+    EXPECT_NE(RoundTrip(values), TENSOR_CODEC_NONE);
+  }
+}
+
+TEST(TensorCompressionTest, SmoothFloatsAreShuffled) {
+  // Nearby floats share their sign, exponent and high mantissa bytes.
+  std::vector<float> values(100000);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = 1.0f + i * 1e-6f;
+  EXPECT_EQ(RoundTrip(values), TENSOR_CODEC_SHUFFLE_SNAPPY);
+}
+
+TEST(TensorCompressionTest, RandomBytesAreNotCompressed) {
+  random::PhiloxRandom philox(7, 7);
+  random::SimplePhilox rnd(&philox);
+  std::vector<uint32> values(100000);
+  for (uint32& v : values) v = rnd.Rand32();
+  EXPECT_EQ(RoundTrip(values), TENSOR_CODEC_NONE);
+}
+
+TEST(TensorCompressionTest, SizeMismatch) {
+  std::vector<int32> values(1000, 3);
+  std::string compressed;
+  TensorCodec codec = CompressTensorData(
+      StringPiece(reinterpret_cast<const char*>(values.data()), 4000), 4,
+      &compressed);
+  ASSERT_NE(codec, TENSOR_CODEC_NONE);
+  std::vector<char> out(3996);
+  EXPECT_FALSE(
+      UncompressTensorData(codec, compressed, 4, out.data(), out.size()).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -266,6 +266,41 @@ public final class Tensor<T> implements AutoCloseable {
     return t;
   }
 
+  /**
+   * Create a Tensor of any type backed by the memory of the given direct buffer, without copying
+   * it.
+   *
+   * <p>The tensor aliases the bytes of {@code data} between its position and its limit, encoded as
+   * per the specification of the TensorFlow <a
+   * href="https://www.tensorflow.org/code/tensorflow/c/c_api.h">C API</a>, so they must not be
+   * modified while the tensor is in use, including by a {@link Session} it was fed to. The buffer
+   * is kept reachable until the native tensor is deallocated, which can be after {@link #close()}.
+   * The data is copied if it is not aligned as TensorFlow requires.
+   *
+   * @param <T> the tensor element type
+   * @param type the tensor element type, represented as a class object.
+   * @param shape the tensor shape.
+   * @param data a direct buffer containing the tensor data.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, the tensor datatype is
+   *     STRING, or the shape is not compatible with the buffer
+   */
+  public static <T> Tensor<T> wrap(Class<T> type, long[] shape, ByteBuffer data) {
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("only a direct buffer can back a Tensor");
+    }
+    DataType dtype = DataType.fromClass(type);
+    int elemBytes = elemByteSize(dtype);
+    if (data.remaining() != numElements(shape) * elemBytes) {
+      throw incompatibleBuffer(data.remaining() / elemBytes, shape);
+    }
+    Tensor<T> t = new Tensor<T>(dtype);
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    long nativeHandle =
+        allocateWrapping(t.dtype.c(), t.shapeCopy, data, data.position(), data.remaining());
+    t.nativeRef = new NativeReference(nativeHandle);
+    return t;
+  }
+
   /**
    * Returns this Tensor object with the type {@code Tensor<U>}. This method is useful when given a
    * value of type {@code Tensor<?>}.
@@ -806,6 +841,9 @@ public final class Tensor<T> implements AutoCloseable {
 
   private static native long allocate(int dtype, long[] shape, long byteSize);
 
+  private static native long allocateWrapping(
+      int dtype, long[] shape, ByteBuffer data, long offset, long byteSize);
+
   private static native long allocateScalarBytes(byte[] value);
 
   private static native long allocateNonScalarBytes(long[] shape, Object[] value);
@@ -281,6 +281,34 @@ void readNDStringArray(JNIEnv* env, StringTensorReader* reader, int dims_left,
     if (TF_GetCode(status) != TF_OK) return;
   }
 }
+
+// A direct java.nio.ByteBuffer backing a TF_Tensor, referenced until the
+// tensor is deallocated.
+struct WrappedBuffer {
+  JavaVM* vm;
+  jobject buffer;  // Global reference.
+};
+
+void releaseWrappedBuffer(void* data, size_t len, void* arg) {
+  WrappedBuffer* wrapped = static_cast<WrappedBuffer*>(arg);
+  // The tensor can be deallocated by a thread of the TensorFlow runtime, which
+  // is then attached to the JVM for the time of the release.
+  JNIEnv* env = nullptr;
+  bool attached = false;
+  if (wrapped->vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) ==
+      JNI_EDETACHED) {
+#ifdef __ANDROID__
+    attached = wrapped->vm->AttachCurrentThread(&env, nullptr) == JNI_OK;
+#else
+    attached = wrapped->vm->AttachCurrentThread(reinterpret_cast<void**>(&env),
+                                                nullptr) == JNI_OK;
+#endif
+    if (!attached) env = nullptr;
+  }
+  if (env != nullptr) env->DeleteGlobalRef(wrapped->buffer);
+  if (attached) wrapped->vm->DetachCurrentThread();
+  delete wrapped;
+}
 }  // namespace
 
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
@@ -322,6 +350,43 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
   return reinterpret_cast<jlong>(t);
 }
 
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateWrapping(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject data,
+    jlong offset, jlong sizeInBytes) {
+  char* address = static_cast<char*>(env->GetDirectBufferAddress(data));
+  if (address == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "only a direct buffer can back a Tensor");
+    return 0;
+  }
+  const int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  std::unique_ptr<int64_t[]> dims(new int64_t[num_dims]);
+  if (num_dims > 0) {
+    jlong* shape_elems = env->GetLongArrayElements(shape, nullptr);
+    for (int i = 0; i < num_dims; ++i) {
+      dims[i] = static_cast<int64_t>(shape_elems[i]);
+    }
+    env->ReleaseLongArrayElements(shape, shape_elems, JNI_ABORT);
+  }
+  WrappedBuffer* wrapped = new WrappedBuffer;
+  if (env->GetJavaVM(&wrapped->vm) != JNI_OK) {
+    delete wrapped;
+    throwException(env, kIllegalStateException, "unable to get the Java VM");
+    return 0;
+  }
+  wrapped->buffer = env->NewGlobalRef(data);
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.get(),
+                              num_dims, address + offset,
+                              static_cast<size_t>(sizeInBytes),
+                              releaseWrappedBuffer, wrapped);
+  if (t == nullptr) {
+    throwException(env, kNullPointerException,
+                   "unable to allocate memory for the Tensor");
+    return 0;
+  }
+  return reinterpret_cast<jlong>(t);
+}
+
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateScalarBytes(
     JNIEnv* env, jclass clazz, jbyteArray value) {
   // TF_STRING tensors are encoded with a table of 8-byte offsets followed by
@@ -92,6 +92,32 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void wrapDirectBuffer() {
+    double[] doubles = {1d, 2d, 3d, 4d};
+    ByteBuffer buf = ByteBuffer.allocateDirect(8 * (doubles.length + 1));
+    buf.order(ByteOrder.nativeOrder()).asDoubleBuffer().put(0d).put(doubles);
+    buf.position(8);
+    try (Tensor<Double> t = Tensor.wrap(Double.class, new long[] {2, 2}, buf)) {
+      assertArrayEquals(new long[] {2, 2}, t.shape());
+      double[][] actual = t.copyTo(new double[2][2]);
+      assertArrayEquals(new double[] {1d, 2d}, actual[0], EPSILON);
+      assertArrayEquals(new double[] {3d, 4d}, actual[1], EPSILON);
+    }
+
+    // Only direct buffers of a compatible size are accepted.
+    try (Tensor<Double> t = Tensor.wrap(Double.class, new long[] {4}, ByteBuffer.allocate(32))) {
+      fail("should have failed on a heap buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+    try (Tensor<Double> t = Tensor.wrap(Double.class, new long[] {2}, buf)) {
+      fail("should have failed on incompatible buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+  }
+
   @Test
   public void createFromBufferWithNonNativeByteOrder() {
     double[] doubles = {1d, 2d, 3d, 4d};
@@ -53,6 +53,7 @@ std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
 }
 
 TfLiteStatus ArenaPlanner::ResetAllocations() {
+  keep_layout_ = false;
   TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
   TF_LITE_ENSURE_STATUS(persistent_arena_.ClearPlan());
   allocs_.clear();
@@ -60,6 +61,13 @@ TfLiteStatus ArenaPlanner::ResetAllocations() {
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::ResetAllocationsKeepingLayout() {
+  // The allocations stay in the arenas, so that CalculateAllocations() only
+  // moves the tensors which outgrew them.
+  keep_layout_ = true;
+  return kTfLiteOk;
+}
+
 TfLiteStatus ArenaPlanner::ResetAllocationsAfter(int node) {
   for (int i = 0; i < static_cast<int>(allocs_.size()); ++i) {
     if (allocs_[i].first_node > node && allocs_[i].size > 0) {
@@ -300,11 +308,144 @@ std::vector<int32_t> ArenaPlanner::CreateTensorAllocationVector(int first_node,
   return tensor_order;
 }
 
+std::vector<int32_t> ArenaPlanner::CreateTensorAllocationVectorByBreadth(
+    const std::vector<int32_t>& tensor_order) {
+  const int32_t num_nodes =
+      static_cast<int32_t>(graph_info_->num_execution_nodes());
+  // As in CreateTensorAllocationVector(), the tensors live during the whole
+  // inference go first, and only the others are reordered.
+  std::vector<int32_t> whole_lifetime_tensors;
+  std::vector<int32_t> arena_tensors;
+  for (int32_t tensor_index : tensor_order) {
+    if (graph_info_->tensor(tensor_index)->allocation_type != kTfLiteArenaRw) {
+      continue;
+    }
+    if (alloc_node_[tensor_index] == 0 &&
+        dealloc_node_[tensor_index] == kNodeNotAssigned) {
+      whole_lifetime_tensors.push_back(tensor_index);
+    } else {
+      arena_tensors.push_back(tensor_index);
+    }
+  }
+  if (num_nodes == 0) {
+    whole_lifetime_tensors.insert(whole_lifetime_tensors.end(),
+                                  arena_tensors.begin(), arena_tensors.end());
+    return whole_lifetime_tensors;
+  }
+
+  // The nodes over which each tensor is live, clamped to the graph.
+  auto first_live_node = [&](int32_t tensor_index) {
+    return std::min(StepBegin(alloc_node_[tensor_index]), num_nodes - 1);
+  };
+  auto last_live_node = [&](int32_t tensor_index) {
+    return std::min(StepEnd(dealloc_node_[tensor_index]), num_nodes - 1);
+  };
+
+  // The breadth of a node is the bytes of the tensors live during it.
+  std::vector<size_t> breadth(num_nodes + 1, 0);
+  for (int32_t tensor_index : arena_tensors) {
+    const size_t bytes = graph_info_->tensor(tensor_index)->bytes;
+    breadth[first_live_node(tensor_index)] += bytes;
+    breadth[last_live_node(tensor_index) + 1] -= bytes;
+  }
+  for (int32_t node = 1; node < num_nodes; ++node) {
+    breadth[node] += breadth[node - 1];
+  }
+
+  // A tensor is visited with the broadest node it is live in, so tensors are
+  // ordered by the breadth of that node first.
+  std::vector<int32_t> broadest_node(graph_info_->num_tensors(), 0);
+  for (int32_t tensor_index : arena_tensors) {
+    int32_t& broadest = broadest_node[tensor_index];
+    broadest = first_live_node(tensor_index);
+    for (int32_t node = broadest + 1; node <= last_live_node(tensor_index);
+         ++node) {
+      if (breadth[node] > breadth[broadest]) broadest = node;
+    }
+  }
+  std::sort(arena_tensors.begin(), arena_tensors.end(),
+            [&](int32_t idx1, int32_t idx2) {
+              const int32_t node1 = broadest_node[idx1];
+              const int32_t node2 = broadest_node[idx2];
+              if (breadth[node1] != breadth[node2]) {
+                return breadth[node1] > breadth[node2];
+              }
+              if (node1 != node2) return node1 < node2;
+              const size_t size1 = graph_info_->tensor(idx1)->bytes;
+              const size_t size2 = graph_info_->tensor(idx2)->bytes;
+              if (size1 != size2) return size1 > size2;
+              return idx1 < idx2;
+            });
+  whole_lifetime_tensors.insert(whole_lifetime_tensors.end(),
+                                arena_tensors.begin(), arena_tensors.end());
+  return whole_lifetime_tensors;
+}
+
+int32_t ArenaPlanner::StepBegin(int32_t node) const {
+  return node < static_cast<int32_t>(graph_info_->num_execution_nodes())
+             ? graph_info_->step_begin(node)
+             : node;
+}
+
+int32_t ArenaPlanner::StepEnd(int32_t node) const {
+  return node < static_cast<int32_t>(graph_info_->num_execution_nodes())
+             ? graph_info_->step_end(node)
+             : node;
+}
+
+TfLiteStatus ArenaPlanner::AllocateArenaTensors(
+    const std::vector<int32_t>& tensor_order) {
+  auto offline_offset = [this](int32_t tensor_index) -> int32_t {
+    return tensor_index < static_cast<int32_t>(offline_planned_offsets_.size())
+               ? offline_planned_offsets_[tensor_index]
+               : -1;
+  };
+  // The offline planned tensors go first, so that the others are packed
+  // around them.
+  std::vector<int32_t> ordered_tensors(tensor_order);
+  std::stable_partition(
+      ordered_tensors.begin(), ordered_tensors.end(),
+      [&](int32_t tensor_index) { return offline_offset(tensor_index) >= 0; });
+  for (int32_t tensor_index : ordered_tensors) {
+    TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    if (tensor.allocation_type != kTfLiteArenaRw) continue;
+    const int32_t first_node = StepBegin(alloc_node_[tensor_index]);
+    const int32_t last_node = StepEnd(dealloc_node_[tensor_index]);
+    if (offline_offset(tensor_index) >= 0 &&
+        arena_.AllocateAt(tensor_alignment_, offline_offset(tensor_index),
+                          tensor.bytes, tensor_index, first_node, last_node,
+                          &allocs_[tensor_index])) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(arena_.Allocate(context_, tensor_alignment_,
+                                          tensor.bytes, tensor_index,
+                                          first_node, last_node,
+                                          &allocs_[tensor_index]));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   // Indices of tensors in order their allocation offsets will be calculated.
-  const std::vector<int32_t> tensor_order =
+  std::vector<int32_t> tensor_order =
       CreateTensorAllocationVector(first_node, last_node);
 
+  if (keep_layout_) {
+    // Tensors which still fit in their allocations, over the same lifetime,
+    // keep them.
+    auto keeps_allocation = [&](int32_t tensor_index) {
+      const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+      const ArenaAllocWithUsageInterval& alloc = allocs_[tensor_index];
+      return tensor.allocation_type == kTfLiteArenaRw && alloc.size != 0 &&
+             alloc.size >= tensor.bytes &&
+             alloc.first_node == StepBegin(alloc_node_[tensor_index]) &&
+             alloc.last_node == StepEnd(dealloc_node_[tensor_index]);
+    };
+    tensor_order.erase(std::remove_if(tensor_order.begin(), tensor_order.end(),
+                                      keeps_allocation),
+                       tensor_order.end());
+  }
+
   // Deallocate if the tensor was already allocated.
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
@@ -312,18 +453,35 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
         allocs_[tensor_index].size != 0) {
       TF_LITE_ENSURE_STATUS(arena_.Deallocate(context_, allocs_[tensor_index]));
     }
+    // Persistent tensors only keep their allocations if they fit in them.
+    if (tensor.allocation_type == kTfLiteArenaRwPersistent &&
+        allocs_[tensor_index].size != 0 &&
+        allocs_[tensor_index].size < tensor.bytes) {
+      TF_LITE_ENSURE_STATUS(
+          persistent_arena_.Deallocate(context_, allocs_[tensor_index]));
+      allocs_[tensor_index].reset();
+    }
+  }
+
+  // When the whole arena is planned, the tensors are also packed in the
+  // "greedy by breadth" order, and the smaller of the two plans is kept.
+  const bool plans_whole_arena = !arena_.HasAllocations();
+  TF_LITE_ENSURE_STATUS(AllocateArenaTensors(tensor_order));
+  if (plans_whole_arena) {
+    const size_t greedy_by_size_bytes = arena_.RequiredBufferSize();
+    TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
+    TF_LITE_ENSURE_STATUS(
+        AllocateArenaTensors(CreateTensorAllocationVectorByBreadth(
+            tensor_order)));
+    if (arena_.RequiredBufferSize() >= greedy_by_size_bytes) {
+      TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
+      TF_LITE_ENSURE_STATUS(AllocateArenaTensors(tensor_order));
+    }
   }
 
-  // Vector of ids of already allocated tensors, ordered by offset.
+  // Check allocs_[].size to prevent from reallocation of persistent tensors.
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw) {
-      TF_LITE_ENSURE_STATUS(
-          arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
-                          tensor_index, alloc_node_[tensor_index],
-                          dealloc_node_[tensor_index], &allocs_[tensor_index]));
-    }
-    // Check allocs_[].size to prevent from reallocation of persistent tensors.
     if (tensor.allocation_type == kTfLiteArenaRwPersistent &&
         allocs_[tensor_index].size == 0) {
       TF_LITE_ENSURE_STATUS(persistent_arena_.Allocate(
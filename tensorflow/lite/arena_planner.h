@@ -57,6 +57,7 @@ class ArenaPlanner : public MemoryPlanner {
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
 
   TfLiteStatus ResetAllocations() override;
+  TfLiteStatus ResetAllocationsKeepingLayout() override;
   TfLiteStatus ResetAllocationsAfter(int node) override;
   TfLiteStatus PlanAllocations() override;
   TfLiteStatus ExecuteAllocations(int first_node, int last_node) override;
@@ -67,6 +68,14 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Sets arena offsets planned offline for the kTfLiteArenaRw tensors, indexed
+  // by tensor, with -1 for the tensors to plan at runtime. An offset is only
+  // used if it is aligned and doesn't overlap the offsets of the tensors used
+  // at the same time, which keeps the plan valid when tensors are resized.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+    offline_planned_offsets_ = std::move(offsets);
+  }
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -82,6 +91,24 @@ class ArenaPlanner : public MemoryPlanner {
   std::vector<int32_t> CreateTensorAllocationVector(int first_node,
                                                     int last_node);
 
+  // Returns the kTfLiteArenaRw tensors of 'tensor_order' in the order of the
+  // "greedy by breadth" algorithm: nodes are visited in non-increasing order
+  // of the bytes of the tensors used during their step, and the tensors they
+  // use which weren't visited yet are ordered in non-increasing order of size.
+  // Which of this order and the one of CreateTensorAllocationVector() packs
+  // the arena tighter depends on the graph.
+  std::vector<int32_t> CreateTensorAllocationVectorByBreadth(
+      const std::vector<int32_t>& tensor_order);
+
+  // Reserves space in the arena for the kTfLiteArenaRw tensors of
+  // 'tensor_order', in that order, after the ones with an offline offset.
+  TfLiteStatus AllocateArenaTensors(const std::vector<int32_t>& tensor_order);
+
+  // Returns the first and last nodes of the step of 'node', over which the
+  // tensors used by 'node' must be live.
+  int32_t StepBegin(int32_t node) const;
+  int32_t StepEnd(int32_t node) const;
+
   // Traverse the allocation queue and reserve space in the appropriate arena
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
@@ -131,6 +158,12 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // If true, tensors which fit in their current allocations keep them.
+  bool keep_layout_ = false;
+
+  // Arena offsets planned offline, or -1, indexed by tensor.
+  std::vector<int32_t> offline_planned_offsets_;
 };
 
 }  // namespace tflite
@@ -191,6 +191,10 @@ class ArenaPlannerTest : public ::testing::Test {
     CHECK(planner_->AcquireNonPersistentMemory() == kTfLiteOk);
   }
 
+  void ResetAllocationsKeepingLayout() {
+    CHECK(planner_->ResetAllocationsKeepingLayout() == kTfLiteOk);
+  }
+
   void ResetAllocationsAfter(int node) {
     CHECK(planner_->ResetAllocationsAfter(node) == kTfLiteOk);
   }
@@ -745,6 +749,103 @@ TEST_F(ArenaPlannerTest, GraphWithIntermediates) {
   EXPECT_EQ(GetOffset(2), GetOffsetAfter(5));
 }
 
+TEST_F(ArenaPlannerTest, KeepLayoutForSmallerTensors) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {2}},
+                      {{1}, {3}, {}},
+                  },
+                  {3});
+  (*graph.tensors())[0].bytes = 64;
+  (*graph.tensors())[1].bytes = 64;
+  (*graph.tensors())[2].bytes = 64;
+  (*graph.tensors())[3].bytes = 64;
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i < 4; ++i) offsets.push_back(GetOffset(i));
+
+  // Smaller tensors keep their offsets, even where a new plan would differ.
+  ResetAllocationsKeepingLayout();
+  (*graph.tensors())[0].bytes = 16;
+  (*graph.tensors())[1].bytes = 16;
+  (*graph.tensors())[2].bytes = 8;
+  Execute(0, 10);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]);
+  }
+
+  // A tensor outgrowing its allocation is allocated again, without
+  // overlapping the allocation of 1, which is live at the same time.
+  ResetAllocationsKeepingLayout();
+  (*graph.tensors())[3].bytes = 128;
+  Execute(0, 10);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]);
+  }
+  EXPECT_TRUE(GetOffset(3) >= offsets[1] + 64 ||
+              GetOffset(3) + 128 <= offsets[1]);
+}
+
+TEST_F(ArenaPlannerTest, GreedyByBreadth) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},
+                      {{1}, {2}, {}},
+                      {{2, 1}, {3}, {}},
+                  },
+                  {3});
+  (*graph.tensors())[0].bytes = 12;
+  (*graph.tensors())[1].bytes = 8;
+  (*graph.tensors())[2].bytes = 8;
+  (*graph.tensors())[3].bytes = 8;
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // Allocating by size puts 0 and 1 next to each other, then 2 after 1 and 3
+  // after 2, for 28 bytes. The last node uses 1, 2 and 3, which are packed
+  // first, in 24 bytes.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_LE(GetOffsetAfter(i), 24);
+  }
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(1));
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(2));
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlannedOffsets) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},
+                      {{1}, {2}, {}},
+                      {{2}, {3}, {}},
+                  },
+                  {3});
+  SetGraph(&graph);
+  // 1 overlaps 2, which is live at the same time and, being larger, placed
+  // first, so the offset of 1 is ignored.
+  planner_->SetOfflinePlannedOffsets({-1, 36, 32, 0});
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  CHECK(planner_->PlanAllocations() == kTfLiteOk);
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(2), 32);
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_NE(GetOffset(1), 36);
+  EXPECT_TRUE(GetOffset(1) >= GetOffsetAfter(2) ||
+              GetOffsetAfter(1) <= GetOffset(2));
+
+  // Misaligned offsets are ignored too.
+  planner_->SetOfflinePlannedOffsets({-1, 33, -1, -1});
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  CHECK(planner_->PlanAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(1) % kTensorAlignment, 0);
+}
+
 }  // namespace
 }  // namespace tflite
 
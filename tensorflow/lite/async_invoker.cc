@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/async_invoker.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace {
+
+// Allocates a buffer of `bytes` aligned for a custom allocation in `storage`,
+// and returns it.
+char* AllocateAlignedBuffer(size_t bytes,
+                            std::vector<std::unique_ptr<char[]>>* storage) {
+  storage->emplace_back(new char[bytes + kDefaultTensorAlignment]);
+  char* buffer = storage->back().get();
+  const size_t misalignment =
+      reinterpret_cast<uintptr_t>(buffer) % kDefaultTensorAlignment;
+  return misalignment == 0 ? buffer
+                           : buffer + kDefaultTensorAlignment - misalignment;
+}
+
+}  // namespace
+
+AsyncInvoker::AsyncInvoker(Interpreter* interpreter)
+    : interpreter_(interpreter), thread_([this] { Run(); }) {}
+
+AsyncInvoker::~AsyncInvoker() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return !pending_; });
+    stopping_ = true;
+  }
+  cond_.notify_all();
+  thread_.join();
+}
+
+TfLiteStatus AsyncInvoker::EnableDoubleBuffering() {
+  Wait();
+  for (BufferSet& buffer_set : buffer_sets_) {
+    buffer_set = BufferSet();
+    for (int tensor_index : interpreter_->inputs()) {
+      buffer_set.inputs.push_back(AllocateAlignedBuffer(
+          interpreter_->tensor(tensor_index)->bytes, &buffer_set.storage));
+    }
+    for (int tensor_index : interpreter_->outputs()) {
+      buffer_set.outputs.push_back(AllocateAlignedBuffer(
+          interpreter_->tensor(tensor_index)->bytes, &buffer_set.storage));
+    }
+  }
+  double_buffering_ = true;
+  next_buffer_set_ = 0;
+  completed_buffer_set_ = 1;
+  return BindBuffers(&buffer_sets_[next_buffer_set_]);
+}
+
+TfLiteStatus AsyncInvoker::BindBuffers(BufferSet* buffer_set) {
+  auto bind = [this](int tensor_index, char* data) {
+    TfLiteCustomAllocation allocation = {
+        data, interpreter_->tensor(tensor_index)->bytes};
+    return interpreter_->SetCustomAllocationForTensor(tensor_index,
+                                                      allocation);
+  };
+  for (size_t i = 0; i < buffer_set->inputs.size(); ++i) {
+    TF_LITE_ENSURE_STATUS(
+        bind(interpreter_->inputs()[i], buffer_set->inputs[i]));
+  }
+  for (size_t i = 0; i < buffer_set->outputs.size(); ++i) {
+    TF_LITE_ENSURE_STATUS(
+        bind(interpreter_->outputs()[i], buffer_set->outputs[i]));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AsyncInvoker::InvokeAsync(DoneCallback done) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return !pending_; });
+  if (double_buffering_) {
+    TF_LITE_ENSURE_STATUS(BindBuffers(&buffer_sets_[next_buffer_set_]));
+  }
+  pending_buffer_set_ = next_buffer_set_;
+  next_buffer_set_ = 1 - next_buffer_set_;
+  done_ = std::move(done);
+  pending_ = true;
+  posted_ = true;
+  lock.unlock();
+  cond_.notify_all();
+  return kTfLiteOk;
+}
+
+TfLiteStatus AsyncInvoker::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return !pending_; });
+  return last_status_;
+}
+
+void* AsyncInvoker::input_data(int input_index) {
+  if (double_buffering_) {
+    return buffer_sets_[next_buffer_set_].inputs[input_index];
+  }
+  return interpreter_->input_tensor(input_index)->data.raw;
+}
+
+const void* AsyncInvoker::completed_output_data(int output_index) {
+  if (double_buffering_) {
+    return buffer_sets_[completed_buffer_set_].outputs[output_index];
+  }
+  return interpreter_->output_tensor(output_index)->data.raw;
+}
+
+void AsyncInvoker::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stopping_ || posted_; });
+    if (stopping_) return;
+    posted_ = false;
+    DoneCallback done = std::move(done_);
+    const int buffer_set = pending_buffer_set_;
+    lock.unlock();
+
+    const TfLiteStatus status = interpreter_->Invoke();
+
+    lock.lock();
+    last_status_ = status;
+    completed_buffer_set_ = buffer_set;
+    if (done) {
+      lock.unlock();
+      done(status);
+      lock.lock();
+    }
+    pending_ = false;
+    cond_.notify_all();
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_ASYNC_INVOKER_H_
+#define TENSORFLOW_LITE_ASYNC_INVOKER_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+
+// Runs the invocations of an interpreter on a thread of its own, so that the
+// calling thread isn't blocked while the interpreter, or the accelerator of
+// its delegates, computes:
+//
+//   AsyncInvoker invoker(interpreter.get());
+//   invoker.EnableDoubleBuffering();
+//   while (...) {
+//     Preprocess(frame, invoker.input_data(0));
+//     invoker.InvokeAsync([&](TfLiteStatus status) {
+//       Postprocess(invoker.completed_output_data(0));
+//     });
+//   }
+//   invoker.Wait();
+//
+// With double buffering, the input and output tensors alternate between two
+// sets of buffers, so that the inputs of the next invocation can be written,
+// and the outputs of the last completed one read, while an invocation runs.
+// Otherwise, the tensors of the interpreter must not be accessed until the
+// invocation completes.
+//
+// The interpreter must have its tensors allocated, must not be used directly
+// while the invoker has a pending invocation, and must outlive the invoker.
+// The methods of the invoker are meant to be called from a single thread.
+class AsyncInvoker {
+ public:
+  // Called on the thread of the invoker with the status of Invoke().
+  using DoneCallback = std::function<void(TfLiteStatus status)>;
+
+  explicit AsyncInvoker(Interpreter* interpreter);
+  // Waits for the pending invocation.
+  ~AsyncInvoker();
+
+  // Allocates two buffers for each input and output tensor of the
+  // interpreter, which replace their arena memory. The tensors must not be
+  // resized afterwards.
+  TfLiteStatus EnableDoubleBuffering();
+
+  // Starts an invocation of the interpreter, after waiting for the pending
+  // one, if any, and returns without waiting for it. `done`, if set, is called
+  // once the invocation completes. Returns an error if the invoker failed to
+  // bind the buffers of the invocation to the tensors.
+  TfLiteStatus InvokeAsync(DoneCallback done = nullptr);
+
+  // Waits for the pending invocation, if any, and returns the status of the
+  // last completed one.
+  TfLiteStatus Wait();
+
+  // Returns the buffer of the `input_index`-th input of the next invocation,
+  // or, without double buffering, the data of the input tensor.
+  void* input_data(int input_index);
+
+  // Returns the buffer of the `output_index`-th output of the last completed
+  // invocation, which stays valid until the invocation after the next one
+  // starts, or, without double buffering, the data of the output tensor. Must
+  // be called from `done` or after Wait().
+  const void* completed_output_data(int output_index);
+
+ private:
+  // The buffers of the input and output tensors of an invocation, aligned in
+  // `storage`.
+  struct BufferSet {
+    std::vector<std::unique_ptr<char[]>> storage;
+    std::vector<char*> inputs;
+    std::vector<char*> outputs;
+  };
+
+  // Binds the buffers of `buffer_set` to the input and output tensors.
+  TfLiteStatus BindBuffers(BufferSet* buffer_set);
+
+  // Runs the invocations posted by InvokeAsync().
+  void Run();
+
+  Interpreter* const interpreter_;
+
+  // The buffers of the two invocations when double buffering.
+  bool double_buffering_ = false;
+  BufferSet buffer_sets_[2];
+  // The buffer sets of the next invocation, of the pending one and of the
+  // last completed one.
+  int next_buffer_set_ = 0;
+  int pending_buffer_set_ = 0;
+  int completed_buffer_set_ = 1;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // Whether an invocation was posted and hasn't completed yet, and whether
+  // the thread of the invoker hasn't started it yet.
+  bool pending_ = false;
+  bool posted_ = false;
+  bool stopping_ = false;
+  DoneCallback done_;
+  TfLiteStatus last_status_ = kTfLiteOk;
+  std::thread thread_;
+
+  AsyncInvoker(const AsyncInvoker&) = delete;
+  AsyncInvoker& operator=(const AsyncInvoker&) = delete;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_ASYNC_INVOKER_H_
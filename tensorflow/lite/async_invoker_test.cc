@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/async_invoker.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+// Builds an interpreter computing the sum of two float tensors of 4 elements.
+std::unique_ptr<Interpreter> BuildAddInterpreter() {
+  std::unique_ptr<Interpreter> interpreter(new Interpreter);
+  EXPECT_EQ(interpreter->AddTensors(3), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetInputs({0, 1}), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetOutputs({2}), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter->SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {4}, TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  auto* params =
+      reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+  params->activation = kTfLiteActNone;
+  EXPECT_EQ(interpreter->AddNodeWithParameters({0, 1}, {2}, nullptr, 0, params,
+                                               ops::builtin::Register_ADD()),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  return interpreter;
+}
+
+void FillInputs(AsyncInvoker* invoker, float value) {
+  for (int input = 0; input < 2; ++input) {
+    float* data = static_cast<float*>(invoker->input_data(input));
+    for (int i = 0; i < 4; ++i) data[i] = value + i;
+  }
+}
+
+std::vector<float> CompletedOutput(AsyncInvoker* invoker) {
+  const float* data =
+      static_cast<const float*>(invoker->completed_output_data(0));
+  return std::vector<float>(data, data + 4);
+}
+
+TEST(AsyncInvokerTest, InvokesOnItsThread) {
+  std::unique_ptr<Interpreter> interpreter = BuildAddInterpreter();
+  AsyncInvoker invoker(interpreter.get());
+  FillInputs(&invoker, 1);
+  std::thread::id done_thread_id;
+  TfLiteStatus done_status = kTfLiteError;
+  auto done = [&](TfLiteStatus status) {
+    done_thread_id = std::this_thread::get_id();
+    done_status = status;
+  };
+  ASSERT_EQ(invoker.InvokeAsync(done), kTfLiteOk);
+  EXPECT_EQ(invoker.Wait(), kTfLiteOk);
+  EXPECT_EQ(done_status, kTfLiteOk);
+  EXPECT_NE(done_thread_id, std::this_thread::get_id());
+  EXPECT_THAT(CompletedOutput(&invoker), ::testing::ElementsAre(2, 4, 6, 8));
+}
+
+TEST(AsyncInvokerTest, DoubleBuffering) {
+  std::unique_ptr<Interpreter> interpreter = BuildAddInterpreter();
+  AsyncInvoker invoker(interpreter.get());
+  ASSERT_EQ(invoker.EnableDoubleBuffering(), kTfLiteOk);
+
+  std::vector<std::vector<float>> outputs;
+  auto done = [&](TfLiteStatus status) {
+    EXPECT_EQ(status, kTfLiteOk);
+    outputs.push_back(CompletedOutput(&invoker));
+  };
+  for (int frame = 0; frame < 4; ++frame) {
+    // The inputs of the next frame are written while the previous one runs.
+    FillInputs(&invoker, frame);
+    ASSERT_EQ(invoker.InvokeAsync(done), kTfLiteOk);
+  }
+  EXPECT_EQ(invoker.Wait(), kTfLiteOk);
+
+  ASSERT_EQ(outputs.size(), 4);
+  for (int frame = 0; frame < 4; ++frame) {
+    EXPECT_THAT(outputs[frame],
+                ::testing::ElementsAre(2 * frame, 2 * frame + 2,
+                                       2 * frame + 4, 2 * frame + 6));
+  }
+  // The outputs of the last frame stay readable after it completes.
+  EXPECT_THAT(CompletedOutput(&invoker), ::testing::ElementsAre(6, 8, 10, 12));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
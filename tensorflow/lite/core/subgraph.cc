@@ -16,7 +16,12 @@ limitations under the License.
 #include "tensorflow/lite/core/subgraph.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <cstdint>
+#include <functional>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
 
 #include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/builtin_ops.h"
@@ -24,6 +29,7 @@ limitations under the License.
 #include "tensorflow/lite/context_util.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -51,6 +57,32 @@ struct TfLiteSparsityDeleter {
 using ScopedTfLiteSparsity =
     std::unique_ptr<TfLiteSparsity, TfLiteSparsityDeleter>;
 
+// The CPU backend context used instead of the shared one by the nodes running
+// on the current thread, if it is an inter-op thread.
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
+// Returns whether the node may depend on, or change, state other than its
+// tensors, and must keep its order relative to the other such nodes.
+bool IsOrderedNode(const TfLiteContext& context, const TfLiteNode& node,
+                   const TfLiteRegistration& registration) {
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinCustom:
+    case kTfLiteBuiltinIf:
+    case kTfLiteBuiltinWhile:
+      return true;
+    default:
+      break;
+  }
+  for (int i = 0; i < node.inputs->size; ++i) {
+    const int tensor_index = node.inputs->data[i];
+    if (tensor_index != kTfLiteOptionalTensor &&
+        context.tensors[tensor_index].is_variable) {
+      return true;
+    }
+  }
+  return false;
+}
+
 TfLiteStatus ReportOpError(TfLiteContext* context, const TfLiteNode& node,
                            const TfLiteRegistration& registration,
                            int node_index, const char* message) {
@@ -154,6 +186,90 @@ TfLiteStatus ValidateCustomAllocationForTensor(
 
 }  // namespace
 
+// A fixed set of threads running batches of tasks, together with the thread
+// submitting them.
+class InterOpThreadPool {
+ public:
+  // A task is given its index in the batch, and the index of the thread
+  // running it, where the submitting thread is 0.
+  using Task = std::function<void(int task_index, int thread_index)>;
+
+  explicit InterOpThreadPool(int num_threads) {
+    for (int i = 1; i < num_threads; ++i) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ~InterOpThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int num_threads() const { return workers_.size() + 1; }
+
+  // Runs `task` for the task indices in [0, num_tasks), and returns once they
+  // have all run.
+  void Run(int num_tasks, const Task& task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      num_tasks_ = num_tasks;
+      next_task_ = 0;
+      busy_workers_ = workers_.size();
+      ++generation_;
+    }
+    work_available_.notify_all();
+    RunTasks(/*thread_index=*/0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  void RunTasks(int thread_index) {
+    for (int i = next_task_++; i < num_tasks_; i = next_task_++) {
+      (*task_)(i, thread_index);
+    }
+  }
+
+  void WorkerLoop(int thread_index) {
+    int64_t last_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [&] {
+          return stopping_ || generation_ != last_generation;
+        });
+        if (stopping_) return;
+        last_generation = generation_;
+      }
+      RunTasks(thread_index);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_workers_ == 0) {
+        work_done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  bool stopping_ = false;
+  int64_t generation_ = 0;
+  int busy_workers_ = 0;
+  // The current batch, set under `mutex_` before `generation_` changes.
+  const Task* task_ = nullptr;
+  int num_tasks_ = 0;
+  std::atomic<int> next_task_{0};
+};
+
 // A trivial implementation of GraphInfo around the Interpreter.
 // NOTE: this interpreter info represents the subset of the
 // graph that is executed according to execution plan. Thus,
@@ -187,6 +303,18 @@ class InterpreterInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return subgraph_->variables();
   }
+  size_t step_begin(size_t index) const override {
+    const std::vector<int>& steps = subgraph_->inter_op_steps();
+    if (steps.empty()) return index;
+    return *(std::upper_bound(steps.begin(), steps.end(), index) - 1);
+  }
+  size_t step_end(size_t index) const override {
+    const std::vector<int>& steps = subgraph_->inter_op_steps();
+    if (steps.empty()) return index;
+    auto next_step = std::upper_bound(steps.begin(), steps.end(), index);
+    return next_step == steps.end() ? subgraph_->execution_plan().size() - 1
+                                    : *next_step - 1;
+  }
 
  public:
   Subgraph* subgraph_;
@@ -425,6 +553,10 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext &&
+      inter_op_cpu_backend_context != nullptr) {
+    return inter_op_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -679,7 +811,15 @@ TfLiteStatus Subgraph::AllocateTensors() {
   next_execution_plan_index_to_plan_allocation_ = 0;
   next_original_execution_plan_index_to_prepare_ = 0;
   if (memory_planner_) {
-    TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+    // With dynamic batching, the memory planned for the maximum batch size is
+    // kept.
+    TF_LITE_ENSURE_STATUS(max_batch_size_ > 0
+                              ? memory_planner_->ResetAllocationsKeepingLayout()
+                              : memory_planner_->ResetAllocations());
+  }
+  if (PlanInterOpSteps() && memory_planner_) {
+    // The lifetimes of the tensors depend on the order of the nodes.
+    TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
   }
 
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
@@ -855,6 +995,47 @@ TfLiteStatus Subgraph::ResizeInputTensorStrict(int tensor_index,
   return ResizeInputTensor(tensor_index, dims);
 }
 
+TfLiteStatus Subgraph::SetMaxBatchSize(int max_batch_size) {
+  TF_LITE_ENSURE(&context_, max_batch_size > 0);
+  for (int tensor_index : inputs_) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    TF_LITE_ENSURE(&context_, tensor.dims->size > 0);
+    std::vector<int> dims(tensor.dims->data,
+                          tensor.dims->data + tensor.dims->size);
+    dims[0] = max_batch_size;
+    TF_LITE_ENSURE_STATUS(ResizeInputTensor(tensor_index, dims));
+  }
+  // The memory is planned from scratch for the new maximum.
+  if (memory_planner_) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+  }
+  state_ = kStateUninvokable;
+  max_batch_size_ = max_batch_size;
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::ResizeInputBatch(int batch_size) {
+  if (max_batch_size_ == 0) {
+    ReportError("ResizeInputBatch called without a maximum batch size.");
+    return kTfLiteError;
+  }
+  if (batch_size < 1 || batch_size > max_batch_size_) {
+    ReportError("Batch size %d is not in [1, %d].", batch_size,
+                max_batch_size_);
+    return kTfLiteError;
+  }
+  for (int tensor_index : inputs_) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    std::vector<int> dims(tensor.dims->data,
+                          tensor.dims->data + tensor.dims->size);
+    dims[0] = batch_size;
+    TF_LITE_ENSURE_STATUS(ResizeInputTensor(tensor_index, dims));
+  }
+  return AllocateTensors();
+}
+
 TfLiteStatus Subgraph::ReleaseNonPersistentMemory() {
   if (memory_planner_) {
     TF_LITE_ENSURE_STATUS(memory_planner_->ReleaseNonPersistentMemory());
@@ -916,10 +1097,12 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
 
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   if (!memory_planner_) {
-    memory_planner_.reset(new ArenaPlanner(
+    ArenaPlanner* arena_planner = new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
         /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
-        kDefaultTensorAlignment));
+        kDefaultTensorAlignment);
+    arena_planner->SetOfflinePlannedOffsets(offline_planned_offsets_);
+    memory_planner_.reset(arena_planner);
     memory_planner_->PlanAllocations();
   }
 
@@ -998,6 +1181,22 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  if (inter_op_thread_pool_ && !inter_op_steps_.empty() && !profiler_) {
+    // Nodes resizing dynamic tensors need the following nodes to be prepared
+    // again, so they run one at a time.
+    bool has_dynamic_tensors = false;
+    for (const TfLiteTensor& tensor : tensors_) {
+      if (tensor.allocation_type == kTfLiteDynamic) {
+        has_dynamic_tensors = true;
+        break;
+      }
+    }
+    if (!has_dynamic_tensors &&
+        next_execution_plan_index_to_prepare_ == execution_plan_.size()) {
+      return InvokeInterOpSteps();
+    }
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1084,6 +1283,140 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+TfLiteStatus Subgraph::SetNumInterOpThreads(int num_threads) {
+  if (num_threads < 1) {
+    ReportError("num_threads should be >= 1");
+    return kTfLiteError;
+  }
+  inter_op_cpu_backend_contexts_.clear();
+  if (num_threads > 1) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_threads));
+    for (int i = 1; i < num_threads; ++i) {
+      inter_op_cpu_backend_contexts_.emplace_back(
+          new ExternalCpuBackendContext());
+    }
+  } else {
+    inter_op_thread_pool_.reset();
+  }
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+bool Subgraph::PlanInterOpSteps() {
+  std::vector<int> steps;
+  std::vector<int> plan = execution_plan_;
+  // Delegated nodes may depend on each other through their delegate.
+  if (inter_op_thread_pool_ && pre_delegation_execution_plan_.empty()) {
+    // The level of a node is the length of the longest chain of nodes it
+    // depends on; nodes of the same level do not depend on each other.
+    std::vector<int> producer_level(tensors_.size(), -1);
+    std::vector<int> levels(plan.size());
+    int last_ordered_level = -1;
+    for (int i = 0; i < plan.size(); ++i) {
+      const TfLiteNode& node = nodes_and_registration_[plan[i]].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[plan[i]].second;
+      int level = 0;
+      for (int j = 0; j < node.inputs->size; ++j) {
+        const int tensor_index = node.inputs->data[j];
+        if (tensor_index != kTfLiteOptionalTensor) {
+          level = std::max(level, producer_level[tensor_index] + 1);
+        }
+      }
+      if (IsOrderedNode(context_, node, registration)) {
+        level = std::max(level, last_ordered_level + 1);
+        last_ordered_level = level;
+      }
+      for (int j = 0; j < node.outputs->size; ++j) {
+        const int tensor_index = node.outputs->data[j];
+        if (tensor_index != kTfLiteOptionalTensor) {
+          producer_level[tensor_index] = level;
+        }
+      }
+      levels[i] = level;
+    }
+
+    std::vector<int> order(plan.size());
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return levels[a] < levels[b]; });
+    for (int i = 0; i < order.size(); ++i) {
+      plan[i] = execution_plan_[order[i]];
+      if (i == 0 || levels[order[i]] != levels[order[i - 1]]) {
+        steps.push_back(i);
+      }
+    }
+    // Nothing runs concurrently if each step has a single node.
+    if (steps.size() == plan.size()) {
+      steps.clear();
+      plan = execution_plan_;
+    }
+  }
+  const bool changed = plan != execution_plan_ || steps != inter_op_steps_;
+  execution_plan_ = std::move(plan);
+  inter_op_steps_ = std::move(steps);
+  return changed;
+}
+
+TfLiteStatus Subgraph::InvokeInterOpNode(int execution_plan_index) {
+  int node_index = execution_plan_[execution_plan_index];
+  TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    // As in Invoke(), the second input of Reshape is only used for its shape.
+    if (tensor.data.raw == nullptr && tensor.bytes > 0 &&
+        !(registration.builtin_code == kTfLiteBuiltinReshape && i == 1)) {
+      ReportError("Input tensor %d lacks data", tensor_index);
+      return kTfLiteError;
+    }
+  }
+  if (OpInvoke(registration, &node) != kTfLiteOk) {
+    return ReportOpError(&context_, node, registration, node_index,
+                         "failed to invoke");
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::InvokeInterOpSteps() {
+  EnsureTensorsVectorCapacity();
+  for (int step = 0; step < inter_op_steps_.size(); ++step) {
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+    const int begin = inter_op_steps_[step];
+    const int end = step + 1 < inter_op_steps_.size()
+                        ? inter_op_steps_[step + 1]
+                        : execution_plan_.size();
+    if (end - begin == 1) {
+      TF_LITE_ENSURE_STATUS(InvokeInterOpNode(begin));
+      continue;
+    }
+    std::vector<TfLiteStatus> statuses(end - begin, kTfLiteOk);
+    inter_op_thread_pool_->Run(end - begin, [&](int task, int thread) {
+      if (thread > 0) {
+        inter_op_cpu_backend_context =
+            inter_op_cpu_backend_contexts_[thread - 1].get();
+      }
+      statuses[task] = InvokeInterOpNode(begin + task);
+      if (thread > 0) {
+        inter_op_cpu_backend_context = nullptr;
+      }
+    });
+    for (TfLiteStatus status : statuses) {
+      TF_LITE_ENSURE_STATUS(status);
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
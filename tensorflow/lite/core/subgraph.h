@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <cstdlib>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -34,6 +35,8 @@ namespace tflite {
 
 // Forward declare since NNAPIDelegate uses Interpreter.
 class NNAPIDelegate;
+class ExternalCpuBackendContext;
+class InterOpThreadPool;
 
 class Subgraph {
  public:
@@ -66,6 +69,13 @@ class Subgraph {
   // interpreter.
   TfLiteStatus SetVariables(std::vector<int> variables);
 
+  // Provide arena offsets planned offline for the tensors, indexed by tensor,
+  // with -1 for the tensors planned at runtime. The memory planner uses them
+  // where they are valid for the current tensor sizes.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+    offline_planned_offsets_ = std::move(offsets);
+  }
+
   // Ensure the internal node storage memory allocates at least `count`
   // spots for node. NOTE, this doesn't actually add operators. This is an
   // efficiency optimization that is subject to change.
@@ -225,6 +235,20 @@ class Subgraph {
   TfLiteStatus ResizeInputTensorStrict(int tensor_index,
                                        const std::vector<int>& dims);
 
+  // WARNING: Experimental interface, subject to change
+  // Enables dynamic batching: resizes the leading (batch) dimension of all the
+  // inputs to `max_batch_size`, so that the next AllocateTensors() plans the
+  // memory of the tensors for it. Later resizes, e.g. by ResizeInputBatch(),
+  // keep that memory layout as long as the tensors still fit in it.
+  TfLiteStatus SetMaxBatchSize(int max_batch_size);
+
+  // WARNING: Experimental interface, subject to change
+  // Resizes the batch dimension of all the inputs to `batch_size`, which must
+  // not exceed the size given to SetMaxBatchSize(), and prepares the ops for
+  // it. The tensors keep the memory planned for the maximum batch size, so
+  // this is much cheaper than ResizeInputTensor() and AllocateTensors().
+  TfLiteStatus ResizeInputBatch(int batch_size);
+
   // This releases memory held by non-persistent tensors. It does NOT re-perform
   // memory planning.
   // AllocateTensors needs to be called before next invocation.
@@ -244,6 +268,27 @@ class Subgraph {
   // Returns status of success or failure.
   TfLiteStatus Invoke();
 
+  // Sets the number of threads running independent nodes of the subgraph
+  // concurrently, in addition to the intra-op parallelism of each node. With
+  // more than one thread, AllocateTensors() reorders the execution plan into
+  // steps of nodes which do not depend on each other, plans the memory of the
+  // tensors so that the nodes of a step never share it, and Invoke() runs the
+  // nodes of each step concurrently. Each thread other than the calling one
+  // gets its own CPU backend context.
+  //
+  // Custom ops, control flow ops and nodes updating variable tensors keep
+  // their relative order, since they may depend on each other through state
+  // other than their tensors. Subgraphs with delegated nodes, and invocations
+  // with a profiler or with dynamic tensors, run one node at a time.
+  //
+  // AllocateTensors() needs to be called before the next invocation.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  // Returns the execution plan indices of the first node of each step of
+  // concurrent nodes, or an empty vector if the nodes run one at a time.
+  const std::vector<int>& inter_op_steps() const { return inter_op_steps_; }
+
   // Entry point for C node plugin API to report an error.
   void ReportError(const char* format, ...);
 
@@ -425,6 +470,18 @@ class Subgraph {
     return op_reg.invoke(&context_, node);
   }
 
+  // Groups the execution plan into `inter_op_steps_`, reordering it so that
+  // the nodes of each step are consecutive. Returns whether the execution plan
+  // changed.
+  bool PlanInterOpSteps();
+
+  // Invokes the node at `execution_plan_index` on one of the inter-op threads.
+  TfLiteStatus InvokeInterOpNode(int execution_plan_index);
+
+  // Invokes the steps of `inter_op_steps_` in order, with the nodes of each
+  // step running concurrently.
+  TfLiteStatus InvokeInterOpSteps();
+
   // Call OpPrepare() for as many ops as possible, allocating memory for their
   // tensors. If an op containing dynamic tensors is found, preparation will be
   // postponed until this function is called again. This allows the interpreter
@@ -710,6 +767,9 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Arena offsets planned offline, given to the memory planner.
+  std::vector<int32_t> offline_planned_offsets_;
+
   // Contains <tensor idx, custom allocation> pairs for all applicable tensors.
   std::vector<std::pair<int, TfLiteCustomAllocation>> custom_allocations_;
 
@@ -741,6 +801,20 @@ class Subgraph {
 
   // A map of resources. Owned by interpreter and shared by multiple subgraphs.
   resource::ResourceMap* resources_ = nullptr;
+
+  // Threads running independent nodes concurrently, if more than one.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // CPU backend context of each inter-op thread other than the calling one.
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
+  // Execution plan index of the first node of each step of concurrent nodes.
+  std::vector<int> inter_op_steps_;
+
+  // The batch size the memory of the tensors is planned for, if dynamic
+  // batching is enabled, or 0.
+  int max_batch_size_ = 0;
 };
 
 }  // namespace tflite
@@ -0,0 +1,441 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/elementwise_fusion/elementwise_fusion_delegate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/utils/simple_delegate.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace elementwise_fusion {
+namespace {
+
+// The number of elements computed through a whole chain at a time, small
+// enough for the intermediate values to stay in the L1 cache.
+constexpr int kBlockSize = 256;
+
+enum class StepType {
+  // The values of a quantized input are dequantized as they are loaded.
+  kDequantize,
+  kLogistic,
+  kTanh,
+  kRelu,
+  kRelu6,
+  kAdd,
+  kSub,
+  // Subtracts the value from the operand.
+  kReverseSub,
+  kMul,
+};
+
+// An op of a chain, computing a float value from the previous one.
+struct Step {
+  StepType type;
+  // The constant scalar operand of binary ops.
+  float operand = 0.0f;
+  TfLiteFusedActivation activation = kTfLiteActNone;
+  // The tensor the values are written to, or -1 if they are only consumed
+  // by the next op of the chain.
+  int output = -1;
+};
+
+// A chain of ops fused into one pass over the data.
+struct Chain {
+  int input;
+  // Whether the input is quantized and dequantized by the first op.
+  bool dequantize = false;
+  float scale = 0.0f;
+  int32_t zero_point = 0;
+  std::vector<Step> steps;
+};
+
+// The fused op a node computes and the index of the data it computes it on.
+struct FusableNode {
+  bool dequantize = false;
+  Step step;
+  int input = -1;
+};
+
+bool IsFloatTensor(const TfLiteContext* context, int tensor_index) {
+  return tensor_index >= 0 &&
+         context->tensors[tensor_index].type == kTfLiteFloat32 &&
+         !IsConstantTensor(&context->tensors[tensor_index]);
+}
+
+// Returns the value of a constant float tensor of one element, of at most one
+// dimension so that it doesn't broadcast the other operand to a higher rank.
+bool GetScalarOperand(const TfLiteContext* context, int tensor_index,
+                      float* value) {
+  if (tensor_index < 0) return false;
+  const TfLiteTensor& tensor = context->tensors[tensor_index];
+  if (tensor.type != kTfLiteFloat32 || !IsConstantTensor(&tensor) ||
+      tensor.dims->size > 1 || NumElements(&tensor) != 1) {
+    return false;
+  }
+  *value = tensor.data.f[0];
+  return true;
+}
+
+bool GetActivation(const TfLiteNode* node, TfLiteFusedActivation* activation) {
+  // All of TfLiteAddParams, TfLiteSubParams and TfLiteMulParams start with
+  // the activation.
+  *activation = node->builtin_data == nullptr
+                    ? kTfLiteActNone
+                    : static_cast<const TfLiteMulParams*>(node->builtin_data)
+                          ->activation;
+  return *activation == kTfLiteActNone || *activation == kTfLiteActRelu ||
+         *activation == kTfLiteActReluN1To1 || *activation == kTfLiteActRelu6;
+}
+
+// Returns whether `node` can be fused into a chain, and how.
+bool GetFusableNode(const TfLiteContext* context, const TfLiteNode* node,
+                    const TfLiteRegistration* registration,
+                    FusableNode* fusable) {
+  if (node->outputs->size != 1 ||
+      !IsFloatTensor(context, node->outputs->data[0])) {
+    return false;
+  }
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinDequantize: {
+      if (node->inputs->size != 1 || node->inputs->data[0] < 0) return false;
+      const TfLiteTensor& input = context->tensors[node->inputs->data[0]];
+      // Constant weights are dequantized once by the op itself.
+      if ((input.type != kTfLiteUInt8 && input.type != kTfLiteInt8) ||
+          IsConstantTensor(&input) ||
+          input.quantization.type != kTfLiteAffineQuantization) {
+        return false;
+      }
+      const auto* params = static_cast<const TfLiteAffineQuantization*>(
+          input.quantization.params);
+      if (params == nullptr || params->scale == nullptr ||
+          params->scale->size != 1 || params->zero_point == nullptr) {
+        return false;
+      }
+      fusable->dequantize = true;
+      fusable->step.type = StepType::kDequantize;
+      fusable->input = node->inputs->data[0];
+      return true;
+    }
+    case kTfLiteBuiltinLogistic:
+    case kTfLiteBuiltinTanh:
+    case kTfLiteBuiltinRelu:
+    case kTfLiteBuiltinRelu6: {
+      if (node->inputs->size != 1 ||
+          !IsFloatTensor(context, node->inputs->data[0])) {
+        return false;
+      }
+      fusable->input = node->inputs->data[0];
+      switch (registration->builtin_code) {
+        case kTfLiteBuiltinLogistic:
+          fusable->step.type = StepType::kLogistic;
+          break;
+        case kTfLiteBuiltinTanh:
+          fusable->step.type = StepType::kTanh;
+          break;
+        case kTfLiteBuiltinRelu:
+          fusable->step.type = StepType::kRelu;
+          break;
+        default:
+          fusable->step.type = StepType::kRelu6;
+          break;
+      }
+      return true;
+    }
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinMul: {
+      if (node->inputs->size != 2 ||
+          !GetActivation(node, &fusable->step.activation)) {
+        return false;
+      }
+      int operand_index;
+      if (IsFloatTensor(context, node->inputs->data[0]) &&
+          GetScalarOperand(context, node->inputs->data[1],
+                           &fusable->step.operand)) {
+        operand_index = 1;
+      } else if (IsFloatTensor(context, node->inputs->data[1]) &&
+                 GetScalarOperand(context, node->inputs->data[0],
+                                  &fusable->step.operand)) {
+        operand_index = 0;
+      } else {
+        return false;
+      }
+      fusable->input = node->inputs->data[1 - operand_index];
+      switch (registration->builtin_code) {
+        case kTfLiteBuiltinAdd:
+          fusable->step.type = StepType::kAdd;
+          break;
+        case kTfLiteBuiltinSub:
+          fusable->step.type =
+              operand_index == 1 ? StepType::kSub : StepType::kReverseSub;
+          break;
+        default:
+          fusable->step.type = StepType::kMul;
+          break;
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void ApplyActivation(TfLiteFusedActivation activation, float* values,
+                     int size) {
+  switch (activation) {
+    case kTfLiteActRelu:
+      for (int i = 0; i < size; ++i) values[i] = std::max(values[i], 0.0f);
+      break;
+    case kTfLiteActReluN1To1:
+      for (int i = 0; i < size; ++i) {
+        values[i] = std::min(std::max(values[i], -1.0f), 1.0f);
+      }
+      break;
+    case kTfLiteActRelu6:
+      for (int i = 0; i < size; ++i) {
+        values[i] = std::min(std::max(values[i], 0.0f), 6.0f);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void ApplyStep(const Step& step, float* values, int size) {
+  const float operand = step.operand;
+  switch (step.type) {
+    case StepType::kDequantize:
+      break;
+    case StepType::kLogistic:
+      for (int i = 0; i < size; ++i) {
+        values[i] = 1.0f / (1.0f + std::exp(-values[i]));
+      }
+      break;
+    case StepType::kTanh:
+      for (int i = 0; i < size; ++i) values[i] = std::tanh(values[i]);
+      break;
+    case StepType::kRelu:
+      for (int i = 0; i < size; ++i) values[i] = std::max(values[i], 0.0f);
+      break;
+    case StepType::kRelu6:
+      for (int i = 0; i < size; ++i) {
+        values[i] = std::min(std::max(values[i], 0.0f), 6.0f);
+      }
+      break;
+    case StepType::kAdd:
+      for (int i = 0; i < size; ++i) values[i] += operand;
+      break;
+    case StepType::kSub:
+      for (int i = 0; i < size; ++i) values[i] -= operand;
+      break;
+    case StepType::kReverseSub:
+      for (int i = 0; i < size; ++i) values[i] = operand - values[i];
+      break;
+    case StepType::kMul:
+      for (int i = 0; i < size; ++i) values[i] *= operand;
+      break;
+  }
+  ApplyActivation(step.activation, values, size);
+}
+
+template <typename T>
+void Dequantize(const T* input, float scale, int32_t zero_point,
+                float* values, int size) {
+  for (int i = 0; i < size; ++i) {
+    values[i] = scale * (static_cast<int32_t>(input[i]) - zero_point);
+  }
+}
+
+// Computes the chains of ops of a delegated partition, block by block.
+class ElementwiseFusionKernel : public SimpleDelegateKernelInterface {
+ public:
+  TfLiteStatus Init(TfLiteContext* context,
+                    const TfLiteDelegateParams* params) override {
+    // The tensors written by the partition, and the chain whose last op
+    // produced each tensor.
+    std::unordered_set<int> partition_outputs(
+        params->output_tensors->data,
+        params->output_tensors->data + params->output_tensors->size);
+    std::vector<int> producer_chain(context->tensors_size, -1);
+    std::unordered_set<int> chain_inputs;
+
+    // The nodes are in execution order, so an op follows the ones it depends
+    // on.
+    for (int i = 0; i < params->nodes_to_replace->size; ++i) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, params->nodes_to_replace->data[i], &node, &registration));
+      FusableNode fusable;
+      TF_LITE_ENSURE(context,
+                     GetFusableNode(context, node, registration, &fusable));
+      const int output = node->outputs->data[0];
+      int chain_index = producer_chain[fusable.input];
+      // Only the last op of a chain can be followed by another.
+      if (fusable.dequantize || chain_index < 0 ||
+          chains_[chain_index].steps.back().output != fusable.input) {
+        chains_.emplace_back();
+        chain_index = chains_.size() - 1;
+        Chain& chain = chains_.back();
+        chain.input = fusable.input;
+        chain_inputs.insert(fusable.input);
+        if (fusable.dequantize) {
+          const TfLiteTensor& input = context->tensors[fusable.input];
+          const auto* quantization =
+              static_cast<const TfLiteAffineQuantization*>(
+                  input.quantization.params);
+          chain.dequantize = true;
+          chain.scale = quantization->scale->data[0];
+          chain.zero_point = quantization->zero_point->data[0];
+        }
+      }
+      fusable.step.output = output;
+      chains_[chain_index].steps.push_back(fusable.step);
+      producer_chain[output] = chain_index;
+    }
+
+    // The values of the ops are only written if they are the result of a
+    // chain, consumed by another chain or out of the partition.
+    for (Chain& chain : chains_) {
+      for (size_t i = 0; i + 1 < chain.steps.size(); ++i) {
+        Step& step = chain.steps[i];
+        if (partition_outputs.count(step.output) == 0 &&
+            chain_inputs.count(step.output) == 0) {
+          step.output = -1;
+        }
+      }
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) override {
+    for (const Chain& chain : chains_) {
+      const TfLiteTensor& input = context->tensors[chain.input];
+      for (const Step& step : chain.steps) {
+        if (step.output < 0) continue;
+        TF_LITE_ENSURE_STATUS(
+            context->ResizeTensor(context, &context->tensors[step.output],
+                                  TfLiteIntArrayCopy(input.dims)));
+      }
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) override {
+    float values[kBlockSize];
+    for (const Chain& chain : chains_) {
+      const TfLiteTensor& input = context->tensors[chain.input];
+      const int64_t num_elements = NumElements(&input);
+      for (int64_t begin = 0; begin < num_elements; begin += kBlockSize) {
+        const int size =
+            static_cast<int>(std::min<int64_t>(kBlockSize,
+                                               num_elements - begin));
+        if (!chain.dequantize) {
+          std::copy_n(input.data.f + begin, size, values);
+        } else if (input.type == kTfLiteUInt8) {
+          Dequantize(input.data.uint8 + begin, chain.scale, chain.zero_point,
+                     values, size);
+        } else {
+          Dequantize(input.data.int8 + begin, chain.scale, chain.zero_point,
+                     values, size);
+        }
+        for (const Step& step : chain.steps) {
+          ApplyStep(step, values, size);
+          if (step.output >= 0) {
+            std::copy_n(values, size,
+                        context->tensors[step.output].data.f + begin);
+          }
+        }
+      }
+    }
+    return kTfLiteOk;
+  }
+
+ private:
+  std::vector<Chain> chains_;
+};
+
+class ElementwiseFusionDelegate : public SimpleDelegateInterface {
+ public:
+  bool IsNodeSupportedByDelegate(const TfLiteRegistration* registration,
+                                 const TfLiteNode* node,
+                                 TfLiteContext* context) const override {
+    return chained_nodes_.count(node) > 0;
+  }
+
+  // Finds the ops which are linked to another by their data, so that single
+  // ops are left to their own kernels.
+  TfLiteStatus Initialize(TfLiteContext* context) override {
+    chained_nodes_.clear();
+    TfLiteIntArray* execution_plan;
+    TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &execution_plan));
+    std::vector<const TfLiteNode*> producers(context->tensors_size, nullptr);
+    for (int i = 0; i < execution_plan->size; ++i) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, execution_plan->data[i], &node, &registration));
+      FusableNode fusable;
+      if (!GetFusableNode(context, node, registration, &fusable)) continue;
+      const TfLiteNode* producer = producers[fusable.input];
+      if (producer != nullptr && !fusable.dequantize) {
+        chained_nodes_.insert(producer);
+        chained_nodes_.insert(node);
+      }
+      producers[node->outputs->data[0]] = node;
+    }
+    return kTfLiteOk;
+  }
+
+  const char* Name() const override {
+    static constexpr char kName[] = "ElementwiseFusion";
+    return kName;
+  }
+
+  std::unique_ptr<SimpleDelegateKernelInterface> CreateDelegateKernelInterface()
+      override {
+    return std::unique_ptr<SimpleDelegateKernelInterface>(
+        new ElementwiseFusionKernel());
+  }
+
+  SimpleDelegateInterface::Options DelegateOptions() const override {
+    SimpleDelegateInterface::Options options;
+    options.min_nodes_per_partition = 2;
+    return options;
+  }
+
+ private:
+  std::unordered_set<const TfLiteNode*> chained_nodes_;
+};
+
+}  // namespace
+}  // namespace elementwise_fusion
+
+TfLiteDelegateUniquePtr CreateElementwiseFusionDelegate() {
+  return TfLiteDelegateFactory::Create(
+      std::unique_ptr<SimpleDelegateInterface>(
+          new elementwise_fusion::ElementwiseFusionDelegate()));
+}
+
+}  // namespace tflite
@@ -0,0 +1,41 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_DELEGATES_ELEMENTWISE_FUSION_ELEMENTWISE_FUSION_DELEGATE_H_
+#define TENSORFLOW_LITE_DELEGATES_ELEMENTWISE_FUSION_ELEMENTWISE_FUSION_DELEGATE_H_
+
+#include "tensorflow/lite/delegates/utils/simple_delegate.h"
+
+namespace tflite {
+
+// Creates a delegate fusing the chains of elementwise float ops of a graph,
+// e.g. the `Dequantize -> Logistic -> Mul -> Add` of model post-processing,
+// into single nodes which compute each element through the whole chain in one
+// pass over the data, instead of writing and reading back an intermediate
+// tensor per op. It runs on the CPU, so it is meant to be applied after the
+// delegates of accelerators, to the nodes they left to the interpreter:
+//
+//   interpreter->ModifyGraphWithDelegate(gpu_delegate);
+//   interpreter->ModifyGraphWithDelegate(fusion_delegate.get());
+//   interpreter->AllocateTensors();
+//
+// The fused ops are a leading DEQUANTIZE of a per-tensor quantized uint8 or
+// int8 tensor, and LOGISTIC, TANH, RELU, RELU6, and ADD, SUB and MUL of a
+// constant scalar, with their fused RELU activations, on float32 tensors.
+// Chains need at least two ops.
+TfLiteDelegateUniquePtr CreateElementwiseFusionDelegate();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_ELEMENTWISE_FUSION_ELEMENTWISE_FUSION_DELEGATE_H_
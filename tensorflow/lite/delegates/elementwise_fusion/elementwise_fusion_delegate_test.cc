@@ -0,0 +1,160 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/elementwise_fusion/elementwise_fusion_delegate.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kNumElements = 300;
+const float kTwo = 2.0f;
+const float kMinusOne = -1.0f;
+
+// Builds an interpreter computing `2 * Logistic(Dequantize(input)) - 1` on a
+// uint8 tensor of `kNumElements`, i.e. Tanh(Dequantize(input) / 2). If
+// `logistic_is_output`, the result of the Logistic is an output too.
+std::unique_ptr<Interpreter> BuildChainInterpreter(bool logistic_is_output) {
+  std::unique_ptr<Interpreter> interpreter(new Interpreter);
+  EXPECT_EQ(interpreter->AddTensors(7), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetInputs({0}), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetOutputs(logistic_is_output
+                                        ? std::vector<int>{6, 2}
+                                        : std::vector<int>{6}),
+            kTfLiteOk);
+  TfLiteQuantizationParams quantization;
+  quantization.scale = 0.05f;
+  quantization.zero_point = 128;
+  EXPECT_EQ(interpreter->SetTensorParametersReadWrite(
+                0, kTfLiteUInt8, "input", {kNumElements}, quantization),
+            kTfLiteOk);
+  for (int i : {1, 2, 4, 6}) {
+    EXPECT_EQ(interpreter->SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {kNumElements},
+                  TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  EXPECT_EQ(interpreter->SetTensorParametersReadOnly(
+                3, kTfLiteFloat32, "two", {1}, TfLiteQuantizationParams(),
+                reinterpret_cast<const char*>(&kTwo), sizeof(kTwo)),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->SetTensorParametersReadOnly(
+                5, kTfLiteFloat32, "minus_one", {}, TfLiteQuantizationParams(),
+                reinterpret_cast<const char*>(&kMinusOne), sizeof(kMinusOne)),
+            kTfLiteOk);
+
+  EXPECT_EQ(interpreter->AddNodeWithParameters(
+                {0}, {1}, nullptr, 0, nullptr,
+                ops::builtin::Register_DEQUANTIZE()),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->AddNodeWithParameters(
+                {1}, {2}, nullptr, 0, nullptr,
+                ops::builtin::Register_LOGISTIC()),
+            kTfLiteOk);
+  auto* mul_params =
+      reinterpret_cast<TfLiteMulParams*>(malloc(sizeof(TfLiteMulParams)));
+  mul_params->activation = kTfLiteActNone;
+  EXPECT_EQ(interpreter->AddNodeWithParameters({2, 3}, {4}, nullptr, 0,
+                                               mul_params,
+                                               ops::builtin::Register_MUL()),
+            kTfLiteOk);
+  auto* add_params =
+      reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+  add_params->activation = kTfLiteActNone;
+  add_params->pot_scale_int16 = false;
+  EXPECT_EQ(interpreter->AddNodeWithParameters({5, 4}, {6}, nullptr, 0,
+                                               add_params,
+                                               ops::builtin::Register_ADD()),
+            kTfLiteOk);
+  return interpreter;
+}
+
+void FillInput(Interpreter* interpreter) {
+  uint8_t* input = interpreter->typed_input_tensor<uint8_t>(0);
+  for (int i = 0; i < kNumElements; ++i) input[i] = i % 256;
+}
+
+float Dequantized(int i) { return 0.05f * (i % 256 - 128); }
+
+TEST(ElementwiseFusionDelegateTest, FusesChain) {
+  std::unique_ptr<Interpreter> interpreter =
+      BuildChainInterpreter(/*logistic_is_output=*/false);
+  TfLiteDelegateUniquePtr delegate = CreateElementwiseFusionDelegate();
+  ASSERT_EQ(interpreter->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+  ASSERT_EQ(interpreter->execution_plan().size(), 1);
+  const int node_index = interpreter->execution_plan()[0];
+  EXPECT_EQ(interpreter->node_and_registration(node_index)->second.builtin_code,
+            kTfLiteBuiltinDelegate);
+
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  FillInput(interpreter.get());
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  const float* output = interpreter->typed_output_tensor<float>(0);
+  for (int i = 0; i < kNumElements; ++i) {
+    EXPECT_NEAR(output[i], std::tanh(Dequantized(i) / 2), 1e-5) << i;
+  }
+}
+
+TEST(ElementwiseFusionDelegateTest, WritesIntermediateOutputs) {
+  std::unique_ptr<Interpreter> interpreter =
+      BuildChainInterpreter(/*logistic_is_output=*/true);
+  TfLiteDelegateUniquePtr delegate = CreateElementwiseFusionDelegate();
+  ASSERT_EQ(interpreter->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+  ASSERT_EQ(interpreter->execution_plan().size(), 1);
+
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  FillInput(interpreter.get());
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  const float* output = interpreter->typed_output_tensor<float>(0);
+  const float* logistic = interpreter->typed_output_tensor<float>(1);
+  for (int i = 0; i < kNumElements; ++i) {
+    EXPECT_NEAR(output[i], std::tanh(Dequantized(i) / 2), 1e-5) << i;
+    EXPECT_NEAR(logistic[i], 1 / (1 + std::exp(-Dequantized(i))), 1e-5) << i;
+  }
+}
+
+TEST(ElementwiseFusionDelegateTest, LeavesSingleOps) {
+  std::unique_ptr<Interpreter> interpreter(new Interpreter);
+  ASSERT_EQ(interpreter->AddTensors(2), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetOutputs({1}), kTfLiteOk);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(interpreter->SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {4}, TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter->AddNodeWithParameters(
+                {0}, {1}, nullptr, 0, nullptr,
+                ops::builtin::Register_LOGISTIC()),
+            kTfLiteOk);
+  TfLiteDelegateUniquePtr delegate = CreateElementwiseFusionDelegate();
+  ASSERT_EQ(interpreter->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+  ASSERT_EQ(interpreter->execution_plan().size(), 1);
+  const int node_index = interpreter->execution_plan()[0];
+  EXPECT_EQ(interpreter->node_and_registration(node_index)->second.builtin_code,
+            kTfLiteBuiltinLogistic);
+}
+
+}  // namespace
+}  // namespace tflite
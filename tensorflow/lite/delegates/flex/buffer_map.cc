@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/c/c_api_internal.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/typed_allocator.h"
 #include "tensorflow/lite/delegates/flex/util.h"
 #include "tensorflow/lite/string_type.h"
@@ -66,9 +67,8 @@ class TfLiteTensorBuffer : public BaseTfLiteTensorBuffer {
   explicit TfLiteTensorBuffer(const TfLiteTensor* tensor)
       : BaseTfLiteTensorBuffer(tensorflow::cpu_allocator()->AllocateRaw(
             EIGEN_MAX_ALIGN_BYTES, tensor->bytes)) {
-    // TODO(ahentz): if we can guarantee that TF Lite allocated tensors with
-    // the same alignment as TensorFlow (EIGEN_MAX_ALIGN_BYTES), then we can
-    // potentially eliminate the copy below.
+    // Tensors whose data is aligned as TensorFlow expects
+    // (EIGEN_MAX_ALIGN_BYTES) can avoid this copy, see AliasTfLiteTensorBuffer.
     len_ = tensor->bytes;
 
     LogAllocation();
@@ -89,6 +89,27 @@ class TfLiteTensorBuffer : public BaseTfLiteTensorBuffer {
   size_t len_;
 };
 
+// A tensor buffer that aliases the data of a TF Lite tensor, which must be
+// aligned as TensorFlow expects and stay valid while TensorFlow uses it.
+class AliasTfLiteTensorBuffer : public BaseTfLiteTensorBuffer {
+ public:
+  explicit AliasTfLiteTensorBuffer(const TfLiteTensor* tensor)
+      : BaseTfLiteTensorBuffer(tensor->data.raw), len_(tensor->bytes) {}
+
+  size_t size() const override { return len_; }
+
+ private:
+  size_t len_;
+};
+
+// Returns true if the data of 'tensor' can be used by TensorFlow as is.
+bool CanAliasTfLiteTensor(const TfLiteTensor* tensor) {
+  return tensor->type != kTfLiteString && tensor->data.raw != nullptr &&
+         reinterpret_cast<uintptr_t>(tensor->data.raw) %
+                 EIGEN_MAX_ALIGN_BYTES ==
+             0;
+}
+
 // A string buffer. TFLITE string tensor format is different than
 // TF's so we need perform the conversion here.
 class StringTfLiteTensorBuffer : public BaseTfLiteTensorBuffer {
@@ -154,7 +175,8 @@ const tensorflow::Tensor* BufferMap::GetTensorPtr(int tensor_index) const {
   return &tensor;
 }
 
-void BufferMap::SetFromTfLite(int tensor_index, const TfLiteTensor* tensor) {
+void BufferMap::SetFromTfLite(int tensor_index, const TfLiteTensor* tensor,
+                              bool allow_aliasing) {
   tensorflow::TensorShape shape;
   int num_dims = tensor->dims->size;
   for (int i = 0; i < num_dims; ++i) {
@@ -165,7 +187,10 @@ void BufferMap::SetFromTfLite(int tensor_index, const TfLiteTensor* tensor) {
   // be a reallocation after resizing tensors. In that case it would be
   // preferable to somehow reuse the buffer.
   BaseTfLiteTensorBuffer* buf;
-  if (tensor->type == kTfLiteString) {
+  const bool alias = allow_aliasing && CanAliasTfLiteTensor(tensor);
+  if (alias) {
+    buf = new AliasTfLiteTensorBuffer(tensor);
+  } else if (tensor->type == kTfLiteString) {
     buf = new StringTfLiteTensorBuffer(tensor);
   } else {
     buf = new TfLiteTensorBuffer(tensor);
@@ -176,11 +201,26 @@ void BufferMap::SetFromTfLite(int tensor_index, const TfLiteTensor* tensor) {
 
   id_to_tensor_[tensor_index] = std::move(t);
   owned_by_tf_.erase(tensor_index);
+  if (alias) {
+    aliased_.insert(tensor_index);
+  } else {
+    aliased_.erase(tensor_index);
+  }
 }
 
 void BufferMap::SetFromTensorFlow(int tensor_index, tensorflow::Tensor tensor) {
+  // Ops like Identity or Reshape forward the buffers of their inputs to their
+  // outputs, which must not keep aliasing TF Lite memory.
+  for (int aliased_index : aliased_) {
+    if (aliased_index != tensor_index &&
+        tensor.SharesBufferWith(id_to_tensor_.at(aliased_index))) {
+      tensor = tensorflow::tensor::DeepCopy(tensor);
+      break;
+    }
+  }
   id_to_tensor_[tensor_index] = std::move(tensor);
   owned_by_tf_.insert(tensor_index);
+  aliased_.erase(tensor_index);
 }
 
 }  // namespace flex
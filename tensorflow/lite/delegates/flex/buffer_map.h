@@ -58,8 +58,12 @@ class BufferMap {
   void SetFromTensorFlow(int tensor_index, tensorflow::Tensor tensor);
 
   // Same as above but creates a new tensorflow::Tensor with a copy of the
-  // given TfLiteTensor's data.
-  void SetFromTfLite(int tensor_index, const TfLiteTensor* tensor);
+  // given TfLiteTensor's data. If 'allow_aliasing' is true and the data is
+  // suitably aligned, the tensorflow::Tensor uses it without copying instead,
+  // so the TfLiteTensor's buffer must stay valid until the mapping is
+  // replaced. Tensors later set from TensorFlow never share that buffer.
+  void SetFromTfLite(int tensor_index, const TfLiteTensor* tensor,
+                     bool allow_aliasing = false);
 
  private:
   // Mapping from TL Lite tensor ID to TensorFlow's Tensor. All tensors that
@@ -73,6 +77,8 @@ class BufferMap {
   // TensorFlow. This set keeps track of all input or output tensors that have
   // been populated by tensorflow.
   std::set<int> owned_by_tf_;
+  // The tensors set from TF Lite that alias the TfLiteTensor's buffer.
+  std::set<int> aliased_;
 };
 
 }  // namespace flex
@@ -218,6 +218,35 @@ TEST(BufferMapTest, TensorFlowOverwritesTfLite) {
               ElementsAre(0, 0, 0, 0.123f, 0, 0));
 }
 
+TEST(BufferMapTest, SetFromTfLiteWithAliasing) {
+  alignas(EIGEN_MAX_ALIGN_BYTES) float data[6] = {0, 0, 0, 0.123f, 0, 0};
+  TfLiteTensor t = {};
+  t.type = kTfLiteFloat32;
+  t.allocation_type = kTfLiteCustom;
+  t.dims = ConvertVectorToTfLiteIntArray({1, 2, 1, 3});
+  t.data.raw = reinterpret_cast<char*>(data);
+  t.bytes = sizeof(data);
+
+  BufferMap buffer_map;
+  buffer_map.SetFromTfLite(0, &t, /*allow_aliasing=*/true);
+  tensorflow::Tensor aliased = buffer_map.GetTensor(0);
+  EXPECT_EQ(aliased.tensor_data().data(), t.data.raw);
+  EXPECT_THAT(GetTensorData<float>(aliased),
+              ElementsAre(0, 0, 0, 0.123f, 0, 0));
+
+  // A tensor forwarding the aliased buffer is copied when set from TF.
+  buffer_map.SetFromTensorFlow(1, aliased);
+  data[0] = 1;
+  EXPECT_FALSE(buffer_map.GetTensor(1).SharesBufferWith(aliased));
+  EXPECT_THAT(GetTensorData<float>(buffer_map.GetTensor(1)),
+              ElementsAre(0, 0, 0, 0.123f, 0, 0));
+
+  // Without aliasing, the data is copied.
+  buffer_map.SetFromTfLite(0, &t);
+  EXPECT_NE(buffer_map.GetTensor(0).tensor_data().data(), t.data.raw);
+  TfLiteIntArrayFree(t.dims);
+}
+
 }  // namespace
 }  // namespace flex
 }  // namespace tflite
@@ -606,7 +606,9 @@ TfLiteStatus DelegateKernel::Eval(TfLiteContext* context, TfLiteNode* node) {
       // to the BufferMap again, because TF already knows about it and its
       // contents are kept automatically up-to-date.
       if (!buffer_map->IsTensorFlowTensor(tensor_index)) {
-        buffer_map->SetFromTfLite(tensor_index, tensor);
+        // The inputs stay valid during Eval(), so TF can read them in place.
+        buffer_map->SetFromTfLite(tensor_index, tensor,
+                                  /*allow_aliasing=*/true);
       }
     }
   }
@@ -16,12 +16,16 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/delegate.h"
 
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
@@ -69,6 +73,40 @@ InferenceUsage ToUsage(int32_t usage) {
   return InferenceUsage::UNKNOWN;
 }
 
+absl::Status ReadSerializedData(const std::string& path,
+                                std::vector<uint8_t>* data) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return absl::NotFoundError(absl::StrCat("Can not open ", path));
+  }
+  data->resize(file.tellg());
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data->data()), data->size())) {
+    return absl::DataLossError(absl::StrCat("Can not read ", path));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteSerializedData(const std::string& path,
+                                 const std::vector<uint8_t>& data) {
+  // Writes to a temporary file first, so that a concurrent or interrupted run
+  // never leaves a truncated file behind.
+  const std::string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char*>(data.data()),
+                    data.size())) {
+      return absl::UnavailableError(
+          absl::StrCat("Can not write ", temporary_path));
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    return absl::UnavailableError(absl::StrCat("Can not write ", path));
+  }
+  return absl::OkStatus();
+}
+
 // Forward declarations.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
@@ -89,6 +127,11 @@ class Delegate {
     return options_.experimental_flags &
            TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT;
   }
+  bool IsSerializationEnabled() const {
+    return (options_.experimental_flags &
+            TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION) &&
+           options_.serialization_dir && options_.model_token;
+  }
   int MaxDelegatedPartitions() const {
     return options_.max_delegated_partitions;
   }
@@ -130,6 +173,10 @@ class DelegateKernel {
     RETURN_IF_ERROR(InitializeGraph(context, delegate_params, &graph,
                                     &input_refs, &output_refs));
 
+    if (delegate_->IsSerializationEnabled()) {
+      serialization_path_ = GetSerializationPath(delegate_params);
+    }
+
     std::unique_ptr<InferenceBuilder> builder;
     bool graph_is_destroyed;
     const int experimental_flags = delegate_->options().experimental_flags;
@@ -283,12 +330,40 @@ class DelegateKernel {
     return absl::OkStatus();
   }
 
+  // Returns the path prefix of the files caching the inference context of the
+  // partition of `delegate_params`. The partition is named by its nodes, and
+  // the inference options are part of the name, since they change the cached
+  // context.
+  std::string GetSerializationPath(
+      const TfLiteDelegateParams* delegate_params) const {
+    const auto& delegate_options = delegate_->options();
+    const TfLiteIntArray* nodes = delegate_params->nodes_to_replace;
+    return absl::StrCat(
+        delegate_options.serialization_dir, "/", delegate_options.model_token,
+        "_gpu_", nodes->size > 0 ? nodes->data[0] : -1, "_", nodes->size, "_",
+        delegate_options.is_precision_loss_allowed,
+        delegate_options.inference_preference,
+        delegate_options.inference_priority1,
+        delegate_options.inference_priority2,
+        delegate_options.inference_priority3,
+        delegate_->IsQuantOpsAllowed() ? "q" : "");
+  }
+
   absl::Status InitializeOpenClApi(GraphFloat32* graph,
                                    std::unique_ptr<InferenceBuilder>* builder,
                                    bool* graph_is_destroyed) {
     *graph_is_destroyed = false;
     cl::InferenceEnvironmentOptions env_options;
     cl::InferenceEnvironmentProperties properties;
+    // The compiled programs are cached separately from the inference context
+    // since they depend on the driver, whose fingerprint is stored with them,
+    // rather than on the model only.
+    if (!serialization_path_.empty() &&
+        ReadSerializedData(serialization_path_ + "_programs.bin",
+                           &serialized_binary_cache_)
+            .ok()) {
+      env_options.serialized_binary_cache = serialized_binary_cache_;
+    }
     RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
                                                 &properties));
     auto delegate_options = delegate_->options();
@@ -308,6 +383,10 @@ class DelegateKernel {
       }
     }
     options.usage = ToUsage(delegate_options.inference_preference);
+    if (!serialization_path_.empty()) {
+      return InitializeSerializedOpenClApi(options, graph, builder,
+                                           graph_is_destroyed);
+    }
     *graph_is_destroyed = true;
     RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
         options, std::move(*graph), builder));
@@ -316,6 +395,53 @@ class DelegateKernel {
     return absl::OkStatus();
   }
 
+  // Restores the inference context cached at serialization_path_ if there is
+  // one, skipping the operation selection and work group tuning. Otherwise,
+  // builds it from `graph` and caches it for the next runs.
+  absl::Status InitializeSerializedOpenClApi(
+      const cl::InferenceOptions& options, GraphFloat32* graph,
+      std::unique_ptr<InferenceBuilder>* builder, bool* graph_is_destroyed) {
+    const std::string context_path = serialization_path_ + "_context.bin";
+    std::vector<uint8_t> serialized_model;
+    if (ReadSerializedData(context_path, &serialized_model).ok()) {
+      const absl::Status status =
+          cl_environment_->NewInferenceBuilder(serialized_model, builder);
+      if (status.ok()) {
+        TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
+                             "Initialized OpenCL-based API from serialized "
+                             "inference context.");
+        return absl::OkStatus();
+      }
+      // The cached context is stale, e.g. from another version of the
+      // delegate, so it is rebuilt and overwritten below.
+      TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+                 "Can not restore serialized inference context: %s",
+                 std::string(status.message()).c_str());
+    }
+
+    *graph_is_destroyed = true;
+    serialized_model.clear();
+    RETURN_IF_ERROR(cl_environment_->BuildSerializedModel(
+        options, std::move(*graph), &serialized_model));
+    // The programs compiled when building the model are in the program cache
+    // of the environment, so this does not compile them again.
+    RETURN_IF_ERROR(
+        cl_environment_->NewInferenceBuilder(serialized_model, builder));
+    // Failing to cache only makes the next run slower.
+    absl::Status status = WriteSerializedData(context_path, serialized_model);
+    if (status.ok()) {
+      status = WriteSerializedData(serialization_path_ + "_programs.bin",
+                                   cl_environment_->GetSerializedBinaryCache());
+    }
+    if (!status.ok()) {
+      TFLITE_LOG(tflite::TFLITE_LOG_WARNING, "%s",
+                 std::string(status.message()).c_str());
+    }
+    TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
+                         "Initialized OpenCL-based API.");
+    return absl::OkStatus();
+  }
+
   absl::Status InitializeOpenGlApi(GraphFloat32* graph,
                                    std::unique_ptr<InferenceBuilder>* builder) {
 #ifndef CL_DELEGATE_NO_GL
@@ -341,6 +467,11 @@ class DelegateKernel {
   // The Delegate instance that's shared across all DelegateKernel instances.
   Delegate* const delegate_;  // doesn't own the memory.
   std::unique_ptr<cl::InferenceEnvironment> cl_environment_;
+  // Path prefix of the files caching the OpenCL inference context, or empty if
+  // serialization is disabled.
+  std::string serialization_path_;
+  // The environment refers to the cached program binaries while building.
+  std::vector<uint8_t> serialized_binary_cache_;
 #ifndef CL_DELEGATE_NO_GL
   std::unique_ptr<gl::InferenceEnvironment> gl_environment_;
 #endif
@@ -450,6 +581,8 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
       .inference_priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO,
       .experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT,
       .max_delegated_partitions = 1,
+      .serialization_dir = nullptr,
+      .model_token = nullptr,
   };
   return options;
 }
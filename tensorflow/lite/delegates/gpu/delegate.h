@@ -55,7 +55,12 @@ enum TfLiteGpuExperimentalFlags {
   TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT = 1 << 0,
   // Enforces execution with the provided backend.
   TFLITE_GPU_EXPERIMENTAL_FLAGS_CL_ONLY = 1 << 1,
-  TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY = 1 << 2
+  TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY = 1 << 2,
+  // Enables caching of the OpenCL inference context, i.e. the selected
+  // operations, tuned work groups, tensor storage plans and compiled programs,
+  // in serialization_dir. Ignored unless serialization_dir and model_token are
+  // set.
+  TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION = 1 << 3
 };
 
 // IMPORTANT: Always use TfLiteGpuDelegateOptionsV2Default() method to create
@@ -101,6 +106,18 @@ typedef struct {
   // This limits the maximum number of partitions to be delegated. By default,
   // it's set to 1 in TfLiteGpuDelegateOptionsV2Default().
   int32_t max_delegated_partitions;
+
+  // With TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION, the directory in
+  // which the OpenCL inference contexts are cached, so that later runs skip
+  // building and tuning the model. The directory should be private to the
+  // app, e.g. its cache directory, and must already exist.
+  const char* serialization_dir;
+
+  // With TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION, a token naming
+  // the model in serialization_dir. The cached data is not validated against
+  // the model, so the token must change whenever the model does, e.g. by
+  // including a fingerprint of the model file.
+  const char* model_token;
 } TfLiteGpuDelegateOptionsV2;
 
 // Populates TfLiteGpuDelegateOptionsV2 as follows:
@@ -111,6 +128,8 @@ typedef struct {
 //   priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO
 //   experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT
 //   max_delegated_partitions = 1
+//   serialization_dir = nullptr
+//   model_token = nullptr
 TFL_CAPI_EXPORT TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default();
 
 // Creates a new delegate instance that need to be destroyed with
@@ -505,6 +505,74 @@ uint64_t GetHash(const TfLiteIntArray* int_array) {
   return result;
 }
 
+// Mixes the bytes of `data` into the hash `seed`, eight at a time.
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+  constexpr auto kHashConst = 0x9e3779b97f4a7800ULL;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t result = seed;
+  for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, bytes + offset, std::min(sizeof(word), size - offset));
+    result = result ^ (word + kHashConst + (result << 10) + (result >> 4));
+  }
+  return result;
+}
+
+// Compute the hash of the content of the nodes in `node_indices`: their
+// operators and the types, shapes, quantization and, for the constant ones,
+// the data of their tensors. Used as the model part of the compilation cache
+// token when the user didn't provide one, so that the token only changes
+// with the model.
+uint64_t GetNodesContentHash(TfLiteContext* context,
+                             const TfLiteIntArray* node_indices) {
+  uint64_t result = GetHash(node_indices);
+  auto hash_tensors = [context, &result](const TfLiteIntArray* tensors) {
+    result = HashBytes(tensors->data, tensors->size * sizeof(int), result);
+    for (int tensor_index : TfLiteIntArrayView(tensors)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      result = HashBytes(&tensor.type, sizeof(tensor.type), result);
+      result = HashBytes(&tensor.params, sizeof(tensor.params), result);
+      if (tensor.dims != nullptr) {
+        result = HashBytes(tensor.dims->data, tensor.dims->size * sizeof(int),
+                           result);
+      }
+      if (tensor.quantization.type == kTfLiteAffineQuantization) {
+        const auto* params = static_cast<const TfLiteAffineQuantization*>(
+            tensor.quantization.params);
+        result = HashBytes(params->scale->data,
+                           params->scale->size * sizeof(float), result);
+        result = HashBytes(params->zero_point->data,
+                           params->zero_point->size * sizeof(int), result);
+      }
+      if (tensor.allocation_type == kTfLiteMmapRo) {
+        result = HashBytes(tensor.data.raw, tensor.bytes, result);
+      }
+    }
+  };
+  for (int node_index : TfLiteIntArrayView(node_indices)) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    if (context->GetNodeAndRegistration(context, node_index, &node,
+                                        &registration) != kTfLiteOk) {
+      continue;
+    }
+    result = HashBytes(&registration->builtin_code,
+                       sizeof(registration->builtin_code), result);
+    result = HashBytes(&registration->version, sizeof(registration->version),
+                       result);
+    if (registration->custom_name != nullptr) {
+      result = HashBytes(registration->custom_name,
+                         strlen(registration->custom_name), result);
+    }
+    result = HashBytes(node->custom_initial_data,
+                       node->custom_initial_data_size, result);
+    hash_tensors(node->inputs);
+    hash_tensors(node->outputs);
+  }
+  return result;
+}
+
 bool HasZeroes(TfLiteIntArrayView array) {
   for (auto value : array) {
     if (value == 0) {
@@ -3511,14 +3579,16 @@ TfLiteStatus NNAPIDelegateKernel::Init(TfLiteContext* context,
   nn_compilation_cache_token_.clear();
   const char* cache_dir = delegate_options.cache_dir;
   const char* model_token = delegate_options.model_token;
-  if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 && cache_dir &&
-      model_token) {
+  if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 && cache_dir) {
     // Compilation caching could be enabled, try construct the uint8
     // token.
     // TODO(b/133342794): use a generic token generator class.
     uint64_t token_parts[4];
-    // bits from model_token.
-    token_parts[0] = std::hash<std::string>{}(model_token);
+    // bits from model_token, or from the content of the delegated nodes.
+    token_parts[0] =
+        model_token
+            ? std::hash<std::string>{}(model_token)
+            : GetNodesContentHash(context, params->nodes_to_replace);
     // bits from params->nodes_to_replace.
     token_parts[1] = GetHash(params->nodes_to_replace);
     // bits from params->input_tensors.
@@ -3728,6 +3798,8 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
       }
     }
     if (total_input_byte_size > nn_input_memory_->get_byte_size()) {
+      // The burst might keep the memory pool being replaced.
+      nn_burst_.reset();
       nn_input_memory_.reset(
           new NNMemory(nnapi_, "input_pool", total_input_byte_size));
     }
@@ -3741,6 +3813,7 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
       total_output_byte_size += getNumPaddingBytes(context->tensors[i].bytes);
     }
     if (total_output_byte_size > nn_output_memory_->get_byte_size()) {
+      nn_burst_.reset();
       nn_output_memory_.reset(
           new NNMemory(nnapi_, "output_pool", total_output_byte_size));
     }
@@ -3925,6 +3998,23 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
     RETURN_TFLITE_ERROR_IF_NN_ERROR(context, wait_result,
                                     "waiting for async computation completion",
                                     nnapi_errno);
+  } else if (delegate_options.use_burst_computation &&
+             nnapi_->ANeuralNetworksBurst_create != nullptr) {
+    // Run the executions through a burst, created with the first one, so that
+    // the driver can reuse their resources, including the memory pools.
+    if (!nn_burst_) {
+      ANeuralNetworksBurst* burst = nullptr;
+      RETURN_TFLITE_ERROR_IF_NN_ERROR(
+          context,
+          nnapi_->ANeuralNetworksBurst_create(nn_compilation_.get(), &burst),
+          "creating NNAPI burst", nnapi_errno);
+      nn_burst_.reset(burst);
+    }
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(
+        context,
+        nnapi_->ANeuralNetworksExecution_burstCompute(execution,
+                                                      nn_burst_.get()),
+        "running burst computation", nnapi_errno);
   } else {
     // Use synchronous execution for NNAPI 1.2+.
     RETURN_TFLITE_ERROR_IF_NN_ERROR(
@@ -4586,6 +4676,7 @@ StatefulNnApiDelegate::StatefulNnApiDelegate(const NnApi* nnapi,
   if (nnapi->android_sdk_version >= kMinSdkVersionForNNAPI11) {
     delegate_data_.allow_dynamic_dimensions = options.allow_dynamic_dimensions;
   }
+  delegate_data_.use_burst_computation = options.use_burst_computation;
   TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                        "Created TensorFlow Lite delegate for NNAPI.");
   Prepare = DoPrepare;
@@ -4628,6 +4719,7 @@ const StatefulNnApiDelegate::Options StatefulNnApiDelegate::GetOptions(
   options.max_execution_loop_timeout_duration_ns =
       delegate_data->max_execution_loop_timeout_duration_ns;
   options.allow_dynamic_dimensions = delegate_data->allow_dynamic_dimensions;
+  options.use_burst_computation = delegate_data->use_burst_computation;
   return options;
 }
 
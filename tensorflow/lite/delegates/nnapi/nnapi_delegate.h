@@ -68,9 +68,11 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     const char* cache_dir = nullptr;
 
     // The unique nul-terminated token string for NNAPI model.
-    // Default to nullptr, which implies the NNAPI will not try caching the
-    // compilation. It is the caller's responsibility to ensure there is no
-    // clash of the tokens.
+    // Default to nullptr, which implies that, if cache_dir is set, the token
+    // is derived from a hash of the content of the delegated nodes: their
+    // operators, the types, shapes and quantization of their tensors and the
+    // data of their constant tensors. It is the caller's responsibility to
+    // ensure there is no clash of the tokens.
     // NOTE: when using compilation caching, it is not recommended to use the
     // same delegate instance for multiple models.
     const char* model_token = nullptr;
@@ -125,6 +127,12 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // accelerator. This should only be enabled if the target device supports
     // dynamic dimensions of the model.
     bool allow_dynamic_dimensions = false;
+
+    // Whether to run the executions through an NNAPI burst object, which
+    // lets the driver reuse the resources of the previous executions, such as
+    // the memory pools of the inputs and outputs. Only effective on Android 10
+    // and above.
+    bool use_burst_computation = true;
   };
 
   // Uses default options.
@@ -235,6 +243,8 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     uint64_t max_execution_loop_timeout_duration_ns = 0;
     // Whether to allow dynamic dimension sizes without re-compilation.
     bool allow_dynamic_dimensions = false;
+    // Whether to run the executions through an NNAPI burst object.
+    bool use_burst_computation = true;
 
     explicit Data(const NnApi* nnapi);
     ~Data();
@@ -127,6 +127,22 @@ TEST_F(NnApiErrnoTest, HasTheStatusOfTheNnApiCallFailedCallingInvoke) {
   EXPECT_EQ(m.GetDelegate()->GetNnApiErrno(), -4);
 }
 
+TEST_F(NnApiErrnoTest, HasTheStatusOfTheBurstComputationFailedCallingInvoke) {
+  nnapi_mock_->BurstCreateReturns<0>();
+  nnapi_mock_->ExecutionBurstComputeReturns<6>();
+
+  FloatAddOpModel m(nnapi_mock_->GetNnApi(), {TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {}}, ActivationFunctionType_NONE);
+
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+
+  // The executions run through the burst when it is available.
+  EXPECT_EQ(m.InvokeUnchecked(), kTfLiteError);
+  EXPECT_EQ(m.GetDelegate()->GetNnApiErrno(), 6);
+}
+
 TEST_F(NnApiErrnoTest, ErrnoIsResetWhenRestoringDelegateForModel) {
   nnapi_mock_->ModelFinishReturns<-4>();
 
@@ -155,6 +155,19 @@ class NNFreeExecution {
   const NnApi* nnapi_;
 };
 
+// RAII NN API Burst Destructor for use with std::unique_ptr
+class NNFreeBurst {
+ public:
+  explicit NNFreeBurst(const NnApi* nnapi) : nnapi_(nnapi) {}
+  void operator()(ANeuralNetworksBurst* burst) {
+    nnapi_->ANeuralNetworksBurst_free(burst);
+  }
+
+ private:
+  // NnApi instance to use. Not owned by this object.
+  const NnApi* nnapi_;
+};
+
 // Manage NNAPI shared memory handle
 class NNMemory {
  public:
@@ -249,7 +262,8 @@ class NNAPIDelegateKernel {
       : initialised_(false),
         nnapi_(nnapi),
         nn_model_(nullptr, NNFreeModel(nnapi_)),
-        nn_compilation_(nullptr, NNFreeCompilation(nnapi_)) {}
+        nn_compilation_(nullptr, NNFreeCompilation(nnapi_)),
+        nn_burst_(nullptr, NNFreeBurst(nnapi_)) {}
   NNAPIDelegateKernel() : NNAPIDelegateKernel(NnApiImplementation()) {}
   ~NNAPIDelegateKernel() {
     for (auto content : allocation_memory_mapping_) {
@@ -342,6 +356,9 @@ class NNAPIDelegateKernel {
 
   std::unique_ptr<NNMemory> nn_input_memory_;
   std::unique_ptr<NNMemory> nn_output_memory_;
+  // The burst of the executions, created with the first one when used. It is
+  // declared after the memory pools so that it is freed before them.
+  std::unique_ptr<ANeuralNetworksBurst, NNFreeBurst> nn_burst_;
 
   std::vector<uint8_t> nn_compilation_cache_token_;
 
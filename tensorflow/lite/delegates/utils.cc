@@ -46,6 +46,59 @@ TfLiteStatus CreateNewTensorWithDifferentType(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+namespace {
+
+// Returns the bytes of the tensors of `tensor_indices`, without the constant
+// ones if `skip_constants` is true.
+size_t GetTensorBytes(const TfLiteContext* context,
+                      const TfLiteIntArray* tensor_indices,
+                      bool skip_constants) {
+  if (tensor_indices == nullptr) return 0;
+  size_t bytes = 0;
+  for (int tensor_index : TfLiteIntArrayView(tensor_indices)) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    if (skip_constants && tensor.allocation_type == kTfLiteMmapRo) continue;
+    bytes += tensor.bytes;
+  }
+  return bytes;
+}
+
+}  // namespace
+
+bool IsPartitionProfitable(TfLiteContext* context,
+                           const TfLiteDelegateParams& partition,
+                           const PartitionCostModel& cost_model) {
+  double cpu_seconds = 0;
+  for (int node_index : TfLiteIntArrayView(partition.nodes_to_replace)) {
+    if (cost_model.node_cpu_seconds) {
+      cpu_seconds += cost_model.node_cpu_seconds(context, node_index);
+      continue;
+    }
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    if (context->GetNodeAndRegistration(context, node_index, &node,
+                                        &registration) != kTfLiteOk) {
+      return false;
+    }
+    const size_t bytes =
+        GetTensorBytes(context, node->inputs, /*skip_constants=*/false) +
+        GetTensorBytes(context, node->outputs, /*skip_constants=*/false);
+    cpu_seconds += bytes / cost_model.cpu_bytes_per_second;
+  }
+  // Constant inputs are copied to the delegate once when it is prepared.
+  const size_t transfer_bytes =
+      GetTensorBytes(context, partition.input_tensors,
+                     /*skip_constants=*/true) +
+      GetTensorBytes(context, partition.output_tensors,
+                     /*skip_constants=*/true);
+  const double delegate_seconds =
+      cpu_seconds / cost_model.delegate_speedup +
+      transfer_bytes / cost_model.transfer_bytes_per_second +
+      cost_model.partition_overhead_seconds;
+  return delegate_seconds < cpu_seconds;
+}
+
 TfLiteStatus GraphPartitionHelper::Partition(
     std::set<std::string>* unsupported_nodes_info) {
   const auto prepare_status = PrepareSupportedNodes(unsupported_nodes_info);
@@ -83,13 +136,14 @@ GraphPartitionHelper::GetFirstNLargestPartitions(
             });
 
   std::vector<TfLiteDelegateParams*> results;
-  auto p_it = sorted_partitions.begin();
-  const int total = sorted_partitions.size();
-  for (int i = 0; i < std::min(total, n); ++i, ++p_it) {
-    auto* p = (*p_it);
-    if (p->nodes_to_replace->size < min_nodes_per_partition) {
+  for (auto* p : sorted_partitions) {
+    if (static_cast<int>(results.size()) >= n ||
+        p->nodes_to_replace->size < min_nodes_per_partition) {
       break;
     }
+    if (cost_model_ && !IsPartitionProfitable(context_, *p, *cost_model_)) {
+      continue;
+    }
     results.push_back(p);
   }
   return results;
@@ -45,6 +45,38 @@ using IsNodeSupportedFn =
     std::function<bool(TfLiteContext*, TfLiteNode*, TfLiteRegistration*,
                        std::string* unsupported_details)>;
 
+// A cost model deciding whether a partition runs faster on a delegate than on
+// the CPU. A small partition surrounded by CPU nodes may not be worth
+// delegating, since its inputs and outputs are copied between the CPU and the
+// delegate on each invocation.
+struct PartitionCostModel {
+  // Returns the CPU time of node `node_index` in seconds, e.g. as measured
+  // with the tools in lite/profiling. When unset, it is estimated as the time
+  // to read the inputs and write the outputs of the node at
+  // `cpu_bytes_per_second`.
+  std::function<double(TfLiteContext* context, int node_index)>
+      node_cpu_seconds;
+  double cpu_bytes_per_second = 1e10;
+
+  // The ratio of the CPU time of a node to its time on the delegate.
+  double delegate_speedup = 4.0;
+
+  // The bandwidth of the copies of the non-constant partition inputs and
+  // outputs between the CPU and the delegate.
+  double transfer_bytes_per_second = 1e9;
+
+  // The fixed cost of invoking a delegated partition, e.g. launching and
+  // waiting for its kernels.
+  double partition_overhead_seconds = 1e-4;
+};
+
+// Returns whether `cost_model` estimates that `partition` runs faster on the
+// delegate, including the transfers of its inputs and outputs, than on the
+// CPU.
+bool IsPartitionProfitable(TfLiteContext* context,
+                           const TfLiteDelegateParams& partition,
+                           const PartitionCostModel& cost_model);
+
 // A utility class to help model graph parition.
 // Note the class *needs* to be used in TfLiteDelegate::Prepare.
 class GraphPartitionHelper {
@@ -70,6 +102,8 @@ class GraphPartitionHelper {
 
   // Returns the first n largest partitions or all if #partitions is less than
   // 'n' and each parition has at least (>=) 'min_nodes_per_partition' nodes.
+  // If a cost model is set, the partitions it estimates to be faster on the
+  // CPU are left out.
   // Note that partitions are ranked according to the number of nodes that
   // a partition has, and the returned TfLiteDelegateParams objects are *owned*
   // by the TfLite runtime.
@@ -91,6 +125,12 @@ class GraphPartitionHelper {
   int num_total_nodes() const { return num_total_nodes_; }
   int num_partitions() const { return partitions_.size(); }
 
+  // Sets the cost model used to decline unprofitable partitions, or nullptr to
+  // keep all of them. The model must outlive the helper.
+  void set_cost_model(const PartitionCostModel* cost_model) {
+    cost_model_ = cost_model;
+  }
+
  protected:
   virtual bool IsNodeSupported(TfLiteContext* context, TfLiteNode* node,
                                TfLiteRegistration* registration, int node_id,
@@ -108,6 +148,8 @@ class GraphPartitionHelper {
   // TfLiteContext::PreviewDelegatePartitioning for details.
   std::vector<TfLiteDelegateParams*> partitions_;
 
+  const PartitionCostModel* cost_model_ = nullptr;  // not owned
+
  private:
   // Generate a list of supported nodes (i.e. populating 'supported_nodes_') by
   // iterating over all nodes (i,e. those listed in the execution_plan
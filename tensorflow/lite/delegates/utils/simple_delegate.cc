@@ -93,6 +93,9 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context,
   // TODO(b/149484598): Update to have method that gets all supported nodes.
   delegates::GraphPartitionHelper helper(context, node_supported_fn);
   TF_LITE_ENSURE_STATUS(helper.Partition(nullptr));
+  if (delegate_options.decline_unprofitable_partitions) {
+    helper.set_cost_model(&delegate_options.partition_cost_model);
+  }
 
   std::vector<int> supported_nodes = helper.GetNodesOfFirstNLargestPartitions(
       delegate_options.max_delegated_partitions,
@@ -32,6 +32,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/utils.h"
 
 namespace tflite {
 
@@ -78,6 +79,12 @@ class SimpleDelegateInterface {
     // The minimum number of nodes allowed in a delegated graph, values <=0
     // means unlimited.
     int min_nodes_per_partition = 0;
+
+    // Whether to decline the partitions that 'partition_cost_model' estimates
+    // to be faster on the CPU, e.g. small partitions whose inputs and outputs
+    // take longer to copy to and from the delegate than to compute.
+    bool decline_unprofitable_partitions = false;
+    delegates::PartitionCostModel partition_cost_model;
   };
 
   virtual ~SimpleDelegateInterface() {}
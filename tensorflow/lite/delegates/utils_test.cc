@@ -250,6 +250,45 @@ TEST(GraphPartitionHelper, CheckPartitionsWithSupportedNodeList) {
   EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
 }
 
+TEST(GraphPartitionHelper, CheckPartitionsWithCostModel) {
+  // The mocked TfLiteContext has 4 partitions: {1}, {0,3,7,8}, {2,4,9}, {5,6}.
+  MockTfLiteContext mocked_context;
+  GraphPartitionHelper helper(&mocked_context, IsNodeSupported);
+  EXPECT_EQ(kTfLiteOk, helper.Partition(nullptr));
+
+  // Each node takes 1ms on the CPU and 0.5ms on the delegate, and invoking a
+  // partition takes 1.2ms more, so only partitions of 3 nodes or more are
+  // faster on the delegate.
+  PartitionCostModel cost_model;
+  cost_model.node_cpu_seconds = [](TfLiteContext*, int) { return 1e-3; };
+  cost_model.delegate_speedup = 2.0;
+  cost_model.partition_overhead_seconds = 1.2e-3;
+  EXPECT_TRUE(IsPartitionProfitable(&mocked_context,
+                                    mocked_context.delegate_params()[1],
+                                    cost_model));
+  EXPECT_FALSE(IsPartitionProfitable(&mocked_context,
+                                     mocked_context.delegate_params()[3],
+                                     cost_model));
+
+  helper.set_cost_model(&cost_model);
+  auto partitions = helper.GetFirstNLargestPartitions();
+  EXPECT_EQ(2, partitions.size());
+  auto nodes = GetNodesToReplaceFromPartitions(partitions);
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
+
+  // Declined partitions don't count towards the partitions to return: with
+  // the nodes of {0,3,7,8} taking 0.1ms, {2,4,9} is the largest one left.
+  cost_model.node_cpu_seconds = [](TfLiteContext*, int node_index) {
+    const bool is_fast = node_index == 0 || node_index == 3 ||
+                         node_index == 7 || node_index == 8;
+    return is_fast ? 1e-4 : 1e-3;
+  };
+  nodes = helper.GetNodesOfFirstNLargestPartitions(1);
+  EXPECT_THAT(nodes, testing::ElementsAreArray({2, 4, 9}));
+  cost_model.partition_overhead_seconds = 2.5e-3;
+  EXPECT_TRUE(helper.GetNodesOfFirstNLargestPartitions().empty());
+}
+
 }  // namespace
 }  // namespace delegates
 }  // namespace tflite
@@ -0,0 +1,94 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+
+namespace tflite {
+namespace xnnpack {
+
+TEST(ResizeInputs, KeepsDelegation) {
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      xnnpack_delegate(TfLiteXNNPackDelegateCreate(nullptr),
+                       TfLiteXNNPackDelegateDelete);
+
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(3), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2}), kTfLiteOk);
+  for (int t = 0; t < 3; t++) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(
+                  t, kTfLiteFloat32, "", {1, 2, 2, 3},
+                  TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  auto* add_params =
+      static_cast<TfLiteAddParams*>(calloc(1, sizeof(TfLiteAddParams)));
+  add_params->activation = kTfLiteActNone;
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {0, 1}, {2}, nullptr, 0, add_params,
+                ::tflite::ops::builtin::Register_ADD()),
+            kTfLiteOk);
+
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter.ModifyGraphWithDelegate(xnnpack_delegate.get()),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.execution_plan().size(), 1);
+  const int delegate_node_index = interpreter.execution_plan()[0];
+
+  const std::vector<std::vector<int>> shapes = {
+      {2, 5, 3, 3}, {1, 2, 2, 3}, {3, 1, 4, 3}};
+  for (const std::vector<int>& shape : shapes) {
+    ASSERT_EQ(interpreter.ResizeInputTensor(0, shape), kTfLiteOk);
+    ASSERT_EQ(interpreter.ResizeInputTensor(1, shape), kTfLiteOk);
+    ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+    // The delegate kernel is kept rather than recreated by a new delegation.
+    ASSERT_EQ(interpreter.execution_plan().size(), 1);
+    EXPECT_EQ(interpreter.execution_plan()[0], delegate_node_index);
+
+    const TfLiteTensor* output = interpreter.tensor(2);
+    ASSERT_EQ(output->dims->size, shape.size());
+    int size = 1;
+    for (int i = 0; i < shape.size(); i++) {
+      EXPECT_EQ(output->dims->data[i], shape[i]);
+      size *= shape[i];
+    }
+
+    float* input1_data = interpreter.typed_tensor<float>(0);
+    float* input2_data = interpreter.typed_tensor<float>(1);
+    for (int i = 0; i < size; i++) {
+      input1_data[i] = static_cast<float>(i);
+      input2_data[i] = 0.5f * static_cast<float>(i);
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+
+    const float* output_data = interpreter.typed_tensor<float>(2);
+    for (int i = 0; i < size; i++) {
+      EXPECT_EQ(output_data[i], 1.5f * static_cast<float>(i));
+    }
+  }
+}
+
+}  // namespace xnnpack
+}  // namespace tflite
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 namespace xnnpack {
@@ -75,7 +76,8 @@ class Delegate {
       nullptr,                        // .CopyFromBufferHandle
       nullptr,                        // .CopyToBufferHandle
       nullptr,                        // .FreeBufferHandle
-      kTfLiteDelegateFlagsNone,       // .flags
+      kTfLiteDelegateFlagsAllowDynamicTensors |
+          kTfLiteDelegateFlagsRequirePropagatedShapes,  // .flags
   };
 
   // Unpacked data for quasi-static tensors, i.e. tensors produced by
@@ -101,177 +103,40 @@ class Subgraph {
   static Subgraph* Create(TfLiteContext* context,
                           const TfLiteDelegateParams* params,
                           const Delegate* delegate) {
-    // Convert subgraph inputs and outputs to hash sets for faster lookup.
-    const std::unordered_set<int> inputs(
-        &params->input_tensors->data[0],
-        &params->input_tensors->data[params->input_tensors->size]);
-    std::unordered_set<int> outputs;
-    for (int o = 0; o < params->output_tensors->size; o++) {
-      const int output_tensor_idx = params->output_tensors->data[o];
-      // Exclude quasi-static tensors which may have become subgraph outputs
-      // after partitioning.
-      if (delegate->static_unpacked_data_map_.count(output_tensor_idx) == 0) {
-        outputs.insert(output_tensor_idx);
-      }
-    }
-    std::unordered_set<int> externals(outputs);
-
-    TfLiteIntArray* execution_plan;
-    if (context->GetExecutionPlan(context, &execution_plan) != kTfLiteOk) {
-      return nullptr;
-    }
-
-    xnn_subgraph_t subgraph_ptr = nullptr;
-    xnn_status status = xnn_create_subgraph(
-        /*external_value_ids=*/context->tensors_size, /*flags=*/0,
-        &subgraph_ptr);
-    if (status != xnn_status_success) {
-      TF_LITE_KERNEL_LOG(context, "failed to create XNNPACK subgraph");
-      return nullptr;
-    }
-
-    // Smart pointer to automatically release subgraph on exit.
-    std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> subgraph(
-        subgraph_ptr, &xnn_delete_subgraph);
-
-    // Detect which tensors are used as inputs or outputs of any subgraph nodes.
-    // -1 denotes tensor not used in the subgraph. These indexes will be
-    // filtered out and removed later.
-    std::vector<int> tensors(context->tensors_size, -1);
-    for (int i = 0; i < params->nodes_to_replace->size; i++) {
-      const int node_index = params->nodes_to_replace->data[i];
-      if (delegate->static_unpack_nodes_.count(node_index)) {
-        // The node unpacks static input and can be skipped because its input
-        // was pre-unpacked in DelegatePrepare.
-        continue;
-      }
-
-      TfLiteNode* node = nullptr;
-      TfLiteRegistration* registration = nullptr;
-      if (context->GetNodeAndRegistration(context, node_index, &node,
-                                          &registration) != kTfLiteOk) {
-        return nullptr;
-      }
-
-      switch (registration->builtin_code) {
-        case kTfLiteBuiltinMean:
-        case kTfLiteBuiltinPad:
-        case kTfLiteBuiltinReshape:
-        case kTfLiteBuiltinResizeBilinear:
-          // Ignore the second input (axes, static padding, or new shape),
-          // because it is represented as parameters of the XNNPACK operator
-          // rather than extra input.
-          {
-            const int t = node->inputs->data[0];
-            tensors[t] = t;
-          }
-          break;
-        default:
-          // All other operators: process all inputs
-          for (int k = 0; k < node->inputs->size; k++) {
-            const int t = node->inputs->data[k];
-            tensors[t] = t;
-          }
-      }
-      for (int k = 0; k < node->outputs->size; k++) {
-        const int t = node->outputs->data[k];
-        tensors[t] = t;
-      }
-    }
-    // Filter out and remove -1 (unused) indexes.
-    tensors.erase(std::remove_if(tensors.begin(), tensors.end(),
-                                 [](int i) { return i < 0; }),
-                  tensors.end());
-    std::sort(tensors.begin(), tensors.end());
-
-    // XNNPACK Value IDs for TFLite tensors
-    std::vector<uint32_t> xnnpack_tensors(tensors.back() + 1);
-    for (int t : tensors) {
-      if (context->tensors[t].type != kTfLiteFloat32) {
-        TF_LITE_KERNEL_LOG(
-            context,
-            "unsupported datatype (%s) of tensor %d in XNNPACK delegate",
-            TfLiteTypeGetName(context->tensors[t].type), t);
-        return nullptr;
-      }
-
-      uint32_t flags = 0;
-      const void* data = nullptr;
-      if (context->tensors[t].allocation_type == kTfLiteMmapRo) {
-        data = context->tensors[t].data.raw_const;
-      } else {
-        // Check for quasi-static data.
-        const auto it = delegate->static_unpacked_data_map_.find(t);
-        if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
-        }
-      }
-      if (inputs.count(t) != 0) {
-        flags |= XNN_VALUE_FLAG_EXTERNAL_INPUT;
-        if (data == nullptr) {
-          externals.insert(t);
-        }
-      }
-      if (outputs.count(t) != 0) {
-        flags |= XNN_VALUE_FLAG_EXTERNAL_OUTPUT;
-      }
-
-      std::vector<size_t> dims(
-          &context->tensors[t].dims->data[0],
-          &context->tensors[t].dims->data[context->tensors[t].dims->size]);
-
-      const xnn_status status = xnn_define_tensor_value(
-          subgraph.get(), xnn_datatype_fp32, dims.size(), dims.data(), data,
-          static_cast<uint32_t>(t), flags, &xnnpack_tensors[t]);
-      if (status != xnn_status_success) {
+    return new Subgraph(params, delegate);
+  }
+
+  TfLiteStatus Prepare(TfLiteContext* context) {
+    // The XNNPACK runtime is specialized for the shapes of the tensors it is
+    // created with. The delegate requires propagated shapes, so by the time
+    // the delegate kernel is prepared the builtin kernels of the delegated
+    // nodes have computed the shapes of all tensors in the subgraph, and the
+    // runtime is (re)created with them when the subgraph inputs were resized,
+    // without undoing the delegation.
+    bool inputs_resized = runtime_ == nullptr;
+    for (const auto& input : input_dims_) {
+      const TfLiteTensor& tensor = context->tensors[input.first];
+      if (tensor.allocation_type == kTfLiteDynamic) {
         TF_LITE_KERNEL_LOG(context,
-                           "failed to create XNNPACK Value for tensor %d", t);
-        return nullptr;
-      }
-    }
-
-    // Create a set of quasi-static tensors for VisitNode function
-    std::unordered_set<int> quasi_static_tensors;
-    for (const std::pair<const int, size_t>& entry :
-         delegate->static_unpacked_data_map_) {
-      quasi_static_tensors.insert(entry.first);
-    }
-
-    // Create XNNPACK nodes for TFLite delegate nodes
-    for (int i = 0; i < params->nodes_to_replace->size; i++) {
-      const int node_index = params->nodes_to_replace->data[i];
-      if (delegate->static_unpack_nodes_.count(node_index)) {
-        // The node unpacks static input and can be skipped because its input
-        // was pre-unpacked in DelegatePrepare.
-        continue;
-      }
-
-      TfLiteNode* node = nullptr;
-      TfLiteRegistration* registration = nullptr;
-      if (context->GetNodeAndRegistration(context, node_index, &node,
-                                          &registration) != kTfLiteOk) {
-        return nullptr;
+                           "unsupported dynamic tensor %d in XNNPACK delegate",
+                           input.first);
+        return kTfLiteError;
       }
-
-      if (VisitNode(subgraph.get(), context, registration, node, node_index,
-                    quasi_static_tensors, xnnpack_tensors) != kTfLiteOk) {
-        return nullptr;
+      if (!EqualArrayAndTfLiteIntArray(tensor.dims, input.second.size(),
+                                       input.second.data())) {
+        inputs_resized = true;
       }
     }
-
-    xnn_runtime_t runtime_ptr = nullptr;
-    status = xnn_create_runtime_v2(subgraph.get(), delegate->threadpool(),
-                                   /*flags=*/0, &runtime_ptr);
-    if (status != xnn_status_success) {
-      TF_LITE_KERNEL_LOG(context, "failed to create XNNPACK runtime");
-      return nullptr;
+    if (inputs_resized) {
+      TF_LITE_ENSURE_STATUS(CreateRuntime(context));
     }
 
-    return new Subgraph(runtime_ptr, std::move(externals));
+    // Tensors may have been reallocated, so the runtime is set up again with
+    // their data pointers on the next invocation.
+    first_run_ = true;
+    return kTfLiteOk;
   }
 
-  TfLiteStatus Prepare(TfLiteContext* context) { return kTfLiteOk; }
-
   TfLiteStatus Invoke(TfLiteContext* context) {
     if (first_run_) {
       std::vector<xnn_external_value> external_values;
@@ -625,6 +490,163 @@ class Subgraph {
                            node_index);
   }
 
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+  // Returns the XNNPACK datatype of an INT8 or INT32 tensor with per-tensor or
+  // per-channel affine quantization, or xnn_datatype_invalid if XNNPACK does
+  // not support its quantization.
+  static xnn_datatype GetQuantizedDatatype(const TfLiteTensor& tensor) {
+    if (tensor.quantization.type != kTfLiteAffineQuantization) {
+      return xnn_datatype_invalid;
+    }
+    const auto* quantization_params =
+        static_cast<const TfLiteAffineQuantization*>(
+            tensor.quantization.params);
+    if (quantization_params == nullptr ||
+        quantization_params->scale == nullptr ||
+        quantization_params->zero_point == nullptr ||
+        quantization_params->scale->size !=
+            quantization_params->zero_point->size) {
+      return xnn_datatype_invalid;
+    }
+    const bool is_int8 = tensor.type == kTfLiteInt8;
+    if (quantization_params->scale->size == 1) {
+      return is_int8 ? xnn_datatype_qint8 : xnn_datatype_qint32;
+    }
+    const int quantized_dimension = quantization_params->quantized_dimension;
+    if (quantized_dimension < 0 || quantized_dimension >= tensor.dims->size ||
+        quantization_params->scale->size !=
+            tensor.dims->data[quantized_dimension]) {
+      return xnn_datatype_invalid;
+    }
+    // Per-channel quantization is supported only for symmetric weights and
+    // biases.
+    for (int i = 0; i < quantization_params->zero_point->size; i++) {
+      if (quantization_params->zero_point->data[i] != 0) {
+        return xnn_datatype_invalid;
+      }
+    }
+    return is_int8 ? xnn_datatype_qcint8 : xnn_datatype_qcint32;
+  }
+
+  static const TfLiteAffineQuantization& GetAffineQuantization(
+      const TfLiteTensor& tensor) {
+    return *static_cast<const TfLiteAffineQuantization*>(
+        tensor.quantization.params);
+  }
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+
+  // Checks that the tensor is FP32, or, in builds with QS8 support, INT8 with
+  // per-tensor quantization, as XNNPACK supports for activations.
+  static TfLiteStatus CheckTensorFloat32OrQInt8Type(TfLiteContext* context,
+                                                    const TfLiteTensor& tensor,
+                                                    int tensor_index,
+                                                    int node_index) {
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+    if (tensor.type == kTfLiteInt8) {
+      if (GetQuantizedDatatype(tensor) != xnn_datatype_qint8) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            context,
+            "unsupported quantization in INT8 tensor #%d in node #%d: "
+            "per-tensor affine quantization expected",
+            tensor_index, node_index);
+        return kTfLiteError;
+      }
+      return kTfLiteOk;
+    }
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+    return CheckTensorFloatType(context, tensor, tensor_index, node_index);
+  }
+
+  // Checks that the filter tensor is FP32, or, in builds with QS8 support,
+  // INT8 with symmetric per-tensor quantization or per-channel quantization
+  // along `expected_quantized_dimension`.
+  static TfLiteStatus CheckTensorFloat32OrQCInt8Type(
+      TfLiteContext* context, const TfLiteTensor& tensor,
+      int expected_quantized_dimension, int tensor_index, int node_index) {
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+    if (tensor.type == kTfLiteInt8) {
+      switch (GetQuantizedDatatype(tensor)) {
+        case xnn_datatype_qint8:
+          if (GetAffineQuantization(tensor).zero_point->data[0] == 0) {
+            return kTfLiteOk;
+          }
+          break;
+        case xnn_datatype_qcint8:
+          if (GetAffineQuantization(tensor).quantized_dimension ==
+              expected_quantized_dimension) {
+            return kTfLiteOk;
+          }
+          break;
+        default:
+          break;
+      }
+      TF_LITE_MAYBE_KERNEL_LOG(
+          context,
+          "unsupported quantization in INT8 tensor #%d in node #%d: "
+          "symmetric per-tensor or per-channel quantization along "
+          "dimension %d expected",
+          tensor_index, node_index, expected_quantized_dimension);
+      return kTfLiteError;
+    }
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+    return CheckTensorFloatType(context, tensor, tensor_index, node_index);
+  }
+
+  // Checks that the bias tensor is FP32, or, in builds with QS8 support,
+  // INT32 with symmetric per-tensor or per-channel quantization.
+  static TfLiteStatus CheckTensorFloat32OrQCInt32Type(
+      TfLiteContext* context, const TfLiteTensor& tensor, int tensor_index,
+      int node_index) {
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+    if (tensor.type == kTfLiteInt32) {
+      switch (GetQuantizedDatatype(tensor)) {
+        case xnn_datatype_qint32:
+          if (GetAffineQuantization(tensor).zero_point->data[0] == 0) {
+            return kTfLiteOk;
+          }
+          break;
+        case xnn_datatype_qcint32:
+          return kTfLiteOk;
+        default:
+          break;
+      }
+      TF_LITE_MAYBE_KERNEL_LOG(
+          context,
+          "unsupported quantization in INT32 tensor #%d in node #%d: "
+          "symmetric quantization expected",
+          tensor_index, node_index);
+      return kTfLiteError;
+    }
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+    return CheckTensorFloatType(context, tensor, tensor_index, node_index);
+  }
+
+  // Checks that two quantized tensors have the same quantization parameters,
+  // as XNNPACK requires for operators that don't requantize, e.g. MaxPool.
+  static TfLiteStatus CheckTensorsQuantizationMatch(
+      TfLiteContext* context, const TfLiteTensor& tensor1,
+      const TfLiteTensor& tensor2, int tensor1_index, int tensor2_index,
+      int node_index) {
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+    if (tensor1.type == kTfLiteInt8) {
+      const TfLiteAffineQuantization& quantization1 =
+          GetAffineQuantization(tensor1);
+      const TfLiteAffineQuantization& quantization2 =
+          GetAffineQuantization(tensor2);
+      if (quantization1.scale->data[0] != quantization2.scale->data[0] ||
+          quantization1.zero_point->data[0] !=
+              quantization2.zero_point->data[0]) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            context,
+            "mismatching quantization in tensors #%d and #%d in node #%d",
+            tensor1_index, tensor2_index, node_index);
+        return kTfLiteError;
+      }
+    }
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+    return kTfLiteOk;
+  }
+
   static TfLiteStatus CheckTensorShape(TfLiteContext* context,
                                        const TfLiteTensor& tensor,
                                        int min_num_dims, int max_num_dims,
@@ -1044,19 +1066,25 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 2, 1, node_index));
 
     const TfLiteTensor& input1_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input1_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input1_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& input2_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, input2_tensor,
+                                          input1_tensor.type,
+                                          node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input2_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input2_tensor, node->inputs->data[1], node_index));
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input1_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, output_tensor, node->outputs->data[0], node_index));
@@ -1197,7 +1225,7 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 3, 1, node_index));
 
     const TfLiteTensor& input_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, input_tensor, 4,
                                            node->inputs->data[0]));
@@ -1205,8 +1233,12 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, filter_tensor,
+                                          input_tensor.type,
+                                          node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt8Type(
+        logging_context, filter_tensor, /*expected_quantized_dimension=*/0,
+        node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
                                            node->inputs->data[1]));
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
@@ -1215,7 +1247,11 @@ class Subgraph {
     }
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(
+        logging_context, bias_tensor,
+        input_tensor.type == kTfLiteFloat32 ? kTfLiteFloat32 : kTfLiteInt32,
+        node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt32Type(
         logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
@@ -1225,7 +1261,10 @@ class Subgraph {
     }
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, output_tensor, 4,
                                            node->outputs->data[0]));
@@ -1285,7 +1324,7 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 3, 1, node_index));
 
     const TfLiteTensor& input_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, input_tensor, 4,
                                            node->inputs->data[0]));
@@ -1293,8 +1332,12 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, filter_tensor,
+                                          input_tensor.type,
+                                          node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt8Type(
+        logging_context, filter_tensor, /*expected_quantized_dimension=*/3,
+        node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
                                            node->inputs->data[1]));
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
@@ -1303,8 +1346,12 @@ class Subgraph {
     }
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorType(
+        logging_context, bias_tensor,
+        input_tensor.type == kTfLiteFloat32 ? kTfLiteFloat32 : kTfLiteInt32,
+        node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt32Type(
+        logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
     if (quasi_static_tensors.count(node->inputs->data[2]) == 0) {
@@ -1313,7 +1360,10 @@ class Subgraph {
     }
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, output_tensor, 4,
                                            node->outputs->data[0]));
@@ -1432,14 +1482,18 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 3, 1, node_index));
 
     const TfLiteTensor& input_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, filter_tensor,
+                                          input_tensor.type,
+                                          node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt8Type(
+        logging_context, filter_tensor, /*expected_quantized_dimension=*/0,
+        node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 2,
                                            node->inputs->data[1]));
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
@@ -1448,8 +1502,12 @@ class Subgraph {
     }
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorType(
+        logging_context, bias_tensor,
+        input_tensor.type == kTfLiteFloat32 ? kTfLiteFloat32 : kTfLiteInt32,
+        node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQCInt32Type(
+        logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
     if (quasi_static_tensors.count(node->inputs->data[2]) == 0) {
@@ -1458,7 +1516,10 @@ class Subgraph {
     }
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, output_tensor, node->outputs->data[0], node_index));
@@ -1707,14 +1768,20 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 1, 1, node_index));
 
     const TfLiteTensor& input_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorsQuantizationMatch(
+        logging_context, input_tensor, output_tensor, node->inputs->data[0],
+        node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, output_tensor, node->outputs->data[0], node_index));
 
@@ -2156,19 +2223,25 @@ class Subgraph {
         CheckNumInputsAndOutputs(logging_context, node, 2, 1, node_index));
 
     const TfLiteTensor& input1_tensor = tensors[node->inputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input1_tensor, node->inputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input1_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& input2_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, input2_tensor,
+                                          input1_tensor.type,
+                                          node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, input2_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, input2_tensor, node->inputs->data[1], node_index));
 
     const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_tensor,
+                                          input1_tensor.type,
+                                          node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorFloat32OrQInt8Type(
         logging_context, output_tensor, node->outputs->data[0], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
         logging_context, output_tensor, node->outputs->data[0], node_index));
@@ -2777,8 +2850,230 @@ class Subgraph {
   }
 
  private:
-  Subgraph(xnn_runtime_t runtime, std::unordered_set<int>&& externals)
-      : runtime_(runtime, &xnn_delete_runtime), externals_(externals) {}
+  Subgraph(const TfLiteDelegateParams* params, const Delegate* delegate)
+      : delegate_(delegate),
+        nodes_(&params->nodes_to_replace->data[0],
+               &params->nodes_to_replace->data[params->nodes_to_replace->size]),
+        inputs_(&params->input_tensors->data[0],
+                &params->input_tensors->data[params->input_tensors->size]) {
+    for (int o = 0; o < params->output_tensors->size; o++) {
+      const int output_tensor_idx = params->output_tensors->data[o];
+      // Exclude quasi-static tensors which may have become subgraph outputs
+      // after partitioning.
+      if (delegate->static_unpacked_data_map_.count(output_tensor_idx) == 0) {
+        outputs_.insert(output_tensor_idx);
+      }
+    }
+  }
+
+  // Creates the XNNPACK runtime for the delegated nodes, with the current
+  // shapes of their tensors.
+  TfLiteStatus CreateRuntime(TfLiteContext* context) {
+    std::unordered_set<int> externals(outputs_);
+
+    xnn_subgraph_t subgraph_ptr = nullptr;
+    xnn_status status = xnn_create_subgraph(
+        /*external_value_ids=*/context->tensors_size, /*flags=*/0,
+        &subgraph_ptr);
+    if (status != xnn_status_success) {
+      TF_LITE_KERNEL_LOG(context, "failed to create XNNPACK subgraph");
+      return kTfLiteError;
+    }
+
+    // Smart pointer to automatically release subgraph on exit.
+    std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> subgraph(
+        subgraph_ptr, &xnn_delete_subgraph);
+
+    // Detect which tensors are used as inputs or outputs of any subgraph nodes.
+    // -1 denotes tensor not used in the subgraph. These indexes will be
+    // filtered out and removed later.
+    std::vector<int> tensors(context->tensors_size, -1);
+    for (int node_index : nodes_) {
+      if (delegate_->static_unpack_nodes_.count(node_index)) {
+        // The node unpacks static input and can be skipped because its input
+        // was pre-unpacked in DelegatePrepare.
+        continue;
+      }
+
+      TfLiteNode* node = nullptr;
+      TfLiteRegistration* registration = nullptr;
+      if (context->GetNodeAndRegistration(context, node_index, &node,
+                                          &registration) != kTfLiteOk) {
+        return kTfLiteError;
+      }
+
+      switch (registration->builtin_code) {
+        case kTfLiteBuiltinMean:
+        case kTfLiteBuiltinPad:
+        case kTfLiteBuiltinReshape:
+        case kTfLiteBuiltinResizeBilinear:
+          // Ignore the second input (axes, static padding, or new shape),
+          // because it is represented as parameters of the XNNPACK operator
+          // rather than extra input.
+          {
+            const int t = node->inputs->data[0];
+            tensors[t] = t;
+          }
+          break;
+        default:
+          // All other operators: process all inputs
+          for (int k = 0; k < node->inputs->size; k++) {
+            const int t = node->inputs->data[k];
+            tensors[t] = t;
+          }
+      }
+      for (int k = 0; k < node->outputs->size; k++) {
+        const int t = node->outputs->data[k];
+        tensors[t] = t;
+      }
+    }
+    // Filter out and remove -1 (unused) indexes.
+    tensors.erase(std::remove_if(tensors.begin(), tensors.end(),
+                                 [](int i) { return i < 0; }),
+                  tensors.end());
+    std::sort(tensors.begin(), tensors.end());
+
+    // XNNPACK Value IDs for TFLite tensors
+    std::vector<uint32_t> xnnpack_tensors(tensors.back() + 1);
+    for (int t : tensors) {
+      const TfLiteTensor& tensor = context->tensors[t];
+      xnn_datatype datatype = xnn_datatype_invalid;
+      switch (tensor.type) {
+        case kTfLiteFloat32:
+          datatype = xnn_datatype_fp32;
+          break;
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+        case kTfLiteInt8:
+        case kTfLiteInt32:
+          datatype = GetQuantizedDatatype(tensor);
+          break;
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+        default:
+          break;
+      }
+      if (datatype == xnn_datatype_invalid) {
+        TF_LITE_KERNEL_LOG(
+            context,
+            "unsupported datatype (%s) of tensor %d in XNNPACK delegate",
+            TfLiteTypeGetName(tensor.type), t);
+        return kTfLiteError;
+      }
+
+      uint32_t flags = 0;
+      const void* data = nullptr;
+      if (tensor.allocation_type == kTfLiteMmapRo) {
+        data = tensor.data.raw_const;
+      } else {
+        // Check for quasi-static data.
+        const auto it = delegate_->static_unpacked_data_map_.find(t);
+        if (it != delegate_->static_unpacked_data_map_.end()) {
+          data = delegate_->static_unpacked_data_.data() + it->second;
+        }
+      }
+      if (inputs_.count(t) != 0) {
+        flags |= XNN_VALUE_FLAG_EXTERNAL_INPUT;
+        if (data == nullptr) {
+          externals.insert(t);
+        }
+      }
+      if (outputs_.count(t) != 0) {
+        flags |= XNN_VALUE_FLAG_EXTERNAL_OUTPUT;
+      }
+
+      std::vector<size_t> dims(&tensor.dims->data[0],
+                               &tensor.dims->data[tensor.dims->size]);
+
+      xnn_status status = xnn_status_success;
+      switch (datatype) {
+#ifdef XNNPACK_DELEGATE_ENABLE_QS8
+        case xnn_datatype_qint8:
+        case xnn_datatype_qint32:
+          status = xnn_define_quantized_tensor_value(
+              subgraph.get(), datatype,
+              GetAffineQuantization(tensor).zero_point->data[0],
+              GetAffineQuantization(tensor).scale->data[0], dims.size(),
+              dims.data(), data, static_cast<uint32_t>(t), flags,
+              &xnnpack_tensors[t]);
+          break;
+        case xnn_datatype_qcint8:
+        case xnn_datatype_qcint32:
+          status = xnn_define_channelwise_quantized_tensor_value(
+              subgraph.get(), datatype,
+              GetAffineQuantization(tensor).scale->data, dims.size(),
+              GetAffineQuantization(tensor).quantized_dimension, dims.data(),
+              data, static_cast<uint32_t>(t), flags, &xnnpack_tensors[t]);
+          break;
+#endif  // XNNPACK_DELEGATE_ENABLE_QS8
+        default:
+          status = xnn_define_tensor_value(
+              subgraph.get(), datatype, dims.size(), dims.data(), data,
+              static_cast<uint32_t>(t), flags, &xnnpack_tensors[t]);
+          break;
+      }
+      if (status != xnn_status_success) {
+        TF_LITE_KERNEL_LOG(context,
+                           "failed to create XNNPACK Value for tensor %d", t);
+        return kTfLiteError;
+      }
+    }
+
+    // Create a set of quasi-static tensors for VisitNode function
+    std::unordered_set<int> quasi_static_tensors;
+    for (const std::pair<const int, size_t>& entry :
+         delegate_->static_unpacked_data_map_) {
+      quasi_static_tensors.insert(entry.first);
+    }
+
+    // Create XNNPACK nodes for TFLite delegate nodes
+    for (int node_index : nodes_) {
+      if (delegate_->static_unpack_nodes_.count(node_index)) {
+        // The node unpacks static input and can be skipped because its input
+        // was pre-unpacked in DelegatePrepare.
+        continue;
+      }
+
+      TfLiteNode* node = nullptr;
+      TfLiteRegistration* registration = nullptr;
+      if (context->GetNodeAndRegistration(context, node_index, &node,
+                                          &registration) != kTfLiteOk) {
+        return kTfLiteError;
+      }
+
+      if (VisitNode(subgraph.get(), context, registration, node, node_index,
+                    quasi_static_tensors, xnnpack_tensors) != kTfLiteOk) {
+        return kTfLiteError;
+      }
+    }
+
+    xnn_runtime_t runtime_ptr = nullptr;
+    status = xnn_create_runtime_v2(subgraph.get(), delegate_->threadpool(),
+                                   /*flags=*/0, &runtime_ptr);
+    if (status != xnn_status_success) {
+      TF_LITE_KERNEL_LOG(context, "failed to create XNNPACK runtime");
+      return kTfLiteError;
+    }
+
+    runtime_.reset(runtime_ptr);
+    externals_ = std::move(externals);
+    input_dims_.clear();
+    for (int t : externals_) {
+      if (inputs_.count(t) != 0) {
+        const TfLiteIntArray* dims = context->tensors[t].dims;
+        input_dims_[t].assign(&dims->data[0], &dims->data[dims->size]);
+      }
+    }
+    return kTfLiteOk;
+  }
+
+  const Delegate* delegate_;
+  // Indices of the delegated TFLite nodes.
+  std::vector<int> nodes_;
+  // Inputs and outputs of the delegated subgraph, as hash sets for faster
+  // lookup.
+  std::unordered_set<int> inputs_;
+  std::unordered_set<int> outputs_;
+  // Shapes of the non-static subgraph inputs the runtime was created for.
+  std::unordered_map<int, std::vector<int>> input_dims_;
 
   // XNNPACK Runtime (subgraph + workspace) with smart-pointer for lifetime
   // management.
@@ -59,6 +59,13 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Consecutive nodes of the execution plan may form a step, whose nodes run
+  // concurrently. Returns the execution plan indices of the first and the last
+  // node of the step of the node at execution plan index `index`. By default,
+  // each node is a step of its own.
+  virtual size_t step_begin(size_t index) const { return index; }
+  virtual size_t step_end(size_t index) const { return index; }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
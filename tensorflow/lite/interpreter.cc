@@ -269,6 +269,14 @@ TfLiteStatus Interpreter::ResizeInputTensorStrict(
   return primary_subgraph().ResizeInputTensorStrict(tensor_index, dims);
 }
 
+TfLiteStatus Interpreter::SetMaxBatchSize(int max_batch_size) {
+  return primary_subgraph().SetMaxBatchSize(max_batch_size);
+}
+
+TfLiteStatus Interpreter::ResizeInputBatch(int batch_size) {
+  return primary_subgraph().ResizeInputBatch(batch_size);
+}
+
 TfLiteStatus Interpreter::ReleaseNonPersistentMemory() {
   // TODO(b/138790287): We could do this for all subgraphs whose tensors have
   // been allocated. However, AllocateTensors() relies on Control Flow ops to
@@ -372,6 +380,10 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetNumInterOpThreads(int num_threads) {
+  return primary_subgraph().SetNumInterOpThreads(num_threads);
+}
+
 void Interpreter::SetAllowFp16PrecisionForFp32(bool allow) {
   for (auto& subgraph : subgraphs_) {
     subgraph->context()->allow_fp32_relax_to_fp16 = allow;
@@ -341,6 +341,19 @@ class Interpreter {
   TfLiteStatus ResizeInputTensorStrict(int tensor_index,
                                        const std::vector<int>& dims);
 
+  /// Enables dynamic batching: resizes the leading (batch) dimension of all
+  /// the inputs to `max_batch_size`. The next AllocateTensors() plans the
+  /// memory of the tensors for it, and later calls to `ResizeInputBatch` reuse
+  /// that plan.
+  /// WARNING: Experimental interface, subject to change
+  TfLiteStatus SetMaxBatchSize(int max_batch_size);
+
+  /// Resizes the batch dimension of all the inputs to `batch_size`, at most the
+  /// maximum batch size, and allocates the tensors without planning their
+  /// memory again. Only the ops are prepared again, for their output shapes.
+  /// WARNING: Experimental interface, subject to change
+  TfLiteStatus ResizeInputBatch(int batch_size);
+
   // This releases memory held by non-persistent tensors. It does NOT re-perform
   // memory planning.
   // AllocateTensors needs to be called before next invocation.
@@ -379,6 +392,14 @@ class Interpreter {
   /// available to itself.
   TfLiteStatus SetNumThreads(int num_threads);
 
+  /// Set the number of threads running independent nodes of the primary
+  /// subgraph concurrently, on top of the threads set by `SetNumThreads`
+  /// for each node. `AllocateTensors` must be called again afterwards.
+  ///
+  /// NOTE: num_threads should be >= 1, where 1 runs one node at a time.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
   /// Allow float16 precision for FP32 calculation when possible.
   /// Default: not allow.
   ///
@@ -18,6 +18,7 @@ limitations under the License.
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -567,6 +568,46 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
   return status;
 }
 
+TfLiteStatus InterpreterBuilder::ParseOfflinePlannedOffsets(
+    int subgraph_index, Subgraph* subgraph) {
+  // The "OfflineMemoryAllocation" metadata holds the int32 words
+  // [version, subgraph index, number of offsets, offsets...], with an arena
+  // offset or -1 per tensor of the subgraph, as for TFLite Micro.
+  constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+  if (model_->metadata() == nullptr) return kTfLiteOk;
+  for (const Metadata* metadata : *model_->metadata()) {
+    if (metadata->name() == nullptr ||
+        strcmp(metadata->name()->c_str(), kOfflineMemAllocMetadata) != 0) {
+      continue;
+    }
+    const Buffer* buffer = metadata->buffer() < model_->buffers()->size()
+                               ? model_->buffers()->Get(metadata->buffer())
+                               : nullptr;
+    if (buffer == nullptr || buffer->data() == nullptr ||
+        buffer->data()->size() < 3 * sizeof(int32_t)) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Invalid offline memory allocation metadata.\n");
+      return kTfLiteError;
+    }
+    const size_t num_words = buffer->data()->size() / sizeof(int32_t);
+    std::vector<int32_t> words(num_words);
+    memcpy(words.data(), buffer->data()->data(), num_words * sizeof(int32_t));
+    if (words[1] != subgraph_index) continue;
+    const int32_t num_offsets = words[2];
+    if (num_offsets != subgraph->tensors_size() ||
+        num_words < 3 + static_cast<size_t>(num_offsets)) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Offline memory allocation metadata of subgraph %d "
+                           "doesn't match its %d tensors.\n",
+                           subgraph_index, subgraph->tensors_size());
+      return kTfLiteError;
+    }
+    subgraph->SetOfflinePlannedOffsets(std::vector<int32_t>(
+        words.begin() + 3, words.begin() + 3 + num_offsets));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus InterpreterBuilder::ApplyDelegates(Interpreter* interpreter,
                                                 int num_threads) {
   // Apply Flex delegate if applicable.
@@ -678,6 +719,9 @@ TfLiteStatus InterpreterBuilder::operator()(
       return cleanup_and_error();
     if (ParseTensors(buffers, tensors, modified_subgraph) != kTfLiteOk)
       return cleanup_and_error();
+    if (ParseOfflinePlannedOffsets(subgraph_index, modified_subgraph) !=
+        kTfLiteOk)
+      return cleanup_and_error();
 
     std::vector<int> variables;
     for (int i = 0; i < modified_subgraph->tensors_size(); ++i) {
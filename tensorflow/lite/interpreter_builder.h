@@ -75,6 +75,8 @@ class InterpreterBuilder {
       const flatbuffers::Vector<flatbuffers::Offset<Tensor>>* tensors,
       Subgraph* subgraph);
   TfLiteStatus ApplyDelegates(Interpreter* interpreter, int num_threads);
+  TfLiteStatus ParseOfflinePlannedOffsets(int subgraph_index,
+                                          Subgraph* subgraph);
   TfLiteStatus ParseQuantization(const QuantizationParameters* src_quantization,
                                  TfLiteQuantization* quantization,
                                  const std::vector<int>& dims);
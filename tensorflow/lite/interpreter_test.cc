@@ -703,6 +703,106 @@ TEST(BasicInterpreter, OneOpInterpreter) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
+TEST(BasicInterpreter, InterOpParallelBranches) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+
+  // Two independent chains of two nodes each: 0 -> 1 -> 3 and 0 -> 2 -> 4.
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({2}, {4}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+
+  ASSERT_NE(interpreter.SetNumInterOpThreads(0), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // The first nodes of the chains run together, then the second ones.
+  EXPECT_EQ(interpreter.execution_plan(), std::vector<int>({0, 2, 1, 3}));
+  EXPECT_EQ(interpreter.primary_subgraph().inter_op_steps(),
+            std::vector<int>({0, 2}));
+  // The tensors used by the nodes of a step never share memory.
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(2)->data.raw);
+
+  for (int i = 0; i < 3; ++i) {
+    interpreter.typed_tensor<float>(0)[i] = i + 1;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], i + 1);
+    EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], i + 1);
+  }
+
+  // A single thread runs one node at a time.
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(1), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_TRUE(interpreter.primary_subgraph().inter_op_steps().empty());
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(4)[2], 3);
+}
+
+TEST(BasicInterpreter, DynamicBatch) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({1}), kTfLiteOk);
+
+  TfLiteQuantizationParams quantized;
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "in1",
+                                                     {1}, quantized),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(1, kTfLiteFloat32, "out0",
+                                                     {1}, quantized),
+            kTfLiteOk);
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+
+  ASSERT_NE(interpreter.ResizeInputBatch(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetMaxBatchSize(8), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(1)->bytes, 8 * sizeof(float));
+  const char* input_data = interpreter.tensor(0)->data.raw;
+  const char* output_data = interpreter.tensor(1)->data.raw;
+
+  // The tensors keep the memory planned for 8.
+  ASSERT_EQ(interpreter.ResizeInputBatch(3), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(1)->bytes, 3 * sizeof(float));
+  EXPECT_EQ(interpreter.tensor(0)->data.raw, input_data);
+  EXPECT_EQ(interpreter.tensor(1)->data.raw, output_data);
+  for (int i = 0; i < 3; ++i) {
+    interpreter.typed_tensor<float>(0)[i] = i;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(1)[i], i);
+  }
+
+  ASSERT_NE(interpreter.ResizeInputBatch(9), kTfLiteOk);
+  ASSERT_EQ(interpreter.ResizeInputBatch(8), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(1)->data.raw, output_data);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+}
+
 TEST(BasicInterpreter, ReleaseNonPersistentMemory) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
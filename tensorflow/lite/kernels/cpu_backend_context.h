@@ -101,9 +101,10 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   int max_num_threads_;
   // For matrix muliplications with constants parameters (i.e. weights), we can
   // sometimes provide speedups by caching the "prepacked" data, for some
-  // additional memory cost. This flag permits the user to route all
-  // CpuBackendGem operations to a library that permits such an optimization
-  // (currently the Ruy library only).
+  // additional memory cost. This flag permits the user to route the
+  // CpuBackendGemm operations with cacheable operands, e.g. the constant
+  // weights of FullyConnected and Conv, to a library that permits such an
+  // optimization (currently the Ruy library only).
   bool use_caching_;
 
   CpuBackendContext(const CpuBackendContext&) = delete;
@@ -130,10 +130,14 @@ void Gemm(const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
   // In some cases we want to unconditionally use ruy as the backend, overriding
   // the `tflite_with_ruy` setting and the platform default.
   bool must_use_ruy = false;
-  if (context->use_caching()) {
-    // Only ruy supports caching of pre-packed matrices. Due to the large
-    // performance impact in the cases where it's typically used, this overrides
-    // the default.
+  if (context->use_caching() &&
+      (lhs_params.cache_policy != CachePolicy::kNeverCache ||
+       rhs_params.cache_policy != CachePolicy::kNeverCache)) {
+    // Only ruy supports caching of pre-packed matrices, so that constant
+    // operands such as weights are packed on the first call only. Due to the
+    // large performance impact in the cases where it's typically used, this
+    // overrides the default, including the Eigen and gemmlowp backends of x86
+    // without AVX. Operands which are not cacheable keep the default backend.
     must_use_ruy = true;
   }
   if (lhs_params.order != Order::kRowMajor ||
@@ -398,6 +398,11 @@ void TestSomeGemm(int rows, int depth, int cols,
       use_golden ? cpu_backend_gemm::Order::kRowMajor : random_order();
   lhs_params.rows = rows;
   lhs_params.cols = depth;
+  if (use_caching) {
+    // The LHS does not change, like the weights of FullyConnected and Conv,
+    // so it may be packed once by the first Gemm and reused by the others.
+    lhs_params.cache_policy = cpu_backend_gemm::CachePolicy::kAlwaysCache;
+  }
   if (!std::is_floating_point<LhsScalar>::value) {
     lhs_params.zero_point = 1;
     if (!use_golden) {
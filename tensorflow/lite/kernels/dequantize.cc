@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/optimized/neon_check.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/shared_constant_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -49,6 +50,31 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+// Dequantizes the constant input once for all the interpreters sharing
+// `cache`, and points the output to the shared data.
+template <KernelType kernel_type>
+TfLiteStatus PrepareShared(TfLiteContext* context, TfLiteNode* node,
+                           SharedConstantCache* cache) {
+  OpContext op_context(context, node);
+  TF_LITE_ENSURE_STATUS(context->ResizeTensor(
+      context, op_context.output, TfLiteIntArrayCopy(op_context.input->dims)));
+  const void* data = cache->GetOrCreate(
+      op_context.input->data.raw, SharedConstantCache::kDequantizedFloat32,
+      op_context.output->bytes, [&](void* data) {
+        op_context.output->data.raw = static_cast<char*>(data);
+        return DequantizeImpl<kernel_type>(context, node, op_context.input,
+                                           op_context.output);
+      });
+  TF_LITE_ENSURE(context, data != nullptr);
+  // The output is read-only data allocated outside of the interpreter, like
+  // the constant tensors of the model.
+  op_context.output->allocation_type = kTfLiteMmapRo;
+  op_context.output->data.raw =
+      const_cast<char*>(static_cast<const char*>(data));
+  return kTfLiteOk;
+}
+
+template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -60,10 +86,20 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                               op_context.input->type == kTfLiteInt16 ||
                               op_context.input->type == kTfLiteFloat16);
 
+  // The output already points to the data shared with other interpreters.
+  if (op_context.output->allocation_type == kTfLiteMmapRo) {
+    return kTfLiteOk;
+  }
+
   op_context.output->type = kTfLiteFloat32;
   // If the input tensor is constant, we can persist the dequantized value in
-  // the output tensor. Otherwise we run dequantize upon each eval.
+  // the output tensor, or share it with other interpreters built from the same
+  // model. Otherwise we run dequantize upon each eval.
   if (IsConstantTensor(op_context.input)) {
+    SharedConstantCache* cache = SharedConstantCache::GetFromContext(context);
+    if (cache != nullptr) {
+      return PrepareShared<kernel_type>(context, node, cache);
+    }
     op_context.output->allocation_type = kTfLiteArenaRwPersistent;
   }
   return context->ResizeTensor(context, op_context.output,
@@ -74,6 +110,9 @@ template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
   OpContext op_context(context, node);
+  if (op_context.output->allocation_type == kTfLiteMmapRo) {
+    return kTfLiteOk;
+  }
   if (IsConstantTensor(op_context.input) &&
       op_data->float_dequantized_weights_initialized) {
     return kTfLiteOk;
@@ -95,14 +134,15 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
 TfLiteRegistration* Register_DEQUANTIZE_OPT() {
   static TfLiteRegistration r = {
-      dequantize::Init, dequantize::Free, dequantize::Prepare,
+      dequantize::Init, dequantize::Free,
+      dequantize::Prepare<dequantize::kGenericOptimized>,
       dequantize::Eval<dequantize::kGenericOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_DEQUANTIZE_REF() {
   static TfLiteRegistration r = {dequantize::Init, dequantize::Free,
-                                 dequantize::Prepare,
+                                 dequantize::Prepare<dequantize::kReference>,
                                  dequantize::Eval<dequantize::kReference>};
   return &r;
 }
@@ -31,10 +31,16 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 
 namespace tflite {
@@ -42,6 +48,12 @@ namespace ops {
 namespace builtin {
 namespace embedding_lookup {
 
+// The rows are only looked up on several threads if each thread writes at
+// least this many output bytes.
+constexpr int kMinBytesPerThread = 64 * 1024;
+// The row of the lookup this far ahead is prefetched while copying a row.
+constexpr int kPrefetchDistance = 4;
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -67,14 +79,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return context->ResizeTensor(context, output, outputSize);
 }
 
-TfLiteStatus EvalSimple(TfLiteContext* context, TfLiteNode* node,
-                        const TfLiteTensor* lookup, const TfLiteTensor* value,
-                        TfLiteTensor* output) {
+// Checks that all the lookups are rows of `value`.
+TfLiteStatus CheckLookups(TfLiteContext* context, const TfLiteTensor* lookup,
+                          const TfLiteTensor* value) {
   const int row_size = SizeOfDimension(value, 0);
-  const int row_bytes = value->bytes / row_size;
-
-  char* output_raw = GetTensorData<char>(output);
-  const char* value_raw = GetTensorData<char>(value);
   const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
   for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
     int idx = lookup_data[i];
@@ -84,20 +92,117 @@ TfLiteStatus EvalSimple(TfLiteContext* context, TfLiteNode* node,
                            "Got %d, and bounds are [0, %d]",
                            idx, row_size - 1);
       return kTfLiteError;
-    } else {
-      std::memcpy(output_raw + i * row_bytes, value_raw + idx * row_bytes,
-                  row_bytes);
     }
   }
+  return kTfLiteOk;
+}
+
+// Copies the rows of the lookups in [start, end).
+struct EmbeddingLookupTask : cpu_backend_threadpool::Task {
+  EmbeddingLookupTask(const int32_t* lookup_data, const char* value_raw,
+                      size_t row_bytes, char* output_raw, int start, int end)
+      : lookup_data(lookup_data),
+        value_raw(value_raw),
+        row_bytes(row_bytes),
+        output_raw(output_raw),
+        start(start),
+        end(end) {}
+  void Run() override {
+    for (int i = start; i < end; i++) {
+      if (i + kPrefetchDistance < end) {
+        optimized_ops_preload_l1_stream(
+            value_raw + lookup_data[i + kPrefetchDistance] * row_bytes);
+      }
+      std::memcpy(output_raw + i * row_bytes,
+                  value_raw + lookup_data[i] * row_bytes, row_bytes);
+    }
+  }
+
+ private:
+  const int32_t* lookup_data;
+  const char* value_raw;
+  size_t row_bytes;
+  char* output_raw;
+  int start;
+  int end;
+};
+
+// Dequantizes the rows of the lookups in [start, end).
+struct EmbeddingLookupHybridTask : cpu_backend_threadpool::Task {
+  EmbeddingLookupHybridTask(const int32_t* lookup_data, const int8_t* value_ptr,
+                            int col_size, float scaling_factor,
+                            float* output_ptr, int start, int end)
+      : lookup_data(lookup_data),
+        value_ptr(value_ptr),
+        col_size(col_size),
+        scaling_factor(scaling_factor),
+        output_ptr(output_ptr),
+        start(start),
+        end(end) {}
+  void Run() override {
+    for (int i = start; i < end; i++) {
+      if (i + kPrefetchDistance < end) {
+        optimized_ops_preload_l1_stream(
+            value_ptr +
+            static_cast<size_t>(lookup_data[i + kPrefetchDistance]) * col_size);
+      }
+      tensor_utils::VectorScalarMultiply(
+          value_ptr + static_cast<size_t>(lookup_data[i]) * col_size, col_size,
+          scaling_factor, output_ptr + static_cast<size_t>(i) * col_size);
+    }
+  }
+
+ private:
+  const int32_t* lookup_data;
+  const int8_t* value_ptr;
+  int col_size;
+  float scaling_factor;
+  float* output_ptr;
+  int start;
+  int end;
+};
+
+// Runs a `TaskType` built from `args` and a range of lookups on each thread,
+// for `num_lookups` lookups writing `row_bytes` output bytes each.
+template <typename TaskType, typename... Args>
+void RunLookupTasks(TfLiteContext* context, int num_lookups, size_t row_bytes,
+                    Args... args) {
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const size_t output_bytes = static_cast<size_t>(num_lookups) * row_bytes;
+  int thread_count = std::min<size_t>(cpu_backend_context->max_num_threads(),
+                                      output_bytes / kMinBytesPerThread);
+  thread_count = std::max(1, std::min(thread_count, num_lookups));
+  std::vector<TaskType> tasks;
+  tasks.reserve(thread_count);
+  int start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int end = start + (num_lookups - start) / (thread_count - i);
+    tasks.emplace_back(args..., start, end);
+    start = end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+TfLiteStatus EvalSimple(TfLiteContext* context, TfLiteNode* node,
+                        const TfLiteTensor* lookup, const TfLiteTensor* value,
+                        TfLiteTensor* output) {
+  TF_LITE_ENSURE_OK(context, CheckLookups(context, lookup, value));
+  const int row_size = SizeOfDimension(value, 0);
+  const size_t row_bytes = value->bytes / row_size;
 
+  RunLookupTasks<EmbeddingLookupTask>(
+      context, SizeOfDimension(lookup, 0), row_bytes,
+      GetTensorData<int32_t>(lookup), GetTensorData<char>(value), row_bytes,
+      GetTensorData<char>(output));
   return kTfLiteOk;
 }
 
 TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
                         const TfLiteTensor* lookup, const TfLiteTensor* value,
                         TfLiteTensor* output) {
-  const int row_size = SizeOfDimension(value, 0);
-  const double scaling_factor = value->params.scale;
+  TF_LITE_ENSURE_OK(context, CheckLookups(context, lookup, value));
 
   // col_size after we flatten tensor into 2D.
   int col_size = 1;
@@ -105,29 +210,11 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
     col_size *= SizeOfDimension(value, i);
   }
 
-  float* output_ptr = GetTensorData<float>(output);
-  const int8_t* value_ptr = GetTensorData<int8_t>(value);
-  const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
-
-  for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
-    int idx = lookup_data[i];
-    if (idx >= row_size || idx < 0) {
-      context->ReportError(context,
-                           "Embedding Lookup: index out of bounds. "
-                           "Got %d, and bounds are [0, %d]",
-                           idx, row_size - 1);
-      return kTfLiteError;
-    } else {
-      // Dequantize embedding values.
-      // TODO(alanchiao): refactor scalar multiply into separate function
-      // for ease of adding a neon equivalent if ever necessary.
-      for (int j = 0; j < col_size; j++) {
-        output_ptr[j + i * col_size] =
-            value_ptr[j + idx * col_size] * scaling_factor;
-      }
-    }
-  }
-
+  // Dequantize embedding values.
+  RunLookupTasks<EmbeddingLookupHybridTask>(
+      context, SizeOfDimension(lookup, 0), col_size * sizeof(float),
+      GetTensorData<int32_t>(lookup), GetTensorData<int8_t>(value), col_size,
+      value->params.scale, GetTensorData<float>(output));
   return kTfLiteOk;
 }
 
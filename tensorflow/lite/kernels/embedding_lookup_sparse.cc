@@ -66,9 +66,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
@@ -79,6 +83,12 @@ namespace builtin {
 
 namespace {
 
+// The buckets are only aggregated on several threads if each thread reads at
+// least this many bytes of embeddings.
+constexpr int kMinBytesPerThread = 64 * 1024;
+// The embedding of the lookup this far ahead is prefetched while aggregating.
+constexpr int kPrefetchDistance = 4;
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 5);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -143,6 +153,63 @@ void FinalizeAggregation(TfLiteCombinerType combiner, int num_elements,
   }
 }
 
+// The consecutive lookups in [begin, end), all aggregated into the bucket at
+// `output_offset`.
+struct LookupRun {
+  int begin;
+  int end;
+  int output_offset;
+};
+
+struct SparseLookup {
+  const int32_t* ids;
+  const float* weights;
+  const float* value;
+  float* output;
+  int embedding_size;
+  TfLiteCombinerType combiner;
+};
+
+void AggregateRun(const SparseLookup& lookup, const LookupRun& run) {
+  const int embedding_size = lookup.embedding_size;
+  float* output = lookup.output + run.output_offset;
+  float total_weight = 0.0;
+  float squares_weight = 0.0;
+  for (int i = run.begin; i < run.end; i++) {
+    if (i + kPrefetchDistance < run.end) {
+      optimized_ops_preload_l1_stream(
+          lookup.value + lookup.ids[i + kPrefetchDistance] * embedding_size);
+    }
+    const float* embedding = lookup.value + lookup.ids[i] * embedding_size;
+    const float w = lookup.weights[i];
+    squares_weight += w * w;
+    total_weight += w;
+    for (int k = 0; k < embedding_size; k++) {
+      output[k] += embedding[k] * w;
+    }
+  }
+  FinalizeAggregation(lookup.combiner, run.end - run.begin, total_weight,
+                      squares_weight, embedding_size, output);
+}
+
+// Aggregates the runs in [start, end).
+struct EmbeddingLookupSparseTask : cpu_backend_threadpool::Task {
+  EmbeddingLookupSparseTask(const SparseLookup* lookup, const LookupRun* runs,
+                            int start, int end)
+      : lookup(lookup), runs(runs), start(start), end(end) {}
+  void Run() override {
+    for (int i = start; i < end; i++) {
+      AggregateRun(*lookup, runs[i]);
+    }
+  }
+
+ private:
+  const SparseLookup* lookup;
+  const LookupRun* runs;
+  int start;
+  int end;
+};
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
       reinterpret_cast<TfLiteEmbeddingLookupSparseParams*>(node->builtin_data);
@@ -191,17 +258,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensorRealloc(output_size * sizeof(float), output);
 
   float* output_ptr = GetTensorData<float>(output);
-  const float* weights_ptr = GetTensorData<float>(weights);
-  const float* value_ptr = GetTensorData<float>(value);
-
   std::fill_n(output_ptr, output_size, 0.0f);
 
-  // Keep track of the current bucket for aggregation/combination.
-  int current_output_offset = 0;
-  float current_total_weight = 0.0;
-  float current_squares_weight = 0.0;
-  int num_elements = 0;
-
+  // Finds the consecutive lookups aggregated into the same bucket.
+  std::vector<LookupRun> runs;
+  bool disjoint_runs = true;
   for (int i = 0; i < num_lookups; i++) {
     int idx = ids->data.i32[i];
     if (idx >= num_rows || idx < 0) {
@@ -222,36 +283,47 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     }
     const int output_offset = output_bucket * embedding_size;
 
-    // If we are in a new aggregation bucket and the combiner is not the sum,
-    // go back and finalize the result of the previous bucket.
-    if (output_offset != current_output_offset) {
-      FinalizeAggregation(params->combiner, num_elements, current_total_weight,
-                          current_squares_weight, embedding_size,
-                          &output_ptr[current_output_offset]);
-
-      // Track next bucket.
-      num_elements = 0;
-      current_total_weight = 0.0;
-      current_squares_weight = 0.0;
-      current_output_offset = output_offset;
-    }
-
-    // Add element to aggregation.
-    ++num_elements;
-    const int example_embedding_offset = idx * embedding_size;
-    const float w = weights_ptr[i];
-    current_squares_weight += w * w;
-    current_total_weight += w;
-    for (int k = 0; k < embedding_size; k++) {
-      output_ptr[current_output_offset + k] +=
-          value_ptr[example_embedding_offset + k] * w;
+    if (!runs.empty() && runs.back().output_offset == output_offset) {
+      runs.back().end = i + 1;
+    } else {
+      // A bucket revisited after another one is aggregated again on top of
+      // its finalized result, so the runs have to be aggregated in order.
+      if (!runs.empty() && runs.back().output_offset > output_offset) {
+        disjoint_runs = false;
+      }
+      runs.push_back({i, i + 1, output_offset});
     }
   }
 
-  // Finalize last bucket.
-  FinalizeAggregation(params->combiner, num_elements, current_total_weight,
-                      current_squares_weight, embedding_size,
-                      &GetTensorData<float>(output)[current_output_offset]);
+  SparseLookup lookup;
+  lookup.ids = ids->data.i32;
+  lookup.weights = GetTensorData<float>(weights);
+  lookup.value = GetTensorData<float>(value);
+  lookup.output = output_ptr;
+  lookup.embedding_size = embedding_size;
+  lookup.combiner = params->combiner;
+
+  const int num_runs = runs.size();
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  int thread_count = 1;
+  if (disjoint_runs) {
+    const size_t input_bytes =
+        static_cast<size_t>(num_lookups) * embedding_size * sizeof(float);
+    thread_count = std::min<size_t>(cpu_backend_context->max_num_threads(),
+                                    input_bytes / kMinBytesPerThread);
+    thread_count = std::max(1, std::min(thread_count, num_runs));
+  }
+  std::vector<EmbeddingLookupSparseTask> tasks;
+  tasks.reserve(thread_count);
+  int run_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int run_end = run_start + (num_runs - run_start) / (thread_count - i);
+    tasks.emplace_back(&lookup, runs.data(), run_start, run_end);
+    run_start = run_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
 
   return kTfLiteOk;
 }
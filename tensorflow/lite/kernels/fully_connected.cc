@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -74,6 +75,9 @@ struct OpData {
   // The index of the temporary tensor where the quantized inputs are cached.
   int scratch_tensor_index;
   bool compute_row_sums = false;
+  // The scale of each row of hybrid int8 weights, for multiplying them with
+  // unquantized inputs.
+  std::vector<float> row_scales;
 };
 
 constexpr int kInputTensor = 0;
@@ -216,6 +220,18 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node) {
       (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8)) {
     TfLiteIntArrayFree(node->temporaries);
     data->compute_row_sums = true;
+    const auto* affine_quantization =
+        reinterpret_cast<const TfLiteAffineQuantization*>(
+            filter->quantization.params);
+    if (filter->quantization.type == kTfLiteAffineQuantization &&
+        affine_quantization && affine_quantization->scale &&
+        affine_quantization->scale->size == num_units) {
+      data->row_scales.assign(
+          affine_quantization->scale->data,
+          affine_quantization->scale->data + num_units);
+    } else {
+      data->row_scales.assign(num_units, filter->params.scale);
+    }
     node->temporaries = TfLiteIntArrayCreate(5);
     node->temporaries->data[0] = data->scratch_tensor_index;
 
@@ -405,6 +421,21 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
     return kTfLiteOk;
   }
 
+  const int8_t* filter_data = GetTensorData<int8_t>(filter);
+  const float* input_ptr = GetTensorData<float>(input);
+  // A single input is bound by reading the weights rather than by the
+  // multiplications, so the weights are multiplied with the float input
+  // directly, which saves quantizing the input and its rounding error.
+  if (batch_size == 1) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        filter_data, num_units, input_size, data->row_scales.data(), input_ptr,
+        batch_size, GetTensorData<float>(output));
+    tensor_utils::ApplyActivationToVector(
+        GetTensorData<float>(output), batch_size * num_units,
+        params->activation, GetTensorData<float>(output));
+    return kTfLiteOk;
+  }
+
   // Quantize input from float to uint8 + quantization params (scaling factor).
   float* scaling_factors_ptr = GetTensorData<float>(scaling_factors);
   int32_t* input_offset_ptr = nullptr;
@@ -414,8 +445,6 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
     row_sums_ptr = GetTensorData<int32_t>(row_sums);
   }
   int8_t* quant_data = GetTensorData<int8_t>(input_quantized);
-  const int8_t* filter_data = GetTensorData<int8_t>(filter);
-  const float* input_ptr = GetTensorData<float>(input);
   tensor_utils::BatchQuantizeFloats(
       input_ptr, batch_size, input_size, quant_data, scaling_factors_ptr,
       input_offset_ptr, params->asymmetric_quantize_inputs);
@@ -441,10 +470,11 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
 
 namespace {
 template <KernelType kernel_type>
-void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
-                        const TfLiteTensor* filter, const TfLiteTensor* bias,
-                        TfLiteTensor* output,
-                        CpuBackendContext* cpu_backend_context) {
+TfLiteStatus FullyConnectedInt8(TfLiteContext* context, const OpData* data,
+                                const TfLiteTensor* input,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* bias, TfLiteTensor* output,
+                                CpuBackendContext* cpu_backend_context) {
   FullyConnectedParams op_params;
   op_params.input_offset = -input->params.zero_point;
   op_params.weights_offset = -filter->params.zero_point;
@@ -455,6 +485,33 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.quantized_activation_max = data->output_activation_max;
   op_params.lhs_cacheable = IsConstantTensor(filter);
   op_params.rhs_cacheable = IsConstantTensor(input);
+  if (filter->sparsity != nullptr) {
+    const auto& sparsity = *filter->sparsity;
+    if (kernel_type == kReference) {
+      reference_ops::FullyConnectedSparseWeight(
+          sparsity, op_params, GetTensorShape(input),
+          GetTensorData<int8_t>(input), GetTensorShape(filter),
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output));
+    } else if (SupportedSparsityFormat(sparsity) &&
+               sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
+               sparsity.dim_metadata[2].dense_size == 16 &&
+               filter->params.zero_point == 0) {
+      // Block sparse with block size of 1x16.
+      optimized_ops::FullyConnectedSparseWeight1x16(
+          sparsity, op_params, GetTensorShape(input),
+          GetTensorData<int8_t>(input), GetTensorShape(filter),
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output), cpu_backend_context);
+    } else {
+      TF_LITE_KERNEL_LOG(context,
+                         "Unsupported sparse fully-connected weight format.");
+      return kTfLiteError;
+    }
+    return kTfLiteOk;
+  }
   if (kernel_type == kReference) {
     reference_integer_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
@@ -469,6 +526,7 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
         GetTensorShape(output), GetTensorData<int8_t>(output),
         cpu_backend_context);
   }
+  return kTfLiteOk;
 }
 }  // namespace
 
@@ -549,10 +607,9 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         }
         break;
       case kTfLiteInt8:
-        FullyConnectedInt8<kernel_type>(
-            data, input, filter, bias, output,
+        return FullyConnectedInt8<kernel_type>(
+            context, data, input, filter, bias, output,
             CpuBackendContext::GetFromContext(context));
-        break;
       case kTfLiteInt16:
         if (input->type == kTfLiteInt16) {
           FullyConnectedInt16<kernel_type>(data, input, filter, bias, output);
@@ -20,6 +20,7 @@ limitations under the License.
 #include <stdint.h>
 
 #include <algorithm>
+#include <cmath>
 #include <initializer_list>
 #include <limits>
 #include <map>
@@ -879,6 +880,30 @@ TEST(HybridFullyConnectedOpTest, SimpleTestQuantizedInt8) {
                                  /*max_abs_error=*/1.3f)));
 }
 
+TEST(HybridFullyConnectedOpTest, SimpleTestQuantizedInt8SingleBatch) {
+  HybridFullyConnectedOpModel m(
+      /*units=*/3, /*batches=*/1,
+      /*input=*/{TensorType_FLOAT32, {1, 10}},
+      /*weights=*/{TensorType_INT8, {3, 10}, 0, 0, 10.0 / 127.0, 0});  // Hybrid
+
+  m.SetSignedWeights({
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10,  // u = 0
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10,  // u = 1
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10,  // u = 2
+  });
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({1, 2, 3, 4, 5, 6, 7, 8, -9, -10});
+
+  m.Invoke();
+
+  // A single input is not quantized, so only the rounding of the weights to
+  // multiples of 10/127 differs from the float result of {24, 25, 26}.
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({24.622, 25.622, 26.622},
+                                              /*max_abs_error=*/1e-3)));
+}
+
 TEST(HybridAsymmetricInputFullyConnectedOpTest, SimpleTestQuantizedUint8) {
   HybridFullyConnectedOpModel m(
       /*units=*/3, /*batches=*/2,
@@ -1191,6 +1216,63 @@ class SparseFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// In the sparse quantized model, the input, bias and output are quantized as in
+// the dense quantized model, and the weights symmetrically to int8.
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                       int units, int batches,
+                                       const TensorData& input,
+                                       const TensorData& weights,
+                                       const std::vector<float>& weights_data,
+                                       const TensorData& output,
+                                       int num_threads = 1)
+      : batches_(batches), units_(units) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data,
+                                   /*symmetric_quantize=*/true);
+
+    float weights_max = 0;
+    for (float weight : weights_data) {
+      weights_max = std::max(weights_max, std::abs(weight));
+    }
+    const float bias_scale = GetScale(input_) * weights_max / 127;
+    bias_ = AddInput({TensorType_INT32, {units_}, 0, 0, bias_scale});
+
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_NONE)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+
+  int batches_;
+  int units_;
+};
+
 class SparseFullyConnectedOpTest : public SingleOpTest {
  protected:
   const std::map<string, TfLiteRegistration*>& GetKernelMap() override {
@@ -1355,6 +1437,44 @@ TEST_P(SparseFullyConnectedOpTest, Simple1x4TestMultiThreadedMoreBatches) {
                                            ));
   }
 }
+TEST_P(SparseFullyConnectedOpTest, SimpleInt8With1x16Blocks) {
+  std::vector<float> weight_data(3 * 32, 0);
+  for (int i = 0; i < 16; ++i) {
+    weight_data[i] = i + 1;             // u = 0, first block
+    weight_data[32 + 16 + i] = -i - 1;  // u = 1, second block
+    weight_data[64 + 16 + i] = 2;       // u = 2, second block
+  }
+  weight_data[64] = 127;  // u = 2, first block
+  weight_data[65] = 1;
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {3, 32};
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {1};
+  weight.block_size = {16};
+  for (int num_threads = 1; num_threads <= 2; num_threads++) {
+    SparseQuantizedFullyConnectedOpModel m(
+        GetRegistration(), /*units=*/3, /*batches=*/2,
+        /*input=*/{TensorType_INT8, {2, 32}, -63.5, 64}, weight, weight_data,
+        /*output=*/{TensorType_INT8, {}, -256, 254}, num_threads);
+    m.SetBias({2, 4, -2});
+
+    std::vector<float> input(2 * 32, 1);  // b = 0
+    for (int i = 0; i < 16; ++i) {
+      input[32 + i] = 0.5;      // b = 1, first half
+      input[32 + 16 + i] = -1;  // b = 1, second half
+    }
+    m.SetInput(input);
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+    EXPECT_THAT(m.GetDequantizedOutput(),
+                ElementsAre(138, -132, 158, 70, 140, 30));
+  }
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
@@ -33,10 +33,15 @@ limitations under the License.
 
 #include <stdint.h>
 
-#include <cstdlib>
+#include <algorithm>
 #include <cstring>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/string_util.h"
@@ -47,11 +52,29 @@ namespace builtin {
 
 namespace {
 
-int greater(const void* a, const void* b) {
-  return *static_cast<const int*>(a) - *static_cast<const int*>(b);
+// The rows are only copied on several threads if each thread writes at least
+// this many output bytes.
+constexpr int kMinBytesPerThread = 64 * 1024;
+// The row of the lookup this far ahead is prefetched while copying a row.
+constexpr int kPrefetchDistance = 4;
+
+struct OpData {
+  // The rows of the keys, if the keys are constant.
+  std::unordered_map<int32_t, int> key_rows;
+  bool has_key_rows = false;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  return new OpData;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 3);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 2);
 
@@ -74,6 +97,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, NumDimensions(value), 1);
   }
 
+  // Constant keys are hashed once, rather than searched for every lookup.
+  op_data->key_rows.clear();
+  op_data->has_key_rows = IsConstantTensor(key);
+  if (op_data->has_key_rows) {
+    const int32_t* key_data = key->data.i32;
+    for (int i = 0; i < SizeOfDimension(key, 0); i++) {
+      op_data->key_rows.emplace(key_data[i], i);
+    }
+  }
+
   TfLiteTensor* hits;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 1, &hits));
   TF_LITE_ENSURE_EQ(context, hits->type, kTfLiteUInt8);
@@ -99,7 +132,43 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return status;
 }
 
+// Copies the rows of the lookups in [start, end), or zeroes them if their key
+// is missing.
+struct HashtableLookupTask : cpu_backend_threadpool::Task {
+  HashtableLookupTask(const int* rows, const char* value_raw, size_t row_bytes,
+                      char* output_raw, int start, int end)
+      : rows(rows),
+        value_raw(value_raw),
+        row_bytes(row_bytes),
+        output_raw(output_raw),
+        start(start),
+        end(end) {}
+  void Run() override {
+    for (int i = start; i < end; i++) {
+      if (i + kPrefetchDistance < end && rows[i + kPrefetchDistance] >= 0) {
+        optimized_ops_preload_l1_stream(
+            value_raw + rows[i + kPrefetchDistance] * row_bytes);
+      }
+      if (rows[i] < 0) {
+        memset(output_raw + i * row_bytes, 0, row_bytes);
+      } else {
+        memcpy(output_raw + i * row_bytes, value_raw + rows[i] * row_bytes,
+               row_bytes);
+      }
+    }
+  }
+
+ private:
+  const int* rows;
+  const char* value_raw;
+  size_t row_bytes;
+  char* output_raw;
+  int start;
+  int end;
+};
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
   TfLiteTensor* hits;
@@ -112,46 +181,64 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 2, &value));
 
   const int num_rows = SizeOfDimension(value, 0);
-  const int row_bytes = value->bytes / num_rows;
-  void* pointer = nullptr;
-  DynamicBuffer buf;
-
-  for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
-    int idx = -1;
-    pointer = bsearch(&(lookup->data.i32[i]), key->data.i32, num_rows,
-                      sizeof(int32_t), greater);
-    if (pointer != nullptr) {
-      idx = (reinterpret_cast<char*>(pointer) - (key->data.raw)) /
-            sizeof(int32_t);
+  const int num_lookups = SizeOfDimension(lookup, 0);
+
+  // Finds the row of each lookup, or -1 if its key is missing.
+  std::vector<int> rows(num_lookups, -1);
+  const int32_t* key_data = key->data.i32;
+  for (int i = 0; i < num_lookups; i++) {
+    const int32_t lookup_key = lookup->data.i32[i];
+    if (op_data->has_key_rows) {
+      auto it = op_data->key_rows.find(lookup_key);
+      if (it != op_data->key_rows.end()) rows[i] = it->second;
+    } else {
+      const int32_t* it =
+          std::lower_bound(key_data, key_data + num_rows, lookup_key);
+      if (it != key_data + num_rows && *it == lookup_key) {
+        rows[i] = it - key_data;
+      }
     }
+    hits->data.uint8[i] = rows[i] >= 0 ? 1 : 0;
+  }
 
-    if (idx >= num_rows || idx < 0) {
-      if (output->type == kTfLiteString) {
+  if (output->type == kTfLiteString) {
+    DynamicBuffer buf;
+    for (int i = 0; i < num_lookups; i++) {
+      if (rows[i] < 0) {
         buf.AddString(nullptr, 0);
       } else {
-        memset(output->data.raw + i * row_bytes, 0, row_bytes);
+        buf.AddString(GetString(value, rows[i]));
       }
-      hits->data.uint8[i] = 0;
-    } else {
-      if (output->type == kTfLiteString) {
-        buf.AddString(GetString(value, idx));
-      } else {
-        memcpy(output->data.raw + i * row_bytes,
-               value->data.raw + idx * row_bytes, row_bytes);
-      }
-      hits->data.uint8[i] = 1;
     }
-  }
-  if (output->type == kTfLiteString) {
     buf.WriteToTensorAsVector(output);
+    return kTfLiteOk;
+  }
+
+  const size_t row_bytes = num_rows > 0 ? value->bytes / num_rows : 0;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const size_t output_bytes = static_cast<size_t>(num_lookups) * row_bytes;
+  int thread_count = std::min<size_t>(cpu_backend_context->max_num_threads(),
+                                      output_bytes / kMinBytesPerThread);
+  thread_count = std::max(1, std::min(thread_count, num_lookups));
+  std::vector<HashtableLookupTask> tasks;
+  tasks.reserve(thread_count);
+  int start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int end = start + (num_lookups - start) / (thread_count - i);
+    tasks.emplace_back(rows.data(), value->data.raw, row_bytes,
+                       output->data.raw, start, end);
+    start = end;
   }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
 
   return kTfLiteOk;
 }
 }  // namespace
 
 TfLiteRegistration* Register_HASHTABLE_LOOKUP() {
-  static TfLiteRegistration r = {nullptr, nullptr, Prepare, Eval};
+  static TfLiteRegistration r = {Init, Free, Prepare, Eval};
   return &r;
 }
 
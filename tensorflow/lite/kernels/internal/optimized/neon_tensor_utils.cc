@@ -1273,6 +1273,42 @@ void NeonMatrixBatchVectorMultiplyAccumulate(const int8_t* __restrict__ matrix,
                                           scaling_factors, n_batch, result);
 }
 
+void NeonMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const float* __restrict__ row_scales, const float* __restrict__ vectors,
+    int n_batch, float* __restrict__ result) {
+  static const int kWeightsPerNeonLane = 8;
+  const int postamble_start = RoundDownVectors<kWeightsPerNeonLane>(m_cols);
+  for (int row = 0; row < m_rows; ++row) {
+    const int8_t* row_ptr = matrix + row * m_cols;
+    // The weights of a row are read once for all the batches.
+    for (int batch = 0; batch < n_batch; ++batch) {
+      const float* vector = vectors + batch * m_cols;
+      float32x4_t acc0_f32x4 = vmovq_n_f32(0.0f);
+      float32x4_t acc1_f32x4 = vmovq_n_f32(0.0f);
+      int col = 0;
+      for (; col < postamble_start; col += kWeightsPerNeonLane) {
+        // Widen 8 weights to float and multiply them with 8 vector values.
+        const int16x8_t weights_s16x8 = vmovl_s8(vld1_s8(row_ptr + col));
+        const float32x4_t weights0_f32x4 =
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(weights_s16x8)));
+        const float32x4_t weights1_f32x4 =
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(weights_s16x8)));
+        acc0_f32x4 =
+            vmlaq_f32(acc0_f32x4, weights0_f32x4, vld1q_f32(vector + col));
+        acc1_f32x4 =
+            vmlaq_f32(acc1_f32x4, weights1_f32x4,
+                      vld1q_f32(vector + col + kFloatValuesPerNeonVector));
+      }
+      float dotprod = AccumulateNeonLane(vaddq_f32(acc0_f32x4, acc1_f32x4));
+      for (; col < m_cols; ++col) {
+        dotprod += row_ptr[col] * vector[col];
+      }
+      result[batch * m_rows + row] += dotprod * row_scales[row];
+    }
+  }
+}
+
 void NeonMatrixScalarMultiplyAccumulate(const int8_t* matrix, int32_t scalar,
                                         int32_t n_row, int32_t n_col,
                                         int32_t* output) {
@@ -1989,6 +2025,65 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  const int kBlockSize = 16;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  // The vector values plus the input offset fit in 16 bits.
+  const int16x8_t input_offset_16x8 =
+      vdupq_n_s16(static_cast<int16_t>(input_offset));
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* matrix_ptr = matrix;
+    for (int row = 0; row < m_rows; ++row) {
+      int32x4_t acc0_32x4 = vmovq_n_s32(0);
+      int32x4_t acc1_32x4 = vmovq_n_s32(0);
+      const int8_t* vector_in_batch = vector + batch * m_cols;
+
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int block_start_index = indices[i] * kBlockSize;
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + block_start_index;
+
+        // Load 16 int8 values from the vector and matrix row, and widen them
+        // to 16 bits, offsetting the vector ones.
+        const int8x16_t vector_8x16 = vld1q_s8(vector_block_in_batch_ptr);
+        const int8x16_t matrix_8x16 = vld1q_s8(matrix_ptr);
+        const int16x8_t vector_lo_16x8 =
+            vaddq_s16(vmovl_s8(vget_low_s8(vector_8x16)), input_offset_16x8);
+        const int16x8_t vector_hi_16x8 =
+            vaddq_s16(vmovl_s8(vget_high_s8(vector_8x16)), input_offset_16x8);
+        const int16x8_t matrix_lo_16x8 = vmovl_s8(vget_low_s8(matrix_8x16));
+        const int16x8_t matrix_hi_16x8 = vmovl_s8(vget_high_s8(matrix_8x16));
+        // Multiply the vector and matrix row and add to the accumulators.
+        acc0_32x4 = vmlal_s16(acc0_32x4, vget_low_s16(matrix_lo_16x8),
+                              vget_low_s16(vector_lo_16x8));
+        acc1_32x4 = vmlal_s16(acc1_32x4, vget_high_s16(matrix_lo_16x8),
+                              vget_high_s16(vector_lo_16x8));
+        acc0_32x4 = vmlal_s16(acc0_32x4, vget_low_s16(matrix_hi_16x8),
+                              vget_low_s16(vector_hi_16x8));
+        acc1_32x4 = vmlal_s16(acc1_32x4, vget_high_s16(matrix_hi_16x8),
+                              vget_high_s16(vector_hi_16x8));
+        matrix_ptr += kBlockSize;
+      }
+      int32_t dot_prod = AccumulateNeonLane(vaddq_s32(acc0_32x4, acc1_32x4));
+      const int32_t bias_value = bias_vector != nullptr ? bias_vector[row] : 0;
+      dot_prod = MultiplyByQuantizedMultiplier(dot_prod + bias_value,
+                                               output_multiplier, output_shift);
+      dot_prod += output_offset;
+      result[batch * m_rows + row] =
+          static_cast<int8_t>(ActivationFunctionWithMinMax(
+              dot_prod, output_activation_min, output_activation_max));
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
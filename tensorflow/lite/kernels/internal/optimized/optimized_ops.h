@@ -1351,6 +1351,8 @@ inline void Conv(const ConvParams& params, const RuntimeShape& input_shape,
   lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
   lhs_params.rows = n;
   lhs_params.cols = k;
+  lhs_params.cache_policy =
+      cpu_backend_gemm::DefaultCachePolicy(params.lhs_cacheable);
   cpu_backend_gemm::MatrixParams<float> rhs_params;
   rhs_params.order = cpu_backend_gemm::Order::kColMajor;
   rhs_params.rows = k;
@@ -1647,6 +1649,8 @@ inline void Conv(const ConvParams& params, const RuntimeShape& input_shape,
   lhs_params.cols = filter_cols;
   lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
   lhs_params.zero_point = -filter_offset;
+  lhs_params.cache_policy =
+      cpu_backend_gemm::DefaultCachePolicy(params.lhs_cacheable);
   cpu_backend_gemm::MatrixParams<uint8> rhs_params;
   rhs_params.rows = gemm_input_rows;
   rhs_params.cols = gemm_input_cols;
@@ -3223,66 +3227,209 @@ inline int NodeOffset(int b, int h, int w, int height, int width) {
   return (b * height + h) * width + w;
 }
 
-inline void AveragePool(const PoolParams& params,
+// Float pooling can run with multiple threads on the dim specified by
+// thread_dim, as for DepthwiseConv: each thread computes the output elements
+// on dim thread_dim (0 for batches, 1 for rows) in [thread_start, thread_end).
+inline void AveragePoolImpl(const PoolParams& params,
+                            const RuntimeShape& input_shape,
+                            const float* input_data,
+                            const RuntimeShape& output_shape,
+                            float* output_data, int thread_start,
+                            int thread_end, int thread_dim) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int batch_start = thread_dim == 0 ? thread_start : 0;
+  const int batch_end = thread_dim == 0 ? thread_end : batches;
+  const int out_y_start = thread_dim == 1 ? thread_start : 0;
+  const int out_y_end = thread_dim == 1 ? thread_end : output_height;
+
+  const auto in_mat = MapAsMatrixWithLastDimAsRows(input_data, input_shape);
+  auto out_mat = MapAsMatrixWithLastDimAsRows(output_data, output_shape);
+  for (int b = batch_start; b < batch_end; ++b) {
+    for (int out_y = out_y_start; out_y < out_y_end; ++out_y) {
+      const int in_y_origin =
+          out_y * params.stride_height - params.padding_values.height;
+      const int filter_y_start = std::max(0, -in_y_origin);
+      const int filter_y_end =
+          std::min(params.filter_height, input_height - in_y_origin);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            out_x * params.stride_width - params.padding_values.width;
+        const int filter_x_start = std::max(0, -in_x_origin);
+        const int filter_x_end =
+            std::min(params.filter_width, input_width - in_x_origin);
+        const int filter_count =
+            (filter_y_end - filter_y_start) * (filter_x_end - filter_x_start);
+        TFLITE_DCHECK_GT(filter_count, 0);
+        auto out_col =
+            out_mat.col(NodeOffset(b, out_y, out_x, output_height,
+                                   output_width));
+        out_col.setZero();
+        for (int fy = filter_y_start; fy < filter_y_end; ++fy) {
+          for (int fx = filter_x_start; fx < filter_x_end; ++fx) {
+            out_col += in_mat.col(NodeOffset(b, in_y_origin + fy,
+                                             in_x_origin + fx, input_height,
+                                             input_width));
+          }
+        }
+        // Divide by the actual number of elements being averaged over.
+        out_col.array() = (out_col.array() / static_cast<float>(filter_count))
+                              .max(params.float_activation_min)
+                              .min(params.float_activation_max);
+      }
+    }
+  }
+}
+
+inline void MaxPoolImpl(const PoolParams& params,
                         const RuntimeShape& input_shape,
                         const float* input_data,
-                        const RuntimeShape& output_shape, float* output_data) {
-  ruy::profiler::ScopeLabel label("AveragePool");
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+                        const RuntimeShape& output_shape, float* output_data,
+                        int thread_start, int thread_end, int thread_dim) {
   const int batches = MatchingDim(input_shape, 0, output_shape, 0);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
   const int output_height = output_shape.Dims(1);
   const int output_width = output_shape.Dims(2);
-  const int stride_height = params.stride_height;
-  const int stride_width = params.stride_width;
+  const int batch_start = thread_dim == 0 ? thread_start : 0;
+  const int batch_end = thread_dim == 0 ? thread_end : batches;
+  const int out_y_start = thread_dim == 1 ? thread_start : 0;
+  const int out_y_end = thread_dim == 1 ? thread_end : output_height;
 
-  // TODO(benoitjacob) make this a proper reference impl without Eigen!
   const auto in_mat = MapAsMatrixWithLastDimAsRows(input_data, input_shape);
   auto out_mat = MapAsMatrixWithLastDimAsRows(output_data, output_shape);
-  // TODO(benoitjacob) get rid of the dynamic memory allocation here!
-  Eigen::VectorXf out_count(out_mat.cols());
-  out_count.setZero();
-  // Prefill the output to 0.
-  out_mat.setZero();
-  for (int b = 0; b < batches; ++b) {
-    for (int h = 0; h < input_height; ++h) {
-      for (int w = 0; w < input_width; ++w) {
-        // (h_start, h_end) * (w_start, w_end) is the range that the input
-        // vector projects to.
-        int hpad = h + params.padding_values.height;
-        int wpad = w + params.padding_values.width;
-        int h_start = (hpad < params.filter_height)
-                          ? 0
-                          : (hpad - params.filter_height) / stride_height + 1;
-        int h_end = std::min(hpad / stride_height + 1, output_height);
-        int w_start = (wpad < params.filter_width)
-                          ? 0
-                          : (wpad - params.filter_width) / stride_width + 1;
-        int w_end = std::min(wpad / stride_width + 1, output_width);
-        // compute elementwise sum
-        for (int ph = h_start; ph < h_end; ++ph) {
-          for (int pw = w_start; pw < w_end; ++pw) {
-            int out_offset = NodeOffset(b, ph, pw, output_height, output_width);
-            out_mat.col(out_offset) +=
-                in_mat.col(NodeOffset(b, h, w, input_height, input_width));
-            out_count(out_offset)++;
+  for (int b = batch_start; b < batch_end; ++b) {
+    for (int out_y = out_y_start; out_y < out_y_end; ++out_y) {
+      const int in_y_origin =
+          out_y * params.stride_height - params.padding_values.height;
+      const int filter_y_start = std::max(0, -in_y_origin);
+      const int filter_y_end =
+          std::min(params.filter_height, input_height - in_y_origin);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            out_x * params.stride_width - params.padding_values.width;
+        const int filter_x_start = std::max(0, -in_x_origin);
+        const int filter_x_end =
+            std::min(params.filter_width, input_width - in_x_origin);
+        auto out_col =
+            out_mat.col(NodeOffset(b, out_y, out_x, output_height,
+                                   output_width));
+        // Prefill the output to minimum representable float value.
+        out_col.setConstant(std::numeric_limits<float>::lowest());
+        for (int fy = filter_y_start; fy < filter_y_end; ++fy) {
+          for (int fx = filter_x_start; fx < filter_x_end; ++fx) {
+            out_col = out_col.cwiseMax(in_mat.col(
+                NodeOffset(b, in_y_origin + fy, in_x_origin + fx,
+                           input_height, input_width)));
           }
         }
+        out_col.array() = out_col.array()
+                              .max(params.float_activation_min)
+                              .min(params.float_activation_max);
       }
     }
   }
-  // Divide the output by the actual number of elements being averaged over
-  TFLITE_DCHECK_GT(out_count.minCoeff(), 0);
-  out_mat.array().rowwise() /= out_count.transpose().array();
+}
 
-  const int flat_size = output_shape.FlatSize();
-  for (int i = 0; i < flat_size; ++i) {
-    output_data[i] = ActivationFunctionWithMinMax(output_data[i],
-                                                  params.float_activation_min,
-                                                  params.float_activation_max);
+using FloatPoolImplFunction = void (*)(const PoolParams&, const RuntimeShape&,
+                                       const float*, const RuntimeShape&,
+                                       float*, int, int, int);
+
+struct FloatPoolWorkerTask : cpu_backend_threadpool::Task {
+  FloatPoolWorkerTask(FloatPoolImplFunction impl, const PoolParams& params,
+                      const RuntimeShape& input_shape,
+                      const float* input_data,
+                      const RuntimeShape& output_shape, float* output_data,
+                      int thread_start, int thread_end, int thread_dim)
+      : impl(impl),
+        params(params),
+        input_shape(input_shape),
+        input_data(input_data),
+        output_shape(output_shape),
+        output_data(output_data),
+        thread_start(thread_start),
+        thread_end(thread_end),
+        thread_dim(thread_dim) {}
+  void Run() override {
+    impl(params, input_shape, input_data, output_shape, output_data,
+         thread_start, thread_end, thread_dim);
   }
+
+ private:
+  FloatPoolImplFunction impl;
+  const PoolParams& params;
+  const RuntimeShape& input_shape;
+  const float* input_data;
+  const RuntimeShape& output_shape;
+  float* output_data;
+  int thread_start;
+  int thread_end;
+  int thread_dim;
+};
+
+// Runs a float pooling `impl` over the whole output, splitting it across the
+// threads of `cpu_backend_context` along batches or, when there are fewer
+// batches than threads (e.g. batch 1 on mobile), along output rows.
+inline void FloatPool(FloatPoolImplFunction impl, const PoolParams& params,
+                      const RuntimeShape& input_shape, const float* input_data,
+                      const RuntimeShape& output_shape, float* output_data,
+                      CpuBackendContext* cpu_backend_context) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int output_height = output_shape.Dims(1);
+  // How many window elements are needed to make it worth using one more
+  // thread.
+  constexpr int kMinElementsPerThread = 1 << 14;  // 16k
+  const int num_elements =
+      output_shape.FlatSize() * params.filter_height * params.filter_width;
+  int thread_count = std::max(1, num_elements / kMinElementsPerThread);
+  thread_count =
+      cpu_backend_context == nullptr
+          ? 1
+          : std::min(thread_count, cpu_backend_context->max_num_threads());
+  if (thread_count == 1) {
+    impl(params, input_shape, input_data, output_shape, output_data,
+         /*thread_start=*/0, /*thread_end=*/batches, /*thread_dim=*/0);
+    return;
+  }
+  int thread_dim, thread_dim_size;
+  if (batches >= thread_count) {
+    thread_dim = 0;
+    thread_dim_size = batches;
+  } else {
+    thread_dim = 1;
+    thread_dim_size = output_height;
+  }
+  thread_count = std::min(thread_count, thread_dim_size);
+  std::vector<FloatPoolWorkerTask> tasks;
+  // TODO(b/131746020) don't create new heap allocations every time.
+  // At least we make it a single heap allocation by using reserve().
+  tasks.reserve(thread_count);
+  int thread_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    // Try to distribute the tasks as even as possible.
+    int thread_end =
+        thread_start + (thread_dim_size - thread_start) / (thread_count - i);
+    tasks.emplace_back(impl, params, input_shape, input_data, output_shape,
+                       output_data, thread_start, thread_end, thread_dim);
+    thread_start = thread_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+inline void AveragePool(const PoolParams& params,
+                        const RuntimeShape& input_shape,
+                        const float* input_data,
+                        const RuntimeShape& output_shape, float* output_data,
+                        CpuBackendContext* cpu_backend_context = nullptr) {
+  ruy::profiler::ScopeLabel label("AveragePool");
+  FloatPool(AveragePoolImpl, params, input_shape, input_data, output_shape,
+            output_data, cpu_backend_context);
 }
 
 inline void AveragePool16(const PoolParams& params,
@@ -3568,56 +3715,11 @@ inline void AveragePool(const PoolParams& params,
 
 inline void MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
                     const float* input_data, const RuntimeShape& output_shape,
-                    float* output_data) {
+                    float* output_data,
+                    CpuBackendContext* cpu_backend_context = nullptr) {
   ruy::profiler::ScopeLabel label("MaxPool");
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
-  const int input_height = input_shape.Dims(1);
-  const int input_width = input_shape.Dims(2);
-  const int output_height = output_shape.Dims(1);
-  const int output_width = output_shape.Dims(2);
-  const int stride_height = params.stride_height;
-  const int stride_width = params.stride_width;
-
-  const auto in_mat = MapAsMatrixWithLastDimAsRows(input_data, input_shape);
-  auto out_mat = MapAsMatrixWithLastDimAsRows(output_data, output_shape);
-  // Prefill the output to minimum representable float value
-  out_mat.setConstant(std::numeric_limits<float>::lowest());
-  for (int b = 0; b < batches; ++b) {
-    for (int h = 0; h < input_height; ++h) {
-      for (int w = 0; w < input_width; ++w) {
-        // (h_start, h_end) * (w_start, w_end) is the range that the input
-        // vector projects to.
-        int hpad = h + params.padding_values.height;
-        int wpad = w + params.padding_values.width;
-        int h_start = (hpad < params.filter_height)
-                          ? 0
-                          : (hpad - params.filter_height) / stride_height + 1;
-        int h_end = std::min(hpad / stride_height + 1, output_height);
-        int w_start = (wpad < params.filter_width)
-                          ? 0
-                          : (wpad - params.filter_width) / stride_width + 1;
-        int w_end = std::min(wpad / stride_width + 1, output_width);
-        // compute elementwise sum
-        for (int ph = h_start; ph < h_end; ++ph) {
-          for (int pw = w_start; pw < w_end; ++pw) {
-            int out_offset = NodeOffset(b, ph, pw, output_height, output_width);
-            out_mat.col(out_offset) =
-                out_mat.col(out_offset)
-                    .cwiseMax(in_mat.col(
-                        NodeOffset(b, h, w, input_height, input_width)));
-          }
-        }
-      }
-    }
-  }
-  const int flat_size = output_shape.FlatSize();
-  for (int i = 0; i < flat_size; ++i) {
-    output_data[i] = ActivationFunctionWithMinMax(output_data[i],
-                                                  params.float_activation_min,
-                                                  params.float_activation_max);
-  }
+  FloatPool(MaxPoolImpl, params, input_shape, input_data, output_shape,
+            output_data, cpu_backend_context);
 }
 
 inline void MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
@@ -199,6 +199,38 @@ void SparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ scaling_factors, int n_batch,
     float* __restrict__ result);
 
+// Multiplies a sparse int8 matrix with block pattern 1x16, stored in the
+// format of SparseMatrixBatchVectorMultiplyAccumulate1x4, by int8 vectors as
+// in a fully quantized fully-connected layer: 'input_offset' is added to the
+// vector values and the optional 'bias_vector' to the products, which are then
+// requantized with 'output_multiplier', 'output_shift' and 'output_offset',
+// clamped to the activation range and stored (not accumulated) into the
+// result buffer.
+// This function assumes that m_cols is a multiple of the block size (16 in
+// this case) so that there's no incomplete block.
+void SparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
+// Multiplies a matrix of symmetrically quantized weights by float vectors, and
+// accumulates the products of each row, scaled by its entry of 'row_scales',
+// into the result buffer. Unlike the hybrid functions above, the vectors are
+// not quantized, so this reads the weights in place without any scratch.
+// Parameters:
+//     - matrix: int8 matrix of size m_rows * m_cols
+//     - row_scales: the quantization scale of each row of the matrix
+//     - vectors: float vectors of size n_batch * m_cols
+//     - result: float result of size n_batch * m_rows
+void MatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const float* __restrict__ row_scales, const float* __restrict__ vectors,
+    int n_batch, float* __restrict__ result);
+
 // Multiplies a matrix by a "batched" vector (i.e. a matrix with a batch
 // dimension composed by input vectors independent from each other). The result
 // of the multiplication is accumulated to the passed result buffer.
@@ -670,6 +670,28 @@ TEST(uKernels, MatrixScalarMultiplyAccumulateTest) {
   EXPECT_THAT(output, testing::ElementsAreArray(expected_output));
 }
 
+// Quantized weights with float vectors, 3 * 11 matrix and 2 batches.
+TEST(uKernels, MatrixBatchVectorMultiplyAccumulateFloatVectorsTest) {
+  const std::vector<int8_t> matrix = {
+      1,   -2,   3,  -4, 5,  -6, 7,  -8, 9,  -10, 11,  // row 0
+      127, -128, 0,  1,  2,  3,  4,  5,  6,  7,   8,   // row 1
+      -1,  -1,   -1, -1, -1, -1, -1, -1, -1, -1,  -1,  // row 2
+  };
+  const std::vector<float> row_scales = {0.5, 0.25, 2.0};
+  const std::vector<float> vectors = {
+      0.5, 1, -1.5, 2, 0.25, -0.5, 1, 2, -2, 0.5, 1,  // batch 0
+      1,   0, 0,    0, 0,    0,    0, 0, 0,  0,   -1,  // batch 1
+  };
+  std::vector<float> output = {1, 2, 3, 4, 5, 6};
+
+  MatrixBatchVectorMultiplyAccumulate(matrix.data(), /*m_rows=*/3,
+                                      /*m_cols=*/11, row_scales.data(),
+                                      vectors.data(), /*n_batch=*/2,
+                                      output.data());
+  EXPECT_THAT(output, ElementsAreArray(ArrayFloatNear(
+                          {-14.375, -10.5, -5.5, -1.0, 34.75, 6.0})));
+}
+
 // Quantized layer norm of n_batch = 2 and n_input = 15.
 TEST(uKernels, QuantApplyLayerNormTest) {
   const std::vector<int16_t> input = {
@@ -838,6 +838,8 @@ struct ConvParams {
   // float activation params.
   float float_activation_min;
   float float_activation_max;
+  // Mark the filter as cacheable if it is unchanging, e.g. constant weights.
+  bool lhs_cacheable = false;
 };
 
 struct DepthToSpaceParams {
@@ -171,14 +171,18 @@ inline int64_t NumElements(const TfLiteTensor* t) {
 }
 
 // Determines whether tensor is constant.
-// TODO(b/138199592): Introduce new query which checks for constant OR
-// persistent-read-only, which would be useful for most tensor kernels that
-// are potentially dynamic based on the input tensor value availability at the
-// time of prepare.
 inline bool IsConstantTensor(const TfLiteTensor* tensor) {
   return tensor->allocation_type == kTfLiteMmapRo;
 }
 
+// Determines whether tensor is constant or persistent-read-only, i.e. whether
+// its value is already available when the ops consuming it are prepared, e.g.
+// for the output of Shape.
+inline bool IsConstantOrPersistentTensor(const TfLiteTensor* tensor) {
+  return tensor->allocation_type == kTfLiteMmapRo ||
+         tensor->allocation_type == kTfLitePersistentRo;
+}
+
 // Determines whether tensor is dynamic. Note that a tensor can be non-const and
 // not dynamic. This function specifically checks for a dynamic tensor.
 inline bool IsDynamicTensor(const TfLiteTensor* tensor) {
@@ -127,6 +127,43 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
   return tensor == nullptr ? 1.0f : tensor->params.scale;
 }
 
+// Initializes an LSTM gate with the contribution of the inputs, i.e. the
+// terms of the formula of CalculateLstmGateFloat() which don't depend on the
+// state:
+//   gate = W_input * input + W_aux * aux_input + bias
+// with layer norm, the bias is added after normalizing, so
+//   gate = W_input * input + W_aux * aux_input
+// Since the terms of the batches are independent, the gates of several time
+// steps can be initialized at once by passing their inputs as batches.
+inline void InitializeLstmGateFloat(
+    const float* input, const float* input_to_gate_weights,
+    const float* aux_input, const float* aux_input_to_gate_weights,
+    const float* layer_norm_coefficients, const float* gate_bias,
+    const int n_batch, const int n_input, const int n_aux_input,
+    const int n_cell, float* gate, const bool is_input_all_zeros,
+    const bool is_aux_input_all_zeros) {
+  // Initialize scratch buffers with bias for regular lstm or initialize with
+  // zero for layer norm lstm.
+  if (layer_norm_coefficients != nullptr) {
+    std::fill_n(gate, n_cell * n_batch, 0.0f);
+  } else {
+    tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
+  }
+  // For each batch and cell: compute input_weight * input.
+  // Skip if input is all zeros.
+  if (!is_input_all_zeros) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
+  }
+  // For each batch and cell: compute aux_input_weight * aux_input.
+  // Skip if auxiliary input is not available or all zeros.
+  if (!is_aux_input_all_zeros) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(aux_input_to_gate_weights,
+                                                      n_cell, n_aux_input,
+                                                      aux_input, n_batch, gate);
+  }
+}
+
 // LINT.IfChange
 // Calculates a single LSTM gate.
 //
@@ -160,6 +197,8 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
 //   activation                                 - activation to use.
 //   is_input_all_zeros, is_aux_input_all_zeros - if input vectors are all zero.
 //   use_layer_norm                             - if doing layer norm LSTM.
+//   is_input_precomputed - if 'gate' already holds the contribution of the
+//                          inputs, from InitializeLstmGateFloat().
 inline void CalculateLstmGateFloat(
     const float* input, const float* input_to_gate_weights,
     const float* aux_input, const float* aux_input_to_gate_weights,
@@ -169,29 +208,16 @@ inline void CalculateLstmGateFloat(
     const int n_batch, const int n_input, const int n_aux_input,
     const int n_output, const int n_cell,
     const TfLiteFusedActivation activation, float* gate,
-    const bool is_input_all_zeros, const bool is_aux_input_all_zeros) {
+    const bool is_input_all_zeros, const bool is_aux_input_all_zeros,
+    const bool is_input_precomputed) {
   const bool use_peephole = (cell_to_gate_weights != nullptr);
   const bool use_layer_norm = (layer_norm_coefficients != nullptr);
 
-  // Initialize scratch buffers with bias for regular lstm or initialize with
-  // zero for layer norm lstm.
-  if (use_layer_norm) {
-    std::fill_n(gate, n_cell * n_batch, 0.0f);
-  } else {
-    tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
-  }
-  // For each batch and cell: compute input_weight * input.
-  // Skip if input is all zeros.
-  if (!is_input_all_zeros) {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
-  }
-  // For each batch and cell: compute aux_input_weight * aux_input.
-  // Skip if auxiliary input is not available or all zeros.
-  if (!is_aux_input_all_zeros) {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(aux_input_to_gate_weights,
-                                                      n_cell, n_aux_input,
-                                                      aux_input, n_batch, gate);
+  if (!is_input_precomputed) {
+    InitializeLstmGateFloat(input, input_to_gate_weights, aux_input,
+                            aux_input_to_gate_weights, layer_norm_coefficients,
+                            gate_bias, n_batch, n_input, n_aux_input, n_cell,
+                            gate, is_input_all_zeros, is_aux_input_all_zeros);
   }
   // For each batch and cell: compute recurrent_weight * output_state.
   tensor_utils::MatrixBatchVectorMultiplyAccumulate(
@@ -817,6 +843,9 @@ void CalculateLstmOutputInteger8x8_8(
 // for bidirectional LSTMs with merge_outputs. In this case, the batched
 // operations cannot be used since they assume that the batched outputs are
 // contiguous, and we manually loop over the batched outputs.
+//
+// If is_input_precomputed, the scratch buffers of the gates already hold the
+// contribution of the inputs, and the inputs aren't read.
 // LINT.IfChange
 inline void LstmStepFloat(
     const float* input_ptr, const float* input_to_input_weights_ptr,
@@ -844,7 +873,8 @@ inline void LstmStepFloat(
     const TfLiteLSTMParams* params, int n_batch, int n_cell, int n_input,
     int n_aux_input, int n_output, int output_batch_leading_dim,
     float* output_state_ptr, float* cell_state_ptr, float* scratch0,
-    float* scratch1, float* scratch2, float* scratch3, float* output_ptr) {
+    float* scratch1, float* scratch2, float* scratch3, float* output_ptr,
+    bool is_input_precomputed) {
   ruy::profiler::ScopeLabel label("LstmStepFloat");
   // Since we have already checked that weights are all there or none, we can
   // check the existence of only one to the get the condition.
@@ -858,9 +888,10 @@ inline void LstmStepFloat(
 
   // Check if inputs are all zeros so we can skip some computations.
   const bool is_input_all_zeros =
+      is_input_precomputed ||
       tensor_utils::IsZeroVector(input_ptr, n_batch * n_input);
   const bool is_aux_input_all_zeros =
-      (aux_input_ptr == nullptr ||
+      (is_input_precomputed || aux_input_ptr == nullptr ||
        tensor_utils::IsZeroVector(aux_input_ptr, n_batch * n_aux_input));
   if (!use_cifg) {
     // Calculate the input gate. (If not CIFG.)
@@ -871,7 +902,7 @@ inline void LstmStepFloat(
         cell_to_input_weights_ptr, input_layer_norm_coefficients_ptr,
         input_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
         /*activation=*/kTfLiteActSigmoid, input_gate_scratch,
-        is_input_all_zeros, is_aux_input_all_zeros);
+        is_input_all_zeros, is_aux_input_all_zeros, is_input_precomputed);
   }
   // Calculate the forget gate.
   CalculateLstmGateFloat(
@@ -881,7 +912,7 @@ inline void LstmStepFloat(
       cell_to_forget_weights_ptr, forget_layer_norm_coefficients_ptr,
       forget_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, forget_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, is_input_precomputed);
   // Calculate the cell update gate.
   CalculateLstmGateFloat(input_ptr, input_to_cell_weights_ptr, aux_input_ptr,
                          aux_input_to_cell_weights_ptr, output_state_ptr,
@@ -890,7 +921,8 @@ inline void LstmStepFloat(
                          cell_layer_norm_coefficients_ptr, cell_gate_bias_ptr,
                          n_batch, n_input, n_aux_input, n_output, n_cell,
                          params->activation, cell_gate_scratch,
-                         is_input_all_zeros, is_aux_input_all_zeros);
+                         is_input_all_zeros, is_aux_input_all_zeros,
+                         is_input_precomputed);
   // Update the cell state.
   UpdateLstmCellFloat(n_batch, n_cell, cell_state_ptr, input_gate_scratch,
                       forget_gate_scratch, cell_gate_scratch, use_cifg,
@@ -903,7 +935,7 @@ inline void LstmStepFloat(
       cell_to_output_weights_ptr, output_layer_norm_coefficients_ptr,
       output_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, output_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, is_input_precomputed);
   // Update the output state.
   CalculateLstmOutputFloat(n_batch, n_cell, n_output, cell_state_ptr,
                            output_gate_scratch, params->activation,
@@ -1745,6 +1777,17 @@ TfLiteStatus EvalFloat(
   // check the existence of only one to the get the condition.
   const bool use_cifg = (input_to_input_weights == nullptr);
 
+  // If the scratch buffer has room for the gates of all the time steps, the
+  // contributions of the inputs to the gates are computed for the whole
+  // sequence at once before the recurrence, as larger matrix multiplications,
+  // and each step only adds the contributions of the state.
+  const int n_gates = use_cifg ? 3 : 4;
+  const bool precompute_input_gates =
+      max_time > 1 && scratch_buffer->bytes >= n_gates * n_cell * n_batch *
+                                                 max_time * sizeof(float);
+  const int gate_scratch_size =
+      n_cell * n_batch * (precompute_input_gates ? max_time : 1);
+
   // Index the scratch buffers pointers to the global scratch buffer.
   float* scratch_buffer_ptr = GetTensorData<float>(scratch_buffer);
   float* input_gate_scratch = nullptr;
@@ -1753,13 +1796,51 @@ TfLiteStatus EvalFloat(
   float* output_gate_scratch = nullptr;
   if (use_cifg) {
     cell_gate_scratch = scratch_buffer_ptr;
-    forget_gate_scratch = scratch_buffer_ptr + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer_ptr + 2 * n_cell * n_batch;
+    forget_gate_scratch = scratch_buffer_ptr + gate_scratch_size;
+    output_gate_scratch = scratch_buffer_ptr + 2 * gate_scratch_size;
   } else {
     input_gate_scratch = scratch_buffer_ptr;
-    cell_gate_scratch = scratch_buffer_ptr + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer_ptr + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer_ptr + 3 * n_cell * n_batch;
+    cell_gate_scratch = scratch_buffer_ptr + gate_scratch_size;
+    forget_gate_scratch = scratch_buffer_ptr + 2 * gate_scratch_size;
+    output_gate_scratch = scratch_buffer_ptr + 3 * gate_scratch_size;
+  }
+
+  if (precompute_input_gates) {
+    // The inputs of all the time steps are rows of the same matrix, in the
+    // order of the scratch buffers: time-major or batch-major.
+    const int n_rows = max_time * n_batch;
+    const float* input_data = GetTensorData<float>(input);
+    const float* aux_input_data = GetTensorData<float>(aux_input);
+    const bool is_input_all_zeros =
+        tensor_utils::IsZeroVector(input_data, n_rows * n_input);
+    const bool is_aux_input_all_zeros =
+        (aux_input == nullptr ||
+         tensor_utils::IsZeroVector(aux_input_data, n_rows * aux_input_size));
+    auto initialize_gate = [&](const TfLiteTensor* input_to_gate_weights,
+                               const TfLiteTensor* aux_input_to_gate_weights,
+                               const TfLiteTensor* layer_norm_coefficients,
+                               const TfLiteTensor* gate_bias, float* gate) {
+      InitializeLstmGateFloat(
+          input_data, GetTensorData<float>(input_to_gate_weights),
+          aux_input_data, GetTensorData<float>(aux_input_to_gate_weights),
+          GetTensorData<float>(layer_norm_coefficients),
+          GetTensorData<float>(gate_bias), n_rows, n_input, aux_input_size,
+          n_cell, gate, is_input_all_zeros, is_aux_input_all_zeros);
+    };
+    if (!use_cifg) {
+      initialize_gate(input_to_input_weights, aux_input_to_input_weights,
+                      input_layer_norm_coefficients, input_gate_bias,
+                      input_gate_scratch);
+    }
+    initialize_gate(input_to_forget_weights, aux_input_to_forget_weights,
+                    forget_layer_norm_coefficients, forget_gate_bias,
+                    forget_gate_scratch);
+    initialize_gate(input_to_cell_weights, aux_input_to_cell_weights,
+                    cell_layer_norm_coefficients, cell_gate_bias,
+                    cell_gate_scratch);
+    initialize_gate(input_to_output_weights, aux_input_to_output_weights,
+                    output_layer_norm_coefficients, output_gate_bias,
+                    output_gate_scratch);
   }
 
   const int output_batch_leading_dim =
@@ -1779,6 +1860,9 @@ TfLiteStatus EvalFloat(
       }
       float* output_ptr =
           GetTensorData<float>(output) + t_rel * output_step + output_offset;
+      // Offset the scratch pointers to the right time step.
+      const int scratch_offset =
+          precompute_input_gates ? t_rel * n_batch * n_cell : 0;
 
       LstmStepFloat(
           input_ptr, GetTensorData<float>(input_to_input_weights),
@@ -1808,8 +1892,11 @@ TfLiteStatus EvalFloat(
           GetTensorData<float>(projection_bias), params, n_batch, n_cell,
           n_input, aux_input_size, n_output, output_batch_leading_dim,
           GetTensorData<float>(output_state), GetTensorData<float>(cell_state),
-          input_gate_scratch, forget_gate_scratch, cell_gate_scratch,
-          output_gate_scratch, output_ptr);
+          input_gate_scratch ? input_gate_scratch + scratch_offset : nullptr,
+          forget_gate_scratch + scratch_offset,
+          cell_gate_scratch + scratch_offset,
+          output_gate_scratch + scratch_offset, output_ptr,
+          precompute_input_gates);
     }
   } else {
     for (int b = 0; b < n_batch; b++) {
@@ -1834,12 +1921,14 @@ TfLiteStatus EvalFloat(
         float* output_state_ptr =
             GetTensorData<float>(output_state) + b * output_batch_leading_dim;
         float* cell_state_ptr = GetTensorData<float>(cell_state) + b * n_cell;
-        // Offset the scratch pointers to the right batch.
+        // Offset the scratch pointers to the right batch, and time step.
+        const int scratch_offset =
+            (precompute_input_gates ? time_offset : b) * n_cell;
         float* input_gate_scratch_ptr =
-            input_gate_scratch ? input_gate_scratch + b * n_cell : nullptr;
-        float* forget_gate_scratch_ptr = forget_gate_scratch + b * n_cell;
-        float* cell_gate_scratch_ptr = cell_gate_scratch + b * n_cell;
-        float* output_gate_scratch_ptr = output_gate_scratch + b * n_cell;
+            input_gate_scratch ? input_gate_scratch + scratch_offset : nullptr;
+        float* forget_gate_scratch_ptr = forget_gate_scratch + scratch_offset;
+        float* cell_gate_scratch_ptr = cell_gate_scratch + scratch_offset;
+        float* output_gate_scratch_ptr = output_gate_scratch + scratch_offset;
 
         LstmStepFloat(
             input_ptr, GetTensorData<float>(input_to_input_weights),
@@ -1870,7 +1959,7 @@ TfLiteStatus EvalFloat(
             n_cell, n_input, aux_input_size, n_output, output_batch_leading_dim,
             output_state_ptr, cell_state_ptr, input_gate_scratch_ptr,
             forget_gate_scratch_ptr, cell_gate_scratch_ptr,
-            output_gate_scratch_ptr, output_ptr);
+            output_gate_scratch_ptr, output_ptr, precompute_input_gates);
       }
     }
   }
@@ -95,6 +95,10 @@ struct IntegerLstmParameter {
   int32_t intermediate_zp[12];
 };
 
+// The scratch buffer holds the gates of a time step, i.e. n_batch * n_cell * 4
+// floats, or n_batch * n_cell * 3 with CIFG. If it holds the gates of all the
+// time steps of the input instead, the contributions of the inputs to the
+// gates are computed for all the steps at once.
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
@@ -31,6 +31,62 @@ namespace {
 
 constexpr int kOutputTensor = 0;
 
+template <typename T>
+TfLiteStatus PackImpl(TfLiteContext* context, TfLiteNode* node,
+                      TfLiteTensor* output, int values_count, int axis) {
+  TF_LITE_ENSURE(context, axis >= 0);
+
+  VectorOfTensors<T> all_inputs(*context, *node->inputs);
+  tflite::PackParams op_params;
+  op_params.axis = axis;
+  op_params.inputs_count = values_count;
+
+  reference_ops::Pack<T>(op_params, all_inputs.shapes(), all_inputs.data(),
+                         GetTensorShape(output), GetTensorData<T>(output));
+  return kTfLiteOk;
+}
+
+// Packs the inputs into `output`, which must have been resized.
+TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node,
+                      TfLiteTensor* output) {
+  const TfLitePackParams* data =
+      reinterpret_cast<TfLitePackParams*>(node->builtin_data);
+
+  switch (output->type) {
+    case kTfLiteFloat32: {
+      return PackImpl<float>(context, node, output, data->values_count,
+                             data->axis);
+    }
+    case kTfLiteUInt8: {
+      return PackImpl<uint8_t>(context, node, output, data->values_count,
+                               data->axis);
+    }
+    case kTfLiteInt8: {
+      return PackImpl<int8_t>(context, node, output, data->values_count,
+                              data->axis);
+    }
+    case kTfLiteInt16: {
+      return PackImpl<int16_t>(context, node, output, data->values_count,
+                               data->axis);
+    }
+    case kTfLiteInt32: {
+      return PackImpl<int32_t>(context, node, output, data->values_count,
+                               data->axis);
+    }
+    case kTfLiteInt64: {
+      return PackImpl<int64_t>(context, node, output, data->values_count,
+                               data->axis);
+    }
+    default: {
+      context->ReportError(context, "Type '%s' is not supported by pack.",
+                           TfLiteTypeGetName(output->type));
+      return kTfLiteError;
+    }
+  }
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TfLitePackParams* data =
       reinterpret_cast<TfLitePackParams*>(node->builtin_data);
@@ -89,64 +145,34 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, input->params.scale, output->params.scale);
   }
 
+  // Pack the values immediately if they are all known, e.g. computed by
+  // Shape, so that the shape arithmetic is folded once instead of being run on
+  // every invocation, and downstream ops can use the value in their own
+  // Prepare.
+  bool all_inputs_known = true;
+  for (int i = 0; i < data->values_count; i++) {
+    const TfLiteTensor* input;
+    TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, i, &input));
+    all_inputs_known &= IsConstantOrPersistentTensor(input);
+  }
+  if (all_inputs_known) {
+    SetTensorToPersistentRo(output);
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, output, output_shape));
+    return EvalImpl(context, node, output);
+  }
   return context->ResizeTensor(context, output, output_shape);
 }
 
-template <typename T>
-TfLiteStatus PackImpl(TfLiteContext* context, TfLiteNode* node,
-                      TfLiteTensor* output, int values_count, int axis) {
-  TF_LITE_ENSURE(context, axis >= 0);
-
-  VectorOfTensors<T> all_inputs(*context, *node->inputs);
-  tflite::PackParams op_params;
-  op_params.axis = axis;
-  op_params.inputs_count = values_count;
-
-  reference_ops::Pack<T>(op_params, all_inputs.shapes(), all_inputs.data(),
-                         GetTensorShape(output), GetTensorData<T>(output));
-  return kTfLiteOk;
-}
-
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  const TfLitePackParams* data =
-      reinterpret_cast<TfLitePackParams*>(node->builtin_data);
-
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context,
                     GetOutputSafe(context, node, kOutputTensor, &output));
-  switch (output->type) {
-    case kTfLiteFloat32: {
-      return PackImpl<float>(context, node, output, data->values_count,
-                             data->axis);
-    }
-    case kTfLiteUInt8: {
-      return PackImpl<uint8_t>(context, node, output, data->values_count,
-                               data->axis);
-    }
-    case kTfLiteInt8: {
-      return PackImpl<int8_t>(context, node, output, data->values_count,
-                              data->axis);
-    }
-    case kTfLiteInt16: {
-      return PackImpl<int16_t>(context, node, output, data->values_count,
-                               data->axis);
-    }
-    case kTfLiteInt32: {
-      return PackImpl<int32_t>(context, node, output, data->values_count,
-                               data->axis);
-    }
-    case kTfLiteInt64: {
-      return PackImpl<int64_t>(context, node, output, data->values_count,
-                               data->axis);
-    }
-    default: {
-      context->ReportError(context, "Type '%s' is not supported by pack.",
-                           TfLiteTypeGetName(output->type));
-      return kTfLiteError;
-    }
+  // The output was already computed by Prepare.
+  if (output->allocation_type == kTfLitePersistentRo) {
+    return kTfLiteOk;
   }
-
-  return kTfLiteOk;
+  return EvalImpl(context, node, output);
 }
 
 }  // namespace
@@ -151,6 +151,39 @@ TEST(PackOpTest, Int32MultilDimensions) {
               ElementsAreArray({1, 2, 3, 7, 8, 9, 4, 5, 6, 10, 11, 12}));
 }
 
+// Packs constant int32 vectors, as in shape arithmetic.
+class ConstPackOpModel : public SingleOpModel {
+ public:
+  ConstPackOpModel(std::initializer_list<int32_t> value0,
+                   std::initializer_list<int32_t> value1) {
+    AddConstInput(TensorType_INT32, value0, {static_cast<int>(value0.size())});
+    AddConstInput(TensorType_INT32, value1, {static_cast<int>(value1.size())});
+    output_ = AddOutput(TensorType_INT32);
+    SetBuiltinOp(BuiltinOperator_PACK, BuiltinOptions_PackOptions,
+                 CreatePackOptions(builder_, 2, 0).Union());
+    BuildInterpreter({});
+  }
+
+  std::vector<int32_t> GetOutput() { return ExtractVector<int32_t>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+  TfLiteAllocationType GetOutputAllocationType() const {
+    return interpreter_->tensor(output_)->allocation_type;
+  }
+
+ private:
+  int output_;
+};
+
+TEST(PackOpTest, Int32ConstantInputsAreFoldedInPrepare) {
+  ConstPackOpModel model({1, 2}, {3, 4});
+  ASSERT_EQ(model.GetOutputAllocationType(), kTfLitePersistentRo);
+  // The output is populated by Prepare(), without invoking the model.
+  EXPECT_THAT(model.GetOutputShape(), ElementsAre(2, 2));
+  EXPECT_THAT(model.GetOutput(), ElementsAreArray({1, 2, 3, 4}));
+  model.Invoke();
+  EXPECT_THAT(model.GetOutput(), ElementsAreArray({1, 2, 3, 4}));
+}
+
 // int64 tests.
 TEST(PackOpTest, Int64ThreeInputs) {
   PackOpModel<int64_t> model({TensorType_INT64, {2}}, 0, 3);
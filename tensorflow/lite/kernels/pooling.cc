@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
@@ -119,7 +120,7 @@ void AverageEvalFloat(TfLiteContext* context, TfLiteNode* node,
   float activation_min, activation_max;
   CalculateActivationRange(params->activation, &activation_min,
                            &activation_max);
-#define TF_LITE_AVERAGE_POOL(type)                                       \
+#define TF_LITE_AVERAGE_POOL(type, ...)                                  \
   tflite::PoolParams op_params;                                          \
   op_params.stride_height = params->stride_height;                       \
   op_params.stride_width = params->stride_width;                         \
@@ -131,11 +132,12 @@ void AverageEvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.float_activation_max = activation_max;                       \
   type::AveragePool(op_params, GetTensorShape(input),                    \
                     GetTensorData<float>(input), GetTensorShape(output), \
-                    GetTensorData<float>(output))
+                    GetTensorData<float>(output), ##__VA_ARGS__)
   if (kernel_type == kReference) {
     TF_LITE_AVERAGE_POOL(reference_ops);
   } else {
-    TF_LITE_AVERAGE_POOL(optimized_ops);
+    TF_LITE_AVERAGE_POOL(optimized_ops,
+                         CpuBackendContext::GetFromContext(context));
   }
 #undef TF_LITE_AVERAGE_POOL
 }
@@ -233,7 +235,7 @@ void MaxEvalFloat(TfLiteContext* context, TfLiteNode* node,
   float activation_min, activation_max;
   CalculateActivationRange(params->activation, &activation_min,
                            &activation_max);
-#define TF_LITE_MAX_POOL(type)                                                 \
+#define TF_LITE_MAX_POOL(type, ...)                                            \
   tflite::PoolParams op_params;                                                \
   op_params.stride_height = params->stride_height;                             \
   op_params.stride_width = params->stride_width;                               \
@@ -244,11 +246,12 @@ void MaxEvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.float_activation_min = activation_min;                             \
   op_params.float_activation_max = activation_max;                             \
   type::MaxPool(op_params, GetTensorShape(input), GetTensorData<float>(input), \
-                GetTensorShape(output), GetTensorData<float>(output))
+                GetTensorShape(output), GetTensorData<float>(output),          \
+                ##__VA_ARGS__)
   if (kernel_type == kReference) {
     TF_LITE_MAX_POOL(reference_ops);
   } else {
-    TF_LITE_MAX_POOL(optimized_ops);
+    TF_LITE_MAX_POOL(optimized_ops, CpuBackendContext::GetFromContext(context));
   }
 #undef TF_LITE_MAX_POOL
 }
@@ -59,6 +59,10 @@ class FloatPoolingOpModel : public BasePoolingOpModel {
     PopulateTensor(input_, data);
   }
 
+  void SetInput(const std::vector<float>& data) {
+    PopulateTensor(input_, data);
+  }
+
   std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
 };
 
@@ -715,6 +719,40 @@ TEST(FloatPoolingOpTest, MaxPoolPaddingValidStride1) {
   EXPECT_THAT(m.GetOutput(), ElementsAreArray({6, 10, 10}));
 }
 
+// Returns the output of pooling a 2x32x32x8 input with a 3x3 filter, which is
+// large enough to be split across `num_threads` threads.
+std::vector<float> RunLargeFloatPool(BuiltinOperator type, int num_threads) {
+  FloatPoolingOpModel m(type,
+                        /*input=*/{TensorType_FLOAT32, {2, 32, 32, 8}},
+                        /*filter_width=*/3, /*filter_height=*/3,
+                        /*output=*/{TensorType_FLOAT32, {}}, Padding_SAME, 1,
+                        1);
+  m.SetNumThreads(num_threads);
+  std::vector<float> input(2 * 32 * 32 * 8);
+  for (int i = 0; i < 2 * 32 * 32 * 8; ++i) {
+    input[i] = (i * 37) % 101 - 50;
+  }
+  m.SetInput(input);
+  m.Invoke();
+  return m.GetOutput();
+}
+
+TEST(FloatPoolingOpTest, AveragePoolMultiThreaded) {
+  const std::vector<float> expected =
+      RunLargeFloatPool(BuiltinOperator_AVERAGE_POOL_2D, 1);
+  ASSERT_EQ(expected.size(), 2 * 32 * 32 * 8);
+  EXPECT_THAT(RunLargeFloatPool(BuiltinOperator_AVERAGE_POOL_2D, 4),
+              ElementsAreArray(ArrayFloatNear(expected)));
+}
+
+TEST(FloatPoolingOpTest, MaxPoolMultiThreaded) {
+  const std::vector<float> expected =
+      RunLargeFloatPool(BuiltinOperator_MAX_POOL_2D, 1);
+  ASSERT_EQ(expected.size(), 2 * 32 * 32 * 8);
+  EXPECT_THAT(RunLargeFloatPool(BuiltinOperator_MAX_POOL_2D, 4),
+              ElementsAreArray(expected));
+}
+
 TEST(QuantizedUInt8PoolingOpTest, MaxPool) {
   // Choose the input ranges carefully so that the dequantized output matches
   // the results of the float model above.
@@ -142,61 +142,19 @@ TfLiteStatus ResizeOutputTensor(TfLiteContext* context,
   return kTfLiteOk;
 }
 
-TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
-  TF_LITE_ENSURE_EQ(context, NumInputs(node), 4);
-  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
-
-  StridedSliceContext op_context(context, node);
-
-  // Ensure validity of input tensor and its dimension
-  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.begin), 1);
-  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.end), 1);
-  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.strides), 1);
-  TF_LITE_ENSURE_EQ(context, op_context.input->type, op_context.output->type);
-  // Only INT32 begin/end/strides are supported
-  // TODO(soroosh) add support for INT64
-  TF_LITE_ENSURE_TYPES_EQ(context, op_context.begin->type, kTfLiteInt32);
-  TF_LITE_ENSURE_TYPES_EQ(context, op_context.end->type, kTfLiteInt32);
-  TF_LITE_ENSURE_TYPES_EQ(context, op_context.strides->type, kTfLiteInt32);
-  TF_LITE_ENSURE_MSG(context, op_context.dims <= 5,
-                     "StridedSlice op only supports 1D-5D input arrays.");
-
-  // TODO(b/138098220): Remove when bug is resolved.
-  // Currently, working on using the compiler to cannonize strided_slice,
-  // so ellipis_mask will become part of begin/end mask, new_axis_mask will
-  // involve in a reshape to pad the dimensions.
-  TF_LITE_ENSURE_MSG(context, op_context.params->ellipsis_mask == 0,
-                     "ellipsis_mask is not implemented yet.");
-  TF_LITE_ENSURE_MSG(context, op_context.params->new_axis_mask == 0,
-                     "new_axis_mask is not implemented yet.");
-
-  // Postpone allocation of output if any of the indexing tensors is not
-  // constant
-  if (!(IsConstantTensor(op_context.begin) &&
-        IsConstantTensor(op_context.end) &&
-        IsConstantTensor(op_context.strides))) {
-    SetTensorToDynamic(op_context.output);
-    return kTfLiteOk;
-  }
-  return ResizeOutputTensor(context, &op_context);
-}
-
+// Slices the input into the output, which must have been resized.
 template <KernelType kernel_type>
-TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  StridedSliceContext op_context(context, node);
-
-  if (IsDynamicTensor(op_context.output)) {
-    TF_LITE_ENSURE_OK(context, ResizeOutputTensor(context, &op_context));
-  }
-  StridedSliceParams op_params = BuildStridedSliceParams(&op_context);
+TfLiteStatus EvalImpl(TfLiteContext* context,
+                      StridedSliceContext* op_context) {
+  StridedSliceParams op_params = BuildStridedSliceParams(op_context);
 
-#define TF_LITE_STRIDED_SLICE(kernel_type, data_type)                    \
-  kernel_type::StridedSlice(op_params, GetTensorShape(op_context.input), \
-                            GetTensorData<data_type>(op_context.input),  \
-                            GetTensorShape(op_context.output),           \
-                            GetTensorData<data_type>(op_context.output))
+#define TF_LITE_STRIDED_SLICE(kernel_type, data_type)                     \
+  kernel_type::StridedSlice(op_params, GetTensorShape(op_context->input), \
+                            GetTensorData<data_type>(op_context->input),  \
+                            GetTensorShape(op_context->output),           \
+                            GetTensorData<data_type>(op_context->output))
 
-  switch (op_context.input->type) {
+  switch (op_context->input->type) {
     case kTfLiteFloat32:
       if (kernel_type == kReference) {
         TF_LITE_STRIDED_SLICE(reference_ops, float);
@@ -236,13 +194,74 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       TF_LITE_KERNEL_LOG(context,
                          "Type %s is currently not supported "
                          "by StridedSlice.",
-                         TfLiteTypeGetName(op_context.input->type));
+                         TfLiteTypeGetName(op_context->input->type));
       return kTfLiteError;
   }
 #undef TF_LITE_STRIDED_SLICE
   return kTfLiteOk;
 }
 
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 4);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  StridedSliceContext op_context(context, node);
+
+  // Ensure validity of input tensor and its dimension
+  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.begin), 1);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.end), 1);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(op_context.strides), 1);
+  TF_LITE_ENSURE_EQ(context, op_context.input->type, op_context.output->type);
+  // Only INT32 begin/end/strides are supported
+  // TODO(soroosh) add support for INT64
+  TF_LITE_ENSURE_TYPES_EQ(context, op_context.begin->type, kTfLiteInt32);
+  TF_LITE_ENSURE_TYPES_EQ(context, op_context.end->type, kTfLiteInt32);
+  TF_LITE_ENSURE_TYPES_EQ(context, op_context.strides->type, kTfLiteInt32);
+  TF_LITE_ENSURE_MSG(context, op_context.dims <= 5,
+                     "StridedSlice op only supports 1D-5D input arrays.");
+
+  // TODO(b/138098220): Remove when bug is resolved.
+  // Currently, working on using the compiler to cannonize strided_slice,
+  // so ellipis_mask will become part of begin/end mask, new_axis_mask will
+  // involve in a reshape to pad the dimensions.
+  TF_LITE_ENSURE_MSG(context, op_context.params->ellipsis_mask == 0,
+                     "ellipsis_mask is not implemented yet.");
+  TF_LITE_ENSURE_MSG(context, op_context.params->new_axis_mask == 0,
+                     "new_axis_mask is not implemented yet.");
+
+  // Postpone allocation of output if any of the indexing tensors is not
+  // constant
+  if (!(IsConstantOrPersistentTensor(op_context.begin) &&
+        IsConstantOrPersistentTensor(op_context.end) &&
+        IsConstantOrPersistentTensor(op_context.strides))) {
+    SetTensorToDynamic(op_context.output);
+    return kTfLiteOk;
+  }
+  // Slice the input immediately if it is known too, e.g. computed by Shape, so
+  // that the shape arithmetic is folded once instead of being run on every
+  // invocation, and downstream ops can use the value in their own Prepare.
+  if (IsConstantOrPersistentTensor(op_context.input)) {
+    SetTensorToPersistentRo(op_context.output);
+    TF_LITE_ENSURE_OK(context, ResizeOutputTensor(context, &op_context));
+    return EvalImpl<kReference>(context, &op_context);
+  }
+  return ResizeOutputTensor(context, &op_context);
+}
+
+template <KernelType kernel_type>
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  StridedSliceContext op_context(context, node);
+
+  // The output was already computed by Prepare.
+  if (op_context.output->allocation_type == kTfLitePersistentRo) {
+    return kTfLiteOk;
+  }
+  if (IsDynamicTensor(op_context.output)) {
+    TF_LITE_ENSURE_OK(context, ResizeOutputTensor(context, &op_context));
+  }
+  return EvalImpl<kernel_type>(context, &op_context);
+}
+
 }  // namespace strided_slice
 
 TfLiteRegistration* Register_STRIDED_SLICE_REF() {
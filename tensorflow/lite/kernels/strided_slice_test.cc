@@ -692,5 +692,43 @@ TYPED_TEST(StridedSliceOpTest, In3D_Backward) {
   EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({0, 1, 2}));
 }
 
+// Slices a constant int32 vector with constant indices, as in shape arithmetic.
+class ConstStridedSliceOpModel : public SingleOpModel {
+ public:
+  ConstStridedSliceOpModel(std::initializer_list<int32_t> input,
+                           std::initializer_list<int32_t> begin,
+                           std::initializer_list<int32_t> end,
+                           std::initializer_list<int32_t> strides) {
+    AddConstInput(TensorType_INT32, input, {static_cast<int>(input.size())});
+    AddConstInput(TensorType_INT32, begin, {1});
+    AddConstInput(TensorType_INT32, end, {1});
+    AddConstInput(TensorType_INT32, strides, {1});
+    output_ = AddOutput(TensorType_INT32);
+    SetBuiltinOp(BuiltinOperator_STRIDED_SLICE,
+                 BuiltinOptions_StridedSliceOptions,
+                 CreateStridedSliceOptions(builder_, 0, 0, 0, 0, 0).Union());
+    BuildInterpreter({});
+  }
+
+  std::vector<int32_t> GetOutput() { return ExtractVector<int32_t>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+  TfLiteAllocationType GetOutputAllocationType() const {
+    return interpreter_->tensor(output_)->allocation_type;
+  }
+
+ private:
+  int output_;
+};
+
+TEST(StridedSliceConstOpTest, ConstantInputsAreFoldedInPrepare) {
+  ConstStridedSliceOpModel m({1, 3, 224, 224}, {1}, {3}, {1});
+  ASSERT_EQ(m.GetOutputAllocationType(), kTfLitePersistentRo);
+  // The output is populated by Prepare(), without invoking the model.
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({2}));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({3, 224}));
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({3, 224}));
+}
+
 }  // namespace
 }  // namespace tflite
@@ -961,6 +961,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const bool use_cifg = (input_to_input_weights == nullptr);
   TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
   scratch_buffer_size->data[0] = n_batch;
+  if (input->type == kTfLiteFloat32 &&
+      input_to_output_weights->type == kTfLiteFloat32) {
+    // Reserving space for the gates of all the time steps, so that the input
+    // contributions are computed for the whole sequence at once.
+    const int max_time =
+        time_major ? input->dims->data[0] : input->dims->data[1];
+    scratch_buffer_size->data[0] *= max_time;
+  }
   if (use_cifg) {
     // Reserving space for Cell, Forget, Output gates
     scratch_buffer_size->data[1] = n_cell * 3;
@@ -39,6 +39,13 @@ class MemoryPlanner {
   // ExecuteAllocations() is called.
   virtual TfLiteStatus ResetAllocations() = 0;
 
+  // Like ResetAllocations(), except that the tensors which still fit in their
+  // allocations keep them in the next ExecuteAllocations(), e.g. after their
+  // batch dimension shrank, so that the memory layout is not planned again.
+  virtual TfLiteStatus ResetAllocationsKeepingLayout() {
+    return ResetAllocations();
+  }
+
   // Invalidates allocations after the given node execution.
   virtual TfLiteStatus ResetAllocationsAfter(int node) = 0;
 
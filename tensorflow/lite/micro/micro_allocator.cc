@@ -391,6 +391,52 @@ TfLiteStatus CommitPlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
   }
   return kTfLiteOk;
 }
+
+// Returns whether the offline plan places all of the buffers that need
+// allocating, in which case the memory planner doesn't need to run.
+bool IsFullyOfflinePlanned(const AllocationInfo* allocation_info,
+                           size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating &&
+        current->offline_offset == kOnlinePlannedBuffer) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the number of bytes from the start of the arena to the end of the
+// last buffer of a fully offline plan.
+size_t GetOfflinePlanSize(const AllocationInfo* allocation_info,
+                          size_t allocation_info_size) {
+  size_t plan_size = 0;
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating) {
+      const size_t buffer_end = current->offline_offset +
+                                AlignSizeUp(current->bytes, kBufferAlignment);
+      if (buffer_end > plan_size) {
+        plan_size = buffer_end;
+      }
+    }
+  }
+  return plan_size;
+}
+
+// Same as CommitPlan(), but takes the offsets of a fully offline plan as they
+// are instead of from a memory planner.
+void CommitOfflinePlan(uint8_t* starting_point,
+                       const AllocationInfo* allocation_info,
+                       size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating) {
+      *current->output_ptr =
+          reinterpret_cast<void*>(starting_point + current->offline_offset);
+    }
+  }
+}
 }  // namespace
 
 namespace internal {
@@ -1046,6 +1092,8 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   // 2. Add them into the planner (such as the GreedyMemoryPlanner).
   // 3. Static memory planning using the planner.
   // 4. Set tensor/buffer pointers based on the offsets from the previous step.
+  // Steps 2 and 3 are skipped when the model holds offline planned offsets for
+  // all of the buffers.
   //
   // Note that AllocationInfo is only needed for creating the plan. It will be
   // allocated from the temp section and cleaned up at the bottom of this
@@ -1084,36 +1132,33 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(scratch_buffer_requests,
                                                   scratch_buffer_handles));
 
-  // Remaining arena size that memory planner can use for calculating offsets.
-  size_t remaining_arena_size =
-      memory_allocator_->GetAvailableMemory(kBufferAlignment);
-  uint8_t* planner_arena =
-      memory_allocator_->AllocateTemp(remaining_arena_size, kBufferAlignment);
-  TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
-  GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
-  TF_LITE_ENSURE_STATUS(CreatePlan(error_reporter_, &planner, allocation_info,
-                                   allocation_info_count));
-
-  // Reset all temp allocations used above:
-  memory_allocator_->ResetTempAllocations();
-
-  size_t actual_available_arena_size =
-      memory_allocator_->GetAvailableMemory(kBufferAlignment);
-
-  // Make sure we have enough arena size.
-  if (planner.GetMaximumMemorySize() > actual_available_arena_size) {
-    TF_LITE_REPORT_ERROR(
-        error_reporter_,
-        "Arena size is too small for all buffers. Needed %u but only "
-        "%u was available.",
-        planner.GetMaximumMemorySize(), actual_available_arena_size);
-    return kTfLiteError;
+  if (offline_planner_offsets != nullptr &&
+      IsFullyOfflinePlanned(allocation_info, allocation_info_count)) {
+    // The offsets were all computed ahead of time, so skip the planner and its
+    // scratch memory, which saves startup time on large models.
+    head_usage = GetOfflinePlanSize(allocation_info, allocation_info_count);
+    TF_LITE_ENSURE_STATUS(EnsureArenaFitsHeadUsage(head_usage));
+    CommitOfflinePlan(memory_allocator_->GetHeadBuffer(), allocation_info,
+                      allocation_info_count);
+  } else {
+    // Remaining arena size that memory planner can use for calculating
+    // offsets.
+    size_t remaining_arena_size =
+        memory_allocator_->GetAvailableMemory(kBufferAlignment);
+    uint8_t* planner_arena =
+        memory_allocator_->AllocateTemp(remaining_arena_size, kBufferAlignment);
+    TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
+    GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
+    TF_LITE_ENSURE_STATUS(CreatePlan(error_reporter_, &planner,
+                                     allocation_info, allocation_info_count));
+
+    head_usage = planner.GetMaximumMemorySize();
+    TF_LITE_ENSURE_STATUS(EnsureArenaFitsHeadUsage(head_usage));
+    // Commit the plan.
+    TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
+                                     memory_allocator_->GetHeadBuffer(),
+                                     allocation_info, allocation_info_count));
   }
-  // Commit the plan.
-  TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
-                                   memory_allocator_->GetHeadBuffer(),
-                                   allocation_info, allocation_info_count));
-  head_usage = planner.GetMaximumMemorySize();
 
   // The head is used to store memory plans for one model at a time during the
   // model preparation stage, and is re-purposed to store scratch buffer handles
@@ -1132,6 +1177,25 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::EnsureArenaFitsHeadUsage(size_t head_usage) {
+  // Reset all temp allocations used for planning:
+  memory_allocator_->ResetTempAllocations();
+
+  size_t actual_available_arena_size =
+      memory_allocator_->GetAvailableMemory(kBufferAlignment);
+
+  // Make sure we have enough arena size.
+  if (head_usage > actual_available_arena_size) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "Arena size is too small for all buffers. Needed %u but only "
+        "%u was available.",
+        head_usage, actual_available_arena_size);
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::AllocateScratchBufferHandles(
     ScratchBufferHandle** scratch_buffer_handles, size_t handle_count) {
   TFLITE_DCHECK(scratch_buffer_handles != nullptr);
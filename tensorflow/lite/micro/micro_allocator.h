@@ -128,12 +128,15 @@ class MicroAllocator {
 
   // Finish allocating internal resources required for model inference.
   // This method will plan non-persistent buffers and commit a memory plan to
-  // the 'head' section of the memory arena. All variable tensor data will also
-  // be allocated. This method should be called after assigning model resources
-  // in StartModelAllocation(). The eval_tensors pointer should be the value
-  // passed into this class during StartModelAllocation(). Scratch buffer
-  // handles are stored in the out-param `scratch_buffer_handles`. This value
-  // will be used in `GetScratchBuffer` call to retrieve scratch buffers.
+  // the 'head' section of the memory arena. If the model metadata holds
+  // offline planned offsets ("OfflineMemoryAllocation") for all of the
+  // buffers, they are committed as they are without running the planner. All
+  // variable tensor data will also be allocated. This method should be called
+  // after assigning model resources in StartModelAllocation(). The
+  // eval_tensors pointer should be the value passed into this class during
+  // StartModelAllocation(). Scratch buffer handles are stored in the out-param
+  // `scratch_buffer_handles`. This value will be used in `GetScratchBuffer`
+  // call to retrieve scratch buffers.
   TfLiteStatus FinishModelAllocation(
       const Model* model, TfLiteEvalTensor* eval_tensors,
       ScratchBufferHandle** scratch_buffer_handles);
@@ -244,6 +247,10 @@ class MicroAllocator {
       TfLiteEvalTensor* eval_tensors,
       ScratchBufferHandle* scratch_buffer_handles);
 
+  // Resets the temp allocations made while planning, and reports an error if
+  // the remaining arena is smaller than the `head_usage` of the memory plan.
+  TfLiteStatus EnsureArenaFitsHeadUsage(size_t head_usage);
+
   // Allocates an array of ScratchBufferHandle structs in the tail section for a
   // given number of handles.
   virtual TfLiteStatus AllocateScratchBufferHandles(
@@ -674,6 +674,85 @@ TF_LITE_MICRO_TEST(OfflinePlannerOfflineOnline) {
   TF_LITE_MICRO_EXPECT_EQ(0, eval_tensors[3].data.uint8 - start);
 }
 
+TF_LITE_MICRO_TEST(OfflinePlannerMultiTenant) {
+  constexpr int nbr_tensors = 4;
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  const int32_t metadata_buffer1[tflite::testing::kOfflinePlannerHeaderSize +
+                                 nbr_tensors] = {1, 0, nbr_tensors,
+                                                 0,    // t0
+                                                 48,   // t1
+                                                 0,    // t2
+                                                 48};  // t3
+  const int32_t metadata_buffer2[tflite::testing::kOfflinePlannerHeaderSize +
+                                 nbr_tensors] = {1, 0, nbr_tensors,
+                                                 0,   // t0
+                                                 48,  // t1
+                                                 96,  // t2
+                                                 0};  // t3
+
+  int t0 = 0;
+  int t1 = 1;
+  int t2 = 2;
+  int t3 = 3;
+
+  int num_conns = 3;
+  tflite::testing::NodeConnection node_list[3] = {{
+                                                      {t0},  // input
+                                                      {t1}   // output
+                                                  },
+                                                  {
+                                                      {t1},  // input
+                                                      {t2}   // output
+                                                  },
+                                                  {
+                                                      {t2},  // input
+                                                      {t3}   // output
+                                                  }};
+
+  // Both models are fully planned offline, so they share the head of the arena
+  // without running the memory planner.
+  const tflite::Model* model1 = tflite::testing::GetModelWithOfflinePlanning(
+      nbr_tensors, metadata_buffer1, node_list, num_conns);
+  const tflite::Model* model2 = tflite::testing::GetModelWithOfflinePlanning(
+      nbr_tensors, metadata_buffer2, node_list, num_conns);
+
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, arena_size, micro_test::reporter);
+
+  tflite::NodeAndRegistration* node_and_registration1;
+  TfLiteEvalTensor* eval_tensors1 = nullptr;
+  tflite::ScratchBufferHandle* scratch_buffer_handles1 = nullptr;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      allocator->StartModelAllocation(model1, op_resolver,
+                                      &node_and_registration1, &eval_tensors1));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model1, eval_tensors1,
+                                                  &scratch_buffer_handles1));
+
+  tflite::NodeAndRegistration* node_and_registration2;
+  TfLiteEvalTensor* eval_tensors2 = nullptr;
+  tflite::ScratchBufferHandle* scratch_buffer_handles2 = nullptr;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      allocator->StartModelAllocation(model2, op_resolver,
+                                      &node_and_registration2, &eval_tensors2));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model2, eval_tensors2,
+                                                  &scratch_buffer_handles2));
+
+  uint8_t* start = eval_tensors1[0].data.uint8;
+  TF_LITE_MICRO_EXPECT_EQ(48, eval_tensors1[1].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(0, eval_tensors1[2].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(48, eval_tensors1[3].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(0, eval_tensors2[0].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(48, eval_tensors2[1].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(96, eval_tensors2[2].data.uint8 - start);
+  TF_LITE_MICRO_EXPECT_EQ(0, eval_tensors2[3].data.uint8 - start);
+}
+
 TF_LITE_MICRO_TEST(TestAllocatePersistentTfLiteTensor) {
   const tflite::Model* model = tflite::GetModel(kTestConvModelData);
   constexpr size_t arena_size = 1024 * 12;
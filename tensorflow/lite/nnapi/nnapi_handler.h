@@ -242,6 +242,24 @@ class NnApiHandler {
         [](ANeuralNetworksExecution* execution) { return Value; };
   }
 
+  template <int Value>
+  void BurstCreateReturns() {
+    nnapi_->ANeuralNetworksBurst_create =
+        [](ANeuralNetworksCompilation* compilation,
+           ANeuralNetworksBurst** burst) {
+          *burst = reinterpret_cast<ANeuralNetworksBurst*>(1);
+          return Value;
+        };
+  }
+
+  template <int Value>
+  void ExecutionBurstComputeReturns() {
+    nnapi_->ANeuralNetworksExecution_burstCompute =
+        [](ANeuralNetworksExecution* execution, ANeuralNetworksBurst* burst) {
+          return Value;
+        };
+  }
+
   template <int Value>
   void GetSupportedOperationsForDevicesReturns() {
     nnapi_->ANeuralNetworksModel_getSupportedOperationsForDevices =
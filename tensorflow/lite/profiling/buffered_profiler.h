@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_PROFILING_BUFFERED_PROFILER_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/lite/core/api/profiler.h"
@@ -105,6 +106,20 @@ class BufferedProfiler : public tflite::Profiler {
                      event_metadata2);
   }
 
+  // Records the hardware counters of the CPU with each event, see
+  // ProfileEvent::begin_hw_counters. The counters are those of the calling
+  // thread and of the threads it creates afterwards, so this should be called
+  // on the thread that invokes the interpreter, before it creates any of its
+  // threads. Returns false if the counters are not supported.
+  bool EnableHardwareCounters() {
+    hw_counter_reader_.reset(new hardware::HardwareCounterReader());
+    if (!hw_counter_reader_->IsSupported()) {
+      hw_counter_reader_.reset();
+    }
+    buffer_.SetHardwareCounterReader(hw_counter_reader_.get());
+    return hw_counter_reader_ != nullptr;
+  }
+
   void StartProfiling() { buffer_.SetEnabled(true); }
   void StopProfiling() { buffer_.SetEnabled(false); }
   void Reset() { buffer_.Reset(); }
@@ -124,6 +139,7 @@ class BufferedProfiler : public tflite::Profiler {
 
  private:
   ProfileBuffer* GetProfileBuffer() { return &buffer_; }
+  std::unique_ptr<hardware::HardwareCounterReader> hw_counter_reader_;
   ProfileBuffer buffer_;
   const uint64_t supported_event_types_;
 };
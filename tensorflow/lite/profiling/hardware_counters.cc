@@ -0,0 +1,105 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace tflite {
+namespace profiling {
+namespace hardware {
+
+const int64_t HardwareCounters::kValueNotSet = -1;
+const int HardwareCounters::kCacheLineBytes = 64;
+
+void HardwareCounters::AllStatsToStream(std::ostream* stream) const {
+  *stream << "cycles = " << cycles << ", instructions = " << instructions
+          << ", cache references = " << cache_references
+          << ", cache misses = " << cache_misses;
+}
+
+#ifdef __linux__
+namespace {
+
+const uint64_t kCounterConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+
+int OpenCounter(uint64_t config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                 /*group_fd=*/-1, /*flags=*/0);
+}
+
+}  // namespace
+#endif
+
+HardwareCounterReader::HardwareCounterReader() {
+  for (int i = 0; i < kNumCounters; ++i) fds_[i] = -1;
+#ifdef __linux__
+  supported_ = true;
+  for (int i = 0; i < kNumCounters; ++i) {
+    fds_[i] = OpenCounter(kCounterConfigs[i]);
+    if (fds_[i] < 0) supported_ = false;
+  }
+#endif
+}
+
+HardwareCounterReader::~HardwareCounterReader() {
+#ifdef __linux__
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+#endif
+}
+
+HardwareCounters HardwareCounterReader::Read() const {
+  HardwareCounters result;
+#ifdef __linux__
+  if (!supported_) return result;
+  int64_t values[kNumCounters];
+  for (int i = 0; i < kNumCounters; ++i) {
+    uint64_t value = 0;
+    if (read(fds_[i], &value, sizeof(value)) != sizeof(value)) {
+      return HardwareCounters();
+    }
+    values[i] = static_cast<int64_t>(value);
+  }
+  result.cycles = values[0];
+  result.instructions = values[1];
+  result.cache_references = values[2];
+  result.cache_misses = values[3];
+#endif
+  return result;
+}
+
+}  // namespace hardware
+}  // namespace profiling
+}  // namespace tflite
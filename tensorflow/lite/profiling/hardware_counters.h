@@ -0,0 +1,106 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
+#define TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
+
+#include <cstdint>
+#include <sstream>
+
+namespace tflite {
+namespace profiling {
+namespace hardware {
+
+// The values of the hardware performance counters of the CPU.
+struct HardwareCounters {
+  static const int64_t kValueNotSet;
+
+  // Indicates whether the counters hold values read by HardwareCounterReader.
+  bool IsSet() const { return cycles != kValueNotSet; }
+
+  // The size in bytes of the cache lines moved from memory on a cache miss,
+  // used to estimate the memory traffic.
+  static const int kCacheLineBytes;
+
+  HardwareCounters()
+      : cycles(kValueNotSet),
+        instructions(kValueNotSet),
+        cache_references(kValueNotSet),
+        cache_misses(kValueNotSet) {}
+
+  // The number of CPU cycles.
+  int64_t cycles;
+  // The number of retired instructions.
+  int64_t instructions;
+  // The number of accesses to, and misses of, the last level cache. These are
+  // aliases to PERF_COUNT_HW_CACHE_REFERENCES and PERF_COUNT_HW_CACHE_MISSES.
+  int64_t cache_references;
+  int64_t cache_misses;
+
+  // Returns an estimate of the bytes read from or written to memory, assuming
+  // each cache miss moves one cache line.
+  int64_t EstimatedMemoryBytes() const {
+    return cache_misses * kCacheLineBytes;
+  }
+
+  HardwareCounters operator-(HardwareCounters const& obj) const {
+    HardwareCounters res;
+    res.cycles = cycles - obj.cycles;
+    res.instructions = instructions - obj.instructions;
+    res.cache_references = cache_references - obj.cache_references;
+    res.cache_misses = cache_misses - obj.cache_misses;
+    return res;
+  }
+
+  void AllStatsToStream(std::ostream* stream) const;
+
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const HardwareCounters& obj) {
+    obj.AllStatsToStream(&stream);
+    return stream;
+  }
+};
+
+// Reads the hardware counters of the thread that creates it, and of the
+// threads that thread creates afterwards, through perf_event_open(2).
+// Note: this currently only works on Linux and Android, when the kernel allows
+// the process to monitor itself (see /proc/sys/kernel/perf_event_paranoid).
+class HardwareCounterReader {
+ public:
+  HardwareCounterReader();
+  ~HardwareCounterReader();
+
+  // Indicates whether all the counters could be opened, thus whether Read()
+  // returns meaningful values.
+  bool IsSupported() const { return supported_; }
+
+  // Returns the current values of the counters, or values that are not set if
+  // they are not supported.
+  HardwareCounters Read() const;
+
+ private:
+  static constexpr int kNumCounters = 4;
+
+  bool supported_ = false;
+  int fds_[kNumCounters];
+
+  HardwareCounterReader(const HardwareCounterReader&) = delete;
+  HardwareCounterReader& operator=(const HardwareCounterReader&) = delete;
+};
+
+}  // namespace hardware
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
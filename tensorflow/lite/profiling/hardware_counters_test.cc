@@ -0,0 +1,65 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counters.h"
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace profiling {
+namespace hardware {
+
+TEST(HardwareCounters, Sub) {
+  HardwareCounters counters1, counters2;
+  EXPECT_FALSE(counters1.IsSet());
+  counters1.cycles = 500;
+  counters1.instructions = 900;
+  counters1.cache_references = 40;
+  counters1.cache_misses = 10;
+
+  counters2.cycles = 200;
+  counters2.instructions = 300;
+  counters2.cache_references = 30;
+  counters2.cache_misses = 4;
+
+  const auto sub_counters = counters1 - counters2;
+  EXPECT_TRUE(sub_counters.IsSet());
+  EXPECT_EQ(300, sub_counters.cycles);
+  EXPECT_EQ(600, sub_counters.instructions);
+  EXPECT_EQ(10, sub_counters.cache_references);
+  EXPECT_EQ(6, sub_counters.cache_misses);
+  EXPECT_EQ(6 * HardwareCounters::kCacheLineBytes,
+            sub_counters.EstimatedMemoryBytes());
+}
+
+TEST(HardwareCounters, Read) {
+  HardwareCounterReader reader;
+  const HardwareCounters begin = reader.Read();
+  // The counters may not be available, for example in virtual machines or
+  // when perf_event_paranoid forbids monitoring.
+  if (!reader.IsSupported()) {
+    EXPECT_FALSE(begin.IsSet());
+    return;
+  }
+  volatile int sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  const HardwareCounters end = reader.Read();
+  EXPECT_TRUE(begin.IsSet());
+  EXPECT_GT(end.instructions, begin.instructions);
+  EXPECT_GT(end.cycles, begin.cycles);
+}
+
+}  // namespace hardware
+}  // namespace profiling
+}  // namespace tflite
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/hardware_counters.h"
 #include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/profiling/time.h"
 
@@ -48,6 +49,11 @@ struct ProfileEvent {
   // The memory usage when the event ends.
   memory::MemoryUsage end_mem_usage;
 
+  // The hardware counters when the event begins and ends, only set when the
+  // buffer has a HardwareCounterReader.
+  hardware::HardwareCounters begin_hw_counters;
+  hardware::HardwareCounters end_hw_counters;
+
   // The field containing the type of event. This must be one of the event types
   // in EventType.
   EventType event_type;
@@ -89,6 +95,12 @@ class ProfileBuffer {
     if (event_type != Profiler::EventType::OPERATOR_INVOKE_EVENT) {
       event_buffer_[index].begin_mem_usage = memory::GetMemoryUsage();
     }
+    // Read last, so that the counters include as little of the profiling as
+    // possible.
+    event_buffer_[index].begin_hw_counters =
+        hw_counter_reader_ ? hw_counter_reader_->Read()
+                           : hardware::HardwareCounters();
+    event_buffer_[index].end_hw_counters = hardware::HardwareCounters();
     current_index_++;
     return index;
   }
@@ -96,6 +108,14 @@ class ProfileBuffer {
   // Sets the enabled state of buffer to |enabled|
   void SetEnabled(bool enabled) { enabled_ = enabled; }
 
+  // Sets the reader of the hardware counters recorded with each event that
+  // begins and ends, or nullptr not to record them. Reading the counters
+  // takes a few system calls, so it adds to the duration of the events.
+  void SetHardwareCounterReader(
+      const hardware::HardwareCounterReader* hw_counter_reader) {
+    hw_counter_reader_ = hw_counter_reader;
+  }
+
   // Sets the end timestamp for event for the handle to current time.
   // If the buffer is disabled or previous event has been overwritten this
   // operation has not effect.
@@ -113,6 +133,9 @@ class ProfileBuffer {
     }
 
     int event_index = event_handle % max_size;
+    if (hw_counter_reader_) {
+      event_buffer_[event_index].end_hw_counters = hw_counter_reader_->Read();
+    }
     event_buffer_[event_index].end_timestamp_us = time::NowMicros();
     if (event_buffer_[event_index].event_type !=
         Profiler::EventType::OPERATOR_INVOKE_EVENT) {
@@ -143,6 +166,8 @@ class ProfileBuffer {
     event_buffer_[index].extra_event_metadata = event_metadata2;
     event_buffer_[index].begin_timestamp_us = start;
     event_buffer_[index].end_timestamp_us = end;
+    event_buffer_[index].begin_hw_counters = hardware::HardwareCounters();
+    event_buffer_[index].end_hw_counters = hardware::HardwareCounters();
     current_index_++;
   }
 
@@ -177,6 +202,7 @@ class ProfileBuffer {
   bool enabled_;
   uint32_t current_index_;
   std::vector<ProfileEvent> event_buffer_;
+  const hardware::HardwareCounterReader* hw_counter_reader_ = nullptr;
 };
 
 }  // namespace profiling
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 
+#include <algorithm>
+#include <iomanip>
 #include <memory>
 #include <sstream>
 
@@ -156,6 +158,9 @@ void ProfileSummarizer::ProcessProfiles(
       stats_calculator->AddNodeStats(node_name_in_stats, type_in_stats,
                                      node_num, start_us, node_exec_time,
                                      0 /*memory */);
+      AddHardwareCounterStats(
+          std::to_string(subgraph_index) + "/" + node_name_in_stats,
+          type_in_stats, node_num, node_exec_time, *event);
     } else if (event->event_type ==
                Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT) {
       const std::string node_name(event->tag);
@@ -167,6 +172,9 @@ void ProfileSummarizer::ProcessProfiles(
       delegate_stats_calculator_->AddNodeStats(
           node_name_in_stats, "DelegateOpInvoke", node_num, start_us,
           node_exec_time, 0 /*memory */);
+      AddHardwareCounterStats(
+          node_name_in_stats, "DelegateOpInvoke", node_num, node_exec_time,
+          *event);
     } else {
       // TODO(b/139812778) consider use a different stats_calculator to record
       // non-op-invoke events so that these could be separated from
@@ -201,6 +209,78 @@ void ProfileSummarizer::ProcessProfiles(
   }
 }
 
+void ProfileSummarizer::AddHardwareCounterStats(
+    const std::string& name, const std::string& type, int64_t run_order,
+    int64_t time_us, const ProfileEvent& event) {
+  if (!event.begin_hw_counters.IsSet() || !event.end_hw_counters.IsSet()) {
+    return;
+  }
+  const hardware::HardwareCounters counters =
+      event.end_hw_counters - event.begin_hw_counters;
+  auto& stats = hardware_counter_stats_[name];
+  if (stats.count == 0) {
+    stats.type = type;
+    stats.run_order = run_order;
+  }
+  ++stats.count;
+  stats.time_us += time_us;
+  stats.cycles += counters.cycles;
+  stats.instructions += counters.instructions;
+  stats.cache_references += counters.cache_references;
+  stats.cache_misses += counters.cache_misses;
+}
+
+std::string ProfileSummarizer::GetHardwareCountersString() const {
+  if (hardware_counter_stats_.empty()) return "";
+
+  std::vector<std::pair<std::string, const HardwareCounterStats*>> nodes;
+  for (const auto& node : hardware_counter_stats_) {
+    nodes.emplace_back(node.first, &node.second);
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const std::pair<std::string, const HardwareCounterStats*>& a,
+               const std::pair<std::string, const HardwareCounterStats*>& b) {
+              return a.second->run_order < b.second->run_order;
+            });
+
+  std::stringstream stream;
+  stream << "============================== Hardware counters per node "
+            "==============================\n";
+  stream << std::setw(24) << "[node type]" << std::setw(10) << "[avg ms]"
+         << std::setw(16) << "[instrs (K)]" << std::setw(8) << "[IPC]"
+         << std::setw(16) << "[misses (K)]" << std::setw(12) << "[miss %]"
+         << std::setw(14) << "[est. GB/s]"
+         << "\t[Name]\n";
+  stream << std::fixed;
+  for (const auto& node : nodes) {
+    const HardwareCounterStats& stats = *node.second;
+    const double count = stats.count;
+    const double ipc =
+        stats.cycles > 0 ? static_cast<double>(stats.instructions) /
+                               stats.cycles
+                         : 0.0;
+    const double miss_percent =
+        stats.cache_references > 0
+            ? 100.0 * stats.cache_misses / stats.cache_references
+            : 0.0;
+    // Bytes per microsecond, divided by 1000, are gigabytes per second.
+    const double memory_gb_per_s =
+        stats.time_us > 0 ? static_cast<double>(stats.cache_misses) *
+                                hardware::HardwareCounters::kCacheLineBytes /
+                                stats.time_us / 1000.0
+                          : 0.0;
+    stream << std::setw(24) << stats.type << std::setprecision(3)
+           << std::setw(10) << stats.time_us / count / 1000.0
+           << std::setprecision(1) << std::setw(16)
+           << stats.instructions / count / 1000.0 << std::setprecision(2)
+           << std::setw(8) << ipc << std::setprecision(1) << std::setw(16)
+           << stats.cache_misses / count / 1000.0 << std::setw(12)
+           << miss_percent << std::setprecision(3) << std::setw(14)
+           << memory_gb_per_s << "\t" << node.first << "\n";
+  }
+  return stream.str();
+}
+
 tensorflow::StatsCalculator* ProfileSummarizer::GetStatsCalculator(
     uint32_t subgraph_index) {
   if (stats_calculator_map_.count(subgraph_index) == 0) {
@@ -17,11 +17,14 @@ limitations under the License.
 #define TENSORFLOW_LITE_PROFILING_PROFILE_SUMMARIZER_H_
 
 #include <functional>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "tensorflow/core/util/stats_calculator.h"
 #include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/profiling/hardware_counters.h"
 #include "tensorflow/lite/profiling/profile_buffer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 
@@ -41,10 +44,12 @@ class ProfileSummarizer {
                        const tflite::Interpreter& interpreter);
 
   // Returns a string detailing the accumulated runtime stats in the format of
-  // summary_formatter_.
+  // summary_formatter_, followed by the hardware counters of the operators
+  // if they were recorded.
   std::string GetOutputString() {
     return summary_formatter_->GetOutputString(stats_calculator_map_,
-                                               *delegate_stats_calculator_);
+                                               *delegate_stats_calculator_) +
+           GetHardwareCountersString();
   }
 
   std::string GetShortSummary() {
@@ -63,12 +68,36 @@ class ProfileSummarizer {
   }
 
  private:
+  // The hardware counters accumulated over the invocations of an operator.
+  struct HardwareCounterStats {
+    std::string type;
+    int64_t run_order = 0;
+    int64_t count = 0;
+    int64_t time_us = 0;
+    int64_t cycles = 0;
+    int64_t instructions = 0;
+    int64_t cache_references = 0;
+    int64_t cache_misses = 0;
+  };
+
+  // Accumulates the hardware counters recorded by `event`, if any.
+  void AddHardwareCounterStats(const std::string& name,
+                               const std::string& type, int64_t run_order,
+                               int64_t time_us, const ProfileEvent& event);
+
+  // Returns a table of the hardware counters per operator, or an empty string
+  // if none were recorded.
+  std::string GetHardwareCountersString() const;
+
   // Map storing stats per subgraph.
   std::map<uint32_t, std::unique_ptr<tensorflow::StatsCalculator>>
       stats_calculator_map_;
 
   std::unique_ptr<tensorflow::StatsCalculator> delegate_stats_calculator_;
 
+  // Hardware counter stats per operator, keyed by their name in the stats.
+  std::map<std::string, HardwareCounterStats> hardware_counter_stats_;
+
   // Summary formatter for customized output formats.
   std::shared_ptr<ProfileSummaryFormatter> summary_formatter_;
 };
@@ -0,0 +1,68 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shared_constant_cache.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace tflite {
+namespace {
+
+// The alignment of the tensor data allocated by the interpreter.
+constexpr size_t kBufferAlignment = 64;
+
+// Returns the first aligned address of a buffer of `kBufferAlignment` more
+// bytes than its data.
+char* AlignedData(char* buffer) {
+  const size_t misalignment =
+      reinterpret_cast<uintptr_t>(buffer) % kBufferAlignment;
+  return misalignment == 0 ? buffer : buffer + kBufferAlignment - misalignment;
+}
+
+}  // namespace
+
+SharedConstantCache::SharedConstantCache() {
+  this->type = kTfLiteSharedConstantCacheContext;
+  this->Refresh = nullptr;
+}
+
+SharedConstantCache* SharedConstantCache::GetFromContext(
+    TfLiteContext* context) {
+  return static_cast<SharedConstantCache*>(
+      context->GetExternalContext(context, kTfLiteSharedConstantCacheContext));
+}
+
+const void* SharedConstantCache::GetOrCreate(const void* source, Kind kind,
+                                             size_t bytes,
+                                             const FillFunction& fill) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Key key(source, kind, bytes);
+  auto it = buffers_.find(key);
+  if (it == buffers_.end()) {
+    std::unique_ptr<char[]> buffer(new char[bytes + kBufferAlignment]);
+    if (fill(AlignedData(buffer.get())) != kTfLiteOk) {
+      return nullptr;
+    }
+    it = buffers_.emplace(key, std::move(buffer)).first;
+  }
+  return AlignedData(it->second.get());
+}
+
+size_t SharedConstantCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return buffers_.size();
+}
+
+}  // namespace tflite
@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_SHARED_CONSTANT_CACHE_H_
+#define TENSORFLOW_LITE_SHARED_CONSTANT_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <tuple>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// A cache of read-only data derived from the constant tensors of a model, such
+// as dequantized weights, which can be shared by several interpreters built
+// from the same FlatBufferModel, e.g. to run them concurrently, so that the
+// data is computed and stored once rather than once per interpreter.
+//
+// The data is keyed by the address of the constant buffer it is derived from,
+// so the models of the interpreters sharing the cache must outlive it. The
+// cache is set on each interpreter with
+//   interpreter->SetExternalContext(kTfLiteSharedConstantCacheContext, &cache);
+// before AllocateTensors(), and must outlive the interpreters. It is safe to
+// use from several threads.
+class SharedConstantCache : public TfLiteExternalContext {
+ public:
+  // Kinds of data derived from a constant buffer, so that the data derived
+  // from the same buffer by different kernels are cached separately.
+  enum Kind {
+    // The buffer dequantized to float32, by the Dequantize kernel.
+    kDequantizedFloat32 = 0,
+  };
+
+  // Fills the `bytes` bytes of `data` with the derived data.
+  using FillFunction = std::function<TfLiteStatus(void* data)>;
+
+  SharedConstantCache();
+  ~SharedConstantCache() {}
+
+  // Returns the cache set on the interpreter of `context`, or nullptr if there
+  // is none.
+  static SharedConstantCache* GetFromContext(TfLiteContext* context);
+
+  // Returns the `bytes` bytes of data of `kind` derived from the constant
+  // buffer at `source`, calling `fill` to compute them the first time. The
+  // returned data is aligned for any tensor type, and lives as long as the
+  // cache. Returns nullptr if `fill` fails.
+  const void* GetOrCreate(const void* source, Kind kind, size_t bytes,
+                          const FillFunction& fill);
+
+  // Returns the number of buffers of derived data in the cache.
+  size_t size() const;
+
+ private:
+  using Key = std::tuple<const void*, Kind, size_t>;
+
+  mutable std::mutex mutex_;
+  std::map<Key, std::unique_ptr<char[]>> buffers_;
+
+  SharedConstantCache(const SharedConstantCache&) = delete;
+  SharedConstantCache& operator=(const SharedConstantCache&) = delete;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_SHARED_CONSTANT_CACHE_H_
@@ -0,0 +1,138 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shared_constant_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+TEST(SharedConstantCacheTest, FillsOnce) {
+  SharedConstantCache cache;
+  const int32_t source[4] = {1, 2, 3, 4};
+  int num_fills = 0;
+  auto fill = [&](void* data) {
+    ++num_fills;
+    std::memcpy(data, source, sizeof(source));
+    return kTfLiteOk;
+  };
+
+  const void* data = cache.GetOrCreate(
+      source, SharedConstantCache::kDequantizedFloat32, sizeof(source), fill);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % 64, 0);
+  EXPECT_EQ(std::memcmp(data, source, sizeof(source)), 0);
+  EXPECT_EQ(cache.GetOrCreate(source, SharedConstantCache::kDequantizedFloat32,
+                              sizeof(source), fill),
+            data);
+  EXPECT_EQ(num_fills, 1);
+  EXPECT_EQ(cache.size(), 1);
+
+  // Data derived from another buffer is cached separately.
+  EXPECT_NE(cache.GetOrCreate(source + 1,
+                              SharedConstantCache::kDequantizedFloat32,
+                              sizeof(source), fill),
+            data);
+  EXPECT_EQ(num_fills, 2);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(SharedConstantCacheTest, FailedFillIsNotCached) {
+  SharedConstantCache cache;
+  const int32_t source = 0;
+  EXPECT_EQ(cache.GetOrCreate(&source, SharedConstantCache::kDequantizedFloat32,
+                              sizeof(source),
+                              [](void*) { return kTfLiteError; }),
+            nullptr);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+// Builds an interpreter dequantizing the constant `weights`, as if built from
+// a model holding them.
+std::unique_ptr<Interpreter> BuildDequantizeInterpreter(
+    const int8_t* weights, int size, SharedConstantCache* cache) {
+  std::unique_ptr<Interpreter> interpreter(new Interpreter);
+  EXPECT_EQ(interpreter->AddTensors(2), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetInputs({}), kTfLiteOk);
+  EXPECT_EQ(interpreter->SetOutputs({1}), kTfLiteOk);
+  TfLiteQuantizationParams quantized = {0.5, 1};
+  EXPECT_EQ(interpreter->SetTensorParametersReadOnly(
+                0, kTfLiteInt8, "weights", {size}, quantized,
+                reinterpret_cast<const char*>(weights), size),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->SetTensorParametersReadWrite(
+                1, kTfLiteFloat32, "dequantized", {size},
+                TfLiteQuantizationParams()),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->AddNodeWithParameters(
+                {0}, {1}, nullptr, 0, nullptr,
+                ops::builtin::Register_DEQUANTIZE()),
+            kTfLiteOk);
+  if (cache != nullptr) {
+    interpreter->SetExternalContext(kTfLiteSharedConstantCacheContext, cache);
+  }
+  return interpreter;
+}
+
+TEST(SharedConstantCacheTest, SharesDequantizedWeights) {
+  const int8_t weights[4] = {1, 3, 5, 7};
+  SharedConstantCache cache;
+  std::unique_ptr<Interpreter> interpreters[2];
+  for (auto& interpreter : interpreters) {
+    interpreter = BuildDequantizeInterpreter(weights, 4, &cache);
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+    EXPECT_THAT(std::vector<float>(interpreter->typed_output_tensor<float>(0),
+                                   interpreter->typed_output_tensor<float>(0) +
+                                       4),
+                ::testing::ElementsAre(0, 1, 2, 3));
+  }
+  EXPECT_EQ(interpreters[0]->typed_output_tensor<float>(0),
+            interpreters[1]->typed_output_tensor<float>(0));
+  EXPECT_EQ(cache.size(), 1);
+
+  // Reallocating keeps the shared data.
+  ASSERT_EQ(interpreters[0]->AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreters[0]->Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreters[0]->typed_output_tensor<float>(0),
+            interpreters[1]->typed_output_tensor<float>(0));
+
+  // Without the cache, each interpreter has its own copy.
+  std::unique_ptr<Interpreter> unshared =
+      BuildDequantizeInterpreter(weights, 4, nullptr);
+  ASSERT_EQ(unshared->AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(unshared->Invoke(), kTfLiteOk);
+  EXPECT_NE(unshared->typed_output_tensor<float>(0),
+            interpreters[0]->typed_output_tensor<float>(0));
+  EXPECT_EQ(unshared->typed_output_tensor<float>(0)[3], 3);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
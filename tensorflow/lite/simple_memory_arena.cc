@@ -64,7 +64,7 @@ TfLiteStatus SimpleMemoryArena::Allocate(
     if (aligned_current_offset + size <= alloc.offset &&
         alloc.offset - aligned_current_offset < best_offset_fit) {
       best_offset = aligned_current_offset;
-      best_offset_fit = alloc.offset - current_offset;
+      best_offset_fit = alloc.offset - aligned_current_offset;
     }
     current_offset = std::max(current_offset, alloc.offset + alloc.size);
   }
@@ -72,16 +72,46 @@ TfLiteStatus SimpleMemoryArena::Allocate(
     best_offset = AlignTo(alignment, current_offset);
   }
 
-  // Update the required buffer size.
-  high_water_mark_ = std::max(high_water_mark_, best_offset + size);
   new_alloc->offset = best_offset;
+  InsertAlloc(*new_alloc);
+  return kTfLiteOk;
+}
+
+bool SimpleMemoryArena::AllocateAt(size_t alignment, size_t offset,
+                                   size_t size, int32_t tensor,
+                                   int32_t first_node, int32_t last_node,
+                                   ArenaAllocWithUsageInterval* new_alloc) {
+  if (alignment > arena_alignment_ || offset % alignment != 0) {
+    return false;
+  }
+  for (const auto& alloc : ordered_allocs_) {
+    if (alloc.last_node < first_node || alloc.first_node > last_node) {
+      continue;
+    }
+    if (alloc.offset < offset + size && offset < alloc.offset + alloc.size) {
+      return false;
+    }
+  }
+  new_alloc->tensor = tensor;
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  new_alloc->size = size;
+  new_alloc->offset = size == 0 ? 0 : offset;
+  if (size != 0) {
+    InsertAlloc(*new_alloc);
+  }
+  return true;
+}
+
+void SimpleMemoryArena::InsertAlloc(const ArenaAllocWithUsageInterval& alloc) {
+  // Update the required buffer size.
+  high_water_mark_ = std::max(high_water_mark_, alloc.offset + alloc.size);
 
   auto insertion_it = ordered_allocs_.begin();
-  while (insertion_it != ordered_allocs_.end() && *insertion_it < *new_alloc) {
+  while (insertion_it != ordered_allocs_.end() && *insertion_it < alloc) {
     ++insertion_it;
   }
-  ordered_allocs_.insert(insertion_it, *new_alloc);
-  return kTfLiteOk;
+  ordered_allocs_.insert(insertion_it, alloc);
 }
 
 TfLiteStatus SimpleMemoryArena::Deallocate(
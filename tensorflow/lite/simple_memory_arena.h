@@ -73,9 +73,21 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Schedules the memory allocation of a tensor at a given offset, e.g. one
+  // planned offline, instead of the one Allocate() would choose. Returns false
+  // without scheduling it if the offset isn't aligned, or if the allocation
+  // would overlap another one whose usage interval intersects with
+  // [first_node, last_node].
+  bool AllocateAt(size_t alignment, size_t offset, size_t size, int32_t tensor,
+                  int32_t first_node, int32_t last_node,
+                  ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
+  // Returns true if any allocation is scheduled in the arena.
+  bool HasAllocations() const { return !ordered_allocs_.empty(); }
+
   inline size_t RequiredBufferSize() {
     // Add in a small amount of padding to reduce the chance of resize events
     // for small allocations.
@@ -106,6 +118,10 @@ class SimpleMemoryArena {
   }
 
  private:
+  // Adds 'alloc' to the allocations ordered by offset, and grows the required
+  // buffer size to hold it.
+  void InsertAlloc(const ArenaAllocWithUsageInterval& alloc);
+
   bool committed_;
   size_t arena_alignment_;
   size_t high_water_mark_;
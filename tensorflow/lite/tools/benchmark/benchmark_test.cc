@@ -373,6 +373,18 @@ TEST(BenchmarkTest, RunWithUseCaching) {
   EXPECT_EQ(kTfLiteOk, status);
 }
 
+TEST(BenchmarkTest, RunWithMultipleInterpreters) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  for (bool share_weights : {true, false}) {
+    BenchmarkParams params = CreateFp32Params();
+    params.Set<int32_t>("num_interpreters", 3);
+    params.Set<bool>("pin_interpreter_threads", true);
+    params.Set<bool>("share_interpreter_weights", share_weights);
+    TestBenchmark benchmark(std::move(params));
+    EXPECT_EQ(kTfLiteOk, benchmark.Run());
+  }
+}
+
 class MaxDurationWorksTestListener : public BenchmarkListener {
   void OnBenchmarkEnd(const BenchmarkResults& results) override {
     const int64_t num_actual_runs = results.inference_time_us().count();
@@ -15,14 +15,22 @@ limitations under the License.
 
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
 
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <cstdarg>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <unordered_set>
 #include <vector>
 
@@ -34,7 +42,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/op_resolver.h"
+#include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/time.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
@@ -231,6 +241,26 @@ CreateProfileSummaryFormatter(bool format_as_csv) {
              : std::make_shared<profiling::ProfileSummaryDefaultFormatter>();
 }
 
+// Pins the calling thread to the CPU 'cpu', where supported.
+void PinCurrentThreadToCpu(int cpu) {
+#if defined(__linux__) || defined(__ANDROID__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    TFLITE_LOG(WARN) << "Failed to pin a benchmark thread to CPU " << cpu;
+  }
+#else
+  TFLITE_LOG(WARN) << "Pinning threads isn't supported on this platform.";
+#endif
+}
+
+// Returns the 'percentile'-th percentile of the sorted 'values'.
+int64_t GetPercentile(const std::vector<int64_t>& values, int percentile) {
+  if (values.empty()) return 0;
+  return values[(values.size() - 1) * percentile / 100];
+}
+
 }  // namespace
 
 BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
@@ -254,6 +284,14 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<int32_t>(1024));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("profile_hardware_counters",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("num_interpreters",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("pin_interpreter_threads",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("share_interpreter_weights",
+                          BenchmarkParam::Create<bool>(true));
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -314,7 +352,22 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<std::string>(
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
-          "prints to stdout.")};
+          "prints to stdout."),
+      CreateFlag<bool>("profile_hardware_counters", &params_,
+                       "also record the CPU cycles, instructions and cache "
+                       "misses of each op when op profiling is enabled"),
+      CreateFlag<int32_t>(
+          "num_interpreters", &params_,
+          "If above 1, also measure the throughput of this number of "
+          "interpreters, each invoked in a loop on a thread of its own"),
+      CreateFlag<bool>("pin_interpreter_threads", &params_,
+                       "pin the thread of each interpreter of the throughput "
+                       "benchmark to a CPU of its own, where supported"),
+      CreateFlag<bool>(
+          "share_interpreter_weights", &params_,
+          "whether the interpreters of the throughput benchmark share the "
+          "model and the data derived from its weights, or each load the "
+          "model on their own")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
 
@@ -349,6 +402,14 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Max profiling buffer entries", verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "profile_hardware_counters",
+                      "Profile hardware counters", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_interpreters", "Num interpreters",
+                      verbose);
+  LOG_BENCHMARK_PARAM(bool, "pin_interpreter_threads",
+                      "Pin interpreter threads", verbose);
+  LOG_BENCHMARK_PARAM(bool, "share_interpreter_weights",
+                      "Share interpreter weights", verbose);
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -362,6 +423,10 @@ TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
         << "Please specify the name of your TF Lite input file with --graph";
     return kTfLiteError;
   }
+  if (params_.Get<int32_t>("num_interpreters") < 1) {
+    TFLITE_LOG(ERROR) << "--num_interpreters must be at least 1";
+    return kTfLiteError;
+  }
 
   return PopulateInputLayerInfo(
       params_.Get<std::string>("input_layer"),
@@ -546,11 +611,16 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  auto interpreter_inputs = interpreter_->inputs();
+  return SetInputTensors(interpreter_.get());
+}
+
+TfLiteStatus BenchmarkTfLiteModel::SetInputTensors(
+    tflite::Interpreter* interpreter) {
+  auto interpreter_inputs = interpreter->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < interpreter_inputs.size(); ++j) {
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -728,10 +798,167 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<std::string>("profiling_output_csv_file"),
       CreateProfileSummaryFormatter(
-          !params_.Get<std::string>("profiling_output_csv_file").empty())));
+          !params_.Get<std::string>("profiling_output_csv_file").empty()),
+      params_.Get<bool>("profile_hardware_counters")));
 }
 
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
 
+TfLiteStatus BenchmarkTfLiteModel::Run() {
+  TF_LITE_ENSURE_STATUS(BenchmarkModel::Run());
+  if (params_.Get<int32_t>("num_interpreters") <= 1) return kTfLiteOk;
+  return RunThroughputBenchmark();
+}
+
+TfLiteStatus BenchmarkTfLiteModel::InitThroughputWorker(
+    SharedConstantCache* constant_cache, ThroughputWorker* worker) {
+  const FlatBufferModel* model = model_.get();
+  if (!constant_cache) {
+    const std::string graph = params_.Get<std::string>("graph");
+    worker->model = tflite::FlatBufferModel::BuildFromFile(graph.c_str());
+    if (!worker->model) {
+      TFLITE_LOG(ERROR) << "Failed to mmap model " << graph;
+      return kTfLiteError;
+    }
+    model = worker->model.get();
+  }
+  auto resolver = GetOpResolver();
+  tflite::InterpreterBuilder(*model, *resolver)(
+      &worker->interpreter, params_.Get<int32_t>("num_threads"));
+  if (!worker->interpreter) {
+    TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
+    return kTfLiteError;
+  }
+  tflite::Interpreter* interpreter = worker->interpreter.get();
+  if (constant_cache) {
+    interpreter->SetExternalContext(kTfLiteSharedConstantCacheContext,
+                                    constant_cache);
+  }
+  interpreter->SetAllowFp16PrecisionForFp32(params_.Get<bool>("allow_fp16"));
+
+  for (const auto& delegate_provider :
+       tools::GetRegisteredDelegateProviders()) {
+    auto delegate = delegate_provider->CreateTfLiteDelegate(params_);
+    if (delegate == nullptr) continue;
+    if (interpreter->ModifyGraphWithDelegate(delegate.get()) != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to apply " << delegate_provider->GetName()
+                        << " delegate.";
+      return kTfLiteError;
+    }
+    worker->delegates.emplace_back(std::move(delegate));
+  }
+
+  for (int j = 0; j < inputs_.size(); ++j) {
+    const int i = interpreter->inputs()[j];
+    if (interpreter->tensor(i)->type != kTfLiteString) {
+      interpreter->ResizeInputTensor(i, inputs_[j].shape);
+    }
+  }
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
+    return kTfLiteError;
+  }
+  return SetInputTensors(interpreter);
+}
+
+TfLiteStatus BenchmarkTfLiteModel::RunThroughputBenchmark() {
+  const int num_interpreters = params_.Get<int32_t>("num_interpreters");
+  const bool pin_threads = params_.Get<bool>("pin_interpreter_threads");
+  const int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+
+  // Declared before the workers so that it outlives their interpreters.
+  SharedConstantCache constant_cache;
+  std::vector<ThroughputWorker> workers(num_interpreters);
+  for (int i = 0; i < num_interpreters; ++i) {
+    const auto start_mem_usage = profiling::memory::GetMemoryUsage();
+    TF_LITE_ENSURE_STATUS(InitThroughputWorker(
+        params_.Get<bool>("share_interpreter_weights") ? &constant_cache
+                                                       : nullptr,
+        &workers[i]));
+    const auto mem_usage =
+        profiling::memory::GetMemoryUsage() - start_mem_usage;
+    if (profiling::memory::MemoryUsage::IsSupported()) {
+      const double in_use_mb =
+          mem_usage.in_use_allocated_bytes / (1024.0 * 1024.0);
+      TFLITE_LOG(INFO) << "Memory of interpreter " << i
+                       << " (MB): in use=" << in_use_mb
+                       << " rss increase=" << mem_usage.max_rss_kb / 1024.0;
+    }
+  }
+
+  const int32_t warmup_runs = params_.Get<int32_t>("warmup_runs");
+  const int32_t num_runs = params_.Get<int32_t>("num_runs");
+  const float min_secs = params_.Get<float>("min_secs");
+  const float max_secs = params_.Get<float>("max_secs");
+
+  // The timed runs of all the interpreters start together, once each is
+  // warmed up.
+  std::mutex mutex;
+  std::condition_variable cond;
+  int num_ready = 0;
+  bool started = false;
+  int64_t start_us = 0;
+  std::vector<std::thread> threads;
+  for (int w = 0; w < num_interpreters; ++w) {
+    threads.emplace_back([&, w]() {
+      ThroughputWorker& worker = workers[w];
+      if (pin_threads) PinCurrentThreadToCpu(w % num_cpus);
+      for (int run = 0; run < warmup_runs; ++run) {
+        worker.interpreter->Invoke();
+      }
+      int64_t now_us;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++num_ready;
+        cond.notify_all();
+        cond.wait(lock, [&]() { return started; });
+        now_us = start_us;
+      }
+      const int64_t min_finish_us =
+          now_us + static_cast<int64_t>(min_secs * 1.e6f);
+      const int64_t max_finish_us =
+          now_us + static_cast<int64_t>(max_secs * 1.e6f);
+      for (int run = 0; (run < num_runs || now_us < min_finish_us) &&
+                        now_us <= max_finish_us;
+           run++) {
+        const int64_t run_start_us = profiling::time::NowMicros();
+        const TfLiteStatus status = worker.interpreter->Invoke();
+        now_us = profiling::time::NowMicros();
+        worker.latencies_us.push_back(now_us - run_start_us);
+        if (status != kTfLiteOk) worker.status = status;
+      }
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&]() { return num_ready == num_interpreters; });
+    start_us = profiling::time::NowMicros();
+    started = true;
+  }
+  cond.notify_all();
+  for (auto& thread : threads) thread.join();
+  const int64_t duration_us = profiling::time::NowMicros() - start_us;
+
+  TfLiteStatus status = kTfLiteOk;
+  std::vector<int64_t> latencies_us;
+  for (const ThroughputWorker& worker : workers) {
+    latencies_us.insert(latencies_us.end(), worker.latencies_us.begin(),
+                        worker.latencies_us.end());
+    if (worker.status != kTfLiteOk) status = worker.status;
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  const double inferences_per_sec =
+      latencies_us.size() * 1e6 / std::max<int64_t>(duration_us, 1);
+  TFLITE_LOG(INFO) << "Throughput of " << num_interpreters
+                   << " interpreters: " << inferences_per_sec
+                   << " inferences/s over " << latencies_us.size()
+                   << " runs, latency in us: p50="
+                   << GetPercentile(latencies_us, 50)
+                   << " p90=" << GetPercentile(latencies_us, 90)
+                   << " p99=" << GetPercentile(latencies_us, 99)
+                   << " max=" << GetPercentile(latencies_us, 100);
+  return status;
+}
+
 }  // namespace benchmark
 }  // namespace tflite
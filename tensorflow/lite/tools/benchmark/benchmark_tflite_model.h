@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/profiling/profiler.h"
+#include "tensorflow/lite/shared_constant_cache.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
 
 namespace tflite {
@@ -55,6 +56,9 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   explicit BenchmarkTfLiteModel(BenchmarkParams params = DefaultParams());
   ~BenchmarkTfLiteModel() override;
 
+  using BenchmarkModel::Run;
+  // Also runs the throughput benchmark when 'num_interpreters' is above 1.
+  TfLiteStatus Run() override;
   std::vector<Flag> GetFlags() override;
   void LogParams() override;
   TfLiteStatus ValidateParams() override;
@@ -81,6 +85,11 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // necessary.
   virtual std::unique_ptr<BenchmarkListener> MayCreateProfilingListener() const;
 
+  // Runs 'num_interpreters' interpreters concurrently, each invoked in a loop
+  // on a thread of its own, and logs their aggregate number of inferences per
+  // second, the percentiles of their latencies and the memory used by each.
+  TfLiteStatus RunThroughputBenchmark();
+
   void CleanUp();
 
   std::unique_ptr<tflite::FlatBufferModel> model_;
@@ -118,6 +127,26 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   InputTensorData LoadInputTensorData(const TfLiteTensor& t,
                                       const std::string& input_file_path);
 
+  // Sets the input tensors of 'interpreter' from inputs_data_.
+  TfLiteStatus SetInputTensors(tflite::Interpreter* interpreter);
+
+  // An interpreter of the throughput benchmark, with what it depends on.
+  struct ThroughputWorker {
+    // Only set when the interpreters don't share the model.
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    std::vector<Interpreter::TfLiteDelegatePtr> delegates;
+    std::vector<int64_t> latencies_us;
+    TfLiteStatus status = kTfLiteOk;
+  };
+
+  // Builds the interpreter of 'worker', with the same delegates and input
+  // shapes as interpreter_. If 'constant_cache' is set, the interpreter is
+  // built from model_ and shares the data derived from its weights through
+  // the cache, otherwise it loads a model of its own.
+  TfLiteStatus InitThroughputWorker(SharedConstantCache* constant_cache,
+                                    ThroughputWorker* worker);
+
   std::vector<InputLayerInfo> inputs_;
   std::vector<InputTensorData> inputs_data_;
   std::unique_ptr<BenchmarkListener> profiling_listener_ = nullptr;
@@ -33,7 +33,8 @@ class ProfilingListener : public BenchmarkListener {
       Interpreter* interpreter, uint32_t max_num_entries,
       const std::string& csv_file_path = "",
       std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter =
-          std::make_shared<profiling::ProfileSummaryDefaultFormatter>());
+          std::make_shared<profiling::ProfileSummaryDefaultFormatter>(),
+      bool profile_hardware_counters = false);
 
   void OnBenchmarkStart(const BenchmarkParams& params) override;
 
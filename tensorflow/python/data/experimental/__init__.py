@@ -46,7 +46,9 @@ See [Importing Data](https://tensorflow.org/guide/datasets) for an overview.
 @@ThreadingOptions
 
 @@assert_cardinality
+@@block_shuffled_tfrecord_dataset
 @@bucket_by_sequence_length
+@@bucket_by_token_budget
 @@bytes_produced_stats
 @@cardinality
 @@choose_from_datasets
@@ -71,6 +73,7 @@ See [Importing Data](https://tensorflow.org/guide/datasets) for an overview.
 @@map_and_batch_with_legacy_function
 @@parallel_interleave
 @@parse_example_dataset
+@@persistent_cache
 @@prefetch_to_device
 @@rejection_resample
 @@sample_from_datasets
@@ -110,6 +113,7 @@ from tensorflow.python.data.experimental.ops.enumerate_ops import enumerate_data
 from tensorflow.python.data.experimental.ops.error_ops import ignore_errors
 from tensorflow.python.data.experimental.ops.get_single_element import get_single_element
 from tensorflow.python.data.experimental.ops.grouping import bucket_by_sequence_length
+from tensorflow.python.data.experimental.ops.grouping import bucket_by_token_budget
 from tensorflow.python.data.experimental.ops.grouping import group_by_reducer
 from tensorflow.python.data.experimental.ops.grouping import group_by_window
 from tensorflow.python.data.experimental.ops.grouping import Reducer
@@ -123,10 +127,12 @@ from tensorflow.python.data.experimental.ops.iterator_ops import make_saveable_f
 from tensorflow.python.data.experimental.ops.optimization_options import MapVectorizationOptions
 from tensorflow.python.data.experimental.ops.optimization_options import OptimizationOptions
 from tensorflow.python.data.experimental.ops.parsing_ops import parse_example_dataset
+from tensorflow.python.data.experimental.ops.persistent_cache import persistent_cache
 from tensorflow.python.data.experimental.ops.prefetching_ops import copy_to_device
 from tensorflow.python.data.experimental.ops.prefetching_ops import prefetch_to_device
 from tensorflow.python.data.experimental.ops.random_ops import RandomDataset
 from tensorflow.python.data.experimental.ops.readers import CsvDataset
+from tensorflow.python.data.experimental.ops.readers import block_shuffled_tfrecord_dataset
 from tensorflow.python.data.experimental.ops.readers import make_batched_features_dataset
 from tensorflow.python.data.experimental.ops.readers import make_csv_dataset
 from tensorflow.python.data.experimental.ops.readers import SqlDataset
@@ -0,0 +1,119 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.block_shuffled_tfrecord_dataset()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import readers
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
+from tensorflow.python.lib.io import python_io
+from tensorflow.python.platform import test
+from tensorflow.python.util import compat
+
+
+class BlockShuffledTFRecordDatasetTest(test_base.DatasetTestBase,
+                                       parameterized.TestCase):
+
+  def setUp(self):
+    super(BlockShuffledTFRecordDatasetTest, self).setUp()
+    self._num_files = 3
+    self._num_records = 10
+    self._filenames = self._createFiles()
+
+  def _record(self, f, r):
+    return compat.as_bytes("Record %d of file %d" % (r, f))
+
+  def _createFiles(self):
+    filenames = []
+    for i in range(self._num_files):
+      fn = os.path.join(self.get_temp_dir(), "tf_record.%d.txt" % i)
+      filenames.append(fn)
+      writer = python_io.TFRecordWriter(fn)
+      for j in range(self._num_records):
+        writer.write(self._record(i, j))
+      writer.close()
+    return filenames
+
+  def _allRecords(self):
+    return [
+        self._record(f, r)
+        for f in range(self._num_files)
+        for r in range(self._num_records)
+    ]
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(block_size=[1, 3, 100], window_size=[1, 4])))
+  def testProducesAllRecords(self, block_size, window_size):
+    dataset = readers.block_shuffled_tfrecord_dataset(
+        self._filenames, block_size, window_size, seed=42)
+    self.assertDatasetProduces(
+        dataset, self._allRecords(), assert_items_equal=True)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testKeepsBlocksContiguous(self):
+    block_size = 5
+    dataset = readers.block_shuffled_tfrecord_dataset(
+        self._filenames, block_size, window_size=1, seed=42)
+    output = self.getDatasetOutput(dataset)
+    blocks = [
+        output[i:i + block_size] for i in range(0, len(output), block_size)
+    ]
+    expected_blocks = [
+        [self._record(f, r) for r in range(b, b + block_size)]
+        for f in range(self._num_files)
+        for b in range(0, self._num_records, block_size)
+    ]
+    self.assertCountEqual(expected_blocks, blocks)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testSeedDeterminesOrder(self):
+    dataset = readers.block_shuffled_tfrecord_dataset(
+        self._filenames, 2, 4, seed=42, reshuffle_each_iteration=False)
+    other = readers.block_shuffled_tfrecord_dataset(
+        self._filenames, 2, 4, seed=42, reshuffle_each_iteration=False)
+    output = self.getDatasetOutput(dataset)
+    self.assertEqual(output, self.getDatasetOutput(dataset))
+    self.assertEqual(output, self.getDatasetOutput(other))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testReshuffleEachIteration(self):
+    dataset = readers.block_shuffled_tfrecord_dataset(
+        self._filenames, 2, 4, seed=42).repeat(2)
+    output = self.getDatasetOutput(dataset)
+    num_records = self._num_files * self._num_records
+    self.assertCountEqual(output[:num_records], output[num_records:])
+    self.assertNotEqual(output[:num_records], output[num_records:])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidArguments(self):
+    with self.assertRaisesRegex(errors.InvalidArgumentError, "block_size"):
+      dataset = readers.block_shuffled_tfrecord_dataset(self._filenames, 0, 1)
+      self.evaluate(self.getNext(dataset)())
+    with self.assertRaisesRegex(errors.InvalidArgumentError, "window_size"):
+      dataset = readers.block_shuffled_tfrecord_dataset(self._filenames, 1, 0)
+      self.evaluate(self.getNext(dataset)())
+
+
+if __name__ == "__main__":
+  test.main()
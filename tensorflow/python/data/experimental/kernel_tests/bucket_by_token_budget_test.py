@@ -0,0 +1,113 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.bucket_by_token_budget()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import grouping
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+def _sequence_dataset(lengths):
+  """Returns a dataset of sequences `[0, ..., n - 1]` for `n` in `lengths`."""
+  return dataset_ops.Dataset.from_tensor_slices(lengths).map(math_ops.range)
+
+
+def _length(x):
+  return array_ops.shape(x)[0]
+
+
+class BucketByTokenBudgetTest(test_base.DatasetTestBase,
+                              parameterized.TestCase):
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testBatchesWithinBudget(self):
+    dataset = _sequence_dataset([1, 2, 2, 1, 1, 3])
+    dataset = dataset.apply(
+        grouping.bucket_by_token_budget(
+            _length, bucket_boundaries=[2], max_tokens=4))
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[[[0, 1], [0, 1]], [[0, 1, 2]], [[0], [0], [0]]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testPadsToLongestElement(self):
+    dataset = _sequence_dataset([3, 1, 2, 3])
+    dataset = dataset.apply(
+        grouping.bucket_by_token_budget(
+            _length, bucket_boundaries=[], max_tokens=9, padding_values=-1))
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[[[0, 1, 2], [0, -1, -1], [0, 1, -1]], [[0, 1, 2]]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testDropRemainder(self):
+    dataset = _sequence_dataset([1, 2, 2, 1, 1, 3])
+    dataset = dataset.apply(
+        grouping.bucket_by_token_budget(
+            _length, bucket_boundaries=[2], max_tokens=4,
+            drop_remainder=True))
+    self.assertDatasetProduces(
+        dataset, expected_output=[[[0, 1], [0, 1]], [[0, 1, 2]]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testTupleElements(self):
+    dataset = _sequence_dataset([2, 1, 2]).map(
+        lambda x: (x, array_ops.fill([_length(x)], "a")))
+    dataset = dataset.apply(
+        grouping.bucket_by_token_budget(
+            lambda x, y: _length(x), bucket_boundaries=[], max_tokens=4))
+    self.assertEqual([None, None], dataset.element_spec[0].shape.as_list())
+    self.assertEqual(dtypes.string, dataset.element_spec[1].dtype)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[([[0, 1], [0, 0]], [[b"a", b"a"], [b"a", b""]]),
+                         ([[0, 1]], [[b"a", b"a"]])])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testParallelCopy(self):
+    dataset = _sequence_dataset([1, 2, 2, 1, 1, 3])
+    dataset = dataset.apply(
+        grouping.bucket_by_token_budget(
+            _length, bucket_boundaries=[2], max_tokens=4))
+    options = dataset_ops.Options()
+    options.experimental_optimization.parallel_batch = True
+    dataset = dataset.with_options(options)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[[[0, 1], [0, 1]], [[0, 1, 2]], [[0], [0], [0]]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidBucketBoundaries(self):
+    with self.assertRaisesRegex(errors.InvalidArgumentError,
+                                "must be strictly increasing"):
+      dataset = _sequence_dataset([1, 2]).apply(
+          grouping.bucket_by_token_budget(
+              _length, bucket_boundaries=[3, 2], max_tokens=4))
+      self.evaluate(self.getNext(dataset)())
+
+
+if __name__ == "__main__":
+  test.main()
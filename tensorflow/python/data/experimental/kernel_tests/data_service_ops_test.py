@@ -283,6 +283,44 @@ class DataServiceOpsTest(data_service_test_base.TestBase,
       results.append(elem.numpy())
     self.assertCountEqual(num_repetitions * list(range(num_elements)), results)
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testCoordinatedRead(self):
+    cluster = self.create_cluster(num_workers=1)
+    num_consumers = 3
+    num_rounds = 10
+    ds = dataset_ops.Dataset.range(num_consumers * num_rounds)
+    iterators = [
+        iter(
+            self.make_distributed_dataset(
+                ds,
+                cluster,
+                job_name="job_name",
+                consumer_index=i,
+                num_consumers=num_consumers)) for i in range(num_consumers)
+    ]
+    # In round r, consumer i receives element i of the r-th group of
+    # `num_consumers` consecutive elements.
+    for r in range(num_rounds):
+      for i, it in enumerate(iterators):
+        self.assertEqual(r * num_consumers + i, next(it).numpy())
+    for it in iterators:
+      with self.assertRaises(StopIteration):
+        next(it)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testCoordinatedReadInvalidArguments(self):
+    cluster = self.create_cluster(num_workers=1)
+    ds = dataset_ops.Dataset.range(10)
+    with self.assertRaisesRegex(ValueError, "job_name must be set"):
+      self.make_distributed_dataset(
+          ds, cluster, consumer_index=0, num_consumers=2)
+    with self.assertRaisesRegex(ValueError, "Must either set both"):
+      self.make_distributed_dataset(
+          ds, cluster, job_name="job_name", consumer_index=0)
+    with self.assertRaisesRegex(ValueError, "must be in the range"):
+      self.make_distributed_dataset(
+          ds, cluster, job_name="job_name", consumer_index=2, num_consumers=2)
+
   @combinations.generate(
       combinations.times(test_base.eager_only_combinations(),
                          combinations.combine(job_name=[None, "test"])))
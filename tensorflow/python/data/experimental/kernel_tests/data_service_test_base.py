@@ -200,7 +200,9 @@ class TestBase(test_base.DatasetTestBase):
                                cluster,
                                processing_mode="parallel_epochs",
                                job_name=None,
-                               max_outstanding_requests=None):
+                               max_outstanding_requests=None,
+                               consumer_index=None,
+                               num_consumers=None):
     # pylint: disable=protected-access
     return dataset.apply(
         data_service_ops._distribute(
@@ -208,7 +210,9 @@ class TestBase(test_base.DatasetTestBase):
             cluster.target,
             job_name=job_name,
             max_outstanding_requests=max_outstanding_requests,
-            task_refresh_interval_hint_ms=20))
+            task_refresh_interval_hint_ms=20,
+            consumer_index=consumer_index,
+            num_consumers=num_consumers))
 
   def make_distributed_range_dataset(self,
                                      num_elements,
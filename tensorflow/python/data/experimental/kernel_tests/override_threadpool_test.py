@@ -113,6 +113,20 @@ class OverrideThreadpoolTest(test_base.DatasetTestBase,
 
     self._testNumThreadsHelper(num_threads, override_threadpool_fn)
 
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(numa_node=[None, 0])))
+  def testNumaNode(self, numa_node):
+
+    def override_threadpool_fn(dataset):
+      options = dataset_ops.Options()
+      options.experimental_threading.private_threadpool_size = 2
+      if numa_node is not None:
+        options.experimental_threading.private_threadpool_numa_node = numa_node
+      return dataset.with_options(options)
+
+    self._testNumThreadsHelper(2, override_threadpool_fn)
+
   @combinations.generate(test_base.default_test_combinations())
   def testMaxIntraOpParallelismAsGraphDefInternal(self):
     dataset = dataset_ops.Dataset.from_tensors(0)
@@ -0,0 +1,84 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.persistent_cache()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import persistent_cache
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+
+
+class PersistentCacheTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def setUp(self):
+    super(PersistentCacheTest, self).setUp()
+    self.cache_dir = os.path.join(self.get_temp_dir(), "persistent_cache")
+
+  def _entries(self):
+    return [f for f in os.listdir(self.cache_dir) if f.endswith(".cache")]
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testCachesElements(self):
+    dataset = dataset_ops.Dataset.range(10).map(lambda x: x * x)
+    dataset = dataset.apply(persistent_cache.persistent_cache(self.cache_dir))
+    expected = [x * x for x in range(10)]
+    self.assertDatasetProduces(dataset, expected)
+    self.assertLen(self._entries(), 1)
+    self.assertDatasetProduces(dataset, expected)
+    self.assertLen(self._entries(), 1)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testSecondIterationReadsEntry(self):
+    num_calls = [0]
+
+    def gen():
+      num_calls[0] += 1
+      for i in range(5):
+        yield i
+
+    dataset = dataset_ops.Dataset.from_generator(gen, dtypes.int64)
+    dataset = dataset.apply(persistent_cache.persistent_cache(self.cache_dir))
+    self.assertDatasetProduces(dataset, list(range(5)))
+    self.assertDatasetProduces(dataset, list(range(5)))
+    self.assertEqual(num_calls[0], 1)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testEviction(self):
+    for stop in [10, 20]:
+      dataset = dataset_ops.Dataset.range(stop).apply(
+          persistent_cache.persistent_cache(self.cache_dir, max_size_bytes=1))
+      self.assertDatasetProduces(dataset, list(range(stop)))
+      self.assertLen(self._entries(), 1)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidMaxSizeBytes(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = dataset_ops.Dataset.range(10).apply(
+          persistent_cache.persistent_cache(self.cache_dir, max_size_bytes=-1))
+      self.evaluate(dataset._variant_tensor)  # pylint: disable=protected-access
+
+
+if __name__ == "__main__":
+  test.main()
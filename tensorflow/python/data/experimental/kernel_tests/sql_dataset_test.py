@@ -518,6 +518,49 @@ class SqlDatasetTest(sql_dataset_test_base.SqlDatasetTestBase,
     with self.assertRaises(errors.OutOfRangeError):
       self.evaluate(get_next())
 
+  # Test that SqlDataset can read the rows in batches.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInBatches(self):
+    dataset = self._createSqlDataset(
+        query="SELECT * FROM data", output_types=(dtypes.int32), batch_size=2)
+    self.assertDatasetProduces(dataset, expected_output=[[0, 1], [2]])
+
+  # Test that SqlDataset reads the ranges of the partition column in turn.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInPartitions(self):
+    dataset = self._createSqlDataset(
+        query="SELECT id, first_name FROM people",
+        output_types=(dtypes.int64, dtypes.string),
+        partition_column="id",
+        num_partitions=2)
+    self.assertDatasetProduces(
+        dataset, expected_output=[(1, b"Benjamin"), (2, b"John")])
+
+  # Test that every row is read once when there are more partitions than
+  # values of the partition column, and when it is NULL.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInPartitionsOfBatches(self):
+    dataset = self._createSqlDataset(
+        query="SELECT col1 FROM data UNION ALL SELECT NULL",
+        output_types=(dtypes.int32),
+        partition_column="col1",
+        num_partitions=5,
+        batch_size=2)
+    self.assertDatasetProduces(
+        dataset.unbatch(), expected_output=[0, 1, 2, 0],
+        assert_items_equal=True)
+
+  # Test that an error is raised when the query is partitioned without a
+  # partition column.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInPartitionsWithoutPartitionColumn(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = self._createSqlDataset(
+          query="SELECT * FROM data",
+          output_types=(dtypes.int32),
+          num_partitions=2)
+      self.assertDatasetProduces(dataset, expected_output=[])
+
 
 if __name__ == "__main__":
   test.main()
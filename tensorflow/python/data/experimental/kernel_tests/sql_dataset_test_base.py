@@ -34,9 +34,18 @@ class SqlDatasetTestBase(test_base.DatasetTestBase):
                         query,
                         output_types,
                         driver_name="sqlite",
-                        num_repeats=1):
-    dataset = readers.SqlDataset(driver_name, self.data_source_name, query,
-                                 output_types).repeat(num_repeats)
+                        num_repeats=1,
+                        partition_column=None,
+                        num_partitions=1,
+                        batch_size=None):
+    dataset = readers.SqlDataset(
+        driver_name,
+        self.data_source_name,
+        query,
+        output_types,
+        partition_column=partition_column,
+        num_partitions=num_partitions,
+        batch_size=batch_size).repeat(num_repeats)
     return dataset
 
   def setUp(self):
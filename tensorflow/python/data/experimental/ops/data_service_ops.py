@@ -61,7 +61,9 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
                protocol,
                job_name=None,
                max_outstanding_requests=None,
-               task_refresh_interval_hint_ms=None):
+               task_refresh_interval_hint_ms=None,
+               consumer_index=None,
+               num_consumers=None):
     """Constructs a _DataServiceDatasetV2.
 
     Args:
@@ -83,6 +85,10 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
         `element_size` * `max_outstanding_requests` of memory.
       task_refresh_interval_hint_ms: (Optional.) A hint for how often to query
         the dispatcher for task changes.
+      consumer_index: (Optional.) The index of the consumer in the range
+        `[0, num_consumers)`, for coordinated reads.
+      num_consumers: (Optional.) The number of consumers reading from the job
+        in coordinated rounds.
     """
 
     if job_name is None:
@@ -91,6 +97,10 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
       max_outstanding_requests = dataset_ops.AUTOTUNE
     if task_refresh_interval_hint_ms is None:
       task_refresh_interval_hint_ms = dataset_ops.AUTOTUNE
+    if consumer_index is None:
+      consumer_index = 0
+    if num_consumers is None:
+      num_consumers = 0
 
     self._dataset_id = ops.convert_to_tensor(
         dataset_id, dtype=dtypes.int64, name="dataset_id")
@@ -118,6 +128,8 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
         job_name=self._job_name,
         max_outstanding_requests=self._max_outstanding_requests,
         task_refresh_interval_hint_ms=task_refresh_interval_hint_ms,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers,
         iteration_counter=gen_experimental_dataset_ops.dummy_iteration_counter(
         ),
         **self._flat_structure)
@@ -133,7 +145,8 @@ class _DataServiceDatasetV1(dataset_ops.DatasetV1Adapter):
 
   @functools.wraps(_DataServiceDatasetV2.__init__)
   def __init__(self, dataset_id, processing_mode, address, protocol, job_name,
-               max_outstanding_requests, task_refresh_interval_hint_ms):
+               max_outstanding_requests, task_refresh_interval_hint_ms,
+               consumer_index, num_consumers):
 
     self._wrapped = _DataServiceDatasetV2(
         dataset_id=dataset_id,
@@ -142,7 +155,9 @@ class _DataServiceDatasetV1(dataset_ops.DatasetV1Adapter):
         protocol=protocol,
         job_name=job_name,
         max_outstanding_requests=max_outstanding_requests,
-        task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
+        task_refresh_interval_hint_ms=task_refresh_interval_hint_ms,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers)
     super(_DataServiceDatasetV1, self).__init__(self._wrapped)
 
 
@@ -185,7 +200,9 @@ def _from_dataset_id(processing_mode,
                      element_spec,
                      job_name=None,
                      max_outstanding_requests=None,
-                     task_refresh_interval_hint_ms=None):
+                     task_refresh_interval_hint_ms=None,
+                     consumer_index=None,
+                     num_consumers=None):
   """Creates a dataset which reads data from the tf.data service.
 
   This transformation is similar to `from_dataset_id`, but supports additional
@@ -215,6 +232,11 @@ def _from_dataset_id(processing_mode,
       `max_outstanding_requests` of memory.
     task_refresh_interval_hint_ms: (Optional.) A hint for how often to query the
       dispatcher for task changes.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which read from the job
+      in coordinated rounds. All consumers must use the same `job_name`. Must be
+      specified alongside `consumer_index`.
 
   Returns:
     A `tf.data.Dataset` which reads from the tf.data service.
@@ -226,6 +248,21 @@ def _from_dataset_id(processing_mode,
                        "{0}. job_name={1}".format(type(job_name), job_name))
     if not job_name:
       raise ValueError("job_name must not be empty")
+  if (consumer_index is None) != (num_consumers is None):
+    raise ValueError(
+        "Must either set both consumer_index and num_consumers, or neither. "
+        "consumer_index: {0}, num_consumers: {1}".format(
+            consumer_index, num_consumers))
+  if num_consumers is not None:
+    if num_consumers <= 0:
+      raise ValueError("num_consumers must be positive, but was {0}".format(
+          num_consumers))
+    if consumer_index < 0 or consumer_index >= num_consumers:
+      raise ValueError(
+          "consumer_index must be in the range [0, {0}), but was {1}".format(
+              num_consumers, consumer_index))
+    if job_name is None:
+      raise ValueError("job_name must be set when setting num_consumers")
   if element_spec is None:
     raise ValueError("element_spec must not be None")
   protocol, address = _parse_service(service)
@@ -237,7 +274,9 @@ def _from_dataset_id(processing_mode,
       protocol=protocol,
       job_name=job_name,
       max_outstanding_requests=max_outstanding_requests,
-      task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
+      task_refresh_interval_hint_ms=task_refresh_interval_hint_ms,
+      consumer_index=consumer_index,
+      num_consumers=num_consumers)
   dataset = dataset.map(
       lambda x: compression_ops.uncompress(x, output_spec=element_spec),
       num_parallel_calls=dataset_ops.AUTOTUNE)
@@ -254,7 +293,9 @@ def _distribute(processing_mode,
                 service,
                 job_name=None,
                 max_outstanding_requests=None,
-                task_refresh_interval_hint_ms=None):
+                task_refresh_interval_hint_ms=None,
+                consumer_index=None,
+                num_consumers=None):
   """A transformation that moves dataset processing to the tf.data service.
 
   This transformation is similar to `distribute`, but supports additional
@@ -278,6 +319,11 @@ def _distribute(processing_mode,
       `max_outstanding_requests` of memory.
     task_refresh_interval_hint_ms: (Optional.) A hint for how often to query the
       dispatcher for task changes.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which read from the job
+      in coordinated rounds. All consumers must use the same `job_name`. Must be
+      specified alongside `consumer_index`.
 
   Returns:
     Dataset: A `Dataset` of the elements produced by the data service.
@@ -293,7 +339,9 @@ def _distribute(processing_mode,
         dataset.element_spec,
         job_name=job_name,
         max_outstanding_requests=max_outstanding_requests,
-        task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
+        task_refresh_interval_hint_ms=task_refresh_interval_hint_ms,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers)
 
   return _apply_fn
 
@@ -302,7 +350,9 @@ def _distribute(processing_mode,
 def distribute(processing_mode,
                service,
                job_name=None,
-               max_outstanding_requests=None):
+               max_outstanding_requests=None,
+               consumer_index=None,
+               num_consumers=None):
   """A transformation that moves dataset processing to the tf.data service.
 
   When you iterate over a dataset containing the `distribute` transformation,
@@ -440,6 +490,30 @@ def distribute(processing_mode,
   from `job_name="job"`, it will immediately receive end of input, without
   getting any data.
 
+  **Coordinated data read**
+
+  For synchronous training, the replicas wait for each other at every step, so
+  a replica which receives a large element (e.g. a batch of long sequences)
+  slows down all of them. Setting `num_consumers` and `consumer_index` makes
+  the consumers of a shared job read in coordinated rounds: in every round,
+  each consumer receives one of `num_consumers` consecutive elements produced
+  by the same worker, and a worker only moves on to its next round once all
+  consumers have read their element of the current one. Producing consecutive
+  elements of similar size, e.g. by bucketing and batching `num_consumers`
+  batches at a time from each bucket, then gives all replicas similarly sized
+  elements in each step.
+
+  ```
+  dataset = dataset.apply(tf.data.experimental.service.distribute(
+      "parallel_epochs", "grpc://dataservice:5000", job_name="train",
+      consumer_index=replica_id, num_consumers=num_replicas))
+  ```
+
+  All consumers must use the same `job_name`, and read from the job at the
+  same time. Coordinated reads end as soon as any worker reaches the end of its
+  input, so the dataset is typically repeated. The set of workers should not
+  change while a coordinated job runs.
+
   **Keras and Distribution Strategies**
 
   The dataset produced by the `distribute` transformation can be passed to
@@ -472,6 +546,11 @@ def distribute(processing_mode,
       requested at the same time. You can use this option to control the amount
       of memory used, since `distribute` won't use more than `element_size` *
       `max_outstanding_requests` of memory.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which read from the job
+      in coordinated rounds. All consumers must use the same `job_name`. Must be
+      specified alongside `consumer_index`.
 
   Returns:
     Dataset: A `Dataset` of the elements produced by the data service.
@@ -480,7 +559,9 @@ def distribute(processing_mode,
       processing_mode=processing_mode,
       service=service,
       job_name=job_name,
-      max_outstanding_requests=max_outstanding_requests)
+      max_outstanding_requests=max_outstanding_requests,
+      consumer_index=consumer_index,
+      num_consumers=num_consumers)
 
 
 @tf_export("data.experimental.service.register_dataset")
@@ -553,7 +634,9 @@ def from_dataset_id(processing_mode,
                     dataset_id,
                     element_spec=None,
                     job_name=None,
-                    max_outstanding_requests=None):
+                    max_outstanding_requests=None,
+                    consumer_index=None,
+                    num_consumers=None):
   """Creates a dataset which reads data from the tf.data service.
 
   This is useful when the dataset is registered by one process, then used in
@@ -616,6 +699,11 @@ def from_dataset_id(processing_mode,
       requested at the same time. You can use this option to control the amount
       of memory used, since `distribute` won't use more than `element_size` *
       `max_outstanding_requests` of memory.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which read from the job
+      in coordinated rounds. All consumers must use the same `job_name`. Must be
+      specified alongside `consumer_index`.
 
   Returns:
     A `tf.data.Dataset` which reads from the tf.data service.
@@ -626,4 +714,6 @@ def from_dataset_id(processing_mode,
       dataset_id=dataset_id,
       element_spec=element_spec,
       job_name=job_name,
-      max_outstanding_requests=max_outstanding_requests)
+      max_outstanding_requests=max_outstanding_requests,
+      consumer_index=consumer_index,
+      num_consumers=num_consumers)
@@ -244,6 +244,129 @@ def bucket_by_sequence_length(element_length_func,
     return _apply_fn
 
 
+@tf_export("data.experimental.bucket_by_token_budget")
+def bucket_by_token_budget(element_length_func,
+                           bucket_boundaries,
+                           max_tokens,
+                           padding_values=None,
+                           drop_remainder=False):
+  """A transformation that batches elements of similar length by token count.
+
+  Like `bucket_by_sequence_length`, this transformation assigns each element to
+  a bucket by its length. Instead of a fixed batch size per bucket, a bucket is
+  emitted as a batch as soon as the number of its elements times the length of
+  its longest element would exceed `max_tokens` with one more element, so that
+  batches of short elements hold more elements than batches of long ones. Each
+  component is padded to its largest size within the batch, and an element
+  that exceeds `max_tokens` on its own forms a batch by itself.
+
+  For example:
+
+  >>> dataset = tf.data.Dataset.from_generator(
+  ...     lambda: [[1], [2, 3], [4, 5], [6], [7]], tf.int32, [None])
+  >>> dataset = dataset.apply(
+  ...     tf.data.experimental.bucket_by_token_budget(
+  ...         element_length_func=lambda x: tf.shape(x)[0],
+  ...         bucket_boundaries=[2],
+  ...         max_tokens=4))
+  >>> for batch in dataset:
+  ...   print(batch.numpy().tolist())
+  [[2, 3], [4, 5]]
+  [[1], [6], [7]]
+
+  The batching runs in a single native op rather than in a
+  `group_by_window` pipeline; when
+  `tf.data.Options.experimental_optimization.parallel_batch` is set, the
+  elements of a batch are copied in parallel.
+
+  Args:
+    element_length_func: function from element in `Dataset` to a scalar
+      integer `tf.Tensor`, which determines the bucket of the element and the
+      number of tokens it accounts for.
+    bucket_boundaries: `list<int>`, strictly increasing upper length
+      boundaries of the buckets.
+    max_tokens: A `tf.int64` scalar `tf.Tensor`, representing the largest
+      number of elements times padded length of a batch.
+    padding_values: (Optional.) A (nested) structure of scalar-shaped
+      `tf.Tensor`, representing the padding values to use for the respective
+      components. Defaults to padding with 0 (or "" for strings).
+    drop_remainder: (Optional.) A `tf.bool` scalar `tf.Tensor`, representing
+      whether the incomplete batches left in the buckets at the end of the
+      input should be dropped; the default behavior is to emit them.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _BucketByTokenBudgetDataset(dataset, element_length_func,
+                                       bucket_boundaries, max_tokens,
+                                       padding_values, drop_remainder)
+
+  return _apply_fn
+
+
+class _BucketByTokenBudgetDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that batches elements of similar length by token count."""
+
+  def __init__(self, input_dataset, element_length_func, bucket_boundaries,
+               max_tokens, padding_values, drop_remainder):
+    """See `bucket_by_token_budget()` for details."""
+
+    def check_types(component_spec):
+      if not isinstance(component_spec, tensor_spec.TensorSpec):
+        raise TypeError("Bucketing of components of type ",
+                        type(component_spec), " is not supported.")
+
+    nest.map_structure(check_types, input_dataset.element_spec)
+    input_shapes = dataset_ops.get_legacy_output_shapes(input_dataset)
+    input_types = dataset_ops.get_legacy_output_types(input_dataset)
+    padding_values = dataset_ops._padding_values_or_default(  # pylint: disable=protected-access
+        padding_values, input_dataset)
+    # If padding_values is a single element and input_shapes is a structure,
+    # "broadcast" padding_values to the same structure as input_shapes.
+    if nest.is_sequence(input_shapes) and not nest.is_sequence(padding_values):
+      padding_values = nest.map_structure(lambda _: padding_values,
+                                          input_shapes)
+    self._padding_values = nest.map_structure_up_to(
+        input_shapes, dataset_ops._padding_value_to_tensor,  # pylint: disable=protected-access
+        padding_values, input_types)
+    self._bucket_boundaries = ops.convert_to_tensor(
+        bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries")
+    self._max_tokens = ops.convert_to_tensor(
+        max_tokens, dtype=dtypes.int64, name="max_tokens")
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+
+    def add_length(*args):
+      element = args[0] if len(args) == 1 else args
+      length = math_ops.cast(element_length_func(*args), dtypes.int64)
+      return length, element
+
+    # The kernel expects the length as the first component of each element.
+    self._input_dataset = input_dataset.map(add_length)
+    output_shapes = nest.map_structure(
+        lambda s: tensor_shape.TensorShape([None]).concatenate(s),
+        input_shapes)
+    self._structure = structure.convert_legacy_structure(
+        input_types, output_shapes,
+        dataset_ops.get_legacy_output_classes(input_dataset))
+    variant_tensor = ged_ops.bucket_by_token_budget_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        bucket_boundaries=self._bucket_boundaries,
+        max_tokens=self._max_tokens,
+        padding_values=nest.flatten(self._padding_values),
+        drop_remainder=self._drop_remainder,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure))
+    super(_BucketByTokenBudgetDataset, self).__init__(self._input_dataset,
+                                                      variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
 class _GroupByReducerDataset(dataset_ops.UnaryDataset):
   """A `Dataset` that groups its input and performs a reduction."""
 
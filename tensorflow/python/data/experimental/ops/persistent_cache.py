@@ -0,0 +1,87 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Persistent, content-addressed caching of dataset elements."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops
+from tensorflow.python.util.tf_export import tf_export
+
+
+@tf_export("data.experimental.persistent_cache")
+def persistent_cache(directory, max_size_bytes=0):
+  """Caches the elements of a dataset in a directory shared between jobs.
+
+  Unlike `tf.data.Dataset.cache`, the cache entry is not named by the user but
+  keyed by a fingerprint of the input dataset graph. Jobs that run the same
+  input pipeline, e.g. the trials of a hyperparameter sweep, therefore share an
+  entry as long as they use the same `directory`, which is typically on a
+  local SSD:
+
+  ```python
+  dataset = tf.data.TFRecordDataset(filenames).map(expensive_preprocessing)
+  dataset = dataset.apply(
+      tf.data.experimental.persistent_cache("/mnt/ssd/tf_data_cache",
+                                            max_size_bytes=100 << 30))
+  ```
+
+  The first iteration over a dataset without an entry runs the input pipeline
+  and writes its elements to the entry once the input is exhausted. Later
+  iterations, including those of other jobs, read the entry through a memory
+  map instead. After writing an entry, the least recently used other entries
+  are deleted until all entries fit into `max_size_bytes`.
+
+  The input pipeline must produce the same elements every time it is iterated
+  over: the fingerprint does not capture, for example, an unseeded shuffle.
+
+  Args:
+    directory: A `tf.string` scalar `tf.Tensor`, the directory that holds the
+      cache entries.
+    max_size_bytes: (Optional.) A `tf.int64` scalar `tf.Tensor`, the total size
+      of the entries above which entries are evicted. Defaults to 0, which
+      means that entries are never evicted.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _PersistentCacheDataset(dataset, directory, max_size_bytes)
+
+  return _apply_fn
+
+
+class _PersistentCacheDataset(dataset_ops.UnaryUnchangedStructureDataset):
+  """A `Dataset` that caches its input in a content-addressed entry."""
+
+  def __init__(self, input_dataset, directory, max_size_bytes):
+    """See `persistent_cache()` for details."""
+    self._input_dataset = input_dataset
+    self._directory = ops.convert_to_tensor(
+        directory, dtype=dtypes.string, name="directory")
+    self._max_size_bytes = ops.convert_to_tensor(
+        max_size_bytes, dtype=dtypes.int64, name="max_size_bytes")
+    variant_tensor = gen_experimental_dataset_ops.persistent_cache_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        directory=self._directory,
+        max_size_bytes=self._max_size_bytes,
+        **self._flat_structure)
+    super(_PersistentCacheDataset, self).__init__(input_dataset,
+                                                  variant_tensor)
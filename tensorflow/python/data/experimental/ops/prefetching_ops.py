@@ -40,6 +40,10 @@ def prefetch_to_device(device, buffer_size=None):
   NOTE: Although the transformation creates a `tf.data.Dataset`, the
   transformation must be the final `Dataset` in the input pipeline.
 
+  When `device` is a GPU, the elements are first staged in pinned host memory
+  by a background thread, so that their copies to the GPU are asynchronous and
+  the next `buffer_size` elements are resident on the GPU ahead of their use.
+
   Args:
     device: A string. The name of a device to which elements will be prefetched.
     buffer_size: (Optional.) The number of elements to buffer on `device`.
@@ -50,6 +54,10 @@ def prefetch_to_device(device, buffer_size=None):
     `tf.data.Dataset.apply`.
   """
   def _apply_fn(dataset):
+    spec = framework_device.DeviceSpec().from_string(device)
+    if spec.device_type == "GPU":
+      dataset = dataset_ops.PrefetchDataset(
+          dataset, buffer_size=1, pin_host_memory=True)
     return dataset.apply(
         copy_to_device(target_device=device)).prefetch(buffer_size)
 
@@ -32,6 +32,7 @@ from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import readers as core_readers
 from tensorflow.python.data.util import convert
 from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import random_seed
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
@@ -1114,7 +1115,14 @@ def _get_file_names(file_pattern, shuffle):
 class SqlDatasetV2(dataset_ops.DatasetSource):
   """A `Dataset` consisting of the results from a SQL query."""
 
-  def __init__(self, driver_name, data_source_name, query, output_types):
+  def __init__(self,
+               driver_name,
+               data_source_name,
+               query,
+               output_types,
+               partition_column=None,
+               num_partitions=1,
+               batch_size=None):
     """Creates a `SqlDataset`.
 
     `SqlDataset` allows a user to read data from the result set of a SQL query.
@@ -1129,6 +1137,19 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
       print(element)
     ```
 
+    Large result sets can be read faster by splitting the query in ranges of an
+    integer column, read concurrently, and by reading the rows in batches:
+
+    ```python
+    dataset = tf.data.experimental.SqlDataset(
+        "sqlite", "/foo/bar.sqlite3", "SELECT id, name, age FROM people",
+        (tf.int64, tf.string, tf.int32), partition_column="id",
+        num_partitions=4, batch_size=1024)
+    ```
+
+    The batches of the partitions are produced in turn, so the order of the
+    rows differs from the order of the result set of the query.
+
     Args:
       driver_name: A 0-D `tf.string` tensor containing the database type.
         Currently, the only supported value is 'sqlite'.
@@ -1137,6 +1158,13 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
       query: A 0-D `tf.string` tensor containing the SQL query to execute.
       output_types: A tuple of `tf.DType` objects representing the types of the
         columns returned by `query`.
+      partition_column: (Optional.) The name of an integer column of the result
+        set of `query`, required if `num_partitions` > 1.
+      num_partitions: (Optional.) The number of ranges of the values of
+        `partition_column` read concurrently, each by its own connection.
+        Defaults to 1.
+      batch_size: (Optional.) If set, the dataset produces batches of up to
+        `batch_size` rows, one vector per column, instead of rows.
     """
     self._driver_name = ops.convert_to_tensor(
         driver_name, dtype=dtypes.string, name="driver_name")
@@ -1144,10 +1172,16 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
         data_source_name, dtype=dtypes.string, name="data_source_name")
     self._query = ops.convert_to_tensor(
         query, dtype=dtypes.string, name="query")
+    shape = [None] if batch_size else []
     self._element_spec = nest.map_structure(
-        lambda dtype: tensor_spec.TensorSpec([], dtype), output_types)
+        lambda dtype: tensor_spec.TensorSpec(shape, dtype), output_types)
     variant_tensor = gen_experimental_dataset_ops.sql_dataset(
-        self._driver_name, self._data_source_name, self._query,
+        self._driver_name,
+        self._data_source_name,
+        self._query,
+        partition_column=partition_column or "",
+        num_partitions=num_partitions,
+        batch_size=batch_size or 0,
         **self._flat_structure)
     super(SqlDatasetV2, self).__init__(variant_tensor)
 
@@ -1161,18 +1195,115 @@ class SqlDatasetV1(dataset_ops.DatasetV1Adapter):
   """A `Dataset` consisting of the results from a SQL query."""
 
   @functools.wraps(SqlDatasetV2.__init__)
-  def __init__(self, driver_name, data_source_name, query, output_types):
-    wrapped = SqlDatasetV2(driver_name, data_source_name, query, output_types)
+  def __init__(self,
+               driver_name,
+               data_source_name,
+               query,
+               output_types,
+               partition_column=None,
+               num_partitions=1,
+               batch_size=None):
+    wrapped = SqlDatasetV2(driver_name, data_source_name, query, output_types,
+                           partition_column, num_partitions, batch_size)
     super(SqlDatasetV1, self).__init__(wrapped)
 
 
+class _BlockShuffledTFRecordDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of TFRecord records, shuffled in blocks."""
+
+  def __init__(self, filenames, block_size, window_size, seed,
+               reshuffle_each_iteration):
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._block_size = ops.convert_to_tensor(
+        block_size, dtype=dtypes.int64, name="block_size")
+    self._window_size = ops.convert_to_tensor(
+        window_size, dtype=dtypes.int64, name="window_size")
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+    variant_tensor = (
+        gen_experimental_dataset_ops.block_shuffled_tf_record_dataset(
+            self._filenames,
+            self._block_size,
+            self._window_size,
+            seed=self._seed,
+            seed2=self._seed2,
+            reshuffle_each_iteration=reshuffle_each_iteration))
+    super(_BlockShuffledTFRecordDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return tensor_spec.TensorSpec([], dtypes.string)
+
+
+@tf_export("data.experimental.block_shuffled_tfrecord_dataset", v1=[])
+def block_shuffled_tfrecord_dataset_v2(filenames,
+                                       block_size,
+                                       window_size,
+                                       seed=None,
+                                       reshuffle_each_iteration=True):
+  """Reads TFRecord files in a shuffled order without a large buffer.
+
+  `Dataset.shuffle()` needs a buffer of about the size of the dataset to mix
+  its elements well, which does not fit in memory for large datasets. This
+  dataset shuffles in two levels instead: the records of all `filenames` are
+  split into blocks of `block_size` consecutive records and the order of the
+  blocks is shuffled globally, then the records of consecutive blocks are
+  mixed in a window of `window_size` records. Only the window is kept in
+  memory.
+
+  ```python
+  dataset = tf.data.experimental.block_shuffled_tfrecord_dataset(
+      filenames, block_size=1024, window_size=4096)
+  ```
+
+  A block is read sequentially, so larger blocks mean fewer seeks at the cost
+  of a coarser shuffle. A window of a few blocks is usually enough to mix
+  records of different blocks. The files must be uncompressed.
+
+  Args:
+    filenames: A `tf.string` tensor containing one or more filenames.
+    block_size: A `tf.int64` scalar, the number of consecutive records in a
+      block.
+    window_size: A `tf.int64` scalar, the number of records from which each
+      output is sampled.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the random
+      seed that will be used to create the distribution. See
+      `tf.random.set_seed` for behavior.
+    reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
+      that the records should be shuffled differently each time the dataset
+      is iterated over. (Defaults to `True`.)
+
+  Returns:
+    A `Dataset` of scalar `tf.string` records.
+  """
+  return _BlockShuffledTFRecordDataset(filenames, block_size, window_size,
+                                       seed, reshuffle_each_iteration)
+
+
+@tf_export(v1=["data.experimental.block_shuffled_tfrecord_dataset"])
+def block_shuffled_tfrecord_dataset_v1(filenames,
+                                       block_size,
+                                       window_size,
+                                       seed=None,
+                                       reshuffle_each_iteration=True):
+  return dataset_ops.DatasetV1Adapter(
+      block_shuffled_tfrecord_dataset_v2(filenames, block_size, window_size,
+                                         seed, reshuffle_each_iteration))
+
+
+block_shuffled_tfrecord_dataset_v1.__doc__ = (
+    block_shuffled_tfrecord_dataset_v2.__doc__)
+
+
 if tf2.enabled():
   CsvDataset = CsvDatasetV2
   SqlDataset = SqlDatasetV2
+  block_shuffled_tfrecord_dataset = block_shuffled_tfrecord_dataset_v2
   make_batched_features_dataset = make_batched_features_dataset_v2
   make_csv_dataset = make_csv_dataset_v2
 else:
   CsvDataset = CsvDatasetV1
   SqlDataset = SqlDatasetV1
+  block_shuffled_tfrecord_dataset = block_shuffled_tfrecord_dataset_v1
   make_batched_features_dataset = make_batched_features_dataset_v1
   make_csv_dataset = make_csv_dataset_v1
@@ -48,3 +48,12 @@ class ThreadingOptions(options.OptionsBase):
       ty=int,
       docstring=
       "If set, the dataset will use a private threadpool of the given size.")
+
+  private_threadpool_numa_node = options.create_option(
+      name="private_threadpool_numa_node",
+      ty=int,
+      docstring=
+      "If set together with `private_threadpool_size`, the threads of the "
+      "private threadpool are bound to the given NUMA node, and the elements "
+      "they produce are allocated on it. Pinning the pipeline to the node of "
+      "the consuming trainer thread avoids cross-socket memory traffic.")
@@ -370,8 +370,9 @@ class DatasetV2(collections_abc.Iterable, tracking_base.Trackable,
         dataset = _MaxIntraOpParallelismDataset(
             dataset, t_options.max_intra_op_parallelism)
       if t_options.private_threadpool_size is not None:
-        dataset = _PrivateThreadPoolDataset(dataset,
-                                            t_options.private_threadpool_size)
+        dataset = _PrivateThreadPoolDataset(
+            dataset, t_options.private_threadpool_size,
+            t_options.private_threadpool_numa_node)
 
     # (2) Apply autotune options
     autotune, algorithm, cpu_budget, ram_budget = options._autotune_settings()  # pylint: disable=protected-access
@@ -4448,7 +4449,11 @@ class FilterDataset(UnaryUnchangedStructureDataset):
 class PrefetchDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that asynchronously prefetches its input."""
 
-  def __init__(self, input_dataset, buffer_size, slack_period=None):
+  def __init__(self,
+               input_dataset,
+               buffer_size,
+               slack_period=None,
+               pin_host_memory=False):
     """See `Dataset.prefetch()` for details.
 
     Args:
@@ -4460,12 +4465,20 @@ class PrefetchDataset(UnaryUnchangedStructureDataset):
         user should not have to set this manually; enable this behavior
         automatically via `tf.data.Options.experimental_slack` instead. Defaults
         to None.
+      pin_host_memory: (Optional.) A boolean. If true, buffered elements are
+        moved to pinned host memory, so that their later transfer to a GPU is
+        asynchronous. Defaults to False.
     """
     self._input_dataset = input_dataset
     if buffer_size is None:
       buffer_size = AUTOTUNE
     self._buffer_size = ops.convert_to_tensor(
         buffer_size, dtype=dtypes.int64, name="buffer_size")
+    kwargs = dict(self._flat_structure)
+    # The attr is only set when needed, so that graphs that do not pin host
+    # memory remain readable by older binaries.
+    if pin_host_memory:
+      kwargs["pin_host_memory"] = True
     # pylint: disable=protected-access
     # We colocate the prefetch dataset with its input as this collocation only
     # happens automatically in graph mode.
@@ -4474,7 +4487,7 @@ class PrefetchDataset(UnaryUnchangedStructureDataset):
           input_dataset._variant_tensor,
           buffer_size=self._buffer_size,
           slack_period=slack_period,
-          **self._flat_structure)
+          **kwargs)
     super(PrefetchDataset, self).__init__(input_dataset, variant_tensor)
 
 
@@ -4623,13 +4636,16 @@ class _MaxIntraOpParallelismDataset(UnaryUnchangedStructureDataset):
 class _PrivateThreadPoolDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, setting a private threadpool."""
 
-  def __init__(self, input_dataset, num_threads):
+  def __init__(self, input_dataset, num_threads, numa_node=None):
     self._input_dataset = input_dataset
     self._num_threads = ops.convert_to_tensor(
         num_threads, dtype=dtypes.int64, name="num_threads")
+    if numa_node is None:
+      numa_node = -1
     variant_tensor = ged_ops.private_thread_pool_dataset(
         input_dataset._variant_tensor,  # pylint: disable=protected-access
         self._num_threads,
+        numa_node=numa_node,
         **self._flat_structure)
     super(_PrivateThreadPoolDataset, self).__init__(input_dataset,
                                                     variant_tensor)
@@ -983,6 +983,7 @@ class Context(object):
     rewriter_toggle("constant_folding")
     rewriter_toggle("shape_optimization")
     rewriter_toggle("remapping")
+    rewriter_toggle("elementwise_fusion")
     rewriter_toggle("arithmetic_optimization")
     rewriter_toggle("dependency_optimization")
     rewriter_toggle("loop_optimization")
@@ -1553,6 +1554,7 @@ class Context(object):
     rewriter_toggle("constant_folding")
     rewriter_toggle("shape_optimization")
     rewriter_toggle("remapping")
+    rewriter_toggle("elementwise_fusion")
     rewriter_toggle("arithmetic_optimization")
     rewriter_toggle("dependency_optimization")
     rewriter_toggle("loop_optimization")
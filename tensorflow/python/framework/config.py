@@ -205,6 +205,8 @@ def set_optimizer_experimental_options(options):
         result using constants.
       - shape_optimization: Simplify computations made on shapes.
       - remapping: Remap subgraphs onto more efficient implementations.
+      - elementwise_fusion: Fuse chains of elementwise ops on the CPU into
+        single ops, which do not write their intermediate results to memory.
       - arithmetic_optimization: Simplify arithmetic ops with common
         sub-expression elimination and arithmetic simplification.
       - dependency_optimization: Control dependency optimizations. Remove
@@ -42,6 +42,7 @@ from tensorflow.python.framework import tensor_spec
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import gen_lookup_ops
 from tensorflow.python.ops import lookup_ops
 from tensorflow.python.ops import map_fn
 from tensorflow.python.ops import string_ops
@@ -3045,6 +3046,70 @@ class MutableHashTableOpTest(test.TestCase):
     self.assertAllEqual([b"brain", b"salad", b"surgery"], sorted_keys)
     self.assertAllEqual([0, 1, 2], sorted_values)
 
+  def testShardedMutableHashTable(self):
+    default_val = -1
+    keys = constant_op.constant(["brain", "salad", "surgery", "tarkus"])
+    values = constant_op.constant([0, 1, 2, 3], dtypes.int64)
+    table = lookup_ops.MutableHashTable(
+        dtypes.string, dtypes.int64, default_val, experimental_num_shards=3)
+    self.assertAllEqual(0, self.evaluate(table.size()))
+
+    self.evaluate(table.insert(keys, values))
+    self.assertAllEqual(4, self.evaluate(table.size()))
+
+    remove_string = constant_op.constant(["tarkus", "tank"])
+    self.evaluate(table.remove(remove_string))
+    self.assertAllEqual(3, self.evaluate(table.size()))
+
+    # Reinserting a removed key reuses its slot.
+    self.evaluate(
+        table.insert(
+            constant_op.constant(["tarkus", "brain"]),
+            constant_op.constant([4, 5], dtypes.int64)))
+    self.assertAllEqual(4, self.evaluate(table.size()))
+
+    output = table.lookup(
+        constant_op.constant([["brain", "salad"], ["tank", "tarkus"]]))
+    self.assertAllEqual([2, 2], output.get_shape())
+    self.assertAllEqual([[5, 1], [-1, 4]], self.evaluate(output))
+
+    exported_keys, exported_values = table.export()
+    sorted_keys = np.sort(self.evaluate(exported_keys))
+    sorted_values = np.sort(self.evaluate(exported_values))
+    self.assertAllEqual([b"brain", b"salad", b"surgery", b"tarkus"],
+                        sorted_keys)
+    self.assertAllEqual([1, 2, 4, 5], sorted_values)
+
+  def testShardedMutableHashTableOfTensors(self):
+    default_val = constant_op.constant([-1, -1], dtypes.int64)
+    keys = constant_op.constant(list(range(100)), dtypes.int64)
+    values = constant_op.constant([[i, 2 * i] for i in range(100)],
+                                  dtypes.int64)
+    table = lookup_ops.MutableHashTable(
+        dtypes.int64, dtypes.int64, default_val, experimental_num_shards=8)
+    self.evaluate(table.insert(keys, values))
+    self.assertAllEqual(100, self.evaluate(table.size()))
+
+    # The last of duplicate keys wins.
+    self.evaluate(
+        table.insert(
+            constant_op.constant([7, 7], dtypes.int64),
+            constant_op.constant([[0, 0], [70, 71]], dtypes.int64)))
+    output = table.lookup(constant_op.constant([3, 7, 100], dtypes.int64))
+    self.assertAllEqual([3, 2], output.get_shape())
+    self.assertAllEqual([[3, 6], [70, 71], [-1, -1]], self.evaluate(output))
+
+    exported_keys, exported_values = table.export()
+    self.assertAllEqual([100, 2], exported_values.get_shape())
+    table2 = lookup_ops.MutableHashTable(
+        dtypes.int64, dtypes.int64, default_val, experimental_num_shards=2)
+    self.evaluate(
+        gen_lookup_ops.lookup_table_import_v2(table2.resource_handle,
+                                              exported_keys, exported_values))
+    self.assertAllEqual(100, self.evaluate(table2.size()))
+    self.assertAllEqual(
+        self.evaluate(table.lookup(keys)), self.evaluate(table2.lookup(keys)))
+
   @test_util.run_v1_only("SaverV1")
   def testSaveRestore(self):
     save_dir = os.path.join(self.get_temp_dir(), "save_restore")
@@ -0,0 +1,94 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for RegexSetMatch op from string_ops."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import gen_string_ops
+from tensorflow.python.platform import test
+
+
+class RegexSetMatchOpTest(test.TestCase):
+
+  @test_util.run_deprecated_v1
+  def testFullMatch(self):
+    values = ["abaaba", "abcdabcde", "12"]
+    with self.cached_session():
+      input_tensor = constant_op.constant(values, dtypes.string)
+      matched = gen_string_ops.regex_set_match(
+          input_tensor, ["a.*a", "[a-e]*", "[0-9]+", "b"])
+      self.assertAllEqual(
+          [[True, True, False, False], [False, True, False, False],
+           [False, False, True, False]], self.evaluate(matched))
+
+  @test_util.run_deprecated_v1
+  def testPartialMatch(self):
+    values = ["abaaba", "abcdabcde", "12"]
+    with self.cached_session():
+      input_tensor = constant_op.constant(values, dtypes.string)
+      matched = gen_string_ops.regex_set_match(
+          input_tensor, ["a.*a", "e$", "[0-9]", "^b"], full_match=False)
+      self.assertAllEqual(
+          [[True, False, False, False], [True, True, False, False],
+           [False, False, True, False]], self.evaluate(matched))
+
+  @test_util.run_deprecated_v1
+  def testTwoDims(self):
+    values = [["abaaba", "abcdabcde"], ["acdcba", "ebcda"]]
+    with self.cached_session():
+      input_tensor = constant_op.constant(values, dtypes.string)
+      matched = gen_string_ops.regex_set_match(input_tensor, ["a.*a", ".*a"])
+      self.assertAllEqual(
+          [[[True, True], [False, False]], [[True, True], [False, True]]],
+          self.evaluate(matched))
+
+  @test_util.run_deprecated_v1
+  def testSameAsRegexFullMatch(self):
+    values = ["TensorFlow", "tensor", "flow", "", "Tensor Flow 2"]
+    patterns = ["[A-Z].*", ".*[0-9]", "", "t.*r", "\\w+( \\w+)*"]
+    with self.cached_session():
+      input_tensor = constant_op.constant(values, dtypes.string)
+      matched = self.evaluate(
+          gen_string_ops.regex_set_match(input_tensor, patterns))
+      for i, pattern in enumerate(patterns):
+        self.assertAllEqual(
+            self.evaluate(
+                gen_string_ops.regex_full_match(input_tensor, pattern)),
+            matched[:, i])
+
+  @test_util.run_deprecated_v1
+  def testNoPatterns(self):
+    with self.cached_session():
+      input_tensor = constant_op.constant(["abc", "1"], dtypes.string)
+      matched = gen_string_ops.regex_set_match(
+          input_tensor, constant_op.constant([], dtypes.string))
+      self.assertAllEqual([[], []], self.evaluate(matched))
+
+  @test_util.run_deprecated_v1
+  def testInvalidPattern(self):
+    with self.cached_session():
+      input_tensor = constant_op.constant(["abc", "1"], dtypes.string)
+      matched = gen_string_ops.regex_set_match(input_tensor, ["a.*", "A["])
+      with self.assertRaisesOpError("Invalid pattern"):
+        self.evaluate(matched)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -86,6 +86,17 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]])
 
+  def testInt64Large(self):
+    # Large enough to find the unique elements in parallel partitions.
+    x = np.random.randint(0, high=100000, size=1 << 20).astype(np.int64)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+
+    # The unique elements are in the order of their first occurrences.
+    _, first_indices = np.unique(x, return_index=True)
+    self.assertAllEqual(tf_y, x[np.sort(first_indices)])
+    self.assertAllEqual(tf_y[tf_idx], x)
+
   def testBool(self):
     x = np.random.choice([True, False], size=7000)
     y, idx = array_ops.unique(x)
@@ -121,6 +132,18 @@ class UniqueWithCountsTest(test.TestCase):
     for value, count in zip(tf_y, tf_count):
       self.assertEqual(count, np.sum(x == value))
 
+  def testInt64Large(self):
+    x = np.random.randint(0, high=100000, size=1 << 20).astype(np.int64)
+    y, idx, count = array_ops.unique_with_counts(x)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+
+    _, first_indices, counts = np.unique(
+        x, return_index=True, return_counts=True)
+    order = np.argsort(first_indices)
+    self.assertAllEqual(tf_y, x[first_indices[order]])
+    self.assertAllEqual(tf_y[tf_idx], x)
+    self.assertAllEqual(tf_count, counts[order])
+
   def testInt32OutIdxInt64(self):
     x = np.random.randint(2, high=10, size=7000)
     y, idx, count = array_ops.unique_with_counts(x, out_idx=dtypes.int64)
@@ -288,6 +288,43 @@ class BatchOpsTest(test.TestCase):
       self.assertEqual(thread_results[0], [2])
       self.assertEqual(main_results[0], [3])
 
+  def testBatchFunctionOpWithRaggedBatching(self):
+    """Tests that the batch_function op batches inputs of different lengths."""
+    if context.executing_eagerly():
+      return
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.int32, dtypes.int64)
+      def computation(values, row_splits):
+        lengths = row_splits[1:] - row_splits[:-1]
+        # One output per value, and one per row.
+        return (values + 1, row_splits, lengths,
+                array_ops.zeros([0], dtype=dtypes.int64))
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=100000,
+          Tout=[dtypes.int32, dtypes.int64],
+          f=computation,
+          captured_tensors=computation.captured_inputs,
+          enable_ragged_batching=True)
+      thread_results = []
+
+      def worker():
+        thread_results.extend(sess.run(result, feed_dict={inp: [[1, 2, 3]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run(result, feed_dict={inp: [[4]]})
+      worker_thread.join()
+      self.assertAllEqual(thread_results[0], [[2, 3, 4]])
+      self.assertAllEqual(thread_results[1], [3])
+      self.assertAllEqual(main_results[0], [[5]])
+      self.assertAllEqual(main_results[1], [1])
+
   def testBatchFunctionOpWithCapturedInput(self):
     """Tests that batch_function op works with captured input."""
     if context.executing_eagerly():
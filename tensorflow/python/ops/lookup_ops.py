@@ -1734,7 +1734,8 @@ class MutableHashTable(LookupInterface):
                value_dtype,
                default_value,
                name="MutableHashTable",
-               checkpoint=True):
+               checkpoint=True,
+               experimental_num_shards=None):
     """Creates an empty `MutableHashTable` object.
 
     Creates a table, the type of its keys and values are specified by key_dtype
@@ -1748,6 +1749,9 @@ class MutableHashTable(LookupInterface):
       checkpoint: if True, the contents of the table are saved to and restored
         from checkpoints. If `shared_name` is empty for a checkpointed table, it
         is shared using the table node name.
+      experimental_num_shards: If set, the entries of the table are spread over
+        this many independently locked shards, which lets concurrent lookups
+        and inserts proceed in parallel.
 
     Returns:
       A `MutableHashTable` object.
@@ -1762,6 +1766,7 @@ class MutableHashTable(LookupInterface):
     self._key_dtype = key_dtype
     self._value_dtype = value_dtype
     self._name = name
+    self._num_shards = experimental_num_shards
 
     self._shared_name = None
     if context.executing_eagerly():
@@ -1784,7 +1789,16 @@ class MutableHashTable(LookupInterface):
     # training to work correctly. Use the node name if no shared_name has been
     # explicitly specified.
     use_node_name_sharing = self._checkpoint and self._shared_name is None
-    if self._default_value.get_shape().ndims == 0:
+    if self._num_shards is not None:
+      table_ref = gen_lookup_ops.sharded_mutable_hash_table(
+          shared_name=self._shared_name,
+          use_node_name_sharing=use_node_name_sharing,
+          key_dtype=self._key_dtype,
+          value_dtype=self._value_dtype,
+          value_shape=self._default_value.get_shape(),
+          num_shards=self._num_shards,
+          name=self._name)
+    elif self._default_value.get_shape().ndims == 0:
       table_ref = gen_lookup_ops.mutable_hash_table_v2(
           shared_name=self._shared_name,
           use_node_name_sharing=use_node_name_sharing,
@@ -2269,3 +2283,4 @@ ops.NotDifferentiable("MutableHashTable")
 ops.NotDifferentiable("MutableHashTableV2")
 ops.NotDifferentiable("MutableHashTableOfTensors")
 ops.NotDifferentiable("MutableHashTableOfTensorsV2")
+ops.NotDifferentiable("ShardedMutableHashTable")
@@ -26,8 +26,7 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import test_util
 from tensorflow.python.framework.test_util import TensorFlowTestCase
-# Import resource_variable_ops for the variables-to-tensor implicit conversion.
-from tensorflow.python.ops import resource_variable_ops  # pylint: disable=unused-import
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import googletest
 from tensorflow.python.training import training_ops
@@ -441,6 +440,97 @@ class TrainingOpsTest(TensorFlowTestCase):
     param_t = param - alpha_t * m_t / (np.sqrt(v_t) + epsilon)
     return param_t, m_t, v_t
 
+  def _testResourceSparseApplyAdam(self, dtype, lazy_update):
+    var = np.arange(12).reshape(4, 3).astype(dtype)
+    m = np.arange(1, 13).reshape(4, 3).astype(dtype) * 0.1
+    v = np.arange(2, 14).reshape(4, 3).astype(dtype) * 0.1
+    grad = np.arange(9).reshape(3, 3).astype(dtype)
+    indices = np.array([2, 0, 2], dtype=np.int32)
+    t = 1
+    beta1 = np.array(0.9, dtype=dtype)
+    beta2 = np.array(0.999, dtype=dtype)
+    lr = np.array(0.001, dtype=dtype)
+    epsilon = np.array(1e-8, dtype=dtype)
+
+    var_t = resource_variable_ops.ResourceVariable(var)
+    m_t = resource_variable_ops.ResourceVariable(m)
+    v_t = resource_variable_ops.ResourceVariable(v)
+    self.evaluate(variables.global_variables_initializer())
+    self.evaluate(
+        training_ops.resource_sparse_apply_adam(
+            var_t.handle, m_t.handle, v_t.handle, beta1**t, beta2**t, lr,
+            beta1, beta2, epsilon, grad, indices, lazy_update=lazy_update))
+
+    # Duplicate indices are summed into a dense gradient.
+    dense_grad = np.zeros_like(var)
+    np.add.at(dense_grad, indices, grad)
+    new_var, new_m, new_v = self._adamUpdateNumpy(var, dense_grad, t, m, v, lr,
+                                                  beta1, beta2, epsilon)
+    if lazy_update:
+      untouched = [1, 3]
+      new_var[untouched] = var[untouched]
+      new_m[untouched] = m[untouched]
+      new_v[untouched] = v[untouched]
+    self.assertAllCloseAccordingToType(new_var, self.evaluate(var_t))
+    self.assertAllCloseAccordingToType(new_m, self.evaluate(m_t))
+    self.assertAllCloseAccordingToType(new_v, self.evaluate(v_t))
+
+  @test_util.run_in_graph_and_eager_modes
+  def testResourceSparseApplyAdam(self):
+    for dtype, lazy_update in itertools.product([np.float32, np.float64],
+                                                [True, False]):
+      self._testResourceSparseApplyAdam(dtype, lazy_update)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testResourceSparseApplyAdamW(self):
+    var = np.array([[1.0, -2.0], [3.0, 4.0]], dtype=np.float32)
+    m = np.zeros_like(var)
+    v = np.zeros_like(var)
+    grad = np.array([[0.5, 0.5], [0.5, 0.5]], dtype=np.float32)
+    indices = np.array([1, 1], dtype=np.int64)
+    lr, beta1, beta2, epsilon, weight_decay = 0.1, 0.9, 0.999, 1e-8, 0.01
+
+    var_t = resource_variable_ops.ResourceVariable(var)
+    m_t = resource_variable_ops.ResourceVariable(m)
+    v_t = resource_variable_ops.ResourceVariable(v)
+    self.evaluate(variables.global_variables_initializer())
+    self.evaluate(
+        training_ops.resource_sparse_apply_adam_w(
+            var_t.handle, m_t.handle, v_t.handle, beta1, beta2, lr, beta1,
+            beta2, epsilon, weight_decay, grad, indices))
+
+    g = grad[0] + grad[1]
+    new_var, _, _ = self._adamUpdateNumpy(var[1], g, 1, m[1], v[1], lr, beta1,
+                                          beta2, epsilon)
+    new_var -= lr * weight_decay * var[1]
+    self.assertAllClose([var[0], new_var], self.evaluate(var_t))
+
+  @test_util.run_in_graph_and_eager_modes
+  def testResourceSparseApplyLamb(self):
+    var = np.array([[1.0, -2.0], [3.0, 4.0]], dtype=np.float32)
+    m = np.zeros_like(var)
+    v = np.zeros_like(var)
+    grad = np.array([[0.5, -1.0]], dtype=np.float32)
+    indices = np.array([0], dtype=np.int32)
+    lr, beta1, beta2, epsilon, weight_decay = 0.1, 0.9, 0.999, 1e-6, 0.01
+
+    var_t = resource_variable_ops.ResourceVariable(var)
+    m_t = resource_variable_ops.ResourceVariable(m)
+    v_t = resource_variable_ops.ResourceVariable(v)
+    self.evaluate(variables.global_variables_initializer())
+    self.evaluate(
+        training_ops.resource_sparse_apply_lamb(
+            var_t.handle, m_t.handle, v_t.handle, beta1, beta2, lr, beta1,
+            beta2, epsilon, weight_decay, grad, indices))
+
+    m_t_np = (1 - beta1) * grad[0]
+    v_t_np = (1 - beta2) * grad[0] * grad[0]
+    update = ((m_t_np / (1 - beta1)) /
+              (np.sqrt(v_t_np / (1 - beta2)) + epsilon) + weight_decay * var[0])
+    trust_ratio = np.linalg.norm(var[0]) / np.linalg.norm(update)
+    new_var = var[0] - lr * trust_ratio * update
+    self.assertAllClose([new_var, var[1]], self.evaluate(var_t), rtol=1e-5)
+
 
 if __name__ == '__main__':
   googletest.main()
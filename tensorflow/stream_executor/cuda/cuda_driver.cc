@@ -994,6 +994,77 @@ GpuDriver::ContextGetSharedMemConfig(GpuContext* context) {
   return false;
 }
 
+/* static */ port::Status GpuDriver::StreamBeginCapture(GpuContext* context,
+                                                        CUstream stream,
+                                                        bool relaxed) {
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+#if CUDA_VERSION >= 10010
+  // Operations of other threads which are not safe during the capture, such
+  // as memory allocations, are not affected by it.
+  RETURN_IF_CUDA_RES_ERROR(
+      cuStreamBeginCapture(stream, relaxed
+                                       ? CU_STREAM_CAPTURE_MODE_RELAXED
+                                       : CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "Could not begin capturing CUDA stream");
+#else
+  if (relaxed) {
+    return port::Status{port::error::UNIMPLEMENTED,
+                        "Relaxed stream capture requires CUDA 10.1"};
+  }
+  RETURN_IF_CUDA_RES_ERROR(cuStreamBeginCapture(stream),
+                           "Could not begin capturing CUDA stream");
+#endif
+  return port::Status::OK();
+}
+
+/* static */ port::Status GpuDriver::StreamEndCapture(GpuContext* context,
+                                                      CUstream stream,
+                                                      CUgraph* graph) {
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(cuStreamEndCapture(stream, graph),
+                           "Could not end capturing CUDA stream");
+  return port::Status::OK();
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ port::Status GpuDriver::GraphInstantiate(GpuContext* context,
+                                                      CUgraph graph,
+                                                      CUgraphExec* graph_exec) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(
+      cuGraphInstantiate(graph_exec, graph, /*phErrorNode=*/nullptr,
+                         /*logBuffer=*/nullptr, /*bufferSize=*/0),
+      "Could not instantiate CUDA graph");
+  return port::Status::OK();
+}
+
+/* static */ port::Status GpuDriver::GraphLaunch(GpuContext* context,
+                                                 CUgraphExec graph_exec,
+                                                 CUstream stream) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(cuGraphLaunch(graph_exec, stream),
+                           "Could not launch CUDA graph");
+  return port::Status::OK();
+}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              CUgraphExec graph_exec) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(graph_exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy executable CUDA graph: " << ToString(res);
+  }
+}
+
 /* static */ port::Status GpuDriver::SynchronousMemcpyD2H(GpuContext* context,
                                                           void* host_dst,
                                                           CUdeviceptr gpu_src,
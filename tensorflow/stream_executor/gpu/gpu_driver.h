@@ -346,6 +346,43 @@ class GpuDriver {
   // the stream immediately after this returns).
   static bool IsStreamIdle(GpuContext* context, GpuStreamHandle stream);
 
+  // Starts capturing the operations enqueued by the calling thread on stream,
+  // and on the streams which wait for it, into a graph instead of running
+  // them. If relaxed is true, the operations of every thread are captured,
+  // potentially unsafe calls such as synchronizations are not checked, and
+  // the capture may be ended by another thread.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status StreamBeginCapture(GpuContext* context,
+                                         GpuStreamHandle stream,
+                                         bool relaxed = false);
+
+  // Ends the capture started by StreamBeginCapture and returns the captured
+  // graph in *graph, which the caller must destroy with DestroyGraph.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status StreamEndCapture(GpuContext* context,
+                                       GpuStreamHandle stream,
+                                       GpuGraphHandle* graph);
+
+  // Destroys a graph returned by StreamEndCapture.
+  static void DestroyGraph(GpuContext* context, GpuGraphHandle graph);
+
+  // Instantiates graph into an executable graph in *graph_exec, which the
+  // caller must destroy with DestroyGraphExec.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::Status GraphInstantiate(GpuContext* context,
+                                       GpuGraphHandle graph,
+                                       GpuGraphExecHandle* graph_exec);
+
+  // Enqueues the executable graph on stream.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::Status GraphLaunch(GpuContext* context,
+                                  GpuGraphExecHandle graph_exec,
+                                  GpuStreamHandle stream);
+
+  // Destroys an executable graph returned by GraphInstantiate.
+  static void DestroyGraphExec(GpuContext* context,
+                               GpuGraphExecHandle graph_exec);
+
   // Returns whether code in the from context can access memory in the to
   // context via cuDeviceCanAccessPeer.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__PEER__ACCESS.html#group__CUDA__PEER__ACCESS_1g496bdaae1f632ebfb695b99d2c40f19e
@@ -117,6 +117,15 @@ port::StatusOr<void*> GetCudnnDsoHandle() {
   return GetDsoHandle("cudnn", GetCudnnVersion());
 }
 
+port::StatusOr<void*> GetNvjpegDsoHandle() {
+  // nvJPEG is versioned by the major CUDA version only.
+  string version = GetCudaVersion();
+  version = version.substr(0, version.find('.'));
+  auto status_or_handle = GetDsoHandle("nvjpeg", version);
+  if (status_or_handle.ok()) return status_or_handle;
+  return GetDsoHandle("nvjpeg", "");
+}
+
 port::StatusOr<void*> GetNvInferDsoHandle() {
   return GetDsoHandle("nvinfer", GetTensorRTVersion());
 }
@@ -200,6 +209,11 @@ port::StatusOr<void*> GetCudnnDsoHandle() {
   return *result;
 }
 
+port::StatusOr<void*> GetNvjpegDsoHandle() {
+  static auto result = new auto(DsoLoader::GetNvjpegDsoHandle());
+  return *result;
+}
+
 port::StatusOr<void*> GetRocblasDsoHandle() {
   static auto result = new auto(DsoLoader::GetRocblasDsoHandle());
   return *result;
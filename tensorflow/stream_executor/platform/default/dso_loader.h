@@ -44,6 +44,7 @@ port::StatusOr<void*> GetCusolverDsoHandle();
 port::StatusOr<void*> GetCusparseDsoHandle();
 port::StatusOr<void*> GetCuptiDsoHandle();
 port::StatusOr<void*> GetCudnnDsoHandle();
+port::StatusOr<void*> GetNvjpegDsoHandle();
 port::StatusOr<void*> GetNvInferDsoHandle();
 port::StatusOr<void*> GetNvInferPluginDsoHandle();
 
@@ -80,6 +81,7 @@ port::StatusOr<void*> GetCusolverDsoHandle();
 port::StatusOr<void*> GetCusparseDsoHandle();
 port::StatusOr<void*> GetCuptiDsoHandle();
 port::StatusOr<void*> GetCudnnDsoHandle();
+port::StatusOr<void*> GetNvjpegDsoHandle();
 
 port::StatusOr<void*> GetRocblasDsoHandle();
 port::StatusOr<void*> GetMiopenDsoHandle();
@@ -0,0 +1,325 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A C++ binary to benchmark the load and the serving of a SavedModel under
+// concurrent requests.
+//
+// See README.md for usage instructions.
+
+#include "tensorflow/tools/benchmark/serving_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/reporter.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+
+namespace {
+
+Status FillTensor(Tensor* tensor) {
+  switch (tensor->dtype()) {
+#define CASE(T)                                       \
+  case DataTypeToEnum<T>::value:                      \
+    tensor->flat<T>().setConstant(static_cast<T>(1)); \
+    break;
+    TF_CALL_INTEGRAL_TYPES(CASE);
+    TF_CALL_float(CASE);
+    TF_CALL_double(CASE);
+#undef CASE
+    case DT_BOOL:
+      tensor->flat<bool>().setConstant(true);
+      break;
+    case DT_STRING:
+      // Left empty, e.g. serialized tf.Examples with default features.
+      break;
+    default:
+      return errors::Unimplemented("Cannot make inputs of type ",
+                                   DataTypeString(tensor->dtype()));
+  }
+  return Status::OK();
+}
+
+int64 PeakRssKb() {
+#if defined(__linux__)
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+  return 0;
+}
+
+void RecordBenchmarkEntry(const string& output_prefix,
+                          const string& benchmark_name,
+                          const Options& options, const Results& results) {
+  TestReporter reporter(output_prefix, benchmark_name);
+  TF_QCHECK_OK(reporter.Initialize());
+  TF_QCHECK_OK(reporter.Benchmark(
+      results.num_requests, -1.0,
+      results.latency_us.avg() * 1e-6 * results.num_requests, results.qps));
+  TF_QCHECK_OK(reporter.AddMetric("p50_latency_us", results.p50_latency_us));
+  TF_QCHECK_OK(reporter.AddMetric("p99_latency_us", results.p99_latency_us));
+  TF_QCHECK_OK(
+      reporter.AddMetric("p999_latency_us", results.p999_latency_us));
+  TF_QCHECK_OK(reporter.AddMetric("qps", results.qps));
+  TF_QCHECK_OK(reporter.AddMetric("load_time_us", results.load_time_us.avg()));
+  TF_QCHECK_OK(
+      reporter.AddMetric("first_request_us", results.first_request_us));
+  TF_QCHECK_OK(reporter.AddMetric("peak_rss_kb", results.peak_rss_kb));
+  TF_QCHECK_OK(reporter.SetProperty("num_clients", options.num_clients));
+  TF_QCHECK_OK(reporter.SetProperty("batch_size", options.batch_size));
+  TF_QCHECK_OK(reporter.Close());
+}
+
+}  // namespace
+
+Status MakeRequest(const SignatureDef& signature, int batch_size,
+                   std::vector<std::pair<string, Tensor>>* inputs,
+                   std::vector<string>* output_names) {
+  inputs->clear();
+  output_names->clear();
+  for (const auto& input : signature.inputs()) {
+    const TensorInfo& info = input.second;
+    if (info.tensor_shape().unknown_rank()) {
+      return errors::InvalidArgument("Input ", input.first,
+                                     " has an unknown rank");
+    }
+    TensorShape shape;
+    for (const auto& dim : info.tensor_shape().dim()) {
+      shape.AddDim(dim.size() < 0 ? batch_size : dim.size());
+    }
+    Tensor tensor(info.dtype(), shape);
+    TF_RETURN_IF_ERROR(FillTensor(&tensor));
+    inputs->emplace_back(info.name(), tensor);
+  }
+  for (const auto& output : signature.outputs()) {
+    output_names->push_back(output.second.name());
+  }
+  return Status::OK();
+}
+
+int64 Percentile(const std::vector<int64>& sorted_values, double percentile) {
+  if (sorted_values.empty()) return 0;
+  // The nearest-rank percentile.
+  const int64 rank = static_cast<int64>(
+      std::ceil(percentile / 100 * sorted_values.size()));
+  return sorted_values[std::min<int64>(std::max<int64>(rank, 1),
+                                       sorted_values.size()) -
+                       1];
+}
+
+Status RunServingBenchmark(const Options& options, Results* results) {
+  if (options.num_loader_threads <= 0 || options.num_clients <= 0) {
+    return errors::InvalidArgument(
+        "There must be at least one loader thread and one client");
+  }
+  Env* env = Env::Default();
+  *results = Results();
+
+  // Cold start: concurrent loads, then the first request.
+  std::vector<std::unique_ptr<SavedModelBundle>> bundles(
+      options.num_loader_threads);
+  std::vector<Status> load_statuses(options.num_loader_threads);
+  std::vector<int64> load_times_us(options.num_loader_threads);
+  {
+    std::vector<std::unique_ptr<Thread>> loaders;
+    for (int i = 0; i < options.num_loader_threads; ++i) {
+      loaders.emplace_back(env->StartThread(
+          ThreadOptions(), strings::StrCat("loader_", i), [&, i]() {
+            bundles[i] = absl::make_unique<SavedModelBundle>();
+            const uint64 start_us = env->NowMicros();
+            load_statuses[i] =
+                LoadSavedModel(options.session_options, RunOptions(),
+                               options.export_dir, options.tags,
+                               bundles[i].get());
+            load_times_us[i] = env->NowMicros() - start_us;
+          }));
+    }
+  }
+  for (int i = 0; i < options.num_loader_threads; ++i) {
+    TF_RETURN_IF_ERROR(load_statuses[i]);
+    results->load_time_us.UpdateStat(load_times_us[i]);
+  }
+  const SavedModelBundle& bundle = *bundles[0];
+  const auto signature = bundle.GetSignatures().find(options.signature);
+  if (signature == bundle.GetSignatures().end()) {
+    return errors::NotFound("No signature ", options.signature, " in ",
+                            options.export_dir);
+  }
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  TF_RETURN_IF_ERROR(MakeRequest(signature->second, options.batch_size,
+                                 &inputs, &output_names));
+  Session* session = bundle.GetSession();
+  {
+    std::vector<Tensor> outputs;
+    const uint64 start_us = env->NowMicros();
+    TF_RETURN_IF_ERROR(session->Run(inputs, output_names, {}, &outputs));
+    results->first_request_us = env->NowMicros() - start_us;
+  }
+
+  // Serving: closed-loop clients, measured after the warmup.
+  const uint64 warmup_end_us =
+      env->NowMicros() + static_cast<uint64>(options.warmup_seconds * 1e6);
+  const uint64 end_us =
+      warmup_end_us + static_cast<uint64>(options.duration_seconds * 1e6);
+  std::vector<std::vector<int64>> client_latencies_us(options.num_clients);
+  std::atomic<int64> num_errors{0};
+  mutex error_mu;
+  Status first_error;
+  {
+    std::vector<std::unique_ptr<Thread>> clients;
+    for (int i = 0; i < options.num_clients; ++i) {
+      clients.emplace_back(env->StartThread(
+          ThreadOptions(), strings::StrCat("client_", i), [&, i]() {
+            std::vector<Tensor> outputs;
+            while (true) {
+              const uint64 start_us = env->NowMicros();
+              if (start_us >= end_us) break;
+              const Status s =
+                  session->Run(inputs, output_names, {}, &outputs);
+              if (!s.ok()) {
+                ++num_errors;
+                mutex_lock l(error_mu);
+                first_error.Update(s);
+              } else if (start_us >= warmup_end_us) {
+                client_latencies_us[i].push_back(env->NowMicros() -
+                                                 start_us);
+              }
+            }
+          }));
+    }
+  }
+
+  std::vector<int64> latencies_us;
+  for (const auto& client : client_latencies_us) {
+    latencies_us.insert(latencies_us.end(), client.begin(), client.end());
+  }
+  if (latencies_us.empty() && !first_error.ok()) return first_error;
+  std::sort(latencies_us.begin(), latencies_us.end());
+  for (int64 latency_us : latencies_us) {
+    results->latency_us.UpdateStat(latency_us);
+  }
+  results->num_requests = latencies_us.size();
+  results->num_errors = num_errors;
+  results->qps = options.duration_seconds > 0
+                     ? results->num_requests / options.duration_seconds
+                     : 0;
+  results->p50_latency_us = Percentile(latencies_us, 50);
+  results->p99_latency_us = Percentile(latencies_us, 99);
+  results->p999_latency_us = Percentile(latencies_us, 99.9);
+  results->peak_rss_kb = PeakRssKb();
+  return Status::OK();
+}
+
+string ResultsToString(const Results& results) {
+  return strings::StrCat(
+      "Load time (us): ", results.load_time_us.avg(),
+      " avg, ", results.load_time_us.max(), " max over ",
+      results.load_time_us.count(), " loads\n",
+      "First request (us): ", results.first_request_us, "\n",
+      "Requests: ", results.num_requests, " (", results.num_errors,
+      " errors), ", results.qps, " QPS\n",
+      "Latency (us): p50 ", results.p50_latency_us, ", p99 ",
+      results.p99_latency_us, ", p999 ", results.p999_latency_us, ", max ",
+      results.latency_us.max(), "\n",
+      "Peak RSS (KB): ", results.peak_rss_kb, "\n");
+}
+
+int Main(int argc, char** argv) {
+  Options options;
+  string tags_string = "serve";
+  float warmup_seconds = options.warmup_seconds;
+  float duration_seconds = options.duration_seconds;
+  int inter_op_threads = 0;
+  int intra_op_threads = 0;
+  string benchmark_name = "";
+  string output_prefix = "";
+
+  std::vector<Flag> flag_list = {
+      Flag("saved_model_dir", &options.export_dir, "SavedModel directory"),
+      Flag("tags", &tags_string, "comma-separated tags of the MetaGraph"),
+      Flag("signature", &options.signature, "signature to serve"),
+      Flag("batch_size", &options.batch_size,
+           "size of the unknown dimensions of the inputs"),
+      Flag("num_loader_threads", &options.num_loader_threads,
+           "number of concurrent loads of the model"),
+      Flag("num_clients", &options.num_clients,
+           "number of concurrent clients"),
+      Flag("warmup_seconds", &warmup_seconds, "unmeasured serving time"),
+      Flag("duration_seconds", &duration_seconds, "measured serving time"),
+      Flag("inter_op_threads", &inter_op_threads,
+           "inter-op threads of the session, 0 for the default"),
+      Flag("intra_op_threads", &intra_op_threads,
+           "intra-op threads of the session, 0 for the default"),
+      Flag("benchmark_name", &benchmark_name, "benchmark name"),
+      Flag("output_prefix", &output_prefix, "benchmark output prefix"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || options.export_dir.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+
+  options.tags.clear();
+  for (const string& tag : str_util::Split(tags_string, ',')) {
+    options.tags.insert(tag);
+  }
+  options.warmup_seconds = warmup_seconds;
+  options.duration_seconds = duration_seconds;
+  ConfigProto& config = options.session_options.config;
+  config.set_inter_op_parallelism_threads(inter_op_threads);
+  config.set_intra_op_parallelism_threads(intra_op_threads);
+
+  Results results;
+  const Status status = RunServingBenchmark(options, &results);
+  if (!status.ok()) {
+    LOG(ERROR) << "Serving benchmark failed: " << status;
+    return -1;
+  }
+  LOG(INFO) << "\n" << ResultsToString(results);
+
+  if (!benchmark_name.empty() && !output_prefix.empty()) {
+    RecordBenchmarkEntry(output_prefix, benchmark_name, options, results);
+  }
+  return 0;
+}
+
+}  // namespace serving_benchmark
+}  // namespace tensorflow
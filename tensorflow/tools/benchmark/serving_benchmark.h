@@ -0,0 +1,101 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_SERVING_BENCHMARK_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_SERVING_BENCHMARK_H_
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/stats_calculator.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+
+// Loads a SavedModel and serves it to concurrent clients, the way a model
+// server does, to measure end-to-end the effect of runtime changes (executor,
+// allocator, batching...).
+//
+// Batching is measured by serving a SavedModel exported with BatchFunction
+// ops (e.g. with `tf.nondifferentiable_batch_function`): the concurrent
+// clients are what fills the batches.
+struct Options {
+  string export_dir;
+  std::unordered_set<string> tags = {"serve"};
+  string signature = "serving_default";
+
+  // The size of the unknown dimensions of the signature inputs.
+  int batch_size = 1;
+
+  // Number of threads loading the model at the same time, as when a server
+  // loads many models on startup. The cold start is measured on each of them.
+  int num_loader_threads = 1;
+
+  // Number of threads calling Session::Run in a closed loop.
+  int num_clients = 1;
+
+  // Requests during the warmup are not measured.
+  double warmup_seconds = 1.0;
+  double duration_seconds = 10.0;
+
+  SessionOptions session_options;
+};
+
+struct Results {
+  // Time to load the model, one sample per loader thread.
+  Stat<int64> load_time_us;
+  // Latency of the first request to a freshly loaded model, which includes
+  // the lazy initialization of the runtime (kernels, allocator regions...).
+  int64 first_request_us = 0;
+
+  int64 num_requests = 0;
+  int64 num_errors = 0;
+  double qps = 0;
+  Stat<int64> latency_us;
+  int64 p50_latency_us = 0;
+  int64 p99_latency_us = 0;
+  int64 p999_latency_us = 0;
+
+  // Peak resident set size of the process, or 0 if unknown.
+  int64 peak_rss_kb = 0;
+};
+
+// Returns the feeds of a request to `signature`, with `batch_size` for the
+// unknown dimensions and constant values, and the names of its fetches.
+Status MakeRequest(const SignatureDef& signature, int batch_size,
+                   std::vector<std::pair<string, Tensor>>* inputs,
+                   std::vector<string>* output_names);
+
+// Returns the `percentile` (in [0, 100]) of `values`, which are sorted.
+int64 Percentile(const std::vector<int64>& sorted_values, double percentile);
+
+// Runs the benchmark described by `options`.
+Status RunServingBenchmark(const Options& options, Results* results);
+
+// Returns a human-readable summary of `results`.
+string ResultsToString(const Results& results);
+
+// Handles all setup and argument parsing.
+int Main(int argc, char** argv);
+
+}  // namespace serving_benchmark
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_SERVING_BENCHMARK_H_
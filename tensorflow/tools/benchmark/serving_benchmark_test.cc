@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/serving_benchmark.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+namespace {
+
+constexpr char kTestData[] = "cc/saved_model/testdata/half_plus_two/00000123";
+
+TEST(ServingBenchmarkTest, Percentile) {
+  std::vector<int64> values;
+  for (int i = 1; i <= 1000; ++i) values.push_back(i);
+  EXPECT_EQ(500, Percentile(values, 50));
+  EXPECT_EQ(990, Percentile(values, 99));
+  EXPECT_EQ(999, Percentile(values, 99.9));
+  EXPECT_EQ(1, Percentile(values, 0));
+  EXPECT_EQ(1000, Percentile(values, 100));
+  EXPECT_EQ(0, Percentile({}, 50));
+}
+
+TEST(ServingBenchmarkTest, MakeRequest) {
+  SignatureDef signature;
+  TensorInfo& x = (*signature.mutable_inputs())["x"];
+  x.set_name("x:0");
+  x.set_dtype(DT_FLOAT);
+  x.mutable_tensor_shape()->add_dim()->set_size(-1);
+  x.mutable_tensor_shape()->add_dim()->set_size(3);
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  TF_ASSERT_OK(MakeRequest(signature, 8, &inputs, &output_names));
+  ASSERT_EQ(1, inputs.size());
+  EXPECT_EQ("x:0", inputs[0].first);
+  EXPECT_EQ(TensorShape({8, 3}), inputs[0].second.shape());
+  EXPECT_EQ(1.0f, inputs[0].second.flat<float>()(0));
+  EXPECT_EQ(std::vector<string>({"y:0"}), output_names);
+
+  x.mutable_tensor_shape()->set_unknown_rank(true);
+  EXPECT_FALSE(MakeRequest(signature, 8, &inputs, &output_names).ok());
+}
+
+TEST(ServingBenchmarkTest, ServesSavedModel) {
+  Options options;
+  options.export_dir = io::JoinPath(testing::TensorFlowSrcRoot(), kTestData);
+  options.num_loader_threads = 2;
+  options.num_clients = 4;
+  options.batch_size = 16;
+  options.warmup_seconds = 0.1;
+  options.duration_seconds = 0.5;
+  Results results;
+  TF_ASSERT_OK(RunServingBenchmark(options, &results));
+  EXPECT_EQ(2, results.load_time_us.count());
+  EXPECT_GT(results.load_time_us.min(), 0);
+  EXPECT_GT(results.first_request_us, 0);
+  EXPECT_GT(results.num_requests, 0);
+  EXPECT_EQ(0, results.num_errors);
+  EXPECT_GT(results.qps, 0);
+  EXPECT_LE(results.p50_latency_us, results.p99_latency_us);
+  EXPECT_LE(results.p99_latency_us, results.p999_latency_us);
+  EXPECT_LE(results.p999_latency_us, results.latency_us.max());
+#if defined(__linux__)
+  EXPECT_GT(results.peak_rss_kb, 0);
+#endif
+
+  options.signature = "missing";
+  EXPECT_EQ(error::NOT_FOUND,
+            RunServingBenchmark(options, &results).code());
+}
+
+}  // namespace
+}  // namespace serving_benchmark
+}  // namespace tensorflow
@@ -0,0 +1,152 @@
+# Lint as: python3
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Flags the benchmarks that regressed between two builds.
+
+Compares the BenchmarkEntries files written by `TestReporter`, e.g. by
+//tensorflow/core/kernels:op_benchmark_suite_main, for a baseline and a
+candidate build:
+
+  compare_benchmarks.py /tmp/before/ /tmp/after/ --output_json=/tmp/diff.json
+
+A benchmark regresses when its median wall time grew by more than
+`--threshold`, and by more than `--noise_factor` times the combined standard
+deviation of the repetitions, so that noisy benchmarks are not flagged. Exits
+with a non-zero status if any benchmark regressed.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import json
+import math
+import os
+import sys
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+
+def load_benchmarks(path):
+  """Returns the BenchmarkEntry protos of `path`, by name.
+
+  Args:
+    path: A BenchmarkEntries file, or a report prefix. A prefix ending with
+      "/" is a directory whose files are all read.
+  """
+  if gfile.IsDirectory(path):
+    files = [os.path.join(path, f) for f in gfile.ListDirectory(path)]
+  elif gfile.Exists(path):
+    files = [path]
+  else:
+    files = gfile.Glob(path + "*")
+  benchmarks = {}
+  for filename in sorted(files):
+    entries = test_log_pb2.BenchmarkEntries()
+    with gfile.GFile(filename, "rb") as f:
+      entries.ParseFromString(f.read())
+    for entry in entries.entry:
+      benchmarks[entry.name] = entry
+  return benchmarks
+
+
+def _median_and_stddev(entry):
+  """Returns the median and stddev of the wall time per iteration."""
+  extras = entry.extras
+  median = (extras["median_wall_time"].double_value
+            if "median_wall_time" in extras else entry.wall_time)
+  stddev = (extras["stddev_wall_time"].double_value
+            if "stddev_wall_time" in extras else 0.0)
+  return median, stddev
+
+
+def compare(baseline, candidate, threshold=0.05, noise_factor=2.0):
+  """Compares the benchmarks present in both builds.
+
+  Args:
+    baseline: The BenchmarkEntry protos of the baseline build, by name.
+    candidate: The BenchmarkEntry protos of the candidate build, by name.
+    threshold: The relative slowdown above which a benchmark may regress.
+    noise_factor: How many combined standard deviations a slowdown must
+      exceed to regress.
+
+  Returns:
+    A list of dicts with the "name", the "baseline" and "candidate" median
+    wall times, their "ratio", and whether it is a "regression" or an
+    "improvement", sorted by decreasing ratio.
+  """
+  results = []
+  for name in sorted(set(baseline) & set(candidate)):
+    old, old_stddev = _median_and_stddev(baseline[name])
+    new, new_stddev = _median_and_stddev(candidate[name])
+    if old <= 0:
+      continue
+    noise = noise_factor * math.sqrt(old_stddev**2 + new_stddev**2)
+    results.append({
+        "name": name,
+        "baseline": old,
+        "candidate": new,
+        "ratio": new / old,
+        "regression": new > old * (1 + threshold) and new - old > noise,
+        "improvement": new < old / (1 + threshold) and old - new > noise,
+    })
+  results.sort(key=lambda result: result["ratio"], reverse=True)
+  return results
+
+
+def main(argv):
+  parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+  parser.add_argument("baseline", help="Report prefix of the baseline build.")
+  parser.add_argument(
+      "candidate", help="Report prefix of the candidate build.")
+  parser.add_argument(
+      "--threshold", type=float, default=0.05,
+      help="Relative slowdown above which a benchmark may regress.")
+  parser.add_argument(
+      "--noise_factor", type=float, default=2.0,
+      help="Standard deviations a slowdown must exceed to regress.")
+  parser.add_argument(
+      "--output_json", default="",
+      help="If set, the comparison of every benchmark is written there.")
+  args = parser.parse_args(argv[1:])
+
+  baseline = load_benchmarks(args.baseline)
+  candidate = load_benchmarks(args.candidate)
+  results = compare(baseline, candidate, args.threshold, args.noise_factor)
+
+  print("%-50s %12s %12s %8s" % ("Benchmark", "Baseline", "Candidate",
+                                  "Ratio"))
+  for result in results:
+    print("%-50s %12.4g %12.4g %8.3f %s" % (
+        result["name"], result["baseline"], result["candidate"],
+        result["ratio"], "REGRESSION" if result["regression"] else
+        "improvement" if result["improvement"] else ""))
+  for name in sorted(set(baseline) ^ set(candidate)):
+    print("%-50s only in the %s" % (
+        name, "baseline" if name in baseline else "candidate"))
+
+  if args.output_json:
+    with gfile.GFile(args.output_json, "w") as f:
+      json.dump(results, f, indent=2)
+
+  num_regressions = sum(result["regression"] for result in results)
+  print("%d of %d benchmarks regressed." % (num_regressions, len(results)))
+  return 1 if num_regressions else 0
+
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))
@@ -0,0 +1,77 @@
+# Lint as: python3
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import test
+from tensorflow.tools.test import compare_benchmarks
+
+
+def _entry(name, median, stddev):
+  entry = test_log_pb2.BenchmarkEntry(name=name, wall_time=median)
+  entry.extras["median_wall_time"].double_value = median
+  entry.extras["stddev_wall_time"].double_value = stddev
+  return entry
+
+
+class CompareBenchmarksTest(test.TestCase):
+
+  def testFlagsRegressionsAboveNoise(self):
+    baseline = {
+        "Slower": _entry("Slower", 1.0, 0.01),
+        "Noisy": _entry("Noisy", 1.0, 0.5),
+        "Faster": _entry("Faster", 1.0, 0.01),
+        "Same": _entry("Same", 1.0, 0.01),
+        "Removed": _entry("Removed", 1.0, 0.01),
+    }
+    candidate = {
+        "Slower": _entry("Slower", 1.2, 0.01),
+        "Noisy": _entry("Noisy", 1.2, 0.5),
+        "Faster": _entry("Faster", 0.8, 0.01),
+        "Same": _entry("Same", 1.01, 0.01),
+    }
+    results = compare_benchmarks.compare(baseline, candidate)
+    # Sorted by decreasing ratio, without the benchmarks of only one build.
+    self.assertEqual(["Noisy", "Slower", "Same", "Faster"],
+                     [r["name"] for r in results])
+    by_name = {r["name"]: r for r in results}
+    self.assertTrue(by_name["Slower"]["regression"])
+    self.assertFalse(by_name["Noisy"]["regression"])
+    self.assertFalse(by_name["Same"]["regression"])
+    self.assertFalse(by_name["Faster"]["regression"])
+    self.assertTrue(by_name["Faster"]["improvement"])
+    self.assertAlmostEqual(1.2, by_name["Slower"]["ratio"])
+
+  def testLoadsReportPrefix(self):
+    prefix = os.path.join(self.get_temp_dir(), "run_")
+    for name in ["A", "B"]:
+      entries = test_log_pb2.BenchmarkEntries()
+      entries.entry.add().CopyFrom(_entry(name, 1.0, 0.0))
+      with gfile.GFile(prefix + name, "wb") as f:
+        f.write(entries.SerializeToString())
+    self.assertEqual(["A", "B"],
+                     sorted(compare_benchmarks.load_benchmarks(prefix)))
+
+
+if __name__ == "__main__":
+  test.main()